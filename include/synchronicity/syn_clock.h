@@ -0,0 +1,51 @@
+#ifndef SYN_CLOCK_H_
+#define SYN_CLOCK_H_
+
+#include <vlc_common.h>
+
+// Clock offset estimate of a peer from sync exchanges. Each exchange
+// gives an offset sample, good to half its round trip time. Queueing
+// only ever makes round trips longer, so the estimate is fit to the
+// samples with the shortest ones in a recent window: a line through
+// them tracks the drift between the two clocks, their spread around it
+// is the jitter.
+//
+// The estimator is exported so that other clock sources, such as the
+// netsync module, share it instead of trusting single exchanges.
+#define SYN_CLOCK_SAMPLES 32       // window size
+#define SYN_CLOCK_MIN_FIT 4        // samples needed for a drift fit
+#define SYN_CLOCK_MIN_SPAN 2000000 // and the time they need to span
+#define SYN_CLOCK_MAX_DRIFT 0.0005 // crystals are good to 500 ppm
+#define SYN_CLOCK_FAST_SAMPLES 16  // sync quickly until we have these
+
+struct SynClockSample {
+  mtime_t local;   // when the reply arrived
+  mtime_t offset;  // local minus peer clock
+  mtime_t rtt;
+};
+typedef struct SynClockSample SynClockSample;
+
+struct SynClock {
+  SynClockSample samples[SYN_CLOCK_SAMPLES];
+  int count;
+  int next;
+
+  mtime_t reference;  // local time the estimate below is for
+  mtime_t offset;
+  double drift;       // offset change per microsecond of local time
+  mtime_t jitter;
+  mtime_t min_rtt;
+};
+typedef struct SynClock SynClock;
+
+VLC_API void syn_clock_init(SynClock* clock);
+// One sync exchange: the reply came in at local, said offset, took rtt
+VLC_API void syn_clock_add(SynClock* clock, mtime_t local, mtime_t offset,
+    mtime_t rtt);
+// Estimated offset at local time local, 0 without samples
+VLC_API mtime_t syn_clock_offset(const SynClock* clock, mtime_t local);
+// Bound on the error of syn_clock_offset(): half the best round trip,
+// which path asymmetry can hide in, plus the jitter
+VLC_API mtime_t syn_clock_error(const SynClock* clock);
+
+#endif
@@ -7,8 +7,11 @@
 
 #define SYNC_STDEV_THRESHOLD 20000
 
+// Handle to a connection. generation tells a handle to a connection that
+// was destroyed apart from one to whatever reuses its slot later.
 struct SynConnection {
   int index;
+  unsigned int generation;
 };
 typedef struct SynConnection SynConnection;
 
@@ -43,6 +46,21 @@ VLC_API int SynConnection_InitializeAsServer(
     SynConnection_Callback* peer_connect_callback,
     void* peer_connect_param
 );
+// Like a server, but any number of clients can join with the key. What
+// is sent reaches all of them at once through the relay, every client
+// is synced on its own and peer_connect_callback is called for each.
+VLC_API int SynConnection_InitializeAsPartyHost(
+    vlc_object_t* parent,
+    SynConnection* connection,
+    const char* server_addr,
+    int server_port,
+    SynConnection_ReceiveCallback* receive_callback,
+    void* receive_param,
+    SynConnection_Callback* host_key_callback,
+    void* host_key_param,
+    SynConnection_Callback* peer_connect_callback,
+    void* peer_connect_param
+);
 VLC_API int SynConnection_InitializeAsClient(
     vlc_object_t* parent,
     SynConnection* connection,
@@ -54,11 +72,19 @@ VLC_API int SynConnection_InitializeAsClient(
     SynConnection_Callback* callback,
     void* param
 );
+// Playback jumped or changed speed: sync the peer clock quickly for a
+// while, the estimate is about to be relied on
+VLC_API int SynConnection_Resync(
+    SynConnection connection
+);
+
 VLC_API int SynConnection_Destroy(
     SynConnection connection,
     SynConnection_Callback* callback,
     void* param
 );
+// The buffer is copied before this returns, the caller can reuse it
+// right away; the callback only reports whether the data went out.
 VLC_API int SynConnection_Send(
     SynConnection connection,
     void* buffer,
@@ -67,4 +93,37 @@ VLC_API int SynConnection_Send(
     void* param
 );
 
+// Wire version agreed with the peer, 0 until it is known or if the peer
+// only speaks the original format. Payload encodings can follow it, see
+// SynCommand_Encode.
+VLC_API int SynConnection_GetWireVersion(
+    SynConnection connection
+);
+
+// Estimated local minus peer clock, and a bound on the estimate's error.
+// Returns -2 until the first sync exchange completed.
+VLC_API int SynConnection_GetClockOffset(
+    SynConnection connection,
+    mtime_t* offset,
+    mtime_t* error
+);
+
+// What a connection is through so far, to tell a bad link from a bad peer
+struct SynConnection_Stats {
+  mtime_t rtt;              // smoothed round trip time, -1 until measured
+  mtime_t offset;           // as SynConnection_GetClockOffset, 0 until then
+  mtime_t offset_error;
+  uint64_t bytes_sent;      // on the relay connection and as datagrams
+  uint64_t bytes_received;
+  unsigned int beacons_sent;
+  unsigned int beacons_answered;
+};
+typedef struct SynConnection_Stats SynConnection_Stats;
+
+// Returns -1 if the connection is gone
+VLC_API int SynConnection_GetStats(
+    SynConnection connection,
+    SynConnection_Stats* stats
+);
+
 #endif
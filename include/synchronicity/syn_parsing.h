@@ -9,6 +9,15 @@ enum SynCommandType {
   SYNCOMMAND_PAUSE,
   SYNCOMMAND_SEEK,
   SYNCOMMAND_MYNAMEIS,
+  // Coordinated start, binary format only: pause at i_time and fill the
+  // buffers there, report that they are full at i_time, then start i_time
+  // microseconds after the start command was sent
+  SYNCOMMAND_PREPARE,
+  SYNCOMMAND_READY,
+  SYNCOMMAND_START,
+  // Binary format only: the peer plays the item with the content key
+  // i_int, see playlist_SynItemKey()
+  SYNCOMMAND_ITEM,
   SYNCOMMAND_NUM,
   SYNCOMMAND_ERROR = SYNCOMMAND_NUM,
 };
@@ -21,7 +30,23 @@ struct SynCommand {
 };
 typedef struct SynCommand SynCommand;
 
+// Accepts both the fixed size text format and the binary one
 SynCommand CommandFromString(char* buffer, int length);
 // Returns number of bytes written, or negative for error
 int StringFromCommand(SynCommand command, char* outbuffer, int length);
+
+// Wire version a peer needs for the coordinated start commands
+#define SYNCOMMAND_START_VERSION 2
+// and for SYNCOMMAND_ITEM, the session then lives across items
+#define SYNCOMMAND_ITEM_VERSION 3
+
+// Binary commands start with a byte no text command starts with
+#define SYNCOMMAND_BINARY_MARK 0x80
+
+// Encode for a peer speaking the given wire version (see
+// SynConnection_GetWireVersion()): the text format for version 0, a
+// few bytes of varints from version 1 on. Returns number of bytes
+// written, or negative for error.
+int SynCommand_Encode(SynCommand command, char* outbuffer, int length,
+    int version);
 #endif
@@ -0,0 +1,40 @@
+#ifndef SYN_STREAM_H_
+#define SYN_STREAM_H_
+
+#include <vlc_common.h>
+
+// The host of a viewing may stream its media to its peers through the
+// relay server rather than have them open the same file. The host's
+// sout chain opens the source of the stream on its key, each peer a
+// sink on the same key, and the relay copies every frame of the source
+// to the sinks. A sink that cannot keep up skips frames, whole ones,
+// the source is never held up; see relay_stream.h.
+//
+// A frame is its payload length (32 bit), the host's mdate() when it
+// was sent (64 bit), both big endian, then the payload. Sinks release a
+// frame at that date on their own clock, through the clock offset of
+// the sync connection, plus a fixed latency.
+#define SYN_STREAM_FRAME_HEADER 12
+#define SYN_STREAM_MAX_PAYLOAD (1 << 20)
+#define SYN_STREAM_KEY_LENGTH 16  // hex digits of a key
+
+// Stream output of every input with synchronicity-stream: played as
+// usual, and muxed for the relay in case we host
+#define SYN_STREAM_SOUT \
+  "#duplicate{dst=display,dst=std{access=synchronicity,mux=ts}}"
+
+// Sent to the relay before the key, see relay_stream.h
+#define SYN_STREAM_SOURCE_KEY 4
+#define SYN_STREAM_SINK_KEY 5
+
+// Connects to the relay of the synchronicity-server and -port variables
+// as the source or a sink of the stream of key. Returns the socket, or
+// -1 if the relay cannot be reached or refused the key.
+VLC_API int SynStream_Open(
+    vlc_object_t* obj,
+    const char* key,
+    bool source
+);
+#define SynStream_Open(o, k, s) SynStream_Open(VLC_OBJECT(o), k, s)
+
+#endif
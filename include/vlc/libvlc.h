@@ -303,6 +303,80 @@ LIBVLC_API void libvlc_event_detach( libvlc_event_manager_t *p_event_manager,
  */
 LIBVLC_API const char * libvlc_event_type_name( libvlc_event_type_t event_type );
 
+/**
+ * Event queue, to receive events from the application's own event loop
+ * instead of callbacks.
+ *
+ * The events are queued as they occur, and drained with
+ * libvlc_event_queue_poll(). High-frequency events (time, position and
+ * buffering changes) are coalesced: only the latest one of each object stays
+ * in the queue. The file descriptor of the queue becomes readable when the
+ * queue stops being empty, so that a single wakeup serves a batch of events.
+ *
+ * \note The pointers carried by the queued events (media, strings) are not
+ * held: they may be invalid by the time the event is drained.
+ */
+typedef struct libvlc_event_queue_t libvlc_event_queue_t;
+
+/**
+ * Create an event queue.
+ *
+ * \return a new event queue, or NULL on error
+ */
+LIBVLC_API libvlc_event_queue_t *libvlc_event_queue_new( void );
+
+/**
+ * Release an event queue. It must have been detached from all events first.
+ *
+ * \param p_queue the event queue
+ */
+LIBVLC_API void libvlc_event_queue_release( libvlc_event_queue_t *p_queue );
+
+/**
+ * Queue an event type of an event manager.
+ *
+ * \param p_queue the event queue
+ * \param p_event_manager the event manager
+ * \param i_event_type the event to queue
+ * \return 0 on success, ENOMEM on error
+ */
+LIBVLC_API int libvlc_event_queue_attach( libvlc_event_queue_t *p_queue,
+                                          libvlc_event_manager_t *p_event_manager,
+                                          libvlc_event_type_t i_event_type );
+
+/**
+ * Stop queuing an event type of an event manager. The events of that type
+ * that are still queued are dropped.
+ *
+ * \param p_queue the event queue
+ * \param p_event_manager the event manager
+ * \param i_event_type the event
+ */
+LIBVLC_API void libvlc_event_queue_detach( libvlc_event_queue_t *p_queue,
+                                           libvlc_event_manager_t *p_event_manager,
+                                           libvlc_event_type_t i_event_type );
+
+/**
+ * Get the file descriptor of an event queue, to poll it for reading.
+ * It is readable as long as events are queued. Do not read from it.
+ *
+ * \param p_queue the event queue
+ * \return the file descriptor, or -1 if the queue has none
+ */
+LIBVLC_API int libvlc_event_queue_fd( libvlc_event_queue_t *p_queue );
+
+/**
+ * Dequeue events, in the order they occurred. This never blocks.
+ *
+ * \param p_queue the event queue
+ * \param p_events array to store the events [OUT]
+ * \param i_max size of the array
+ * \return the number of events stored, 0 if the queue is empty
+ */
+LIBVLC_API unsigned libvlc_event_queue_poll( libvlc_event_queue_t *p_queue,
+                                             struct libvlc_event_t *p_events,
+                                             unsigned i_max );
+
 /** @} */
 
 /** \defgroup libvlc_log LibVLC logging
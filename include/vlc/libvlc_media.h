@@ -140,6 +140,17 @@ typedef struct libvlc_media_stats_t
     int         i_sent_packets;
     int         i_sent_bytes;
     float       f_send_bitrate;
+
+    /* Percentiles, in microseconds */
+    int         i_video_decode_time_p50; /**< decoding time per picture */
+    int         i_video_decode_time_p90;
+    int         i_video_decode_time_p99;
+    int         i_audio_decode_time_p50; /**< decoding time per buffer */
+    int         i_audio_decode_time_p90;
+    int         i_audio_decode_time_p99;
+    int         i_video_latency_p50; /**< from decoder output to display */
+    int         i_video_latency_p90;
+    int         i_video_latency_p99;
 } libvlc_media_stats_t;
 /** @}*/
 
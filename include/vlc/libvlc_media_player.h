@@ -358,6 +358,68 @@ void libvlc_video_set_format_callbacks( libvlc_media_player_t *mp,
                                         libvlc_video_format_cb setup,
                                         libvlc_video_cleanup_cb cleanup );
 
+/**
+ * Callback prototype to map one of the picture buffers of the application.
+ *
+ * LibVLC calls it for buffer indexes 0 to count - 1 when the video output
+ * starts, and uses these buffers as long as the video format does not
+ * change: the video decoder renders straight into them, without copies.
+ * The planes must have the pitches and scanlines returned by the
+ * @ref libvlc_video_format_cb callback, and be aligned on 32-bytes.
+ *
+ * \param opaque private pointer as passed to
+ *               libvlc_video_set_pool_callbacks() [IN]
+ * \param index index of the buffer [IN]
+ * \param count number of buffers LibVLC would like, at most as many as the
+ *              @ref libvlc_video_format_cb callback returned [IN]
+ * \param planes start address of the pixel planes of the buffer [OUT]
+ * \return 0 on success, non-zero if no more buffers are available
+ *
+ * \note LibVLC needs the buffers for the pictures the decoder references,
+ * plus a few for its own use, i.e. typically 20 to 30 buffers. With fewer
+ * buffers, or if the format callback changed the chroma or the dimensions,
+ * the decoder renders to memory of its own and the pictures are copied.
+ */
+typedef int (*libvlc_video_buffer_cb)(void *opaque, unsigned index,
+                                      unsigned count, void **planes);
+
+/**
+ * Callback prototype to take or give back a picture buffer of the
+ * application.
+ *
+ * LibVLC takes a buffer before it decodes a picture into it, and gives it
+ * back once the picture was displayed or dropped. Taking a buffer may block
+ * until the application is done with it, e.g. until it was composited.
+ *
+ * \param opaque private pointer as passed to
+ *               libvlc_video_set_pool_callbacks() [IN]
+ * \param index index of the buffer [IN]
+ */
+typedef void (*libvlc_video_buffer_ref_cb)(void *opaque, unsigned index);
+
+/**
+ * Set callbacks to render decoded video to a pool of picture buffers of the
+ * application, e.g. shared memory or memory mapped from a GPU.
+ * This replaces libvlc_video_set_callbacks(). The video format is selected
+ * with libvlc_video_set_format_callbacks(), which is then mandatory; the
+ * cleanup callback should release the buffers.
+ *
+ * \param mp the media player
+ * \param buffer callback to map the buffers (cannot be NULL)
+ * \param acquire callback called when LibVLC takes a buffer (or NULL)
+ * \param release callback called when LibVLC gives a buffer back (or NULL)
+ * \param present callback to display a buffer (or NULL)
+ * \param opaque private pointer for the callbacks (as first parameter)
+ * \version LibVLC 2.1.0 or later
+ */
+LIBVLC_API
+void libvlc_video_set_pool_callbacks( libvlc_media_player_t *mp,
+                                      libvlc_video_buffer_cb buffer,
+                                      libvlc_video_buffer_ref_cb acquire,
+                                      libvlc_video_buffer_ref_cb release,
+                                      libvlc_video_buffer_ref_cb present,
+                                      void *opaque );
+
 /**
  * Set the NSView handler where the media player should render its video output.
  *
@@ -0,0 +1,93 @@
+/*****************************************************************************
+ * libvlc_media_worker.h:  libvlc external API
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/**
+ * \file
+ * This file defines libvlc_media_worker external API
+ */
+
+#ifndef VLC_LIBVLC_MEDIA_WORKER_H
+#define VLC_LIBVLC_MEDIA_WORKER_H 1
+
+# ifdef __cplusplus
+extern "C" {
+# endif
+
+/** \defgroup libvlc_media_worker LibVLC media worker
+ * \ingroup libvlc
+ * A LibVLC media worker processes media without playing them, e.g. to
+ * extract thumbnails. It is much lighter than a media player: there is no
+ * audio output, no window and no event manager, and the video output is kept
+ * from one media to the next.
+ *
+ * All the workers of a LibVLC instance share its modules and configuration.
+ * A worker handles one media at a time, but several workers can be used
+ * concurrently, e.g. one per thread of a thread pool.
+ * @{
+ */
+
+typedef struct libvlc_media_worker_t libvlc_media_worker_t;
+
+/**
+ * Create a media worker.
+ *
+ * \param p_instance the libvlc instance
+ * \return a new media worker object, or NULL on error.
+ */
+LIBVLC_API libvlc_media_worker_t *
+libvlc_media_worker_new( libvlc_instance_t *p_instance );
+
+/**
+ * Release a media worker. It must not be in use by another thread.
+ *
+ * \param p_mw the media worker
+ */
+LIBVLC_API void libvlc_media_worker_release( libvlc_media_worker_t *p_mw );
+
+/**
+ * Extract a snapshot of a media, and save it to a file.
+ * This function blocks until the snapshot is saved or the timeout expires.
+ *
+ * \param p_mw the media worker
+ * \param p_md the media
+ * \param i_time time of the snapshot (in ms) from the start of the media
+ * \param i_width the snapshot's width
+ * \param i_height the snapshot's height
+ * \param psz_filepath the path where to save the snapshot; the image format
+ *        follows the file name extension (PNG by default)
+ * \param i_timeout how long to wait at most (in ms)
+ * \return 0 on success, -1 on error or timeout
+ *
+ * \note If i_width AND i_height are 0, the original size is used.
+ *       If i_width XOR i_height is 0, the original aspect-ratio is preserved.
+ */
+LIBVLC_API int
+libvlc_media_worker_snapshot( libvlc_media_worker_t *p_mw,
+                              libvlc_media_t *p_md, libvlc_time_t i_time,
+                              unsigned i_width, unsigned i_height,
+                              const char *psz_filepath, int i_timeout );
+
+/** @} media_worker */
+
+# ifdef __cplusplus
+}
+# endif
+
+#endif /* VLC_LIBVLC_MEDIA_WORKER_H */
@@ -0,0 +1,228 @@
+/*****************************************************************************
+ * libvlc_packet.h:  libvlc external API
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/**
+ * \file
+ * This file defines libvlc_packet external API
+ */
+
+#ifndef VLC_LIBVLC_PACKET_H
+#define VLC_LIBVLC_PACKET_H 1
+
+#include <stddef.h>
+
+# ifdef __cplusplus
+extern "C" {
+# else
+#  include <stdbool.h>
+# endif
+
+/** \defgroup libvlc_packet LibVLC encoded packets
+ * \ingroup libvlc_media_player
+ * A media player can hand the encoded packets of the elementary streams (ES)
+ * over to the application, instead of decoding and rendering them. The media
+ * is only demultiplexed (and packetized, so that each packet holds a whole
+ * frame): there is no decoder, no audio output and no video output.
+ *
+ * The packets are not copied: a packet refers to the demultiplexer buffer,
+ * which stays valid until the packet is released.
+ * @{
+ */
+
+typedef struct libvlc_packet_t libvlc_packet_t;
+
+/**
+ * Description of an elementary stream.
+ * It remains valid as long as a packet of the ES is held.
+ */
+typedef struct libvlc_packet_es_t
+{
+    int         i_id;           /**< ES identifier, as in the track API */
+    libvlc_track_type_t i_type;
+    uint32_t    i_codec;        /**< codec fourcc */
+    uint32_t    i_original_fourcc; /**< fourcc in the container, or 0 */
+
+    /* Codec specific */
+    int         i_profile;
+    int         i_level;
+    const char *psz_language;   /**< ISO 639 language code, or NULL */
+    const void *p_extra;        /**< codec private data, or NULL */
+    size_t      i_extra;        /**< size of the codec private data */
+
+    union {
+        struct {
+            /* Audio specific */
+            unsigned    i_channels;
+            unsigned    i_rate;
+        } audio;
+        struct {
+            /* Video specific */
+            unsigned    i_height;
+            unsigned    i_width;
+            unsigned    i_frame_rate;
+            unsigned    i_frame_rate_base;
+        } video;
+    } u;
+} libvlc_packet_es_t;
+
+/** ES types, for libvlc_media_player_set_packet_callbacks() */
+enum
+{
+    libvlc_packet_audio = 0x1,
+    libvlc_packet_video = 0x2,
+    libvlc_packet_text  = 0x4,
+};
+
+/** Packet flags, see libvlc_packet_flags() */
+enum
+{
+    libvlc_packet_keyframe      = 0x1, /**< the packet is a random access point */
+    libvlc_packet_discontinuity = 0x2, /**< packets were lost before this one */
+    libvlc_packet_corrupted     = 0x4, /**< the packet is damaged */
+};
+
+/**
+ * Callback prototype to select the ES.
+ * It is called when an ES starts, before its first packet.
+ *
+ * \param opaque private pointer as passed to
+ *        libvlc_media_player_set_packet_callbacks() [IN]
+ * \param es the description of the ES [IN]
+ * \return true to receive the packets of the ES, false to drop them
+ */
+typedef bool (*libvlc_packet_es_cb)(void *opaque,
+                                    const libvlc_packet_es_t *es);
+
+/**
+ * Callback prototype for the packets.
+ * It is called from the thread of the ES: the callbacks for different ES may
+ * run concurrently, but the packets of one ES are delivered in order.
+ *
+ * \param opaque private pointer as passed to
+ *        libvlc_media_player_set_packet_callbacks() [IN]
+ * \param packet the packet; the callback owns it, and must release it
+ *        with libvlc_packet_release(), now or later [IN]
+ */
+typedef void (*libvlc_packet_cb)(void *opaque, libvlc_packet_t *packet);
+
+/**
+ * Deliver the encoded packets of the media to the application.
+ * This replaces the audio and video outputs; it takes effect with the next
+ * media played.
+ *
+ * Only the ES of the given types are selected: the others are neither
+ * packetized nor delivered. The ES callback, if any, filters the selected ES
+ * further; the ES it rejects are still packetized, but their packets are
+ * dropped at once.
+ *
+ * \param mp the media player
+ * \param packet callback to receive the packets, or NULL to play the media
+ *        normally again
+ * \param es callback to select the ES, or NULL to select them all
+ * \param types the types of ES to select (libvlc_packet_audio,
+ *        libvlc_packet_video, libvlc_packet_text), or 0 for all types
+ * \param opaque private pointer for the callbacks
+ */
+LIBVLC_API void
+libvlc_media_player_set_packet_callbacks( libvlc_media_player_t *mp,
+                                          libvlc_packet_cb packet,
+                                          libvlc_packet_es_cb es,
+                                          unsigned types, void *opaque );
+
+/**
+ * Hold a packet, e.g. to share it between threads.
+ *
+ * \param p_packet the packet
+ */
+LIBVLC_API void libvlc_packet_retain( libvlc_packet_t *p_packet );
+
+/**
+ * Release a packet. The buffer of the packet is freed with the last
+ * reference.
+ *
+ * \param p_packet the packet
+ */
+LIBVLC_API void libvlc_packet_release( libvlc_packet_t *p_packet );
+
+/**
+ * Get the encoded data of a packet.
+ *
+ * \param p_packet the packet
+ * \return the data, valid until the packet is released
+ */
+LIBVLC_API const uint8_t *libvlc_packet_data( const libvlc_packet_t *p_packet );
+
+/**
+ * Get the size of the encoded data of a packet.
+ *
+ * \param p_packet the packet
+ * \return the size in bytes
+ */
+LIBVLC_API size_t libvlc_packet_size( const libvlc_packet_t *p_packet );
+
+/**
+ * Get the presentation timestamp of a packet.
+ *
+ * \param p_packet the packet
+ * \return the timestamp (in microseconds), or -1 if unknown
+ */
+LIBVLC_API int64_t libvlc_packet_pts( const libvlc_packet_t *p_packet );
+
+/**
+ * Get the decoding timestamp of a packet.
+ *
+ * \param p_packet the packet
+ * \return the timestamp (in microseconds), or -1 if unknown
+ */
+LIBVLC_API int64_t libvlc_packet_dts( const libvlc_packet_t *p_packet );
+
+/**
+ * Get the duration of a packet.
+ *
+ * \param p_packet the packet
+ * \return the duration (in microseconds), or 0 if unknown
+ */
+LIBVLC_API int64_t libvlc_packet_duration( const libvlc_packet_t *p_packet );
+
+/**
+ * Get the flags of a packet.
+ *
+ * \param p_packet the packet
+ * \return a combination of libvlc_packet_keyframe,
+ *         libvlc_packet_discontinuity and libvlc_packet_corrupted
+ */
+LIBVLC_API unsigned libvlc_packet_flags( const libvlc_packet_t *p_packet );
+
+/**
+ * Get the ES of a packet.
+ *
+ * \param p_packet the packet
+ * \return the description of the ES, valid until the packet is released
+ */
+LIBVLC_API const libvlc_packet_es_t *
+libvlc_packet_es( const libvlc_packet_t *p_packet );
+
+/** @} packet */
+
+# ifdef __cplusplus
+}
+# endif
+
+#endif /* VLC_LIBVLC_PACKET_H */
@@ -0,0 +1,129 @@
+/*****************************************************************************
+ * libvlc_thumbnailer.h:  libvlc external API
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/**
+ * \file
+ * This file defines libvlc_thumbnailer external API
+ */
+
+#ifndef VLC_LIBVLC_THUMBNAILER_H
+#define VLC_LIBVLC_THUMBNAILER_H 1
+
+#include <stddef.h>
+
+# ifdef __cplusplus
+extern "C" {
+# endif
+
+/** \defgroup libvlc_thumbnailer LibVLC thumbnailer
+ * \ingroup libvlc
+ * A LibVLC thumbnailer extracts frames of media asynchronously, without a
+ * media player: there is no audio or video output, and no clock. Each
+ * request seeks to the keyframe nearest to the requested time, and decodes
+ * that keyframe only, with hardware acceleration if available. The frame is
+ * scaled and converted in one pass, then encoded.
+ *
+ * The requests of all the thumbnailers of a LibVLC instance are run
+ * concurrently by a shared pool of threads. This is much cheaper than
+ * playing each media, and than the media workers.
+ * @{
+ */
+
+typedef struct libvlc_thumbnailer_t libvlc_thumbnailer_t;
+typedef struct libvlc_thumbnailer_request_t libvlc_thumbnailer_request_t;
+
+/** Thumbnail image formats */
+typedef enum libvlc_thumbnail_type_t
+{
+    libvlc_thumbnail_png,
+    libvlc_thumbnail_jpg,
+} libvlc_thumbnail_type_t;
+
+/**
+ * Callback prototype for the thumbnails.
+ * It is called from a thread of the pool, exactly once per request unless
+ * the request is cancelled.
+ *
+ * \param opaque private pointer as passed to libvlc_thumbnailer_request()
+ * \param p_image the encoded image, valid until the callback returns,
+ *        or NULL if no frame could be extracted
+ * \param i_size size of the encoded image, in bytes
+ */
+typedef void (*libvlc_thumbnailer_cb)(void *opaque, const void *p_image,
+                                      size_t i_size);
+
+/**
+ * Create a thumbnailer.
+ *
+ * \param p_instance the libvlc instance
+ * \return a new thumbnailer object, or NULL on error.
+ */
+LIBVLC_API libvlc_thumbnailer_t *
+libvlc_thumbnailer_new( libvlc_instance_t *p_instance );
+
+/**
+ * Release a thumbnailer. The pending requests are cancelled.
+ *
+ * \param p_th the thumbnailer
+ */
+LIBVLC_API void libvlc_thumbnailer_release( libvlc_thumbnailer_t *p_th );
+
+/**
+ * Request a thumbnail. This function returns at once.
+ *
+ * \param p_th the thumbnailer
+ * \param p_md the media
+ * \param i_time time of the thumbnail (in ms) from the start of the media;
+ *        the nearest keyframe is used
+ * \param i_width the thumbnail's width
+ * \param i_height the thumbnail's height
+ * \param i_type the image format
+ * \param i_timeout how long the request may take at most (in ms)
+ * \param cb callback to receive the thumbnail
+ * \param opaque private pointer for the callback
+ * \return the request, or NULL on error
+ *
+ * \note If i_width AND i_height are 0, the original size is used.
+ *       If i_width XOR i_height is 0, the original aspect-ratio is preserved.
+ */
+LIBVLC_API libvlc_thumbnailer_request_t *
+libvlc_thumbnailer_request( libvlc_thumbnailer_t *p_th, libvlc_media_t *p_md,
+                            libvlc_time_t i_time,
+                            unsigned i_width, unsigned i_height,
+                            libvlc_thumbnail_type_t i_type, int i_timeout,
+                            libvlc_thumbnailer_cb cb, void *opaque );
+
+/**
+ * Cancel a request. If its callback is running, this function waits for it.
+ * It must not be called once the callback has returned.
+ *
+ * \param p_th the thumbnailer
+ * \param p_req the request
+ */
+LIBVLC_API void libvlc_thumbnailer_cancel( libvlc_thumbnailer_t *p_th,
+                                           libvlc_thumbnailer_request_t *p_req );
+
+/** @} thumbnailer */
+
+# ifdef __cplusplus
+}
+# endif
+
+#endif /* VLC_LIBVLC_THUMBNAILER_H */
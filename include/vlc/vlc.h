@@ -41,6 +41,9 @@ extern "C" {
 #include <vlc/libvlc.h>
 #include <vlc/libvlc_media.h>
 #include <vlc/libvlc_media_player.h>
+#include <vlc/libvlc_media_worker.h>
+#include <vlc/libvlc_packet.h>
+#include <vlc/libvlc_thumbnailer.h>
 #include <vlc/libvlc_media_list.h>
 #include <vlc/libvlc_media_list_player.h>
 #include <vlc/libvlc_media_library.h>
@@ -57,6 +57,10 @@ enum access_query_e
     /* */
     ACCESS_GET_SIGNAL,      /* arg1=double *pf_quality, arg2=double *pf_strength   res=can fail */
 
+    /* The whole input mapped read-only in memory, for the stream to use
+     * instead of reading */
+    ACCESS_GET_MMAP,        /* arg1= block_t **     res=can fail */
+
     /* */
     ACCESS_SET_PAUSE_STATE = 0x200, /* arg1= bool           can fail */
 
@@ -79,6 +79,12 @@
        || ((p_format)->i_format == VLC_CODEC_A52)       \
        || ((p_format)->i_format == VLC_CODEC_DTS) )
 
+/* Compressed formats which can only be passed through HDMI (IEC 61937 high
+ * bitrate bursts) */
+#define AOUT_FMT_HDMI( p_format ) \
+    ( ((p_format)->i_format == VLC_CODEC_EAC3)         \
+       || ((p_format)->i_format == VLC_CODEC_TRUEHD) )
+
 /* This is heavily borrowed from libmad, by Robert Leslie <rob@mars.org> */
 /*
  * Fixed-point format: 0xABBBBBBB
@@ -186,6 +192,9 @@ struct audio_output
         callback (optional, may be NULL) */
     void (* pf_flush)( audio_output_t *, bool ); /**< Flush/drain callback
         (optional, may be NULL) */
+    int (*pf_time_get)(audio_output_t *, mtime_t *); /**< Delay estimation
+        callback, from the next queued sample to the speakers (optional,
+        may be NULL) */
     aout_volume_cb          pf_volume_set; /**< Volume setter (or NULL) */
 };
 
@@ -294,5 +303,28 @@ VLC_API void aout_PacketFlush(audio_output_t *, bool);
 
 VLC_API block_t *aout_PacketNext(audio_output_t *, mtime_t) VLC_USED;
 
+/* Ring buffer helpers for callback-driven audio outputs */
+typedef struct
+{
+    uint8_t *buffer; /**< Interleaved samples */
+    unsigned size; /**< Capacity in frames (power of two) */
+    unsigned framesize; /**< Bytes per frame */
+    vlc_atomic_t read; /**< Frames consumed by the output callback */
+    vlc_atomic_t write; /**< Frames queued by aout_RingPlay() */
+    vlc_atomic_t flush; /**< Read position to skip to plus one, or zero */
+    vlc_atomic_t paused; /**< Whether the callback must play silence */
+    vlc_atomic_t latency; /**< Output latency after the ring (microseconds) */
+} aout_ring_t;
+
+VLC_API int aout_RingInit(audio_output_t *, aout_ring_t *, mtime_t);
+VLC_API void aout_RingDestroy(audio_output_t *);
+
+VLC_API void aout_RingPlay(audio_output_t *, block_t *);
+VLC_API void aout_RingPause(audio_output_t *, bool, mtime_t);
+VLC_API void aout_RingFlush(audio_output_t *, bool);
+VLC_API int aout_RingTimeGet(audio_output_t *, mtime_t *);
+
+VLC_API unsigned aout_RingRead(audio_output_t *, void *, unsigned);
+
 
 #endif /* VLC_AOUT_H */
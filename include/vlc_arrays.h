@@ -237,6 +237,12 @@ static inline void *realloc_down( void *ptr, size_t size )
     (array).i_size++;                                                       \
   } while(0)
 
+#define ARRAY_RESERVE(array, count)                                         \
+  do {                                                                      \
+    if( (array).i_alloc < (array).i_size + (count) )                        \
+        _ARRAY_ALLOC(array, (array).i_size + (count))                       \
+  } while(0)
+
 #define ARRAY_INSERT(array,elem,pos)                                        \
   do {                                                                      \
     _ARRAY_GROW1(array);                                                    \
@@ -71,6 +71,17 @@ static inline uint32_t bs_read( bs_t *s, int i_count )
     int      i_shr;
     uint32_t i_result = 0;
 
+    /* Fast path: up to 25 bits from one big endian 32-bits load */
+    if( i_count > 0 && i_count <= 25 && s->p_end - s->p >= 4 )
+    {
+        const unsigned i_pos = 8 - s->i_left + i_count;
+
+        i_result = ( GetDWBE( s->p ) << ( 8 - s->i_left ) ) >> ( 32 - i_count );
+        s->p += i_pos / 8;
+        s->i_left = 8 - i_pos % 8;
+        return i_result;
+    }
+
     while( i_count > 0 )
     {
         if( s->p >= s->p_end )
@@ -141,6 +152,37 @@ static inline void bs_skip( bs_t *s, ssize_t i_count )
     }
 }
 
+/* Unsigned Exp-Golomb code, as used by H.264 and HEVC */
+static inline uint32_t bs_read_ue( bs_t *s )
+{
+    unsigned i = 0;
+
+    /* Fast path: codes of up to 25 bits (values below 4095) */
+    if( s->p_end - s->p >= 4 )
+    {
+        const uint32_t i_bits = GetDWBE( s->p ) << ( 8 - s->i_left );
+
+        if( i_bits >= 1u << 19 )
+        {
+            i = clz32( i_bits );
+            bs_skip( s, i + 1 );
+            return ( 1u << i ) - 1 + bs_read( s, i );
+        }
+    }
+
+    while( bs_read1( s ) == 0 && s->p < s->p_end && i < 31 )
+        i++;
+    return ( 1u << i ) - 1 + bs_read( s, i );
+}
+
+/* Signed Exp-Golomb code */
+static inline int32_t bs_read_se( bs_t *s )
+{
+    uint32_t val = bs_read_ue( s );
+
+    return val & 0x01 ? (int32_t)((val + 1) / 2) : -(int32_t)(val / 2);
+}
+
 static inline void bs_write( bs_t *s, int i_count, uint32_t i_bits )
 {
     while( i_count > 0 )
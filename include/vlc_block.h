@@ -134,10 +134,13 @@ struct block_t
  *      with preheader and or body (increase
  *      and decrease are supported). Use it as it is optimised.
  * - block_Duplicate : create a copy of a block.
+ * - block_Slice : create a block sharing part of the payload of another one
+ *      (without copying if the latter comes from block_Alloc).
  ****************************************************************************/
 VLC_API void block_Init( block_t *, void *, size_t );
 VLC_API block_t * block_Alloc( size_t ) VLC_USED;
 VLC_API block_t * block_Realloc( block_t *, ssize_t i_pre, size_t i_body ) VLC_USED;
+VLC_API block_t * block_Slice( block_t *, size_t i_offset, size_t i_size ) VLC_USED;
 
 #define block_New( dummy, size ) block_Alloc(size)
 
@@ -184,6 +187,8 @@ static inline void block_Cleanup (void *block)
  * - block_ChainRelease : release a chain of block
  * - block_ChainExtract : extract data from a chain, return real bytes counts
  * - block_ChainGather : gather a chain, free it and return one block.
+ * - block_ChainJoin : same without copying, if the chain is made of
+ *      consecutive slices of one block, return NULL otherwise.
  ****************************************************************************/
 static inline void block_ChainAppend( block_t **pp_list, block_t *p_block )
 {
@@ -261,6 +266,8 @@ static inline void block_ChainProperties( block_t *p_list, int *pi_count, size_t
         *pi_count = i_count;
 }
 
+VLC_API block_t * block_ChainJoin( block_t * ) VLC_USED;
+
 static inline block_t *block_ChainGather( block_t *p_list )
 {
     size_t  i_total = 0;
@@ -272,16 +279,24 @@ static inline block_t *block_ChainGather( block_t *p_list )
 
     block_ChainProperties( p_list, NULL, &i_total, &i_length );
 
-    g = block_Alloc( i_total );
-    block_ChainExtract( p_list, g->p_buffer, g->i_buffer );
+    const uint32_t i_flags = p_list->i_flags;
+    const mtime_t i_pts = p_list->i_pts;
+    const mtime_t i_dts = p_list->i_dts;
 
-    g->i_flags = p_list->i_flags;
-    g->i_pts   = p_list->i_pts;
-    g->i_dts   = p_list->i_dts;
-    g->i_length = i_length;
+    g = block_ChainJoin( p_list );
+    if( g == NULL )
+    {
+        g = block_Alloc( i_total );
+        block_ChainExtract( p_list, g->p_buffer, g->i_buffer );
 
-    /* free p_list */
-    block_ChainRelease( p_list );
+        /* free p_list */
+        block_ChainRelease( p_list );
+    }
+
+    g->i_flags = i_flags;
+    g->i_pts   = i_pts;
+    g->i_dts   = i_dts;
+    g->i_length = i_length;
     return g;
 }
 
@@ -289,11 +304,13 @@ static inline block_t *block_ChainGather( block_t *p_list )
  * Fifos of blocks.
  ****************************************************************************
  * - block_FifoNew : create and init a new fifo
+ * - block_FifoNewSPSC : same, without locking, for a single getter thread
  * - block_FifoRelease : destroy a fifo and free all blocks in it.
  * - block_FifoPace : wait for a fifo to drain to a specified number of packets or total data size
  * - block_FifoEmpty : free all blocks in a fifo
  * - block_FifoPut : put a block
  * - block_FifoGet : get a packet from the fifo (and wait if it is empty)
+ * - block_FifoGetUpTo : same, several packets at once as a chain
  * - block_FifoShow : show the first packet of the fifo (and wait if
  *      needed), be carefull, you can use it ONLY if you are sure to be the
  *      only one getting data from the fifo.
@@ -301,16 +318,19 @@ static inline block_t *block_ChainGather( block_t *p_list )
  * - block_FifoWake : wake ups a thread with block_FifoGet() = NULL
  *   (this is used to wakeup a thread when there is no data to queue)
  *
- * block_FifoGet and block_FifoShow are cancellation points.
+ * block_FifoGet, block_FifoGetUpTo and block_FifoShow are cancellation
+ * points.
  ****************************************************************************/
 
 VLC_API block_fifo_t * block_FifoNew( void ) VLC_USED;
+VLC_API block_fifo_t * block_FifoNewSPSC( void ) VLC_USED;
 VLC_API void block_FifoRelease( block_fifo_t * );
 VLC_API void block_FifoPace( block_fifo_t *fifo, size_t max_depth, size_t max_size );
 VLC_API void block_FifoEmpty( block_fifo_t * );
 VLC_API size_t block_FifoPut( block_fifo_t *, block_t * );
 VLC_API void block_FifoWake( block_fifo_t * );
 VLC_API block_t * block_FifoGet( block_fifo_t * ) VLC_USED;
+VLC_API block_t * block_FifoGetUpTo( block_fifo_t *, size_t max_blocks, size_t max_bytes ) VLC_USED;
 VLC_API block_t * block_FifoShow( block_fifo_t * );
 size_t block_FifoSize( const block_fifo_t *p_fifo ) VLC_USED;
 VLC_API size_t block_FifoCount( const block_fifo_t *p_fifo ) VLC_USED;
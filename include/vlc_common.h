@@ -239,6 +239,7 @@ typedef struct playlist_view_t playlist_view_t;
 typedef struct services_discovery_t services_discovery_t;
 typedef struct services_discovery_sys_t services_discovery_sys_t;
 typedef struct playlist_add_t playlist_add_t;
+typedef struct playlist_add_range_t playlist_add_range_t;
 
 /* Modules */
 typedef struct module_t module_t;
@@ -354,6 +355,7 @@ typedef struct httpd_handler_sys_t httpd_handler_sys_t;
 typedef int (*httpd_handler_callback_t)( httpd_handler_sys_t *, httpd_handler_t *, char *psz_url, uint8_t *psz_request, int i_type, uint8_t *p_in, int i_in, char *psz_remote_addr, char *psz_remote_host, uint8_t **pp_data, int *pi_data );
 typedef struct httpd_redirect_t httpd_redirect_t;
 typedef struct httpd_stream_t httpd_stream_t;
+typedef struct httpd_live_t httpd_live_t;
 
 /* Hashing */
 typedef struct md5_s md5_t;
@@ -37,6 +37,9 @@
 #  define CPU_CAPABILITY_SSE4_1  (1<<10)
 #  define CPU_CAPABILITY_SSE4_2  (1<<11)
 #  define CPU_CAPABILITY_SSE4A   (1<<12)
+#  define CPU_CAPABILITY_AVX2    (1<<13)
+#  define CPU_CAPABILITY_AVX     (1<<14)
+#  define CPU_CAPABILITY_AVX512  (1<<15) /* AVX-512 F and BW */
 
 # if defined (__MMX__)
 #  define VLC_MMX
@@ -54,6 +57,38 @@
 #  define VLC_SSE VLC_SSE_is_not_implemented_on_this_compiler
 # endif
 
+# if defined (__SSE2__)
+#  define VLC_SSE2
+# elif VLC_GCC_VERSION(4, 4)
+#  define VLC_SSE2 __attribute__ ((__target__ ("sse2")))
+# else
+#  define VLC_SSE2 VLC_SSE2_is_not_implemented_on_this_compiler
+# endif
+
+# if defined (__AVX__)
+#  define VLC_AVX
+# elif VLC_GCC_VERSION(4, 4)
+#  define VLC_AVX __attribute__ ((__target__ ("avx")))
+# else
+#  define VLC_AVX VLC_AVX_is_not_implemented_on_this_compiler
+# endif
+
+# if defined (__AVX2__)
+#  define VLC_AVX2
+# elif VLC_GCC_VERSION(4, 9)
+#  define VLC_AVX2 __attribute__ ((__target__ ("avx2")))
+# else
+#  define VLC_AVX2 VLC_AVX2_is_not_implemented_on_this_compiler
+# endif
+
+# if defined (__AVX512F__) && defined (__AVX512BW__)
+#  define VLC_AVX512
+# elif VLC_GCC_VERSION(5, 0)
+#  define VLC_AVX512 __attribute__ ((__target__ ("avx512f,avx512bw")))
+# else
+#  define VLC_AVX512 VLC_AVX512_is_not_implemented_on_this_compiler
+# endif
+
 # else
 #  define CPU_CAPABILITY_MMX     (0)
 #  define CPU_CAPABILITY_3DNOW   (0)
@@ -65,6 +100,9 @@
 #  define CPU_CAPABILITY_SSE4_1  (0)
 #  define CPU_CAPABILITY_SSE4_2  (0)
 #  define CPU_CAPABILITY_SSE4A   (0)
+#  define CPU_CAPABILITY_AVX2    (0)
+#  define CPU_CAPABILITY_AVX     (0)
+#  define CPU_CAPABILITY_AVX512  (0)
 # endif
 
 # if defined (__ppc__) || defined (__ppc64__) || defined (__powerpc__)
@@ -73,14 +111,49 @@
 #  define CPU_CAPABILITY_ALTIVEC (0)
 # endif
 
-# if defined (__arm__)
+# if defined (__arm__) || defined (__aarch64__)
 #  define CPU_CAPABILITY_NEON    (1<<24)
 # else
 #  define CPU_CAPABILITY_NEON    (0)
 # endif
 
+# if defined (__aarch64__)
+#  define CPU_CAPABILITY_SVE     (1<<25)
+# else
+#  define CPU_CAPABILITY_SVE     (0)
+# endif
+
+/**
+ * Retrieves the CPU capability flags.
+ * For testing, the VLC_CPU environment variable limits them to a given tier
+ * and the lower ones, e.g. VLC_CPU=sse2, or VLC_CPU=none for plain C.
+ */
 VLC_API unsigned vlc_CPU( void );
 
+/**
+ * Picks the best implementation of a kernel that the CPU supports.
+ * The table entries have a "func" member and a "cpu" member with the
+ * capabilities the function requires. They are ordered from the most to the
+ * least demanding, and the table must end with a plain C entry (cpu 0).
+ * Tables are meant to be resolved once, when the module is opened.
+ * @return the func member of the selected entry
+ */
+#define vlc_CPU_select(table) \
+    ((table)[vlc_CPU_index (&(table)[0].cpu, sizeof ((table)[0]))].func)
+
+static inline size_t vlc_CPU_index (const unsigned *cpu, size_t stride)
+{
+    const unsigned flags = vlc_CPU ();
+    size_t i = 0;
+
+    while ((*cpu & flags) != *cpu)
+    {
+        cpu = (const unsigned *)((const char *)cpu + stride);
+        i++;
+    }
+    return i;
+}
+
 /** Are floating point operations fast?
  * If this bit is not set, you should try to use fixed-point instead.
  */
@@ -90,6 +163,9 @@ VLC_API unsigned vlc_CPU( void );
 # elif defined (__powerpc__) || defined (__ppc__) || defined (__ppc64__)
 #  define HAVE_FPU 1
 
+# elif defined (__aarch64__)
+#  define HAVE_FPU 1
+
 # elif defined (__arm__)
 #  if defined (__VFP_FP__) && !defined (__SOFTFP__)
 #   define HAVE_FPU 1
@@ -0,0 +1,49 @@
+/*****************************************************************************
+ * vlc_crc.h: cyclic redundancy checks
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_CRC_H
+# define VLC_CRC_H
+
+/**
+ * \file
+ * This file defines the CRCs used by the multimedia formats. They are all
+ * computed most significant bit first, without final inversion, and can be
+ * computed piecewise by passing the result of a call to the next one.
+ */
+
+/**
+ * CRC-32 of the MPEG-2 systems (ISO/IEC 13818-1 annex A), used by the PSI
+ * sections and the program stream directories. Starts with 0xFFFFFFFF.
+ */
+VLC_API uint32_t vlc_crc32_mpeg( uint32_t crc, const void *, size_t ) VLC_USED;
+
+/**
+ * CRC-16 with polynomial x^16 + x^15 + x^2 + 1, used by FLAC frames (from 0)
+ * and A/52 (from 0).
+ */
+VLC_API uint16_t vlc_crc16( uint16_t crc, const void *, size_t ) VLC_USED;
+
+/**
+ * CRC-8 with polynomial x^8 + x^2 + x + 1, used by FLAC frame headers
+ * (from 0).
+ */
+VLC_API uint8_t vlc_crc8( uint8_t crc, const void *, size_t ) VLC_USED;
+
+#endif
@@ -57,6 +57,10 @@ struct demux_t
     /* es output */
     es_out_t    *out;   /* our p_es_out */
 
+    /* Only the meta data will be used (preparsing): the demuxer may skip
+     * whatever is needed only to play the stream */
+    bool        b_meta_only;
+
     /* set by demuxer */
     int (*pf_demux)  ( demux_t * );   /* demux one frame only */
     int (*pf_control)( demux_t *, int i_query, va_list args);
@@ -207,6 +211,32 @@ VLC_API void demux_PacketizerDestroy( decoder_t *p_packetizer );
  */
 VLC_API input_thread_t * demux_GetParentInput( demux_t *p_demux ) VLC_USED;
 
+/**
+ * This function returns the path of the file a demuxer may keep what it
+ * learnt by scanning its input in, such as a seek index, in the psz_name
+ * directory of the user cache. Only local files have one: the path depends
+ * on their size and modification date, so that a file that changed is
+ * scanned again. The demuxer checks what it reads from it anyway.
+ *
+ * Returns NULL if there is none, the path must be freed otherwise.
+ */
+VLC_API char * demux_IndexCachePath( demux_t *p_demux, const char *psz_name ) VLC_USED VLC_MALLOC;
+
+/**
+ * This function opens a temporary file next to psz_path to write an index
+ * in, creating the cache directories as needed and removing the oldest
+ * files of the directory beyond its limits. It must be closed with
+ * demux_IndexCacheClose. Returns NULL on error.
+ */
+VLC_API FILE * demux_IndexCacheCreate( demux_t *p_demux, const char *psz_path ) VLC_USED;
+
+/**
+ * This function closes a file opened by demux_IndexCacheCreate. If b_ok is
+ * true and it could be written out, it replaces psz_path, it is removed
+ * otherwise.
+ */
+VLC_API int demux_IndexCacheClose( demux_t *p_demux, const char *psz_path, FILE *p_file, bool b_ok );
+
 /* */
 #define DEMUX_INIT_COMMON() do {            \
     p_demux->pf_control = Control;          \
@@ -160,6 +160,7 @@ typedef struct vlc_event_t
         struct vlc_input_item_subitem_tree_added
         {
             input_item_node_t * p_root;
+            bool b_partial; /* more subitems will follow */
         } input_item_subitem_tree_added;
         struct vlc_input_item_duration_changed
         {
@@ -0,0 +1,130 @@
+/*****************************************************************************
+ * vlc_executor.h: thread pool running tasks
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_EXECUTOR_H
+# define VLC_EXECUTOR_H
+
+/**
+ * \file
+ * This file defines a pool of threads running short tasks, so that work can
+ * be done in the background without a thread per object.
+ *
+ * Each thread of the pool has its own queue. A task goes to the queue of the
+ * thread given by its affinity hint, if any, and idle threads steal the tasks
+ * queued to busy ones. Tasks of higher priority are always run first.
+ *
+ * The tasks belong to the caller, which must keep them alive until they have
+ * been run or cancelled. The executor does not touch a task anymore once its
+ * function has been called, so that the function may free or submit again
+ * its own task.
+ */
+
+typedef struct vlc_executor_t vlc_executor_t;
+
+enum vlc_task_priority
+{
+    VLC_TASK_LOW,    /**< background work (preparsing, art fetching...) */
+    VLC_TASK_NORMAL,
+    VLC_TASK_HIGH,   /**< work that the playback is waiting for */
+};
+#define VLC_TASK_PRIORITIES 3
+
+typedef struct vlc_task_t vlc_task_t;
+
+struct vlc_task_t
+{
+    void (*pf_run)( void * ); /**< function to run */
+    void  *p_data;            /**< parameter for pf_run */
+    int    i_priority;        /**< VLC_TASK_* */
+    int    i_affinity;        /**< preferred thread, or -1 for any */
+
+    /* Private */
+    vlc_task_t *p_next;
+    unsigned    i_queue;
+    bool        b_queued;
+};
+
+/**
+ * Initializes a task of normal priority without affinity.
+ */
+static inline void vlc_task_Init( vlc_task_t *p_task,
+                                  void (*pf_run)( void * ), void *p_data )
+{
+    p_task->pf_run = pf_run;
+    p_task->p_data = p_data;
+    p_task->i_priority = VLC_TASK_NORMAL;
+    p_task->i_affinity = -1;
+    p_task->b_queued = false;
+}
+
+/**
+ * Creates an executor. The threads are started as tasks are submitted.
+ * @param i_threads maximum number of threads, 0 for the number of CPUs
+ * @param i_priority thread priority (VLC_THREAD_PRIORITY_*)
+ */
+VLC_API vlc_executor_t *vlc_executor_New( unsigned i_threads,
+                                          int i_priority ) VLC_USED;
+
+/**
+ * Destroys an executor. The queued tasks are dropped, and the running ones
+ * are waited for.
+ */
+VLC_API void vlc_executor_Delete( vlc_executor_t * );
+
+/**
+ * Returns the executor shared by all the objects of a LibVLC instance.
+ * Its threads run at VLC_THREAD_PRIORITY_LOW; their count is bounded by the
+ * number of CPUs. Tasks submitted to it must not block for long.
+ */
+VLC_API vlc_executor_t *vlc_executor_Get( vlc_object_t * ) VLC_USED;
+#define vlc_executor_Get(o) vlc_executor_Get(VLC_OBJECT(o))
+
+/**
+ * Returns the maximum number of threads of an executor, i.e. the range of
+ * useful affinity hints.
+ */
+VLC_API unsigned vlc_executor_GetThreadCount( vlc_executor_t * ) VLC_USED;
+
+/**
+ * Queues a task. The task must not be queued already.
+ * @return VLC_SUCCESS, or an error if no thread could be started
+ */
+VLC_API int vlc_executor_Submit( vlc_executor_t *, vlc_task_t * );
+
+/**
+ * Cancels a task. If the task is still queued, it is removed and will not
+ * run. If it is running, it is flagged (see vlc_executor_IsCanceled()) and
+ * waited for.
+ * @return true if the task was removed before running
+ */
+VLC_API bool vlc_executor_Cancel( vlc_executor_t *, vlc_task_t * );
+
+/**
+ * Waits until a task is neither queued nor running.
+ */
+VLC_API void vlc_executor_Wait( vlc_executor_t *, vlc_task_t * );
+
+/**
+ * Tells whether vlc_executor_Cancel() was called for a running task, so that
+ * long tasks can stop early. This must be called from the task function.
+ */
+VLC_API bool vlc_executor_IsCanceled( vlc_executor_t *, vlc_task_t * ) VLC_USED;
+
+#endif
@@ -36,6 +36,7 @@
  */
 
 typedef struct filter_owner_sys_t filter_owner_sys_t;
+typedef struct filter_slice_pool_t filter_slice_pool_t;
 
 /** Structure describing a filter
  * @warning BIG FAT WARNING : the code relies on the first 4 members of
@@ -140,8 +141,56 @@ struct filter_t
 
     /* Private structure for the owner of the decoder */
     filter_owner_sys_t *p_owner;
+
+    /* Set by the module if its video filter splits its work with
+     * filter_ExecuteSlices() */
+    bool b_slice_threads;
+
+    /* Worker pool used by filter_ExecuteSlices(), set by the owner */
+    filter_slice_pool_t *p_slice_pool;
 };
 
+/**
+ * Callback processing one horizontal slice of a picture.
+ *
+ * \param p_filter filter_t object
+ * \param p_data opaque data given to filter_ExecuteSlices
+ * \param i_slice index of the slice to process
+ * \param i_slice_count number of slices
+ */
+typedef void (*filter_slice_cb_t)( filter_t *p_filter, void *p_data,
+                                   int i_slice, int i_slice_count );
+
+/**
+ * This function calls pf_slice once for each slice of the picture, in
+ * parallel on the worker pool of the filter if it has one, and returns once
+ * all slices are processed. The slices must be independent of each other.
+ */
+VLC_API void filter_ExecuteSlices( filter_t *, filter_slice_cb_t pf_slice, void *p_data );
+
+/**
+ * This function returns the number of slices filter_ExecuteSlices() calls
+ * the callback with, so that a filter can prepare per slice data.
+ */
+VLC_API int filter_GetSliceCount( const filter_t * );
+
+/**
+ * This function gives the range of lines of a plane covered by a slice.
+ * The planes are split proportionally, so that a slice covers the same part
+ * of the picture in each plane.
+ */
+static inline void plane_GetSlice( const plane_t *p_plane, int i_slice,
+                                   int i_slice_count,
+                                   int *pi_first_line, int *pi_line_count )
+{
+    const int i_lines = p_plane->i_visible_lines;
+    const int i_first = i_lines * i_slice / i_slice_count;
+    const int i_last  = i_lines * (i_slice + 1) / i_slice_count;
+
+    *pi_first_line = i_first;
+    *pi_line_count = i_last - i_first;
+}
+
 /**
  * This function will return a new picture usable by p_filter as an output
  * buffer. You have to release it using filter_DeletePicture or by returning
@@ -130,6 +130,11 @@ VLC_API void httpd_StreamDelete( httpd_stream_t * );
 VLC_API int httpd_StreamHeader( httpd_stream_t *, uint8_t *p_data, int i_data );
 VLC_API int httpd_StreamSend( httpd_stream_t *, uint8_t *p_data, int i_data );
 
+VLC_API httpd_live_t * httpd_LiveNew( httpd_host_t *, const char *psz_url, const char *psz_mime, const char *psz_user, const char *psz_password, const vlc_acl_t *p_acl ) VLC_USED;
+VLC_API void httpd_LiveDelete( httpd_live_t * );
+VLC_API int httpd_LiveAppend( httpd_live_t *, const uint8_t *p_data, size_t i_data );
+VLC_API void httpd_LiveEnd( httpd_live_t * );
+
 
 /* Msg functions facilities */
 VLC_API void httpd_MsgAdd( httpd_message_t *, const char *psz_name, const char *psz_value, ... ) VLC_FORMAT( 3, 4 );
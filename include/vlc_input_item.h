@@ -89,6 +89,8 @@ struct input_item_t
     uint8_t     i_type;              /**< Type (file, disc, ... see input_item_type_e) */
     bool        b_fixed_name;        /**< Can the interface change the name ?*/
     bool        b_error_when_reading;/**< Error When Reading */
+
+    int64_t     i_preparse_mtime;    /**< File date when last preparsed */
 };
 
 enum input_item_type_e
@@ -165,6 +167,16 @@ VLC_API void input_item_node_Delete( input_item_node_t *p_node );
  */
 VLC_API void input_item_node_PostAndDelete( input_item_node_t *p_node );
 
+/**
+ * Post the subitems added so far, while more are still to come.
+ *
+ * Sends the same events as input_item_node_PostAndDelete(), then deletes the
+ * children nodes only. The root node can be filled again, and must finally be
+ * posted with input_item_node_PostAndDelete().
+ * This lets long lists appear, and play, before they are completely parsed.
+ */
+VLC_API void input_item_node_PostBatch( input_item_node_t *p_node );
+
 
 /**
  * Option flags
@@ -288,14 +300,24 @@ struct input_stats_t
     float f_average_demux_bitrate;
     int64_t i_demux_corrupted;
     int64_t i_demux_discontinuity;
+    int64_t i_demux_latency; /* reception to presentation, in us */
 
     /* Decoders */
     int64_t i_decoded_audio;
     int64_t i_decoded_video;
+    int64_t i_video_decode_time_p50; /* per output picture, in us */
+    int64_t i_video_decode_time_p90;
+    int64_t i_video_decode_time_p99;
+    int64_t i_audio_decode_time_p50; /* per output buffer, in us */
+    int64_t i_audio_decode_time_p90;
+    int64_t i_audio_decode_time_p99;
 
     /* Vout */
     int64_t i_displayed_pictures;
     int64_t i_lost_pictures;
+    int64_t i_video_latency_p50; /* decoder output to display, in us */
+    int64_t i_video_latency_p90;
+    int64_t i_video_latency_p99;
 
     /* Sout */
     int64_t i_sent_packets;
@@ -305,6 +327,23 @@ struct input_stats_t
     /* Aout */
     int64_t i_played_abuffers;
     int64_t i_lost_abuffers;
+    int64_t i_audio_filter_time; /* in us */
+    int64_t i_audio_resampler_time; /* in us */
+    int64_t i_audio_output_time; /* in us */
+    int64_t i_audio_allocations;
+    int64_t i_audio_buffered; /* in us */
+    int64_t i_audio_delay; /* output reported, in us, -1 if unknown */
+
+    /* Synchronicity */
+    int64_t i_syn_rtt;
+    int64_t i_syn_offset;
+    int64_t i_syn_offset_error;
+    int64_t i_syn_sent_bytes;
+    int64_t i_syn_received_bytes;
+    int64_t i_syn_beacons;
+    int64_t i_syn_beacon_replies;
+    int64_t i_syn_seeks;
+    int64_t i_syn_slews;
 };
 
 #endif
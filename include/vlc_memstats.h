@@ -0,0 +1,84 @@
+/*****************************************************************************
+ * vlc_memstats.h: per-subsystem memory accounting
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_MEMSTATS_H
+# define VLC_MEMSTATS_H
+
+/**
+ * \file
+ * This file defines functions to account the memory of the subsystems.
+ *
+ * The large allocations of a subsystem (buffers, caches, pools) are tagged:
+ * the counters of the tag follow the live bytes, their peak, and the number
+ * of allocations and releases. The counters are process-wide, and updated
+ * without locking. Accounting is compiled in LibVLC with --enable-memstats;
+ * otherwise vlc_memstats_Add() does nothing and vlc_memstats_Get() fails.
+ */
+
+enum vlc_mem_tag
+{
+    VLC_MEM_BLOCK,      /**< block_Alloc() buffers in use */
+    VLC_MEM_PICTURE,    /**< picture buffers, including the picture pools */
+    VLC_MEM_STREAM,     /**< stream caches and read-ahead buffers */
+    VLC_MEM_TIMESHIFT,  /**< timeshift command queues and file mappings */
+    VLC_MEM_PLAYLIST,   /**< input and playlist items */
+    VLC_MEM_MODULES,    /**< module bank */
+    VLC_MEM_OTHER,      /**< plugins */
+    VLC_MEM_TAGS
+};
+
+typedef struct
+{
+    int64_t  i_live;    /**< bytes allocated and not released */
+    int64_t  i_peak;    /**< highest i_live so far */
+    uint64_t i_allocs;  /**< allocations so far */
+    uint64_t i_frees;   /**< releases so far */
+} vlc_memstats_t;
+
+VLC_API void vlc_memstats_Add( unsigned i_tag, ssize_t i_bytes );
+VLC_API int vlc_memstats_Get( unsigned i_tag, vlc_memstats_t * );
+VLC_API const char *vlc_memstats_Name( unsigned i_tag ) VLC_USED;
+
+/** Accounts an allocation of size bytes */
+#define VLC_MEM_ALLOC(tag, size) vlc_memstats_Add(tag, size)
+/** Accounts the release of an allocation of size bytes */
+#define VLC_MEM_FREE(tag, size)  vlc_memstats_Add(tag, -(ssize_t)(size))
+
+/**
+ * Allocates memory accounted to a tag.
+ * It must be released with vlc_free_tagged(), with the same size.
+ */
+VLC_USED VLC_MALLOC
+static inline void *vlc_malloc_tagged( unsigned i_tag, size_t i_size )
+{
+    void *p = malloc( i_size );
+    if( likely(p != NULL) )
+        VLC_MEM_ALLOC( i_tag, i_size );
+    return p;
+}
+
+static inline void vlc_free_tagged( unsigned i_tag, void *p, size_t i_size )
+{
+    if( p != NULL )
+        VLC_MEM_FREE( i_tag, i_size );
+    free( p );
+}
+
+#endif
@@ -40,6 +40,8 @@ VLC_API void vlc_module_unload( module_t *, vlc_deactivate_t deinit, ... );
 
 VLC_API module_t * module_need( vlc_object_t *, const char *, const char *, bool ) VLC_USED;
 #define module_need(a,b,c,d) module_need(VLC_OBJECT(a),b,c,d)
+VLC_API module_t * module_need_codec( vlc_object_t *, const char *, const char *, bool, vlc_fourcc_t ) VLC_USED;
+#define module_need_codec(a,b,c,d,e) module_need_codec(VLC_OBJECT(a),b,c,d,e)
 VLC_API void module_unneed( vlc_object_t *, module_t * );
 #define module_unneed(a,b) module_unneed(VLC_OBJECT(a),b)
 VLC_API bool module_exists(const char *) VLC_USED;
@@ -43,6 +43,13 @@ typedef struct picture_fifo_t picture_fifo_t;
  */
 VLC_API picture_fifo_t * picture_fifo_New( void ) VLC_USED;
 
+/**
+ * It creates an empty picture_fifo_t for a single thread getting pictures
+ * (pop, peek, flush and offset), pictures being pushed from any thread.
+ * Push and pop do not lock.
+ */
+VLC_API picture_fifo_t * picture_fifo_NewSPSC( void ) VLC_USED;
+
 /**
  * It destroys a fifo created by picture_fifo_New.
  *
@@ -66,6 +73,11 @@ VLC_API picture_t * picture_fifo_Pop( picture_fifo_t * ) VLC_USED;
  */
 VLC_API picture_t * picture_fifo_Peek( picture_fifo_t * ) VLC_USED;
 
+/**
+ * It returns whether the fifo is empty. It can be called from any thread.
+ */
+VLC_API bool picture_fifo_IsEmpty( picture_fifo_t * ) VLC_USED;
+
 /**
  * It saves a picture_t into the fifo.
  */
@@ -35,7 +35,8 @@
  * Picture pool handle
  *
  * XXX it is not thread safe, all pool manipulations and picture_Release
- * must be properly locked if needed.
+ * must be properly locked if needed. Only the return of a picture to its
+ * pool, once its last reference is released, is safe from any thread.
  */
 typedef struct picture_pool_t picture_pool_t;
 
@@ -121,6 +122,12 @@ VLC_API picture_pool_t * picture_pool_Reserve(picture_pool_t *, int picture_coun
  */
 VLC_API int picture_pool_GetSize(picture_pool_t *);
 
+/**
+ * It returns the highest number of pictures that were in use at once,
+ * and the number of times picture_pool_Get failed because none was free.
+ */
+VLC_API void picture_pool_GetStats(picture_pool_t *, unsigned *used_max, unsigned *starved);
+
 
 #endif /* VLC_PICTURE_POOL_H */
 
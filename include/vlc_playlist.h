@@ -106,6 +106,9 @@ TYPEDEF_ARRAY(playlist_item_t*, playlist_item_array_t)
  * item being played.
  *
  * - "playlist-item-append": It will contain a pointer to a playlist_add_t.
+ * - "playlist-items-append": It will contain a pointer to a
+ * playlist_add_range_t, for items added together by playlist_NodeAddInputs
+ * (no "playlist-item-append" is sent for those).
  * - "playlist-item-deleted": It will contain the playlist_item_t->i_id of a
  * deleted playlist_item_t.
  *
@@ -191,6 +194,15 @@ struct playlist_add_t
     int i_item; /**< Playist id of the playlist_item_t */
 };
 
+/** Helper to add several items at once */
+struct playlist_add_range_t
+{
+    int i_node;  /**< Playlist id of the parent node */
+    int i_item;  /**< Playlist id of the first item, the others follow */
+    int i_count; /**< Number of items */
+    int i_pos;   /**< Index of the first item in the children of the node */
+};
+
 /* A bit of macro magic to generate an enum out of the following list,
  * and later, to generate a list of static functions out of the same list.
  * There is also SORT_RANDOM, which is always last and handled specially.
@@ -342,6 +354,7 @@ VLC_API int playlist_Add( playlist_t *, const char *, const char *, int, int, bo
 VLC_API int playlist_AddExt( playlist_t *, const char *, const char *, int, int, mtime_t, int, const char *const *, unsigned, bool, bool );
 VLC_API int playlist_AddInput( playlist_t *, input_item_t *, int, int, bool, bool );
 VLC_API playlist_item_t * playlist_NodeAddInput( playlist_t *, input_item_t *, playlist_item_t *, int, int, bool );
+VLC_API int playlist_NodeAddInputs( playlist_t *, input_item_t *const *, int, playlist_item_t *, int, int, bool );
 VLC_API int playlist_NodeAddCopy( playlist_t *, playlist_item_t *, playlist_item_t *, int );
 
 /********************************** Item search *************************/
@@ -364,6 +377,49 @@ VLC_API int playlist_NodeDelete( playlist_t *, playlist_item_t *, bool , bool );
 VLC_API playlist_item_t * playlist_GetNextLeaf( playlist_t *p_playlist, playlist_item_t *p_root, playlist_item_t *p_item, bool b_ena, bool b_unplayed ) VLC_USED;
 VLC_API playlist_item_t * playlist_GetPrevLeaf( playlist_t *p_playlist, playlist_item_t *p_root, playlist_item_t *p_item, bool b_ena, bool b_unplayed ) VLC_USED;
 
+/********************************************************
+ * Change log
+ ********************************************************/
+/** Kinds of tree changes, see playlist_GetChanges() */
+enum playlist_change_type_e
+{
+    PLAYLIST_CHANGE_ADDED,     /**< i_count items added to i_node, from i_id */
+    PLAYLIST_CHANGE_DELETED,   /**< item or node i_id deleted */
+    PLAYLIST_CHANGE_UPDATED,   /**< meta, duration or type of i_id changed */
+    PLAYLIST_CHANGE_REORDERED, /**< children of node i_id moved or sorted */
+};
+
+/** A change of the playlist tree */
+typedef struct
+{
+    uint64_t i_revision; /**< revision of the tree after the change */
+    int      i_type;     /**< playlist_change_type_e */
+    int      i_id;
+    int      i_node;     /**< parent node, for PLAYLIST_CHANGE_ADDED */
+    int      i_count;    /**< for PLAYLIST_CHANGE_ADDED, the ids follow */
+} playlist_change_t;
+
+/**
+ * Gets the changes of the tree after a revision, oldest first.
+ * Only the last changes are kept: a client that is too late must read the
+ * whole tree again. The playlist lock must not be held.
+ * \param i_since last revision seen by the caller (0 for none)
+ * \param pp_changes changes to free(), NULL if there is none
+ * \param pi_revision current revision
+ * \return VLC_SUCCESS, VLC_EGENERIC if i_since is too old, or VLC_ENOMEM
+ */
+VLC_API int playlist_GetChanges( playlist_t *, uint64_t i_since,
+                                 playlist_change_t **pp_changes,
+                                 unsigned *pi_count, uint64_t *pi_revision );
+
+/**
+ * Waits until the revision of the tree is not i_since anymore, or until a
+ * deadline. This is a cancellation point.
+ * \return the current revision
+ */
+VLC_API uint64_t playlist_WaitChange( playlist_t *, uint64_t i_since,
+                                      mtime_t deadline );
+
 /***********************************************************************
  * Inline functions
  ***********************************************************************/
@@ -395,6 +451,8 @@ VLC_API void playlist_SynConnect(playlist_t*, const char*);
 VLC_API void playlist_SynHost(playlist_t*);
 VLC_API size_t playlist_SynGetHostAddrLen(playlist_t*);
 VLC_API void playlist_SynGetHostAddr(playlist_t*, char*, size_t);
+VLC_API int playlist_SynGetStreamKey(playlist_t*, char*, size_t);
+VLC_API int playlist_SynGetClockOffset(playlist_t*, mtime_t*);
 VLC_API void playlist_SynDisconnect(playlist_t*);
 
 /** @} */
@@ -48,6 +48,7 @@ enum vlc_module_properties
     VLC_MODULE_DESCRIPTION,
     VLC_MODULE_HELP,
     VLC_MODULE_TEXTDOMAIN,
+    VLC_MODULE_CODEC,
     /* Insert new VLC_MODULE_* here */
 
     /* DO NOT EVER REMOVE, INSERT OR REPLACE ANY ITEM! It would break the ABI!
@@ -215,6 +216,12 @@ VLC_METADATA_EXPORTS
      || vlc_module_set (VLC_MODULE_SCORE, (int)(score))) \
         goto error;
 
+/* Codec handled by the module (decoders, packetizers...). A module that
+ * declares some is not loaded for other codecs. */
+#define add_codec( codec ) \
+    if (vlc_module_set (VLC_MODULE_CODEC, (unsigned)(codec))) \
+        goto error;
+
 #define set_callbacks( activate, deactivate ) \
     if (vlc_module_set (VLC_MODULE_CB_OPEN, activate) \
      || vlc_module_set (VLC_MODULE_CB_CLOSE, deactivate)) \
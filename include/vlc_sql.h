@@ -135,6 +135,13 @@ struct sql_t
 
     /** Get column size of a specified column */
     int (*pf_getcolumnsize) ( sql_t* p_sql, sql_stmt_t* p_stmt, int i_col );
+
+    /** Get the number of columns of the statement results */
+    int (*pf_getcolumncount) ( sql_t* p_sql, sql_stmt_t* p_stmt );
+
+    /** Get the name of a specified column */
+    const char* (*pf_getcolumnname) ( sql_t* p_sql, sql_stmt_t* p_stmt,
+                                      int i_col );
 };
 
 /*****************************************************************************
@@ -164,6 +171,23 @@ VLC_API sql_t *sql_Create( vlc_object_t *p_this, const char *psz_name,
 VLC_API void sql_Destroy( vlc_object_t *obj );
 #define sql_Destroy( a ) sql_Destroy( VLC_OBJECT( a ) )
 
+/**
+ * @brief Get a prepared statement for a query, from the statement cache
+ * @param p_sql This SQL object
+ * @param psz_query The SQL query, with '?' for the parameters
+ * @return a statement to hand back with sql_PutStatement(), or NULL
+ * @note The query text is the cache key: bind the values that change
+ * instead of printing them in the query.
+ */
+VLC_API sql_stmt_t *sql_GetStatement( sql_t *p_sql, const char *psz_query );
+
+/**
+ * @brief Give back a statement obtained with sql_GetStatement()
+ * @param p_sql This SQL object
+ * @param p_stmt The statement, which is reset (or finalized if not cached)
+ */
+VLC_API void sql_PutStatement( sql_t *p_sql, sql_stmt_t *p_stmt );
+
 
 /**
  * @brief Perform a query using a callback function
@@ -569,6 +593,30 @@ static inline int sql_GetColumnSize( sql_t* p_sql, sql_stmt_t* p_stmt,
     return p_sql->pf_getcolumnsize( p_sql, p_stmt, i_col );
 }
 
+/**
+ * @brief Get the number of columns in the results of a statement
+ * @param p_sql The SQL object
+ * @param p_stmt The sql statement object
+ * @return Number of columns, 0 if the statement returns no data
+ */
+static inline int sql_GetColumnCount( sql_t* p_sql, sql_stmt_t* p_stmt )
+{
+    return p_sql->pf_getcolumncount( p_sql, p_stmt );
+}
+
+/**
+ * @brief Get the name of a column in the results of a statement
+ * @param p_sql The SQL object
+ * @param p_stmt The sql statement object
+ * @param i_col The column
+ * @return Name of the column, valid until the statement is finalized
+ */
+static inline const char* sql_GetColumnName( sql_t* p_sql,
+        sql_stmt_t* p_stmt, int i_col )
+{
+    return p_sql->pf_getcolumnname( p_sql, p_stmt, i_col );
+}
+
 # ifdef __cplusplus
 }
 # endif /* C++ extern "C" */
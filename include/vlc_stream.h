@@ -82,6 +82,15 @@ struct stream_t
     input_thread_t *p_input;
 };
 
+/**
+ * Byte range of a stream, see STREAM_SET_PREFETCH_HINTS
+ */
+typedef struct
+{
+    uint64_t i_offset;
+    uint64_t i_size;
+} stream_range_t;
+
 /**
  * Possible commands to send to stream_Control() and stream_vaControl()
  */
@@ -111,6 +120,10 @@ enum stream_query_e
 
     /* XXX only data read through stream_Read/Block will be recorded */
     STREAM_SET_RECORD_STATE,     /**< arg1=bool, arg2=const char *psz_ext (if arg1 is true)  res=can fail */
+
+    /* Ranges the demuxer is about to read, from its index. They replace the
+     * previous ones, and are only a hint (none if count is 0) */
+    STREAM_SET_PREFETCH_HINTS,   /**< arg1= const stream_range_t *, arg2= int i_count  res=can fail */
 };
 
 VLC_API int stream_Read( stream_t *s, void *p_read, int i_read );
@@ -0,0 +1,77 @@
+/*****************************************************************************
+ * vlc_thumbnailer.h: extraction of video frames without playback
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_THUMBNAILER_H
+# define VLC_THUMBNAILER_H
+
+/**
+ * \file
+ * This file defines functions to extract a frame of a video, e.g. for
+ * thumbnails.
+ *
+ * There is no input thread, no clock and no output: each request opens the
+ * media, seeks to the keyframe nearest to the requested time, and decodes
+ * that keyframe only (the other frames are skipped by the decoder). Requests
+ * run as tasks of the executor of the LibVLC instance, so that many of them
+ * are processed concurrently.
+ */
+
+#include <vlc_picture.h>
+
+typedef struct vlc_thumbnailer_t vlc_thumbnailer_t;
+typedef struct vlc_thumbnailer_request_t vlc_thumbnailer_request_t;
+
+/**
+ * Receives the frame of a request, from a thread of the executor.
+ * @param p_pic the frame (to be released by the callee), or NULL on error
+ */
+typedef void (*vlc_thumbnailer_cb)( void *p_data, picture_t *p_pic );
+
+/**
+ * Creates a thumbnailer.
+ */
+VLC_API vlc_thumbnailer_t *vlc_thumbnailer_Create( vlc_object_t * ) VLC_USED;
+#define vlc_thumbnailer_Create(o) vlc_thumbnailer_Create(VLC_OBJECT(o))
+
+/**
+ * Destroys a thumbnailer. The pending requests are cancelled.
+ */
+VLC_API void vlc_thumbnailer_Release( vlc_thumbnailer_t * );
+
+/**
+ * Queues a request.
+ * @param i_time time of the frame from the start of the media
+ * @param i_timeout how long the request may take at most
+ * @param pf_cb callback, called exactly once unless the request is cancelled
+ * @return the request, or NULL on error
+ */
+VLC_API vlc_thumbnailer_request_t *
+vlc_thumbnailer_Request( vlc_thumbnailer_t *, input_item_t *, mtime_t i_time,
+                         mtime_t i_timeout, vlc_thumbnailer_cb pf_cb,
+                         void *p_data );
+
+/**
+ * Cancels a request. If its callback is running, it is waited for.
+ * This must not be called once the callback has returned.
+ */
+VLC_API void vlc_thumbnailer_Cancel( vlc_thumbnailer_t *,
+                                     vlc_thumbnailer_request_t * );
+
+#endif
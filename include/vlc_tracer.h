@@ -0,0 +1,51 @@
+/*****************************************************************************
+ * vlc_tracer.h: hot path tracing
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_TRACER_H
+# define VLC_TRACER_H
+
+/**
+ * \file
+ * This file defines macros to trace the timing of the playback pipeline.
+ *
+ * Tracing is enabled at run-time with the trace-file option, which LibVLC
+ * offers when built with --enable-trace. Until then, an event costs a call
+ * and a test. Each thread records its events to its own ring buffer,
+ * without locking; the latest events of all threads are written to
+ * the trace file when LibVLC exits, in the Chrome trace event format, which
+ * chrome://tracing and Perfetto can display.
+ *
+ * Event names must be string literals (or otherwise outlive LibVLC), and
+ * must not need JSON escaping.
+ */
+
+VLC_API void vlc_tracer_Event( const char *psz_name, char phase,
+                               int64_t i_value );
+
+/** Starts a duration, ended by VLC_TRACE_END() on the same thread */
+#define VLC_TRACE_BEGIN(name)        vlc_tracer_Event(name, 'B', 0)
+/** Ends a duration */
+#define VLC_TRACE_END(name)          vlc_tracer_Event(name, 'E', 0)
+/** Marks a point in time */
+#define VLC_TRACE_INSTANT(name)      vlc_tracer_Event(name, 'i', 0)
+/** Records the value of a counter (e.g. a queue depth) */
+#define VLC_TRACE_COUNTER(name, val) vlc_tracer_Event(name, 'C', val)
+
+#endif
@@ -166,6 +166,21 @@ VLC_API int var_GetChecked( vlc_object_t *, const char *, int, vlc_value_t * );
 #define var_GetChecked(o,n,t,v) var_GetChecked(VLC_OBJECT(o),n,t,v)
 VLC_API int var_GetAndSet( vlc_object_t *, const char *, int, vlc_value_t * );
 
+/**
+ * Handle to a variable, to skip the name look-up in frequent accesses.
+ * \see var_Handle
+ */
+typedef struct variable_t vlc_var_handle_t;
+
+VLC_API vlc_var_handle_t *var_Handle( vlc_object_t *, const char * ) VLC_USED;
+#define var_Handle(o,n) var_Handle(VLC_OBJECT(o),n)
+VLC_API void var_HandleRelease( vlc_object_t *, vlc_var_handle_t * );
+#define var_HandleRelease(o,h) var_HandleRelease(VLC_OBJECT(o),h)
+VLC_API int var_HandleGet( vlc_object_t *, vlc_var_handle_t *, int, vlc_value_t * );
+#define var_HandleGet(o,h,t,v) var_HandleGet(VLC_OBJECT(o),h,t,v)
+VLC_API int var_HandleSet( vlc_object_t *, vlc_var_handle_t *, int, vlc_value_t );
+#define var_HandleSet(o,h,t,v) var_HandleSet(VLC_OBJECT(o),h,t,v)
+
 VLC_API int var_Inherit( vlc_object_t *, const char *, int, vlc_value_t * );
 
 VLC_API int var_Command( vlc_object_t *, const char *, const char *, const char *, char ** );
@@ -379,6 +394,66 @@ static inline float var_GetFloat( vlc_object_t *p_obj, const char *psz_name )
         return 0.0;
 }
 
+/**
+ * Get an integer value through a variable handle
+ *
+ * \param p_obj The object that holds the variable
+ * \param p_var The handle from var_Handle()
+ */
+VLC_USED
+static inline int64_t var_HandleGetInteger( vlc_object_t *p_obj,
+                                            vlc_var_handle_t *p_var )
+{
+    vlc_value_t val;
+    var_HandleGet( p_obj, p_var, VLC_VAR_INTEGER, &val );
+    return val.i_int;
+}
+
+/**
+ * Get a boolean value through a variable handle
+ *
+ * \param p_obj The object that holds the variable
+ * \param p_var The handle from var_Handle()
+ */
+VLC_USED
+static inline bool var_HandleGetBool( vlc_object_t *p_obj,
+                                      vlc_var_handle_t *p_var )
+{
+    vlc_value_t val;
+    var_HandleGet( p_obj, p_var, VLC_VAR_BOOL, &val );
+    return val.b_bool;
+}
+
+/**
+ * Get a float value through a variable handle
+ *
+ * \param p_obj The object that holds the variable
+ * \param p_var The handle from var_Handle()
+ */
+VLC_USED
+static inline float var_HandleGetFloat( vlc_object_t *p_obj,
+                                        vlc_var_handle_t *p_var )
+{
+    vlc_value_t val;
+    var_HandleGet( p_obj, p_var, VLC_VAR_FLOAT, &val );
+    return val.f_float;
+}
+
+/**
+ * Set an integer value through a variable handle
+ *
+ * \param p_obj The object that holds the variable
+ * \param p_var The handle from var_Handle()
+ * \param i The new integer value of this variable
+ */
+static inline int var_HandleSetInteger( vlc_object_t *p_obj,
+                                        vlc_var_handle_t *p_var, int64_t i )
+{
+    vlc_value_t val;
+    val.i_int = i;
+    return var_HandleSet( p_obj, p_var, VLC_VAR_INTEGER, val );
+}
+
 /**
  * Get a string value
  *
@@ -749,6 +824,10 @@ VLC_API int var_InheritURational( vlc_object_t *, unsigned *num, unsigned *den,
 #define var_GetString(a,b)   var_GetString( VLC_OBJECT(a),b)
 #define var_GetNonEmptyString(a,b)   var_GetNonEmptyString( VLC_OBJECT(a),b)
 #define var_GetAddress(a,b)  var_GetAddress( VLC_OBJECT(a),b)
+#define var_HandleGetInteger(a,b)   var_HandleGetInteger( VLC_OBJECT(a),b)
+#define var_HandleGetBool(a,b)   var_HandleGetBool( VLC_OBJECT(a),b)
+#define var_HandleGetFloat(a,b)   var_HandleGetFloat( VLC_OBJECT(a),b)
+#define var_HandleSetInteger(a,b,c)   var_HandleSetInteger( VLC_OBJECT(a),b,c)
 
 VLC_API int var_LocationParse(vlc_object_t *, const char *mrl, const char *prefix);
 #define var_LocationParse(o, m, p) var_LocationParse(VLC_OBJECT(o), m, p)
@@ -212,6 +212,7 @@ void libvlc_event_send( libvlc_event_manager_t * p_em,
         {
             /* The listener wants not to block the emitter during event callback */
             libvlc_event_async_dispatch(p_em, listener_cached, p_event);
+            listener_cached++;
         }
         else
         {
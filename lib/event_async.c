@@ -75,7 +75,22 @@ static inline bool current_thread_is_asynch_thread(libvlc_event_manager_t * p_em
 static void push(libvlc_event_manager_t * p_em,
                  libvlc_event_listener_t * listener, libvlc_event_t * event)
 {
+    if(event_is_coalescable(event->type))
+    {
+        /* Overwrite the pending event of that listener, if any */
+        for(struct queue_elmt * iter = queue(p_em)->first_elmt; iter;
+            iter = iter->next)
+            if(iter->event.type == event->type &&
+               listeners_are_equal(&iter->listener, listener))
+            {
+                iter->event = *event;
+                return;
+            }
+    }
+
     struct queue_elmt * elmt = malloc(sizeof(struct queue_elmt));
+    if(!elmt)
+        return;
     elmt->listener = *listener;
     elmt->event = *event;
     elmt->next = NULL;
@@ -242,8 +257,10 @@ libvlc_event_async_dispatch(libvlc_event_manager_t * p_em, libvlc_event_listener
     vlc_mutex_unlock(&p_em->object_lock);
 
     queue_lock(p_em);
+    /* The loop only waits when the queue is empty: one wakeup per batch */
+    if(!queue(p_em)->first_elmt)
+        vlc_cond_signal(&queue(p_em)->signal);
     push(p_em, listener, event);
-    vlc_cond_signal(&queue(p_em)->signal);
     queue_unlock(p_em);
 }
 
@@ -105,6 +105,22 @@ listeners_are_equal( libvlc_event_listener_t * listener1,
     listener1->is_asynchronous == listener2->is_asynchronous;
 }
 
+/* High-frequency events, of which only the latest one matters: a pending
+ * event of the same type and object is overwritten rather than queued. */
+static inline bool
+event_is_coalescable( libvlc_event_type_t event_type )
+{
+    switch( event_type )
+    {
+        case libvlc_MediaPlayerTimeChanged:
+        case libvlc_MediaPlayerPositionChanged:
+        case libvlc_MediaPlayerBuffering:
+            return true;
+        default:
+            return false;
+    }
+}
+
 /* event_async.c */
 void libvlc_event_async_fini(libvlc_event_manager_t * p_em);
 void libvlc_event_async_dispatch(libvlc_event_manager_t * p_em, libvlc_event_listener_t * listener, libvlc_event_t * event);
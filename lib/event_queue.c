@@ -0,0 +1,187 @@
+/*****************************************************************************
+ * event_queue.c: libvlc events polled from the application event loop
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+
+#include <vlc/libvlc.h>
+
+#include <vlc_common.h>
+#include <vlc_fs.h>
+
+#include "libvlc_internal.h"
+#include "event_internal.h"
+
+struct libvlc_event_queue_t
+{
+    vlc_mutex_t      lock;
+    libvlc_event_t  *p_events;
+    unsigned         i_count;
+    unsigned         i_size;
+    unsigned         i_attached;
+    bool             b_signaled; /* a byte is in the pipe */
+    int              fd[2];
+};
+
+/* Synchronous listener of the event managers */
+static void QueueEvent( const libvlc_event_t *p_event, void *data )
+{
+    libvlc_event_queue_t *p_queue = data;
+
+    vlc_mutex_lock( &p_queue->lock );
+    if( event_is_coalescable( p_event->type ) )
+    {
+        for( unsigned i = p_queue->i_count; i-- > 0; )
+        {
+            libvlc_event_t *p_old = &p_queue->p_events[i];
+            if( p_old->type == p_event->type && p_old->p_obj == p_event->p_obj )
+            {
+                *p_old = *p_event;
+                vlc_mutex_unlock( &p_queue->lock );
+                return;
+            }
+        }
+    }
+
+    if( p_queue->i_count == p_queue->i_size )
+    {
+        unsigned i_size = p_queue->i_size ? 2 * p_queue->i_size : 16;
+        libvlc_event_t *p_events = realloc( p_queue->p_events,
+                                            i_size * sizeof( *p_events ) );
+        if( unlikely(p_events == NULL) )
+        {
+            vlc_mutex_unlock( &p_queue->lock );
+            return;
+        }
+        p_queue->p_events = p_events;
+        p_queue->i_size = i_size;
+    }
+    p_queue->p_events[p_queue->i_count++] = *p_event;
+
+    if( !p_queue->b_signaled && p_queue->fd[1] != -1 )
+    {
+        const char c = 0;
+        p_queue->b_signaled = write( p_queue->fd[1], &c, 1 ) == 1;
+    }
+    vlc_mutex_unlock( &p_queue->lock );
+}
+
+libvlc_event_queue_t *libvlc_event_queue_new( void )
+{
+    libvlc_event_queue_t *p_queue = malloc( sizeof( *p_queue ) );
+    if( unlikely(p_queue == NULL) )
+    {
+        libvlc_printerr( "Not enough memory" );
+        return NULL;
+    }
+
+    vlc_mutex_init( &p_queue->lock );
+    p_queue->p_events = NULL;
+    p_queue->i_count = 0;
+    p_queue->i_size = 0;
+    p_queue->i_attached = 0;
+    p_queue->b_signaled = false;
+    /* Without a pipe, the queue can still be polled periodically */
+    if( vlc_pipe( p_queue->fd ) )
+        p_queue->fd[0] = p_queue->fd[1] = -1;
+    return p_queue;
+}
+
+void libvlc_event_queue_release( libvlc_event_queue_t *p_queue )
+{
+    assert( p_queue->i_attached == 0 );
+
+    if( p_queue->fd[0] != -1 )
+    {
+        close( p_queue->fd[1] );
+        close( p_queue->fd[0] );
+    }
+    free( p_queue->p_events );
+    vlc_mutex_destroy( &p_queue->lock );
+    free( p_queue );
+}
+
+int libvlc_event_queue_attach( libvlc_event_queue_t *p_queue,
+                               libvlc_event_manager_t *p_em,
+                               libvlc_event_type_t i_event_type )
+{
+    int i_ret = libvlc_event_attach( p_em, i_event_type, QueueEvent, p_queue );
+    if( i_ret == 0 )
+    {
+        vlc_mutex_lock( &p_queue->lock );
+        p_queue->i_attached++;
+        vlc_mutex_unlock( &p_queue->lock );
+    }
+    return i_ret;
+}
+
+void libvlc_event_queue_detach( libvlc_event_queue_t *p_queue,
+                                libvlc_event_manager_t *p_em,
+                                libvlc_event_type_t i_event_type )
+{
+    libvlc_event_detach( p_em, i_event_type, QueueEvent, p_queue );
+
+    vlc_mutex_lock( &p_queue->lock );
+    assert( p_queue->i_attached > 0 );
+    p_queue->i_attached--;
+
+    unsigned j = 0;
+    for( unsigned i = 0; i < p_queue->i_count; i++ )
+    {
+        const libvlc_event_t *p_event = &p_queue->p_events[i];
+        if( p_event->type != i_event_type || p_event->p_obj != p_em->p_obj )
+            p_queue->p_events[j++] = *p_event;
+    }
+    p_queue->i_count = j;
+    vlc_mutex_unlock( &p_queue->lock );
+}
+
+int libvlc_event_queue_fd( libvlc_event_queue_t *p_queue )
+{
+    return p_queue->fd[0];
+}
+
+unsigned libvlc_event_queue_poll( libvlc_event_queue_t *p_queue,
+                                  libvlc_event_t *p_events, unsigned i_max )
+{
+    vlc_mutex_lock( &p_queue->lock );
+    unsigned i_count = __MIN( i_max, p_queue->i_count );
+
+    memcpy( p_events, p_queue->p_events, i_count * sizeof( *p_events ) );
+    p_queue->i_count -= i_count;
+    memmove( p_queue->p_events, p_queue->p_events + i_count,
+             p_queue->i_count * sizeof( *p_events ) );
+
+    if( p_queue->i_count == 0 && p_queue->b_signaled )
+    {
+        char c;
+        if( read( p_queue->fd[0], &c, 1 ) == 1 )
+            p_queue->b_signaled = false;
+    }
+    vlc_mutex_unlock( &p_queue->lock );
+    return i_count;
+}
@@ -554,6 +554,16 @@ int libvlc_media_get_stats( libvlc_media_t *p_md,
     p_stats->i_sent_packets = p_itm_stats->i_sent_packets;
     p_stats->i_sent_bytes = p_itm_stats->i_sent_bytes;
     p_stats->f_send_bitrate = p_itm_stats->f_send_bitrate;
+
+    p_stats->i_video_decode_time_p50 = p_itm_stats->i_video_decode_time_p50;
+    p_stats->i_video_decode_time_p90 = p_itm_stats->i_video_decode_time_p90;
+    p_stats->i_video_decode_time_p99 = p_itm_stats->i_video_decode_time_p99;
+    p_stats->i_audio_decode_time_p50 = p_itm_stats->i_audio_decode_time_p50;
+    p_stats->i_audio_decode_time_p90 = p_itm_stats->i_audio_decode_time_p90;
+    p_stats->i_audio_decode_time_p99 = p_itm_stats->i_audio_decode_time_p99;
+    p_stats->i_video_latency_p50 = p_itm_stats->i_video_latency_p50;
+    p_stats->i_video_latency_p90 = p_itm_stats->i_video_latency_p90;
+    p_stats->i_video_latency_p99 = p_itm_stats->i_video_latency_p99;
     vlc_mutex_unlock( &p_itm_stats->lock );
     return true;
 }
@@ -399,6 +399,20 @@ libvlc_media_player_new( libvlc_instance_t *instance )
     /* Input */
     var_Create (mp, "rate", VLC_VAR_FLOAT|VLC_VAR_DOINHERIT);
 
+    /* Packets */
+    var_Create (mp, "sout", VLC_VAR_STRING | VLC_VAR_DOINHERIT);
+    var_Create (mp, "sout-all", VLC_VAR_BOOL | VLC_VAR_DOINHERIT);
+    var_Create (mp, "sout-audio", VLC_VAR_BOOL | VLC_VAR_DOINHERIT);
+    var_Create (mp, "sout-video", VLC_VAR_BOOL | VLC_VAR_DOINHERIT);
+    var_Create (mp, "sout-spu", VLC_VAR_BOOL | VLC_VAR_DOINHERIT);
+    var_Create (mp, "sout-tap-add", VLC_VAR_ADDRESS);
+    var_Create (mp, "sout-tap-send", VLC_VAR_ADDRESS);
+    var_Create (mp, "sout-tap-del", VLC_VAR_ADDRESS);
+    var_Create (mp, "sout-tap-data", VLC_VAR_ADDRESS);
+    var_Create (mp, "packet-send", VLC_VAR_ADDRESS);
+    var_Create (mp, "packet-es", VLC_VAR_ADDRESS);
+    var_Create (mp, "packet-data", VLC_VAR_ADDRESS);
+
     /* Video */
     var_Create (mp, "vout", VLC_VAR_STRING|VLC_VAR_DOINHERIT);
     var_Create (mp, "window", VLC_VAR_STRING);
@@ -408,6 +422,10 @@ libvlc_media_player_new( libvlc_instance_t *instance )
     var_Create (mp, "vmem-data", VLC_VAR_ADDRESS);
     var_Create (mp, "vmem-setup", VLC_VAR_ADDRESS);
     var_Create (mp, "vmem-cleanup", VLC_VAR_ADDRESS);
+    var_Create (mp, "vmem-buffer", VLC_VAR_ADDRESS);
+    var_Create (mp, "vmem-acquire", VLC_VAR_ADDRESS);
+    var_Create (mp, "vmem-release", VLC_VAR_ADDRESS);
+    var_Create (mp, "vmem-present", VLC_VAR_ADDRESS);
     var_Create (mp, "vmem-chroma", VLC_VAR_STRING | VLC_VAR_DOINHERIT);
     var_Create (mp, "vmem-width", VLC_VAR_INTEGER | VLC_VAR_DOINHERIT);
     var_Create (mp, "vmem-height", VLC_VAR_INTEGER | VLC_VAR_DOINHERIT);
@@ -834,6 +852,23 @@ void libvlc_video_set_callbacks( libvlc_media_player_t *mp,
     var_SetAddress( mp, "vmem-unlock", unlock_cb );
     var_SetAddress( mp, "vmem-display", display_cb );
     var_SetAddress( mp, "vmem-data", opaque );
+    var_SetAddress( mp, "vmem-buffer", NULL );
+    var_SetString( mp, "vout", "vmem" );
+}
+
+void libvlc_video_set_pool_callbacks( libvlc_media_player_t *mp,
+                                      libvlc_video_buffer_cb buffer,
+                                      libvlc_video_buffer_ref_cb acquire,
+                                      libvlc_video_buffer_ref_cb release,
+                                      libvlc_video_buffer_ref_cb present,
+                                      void *opaque )
+{
+    var_SetAddress( mp, "vmem-buffer", buffer );
+    var_SetAddress( mp, "vmem-acquire", acquire );
+    var_SetAddress( mp, "vmem-release", release );
+    var_SetAddress( mp, "vmem-present", present );
+    var_SetAddress( mp, "vmem-lock", NULL );
+    var_SetAddress( mp, "vmem-data", opaque );
     var_SetString( mp, "vout", "vmem" );
 }
 
@@ -0,0 +1,229 @@
+/*****************************************************************************
+ * media_worker.c: libvlc new API media worker functions
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdio.h>
+
+#include <vlc/libvlc.h>
+#include <vlc/libvlc_media.h>
+#include <vlc/libvlc_media_worker.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_input.h>
+#include <vlc_vout.h>
+#include <vlc_image.h>
+#include <vlc_fs.h>
+
+#include "libvlc_internal.h"
+#include "media_internal.h"
+
+struct libvlc_media_worker_t
+{
+    VLC_COMMON_MEMBERS
+
+    libvlc_instance_t *p_libvlc_instance;
+    /* Kept from one media to the next, with its video output */
+    input_resource_t  *p_resource;
+
+    vlc_mutex_t        lock;
+    vlc_cond_t         wait;
+    bool               b_vout;  /* the input has a video output */
+    bool               b_dead;  /* the input stopped */
+};
+
+libvlc_media_worker_t *libvlc_media_worker_new( libvlc_instance_t *p_instance )
+{
+    libvlc_media_worker_t *p_mw =
+        vlc_object_create( p_instance->p_libvlc_int, sizeof( *p_mw ) );
+    if( unlikely(p_mw == NULL) )
+    {
+        libvlc_printerr( "Not enough memory" );
+        return NULL;
+    }
+
+    /* Decode the video only, without displaying it */
+    var_Create( p_mw, "vout", VLC_VAR_STRING );
+    var_SetString( p_mw, "vout", "dummy" );
+    var_Create( p_mw, "audio", VLC_VAR_BOOL );
+    var_SetBool( p_mw, "audio", false );
+    var_Create( p_mw, "spu", VLC_VAR_BOOL );
+    var_SetBool( p_mw, "spu", false );
+    var_Create( p_mw, "osd", VLC_VAR_BOOL );
+    var_SetBool( p_mw, "osd", false );
+    var_Create( p_mw, "video-title-show", VLC_VAR_BOOL );
+    var_SetBool( p_mw, "video-title-show", false );
+    var_Create( p_mw, "sub-autodetect-file", VLC_VAR_BOOL );
+    var_SetBool( p_mw, "sub-autodetect-file", false );
+    var_Create( p_mw, "input-fast-seek", VLC_VAR_BOOL );
+    var_SetBool( p_mw, "input-fast-seek", true );
+    var_Create( p_mw, "start-time", VLC_VAR_FLOAT );
+
+    p_mw->p_resource = input_resource_New( VLC_OBJECT( p_mw ) );
+    if( unlikely(p_mw->p_resource == NULL) )
+    {
+        vlc_object_release( p_mw );
+        libvlc_printerr( "Not enough memory" );
+        return NULL;
+    }
+    vlc_mutex_init( &p_mw->lock );
+    vlc_cond_init( &p_mw->wait );
+
+    p_mw->p_libvlc_instance = p_instance;
+    libvlc_retain( p_instance );
+    return p_mw;
+}
+
+void libvlc_media_worker_release( libvlc_media_worker_t *p_mw )
+{
+    libvlc_instance_t *p_instance = p_mw->p_libvlc_instance;
+
+    input_resource_Terminate( p_mw->p_resource );
+    input_resource_Release( p_mw->p_resource );
+    vlc_cond_destroy( &p_mw->wait );
+    vlc_mutex_destroy( &p_mw->lock );
+    vlc_object_release( p_mw );
+    libvlc_release( p_instance );
+}
+
+static int input_event_changed( vlc_object_t *p_this, char const *psz_cmd,
+                                vlc_value_t oldval, vlc_value_t newval,
+                                void *p_userdata )
+{
+    libvlc_media_worker_t *p_mw = p_userdata;
+    VLC_UNUSED(p_this); VLC_UNUSED(psz_cmd); VLC_UNUSED(oldval);
+
+    switch( newval.i_int )
+    {
+        case INPUT_EVENT_VOUT:
+            vlc_mutex_lock( &p_mw->lock );
+            p_mw->b_vout = true;
+            vlc_cond_signal( &p_mw->wait );
+            vlc_mutex_unlock( &p_mw->lock );
+            break;
+        case INPUT_EVENT_DEAD:
+        case INPUT_EVENT_ABORT:
+            vlc_mutex_lock( &p_mw->lock );
+            p_mw->b_dead = true;
+            vlc_cond_signal( &p_mw->wait );
+            vlc_mutex_unlock( &p_mw->lock );
+            break;
+    }
+    return VLC_SUCCESS;
+}
+
+static int SaveSnapshot( libvlc_media_worker_t *p_mw, picture_t *p_pic,
+                         unsigned i_width, unsigned i_height,
+                         const char *psz_filepath )
+{
+    vlc_fourcc_t i_codec = image_Ext2Fourcc( psz_filepath );
+    block_t *p_image;
+    video_format_t fmt;
+
+    if( i_codec == 0 )
+        i_codec = VLC_CODEC_PNG;
+    if( picture_Export( VLC_OBJECT( p_mw ), &p_image, &fmt, p_pic, i_codec,
+                        i_width, i_height ) )
+    {
+        libvlc_printerr( "Cannot convert the snapshot" );
+        return -1;
+    }
+
+    int i_ret = -1;
+    FILE *file = vlc_fopen( psz_filepath, "wb" );
+    if( file != NULL )
+    {
+        if( fwrite( p_image->p_buffer, p_image->i_buffer, 1, file ) == 1 )
+            i_ret = 0;
+        if( fclose( file ) )
+            i_ret = -1;
+    }
+    if( i_ret )
+        libvlc_printerr( "Cannot write %s", psz_filepath );
+    block_Release( p_image );
+    return i_ret;
+}
+
+int libvlc_media_worker_snapshot( libvlc_media_worker_t *p_mw,
+                                  libvlc_media_t *p_md, libvlc_time_t i_time,
+                                  unsigned i_width, unsigned i_height,
+                                  const char *psz_filepath, int i_timeout )
+{
+    assert( psz_filepath != NULL );
+
+    const mtime_t i_deadline = mdate() + to_mtime( i_timeout );
+    int i_ret = -1;
+
+    var_SetFloat( p_mw, "start-time", i_time / 1000.f );
+    input_thread_t *p_input = input_Create( p_mw, p_md->p_input_item, NULL,
+                                            p_mw->p_resource );
+    if( p_input == NULL )
+    {
+        libvlc_printerr( "Not enough memory" );
+        return -1;
+    }
+
+    p_mw->b_vout = false;
+    p_mw->b_dead = false;
+    var_AddCallback( p_input, "intf-event", input_event_changed, p_mw );
+    if( input_Start( p_input ) )
+    {
+        libvlc_printerr( "Input initialization failure" );
+        goto out;
+    }
+
+    /* Wait for the video output */
+    vlc_mutex_lock( &p_mw->lock );
+    while( !p_mw->b_vout && !p_mw->b_dead )
+        if( vlc_cond_timedwait( &p_mw->wait, &p_mw->lock, i_deadline ) )
+            break;
+    vlc_mutex_unlock( &p_mw->lock );
+
+    vout_thread_t *p_vout = input_GetVout( p_input );
+    if( p_vout == NULL )
+    {
+        libvlc_printerr( "No video output" );
+        goto out;
+    }
+
+    /* Grab the first picture displayed after the seek */
+    picture_t *p_pic;
+    video_format_t fmt;
+    mtime_t i_left = i_deadline - mdate();
+    if( i_left > 0
+     && vout_GetSnapshot( p_vout, NULL, &p_pic, &fmt, NULL, i_left ) == 0 )
+    {
+        i_ret = SaveSnapshot( p_mw, p_pic, i_width, i_height, psz_filepath );
+        picture_Release( p_pic );
+    }
+    else
+        libvlc_printerr( "Snapshot timed out" );
+    vlc_object_release( p_vout );
+
+out:
+    var_DelCallback( p_input, "intf-event", input_event_changed, p_mw );
+    input_Stop( p_input, true );
+    input_Close( p_input );
+    return i_ret;
+}
@@ -0,0 +1,253 @@
+/*****************************************************************************
+ * packet.c: libvlc new API encoded packets functions
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+
+#include <vlc/libvlc.h>
+#include <vlc/libvlc_media.h>
+#include <vlc/libvlc_media_player.h>
+#include <vlc/libvlc_packet.h>
+
+#include <vlc_common.h>
+#include <vlc_atomic.h>
+#include <vlc_block.h>
+#include <vlc_es.h>
+
+#include "libvlc_internal.h"
+#include "media_player_internal.h"
+
+/* The ES outlives the stream output if the application holds its packets */
+typedef struct
+{
+    vlc_atomic_t       refs;
+    libvlc_packet_es_t es;
+    es_format_t        fmt;
+    libvlc_packet_cb   packet;
+    void              *opaque;
+} packet_es_t;
+
+struct libvlc_packet_t
+{
+    vlc_atomic_t refs;
+    block_t     *p_block;
+    packet_es_t *p_es;
+};
+
+static void EsRelease( packet_es_t *p_es )
+{
+    if( vlc_atomic_dec( &p_es->refs ) > 0 )
+        return;
+    es_format_Clean( &p_es->fmt );
+    free( p_es );
+}
+
+/**************************************************************************
+ * Callbacks of the "tap" stream output (stream_out/tap.c)
+ **************************************************************************/
+static void *PacketAdd( void *data, const es_format_t *p_fmt )
+{
+    libvlc_media_player_t *mp = data;
+    libvlc_packet_es_cb es_cb = var_GetAddress( mp, "packet-es" );
+    packet_es_t *p_es = malloc( sizeof( *p_es ) );
+    if( unlikely(p_es == NULL) )
+        return NULL;
+
+    vlc_atomic_set( &p_es->refs, 1 );
+    es_format_Copy( &p_es->fmt, p_fmt );
+    p_es->packet = var_GetAddress( mp, "packet-send" );
+    p_es->opaque = var_GetAddress( mp, "packet-data" );
+
+    libvlc_packet_es_t *es = &p_es->es;
+    memset( es, 0, sizeof( *es ) );
+    es->i_id = p_fmt->i_id;
+    es->i_codec = p_fmt->i_codec;
+    es->i_original_fourcc = p_fmt->i_original_fourcc;
+    es->i_profile = p_fmt->i_profile;
+    es->i_level = p_fmt->i_level;
+    es->psz_language = p_es->fmt.psz_language;
+    es->p_extra = p_es->fmt.p_extra;
+    es->i_extra = p_es->fmt.i_extra;
+
+    switch( p_fmt->i_cat )
+    {
+        case AUDIO_ES:
+            es->i_type = libvlc_track_audio;
+            es->u.audio.i_channels = p_fmt->audio.i_channels;
+            es->u.audio.i_rate = p_fmt->audio.i_rate;
+            break;
+        case VIDEO_ES:
+            es->i_type = libvlc_track_video;
+            es->u.video.i_height = p_fmt->video.i_height;
+            es->u.video.i_width = p_fmt->video.i_width;
+            es->u.video.i_frame_rate = p_fmt->video.i_frame_rate;
+            es->u.video.i_frame_rate_base = p_fmt->video.i_frame_rate_base;
+            break;
+        case SPU_ES:
+            es->i_type = libvlc_track_text;
+            break;
+        default:
+            es->i_type = libvlc_track_unknown;
+            break;
+    }
+
+    if( p_es->packet == NULL
+     || (es_cb != NULL && !es_cb( p_es->opaque, es )) )
+    {
+        EsRelease( p_es );
+        return NULL;
+    }
+    return p_es;
+}
+
+static void PacketSend( void *data, void *es, block_t *p_block )
+{
+    packet_es_t *p_es = es;
+    libvlc_packet_t *p_packet = malloc( sizeof( *p_packet ) );
+
+    VLC_UNUSED(data);
+    if( unlikely(p_packet == NULL) )
+    {
+        block_Release( p_block );
+        return;
+    }
+
+    vlc_atomic_set( &p_packet->refs, 1 );
+    p_packet->p_block = p_block;
+    p_packet->p_es = p_es;
+    vlc_atomic_inc( &p_es->refs );
+
+    p_es->packet( p_es->opaque, p_packet );
+}
+
+static void PacketDel( void *data, void *es )
+{
+    VLC_UNUSED(data);
+    EsRelease( es );
+}
+
+void libvlc_media_player_set_packet_callbacks( libvlc_media_player_t *mp,
+                                               libvlc_packet_cb packet,
+                                               libvlc_packet_es_cb es,
+                                               unsigned types, void *opaque )
+{
+    var_SetAddress( mp, "packet-send", packet );
+    var_SetAddress( mp, "packet-es", es );
+    var_SetAddress( mp, "packet-data", opaque );
+
+    if( packet == NULL )
+    {
+        /* Back to the configured stream output, normally none */
+        char *psz_sout = var_InheritString( mp->p_libvlc, "sout" );
+        var_SetString( mp, "sout", psz_sout ? psz_sout : "" );
+        free( psz_sout );
+        var_SetBool( mp, "sout-all", var_InheritBool( mp->p_libvlc,
+                                                      "sout-all" ) );
+        var_SetBool( mp, "sout-audio", var_InheritBool( mp->p_libvlc,
+                                                        "sout-audio" ) );
+        var_SetBool( mp, "sout-video", var_InheritBool( mp->p_libvlc,
+                                                        "sout-video" ) );
+        var_SetBool( mp, "sout-spu", var_InheritBool( mp->p_libvlc,
+                                                      "sout-spu" ) );
+        return;
+    }
+
+    if( types == 0 )
+        types = libvlc_packet_audio | libvlc_packet_video | libvlc_packet_text;
+
+    var_SetAddress( mp, "sout-tap-add", PacketAdd );
+    var_SetAddress( mp, "sout-tap-send", PacketSend );
+    var_SetAddress( mp, "sout-tap-del", PacketDel );
+    var_SetAddress( mp, "sout-tap-data", mp );
+    /* The ES of the other types are not even selected */
+    var_SetBool( mp, "sout-all", true );
+    var_SetBool( mp, "sout-audio", types & libvlc_packet_audio );
+    var_SetBool( mp, "sout-video", types & libvlc_packet_video );
+    var_SetBool( mp, "sout-spu", types & libvlc_packet_text );
+    var_SetString( mp, "sout", "#tap" );
+}
+
+/**************************************************************************
+ * Packets
+ **************************************************************************/
+void libvlc_packet_retain( libvlc_packet_t *p_packet )
+{
+    vlc_atomic_inc( &p_packet->refs );
+}
+
+void libvlc_packet_release( libvlc_packet_t *p_packet )
+{
+    if( vlc_atomic_dec( &p_packet->refs ) > 0 )
+        return;
+    block_Release( p_packet->p_block );
+    EsRelease( p_packet->p_es );
+    free( p_packet );
+}
+
+const uint8_t *libvlc_packet_data( const libvlc_packet_t *p_packet )
+{
+    return p_packet->p_block->p_buffer;
+}
+
+size_t libvlc_packet_size( const libvlc_packet_t *p_packet )
+{
+    return p_packet->p_block->i_buffer;
+}
+
+int64_t libvlc_packet_pts( const libvlc_packet_t *p_packet )
+{
+    mtime_t i_pts = p_packet->p_block->i_pts;
+    return (i_pts > VLC_TS_INVALID) ? i_pts - VLC_TS_0 : -1;
+}
+
+int64_t libvlc_packet_dts( const libvlc_packet_t *p_packet )
+{
+    mtime_t i_dts = p_packet->p_block->i_dts;
+    return (i_dts > VLC_TS_INVALID) ? i_dts - VLC_TS_0 : -1;
+}
+
+int64_t libvlc_packet_duration( const libvlc_packet_t *p_packet )
+{
+    return p_packet->p_block->i_length;
+}
+
+unsigned libvlc_packet_flags( const libvlc_packet_t *p_packet )
+{
+    const block_t *p_block = p_packet->p_block;
+    unsigned i_flags = 0;
+
+    /* Only the video packets carry a picture type */
+    if( p_packet->p_es->fmt.i_cat != VIDEO_ES
+     || (p_block->i_flags & BLOCK_FLAG_TYPE_I) )
+        i_flags |= libvlc_packet_keyframe;
+    if( p_block->i_flags & BLOCK_FLAG_DISCONTINUITY )
+        i_flags |= libvlc_packet_discontinuity;
+    if( p_block->i_flags & BLOCK_FLAG_CORRUPTED )
+        i_flags |= libvlc_packet_corrupted;
+    return i_flags;
+}
+
+const libvlc_packet_es_t *libvlc_packet_es( const libvlc_packet_t *p_packet )
+{
+    return &p_packet->p_es->es;
+}
@@ -0,0 +1,210 @@
+/*****************************************************************************
+ * thumbnailer.c: libvlc new API thumbnailer functions
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+
+#include <vlc/libvlc.h>
+#include <vlc/libvlc_media.h>
+#include <vlc/libvlc_thumbnailer.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_picture.h>
+#include <vlc_thumbnailer.h>
+
+#include "libvlc_internal.h"
+#include "media_internal.h"
+
+struct libvlc_thumbnailer_t
+{
+    libvlc_instance_t            *p_libvlc_instance;
+    vlc_thumbnailer_t            *p_core;
+    vlc_mutex_t                   lock;
+    libvlc_thumbnailer_request_t *p_first; /* pending requests */
+};
+
+struct libvlc_thumbnailer_request_t
+{
+    libvlc_thumbnailer_t         *p_owner;
+    vlc_thumbnailer_request_t    *p_core;
+    libvlc_thumbnailer_request_t *p_next;
+    libvlc_thumbnailer_cb         cb;
+    void                         *opaque;
+    unsigned                      i_width;
+    unsigned                      i_height;
+    vlc_fourcc_t                  i_codec;
+    bool                          b_canceled; /* cancel() frees the request */
+};
+
+/* Must be called with the lock held */
+static void request_unlink( libvlc_thumbnailer_request_t *p_req )
+{
+    libvlc_thumbnailer_t *p_th = p_req->p_owner;
+
+    for( libvlc_thumbnailer_request_t **pp = &p_th->p_first; *pp != NULL;
+         pp = &(*pp)->p_next )
+        if( *pp == p_req )
+        {
+            *pp = p_req->p_next;
+            break;
+        }
+}
+
+/* Runs on a thread of the executor: the encoding is concurrent too */
+static void thumbnail_ready( void *data, picture_t *p_pic )
+{
+    libvlc_thumbnailer_request_t *p_req = data;
+    libvlc_thumbnailer_t *p_th = p_req->p_owner;
+    block_t *p_image = NULL;
+
+    if( p_pic != NULL )
+    {
+        video_format_t fmt;
+        /* Scaled and converted by a single filter, then encoded */
+        if( picture_Export( VLC_OBJECT(p_th->p_libvlc_instance->p_libvlc_int),
+                            &p_image, &fmt, p_pic, p_req->i_codec,
+                            p_req->i_width, p_req->i_height ) )
+            p_image = NULL;
+        picture_Release( p_pic );
+    }
+
+    /* Not before the request is registered */
+    vlc_mutex_lock( &p_th->lock );
+    vlc_mutex_unlock( &p_th->lock );
+
+    if( p_image != NULL )
+    {
+        p_req->cb( p_req->opaque, p_image->p_buffer, p_image->i_buffer );
+        block_Release( p_image );
+    }
+    else
+        p_req->cb( p_req->opaque, NULL, 0 );
+
+    vlc_mutex_lock( &p_th->lock );
+    bool b_canceled = p_req->b_canceled;
+    if( !b_canceled )
+        request_unlink( p_req );
+    vlc_mutex_unlock( &p_th->lock );
+    if( !b_canceled )
+        free( p_req );
+}
+
+libvlc_thumbnailer_t *libvlc_thumbnailer_new( libvlc_instance_t *p_instance )
+{
+    libvlc_thumbnailer_t *p_th = malloc( sizeof( *p_th ) );
+    if( unlikely(p_th == NULL) )
+    {
+        libvlc_printerr( "Not enough memory" );
+        return NULL;
+    }
+
+    p_th->p_core = vlc_thumbnailer_Create( p_instance->p_libvlc_int );
+    if( unlikely(p_th->p_core == NULL) )
+    {
+        free( p_th );
+        libvlc_printerr( "Not enough memory" );
+        return NULL;
+    }
+    vlc_mutex_init( &p_th->lock );
+    p_th->p_first = NULL;
+
+    p_th->p_libvlc_instance = p_instance;
+    libvlc_retain( p_instance );
+    return p_th;
+}
+
+void libvlc_thumbnailer_release( libvlc_thumbnailer_t *p_th )
+{
+    /* No callback runs anymore after this */
+    vlc_thumbnailer_Release( p_th->p_core );
+
+    while( p_th->p_first != NULL )
+    {
+        libvlc_thumbnailer_request_t *p_req = p_th->p_first;
+        p_th->p_first = p_req->p_next;
+        free( p_req );
+    }
+    vlc_mutex_destroy( &p_th->lock );
+    libvlc_release( p_th->p_libvlc_instance );
+    free( p_th );
+}
+
+libvlc_thumbnailer_request_t *
+libvlc_thumbnailer_request( libvlc_thumbnailer_t *p_th, libvlc_media_t *p_md,
+                            libvlc_time_t i_time,
+                            unsigned i_width, unsigned i_height,
+                            libvlc_thumbnail_type_t i_type, int i_timeout,
+                            libvlc_thumbnailer_cb cb, void *opaque )
+{
+    libvlc_thumbnailer_request_t *p_req = malloc( sizeof( *p_req ) );
+    if( unlikely(p_req == NULL) )
+    {
+        libvlc_printerr( "Not enough memory" );
+        return NULL;
+    }
+
+    p_req->p_owner = p_th;
+    p_req->cb = cb;
+    p_req->opaque = opaque;
+    p_req->i_width = i_width;
+    p_req->i_height = i_height;
+    p_req->i_codec = (i_type == libvlc_thumbnail_jpg) ? VLC_CODEC_JPEG
+                                                      : VLC_CODEC_PNG;
+    p_req->b_canceled = false;
+
+    vlc_mutex_lock( &p_th->lock );
+    p_req->p_core = vlc_thumbnailer_Request( p_th->p_core, p_md->p_input_item,
+                                             to_mtime( i_time ),
+                                             to_mtime( i_timeout ),
+                                             thumbnail_ready, p_req );
+    if( p_req->p_core != NULL )
+    {
+        p_req->p_next = p_th->p_first;
+        p_th->p_first = p_req;
+    }
+    vlc_mutex_unlock( &p_th->lock );
+
+    if( p_req->p_core == NULL )
+    {
+        libvlc_printerr( "Cannot queue the thumbnail request" );
+        free( p_req );
+        return NULL;
+    }
+    return p_req;
+}
+
+void libvlc_thumbnailer_cancel( libvlc_thumbnailer_t *p_th,
+                                libvlc_thumbnailer_request_t *p_req )
+{
+    vlc_mutex_lock( &p_th->lock );
+    p_req->b_canceled = true;
+    vlc_mutex_unlock( &p_th->lock );
+
+    vlc_thumbnailer_Cancel( p_th->p_core, p_req->p_core );
+
+    vlc_mutex_lock( &p_th->lock );
+    request_unlink( p_req );
+    vlc_mutex_unlock( &p_th->lock );
+    free( p_req );
+}
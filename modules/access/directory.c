@@ -58,17 +58,64 @@ enum
     MODE_EXPAND,
 };
 
+/* Type of a directory entry, if known without opening it */
+enum
+{
+    ENTRY_UNKNOWN, /* not probed yet */
+    ENTRY_FILE,
+    ENTRY_DIR,
+    ENTRY_ANY,     /* try to open it as a directory */
+};
+
+typedef struct
+{
+    char          *name;
+    unsigned char  type;
+} dir_entry_t;
+
+/* Sorted entries of a directory. Opening a large folder on a network share
+ * is very slow, and the same folder is often expanded again (e.g. while
+ * browsing), so listings are cached for a while. */
+typedef struct listing_t listing_t;
+struct listing_t
+{
+    listing_t   *next;
+    unsigned     refs; /* protected by listing_lock */
+#ifdef HAVE_OPENAT
+    dev_t        device;
+    ino_t        inode;
+    time_t       mtime;
+    mtime_t      date;
+#endif
+    vlc_mutex_t  lock; /* protects the types of the entries */
+    vlc_cond_t   wait;
+    unsigned     count;
+    dir_entry_t  entries[];
+};
+
+#define LISTING_CACHE_MAX   8
+#define LISTING_CACHE_DELAY (30 * CLOCK_FREQ)
+#define PROBE_THREADS       4
+
+static vlc_mutex_t listing_lock = VLC_STATIC_MUTEX;
+#ifdef HAVE_OPENAT
+static listing_t *listing_cache = NULL;
+#endif
+
 typedef struct directory_t directory_t;
 struct directory_t
 {
     directory_t *parent;
     DIR         *handle;
     char        *uri;
-    char       **filev;
-    int          filec, i;
+    listing_t   *listing;
+    unsigned     i;
 #ifdef HAVE_OPENAT
     dev_t        device;
     ino_t        inode;
+    vlc_thread_t probers[PROBE_THREADS];
+    unsigned     probec;
+    unsigned     probe_next; /* protected by listing->lock */
 #else
     char         *path;
 #endif
@@ -82,6 +129,8 @@ struct access_sys_t
     bool header;
     int i_item_count;
     char *xspf_ext;
+    size_t xspf_len;
+    size_t xspf_size;
 };
 
 /* Select non-hidden files only */
@@ -90,15 +139,323 @@ static int visible (const char *name)
     return name[0] != '.';
 }
 
-static int collate (const char **a, const char **b)
+static int collate (const void *a, const void *b)
 {
+    const dir_entry_t *ea = a, *eb = b;
 #ifdef HAVE_STRCOLL
-    return strcoll (*a, *b);
+    return strcoll (ea->name, eb->name);
 #else
-    return strcmp  (*a, *b);
+    return strcmp  (ea->name, eb->name);
 #endif
 }
 
+static void ListingDelete (listing_t *listing)
+{
+    for (unsigned i = 0; i < listing->count; i++)
+        free (listing->entries[i].name);
+    vlc_cond_destroy (&listing->wait);
+    vlc_mutex_destroy (&listing->lock);
+    free (listing);
+}
+
+static void ListingRelease (listing_t *listing)
+{
+    vlc_mutex_lock (&listing_lock);
+    bool last = --listing->refs == 0;
+    vlc_mutex_unlock (&listing_lock);
+    if (last)
+        ListingDelete (listing);
+}
+
+/**
+ * Reads and sorts the entries of a directory. Their types are taken from
+ * the directory if possible, so that most files need not be opened.
+ */
+static listing_t *ListingLoad (DIR *handle)
+{
+    dir_entry_t *tab = NULL;
+    unsigned num = 0;
+
+#if defined (HAVE_OPENAT) && defined (DT_UNKNOWN)
+    rewinddir (handle);
+    for (unsigned size = 0;;)
+    {
+        struct dirent *ent = readdir (handle);
+        if (ent == NULL)
+            break;
+        if (!visible (ent->d_name))
+            continue;
+
+        if (num >= size)
+        {
+            size = size ? (2 * size) : 16;
+            dir_entry_t *newtab = realloc (tab, sizeof (*tab) * size);
+            if (unlikely(newtab == NULL))
+                break;
+            tab = newtab;
+        }
+# ifndef __APPLE__
+        tab[num].name = FromLocaleDup (ent->d_name);
+# else
+        tab[num].name = FromCharset ("UTF-8-MAC", ent->d_name,
+                                     strlen (ent->d_name));
+# endif
+        if (unlikely(tab[num].name == NULL))
+            break;
+        switch (ent->d_type)
+        {
+            case DT_DIR:
+                tab[num].type = ENTRY_DIR;
+                break;
+            case DT_LNK:
+            case DT_UNKNOWN:
+                tab[num].type = ENTRY_UNKNOWN;
+                break;
+            default:
+                tab[num].type = ENTRY_FILE;
+        }
+        num++;
+    }
+#else
+    char **filev;
+    int filec = vlc_loaddir (handle, &filev, visible, NULL);
+    if (filec > 0)
+    {
+        tab = malloc (sizeof (*tab) * filec);
+        for (int i = 0; i < filec; i++)
+        {
+            if (likely(tab != NULL))
+            {
+                tab[num].name = filev[i];
+# ifdef HAVE_OPENAT
+                tab[num++].type = ENTRY_UNKNOWN;
+# else
+                tab[num++].type = ENTRY_ANY;
+# endif
+            }
+            else
+                free (filev[i]);
+        }
+        free (filev);
+    }
+#endif
+
+    listing_t *listing = malloc (sizeof (*listing) + num * sizeof (*tab));
+    if (unlikely(listing == NULL))
+    {
+        while (num > 0)
+            free (tab[--num].name);
+        free (tab);
+        return NULL;
+    }
+    vlc_mutex_init (&listing->lock);
+    vlc_cond_init (&listing->wait);
+    listing->refs = 1;
+    listing->count = num;
+    if (num > 0)
+        memcpy (listing->entries, tab, num * sizeof (*tab));
+    free (tab);
+    qsort (listing->entries, num, sizeof (*tab), collate);
+    return listing;
+}
+
+#ifdef HAVE_OPENAT
+/**
+ * Gets the listing of a directory, from the cache if it has not changed.
+ */
+static listing_t *ListingGet (DIR *handle, const struct stat *st)
+{
+    mtime_t now = mdate ();
+    listing_t *listing, **pp;
+
+    vlc_mutex_lock (&listing_lock);
+    for (pp = &listing_cache; (listing = *pp) != NULL;)
+    {
+        if (listing->date + LISTING_CACHE_DELAY < now)
+        {   /* Expired */
+            *pp = listing->next;
+            if (--listing->refs == 0)
+                ListingDelete (listing);
+            continue;
+        }
+        if (listing->device == st->st_dev && listing->inode == st->st_ino
+         && listing->mtime == st->st_mtime)
+        {
+            listing->refs++;
+            vlc_mutex_unlock (&listing_lock);
+            return listing;
+        }
+        pp = &listing->next;
+    }
+    vlc_mutex_unlock (&listing_lock);
+
+    listing = ListingLoad (handle);
+    if (unlikely(listing == NULL))
+        return NULL;
+    listing->device = st->st_dev;
+    listing->inode = st->st_ino;
+    listing->mtime = st->st_mtime;
+    listing->date = now;
+
+    vlc_mutex_lock (&listing_lock);
+    listing->refs++; /* reference of the cache */
+    listing->next = listing_cache;
+    listing_cache = listing;
+
+    /* Drop the oldest listings */
+    pp = &listing_cache;
+    for (unsigned n = 0; *pp != NULL && n < LISTING_CACHE_MAX; n++)
+        pp = &(*pp)->next;
+    for (listing_t *old = *pp, *next; old != NULL; old = next)
+    {
+        next = old->next;
+        if (--old->refs == 0)
+            ListingDelete (old);
+    }
+    *pp = NULL;
+    vlc_mutex_unlock (&listing_lock);
+    return listing;
+}
+
+/* Finds the types of the entries that are not known from the directory
+ * (e.g. symbolic links), so that the files need not be opened. */
+static void *ProbeThread (void *data)
+{
+    directory_t *dir = data;
+    listing_t *listing = dir->listing;
+    int fd = dirfd (dir->handle);
+
+    vlc_mutex_lock (&listing->lock);
+    for (;;)
+    {
+        while (dir->probe_next < listing->count
+            && listing->entries[dir->probe_next].type != ENTRY_UNKNOWN)
+            dir->probe_next++;
+        if (dir->probe_next >= listing->count)
+            break;
+
+        dir_entry_t *ent = &listing->entries[dir->probe_next++];
+        vlc_mutex_unlock (&listing->lock);
+
+        unsigned char type = ENTRY_ANY;
+        const char *local_name = ToLocale (ent->name);
+        if (likely(local_name != NULL))
+        {
+            struct stat st;
+            if (fstatat (fd, local_name, &st, 0) == 0)
+                type = S_ISDIR (st.st_mode) ? ENTRY_DIR : ENTRY_FILE;
+            LocaleFree (local_name);
+        }
+
+        vlc_mutex_lock (&listing->lock);
+        ent->type = type;
+        vlc_cond_broadcast (&listing->wait);
+    }
+    vlc_mutex_unlock (&listing->lock);
+    return NULL;
+}
+
+static void ProbeStart (directory_t *dir)
+{
+    listing_t *listing = dir->listing;
+    bool unknown = false;
+
+    dir->probec = 0;
+    dir->probe_next = 0;
+
+    vlc_mutex_lock (&listing->lock);
+    for (unsigned i = 0; i < listing->count && !unknown; i++)
+        unknown = listing->entries[i].type == ENTRY_UNKNOWN;
+    vlc_mutex_unlock (&listing->lock);
+
+    if (!unknown)
+        return;
+    for (unsigned i = 0; i < PROBE_THREADS; i++)
+        if (vlc_clone (&dir->probers[dir->probec], ProbeThread, dir,
+                       VLC_THREAD_PRIORITY_LOW) == 0)
+            dir->probec++;
+}
+
+static void ProbeStop (directory_t *dir)
+{
+    listing_t *listing = dir->listing;
+
+    vlc_mutex_lock (&listing->lock);
+    dir->probe_next = listing->count;
+    vlc_mutex_unlock (&listing->lock);
+
+    for (unsigned i = 0; i < dir->probec; i++)
+        vlc_join (dir->probers[i], NULL);
+}
+#endif
+
+/* Gets the type of the next entry of a directory */
+static unsigned char EntryType (directory_t *dir, unsigned i)
+{
+#ifdef HAVE_OPENAT
+    listing_t *listing = dir->listing;
+    unsigned char type;
+
+    vlc_mutex_lock (&listing->lock);
+    while ((type = listing->entries[i].type) == ENTRY_UNKNOWN
+        && dir->probec > 0)
+        vlc_cond_wait (&listing->wait, &listing->lock);
+    vlc_mutex_unlock (&listing->lock);
+    return (type != ENTRY_UNKNOWN) ? type : ENTRY_ANY;
+#else
+    return dir->listing->entries[i].type;
+#endif
+}
+
+static void DirectoryDelete (directory_t *dir)
+{
+#ifdef HAVE_OPENAT
+    ProbeStop (dir);
+#else
+    free (dir->path);
+#endif
+    ListingRelease (dir->listing);
+    closedir (dir->handle);
+    free (dir->uri);
+    free (dir);
+}
+
+/* Appends to the XSPF extension. This is called for each item, and the
+ * extension is huge for large folders: it must not be copied every time. */
+static void AppendExtension (access_sys_t *p_sys, const char *fmt, ...)
+{
+    va_list ap;
+
+    if (p_sys->xspf_ext == NULL)
+        return;
+
+    va_start (ap, fmt);
+    int len = vsnprintf (NULL, 0, fmt, ap);
+    va_end (ap);
+    if (len < 0)
+        goto error;
+
+    if (p_sys->xspf_len + len + 1 > p_sys->xspf_size)
+    {
+        size_t size = 2 * (p_sys->xspf_len + len + 1);
+        char *ext = realloc (p_sys->xspf_ext, size);
+        if (unlikely(ext == NULL))
+            goto error;
+        p_sys->xspf_ext = ext;
+        p_sys->xspf_size = size;
+    }
+
+    va_start (ap, fmt);
+    vsnprintf (p_sys->xspf_ext + p_sys->xspf_len, len + 1, fmt, ap);
+    va_end (ap);
+    p_sys->xspf_len += len;
+    return;
+
+error:
+    free (p_sys->xspf_ext);
+    p_sys->xspf_ext = NULL;
+}
+
 /*****************************************************************************
  * Open: open the directory
  *****************************************************************************/
@@ -143,13 +500,11 @@ int DirInit (access_t *p_access, DIR *handle)
     root->parent = NULL;
     root->handle = handle;
     root->uri = uri;
-    root->filec = vlc_loaddir (handle, &root->filev, visible, collate);
-    if (root->filec < 0)
-        root->filev = NULL;
     root->i = 0;
 #ifdef HAVE_OPENAT
     struct stat st;
-    if (fstat (dirfd (handle), &st))
+    if (fstat (dirfd (handle), &st)
+     || (root->listing = ListingGet (handle, &st)) == NULL)
     {
         free (root);
         free (uri);
@@ -157,7 +512,15 @@ int DirInit (access_t *p_access, DIR *handle)
     }
     root->device = st.st_dev;
     root->inode = st.st_ino;
+    ProbeStart (root);
 #else
+    root->listing = ListingLoad (handle);
+    if (unlikely(root->listing == NULL))
+    {
+        free (root);
+        free (uri);
+        goto error;
+    }
     root->path = strdup (p_access->psz_filepath);
 #endif
 
@@ -167,6 +530,8 @@ int DirInit (access_t *p_access, DIR *handle)
     p_sys->header = true;
     p_sys->i_item_count = 0;
     p_sys->xspf_ext = strdup ("");
+    p_sys->xspf_len = 0;
+    p_sys->xspf_size = 1;
 
     /* Handle mode */
     char *psz = var_InheritString (p_access, "recursive");
@@ -207,15 +572,7 @@ void DirClose( vlc_object_t * p_this )
         directory_t *current = p_sys->current;
 
         p_sys->current = current->parent;
-        closedir (current->handle);
-        free (current->uri);
-        while (current->i < current->filec)
-            free (current->filev[current->i++]);
-        free (current->filev);
-#ifndef HAVE_OPENAT
-        free (current->path);
-#endif
-        free (current);
+        DirectoryDelete (current);
     }
 
     free (p_sys->xspf_ext);
@@ -259,16 +616,10 @@ block_t *DirBlock (access_t *p_access)
         return block;
     }
 
-    if (current->i >= current->filec)
+    if (current->i >= current->listing->count)
     {   /* End of directory, go back to parent */
-        closedir (current->handle);
         p_sys->current = current->parent;
-        free (current->uri);
-        free (current->filev);
-#ifndef HAVE_OPENAT
-        free (current->path);
-#endif
-        free (current);
+        DirectoryDelete (current);
 
         if (p_sys->current == NULL)
         {   /* End of XSPF playlist */
@@ -292,22 +643,24 @@ block_t *DirBlock (access_t *p_access)
         {
             /* This was the end of a "subnode" */
             /* Write the ID to the extension */
-            char *old_xspf_ext = p_sys->xspf_ext;
-            if (old_xspf_ext != NULL
-             && asprintf (&p_sys->xspf_ext, "%s  </vlc:node>\n",
-                          old_xspf_ext ? old_xspf_ext : "") == -1)
-                p_sys->xspf_ext = NULL;
-            free (old_xspf_ext);
+            AppendExtension (p_sys, "  </vlc:node>\n");
         }
         return NULL;
     }
 
-    char *entry = current->filev[current->i++];
+    unsigned type = EntryType (current, current->i);
+    const char *entry = current->listing->entries[current->i++].name;
 
     /* Handle recursion */
     if (p_sys->mode != MODE_COLLAPSE)
     {
         DIR *handle;
+
+        /* Files and directories known from the listing need not be opened */
+        if (type == ENTRY_FILE)
+            goto notdir;
+        if (type == ENTRY_DIR && p_sys->mode == MODE_NONE)
+            return NULL;
 #ifdef HAVE_OPENAT
         int fd = vlc_openat (dirfd (current->handle), entry,
                              O_RDONLY | O_DIRECTORY);
@@ -315,7 +668,7 @@ block_t *DirBlock (access_t *p_access)
         {
             if (errno == ENOTDIR)
                 goto notdir;
-            goto skip; /* File cannot be opened... forget it */
+            return NULL; /* File cannot be opened... forget it */
         }
 
         struct stat st;
@@ -325,16 +678,23 @@ block_t *DirBlock (access_t *p_access)
          || (handle = fdopendir (fd)) == NULL)
         {
             close (fd);
-            goto skip;
+            return NULL;
         }
 #else
         char *path;
         if (asprintf (&path, "%s/%s", current->path, entry) == -1)
-            goto skip;
+            return NULL;
         if ((handle = vlc_opendir (path)) == NULL)
+        {
+            free (path);
             goto notdir;
+        }
         if (p_sys->mode == MODE_NONE)
-            goto skip;
+        {
+            closedir (handle);
+            free (path);
+            return NULL;
+        }
 #endif
         directory_t *sub = malloc (sizeof (*sub));
         if (unlikely(sub == NULL))
@@ -343,17 +703,29 @@ block_t *DirBlock (access_t *p_access)
 #ifndef HAVE_OPENAT
             free (path);
 #endif
-            goto skip;
+            return NULL;
         }
         sub->parent = current;
         sub->handle = handle;
-        sub->filec = vlc_loaddir (handle, &sub->filev, visible, collate);
-        if (sub->filec < 0)
-            sub->filev = NULL;
         sub->i = 0;
+#ifdef HAVE_OPENAT
+        sub->listing = ListingGet (handle, &st);
+#else
+        sub->listing = ListingLoad (handle);
+#endif
+        if (unlikely(sub->listing == NULL))
+        {
+            closedir (handle);
+#ifndef HAVE_OPENAT
+            free (path);
+#endif
+            free (sub);
+            return NULL;
+        }
 #ifdef HAVE_OPENAT
         sub->device = st.st_dev;
         sub->inode = st.st_ino;
+        ProbeStart (sub);
 #else
         sub->path = path;
 #endif
@@ -365,22 +737,18 @@ block_t *DirBlock (access_t *p_access)
              sub->uri = NULL;
         free (encoded);
         if (unlikely(sub->uri == NULL))
-        {
-            free (entry);
             goto fatal;
-        }
 
         /* Add node to XSPF extension */
-        char *old_xspf_ext = p_sys->xspf_ext;
-        EnsureUTF8 (entry);
-        char *title = convert_xml_special_chars (entry);
-        if (old_xspf_ext != NULL
-         && asprintf (&p_sys->xspf_ext, "%s  <vlc:node title=\"%s\">\n",
-                      old_xspf_ext, title ? title : "?") == -1)
-            p_sys->xspf_ext = NULL;
-        free (old_xspf_ext);
+        char *name = strdup (entry); /* the listing may be shared */
+        if (likely(name != NULL))
+            EnsureUTF8 (name);
+        char *title = name ? convert_xml_special_chars (name) : NULL;
+        AppendExtension (p_sys, "  <vlc:node title=\"%s\">\n",
+                         title ? title : "?");
         free (title);
-        goto skip;
+        free (name);
+        return NULL;
     }
 
 notdir:
@@ -400,10 +768,7 @@ notdir:
 
                 if (type + extlen == end
                  && !strncasecmp (ext, type, extlen))
-                {
-                    free (entry);
                     return NULL;
-                }
 
                 if (*end == '\0')
                     break;
@@ -412,10 +777,10 @@ notdir:
     }
 
     char *encoded = encode_URI_component (entry);
-    free (entry);
     if (encoded == NULL)
         goto fatal;
-    int len = asprintf (&entry,
+    char *item;
+    int len = asprintf (&item,
                         "  <track><location>%s/%s</location>\n" \
                         "   <extension application=\"http://www.videolan.org/vlc/playlist/0\">\n" \
                         "    <vlc:id>%d</vlc:id>\n" \
@@ -427,17 +792,13 @@ notdir:
         goto fatal;
 
     /* Write the ID to the extension */
-    char *old_xspf_ext = p_sys->xspf_ext;
-    if (old_xspf_ext != NULL
-     && asprintf (&p_sys->xspf_ext, "%s   <vlc:item tid=\"%i\" />\n",
-                  old_xspf_ext, p_sys->i_item_count - 1) == -1)
-        p_sys->xspf_ext = NULL;
-    free (old_xspf_ext);
-
-    block_t *block = block_heap_Alloc (entry, entry, len);
+    AppendExtension (p_sys, "   <vlc:item tid=\"%i\" />\n",
+                     p_sys->i_item_count - 1);
+
+    block_t *block = block_heap_Alloc (item, item, len);
     if (unlikely(block == NULL))
     {
-        free (entry);
+        free (item);
         goto fatal;
     }
     return block;
@@ -445,10 +806,6 @@ notdir:
 fatal:
     p_access->info.b_eof = true;
     return NULL;
-
-skip:
-    free (entry);
-    return NULL;
 }
 
 /*****************************************************************************
@@ -405,6 +405,9 @@ vlc_module_end ()
 
 struct access_sys_t
 {
+#ifdef HAVE_LINUX_DVB
+    dvb_client_t *client;
+#endif
     dvb_device_t *dev;
     uint8_t signal_poll;
 };
@@ -425,6 +428,16 @@ static const delsys_t *GuessSystem (const char *, dvb_device_t *);
 static int Tune (vlc_object_t *, dvb_device_t *, const delsys_t *, uint64_t);
 static uint64_t var_InheritFrequency (vlc_object_t *);
 
+#ifdef HAVE_LINUX_DVB
+static int TuneShared (vlc_object_t *obj, dvb_device_t *dev, uint64_t freq)
+{
+    const delsys_t *delsys = GuessSystem (((access_t *)obj)->psz_access, dev);
+    if (delsys == NULL)
+        return VLC_EGENERIC;
+    return Tune (obj, dev, delsys, freq);
+}
+#endif
+
 static int Open (vlc_object_t *obj)
 {
     access_t *access = (access_t *)obj;
@@ -434,6 +447,29 @@ static int Open (vlc_object_t *obj)
 
     var_LocationParse (obj, access->psz_location, "dvb-");
 
+    uint64_t freq = var_InheritFrequency (obj);
+#ifdef HAVE_LINUX_DVB
+    /* Several inputs can use the same tuner, on the same frequency. */
+    sys->client = dvb_share_open (obj, freq, TuneShared);
+    if (sys->client == NULL)
+    {
+        if (freq != 0)
+        {
+            msg_Err (obj, "tuning to %"PRIu64" Hz failed", freq);
+            dialog_Fatal (obj, N_("Digital broadcasting"),
+                          N_("The selected digital tuner does not support "
+                             "the specified parameters.\n"
+                             "Please check the preferences."));
+        }
+        free (sys);
+        return VLC_EGENERIC;
+    }
+
+    sys->dev = dvb_share_device (sys->client);
+    sys->signal_poll = 0;
+    access->p_sys = sys;
+    dvb_share_add_pid (sys->client, 0);
+#else
     dvb_device_t *dev = dvb_open (obj);
     if (dev == NULL)
     {
@@ -445,7 +481,6 @@ static int Open (vlc_object_t *obj)
     sys->signal_poll = 0;
     access->p_sys = sys;
 
-    uint64_t freq = var_InheritFrequency (obj);
     if (freq != 0)
     {
         const delsys_t *delsys = GuessSystem (access->psz_access, dev);
@@ -460,6 +495,7 @@ static int Open (vlc_object_t *obj)
         }
     }
     dvb_add_pid (dev, 0);
+#endif
 
     access->pf_block = Read;
     access->pf_control = Control;
@@ -470,10 +506,12 @@ static int Open (vlc_object_t *obj)
     }
     return VLC_SUCCESS;
 
+#ifndef HAVE_LINUX_DVB
 error:
     Close (obj);
     access->p_sys = NULL;
     return VLC_EGENERIC;
+#endif
 }
 
 static void Close (vlc_object_t *obj)
@@ -481,18 +519,32 @@ static void Close (vlc_object_t *obj)
     access_t *access = (access_t *)obj;
     access_sys_t *sys = access->p_sys;
 
+#ifdef HAVE_LINUX_DVB
+    dvb_share_close (sys->client);
+#else
     dvb_close (sys->dev);
+#endif
     free (sys);
 }
 
 static block_t *Read (access_t *access)
 {
+    access_sys_t *sys = access->p_sys;
+#ifdef HAVE_LINUX_DVB
+    bool eof;
+    block_t *block = dvb_share_read (sys->client, &eof);
+
+    if (block == NULL)
+    {
+        access->info.b_eof = eof;
+        return NULL;
+    }
+#else
 #define BUFSIZE (20*188)
     block_t *block = block_Alloc (BUFSIZE);
     if (unlikely(block == NULL))
         return NULL;
 
-    access_sys_t *sys = access->p_sys;
     ssize_t val = dvb_read (sys->dev, block->p_buffer, BUFSIZE);
 
     if (val <= 0)
@@ -504,6 +556,7 @@ static block_t *Read (access_t *access)
     }
 
     block->i_buffer = val;
+#endif
 
     /* Fetch the signal levels every so often. Some devices do not like this
      * to be requested too frequently, e.g. due to low bandwidth I²C bus. */
@@ -565,6 +618,15 @@ static int Control (access_t *access, int query, va_list args)
 
             if (unlikely(pid > 0x1FFF))
                 return VLC_EGENERIC;
+#ifdef HAVE_LINUX_DVB
+            if (add)
+            {
+                if (dvb_share_add_pid (sys->client, pid))
+                    return VLC_EGENERIC;
+            }
+            else
+                dvb_share_remove_pid (sys->client, pid);
+#else
             if (add)
             {
                 if (dvb_add_pid (dev, pid))
@@ -572,6 +634,7 @@ static int Control (access_t *access, int query, va_list args)
             }
             else
                 dvb_remove_pid (dev, pid);
+#endif
             return VLC_SUCCESS;
         }
 
@@ -580,7 +643,11 @@ static int Control (access_t *access, int query, va_list args)
         {
             struct dvbpsi_pmt_s *pmt = va_arg (args, struct dvbpsi_pmt_s *);
 
+#ifdef HAVE_LINUX_DVB
+            dvb_share_set_ca_pmt (sys->client, pmt);
+#else
             dvb_set_ca_pmt (dev, pmt);
+#endif
             return VLC_SUCCESS;
         }
 #endif
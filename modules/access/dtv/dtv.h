@@ -59,6 +59,23 @@ struct dvbpsi_pmt_s;
 void dvb_set_ca_pmt (dvb_device_t *, struct dvbpsi_pmt_s *);
 #endif
 
+#ifdef HAVE_LINUX_DVB
+/* Tuner sharing */
+typedef struct dvb_client dvb_client_t;
+
+dvb_client_t *dvb_share_open (vlc_object_t *, uint64_t freq,
+                              int (*tune) (vlc_object_t *, dvb_device_t *,
+                                           uint64_t));
+void dvb_share_close (dvb_client_t *);
+dvb_device_t *dvb_share_device (dvb_client_t *);
+block_t *dvb_share_read (dvb_client_t *, bool *eof);
+int dvb_share_add_pid (dvb_client_t *, uint16_t);
+void dvb_share_remove_pid (dvb_client_t *, uint16_t);
+# ifdef HAVE_DVBPSI
+void dvb_share_set_ca_pmt (dvb_client_t *, struct dvbpsi_pmt_s *);
+# endif
+#endif
+
 int dvb_set_inversion (dvb_device_t *, int);
 int dvb_tune (dvb_device_t *);
 
@@ -161,6 +161,7 @@ struct dvb_device
 #endif
 #ifdef HAVE_DVBPSI
     cam_t *cam;
+    vlc_mutex_t cam_lock; /* if cam is not NULL */
 #endif
     uint8_t device;
     bool budget;
@@ -270,6 +271,8 @@ dvb_device_t *dvb_open (vlc_object_t *obj)
         d->cam = en50221_Init (obj, ca);
         if (d->cam == NULL)
             close (ca);
+        else
+            vlc_mutex_init (&d->cam_lock);
     }
     else
         msg_Dbg (obj, "conditional access module not available (%m)");
@@ -293,7 +296,10 @@ void dvb_close (dvb_device_t *d)
 #endif
 #ifdef HAVE_DVBPSI
     if (d->cam != NULL)
+    {
         en50221_End (d->cam);
+        vlc_mutex_destroy (&d->cam_lock);
+    }
 #endif
     if (d->frontend != -1)
         close (d->frontend);
@@ -313,7 +319,13 @@ ssize_t dvb_read (dvb_device_t *d, void *buf, size_t len)
 
 #ifdef HAVE_DVBPSI
     if (d->cam != NULL)
+    {   /* The CAM may be shared with other threads, see share.c */
+        int canc = vlc_savecancel ();
+        vlc_mutex_lock (&d->cam_lock);
         en50221_Poll (d->cam);
+        vlc_mutex_unlock (&d->cam_lock);
+        vlc_restorecancel (canc);
+    }
 #endif
 
     ufd[0].fd = d->demux;
@@ -530,7 +542,11 @@ float dvb_get_snr (dvb_device_t *d)
 void dvb_set_ca_pmt (dvb_device_t *d, struct dvbpsi_pmt_s *pmt)
 {
     if (d->cam != NULL)
+    {
+        vlc_mutex_lock (&d->cam_lock);
         en50221_SetCAPMT (d->cam, pmt);
+        vlc_mutex_unlock (&d->cam_lock);
+    }
 }
 #endif
 
@@ -0,0 +1,406 @@
+/**
+ * @file share.c
+ * @brief Sharing of a DVB tuner among several accesses
+ */
+/*****************************************************************************
+ * Copyright © 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <assert.h>
+
+#include "dtv/dtv.h"
+
+/*
+ * Each adapter is opened once, by the first access, and tuned by it. The
+ * following accesses for the same adapter and frequency share it: the
+ * hardware filters the union of the PIDs they need, and a thread of the
+ * tuner dispatches the TS packets to the accesses that want them. So each
+ * TS demux only sees the packets of its own programs.
+ */
+
+#define TS_PACKET_SIZE 188
+#define READ_SIZE (20*TS_PACKET_SIZE)
+/* Beyond this, the packets for a client that does not read are dropped */
+#define MAX_QUEUE (4 << 20)
+/* Longest wait for data in dvb_share_read(): the input thread only notices
+ * that it is stopped between two reads, so it must get control back. */
+#define READ_TIMEOUT (CLOCK_FREQ / 2)
+
+typedef struct dvb_share dvb_share_t;
+
+struct dvb_share
+{
+    dvb_share_t  *next;
+    vlc_object_t *obj; /* outlives the accesses */
+    dvb_device_t *dev;
+    unsigned      adapter;
+    unsigned      device;
+    uint64_t      freq;
+    unsigned      refs; /* protected by share_lock */
+    bool          budget;
+    vlc_thread_t  thread;
+
+    vlc_mutex_t   lock;
+    dvb_client_t *clients;
+    uint16_t      pid_refs[8192];
+};
+
+struct dvb_client
+{
+    dvb_client_t *next;
+    dvb_share_t  *share;
+    vlc_object_t *obj;
+    vlc_cond_t    wait;
+    block_t      *first;
+    block_t     **lastp;
+    size_t        size;
+    bool          eof;
+    bool          overflow;
+    uint32_t      pids[8192 / 32];
+};
+
+static vlc_mutex_t share_lock = VLC_STATIC_MUTEX;
+static dvb_share_t *shares = NULL;
+
+static bool client_has_pid (const dvb_client_t *c, uint16_t pid)
+{
+    return (c->pids[pid >> 5] >> (pid & 31)) & 1;
+}
+
+/** Copies the packets wanted by each client into its queue */
+static void dvb_share_dispatch (dvb_share_t *s, const uint8_t *buf,
+                                size_t len)
+{
+    vlc_mutex_lock (&s->lock);
+    for (dvb_client_t *c = s->clients; c != NULL; c = c->next)
+    {
+        block_t *block = block_Alloc (len);
+        if (unlikely(block == NULL))
+            break;
+
+        size_t out = 0;
+        for (size_t i = 0; i + TS_PACKET_SIZE <= len; )
+        {
+            if (buf[i] != 0x47)
+            {   /* lost synchronization */
+                i++;
+                continue;
+            }
+
+            uint16_t pid = ((buf[i + 1] & 0x1F) << 8) | buf[i + 2];
+            if (s->budget || client_has_pid (c, pid))
+            {
+                memcpy (block->p_buffer + out, buf + i, TS_PACKET_SIZE);
+                out += TS_PACKET_SIZE;
+            }
+            i += TS_PACKET_SIZE;
+        }
+
+        if (out == 0 || c->size + out > MAX_QUEUE)
+        {
+            if (out != 0 && !c->overflow)
+                msg_Err (c->obj, "cannot read data fast enough!");
+            c->overflow = out != 0;
+            block_Release (block);
+            continue;
+        }
+        c->overflow = false;
+        block->i_buffer = out;
+        *(c->lastp) = block;
+        c->lastp = &block->p_next;
+        c->size += out;
+        vlc_cond_signal (&c->wait);
+    }
+    vlc_mutex_unlock (&s->lock);
+}
+
+static void *dvb_share_thread (void *data)
+{
+    dvb_share_t *s = data;
+    uint8_t buf[READ_SIZE];
+
+    for (;;)
+    {
+        ssize_t val = dvb_read (s->dev, buf, sizeof (buf));
+        int canc = vlc_savecancel ();
+
+        if (val > 0)
+            dvb_share_dispatch (s, buf, val);
+        else if (val == 0)
+        {
+            vlc_mutex_lock (&s->lock);
+            for (dvb_client_t *c = s->clients; c != NULL; c = c->next)
+            {
+                c->eof = true;
+                vlc_cond_signal (&c->wait);
+            }
+            vlc_mutex_unlock (&s->lock);
+            vlc_restorecancel (canc);
+            break;
+        }
+        vlc_restorecancel (canc);
+    }
+    return NULL;
+}
+
+/** Creates the object of a tuner, with the settings of the first access */
+static vlc_object_t *dvb_share_object (vlc_object_t *obj)
+{
+    static const char bools[][20] = {
+        "dvb-budget-mode", "dvb-high-voltage",
+    };
+    static const char ints[][20] = {
+        "dvb-adapter", "dvb-device", "dvb-tone", "dvb-satno",
+    };
+
+    vlc_object_t *tuner = vlc_object_create (obj->p_libvlc, sizeof (*tuner));
+    if (unlikely(tuner == NULL))
+        return NULL;
+
+    for (size_t i = 0; i < sizeof (bools) / sizeof (bools[0]); i++)
+    {
+        var_Create (tuner, bools[i], VLC_VAR_BOOL);
+        var_SetBool (tuner, bools[i], var_InheritBool (obj, bools[i]));
+    }
+    for (size_t i = 0; i < sizeof (ints) / sizeof (ints[0]); i++)
+    {
+        var_Create (tuner, ints[i], VLC_VAR_INTEGER);
+        var_SetInteger (tuner, ints[i], var_InheritInteger (obj, ints[i]));
+    }
+    return tuner;
+}
+
+static void dvb_share_delete (dvb_share_t *s)
+{
+    vlc_mutex_destroy (&s->lock);
+    dvb_close (s->dev);
+    vlc_object_release (s->obj);
+    free (s);
+}
+
+/**
+ * Opens a shared tuner. If the adapter is not open yet, it is opened and
+ * tuned with the given callback. Otherwise the frequency must match the
+ * current one, or be zero.
+ */
+dvb_client_t *dvb_share_open (vlc_object_t *obj, uint64_t freq,
+                              int (*tune) (vlc_object_t *, dvb_device_t *,
+                                           uint64_t))
+{
+    dvb_client_t *c = malloc (sizeof (*c));
+    if (unlikely(c == NULL))
+        return NULL;
+
+    c->obj = obj;
+    vlc_cond_init (&c->wait);
+    c->first = NULL;
+    c->lastp = &c->first;
+    c->size = 0;
+    c->eof = false;
+    c->overflow = false;
+    memset (c->pids, 0, sizeof (c->pids));
+
+    unsigned adapter = var_InheritInteger (obj, "dvb-adapter");
+    unsigned device = var_InheritInteger (obj, "dvb-device");
+    dvb_share_t *s;
+
+    vlc_mutex_lock (&share_lock);
+    for (s = shares; s != NULL; s = s->next)
+        if (s->adapter == adapter && s->device == device)
+            break;
+
+    if (s != NULL)
+    {
+        if (freq != 0 && freq != s->freq)
+        {
+            msg_Err (obj, "adapter %u is tuned to %"PRIu64" Hz", adapter,
+                     s->freq);
+            goto error;
+        }
+        msg_Dbg (obj, "sharing adapter %u with %u other access(es)",
+                 adapter, s->refs);
+    }
+    else
+    {
+        s = malloc (sizeof (*s));
+        if (unlikely(s == NULL))
+            goto error;
+
+        s->obj = dvb_share_object (obj);
+        if (unlikely(s->obj == NULL))
+        {
+            free (s);
+            goto error;
+        }
+        s->dev = dvb_open (s->obj);
+        if (s->dev == NULL)
+        {
+            vlc_object_release (s->obj);
+            free (s);
+            goto error;
+        }
+        vlc_mutex_init (&s->lock);
+        s->adapter = adapter;
+        s->device = device;
+        s->freq = freq;
+        s->refs = 0;
+        s->budget = var_GetBool (s->obj, "dvb-budget-mode");
+        s->clients = NULL;
+        memset (s->pid_refs, 0, sizeof (s->pid_refs));
+
+        if ((freq != 0 && tune (obj, s->dev, freq))
+         || vlc_clone (&s->thread, dvb_share_thread, s,
+                       VLC_THREAD_PRIORITY_INPUT))
+        {
+            dvb_share_delete (s);
+            goto error;
+        }
+        s->next = shares;
+        shares = s;
+    }
+    s->refs++;
+    c->share = s;
+
+    vlc_mutex_lock (&s->lock);
+    c->next = s->clients;
+    s->clients = c;
+    vlc_mutex_unlock (&s->lock);
+    vlc_mutex_unlock (&share_lock);
+    return c;
+
+error:
+    vlc_mutex_unlock (&share_lock);
+    vlc_cond_destroy (&c->wait);
+    free (c);
+    return NULL;
+}
+
+void dvb_share_close (dvb_client_t *c)
+{
+    dvb_share_t *s = c->share;
+
+    vlc_mutex_lock (&share_lock);
+    vlc_mutex_lock (&s->lock);
+    for (dvb_client_t **pp = &s->clients; *pp != NULL; pp = &(*pp)->next)
+        if (*pp == c)
+        {
+            *pp = c->next;
+            break;
+        }
+    for (unsigned pid = 0; pid < 8192; pid++)
+        if (client_has_pid (c, pid) && --s->pid_refs[pid] == 0)
+            dvb_remove_pid (s->dev, pid);
+    vlc_mutex_unlock (&s->lock);
+
+    if (--s->refs == 0)
+    {
+        for (dvb_share_t **pp = &shares; *pp != NULL; pp = &(*pp)->next)
+            if (*pp == s)
+            {
+                *pp = s->next;
+                break;
+            }
+        vlc_cancel (s->thread);
+        vlc_join (s->thread, NULL);
+        dvb_share_delete (s);
+    }
+    vlc_mutex_unlock (&share_lock);
+
+    block_ChainRelease (c->first);
+    vlc_cond_destroy (&c->wait);
+    free (c);
+}
+
+dvb_device_t *dvb_share_device (dvb_client_t *c)
+{
+    return c->share->dev;
+}
+
+/**
+ * Reads the TS packets of the PIDs of the client.
+ * @return a block, or NULL if no data (yet) or at the end of the stream
+ */
+block_t *dvb_share_read (dvb_client_t *c, bool *eof)
+{
+    dvb_share_t *s = c->share;
+    block_t *block;
+
+    vlc_mutex_lock (&s->lock);
+    if (c->first == NULL && !c->eof)
+        vlc_cond_timedwait (&c->wait, &s->lock, mdate () + READ_TIMEOUT);
+    block = c->first;
+    if (block != NULL)
+    {
+        c->first = block->p_next;
+        if (c->first == NULL)
+            c->lastp = &c->first;
+        block->p_next = NULL;
+        c->size -= block->i_buffer;
+    }
+    *eof = c->eof && block == NULL;
+    vlc_mutex_unlock (&s->lock);
+    return block;
+}
+
+int dvb_share_add_pid (dvb_client_t *c, uint16_t pid)
+{
+    dvb_share_t *s = c->share;
+    int ret = 0;
+
+    assert (pid < 8192);
+    vlc_mutex_lock (&s->lock);
+    if (!client_has_pid (c, pid))
+    {
+        if (s->pid_refs[pid] == 0)
+            ret = dvb_add_pid (s->dev, pid);
+        if (ret == 0)
+        {
+            s->pid_refs[pid]++;
+            c->pids[pid >> 5] |= 1u << (pid & 31);
+        }
+    }
+    vlc_mutex_unlock (&s->lock);
+    return ret;
+}
+
+void dvb_share_remove_pid (dvb_client_t *c, uint16_t pid)
+{
+    dvb_share_t *s = c->share;
+
+    assert (pid < 8192);
+    vlc_mutex_lock (&s->lock);
+    if (client_has_pid (c, pid))
+    {
+        c->pids[pid >> 5] &= ~(1u << (pid & 31));
+        if (--s->pid_refs[pid] == 0)
+            dvb_remove_pid (s->dev, pid);
+    }
+    vlc_mutex_unlock (&s->lock);
+}
+
+#ifdef HAVE_DVBPSI
+void dvb_share_set_ca_pmt (dvb_client_t *c, struct dvbpsi_pmt_s *pmt)
+{
+    dvb_set_ca_pmt (c->share->dev, pmt);
+}
+#endif
@@ -49,6 +49,9 @@
 #      include <sys/mount.h>
 #   endif
 #endif
+#ifdef HAVE_MMAP
+#   include <sys/mman.h>
+#endif
 #ifdef HAVE_LINUX_MAGIC_H
 #   include <sys/vfs.h>
 #   include <linux/magic.h>
@@ -355,6 +358,43 @@ int FileSeek (access_t *p_access, uint64_t i_pos)
     return VLC_SUCCESS;
 }
 
+#ifdef HAVE_MMAP
+/* Maps what the file holds now, which may have grown since the last time */
+static int FileMap (access_t *p_access, block_t **pp_block)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    struct stat st;
+
+    if (p_access->pf_seek == NoSeek
+     || !var_InheritBool (p_access, "file-mmap")
+     || fstat (p_sys->fd, &st) || !S_ISREG (st.st_mode) || st.st_size <= 0
+     || IsRemote (p_sys->fd, p_access->psz_filepath))
+        return VLC_EGENERIC;
+
+    /* Leave some address space to the rest on 32-bits systems */
+    if ((uint64_t)st.st_size >= SIZE_MAX / 4)
+        return VLC_EGENERIC;
+
+    size_t length = st.st_size;
+    void *addr = mmap (NULL, length, PROT_READ, MAP_SHARED, p_sys->fd, 0);
+    if (addr == MAP_FAILED)
+        return VLC_EGENERIC;
+#ifdef HAVE_POSIX_MADVISE
+    posix_madvise (addr, length, POSIX_MADV_SEQUENTIAL);
+#endif
+
+    block_t *block = block_mmap_Alloc (addr, length);
+    if (block == NULL)
+    {
+        munmap (addr, length);
+        return VLC_ENOMEM;
+    }
+    p_access->info.i_size = st.st_size;
+    *pp_block = block;
+    return VLC_SUCCESS;
+}
+#endif
+
 int NoSeek (access_t *p_access, uint64_t i_pos)
 {
     /* assert(0); ?? */
@@ -401,6 +441,13 @@ int FileControl( access_t *p_access, int i_query, va_list args )
             /* Nothing to do */
             break;
 
+        case ACCESS_GET_MMAP:
+#ifdef HAVE_MMAP
+            return FileMap (p_access, va_arg (args, block_t **));
+#else
+            return VLC_EGENERIC;
+#endif
+
         case ACCESS_GET_TITLE_INFO:
         case ACCESS_SET_TITLE:
         case ACCESS_SET_SEEKPOINT:
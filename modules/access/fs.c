@@ -37,6 +37,11 @@
         "collapse: subdirectories appear but are expanded on first play.\n" \
         "expand: all subdirectories are expanded.\n" )
 
+#define MMAP_TEXT N_("Map local files in memory")
+#define MMAP_LONGTEXT N_( \
+        "Read regular local files through a memory mapping instead of " \
+        "copying them, unless they are on a network file system." )
+
 static const char *const psz_recursive_list[] = { "none", "collapse", "expand" };
 static const char *const psz_recursive_list_text[] = {
     N_("none"), N_("collapse"), N_("expand") };
@@ -57,6 +62,7 @@ vlc_module_begin ()
     set_capability( "access", 50 )
     add_shortcut( "file", "fd", "stream" )
     set_callbacks( FileOpen, FileClose )
+    add_bool( "file-mmap", true, MMAP_TEXT, MMAP_LONGTEXT, true )
 
     add_submodule()
     set_section( N_("Directory" ), NULL )
@@ -99,6 +99,13 @@ static void Close( vlc_object_t * );
 #define UA_TEXT N_("User Agent")
 #define UA_LONGTEXT N_("You can use a custom User agent or use a known one")
 
+#define PARALLEL_TEXT N_("Parallel connections")
+#define PARALLEL_LONGTEXT N_( \
+    "Fetch seekable files as byte ranges over that many kept-alive " \
+    "connections at once, and put them back in order. This fills long fat " \
+    "links that a single connection cannot, and seeks reuse the open " \
+    "connections. 0 reads over a single connection.")
+
 vlc_module_begin ()
     set_description( N_("HTTP input") )
     set_capability( "access", 0 )
@@ -123,6 +130,8 @@ vlc_module_begin ()
         change_safe()
     add_bool( "http-forward-cookies", true, FORWARD_COOKIES_TEXT,
               FORWARD_COOKIES_LONGTEXT, true )
+    add_integer_with_range( "http-parallel", 0, 0, 8, PARALLEL_TEXT,
+                            PARALLEL_LONGTEXT, true )
     /* 'itpc' = iTunes Podcast */
     add_shortcut( "http", "https", "unsv", "itpc", "icyx" )
     set_callbacks( Open, Close )
@@ -132,6 +141,48 @@ vlc_module_end ()
  * Local prototypes
  *****************************************************************************/
 
+/* Parallel ranges ("http-parallel")
+ *  Every connection has a thread that takes the first range not taken yet
+ *  in the window, requests it over its kept-alive connection, and reads it
+ *  into a block. Blocks are handed out in file order. A seek drops the
+ *  window; a range still being read is read up if little is left of it,
+ *  so that its connection stays usable, or its connection is closed.
+ */
+#define HTTP_RANGE_SIZE   (512*1024)
+#define HTTP_RANGE_WINDOW 16       /* at most queued, 2 per connection */
+#define HTTP_RANGE_READ   (64*1024)
+#define HTTP_RANGE_DRAIN  (128*1024)
+#define HTTP_RANGE_TRIES  3
+
+enum
+{
+    RANGE_QUEUED,
+    RANGE_BUSY,
+    RANGE_DONE,
+    RANGE_FAILED,
+};
+
+typedef struct
+{
+    uint64_t i_offset;
+    size_t   i_size;
+    int      i_state;
+    int      i_tries;
+    block_t  *p_block;     /* once RANGE_DONE */
+} http_range_t;
+
+typedef struct
+{
+    access_t     *p_access;
+    vlc_thread_t thread;
+
+    /* Changed with the lock held, so that Close can shut it down */
+    int        fd;
+    vlc_tls_t  *p_tls;
+    v_socket_t *p_vs;
+    unsigned   i_requests; /* over this connection */
+} http_conn_t;
+
 struct access_sys_t
 {
     int fd;
@@ -190,6 +241,25 @@ struct access_sys_t
     bool b_has_size;
 
     vlc_array_t * cookies;
+
+    struct
+    {
+        bool         b_on;
+        unsigned     i_conns;
+        http_conn_t  *p_conns;
+        char         *psz_head;    /* request headers but Range and auth */
+
+        vlc_mutex_t  lock;
+        vlc_cond_t   wait;         /* a range is done or failed */
+        vlc_cond_t   wait_work;    /* a range is queued, or exit */
+        http_range_t p_ranges[HTTP_RANGE_WINDOW]; /* ring, in file order */
+        unsigned     i_first;
+        unsigned     i_count;
+        unsigned     i_window;
+        uint64_t     i_next;       /* offset of the next range to queue */
+        unsigned     i_generation; /* bumped when the window is dropped */
+        bool         b_exit;
+    } range;
 };
 
 /* */
@@ -207,6 +277,11 @@ static int Connect( access_t *, uint64_t );
 static int Request( access_t *p_access, uint64_t i_tell );
 static void Disconnect( access_t * );
 
+static int  RangeStart( access_t * );
+static void RangeStop( access_t * );
+static block_t *RangeBlock( access_t * );
+static int  RangeSeek( access_t *, uint64_t );
+
 /* Small Cookie utilities. Cookies support is partial. */
 static char * cookie_get_content( const char * cookie );
 static char * cookie_get_domain( const char * cookie );
@@ -287,6 +362,7 @@ static int OpenWithCookies( vlc_object_t *p_this, const char *psz_access,
     p_sys->i_remaining = 0;
     p_sys->b_persist = false;
     p_sys->b_has_size = false;
+    p_sys->range.b_on = false;
     p_access->info.i_size = 0;
     p_access->info.i_pos  = 0;
     p_access->info.b_eof  = false;
@@ -675,6 +751,22 @@ connect:
 
     if( p_sys->b_reconnect ) msg_Dbg( p_access, "auto re-connect enabled" );
 
+    /* Seekable and plain: fetch ranges in parallel if asked to */
+    if( var_InheritInteger( p_access, "http-parallel" ) > 0
+     && p_sys->i_code == 206 && p_sys->b_seekable && p_sys->b_has_size
+     && !p_sys->b_chunked && !p_sys->b_icecast && p_sys->i_icy_meta == 0
+#ifdef HAVE_ZLIB_H
+     && !p_sys->b_compressed
+#endif
+     && !p_sys->b_continuous
+     && ( !p_sys->b_proxy || ( !p_sys->b_ssl && !p_sys->proxy.psz_username ) )
+     && RangeStart( p_access ) == VLC_SUCCESS )
+    {
+        p_access->pf_read = NULL;
+        p_access->pf_block = RangeBlock;
+        p_access->pf_seek = RangeSeek;
+    }
+
     return VLC_SUCCESS;
 
 error:
@@ -712,6 +804,9 @@ static void Close( vlc_object_t *p_this )
     access_t     *p_access = (access_t*)p_this;
     access_sys_t *p_sys = p_access->p_sys;
 
+    if( p_sys->range.b_on )
+        RangeStop( p_access );
+
     vlc_UrlClean( &p_sys->url );
     http_auth_Reset( &p_sys->auth );
     vlc_UrlClean( &p_sys->proxy );
@@ -1653,6 +1748,497 @@ static void Disconnect( access_t *p_access )
 
 }
 
+/*****************************************************************************
+ * Parallel ranges
+ *****************************************************************************/
+static void RangeDisconnect( access_t *p_access, http_conn_t *p_conn )
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    vlc_mutex_lock( &p_sys->range.lock );
+    int fd = p_conn->fd;
+    vlc_tls_t *p_tls = p_conn->p_tls;
+    p_conn->fd = -1;
+    p_conn->p_tls = NULL;
+    p_conn->p_vs = NULL;
+    vlc_mutex_unlock( &p_sys->range.lock );
+
+    if( p_tls != NULL )
+        vlc_tls_ClientDelete( p_tls );
+    if( fd != -1 )
+        net_Close( fd );
+}
+
+static int RangeConnect( access_t *p_access, http_conn_t *p_conn )
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    const vlc_url_t *srv = p_sys->b_proxy ? &p_sys->proxy : &p_sys->url;
+
+    int fd = net_ConnectTCP( p_access, srv->psz_host, srv->i_port );
+    if( fd == -1 )
+        return VLC_EGENERIC;
+    setsockopt( fd, SOL_SOCKET, SO_KEEPALIVE, &(int){ 1 }, sizeof (int) );
+
+    vlc_mutex_lock( &p_sys->range.lock );
+    bool b_exit = p_sys->range.b_exit;
+    if( !b_exit )
+        p_conn->fd = fd;
+    vlc_mutex_unlock( &p_sys->range.lock );
+    if( b_exit )
+    {
+        net_Close( fd );
+        return VLC_EGENERIC;
+    }
+    p_conn->i_requests = 0;
+
+    if( p_sys->b_ssl )
+    {
+        vlc_tls_t *p_tls = vlc_tls_ClientCreate( VLC_OBJECT(p_access), fd,
+                                                 p_sys->url.psz_host );
+        if( p_tls == NULL )
+        {
+            msg_Err( p_access, "cannot establish HTTP/TLS session" );
+            RangeDisconnect( p_access, p_conn );
+            return VLC_EGENERIC;
+        }
+        vlc_mutex_lock( &p_sys->range.lock );
+        p_conn->p_tls = p_tls;
+        p_conn->p_vs = &p_tls->sock;
+        vlc_mutex_unlock( &p_sys->range.lock );
+    }
+    return VLC_SUCCESS;
+}
+
+/* Asks for the range and reads the answer up to the body. Returns the
+ * length of the body, or -1 if the connection is of no use anymore. */
+static int64_t RangeRequest( access_t *p_access, http_conn_t *p_conn,
+                             uint64_t i_offset, size_t i_size, bool *pb_close )
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    char *psz_auth = NULL, *psz;
+
+    if( p_sys->url.psz_username || p_sys->url.psz_password )
+    {
+        /* The nonce count is shared by the connections */
+        vlc_mutex_lock( &p_sys->range.lock );
+        psz_auth = http_auth_FormatAuthorizationHeader( VLC_OBJECT(p_access),
+                                                        &p_sys->auth, "GET",
+                                                        p_sys->url.psz_path,
+                                                        p_sys->url.psz_username,
+                                                        p_sys->url.psz_password );
+        vlc_mutex_unlock( &p_sys->range.lock );
+    }
+
+    /* In one go, the connection may well not delay small writes */
+    int i_ret = net_Printf( p_access, p_conn->fd, p_conn->p_vs,
+                            "%s%s%s%sRange: bytes=%"PRIu64"-%"PRIu64"\r\n\r\n",
+                            p_sys->range.psz_head,
+                            psz_auth ? "Authorization: " : "",
+                            psz_auth ? psz_auth : "", psz_auth ? "\r\n" : "",
+                            i_offset, i_offset + i_size - 1 );
+    free( psz_auth );
+    if( i_ret < 0 )
+        return -1;
+
+    if( ( psz = net_Gets( p_access, p_conn->fd, p_conn->p_vs ) ) == NULL )
+        return -1;
+    int i_code = 0;
+    if( !strncmp( psz, "HTTP/1.", 7 ) && strlen( psz ) >= 12 )
+    {
+        i_code = atoi( &psz[9] );
+        *pb_close = psz[7] == '0'; /* 1.0 closes unless told otherwise */
+    }
+    free( psz );
+
+    int64_t i_length = -1;
+    uint64_t i_start = i_offset;
+    bool b_chunked = false;
+    for( ;; )
+    {
+        if( ( psz = net_Gets( p_access, p_conn->fd, p_conn->p_vs ) ) == NULL )
+            return -1;
+        if( *psz == '\0' )
+        {
+            free( psz );
+            break;
+        }
+
+        char *p = strchr( psz, ':' );
+        if( p != NULL )
+        {
+            *p++ = '\0';
+            p += strspn( p, " \t" );
+            if( !strcasecmp( psz, "Content-Length" ) )
+                i_length = atoll( p );
+            else if( !strcasecmp( psz, "Content-Range" ) )
+                sscanf( p, "bytes %"SCNu64, &i_start );
+            else if( !strcasecmp( psz, "Connection" ) )
+                *pb_close = !strncasecmp( p, "close", 5 );
+            else if( !strcasecmp( psz, "Transfer-Encoding" ) )
+                b_chunked = strcasecmp( p, "identity" );
+        }
+        free( psz );
+    }
+
+    if( i_code != 206 || i_start != i_offset || b_chunked
+     || i_length < 0 || (uint64_t)i_length > i_size )
+    {
+        msg_Err( p_access, "range at %"PRIu64" refused (%d)", i_offset,
+                 i_code );
+        return -1;
+    }
+    return i_length;
+}
+
+static block_t *RangeFetch( access_t *p_access, http_conn_t *p_conn,
+                            uint64_t i_offset, size_t i_size,
+                            unsigned i_generation )
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    bool b_close = false;
+
+    if( p_conn->fd == -1 && RangeConnect( p_access, p_conn ) )
+        return NULL;
+
+    int64_t i_length = RangeRequest( p_access, p_conn, i_offset, i_size,
+                                     &b_close );
+    block_t *p_block = i_length >= 0 ? block_Alloc( i_length ) : NULL;
+    if( p_block == NULL )
+    {
+        if( p_conn->i_requests > 0 )
+            msg_Dbg( p_access, "kept-alive connection lost" );
+        RangeDisconnect( p_access, p_conn );
+        return NULL;
+    }
+    p_conn->i_requests++;
+
+    size_t i_got = 0;
+    while( i_got < p_block->i_buffer )
+    {
+        int i_read = net_Read( p_access, p_conn->fd, p_conn->p_vs,
+                               p_block->p_buffer + i_got,
+                               __MIN( HTTP_RANGE_READ,
+                                      p_block->i_buffer - i_got ), false );
+        if( i_read <= 0 )
+            break;
+        i_got += i_read;
+
+        /* Not wanted anymore: read it up only if that is cheaper than
+         * connecting again */
+        vlc_mutex_lock( &p_sys->range.lock );
+        bool b_stale = i_generation != p_sys->range.i_generation;
+        vlc_mutex_unlock( &p_sys->range.lock );
+        if( b_stale && p_block->i_buffer - i_got > HTTP_RANGE_DRAIN )
+            break;
+    }
+    if( i_got < p_block->i_buffer )
+    {
+        block_Release( p_block );
+        RangeDisconnect( p_access, p_conn );
+        return NULL;
+    }
+    if( b_close )
+        RangeDisconnect( p_access, p_conn );
+    return p_block;
+}
+
+static void *RangeThread( void *data )
+{
+    http_conn_t *p_conn = data;
+    access_t *p_access = p_conn->p_access;
+    access_sys_t *p_sys = p_access->p_sys;
+
+    vlc_mutex_lock( &p_sys->range.lock );
+    while( !p_sys->range.b_exit )
+    {
+        /* The first one not taken yet */
+        http_range_t *p_range = NULL;
+        for( unsigned i = 0; i < p_sys->range.i_count && !p_range; i++ )
+        {
+            http_range_t *r = &p_sys->range.p_ranges[(p_sys->range.i_first + i)
+                                                     % HTTP_RANGE_WINDOW];
+            if( r->i_state == RANGE_QUEUED )
+                p_range = r;
+        }
+        if( p_range == NULL )
+        {
+            vlc_cond_wait( &p_sys->range.wait_work, &p_sys->range.lock );
+            continue;
+        }
+
+        /* The slot stays ours while busy, unless the window is dropped */
+        p_range->i_state = RANGE_BUSY;
+        const unsigned i_generation = p_sys->range.i_generation;
+        const uint64_t i_offset = p_range->i_offset;
+        const size_t i_size = p_range->i_size;
+        vlc_mutex_unlock( &p_sys->range.lock );
+
+        block_t *p_block = RangeFetch( p_access, p_conn, i_offset, i_size,
+                                       i_generation );
+
+        vlc_mutex_lock( &p_sys->range.lock );
+        if( i_generation == p_sys->range.i_generation )
+        {
+            p_range->p_block = p_block;
+            p_range->i_state = p_block ? RANGE_DONE : RANGE_FAILED;
+            vlc_cond_signal( &p_sys->range.wait );
+        }
+        else if( p_block )
+            block_Release( p_block );
+    }
+    vlc_mutex_unlock( &p_sys->range.lock );
+
+    RangeDisconnect( p_access, p_conn );
+    return NULL;
+}
+
+/* Lock held */
+static void RangeQueue( access_t *p_access )
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    while( p_sys->range.i_count < p_sys->range.i_window
+        && p_sys->range.i_next < p_access->info.i_size )
+    {
+        http_range_t *r = &p_sys->range.p_ranges[(p_sys->range.i_first +
+                                                  p_sys->range.i_count)
+                                                 % HTTP_RANGE_WINDOW];
+        r->i_offset = p_sys->range.i_next;
+        r->i_size = __MIN( HTTP_RANGE_SIZE,
+                           p_access->info.i_size - p_sys->range.i_next );
+        r->i_state = RANGE_QUEUED;
+        r->i_tries = 0;
+        r->p_block = NULL;
+        p_sys->range.i_next += r->i_size;
+        p_sys->range.i_count++;
+    }
+    vlc_cond_broadcast( &p_sys->range.wait_work );
+}
+
+/* Lock held. Drops the window, the next ranges are queued from i_pos */
+static void RangeFlush( access_t *p_access, uint64_t i_pos )
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    for( unsigned i = 0; i < p_sys->range.i_count; i++ )
+    {
+        http_range_t *r = &p_sys->range.p_ranges[(p_sys->range.i_first + i)
+                                                 % HTTP_RANGE_WINDOW];
+        if( r->i_state == RANGE_DONE )
+            block_Release( r->p_block );
+    }
+    p_sys->range.i_first = 0;
+    p_sys->range.i_count = 0;
+    p_sys->range.i_next = i_pos;
+    p_sys->range.i_generation++;
+}
+
+static block_t *RangeBlock( access_t *p_access )
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    block_t *p_block = NULL;
+
+    vlc_mutex_lock( &p_sys->range.lock );
+    RangeQueue( p_access );
+    if( p_sys->range.i_count == 0 )
+    {
+        p_access->info.b_eof = true;
+        goto out;
+    }
+
+    http_range_t *r = &p_sys->range.p_ranges[p_sys->range.i_first];
+    while( r->i_state != RANGE_DONE )
+    {
+        if( !vlc_object_alive( p_access ) )
+            goto out;
+        if( r->i_state == RANGE_FAILED )
+        {
+            if( ++r->i_tries >= HTTP_RANGE_TRIES )
+            {
+                msg_Err( p_access, "cannot get the range at %"PRIu64,
+                         r->i_offset );
+                p_access->info.b_eof = true;
+                goto out;
+            }
+            r->i_state = RANGE_QUEUED;
+            vlc_cond_signal( &p_sys->range.wait_work );
+        }
+        vlc_cond_wait( &p_sys->range.wait, &p_sys->range.lock );
+    }
+
+    p_block = r->p_block;
+    p_sys->range.i_first = (p_sys->range.i_first + 1) % HTTP_RANGE_WINDOW;
+    p_sys->range.i_count--;
+    p_access->info.i_pos += p_block->i_buffer;
+
+    if( p_block->i_buffer < r->i_size )
+    {
+        /* Less than asked for, the file shrank: go on from there */
+        RangeFlush( p_access, p_access->info.i_pos );
+        if( p_block->i_buffer == 0 )
+        {
+            block_Release( p_block );
+            p_block = NULL;
+            p_access->info.b_eof = true;
+            goto out;
+        }
+    }
+    RangeQueue( p_access );
+out:
+    vlc_mutex_unlock( &p_sys->range.lock );
+    return p_block;
+}
+
+static int RangeSeek( access_t *p_access, uint64_t i_pos )
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    /* The connections stay, only what is queued is dropped */
+    vlc_mutex_lock( &p_sys->range.lock );
+    RangeFlush( p_access, i_pos );
+    p_access->info.i_pos = i_pos;
+    p_access->info.b_eof = false;
+    RangeQueue( p_access );
+    vlc_mutex_unlock( &p_sys->range.lock );
+    return VLC_SUCCESS;
+}
+
+static int RangeHeader( char **ppsz_head, const char *psz_format, ... )
+{
+    va_list args;
+    char *psz_line, *psz_head;
+
+    va_start( args, psz_format );
+    int i_ret = vasprintf( &psz_line, psz_format, args );
+    va_end( args );
+    if( i_ret < 0 )
+        return VLC_ENOMEM;
+
+    i_ret = asprintf( &psz_head, "%s%s", *ppsz_head ? *ppsz_head : "",
+                      psz_line );
+    free( psz_line );
+    if( i_ret < 0 )
+        return VLC_ENOMEM;
+    free( *ppsz_head );
+    *ppsz_head = psz_head;
+    return VLC_SUCCESS;
+}
+
+static int RangeStart( access_t *p_access )
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    unsigned i_conns = var_InheritInteger( p_access, "http-parallel" );
+    char *psz_head = NULL;
+    int i_ret;
+
+    /* What every request says but its range */
+    const char *psz_path = p_sys->url.psz_path;
+    if( !psz_path || !*psz_path )
+        psz_path = "/";
+    if( p_sys->b_proxy )
+        i_ret = RangeHeader( &psz_head, "GET http://%s:%d%s HTTP/1.1\r\n",
+                             p_sys->url.psz_host, p_sys->url.i_port,
+                             psz_path );
+    else
+        i_ret = RangeHeader( &psz_head, "GET %s HTTP/1.1\r\n", psz_path );
+    if( p_sys->url.i_port != (p_sys->b_ssl ? 443 : 80) )
+        i_ret |= RangeHeader( &psz_head, "Host: %s:%d\r\n",
+                              p_sys->url.psz_host, p_sys->url.i_port );
+    else
+        i_ret |= RangeHeader( &psz_head, "Host: %s\r\n", p_sys->url.psz_host );
+    if( p_sys->psz_user_agent )
+        i_ret |= RangeHeader( &psz_head, "User-Agent: %s\r\n",
+                              p_sys->psz_user_agent );
+    if( p_sys->psz_referrer )
+        i_ret |= RangeHeader( &psz_head, "Referer: %s\r\n",
+                              p_sys->psz_referrer );
+    for( int i = 0; p_sys->cookies && i < vlc_array_count( p_sys->cookies );
+         i++ )
+    {
+        const char *cookie = vlc_array_item_at_index( p_sys->cookies, i );
+        char *psz_cookie_content = cookie_get_content( cookie );
+        char *psz_cookie_domain = cookie_get_domain( cookie );
+
+        if( !psz_cookie_domain ||
+            strstr( p_sys->url.psz_host, psz_cookie_domain ) )
+            i_ret |= RangeHeader( &psz_head, "Cookie: %s\r\n",
+                                  psz_cookie_content );
+        free( psz_cookie_content );
+        free( psz_cookie_domain );
+    }
+    if( i_ret != VLC_SUCCESS )
+    {
+        free( psz_head );
+        return VLC_ENOMEM;
+    }
+
+    p_sys->range.p_conns = calloc( i_conns, sizeof( *p_sys->range.p_conns ) );
+    if( unlikely(p_sys->range.p_conns == NULL) )
+    {
+        free( psz_head );
+        return VLC_ENOMEM;
+    }
+    p_sys->range.psz_head = psz_head;
+    vlc_mutex_init( &p_sys->range.lock );
+    vlc_cond_init( &p_sys->range.wait );
+    vlc_cond_init( &p_sys->range.wait_work );
+    p_sys->range.i_first = 0;
+    p_sys->range.i_count = 0;
+    p_sys->range.i_window = __MIN( 2 * i_conns, HTTP_RANGE_WINDOW );
+    p_sys->range.i_next = p_access->info.i_pos;
+    p_sys->range.i_generation = 0;
+    p_sys->range.b_exit = false;
+
+    for( p_sys->range.i_conns = 0; p_sys->range.i_conns < i_conns;
+         p_sys->range.i_conns++ )
+    {
+        http_conn_t *p_conn = &p_sys->range.p_conns[p_sys->range.i_conns];
+
+        p_conn->p_access = p_access;
+        p_conn->fd = -1;
+        if( vlc_clone( &p_conn->thread, RangeThread, p_conn,
+                       VLC_THREAD_PRIORITY_INPUT ) )
+            break;
+    }
+    if( p_sys->range.i_conns == 0 )
+    {
+        RangeStop( p_access );
+        return VLC_EGENERIC;
+    }
+
+    /* The first answer was asked for with Connection: close */
+    Disconnect( p_access );
+    p_sys->range.b_on = true;
+    msg_Dbg( p_access, "fetching ranges of %u KiB over %u connections",
+             HTTP_RANGE_SIZE / 1024, p_sys->range.i_conns );
+    return VLC_SUCCESS;
+}
+
+static void RangeStop( access_t *p_access )
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    /* Interrupt what is being read */
+    vlc_mutex_lock( &p_sys->range.lock );
+    p_sys->range.b_exit = true;
+    vlc_cond_broadcast( &p_sys->range.wait_work );
+    for( unsigned i = 0; i < p_sys->range.i_conns; i++ )
+        if( p_sys->range.p_conns[i].fd != -1 )
+            shutdown( p_sys->range.p_conns[i].fd, SHUT_RDWR );
+    vlc_mutex_unlock( &p_sys->range.lock );
+
+    for( unsigned i = 0; i < p_sys->range.i_conns; i++ )
+        vlc_join( p_sys->range.p_conns[i].thread, NULL );
+
+    RangeFlush( p_access, 0 );
+    vlc_cond_destroy( &p_sys->range.wait_work );
+    vlc_cond_destroy( &p_sys->range.wait );
+    vlc_mutex_destroy( &p_sys->range.lock );
+    free( p_sys->range.p_conns );
+    free( p_sys->range.psz_head );
+    p_sys->range.b_on = false;
+}
+
 /*****************************************************************************
  * Cookies (FIXME: we may want to rewrite that using a nice structure to hold
  * them) (FIXME: only support the "domain=" param)
@@ -287,10 +287,7 @@ static void Close( vlc_object_t * p_this )
     for( i = 0; i < 64; i++ ) /* RTMP_HEADER_STREAM_INDEX_MASK */
     {
         if( p_sys->p_thread->rtmp_headers_recv[i].body != NULL )
-        {
-            free( p_sys->p_thread->rtmp_headers_recv[i].body->body );
-            free( p_sys->p_thread->rtmp_headers_recv[i].body );
-        }
+            rtmp_body_free( p_sys->p_thread->rtmp_headers_recv[i].body );
     }
 
     net_Close( p_sys->p_thread->fd );
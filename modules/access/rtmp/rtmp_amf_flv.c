@@ -38,6 +38,10 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
+#include <errno.h>
+#ifdef HAVE_POLL
+# include <poll.h>
+#endif
 
 #include "rtmp_amf_flv.h"
 
@@ -111,12 +115,14 @@ const uint8_t RTMP_DEFAULT_STREAM_INDEX_NOTIFY = 0x04;
 const uint8_t RTMP_DEFAULT_STREAM_INDEX_VIDEO_DATA = 0x05;
 const uint8_t RTMP_DEFAULT_STREAM_INDEX_AUDIO_DATA = 0x06;
 const uint32_t RTMP_DEFAULT_CHUNK_SIZE = 128;
+const uint32_t RTMP_SEND_CHUNK_SIZE = 4096; /* announced to the peer */
 const double RTMP_DEFAULT_STREAM_CLIENT_ID = 1.0;
 const double RTMP_DEFAULT_STREAM_SERVER_ID = 1.0;
 
 /* misc */
 const uint16_t MAX_EMPTY_BLOCKS = 200; /* empty blocks in fifo for media*/
 const uint16_t RTMP_BODY_SIZE_ALLOC = 1024;
+#define RTMP_IOV_MAX 64 /* I/O vectors per system call */
 const uint32_t RTMP_TIME_CLIENT_BUFFER = 2000; /* milliseconds */
 const uint32_t RTMP_SERVER_BW = 0x00000200;
 const uint32_t RTMP_SRC_DST_CONNECT_OBJECT = 0x00000000;
@@ -229,7 +235,10 @@ const uint8_t FLV_VIDEO_FRAME_TYPE_DISPOSABLE_INTER_FRAME = 0x30;
  * static RTMP functions:
  ******************************************************************************/
 static rtmp_packet_t *rtmp_new_packet( rtmp_control_thread_t *p_thread, uint8_t stream_index, uint32_t timestamp, uint8_t content_type, uint32_t src_dst, rtmp_body_t *body );
+static void rtmp_new_header( rtmp_control_thread_t *p_thread, rtmp_packet_t *rtmp_packet, uint8_t stream_index, uint32_t timestamp, uint8_t content_type, uint32_t src_dst, int32_t length_body );
+static void rtmp_encode_header( rtmp_control_thread_t *p_thread, const rtmp_packet_t *rtmp_packet, uint8_t *out );
 static block_t *rtmp_new_block( rtmp_control_thread_t *p_thread, uint8_t *buffer, int32_t length_buffer );
+static rtmp_packet_t *rtmp_encode_chunk_size( rtmp_control_thread_t *p_thread, uint32_t chunk_size );
 
 static rtmp_packet_t *rtmp_encode_onBWDone( rtmp_control_thread_t *p_thread, double number );
 static rtmp_packet_t *rtmp_encode_server_bw( rtmp_control_thread_t *p_thread, uint32_t number );
@@ -243,6 +252,7 @@ static uint8_t rtmp_encode_header_size( vlc_object_t *p_this, uint8_t header_siz
 static uint8_t rtmp_decode_header_size( vlc_object_t *p_this, uint8_t header_size );
 static uint8_t rtmp_get_stream_index( uint8_t content_type );
 
+static rtmp_body_t *rtmp_body_new_media( int32_t length_body );
 static void rtmp_body_append( rtmp_body_t *rtmp_body, uint8_t *buffer, uint32_t length );
 
 static uint8_t *rtmp_encode_ping( uint16_t type, uint32_t src_dst, uint32_t third_arg, uint32_t fourth_arg );
@@ -260,7 +270,7 @@ static char *amf_decode_object( uint8_t **buffer );
 /*****************************************************************************
  * static FLV functions:
  ******************************************************************************/
-static void flv_rebuild( rtmp_control_thread_t *p_thread, rtmp_packet_t *rtmp_packet );
+static block_t *flv_rebuild( rtmp_control_thread_t *p_thread, rtmp_packet_t *rtmp_packet );
 static void flv_get_metadata_audio( rtmp_control_thread_t *p_thread, rtmp_packet_t *packet_audio, uint8_t *stereo, uint8_t *audiosamplesize, uint32_t *audiosamplerate, uint8_t *audiocodecid );
 static void flv_get_metadata_video( rtmp_control_thread_t *p_thread, rtmp_packet_t *packet_video, uint8_t *videocodecid, uint8_t *frametype );
 static rtmp_packet_t *flv_build_onMetaData( access_t *p_access, uint64_t duration, uint8_t stereo, uint8_t audiosamplesize, uint32_t audiosamplerate, uint8_t audiocodecid, uint8_t videocodecid );
@@ -672,8 +682,7 @@ rtmp_connect_passive( rtmp_control_thread_t *p_thread )
 static void
 rtmp_packet_free( rtmp_packet_t *pkt )
 {
-    free( pkt->body->body );
-    free( pkt->body );
+    rtmp_body_free( pkt->body );
     free( pkt );
 }
 
@@ -833,49 +842,66 @@ rtmp_build_publish_start( rtmp_control_thread_t *p_thread )
     return rtmp_packet;
 }
 
-rtmp_packet_t *
-rtmp_build_flv_over_rtmp( rtmp_control_thread_t *p_thread, block_t *p_buffer )
+/* Sends the FLV tags of the muxer as RTMP messages. A tag held in one block
+ * is sent straight from it; only the tags split over several blocks are
+ * gathered into flv_body first. */
+int
+rtmp_send_flv_over_rtmp( rtmp_control_thread_t *p_thread, block_t *p_buffer )
 {
-    rtmp_packet_t *rtmp_packet;
+    const uint8_t *p_data = p_buffer->p_buffer;
+    uint32_t i_data = p_buffer->i_buffer;
+    rtmp_packet_t rtmp_packet;
+    rtmp_body_t body;
 
     if( p_thread->flv_length_body > 0 )
     {
-        p_thread->flv_length_body -= p_buffer->i_buffer;
-        rtmp_body_append( p_thread->flv_body, p_buffer->p_buffer, p_buffer->i_buffer );
-
+        /* Rest of a tag */
+        if( i_data > p_thread->flv_length_body )
+            i_data = p_thread->flv_length_body;
+        rtmp_body_append( p_thread->flv_body, (uint8_t *)p_data, i_data );
+        p_thread->flv_length_body -= i_data;
         if( p_thread->flv_length_body > 0 )
-            return NULL;
+            return 0;
 
+        body = *p_thread->flv_body;
+        rtmp_body_reset( p_thread->flv_body );
     }
     else
     {
-        p_thread->flv_content_type = *p_buffer->p_buffer;
-
-        p_buffer->p_buffer[0] = 0;
-        p_thread->flv_length_body = ntoh32( *(uint32_t *) (p_buffer->p_buffer) );
-
-        p_buffer->p_buffer[3] = 0;
-        p_thread->flv_timestamp = ntoh32( *(uint32_t *) (p_buffer->p_buffer + 3) );
-    }
-
-    if( p_thread->flv_length_body > p_buffer->i_buffer - FLV_TAG_SIZE - FLV_TAG_PREVIOUS_TAG_SIZE )
-    {
-        p_thread->flv_length_body -= p_buffer->i_buffer - FLV_TAG_SIZE - FLV_TAG_PREVIOUS_TAG_SIZE;
-        rtmp_body_append( p_thread->flv_body, p_buffer->p_buffer + FLV_TAG_SIZE, p_buffer->i_buffer - FLV_TAG_SIZE );
+        if( i_data < FLV_TAG_SIZE )
+            return 0;
+
+        p_thread->flv_content_type = p_data[0];
+        p_thread->flv_length_body = (p_data[1] << 16) | (p_data[2] << 8)
+                                  | p_data[3];
+        p_thread->flv_timestamp = ((uint32_t)p_data[7] << 24)
+                                | (p_data[4] << 16) | (p_data[5] << 8)
+                                | p_data[6];
+        p_data += FLV_TAG_SIZE;
+        i_data -= FLV_TAG_SIZE;
+
+        if( i_data < p_thread->flv_length_body )
+        {
+            /* The tag continues in the next blocks */
+            rtmp_body_append( p_thread->flv_body, (uint8_t *)p_data, i_data );
+            p_thread->flv_length_body -= i_data;
+            return 0;
+        }
 
-        return NULL;
+        body.length_body = p_thread->flv_length_body;
+        body.length_buffer = p_thread->flv_length_body;
+        body.body = (uint8_t *)p_data;
+        body.block = NULL;
     }
-    else
-    {
-        rtmp_body_append( p_thread->flv_body, p_buffer->p_buffer + FLV_TAG_SIZE, p_thread->flv_length_body );
-    }
-
-    rtmp_packet = rtmp_new_packet( p_thread, rtmp_get_stream_index( p_thread->flv_content_type ),
-        p_thread->flv_timestamp, p_thread->flv_content_type, RTMP_SRC_DST_DEFAULT, p_thread->flv_body );
     p_thread->flv_length_body = 0;
-    rtmp_body_reset( p_thread->flv_body );
 
-    return rtmp_packet;
+    rtmp_new_header( p_thread, &rtmp_packet,
+                     rtmp_get_stream_index( p_thread->flv_content_type ),
+                     p_thread->flv_timestamp, p_thread->flv_content_type,
+                     RTMP_SRC_DST_DEFAULT, body.length_body );
+    rtmp_packet.body = &body;
+
+    return rtmp_write_packet( p_thread, &rtmp_packet );
 }
 
 /* This function must be cancellation-safe! */
@@ -938,7 +964,14 @@ rtmp_read_net_packet( rtmp_control_thread_t *p_thread )
 
         if( header->body == NULL )
         {
-            header->body = rtmp_body_new( header->length_body );
+            if( header->content_type == RTMP_CONTENT_TYPE_AUDIO_DATA
+             || header->content_type == RTMP_CONTENT_TYPE_VIDEO_DATA
+             || header->content_type == RTMP_CONTENT_TYPE_NOTIFY )
+                header->body = rtmp_body_new_media( header->length_body );
+            else
+                header->body = rtmp_body_new( header->length_body );
+            if( header->body == NULL )
+                goto error;
         }
 
         bytes_left = header->body->length_buffer - header->body->length_body;
@@ -1009,9 +1042,9 @@ rtmp_handler_audio_data( rtmp_control_thread_t *p_thread, rtmp_packet_t *rtmp_pa
             &p_thread->metadata_samplerate, &p_thread->metadata_audiocodecid );
     }
 
-    flv_rebuild( p_thread, rtmp_packet );
-    p_buffer = rtmp_new_block( p_thread, rtmp_packet->body->body, rtmp_packet->body->length_body );
-    block_FifoPut( p_thread->p_fifo_input, p_buffer );
+    p_buffer = flv_rebuild( p_thread, rtmp_packet );
+    if( p_buffer != NULL )
+        block_FifoPut( p_thread->p_fifo_input, p_buffer );
 
     rtmp_packet_free( rtmp_packet );
 }
@@ -1029,9 +1062,9 @@ rtmp_handler_video_data( rtmp_control_thread_t *p_thread, rtmp_packet_t *rtmp_pa
             &p_thread->metadata_videocodecid, &p_thread->metadata_frametype );
     }
 
-    flv_rebuild( p_thread, rtmp_packet );
-    p_buffer = rtmp_new_block( p_thread, rtmp_packet->body->body, rtmp_packet->body->length_body );
-    block_FifoPut( p_thread->p_fifo_input, p_buffer );
+    p_buffer = flv_rebuild( p_thread, rtmp_packet );
+    if( p_buffer != NULL )
+        block_FifoPut( p_thread->p_fifo_input, p_buffer );
 
     rtmp_packet_free( rtmp_packet );
 }
@@ -1043,9 +1076,9 @@ rtmp_handler_notify( rtmp_control_thread_t *p_thread, rtmp_packet_t *rtmp_packet
 
     p_thread->metadata_received = 1;
 
-    flv_rebuild( p_thread, rtmp_packet );
-    p_buffer = rtmp_new_block( p_thread, rtmp_packet->body->body, rtmp_packet->body->length_body );
-    block_FifoPut( p_thread->p_fifo_input, p_buffer );
+    p_buffer = flv_rebuild( p_thread, rtmp_packet );
+    if( p_buffer != NULL )
+        block_FifoPut( p_thread->p_fifo_input, p_buffer );
 
     rtmp_packet_free( rtmp_packet );
 }
@@ -1230,6 +1263,15 @@ rtmp_handler_invoke( rtmp_control_thread_t *p_thread, rtmp_packet_t *rtmp_packet
         rtmp_packet_free( rtmp_packet );
         free( tmp_buffer );
 
+        /* Bigger chunks for the media: fewer headers and system calls */
+        tmp_rtmp_packet = rtmp_encode_chunk_size( p_thread, RTMP_SEND_CHUNK_SIZE );
+        if( tmp_rtmp_packet != NULL )
+        {
+            if( rtmp_write_packet( p_thread, tmp_rtmp_packet ) == 0 )
+                p_thread->chunk_size_send = RTMP_SEND_CHUNK_SIZE;
+            rtmp_packet_free( tmp_rtmp_packet );
+        }
+
         free( string2 );
 
         p_thread->result_play = 0;
@@ -1362,38 +1404,34 @@ error:
 
 /* length header calculated automatically based on last packet in the same channel */
 /* timestamps passed are always absolute */
-static rtmp_packet_t *
-rtmp_new_packet( rtmp_control_thread_t *p_thread, uint8_t stream_index,
-                 uint32_t timestamp, uint8_t content_type,
-                 uint32_t src_dst, rtmp_body_t *body )
+static void
+rtmp_new_header( rtmp_control_thread_t *p_thread, rtmp_packet_t *rtmp_packet,
+                 uint8_t stream_index, uint32_t timestamp,
+                 uint8_t content_type, uint32_t src_dst, int32_t length_body )
 {
     int interchunk_headers;
-    rtmp_packet_t *rtmp_packet;
     rtmp_packet_t *rtmp_send = p_thread->rtmp_headers_send+stream_index;
 
-    rtmp_packet = (rtmp_packet_t *) malloc( sizeof( rtmp_packet_t ) );
-    if( !rtmp_packet ) return NULL;
-
-    interchunk_headers = body->length_body / p_thread->chunk_size_send;
-    if( body->length_body % p_thread->chunk_size_send == 0 )
+    interchunk_headers = length_body / p_thread->chunk_size_send;
+    if( length_body % p_thread->chunk_size_send == 0 )
         interchunk_headers--;
 
     if( src_dst != rtmp_send->src_dst )
     {
         rtmp_send->timestamp = timestamp;
-        rtmp_send->length_body = body->length_body;
+        rtmp_send->length_body = length_body;
         rtmp_send->content_type = content_type;
         rtmp_send->src_dst = src_dst;
         
         rtmp_packet->length_header = 12;
     }
     else if( content_type != rtmp_send->content_type
-        || body->length_body != rtmp_send->length_body )
+        || length_body != rtmp_send->length_body )
     {
         rtmp_send->timestamp_relative =
             timestamp - rtmp_send->timestamp;
         rtmp_send->timestamp = timestamp;
-        rtmp_send->length_body = body->length_body;
+        rtmp_send->length_body = length_body;
         rtmp_send->content_type = content_type;
 
         rtmp_packet->length_header = 8;
@@ -1424,10 +1462,25 @@ rtmp_new_packet( rtmp_control_thread_t *p_thread, uint8_t stream_index,
     }
 
     rtmp_packet->length_encoded = rtmp_packet->length_header
-                                + body->length_body + interchunk_headers;
-    rtmp_packet->length_body = body->length_body;
+                                + length_body + interchunk_headers;
+    rtmp_packet->length_body = length_body;
     rtmp_packet->content_type = content_type;
     rtmp_packet->src_dst = src_dst;
+    rtmp_packet->body = NULL;
+}
+
+static rtmp_packet_t *
+rtmp_new_packet( rtmp_control_thread_t *p_thread, uint8_t stream_index,
+                 uint32_t timestamp, uint8_t content_type,
+                 uint32_t src_dst, rtmp_body_t *body )
+{
+    rtmp_packet_t *rtmp_packet;
+
+    rtmp_packet = (rtmp_packet_t *) malloc( sizeof( rtmp_packet_t ) );
+    if( !rtmp_packet ) return NULL;
+
+    rtmp_new_header( p_thread, rtmp_packet, stream_index, timestamp,
+                     content_type, src_dst, body->length_body );
 
     rtmp_packet->body = (rtmp_body_t *) malloc( sizeof( rtmp_body_t ) );
     if( !rtmp_packet->body )
@@ -1438,6 +1491,7 @@ rtmp_new_packet( rtmp_control_thread_t *p_thread, uint8_t stream_index,
 
     rtmp_packet->body->length_body = body->length_body;
     rtmp_packet->body->length_buffer = body->length_body;
+    rtmp_packet->body->block = NULL;
     rtmp_packet->body->body = (uint8_t *) malloc( rtmp_packet->body->length_buffer * sizeof( uint8_t ) );
     if( !rtmp_packet->body->body )
     {
@@ -1482,20 +1536,11 @@ rtmp_new_block( rtmp_control_thread_t *p_thread, uint8_t *buffer, int32_t length
  * rtmp_new_packet -> rtmp_encode_packet -> send .
  * No parallelism allowed because of optimization in header length. */
 
-uint8_t *
-rtmp_encode_packet( rtmp_control_thread_t *p_thread, rtmp_packet_t *rtmp_packet )
+static void
+rtmp_encode_header( rtmp_control_thread_t *p_thread,
+                    const rtmp_packet_t *rtmp_packet, uint8_t *out )
 {
-    uint8_t *out;
-    int interchunk_headers;
     uint32_t timestamp, length_body, src_dst;
-    int i, j;
-
-    out = (uint8_t *) malloc( rtmp_packet->length_encoded * sizeof( uint8_t ) );
-    if( !out ) return NULL;
-
-    interchunk_headers = rtmp_packet->body->length_body / p_thread->chunk_size_send;
-    if( rtmp_packet->body->length_body % p_thread->chunk_size_send == 0 )
-        interchunk_headers--;
 
     if( rtmp_packet->length_header == 12 )
     {
@@ -1523,6 +1568,23 @@ rtmp_encode_packet( rtmp_control_thread_t *p_thread, rtmp_packet_t *rtmp_packet
     }
 
     out[0] = rtmp_encode_header_size( (vlc_object_t *) p_thread, rtmp_packet->length_header ) + rtmp_packet->stream_index;
+}
+
+uint8_t *
+rtmp_encode_packet( rtmp_control_thread_t *p_thread, rtmp_packet_t *rtmp_packet )
+{
+    uint8_t *out;
+    int interchunk_headers;
+    int i, j;
+
+    out = (uint8_t *) malloc( rtmp_packet->length_encoded * sizeof( uint8_t ) );
+    if( !out ) return NULL;
+
+    interchunk_headers = rtmp_packet->body->length_body / p_thread->chunk_size_send;
+    if( rtmp_packet->body->length_body % p_thread->chunk_size_send == 0 )
+        interchunk_headers--;
+
+    rtmp_encode_header( p_thread, rtmp_packet, out );
 
     /* Insert inter chunk headers */
     for(i = 0, j = 0; i < rtmp_packet->body->length_body + interchunk_headers; i++, j++)
@@ -1535,6 +1597,99 @@ rtmp_encode_packet( rtmp_control_thread_t *p_thread, rtmp_packet_t *rtmp_packet
     return out;
 }
 
+static int
+rtmp_writev( rtmp_control_thread_t *p_thread, struct iovec *iov,
+             unsigned count )
+{
+#ifndef WIN32
+    while( count > 0 )
+    {
+        struct msghdr hdr;
+        ssize_t val;
+
+        memset( &hdr, 0, sizeof( hdr ) );
+        hdr.msg_iov = iov;
+        hdr.msg_iovlen = count;
+        val = sendmsg( p_thread->fd, &hdr, 0 );
+        if( val < 0 )
+        {
+            if( errno == EINTR )
+                continue;
+            if( errno == EAGAIN )
+            {
+                struct pollfd ufd = { .fd = p_thread->fd, .events = POLLOUT };
+                poll( &ufd, 1, -1 );
+                continue;
+            }
+            return -1;
+        }
+
+        /* Skip what was sent */
+        while( count > 0 && (size_t)val >= iov->iov_len )
+        {
+            val -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if( count > 0 )
+        {
+            iov->iov_base = (uint8_t *)iov->iov_base + val;
+            iov->iov_len -= val;
+        }
+    }
+#else
+    for( unsigned i = 0; i < count; i++ )
+        if( net_Write( p_thread, p_thread->fd, NULL, iov[i].iov_base,
+                       iov[i].iov_len ) != (ssize_t)iov[i].iov_len )
+            return -1;
+#endif
+    return 0;
+}
+
+/* Same as rtmp_encode_packet() then net_Write(), without copying the body:
+ * the chunk headers are written into a side buffer, and the body is sent in
+ * place, chunk by chunk, with one system call per RTMP_IOV_MAX/2 chunks. */
+int
+rtmp_write_packet( rtmp_control_thread_t *p_thread,
+                   const rtmp_packet_t *rtmp_packet )
+{
+    uint8_t header[12];
+    uint8_t interchunk = RTMP_HEADER_SIZE_1 + rtmp_packet->stream_index;
+    struct iovec iov[RTMP_IOV_MAX];
+    unsigned n = 0;
+    uint8_t *p_body = rtmp_packet->body->body;
+    uint32_t i_left = rtmp_packet->body->length_body;
+
+    rtmp_encode_header( p_thread, rtmp_packet, header );
+    iov[n].iov_base = header;
+    iov[n++].iov_len = rtmp_packet->length_header;
+
+    for( ;; )
+    {
+        uint32_t i_chunk = __MIN( i_left, p_thread->chunk_size_send );
+
+        iov[n].iov_base = p_body;
+        iov[n++].iov_len = i_chunk;
+        p_body += i_chunk;
+        i_left -= i_chunk;
+
+        if( i_left == 0 || n + 2 > RTMP_IOV_MAX )
+        {
+            if( rtmp_writev( p_thread, iov, n ) )
+            {
+                msg_Err( p_thread, "failed send packet" );
+                return -1;
+            }
+            n = 0;
+            if( i_left == 0 )
+                return 0;
+        }
+
+        iov[n].iov_base = &interchunk;
+        iov[n++].iov_len = 1;
+    }
+}
+
 static rtmp_packet_t *
 rtmp_encode_onBWDone( rtmp_control_thread_t *p_thread, double number )
 {
@@ -1585,6 +1740,26 @@ rtmp_encode_server_bw( rtmp_control_thread_t *p_thread, uint32_t number )
     return rtmp_packet;
 }
 
+static rtmp_packet_t *
+rtmp_encode_chunk_size( rtmp_control_thread_t *p_thread, uint32_t chunk_size )
+{
+    rtmp_packet_t *rtmp_packet;
+    rtmp_body_t *rtmp_body;
+
+    /* Build chunk size */
+    rtmp_body = rtmp_body_new( -1 );
+
+    chunk_size = hton32( chunk_size );
+    rtmp_body_append( rtmp_body, (uint8_t *) &chunk_size, sizeof( uint32_t ) );
+
+    rtmp_packet = rtmp_new_packet( p_thread, RTMP_DEFAULT_STREAM_INDEX_CONTROL,
+      0, RTMP_CONTENT_TYPE_CHUNK_SIZE, RTMP_SRC_DST_CONNECT_OBJECT, rtmp_body );
+    free( rtmp_body->body );
+    free( rtmp_body );
+
+    return rtmp_packet;
+}
+
 static rtmp_packet_t *
 rtmp_encode_NetConnection_connect_result( rtmp_control_thread_t *p_thread, double number )
 {
@@ -1964,9 +2139,44 @@ rtmp_body_new( int length_buffer )
         free( rtmp_body );
         return NULL;
     }
+    rtmp_body->block = NULL;
     return rtmp_body;
 }
 
+/* Audio, video and metadata are received in a block, after room for the FLV
+ * tag: they are passed to the reader as is by flv_rebuild(). */
+static rtmp_body_t *
+rtmp_body_new_media( int32_t length_body )
+{
+    rtmp_body_t *rtmp_body;
+
+    rtmp_body = (rtmp_body_t *) malloc( sizeof( rtmp_body_t ) );
+    if( !rtmp_body ) return NULL;
+
+    rtmp_body->block = block_Alloc( FLV_TAG_PREVIOUS_TAG_SIZE + FLV_TAG_SIZE
+                                    + length_body );
+    if( !rtmp_body->block )
+    {
+        free( rtmp_body );
+        return NULL;
+    }
+    rtmp_body->length_body = 0;
+    rtmp_body->length_buffer = length_body;
+    rtmp_body->body = rtmp_body->block->p_buffer
+                    + FLV_TAG_PREVIOUS_TAG_SIZE + FLV_TAG_SIZE;
+    return rtmp_body;
+}
+
+void
+rtmp_body_free( rtmp_body_t *rtmp_body )
+{
+    if( rtmp_body->block != NULL )
+        block_Release( rtmp_body->block );
+    else
+        free( rtmp_body->body );
+    free( rtmp_body );
+}
+
 void
 rtmp_body_reset( rtmp_body_t *rtmp_body )
 {
@@ -2231,19 +2441,27 @@ amf_decode_object( uint8_t **buffer )
 /*****************************************************************************
  * FLV rebuilding implementation:
  ******************************************************************************/
-static void
+/* Prepends the FLV tag to the body of a packet, and returns the tag */
+static block_t *
 flv_rebuild( rtmp_control_thread_t *p_thread, rtmp_packet_t *rtmp_packet )
 {
     uint32_t length_tag, timestamp;
     uint8_t *tmp;
+    block_t *p_block = rtmp_packet->body->block;
 
-    tmp = (uint8_t *) realloc( rtmp_packet->body->body,
-                               rtmp_packet->body->length_body +
-                               FLV_TAG_PREVIOUS_TAG_SIZE + FLV_TAG_SIZE );
-    if( !tmp ) return;
-    rtmp_packet->body->body = tmp;
-    memmove( rtmp_packet->body->body + FLV_TAG_PREVIOUS_TAG_SIZE + FLV_TAG_SIZE,
-             rtmp_packet->body->body, rtmp_packet->body->length_body );
+    if( p_block != NULL )
+        /* Received with room for the tag */
+        rtmp_packet->body->body -= FLV_TAG_PREVIOUS_TAG_SIZE + FLV_TAG_SIZE;
+    else
+    {
+        tmp = (uint8_t *) realloc( rtmp_packet->body->body,
+                                   rtmp_packet->body->length_body +
+                                   FLV_TAG_PREVIOUS_TAG_SIZE + FLV_TAG_SIZE );
+        if( !tmp ) return NULL;
+        rtmp_packet->body->body = tmp;
+        memmove( rtmp_packet->body->body + FLV_TAG_PREVIOUS_TAG_SIZE + FLV_TAG_SIZE,
+                 rtmp_packet->body->body, rtmp_packet->body->length_body );
+    }
 
     /* Insert tag */
     p_thread->flv_tag_previous_tag_size = hton32( p_thread->flv_tag_previous_tag_size );
@@ -2269,6 +2487,16 @@ flv_rebuild( rtmp_control_thread_t *p_thread, rtmp_packet_t *rtmp_packet )
     /* Update size */
     rtmp_packet->body->length_body += FLV_TAG_PREVIOUS_TAG_SIZE + FLV_TAG_SIZE;
     rtmp_packet->body->length_buffer = rtmp_packet->body->length_body;
+
+    if( p_block == NULL )
+        return rtmp_new_block( p_thread, rtmp_packet->body->body,
+                               rtmp_packet->body->length_body );
+
+    /* The packet gives its block away */
+    p_block->i_buffer = rtmp_packet->body->length_body;
+    rtmp_packet->body->block = NULL;
+    rtmp_packet->body->body = NULL;
+    return p_block;
 }
 
 static void
@@ -2440,9 +2668,7 @@ flv_get_metadata( access_t *p_access )
         p_thread->metadata_audiocodecid,
         p_thread->metadata_videocodecid );
 
-    flv_rebuild( p_thread, p_md );
-    p_buf = rtmp_new_block( p_thread,
-                            p_md->body->body, p_md->body->length_buffer );
+    p_buf = flv_rebuild( p_thread, p_md );
 
     rtmp_packet_free( p_md );
     return p_buf;
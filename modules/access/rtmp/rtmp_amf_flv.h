@@ -46,6 +46,7 @@ struct rtmp_body_t
     int32_t length_body; /* without interchunk headers */
     int32_t length_buffer;
     uint8_t *body;
+    block_t *block; /* storage of media bodies, with room for the FLV tag */
 };
 
 struct rtmp_control_thread_t
@@ -133,10 +134,11 @@ int rtmp_connect_passive( rtmp_control_thread_t *p_thread );
 //
 rtmp_packet_t *rtmp_build_bytes_read( rtmp_control_thread_t *p_thread, uint32_t reply );
 rtmp_packet_t *rtmp_build_publish_start( rtmp_control_thread_t *p_thread );
-rtmp_packet_t *rtmp_build_flv_over_rtmp( rtmp_control_thread_t *p_thread, block_t *p_buffer );
+int rtmp_send_flv_over_rtmp( rtmp_control_thread_t *p_thread, block_t *p_buffer );
 
 rtmp_packet_t *rtmp_read_net_packet( rtmp_control_thread_t *p_thread );
 uint8_t *rtmp_encode_packet( rtmp_control_thread_t *p_thread, rtmp_packet_t *rtmp_packet );
+int rtmp_write_packet( rtmp_control_thread_t *p_thread, const rtmp_packet_t *rtmp_packet );
 void rtmp_init_handler( rtmp_handler_t *rtmp_handler );
 /*****************************************************************************
  * FLV header:
@@ -148,4 +150,5 @@ block_t *flv_insert_header( access_t *p_access, block_t *first_packet );
  * RTMP body header:
  ******************************************************************************/
 rtmp_body_t *rtmp_body_new( int length_buffer );
+void rtmp_body_free( rtmp_body_t * );
 void rtmp_body_reset( rtmp_body_t * );
@@ -0,0 +1,295 @@
+/**
+ * @file fec.c
+ * @brief RTP forward error correction (SMPTE 2022-1, RFC 2733)
+ */
+/*****************************************************************************
+ * Copyright © 2026 VLC authors and VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ ****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_demux.h>
+#include <vlc_block.h>
+
+#include "rtp.h"
+
+/* Media packets kept for recovery (power of two). SMPTE 2022-1 matrices
+ * span at most 100 packets, RFC 2733 masks 24. */
+#define FEC_HISTORY 1024
+/* FEC packets kept, i.e. a few row and column matrices */
+#define FEC_PARITY  64
+
+#define FEC_HEADER      12 /* RFC 2733 FEC header */
+#define FEC_HEADER_EXT  4  /* SMPTE 2022-1 extension, flagged by the E bit */
+
+/* Most packets protected by one FEC packet (8-bits NA field) */
+#define FEC_MAX_PROTECTED 255
+
+/** State for forward error correction */
+struct rtp_fec_t
+{
+    block_t *history[FEC_HISTORY]; /* copies of media packets, by sequence */
+    block_t *parity[FEC_PARITY];   /* FEC packets, replaced round-robin */
+    unsigned next_parity;
+};
+
+rtp_fec_t *rtp_fec_create (void)
+{
+    return calloc (1, sizeof (rtp_fec_t));
+}
+
+void rtp_fec_destroy (rtp_fec_t *fec)
+{
+    for (unsigned i = 0; i < FEC_HISTORY; i++)
+        if (fec->history[i] != NULL)
+            block_Release (fec->history[i]);
+    for (unsigned i = 0; i < FEC_PARITY; i++)
+        if (fec->parity[i] != NULL)
+            block_Release (fec->parity[i]);
+    free (fec);
+}
+
+static inline uint16_t fec_seq (const block_t *block)
+{
+    return GetWBE (block->p_buffer + 2);
+}
+
+static const block_t *fec_lookup (const rtp_fec_t *fec, uint16_t seq)
+{
+    const block_t *block = fec->history[seq & (FEC_HISTORY - 1)];
+
+    if (block == NULL || fec_seq (block) != seq)
+        return NULL;
+    return block;
+}
+
+/**
+ * Keeps a copy of a media packet, including its RTP header and padding,
+ * as the FEC packets protect them as sent.
+ */
+void rtp_fec_media (rtp_fec_t *fec, block_t *block)
+{
+    const uint16_t seq = fec_seq (block);
+    block_t **slot = &fec->history[seq & (FEC_HISTORY - 1)];
+
+    if (*slot != NULL)
+    {
+        if (fec_seq (*slot) == seq)
+            return; /* already known */
+        block_Release (*slot);
+    }
+    *slot = block_Duplicate (block);
+}
+
+/**
+ * Takes an FEC packet.
+ */
+void rtp_fec_parity (rtp_fec_t *fec, block_t *block)
+{
+    /* No CSRC nor header extension (SMPTE 2022-1 section 7) */
+    if (block->i_buffer < 12 + FEC_HEADER
+     || (block->p_buffer[0] & 0xDF) != 0x80)
+        goto drop;
+
+    if (block->p_buffer[0] & 0x20)
+    {
+        uint8_t padding = block->p_buffer[block->i_buffer - 1];
+        if (padding == 0 || block->i_buffer < 12u + FEC_HEADER + padding)
+            goto drop;
+        block->i_buffer -= padding;
+    }
+
+    if ((block->p_buffer[12 + 4] & 0x80)
+     && block->i_buffer < 12 + FEC_HEADER + FEC_HEADER_EXT)
+        goto drop;
+
+    block_t **slot = &fec->parity[fec->next_parity];
+    if (*slot != NULL)
+        block_Release (*slot);
+    *slot = block;
+    fec->next_parity = (fec->next_parity + 1) % FEC_PARITY;
+    return;
+
+drop:
+    block_Release (block);
+}
+
+/**
+ * Lists the media sequence numbers protected by an FEC packet.
+ */
+static unsigned fec_protected (const block_t *parity, uint16_t *seqv)
+{
+    const uint8_t *h = parity->p_buffer + 12;
+    const uint16_t base = GetWBE (h);
+    unsigned n = 0;
+
+    if (h[4] & 0x80)
+    {   /* SMPTE 2022-1: NA packets, Offset apart */
+        const unsigned offset = h[13], na = h[14];
+
+        if (offset > 0)
+            for (; n < na; n++)
+                seqv[n] = base + n * offset;
+    }
+    else
+    {   /* RFC 2733: 24-bits mask */
+        const uint32_t mask = GetDWBE (h + 4) & 0xFFFFFF;
+
+        for (unsigned i = 0; i < 24; i++)
+            if (mask & (1 << i))
+                seqv[n++] = base + i;
+    }
+    return n;
+}
+
+/**
+ * Rebuilds a missing media packet from an FEC packet, if all the other
+ * packets it protects are known.
+ */
+static block_t *fec_rebuild (const rtp_fec_t *fec, const block_t *parity,
+                             uint16_t seq)
+{
+    uint16_t seqv[FEC_MAX_PROTECTED];
+    const unsigned n = fec_protected (parity, seqv);
+    bool covered = false;
+
+    for (unsigned i = 0; i < n; i++)
+    {
+        if (seqv[i] == seq)
+            covered = true;
+        else if (fec_lookup (fec, seqv[i]) == NULL)
+            return NULL; /* another one is missing */
+    }
+    if (!covered || n < 2)
+        return NULL;
+
+    const uint8_t *h = parity->p_buffer + 12;
+    const size_t skip = 12 + FEC_HEADER + ((h[4] & 0x80) ? FEC_HEADER_EXT : 0);
+    const size_t size = parity->i_buffer - skip;
+    uint16_t len = GetWBE (h + 2);
+    uint8_t ptype = h[4] & 0x7F;
+    uint32_t timestamp = GetDWBE (h + 8);
+    const block_t *ref = NULL;
+
+    block_t *block = block_Alloc (12 + size);
+    if (unlikely(block == NULL))
+        return NULL;
+
+    uint8_t *payload = block->p_buffer + 12;
+    memcpy (payload, parity->p_buffer + skip, size);
+
+    for (unsigned i = 0; i < n; i++)
+    {
+        if (seqv[i] == seq)
+            continue;
+
+        const block_t *media = fec_lookup (fec, seqv[i]);
+        const size_t media_len = media->i_buffer - 12;
+
+        len ^= media_len;
+        ptype ^= rtp_ptype (media);
+        timestamp ^= GetDWBE (media->p_buffer + 4);
+        for (size_t j = 0; j < media_len && j < size; j++)
+            payload[j] ^= media->p_buffer[12 + j];
+        ref = media;
+    }
+
+    if (len > size)
+    {
+        block_Release (block);
+        return NULL;
+    }
+
+    block->p_buffer[0] = 0x80; /* version 2 */
+    block->p_buffer[1] = ptype & 0x7F;
+    SetWBE (block->p_buffer + 2, seq);
+    SetDWBE (block->p_buffer + 4, timestamp);
+    memcpy (block->p_buffer + 8, ref->p_buffer + 8, 4); /* SSRC */
+    block->i_buffer = 12 + len;
+    return block;
+}
+
+static block_t *fec_try (const rtp_fec_t *fec, uint16_t seq)
+{
+    for (unsigned i = 0; i < FEC_PARITY; i++)
+    {
+        if (fec->parity[i] == NULL)
+            continue;
+
+        block_t *block = fec_rebuild (fec, fec->parity[i], seq);
+        if (block != NULL)
+            return block;
+    }
+    return NULL;
+}
+
+/**
+ * Tries to rebuild a missing media packet.
+ * @return the rebuilt packet, or NULL if not possible yet
+ */
+block_t *rtp_fec_recover (rtp_fec_t *fec, uint16_t seq)
+{
+    const block_t *known = fec_lookup (fec, seq);
+    if (known != NULL) /* rebuilt earlier */
+        return block_Duplicate ((block_t *)known);
+
+    block_t *block = fec_try (fec, seq);
+
+    /* With both row and column FEC, another packet missing from the row
+     * can often be rebuilt from its column first. */
+    for (unsigned i = 0; block == NULL && i < FEC_PARITY; i++)
+    {
+        if (fec->parity[i] == NULL)
+            continue;
+
+        uint16_t seqv[FEC_MAX_PROTECTED];
+        const unsigned n = fec_protected (fec->parity[i], seqv);
+        bool covered = false;
+        unsigned missing = 0;
+        uint16_t other = 0;
+
+        for (unsigned j = 0; j < n; j++)
+        {
+            if (seqv[j] == seq)
+                covered = true;
+            else if (fec_lookup (fec, seqv[j]) == NULL)
+            {
+                other = seqv[j];
+                missing++;
+            }
+        }
+        if (!covered || missing != 1)
+            continue;
+
+        block_t *repaired = fec_try (fec, other);
+        if (repaired == NULL)
+            continue;
+        rtp_fec_media (fec, repaired);
+        block_Release (repaired);
+        block = fec_try (fec, seq);
+    }
+
+    if (block != NULL)
+        rtp_fec_media (fec, block);
+    return block;
+}
@@ -104,13 +104,21 @@ void *rtp_dgram_thread (void *opaque)
     mtime_t deadline = VLC_TS_INVALID;
     int rtp_fd = sys->fd;
 
-    struct pollfd ufd[1];
+    struct pollfd ufd[3];
+    unsigned nfd = 1;
     ufd[0].fd = rtp_fd;
     ufd[0].events = POLLIN;
+    for (unsigned i = 0; i < 2; i++)
+        if (sys->fec_fd[i] != -1)
+        {
+            ufd[nfd].fd = sys->fec_fd[i];
+            ufd[nfd].events = POLLIN;
+            nfd++;
+        }
 
     for (;;)
     {
-        int n = poll (ufd, 1, rtp_timeout (deadline));
+        int n = poll (ufd, nfd, rtp_timeout (deadline));
         if (n == -1)
             continue;
 
@@ -141,6 +149,25 @@ void *rtp_dgram_thread (void *opaque)
             }
         }
 
+        for (unsigned i = 1; i < nfd; i++)
+        {
+            if (!(ufd[i].revents & POLLIN))
+                continue;
+
+            block_t *block = block_Alloc (0xffff);
+            if (unlikely(block == NULL))
+                continue;
+
+            ssize_t len = recv (ufd[i].fd, block->p_buffer, block->i_buffer, 0);
+            if (len != -1)
+            {
+                block->i_buffer = len;
+                rtp_queue_fec (demux, sys->session, block);
+            }
+            else
+                block_Release (block);
+        }
+
     dequeue:
         if (!rtp_dequeue (demux, sys->session, &deadline))
             deadline = VLC_TS_INVALID;
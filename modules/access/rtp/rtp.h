@@ -22,6 +22,7 @@
 
 typedef struct rtp_pt_t rtp_pt_t;
 typedef struct rtp_session_t rtp_session_t;
+typedef struct rtp_fec_t rtp_fec_t;
 
 /** @section RTP payload format */
 struct rtp_pt_t
@@ -51,10 +52,18 @@ void xiph_decode (demux_t *demux, void *data, block_t *block);
 rtp_session_t *rtp_session_create (demux_t *);
 void rtp_session_destroy (demux_t *, rtp_session_t *);
 void rtp_queue (demux_t *, rtp_session_t *, block_t *);
+void rtp_queue_fec (demux_t *, rtp_session_t *, block_t *);
 bool rtp_dequeue (demux_t *, const rtp_session_t *, mtime_t *);
 void rtp_dequeue_force (demux_t *, const rtp_session_t *);
 int rtp_add_type (demux_t *demux, rtp_session_t *ses, const rtp_pt_t *pt);
 
+/** @section Forward error correction */
+rtp_fec_t *rtp_fec_create (void);
+void rtp_fec_destroy (rtp_fec_t *);
+void rtp_fec_media (rtp_fec_t *, block_t *);
+void rtp_fec_parity (rtp_fec_t *, block_t *);
+block_t *rtp_fec_recover (rtp_fec_t *, uint16_t);
+
 void *rtp_dgram_thread (void *data);
 void *rtp_stream_thread (void *data);
 
@@ -67,9 +76,11 @@ struct demux_sys_t
 #endif
     int           fd;
     int           rtcp_fd;
+    int           fec_fd[2]; /**< SMPTE 2022-1 column and row FEC */
     vlc_thread_t  thread;
 
     mtime_t       timeout;
+    mtime_t       max_latency; /**< Longest wait for a missing packet */
     uint16_t      max_dropout; /**< Max packet forward misordering */
     uint16_t      max_misorder; /**< Max packet backward misordering */
     uint8_t       max_src; /**< Max simultaneous RTP sources */
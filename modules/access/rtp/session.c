@@ -35,6 +35,9 @@
 
 typedef struct rtp_source_t rtp_source_t;
 
+/* Jitter buffer depth, in packets (power of two) */
+#define RTP_RING 4096
+
 /** State for a RTP session: */
 struct rtp_session_t
 {
@@ -42,6 +45,7 @@ struct rtp_session_t
     unsigned       srcc;
     uint8_t        ptc;
     rtp_pt_t      *ptv;
+    rtp_fec_t     *fec; /* created with the first FEC packet */
 };
 
 static rtp_source_t *
@@ -49,7 +53,8 @@ rtp_source_create (demux_t *, const rtp_session_t *, uint32_t, uint16_t);
 static void
 rtp_source_destroy (demux_t *, const rtp_session_t *, rtp_source_t *);
 
-static void rtp_decode (demux_t *, const rtp_session_t *, rtp_source_t *);
+static void rtp_decode (demux_t *, const rtp_session_t *, rtp_source_t *,
+                        block_t **);
 
 /**
  * Creates a new RTP session.
@@ -65,6 +70,7 @@ rtp_session_create (demux_t *demux)
     session->srcc = 0;
     session->ptc = 0;
     session->ptv = NULL;
+    session->fec = NULL;
 
     (void)demux;
     return session;
@@ -79,6 +85,8 @@ void rtp_session_destroy (demux_t *demux, rtp_session_t *session)
     for (unsigned i = 0; i < session->srcc; i++)
         rtp_source_destroy (demux, session, session->srcv[i]);
 
+    if (session->fec != NULL)
+        rtp_fec_destroy (session->fec);
     free (session->srcv);
     free (session->ptv);
     free (session);
@@ -147,8 +155,9 @@ struct rtp_source_t
     uint16_t bad_seq; /* tentatively next expected sequence for resync */
     uint16_t max_seq; /* next expected sequence */
 
-    uint16_t last_seq; /* sequence of the next dequeued packet */
-    block_t *blocks; /* re-ordered blocks queue */
+    uint16_t last_seq; /* sequence of the last dequeued packet */
+    unsigned queued;   /* packets in the jitter buffer */
+    block_t **ring;    /* jitter buffer, indexed by sequence number */
     void    *opaque[0]; /* Per-source private payload data */
 };
 
@@ -165,6 +174,13 @@ rtp_source_create (demux_t *demux, const rtp_session_t *session,
     if (source == NULL)
         return NULL;
 
+    source->ring = calloc (RTP_RING, sizeof (*source->ring));
+    if (source->ring == NULL)
+    {
+        free (source);
+        return NULL;
+    }
+
     source->ssrc = ssrc;
     source->jitter = 0;
     source->ref_rtp = 0;
@@ -172,7 +188,7 @@ rtp_source_create (demux_t *demux, const rtp_session_t *session,
     source->ref_ntp = UINT64_C (1) << 62;
     source->max_seq = source->bad_seq = init_seq;
     source->last_seq = init_seq - 1;
-    source->blocks = NULL;
+    source->queued = 0;
 
     /* Initializes all payload */
     for (unsigned i = 0; i < session->ptc; i++)
@@ -183,6 +199,40 @@ rtp_source_create (demux_t *demux, const rtp_session_t *session,
 }
 
 
+/**
+ * Empties the jitter buffer of an RTP source.
+ */
+static void rtp_source_flush (rtp_source_t *source)
+{
+    for (unsigned i = 0; source->queued > 0; i++)
+    {
+        assert (i < RTP_RING);
+        if (source->ring[i] != NULL)
+        {
+            block_Release (source->ring[i]);
+            source->ring[i] = NULL;
+            source->queued--;
+        }
+    }
+}
+
+/**
+ * Finds the earliest packet in the jitter buffer of an RTP source.
+ * @return its slot in the buffer, or NULL if the buffer is empty
+ */
+static block_t **rtp_source_first (rtp_source_t *source)
+{
+    if (source->queued == 0)
+        return NULL;
+
+    for (uint16_t seq = source->last_seq + 1;; seq++)
+    {
+        block_t **slot = &source->ring[seq & (RTP_RING - 1)];
+        if (*slot != NULL)
+            return slot;
+    }
+}
+
 /**
  * Destroys an RTP source and its associated streams.
  */
@@ -194,7 +244,8 @@ rtp_source_destroy (demux_t *demux, const rtp_session_t *session,
 
     for (unsigned i = 0; i < session->ptc; i++)
         session->ptv[i].destroy (demux, source->opaque[i]);
-    block_ChainRelease (source->blocks);
+    rtp_source_flush (source);
+    free (source->ring);
     free (source);
 }
 
@@ -210,6 +261,23 @@ static inline uint32_t rtp_timestamp (const block_t *block)
     return GetDWBE (block->p_buffer + 4);
 }
 
+/**
+ * Removes padding if present.
+ * @return false if the padding is invalid
+ */
+static bool rtp_strip_padding (block_t *block)
+{
+    if (block->p_buffer[0] & 0x20)
+    {
+        uint8_t padding = block->p_buffer[block->i_buffer - 1];
+        if ((padding == 0) || (block->i_buffer < (12u + padding)))
+            return false; /* illegal value */
+
+        block->i_buffer -= padding;
+    }
+    return true;
+}
+
 static const struct rtp_pt_t *
 rtp_find_ptype (const rtp_session_t *session, rtp_source_t *source,
                 const block_t *block, void **pt_data)
@@ -246,15 +314,12 @@ rtp_queue (demux_t *demux, rtp_session_t *session, block_t *block)
     if ((block->p_buffer[0] >> 6 ) != 2) /* RTP version number */
         goto drop;
 
-    /* Remove padding if present */
-    if (block->p_buffer[0] & 0x20)
-    {
-        uint8_t padding = block->p_buffer[block->i_buffer - 1];
-        if ((padding == 0) || (block->i_buffer < (12u + padding)))
-            goto drop; /* illegal value */
+    /* FEC protects the packets as sent */
+    if (session->fec != NULL)
+        rtp_fec_media (session->fec, block);
 
-        block->i_buffer -= padding;
-    }
+    if (!rtp_strip_padding (block))
+        goto drop;
 
     mtime_t        now = mdate ();
     rtp_source_t  *src  = NULL;
@@ -335,10 +400,9 @@ rtp_queue (demux_t *demux, rtp_session_t *session, block_t *block)
         if (seq == src->bad_seq)
         {
             src->max_seq = src->bad_seq = seq + 1;
-            src->last_seq = seq - 0x7fffe; /* hack for rtp_decode() */
+            src->last_seq = seq - 1;
             msg_Warn (demux, "sequence resynchronized");
-            block_ChainRelease (src->blocks);
-            src->blocks = NULL;
+            rtp_source_flush (src);
         }
         else
         {
@@ -350,25 +414,35 @@ rtp_queue (demux_t *demux, rtp_session_t *session, block_t *block)
     if (delta_seq >= 0)
         src->max_seq = seq + 1;
 
-    /* Queues the block in sequence order,
-     * hence there is a single queue for all payload types. */
-    block_t **pp = &src->blocks;
-    for (block_t *prev = *pp; prev != NULL; prev = *pp)
+    /* Trash too late packets (and PIM Assert duplicates) */
+    if ((int16_t)(seq - (src->last_seq + 1)) < 0)
     {
-        int16_t delta_seq = seq - rtp_seq (prev);
-        if (delta_seq < 0)
-            break;
-        if (delta_seq == 0)
+        msg_Dbg (demux, "ignoring late packet (sequence: %"PRIu16")", seq);
+        goto drop;
+    }
+
+    /* Make room for packets too far ahead, giving up on the oldest ones */
+    while ((uint16_t)(seq - (src->last_seq + 1)) >= RTP_RING)
+    {
+        block_t **slot = rtp_source_first (src);
+        if (slot == NULL)
         {
-            msg_Dbg (demux, "duplicate packet (sequence: %"PRIu16")", seq);
-            goto drop; /* duplicate */
+            src->last_seq = seq - RTP_RING;
+            break;
         }
-        pp = &prev->p_next;
+        rtp_decode (demux, session, src, slot);
     }
-    block->p_next = *pp;
-    *pp = block;
 
-    /*rtp_decode (demux, session, src);*/
+    /* Stores the block at its sequence number,
+     * hence there is a single queue for all payload types. */
+    block_t **slot = &src->ring[seq & (RTP_RING - 1)];
+    if (*slot != NULL)
+    {
+        msg_Dbg (demux, "duplicate packet (sequence: %"PRIu16")", seq);
+        goto drop; /* duplicate */
+    }
+    *slot = block;
+    src->queued++;
     return;
 
 drop:
@@ -376,7 +450,49 @@ drop:
 }
 
 
-static void rtp_decode (demux_t *, const rtp_session_t *, rtp_source_t *);
+/**
+ * Receives an FEC packet. Not a cancellation point.
+ */
+void
+rtp_queue_fec (demux_t *demux, rtp_session_t *session, block_t *block)
+{
+    if (session->fec == NULL)
+    {
+        session->fec = rtp_fec_create ();
+        if (session->fec == NULL)
+        {
+            block_Release (block);
+            return;
+        }
+        msg_Dbg (demux, "forward error correction enabled");
+    }
+    rtp_fec_parity (session->fec, block);
+}
+
+/**
+ * Rebuilds the next missing packet of a source with FEC, if possible.
+ */
+static bool rtp_repair (demux_t *demux, const rtp_session_t *session,
+                        rtp_source_t *src)
+{
+    const uint16_t seq = src->last_seq + 1;
+    block_t *block = rtp_fec_recover (session->fec, seq);
+
+    if (block == NULL)
+        return false;
+    if (!rtp_strip_padding (block)
+     || GetDWBE (block->p_buffer + 8) != src->ssrc)
+    {
+        block_Release (block);
+        return false;
+    }
+
+    msg_Dbg (demux, "repaired packet (sequence: %"PRIu16")", seq);
+    block->i_pts = mdate ();
+    src->ring[seq & (RTP_RING - 1)] = block;
+    src->queued++;
+    return true;
+}
 
 /**
  * Dequeues RTP packets and pass them to decoder. Not cancellation-safe(?).
@@ -393,6 +509,7 @@ static void rtp_decode (demux_t *, const rtp_session_t *, rtp_source_t *);
 bool rtp_dequeue (demux_t *demux, const rtp_session_t *session,
                   mtime_t *restrict deadlinep)
 {
+    demux_sys_t *sys = demux->p_sys;
     mtime_t now = mdate ();
     bool pending = false;
 
@@ -401,7 +518,7 @@ bool rtp_dequeue (demux_t *demux, const rtp_session_t *session,
     for (unsigned i = 0, max = session->srcc; i < max; i++)
     {
         rtp_source_t *src = session->srcv[i];
-        block_t *block;
+        block_t **slot;
 
         /* Because of IP packet delay variation (IPDV), we need to guesstimate
          * how long to wait for a missing packet in the RTP sequence
@@ -419,14 +536,19 @@ bool rtp_dequeue (demux_t *demux, const rtp_session_t *session,
          * LibVLC E/S-out clock synchronization. Here, we need to bother about
          * re-ordering packets, as decoders can't cope with mis-ordered data.
          */
-        while (((block = src->blocks)) != NULL)
+        while ((slot = rtp_source_first (src)) != NULL)
         {
-            if ((int16_t)(rtp_seq (block) - (src->last_seq + 1)) <= 0)
-            {   /* Next (or earlier) block ready, no need to wait */
-                rtp_decode (demux, session, src);
+            block_t *block = *slot;
+
+            if (rtp_seq (block) == (uint16_t)(src->last_seq + 1))
+            {   /* Next block ready, no need to wait */
+                rtp_decode (demux, session, src, slot);
                 continue;
             }
 
+            if (session->fec != NULL && rtp_repair (demux, session, src))
+                continue;
+
             /* Wait for 3 times the inter-arrival delay variance (about 99.7%
              * match for random gaussian jitter).
              */
@@ -441,6 +563,11 @@ bool rtp_dequeue (demux_t *demux, const rtp_session_t *session,
             if (deadline < (CLOCK_FREQ / 40))
                 deadline = CLOCK_FREQ / 40;
 
+            /* FEC packets come after the packets they protect: wait for
+             * them as long as allowed. In any case, bound the latency. */
+            if (session->fec != NULL || deadline > sys->max_latency)
+                deadline = sys->max_latency;
+
             /* Additionnaly, we implicitly wait for the packetization time
              * multiplied by the number of missing packets. block is the first
              * non-missing packet (lowest sequence number). We have no better
@@ -449,7 +576,7 @@ bool rtp_dequeue (demux_t *demux, const rtp_session_t *session,
             deadline += block->i_pts;
             if (now >= deadline)
             {
-                rtp_decode (demux, session, src);
+                rtp_decode (demux, session, src, slot);
                 continue;
             }
             if (*deadlinep > deadline)
@@ -470,35 +597,30 @@ void rtp_dequeue_force (demux_t *demux, const rtp_session_t *session)
     for (unsigned i = 0, max = session->srcc; i < max; i++)
     {
         rtp_source_t *src = session->srcv[i];
-        block_t *block;
+        block_t **slot;
 
-        while (((block = src->blocks)) != NULL)
-            rtp_decode (demux, session, src);
+        while ((slot = rtp_source_first (src)) != NULL)
+            rtp_decode (demux, session, src, slot);
     }
 }
 
 /**
- * Decodes one RTP packet.
+ * Decodes one RTP packet, taken from the jitter buffer.
  */
 static void
-rtp_decode (demux_t *demux, const rtp_session_t *session, rtp_source_t *src)
+rtp_decode (demux_t *demux, const rtp_session_t *session, rtp_source_t *src,
+            block_t **slot)
 {
-    block_t *block = src->blocks;
+    block_t *block = *slot;
 
     assert (block);
-    src->blocks = block->p_next;
-    block->p_next = NULL;
+    *slot = NULL;
+    src->queued--;
 
     /* Discontinuity detection */
     uint16_t delta_seq = rtp_seq (block) - (src->last_seq + 1);
     if (delta_seq != 0)
     {
-        if (delta_seq >= 0x8000)
-        {   /* Trash too late packets (and PIM Assert duplicates) */
-            msg_Dbg (demux, "ignoring late packet (sequence: %"PRIu16")",
-                      rtp_seq (block));
-            goto drop;
-        }
         msg_Warn (demux, "%"PRIu16" packet(s) lost", delta_seq);
         block->i_flags |= BLOCK_FLAG_DISCONTINUITY;
     }
@@ -27,6 +27,14 @@
 #include <assert.h>
 #include <xcb/xcb.h>
 #include <xcb/composite.h>
+#ifdef HAVE_XCB_DAMAGE
+# include <xcb/damage.h>
+#endif
+#ifdef HAVE_SYS_SHM_H
+# include <sys/shm.h>
+# include <sys/stat.h>
+# include <xcb/shm.h>
+#endif
 #include <vlc_common.h>
 #include <vlc_demux.h>
 #include <vlc_plugin.h>
@@ -95,6 +103,14 @@ static void Demux (void *);
 static int Control (demux_t *, int, va_list);
 static es_out_id_t *InitES (demux_t *, uint_fast16_t, uint_fast16_t,
                             uint_fast8_t);
+#ifdef HAVE_XCB_DAMAGE
+static void DamageInit (demux_t *);
+static void FrameFree (demux_t *);
+static block_t *CaptureDamage (demux_t *, xcb_drawable_t,
+                               int, int, int, int);
+#endif
+
+#define MAX_DAMAGES 16
 
 struct demux_sys_t
 {
@@ -108,7 +124,23 @@ struct demux_sys_t
     int16_t           x, y;
     uint16_t          w, h;
     uint16_t          cur_w, cur_h;
+    int16_t           cur_x, cur_y;
     bool              follow_mouse;
+    uint8_t           bpp, pad; /* bits per pixel, scanline pad */
+#ifdef HAVE_XCB_DAMAGE
+    /* Persistent frame, where only the damaged areas are updated */
+    xcb_damage_damage_t damage; /* 0 if not available */
+    uint8_t           damage_event;
+    bool              refresh; /* the whole frame must be fetched */
+    unsigned          damages;
+    xcb_rectangle_t   damage_rects[MAX_DAMAGES];
+    uint8_t          *frame;
+    size_t            pitch;
+# ifdef HAVE_SYS_SHM_H
+    xcb_shm_seg_t     segment; /* 0 if not available */
+    void             *shm;
+# endif
+#endif
     /* Timer does not use this, only input thread: */
     vlc_timer_t       timer;
 };
@@ -217,6 +249,9 @@ static int Open (vlc_object_t *obj)
     p_sys->cur_h = 0;
     p_sys->es = NULL;
     p_sys->pts = VLC_TS_INVALID;
+#ifdef HAVE_XCB_DAMAGE
+    DamageInit (demux);
+#endif
     if (vlc_timer_create (&p_sys->timer, Demux, demux))
         goto error;
     vlc_timer_schedule (p_sys->timer, false, 1, p_sys->interval);
@@ -242,6 +277,9 @@ static void Close (vlc_object_t *obj)
     demux_sys_t *p_sys = demux->p_sys;
 
     vlc_timer_destroy (p_sys->timer);
+#ifdef HAVE_XCB_DAMAGE
+    FrameFree (demux);
+#endif
     xcb_disconnect (p_sys->conn);
     free (p_sys);
 }
@@ -296,6 +334,227 @@ static int Control (demux_t *demux, int query, va_list args)
 }
 
 
+#ifdef HAVE_XCB_DAMAGE
+/**
+ * Enables damage tracking, so that only the modified areas of the screen
+ * are fetched from the X server.
+ */
+static void DamageInit (demux_t *demux)
+{
+    demux_sys_t *sys = demux->p_sys;
+    xcb_connection_t *conn = sys->conn;
+
+    sys->damage = 0;
+    sys->frame = NULL;
+# ifdef HAVE_SYS_SHM_H
+    sys->segment = 0;
+    sys->shm = NULL;
+# endif
+
+    const xcb_query_extension_reply_t *ext =
+        xcb_get_extension_data (conn, &xcb_damage_id);
+    if (ext == NULL || !ext->present)
+        return;
+
+    xcb_damage_query_version_reply_t *r =
+        xcb_damage_query_version_reply (conn,
+            xcb_damage_query_version (conn, 1, 1), NULL);
+    if (r == NULL)
+        return;
+    msg_Dbg (demux, "using Damage extension v%"PRIu32".%"PRIu32,
+             r->major_version, r->minor_version);
+    free (r);
+
+    sys->damage = xcb_generate_id (conn);
+    sys->damage_event = ext->first_event;
+    xcb_damage_create (conn, sys->damage, sys->window,
+                       XCB_DAMAGE_REPORT_LEVEL_RAW_RECTANGLES);
+}
+
+static void FrameFree (demux_t *demux)
+{
+    demux_sys_t *sys = demux->p_sys;
+
+# ifdef HAVE_SYS_SHM_H
+    if (sys->segment != 0)
+    {
+        xcb_shm_detach (sys->conn, sys->segment);
+        sys->segment = 0;
+    }
+    if (sys->shm != NULL)
+    {
+        shmdt (sys->shm);
+        sys->shm = NULL;
+    }
+# endif
+    free (sys->frame);
+    sys->frame = NULL;
+}
+
+/** Bytes per line of a Z pixmap image of the given width */
+static size_t ImagePitch (const demux_sys_t *sys, unsigned width)
+{
+    return ((width * sys->bpp + sys->pad - 1) / sys->pad) * sys->pad / 8;
+}
+
+static int FrameAlloc (demux_t *demux, unsigned width, unsigned height)
+{
+    demux_sys_t *sys = demux->p_sys;
+    size_t size;
+
+    FrameFree (demux);
+    sys->pitch = ImagePitch (sys, width);
+    size = sys->pitch * height;
+    sys->frame = malloc (size);
+    if (unlikely(sys->frame == NULL))
+        return VLC_ENOMEM;
+    sys->refresh = true;
+
+# ifdef HAVE_SYS_SHM_H
+    /* The damaged areas are fetched through shared memory if possible */
+    const xcb_query_extension_reply_t *ext =
+        xcb_get_extension_data (sys->conn, &xcb_shm_id);
+    if (ext == NULL || !ext->present)
+        return VLC_SUCCESS;
+
+    int id = shmget (IPC_PRIVATE, size, IPC_CREAT | S_IRWXU);
+    if (id == -1)
+        return VLC_SUCCESS;
+    sys->shm = shmat (id, NULL, 0);
+    if (sys->shm == (void *)-1)
+        sys->shm = NULL;
+    else
+    {
+        xcb_shm_seg_t segment = xcb_generate_id (sys->conn);
+        xcb_generic_error_t *err = xcb_request_check (sys->conn,
+            xcb_shm_attach_checked (sys->conn, segment, id, 0));
+        if (err == NULL)
+            sys->segment = segment;
+        else
+        {
+            msg_Dbg (demux, "shared memory (MIT-SHM) not available");
+            free (err);
+        }
+    }
+    shmctl (id, IPC_RMID, NULL);
+# endif
+    return VLC_SUCCESS;
+}
+
+/** Accumulates the damaged areas reported since the last frame */
+static void DamageCollect (demux_sys_t *sys)
+{
+    xcb_generic_event_t *ev;
+
+    while ((ev = xcb_poll_for_event (sys->conn)) != NULL)
+    {
+        if ((ev->response_type & 0x7F) == sys->damage_event + XCB_DAMAGE_NOTIFY
+         && !sys->refresh)
+        {
+            const xcb_rectangle_t *area =
+                &((xcb_damage_notify_event_t *)ev)->area;
+
+            if (sys->damages == MAX_DAMAGES)
+            {   /* Too many areas: merge them into their bounding box */
+                xcb_rectangle_t *box = &sys->damage_rects[0];
+                int x2 = box->x + box->width, y2 = box->y + box->height;
+
+                for (unsigned i = 1; i < sys->damages; i++)
+                {
+                    const xcb_rectangle_t *r = &sys->damage_rects[i];
+                    if (r->x < box->x) box->x = r->x;
+                    if (r->y < box->y) box->y = r->y;
+                    if (r->x + r->width > x2) x2 = r->x + r->width;
+                    if (r->y + r->height > y2) y2 = r->y + r->height;
+                }
+                box->width = x2 - box->x;
+                box->height = y2 - box->y;
+                sys->damages = 1;
+            }
+            sys->damage_rects[sys->damages++] = *area;
+        }
+        free (ev);
+    }
+}
+
+/**
+ * Fetches an area of the drawable into the persistent frame.
+ */
+static void FetchArea (demux_t *demux, xcb_drawable_t drawable,
+                       int x, int y, int w, int h, uint8_t *dst)
+{
+    demux_sys_t *sys = demux->p_sys;
+    xcb_connection_t *conn = sys->conn;
+    size_t src_pitch = ImagePitch (sys, w);
+    size_t line = (w * sys->bpp + 7) / 8;
+    const uint8_t *src;
+    void *reply;
+
+# ifdef HAVE_SYS_SHM_H
+    if (sys->segment != 0)
+    {
+        reply = xcb_shm_get_image_reply (conn,
+            xcb_shm_get_image (conn, drawable, x, y, w, h, ~0,
+                               XCB_IMAGE_FORMAT_Z_PIXMAP, sys->segment, 0),
+            NULL);
+        src = sys->shm;
+    }
+    else
+# endif
+    {
+        reply = xcb_get_image_reply (conn,
+            xcb_get_image (conn, XCB_IMAGE_FORMAT_Z_PIXMAP, drawable,
+                           x, y, w, h, ~0), NULL);
+        src = (reply != NULL) ? xcb_get_image_data (reply) : NULL;
+    }
+    if (reply == NULL)
+    {
+        sys->refresh = true; /* try again next time */
+        return;
+    }
+
+    for (int i = 0; i < h; i++)
+        memcpy (dst + i * sys->pitch, src + i * src_pitch, line);
+    free (reply);
+}
+
+/**
+ * Updates the damaged areas of the frame, and returns a copy of it.
+ */
+static block_t *CaptureDamage (demux_t *demux, xcb_drawable_t drawable,
+                               int x, int y, int w, int h)
+{
+    demux_sys_t *sys = demux->p_sys;
+
+    DamageCollect (sys);
+
+    if (sys->refresh)
+    {
+        sys->refresh = false;
+        FetchArea (demux, drawable, x, y, w, h, sys->frame);
+    }
+    else
+    for (unsigned i = 0; i < sys->damages; i++)
+    {
+        const xcb_rectangle_t *r = &sys->damage_rects[i];
+        int x1 = __MAX(r->x, x), y1 = __MAX(r->y, y);
+        int x2 = __MIN(r->x + r->width, x + w);
+        int y2 = __MIN(r->y + r->height, y + h);
+
+        if (x1 < x2 && y1 < y2)
+            FetchArea (demux, drawable, x1, y1, x2 - x1, y2 - y1,
+                       sys->frame + (y1 - y) * sys->pitch
+                                  + (x1 - x) * sys->bpp / 8);
+    }
+    sys->damages = 0;
+
+    block_t *block = block_Alloc (sys->pitch * h);
+    if (likely(block != NULL))
+        memcpy (block->p_buffer, sys->frame, sys->pitch * h);
+    return block;
+}
+#endif
+
 /**
  * Processing callback
  */
@@ -397,6 +656,10 @@ discard:
             sys->cur_w = w;
             sys->cur_h = h;
         }
+#ifdef HAVE_XCB_DAMAGE
+        if (sys->damage != 0 && FrameAlloc (demux, w, h))
+            FrameFree (demux);
+#endif
     }
 
     /* Capture screen */
@@ -404,6 +667,23 @@ discard:
         (sys->window != geo->root) ? sys->pixmap : sys->window;
     free (geo);
 
+    block_t *block;
+#ifdef HAVE_XCB_DAMAGE
+    if (sys->damage != 0 && sys->frame != NULL)
+    {
+        /* The region moved with the mouse */
+        if (x != sys->cur_x || y != sys->cur_y)
+            sys->refresh = true;
+        sys->cur_x = x;
+        sys->cur_y = y;
+
+        block = CaptureDamage (demux, drawable, x, y, w, h);
+        if (block == NULL)
+            return;
+        goto send;
+    }
+#endif
+
     xcb_get_image_reply_t *img;
     img = xcb_get_image_reply (conn,
         xcb_get_image (conn, XCB_IMAGE_FORMAT_Z_PIXMAP, drawable,
@@ -411,12 +691,15 @@ discard:
     if (img == NULL)
         return;
 
-    block_t *block = block_heap_Alloc (img, xcb_get_image_data (img),
-                                       xcb_get_image_data_length (img));
+    block = block_heap_Alloc (img, xcb_get_image_data (img),
+                              xcb_get_image_data_length (img));
     if (block == NULL)
         return;
 
     /* Send block - zero copy */
+#ifdef HAVE_XCB_DAMAGE
+send:
+#endif
     if (sys->es != NULL)
     {
         if (sys->pts == VLC_TS_INVALID)
@@ -427,6 +710,8 @@ discard:
         es_out_Send (demux->out, sys->es, block);
         sys->pts += sys->interval;
     }
+    else
+        block_Release (block);
 }
 
 static es_out_id_t *InitES (demux_t *demux, uint_fast16_t width,
@@ -444,6 +729,8 @@ static es_out_id_t *InitES (demux_t *demux, uint_fast16_t width,
         if (fmt->depth != depth)
             continue;
         bpp = fmt->depth;
+        p_sys->bpp = fmt->bits_per_pixel;
+        p_sys->pad = fmt->scanline_pad;
         switch (fmt->depth)
         {
             case 32:
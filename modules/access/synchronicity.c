@@ -0,0 +1,273 @@
+/*****************************************************************************
+ * synchronicity.c: stream input from the host of a Synchronicity viewing
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * syn://[key] plays what the host of the viewing of key streams through the
+ * relay server (see access_output/synchronicity.c), by default the viewing
+ * we joined. Every frame is dated on the host's clock; it is held until that
+ * date on ours, through the clock offset of the viewing, plus a latency that
+ * covers the way through the relay. All the peers thus play the stream
+ * together, a constant delay after the host.
+ */
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_access.h>
+#include <vlc_block.h>
+#include <vlc_network.h>
+#include <vlc_playlist.h>
+
+#include <synchronicity/syn_stream.h>
+
+/* Between two updates of the clock offset */
+#define OFFSET_INTERVAL (CLOCK_FREQ / 2)
+/* Longest sleep between two checks that the input still runs */
+#define PACE_SLICE      (CLOCK_FREQ / 20)
+
+/*****************************************************************************
+ * Module descriptor
+ *****************************************************************************/
+static int  Open ( vlc_object_t * );
+static void Close( vlc_object_t * );
+
+#define LATENCY_TEXT N_("Latency (ms)")
+#define LATENCY_LONGTEXT N_( \
+    "How long after the host plays it the stream is passed on, on top of " \
+    "the network caching. It must cover the delay through the relay " \
+    "server, or the stream plays late and unevenly." )
+
+vlc_module_begin ()
+    set_shortname( N_("Synchronicity") )
+    set_description( N_("Synchronicity stream input") )
+    set_category( CAT_INPUT )
+    set_subcategory( SUBCAT_INPUT_ACCESS )
+    add_integer( "synchronicity-stream-latency", 1000, LATENCY_TEXT,
+                 LATENCY_LONGTEXT, true )
+
+    set_capability( "access", 0 )
+    add_shortcut( "synchronicity", "syn" )
+    set_callbacks( Open, Close )
+vlc_module_end ()
+
+/*****************************************************************************
+ * Local prototypes
+ *****************************************************************************/
+struct access_sys_t
+{
+    int        fd;
+    mtime_t    i_latency;
+    bool       b_synced;     /* i_offset is known */
+    mtime_t    i_offset;     /* our clock minus the host's */
+    mtime_t    i_offset_date;
+    bool       b_warned;
+};
+
+static block_t *Block( access_t * );
+static int Control( access_t *, int, va_list );
+
+/*****************************************************************************
+ * Open: join the stream of the viewing
+ *****************************************************************************/
+static int Open( vlc_object_t *p_this )
+{
+    access_t     *p_access = (access_t *)p_this;
+    access_sys_t *p_sys;
+    char          psz_key[SYN_STREAM_KEY_LENGTH + 1];
+
+    if( *p_access->psz_location )
+    {
+        if( strlen( p_access->psz_location ) != SYN_STREAM_KEY_LENGTH )
+        {
+            msg_Err( p_access, "invalid key %s", p_access->psz_location );
+            return VLC_EGENERIC;
+        }
+        strcpy( psz_key, p_access->psz_location );
+    }
+    else
+    {
+        playlist_t *p_playlist = pl_Get( p_access );
+
+        if( playlist_SynGetHostAddrLen( p_playlist ) < sizeof (psz_key) )
+        {
+            msg_Err( p_access, "join a viewing first, or give its key" );
+            return VLC_EGENERIC;
+        }
+        playlist_SynGetHostAddr( p_playlist, psz_key, sizeof (psz_key) );
+    }
+
+    /* Init p_access */
+    access_InitFields( p_access );
+    ACCESS_SET_CALLBACKS( NULL, Block, Control, NULL );
+    p_sys = p_access->p_sys = calloc( 1, sizeof( access_sys_t ) );
+    if( !p_sys )
+        return VLC_ENOMEM;
+
+    p_sys->fd = SynStream_Open( p_access, psz_key, false );
+    if( p_sys->fd < 0 )
+    {
+        free( p_sys );
+        return VLC_EGENERIC;
+    }
+    p_sys->i_latency = INT64_C(1000)
+        * var_InheritInteger( p_access, "synchronicity-stream-latency" );
+    msg_Dbg( p_access, "following the stream of %s", psz_key );
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * Close: free unused data structures
+ *****************************************************************************/
+static void Close( vlc_object_t *p_this )
+{
+    access_t     *p_access = (access_t *)p_this;
+    access_sys_t *p_sys = p_access->p_sys;
+
+    net_Close( p_sys->fd );
+    free( p_sys );
+}
+
+/* Holds a frame until its date on the host, on our clock, plus the latency.
+ * Until the clocks are synced frames are passed on as they come. */
+static void Pace( access_t *p_access, mtime_t i_date )
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    mtime_t now = mdate();
+
+    if( now >= p_sys->i_offset_date )
+    {
+        mtime_t i_offset;
+
+        if( !playlist_SynGetClockOffset( pl_Get( p_access ), &i_offset ) )
+        {
+            p_sys->i_offset = i_offset;
+            p_sys->b_synced = true;
+        }
+        p_sys->i_offset_date = now + OFFSET_INTERVAL;
+    }
+    if( !p_sys->b_synced )
+        return;
+
+    mtime_t i_due = i_date + p_sys->i_offset + p_sys->i_latency;
+    if( i_due > now + p_sys->i_latency + CLOCK_FREQ )
+    {
+        /* The host's clock jumped, or it is not our host */
+        if( !p_sys->b_warned )
+            msg_Warn( p_access, "stream dated %"PRId64" us ahead, not paced",
+                      i_due - now );
+        p_sys->b_warned = true;
+        return;
+    }
+
+    while( now < i_due && vlc_object_alive( p_access ) )
+    {
+        mwait( __MIN( i_due, now + PACE_SLICE ) );
+        now = mdate();
+    }
+}
+
+/*****************************************************************************
+ * Block: one frame of the stream, when it is due
+ *****************************************************************************/
+static block_t *Block( access_t *p_access )
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    uint8_t header[SYN_STREAM_FRAME_HEADER];
+    block_t *p_block;
+
+    if( p_access->info.b_eof )
+        return NULL;
+
+    if( net_Read( p_access, p_sys->fd, NULL, header, sizeof (header),
+                  true ) != sizeof (header) )
+        goto eof;
+
+    uint32_t i_payload = GetDWBE( header );
+    mtime_t i_date = GetQWBE( header + 4 );
+    if( i_payload > SYN_STREAM_MAX_PAYLOAD )
+    {
+        msg_Err( p_access, "invalid frame of %"PRIu32" bytes", i_payload );
+        goto eof;
+    }
+
+    p_block = block_Alloc( i_payload );
+    if( unlikely(p_block == NULL) )
+        goto eof;
+    if( net_Read( p_access, p_sys->fd, NULL, p_block->p_buffer, i_payload,
+                  true ) != (ssize_t)i_payload )
+    {
+        block_Release( p_block );
+        goto eof;
+    }
+
+    Pace( p_access, i_date );
+    p_access->info.i_pos += i_payload;
+    return p_block;
+
+eof:
+    p_access->info.b_eof = true;
+    return NULL;
+}
+
+/*****************************************************************************
+ * Control:
+ *****************************************************************************/
+static int Control( access_t *p_access, int i_query, va_list args )
+{
+    bool    *pb_bool;
+    int64_t *pi_64;
+
+    switch( i_query )
+    {
+        /* The host seeks and pauses for us */
+        case ACCESS_CAN_SEEK:
+        case ACCESS_CAN_FASTSEEK:
+        case ACCESS_CAN_PAUSE:
+        case ACCESS_CAN_CONTROL_PACE:
+            pb_bool = (bool*)va_arg( args, bool* );
+            *pb_bool = false;
+            break;
+
+        case ACCESS_GET_PTS_DELAY:
+            pi_64 = (int64_t*)va_arg( args, int64_t * );
+            *pi_64 = INT64_C(1000)
+                   * var_InheritInteger( p_access, "network-caching" );
+            break;
+
+        case ACCESS_SET_PAUSE_STATE:
+        case ACCESS_GET_TITLE_INFO:
+        case ACCESS_SET_TITLE:
+        case ACCESS_SET_SEEKPOINT:
+        case ACCESS_SET_PRIVATE_ID_STATE:
+        case ACCESS_GET_CONTENT_TYPE:
+            return VLC_EGENERIC;
+
+        default:
+            msg_Warn( p_access, "unimplemented query in control" );
+            return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
@@ -40,9 +40,24 @@
 #include <vlc_plugin.h>
 #include <vlc_access.h>
 #include <vlc_network.h>
+#include <vlc_tracer.h>
+
+#ifdef HAVE_RECVMMSG
+#   include <poll.h>
+#   include <sys/socket.h>
+#   include <sys/time.h>
+#   include <time.h>
+#endif
 
 #define MTU 65535
 
+#ifdef HAVE_RECVMMSG
+/* Datagrams received per system call */
+#   define UDP_BATCH 32
+#else
+#   define UDP_BATCH 1
+#endif
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -69,12 +84,31 @@ vlc_module_end ()
 static block_t *BlockUDP( access_t * );
 static int Control( access_t *, int, va_list );
 
+struct access_sys_t
+{
+    int      fd;
+    /* Receive buffers, one per datagram of a batch. Datagrams are copied
+     * out into blocks of their own size. */
+    uint8_t *p_slots;
+#ifdef HAVE_RECVMMSG
+    struct mmsghdr msgv[UDP_BATCH];
+    struct iovec   iov[UDP_BATCH];
+    union
+    {
+        struct cmsghdr hdr;
+        char buf[CMSG_SPACE(sizeof (struct timespec))];
+    } cmsg[UDP_BATCH];
+    bool     b_timestamp;
+#endif
+};
+
 /*****************************************************************************
  * Open: open the socket
  *****************************************************************************/
 static int Open( vlc_object_t *p_this )
 {
     access_t     *p_access = (access_t*)p_this;
+    access_sys_t *p_sys;
 
     char *psz_name = strdup( p_access->psz_location );
     char *psz_parser;
@@ -136,7 +170,37 @@ static int Open( vlc_object_t *p_this )
         msg_Err( p_access, "cannot open socket" );
         return VLC_EGENERIC;
     }
-    p_access->p_sys = (void *)(intptr_t)fd;
+
+    p_access->p_sys = p_sys = malloc( sizeof( *p_sys ) );
+    if( unlikely( p_sys == NULL ) )
+    {
+        net_Close( fd );
+        return VLC_ENOMEM;
+    }
+    /* Only the first bytes of each slot are ever touched with small
+     * datagrams such as TS over UDP */
+    p_sys->p_slots = malloc( UDP_BATCH * MTU );
+    if( unlikely( p_sys->p_slots == NULL ) )
+    {
+        net_Close( fd );
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+    p_sys->fd = fd;
+
+#ifdef HAVE_RECVMMSG
+    memset( p_sys->msgv, 0, sizeof( p_sys->msgv ) );
+    for( unsigned i = 0; i < UDP_BATCH; i++ )
+    {
+        p_sys->iov[i].iov_base = p_sys->p_slots + i * MTU;
+        p_sys->iov[i].iov_len = MTU;
+        p_sys->msgv[i].msg_hdr.msg_iov = &p_sys->iov[i];
+        p_sys->msgv[i].msg_hdr.msg_iovlen = 1;
+    }
+    /* Arrival dates, for clock recovery */
+    p_sys->b_timestamp = setsockopt( fd, SOL_SOCKET, SO_TIMESTAMPNS,
+                                     &(int){ 1 }, sizeof (int) ) == 0;
+#endif
 
     return VLC_SUCCESS;
 }
@@ -147,8 +211,11 @@ static int Open( vlc_object_t *p_this )
 static void Close( vlc_object_t *p_this )
 {
     access_t     *p_access = (access_t*)p_this;
+    access_sys_t *p_sys = p_access->p_sys;
 
-    net_Close( (intptr_t)p_access->p_sys );
+    net_Close( p_sys->fd );
+    free( p_sys->p_slots );
+    free( p_sys );
 }
 
 /*****************************************************************************
@@ -193,27 +260,101 @@ static int Control( access_t *p_access, int i_query, va_list args )
     return VLC_SUCCESS;
 }
 
+#ifdef HAVE_RECVMMSG
 /*****************************************************************************
- * BlockUDP:
+ * ArrivalDate: kernel reception time of a datagram, on the mdate() clock
+ *****************************************************************************/
+static mtime_t ArrivalDate( const struct msghdr *p_msg, mtime_t i_now,
+                            mtime_t i_wallclock )
+{
+    for( struct cmsghdr *p_cmsg = CMSG_FIRSTHDR( p_msg );
+         p_cmsg != NULL;
+         p_cmsg = CMSG_NXTHDR( (struct msghdr *)p_msg, p_cmsg ) )
+    {
+        if( p_cmsg->cmsg_level == SOL_SOCKET
+         && p_cmsg->cmsg_type == SCM_TIMESTAMPNS )
+        {
+            struct timespec ts;
+
+            memcpy( &ts, CMSG_DATA( p_cmsg ), sizeof( ts ) );
+            return i_now - i_wallclock + INT64_C(1000000) * ts.tv_sec
+                                       + ts.tv_nsec / 1000;
+        }
+    }
+    return i_now;
+}
+#endif
+
+/*****************************************************************************
+ * BlockUDP: receives as many datagrams as are waiting, up to UDP_BATCH,
+ * and returns them as a chain
  *****************************************************************************/
 static block_t *BlockUDP( access_t *p_access )
 {
     access_sys_t *p_sys = p_access->p_sys;
-    block_t      *p_block;
-    ssize_t len;
 
     if( p_access->info.b_eof )
         return NULL;
 
-    /* Read data */
-    p_block = block_New( p_access, MTU );
-    len = net_Read( p_access, (intptr_t)p_sys, NULL,
-                    p_block->p_buffer, MTU, false );
-    if( len < 0 )
+#ifdef HAVE_RECVMMSG
+    /* Wake up now and then, so that the stream can notice it is killed */
+    struct pollfd ufd = { .fd = p_sys->fd, .events = POLLIN };
+
+    if( poll( &ufd, 1, 100 ) <= 0 )
+        return NULL;
+
+    for( unsigned i = 0; i < UDP_BATCH; i++ )
     {
-        block_Release( p_block );
+        struct msghdr *p_msg = &p_sys->msgv[i].msg_hdr;
+
+        p_msg->msg_control = p_sys->b_timestamp ? p_sys->cmsg[i].buf : NULL;
+        p_msg->msg_controllen = p_sys->b_timestamp ? sizeof( p_sys->cmsg[i] )
+                                                   : 0;
+    }
+
+    int i_count = recvmmsg( p_sys->fd, p_sys->msgv, UDP_BATCH,
+                            MSG_DONTWAIT, NULL );
+    if( i_count <= 0 )
         return NULL;
+    VLC_TRACE_COUNTER( "udp datagrams", i_count );
+
+    mtime_t i_now = mdate(), i_wallclock = i_now;
+    if( p_sys->b_timestamp )
+    {
+        struct timespec ts;
+
+        clock_gettime( CLOCK_REALTIME, &ts );
+        i_wallclock = INT64_C(1000000) * ts.tv_sec + ts.tv_nsec / 1000;
+    }
+
+    block_t *p_chain = NULL, **pp_last = &p_chain;
+    for( int i = 0; i < i_count; i++ )
+    {
+        size_t i_len = p_sys->msgv[i].msg_len;
+        block_t *p_block = block_Alloc( i_len );
+        if( unlikely( p_block == NULL ) )
+            break;
+
+        memcpy( p_block->p_buffer, p_sys->p_slots + i * MTU, i_len );
+        p_block->i_dts = ArrivalDate( &p_sys->msgv[i].msg_hdr,
+                                      i_now, i_wallclock );
+        *pp_last = p_block;
+        pp_last = &p_block->p_next;
     }
+    return p_chain;
+#else
+    ssize_t len = net_Read( p_access, p_sys->fd, NULL,
+                            p_sys->p_slots, MTU, false );
+    if( len < 0 )
+        return NULL;
+    VLC_TRACE_INSTANT( "udp datagram" );
 
-    return block_Realloc( p_block, 0, len );
+    block_t *p_block = block_Alloc( len );
+    if( likely( p_block != NULL ) )
+    {
+        memcpy( p_block->p_buffer, p_sys->p_slots, len );
+        p_block->i_dts = mdate();
+    }
+    return p_block;
+#endif
 }
@@ -0,0 +1,597 @@
+/*****************************************************************************
+ * udp_ring.c: UDP multicast input through a Linux packet ring
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * All the inputs of one process that receive from the same network interface
+ * share a single AF_PACKET socket with a TPACKET_V3 memory-mapped ring. One
+ * thread walks the ring and hands each IPv4 UDP payload to the inputs whose
+ * group:port (and source, if any) match, so that ingesting many multicast
+ * groups costs neither one socket lookup and queue nor one system call per
+ * datagram. The regular UDP socket is still opened, to join the group, but
+ * it drops everything it receives.
+ */
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_access.h>
+#include <vlc_network.h>
+
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <linux/filter.h>
+
+/* Ring geometry: RING_BLOCKS blocks of RING_BLOCK_SIZE bytes. The kernel
+ * hands a block over when it is full, or after RING_BLOCK_TIMEOUT ms. */
+#define RING_BLOCK_SIZE    (1 << 20)
+#define RING_BLOCKS        64
+#define RING_FRAME_SIZE    2048
+#define RING_BLOCK_TIMEOUT 10
+
+/* Bytes queued for one input before datagrams are dropped */
+#define RING_QUEUE_MAX     (8 << 20)
+
+/*****************************************************************************
+ * Module descriptor
+ *****************************************************************************/
+static int  Open ( vlc_object_t * );
+static void Close( vlc_object_t * );
+
+#define RING_TEXT N_("Packet ring interface")
+#define RING_LONGTEXT N_( \
+    "Receive IPv4 multicast through a packet ring shared by all the inputs " \
+    "on this network interface (e.g. eth0), instead of one socket per " \
+    "input. This requires the CAP_NET_RAW capability.")
+
+vlc_module_begin ()
+    set_shortname( N_("UDP ring") )
+    set_description( N_("UDP multicast input through a packet ring") )
+    set_category( CAT_INPUT )
+    set_subcategory( SUBCAT_INPUT_ACCESS )
+
+    add_string( "udp-ring", NULL, RING_TEXT, RING_LONGTEXT, true )
+
+    set_capability( "access", 1 )
+    add_shortcut( "udp", "udpstream", "udp4" )
+
+    set_callbacks( Open, Close )
+vlc_module_end ()
+
+/*****************************************************************************
+ * Local prototypes
+ *****************************************************************************/
+static block_t *BlockUDP( access_t * );
+static int Control( access_t *, int, va_list );
+
+typedef struct ring_t ring_t;
+
+struct access_sys_t
+{
+    ring_t       *p_ring;
+    access_sys_t *p_next;   /* other inputs on the same ring */
+    int           fd;       /* group membership only */
+
+    /* Datagrams matched, in network byte order; i_source is 0 for any */
+    uint32_t      i_group;
+    uint32_t      i_source;
+    uint16_t      i_port;
+
+    /* Protected by the ring lock */
+    vlc_cond_t    wait;
+    block_t      *p_chain;
+    block_t     **pp_last;
+    size_t        i_queued;
+    unsigned      i_dropped;
+    bool          b_signal;
+};
+
+struct ring_t
+{
+    ring_t       *p_next;
+    unsigned      i_refs;
+    int           i_ifindex;
+
+    int           fd;
+    uint8_t      *p_map;
+    vlc_thread_t  thread;
+
+    vlc_mutex_t   lock;
+    access_sys_t *p_inputs;
+};
+
+static vlc_mutex_t rings_lock = VLC_STATIC_MUTEX;
+static ring_t *p_rings = NULL;
+
+/*****************************************************************************
+ * RingInput: queues the payload of one IPv4 packet for the matching inputs
+ *****************************************************************************/
+static void RingInput( ring_t *p_ring, const uint8_t *p_ip, size_t i_len,
+                       mtime_t i_date )
+{
+    if( i_len < 20 || (p_ip[0] >> 4) != 4 || p_ip[9] != IPPROTO_UDP )
+        return;
+
+    size_t i_ihl = (p_ip[0] & 0x0F) * 4;
+    size_t i_total = GetWBE( p_ip + 2 );
+    if( i_ihl < 20 || i_total > i_len || i_total < i_ihl + 8 )
+        return;
+    /* Fragments would need reassembly: the socket stack handles those */
+    if( GetWBE( p_ip + 6 ) & 0x3FFF )
+        return;
+
+    const uint8_t *p_udp = p_ip + i_ihl;
+    size_t i_udp = GetWBE( p_udp + 4 );
+    if( i_udp < 8 || i_ihl + i_udp > i_total )
+        return;
+
+    uint32_t i_source, i_group;
+    uint16_t i_port;
+    memcpy( &i_source, p_ip + 12, 4 );
+    memcpy( &i_group, p_ip + 16, 4 );
+    memcpy( &i_port, p_udp + 2, 2 );
+
+    for( access_sys_t *p_sys = p_ring->p_inputs; p_sys != NULL;
+         p_sys = p_sys->p_next )
+    {
+        if( p_sys->i_group != i_group || p_sys->i_port != i_port
+         || (p_sys->i_source != 0 && p_sys->i_source != i_source) )
+            continue;
+
+        if( p_sys->i_queued + i_udp - 8 > RING_QUEUE_MAX )
+        {
+            p_sys->i_dropped++;
+            continue;
+        }
+
+        block_t *p_block = block_Alloc( i_udp - 8 );
+        if( unlikely( p_block == NULL ) )
+        {
+            p_sys->i_dropped++;
+            continue;
+        }
+        memcpy( p_block->p_buffer, p_udp + 8, i_udp - 8 );
+        p_block->i_dts = i_date;
+
+        *p_sys->pp_last = p_block;
+        p_sys->pp_last = &p_block->p_next;
+        p_sys->i_queued += p_block->i_buffer;
+        p_sys->b_signal = true;
+    }
+}
+
+/*****************************************************************************
+ * RingDispatch: handles the packets of one ring block
+ *****************************************************************************/
+static void RingDispatch( ring_t *p_ring,
+                          const struct tpacket_block_desc *p_desc )
+{
+    const uint8_t *p = (const uint8_t *)p_desc
+                     + p_desc->hdr.bh1.offset_to_first_pkt;
+    unsigned i_count = p_desc->hdr.bh1.num_pkts;
+
+    /* Kernel timestamps are on the wall clock */
+    struct timespec ts;
+    mtime_t i_now = mdate();
+    clock_gettime( CLOCK_REALTIME, &ts );
+    mtime_t i_offset = i_now - INT64_C(1000000) * ts.tv_sec
+                             - ts.tv_nsec / 1000;
+
+    vlc_mutex_lock( &p_ring->lock );
+    for( ; i_count > 0; i_count-- )
+    {
+        const struct tpacket3_hdr *p_hdr = (const void *)p;
+
+        RingInput( p_ring, p + p_hdr->tp_net, p_hdr->tp_snaplen,
+                   i_offset + INT64_C(1000000) * p_hdr->tp_sec
+                            + p_hdr->tp_nsec / 1000 );
+        p += p_hdr->tp_next_offset;
+    }
+
+    for( access_sys_t *p_sys = p_ring->p_inputs; p_sys != NULL;
+         p_sys = p_sys->p_next )
+    {
+        if( p_sys->b_signal )
+        {
+            vlc_cond_signal( &p_sys->wait );
+            p_sys->b_signal = false;
+        }
+    }
+    vlc_mutex_unlock( &p_ring->lock );
+}
+
+static void *RingThread( void *data )
+{
+    ring_t *p_ring = data;
+
+    for( unsigned i = 0;; i = (i + 1) % RING_BLOCKS )
+    {
+        struct tpacket_block_desc *p_desc =
+            (void *)(p_ring->p_map + i * RING_BLOCK_SIZE);
+
+        while( !(p_desc->hdr.bh1.block_status & TP_STATUS_USER) )
+        {
+            struct pollfd ufd = { .fd = p_ring->fd, .events = POLLIN };
+
+            poll( &ufd, 1, -1 );
+        }
+        __sync_synchronize();
+
+        int canc = vlc_savecancel();
+        RingDispatch( p_ring, p_desc );
+        __sync_synchronize();
+        p_desc->hdr.bh1.block_status = TP_STATUS_KERNEL;
+        vlc_restorecancel( canc );
+    }
+    return NULL;
+}
+
+/*****************************************************************************
+ * RingHold: gets the ring of an interface, creating it if needed
+ *****************************************************************************/
+static ring_t *RingHold( vlc_object_t *p_obj, const char *psz_iface )
+{
+    int i_ifindex = if_nametoindex( psz_iface );
+    if( i_ifindex == 0 )
+    {
+        msg_Err( p_obj, "unknown network interface %s", psz_iface );
+        return NULL;
+    }
+
+    ring_t *p_ring;
+
+    vlc_mutex_lock( &rings_lock );
+    for( p_ring = p_rings; p_ring != NULL; p_ring = p_ring->p_next )
+        if( p_ring->i_ifindex == i_ifindex )
+        {
+            p_ring->i_refs++;
+            goto out;
+        }
+
+    p_ring = malloc( sizeof( *p_ring ) );
+    if( unlikely( p_ring == NULL ) )
+        goto out;
+
+    /* Link-level header removed: packets start with the IP header */
+    p_ring->fd = vlc_socket( AF_PACKET, SOCK_DGRAM, htons( ETH_P_IP ), false );
+    if( p_ring->fd == -1 )
+    {
+        msg_Err( p_obj, "cannot create packet socket: %m" );
+        goto error;
+    }
+
+    /* Only IPv4 UDP to multicast addresses reach the ring */
+    struct sock_filter filter[] = {
+        BPF_STMT( BPF_LD  | BPF_B   | BPF_ABS, 9 ),
+        BPF_JUMP( BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_UDP, 0, 3 ),
+        BPF_STMT( BPF_LD  | BPF_W   | BPF_ABS, 16 ),
+        BPF_STMT( BPF_ALU | BPF_AND | BPF_K, 0xF0000000 ),
+        BPF_JUMP( BPF_JMP | BPF_JEQ | BPF_K, 0xE0000000, 1, 0 ),
+        BPF_STMT( BPF_RET | BPF_K, 0 ),
+        BPF_STMT( BPF_RET | BPF_K, 0xFFFF ),
+    };
+    struct sock_fprog prog = {
+        .len = sizeof( filter ) / sizeof( filter[0] ),
+        .filter = filter,
+    };
+    struct tpacket_req3 req = {
+        .tp_block_size = RING_BLOCK_SIZE,
+        .tp_block_nr = RING_BLOCKS,
+        .tp_frame_size = RING_FRAME_SIZE,
+        .tp_frame_nr = RING_BLOCKS * (RING_BLOCK_SIZE / RING_FRAME_SIZE),
+        .tp_retire_blk_tov = RING_BLOCK_TIMEOUT,
+    };
+    struct sockaddr_ll addr = {
+        .sll_family = AF_PACKET,
+        .sll_protocol = htons( ETH_P_IP ),
+        .sll_ifindex = i_ifindex,
+    };
+
+    if( setsockopt( p_ring->fd, SOL_PACKET, PACKET_VERSION,
+                    &(int){ TPACKET_V3 }, sizeof (int) )
+     || setsockopt( p_ring->fd, SOL_SOCKET, SO_ATTACH_FILTER,
+                    &prog, sizeof( prog ) )
+     || setsockopt( p_ring->fd, SOL_PACKET, PACKET_RX_RING,
+                    &req, sizeof( req ) ) )
+    {
+        msg_Err( p_obj, "cannot set up packet ring: %m" );
+        goto error_fd;
+    }
+
+    p_ring->p_map = mmap( NULL, RING_BLOCKS * RING_BLOCK_SIZE,
+                          PROT_READ | PROT_WRITE, MAP_SHARED,
+                          p_ring->fd, 0 );
+    if( p_ring->p_map == MAP_FAILED )
+    {
+        msg_Err( p_obj, "cannot map packet ring: %m" );
+        goto error_fd;
+    }
+
+    if( bind( p_ring->fd, (struct sockaddr *)&addr, sizeof( addr ) ) )
+    {
+        msg_Err( p_obj, "cannot bind packet socket to %s: %m", psz_iface );
+        goto error_map;
+    }
+
+    p_ring->i_refs = 1;
+    p_ring->i_ifindex = i_ifindex;
+    p_ring->p_inputs = NULL;
+    vlc_mutex_init( &p_ring->lock );
+
+    if( vlc_clone( &p_ring->thread, RingThread, p_ring,
+                   VLC_THREAD_PRIORITY_INPUT ) )
+    {
+        vlc_mutex_destroy( &p_ring->lock );
+        goto error_map;
+    }
+
+    msg_Dbg( p_obj, "packet ring created on %s", psz_iface );
+    p_ring->p_next = p_rings;
+    p_rings = p_ring;
+out:
+    vlc_mutex_unlock( &rings_lock );
+    return p_ring;
+
+error_map:
+    munmap( p_ring->p_map, RING_BLOCKS * RING_BLOCK_SIZE );
+error_fd:
+    close( p_ring->fd );
+error:
+    free( p_ring );
+    p_ring = NULL;
+    goto out;
+}
+
+static void RingRelease( ring_t *p_ring )
+{
+    vlc_mutex_lock( &rings_lock );
+    if( --p_ring->i_refs > 0 )
+    {
+        vlc_mutex_unlock( &rings_lock );
+        return;
+    }
+    for( ring_t **pp = &p_rings; *pp != NULL; pp = &(*pp)->p_next )
+        if( *pp == p_ring )
+        {
+            *pp = p_ring->p_next;
+            break;
+        }
+    vlc_mutex_unlock( &rings_lock );
+
+    vlc_cancel( p_ring->thread );
+    vlc_join( p_ring->thread, NULL );
+    munmap( p_ring->p_map, RING_BLOCKS * RING_BLOCK_SIZE );
+    close( p_ring->fd );
+    vlc_mutex_destroy( &p_ring->lock );
+    free( p_ring );
+}
+
+/*****************************************************************************
+ * Open: joins the group and subscribes to the ring
+ *****************************************************************************/
+static int Open( vlc_object_t *p_this )
+{
+    access_t     *p_access = (access_t*)p_this;
+    access_sys_t *p_sys;
+
+    char *psz_iface = var_InheritString( p_access, "udp-ring" );
+    if( psz_iface == NULL )
+        return VLC_EGENERIC;
+
+    /* Same syntax as the UDP input, IPv4 literals only:
+     * [serveraddr[:serverport]]@group:port */
+    char *psz_name = strdup( p_access->psz_location );
+    char *psz_group, *psz_parser;
+    int i_port = 1234, i_server_port = 0;
+    struct in_addr group, source = { 0 };
+
+    if( unlikely( psz_name == NULL ) )
+        goto error;
+
+    psz_group = strchr( psz_name, '@' );
+    if( psz_group == NULL )
+        goto error;
+    *psz_group++ = '\0';
+
+    psz_parser = strchr( psz_group, ':' );
+    if( psz_parser != NULL )
+    {
+        *psz_parser++ = '\0';
+        i_port = atoi( psz_parser );
+    }
+    if( inet_pton( AF_INET, psz_group, &group ) != 1
+     || !IN_MULTICAST( ntohl( group.s_addr ) ) )
+        goto error;
+
+    psz_parser = strchr( psz_name, ':' );
+    if( psz_parser != NULL )
+    {
+        *psz_parser++ = '\0';
+        i_server_port = atoi( psz_parser );
+    }
+    if( *psz_name && inet_pton( AF_INET, psz_name, &source ) != 1 )
+        goto error;
+
+    p_sys = malloc( sizeof( *p_sys ) );
+    if( unlikely( p_sys == NULL ) )
+        goto error;
+
+    /* The socket makes the kernel join the group, with IGMP, but its own
+     * copy of the datagrams is filtered out right away */
+    p_sys->fd = net_OpenDgram( p_access, psz_group, i_port,
+                               psz_name, i_server_port, IPPROTO_UDP );
+    if( p_sys->fd == -1 )
+    {
+        msg_Err( p_access, "cannot open socket" );
+        free( p_sys );
+        goto error;
+    }
+
+    struct sock_filter drop = BPF_STMT( BPF_RET | BPF_K, 0 );
+    struct sock_fprog prog = { .len = 1, .filter = &drop };
+    setsockopt( p_sys->fd, SOL_SOCKET, SO_ATTACH_FILTER,
+                &prog, sizeof( prog ) );
+
+    p_sys->p_ring = RingHold( p_this, psz_iface );
+    if( p_sys->p_ring == NULL )
+    {
+        net_Close( p_sys->fd );
+        free( p_sys );
+        goto error;
+    }
+
+    p_sys->i_group = group.s_addr;
+    p_sys->i_source = source.s_addr;
+    p_sys->i_port = htons( i_port );
+    p_sys->p_chain = NULL;
+    p_sys->pp_last = &p_sys->p_chain;
+    p_sys->i_queued = 0;
+    p_sys->i_dropped = 0;
+    p_sys->b_signal = false;
+    vlc_cond_init( &p_sys->wait );
+
+    vlc_mutex_lock( &p_sys->p_ring->lock );
+    p_sys->p_next = p_sys->p_ring->p_inputs;
+    p_sys->p_ring->p_inputs = p_sys;
+    vlc_mutex_unlock( &p_sys->p_ring->lock );
+
+    msg_Dbg( p_access, "receiving %s:%d on %s packet ring",
+             psz_group, i_port, psz_iface );
+    free( psz_name );
+    free( psz_iface );
+
+    access_InitFields( p_access );
+    ACCESS_SET_CALLBACKS( NULL, BlockUDP, Control, NULL );
+    p_access->p_sys = p_sys;
+    return VLC_SUCCESS;
+
+error:
+    /* Falls back to the UDP input */
+    free( psz_name );
+    free( psz_iface );
+    return VLC_EGENERIC;
+}
+
+/*****************************************************************************
+ * Close: unsubscribes
+ *****************************************************************************/
+static void Close( vlc_object_t *p_this )
+{
+    access_t     *p_access = (access_t*)p_this;
+    access_sys_t *p_sys = p_access->p_sys;
+    ring_t       *p_ring = p_sys->p_ring;
+
+    vlc_mutex_lock( &p_ring->lock );
+    for( access_sys_t **pp = &p_ring->p_inputs; *pp != NULL;
+         pp = &(*pp)->p_next )
+        if( *pp == p_sys )
+        {
+            *pp = p_sys->p_next;
+            break;
+        }
+    vlc_mutex_unlock( &p_ring->lock );
+    RingRelease( p_ring );
+
+    net_Close( p_sys->fd );
+    block_ChainRelease( p_sys->p_chain );
+    vlc_cond_destroy( &p_sys->wait );
+    free( p_sys );
+}
+
+/*****************************************************************************
+ * Control:
+ *****************************************************************************/
+static int Control( access_t *p_access, int i_query, va_list args )
+{
+    bool    *pb_bool;
+    int64_t *pi_64;
+
+    switch( i_query )
+    {
+        case ACCESS_CAN_SEEK:
+        case ACCESS_CAN_FASTSEEK:
+        case ACCESS_CAN_PAUSE:
+        case ACCESS_CAN_CONTROL_PACE:
+            pb_bool = (bool*)va_arg( args, bool* );
+            *pb_bool = false;
+            break;
+
+        case ACCESS_GET_PTS_DELAY:
+            pi_64 = (int64_t*)va_arg( args, int64_t * );
+            *pi_64 = INT64_C(1000)
+                   * var_InheritInteger(p_access, "network-caching");
+            break;
+
+        case ACCESS_SET_PAUSE_STATE:
+        case ACCESS_GET_TITLE_INFO:
+        case ACCESS_SET_TITLE:
+        case ACCESS_SET_SEEKPOINT:
+        case ACCESS_SET_PRIVATE_ID_STATE:
+        case ACCESS_GET_CONTENT_TYPE:
+            return VLC_EGENERIC;
+
+        default:
+            msg_Warn( p_access, "unimplemented query in control" );
+            return VLC_EGENERIC;
+
+    }
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * BlockUDP: returns the datagrams queued by the ring thread, as a chain
+ *****************************************************************************/
+static block_t *BlockUDP( access_t *p_access )
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    ring_t       *p_ring = p_sys->p_ring;
+
+    /* Wake up now and then, so that the stream can notice it is killed */
+    vlc_mutex_lock( &p_ring->lock );
+    if( p_sys->p_chain == NULL )
+        vlc_cond_timedwait( &p_sys->wait, &p_ring->lock, mdate() + 100000 );
+
+    block_t *p_chain = p_sys->p_chain;
+    unsigned i_dropped = p_sys->i_dropped;
+
+    p_sys->p_chain = NULL;
+    p_sys->pp_last = &p_sys->p_chain;
+    p_sys->i_queued = 0;
+    p_sys->i_dropped = 0;
+    vlc_mutex_unlock( &p_ring->lock );
+
+    if( i_dropped > 0 )
+        msg_Warn( p_access, "%u datagram(s) dropped: input too slow",
+                  i_dropped );
+    return p_chain;
+}
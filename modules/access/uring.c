@@ -0,0 +1,543 @@
+/*****************************************************************************
+ * uring.c: Linux io_uring file input
+ *****************************************************************************
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ ****************************************************************************/
+
+/* Reads regular files with a few reads always queued in the kernel, so the
+ * disk works on the next blocks while the current one is demuxed. Blocks
+ * are read into directly, they are handed out as they are.
+ *
+ *   uring:///path/to/file
+ *
+ * The ring is driven through the raw system calls, without liburing. */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+
+#include <vlc_common.h>
+#include <vlc_input.h>
+#include <vlc_access.h>
+#include <vlc_fs.h>
+#include <vlc_plugin.h>
+
+#define DEPTH_TEXT N_("Queued reads")
+#define DEPTH_LONGTEXT N_( \
+    "How many reads are handed to the kernel ahead of the demuxer.")
+
+#define BLOCK_TEXT N_("Read size (kB)")
+#define BLOCK_LONGTEXT N_( \
+    "Size of every read, and of the blocks handed to the demuxer.")
+
+#define DIRECT_TEXT N_("Direct I/O")
+#define DIRECT_LONGTEXT N_( \
+    "Read around the page cache (O_DIRECT). This spares memory when many " \
+    "files are played from the same disks, but every read waits for the " \
+    "disk.")
+
+static int  Open (vlc_object_t *);
+static void Close (vlc_object_t *);
+
+vlc_module_begin ()
+    set_shortname (N_("io_uring"))
+    set_description (N_("io_uring file input"))
+    set_category (CAT_INPUT)
+    set_subcategory (SUBCAT_INPUT_ACCESS)
+    set_capability ("access", 0)
+    add_shortcut ("uring")
+    set_callbacks (Open, Close)
+
+    add_integer_with_range ("uring-depth", 4, 1, 64,
+                            DEPTH_TEXT, DEPTH_LONGTEXT, true)
+    add_integer_with_range ("uring-block-size", 256, 4, 16384,
+                            BLOCK_TEXT, BLOCK_LONGTEXT, true)
+    add_bool ("uring-direct", false, DIRECT_TEXT, DIRECT_LONGTEXT, true)
+vlc_module_end ()
+
+/* O_DIRECT wants aligned buffers, offsets and lengths */
+#define URING_ALIGN 4096
+
+typedef struct
+{
+    block_t     *block;
+    uint64_t     offset;  /* of the read, aligned down with O_DIRECT */
+    size_t       skip;    /* bytes before the wanted position */
+    struct iovec iov;
+    int          res;
+    bool         done;
+} uring_read_t;
+
+struct access_sys_t
+{
+    int      fd;
+    int      ring;
+    bool     direct;
+    size_t   read_size;
+
+    /* Submission and completion rings, shared with the kernel */
+    void    *sq_ptr, *cq_ptr;
+    size_t   sq_len, cq_len;
+    struct io_uring_sqe *sqes;
+    size_t   sqes_len;
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_cqe *cqes;
+    unsigned to_submit;
+
+    /* Reads in the order of the file, the first one is returned next */
+    uring_read_t *reads;
+    unsigned depth;
+    unsigned first;
+    unsigned count;
+    uint64_t next;      /* where the next read goes */
+    uint64_t size;      /* as of the last fstat() */
+};
+
+static int ring_setup (unsigned entries, struct io_uring_params *p)
+{
+    return syscall (__NR_io_uring_setup, entries, p);
+}
+
+static int ring_enter (int ring, unsigned submit, unsigned wait)
+{
+    return syscall (__NR_io_uring_enter, ring, submit, wait,
+                    wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+}
+
+static int RingOpen (access_t *access, unsigned entries)
+{
+    access_sys_t *sys = access->p_sys;
+    struct io_uring_params p;
+
+    memset (&p, 0, sizeof (p));
+    sys->ring = ring_setup (entries, &p);
+    if (sys->ring == -1)
+    {
+        msg_Err (access, "cannot set up io_uring (%m)");
+        return VLC_EGENERIC;
+    }
+
+    sys->sq_len = p.sq_off.array + p.sq_entries * sizeof (unsigned);
+    sys->cq_len = p.cq_off.cqes + p.cq_entries * sizeof (struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        if (sys->cq_len > sys->sq_len)
+            sys->sq_len = sys->cq_len;
+        sys->cq_len = 0;
+    }
+
+    sys->sq_ptr = mmap (NULL, sys->sq_len, PROT_READ|PROT_WRITE,
+                        MAP_SHARED|MAP_POPULATE, sys->ring, IORING_OFF_SQ_RING);
+    if (sys->sq_ptr == MAP_FAILED)
+        goto error;
+    sys->cq_ptr = sys->sq_ptr;
+    if (sys->cq_len > 0)
+    {
+        sys->cq_ptr = mmap (NULL, sys->cq_len, PROT_READ|PROT_WRITE,
+                            MAP_SHARED|MAP_POPULATE, sys->ring,
+                            IORING_OFF_CQ_RING);
+        if (sys->cq_ptr == MAP_FAILED)
+        {
+            munmap (sys->sq_ptr, sys->sq_len);
+            goto error;
+        }
+    }
+
+    sys->sqes_len = p.sq_entries * sizeof (struct io_uring_sqe);
+    sys->sqes = mmap (NULL, sys->sqes_len, PROT_READ|PROT_WRITE,
+                      MAP_SHARED|MAP_POPULATE, sys->ring, IORING_OFF_SQES);
+    if (sys->sqes == MAP_FAILED)
+    {
+        if (sys->cq_len > 0)
+            munmap (sys->cq_ptr, sys->cq_len);
+        munmap (sys->sq_ptr, sys->sq_len);
+        goto error;
+    }
+
+    uint8_t *sq = sys->sq_ptr, *cq = sys->cq_ptr;
+    sys->sq_head = (unsigned *)(sq + p.sq_off.head);
+    sys->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+    sys->sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+    sys->sq_array = (unsigned *)(sq + p.sq_off.array);
+    sys->cq_head = (unsigned *)(cq + p.cq_off.head);
+    sys->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+    sys->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+    sys->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+    sys->to_submit = 0;
+    return VLC_SUCCESS;
+
+error:
+    msg_Err (access, "cannot map io_uring (%m)");
+    close (sys->ring);
+    return VLC_EGENERIC;
+}
+
+static void RingClose (access_sys_t *sys)
+{
+    munmap (sys->sqes, sys->sqes_len);
+    if (sys->cq_len > 0)
+        munmap (sys->cq_ptr, sys->cq_len);
+    munmap (sys->sq_ptr, sys->sq_len);
+    close (sys->ring);
+}
+
+/* Queues a read of the whole block, submitted with the next RingEnter() */
+static void RingQueue (access_sys_t *sys, uring_read_t *rd)
+{
+    unsigned tail = *sys->sq_tail;
+    unsigned index = tail & *sys->sq_mask;
+    struct io_uring_sqe *sqe = &sys->sqes[index];
+
+    memset (sqe, 0, sizeof (*sqe));
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = sys->fd;
+    sqe->off = rd->offset;
+    sqe->addr = (uintptr_t)&rd->iov;
+    sqe->len = 1;
+    sqe->user_data = (uintptr_t)rd;
+    sys->sq_array[index] = index;
+    rd->done = false;
+    __atomic_store_n (sys->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    sys->to_submit++;
+}
+
+/* Submits what is queued and, if wait, waits for one completion at least */
+static int RingEnter (access_sys_t *sys, bool wait)
+{
+    while (sys->to_submit > 0 || wait)
+    {
+        int val = ring_enter (sys->ring, sys->to_submit, wait);
+        if (val < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        sys->to_submit -= val;
+        break;
+    }
+
+    unsigned head = *sys->cq_head;
+    unsigned tail = __atomic_load_n (sys->cq_tail, __ATOMIC_ACQUIRE);
+    while (head != tail)
+    {
+        struct io_uring_cqe *cqe = &sys->cqes[head & *sys->cq_mask];
+        uring_read_t *rd = (uring_read_t *)(uintptr_t)cqe->user_data;
+
+        rd->res = cqe->res;
+        rd->done = true;
+        head++;
+    }
+    __atomic_store_n (sys->cq_head, head, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/* Reads the block from rd->offset + skip on */
+static int ReadQueue (access_t *access, uring_read_t *rd, uint64_t pos)
+{
+    access_sys_t *sys = access->p_sys;
+    size_t len = sys->read_size;
+
+    rd->offset = pos;
+    rd->skip = 0;
+    if (sys->direct)
+    {
+        rd->skip = pos % URING_ALIGN;
+        rd->offset = pos - rd->skip;
+    }
+
+    rd->block = block_Alloc (len + URING_ALIGN);
+    if (rd->block == NULL)
+        return VLC_ENOMEM;
+    /* Aligned in the block, the demuxer only sees from skip on */
+    uintptr_t addr = (uintptr_t)rd->block->p_buffer;
+    rd->block->p_buffer += (URING_ALIGN - addr % URING_ALIGN) % URING_ALIGN;
+    rd->iov.iov_base = rd->block->p_buffer;
+    rd->iov.iov_len = len;
+    RingQueue (sys, rd);
+    return VLC_SUCCESS;
+}
+
+/* Keeps the queue full, up to what the file held at the last look */
+static void Fill (access_t *access)
+{
+    access_sys_t *sys = access->p_sys;
+
+    while (sys->count < sys->depth && sys->next < sys->size)
+    {
+        uring_read_t *rd =
+            &sys->reads[(sys->first + sys->count) % sys->depth];
+
+        if (ReadQueue (access, rd, sys->next))
+            break;
+        sys->next = rd->offset + sys->read_size;
+        sys->count++;
+    }
+}
+
+/* Waits for every read to complete and drops them */
+static void Drain (access_t *access)
+{
+    access_sys_t *sys = access->p_sys;
+
+    for (unsigned i = 0; i < sys->count; i++)
+    {
+        uring_read_t *rd = &sys->reads[(sys->first + i) % sys->depth];
+
+        while (!rd->done)
+            if (RingEnter (sys, true))
+                break; /* should not happen, leak rather than crash */
+        if (rd->done)
+            block_Release (rd->block);
+    }
+    sys->count = 0;
+}
+
+static void UpdateSize (access_t *access)
+{
+    access_sys_t *sys = access->p_sys;
+    struct stat st;
+
+    if (fstat (sys->fd, &st) == 0 && (uint64_t)st.st_size != sys->size)
+    {
+        sys->size = st.st_size;
+        access->info.i_size = st.st_size;
+        access->info.i_update |= INPUT_UPDATE_SIZE;
+    }
+}
+
+static block_t *Block (access_t *access)
+{
+    access_sys_t *sys = access->p_sys;
+
+    if (sys->count == 0)
+    {
+        /* Caught up with the end, the file may have grown */
+        if (sys->next >= sys->size)
+            UpdateSize (access);
+        Fill (access);
+        if (sys->count == 0)
+        {
+            access->info.b_eof = true;
+            return NULL;
+        }
+    }
+
+    uring_read_t *rd = &sys->reads[sys->first];
+    for (;;)
+    {
+        while (!rd->done)
+            if (RingEnter (sys, true))
+            {
+                msg_Err (access, "io_uring failed (%m)");
+                access->info.b_eof = true;
+                return NULL;
+            }
+        if (rd->res != -EINTR && rd->res != -EAGAIN)
+            break;
+
+        /* Again, in the same place in the queue */
+        uint64_t pos = rd->offset + rd->skip;
+        block_Release (rd->block);
+        if (ReadQueue (access, rd, pos))
+        {   /* Start over from there next time */
+            sys->first = (sys->first + 1) % sys->depth;
+            sys->count--;
+            Drain (access);
+            sys->next = pos;
+            return NULL;
+        }
+        RingEnter (sys, false);
+    }
+
+    block_t *block = rd->block;
+    uint64_t end = rd->offset + (rd->res > 0 ? rd->res : 0);
+    uint64_t want = rd->offset + sys->read_size;
+
+    sys->first = (sys->first + 1) % sys->depth;
+    sys->count--;
+
+    if (rd->res < 0 || end <= rd->offset + rd->skip)
+    {
+        if (rd->res < 0)
+        {
+            errno = -rd->res;
+            msg_Err (access, "failed to read (%m)");
+        }
+        block_Release (block);
+        /* What was queued further on is not wanted anymore */
+        Drain (access);
+        sys->next = access->info.i_pos;
+        if (rd->res < 0)
+            access->info.b_eof = true;
+        else
+            UpdateSize (access);
+        return NULL;
+    }
+
+    block->p_buffer += rd->skip;
+    block->i_buffer = end - rd->offset - rd->skip;
+    access->info.i_pos += block->i_buffer;
+
+    /* A short read leaves a hole before the next read, if any */
+    if (end < want)
+    {
+        Drain (access);
+        sys->next = end;
+    }
+
+    Fill (access);
+    RingEnter (sys, false);
+    return block;
+}
+
+static int Seek (access_t *access, uint64_t pos)
+{
+    access_sys_t *sys = access->p_sys;
+
+    Drain (access);
+    sys->first = 0;
+    sys->next = pos;
+    access->info.i_pos = pos;
+    access->info.b_eof = false;
+
+    Fill (access);
+    RingEnter (sys, false);
+    return VLC_SUCCESS;
+}
+
+static int Control (access_t *access, int query, va_list args)
+{
+    switch (query)
+    {
+        case ACCESS_CAN_SEEK:
+        case ACCESS_CAN_FASTSEEK:
+        case ACCESS_CAN_PAUSE:
+        case ACCESS_CAN_CONTROL_PACE:
+            *va_arg (args, bool *) = true;
+            break;
+
+        case ACCESS_GET_PTS_DELAY:
+            *va_arg (args, int64_t *) =
+                var_InheritInteger (access, "file-caching") * INT64_C(1000);
+            break;
+
+        case ACCESS_SET_PAUSE_STATE:
+            break;
+
+        default:
+            return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+static int Open (vlc_object_t *obj)
+{
+    access_t *access = (access_t *)obj;
+    const char *path = access->psz_filepath;
+
+    if (path == NULL)
+        path = access->psz_location;
+    if (path == NULL || !*path)
+        return VLC_EGENERIC;
+
+    access_sys_t *sys = malloc (sizeof (*sys));
+    if (unlikely(sys == NULL))
+        return VLC_ENOMEM;
+    access->p_sys = sys;
+
+    sys->direct = var_InheritBool (access, "uring-direct");
+    sys->depth = var_InheritInteger (access, "uring-depth");
+    sys->read_size = var_InheritInteger (access, "uring-block-size") * 1024;
+    sys->read_size -= sys->read_size % URING_ALIGN;
+    if (sys->read_size == 0)
+        sys->read_size = URING_ALIGN;
+
+    sys->fd = vlc_open (path, O_RDONLY | (sys->direct ? O_DIRECT : 0));
+    if (sys->fd == -1 && sys->direct)
+    {
+        msg_Warn (access, "cannot open file %s directly (%m)", path);
+        sys->direct = false;
+        sys->fd = vlc_open (path, O_RDONLY);
+    }
+    if (sys->fd == -1)
+    {
+        msg_Err (access, "cannot open file %s (%m)", path);
+        free (sys);
+        return VLC_EGENERIC;
+    }
+
+    struct stat st;
+    if (fstat (sys->fd, &st) || !S_ISREG (st.st_mode))
+    {
+        msg_Dbg (access, "not a regular file");
+        goto error;
+    }
+
+    sys->reads = calloc (sys->depth, sizeof (*sys->reads));
+    if (unlikely(sys->reads == NULL))
+        goto error;
+    if (RingOpen (access, sys->depth))
+    {
+        free (sys->reads);
+        goto error;
+    }
+    sys->first = 0;
+    sys->count = 0;
+    sys->next = 0;
+    sys->size = st.st_size;
+
+    access_InitFields (access);
+    access->pf_read = NULL;
+    access->pf_block = Block;
+    access->pf_control = Control;
+    access->pf_seek = Seek;
+    access->info.i_size = st.st_size;
+
+    if (!sys->direct)
+        posix_fadvise (sys->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    Fill (access);
+    RingEnter (sys, false);
+    msg_Dbg (access, "%u reads of %zu KiB queued%s", sys->depth,
+             sys->read_size / 1024, sys->direct ? ", direct" : "");
+    return VLC_SUCCESS;
+
+error:
+    close (sys->fd);
+    free (sys);
+    return VLC_EGENERIC;
+}
+
+static void Close (vlc_object_t *obj)
+{
+    access_t *access = (access_t *)obj;
+    access_sys_t *sys = access->p_sys;
+
+    Drain (access);
+    RingClose (sys);
+    free (sys->reads);
+    close (sys->fd);
+    free (sys);
+}
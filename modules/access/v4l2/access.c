@@ -73,6 +73,12 @@ void AccessClose( vlc_object_t *obj )
     access_t *access = (access_t *)obj;
     demux_sys_t *sys = (demux_sys_t *)access->p_sys;
 
+    /* The blocks still in use must not requeue their buffers anymore */
+    if( sys->pool != NULL )
+    {
+        ZeroCopyStop( sys->pool );
+        ZeroCopyRelease( sys->pool );
+    }
     ControlsDeinit( obj, sys->controls );
     v4l2_close( sys->i_fd );
     free( sys );
@@ -77,9 +77,14 @@ void DemuxClose( vlc_object_t *obj )
         case IO_METHOD_MMAP:
         case IO_METHOD_USERPTR:
         {
+            /* The buffers still held by blocks are not queued anymore */
+            unsigned n = sys->i_nbuffers;
+            if( sys->pool != NULL )
+                n = ZeroCopyStop( sys->pool );
+
             /* NOTE: Some buggy drivers hang if buffers are not unmapped before
              * streamoff */
-            for( unsigned i = 0; i < sys->i_nbuffers; i++ )
+            for( unsigned i = 0; i < n; i++ )
             {
                 struct v4l2_buffer buf = {
                     .type = V4L2_BUF_TYPE_VIDEO_CAPTURE,
@@ -94,6 +99,13 @@ void DemuxClose( vlc_object_t *obj )
         }
     }
 
+    /* The last block to be released unmaps the buffers */
+    if( sys->pool != NULL )
+    {
+        ZeroCopyRelease( sys->pool );
+        sys->p_buffers = NULL;
+    }
+
     /* Free Video Buffers */
     if( sys->p_buffers ) {
         switch( sys->io )
@@ -79,6 +79,7 @@ typedef enum {
 } io_method;
 
 typedef struct vlc_v4l2_ctrl vlc_v4l2_ctrl_t;
+typedef struct vlc_v4l2_pool vlc_v4l2_pool_t;
 
 /* TODO: move this to access.c and demux.c (separately) */
 struct demux_sys_t
@@ -91,6 +92,7 @@ struct demux_sys_t
     struct buffer_t *p_buffers;
     unsigned int i_nbuffers;
 #define blocksize i_nbuffers /* HACK HACK */
+    vlc_v4l2_pool_t *pool; /* mmap buffers lent to blocks, or NULL */
 
     int i_fourcc;
     uint32_t i_block_flags;
@@ -114,6 +116,8 @@ struct buffer_t
 void ParseMRL(vlc_object_t *, const char *);
 int OpenVideo(vlc_object_t *, demux_sys_t *, bool);
 block_t* GrabVideo(vlc_object_t *, demux_sys_t *);
+unsigned ZeroCopyStop(vlc_v4l2_pool_t *);
+void ZeroCopyRelease(vlc_v4l2_pool_t *);
 
 /* demux.c */
 int DemuxOpen(vlc_object_t *);
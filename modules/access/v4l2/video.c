@@ -459,6 +459,7 @@ vlc_module_end ()
  *****************************************************************************/
 
 static block_t* ProcessVideoFrame( vlc_object_t *p_demux, uint8_t *p_frame, size_t );
+static block_t *ZeroCopyWrap( vlc_v4l2_pool_t *, const struct v4l2_buffer * );
 
 static const struct
 {
@@ -585,6 +586,14 @@ block_t* GrabVideo( vlc_object_t *p_demux, demux_sys_t *p_sys )
             return NULL;
         }
 
+        /* The buffer is requeued when the block is released */
+        if( p_sys->pool != NULL )
+        {
+            p_block = ZeroCopyWrap( p_sys->pool, &buf );
+            if( p_block != NULL )
+                break;
+        }
+
         p_block = ProcessVideoFrame( p_demux, p_sys->p_buffers[buf.index].start, buf.bytesused );
         if( !p_block )
             return NULL;
@@ -675,6 +684,138 @@ static block_t* ProcessVideoFrame( vlc_object_t *p_demux, uint8_t *p_frame, size
     return p_block;
 }
 
+/*****************************************************************************
+ * Zero-copy: the mmap'ed buffers are lent to the blocks, and queued back
+ * into the driver when the blocks are released. The pool outlives the
+ * demux if blocks are still in use when it is closed.
+ *****************************************************************************/
+struct vlc_v4l2_pool
+{
+    vlc_mutex_t      lock;
+    unsigned         refs; /* capture side + lent buffers */
+    unsigned         i_out; /* lent buffers */
+    int              fd; /* -1 once the capture is stopped */
+    struct buffer_t *buffers;
+    unsigned         i_nbuffers;
+};
+
+typedef struct
+{
+    block_t          self;
+    vlc_v4l2_pool_t *pool;
+    unsigned         index;
+} v4l2_block_t;
+
+static vlc_v4l2_pool_t *ZeroCopyNew( demux_sys_t *p_sys, int i_fd )
+{
+    vlc_v4l2_pool_t *pool = malloc( sizeof( *pool ) );
+    if( unlikely(pool == NULL) )
+        return NULL;
+
+    vlc_mutex_init( &pool->lock );
+    pool->refs = 1;
+    pool->i_out = 0;
+    pool->fd = i_fd;
+    pool->buffers = p_sys->p_buffers;
+    pool->i_nbuffers = p_sys->i_nbuffers;
+    return pool;
+}
+
+static void ZeroCopyDelete( vlc_v4l2_pool_t *pool )
+{
+    for( unsigned i = 0; i < pool->i_nbuffers; i++ )
+        v4l2_munmap( pool->buffers[i].start, pool->buffers[i].length );
+    free( pool->buffers );
+    vlc_mutex_destroy( &pool->lock );
+    free( pool );
+}
+
+static void ZeroCopyBlockRelease( block_t *p_block )
+{
+    v4l2_block_t *p_v4l2 = (v4l2_block_t *)p_block;
+    vlc_v4l2_pool_t *pool = p_v4l2->pool;
+    bool b_last;
+
+    vlc_mutex_lock( &pool->lock );
+    if( pool->fd != -1 )
+    {
+        struct v4l2_buffer buf;
+
+        memset( &buf, 0, sizeof(buf) );
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = p_v4l2->index;
+        /* Nothing can be done on error: the buffer is lost for capture */
+        v4l2_ioctl( pool->fd, VIDIOC_QBUF, &buf );
+    }
+    pool->i_out--;
+    b_last = --pool->refs == 0;
+    vlc_mutex_unlock( &pool->lock );
+
+    free( p_v4l2 );
+    if( b_last )
+        ZeroCopyDelete( pool );
+}
+
+/**
+ * Wraps a dequeued buffer into a block, unless too few buffers would be
+ * left to the driver: then the caller copies the frame.
+ */
+static block_t *ZeroCopyWrap( vlc_v4l2_pool_t *pool,
+                              const struct v4l2_buffer *buf )
+{
+    v4l2_block_t *p_v4l2;
+
+    vlc_mutex_lock( &pool->lock );
+    if( pool->i_out + 2 > pool->i_nbuffers
+     || (p_v4l2 = malloc( sizeof( *p_v4l2 ) )) == NULL )
+    {
+        vlc_mutex_unlock( &pool->lock );
+        return NULL;
+    }
+    pool->i_out++;
+    pool->refs++;
+    vlc_mutex_unlock( &pool->lock );
+
+    block_Init( &p_v4l2->self, pool->buffers[buf->index].start,
+                buf->bytesused );
+    p_v4l2->self.pf_release = ZeroCopyBlockRelease;
+    p_v4l2->pool = pool;
+    p_v4l2->index = buf->index;
+    return &p_v4l2->self;
+}
+
+/**
+ * Stops requeuing the buffers lent to blocks.
+ * \return the number of buffers still queued in the driver
+ */
+unsigned ZeroCopyStop( vlc_v4l2_pool_t *pool )
+{
+    unsigned n;
+
+    vlc_mutex_lock( &pool->lock );
+    pool->fd = -1;
+    n = pool->i_nbuffers - pool->i_out;
+    vlc_mutex_unlock( &pool->lock );
+    return n;
+}
+
+/**
+ * Releases the capture side of the pool. The buffers are unmapped once
+ * all the blocks are released.
+ */
+void ZeroCopyRelease( vlc_v4l2_pool_t *pool )
+{
+    bool b_last;
+
+    vlc_mutex_lock( &pool->lock );
+    b_last = --pool->refs == 0;
+    vlc_mutex_unlock( &pool->lock );
+
+    if( b_last )
+        ZeroCopyDelete( pool );
+}
+
 /*****************************************************************************
  * Helper function to initalise video IO using the mmap method
  *****************************************************************************/
@@ -683,7 +824,8 @@ static int InitMmap( vlc_object_t *p_demux, demux_sys_t *p_sys, int i_fd )
     struct v4l2_requestbuffers req;
 
     memset( &req, 0, sizeof(req) );
-    req.count = 4;
+    /* Some buffers are held by the blocks with zero-copy */
+    req.count = 8;
     req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
     req.memory = V4L2_MEMORY_MMAP;
 
@@ -810,6 +952,7 @@ int OpenVideo( vlc_object_t *obj, demux_sys_t *sys, bool b_demux )
     if( !var_InheritBool( obj, CFG_PREFIX "use-libv4l2" ) )
     {
         msg_Dbg( obj, "trying kernel V4L2" );
+        sys->b_libv4l2 = false;
         if( InitVideo( obj, fd, sys, b_demux ) == 0 )
             return fd;
     }
@@ -824,6 +967,7 @@ int OpenVideo( vlc_object_t *obj, demux_sys_t *sys, bool b_demux )
     if( libfd == -1 )
         goto error;
     fd = libfd;
+    sys->b_libv4l2 = true;
 #endif
     if( InitVideo( obj, fd, sys, b_demux ) )
         goto error;
@@ -1366,6 +1510,12 @@ static int InitVideo( vlc_object_t *p_obj, int i_fd, demux_sys_t *p_sys,
             msg_Err( p_obj, "VIDIOC_STREAMON failed" );
             goto error;
         }
+
+        /* libv4l2 may convert into its own buffers: keep copying then */
+#ifdef HAVE_LIBV4L2
+        if( !p_sys->b_libv4l2 )
+#endif
+            p_sys->pool = ZeroCopyNew( p_sys, i_fd );
         break;
 
     case IO_METHOD_USERPTR:
@@ -34,6 +34,42 @@
 #include "zip.h"
 #include <vlc_access.h>
 
+#define ZIP_CACHE_MAX            4         /* archives */
+#define ZIP_CHECKPOINT_DISTANCE  (4 << 20) /* bytes of uncompressed data */
+#define ZIP_CHECKPOINT_MAX       64
+
+/** **************************************************************************
+ * Central directory cache
+ * Playlists of archived files open the same archive for each item, and
+ * unzLocateFile() walks the whole central directory every time. The entries
+ * of the last archives are kept, sorted by name.
+ *****************************************************************************/
+typedef struct
+{
+    char         *psz_name;
+    unz_file_pos  pos;
+} zip_entry_t;
+
+typedef struct
+{
+    char        *psz_archive;
+    uint64_t     i_size;
+    unsigned     i_entries;
+    zip_entry_t *p_entries;
+} zip_index_t;
+
+static vlc_mutex_t cache_lock = VLC_STATIC_MUTEX;
+static zip_index_t *cache[ZIP_CACHE_MAX];
+static unsigned cache_next = 0;
+
+/** State of the decompression, to seek without inflating from the start */
+typedef struct
+{
+    uint64_t i_out; /* offset in the uncompressed data */
+    uint64_t i_in;  /* offset in the compressed data */
+    z_stream z;
+} zip_checkpoint_t;
+
 /** **************************************************************************
  * This is our own access_sys_t for zip files
  *****************************************************************************/
@@ -42,15 +78,32 @@ struct access_sys_t
     /* zlib / unzip members */
     unzFile            zipFile;
     zlib_filefunc_def *fileFunctions;
+    stream_t          *p_stream; /* the archive, owned by unzip */
 
     /* file in zip information */
     char              *psz_fileInzip;
+
+    /* direct access to stored and deflated files, bypassing unzip */
+    int                i_method; /* -1 if read through unzip */
+    uint64_t           i_data;   /* offset of the file data in the archive */
+    uint64_t           i_csize;  /* size of the compressed data */
+    uint64_t           i_in;     /* compressed data passed to zlib */
+    bool               b_inflate;
+    z_stream           z;
+    uint8_t           *p_in;
+    zip_checkpoint_t  *p_checkpoints;
+    unsigned           i_checkpoints;
 };
 
 static int AccessControl( access_t *p_access, int i_query, va_list args );
 static ssize_t AccessRead( access_t *, uint8_t *, size_t );
 static int AccessSeek( access_t *, uint64_t );
 static int OpenFileInZip( access_t *p_access );
+static int LocateFile( access_t *p_access, const char *psz_archive );
+static int DirectOpen( access_t *p_access, const unz_file_info *p_info );
+static void DirectClose( access_t *p_access );
+static ssize_t DirectRead( access_t *, uint8_t *, size_t );
+static int DirectSeek( access_t *, uint64_t );
 static char *unescapeXml( const char *psz_text );
 
 /** **************************************************************************
@@ -161,6 +214,7 @@ int AccessOpen( vlc_object_t *p_this )
     p_func->zclose_file  = ZipIO_Close;
     p_func->zerror_file  = ZipIO_Error;
     p_func->opaque       = p_access;
+    p_sys->fileFunctions = p_func;
 
     /* Open zip archive */
     file = p_access->p_sys->zipFile = unzOpen2( psz_pathToZip, p_func );
@@ -171,17 +225,28 @@ int AccessOpen( vlc_object_t *p_this )
         goto exit;
     }
 
-    /* Open file in zip */
-    if( ( i_ret = OpenFileInZip( p_access ) ) != VLC_SUCCESS )
+    /* Locate file in zip */
+    if( LocateFile( p_access, psz_pathToZip ) != VLC_SUCCESS )
+    {
+        msg_Err( p_access, "could not locate file in zip: '%s'",
+                 p_sys->psz_fileInzip );
+        i_ret = VLC_EGENERIC;
         goto exit;
-
-    /* Set callback */
-    ACCESS_SET_CALLBACKS( AccessRead, NULL, AccessControl, AccessSeek );
+    }
 
     /* Get some infos about current file. Maybe we could want some more ? */
     unz_file_info z_info;
     unzGetCurrentFileInfo( file, &z_info, NULL, 0, NULL, 0, NULL, 0 );
 
+    /* Open file in zip: directly if possible */
+    p_sys->i_method = -1;
+    if( DirectOpen( p_access, &z_info ) != VLC_SUCCESS
+     && ( i_ret = OpenFileInZip( p_access ) ) != VLC_SUCCESS )
+        goto exit;
+
+    /* Set callback */
+    ACCESS_SET_CALLBACKS( AccessRead, NULL, AccessControl, AccessSeek );
+
     /* Set access information: size is needed for AccessSeek */
     p_access->info.i_size = z_info.uncompressed_size;
     p_access->info.i_pos  = 0;
@@ -217,6 +282,7 @@ void AccessClose( vlc_object_t *p_this )
     if( p_sys )
     {
         unzFile file = p_sys->zipFile;
+        DirectClose( p_access );
         if( file )
         {
             unzCloseCurrentFile( file );
@@ -249,6 +315,9 @@ static int AccessControl( access_t *p_access, int i_query, va_list args )
         case ACCESS_CAN_FASTSEEK:
             pb_bool = (bool*)va_arg( args, bool* );
             *pb_bool = false;
+            if( p_access->p_sys->i_method == 0 )
+                stream_Control( p_access->p_sys->p_stream,
+                                STREAM_CAN_FASTSEEK, pb_bool );
             break;
 
         case ACCESS_GET_PTS_DELAY:
@@ -293,6 +362,8 @@ static ssize_t AccessRead( access_t *p_access, uint8_t *p_buffer, size_t sz )
         msg_Err( p_access, "archive not opened !" );
         return VLC_EGENERIC;
     }
+    if( p_sys->i_method >= 0 )
+        return DirectRead( p_access, p_buffer, sz );
 
     int i_read = 0;
     i_read = unzReadCurrentFile( file, p_buffer, sz );
@@ -315,6 +386,8 @@ static int AccessSeek( access_t *p_access, uint64_t seek_len )
         msg_Err( p_access, "archive not opened !" );
         return VLC_EGENERIC;
     }
+    if( p_sys->i_method >= 0 )
+        return DirectSeek( p_access, seek_len );
 
     /* Reopen file in zip if needed */
     if( p_access->info.i_pos > seek_len )
@@ -362,20 +435,349 @@ static int OpenFileInZip( access_t *p_access )
 
     p_access->info.i_pos = 0;
 
+    /* The file was located once and for all by LocateFile() */
     unzCloseCurrentFile( file ); /* returns UNZ_PARAMERROR if file not opened */
-    if( unzLocateFile( file, p_sys->psz_fileInzip, 0 ) != UNZ_OK )
+    if( unzOpenCurrentFile( file ) != UNZ_OK )
     {
-        msg_Err( p_access, "could not [re]locate file in zip: '%s'",
+        msg_Err( p_access, "could not [re]open file in zip: '%s'",
                  p_sys->psz_fileInzip );
         return VLC_EGENERIC;
     }
-    if( unzOpenCurrentFile( file ) != UNZ_OK )
+
+    return VLC_SUCCESS;
+}
+
+static int EntryCmp( const void *a, const void *b )
+{
+    const zip_entry_t *p_a = a, *p_b = b;
+    return strcmp( p_a->psz_name, p_b->psz_name );
+}
+
+static void IndexDelete( zip_index_t *p_index )
+{
+    for( unsigned i = 0; i < p_index->i_entries; i++ )
+        free( p_index->p_entries[i].psz_name );
+    free( p_index->p_entries );
+    free( p_index->psz_archive );
+    free( p_index );
+}
+
+/** **************************************************************************
+ * \brief Read the central directory of the archive, once
+ *****************************************************************************/
+static zip_index_t *IndexNew( unzFile file, const char *psz_archive,
+                              uint64_t i_size )
+{
+    unz_global_info info;
+    if( unzGetGlobalInfo( file, &info ) != UNZ_OK || info.number_entry == 0 )
+        return NULL;
+
+    zip_index_t *p_index = malloc( sizeof( *p_index ) );
+    if( !p_index )
+        return NULL;
+    p_index->psz_archive = strdup( psz_archive );
+    p_index->i_size = i_size;
+    p_index->i_entries = 0;
+    p_index->p_entries = calloc( info.number_entry, sizeof( zip_entry_t ) );
+    if( !p_index->psz_archive || !p_index->p_entries )
     {
-        msg_Err( p_access, "could not [re]open file in zip: '%s'",
-                 p_sys->psz_fileInzip );
+        IndexDelete( p_index );
+        return NULL;
+    }
+
+    char psz_name[ZIP_FILENAME_LEN];
+    for( int i_ret = unzGoToFirstFile( file );
+         i_ret == UNZ_OK && p_index->i_entries < info.number_entry;
+         i_ret = unzGoToNextFile( file ) )
+    {
+        zip_entry_t *p_entry = &p_index->p_entries[p_index->i_entries];
+
+        if( unzGetCurrentFileInfo( file, NULL, psz_name, ZIP_FILENAME_LEN,
+                                   NULL, 0, NULL, 0 ) != UNZ_OK
+         || unzGetFilePos( file, &p_entry->pos ) != UNZ_OK )
+            break;
+        p_entry->psz_name = strdup( psz_name );
+        if( !p_entry->psz_name )
+            break;
+        p_index->i_entries++;
+    }
+    qsort( p_index->p_entries, p_index->i_entries, sizeof( zip_entry_t ),
+           EntryCmp );
+    return p_index;
+}
+
+/** **************************************************************************
+ * \brief Make the requested file the current file of the archive
+ *****************************************************************************/
+static int LocateFile( access_t *p_access, const char *psz_archive )
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    const zip_entry_t key = { .psz_name = p_sys->psz_fileInzip };
+    const zip_entry_t *p_entry;
+    zip_index_t *p_index = NULL;
+    unz_file_pos pos;
+    bool b_found = false;
+    uint64_t i_size = stream_Size( p_sys->p_stream );
+
+    vlc_mutex_lock( &cache_lock );
+    for( unsigned i = 0; i < ZIP_CACHE_MAX; i++ )
+        if( cache[i] != NULL && cache[i]->i_size == i_size
+         && !strcmp( cache[i]->psz_archive, psz_archive ) )
+        {
+            p_index = cache[i];
+            break;
+        }
+    if( p_index != NULL )
+    {
+        p_entry = bsearch( &key, p_index->p_entries, p_index->i_entries,
+                           sizeof( zip_entry_t ), EntryCmp );
+        if( p_entry != NULL )
+        {
+            pos = p_entry->pos;
+            b_found = true;
+        }
+    }
+    vlc_mutex_unlock( &cache_lock );
+
+    if( p_index == NULL
+     && ( p_index = IndexNew( p_sys->zipFile, psz_archive, i_size ) ) )
+    {
+        p_entry = bsearch( &key, p_index->p_entries, p_index->i_entries,
+                           sizeof( zip_entry_t ), EntryCmp );
+        if( p_entry != NULL )
+        {
+            pos = p_entry->pos;
+            b_found = true;
+        }
+
+        vlc_mutex_lock( &cache_lock );
+        if( cache[cache_next] != NULL )
+            IndexDelete( cache[cache_next] );
+        cache[cache_next] = p_index;
+        cache_next = ( cache_next + 1 ) % ZIP_CACHE_MAX;
+        vlc_mutex_unlock( &cache_lock );
+    }
+
+    if( b_found && unzGoToFilePos( p_sys->zipFile, &pos ) == UNZ_OK )
+        return VLC_SUCCESS;
+    /* Not indexed, or not an exact match (e.g. case-insensitive) */
+    if( unzLocateFile( p_sys->zipFile, p_sys->psz_fileInzip, 0 ) != UNZ_OK )
         return VLC_EGENERIC;
+    return VLC_SUCCESS;
+}
+
+/** **************************************************************************
+ * \brief Find the data of the current file in the archive
+ * Stored data is then read and seeked directly, and deflated data is
+ * inflated here, so that seeking can restart from the nearest checkpoint.
+ *****************************************************************************/
+static int DirectOpen( access_t *p_access, const unz_file_info *p_info )
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    stream_t *s = p_sys->p_stream;
+    uint8_t p_hdr[46];
+
+    if( ( p_info->compression_method != 0
+       && p_info->compression_method != Z_DEFLATED )
+     || ( p_info->flag & 1 ) /* encrypted */ )
+        return VLC_EGENERIC;
+
+    /* Offset of the local header, from the central directory */
+    uint64_t i_offset = unzGetOffset( p_sys->zipFile );
+    if( stream_Seek( s, i_offset ) || stream_Read( s, p_hdr, 46 ) < 46
+     || GetDWLE( p_hdr ) != 0x02014b50 )
+        return VLC_EGENERIC;
+    i_offset = GetDWLE( p_hdr + 42 );
+    if( stream_Seek( s, i_offset ) || stream_Read( s, p_hdr, 30 ) < 30
+     || GetDWLE( p_hdr ) != 0x04034b50 )
+        return VLC_EGENERIC;
+
+    p_sys->i_data = i_offset + 30 + GetWLE( p_hdr + 26 ) + GetWLE( p_hdr + 28 );
+    p_sys->i_csize = p_info->compressed_size;
+    p_sys->i_in = 0;
+    if( p_info->compression_method == Z_DEFLATED )
+    {
+        memset( &p_sys->z, 0, sizeof( p_sys->z ) );
+        p_sys->p_in = malloc( ZIP_BUFFER_LEN );
+        p_sys->p_checkpoints = malloc( ZIP_CHECKPOINT_MAX
+                                       * sizeof( zip_checkpoint_t ) );
+        if( !p_sys->p_in || !p_sys->p_checkpoints
+         || inflateInit2( &p_sys->z, -MAX_WBITS ) != Z_OK )
+        {
+            free( p_sys->p_checkpoints );
+            free( p_sys->p_in );
+            p_sys->p_checkpoints = NULL;
+            p_sys->p_in = NULL;
+            return VLC_EGENERIC;
+        }
+        p_sys->b_inflate = true;
+    }
+    p_sys->i_method = p_info->compression_method;
+    return VLC_SUCCESS;
+}
+
+static void DirectClose( access_t *p_access )
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    if( !p_sys->b_inflate )
+        return;
+    for( unsigned i = 0; i < p_sys->i_checkpoints; i++ )
+        inflateEnd( &p_sys->p_checkpoints[i].z );
+    inflateEnd( &p_sys->z );
+    free( p_sys->p_checkpoints );
+    free( p_sys->p_in );
+}
+
+/** **************************************************************************
+ * \brief Remember the state of zlib every ZIP_CHECKPOINT_DISTANCE bytes
+ * The array is never reallocated, as zlib states point to their z_stream.
+ *****************************************************************************/
+static void AddCheckpoint( access_t *p_access )
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    uint64_t i_last = 0;
+
+    if( p_sys->i_checkpoints >= ZIP_CHECKPOINT_MAX )
+        return;
+    if( p_sys->i_checkpoints > 0 )
+        i_last = p_sys->p_checkpoints[p_sys->i_checkpoints - 1].i_out;
+    if( p_access->info.i_pos < i_last + ZIP_CHECKPOINT_DISTANCE )
+        return;
+
+    zip_checkpoint_t *p_cp = &p_sys->p_checkpoints[p_sys->i_checkpoints];
+    if( inflateCopy( &p_cp->z, &p_sys->z ) != Z_OK )
+        return;
+    p_cp->i_out = p_access->info.i_pos;
+    p_cp->i_in = p_sys->i_in - p_sys->z.avail_in;
+    p_sys->i_checkpoints++;
+}
+
+static ssize_t Inflate( access_t *p_access, uint8_t *p_buffer, size_t sz )
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    z_stream *z = &p_sys->z;
+
+    z->next_out = p_buffer;
+    z->avail_out = sz;
+    while( z->avail_out > 0 )
+    {
+        if( z->avail_in == 0 )
+        {
+            int i_len = __MIN( p_sys->i_csize - p_sys->i_in, ZIP_BUFFER_LEN );
+            if( i_len <= 0
+             || stream_Seek( p_sys->p_stream, p_sys->i_data + p_sys->i_in )
+             || ( i_len = stream_Read( p_sys->p_stream, p_sys->p_in,
+                                       i_len ) ) <= 0 )
+                break;
+            p_sys->i_in += i_len;
+            z->next_in = p_sys->p_in;
+            z->avail_in = i_len;
+        }
+
+        int i_ret = inflate( z, Z_NO_FLUSH );
+        if( i_ret == Z_STREAM_END )
+            break;
+        if( i_ret != Z_OK )
+        {
+            msg_Err( p_access, "inflate error %d", i_ret );
+            break;
+        }
     }
 
+    size_t i_out = sz - z->avail_out;
+    if( i_out == 0 )
+        p_access->info.b_eof = true;
+    p_access->info.i_pos += i_out;
+    AddCheckpoint( p_access );
+    return i_out;
+}
+
+static ssize_t DirectRead( access_t *p_access, uint8_t *p_buffer, size_t sz )
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    uint64_t i_pos = p_access->info.i_pos;
+
+    if( sz > p_access->info.i_size - i_pos )
+        sz = p_access->info.i_size - i_pos;
+    if( sz == 0 )
+    {
+        p_access->info.b_eof = true;
+        return 0;
+    }
+    if( p_sys->b_inflate )
+        return Inflate( p_access, p_buffer, sz );
+
+    if( stream_Seek( p_sys->p_stream, p_sys->i_data + i_pos ) )
+        return VLC_EGENERIC;
+    int i_read = stream_Read( p_sys->p_stream, p_buffer, __MIN( sz, INT_MAX ) );
+    if( i_read <= 0 )
+    {
+        p_access->info.b_eof = true;
+        return 0;
+    }
+    p_access->info.i_pos += i_read;
+    return i_read;
+}
+
+static int DirectSeek( access_t *p_access, uint64_t i_pos )
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    uint64_t i_cur = p_access->info.i_pos;
+
+    if( i_pos > p_access->info.i_size )
+        i_pos = p_access->info.i_size;
+    p_access->info.b_eof = false;
+    if( !p_sys->b_inflate )
+    {
+        p_access->info.i_pos = i_pos;
+        return VLC_SUCCESS;
+    }
+
+    /* Restart from the nearest checkpoint before the target if it is
+     * closer than the current position */
+    zip_checkpoint_t *p_cp = NULL;
+    for( unsigned i = 0; i < p_sys->i_checkpoints; i++ )
+        if( p_sys->p_checkpoints[i].i_out <= i_pos )
+            p_cp = &p_sys->p_checkpoints[i];
+
+    if( i_pos < i_cur || ( p_cp != NULL && p_cp->i_out > i_cur ) )
+    {
+        if( p_cp != NULL )
+        {
+            inflateEnd( &p_sys->z );
+            if( inflateCopy( &p_sys->z, &p_cp->z ) != Z_OK )
+            {
+                p_cp = NULL;
+                if( inflateInit2( &p_sys->z, -MAX_WBITS ) != Z_OK )
+                    return VLC_EGENERIC;
+            }
+        }
+        else
+            inflateReset( &p_sys->z );
+
+        p_sys->z.next_in = NULL;
+        p_sys->z.avail_in = 0;
+        p_sys->i_in = p_cp ? p_cp->i_in : 0;
+        p_access->info.i_pos = p_cp ? p_cp->i_out : 0;
+    }
+
+    /* Read and drop the data up to the target */
+    uint8_t *p_buffer = malloc( ZIP_BUFFER_LEN );
+    if( !p_buffer )
+        return VLC_ENOMEM;
+    while( p_access->info.i_pos < i_pos )
+    {
+        if( Inflate( p_access, p_buffer,
+                     __MIN( i_pos - p_access->info.i_pos,
+                            ZIP_BUFFER_LEN ) ) <= 0 )
+        {
+            msg_Warn( p_access, "could not seek in file" );
+            free( p_buffer );
+            return VLC_EGENERIC;
+        }
+    }
+    free( p_buffer );
     return VLC_SUCCESS;
 }
 
@@ -404,6 +806,7 @@ static void* ZCALLBACK ZipIO_Open( void* opaque, const char* file, int mode )
 
     stream_t *s = stream_UrlNew( p_access, fileUri );
     free( fileUri );
+    p_access->p_sys->p_stream = s;
     return s;
 }
 
@@ -42,6 +42,8 @@
 #include <vlc_fs.h>
 #include <vlc_strings.h>
 
+#include "writer.h"
+
 #if defined( WIN32 ) && !defined( UNDER_CE )
 #   include <io.h>
 #   define lseek _lseeki64
@@ -67,6 +69,22 @@ static void Close( vlc_object_t * );
                             "of replacing it.")
 #define SYNC_TEXT N_("Synchronous writing")
 #define SYNC_LONGTEXT N_( "Open the file with synchronous writing.")
+#define ASYNC_TEXT N_("Asynchronous writing")
+#define ASYNC_LONGTEXT N_( "Write from a dedicated thread, so that a slow " \
+                           "storage does not stall the stream output.")
+#define QUEUE_TEXT N_("Write queue size (MiB)")
+#define QUEUE_LONGTEXT N_( "Data waiting to be written asynchronously, " \
+                           "at most.")
+#define OVERFLOW_TEXT N_("Write queue overflow")
+#define OVERFLOW_LONGTEXT N_( "What to do when the storage is too slow " \
+                              "for asynchronous writing." )
+#define DIRECT_TEXT N_("Direct I/O")
+#define DIRECT_LONGTEXT N_( "Write around the page cache (O_DIRECT), " \
+                            "with asynchronous writing." )
+
+static const char *const ppsz_overflow[] = { "block", "drop" };
+static const char *const ppsz_overflow_text[] = {
+    N_("Wait (backpressure)"), N_("Drop data") };
 
 vlc_module_begin ()
     set_description( N_("File stream output") )
@@ -81,6 +99,16 @@ vlc_module_begin ()
     add_bool( SOUT_CFG_PREFIX "sync", false, SYNC_TEXT,SYNC_LONGTEXT,
               false )
 #endif
+    add_bool( SOUT_CFG_PREFIX "async", false, ASYNC_TEXT, ASYNC_LONGTEXT,
+              true )
+    add_integer( SOUT_CFG_PREFIX "queue", 32, QUEUE_TEXT, QUEUE_LONGTEXT,
+                 true )
+        change_integer_range( 1, 1024 )
+    add_string( SOUT_CFG_PREFIX "overflow", "block", OVERFLOW_TEXT,
+                OVERFLOW_LONGTEXT, true )
+        change_string_list( ppsz_overflow, ppsz_overflow_text, NULL )
+    add_bool( SOUT_CFG_PREFIX "direct", false, DIRECT_TEXT, DIRECT_LONGTEXT,
+              true )
     set_callbacks( Open, Close )
 vlc_module_end ()
 
@@ -93,10 +121,18 @@ static const char *const ppsz_sout_options[] = {
 #ifdef O_SYNC
     "sync",
 #endif
+    "async", "queue", "overflow", "direct",
     NULL
 };
 
+struct sout_access_out_sys_t
+{
+    int             fd;
+    async_writer_t *writer; /* NULL if synchronous */
+};
+
 static ssize_t Write( sout_access_out_t *, block_t * );
+static ssize_t WriteAsync( sout_access_out_t *, block_t * );
 static int Seek ( sout_access_out_t *, off_t  );
 static ssize_t Read ( sout_access_out_t *, block_t * );
 static int Control( sout_access_out_t *, int, va_list );
@@ -171,15 +207,42 @@ static int Open( vlc_object_t *p_this )
         }
     }
 
-    p_access->pf_write = Write;
+    sout_access_out_sys_t *p_sys = malloc( sizeof( *p_sys ) );
+    if( unlikely(p_sys == NULL) )
+    {
+        close( fd );
+        return VLC_ENOMEM;
+    }
+    p_sys->fd = fd;
+    p_sys->writer = NULL;
+
+    if (append)
+        lseek (fd, 0, SEEK_END);
+
+    if( var_GetBool( p_access, SOUT_CFG_PREFIX "async" ) )
+    {
+        char *psz_overflow = var_GetString( p_access,
+                                            SOUT_CFG_PREFIX "overflow" );
+        enum async_writer_overflow overflow = ASYNC_WRITER_BLOCK;
+
+        if( psz_overflow != NULL && !strcmp( psz_overflow, "drop" ) )
+            overflow = ASYNC_WRITER_DROP;
+        free( psz_overflow );
+
+        p_sys->writer = async_writer_New( p_access, fd,
+                (size_t)var_GetInteger( p_access, SOUT_CFG_PREFIX "queue" ) << 20,
+                overflow, var_GetBool( p_access, SOUT_CFG_PREFIX "direct" ) );
+        if( p_sys->writer == NULL )
+            msg_Warn( p_access, "writing synchronously" );
+    }
+
+    p_access->pf_write = p_sys->writer != NULL ? WriteAsync : Write;
     p_access->pf_read  = Read;
     p_access->pf_seek  = Seek;
     p_access->pf_control = Control;
-    p_access->p_sys    = (void *)(intptr_t)fd;
+    p_access->p_sys    = p_sys;
 
     msg_Dbg( p_access, "file access output opened (%s)", p_access->psz_path );
-    if (append)
-        lseek (fd, 0, SEEK_END);
 
     return VLC_SUCCESS;
 }
@@ -190,8 +253,13 @@ static int Open( vlc_object_t *p_this )
 static void Close( vlc_object_t * p_this )
 {
     sout_access_out_t *p_access = (sout_access_out_t*)p_this;
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
 
-    close( (intptr_t)p_access->p_sys );
+    if( p_sys->writer != NULL )
+        async_writer_Delete( p_sys->writer ); /* closes the file */
+    else
+        close( p_sys->fd );
+    free( p_sys );
 
     msg_Dbg( p_access, "file access output closed" );
 }
@@ -218,12 +286,19 @@ static int Control( sout_access_out_t *p_access, int i_query, va_list args )
  *****************************************************************************/
 static ssize_t Read( sout_access_out_t *p_access, block_t *p_buffer )
 {
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
     ssize_t val;
 
+    /* Read back what was written */
+    if( p_sys->writer != NULL )
+        async_writer_Flush( p_sys->writer );
+
     do
-        val = read( (intptr_t)p_access->p_sys, p_buffer->p_buffer,
-                    p_buffer->i_buffer );
+        val = read( p_sys->fd, p_buffer->p_buffer, p_buffer->i_buffer );
     while (val == -1 && errno == EINTR);
+
+    if( p_sys->writer != NULL )
+        async_writer_Seek( p_sys->writer, lseek( p_sys->fd, 0, SEEK_CUR ) );
     return val;
 }
 
@@ -236,7 +311,7 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
 
     while( p_buffer )
     {
-        ssize_t val = write ((intptr_t)p_access->p_sys,
+        ssize_t val = write (p_access->p_sys->fd,
                              p_buffer->p_buffer, p_buffer->i_buffer);
         if (val == -1)
         {
@@ -262,10 +337,22 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
     return i_write;
 }
 
+/*****************************************************************************
+ * WriteAsync: queue for the writer thread
+ *****************************************************************************/
+static ssize_t WriteAsync( sout_access_out_t *p_access, block_t *p_buffer )
+{
+    return async_writer_Write( p_access->p_sys->writer, p_buffer );
+}
+
 /*****************************************************************************
  * Seek: seek to a specific location in a file
  *****************************************************************************/
 static int Seek( sout_access_out_t *p_access, off_t i_pos )
 {
-    return lseek( (intptr_t)p_access->p_sys, i_pos, SEEK_SET );
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    if( p_sys->writer != NULL )
+        return async_writer_Seek( p_sys->writer, i_pos );
+    return lseek( p_sys->fd, i_pos, SEEK_SET );
 }
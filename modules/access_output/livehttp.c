@@ -44,6 +44,7 @@
 #include <vlc_fs.h>
 #include <vlc_strings.h>
 #include <vlc_charset.h>
+#include <vlc_httpd.h>
 
 #ifndef O_LARGEFILE
 #   define O_LARGEFILE 0
@@ -82,6 +83,13 @@ static void Close( vlc_object_t * );
 
 #define RATECONTROL_TEXT N_("Use muxers rate control mechanism")
 
+#define HTTPD_TEXT N_("Serve from memory")
+#define HTTPD_LONGTEXT N_("Keep the segments in memory and serve them, and " \
+  "the index, with the built-in HTTP server instead of writing files. The " \
+  "destination and the index are then URLs, such as " \
+  "\":8080/live-########.ts\" and \"/live.m3u8\". The segment being " \
+  "written is listed too, and sent as it is produced.")
+
 vlc_module_begin ()
     set_description( N_("HTTP Live streaming output") )
     set_shortname( N_("LiveHTTP" ))
@@ -101,6 +109,8 @@ vlc_module_begin ()
                 INDEX_TEXT, INDEX_LONGTEXT, true )
     add_string( SOUT_CFG_PREFIX "index-url", NULL,
                 INDEXURL_TEXT, INDEXURL_LONGTEXT, true )
+    add_bool( SOUT_CFG_PREFIX "httpd", false,
+              HTTPD_TEXT, HTTPD_LONGTEXT, true )
     set_callbacks( Open, Close )
 vlc_module_end ()
 
@@ -116,6 +126,7 @@ static const char *const ppsz_sout_options[] = {
     "index",
     "index-url",
     "ratecontrol",
+    "httpd",
     NULL
 };
 
@@ -123,6 +134,13 @@ static ssize_t Write( sout_access_out_t *, block_t * );
 static int Seek ( sout_access_out_t *, off_t  );
 static int Control( sout_access_out_t *, int, va_list );
 
+/* a segment served from memory */
+typedef struct
+{
+    httpd_live_t *p_live;
+    char *psz_name;     /* as listed in the index */
+} livehttp_segment_t;
+
 struct sout_access_out_sys_t
 {
     char *psz_cursegPath;
@@ -137,8 +155,21 @@ struct sout_access_out_sys_t
     bool b_delsegs;
     bool b_ratecontrol;
     bool b_splitanywhere;
+
+    /* in-memory mode */
+    httpd_host_t *p_httpd_host;
+    httpd_file_t *p_httpd_index;
+    char *psz_segUrl;
+    vlc_mutex_t lock;           /* protects the segments and i_segment */
+    livehttp_segment_t **pp_segments; /* oldest first, up to i_segment */
+    int i_segments;
+    bool b_segment_open;
 };
 
+static int IndexFill( httpd_file_sys_t *, httpd_file_t *, uint8_t *,
+                      uint8_t **, int * );
+static int OpenHttpd( sout_access_out_t *, sout_access_out_sys_t * );
+
 /*****************************************************************************
  * Open: open the file
  *****************************************************************************/
@@ -168,6 +199,9 @@ static int Open( vlc_object_t *p_this )
     p_sys->b_delsegs = var_GetBool( p_access, SOUT_CFG_PREFIX "delsegs" );
     p_sys->b_ratecontrol = var_GetBool( p_access, SOUT_CFG_PREFIX "ratecontrol") ;
 
+    p_sys->p_httpd_host = NULL;
+    bool b_httpd = var_GetBool( p_access, SOUT_CFG_PREFIX "httpd" );
+
     p_sys->psz_indexPath = NULL;
     psz_idx = var_GetNonEmptyString( p_access, SOUT_CFG_PREFIX "index" );
     if ( psz_idx )
@@ -180,9 +214,12 @@ static int Open( vlc_object_t *p_this )
             free( p_sys );
             return VLC_ENOMEM;
         }
-        path_sanitize( psz_tmp );
         p_sys->psz_indexPath = psz_tmp;
-        vlc_unlink( p_sys->psz_indexPath );
+        if ( !b_httpd )
+        {
+            path_sanitize( psz_tmp );
+            vlc_unlink( p_sys->psz_indexPath );
+        }
     }
 
     p_sys->psz_indexUrl = var_GetNonEmptyString( p_access, SOUT_CFG_PREFIX "index-url" );
@@ -192,6 +229,14 @@ static int Open( vlc_object_t *p_this )
     p_sys->i_segment = 0;
     p_sys->psz_cursegPath = NULL;
 
+    if ( b_httpd && OpenHttpd( p_access, p_sys ) )
+    {
+        free( p_sys->psz_indexUrl );
+        free( p_sys->psz_indexPath );
+        free( p_sys );
+        return VLC_EGENERIC;
+    }
+
     p_access->pf_write = Write;
     p_access->pf_seek  = Seek;
     p_access->pf_control = Control;
@@ -231,6 +276,197 @@ static char *formatSegmentPath( sout_access_out_t *p_access, char *psz_path, uin
     return psz_result;
 }
 
+/*****************************************************************************
+ * OpenHttpd: serve the segments and the index from memory
+ *****************************************************************************/
+static int OpenHttpd( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys )
+{
+    const char *psz_path = p_access->psz_path;
+    const char *psz_url = psz_path + strcspn( psz_path, "/" );
+
+    if ( !*psz_url || !p_sys->psz_indexPath || *p_sys->psz_indexPath != '/' )
+    {
+        msg_Err( p_access, "serving from memory requires URL paths for "
+                 "the segments and the index" );
+        return VLC_EGENERIC;
+    }
+
+    /* [host][:port] before the path, as with the http access output */
+    if ( psz_url > psz_path )
+    {
+        size_t i_len = psz_url - psz_path;
+        char psz_host[i_len + 1];
+
+        memcpy( psz_host, psz_path, i_len );
+        psz_host[i_len] = '\0';
+
+        char *psz_port = strrchr( psz_host, ':' );
+        if ( psz_port != NULL && strchr( psz_port, ']' ) == NULL )
+        {
+            *psz_port++ = '\0';
+            var_Create( p_access, "http-port", VLC_VAR_INTEGER );
+            var_SetInteger( p_access, "http-port", atoi( psz_port ) );
+        }
+        if ( *psz_host )
+        {
+            var_Create( p_access, "http-host", VLC_VAR_STRING );
+            var_SetString( p_access, "http-host", psz_host );
+        }
+    }
+
+    p_sys->psz_segUrl = strdup( psz_url );
+    if ( !p_sys->psz_segUrl )
+        return VLC_ENOMEM;
+
+    p_sys->p_httpd_host = vlc_http_HostNew( VLC_OBJECT(p_access) );
+    if ( !p_sys->p_httpd_host )
+    {
+        msg_Err( p_access, "cannot start HTTP server" );
+        free( p_sys->psz_segUrl );
+        return VLC_EGENERIC;
+    }
+
+    vlc_mutex_init( &p_sys->lock );
+    p_sys->pp_segments = NULL;
+    p_sys->i_segments = 0;
+    p_sys->b_segment_open = false;
+
+    p_sys->p_httpd_index = httpd_FileNew( p_sys->p_httpd_host,
+                                          p_sys->psz_indexPath,
+                                          "application/vnd.apple.mpegurl",
+                                          NULL, NULL, NULL, IndexFill,
+                                          (httpd_file_sys_t *)p_access );
+    if ( !p_sys->p_httpd_index )
+    {
+        msg_Err( p_access, "cannot serve index %s", p_sys->psz_indexPath );
+        vlc_mutex_destroy( &p_sys->lock );
+        httpd_HostDelete( p_sys->p_httpd_host );
+        free( p_sys->psz_segUrl );
+        return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+static void deleteSegment( livehttp_segment_t *p_seg )
+{
+    httpd_LiveDelete( p_seg->p_live );
+    free( p_seg->psz_name );
+    free( p_seg );
+}
+
+/*****************************************************************************
+ * CloseHttpd: stop serving
+ *****************************************************************************/
+static void CloseHttpd( sout_access_out_sys_t *p_sys )
+{
+    httpd_FileDelete( p_sys->p_httpd_index );
+    for ( int i = 0; i < p_sys->i_segments; i++ )
+        deleteSegment( p_sys->pp_segments[i] );
+    free( p_sys->pp_segments );
+    httpd_HostDelete( p_sys->p_httpd_host );
+    vlc_mutex_destroy( &p_sys->lock );
+    free( p_sys->psz_segUrl );
+}
+
+/*****************************************************************************
+ * IndexFill: generate the index of the segments in memory on request
+ *****************************************************************************/
+static int IndexFill( httpd_file_sys_t *p_data, httpd_file_t *p_file,
+                      uint8_t *psz_request, uint8_t **pp_data, int *pi_data )
+{
+    sout_access_out_t *p_access = (sout_access_out_t *)p_data;
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    VLC_UNUSED(p_file); VLC_UNUSED(psz_request);
+
+    vlc_mutex_lock( &p_sys->lock );
+
+    /* An extra segment may be kept for clients of an older index */
+    int i_first = 0;
+    if ( p_sys->i_numsegs > 0 && (unsigned)p_sys->i_segments > p_sys->i_numsegs )
+        i_first = p_sys->i_segments - p_sys->i_numsegs;
+    uint32_t i_firstseg = p_sys->i_segment - p_sys->i_segments + 1 + i_first;
+
+    int i_size = snprintf( NULL, 0, "#EXTM3U\n#EXT-X-TARGETDURATION:%zu\n"
+                           "#EXT-X-MEDIA-SEQUENCE:%"PRIu32"\n",
+                           p_sys->i_seglen, i_firstseg );
+    for ( int i = i_first; i < p_sys->i_segments; i++ )
+        i_size += snprintf( NULL, 0, "#EXTINF:%zu,\n%s\n", p_sys->i_seglen,
+                            p_sys->pp_segments[i]->psz_name );
+
+    char *psz_index = malloc( i_size + 1 );
+    if ( psz_index )
+    {
+        char *p = psz_index;
+
+        p += sprintf( p, "#EXTM3U\n#EXT-X-TARGETDURATION:%zu\n"
+                      "#EXT-X-MEDIA-SEQUENCE:%"PRIu32"\n",
+                      p_sys->i_seglen, i_firstseg );
+        for ( int i = i_first; i < p_sys->i_segments; i++ )
+            p += sprintf( p, "#EXTINF:%zu,\n%s\n", p_sys->i_seglen,
+                          p_sys->pp_segments[i]->psz_name );
+    }
+    vlc_mutex_unlock( &p_sys->lock );
+
+    *pp_data = (uint8_t *)psz_index;
+    *pi_data = psz_index ? i_size : 0;
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * openNextSegment: start serving a new segment from memory
+ *****************************************************************************/
+static int openNextSegment( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys )
+{
+    uint32_t i_newseg = p_sys->i_segment + 1;
+    livehttp_segment_t *p_seg = malloc( sizeof( *p_seg ) );
+    if ( !p_seg )
+        return -1;
+
+    /* Names are formatted here: str_format() must not run on the HTTP
+     * server threads */
+    char *psz_url = formatSegmentPath( p_access, p_sys->psz_segUrl, i_newseg, false );
+    p_seg->psz_name = formatSegmentPath( p_access,
+                            p_sys->psz_indexUrl ? p_sys->psz_indexUrl
+                                                : p_sys->psz_segUrl,
+                            i_newseg, false );
+    p_seg->p_live = psz_url ? httpd_LiveNew( p_sys->p_httpd_host, psz_url,
+                                             "video/MP2T", NULL, NULL, NULL )
+                            : NULL;
+    if ( !p_seg->p_live || !p_seg->psz_name )
+    {
+        msg_Err( p_access, "cannot serve segment %"PRIu32, i_newseg );
+        if ( p_seg->p_live )
+            httpd_LiveDelete( p_seg->p_live );
+        free( p_seg->psz_name );
+        free( p_seg );
+        free( psz_url );
+        return -1;
+    }
+    msg_Dbg( p_access, "Serving livehttp segment: %s (%"PRIu32")", psz_url, i_newseg );
+    free( psz_url );
+
+    /* Keep the segments of the index, plus the one that just left it */
+    livehttp_segment_t *p_old = NULL;
+
+    vlc_mutex_lock( &p_sys->lock );
+    TAB_APPEND( p_sys->i_segments, p_sys->pp_segments, p_seg );
+    p_sys->i_segment = i_newseg;
+    if ( p_sys->b_delsegs && p_sys->i_numsegs > 0 &&
+         (unsigned)p_sys->i_segments > p_sys->i_numsegs + 1 )
+    {
+        p_old = p_sys->pp_segments[0];
+        REMOVE_ELEM( p_sys->pp_segments, p_sys->i_segments, 0 );
+    }
+    vlc_mutex_unlock( &p_sys->lock );
+
+    /* The HTTP server calls IndexFill() with its own lock held */
+    if ( p_old )
+        deleteSegment( p_old );
+
+    p_sys->b_segment_open = true;
+    return 0;
+}
+
 /************************************************************************
  * updateIndexAndDel: If necessary, update index file & delete old segments
  ************************************************************************/
@@ -331,7 +567,14 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
  *****************************************************************************/
 static void closeCurrentSegment( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys, bool b_isend )
 {
-    if ( p_sys->i_handle >= 0 )
+    if ( p_sys->b_segment_open )
+    {
+        /* Only this thread adds segments, no need to lock */
+        httpd_LiveEnd( p_sys->pp_segments[p_sys->i_segments - 1]->p_live );
+        p_sys->b_segment_open = false;
+        msg_Info( p_access, "LiveHttpSegmentComplete: %"PRIu32, p_sys->i_segment );
+    }
+    else if ( p_sys->i_handle >= 0 )
     {
         close( p_sys->i_handle );
         p_sys->i_handle = -1;
@@ -355,6 +598,8 @@ static void Close( vlc_object_t * p_this )
 
 
     closeCurrentSegment( p_access, p_sys, true );
+    if ( p_sys->p_httpd_host )
+        CloseHttpd( p_sys );
     free( p_sys->psz_indexUrl );
     free( p_sys->psz_indexPath );
     free( p_sys );
@@ -423,9 +668,37 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
 
     while( p_buffer )
     {
-        if ( p_sys->i_handle >= 0 && ( p_sys->b_splitanywhere || ( p_buffer->i_flags & BLOCK_FLAG_TYPE_I ) ) && ( p_buffer->i_dts-p_sys->i_opendts ) > p_sys->i_seglenm )
+        bool b_open = p_sys->i_handle >= 0 || p_sys->b_segment_open;
+
+        if ( b_open && ( p_sys->b_splitanywhere || ( p_buffer->i_flags & BLOCK_FLAG_TYPE_I ) ) && ( p_buffer->i_dts-p_sys->i_opendts ) > p_sys->i_seglenm )
         {
             closeCurrentSegment( p_access, p_sys, false );
+            b_open = false;
+        }
+        if ( p_sys->p_httpd_host )
+        {
+            if ( p_buffer->i_buffer > 0 && !b_open )
+            {
+                p_sys->i_opendts = p_buffer->i_dts;
+                if ( openNextSegment( p_access, p_sys ) < 0 )
+                {
+                    block_ChainRelease( p_buffer );
+                    return -1;
+                }
+            }
+            if ( p_sys->b_segment_open &&
+                 httpd_LiveAppend( p_sys->pp_segments[p_sys->i_segments - 1]->p_live,
+                                   p_buffer->p_buffer, p_buffer->i_buffer ) )
+            {
+                block_ChainRelease( p_buffer );
+                return -1;
+            }
+
+            i_write += p_buffer->i_buffer;
+            block_t *p_next = p_buffer->p_next;
+            block_Release( p_buffer );
+            p_buffer = p_next;
+            continue;
         }
         if ( p_buffer->i_buffer > 0 && p_sys->i_handle < 0 )
         {
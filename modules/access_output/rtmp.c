@@ -278,10 +278,7 @@ static void Close( vlc_object_t * p_this )
     for( i = 0; i < 64; i++ ) /* RTMP_HEADER_STREAM_INDEX_MASK */
     {
         if( p_sys->p_thread->rtmp_headers_recv[i].body != NULL )
-        {
-            free( p_sys->p_thread->rtmp_headers_recv[i].body->body );
-            free( p_sys->p_thread->rtmp_headers_recv[i].body );
-        }
+            rtmp_body_free( p_sys->p_thread->rtmp_headers_recv[i].body );
     }
 
     net_Close( p_sys->p_thread->fd );
@@ -299,59 +296,33 @@ static void Close( vlc_object_t * p_this )
  *****************************************************************************/
 static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
 {
-    rtmp_packet_t *rtmp_packet;
-    uint8_t *tmp_buffer;
-    ssize_t i_ret;
+    rtmp_control_thread_t *p_thread = p_access->p_sys->p_thread;
     ssize_t i_write = 0;
 
-    if( p_access->p_sys->p_thread->first_media_packet )
+    if( p_thread->first_media_packet )
     {
         /* 13 == FLV_HEADER_SIZE + PreviousTagSize*/
-        memmove( p_buffer->p_buffer, p_buffer->p_buffer + 13, p_buffer->i_buffer - 13 );
-        p_buffer = block_Realloc( p_buffer, 0, p_buffer->i_buffer - 13 );
+        p_buffer->p_buffer += 13;
+        p_buffer->i_buffer -= 13;
 
-        p_access->p_sys->p_thread->first_media_packet = 0;
+        p_thread->first_media_packet = 0;
     }
 
     while( p_buffer )
     {
         block_t *p_next = p_buffer->p_next;
-//////////////////////////////
-/*msg_Warn(p_access, "XXXXXXXXXXXXXXXXX");
-int i;
-for(i = 0; i < p_buffer->i_buffer; i += 16)
-{
-    msg_Warn(p_access,"%.2x%.2x %.2x%.2x %.2x%.2x %.2x%.2x %.2x%.2x %.2x%.2x %.2x%.2x %.2x%.2x",
-p_buffer->p_buffer[i], p_buffer->p_buffer[i+1], p_buffer->p_buffer[i+2], p_buffer->p_buffer[i+3], p_buffer->p_buffer[i+4], p_buffer->p_buffer[i+5], p_buffer->p_buffer[i+6], p_buffer->p_buffer[i+7],
-p_buffer->p_buffer[i+8], p_buffer->p_buffer[i+9], p_buffer->p_buffer[i+10], p_buffer->p_buffer[i+11], p_buffer->p_buffer[i+12], p_buffer->p_buffer[i+13], p_buffer->p_buffer[i+14], p_buffer->p_buffer[i+15]);
-}*/
-////////////////////////
-        msg_Warn(p_access, "rtmp.c:360 i_dts %"PRIu64" i_pts %"PRIu64,
-                 p_buffer->i_dts, p_buffer->i_pts);
-        rtmp_packet = rtmp_build_flv_over_rtmp( p_access->p_sys->p_thread, p_buffer );
-
-        if( rtmp_packet )
-        {
-            tmp_buffer = rtmp_encode_packet( p_access->p_sys->p_thread, rtmp_packet );
 
-            i_ret = net_Write( p_access->p_sys->p_thread, p_access->p_sys->p_thread->fd, NULL, tmp_buffer, rtmp_packet->length_encoded );
-            if( i_ret != rtmp_packet->length_encoded )
-            {
-                free( rtmp_packet->body->body );
-                free( rtmp_packet->body );
-                free( rtmp_packet );
-                free( tmp_buffer );
-                msg_Err( p_access->p_sys->p_thread, "failed send flv packet" );
-                return -1;
-            }
-            free( rtmp_packet->body->body );
-            free( rtmp_packet->body );
-            free( rtmp_packet );
-            free( tmp_buffer );
+        /* The tags are sent from the blocks of the muxer */
+        if( rtmp_send_flv_over_rtmp( p_thread, p_buffer ) )
+        {
+            msg_Err( p_access, "failed send flv packet" );
+            block_ChainRelease( p_buffer );
+            return -1;
         }
 
         i_write += p_buffer->i_buffer;
 
+        block_Release( p_buffer );
         p_buffer = p_next;
     }
 
@@ -0,0 +1,311 @@
+/*****************************************************************************
+ * synchronicity.c: stream output to the peers of a Synchronicity viewing
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * The host of a viewing sends what it plays to the relay server, which
+ * copies it to every peer that opened syn:// (see access/synchronicity.c).
+ * Each block goes out as one frame dated with its DTS, the date it plays at
+ * here. The relay must never hold up our own playback: blocks wait for a
+ * thread of their own in a bounded queue, and are dropped when it is full or
+ * while we host no viewing.
+ */
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_sout.h>
+#include <vlc_block.h>
+#include <vlc_network.h>
+#include <vlc_playlist.h>
+
+#include <synchronicity/syn_stream.h>
+
+/* Bytes waiting for the relay before blocks are dropped */
+#define MAX_QUEUE      (4 << 20)
+/* Between two looks at the key we host, or attempts to reach the relay */
+#define CHECK_INTERVAL CLOCK_FREQ
+
+/*****************************************************************************
+ * Module descriptor
+ *****************************************************************************/
+static int  Open ( vlc_object_t * );
+static void Close( vlc_object_t * );
+
+vlc_module_begin ()
+    set_description( N_("Synchronicity stream output") )
+    set_shortname( "Synchronicity" )
+    set_category( CAT_SOUT )
+    set_subcategory( SUBCAT_SOUT_ACO )
+    set_capability( "sout access", 0 )
+    add_shortcut( "synchronicity", "syn" )
+    set_callbacks( Open, Close )
+vlc_module_end ()
+
+/*****************************************************************************
+ * Local prototypes
+ *****************************************************************************/
+static ssize_t Write( sout_access_out_t *, block_t * );
+static int Seek( sout_access_out_t *, off_t );
+static int Control( sout_access_out_t *, int, va_list );
+static void *Thread( void * );
+
+struct sout_access_out_sys_t
+{
+    char         *psz_key;      /* from dst, NULL to use the one we host */
+    block_fifo_t *p_fifo;
+    unsigned      i_dropped;
+    vlc_thread_t  thread;
+
+    /* Stream thread only */
+    int           i_handle;     /* -1 while not streaming */
+    char          psz_stream[SYN_STREAM_KEY_LENGTH + 1];
+    mtime_t       i_next_check;
+};
+
+/*****************************************************************************
+ * Open: start the stream thread, the relay is reached from there
+ *****************************************************************************/
+static int Open( vlc_object_t *p_this )
+{
+    sout_access_out_t     *p_access = (sout_access_out_t*)p_this;
+    sout_access_out_sys_t *p_sys;
+
+    if( p_access->psz_path != NULL && *p_access->psz_path &&
+        strlen( p_access->psz_path ) != SYN_STREAM_KEY_LENGTH )
+    {
+        msg_Err( p_access, "invalid key %s", p_access->psz_path );
+        return VLC_EGENERIC;
+    }
+
+    p_sys = malloc( sizeof( *p_sys ) );
+    if( unlikely(p_sys == NULL) )
+        return VLC_ENOMEM;
+
+    p_sys->psz_key = NULL;
+    if( p_access->psz_path != NULL && *p_access->psz_path )
+    {
+        p_sys->psz_key = strdup( p_access->psz_path );
+        if( unlikely(p_sys->psz_key == NULL) )
+        {
+            free( p_sys );
+            return VLC_ENOMEM;
+        }
+    }
+    p_sys->p_fifo = block_FifoNew();
+    p_sys->i_dropped = 0;
+    p_sys->i_handle = -1;
+    p_sys->psz_stream[0] = '\0';
+    p_sys->i_next_check = 0;
+    p_access->p_sys = p_sys;
+
+    if( unlikely(p_sys->p_fifo == NULL) ||
+        vlc_clone( &p_sys->thread, Thread, p_access, VLC_THREAD_PRIORITY_OUTPUT ) )
+    {
+        msg_Err( p_access, "cannot spawn sout access thread" );
+        if( p_sys->p_fifo != NULL )
+            block_FifoRelease( p_sys->p_fifo );
+        free( p_sys->psz_key );
+        free( p_sys );
+        return VLC_EGENERIC;
+    }
+
+    p_access->pf_write = Write;
+    p_access->pf_seek = Seek;
+    p_access->pf_control = Control;
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * Close: stop streaming, what is still queued is lost
+ *****************************************************************************/
+static void Close( vlc_object_t *p_this )
+{
+    sout_access_out_t     *p_access = (sout_access_out_t*)p_this;
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    vlc_cancel( p_sys->thread );
+    vlc_join( p_sys->thread, NULL );
+    block_FifoRelease( p_sys->p_fifo );
+    if( p_sys->i_handle != -1 )
+        net_Close( p_sys->i_handle );
+    if( p_sys->i_dropped > 0 )
+        msg_Dbg( p_access, "%u blocks dropped", p_sys->i_dropped );
+    free( p_sys->psz_key );
+    free( p_sys );
+}
+
+static int Control( sout_access_out_t *p_access, int i_query, va_list args )
+{
+    (void)p_access;
+
+    switch( i_query )
+    {
+        case ACCESS_OUT_CONTROLS_PACE:
+            *va_arg( args, bool * ) = false;
+            break;
+
+        default:
+            return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+static int Seek( sout_access_out_t *p_access, off_t i_pos )
+{
+    (void)i_pos;
+    msg_Err( p_access, "cannot seek a stream to the peers" );
+    return VLC_EGENERIC;
+}
+
+/* Prepends the frame header and hands the frame to the thread */
+static void Queue( sout_access_out_t *p_access, block_t *p_block,
+                   mtime_t i_date )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    size_t i_payload = p_block->i_buffer;
+
+    if( block_FifoSize( p_sys->p_fifo ) > MAX_QUEUE )
+    {
+        if( p_sys->i_dropped++ == 0 )
+            msg_Warn( p_access, "relay server too slow, dropping blocks" );
+        block_Release( p_block );
+        return;
+    }
+
+    p_block = block_Realloc( p_block, SYN_STREAM_FRAME_HEADER, i_payload );
+    if( unlikely(p_block == NULL) )
+        return;
+    SetDWBE( p_block->p_buffer, i_payload );
+    SetQWBE( p_block->p_buffer + 4, i_date );
+    block_FifoPut( p_sys->p_fifo, p_block );
+}
+
+/*****************************************************************************
+ * Write: queue the blocks as frames, splitting the largest ones
+ *****************************************************************************/
+static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
+{
+    ssize_t i_len = 0;
+
+    while( p_buffer != NULL )
+    {
+        block_t *p_next = p_buffer->p_next;
+        mtime_t i_date = p_buffer->i_dts > VLC_TS_INVALID ? p_buffer->i_dts
+                                                          : mdate();
+
+        p_buffer->p_next = NULL;
+        i_len += p_buffer->i_buffer;
+
+        while( p_buffer->i_buffer > SYN_STREAM_MAX_PAYLOAD )
+        {
+            block_t *p_part = block_Alloc( SYN_STREAM_MAX_PAYLOAD );
+            if( likely(p_part != NULL) )
+            {
+                memcpy( p_part->p_buffer, p_buffer->p_buffer,
+                        SYN_STREAM_MAX_PAYLOAD );
+                Queue( p_access, p_part, i_date );
+            }
+            p_buffer->p_buffer += SYN_STREAM_MAX_PAYLOAD;
+            p_buffer->i_buffer -= SYN_STREAM_MAX_PAYLOAD;
+        }
+        Queue( p_access, p_buffer, i_date );
+        p_buffer = p_next;
+    }
+    return i_len;
+}
+
+/* Follows the key we stream on: the one of the viewing we host, which comes
+ * and goes. Opening the stream does not take long, but is not cancelled. */
+static void Connect( sout_access_out_t *p_access )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    char psz_key[SYN_STREAM_KEY_LENGTH + 1];
+    mtime_t now = mdate();
+
+    if( now < p_sys->i_next_check )
+        return;
+    p_sys->i_next_check = now + CHECK_INTERVAL;
+
+    if( p_sys->psz_key != NULL )
+        strcpy( psz_key, p_sys->psz_key );
+    else if( playlist_SynGetStreamKey( pl_Get( p_access ), psz_key,
+                                       sizeof (psz_key) ) )
+        psz_key[0] = '\0';
+
+    if( p_sys->i_handle != -1 )
+    {
+        if( !strcmp( psz_key, p_sys->psz_stream ) )
+            return;
+        msg_Dbg( p_access, "stopped streaming to the peers of %s",
+                 p_sys->psz_stream );
+        net_Close( p_sys->i_handle );
+        p_sys->i_handle = -1;
+    }
+    if( psz_key[0] == '\0' )
+        return;
+
+    p_sys->i_handle = SynStream_Open( p_access, psz_key, true );
+    if( p_sys->i_handle != -1 )
+    {
+        strcpy( p_sys->psz_stream, psz_key );
+        msg_Dbg( p_access, "streaming to the peers of %s", psz_key );
+    }
+}
+
+static void ReleaseBlock( void *p_block )
+{
+    block_Release( p_block );
+}
+
+/*****************************************************************************
+ * Thread: send the frames to the relay while we have somewhere to send them
+ *****************************************************************************/
+static void *Thread( void *data )
+{
+    sout_access_out_t     *p_access = data;
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    for( ;; )
+    {
+        block_t *p_block = block_FifoGet( p_sys->p_fifo );
+
+        vlc_cleanup_push( ReleaseBlock, p_block );
+        int canc = vlc_savecancel();
+        Connect( p_access );
+        vlc_restorecancel( canc );
+
+        if( p_sys->i_handle != -1 &&
+            net_Write( p_access, p_sys->i_handle, NULL, p_block->p_buffer,
+                       p_block->i_buffer ) != (ssize_t)p_block->i_buffer )
+        {
+            msg_Warn( p_access, "lost the relay server" );
+            net_Close( p_sys->i_handle );
+            p_sys->i_handle = -1;
+        }
+        vlc_cleanup_run();
+    }
+    return NULL;
+}
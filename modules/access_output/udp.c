@@ -50,8 +50,33 @@
 #endif
 
 #include <vlc_network.h>
+#include <errno.h>
+
+#ifdef HAVE_SENDMMSG
+#   include <netinet/udp.h>
+#endif
+#if defined(HAVE_SENDMMSG) && defined(HAVE_LINUX_NET_TSTAMP_H)
+#   include <time.h>
+#   include <linux/net_tstamp.h>
+#   include <linux/errqueue.h>
+#   ifdef SO_TXTIME
+#       define USE_TXTIME 1
+#   endif
+#endif
 
 #define MAX_EMPTY_BLOCKS 200
+#define MAX_BATCH_BLOCKS 64
+
+/* How early packets are handed to the kernel with kernel pacing */
+#define TXTIME_LEAD      10000
+/* Interval between two pacing reports */
+#define STATS_PERIOD     (10 * CLOCK_FREQ)
+
+#ifdef UDP_SEGMENT
+/* Kernel limits for one segmentation offload send */
+#   define GSO_MAX_SEGMENTS 64
+#   define GSO_MAX_SIZE     65000
+#endif
 
 /*****************************************************************************
  * Module descriptor
@@ -73,6 +98,17 @@ static void Close( vlc_object_t * );
                           "helps reducing the scheduling load on " \
                           "heavily-loaded systems." )
 
+#define PACING_TEXT N_("Pacing")
+#define PACING_LONGTEXT N_( \
+    "Packets can be sent at their date by waking up a timer, or handed " \
+    "to the kernel ahead of time with their transmit time, which is more " \
+    "accurate on loaded systems. Kernel pacing needs the fq (monotonic " \
+    "clock) or etf (TAI clock) queuing discipline on the output interface." )
+
+static const char *const ppsz_pacing[] = { "timer", "fq", "etf" };
+static const char *const ppsz_pacing_text[] = {
+    N_("Timer"), N_("Kernel (fq)"), N_("Kernel (etf)") };
+
 vlc_module_begin ()
     set_description( N_("UDP stream output") )
     set_shortname( "UDP" )
@@ -81,6 +117,9 @@ vlc_module_begin ()
     add_integer( SOUT_CFG_PREFIX "caching", DEFAULT_PTS_DELAY / 1000, CACHING_TEXT, CACHING_LONGTEXT, true )
     add_integer( SOUT_CFG_PREFIX "group", 1, GROUP_TEXT, GROUP_LONGTEXT,
                                  true )
+    add_string( SOUT_CFG_PREFIX "pacing", "timer", PACING_TEXT,
+                PACING_LONGTEXT, true )
+        change_string_list( ppsz_pacing, ppsz_pacing_text, 0 )
 
     set_capability( "sout access", 0 )
     add_shortcut( "udp" )
@@ -94,6 +133,7 @@ vlc_module_end ()
 static const char *const ppsz_sout_options[] = {
     "caching",
     "group",
+    "pacing",
     NULL
 };
 
@@ -123,6 +163,21 @@ struct sout_access_out_sys_t
     block_fifo_t *p_empty_blocks;
     block_t      *p_buffer;
 
+#ifdef UDP_SEGMENT
+    bool          b_gso;
+#endif
+#ifdef USE_TXTIME
+    int           i_txtime_clock; /* -1 when pacing with a timer */
+#endif
+
+    /* Send time minus packet date, over the current report period */
+    mtime_t       i_stats_start;
+    unsigned      i_stats_packets;
+    unsigned      i_stats_missed;
+    mtime_t       i_stats_sum;
+    mtime_t       i_stats_min;
+    mtime_t       i_stats_max;
+
     vlc_thread_t  thread;
 };
 
@@ -207,6 +262,46 @@ static int Open( vlc_object_t *p_this )
     }
     shutdown( i_handle, SHUT_RD );
 
+#ifdef UDP_SEGMENT
+    int i_gso;
+    p_sys->b_gso = getsockopt( i_handle, IPPROTO_UDP, UDP_SEGMENT, &i_gso,
+                               &(socklen_t){ sizeof (i_gso) } ) == 0;
+    if( p_sys->b_gso )
+        msg_Dbg( p_access, "using UDP segmentation offload" );
+#endif
+
+#ifdef USE_TXTIME
+    p_sys->i_txtime_clock = -1;
+#endif
+    char *psz_pacing = var_GetNonEmptyString( p_access,
+                                              SOUT_CFG_PREFIX "pacing" );
+    if( psz_pacing != NULL && strcmp( psz_pacing, "timer" ) )
+    {
+#ifdef USE_TXTIME
+        struct sock_txtime txtime = {
+            .clockid = strcmp( psz_pacing, "etf" ) ? CLOCK_MONOTONIC
+                                                   : CLOCK_TAI,
+            .flags = SOF_TXTIME_REPORT_ERRORS,
+        };
+
+        if( setsockopt( i_handle, SOL_SOCKET, SO_TXTIME, &txtime,
+                        sizeof (txtime) ) == 0 )
+        {
+            msg_Dbg( p_access, "using kernel pacing (%s)", psz_pacing );
+            p_sys->i_txtime_clock = txtime.clockid;
+# ifdef UDP_SEGMENT
+            /* Segments of one datagram would leave at once */
+            p_sys->b_gso = false;
+# endif
+        }
+        else
+            msg_Warn( p_access, "kernel pacing not available: %m" );
+#else
+        msg_Warn( p_access, "kernel pacing not supported" );
+#endif
+    }
+    free( psz_pacing );
+
     p_sys->i_caching = UINT64_C(1000)
                      * var_GetInteger( p_access, SOUT_CFG_PREFIX "caching");
     p_sys->i_handle = i_handle;
@@ -215,6 +310,10 @@ static int Open( vlc_object_t *p_this )
     p_sys->p_fifo = block_FifoNew();
     p_sys->p_empty_blocks = block_FifoNew();
     p_sys->p_buffer = NULL;
+    p_sys->i_stats_start = 0;
+    p_sys->i_stats_packets = 0;
+    p_sys->i_stats_missed = 0;
+    p_sys->i_stats_sum = 0;
 
     if( vlc_clone( &p_sys->thread, ThreadWrite, p_access,
                            VLC_THREAD_PRIORITY_HIGHEST ) )
@@ -394,6 +493,255 @@ static block_t *NewUDPPacket( sout_access_out_t *p_access, mtime_t i_dts)
     return p_buffer;
 }
 
+/*****************************************************************************
+ * Batch: packets due for sending, written with as few system calls as possible
+ *****************************************************************************/
+typedef struct
+{
+    block_t  *pp_blocks[MAX_BATCH_BLOCKS];
+    unsigned  i_count;
+} udp_batch_t;
+
+static void BatchCleanup( void *data )
+{
+    udp_batch_t *p_batch = data;
+
+    for( unsigned i = 0; i < p_batch->i_count; i++ )
+        block_Release( p_batch->pp_blocks[i] );
+}
+
+/*****************************************************************************
+ * PacingStats: accounts how far from their date packets were sent
+ *****************************************************************************/
+static void PacingStats( sout_access_out_t *p_access, block_t *const *pp,
+                         unsigned i_count, mtime_t i_sent )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    for( unsigned i = 0; i < i_count; i++ )
+    {
+        mtime_t i_offset = i_sent - (p_sys->i_caching + pp[i]->i_dts);
+
+        if( p_sys->i_stats_packets == 0 )
+            p_sys->i_stats_min = p_sys->i_stats_max = i_offset;
+        else if( i_offset < p_sys->i_stats_min )
+            p_sys->i_stats_min = i_offset;
+        else if( i_offset > p_sys->i_stats_max )
+            p_sys->i_stats_max = i_offset;
+        p_sys->i_stats_sum += i_offset;
+        p_sys->i_stats_packets++;
+    }
+
+    if( p_sys->i_stats_start == 0 )
+        p_sys->i_stats_start = i_sent;
+    if( i_sent - p_sys->i_stats_start < STATS_PERIOD )
+        return;
+
+    const mtime_t i_avg = p_sys->i_stats_sum / p_sys->i_stats_packets;
+#ifdef USE_TXTIME
+    if( p_sys->i_txtime_clock != -1 )
+        msg_Dbg( p_access, "pacing: %u packets queued %"PRId64" us ahead "
+                 "on average, %u missed their transmit time",
+                 p_sys->i_stats_packets, -i_avg, p_sys->i_stats_missed );
+    else
+#endif
+        msg_Dbg( p_access, "pacing: %u packets %"PRId64" us late on "
+                 "average, jitter %"PRId64" us (%"PRId64" to %"PRId64")",
+                 p_sys->i_stats_packets, i_avg,
+                 p_sys->i_stats_max - p_sys->i_stats_min,
+                 p_sys->i_stats_min, p_sys->i_stats_max );
+
+    p_sys->i_stats_start = i_sent;
+    p_sys->i_stats_packets = 0;
+    p_sys->i_stats_missed = 0;
+    p_sys->i_stats_sum = 0;
+}
+
+#ifdef USE_TXTIME
+/*****************************************************************************
+ * TxTimeErrors: counts packets the kernel dropped for missing their time
+ *****************************************************************************/
+static void TxTimeErrors( sout_access_out_t *p_access )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    for( ;; )
+    {
+        union
+        {
+            char           buf[CMSG_SPACE(sizeof (struct sock_extended_err))
+                               + 64];
+            struct cmsghdr align;
+        } ctl;
+        struct msghdr msg = {
+            .msg_control = ctl.buf,
+            .msg_controllen = sizeof (ctl.buf),
+        };
+
+        if( recvmsg( p_sys->i_handle, &msg,
+                     MSG_ERRQUEUE | MSG_DONTWAIT ) == -1 )
+            break;
+
+        for( struct cmsghdr *cmsg = CMSG_FIRSTHDR( &msg ); cmsg != NULL;
+             cmsg = CMSG_NXTHDR( &msg, cmsg ) )
+        {
+            const struct sock_extended_err *err = (void *)CMSG_DATA(cmsg);
+
+            if( err->ee_origin == SO_EE_ORIGIN_TXTIME )
+                p_sys->i_stats_missed++;
+        }
+    }
+}
+#endif
+
+static void BatchSend( sout_access_out_t *p_access, udp_batch_t *p_batch )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    block_t **pp = p_batch->pp_blocks;
+    const unsigned i_count = p_batch->i_count;
+
+    if( i_count == 0 )
+        return;
+
+#ifdef HAVE_SENDMMSG
+    struct mmsghdr msgv[MAX_BATCH_BLOCKS];
+    struct iovec iov[MAX_BATCH_BLOCKS];
+# if defined(UDP_SEGMENT) || defined(USE_TXTIME)
+    union
+    {
+        char           buf[CMSG_SPACE(sizeof (uint64_t))];
+        struct cmsghdr align;
+    } ctlv[MAX_BATCH_BLOCKS];
+# endif
+# ifdef USE_TXTIME
+    int64_t i_txtime_offset = 0; /* from mdate() to the pacing clock, in ns */
+    if( p_sys->i_txtime_clock != -1 )
+    {
+        struct timespec ts;
+
+        clock_gettime( p_sys->i_txtime_clock, &ts );
+        i_txtime_offset = INT64_C(1000000000) * ts.tv_sec + ts.tv_nsec
+                        - INT64_C(1000) * mdate();
+    }
+# endif
+    unsigned i_msgs = 0;
+
+    for( unsigned i = 0; i < i_count; i_msgs++ )
+    {
+        struct msghdr *msg = &msgv[i_msgs].msg_hdr;
+        const size_t i_size = pp[i]->i_buffer;
+        size_t i_total = 0;
+
+        memset( msg, 0, sizeof (*msg) );
+        msg->msg_iov = &iov[i];
+        for( ;; )
+        {
+            iov[i].iov_base = pp[i]->p_buffer;
+            iov[i].iov_len = pp[i]->i_buffer;
+            i_total += pp[i]->i_buffer;
+            msg->msg_iovlen++;
+            i++;
+#ifdef UDP_SEGMENT
+            /* The kernel cuts the datagram into segments of the first packet
+             * size, only the last one may be shorter. */
+            if( p_sys->b_gso && i < i_count
+             && msg->msg_iovlen < GSO_MAX_SEGMENTS
+             && pp[i - 1]->i_buffer == i_size && pp[i]->i_buffer <= i_size
+             && i_total + pp[i]->i_buffer <= GSO_MAX_SIZE )
+                continue;
+#endif
+            break;
+        }
+#ifdef UDP_SEGMENT
+        if( msg->msg_iovlen > 1 )
+        {
+            uint16_t i_segment = i_size;
+            struct cmsghdr *cmsg;
+
+            msg->msg_control = ctlv[i_msgs].buf;
+            msg->msg_controllen = sizeof (ctlv[i_msgs].buf);
+            cmsg = CMSG_FIRSTHDR( msg );
+            cmsg->cmsg_level = IPPROTO_UDP;
+            cmsg->cmsg_type = UDP_SEGMENT;
+            cmsg->cmsg_len = CMSG_LEN(sizeof (i_segment));
+            memcpy( CMSG_DATA(cmsg), &i_segment, sizeof (i_segment) );
+        }
+#else
+        (void) i_size; (void) i_total;
+#endif
+#ifdef USE_TXTIME
+        if( p_sys->i_txtime_clock != -1 )
+        {
+            uint64_t i_txtime = INT64_C(1000)
+                              * (p_sys->i_caching + pp[i - 1]->i_dts)
+                              + i_txtime_offset;
+            struct cmsghdr *cmsg;
+
+            msg->msg_control = ctlv[i_msgs].buf;
+            msg->msg_controllen = CMSG_SPACE(sizeof (i_txtime));
+            cmsg = CMSG_FIRSTHDR( msg );
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_TXTIME;
+            cmsg->cmsg_len = CMSG_LEN(sizeof (i_txtime));
+            memcpy( CMSG_DATA(cmsg), &i_txtime, sizeof (i_txtime) );
+        }
+#endif
+    }
+
+    for( unsigned i = 0; i < i_msgs; )
+    {
+        int val = sendmmsg( p_sys->i_handle, &msgv[i], i_msgs - i, 0 );
+        if( val >= 0 )
+        {
+            i += val;
+            continue;
+        }
+        if( errno == EINTR )
+            continue;
+#ifdef UDP_SEGMENT
+        if( msgv[i].msg_hdr.msg_iovlen > 1 )
+        {   /* Not supported on this route (e.g. MTU or device): fall back */
+            const struct msghdr *msg = &msgv[i].msg_hdr;
+
+            msg_Warn( p_access, "segmentation offload error: %m" );
+            p_sys->b_gso = false;
+            for( size_t j = 0; j < msg->msg_iovlen; j++ )
+                if( send( p_sys->i_handle, msg->msg_iov[j].iov_base,
+                          msg->msg_iov[j].iov_len, 0 ) == -1 )
+                    msg_Warn( p_access, "send error: %m" );
+        }
+        else
+#endif
+            msg_Warn( p_access, "send error: %m" );
+        i++;
+    }
+#else
+    for( unsigned i = 0; i < i_count; i++ )
+        if( send( p_sys->i_handle, pp[i]->p_buffer, pp[i]->i_buffer, 0 ) == -1 )
+            msg_Warn( p_access, "send error: %m" );
+#endif
+
+#ifdef USE_TXTIME
+    if( p_sys->i_txtime_clock != -1 )
+        TxTimeErrors( p_access );
+#endif
+
+    mtime_t i_sent = mdate();
+#if 1
+    mtime_t i_date = p_sys->i_caching + pp[0]->i_dts;
+    if ( i_sent > i_date + 20000 )
+    {
+        msg_Dbg( p_access, "packet has been sent too late (%"PRId64 ")",
+                 i_sent - i_date );
+    }
+#endif
+    PacingStats( p_access, pp, i_count, i_sent );
+
+    for( unsigned i = 0; i < i_count; i++ )
+        block_FifoPut( p_sys->p_empty_blocks, pp[i] );
+    p_batch->i_count = 0;
+}
+
 /*****************************************************************************
  * ThreadWrite: Write a packet on the network at the good time.
  *****************************************************************************/
@@ -406,11 +754,17 @@ static void* ThreadWrite( void *data )
                                              SOUT_CFG_PREFIX "group" );
     mtime_t i_to_send = i_group;
     unsigned i_dropped_packets = 0;
+    udp_batch_t batch = { .i_count = 0 };
 
+    vlc_cleanup_push( BatchCleanup, &batch );
     for (;;)
     {
+        /* Do not hold due packets while there is nothing more to send yet */
+        if( block_FifoCount( p_sys->p_fifo ) == 0 )
+            BatchSend( p_access, &batch );
+
         block_t *p_pk = block_FifoGet( p_sys->p_fifo );
-        mtime_t       i_date, i_sent;
+        mtime_t       i_date;
 
         i_date = p_sys->i_caching + p_pk->i_dts;
         if( i_date_last > 0 )
@@ -435,35 +789,44 @@ static void* ThreadWrite( void *data )
             }
         }
 
-        block_cleanup_push( p_pk );
-        i_to_send--;
-        if( !i_to_send || (p_pk->i_flags & BLOCK_FLAG_CLOCK) )
+        mtime_t i_wait = i_date;
+        bool b_wait;
+#ifdef USE_TXTIME
+        if( p_sys->i_txtime_clock != -1 )
+        {   /* The kernel holds each packet until its transmit time */
+            i_wait -= TXTIME_LEAD;
+            b_wait = true;
+        }
+        else
+#endif
         {
-            mwait( i_date );
-            i_to_send = i_group;
+            i_to_send--;
+            b_wait = !i_to_send || (p_pk->i_flags & BLOCK_FLAG_CLOCK);
+            if( b_wait )
+                i_to_send = i_group;
         }
-        if ( send( p_sys->i_handle, p_pk->p_buffer, p_pk->i_buffer, 0 ) == -1 )
-            msg_Warn( p_access, "send error: %m" );
-        vlc_cleanup_pop();
 
-        if( i_dropped_packets )
+        /* Flush what is due before waiting, so pacing is unchanged */
+        if( b_wait && i_wait > mdate() )
         {
-            msg_Dbg( p_access, "dropped %i packets", i_dropped_packets );
-            i_dropped_packets = 0;
+            BatchSend( p_access, &batch );
+            block_cleanup_push( p_pk );
+            mwait( i_wait );
+            vlc_cleanup_pop();
         }
+        batch.pp_blocks[batch.i_count++] = p_pk;
 
-#if 1
-        i_sent = mdate();
-        if ( i_sent > i_date + 20000 )
+        if( i_dropped_packets )
         {
-            msg_Dbg( p_access, "packet has been sent too late (%"PRId64 ")",
-                     i_sent - i_date );
+            msg_Dbg( p_access, "dropped %i packets", i_dropped_packets );
+            i_dropped_packets = 0;
         }
-#endif
-
-        block_FifoPut( p_sys->p_empty_blocks, p_pk );
 
         i_date_last = i_date;
+
+        if( batch.i_count == MAX_BATCH_BLOCKS )
+            BatchSend( p_access, &batch );
     }
+    vlc_cleanup_pop();
     return NULL;
 }
@@ -0,0 +1,426 @@
+/*****************************************************************************
+ * writer.c: asynchronous file writer
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+#if defined( WIN32 ) && !defined( UNDER_CE )
+# include <io.h>
+# define lseek _lseeki64
+#endif
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+
+#include "writer.h"
+
+#define WRITER_ALIGN    4096      /* of the offsets and lengths for O_DIRECT */
+#define WRITER_BUFFER   (1 << 20) /* size of the writes */
+#define WRITER_PREALLOC (1 << 26) /* preallocation steps */
+#define WRITER_IDLE     CLOCK_FREQ /* data is not kept longer in memory */
+
+/* Queued change of offset: the offset is in i_dts */
+#define BLOCK_FLAG_SEEK (1 << BLOCK_FLAG_PRIVATE_SHIFT)
+
+struct async_writer
+{
+    vlc_object_t *obj;
+    int           fd;
+    vlc_thread_t  thread;
+
+    vlc_mutex_t   lock;
+    vlc_cond_t    wait;      /* for the writer thread */
+    vlc_cond_t    wait_room; /* for the callers */
+    block_t      *p_first;
+    block_t     **pp_last;
+    size_t        i_queued;
+    size_t        i_queue_max;
+    enum async_writer_overflow overflow;
+    unsigned      i_flush_req;
+    unsigned      i_flush_done;
+    bool          b_quit;
+    bool          b_error;
+    bool          b_dropping;
+    uint64_t      i_dropped; /* bytes */
+    unsigned      i_stalls;
+
+    /* Writer thread only */
+    uint8_t      *p_buf;     /* aligned staging buffer */
+    size_t        i_staged;
+    off_t         i_pos;     /* offset of the staging buffer in the file */
+    off_t         i_end;
+    off_t         i_allocated;
+    bool          b_seekable;
+    bool          b_prealloc;
+    bool          b_direct;
+    bool          b_direct_on;
+    bool          b_failing;
+};
+
+/* Writes some staged data */
+static void WriteRaw( async_writer_t *w, size_t i_len )
+{
+#if defined(O_DIRECT) && defined(F_SETFL)
+    /* Only aligned writes may go around the page cache */
+    bool b_direct = w->b_direct && (w->i_pos % WRITER_ALIGN) == 0
+                 && (i_len % WRITER_ALIGN) == 0;
+    if( b_direct != w->b_direct_on )
+    {
+        int flags = fcntl( w->fd, F_GETFL );
+        if( flags != -1 && fcntl( w->fd, F_SETFL,
+                b_direct ? (flags | O_DIRECT) : (flags & ~O_DIRECT) ) == 0 )
+            w->b_direct_on = b_direct;
+        else if( b_direct )
+            w->b_direct = false; /* not supported by the file system */
+    }
+#endif
+#ifdef HAVE_POSIX_FALLOCATE
+    /* Allocate ahead, so that the file is not fragmented */
+    if( w->b_prealloc && w->i_pos + (off_t)i_len > w->i_allocated )
+    {
+        if( posix_fallocate( w->fd, w->i_pos, i_len + WRITER_PREALLOC ) == 0 )
+            w->i_allocated = w->i_pos + i_len + WRITER_PREALLOC;
+        else
+            w->b_prealloc = false; /* not supported: stop trying */
+    }
+#endif
+
+    const uint8_t *p = w->p_buf;
+    size_t i_left = i_len;
+    bool b_error = false;
+
+    while( i_left > 0 )
+    {
+        ssize_t val = write( w->fd, p, i_left );
+        if( val < 0 )
+        {
+            if( errno == EINTR )
+                continue;
+            if( !w->b_failing )
+                msg_Err( w->obj, "cannot write: %m" );
+            b_error = true;
+            break;
+        }
+        p += val;
+        i_left -= val;
+    }
+
+    if( !b_error && w->b_failing )
+        msg_Err( w->obj, "writing again" );
+    w->b_failing = b_error;
+
+    w->i_pos += i_len;
+    if( w->i_pos > w->i_end )
+        w->i_end = w->i_pos;
+    w->i_staged -= i_len;
+    memmove( w->p_buf, w->p_buf + i_len, w->i_staged );
+
+    if( b_error )
+    {
+        vlc_mutex_lock( &w->lock );
+        w->b_error = true;
+        vlc_mutex_unlock( &w->lock );
+    }
+}
+
+/* Writes the staged data, but an unaligned tail unless b_all */
+static void WriteStaged( async_writer_t *w, bool b_all )
+{
+    size_t i_len = w->i_staged;
+
+    if( !b_all )
+        i_len -= (w->i_pos + i_len) % WRITER_ALIGN;
+    if( i_len > 0 && i_len <= w->i_staged )
+        WriteRaw( w, i_len );
+}
+
+static void Stage( async_writer_t *w, const block_t *p_block )
+{
+    const uint8_t *p = p_block->p_buffer;
+    size_t i_left = p_block->i_buffer;
+
+    while( i_left > 0 )
+    {
+        size_t i_copy = __MIN( i_left, WRITER_BUFFER - w->i_staged );
+
+        memcpy( w->p_buf + w->i_staged, p, i_copy );
+        w->i_staged += i_copy;
+        p += i_copy;
+        i_left -= i_copy;
+        if( w->i_staged == WRITER_BUFFER )
+            WriteStaged( w, false );
+    }
+}
+
+static void DoSeek( async_writer_t *w, off_t i_pos )
+{
+    WriteStaged( w, true );
+    if( lseek( w->fd, i_pos, SEEK_SET ) == -1 )
+    {
+        msg_Err( w->obj, "cannot seek: %m" );
+        vlc_mutex_lock( &w->lock );
+        w->b_error = true;
+        vlc_mutex_unlock( &w->lock );
+        return;
+    }
+    w->i_pos = i_pos;
+}
+
+static void *Thread( void *data )
+{
+    async_writer_t *w = data;
+    bool b_idle = false;
+
+    vlc_mutex_lock( &w->lock );
+    for( ;; )
+    {
+        block_t *p_block = w->p_first;
+
+        if( p_block == NULL )
+        {
+            bool b_all = w->i_flush_done != w->i_flush_req || w->b_quit;
+
+            if( w->i_staged > 0 && (b_all || b_idle) )
+            {
+                vlc_mutex_unlock( &w->lock );
+                WriteStaged( w, b_all );
+                vlc_mutex_lock( &w->lock );
+                b_idle = false;
+                continue;
+            }
+            if( w->i_flush_done != w->i_flush_req )
+            {
+                w->i_flush_done = w->i_flush_req;
+                vlc_cond_broadcast( &w->wait_room );
+            }
+            if( w->b_quit )
+                break;
+
+            if( w->i_staged > 0 )
+                b_idle = vlc_cond_timedwait( &w->wait, &w->lock,
+                                             mdate() + WRITER_IDLE ) != 0;
+            else
+                vlc_cond_wait( &w->wait, &w->lock );
+            continue;
+        }
+
+        w->p_first = p_block->p_next;
+        if( w->p_first == NULL )
+            w->pp_last = &w->p_first;
+        w->i_queued -= p_block->i_buffer;
+        vlc_cond_broadcast( &w->wait_room );
+        vlc_mutex_unlock( &w->lock );
+
+        if( p_block->i_flags & BLOCK_FLAG_SEEK )
+            DoSeek( w, p_block->i_dts );
+        else
+            Stage( w, p_block );
+        block_Release( p_block );
+
+        vlc_mutex_lock( &w->lock );
+    }
+    vlc_mutex_unlock( &w->lock );
+    return NULL;
+}
+
+#undef async_writer_New
+async_writer_t *async_writer_New( vlc_object_t *obj, int fd,
+                                  size_t i_queue_max,
+                                  enum async_writer_overflow overflow,
+                                  bool b_direct )
+{
+    async_writer_t *w = malloc( sizeof( *w ) );
+    if( unlikely(w == NULL) )
+        return NULL;
+
+    w->p_buf = vlc_memalign( WRITER_ALIGN, WRITER_BUFFER );
+    if( unlikely(w->p_buf == NULL) )
+    {
+        free( w );
+        return NULL;
+    }
+
+    w->obj = obj;
+    w->fd = fd;
+    vlc_mutex_init( &w->lock );
+    vlc_cond_init( &w->wait );
+    vlc_cond_init( &w->wait_room );
+    w->p_first = NULL;
+    w->pp_last = &w->p_first;
+    w->i_queued = 0;
+    w->i_queue_max = i_queue_max;
+    w->overflow = overflow;
+    w->i_flush_req = w->i_flush_done = 0;
+    w->b_quit = false;
+    w->b_error = false;
+    w->b_dropping = false;
+    w->i_dropped = 0;
+    w->i_stalls = 0;
+
+    w->i_staged = 0;
+    w->i_pos = lseek( fd, 0, SEEK_CUR );
+    w->b_seekable = w->i_pos != -1;
+    if( !w->b_seekable )
+        w->i_pos = 0; /* pipe or socket */
+    w->i_end = w->i_pos;
+    w->i_allocated = w->i_pos;
+    w->b_prealloc = w->b_seekable;
+    w->b_direct = b_direct && w->b_seekable;
+    w->b_direct_on = false;
+    w->b_failing = false;
+
+    if( vlc_clone( &w->thread, Thread, w, VLC_THREAD_PRIORITY_LOW ) )
+    {
+        vlc_cond_destroy( &w->wait_room );
+        vlc_cond_destroy( &w->wait );
+        vlc_mutex_destroy( &w->lock );
+        vlc_free( w->p_buf );
+        free( w );
+        return NULL;
+    }
+    return w;
+}
+
+void async_writer_Delete( async_writer_t *w )
+{
+    vlc_mutex_lock( &w->lock );
+    w->b_quit = true;
+    vlc_cond_signal( &w->wait );
+    vlc_mutex_unlock( &w->lock );
+    vlc_join( w->thread, NULL );
+
+#ifdef HAVE_POSIX_FALLOCATE
+    /* Give back what was preallocated but not written */
+    if( w->i_allocated > w->i_end )
+        if( ftruncate( w->fd, w->i_end ) )
+            msg_Warn( w->obj, "cannot truncate: %m" );
+#endif
+    close( w->fd );
+
+    if( w->i_dropped > 0 )
+        msg_Warn( w->obj, "%"PRIu64" bytes dropped (storage too slow)",
+                  w->i_dropped );
+    if( w->i_stalls > 0 )
+        msg_Dbg( w->obj, "waited %u times for the storage", w->i_stalls );
+
+    vlc_cond_destroy( &w->wait_room );
+    vlc_cond_destroy( &w->wait );
+    vlc_mutex_destroy( &w->lock );
+    vlc_free( w->p_buf );
+    free( w );
+}
+
+static void Enqueue( async_writer_t *w, block_t *p_block )
+{
+    *(w->pp_last) = p_block;
+    w->pp_last = &p_block->p_next;
+    w->i_queued += p_block->i_buffer;
+    vlc_cond_signal( &w->wait );
+}
+
+/* Waits until i_size bytes fit in the queue. This is a cancellation point:
+ * it is kept out of async_writer_Write() so that no local variable that
+ * changes is live across the cleanup handler. */
+static void WaitRoom( async_writer_t *w, size_t i_size )
+{
+    mutex_cleanup_push( &w->lock );
+    while( w->i_queued > 0 && w->i_queued + i_size > w->i_queue_max )
+        vlc_cond_wait( &w->wait_room, &w->lock );
+    vlc_cleanup_pop();
+}
+
+ssize_t async_writer_Write( async_writer_t *w, block_t *p_chain )
+{
+    ssize_t i_write = 0;
+
+    vlc_mutex_lock( &w->lock );
+    while( p_chain != NULL )
+    {
+        block_t *p_block = p_chain;
+
+        p_chain = p_block->p_next;
+        p_block->p_next = NULL;
+        p_block->i_flags &= ~BLOCK_FLAG_SEEK;
+
+        if( w->i_queued > 0
+         && w->i_queued + p_block->i_buffer > w->i_queue_max )
+        {
+            if( w->overflow == ASYNC_WRITER_DROP )
+            {
+                if( !w->b_dropping )
+                    msg_Err( w->obj, "storage too slow, dropping data" );
+                w->b_dropping = true;
+                w->i_dropped += p_block->i_buffer;
+                block_Release( p_block );
+                continue;
+            }
+
+            w->i_stalls++;
+            WaitRoom( w, p_block->i_buffer );
+        }
+        else if( w->b_dropping )
+        {
+            msg_Err( w->obj, "storage fast enough again" );
+            w->b_dropping = false;
+        }
+
+        i_write += p_block->i_buffer;
+        Enqueue( w, p_block );
+    }
+    if( w->b_error )
+        i_write = -1;
+    vlc_mutex_unlock( &w->lock );
+    return i_write;
+}
+
+int async_writer_Seek( async_writer_t *w, off_t i_pos )
+{
+    block_t *p_block = block_Alloc( 0 );
+    if( unlikely(p_block == NULL) )
+        return -1;
+
+    p_block->i_flags |= BLOCK_FLAG_SEEK;
+    p_block->i_dts = i_pos;
+
+    vlc_mutex_lock( &w->lock );
+    Enqueue( w, p_block );
+    vlc_mutex_unlock( &w->lock );
+    return 0;
+}
+
+int async_writer_Flush( async_writer_t *w )
+{
+    vlc_mutex_lock( &w->lock );
+    unsigned i_req = ++w->i_flush_req;
+
+    vlc_cond_signal( &w->wait );
+    mutex_cleanup_push( &w->lock );
+    while( (int)(w->i_flush_done - i_req) < 0 )
+        vlc_cond_wait( &w->wait_room, &w->lock );
+    vlc_cleanup_pop();
+    vlc_mutex_unlock( &w->lock );
+    return w->fd;
+}
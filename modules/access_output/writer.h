@@ -0,0 +1,74 @@
+/*****************************************************************************
+ * writer.h: asynchronous file writer
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_ASYNC_WRITER_H
+#define VLC_ASYNC_WRITER_H 1
+
+/*
+ * Writes blocks to a file descriptor from a thread of its own, so that a slow
+ * disk or network share does not stall the caller. The blocks are queued in
+ * memory up to a bound, then coalesced into large aligned writes.
+ */
+
+typedef struct async_writer async_writer_t;
+
+/** What to do when the queue is full */
+enum async_writer_overflow
+{
+    ASYNC_WRITER_BLOCK, /**< wait for the writer thread (backpressure) */
+    ASYNC_WRITER_DROP,  /**< drop the data */
+};
+
+/**
+ * Starts writing to a file descriptor, from its current offset.
+ * The file descriptor belongs to the writer from then on.
+ * @param i_queue_max bound of the queue, in bytes
+ * @param b_direct write around the page cache (O_DIRECT) where possible
+ */
+async_writer_t *async_writer_New( vlc_object_t *, int fd, size_t i_queue_max,
+                                  enum async_writer_overflow, bool b_direct );
+#define async_writer_New(o, fd, max, ovf, d) \
+        async_writer_New(VLC_OBJECT(o), fd, max, ovf, d)
+
+/**
+ * Writes the pending data, stops the thread and closes the file descriptor.
+ */
+void async_writer_Delete( async_writer_t * );
+
+/**
+ * Queues a chain of blocks.
+ * @return the number of bytes queued, or -1 after a write error
+ */
+ssize_t async_writer_Write( async_writer_t *, block_t * );
+
+/**
+ * Queues a change of the file offset.
+ */
+int async_writer_Seek( async_writer_t *, off_t );
+
+/**
+ * Waits until all the queued data is written. The caller may then use the
+ * file descriptor (e.g. to read it back), and must queue a seek to its
+ * offset before writing again.
+ * @return the file descriptor
+ */
+int async_writer_Flush( async_writer_t * );
+
+#endif
@@ -37,6 +37,9 @@
 #include <vlc_aout.h>
 #include <vlc_filter.h>
 #include <vlc_block.h>
+#include <vlc_fs.h>
+
+#include "../convolution.h"
 
 /*****************************************************************************
  * Local prototypes
@@ -71,6 +74,14 @@ static block_t *Convert( filter_t *, block_t * );
      "Dolby Surround encoded streams won't be decoded before being " \
      "processed by this filter. Enabling this setting is not recommended.")
 
+#define HEADPHONE_IR_TEXT N_("Impulse responses file")
+#define HEADPHONE_IR_LONGTEXT N_( \
+     "WAV file with the impulse responses from each source channel to " \
+     "the left and right ears, such as measured HRTF or room responses, " \
+     "to use instead of the built-in room model. It must have the rate " \
+     "of the stream and two channels (left ear, right ear) per source " \
+     "channel, in the order of the source channels.")
+
 vlc_module_begin ()
     set_description( N_("Headphone virtual spatialization effect") )
     set_shortname( N_("Headphone effect") )
@@ -84,6 +95,8 @@ vlc_module_begin ()
               HEADPHONE_COMPENSATE_LONGTEXT, true )
     add_bool( "headphone-dolby", false, HEADPHONE_DOLBY_TEXT,
               HEADPHONE_DOLBY_LONGTEXT, true )
+    add_loadfile( "headphone-ir", NULL, HEADPHONE_IR_TEXT,
+                  HEADPHONE_IR_LONGTEXT, true )
 
     set_capability( "audio filter", 0 )
     set_callbacks( OpenFilter, CloseFilter )
@@ -108,8 +121,14 @@ struct filter_sys_t
     uint8_t * p_overflow_buffer;
     unsigned int i_nb_atomic_operations;
     struct atomic_operation_t * p_atomic_operations;
+    convolution_t * p_convolution; /* impulse responses, if any */
 };
 
+/* Partition size of the impulse responses, also the added latency */
+#define CONVOLUTION_BLOCK 256
+/* Longest impulse responses, in seconds */
+#define CONVOLUTION_MAX_LENGTH 10
+
 /*****************************************************************************
  * Init: initialize internal data structures
  * and computes the needed atomic operations
@@ -326,6 +345,121 @@ static int Init( vlc_object_t *p_this, struct filter_sys_t * p_data
     return 0;
 }
 
+/*****************************************************************************
+ * LoadResponses: read the impulse responses from a WAV file
+ *****************************************************************************/
+static convolution_t *LoadResponses( vlc_object_t *p_this, const char *psz_path
+        , unsigned int i_nb_channels, unsigned int i_rate )
+{
+    convolution_t *p_conv = NULL;
+    float *p_samples = NULL;
+    uint8_t *p_data = NULL;
+    uint8_t hdr[12];
+    unsigned int i_format = 0, i_channels = 0, i_bits = 0;
+    uint32_t i_data = 0;
+
+    FILE *p_file = vlc_fopen( psz_path, "rb" );
+    if( p_file == NULL )
+    {
+        msg_Err( p_this, "cannot open impulse responses %s", psz_path );
+        return NULL;
+    }
+
+    if( fread( hdr, 1, 12, p_file ) != 12
+     || memcmp( hdr, "RIFF", 4 ) || memcmp( hdr + 8, "WAVE", 4 ) )
+        goto error;
+
+    /* Find the format and the data chunks */
+    for( ;; )
+    {
+        uint8_t chunk[8];
+        if( fread( chunk, 1, 8, p_file ) != 8 )
+            goto error;
+
+        uint32_t i_size = GetDWLE( chunk + 4 );
+        if( !memcmp( chunk, "fmt ", 4 ) && i_size >= 16 )
+        {
+            uint8_t fmt[16];
+            if( fread( fmt, 1, 16, p_file ) != 16 )
+                goto error;
+            i_format = GetWLE( fmt );
+            i_channels = GetWLE( fmt + 2 );
+            if( GetDWLE( fmt + 4 ) != i_rate )
+            {
+                msg_Err( p_this, "impulse responses rate (%"PRIu32" Hz) "
+                         "differs from the stream (%u Hz)", GetDWLE( fmt + 4 ),
+                         i_rate );
+                goto error;
+            }
+            i_bits = GetWLE( fmt + 14 );
+            i_size -= 16;
+        }
+        else if( !memcmp( chunk, "data", 4 ) )
+        {
+            i_data = i_size;
+            break;
+        }
+        if( fseek( p_file, (i_size + 1) & ~1, SEEK_CUR ) )
+            goto error;
+    }
+
+    if( i_channels != 2 * i_nb_channels )
+    {
+        msg_Err( p_this, "impulse responses have %u channels, %u expected",
+                 i_channels, 2 * i_nb_channels );
+        goto error;
+    }
+    if( !((i_format == 1 && i_bits == 16) || (i_format == 3 && i_bits == 32)) )
+    {
+        msg_Err( p_this, "unsupported impulse responses format" );
+        goto error;
+    }
+
+    const unsigned int i_frame_size = i_channels * i_bits / 8;
+    size_t i_length = __MIN( i_data / i_frame_size,
+                             CONVOLUTION_MAX_LENGTH * i_rate );
+    p_data = malloc( i_length * i_frame_size );
+    p_samples = malloc( i_length * sizeof(float) );
+    if( p_data == NULL || p_samples == NULL
+     || fread( p_data, i_frame_size, i_length, p_file ) != i_length )
+        goto error;
+
+    p_conv = convolution_New( CONVOLUTION_BLOCK, i_nb_channels, 2 );
+    if( p_conv == NULL )
+        goto error;
+
+    for( unsigned int i = 0; i < i_channels; i++ )
+    {
+        for( size_t j = 0; j < i_length; j++ )
+        {
+            const uint8_t *p = p_data + j * i_frame_size + i * i_bits / 8;
+            if( i_format == 1 )
+                p_samples[j] = (int16_t)GetWLE( p ) / 32768.f;
+            else
+            {
+                union { uint32_t u; float f; } u = { .u = GetDWLE( p ) };
+                p_samples[j] = u.f;
+            }
+        }
+        if( convolution_SetResponse( p_conv, i / 2, i % 2,
+                                     p_samples, i_length ) )
+        {
+            convolution_Delete( p_conv );
+            p_conv = NULL;
+            goto error;
+        }
+    }
+    msg_Dbg( p_this, "using %zu samples long impulse responses", i_length );
+
+error:
+    if( p_conv == NULL )
+        msg_Err( p_this, "cannot load impulse responses %s", psz_path );
+    free( p_samples );
+    free( p_data );
+    fclose( p_file );
+    return p_conv;
+}
+
 /*****************************************************************************
  * DoWork: convert a buffer
  *****************************************************************************/
@@ -357,6 +491,15 @@ static void DoWork( filter_t * p_filter,
     p_out = p_out_buf->p_buffer;
     i_out_size = p_out_buf->i_buffer;
 
+    if( p_sys->p_convolution != NULL )
+    {
+        if( p_in_buf->i_flags & BLOCK_FLAG_DISCONTINUITY )
+            convolution_Reset( p_sys->p_convolution );
+        convolution_Process( p_sys->p_convolution, p_in, (float *)p_out,
+                             p_in_buf->i_nb_samples );
+        return;
+    }
+
     /* Slide the overflow buffer */
     p_overflow = p_sys->p_overflow_buffer;
     i_overflow_size = p_sys->i_overflow_buffer_size;
@@ -495,8 +638,16 @@ static int OpenFilter( vlc_object_t *p_this )
     p_sys->p_overflow_buffer = NULL;
     p_sys->i_nb_atomic_operations = 0;
     p_sys->p_atomic_operations = NULL;
+    p_sys->p_convolution = NULL;
+
+    char *psz_ir = var_InheritString( p_filter, "headphone-ir" );
+    if( psz_ir != NULL && *psz_ir )
+        p_sys->p_convolution = LoadResponses( VLC_OBJECT(p_filter), psz_ir
+                , aout_FormatNbChannels( &(p_filter->fmt_in.audio) )
+                , p_filter->fmt_in.audio.i_rate );
+    free( psz_ir );
 
-    if( Init( VLC_OBJECT(p_filter), p_sys
+    if( p_sys->p_convolution == NULL && Init( VLC_OBJECT(p_filter), p_sys
                 , aout_FormatNbChannels ( &(p_filter->fmt_in.audio) )
                 , p_filter->fmt_in.audio.i_physical_channels
                 , p_filter->fmt_in.audio.i_rate ) < 0 )
@@ -518,6 +669,8 @@ static void CloseFilter( vlc_object_t *p_this )
 {
     filter_t *p_filter = (filter_t *)p_this;
 
+    if( p_filter->p_sys->p_convolution != NULL )
+        convolution_Delete( p_filter->p_sys->p_convolution );
     free( p_filter->p_sys->p_overflow_buffer );
     free( p_filter->p_sys->p_atomic_operations );
     free( p_filter->p_sys );
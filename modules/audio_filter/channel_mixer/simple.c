@@ -75,6 +75,8 @@ static block_t *Filter( filter_t *, block_t * );
 static void DoWork( filter_t * p_filter,
                     aout_buffer_t * p_in_buf, aout_buffer_t * p_out_buf )
 {
+    /* p_out_buf may be p_in_buf: an output sample is written only once the
+     * input samples at its place have been read */
     const unsigned i_input_physical = p_filter->fmt_in.audio.i_physical_channels;
 
     const bool b_input_7_0 = (i_input_physical & ~AOUT_CHAN_LFE) == AOUT_CHANS_7_0;
@@ -257,28 +259,11 @@ static block_t *Filter( filter_t *p_filter, block_t *p_block )
         return NULL;
     }
 
-    size_t i_out_size = p_block->i_nb_samples *
-      p_filter->fmt_out.audio.i_bitspersample *
-        p_filter->fmt_out.audio.i_channels / 8;
+    /* Only downmixes, each output frame fits in the place of the input
+     * frame once read: mix in place */
+    DoWork( p_filter, p_block, p_block );
 
-    block_t *p_out = filter_NewAudioBuffer( p_filter, i_out_size );
-    if( !p_out )
-    {
-        msg_Warn( p_filter, "can't get output buffer" );
-        block_Release( p_block );
-        return NULL;
-    }
-
-    p_out->i_nb_samples = p_block->i_nb_samples;
-    p_out->i_dts = p_block->i_dts;
-    p_out->i_pts = p_block->i_pts;
-    p_out->i_length = p_block->i_length;
-
-    DoWork( p_filter, p_block, p_out );
-
-    block_Release( p_block );
-
-    return p_out;
+    return p_block;
 }
 
 /*****************************************************************************
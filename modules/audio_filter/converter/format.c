@@ -38,6 +38,16 @@
 #include <vlc_aout.h>
 #include <vlc_block.h>
 #include <vlc_filter.h>
+#include <vlc_cpu.h>
+
+#if defined(CAN_COMPILE_AVX2)
+#   include <immintrin.h>
+#elif defined(HAVE_SSE2_INTRINSICS)
+#   include <emmintrin.h>
+#endif
+#if defined(__ARM_NEON__)
+#   include <arm_neon.h>
+#endif
 
 /*****************************************************************************
  * Module descriptor
@@ -316,6 +326,18 @@ static block_t *S32toS16(filter_t *filter, block_t *b)
     b->i_buffer /= 2;
     return b;
 }
+static inline int16_t Fl32toS16Sample(float f)
+{
+    /* This is walken's trick based on IEEE float format. */
+    union { float f; int32_t i; } u;
+    u.f = f + 384.0;
+    if (u.i > 0x43c07fff)
+        return 32767;
+    else if (u.i < 0x43bf8000)
+        return -32768;
+    else
+        return u.i - 0x43c00000;
+}
 static block_t *Fl32toS16(filter_t *filter, block_t *b)
 {
     VLC_UNUSED(filter);
@@ -329,15 +351,7 @@ static block_t *Fl32toS16(filter_t *filter, block_t *b)
         else *dst = *src * 32768.0;
         src++; dst++;
 #else
-        /* This is walken's trick based on IEEE float format. */
-        union { float f; int32_t i; } u;
-        u.f = *src++ + 384.0;
-        if (u.i > 0x43c07fff)
-            *dst++ = 32767;
-        else if (u.i < 0x43bf8000)
-            *dst++ = -32768;
-        else
-            *dst++ = u.i - 0x43c00000;
+        *dst++ = Fl32toS16Sample(*src++);
 #endif
     }
 
@@ -479,6 +493,228 @@ static void S24toFl32(block_t *bdst, const block_t *bsrc)
     }
 }
 
+/* SIMD versions of the most used conversions. They give the same samples
+ * as the C versions, and convert the last few samples with them. */
+#if defined(HAVE_SSE2_INTRINSICS)
+VLC_SSE2
+static block_t *Fl32toS16SSE2(filter_t *filter, block_t *b)
+{
+    VLC_UNUSED(filter);
+    const float *src = (const float *)b->p_buffer;
+    int16_t     *dst = (int16_t *)b->p_buffer;
+    const size_t n = b->i_buffer / 4;
+    const __m128 scale = _mm_set1_ps(32768.f);
+    const __m128 max   = _mm_set1_ps(32767.f);
+    const __m128 min   = _mm_set1_ps(-32768.f);
+    size_t i = 0;
+
+    /* Rounds to nearest even like the C version, the clipping before the
+     * conversion avoids the integer overflow of very large samples */
+    for (; i + 8 <= n; i += 8) {
+        __m128 lo = _mm_mul_ps(_mm_loadu_ps(&src[i]), scale);
+        __m128 hi = _mm_mul_ps(_mm_loadu_ps(&src[i + 4]), scale);
+        lo = _mm_max_ps(_mm_min_ps(lo, max), min);
+        hi = _mm_max_ps(_mm_min_ps(hi, max), min);
+        /* In place, the output is behind the input already read */
+        _mm_storeu_si128((__m128i *)&dst[i],
+                         _mm_packs_epi32(_mm_cvtps_epi32(lo),
+                                         _mm_cvtps_epi32(hi)));
+    }
+
+    for (; i < n; i++)
+        dst[i] = Fl32toS16Sample(src[i]);
+    b->i_buffer /= 2;
+    return b;
+}
+
+VLC_SSE2
+static block_t *S32toFl32SSE2(filter_t *filter, block_t *b)
+{
+    VLC_UNUSED(filter);
+    int32_t *src = (int32_t *)b->p_buffer;
+    float   *dst = (float *)src;
+    const size_t n = b->i_buffer / 4;
+    const __m128 scale = _mm_set1_ps(1.f / 2147483648.f);
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)&src[i]);
+        _mm_storeu_ps(&dst[i], _mm_mul_ps(_mm_cvtepi32_ps(v), scale));
+    }
+    for (; i < n; i++)
+        dst[i] = (float)src[i] / 2147483648.0;
+    return b;
+}
+
+VLC_SSE2
+static block_t *Fi32toFl32SSE2(filter_t *filter, block_t *b)
+{
+    VLC_UNUSED(filter);
+    vlc_fixed_t *src = (vlc_fixed_t *)b->p_buffer;
+    float       *dst = (float *)src;
+    const size_t n = b->i_buffer / 4;
+    const __m128 scale = _mm_set1_ps(1.f / FIXED32_ONE);
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)&src[i]);
+        _mm_storeu_ps(&dst[i], _mm_mul_ps(_mm_cvtepi32_ps(v), scale));
+    }
+    for (; i < n; i++)
+        dst[i] = src[i] / (float)FIXED32_ONE;
+    return b;
+}
+
+VLC_SSE2
+static void S16toFl32SSE2(block_t *bdst, const block_t *bsrc)
+{
+    const int16_t *src = (const int16_t *)bsrc->p_buffer;
+    float         *dst = (float *)bdst->p_buffer;
+    const size_t n = bsrc->i_buffer / 2;
+    const __m128 scale = _mm_set1_ps(1.f / 32768.f);
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __m128i v  = _mm_loadu_si128((const __m128i *)&src[i]);
+        /* sign extension */
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(&dst[i],     _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(&dst[i + 4], _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+    for (; i < n; i++)
+        dst[i] = (float)src[i] / 32768.f;
+}
+
+VLC_SSE2
+static void S16toS32SSE2(block_t *bdst, const block_t *bsrc)
+{
+    const int16_t *src = (const int16_t *)bsrc->p_buffer;
+    int32_t       *dst = (int32_t *)bdst->p_buffer;
+    const size_t n = bsrc->i_buffer / 2;
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *)&src[i]);
+        _mm_storeu_si128((__m128i *)&dst[i],     _mm_unpacklo_epi16(zero, v));
+        _mm_storeu_si128((__m128i *)&dst[i + 4], _mm_unpackhi_epi16(zero, v));
+    }
+    for (; i < n; i++)
+        dst[i] = src[i] << 16;
+}
+#endif
+
+#if defined(CAN_COMPILE_AVX2)
+VLC_AVX2
+static block_t *Fl32toS16AVX2(filter_t *filter, block_t *b)
+{
+    VLC_UNUSED(filter);
+    const float *src = (const float *)b->p_buffer;
+    int16_t     *dst = (int16_t *)b->p_buffer;
+    const size_t n = b->i_buffer / 4;
+    const __m256 scale = _mm256_set1_ps(32768.f);
+    const __m256 max   = _mm256_set1_ps(32767.f);
+    const __m256 min   = _mm256_set1_ps(-32768.f);
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16) {
+        __m256 lo = _mm256_mul_ps(_mm256_loadu_ps(&src[i]), scale);
+        __m256 hi = _mm256_mul_ps(_mm256_loadu_ps(&src[i + 8]), scale);
+        lo = _mm256_max_ps(_mm256_min_ps(lo, max), min);
+        hi = _mm256_max_ps(_mm256_min_ps(hi, max), min);
+        /* the pack works within each 128-bit lane */
+        __m256i v = _mm256_packs_epi32(_mm256_cvtps_epi32(lo),
+                                       _mm256_cvtps_epi32(hi));
+        _mm256_storeu_si256((__m256i *)&dst[i],
+                            _mm256_permute4x64_epi64(v, 0xd8));
+    }
+
+    for (; i < n; i++)
+        dst[i] = Fl32toS16Sample(src[i]);
+    b->i_buffer /= 2;
+    return b;
+}
+
+VLC_AVX2
+static block_t *S32toFl32AVX2(filter_t *filter, block_t *b)
+{
+    VLC_UNUSED(filter);
+    int32_t *src = (int32_t *)b->p_buffer;
+    float   *dst = (float *)src;
+    const size_t n = b->i_buffer / 4;
+    const __m256 scale = _mm256_set1_ps(1.f / 2147483648.f);
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)&src[i]);
+        _mm256_storeu_ps(&dst[i], _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale));
+    }
+    for (; i < n; i++)
+        dst[i] = (float)src[i] / 2147483648.0;
+    return b;
+}
+
+VLC_AVX2
+static void S16toFl32AVX2(block_t *bdst, const block_t *bsrc)
+{
+    const int16_t *src = (const int16_t *)bsrc->p_buffer;
+    float         *dst = (float *)bdst->p_buffer;
+    const size_t n = bsrc->i_buffer / 2;
+    const __m256 scale = _mm256_set1_ps(1.f / 32768.f);
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16) {
+        __m128i lo = _mm_loadu_si128((const __m128i *)&src[i]);
+        __m128i hi = _mm_loadu_si128((const __m128i *)&src[i + 8]);
+        _mm256_storeu_ps(&dst[i],
+                         _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(lo)),
+                                       scale));
+        _mm256_storeu_ps(&dst[i + 8],
+                         _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(hi)),
+                                       scale));
+    }
+    for (; i < n; i++)
+        dst[i] = (float)src[i] / 32768.f;
+}
+#endif
+
+#if defined(__ARM_NEON__)
+static block_t *S32toFl32NEON(filter_t *filter, block_t *b)
+{
+    VLC_UNUSED(filter);
+    int32_t *src = (int32_t *)b->p_buffer;
+    float   *dst = (float *)src;
+    const size_t n = b->i_buffer / 4;
+    size_t i = 0;
+
+    /* exact, the conversion from fixed point scales by a power of 2 */
+    for (; i + 4 <= n; i += 4)
+        vst1q_f32(&dst[i], vcvtq_n_f32_s32(vld1q_s32(&src[i]), 31));
+    for (; i < n; i++)
+        dst[i] = (float)src[i] / 2147483648.0;
+    return b;
+}
+
+static void S16toFl32NEON(block_t *bdst, const block_t *bsrc)
+{
+    const int16_t *src = (const int16_t *)bsrc->p_buffer;
+    float         *dst = (float *)bdst->p_buffer;
+    const size_t n = bsrc->i_buffer / 2;
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        int16x8_t v = vld1q_s16(&src[i]);
+        vst1q_f32(&dst[i],
+                  vcvtq_n_f32_s32(vmovl_s16(vget_low_s16(v)), 15));
+        vst1q_f32(&dst[i + 4],
+                  vcvtq_n_f32_s32(vmovl_s16(vget_high_s16(v)), 15));
+    }
+    for (; i < n; i++)
+        dst[i] = (float)src[i] / 32768.f;
+}
+#endif
+
 /* */
 static void Swap64(block_t *b)
 {
@@ -543,6 +779,28 @@ static const struct {
     { 0, 0, NULL }
 };
 
+/* Tried first, if the CPU supports them */
+static const struct {
+    vlc_fourcc_t src;
+    vlc_fourcc_t dst;
+    cvt_direct_t convert;
+    unsigned     cpu;
+} cvt_directs_simd[] = {
+#if defined(CAN_COMPILE_AVX2)
+    { VLC_CODEC_FL32, VLC_CODEC_S16N,   Fl32toS16AVX2,  CPU_CAPABILITY_AVX2 },
+    { VLC_CODEC_S32N, VLC_CODEC_FL32,   S32toFl32AVX2,  CPU_CAPABILITY_AVX2 },
+#endif
+#if defined(HAVE_SSE2_INTRINSICS)
+    { VLC_CODEC_FL32, VLC_CODEC_S16N,   Fl32toS16SSE2,  CPU_CAPABILITY_SSE2 },
+    { VLC_CODEC_S32N, VLC_CODEC_FL32,   S32toFl32SSE2,  CPU_CAPABILITY_SSE2 },
+    { VLC_CODEC_FI32, VLC_CODEC_FL32,   Fi32toFl32SSE2, CPU_CAPABILITY_SSE2 },
+#endif
+#if defined(__ARM_NEON__)
+    { VLC_CODEC_S32N, VLC_CODEC_FL32,   S32toFl32NEON,  CPU_CAPABILITY_NEON },
+#endif
+    { 0, 0, NULL, 0 }
+};
+
 static const struct {
     vlc_fourcc_t   src;
     vlc_fourcc_t   dst;
@@ -561,6 +819,24 @@ static const struct {
     { VLC_CODEC_U8,   VLC_CODEC_S16N, U8toS16 },
     { 0, 0, NULL }
 };
+static const struct {
+    vlc_fourcc_t   src;
+    vlc_fourcc_t   dst;
+    cvt_indirect_t convert;
+    unsigned       cpu;
+} cvt_indirects_simd[] = {
+#if defined(CAN_COMPILE_AVX2)
+    { VLC_CODEC_S16N, VLC_CODEC_FL32, S16toFl32AVX2, CPU_CAPABILITY_AVX2 },
+#endif
+#if defined(HAVE_SSE2_INTRINSICS)
+    { VLC_CODEC_S16N, VLC_CODEC_FL32, S16toFl32SSE2, CPU_CAPABILITY_SSE2 },
+    { VLC_CODEC_S16N, VLC_CODEC_S32N, S16toS32SSE2,  CPU_CAPABILITY_SSE2 },
+#endif
+#if defined(__ARM_NEON__)
+    { VLC_CODEC_S16N, VLC_CODEC_FL32, S16toFl32NEON, CPU_CAPABILITY_NEON },
+#endif
+    { 0, 0, NULL, 0 }
+};
 static const struct {
     vlc_fourcc_t a;
     vlc_fourcc_t b;
@@ -579,6 +855,12 @@ static const struct {
 
 static cvt_direct_t FindDirect(vlc_fourcc_t src, vlc_fourcc_t dst)
 {
+    for (int i = 0; cvt_directs_simd[i].convert; i++) {
+        if (cvt_directs_simd[i].src == src &&
+            cvt_directs_simd[i].dst == dst &&
+            (vlc_CPU() & cvt_directs_simd[i].cpu))
+            return cvt_directs_simd[i].convert;
+    }
     for (int i = 0; cvt_directs[i].convert; i++) {
         if (cvt_directs[i].src == src &&
             cvt_directs[i].dst == dst)
@@ -588,6 +870,12 @@ static cvt_direct_t FindDirect(vlc_fourcc_t src, vlc_fourcc_t dst)
 }
 static cvt_indirect_t FindIndirect(vlc_fourcc_t src, vlc_fourcc_t dst)
 {
+    for (int i = 0; cvt_indirects_simd[i].convert; i++) {
+        if (cvt_indirects_simd[i].src == src &&
+            cvt_indirects_simd[i].dst == dst &&
+            (vlc_CPU() & cvt_indirects_simd[i].cpu))
+            return cvt_indirects_simd[i].convert;
+    }
     for (int i = 0; cvt_indirects[i].convert; i++) {
         if (cvt_indirects[i].src == src &&
             cvt_indirects[i].dst == dst)
@@ -57,6 +57,10 @@ struct filter_sys_t
     struct mad_synth  mad_synth;
 
     int               i_reject_count;
+
+    /* decoding speed */
+    mtime_t           i_decode_time;
+    uint64_t          i_decoded; /* samples per channel */
 };
 
 /*****************************************************************************
@@ -192,6 +196,8 @@ static int OpenFilter( vlc_object_t *p_this )
     if( p_sys == NULL )
         return -1;
     p_sys->i_reject_count = 0;
+    p_sys->i_decode_time = 0;
+    p_sys->i_decoded = 0;
 
     p_filter->pf_audio_filter = Convert;
 
@@ -217,6 +223,16 @@ static void CloseFilter( vlc_object_t *p_this )
     filter_t *p_filter = (filter_t *)p_this;
     filter_sys_t *p_sys = p_filter->p_sys;
 
+    if( p_sys->i_decode_time > 0 )
+    {
+        mtime_t i_duration = p_sys->i_decoded * CLOCK_FREQ
+                           / p_filter->fmt_in.audio.i_rate;
+        msg_Dbg( p_filter, "decoded %"PRIu64" samples in %"PRId64" ms, "
+                 "%.1fx real time", p_sys->i_decoded,
+                 p_sys->i_decode_time / 1000,
+                 (double)i_duration / p_sys->i_decode_time );
+    }
+
     mad_synth_finish( &p_sys->mad_synth );
     mad_frame_finish( &p_sys->mad_frame );
     mad_stream_finish( &p_sys->mad_stream );
@@ -249,7 +265,10 @@ static block_t *Convert( filter_t *p_filter, block_t *p_block )
     p_out->i_pts = p_block->i_pts;
     p_out->i_length = p_block->i_length;
 
+    mtime_t i_start = mdate();
     DoWork( p_filter, p_block, p_out );
+    p_filter->p_sys->i_decode_time += mdate() - i_start;
+    p_filter->p_sys->i_decoded += p_block->i_nb_samples;
 
     block_Release( p_block );
 
@@ -0,0 +1,497 @@
+/*****************************************************************************
+ * tospdif.c : encapsulates compressed audio frames into IEC 61937 bursts
+ *****************************************************************************
+ * Copyright (C) 2002, 2006, 2026 VLC authors and VideoLAN
+ *
+ * Authors: Christophe Massiot <massiot@via.ecp.fr>
+ *          Stéphane Borel <stef@via.ecp.fr>
+ *          Jon Lech Johansen <jon-vl@nanocrew.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+
+#include <vlc_aout.h>
+#include <vlc_filter.h>
+
+/*****************************************************************************
+ * Local structures
+ *****************************************************************************/
+/* IEC 61937 burst header (Pa, Pb, Pc, Pd) */
+#define SPDIF_HEADER_SIZE 8
+
+/* Burst data types (Pc) */
+#define IEC61937_AC3        0x01
+#define IEC61937_DTS1       0x0B
+#define IEC61937_DTS2       0x0C
+#define IEC61937_DTS3       0x0D
+#define IEC61937_EAC3       0x15
+#define IEC61937_TRUEHD     0x16
+
+/* E-AC3 bursts hold 6 blocks of 256 samples at four times the sample rate */
+#define EAC3_BURST_SAMPLES  1536
+#define EAC3_BURST_SIZE     (4 * AOUT_SPDIF_SIZE)
+
+/* TrueHD bursts are MAT frames of 24 access units, for HDMI only */
+#define MAT_BURST_SIZE      61440
+#define MAT_FRAME_SIZE      61424
+#define MAT_UNITS           24
+#define MAT_UNIT_SIZE       2560
+#define MAT_MIDDLE_OFFSET   (-4)
+
+/* DTS frames are sent by groups of 3, as A/52 frames hold 3 times as many
+ * samples as the shortest DTS frames */
+#define DTS_FRAMES          3
+
+struct filter_sys_t
+{
+    /* Burst being assembled, allocated once per burst */
+    block_t *p_out_buf;
+    size_t i_out_offset;
+    unsigned i_frames; /* frames or access units in the burst */
+    unsigned i_samples; /* input samples in the burst */
+    size_t i_frame_size; /* DTS frame size of the current group */
+};
+
+static const uint8_t mat_start_code[20] = {
+    0x07, 0x9E, 0x00, 0x03, 0x84, 0x01, 0x01, 0x01, 0x80, 0x00,
+    0x56, 0xA5, 0x3B, 0xF4, 0x81, 0x83, 0x49, 0x80, 0x77, 0xE0 };
+static const uint8_t mat_middle_code[12] = {
+    0xC3, 0xC1, 0x42, 0x49, 0x3B, 0xFA, 0x82, 0x83, 0x49, 0x80, 0x77, 0xE0 };
+static const uint8_t mat_end_code[16] = {
+    0xC3, 0xC2, 0xC0, 0xC4, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x97, 0x11, 0x00, 0x00, 0x00, 0x00 };
+
+/*****************************************************************************
+ * Local prototypes
+ *****************************************************************************/
+static int  Create    ( vlc_object_t * );
+static void Close     ( vlc_object_t * );
+static block_t *DoWorkA52   ( filter_t *, block_t * );
+static block_t *DoWorkEAC3  ( filter_t *, block_t * );
+static block_t *DoWorkDTS   ( filter_t *, block_t * );
+static block_t *DoWorkTrueHD( filter_t *, block_t * );
+
+/*****************************************************************************
+ * Module descriptor
+ *****************************************************************************/
+vlc_module_begin ()
+    set_category( CAT_AUDIO )
+    set_subcategory( SUBCAT_AUDIO_MISC )
+    set_description( N_("Audio filter for A/52, E-AC3, DTS and TrueHD "
+                        "->S/PDIF encapsulation") )
+    set_capability( "audio filter", 10 )
+    set_callbacks( Create, Close )
+vlc_module_end ()
+
+/*****************************************************************************
+ * Create:
+ *****************************************************************************/
+static int Create( vlc_object_t *p_this )
+{
+    filter_t * p_filter = (filter_t *)p_this;
+    const audio_format_t *p_in = &p_filter->fmt_in.audio;
+    const audio_format_t *p_out = &p_filter->fmt_out.audio;
+
+    if( p_out->i_format != VLC_CODEC_SPDIFL &&
+        p_out->i_format != VLC_CODEC_SPDIFB )
+        return VLC_EGENERIC;
+
+    switch( p_in->i_format )
+    {
+        case VLC_CODEC_A52:
+            p_filter->pf_audio_filter = DoWorkA52;
+            break;
+        case VLC_CODEC_DTS:
+            p_filter->pf_audio_filter = DoWorkDTS;
+            break;
+        case VLC_CODEC_EAC3:
+            /* High bitrate bursts need a four times faster link */
+            if( p_out->i_rate != 4 * p_in->i_rate )
+                return VLC_EGENERIC;
+            p_filter->pf_audio_filter = DoWorkEAC3;
+            break;
+        case VLC_CODEC_TRUEHD:
+            /* MAT frames need an 8 channels 192 kHz (HDMI) link, and last
+             * 24 access units only for the 48 kHz family */
+            if( p_out->i_rate != 192000
+             || aout_FormatNbChannels( p_out ) != 8
+             || 192000 % p_in->i_rate )
+                return VLC_EGENERIC;
+            p_filter->pf_audio_filter = DoWorkTrueHD;
+            break;
+        default:
+            return VLC_EGENERIC;
+    }
+
+    filter_sys_t *p_sys = malloc( sizeof(*p_sys) );
+    if( unlikely(p_sys == NULL) )
+        return VLC_ENOMEM;
+    p_sys->p_out_buf = NULL;
+    p_sys->i_out_offset = 0;
+    p_sys->i_frames = 0;
+    p_sys->i_samples = 0;
+    p_sys->i_frame_size = 0;
+    p_filter->p_sys = p_sys;
+
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * Close: free our resources
+ *****************************************************************************/
+static void Close( vlc_object_t * p_this )
+{
+    filter_t * p_filter = (filter_t *)p_this;
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( p_sys->p_out_buf != NULL )
+        block_Release( p_sys->p_out_buf );
+    free( p_sys );
+}
+
+/*****************************************************************************
+ * Helpers
+ *****************************************************************************/
+static inline bool IsLittleEndian( filter_t *p_filter )
+{
+    return p_filter->fmt_out.audio.i_format == VLC_CODEC_SPDIFL;
+}
+
+/**
+ * Writes the burst preamble. Pa and Pb are the sync words, Pc the data type
+ * and Pd the payload length (in bits or bytes depending on the type).
+ */
+static void WriteHeader( filter_t *p_filter, uint8_t *p_out,
+                         uint16_t i_type, uint16_t i_length )
+{
+    if( IsLittleEndian( p_filter ) )
+    {
+        SetWLE( p_out + 0, 0xF872 );
+        SetWLE( p_out + 2, 0x4E1F );
+        SetWLE( p_out + 4, i_type );
+        SetWLE( p_out + 6, i_length );
+    }
+    else
+    {
+        SetWBE( p_out + 0, 0xF872 );
+        SetWBE( p_out + 2, 0x4E1F );
+        SetWBE( p_out + 4, i_type );
+        SetWBE( p_out + 6, i_length );
+    }
+}
+
+/**
+ * Copies a big endian bitstream into the burst payload. An odd size is
+ * padded with one zero byte.
+ */
+static void WritePayload( filter_t *p_filter, uint8_t *p_out,
+                          const uint8_t *p_in, size_t i_size )
+{
+    if( !IsLittleEndian( p_filter ) )
+    {
+        memcpy( p_out, p_in, i_size );
+        if( i_size & 1 )
+            p_out[i_size] = 0;
+        return;
+    }
+
+    swab( p_in, p_out, i_size & ~1 );
+    if( i_size & 1 )
+    {
+        p_out[i_size - 1] = 0;
+        p_out[i_size] = p_in[i_size - 1];
+    }
+}
+
+/**
+ * Returns the number of output frames in a burst.
+ */
+static unsigned BurstSamples( filter_t *p_filter, size_t i_size )
+{
+    const audio_format_t *p_out = &p_filter->fmt_out.audio;
+
+    return i_size * p_out->i_frame_length / p_out->i_bytes_per_frame;
+}
+
+/**
+ * Starts assembling a new burst in a buffer of the final size.
+ */
+static block_t *BurstNew( filter_t *p_filter, block_t *p_in_buf,
+                          size_t i_size )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    block_t *p_out_buf = block_Alloc( i_size );
+    if( unlikely(p_out_buf == NULL) )
+        return NULL;
+    memset( p_out_buf->p_buffer, 0, i_size );
+    p_out_buf->i_pts = p_out_buf->i_dts = p_in_buf->i_pts;
+    p_out_buf->i_nb_samples = BurstSamples( p_filter, i_size );
+
+    p_sys->p_out_buf = p_out_buf;
+    p_sys->i_out_offset = SPDIF_HEADER_SIZE;
+    p_sys->i_frames = 0;
+    p_sys->i_samples = 0;
+    return p_out_buf;
+}
+
+/**
+ * Hands the completed burst over.
+ */
+static block_t *BurstPop( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    block_t *p_out_buf = p_sys->p_out_buf;
+
+    p_out_buf->i_length = (mtime_t)p_sys->i_samples * CLOCK_FREQ
+                        / p_filter->fmt_in.audio.i_rate;
+    p_sys->p_out_buf = NULL;
+    p_sys->i_frames = 0;
+    p_sys->i_samples = 0;
+    return p_out_buf;
+}
+
+static void BurstReset( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( p_sys->p_out_buf != NULL )
+    {
+        block_Release( p_sys->p_out_buf );
+        p_sys->p_out_buf = NULL;
+    }
+    p_sys->i_frames = 0;
+    p_sys->i_samples = 0;
+}
+
+/*****************************************************************************
+ * DoWorkA52: encapsulate an A/52 frame
+ *****************************************************************************
+ * One frame fills one burst. The frame is framed in place: the audio output
+ * core allocates pass-through buffers large enough for a whole burst.
+ *****************************************************************************/
+static block_t *DoWorkA52( filter_t *p_filter, block_t *p_in_buf )
+{
+    const size_t i_size = p_in_buf->i_buffer;
+
+    if( i_size < 6 || i_size > AOUT_SPDIF_SIZE - SPDIF_HEADER_SIZE )
+    {
+        block_Release( p_in_buf );
+        return NULL;
+    }
+
+    const uint8_t bsmod = p_in_buf->p_buffer[5] & 0x7;
+    block_t *p_out_buf = block_Realloc( p_in_buf, SPDIF_HEADER_SIZE,
+                                        AOUT_SPDIF_SIZE - SPDIF_HEADER_SIZE );
+    if( unlikely(p_out_buf == NULL) )
+        return NULL;
+
+    uint8_t *p_out = p_out_buf->p_buffer;
+    uint8_t *p_data = p_out + SPDIF_HEADER_SIZE;
+
+    WriteHeader( p_filter, p_out, IEC61937_AC3 | (bsmod << 8), i_size * 8 );
+    if( IsLittleEndian( p_filter ) )
+        for( size_t i = 0; i + 1 < i_size; i += 2 )
+        {
+            const uint8_t b = p_data[i];
+            p_data[i] = p_data[i + 1];
+            p_data[i + 1] = b;
+        }
+    memset( p_data + i_size, 0, AOUT_SPDIF_SIZE - SPDIF_HEADER_SIZE - i_size );
+
+    p_out_buf->i_nb_samples = BurstSamples( p_filter, AOUT_SPDIF_SIZE );
+    return p_out_buf;
+}
+
+/*****************************************************************************
+ * DoWorkEAC3: accumulate E-AC3 frames until a burst holds 6 blocks
+ *****************************************************************************/
+static block_t *DoWorkEAC3( filter_t *p_filter, block_t *p_in_buf )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    block_t *p_out_buf = NULL;
+
+    if( p_in_buf->i_flags & BLOCK_FLAG_DISCONTINUITY )
+        BurstReset( p_filter );
+
+    if( p_sys->p_out_buf == NULL
+     && BurstNew( p_filter, p_in_buf, EAC3_BURST_SIZE ) == NULL )
+        goto out;
+
+    const size_t i_size = p_in_buf->i_buffer;
+    if( p_sys->i_out_offset + i_size + 1 > EAC3_BURST_SIZE )
+    {
+        msg_Warn( p_filter, "E-AC3 burst overflow, dropping" );
+        BurstReset( p_filter );
+        goto out;
+    }
+
+    WritePayload( p_filter, p_sys->p_out_buf->p_buffer + p_sys->i_out_offset,
+                  p_in_buf->p_buffer, i_size );
+    p_sys->i_out_offset += (i_size + 1) & ~1;
+    p_sys->i_samples += p_in_buf->i_nb_samples;
+
+    if( p_sys->i_samples < EAC3_BURST_SAMPLES )
+        goto out;
+
+    WriteHeader( p_filter, p_sys->p_out_buf->p_buffer, IEC61937_EAC3,
+                 p_sys->i_out_offset - SPDIF_HEADER_SIZE );
+    p_out_buf = BurstPop( p_filter );
+out:
+    block_Release( p_in_buf );
+    return p_out_buf;
+}
+
+/*****************************************************************************
+ * DoWorkTrueHD: pack 24 TrueHD access units into a MAT frame
+ *****************************************************************************/
+static block_t *DoWorkTrueHD( filter_t *p_filter, block_t *p_in_buf )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    block_t *p_out_buf = NULL;
+
+    if( p_in_buf->i_flags & BLOCK_FLAG_DISCONTINUITY )
+        BurstReset( p_filter );
+
+    if( p_sys->p_out_buf == NULL
+     && BurstNew( p_filter, p_in_buf, MAT_BURST_SIZE ) == NULL )
+        goto out;
+
+    /* Each access unit has a fixed slot. The MAT codes take the beginning
+     * of the first one, the middle of the frame and the end of the last
+     * one. */
+    uint8_t *p_out = p_sys->p_out_buf->p_buffer;
+    const unsigned i_unit = p_sys->i_frames;
+    size_t i_start = i_unit * MAT_UNIT_SIZE;
+    size_t i_end = i_start + MAT_UNIT_SIZE;
+
+    if( i_unit == 0 )
+        i_start += SPDIF_HEADER_SIZE + sizeof(mat_start_code);
+    else if( i_unit == MAT_UNITS / 2 - 1 )
+        i_end += MAT_MIDDLE_OFFSET;
+    else if( i_unit == MAT_UNITS / 2 )
+        i_start += MAT_MIDDLE_OFFSET + sizeof(mat_middle_code);
+    else if( i_unit == MAT_UNITS - 1 )
+        i_end = SPDIF_HEADER_SIZE + MAT_FRAME_SIZE - sizeof(mat_end_code);
+
+    const size_t i_size = p_in_buf->i_buffer;
+    if( i_start + i_size > i_end )
+    {
+        msg_Warn( p_filter, "TrueHD access unit too large (%zu bytes), "
+                  "dropping", i_size );
+        BurstReset( p_filter );
+        goto out;
+    }
+
+    WritePayload( p_filter, p_out + i_start, p_in_buf->p_buffer, i_size );
+    p_sys->i_samples += p_in_buf->i_nb_samples;
+
+    if( ++p_sys->i_frames < MAT_UNITS )
+        goto out;
+
+    WritePayload( p_filter, p_out + SPDIF_HEADER_SIZE, mat_start_code,
+                  sizeof(mat_start_code) );
+    WritePayload( p_filter,
+                  p_out + (MAT_UNITS / 2) * MAT_UNIT_SIZE + MAT_MIDDLE_OFFSET,
+                  mat_middle_code, sizeof(mat_middle_code) );
+    WritePayload( p_filter, p_out + SPDIF_HEADER_SIZE + MAT_FRAME_SIZE
+                            - sizeof(mat_end_code),
+                  mat_end_code, sizeof(mat_end_code) );
+    WriteHeader( p_filter, p_out, IEC61937_TRUEHD, MAT_FRAME_SIZE );
+    p_out_buf = BurstPop( p_filter );
+out:
+    block_Release( p_in_buf );
+    return p_out_buf;
+}
+
+/*****************************************************************************
+ * DoWorkDTS: encapsulate groups of 3 DTS frames
+ *****************************************************************************/
+static block_t *DoWorkDTS( filter_t *p_filter, block_t *p_in_buf )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    block_t *p_out_buf = NULL;
+    const size_t i_length = p_in_buf->i_buffer;
+    const size_t i_fz = p_in_buf->i_nb_samples * 4;
+    uint16_t i_type;
+
+    switch( p_in_buf->i_nb_samples )
+    {
+        case  512: i_type = IEC61937_DTS1; break;
+        case 1024: i_type = IEC61937_DTS2; break;
+        case 2048: i_type = IEC61937_DTS3; break;
+        default:
+            msg_Warn( p_filter, "unsupported DTS frame (%u samples)",
+                      p_in_buf->i_nb_samples );
+            goto out;
+    }
+
+    if( i_length != p_sys->i_frame_size
+     || i_length + 1 > i_fz - SPDIF_HEADER_SIZE
+     || (p_in_buf->i_flags & BLOCK_FLAG_DISCONTINUITY) )
+    {
+        /* Frame size changed, reset everything */
+        if( p_sys->i_frame_size != 0 && i_length != p_sys->i_frame_size )
+            msg_Warn( p_filter, "Frame size changed from %zu to %zu, "
+                      "resetting everything.", p_sys->i_frame_size, i_length );
+        BurstReset( p_filter );
+        p_sys->i_frame_size = i_length;
+        if( i_length + 1 > i_fz - SPDIF_HEADER_SIZE )
+            goto out;
+    }
+
+    if( p_sys->p_out_buf == NULL
+     && BurstNew( p_filter, p_in_buf, DTS_FRAMES * i_fz ) == NULL )
+        goto out;
+
+    uint8_t *p_out = p_sys->p_out_buf->p_buffer + p_sys->i_frames * i_fz;
+    const uint8_t *p_in = p_in_buf->p_buffer;
+
+    WriteHeader( p_filter, p_out, i_type, i_length * 8 );
+
+    /* The stream endianness is detected from its sync word (16 or 14 bits
+     * words): swap it when it differs from the output */
+    if( ( (p_in[0] == 0x1F || p_in[0] == 0x7F) && IsLittleEndian( p_filter ) )
+     || ( (p_in[0] == 0xFF || p_in[0] == 0xFE) && !IsLittleEndian( p_filter ) ) )
+    {
+        swab( p_in, p_out + SPDIF_HEADER_SIZE, i_length & ~1 );
+        if( i_length & 1 )
+        {
+            p_out[SPDIF_HEADER_SIZE + i_length - 1] = 0;
+            p_out[SPDIF_HEADER_SIZE + i_length] = p_in[i_length - 1];
+        }
+    }
+    else
+        memcpy( p_out + SPDIF_HEADER_SIZE, p_in, i_length );
+
+    p_sys->i_samples += p_in_buf->i_nb_samples;
+    if( ++p_sys->i_frames < DTS_FRAMES )
+        goto out;
+
+    p_out_buf = BurstPop( p_filter );
+out:
+    block_Release( p_in_buf );
+    return p_out_buf;
+}
@@ -0,0 +1,365 @@
+/*****************************************************************************
+ * convolution.c : partitioned FFT convolution
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <math.h>
+#include <assert.h>
+
+#include <vlc_common.h>
+
+#include "convolution.h"
+
+struct convolution_t
+{
+    unsigned i_block;       /* partition size, in frames */
+    unsigned i_size;        /* FFT size, two blocks */
+    unsigned i_bins;        /* non-redundant bins of a real signal spectrum */
+    unsigned i_inputs;
+    unsigned i_outputs;
+
+    /* FFT tables */
+    unsigned *p_bitrev;
+    float    *p_cos;
+    float    *p_sin;
+
+    /* Responses spectra, per input/output pair and partition, re then im */
+    float   **pp_response;
+    unsigned *p_parts;
+
+    /* Input spectra of the last i_partitions blocks, per input */
+    unsigned  i_partitions;
+    unsigned  i_head;
+    float    *p_fdl;
+
+    float    *p_window;     /* per input, previous and current blocks */
+    float    *p_output;     /* per output, output of the previous block */
+    unsigned  i_pos;        /* frames in the current block */
+
+    float    *p_re, *p_im;  /* FFT scratch */
+    float    *p_acc;        /* spectrum accumulator, re then im */
+};
+
+/*****************************************************************************
+ * FFT: in place, radix-2, decimation in time
+ *****************************************************************************/
+static void FFT( const convolution_t *p_conv, float *p_re, float *p_im,
+                 bool b_inverse )
+{
+    const unsigned n = p_conv->i_size;
+
+    for( unsigned i = 0; i < n; i++ )
+    {
+        unsigned j = p_conv->p_bitrev[i];
+        if( j > i )
+        {
+            float f = p_re[i]; p_re[i] = p_re[j]; p_re[j] = f;
+            f = p_im[i]; p_im[i] = p_im[j]; p_im[j] = f;
+        }
+    }
+
+    for( unsigned i_len = 2; i_len <= n; i_len <<= 1 )
+    {
+        const unsigned i_half = i_len / 2, i_step = n / i_len;
+
+        for( unsigned i = 0; i < n; i += i_len )
+        {
+            for( unsigned k = 0; k < i_half; k++ )
+            {
+                const float wr = p_conv->p_cos[k * i_step];
+                const float wi = b_inverse ? p_conv->p_sin[k * i_step]
+                                           : -p_conv->p_sin[k * i_step];
+                const unsigned a = i + k, b = a + i_half;
+                const float tr = wr * p_re[b] - wi * p_im[b];
+                const float ti = wr * p_im[b] + wi * p_re[b];
+
+                p_re[b] = p_re[a] - tr;
+                p_im[b] = p_im[a] - ti;
+                p_re[a] += tr;
+                p_im[a] += ti;
+            }
+        }
+    }
+}
+
+/* Computes the spectrum of a block of real samples, zero padded */
+static void Spectrum( convolution_t *p_conv, const float *p_in,
+                      unsigned i_count, float *p_spectrum )
+{
+    memcpy( p_conv->p_re, p_in, i_count * sizeof(float) );
+    memset( p_conv->p_re + i_count, 0,
+            (p_conv->i_size - i_count) * sizeof(float) );
+    memset( p_conv->p_im, 0, p_conv->i_size * sizeof(float) );
+    FFT( p_conv, p_conv->p_re, p_conv->p_im, false );
+
+    memcpy( p_spectrum, p_conv->p_re, p_conv->i_bins * sizeof(float) );
+    memcpy( p_spectrum + p_conv->i_bins, p_conv->p_im,
+            p_conv->i_bins * sizeof(float) );
+}
+
+/*****************************************************************************
+ * convolution_New
+ *****************************************************************************/
+convolution_t *convolution_New( unsigned i_block, unsigned i_inputs,
+                                unsigned i_outputs )
+{
+    assert( i_block >= 2 && (i_block & (i_block - 1)) == 0 );
+
+    convolution_t *p_conv = calloc( 1, sizeof(*p_conv) );
+    if( p_conv == NULL )
+        return NULL;
+
+    const unsigned n = 2 * i_block;
+    p_conv->i_block = i_block;
+    p_conv->i_size = n;
+    p_conv->i_bins = i_block + 1;
+    p_conv->i_inputs = i_inputs;
+    p_conv->i_outputs = i_outputs;
+
+    p_conv->p_bitrev = malloc( n * sizeof(unsigned) );
+    p_conv->p_cos = malloc( n / 2 * sizeof(float) );
+    p_conv->p_sin = malloc( n / 2 * sizeof(float) );
+    p_conv->pp_response = calloc( i_inputs * i_outputs, sizeof(float *) );
+    p_conv->p_parts = calloc( i_inputs * i_outputs, sizeof(unsigned) );
+    p_conv->p_window = calloc( i_inputs * n, sizeof(float) );
+    p_conv->p_output = calloc( i_outputs * i_block, sizeof(float) );
+    p_conv->p_re = malloc( n * sizeof(float) );
+    p_conv->p_im = malloc( n * sizeof(float) );
+    p_conv->p_acc = malloc( 2 * p_conv->i_bins * sizeof(float) );
+    if( !p_conv->p_bitrev || !p_conv->p_cos || !p_conv->p_sin
+     || !p_conv->pp_response || !p_conv->p_parts || !p_conv->p_window
+     || !p_conv->p_output || !p_conv->p_re || !p_conv->p_im
+     || !p_conv->p_acc )
+    {
+        convolution_Delete( p_conv );
+        return NULL;
+    }
+
+    unsigned i_bits = 0;
+    while( (1u << i_bits) < n )
+        i_bits++;
+    for( unsigned i = 0; i < n; i++ )
+    {
+        unsigned j = 0;
+        for( unsigned b = 0; b < i_bits; b++ )
+            if( i & (1u << b) )
+                j |= 1u << (i_bits - 1 - b);
+        p_conv->p_bitrev[i] = j;
+    }
+    for( unsigned k = 0; k < n / 2; k++ )
+    {
+        p_conv->p_cos[k] = cos( 2. * M_PI * k / n );
+        p_conv->p_sin[k] = sin( 2. * M_PI * k / n );
+    }
+    return p_conv;
+}
+
+void convolution_Delete( convolution_t *p_conv )
+{
+    if( p_conv->pp_response != NULL )
+        for( unsigned i = 0; i < p_conv->i_inputs * p_conv->i_outputs; i++ )
+            free( p_conv->pp_response[i] );
+    free( p_conv->pp_response );
+    free( p_conv->p_parts );
+    free( p_conv->p_fdl );
+    free( p_conv->p_window );
+    free( p_conv->p_output );
+    free( p_conv->p_re );
+    free( p_conv->p_im );
+    free( p_conv->p_acc );
+    free( p_conv->p_bitrev );
+    free( p_conv->p_cos );
+    free( p_conv->p_sin );
+    free( p_conv );
+}
+
+/*****************************************************************************
+ * convolution_SetResponse
+ *****************************************************************************/
+int convolution_SetResponse( convolution_t *p_conv, unsigned i_input,
+                             unsigned i_output, const float *p_response,
+                             unsigned i_length )
+{
+    const unsigned i_pair = i_input * p_conv->i_outputs + i_output;
+    const unsigned i_parts = (i_length + p_conv->i_block - 1)
+                           / p_conv->i_block;
+    const size_t i_spectrum = 2 * p_conv->i_bins;
+
+    assert( i_input < p_conv->i_inputs && i_output < p_conv->i_outputs );
+
+    float *p_spectra = malloc( i_parts * i_spectrum * sizeof(float) );
+    if( p_spectra == NULL && i_parts > 0 )
+        return VLC_ENOMEM;
+
+    for( unsigned p = 0; p < i_parts; p++ )
+    {
+        const unsigned i_offset = p * p_conv->i_block;
+        Spectrum( p_conv, p_response + i_offset,
+                  __MIN(p_conv->i_block, i_length - i_offset),
+                  p_spectra + p * i_spectrum );
+    }
+
+    if( i_parts > p_conv->i_partitions )
+    {
+        float *p_fdl = calloc( p_conv->i_inputs * i_parts * i_spectrum,
+                               sizeof(float) );
+        if( p_fdl == NULL )
+        {
+            free( p_spectra );
+            return VLC_ENOMEM;
+        }
+        free( p_conv->p_fdl );
+        p_conv->p_fdl = p_fdl;
+        p_conv->i_partitions = i_parts;
+        p_conv->i_head = 0;
+    }
+
+    free( p_conv->pp_response[i_pair] );
+    p_conv->pp_response[i_pair] = p_spectra;
+    p_conv->p_parts[i_pair] = i_parts;
+    return VLC_SUCCESS;
+}
+
+void convolution_Reset( convolution_t *p_conv )
+{
+    const size_t i_spectrum = 2 * p_conv->i_bins;
+
+    if( p_conv->p_fdl != NULL )
+        memset( p_conv->p_fdl, 0, p_conv->i_inputs * p_conv->i_partitions
+                                  * i_spectrum * sizeof(float) );
+    memset( p_conv->p_window, 0,
+            p_conv->i_inputs * p_conv->i_size * sizeof(float) );
+    memset( p_conv->p_output, 0,
+            p_conv->i_outputs * p_conv->i_block * sizeof(float) );
+    p_conv->i_pos = 0;
+}
+
+/*****************************************************************************
+ * convolution_Process
+ *****************************************************************************/
+/* Convolves the block just completed, and replaces the output block */
+static void ProcessBlock( convolution_t *p_conv )
+{
+    const unsigned i_block = p_conv->i_block, n = p_conv->i_size;
+    const unsigned i_bins = p_conv->i_bins;
+    const unsigned i_parts_max = p_conv->i_partitions;
+    const size_t i_spectrum = 2 * i_bins;
+
+    if( i_parts_max == 0 )
+        return; /* no responses: the output stays silent */
+
+    /* Input spectra go to the frequency domain delay line */
+    p_conv->i_head = (p_conv->i_head + 1) % i_parts_max;
+    for( unsigned i = 0; i < p_conv->i_inputs; i++ )
+    {
+        float *p_window = &p_conv->p_window[i * n];
+
+        Spectrum( p_conv, p_window, n,
+                  &p_conv->p_fdl[(i * i_parts_max + p_conv->i_head)
+                                 * i_spectrum] );
+        memcpy( p_window, p_window + i_block, i_block * sizeof(float) );
+    }
+
+    for( unsigned o = 0; o < p_conv->i_outputs; o++ )
+    {
+        float *p_acc_re = p_conv->p_acc, *p_acc_im = p_acc_re + i_bins;
+
+        memset( p_conv->p_acc, 0, i_spectrum * sizeof(float) );
+        for( unsigned i = 0; i < p_conv->i_inputs; i++ )
+        {
+            const unsigned i_pair = i * p_conv->i_outputs + o;
+            const float *p_h = p_conv->pp_response[i_pair];
+
+            for( unsigned p = 0; p < p_conv->p_parts[i_pair]; p++ )
+            {
+                const unsigned i_slot = (p_conv->i_head + i_parts_max - p)
+                                      % i_parts_max;
+                const float *x_re = &p_conv->p_fdl[(i * i_parts_max + i_slot)
+                                                   * i_spectrum];
+                const float *x_im = x_re + i_bins;
+                const float *h_re = p_h + p * i_spectrum;
+                const float *h_im = h_re + i_bins;
+
+                for( unsigned k = 0; k < i_bins; k++ )
+                {
+                    p_acc_re[k] += h_re[k] * x_re[k] - h_im[k] * x_im[k];
+                    p_acc_im[k] += h_re[k] * x_im[k] + h_im[k] * x_re[k];
+                }
+            }
+        }
+
+        /* Rebuild the Hermitian spectrum and go back to the time domain */
+        for( unsigned k = 0; k < i_bins; k++ )
+        {
+            p_conv->p_re[k] = p_acc_re[k];
+            p_conv->p_im[k] = p_acc_im[k];
+        }
+        for( unsigned k = i_bins; k < n; k++ )
+        {
+            p_conv->p_re[k] = p_acc_re[n - k];
+            p_conv->p_im[k] = -p_acc_im[n - k];
+        }
+        FFT( p_conv, p_conv->p_re, p_conv->p_im, true );
+
+        /* Overlap-save: only the second half is free of circular aliasing */
+        float *p_out = &p_conv->p_output[o * i_block];
+        for( unsigned j = 0; j < i_block; j++ )
+            p_out[j] = p_conv->p_re[i_block + j] / n;
+    }
+}
+
+void convolution_Process( convolution_t *p_conv, const float *p_in,
+                          float *p_out, unsigned i_frames )
+{
+    const unsigned i_block = p_conv->i_block, n = p_conv->i_size;
+    const unsigned i_inputs = p_conv->i_inputs;
+    const unsigned i_outputs = p_conv->i_outputs;
+
+    while( i_frames > 0 )
+    {
+        const unsigned i_count = __MIN(i_frames, i_block - p_conv->i_pos);
+
+        for( unsigned i = 0; i < i_inputs; i++ )
+        {
+            float *p_dst = &p_conv->p_window[i * n + i_block + p_conv->i_pos];
+            for( unsigned j = 0; j < i_count; j++ )
+                p_dst[j] = p_in[j * i_inputs + i];
+        }
+        for( unsigned o = 0; o < i_outputs; o++ )
+        {
+            const float *p_src = &p_conv->p_output[o * i_block
+                                                   + p_conv->i_pos];
+            for( unsigned j = 0; j < i_count; j++ )
+                p_out[j * i_outputs + o] = p_src[j];
+        }
+
+        p_in += i_count * i_inputs;
+        p_out += i_count * i_outputs;
+        i_frames -= i_count;
+        p_conv->i_pos += i_count;
+        if( p_conv->i_pos == i_block )
+        {
+            ProcessBlock( p_conv );
+            p_conv->i_pos = 0;
+        }
+    }
+}
@@ -0,0 +1,67 @@
+/*****************************************************************************
+ * convolution.h : partitioned FFT convolution
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_AUDIO_CONVOLUTION_H
+#define VLC_AUDIO_CONVOLUTION_H 1
+
+/**
+ * Multichannel convolver with impulse responses of any length.
+ *
+ * Each output channel is the sum of the input channels convolved with their
+ * impulse response toward it. The responses are cut into partitions of one
+ * block, and convolved in the frequency domain (uniformly partitioned
+ * overlap-save), so the cost per sample grows with the logarithm of the block
+ * size and linearly, but with a small factor, with the response length.
+ * The output is delayed by one block.
+ */
+typedef struct convolution_t convolution_t;
+
+/**
+ * Creates a convolver.
+ * @param block partition size in frames (power of two)
+ * @param inputs number of input channels
+ * @param outputs number of output channels
+ */
+convolution_t *convolution_New( unsigned block, unsigned inputs,
+                                unsigned outputs );
+void convolution_Delete( convolution_t * );
+
+/**
+ * Sets the impulse response from an input channel to an output channel.
+ * This must be done before processing. Pairs without a response do not
+ * contribute.
+ */
+int convolution_SetResponse( convolution_t *, unsigned input, unsigned output,
+                             const float *response, unsigned length );
+
+/**
+ * Convolves interleaved samples.
+ * @param in frames of inputs channels
+ * @param out frames of outputs channels
+ */
+void convolution_Process( convolution_t *, const float *in, float *out,
+                          unsigned frames );
+
+/**
+ * Clears the history, e.g. on discontinuities.
+ */
+void convolution_Reset( convolution_t * );
+
+#endif
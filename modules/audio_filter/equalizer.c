@@ -37,11 +37,19 @@
 
 #include <vlc_aout.h>
 #include <vlc_filter.h>
+#include <vlc_cpu.h>
+
+#if defined(CAN_COMPILE_SSE)
+#   include <xmmintrin.h>
+#endif
+#if defined(__ARM_NEON__)
+#   include <arm_neon.h>
+#endif
 
 #include "equalizer_presets.h"
+#include "spatializer/denormals.h"
 /* TODO:
  *  - add tables for other rates ( 22500, 11250, ...)
- *  - optimize a bit (you can hardly do slower ;)
  *  - add tables for more bands (15 and 32 would be cool), maybe with auto coeffs
  *  computation (not too hard once the Q is found).
  *  - support for external preset
@@ -94,6 +102,10 @@ vlc_module_end ()
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
+/* The bands all filter the same input, so they are processed four at a time
+ * by the vector versions. Padding bands have a null gain and stay silent. */
+#define EQZ_BANDS_PAD ((EQZ_BANDS_MAX + 3) & ~3)
+
 struct filter_sys_t
 {
     /* Filter static config */
@@ -111,13 +123,15 @@ struct filter_sys_t
     float f_gamp;   /* Global preamp */
     bool b_2eqz;
 
-    /* Filter state */
+    /* Filter state: last two inputs, and last two outputs of each band */
     float x[32][2];
-    float y[32][128][2];
+    float y[32][2][EQZ_BANDS_PAD];
 
     /* Second filter state */
     float x2[32][2];
-    float y2[32][128][2];
+    float y2[32][2][EQZ_BANDS_PAD];
+
+    void (*pf_filter)( filter_t *, float *, float *, int, int );
 
     vlc_mutex_t lock;
 };
@@ -127,6 +141,12 @@ static block_t *DoWork( filter_t *, block_t * );
 #define EQZ_IN_FACTOR (0.25)
 static int  EqzInit( filter_t *, int );
 static void EqzFilter( filter_t *, float *, float *, int, int );
+#if defined(CAN_COMPILE_SSE)
+static void EqzFilterSSE( filter_t *, float *, float *, int, int );
+#endif
+#if defined(__ARM_NEON__)
+static void EqzFilterNEON( filter_t *, float *, float *, int, int );
+#endif
 static void EqzClean( filter_t * );
 
 static int PresetCallback ( vlc_object_t *, char const *, vlc_value_t,
@@ -202,7 +222,7 @@ static void Close( vlc_object_t *p_this )
  *****************************************************************************/
 static block_t * DoWork( filter_t * p_filter, block_t * p_in_buf )
 {
-    EqzFilter( p_filter, (float*)p_in_buf->p_buffer,
+    p_filter->p_sys->pf_filter( p_filter, (float*)p_in_buf->p_buffer,
                (float*)p_in_buf->p_buffer, p_in_buf->i_nb_samples,
                aout_FormatNbChannels( &p_filter->fmt_in.audio ) );
     return p_in_buf;
@@ -303,9 +323,9 @@ static int EqzInit( filter_t *p_filter, int i_rate )
 
     /* Create the static filter config */
     p_sys->i_band = p_cfg->i_band;
-    p_sys->f_alpha = malloc( p_sys->i_band * sizeof(float) );
-    p_sys->f_beta  = malloc( p_sys->i_band * sizeof(float) );
-    p_sys->f_gamma = malloc( p_sys->i_band * sizeof(float) );
+    p_sys->f_alpha = calloc( EQZ_BANDS_PAD, sizeof(float) );
+    p_sys->f_beta  = calloc( EQZ_BANDS_PAD, sizeof(float) );
+    p_sys->f_gamma = calloc( EQZ_BANDS_PAD, sizeof(float) );
     if( !p_sys->f_alpha || !p_sys->f_beta || !p_sys->f_gamma )
         goto error;
 
@@ -319,15 +339,10 @@ static int EqzInit( filter_t *p_filter, int i_rate )
     /* Filter dyn config */
     p_sys->b_2eqz = false;
     p_sys->f_gamp = 1.0;
-    p_sys->f_amp  = malloc( p_sys->i_band * sizeof(float) );
+    p_sys->f_amp  = calloc( EQZ_BANDS_PAD, sizeof(float) );
     if( !p_sys->f_amp )
         goto error;
 
-    for( i = 0; i < p_sys->i_band; i++ )
-    {
-        p_sys->f_amp[i] = 0.0;
-    }
-
     /* Filter state */
     for( ch = 0; ch < 32; ch++ )
     {
@@ -336,15 +351,25 @@ static int EqzInit( filter_t *p_filter, int i_rate )
         p_sys->x2[ch][0] =
         p_sys->x2[ch][1] = 0.0;
 
-        for( i = 0; i < p_sys->i_band; i++ )
+        for( i = 0; i < EQZ_BANDS_PAD; i++ )
         {
-            p_sys->y[ch][i][0]  =
-            p_sys->y[ch][i][1]  =
-            p_sys->y2[ch][i][0] =
-            p_sys->y2[ch][i][1] = 0.0;
+            p_sys->y[ch][0][i]  =
+            p_sys->y[ch][1][i]  =
+            p_sys->y2[ch][0][i] =
+            p_sys->y2[ch][1][i] = 0.0;
         }
     }
 
+    p_sys->pf_filter = EqzFilter;
+#if defined(CAN_COMPILE_SSE)
+    if( vlc_CPU() & CPU_CAPABILITY_SSE )
+        p_sys->pf_filter = EqzFilterSSE;
+#endif
+#if defined(__ARM_NEON__)
+    if( vlc_CPU() & CPU_CAPABILITY_NEON )
+        p_sys->pf_filter = EqzFilterNEON;
+#endif
+
     var_Create( p_aout, "equalizer-bands", VLC_VAR_STRING | VLC_VAR_DOINHERIT );
     var_Create( p_aout, "equalizer-preset", VLC_VAR_STRING | VLC_VAR_DOINHERIT );
 
@@ -425,11 +450,11 @@ static void EqzFilter( filter_t *p_filter, float *out, float *in,
             for( j = 0; j < p_sys->i_band; j++ )
             {
                 float y = p_sys->f_alpha[j] * ( x - p_sys->x[ch][1] ) +
-                          p_sys->f_gamma[j] * p_sys->y[ch][j][0] -
-                          p_sys->f_beta[j]  * p_sys->y[ch][j][1];
+                          p_sys->f_gamma[j] * p_sys->y[ch][0][j] -
+                          p_sys->f_beta[j]  * p_sys->y[ch][1][j];
 
-                p_sys->y[ch][j][1] = p_sys->y[ch][j][0];
-                p_sys->y[ch][j][0] = y;
+                p_sys->y[ch][1][j] = p_sys->y[ch][0][j];
+                p_sys->y[ch][0][j] = y;
 
                 o += y * p_sys->f_amp[j];
             }
@@ -444,11 +469,11 @@ static void EqzFilter( filter_t *p_filter, float *out, float *in,
                 for( j = 0; j < p_sys->i_band; j++ )
                 {
                     float y = p_sys->f_alpha[j] * ( x2 - p_sys->x2[ch][1] ) +
-                              p_sys->f_gamma[j] * p_sys->y2[ch][j][0] -
-                              p_sys->f_beta[j]  * p_sys->y2[ch][j][1];
+                              p_sys->f_gamma[j] * p_sys->y2[ch][0][j] -
+                              p_sys->f_beta[j]  * p_sys->y2[ch][1][j];
 
-                    p_sys->y2[ch][j][1] = p_sys->y2[ch][j][0];
-                    p_sys->y2[ch][j][0] = y;
+                    p_sys->y2[ch][1][j] = p_sys->y2[ch][0][j];
+                    p_sys->y2[ch][0][j] = y;
 
                     o += y * p_sys->f_amp[j];
                 }
@@ -468,9 +493,239 @@ static void EqzFilter( filter_t *p_filter, float *out, float *in,
         in  += i_channels;
         out += i_channels;
     }
+
+    /* Do not let the bands decay through denormals in silence */
+    for( ch = 0; ch < i_channels; ch++ )
+        for( j = 0; j < p_sys->i_band; j++ )
+        {
+            p_sys->y[ch][0][j]  = undenormalise( p_sys->y[ch][0][j] );
+            p_sys->y[ch][1][j]  = undenormalise( p_sys->y[ch][1][j] );
+            p_sys->y2[ch][0][j] = undenormalise( p_sys->y2[ch][0][j] );
+            p_sys->y2[ch][1][j] = undenormalise( p_sys->y2[ch][1][j] );
+        }
     vlc_mutex_unlock( &p_sys->lock );
 }
 
+/* The vector versions process one channel at a time, with the state of all
+ * the bands in registers. */
+#define EQZ_VECTORS (EQZ_BANDS_PAD / 4)
+
+#if defined(CAN_COMPILE_SSE)
+VLC_SSE
+static inline float EqzSumSSE( __m128 v )
+{
+    v = _mm_add_ps( v, _mm_movehl_ps( v, v ) );
+    v = _mm_add_ss( v, _mm_shuffle_ps( v, v, 1 ) );
+    return _mm_cvtss_f32( v );
+}
+
+VLC_SSE
+static void EqzFilterSSE( filter_t *p_filter, float *out, float *in,
+                          int i_samples, int i_channels )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    __m128 alpha[EQZ_VECTORS], beta[EQZ_VECTORS], gamma[EQZ_VECTORS];
+    __m128 amp[EQZ_VECTORS];
+    int i, ch, v;
+
+    /* Flush denormals to zero (FTZ and DAZ) while filtering */
+    const unsigned int i_csr = _mm_getcsr();
+    _mm_setcsr( i_csr | 0x8040 );
+
+    vlc_mutex_lock( &p_sys->lock );
+    for( v = 0; v < EQZ_VECTORS; v++ )
+    {
+        alpha[v] = _mm_loadu_ps( &p_sys->f_alpha[4 * v] );
+        beta[v]  = _mm_loadu_ps( &p_sys->f_beta[4 * v] );
+        gamma[v] = _mm_loadu_ps( &p_sys->f_gamma[4 * v] );
+        amp[v]   = _mm_loadu_ps( &p_sys->f_amp[4 * v] );
+    }
+
+    for( ch = 0; ch < i_channels; ch++ )
+    {
+        __m128 y0[EQZ_VECTORS], y1[EQZ_VECTORS];
+        __m128 z0[EQZ_VECTORS], z1[EQZ_VECTORS];
+        float x0 = p_sys->x[ch][0], x1 = p_sys->x[ch][1];
+        float w0 = p_sys->x2[ch][0], w1 = p_sys->x2[ch][1];
+
+        for( v = 0; v < EQZ_VECTORS; v++ )
+        {
+            y0[v] = _mm_loadu_ps( &p_sys->y[ch][0][4 * v] );
+            y1[v] = _mm_loadu_ps( &p_sys->y[ch][1][4 * v] );
+            z0[v] = _mm_loadu_ps( &p_sys->y2[ch][0][4 * v] );
+            z1[v] = _mm_loadu_ps( &p_sys->y2[ch][1][4 * v] );
+        }
+
+        for( i = 0; i < i_samples; i++ )
+        {
+            const float x = in[i * i_channels + ch];
+            __m128 dx = _mm_set1_ps( x - x1 );
+            __m128 acc = _mm_setzero_ps();
+
+            for( v = 0; v < EQZ_VECTORS; v++ )
+            {
+                __m128 y = _mm_sub_ps( _mm_add_ps( _mm_mul_ps( alpha[v], dx ),
+                                                   _mm_mul_ps( gamma[v], y0[v] ) ),
+                                       _mm_mul_ps( beta[v], y1[v] ) );
+                y1[v] = y0[v];
+                y0[v] = y;
+                acc = _mm_add_ps( acc, _mm_mul_ps( y, amp[v] ) );
+            }
+            x1 = x0;
+            x0 = x;
+
+            float o = EqzSumSSE( acc );
+            float x_out = x;
+
+            /* Second filter */
+            if( p_sys->b_2eqz )
+            {
+                const float x2 = EQZ_IN_FACTOR * x + o;
+
+                dx = _mm_set1_ps( x2 - w1 );
+                acc = _mm_setzero_ps();
+                for( v = 0; v < EQZ_VECTORS; v++ )
+                {
+                    __m128 y = _mm_sub_ps( _mm_add_ps( _mm_mul_ps( alpha[v], dx ),
+                                                       _mm_mul_ps( gamma[v], z0[v] ) ),
+                                           _mm_mul_ps( beta[v], z1[v] ) );
+                    z1[v] = z0[v];
+                    z0[v] = y;
+                    acc = _mm_add_ps( acc, _mm_mul_ps( y, amp[v] ) );
+                }
+                w1 = w0;
+                w0 = x2;
+
+                o = EqzSumSSE( acc );
+                x_out = x2;
+            }
+
+            /* We add source PCM + filtered PCM */
+            out[i * i_channels + ch] = p_sys->f_gamp *( EQZ_IN_FACTOR * x_out + o );
+        }
+
+        p_sys->x[ch][0] = x0;
+        p_sys->x[ch][1] = x1;
+        p_sys->x2[ch][0] = w0;
+        p_sys->x2[ch][1] = w1;
+        for( v = 0; v < EQZ_VECTORS; v++ )
+        {
+            _mm_storeu_ps( &p_sys->y[ch][0][4 * v], y0[v] );
+            _mm_storeu_ps( &p_sys->y[ch][1][4 * v], y1[v] );
+            _mm_storeu_ps( &p_sys->y2[ch][0][4 * v], z0[v] );
+            _mm_storeu_ps( &p_sys->y2[ch][1][4 * v], z1[v] );
+        }
+    }
+    vlc_mutex_unlock( &p_sys->lock );
+
+    _mm_setcsr( i_csr );
+}
+#endif
+
+#if defined(__ARM_NEON__)
+static inline float EqzSumNEON( float32x4_t v )
+{
+    float32x2_t s = vadd_f32( vget_low_f32( v ), vget_high_f32( v ) );
+    return vget_lane_f32( vpadd_f32( s, s ), 0 );
+}
+
+/* NEON always flushes denormals to zero */
+static void EqzFilterNEON( filter_t *p_filter, float *out, float *in,
+                           int i_samples, int i_channels )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    float32x4_t alpha[EQZ_VECTORS], beta[EQZ_VECTORS], gamma[EQZ_VECTORS];
+    float32x4_t amp[EQZ_VECTORS];
+    int i, ch, v;
+
+    vlc_mutex_lock( &p_sys->lock );
+    for( v = 0; v < EQZ_VECTORS; v++ )
+    {
+        alpha[v] = vld1q_f32( &p_sys->f_alpha[4 * v] );
+        beta[v]  = vld1q_f32( &p_sys->f_beta[4 * v] );
+        gamma[v] = vld1q_f32( &p_sys->f_gamma[4 * v] );
+        amp[v]   = vld1q_f32( &p_sys->f_amp[4 * v] );
+    }
+
+    for( ch = 0; ch < i_channels; ch++ )
+    {
+        float32x4_t y0[EQZ_VECTORS], y1[EQZ_VECTORS];
+        float32x4_t z0[EQZ_VECTORS], z1[EQZ_VECTORS];
+        float x0 = p_sys->x[ch][0], x1 = p_sys->x[ch][1];
+        float w0 = p_sys->x2[ch][0], w1 = p_sys->x2[ch][1];
+
+        for( v = 0; v < EQZ_VECTORS; v++ )
+        {
+            y0[v] = vld1q_f32( &p_sys->y[ch][0][4 * v] );
+            y1[v] = vld1q_f32( &p_sys->y[ch][1][4 * v] );
+            z0[v] = vld1q_f32( &p_sys->y2[ch][0][4 * v] );
+            z1[v] = vld1q_f32( &p_sys->y2[ch][1][4 * v] );
+        }
+
+        for( i = 0; i < i_samples; i++ )
+        {
+            const float x = in[i * i_channels + ch];
+            float32x4_t dx = vdupq_n_f32( x - x1 );
+            float32x4_t acc = vdupq_n_f32( 0.f );
+
+            for( v = 0; v < EQZ_VECTORS; v++ )
+            {
+                float32x4_t y = vmlsq_f32( vmlaq_f32( vmulq_f32( alpha[v], dx ),
+                                                      gamma[v], y0[v] ),
+                                           beta[v], y1[v] );
+                y1[v] = y0[v];
+                y0[v] = y;
+                acc = vmlaq_f32( acc, y, amp[v] );
+            }
+            x1 = x0;
+            x0 = x;
+
+            float o = EqzSumNEON( acc );
+            float x_out = x;
+
+            /* Second filter */
+            if( p_sys->b_2eqz )
+            {
+                const float x2 = EQZ_IN_FACTOR * x + o;
+
+                dx = vdupq_n_f32( x2 - w1 );
+                acc = vdupq_n_f32( 0.f );
+                for( v = 0; v < EQZ_VECTORS; v++ )
+                {
+                    float32x4_t y = vmlsq_f32( vmlaq_f32( vmulq_f32( alpha[v], dx ),
+                                                          gamma[v], z0[v] ),
+                                               beta[v], z1[v] );
+                    z1[v] = z0[v];
+                    z0[v] = y;
+                    acc = vmlaq_f32( acc, y, amp[v] );
+                }
+                w1 = w0;
+                w0 = x2;
+
+                o = EqzSumNEON( acc );
+                x_out = x2;
+            }
+
+            /* We add source PCM + filtered PCM */
+            out[i * i_channels + ch] = p_sys->f_gamp *( EQZ_IN_FACTOR * x_out + o );
+        }
+
+        p_sys->x[ch][0] = x0;
+        p_sys->x[ch][1] = x1;
+        p_sys->x2[ch][0] = w0;
+        p_sys->x2[ch][1] = w1;
+        for( v = 0; v < EQZ_VECTORS; v++ )
+        {
+            vst1q_f32( &p_sys->y[ch][0][4 * v], y0[v] );
+            vst1q_f32( &p_sys->y[ch][1][4 * v], y1[v] );
+            vst1q_f32( &p_sys->y2[ch][0][4 * v], z0[v] );
+            vst1q_f32( &p_sys->y2[ch][1][4 * v], z1[v] );
+        }
+    }
+    vlc_mutex_unlock( &p_sys->lock );
+}
+#endif
+
 static void EqzClean( filter_t *p_filter )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
@@ -31,11 +31,22 @@
 #endif
 
 #include <math.h>
+#include <assert.h>
 
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_aout.h>
 #include <vlc_filter.h>
+#include <vlc_cpu.h>
+
+#if defined(CAN_COMPILE_SSE)
+#   include <xmmintrin.h>
+#endif
+#if defined(__ARM_NEON__)
+#   include <arm_neon.h>
+#endif
+
+#include "spatializer/denormals.h"
 
 /*****************************************************************************
  * Module descriptor
@@ -44,8 +55,18 @@ static int  Open ( vlc_object_t * );
 static void Close( vlc_object_t * );
 static void CalcPeakEQCoeffs( float, float, float, float, float * );
 static void CalcShelfEQCoeffs( float, float, float, int, float, float * );
+typedef void (*process_eq_t)( const float *, float *, float *, unsigned,
+                              unsigned, const float *, unsigned );
 static void ProcessEQ( const float *, float *, float *, unsigned, unsigned,
                        const float *, unsigned );
+#if defined(CAN_COMPILE_SSE)
+static void ProcessEQSSE( const float *, float *, float *, unsigned, unsigned,
+                          const float *, unsigned );
+#endif
+#if defined(__ARM_NEON__)
+static void ProcessEQNEON( const float *, float *, float *, unsigned, unsigned,
+                           const float *, unsigned );
+#endif
 static block_t *DoWork( filter_t *, block_t * );
 
 vlc_module_begin ()
@@ -95,6 +116,7 @@ struct filter_sys_t
     float   coeffs[5*5];
     /* State */
     float  *p_state;
+    process_eq_t pf_process;
 };
 
 
@@ -170,6 +192,16 @@ static int Open( vlc_object_t *p_this )
     p_sys->p_state = (float*)calloc( p_filter->fmt_in.audio.i_channels*5*4,
                                      sizeof(float) );
 
+    p_sys->pf_process = ProcessEQ;
+#if defined(CAN_COMPILE_SSE)
+    if( vlc_CPU() & CPU_CAPABILITY_SSE )
+        p_sys->pf_process = ProcessEQSSE;
+#endif
+#if defined(__ARM_NEON__)
+    if( vlc_CPU() & CPU_CAPABILITY_NEON )
+        p_sys->pf_process = ProcessEQNEON;
+#endif
+
     return VLC_SUCCESS;
 }
 
@@ -187,7 +219,7 @@ static void Close( vlc_object_t *p_this )
  *****************************************************************************/
 static block_t *DoWork( filter_t * p_filter, block_t * p_in_buf )
 {
-    ProcessEQ( (float*)p_in_buf->p_buffer, (float*)p_in_buf->p_buffer,
+    p_filter->p_sys->pf_process( (float*)p_in_buf->p_buffer, (float*)p_in_buf->p_buffer,
                p_filter->p_sys->p_state,
                p_filter->fmt_in.audio.i_channels, p_in_buf->i_nb_samples,
                p_filter->p_sys->coeffs, 5 );
@@ -339,5 +371,187 @@ void ProcessEQ( const float *src, float *dest, float *state,
             *dest1++ = y;
         }
     }
+
+    /* Do not let the filters decay through denormals in silence */
+    for (i = 0; i < channels * eqCount * 4; i++)
+        state[i] = undenormalise(state[i]);
+}
+
+/*
+  The vector versions filter up to four channels at once, since the filters
+  of a channel are in series. The state of a group of w channels starting at
+  channel c is at state + 4*c*eqCount, as w values of x1, x2, y1 and y2 per
+  filter; for a single channel, this is the layout of ProcessEQ().
+*/
+#define EQ_MAX 5
+
+#if defined(CAN_COMPILE_SSE)
+VLC_SSE
+static inline __m128 LoadSSE( const float *p, unsigned w )
+{
+    if (w == 4)
+        return _mm_loadu_ps(p);
+    if (w == 2)
+        return _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *)p);
+    return _mm_load_ss(p);
+}
+
+VLC_SSE
+static inline void StoreSSE( float *p, __m128 v, unsigned w )
+{
+    if (w == 4)
+        _mm_storeu_ps(p, v);
+    else if (w == 2)
+        _mm_storel_pi((__m64 *)p, v);
+    else
+        _mm_store_ss(p, v);
 }
 
+VLC_SSE
+static void ProcessEQSSE( const float *src, float *dest, float *state,
+                          unsigned channels, unsigned samples,
+                          const float *coeffs, unsigned eqCount )
+{
+    __m128 b0[EQ_MAX], b1[EQ_MAX], b2[EQ_MAX], a1[EQ_MAX], a2[EQ_MAX];
+    unsigned i, chn, eq, w;
+
+    assert(eqCount <= EQ_MAX);
+
+    /* Flush denormals to zero (FTZ and DAZ) while filtering */
+    const unsigned csr = _mm_getcsr();
+    _mm_setcsr(csr | 0x8040);
+
+    for (eq = 0; eq < eqCount; eq++)
+    {
+        b0[eq] = _mm_set1_ps(coeffs[5 * eq + 0]);
+        b1[eq] = _mm_set1_ps(coeffs[5 * eq + 1]);
+        b2[eq] = _mm_set1_ps(coeffs[5 * eq + 2]);
+        a1[eq] = _mm_set1_ps(coeffs[5 * eq + 3]);
+        a2[eq] = _mm_set1_ps(coeffs[5 * eq + 4]);
+    }
+
+    for (chn = 0; chn < channels; chn += w)
+    {
+        __m128 x1[EQ_MAX], x2[EQ_MAX], y1[EQ_MAX], y2[EQ_MAX];
+        float *state1 = state + 4 * chn * eqCount;
+
+        w = channels - chn >= 4 ? 4 : channels - chn >= 2 ? 2 : 1;
+        for (eq = 0; eq < eqCount; eq++)
+        {
+            x1[eq] = LoadSSE(state1 + (4 * eq + 0) * w, w);
+            x2[eq] = LoadSSE(state1 + (4 * eq + 1) * w, w);
+            y1[eq] = LoadSSE(state1 + (4 * eq + 2) * w, w);
+            y2[eq] = LoadSSE(state1 + (4 * eq + 3) * w, w);
+        }
+
+        for (i = 0; i < samples; i++)
+        {
+            __m128 x = LoadSSE(src + i * channels + chn, w);
+
+            /* Direct form 1 IIRs */
+            for (eq = 0; eq < eqCount; eq++)
+            {
+                __m128 y = _mm_mul_ps(x, b0[eq]);
+
+                y = _mm_add_ps(y, _mm_mul_ps(x1[eq], b1[eq]));
+                y = _mm_add_ps(y, _mm_mul_ps(x2[eq], b2[eq]));
+                y = _mm_sub_ps(y, _mm_mul_ps(y1[eq], a1[eq]));
+                y = _mm_sub_ps(y, _mm_mul_ps(y2[eq], a2[eq]));
+                x2[eq] = x1[eq];
+                x1[eq] = x;
+                y2[eq] = y1[eq];
+                y1[eq] = y;
+                x = y;
+            }
+            StoreSSE(dest + i * channels + chn, x, w);
+        }
+
+        for (eq = 0; eq < eqCount; eq++)
+        {
+            StoreSSE(state1 + (4 * eq + 0) * w, x1[eq], w);
+            StoreSSE(state1 + (4 * eq + 1) * w, x2[eq], w);
+            StoreSSE(state1 + (4 * eq + 2) * w, y1[eq], w);
+            StoreSSE(state1 + (4 * eq + 3) * w, y2[eq], w);
+        }
+    }
+    _mm_setcsr(csr);
+}
+#endif
+
+#if defined(__ARM_NEON__)
+static inline float32x4_t LoadNEON( const float *p, unsigned w )
+{
+    if (w == 4)
+        return vld1q_f32(p);
+    if (w == 2)
+        return vcombine_f32(vld1_f32(p), vdup_n_f32(0.f));
+    return vsetq_lane_f32(*p, vdupq_n_f32(0.f), 0);
+}
+
+static inline void StoreNEON( float *p, float32x4_t v, unsigned w )
+{
+    if (w == 4)
+        vst1q_f32(p, v);
+    else if (w == 2)
+        vst1_f32(p, vget_low_f32(v));
+    else
+        *p = vgetq_lane_f32(v, 0);
+}
+
+/* NEON always flushes denormals to zero */
+static void ProcessEQNEON( const float *src, float *dest, float *state,
+                           unsigned channels, unsigned samples,
+                           const float *coeffs, unsigned eqCount )
+{
+    unsigned i, chn, eq, w;
+
+    assert(eqCount <= EQ_MAX);
+
+    for (chn = 0; chn < channels; chn += w)
+    {
+        float32x4_t x1[EQ_MAX], x2[EQ_MAX], y1[EQ_MAX], y2[EQ_MAX];
+        float *state1 = state + 4 * chn * eqCount;
+
+        w = channels - chn >= 4 ? 4 : channels - chn >= 2 ? 2 : 1;
+        for (eq = 0; eq < eqCount; eq++)
+        {
+            x1[eq] = LoadNEON(state1 + (4 * eq + 0) * w, w);
+            x2[eq] = LoadNEON(state1 + (4 * eq + 1) * w, w);
+            y1[eq] = LoadNEON(state1 + (4 * eq + 2) * w, w);
+            y2[eq] = LoadNEON(state1 + (4 * eq + 3) * w, w);
+        }
+
+        for (i = 0; i < samples; i++)
+        {
+            float32x4_t x = LoadNEON(src + i * channels + chn, w);
+
+            /* Direct form 1 IIRs */
+            for (eq = 0; eq < eqCount; eq++)
+            {
+                const float *c = coeffs + 5 * eq;
+                float32x4_t y = vmulq_n_f32(x, c[0]);
+
+                y = vmlaq_n_f32(y, x1[eq], c[1]);
+                y = vmlaq_n_f32(y, x2[eq], c[2]);
+                y = vmlsq_n_f32(y, y1[eq], c[3]);
+                y = vmlsq_n_f32(y, y2[eq], c[4]);
+                x2[eq] = x1[eq];
+                x1[eq] = x;
+                y2[eq] = y1[eq];
+                y1[eq] = y;
+                x = y;
+            }
+            StoreNEON(dest + i * channels + chn, x, w);
+        }
+
+        for (eq = 0; eq < eqCount; eq++)
+        {
+            StoreNEON(state1 + (4 * eq + 0) * w, x1[eq], w);
+            StoreNEON(state1 + (4 * eq + 1) * w, x2[eq], w);
+            StoreNEON(state1 + (4 * eq + 2) * w, y1[eq], w);
+            StoreNEON(state1 + (4 * eq + 3) * w, y2[eq], w);
+        }
+    }
+}
+#endif
+
@@ -0,0 +1,512 @@
+/*****************************************************************************
+ * polyphase.c : polyphase FIR audio resampler
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Each output sample is the dot product of TAPS input samples with one phase
+ * of a Kaiser windowed sinc. When the rates have a small ratio L/M (44.1 to
+ * 48 kHz is 160/147, 48 to 96 kHz is 2/1), the bank holds exactly the L
+ * phases needed. Otherwise, including while the audio output slews the input
+ * rate to compensate a clock drift, the phase is interpolated in a finer
+ * bank. The samples are kept per channel so that the dot products are
+ * contiguous, and vectorized.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <math.h>
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+#include <vlc_filter.h>
+#include <vlc_plugin.h>
+#include <vlc_cpu.h>
+
+#if defined(CAN_COMPILE_AVX2)
+#   include <immintrin.h>
+#elif defined(CAN_COMPILE_SSE)
+#   include <xmmintrin.h>
+#endif
+#if defined(__ARM_NEON__)
+#   include <arm_neon.h>
+#endif
+
+static int  Open (vlc_object_t *);
+static void Close (vlc_object_t *);
+
+vlc_module_begin ()
+    set_shortname (N_("Polyphase resampler"))
+    set_description (N_("Polyphase FIR audio resampler"))
+    set_category (CAT_AUDIO)
+    set_subcategory (SUBCAT_AUDIO_MISC)
+    set_capability ("audio filter", 50)
+    set_callbacks (Open, Close)
+vlc_module_end ()
+
+/* Filter length, in input samples, a multiple of 8 for the vector loops */
+#define TAPS 64
+/* Largest exact bank, in phases */
+#define EXACT_PHASES_MAX 512
+/* Phases of the interpolated bank */
+#define INTERP_PHASES 256
+/* The interpolated bank is rebuilt when the cutoff moves by more than this */
+#define INTERP_CUTOFF_SLACK 0.01f
+/* Kaiser window parameter, about 80 dB of stop band attenuation */
+#define KAISER_BETA 8.
+/* Cutoff relative to the Nyquist frequency of the slower rate */
+#define CUTOFF 0.92f
+
+typedef float (*dot_t) (const float *, const float *);
+
+typedef struct
+{
+    float   *coefs;    /* phases (+1 if interpolated) rows of TAPS */
+    unsigned phases;
+    unsigned in_rate;  /* exact bank: rates it is built for */
+    unsigned out_rate;
+    float    cutoff;
+} bank_t;
+
+struct filter_sys_t
+{
+    bank_t   exact;
+    bank_t   interp;
+    bool     use_exact;
+    unsigned in_rate;  /* current rates */
+    unsigned out_rate;
+
+    /* Input samples per channel, the first ones are kept from the previous
+     * buffer */
+    float   *planes;
+    size_t   plane_size;   /* allocated frames per channel */
+    size_t   frames;       /* valid frames per channel */
+
+    /* Position of the next output frame: index of its first input frame,
+     * and fraction in 1/exact.phases or 1/2^32 */
+    size_t   index;
+    uint32_t frac;
+
+    float    coefs[TAPS];  /* interpolated phase */
+    dot_t    dot;
+};
+
+static block_t *Resample (filter_t *, block_t *);
+
+/*****************************************************************************
+ * Dot products
+ *****************************************************************************/
+static float DotC (const float *a, const float *b)
+{
+    float s0 = 0.f, s1 = 0.f, s2 = 0.f, s3 = 0.f;
+
+    for (unsigned i = 0; i < TAPS; i += 4)
+    {
+        s0 += a[i] * b[i];
+        s1 += a[i + 1] * b[i + 1];
+        s2 += a[i + 2] * b[i + 2];
+        s3 += a[i + 3] * b[i + 3];
+    }
+    return (s0 + s1) + (s2 + s3);
+}
+
+#if defined(CAN_COMPILE_SSE)
+VLC_SSE
+static float DotSSE (const float *a, const float *b)
+{
+    __m128 s0 = _mm_setzero_ps (), s1 = _mm_setzero_ps ();
+
+    for (unsigned i = 0; i < TAPS; i += 8)
+    {
+        s0 = _mm_add_ps (s0, _mm_mul_ps (_mm_loadu_ps (&a[i]),
+                                         _mm_loadu_ps (&b[i])));
+        s1 = _mm_add_ps (s1, _mm_mul_ps (_mm_loadu_ps (&a[i + 4]),
+                                         _mm_loadu_ps (&b[i + 4])));
+    }
+    s0 = _mm_add_ps (s0, s1);
+    s0 = _mm_add_ps (s0, _mm_movehl_ps (s0, s0));
+    s0 = _mm_add_ss (s0, _mm_shuffle_ps (s0, s0, 1));
+    return _mm_cvtss_f32 (s0);
+}
+#endif
+
+#if defined(CAN_COMPILE_AVX2)
+VLC_AVX2
+static float DotAVX2 (const float *a, const float *b)
+{
+    __m256 s0 = _mm256_setzero_ps (), s1 = _mm256_setzero_ps ();
+
+    for (unsigned i = 0; i < TAPS; i += 16)
+    {
+        s0 = _mm256_add_ps (s0, _mm256_mul_ps (_mm256_loadu_ps (&a[i]),
+                                               _mm256_loadu_ps (&b[i])));
+        s1 = _mm256_add_ps (s1, _mm256_mul_ps (_mm256_loadu_ps (&a[i + 8]),
+                                               _mm256_loadu_ps (&b[i + 8])));
+    }
+    s0 = _mm256_add_ps (s0, s1);
+    __m128 s = _mm_add_ps (_mm256_castps256_ps128 (s0),
+                           _mm256_extractf128_ps (s0, 1));
+    s = _mm_add_ps (s, _mm_movehl_ps (s, s));
+    s = _mm_add_ss (s, _mm_shuffle_ps (s, s, 1));
+    return _mm_cvtss_f32 (s);
+}
+#endif
+
+#if defined(__ARM_NEON__)
+static float DotNEON (const float *a, const float *b)
+{
+    float32x4_t s0 = vdupq_n_f32 (0.f), s1 = vdupq_n_f32 (0.f);
+
+    for (unsigned i = 0; i < TAPS; i += 8)
+    {
+        s0 = vmlaq_f32 (s0, vld1q_f32 (&a[i]), vld1q_f32 (&b[i]));
+        s1 = vmlaq_f32 (s1, vld1q_f32 (&a[i + 4]), vld1q_f32 (&b[i + 4]));
+    }
+    s0 = vaddq_f32 (s0, s1);
+    float32x2_t s = vadd_f32 (vget_low_f32 (s0), vget_high_f32 (s0));
+    return vget_lane_f32 (vpadd_f32 (s, s), 0);
+}
+#endif
+
+/*****************************************************************************
+ * Filter banks
+ *****************************************************************************/
+/* Modified Bessel function of the first kind, order 0 */
+static double BesselI0 (double x)
+{
+    double sum = 1., term = 1.;
+
+    for (unsigned k = 1; k < 50 && term > sum * 1e-12; k++)
+    {
+        term *= (x / (2. * k)) * (x / (2. * k));
+        sum += term;
+    }
+    return sum;
+}
+
+/**
+ * Computes the phases of the windowed sinc. Phase p of n delays the input
+ * by p/n sample, each one is normalized to a unity gain.
+ */
+static int BankBuild (bank_t *bank, unsigned rows, unsigned phases,
+                      float cutoff)
+{
+    float *coefs = malloc (rows * TAPS * sizeof (*coefs));
+    if (unlikely(coefs == NULL))
+        return VLC_ENOMEM;
+
+    const double i0_beta = BesselI0 (KAISER_BETA);
+
+    for (unsigned p = 0; p < rows; p++)
+    {
+        float *row = &coefs[p * TAPS];
+        double sum = 0.;
+
+        for (unsigned j = 0; j < TAPS; j++)
+        {
+            /* Distance from the output sample, in input samples */
+            const double x = (double)j - (TAPS / 2 - 1) - (double)p / phases;
+            const double u = x / (TAPS / 2);
+            double h = 0.;
+
+            if (fabs (u) < 1.)
+            {
+                const double y = M_PI * cutoff * x;
+                h = cutoff * (y != 0. ? sin (y) / y : 1.)
+                  * BesselI0 (KAISER_BETA * sqrt (1. - u * u)) / i0_beta;
+            }
+            row[j] = h;
+            sum += h;
+        }
+        for (unsigned j = 0; j < TAPS; j++)
+            row[j] /= sum;
+    }
+
+    free (bank->coefs);
+    bank->coefs = coefs;
+    bank->phases = phases;
+    bank->cutoff = cutoff;
+    return VLC_SUCCESS;
+}
+
+/**
+ * Selects the bank for the current input rate, building it if needed.
+ */
+static int Configure (filter_t *filter, unsigned in_rate, unsigned out_rate)
+{
+    filter_sys_t *sys = filter->p_sys;
+    const unsigned gcd = GCD (in_rate, out_rate);
+    const unsigned phases = out_rate / gcd;
+    const float cutoff = CUTOFF * __MIN(1.f, (float)out_rate / in_rate);
+    bool use_exact = phases <= EXACT_PHASES_MAX;
+
+    if (use_exact && (sys->exact.in_rate != in_rate
+                   || sys->exact.out_rate != out_rate))
+    {
+        if (BankBuild (&sys->exact, phases, phases, cutoff))
+            use_exact = false;
+        else
+        {
+            sys->exact.in_rate = in_rate;
+            sys->exact.out_rate = out_rate;
+            msg_Dbg (filter, "%u phases bank for %u -> %u Hz", phases,
+                     in_rate, out_rate);
+        }
+    }
+    if (!use_exact && (sys->interp.coefs == NULL
+                    || fabsf (sys->interp.cutoff - cutoff) > INTERP_CUTOFF_SLACK))
+    {
+        /* One more row to interpolate after the last phase */
+        if (BankBuild (&sys->interp, INTERP_PHASES + 1, INTERP_PHASES, cutoff))
+            return VLC_ENOMEM;
+    }
+
+    /* Convert the position of the next output frame */
+    if (sys->use_exact && !use_exact)
+        sys->frac = ((uint64_t)sys->frac << 32) / sys->exact.phases;
+    else if (!sys->use_exact && use_exact)
+    {
+        sys->frac = ((uint64_t)sys->frac * phases + (1u << 31)) >> 32;
+        if (sys->frac >= phases)
+        {
+            sys->frac = 0;
+            sys->index++;
+        }
+    }
+    else if (sys->use_exact && use_exact && sys->exact.phases != phases)
+        sys->frac = 0; /* exact ratio changed, e.g. playback rate reset */
+
+    sys->use_exact = use_exact;
+    sys->in_rate = in_rate;
+    sys->out_rate = out_rate;
+    return VLC_SUCCESS;
+}
+
+/* Resets the history to silence, centering the first output frame on the
+ * first input frame */
+static void Reset (filter_sys_t *sys, unsigned channels)
+{
+    sys->frames = TAPS / 2 - 1;
+    for (unsigned c = 0; c < channels; c++)
+        memset (&sys->planes[c * sys->plane_size], 0,
+                sys->frames * sizeof (float));
+    sys->index = 0;
+    sys->frac = 0;
+}
+
+/*****************************************************************************
+ * Open/Close
+ *****************************************************************************/
+static int Open (vlc_object_t *obj)
+{
+    filter_t *filter = (filter_t *)obj;
+
+    /* Will change rate */
+    if (filter->fmt_in.audio.i_rate == filter->fmt_out.audio.i_rate
+    /* Cannot convert format */
+     || filter->fmt_in.audio.i_format != VLC_CODEC_FL32
+     || filter->fmt_out.audio.i_format != VLC_CODEC_FL32
+    /* Cannot remix */
+     || filter->fmt_in.audio.i_physical_channels
+                                  != filter->fmt_out.audio.i_physical_channels
+     || filter->fmt_in.audio.i_original_channels
+                                  != filter->fmt_out.audio.i_original_channels)
+        return VLC_EGENERIC;
+
+    filter_sys_t *sys = calloc (1, sizeof (*sys));
+    if (unlikely(sys == NULL))
+        return VLC_ENOMEM;
+
+    const unsigned channels = aout_FormatNbChannels (&filter->fmt_in.audio);
+    sys->plane_size = 4096;
+    sys->planes = malloc (channels * sys->plane_size * sizeof (float));
+    if (unlikely(sys->planes == NULL))
+    {
+        free (sys);
+        return VLC_ENOMEM;
+    }
+    Reset (sys, channels);
+
+#if defined(CAN_COMPILE_AVX2)
+    if (vlc_CPU () & CPU_CAPABILITY_AVX2)
+        sys->dot = DotAVX2;
+    else
+#endif
+#if defined(CAN_COMPILE_SSE)
+    if (vlc_CPU () & CPU_CAPABILITY_SSE)
+        sys->dot = DotSSE;
+    else
+#endif
+#if defined(__ARM_NEON__)
+    if (vlc_CPU () & CPU_CAPABILITY_NEON)
+        sys->dot = DotNEON;
+    else
+#endif
+        sys->dot = DotC;
+
+    /* The audio output sets the actual input rate after opening the
+     * resampler, and changes it to compensate drifts: the banks are built
+     * on the first buffer. */
+    filter->p_sys = sys;
+    filter->pf_audio_filter = Resample;
+    return VLC_SUCCESS;
+}
+
+static void Close (vlc_object_t *obj)
+{
+    filter_t *filter = (filter_t *)obj;
+    filter_sys_t *sys = filter->p_sys;
+
+    free (sys->exact.coefs);
+    free (sys->interp.coefs);
+    free (sys->planes);
+    free (sys);
+}
+
+/*****************************************************************************
+ * Resample
+ *****************************************************************************/
+/* Appends the interleaved input to the channel planes */
+static int Deinterleave (filter_sys_t *sys, const float *in, size_t count,
+                         unsigned channels)
+{
+    if (sys->frames + count > sys->plane_size)
+    {
+        size_t size = sys->frames + count + 1024;
+        float *planes = malloc (channels * size * sizeof (float));
+        if (unlikely(planes == NULL))
+            return VLC_ENOMEM;
+        for (unsigned c = 0; c < channels; c++)
+            memcpy (&planes[c * size], &sys->planes[c * sys->plane_size],
+                    sys->frames * sizeof (float));
+        free (sys->planes);
+        sys->planes = planes;
+        sys->plane_size = size;
+    }
+
+    for (unsigned c = 0; c < channels; c++)
+    {
+        float *plane = &sys->planes[c * sys->plane_size + sys->frames];
+        for (size_t i = 0; i < count; i++)
+            plane[i] = in[i * channels + c];
+    }
+    sys->frames += count;
+    return VLC_SUCCESS;
+}
+
+static block_t *Resample (filter_t *filter, block_t *in)
+{
+    filter_sys_t *sys = filter->p_sys;
+    const unsigned channels = aout_FormatNbChannels (&filter->fmt_in.audio);
+    const unsigned in_rate = filter->fmt_in.audio.i_rate;
+    const unsigned out_rate = filter->fmt_out.audio.i_rate;
+    block_t *out = NULL;
+
+    if (in->i_flags & BLOCK_FLAG_DISCONTINUITY)
+        Reset (sys, channels);
+
+    if ((in_rate != sys->in_rate || out_rate != sys->out_rate)
+     && Configure (filter, in_rate, out_rate))
+        goto error;
+
+    if (Deinterleave (sys, (const float *)in->p_buffer, in->i_nb_samples,
+                      channels))
+        goto error;
+
+    /* Upper bound of the output frames */
+    const size_t max = (uint64_t)(sys->frames + 1) * out_rate / in_rate + 2;
+    out = block_Alloc (max * channels * sizeof (float));
+    if (unlikely(out == NULL))
+        goto error;
+
+    float *dst = (float *)out->p_buffer;
+    size_t count = 0;
+    size_t index = sys->index;
+    uint32_t frac = sys->frac;
+
+    if (sys->use_exact)
+    {
+        /* The input advances by in_rate/out_rate = M/L frames per output
+         * frame, that is M phases */
+        const unsigned phases = sys->exact.phases;
+        const unsigned step = in_rate / GCD (in_rate, out_rate);
+
+        while (index + TAPS <= sys->frames && count < max)
+        {
+            const float *coefs = &sys->exact.coefs[frac * TAPS];
+
+            for (unsigned c = 0; c < channels; c++)
+                *dst++ = sys->dot (coefs,
+                                   &sys->planes[c * sys->plane_size + index]);
+            count++;
+
+            frac += step;
+            index += frac / phases;
+            frac %= phases;
+        }
+    }
+    else
+    {
+        const uint64_t step = ((uint64_t)in_rate << 32) / out_rate;
+        const float *bank = sys->interp.coefs;
+
+        while (index + TAPS <= sys->frames && count < max)
+        {
+            /* Interpolates between the two nearest of the 2^8 phases */
+            const unsigned phase = frac >> 24;
+            const float w = (frac & 0xffffff) * (1.f / (1 << 24));
+            const float *c0 = &bank[phase * TAPS];
+            const float *c1 = c0 + TAPS;
+
+            for (unsigned j = 0; j < TAPS; j++)
+                sys->coefs[j] = c0[j] + w * (c1[j] - c0[j]);
+
+            for (unsigned c = 0; c < channels; c++)
+                *dst++ = sys->dot (sys->coefs,
+                                   &sys->planes[c * sys->plane_size + index]);
+            count++;
+
+            const uint64_t pos = frac + step;
+            index += pos >> 32;
+            frac = pos;
+        }
+    }
+
+    /* Keep the input frames still needed */
+    const size_t consumed = __MIN(index, sys->frames);
+    sys->frames -= consumed;
+    for (unsigned c = 0; c < channels; c++)
+    {
+        float *plane = &sys->planes[c * sys->plane_size];
+        memmove (plane, plane + consumed, sys->frames * sizeof (float));
+    }
+    sys->index = index - consumed;
+    sys->frac = frac;
+
+    out->i_buffer = count * channels * sizeof (float);
+    out->i_nb_samples = count;
+    out->i_pts = in->i_pts;
+    out->i_dts = in->i_dts;
+    out->i_length = count * CLOCK_FREQ / out_rate;
+    out->i_flags = in->i_flags;
+error:
+    block_Release (in);
+    return out;
+}
@@ -32,10 +32,20 @@
 #include <vlc_plugin.h>
 #include <vlc_aout.h>
 #include <vlc_filter.h>
+#include <vlc_cpu.h>
 
 #include <string.h> /* for memset */
 #include <limits.h> /* form INT_MIN */
 
+#if defined(CAN_COMPILE_AVX2)
+#   include <immintrin.h>
+#elif defined(CAN_COMPILE_SSE)
+#   include <xmmintrin.h>
+#endif
+#if defined(__ARM_NEON__)
+#   include <arm_neon.h>
+#endif
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -110,9 +120,101 @@ struct filter_sys_t
     unsigned  frames_search;
     void     *buf_pre_corr;
     void     *table_window;
+    unsigned  frames_search_step;
     unsigned(*best_overlap_offset)( filter_t *p_filter );
+    float   (*corr)( const float *, const float *, unsigned );
 };
 
+/* Searches longer than this many frames are done every
+ * SEARCH_COARSE_STEP frames first, then refined around the best offset */
+#define SEARCH_COARSE_MIN  128
+#define SEARCH_COARSE_STEP 4
+
+/*****************************************************************************
+ * corr: dot product of the pre-correlation and the queue
+ *****************************************************************************/
+static float corr_c( const float *ppc, const float *ps, unsigned count )
+{
+    float corr = 0;
+    for( unsigned i = 0; i < count; i++ )
+        corr += ppc[i] * ps[i];
+    return corr;
+}
+
+#if defined(CAN_COMPILE_SSE)
+VLC_SSE
+static float corr_sse( const float *ppc, const float *ps, unsigned count )
+{
+    __m128 s0 = _mm_setzero_ps(), s1 = _mm_setzero_ps();
+    unsigned i = 0;
+
+    for( ; i + 8 <= count; i += 8 )
+    {
+        s0 = _mm_add_ps( s0, _mm_mul_ps( _mm_loadu_ps( &ppc[i] ),
+                                         _mm_loadu_ps( &ps[i] ) ) );
+        s1 = _mm_add_ps( s1, _mm_mul_ps( _mm_loadu_ps( &ppc[i + 4] ),
+                                         _mm_loadu_ps( &ps[i + 4] ) ) );
+    }
+    s0 = _mm_add_ps( s0, s1 );
+    s0 = _mm_add_ps( s0, _mm_movehl_ps( s0, s0 ) );
+    s0 = _mm_add_ss( s0, _mm_shuffle_ps( s0, s0, 1 ) );
+
+    float corr = _mm_cvtss_f32( s0 );
+    for( ; i < count; i++ )
+        corr += ppc[i] * ps[i];
+    return corr;
+}
+#endif
+
+#if defined(CAN_COMPILE_AVX2)
+VLC_AVX2
+static float corr_avx2( const float *ppc, const float *ps, unsigned count )
+{
+    __m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps();
+    unsigned i = 0;
+
+    for( ; i + 16 <= count; i += 16 )
+    {
+        s0 = _mm256_add_ps( s0, _mm256_mul_ps( _mm256_loadu_ps( &ppc[i] ),
+                                               _mm256_loadu_ps( &ps[i] ) ) );
+        s1 = _mm256_add_ps( s1, _mm256_mul_ps( _mm256_loadu_ps( &ppc[i + 8] ),
+                                               _mm256_loadu_ps( &ps[i + 8] ) ) );
+    }
+    s0 = _mm256_add_ps( s0, s1 );
+
+    __m128 s = _mm_add_ps( _mm256_castps256_ps128( s0 ),
+                           _mm256_extractf128_ps( s0, 1 ) );
+    s = _mm_add_ps( s, _mm_movehl_ps( s, s ) );
+    s = _mm_add_ss( s, _mm_shuffle_ps( s, s, 1 ) );
+
+    float corr = _mm_cvtss_f32( s );
+    for( ; i < count; i++ )
+        corr += ppc[i] * ps[i];
+    return corr;
+}
+#endif
+
+#if defined(__ARM_NEON__)
+static float corr_neon( const float *ppc, const float *ps, unsigned count )
+{
+    float32x4_t s0 = vdupq_n_f32( 0.f ), s1 = vdupq_n_f32( 0.f );
+    unsigned i = 0;
+
+    for( ; i + 8 <= count; i += 8 )
+    {
+        s0 = vmlaq_f32( s0, vld1q_f32( &ppc[i] ), vld1q_f32( &ps[i] ) );
+        s1 = vmlaq_f32( s1, vld1q_f32( &ppc[i + 4] ), vld1q_f32( &ps[i + 4] ) );
+    }
+    s0 = vaddq_f32( s0, s1 );
+
+    float32x2_t s = vadd_f32( vget_low_f32( s0 ), vget_high_f32( s0 ) );
+    float corr = vget_lane_f32( vpadd_f32( s, s ), 0 );
+    for( ; i < count; i++ )
+        corr += ppc[i] * ps[i];
+    return corr;
+}
+#endif
+
 /*****************************************************************************
  * best_overlap_offset: calculate best offset for overlap
  *****************************************************************************/
@@ -123,6 +225,8 @@ static unsigned best_overlap_offset_float( filter_t *p_filter )
     float best_corr = INT_MIN;
     unsigned best_off = 0;
     unsigned i, off;
+    const unsigned count = p->samples_overlap - p->samples_per_frame;
+    const unsigned step = p->frames_search_step;
 
     pw  = p->table_window;
     po  = p->buf_overlap;
@@ -133,18 +237,30 @@ static unsigned best_overlap_offset_float( filter_t *p_filter )
     }
 
     search_start = (float *)p->buf_queue + p->samples_per_frame;
-    for( off = 0; off < p->frames_search; off++ ) {
-      float corr = 0;
-      float *ps = search_start;
-      ppc = p->buf_pre_corr;
-      for( i = p->samples_per_frame; i < p->samples_overlap; i++ ) {
-        corr += *ppc++ * *ps++;
-      }
+    for( off = 0; off < p->frames_search; off += step ) {
+      float corr = p->corr( p->buf_pre_corr,
+                            search_start + off * p->samples_per_frame, count );
       if( corr > best_corr ) {
         best_corr = corr;
         best_off  = off;
       }
-      search_start += p->samples_per_frame;
+    }
+
+    if( step > 1 ) {
+      /* Refine around the best coarse offset */
+      unsigned coarse = best_off;
+      unsigned first = coarse >= step ? coarse - step + 1 : 0;
+      unsigned last  = __MIN( coarse + step, p->frames_search );
+      for( off = first; off < last; off++ ) {
+        if( off == coarse )
+          continue;
+        float corr = p->corr( p->buf_pre_corr,
+                              search_start + off * p->samples_per_frame, count );
+        if( corr > best_corr ) {
+          best_corr = corr;
+          best_off  = off;
+        }
+      }
     }
 
     return best_off * p->bytes_per_frame;
@@ -337,6 +453,8 @@ static int reinit_buffers( filter_t *p_filter )
             for( j = 0; j < p->samples_per_frame; j++ )
                 *pw++ = v;
         }
+        p->frames_search_step = p->frames_search >= SEARCH_COARSE_MIN
+                              ? SEARCH_COARSE_STEP : 1;
         p->best_overlap_offset = best_overlap_offset_float;
     }
 
@@ -413,6 +531,23 @@ static int Open( vlc_object_t *p_this )
 
     p_filter->pf_audio_filter = DoWork;
 
+#if defined(CAN_COMPILE_AVX2)
+    if( vlc_CPU() & CPU_CAPABILITY_AVX2 )
+        p_sys->corr = corr_avx2;
+    else
+#endif
+#if defined(CAN_COMPILE_SSE)
+    if( vlc_CPU() & CPU_CAPABILITY_SSE )
+        p_sys->corr = corr_sse;
+    else
+#endif
+#if defined(__ARM_NEON__)
+    if( vlc_CPU() & CPU_CAPABILITY_NEON )
+        p_sys->corr = corr_neon;
+    else
+#endif
+        p_sys->corr = corr_c;
+
     p_sys->scale             = 1.0;
     p_sys->sample_rate       = p_filter->fmt_in.audio.i_rate;
     p_sys->samples_per_frame = aout_FormatNbChannels( &p_filter->fmt_in.audio );
@@ -34,12 +34,34 @@
 #include <vlc_plugin.h>
 #include <vlc_aout.h>
 #include <vlc_aout_mixer.h>
+#include <vlc_cpu.h>
+
+#if defined(CAN_COMPILE_AVX2) || defined(CAN_COMPILE_AVX512)
+#   include <immintrin.h>
+#elif defined(CAN_COMPILE_SSE)
+#   include <xmmintrin.h>
+#endif
+#if defined(__ARM_NEON__)
+#   include <arm_neon.h>
+#endif
 
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
 static int Create( vlc_object_t * );
 static void DoWork( audio_mixer_t *, aout_buffer_t *, float );
+#if defined(CAN_COMPILE_SSE)
+static void DoWorkSSE( audio_mixer_t *, aout_buffer_t *, float );
+#endif
+#if defined(CAN_COMPILE_AVX2)
+static void DoWorkAVX2( audio_mixer_t *, aout_buffer_t *, float );
+#endif
+#if defined(CAN_COMPILE_AVX512)
+static void DoWorkAVX512( audio_mixer_t *, aout_buffer_t *, float );
+#endif
+#if defined(__ARM_NEON__)
+static void DoWorkNEON( audio_mixer_t *, aout_buffer_t *, float );
+#endif
 
 /*****************************************************************************
  * Module descriptor
@@ -52,6 +74,27 @@ vlc_module_begin ()
     set_callbacks( Create, NULL )
 vlc_module_end ()
 
+/* Implementations, from the most demanding */
+static const struct
+{
+    void   (*func)( audio_mixer_t *, aout_buffer_t *, float );
+    unsigned cpu;
+} mixers[] = {
+#if defined(CAN_COMPILE_AVX512)
+    { DoWorkAVX512, CPU_CAPABILITY_AVX512 },
+#endif
+#if defined(CAN_COMPILE_AVX2)
+    { DoWorkAVX2,   CPU_CAPABILITY_AVX2 },
+#endif
+#if defined(CAN_COMPILE_SSE)
+    { DoWorkSSE,    CPU_CAPABILITY_SSE },
+#endif
+#if defined(__ARM_NEON__)
+    { DoWorkNEON,   CPU_CAPABILITY_NEON },
+#endif
+    { DoWork,       0 },
+};
+
 /**
  * Initializes the mixer
  */
@@ -62,7 +105,7 @@ static int Create( vlc_object_t *p_this )
     if (p_mixer->format != VLC_CODEC_FL32)
         return -1;
 
-    p_mixer->mix = DoWork;
+    p_mixer->mix = vlc_CPU_select( mixers );
     return 0;
 }
 
@@ -81,3 +124,105 @@ static void DoWork( audio_mixer_t * p_mixer, aout_buffer_t *p_buffer,
 
     (void) p_mixer;
 }
+
+#if defined(CAN_COMPILE_SSE)
+VLC_SSE
+static void DoWorkSSE( audio_mixer_t * p_mixer, aout_buffer_t *p_buffer,
+                       float f_multiplier )
+{
+    if( f_multiplier == 1.0 )
+        return; /* nothing to do */
+
+    float *p = (float *)p_buffer->p_buffer;
+    const size_t i_count = p_buffer->i_buffer / sizeof(float);
+    const __m128 mul = _mm_set1_ps( f_multiplier );
+    size_t i = 0;
+
+    for( ; i + 8 <= i_count; i += 8 )
+    {
+        _mm_storeu_ps( &p[i], _mm_mul_ps( _mm_loadu_ps( &p[i] ), mul ) );
+        _mm_storeu_ps( &p[i + 4], _mm_mul_ps( _mm_loadu_ps( &p[i + 4] ), mul ) );
+    }
+    for( ; i < i_count; i++ )
+        p[i] *= f_multiplier;
+
+    (void) p_mixer;
+}
+#endif
+
+#if defined(CAN_COMPILE_AVX2)
+VLC_AVX2
+static void DoWorkAVX2( audio_mixer_t * p_mixer, aout_buffer_t *p_buffer,
+                        float f_multiplier )
+{
+    if( f_multiplier == 1.0 )
+        return; /* nothing to do */
+
+    float *p = (float *)p_buffer->p_buffer;
+    const size_t i_count = p_buffer->i_buffer / sizeof(float);
+    const __m256 mul = _mm256_set1_ps( f_multiplier );
+    size_t i = 0;
+
+    for( ; i + 16 <= i_count; i += 16 )
+    {
+        _mm256_storeu_ps( &p[i],
+                          _mm256_mul_ps( _mm256_loadu_ps( &p[i] ), mul ) );
+        _mm256_storeu_ps( &p[i + 8],
+                          _mm256_mul_ps( _mm256_loadu_ps( &p[i + 8] ), mul ) );
+    }
+    for( ; i < i_count; i++ )
+        p[i] *= f_multiplier;
+
+    (void) p_mixer;
+}
+#endif
+
+#if defined(CAN_COMPILE_AVX512)
+VLC_AVX512
+static void DoWorkAVX512( audio_mixer_t * p_mixer, aout_buffer_t *p_buffer,
+                          float f_multiplier )
+{
+    if( f_multiplier == 1.0 )
+        return; /* nothing to do */
+
+    float *p = (float *)p_buffer->p_buffer;
+    const size_t i_count = p_buffer->i_buffer / sizeof(float);
+    const __m512 mul = _mm512_set1_ps( f_multiplier );
+    size_t i = 0;
+
+    for( ; i + 16 <= i_count; i += 16 )
+        _mm512_storeu_ps( &p[i],
+                          _mm512_mul_ps( _mm512_loadu_ps( &p[i] ), mul ) );
+    if( i < i_count )
+    {   /* masked tail */
+        const __mmask16 mask = (1 << (i_count - i)) - 1;
+        _mm512_mask_storeu_ps( &p[i], mask,
+            _mm512_mul_ps( _mm512_maskz_loadu_ps( mask, &p[i] ), mul ) );
+    }
+
+    (void) p_mixer;
+}
+#endif
+
+#if defined(__ARM_NEON__)
+static void DoWorkNEON( audio_mixer_t * p_mixer, aout_buffer_t *p_buffer,
+                        float f_multiplier )
+{
+    if( f_multiplier == 1.0 )
+        return; /* nothing to do */
+
+    float *p = (float *)p_buffer->p_buffer;
+    const size_t i_count = p_buffer->i_buffer / sizeof(float);
+    size_t i = 0;
+
+    for( ; i + 8 <= i_count; i += 8 )
+    {
+        vst1q_f32( &p[i], vmulq_n_f32( vld1q_f32( &p[i] ), f_multiplier ) );
+        vst1q_f32( &p[i + 4], vmulq_n_f32( vld1q_f32( &p[i + 4] ), f_multiplier ) );
+    }
+    for( ; i < i_count; i++ )
+        p[i] *= f_multiplier;
+
+    (void) p_mixer;
+}
+#endif
@@ -235,7 +235,7 @@ static int Open (vlc_object_t *obj)
             pcm_format = SND_PCM_FORMAT_U8;
             break;
         default:
-            if (AOUT_FMT_SPDIF(&aout->format))
+            if (AOUT_FMT_SPDIF(&aout->format) || AOUT_FMT_HDMI(&aout->format))
                 spdif = var_InheritBool (aout, "spdif");
             if (spdif)
             {
@@ -269,6 +269,25 @@ static int Open (vlc_object_t *obj)
     else
         msg_Dbg (aout, "keeping %u channels", channels);
 
+    /* IEC 61937 link parameters: high bitrate formats need HDMI, that is
+     * four times the sample rate, or eight channels at 192 kHz */
+    unsigned link_rate = aout->format.i_rate;
+    bool hdmi = spdif && AOUT_FMT_HDMI(&aout->format);
+    if (hdmi)
+    {
+        if (aout->format.i_format == VLC_CODEC_EAC3)
+        {
+            map = AOUT_CHANS_STEREO;
+            link_rate *= 4;
+        }
+        else
+        {
+            map = AOUT_CHANS_7_1;
+            link_rate = 192000;
+        }
+        channels = popcount (map);
+    }
+
     /* Choose the IEC device for S/PDIF output:
        if the device is overridden by the user then it will be the one.
        Otherwise we compute the default device based on the output format. */
@@ -276,7 +295,8 @@ static int Open (vlc_object_t *obj)
     {
         unsigned aes3;
 
-        switch (aout->format.i_rate)
+        /* Eight channels links are signaled at four times their rate */
+        switch (channels == 8 ? 4 * link_rate : link_rate)
         {
 #define FS(freq) \
             case freq: aes3 = IEC958_AES3_CON_FS_ ## freq; break;
@@ -292,7 +312,8 @@ static int Open (vlc_object_t *obj)
 
         free (device);
         if (asprintf (&device,
-                      "iec958:AES0=0x%x,AES1=0x%x,AES2=0x%x,AES3=0x%x",
+                      "%s:AES0=0x%x,AES1=0x%x,AES2=0x%x,AES3=0x%x",
+                      hdmi ? "hdmi" : "iec958",
                       IEC958_AES0_CON_EMPHASIS_NONE | IEC958_AES0_NONAUDIO,
                       IEC958_AES1_CON_ORIGINAL | IEC958_AES1_CON_PCM_CODER,
                       0, aes3) == -1)
@@ -424,16 +445,15 @@ static int Open (vlc_object_t *obj)
     }
 
     /* Set sample rate */
-    unsigned rate = aout->format.i_rate;
+    unsigned rate = link_rate;
     val = snd_pcm_hw_params_set_rate_near (pcm, hw, &rate, NULL);
     if (val)
     {
         msg_Err (aout, "cannot set sample rate: %s", snd_strerror (val));
         goto error;
     }
-    if (aout->format.i_rate != rate)
-        msg_Dbg (aout, "resampling from %d Hz to %d Hz",
-                 aout->format.i_rate, rate);
+    if (link_rate != rate)
+        msg_Dbg (aout, "resampling from %d Hz to %d Hz", link_rate, rate);
 
     /* Set buffer size */
     param = AOUT_MAX_ADVANCE_TIME;
@@ -513,8 +533,11 @@ static int Open (vlc_object_t *obj)
     aout->format.i_rate = rate;
     if (spdif)
     {
-        aout->format.i_bytes_per_frame = AOUT_SPDIF_SIZE;
+        aout->format.i_bytes_per_frame = AOUT_SPDIF_SIZE * channels / 2;
         aout->format.i_frame_length = A52_FRAME_NB;
+        if (hdmi)
+            aout->format.i_original_channels =
+            aout->format.i_physical_channels = map;
         aout_VolumeNoneInit (aout);
     }
     else
@@ -37,6 +37,7 @@
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_aout.h>
+#include <vlc_atomic.h>
 
 #include <jack/jack.h>
 
@@ -50,12 +51,13 @@ typedef jack_default_audio_sample_t jack_sample_t;
  *****************************************************************************/
 struct aout_sys_t
 {
-    aout_packet_t   packet;
+    aout_ring_t     ring;
     jack_client_t  *p_jack_client;
     jack_port_t   **p_jack_ports;
     jack_sample_t **p_jack_buffers;
+    jack_sample_t  *p_scratch; /* interleaved samples from the ring */
+    jack_nframes_t  i_scratch; /* frames */
     unsigned int    i_channels;
-    jack_nframes_t latency;
 };
 
 /*****************************************************************************
@@ -114,7 +116,6 @@ static int Open( vlc_object_t *p_this )
         goto error_out;
     }
     p_aout->sys = p_sys;
-    p_sys->latency = 0;
 
     /* Connect to the JACK server */
     snprintf( psz_name, sizeof(psz_name), "vlc_%d", getpid());
@@ -138,14 +139,29 @@ static int Open( vlc_object_t *p_this )
     // TODO add buffer size callback
     p_aout->format.i_rate = jack_get_sample_rate( p_sys->p_jack_client );
 
-    p_aout->pf_play = aout_PacketPlay;
-    p_aout->pf_pause = aout_PacketPause;
-    p_aout->pf_flush = aout_PacketFlush;
-    aout_PacketInit( p_aout, &p_sys->packet,
-                     jack_get_buffer_size( p_sys->p_jack_client ) );
+    p_sys->i_channels = aout_FormatNbChannels( &p_aout->format );
+
+    /* The process callback reads from a lock-free ring buffer */
+    if( aout_RingInit( p_aout, &p_sys->ring, AOUT_MAX_PREPARE_TIME
+                                             + AOUT_MAX_PTS_DELAY ) )
+    {
+        status = VLC_ENOMEM;
+        goto error_out;
+    }
+    p_aout->pf_play = aout_RingPlay;
+    p_aout->pf_pause = aout_RingPause;
+    p_aout->pf_flush = aout_RingFlush;
+    p_aout->pf_time_get = aout_RingTimeGet;
     aout_VolumeSoftInit( p_aout );
 
-    p_sys->i_channels = aout_FormatNbChannels( &p_aout->format );
+    p_sys->i_scratch = jack_get_buffer_size( p_sys->p_jack_client );
+    p_sys->p_scratch = malloc( p_sys->i_scratch * p_sys->i_channels *
+                               sizeof(jack_sample_t) );
+    if( p_sys->p_scratch == NULL )
+    {
+        status = VLC_ENOMEM;
+        goto error_out;
+    }
 
     p_sys->p_jack_ports = malloc( p_sys->i_channels *
                                   sizeof(jack_port_t *) );
@@ -236,8 +252,9 @@ error_out:
         {
             jack_deactivate( p_sys->p_jack_client );
             jack_client_close( p_sys->p_jack_client );
-            aout_PacketDestroy( p_aout );
         }
+        aout_RingDestroy( p_aout );
+        free( p_sys->p_scratch );
         free( p_sys->p_jack_ports );
         free( p_sys->p_jack_buffers );
         free( p_sys );
@@ -251,25 +268,9 @@ error_out:
  *****************************************************************************/
 int Process( jack_nframes_t i_frames, void *p_arg )
 {
-    unsigned int i, j, i_nb_samples = 0;
+    unsigned int i, j;
     audio_output_t *p_aout = (audio_output_t*) p_arg;
     struct aout_sys_t *p_sys = p_aout->sys;
-    jack_sample_t *p_src = NULL;
-
-    jack_nframes_t dframes = p_sys->latency
-                             - jack_frames_since_cycle_start( p_sys->p_jack_client );
-
-    jack_time_t dtime = dframes * 1000 * 1000 / jack_get_sample_rate( p_sys->p_jack_client );
-    mtime_t play_date = mdate() + (mtime_t) ( dtime );
-
-    /* Get the next audio data buffer */
-    aout_buffer_t *p_buffer = aout_PacketNext( p_aout, play_date );
-
-    if( p_buffer != NULL )
-    {
-        p_src = (jack_sample_t *)p_buffer->p_buffer;
-        i_nb_samples = p_buffer->i_nb_samples;
-    }
 
     /* Get the JACK buffers to write to */
     for( i = 0; i < p_sys->i_channels; i++ )
@@ -278,30 +279,23 @@ int Process( jack_nframes_t i_frames, void *p_arg )
                                                          i_frames );
     }
 
-    /* Copy in the audio data */
-    for( j = 0; j < i_nb_samples; j++ )
+    /* Copy in the audio data, without locking nor allocating */
+    for( jack_nframes_t i_done = 0; i_done < i_frames; )
     {
-        for( i = 0; i < p_sys->i_channels; i++ )
-        {
-            jack_sample_t *p_dst = p_sys->p_jack_buffers[i];
-            p_dst[j] = *p_src;
-            p_src++;
-        }
-    }
+        jack_nframes_t i_count = __MIN( i_frames - i_done, p_sys->i_scratch );
+        const jack_sample_t *p_src = p_sys->p_scratch;
 
-    /* Fill any remaining buffer with silence */
-    if( i_nb_samples < i_frames )
-    {
-        for( i = 0; i < p_sys->i_channels; i++ )
+        aout_RingRead( p_aout, p_sys->p_scratch, i_count );
+        for( j = i_done; j < i_done + i_count; j++ )
         {
-            memset( p_sys->p_jack_buffers[i] + i_nb_samples, 0,
-                    sizeof( jack_sample_t ) * (i_frames - i_nb_samples) );
+            for( i = 0; i < p_sys->i_channels; i++ )
+            {
+                jack_sample_t *p_dst = p_sys->p_jack_buffers[i];
+                p_dst[j] = *p_src;
+                p_src++;
+            }
         }
-    }
-
-    if( p_buffer )
-    {
-        aout_BufferFree( p_buffer );
+        i_done += i_count;
     }
     return 0;
 }
@@ -316,18 +310,18 @@ static int GraphChange( void *p_arg )
   audio_output_t *p_aout = (audio_output_t*) p_arg;
   struct aout_sys_t *p_sys = p_aout->sys;
   unsigned int i;
-  jack_nframes_t port_latency;
-
-  p_sys->latency = 0;
+  jack_nframes_t port_latency, latency = 0;
 
   for( i = 0; i < p_sys->i_channels; ++i )
   {
     port_latency = jack_port_get_total_latency( p_sys->p_jack_client,
                                                   p_sys->p_jack_ports[i] );
-    p_sys->latency = __MAX( p_sys->latency, port_latency );
+    latency = __MAX( latency, port_latency );
   }
 
-  msg_Dbg(p_aout, "JACK graph reordered. Our maximum latency=%d.", p_sys->latency);
+  vlc_atomic_set( &p_sys->ring.latency,
+                  (uint64_t)latency * CLOCK_FREQ / p_aout->format.i_rate );
+  msg_Dbg(p_aout, "JACK graph reordered. Our maximum latency=%d.", latency);
 
   return 0;
 }
@@ -354,6 +348,7 @@ static void Close( vlc_object_t *p_this )
     }
     free( p_sys->p_jack_ports );
     free( p_sys->p_jack_buffers );
-    aout_PacketDestroy( p_aout );
+    free( p_sys->p_scratch );
+    aout_RingDestroy( p_aout );
     free( p_sys );
 }
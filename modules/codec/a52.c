@@ -51,6 +51,8 @@ static void CloseCommon   ( vlc_object_t * );
 vlc_module_begin ()
     set_description( N_("A/52 parser") )
     set_capability( "decoder", 100 )
+    add_codec( VLC_CODEC_A52 )
+    add_codec( VLC_CODEC_EAC3 )
     set_callbacks( OpenDecoder, CloseCommon )
     set_category( CAT_INPUT )
     set_subcategory( SUBCAT_INPUT_ACODEC )
@@ -58,6 +60,8 @@ vlc_module_begin ()
     add_submodule ()
     set_description( N_("A/52 audio packetizer") )
     set_capability( "packetizer", 10 )
+    add_codec( VLC_CODEC_A52 )
+    add_codec( VLC_CODEC_EAC3 )
     set_callbacks( OpenPacketizer, CloseCommon )
 vlc_module_end ()
 
@@ -111,10 +115,6 @@ static int OpenCommon( vlc_object_t *p_this, bool b_packetizer )
         i_codec = VLC_CODEC_A52;
         break;
     case VLC_CODEC_EAC3:
-        /* XXX ugly hack, a52 does not support eac3 so no eac3 pass-through
-         * support */
-        if( !b_packetizer )
-            return VLC_EGENERIC;
         i_codec = VLC_CODEC_EAC3;
         break;
     default:
@@ -150,8 +150,13 @@ static int OpenCommon( vlc_object_t *p_this, bool b_packetizer )
 
 static int OpenDecoder( vlc_object_t *p_this )
 {
-    /* HACK: Don't use this codec if we don't have an a52 audio filter */
-    if( !module_exists( "a52tofloat32" ) )
+    decoder_t *p_dec = (decoder_t*)p_this;
+
+    /* HACK: Don't use this codec if we don't have an a52 audio filter.
+     * E-AC3 cannot be decoded by liba52, only passed through. */
+    if( p_dec->fmt_in.i_codec == VLC_CODEC_EAC3
+        ? !var_InheritBool( p_dec, "spdif" )
+        : !module_exists( "a52tofloat32" ) )
         return VLC_EGENERIC;
     return OpenCommon( p_this, false );
 }
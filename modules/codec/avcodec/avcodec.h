@@ -141,7 +141,8 @@ int ffmpeg_OpenCodec( decoder_t *p_dec );
 #define HW_LONGTEXT N_("This allows hardware decoding when available.")
 
 #define THREADS_TEXT N_( "Threads" )
-#define THREADS_LONGTEXT N_( "Number of threads used for decoding, 0 meaning auto" )
+#define THREADS_LONGTEXT N_( "Number of threads used for decoding, 0 meaning auto. " \
+    "In auto, the video decoders share the CPUs between them." )
 
 /*
  * Encoder options
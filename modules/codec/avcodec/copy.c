@@ -169,6 +169,10 @@ static void SSE_SplitUV(uint8_t *dstu, size_t dstu_pitch,
     for (unsigned y = 0; y < height; y++) {
         unsigned x = 0;
 
+        /* The planes go out of the cache with streaming stores when they
+         * are aligned, as no one reads them before the display */
+        const bool aligned = (((intptr_t)dstu | (intptr_t)dstv) & 0x0f) == 0;
+
 #define LOAD64 \
     "movdqa  0(%[src]), %%xmm0\n" \
     "movdqa 16(%[src]), %%xmm1\n" \
@@ -185,45 +189,75 @@ static void SSE_SplitUV(uint8_t *dstu, size_t dstu_pitch,
     "movhpd %%xmm2,  16(%[dst2])\n" \
     "movhpd %%xmm3,  24(%[dst2])\n"
 
+/* Same, gathering the halves into 16 bytes streaming stores */
+#define STORE2X32_NT \
+    "movdqa     %%xmm0, %%xmm4\n" \
+    "movdqa     %%xmm2, %%xmm5\n" \
+    "punpcklqdq %%xmm1, %%xmm0\n" \
+    "punpckhqdq %%xmm1, %%xmm4\n" \
+    "punpcklqdq %%xmm3, %%xmm2\n" \
+    "punpckhqdq %%xmm3, %%xmm5\n" \
+    "movntdq    %%xmm0,  0(%[dst1])\n" \
+    "movntdq    %%xmm2, 16(%[dst1])\n" \
+    "movntdq    %%xmm4,  0(%[dst2])\n" \
+    "movntdq    %%xmm5, 16(%[dst2])\n"
+
+#define SHUFFLE32(store) \
+    asm volatile ( \
+        "movdqu (%[shuffle]), %%xmm7\n" \
+        LOAD64 \
+        "pshufb  %%xmm7, %%xmm0\n" \
+        "pshufb  %%xmm7, %%xmm1\n" \
+        "pshufb  %%xmm7, %%xmm2\n" \
+        "pshufb  %%xmm7, %%xmm3\n" \
+        store \
+        : : [dst1]"r"(&dstu[x]), [dst2]"r"(&dstv[x]), [src]"r"(&src[2*x]), [shuffle]"r"(shuffle) : "memory", "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm7")
+
+#define MASK32(store) \
+    asm volatile ( \
+        "movdqu (%[mask]), %%xmm7\n" \
+        LOAD64 \
+        "movdqa   %%xmm0, %%xmm4\n" \
+        "movdqa   %%xmm1, %%xmm5\n" \
+        "movdqa   %%xmm2, %%xmm6\n" \
+        "psrlw    $8,     %%xmm0\n" \
+        "psrlw    $8,     %%xmm1\n" \
+        "pand     %%xmm7, %%xmm4\n" \
+        "pand     %%xmm7, %%xmm5\n" \
+        "pand     %%xmm7, %%xmm6\n" \
+        "packuswb %%xmm4, %%xmm0\n" \
+        "packuswb %%xmm5, %%xmm1\n" \
+        "pand     %%xmm3, %%xmm7\n" \
+        "psrlw    $8,     %%xmm2\n" \
+        "psrlw    $8,     %%xmm3\n" \
+        "packuswb %%xmm6, %%xmm2\n" \
+        "packuswb %%xmm7, %%xmm3\n" \
+        store \
+        : : [dst2]"r"(&dstu[x]), [dst1]"r"(&dstv[x]), [src]"r"(&src[2*x]), [mask]"r"(mask) : "memory", "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm6", "xmm7")
+
 #ifdef CAN_COMPILE_SSSE3
         if (cpu & CPU_CAPABILITY_SSSE3) {
-            for (x = 0; x < (width & ~31); x += 32) {
-                asm volatile (
-                    "movdqu (%[shuffle]), %%xmm7\n"
-                    LOAD64
-                    "pshufb  %%xmm7, %%xmm0\n"
-                    "pshufb  %%xmm7, %%xmm1\n"
-                    "pshufb  %%xmm7, %%xmm2\n"
-                    "pshufb  %%xmm7, %%xmm3\n"
-                    STORE2X32
-                    : : [dst1]"r"(&dstu[x]), [dst2]"r"(&dstv[x]), [src]"r"(&src[2*x]), [shuffle]"r"(shuffle) : "memory", "xmm0", "xmm1", "xmm2", "xmm3", "xmm7");
+            if (aligned) {
+                for (x = 0; x < (width & ~31); x += 32)
+                    SHUFFLE32(STORE2X32_NT);
+            } else {
+                for (x = 0; x < (width & ~31); x += 32)
+                    SHUFFLE32(STORE2X32);
             }
         } else
 #endif
         {
-            for (x = 0; x < (width & ~31); x += 32) {
-                asm volatile (
-                    "movdqu (%[mask]), %%xmm7\n"
-                    LOAD64
-                    "movdqa   %%xmm0, %%xmm4\n"
-                    "movdqa   %%xmm1, %%xmm5\n"
-                    "movdqa   %%xmm2, %%xmm6\n"
-                    "psrlw    $8,     %%xmm0\n"
-                    "psrlw    $8,     %%xmm1\n"
-                    "pand     %%xmm7, %%xmm4\n"
-                    "pand     %%xmm7, %%xmm5\n"
-                    "pand     %%xmm7, %%xmm6\n"
-                    "packuswb %%xmm4, %%xmm0\n"
-                    "packuswb %%xmm5, %%xmm1\n"
-                    "pand     %%xmm3, %%xmm7\n"
-                    "psrlw    $8,     %%xmm2\n"
-                    "psrlw    $8,     %%xmm3\n"
-                    "packuswb %%xmm6, %%xmm2\n"
-                    "packuswb %%xmm7, %%xmm3\n"
-                    STORE2X32
-                    : : [dst2]"r"(&dstu[x]), [dst1]"r"(&dstv[x]), [src]"r"(&src[2*x]), [mask]"r"(mask) : "memory", "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm6", "xmm7");
+            if (aligned) {
+                for (x = 0; x < (width & ~31); x += 32)
+                    MASK32(STORE2X32_NT);
+            } else {
+                for (x = 0; x < (width & ~31); x += 32)
+                    MASK32(STORE2X32);
             }
         }
+#undef MASK32
+#undef SHUFFLE32
+#undef STORE2X32_NT
 #undef STORE2X32
 #undef LOAD64
 
@@ -396,5 +430,5 @@ void CopyFromYv12(picture_t *dst, uint8_t *src[3], size_t src_pitch[3],
      CopyPlane(dst->p[1].p_pixels, dst->p[1].i_pitch,
                src[1], src_pitch[1], width / 2, height / 2);
      CopyPlane(dst->p[2].p_pixels, dst->p[2].i_pitch,
-               src[1], src_pitch[2], width / 2, height / 2);
+               src[2], src_pitch[2], width / 2, height / 2);
 }
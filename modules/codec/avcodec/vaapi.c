@@ -85,6 +85,9 @@ typedef struct
     VAImage      image;
     copy_cache_t image_cache;
 
+    /* the surfaces can be mapped without a vaGetImage() copy */
+    bool         b_derive;
+
 } vlc_va_vaapi_t;
 
 static vlc_va_vaapi_t *vlc_va_vaapi_Get( void *p_va )
@@ -310,6 +313,18 @@ static int CreateSurfaces( vlc_va_vaapi_t *p_va, void **pp_hw_ctx, vlc_fourcc_t
         goto error;
     *pi_chroma = i_chroma;
 
+    /* Mapping the surface saves the copy into our image, which is the
+     * larger part of the read back, but not all the drivers can */
+    VAImage derived;
+    p_va->b_derive = false;
+    if( !vaDeriveImage( p_va->p_display, pi_surface_id[0], &derived ) )
+    {
+        p_va->b_derive = derived.format.fourcc == VA_FOURCC( 'Y', 'V', '1', '2' ) ||
+                         derived.format.fourcc == VA_FOURCC( 'I', '4', '2', '0' ) ||
+                         derived.format.fourcc == VA_FOURCC( 'N', 'V', '1', '2' );
+        vaDestroyImage( p_va->p_display, derived.image_id );
+    }
+
     if( unlikely(CopyInitCache( &p_va->image_cache, i_width )) )
         goto error;
 
@@ -368,20 +383,28 @@ static int Extract( vlc_va_t *p_external, picture_t *p_picture, AVFrame *p_ff )
 #endif
         return VLC_EGENERIC;
 
-    /* XXX vaDeriveImage may be better but it is not supported by
-     * my setup.
-     */
-
-    if( vaGetImage( p_va->p_display, i_surface_id,
-                    0, 0, p_va->i_surface_width, p_va->i_surface_height,
-                    p_va->image.image_id) )
-        return VLC_EGENERIC;
+    /* Map the surface itself when possible, else copy it into our image */
+    VAImage image;
+    bool b_derived = p_va->b_derive &&
+                     !vaDeriveImage( p_va->p_display, i_surface_id, &image );
+    if( !b_derived )
+    {
+        if( vaGetImage( p_va->p_display, i_surface_id,
+                        0, 0, p_va->i_surface_width, p_va->i_surface_height,
+                        p_va->image.image_id) )
+            return VLC_EGENERIC;
+        image = p_va->image;
+    }
 
     void *p_base;
-    if( vaMapBuffer( p_va->p_display, p_va->image.buf, &p_base ) )
+    if( vaMapBuffer( p_va->p_display, image.buf, &p_base ) )
+    {
+        if( b_derived )
+            vaDestroyImage( p_va->p_display, image.image_id );
         return VLC_EGENERIC;
+    }
 
-    const uint32_t i_fourcc = p_va->image.format.fourcc;
+    const uint32_t i_fourcc = image.format.fourcc;
     if( i_fourcc == VA_FOURCC('Y','V','1','2') ||
         i_fourcc == VA_FOURCC('I','4','2','0') )
     {
@@ -392,8 +415,8 @@ static int Extract( vlc_va_t *p_external, picture_t *p_picture, AVFrame *p_ff )
         for( int i = 0; i < 3; i++ )
         {
             const int i_src_plane = (b_swap_uv && i != 0) ?  (3 - i) : i;
-            pp_plane[i] = (uint8_t*)p_base + p_va->image.offsets[i_src_plane];
-            pi_pitch[i] = p_va->image.pitches[i_src_plane];
+            pp_plane[i] = (uint8_t*)p_base + image.offsets[i_src_plane];
+            pi_pitch[i] = image.pitches[i_src_plane];
         }
         CopyFromYv12( p_picture, pp_plane, pi_pitch,
                       p_va->i_surface_width,
@@ -408,8 +431,8 @@ static int Extract( vlc_va_t *p_external, picture_t *p_picture, AVFrame *p_ff )
 
         for( int i = 0; i < 2; i++ )
         {
-            pp_plane[i] = (uint8_t*)p_base + p_va->image.offsets[i];
-            pi_pitch[i] = p_va->image.pitches[i];
+            pp_plane[i] = (uint8_t*)p_base + image.offsets[i];
+            pi_pitch[i] = image.pitches[i];
         }
         CopyFromNv12( p_picture, pp_plane, pi_pitch,
                       p_va->i_surface_width,
@@ -417,10 +440,13 @@ static int Extract( vlc_va_t *p_external, picture_t *p_picture, AVFrame *p_ff )
                       &p_va->image_cache );
     }
 
-    if( vaUnmapBuffer( p_va->p_display, p_va->image.buf ) )
-        return VLC_EGENERIC;
+    int i_ret = VLC_SUCCESS;
+    if( vaUnmapBuffer( p_va->p_display, image.buf ) )
+        i_ret = VLC_EGENERIC;
+    if( b_derived )
+        vaDestroyImage( p_va->p_display, image.image_id );
 
-    return VLC_SUCCESS;
+    return i_ret;
 }
 static int Get( vlc_va_t *p_external, AVFrame *p_ff )
 {
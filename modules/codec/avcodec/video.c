@@ -87,6 +87,12 @@ struct decoder_sys_t
     int     i_late_frames;
     mtime_t i_late_frames_start;
 
+    /* what decoding a frame takes, and the skipping it calls for */
+    mtime_t i_decode_time;
+    mtime_t i_decode_spent;
+    int     i_skip_level;
+    enum AVDiscard i_skip_loop_filter;
+
     /* for direct rendering */
     bool b_direct_rendering;
     int  i_direct_rendering_used;
@@ -111,16 +117,38 @@ struct decoder_sys_t
     vlc_va_t *p_va;
 
     vlc_sem_t sem_mt;
+
+    /* counted in auto_threads_decoders */
+    bool b_auto_threads;
 };
 
 #ifdef HAVE_AVCODEC_MT
 #   define wait_mt(s) vlc_sem_wait( &s->sem_mt )
 #   define post_mt(s) vlc_sem_post( &s->sem_mt )
+
+/* The decoders with an automatic thread count share the CPUs, so that
+ * many of them (mosaic, multiview) do not add up to hundreds of threads */
+static vlc_mutex_t auto_threads_lock = VLC_STATIC_MUTEX;
+static unsigned auto_threads_decoders = 0;
+
+static void ReleaseAutoThreads( decoder_sys_t *p_sys )
+{
+    if( !p_sys->b_auto_threads )
+        return;
+    vlc_mutex_lock( &auto_threads_lock );
+    auto_threads_decoders--;
+    vlc_mutex_unlock( &auto_threads_lock );
+    p_sys->b_auto_threads = false;
+}
 #else
 #   define wait_mt(s)
 #   define post_mt(s)
 #endif
 
+/* Frame skipping levels, see DecodeVideo() */
+#define SKIP_LEVEL_NONREF 4
+#define SKIP_LEVEL_MAX    8
+
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
@@ -258,6 +286,7 @@ int InitVideoDec( decoder_t *p_dec, AVCodecContext *p_context,
     else if( i_val == 3 ) p_sys->p_context->skip_loop_filter = AVDISCARD_NONKEY;
     else if( i_val == 2 ) p_sys->p_context->skip_loop_filter = AVDISCARD_BIDIR;
     else if( i_val == 1 ) p_sys->p_context->skip_loop_filter = AVDISCARD_NONREF;
+    p_sys->i_skip_loop_filter = p_sys->p_context->skip_loop_filter;
 
     if( var_CreateGetBool( p_dec, "ffmpeg-fast" ) )
         p_sys->p_context->flags2 |= CODEC_FLAG2_FAST;
@@ -354,7 +383,12 @@ int InitVideoDec( decoder_t *p_dec, AVCodecContext *p_context,
     int i_thread_count = var_InheritInteger( p_dec, "ffmpeg-threads" );
     if( i_thread_count <= 0 )
     {
-        i_thread_count = vlc_GetCPUCount();
+        vlc_mutex_lock( &auto_threads_lock );
+        const unsigned i_decoders = ++auto_threads_decoders;
+        vlc_mutex_unlock( &auto_threads_lock );
+        p_sys->b_auto_threads = true;
+
+        i_thread_count = __MAX( vlc_GetCPUCount() / i_decoders, 1 );
         if( i_thread_count > 1 )
             i_thread_count++;
 
@@ -453,6 +487,9 @@ int InitVideoDec( decoder_t *p_dec, AVCodecContext *p_context,
     if( ffmpeg_OpenCodec( p_dec ) < 0 )
     {
         msg_Err( p_dec, "cannot open codec (%s)", p_sys->psz_namecodec );
+#ifdef HAVE_AVCODEC_MT
+        ReleaseAutoThreads( p_sys );
+#endif
         av_free( p_sys->p_ff_pic );
         vlc_sem_destroy( &p_sys->sem_mt );
         free( p_sys );
@@ -498,6 +535,7 @@ picture_t *DecodeVideo( decoder_t *p_dec, block_t **pp_block )
         p_sys->i_pts = VLC_TS_INVALID; /* To make sure we recover properly */
 
         p_sys->i_late_frames = 0;
+        p_sys->i_skip_level = 0;
 
         if( p_block->i_flags & BLOCK_FLAG_DISCONTINUITY )
             avcodec_flush_buffers( p_context );
@@ -528,31 +566,50 @@ picture_t *DecodeVideo( decoder_t *p_dec, block_t **pp_block )
         return NULL;
     }
 
-    /* A good idea could be to decode all I pictures and see for the other */
-    if( !p_dec->b_pace_control &&
-        p_sys->b_hurry_up &&
-        (p_sys->i_late_frames > 4) )
+    /* A frame that would be displayed past its date once decoded raises
+     * the skipping level, one in time by a decoding time more lowers it,
+     * a step per frame. From 1 the loop filter of the non reference frames
+     * is skipped, from SKIP_LEVEL_NONREF these frames are not decoded. */
+    if( !p_dec->b_pace_control && p_sys->b_hurry_up &&
+        !(p_block->i_flags & BLOCK_FLAG_PREROLL) )
     {
-        b_drawpicture = 0;
-        if( p_sys->i_late_frames < 12 )
-        {
-            p_context->skip_frame =
-                    (p_sys->i_skip_frame <= AVDISCARD_NONREF) ?
-                    AVDISCARD_NONREF : p_sys->i_skip_frame;
-        }
-        else
+        const mtime_t i_ts = p_block->i_pts > VLC_TS_INVALID ?
+                             p_block->i_pts : p_block->i_dts;
+        const mtime_t i_date = i_ts > VLC_TS_INVALID ?
+                               decoder_GetDisplayDate( p_dec, i_ts ) : 0;
+        if( i_date > 0 )
         {
-            /* picture too late, won't decode
-             * but break picture until a new I, and for mpeg4 ...*/
-            p_sys->i_late_frames--; /* needed else it will never be decrease */
-            block_Release( p_block );
-            return NULL;
+            const mtime_t i_margin = i_date - mdate() - p_sys->i_decode_time;
+
+            if( i_margin < 0 )
+                p_sys->i_skip_level = __MIN( p_sys->i_skip_level + 1,
+                                             SKIP_LEVEL_MAX );
+            else if( i_margin > p_sys->i_decode_time && p_sys->i_skip_level > 0 )
+                p_sys->i_skip_level--;
         }
     }
+
+    if( !p_dec->b_pace_control &&
+        p_sys->b_hurry_up &&
+        (p_sys->i_late_frames >= 12) )
+    {
+        /* picture too late, won't decode
+         * but break picture until a new I, and for mpeg4 ...*/
+        p_sys->i_late_frames--; /* needed else it will never be decrease */
+        block_Release( p_block );
+        return NULL;
+    }
     else
     {
         if( p_sys->b_hurry_up )
-            p_context->skip_frame = p_sys->i_skip_frame;
+        {
+            p_context->skip_loop_filter = p_sys->i_skip_level > 0 ?
+                __MAX( p_sys->i_skip_loop_filter, AVDISCARD_NONREF ) :
+                p_sys->i_skip_loop_filter;
+            p_context->skip_frame = p_sys->i_skip_level >= SKIP_LEVEL_NONREF ?
+                __MAX( p_sys->i_skip_frame, AVDISCARD_NONREF ) :
+                p_sys->i_skip_frame;
+        }
         if( !(p_block->i_flags & BLOCK_FLAG_PREROLL) )
             b_drawpicture = 1;
         else
@@ -619,6 +676,7 @@ picture_t *DecodeVideo( decoder_t *p_dec, block_t **pp_block )
         av_init_packet( &pkt );
         pkt.data = p_block->p_buffer;
         pkt.size = p_block->i_buffer;
+        const mtime_t i_decode_start = mdate();
         i_used = avcodec_decode_video2( p_context, p_sys->p_ff_pic,
                                        &b_gotpicture, &pkt );
 
@@ -634,6 +692,15 @@ picture_t *DecodeVideo( decoder_t *p_dec, block_t **pp_block )
         }
         wait_mt( p_sys );
 
+        /* Averaged over the last 8 frames or so */
+        p_sys->i_decode_spent += mdate() - i_decode_start;
+        if( b_gotpicture )
+        {
+            p_sys->i_decode_time = ( 7 * p_sys->i_decode_time +
+                                     p_sys->i_decode_spent ) / 8;
+            p_sys->i_decode_spent = 0;
+        }
+
         if( p_sys->b_flush )
             p_sys->b_first_frame = true;
 
@@ -847,6 +914,9 @@ void EndVideoDec( decoder_t *p_dec )
 
     wait_mt( p_sys );
 
+#ifdef HAVE_AVCODEC_MT
+    ReleaseAutoThreads( p_sys );
+#endif
     if( p_sys->p_ff_pic ) av_free( p_sys->p_ff_pic );
 
     if( p_sys->p_va )
@@ -52,11 +52,13 @@ static void CloseCommon   ( vlc_object_t * );
 vlc_module_begin ()
     set_description( N_("DTS parser") )
     set_capability( "decoder", 100 )
+    add_codec( VLC_CODEC_DTS )
     set_callbacks( OpenDecoder, CloseCommon )
 
     add_submodule ()
     set_description( N_("DTS audio packetizer") )
     set_capability( "packetizer", 10 )
+    add_codec( VLC_CODEC_DTS )
     set_callbacks( OpenPacketizer, CloseCommon )
 vlc_module_end ()
 
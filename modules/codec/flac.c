@@ -110,6 +110,7 @@ vlc_module_begin ()
 
     set_description( N_("Flac audio decoder") )
     set_capability( "decoder", 100 )
+    add_codec( VLC_CODEC_FLAC )
     set_callbacks( OpenDecoder, CloseDecoder )
 
     add_submodule ()
@@ -122,55 +123,91 @@ vlc_module_end ()
 
 /*****************************************************************************
  * Interleave: helper function to interleave channels
+ *****************************************************************************
+ * Each channel is written with a fixed stride, and stereo, by far the most
+ * common case, gets loops simple enough for the compiler to vectorize.
  *****************************************************************************/
-static void Interleave32( int32_t *p_out, const int32_t * const *pp_in,
+static void Interleave32( int32_t *restrict p_out,
+                          const int32_t * const *pp_in,
                           const int pi_index[],
                           int i_nb_channels, int i_samples )
 {
-    int i, j;
-    for ( j = 0; j < i_samples; j++ )
+    if( i_nb_channels == 2 )
     {
-        for ( i = 0; i < i_nb_channels; i++ )
+        const int32_t *restrict p_left = pp_in[pi_index[0]];
+        const int32_t *restrict p_right = pp_in[pi_index[1]];
+
+        for( int j = 0; j < i_samples; j++ )
         {
-            p_out[j * i_nb_channels + i] = pp_in[pi_index[i]][j];
+            p_out[2 * j + 0] = p_left[j];
+            p_out[2 * j + 1] = p_right[j];
         }
+        return;
+    }
+
+    for( int i = 0; i < i_nb_channels; i++ )
+    {
+        const int32_t *restrict p_in = pp_in[pi_index[i]];
+        int32_t *restrict p = p_out + i;
+
+        for( int j = 0; j < i_samples; j++, p += i_nb_channels )
+            *p = p_in[j];
     }
 }
 
-static void Interleave24( int8_t *p_out, const int32_t * const *pp_in,
+static void Interleave24( uint8_t *restrict p_out,
+                          const int32_t * const *pp_in,
                           const int pi_index[],
                           int i_nb_channels, int i_samples )
 {
-    int i, j;
-    for ( j = 0; j < i_samples; j++ )
+    const int i_stride = 3 * i_nb_channels;
+
+    for( int i = 0; i < i_nb_channels; i++ )
     {
-        for ( i = 0; i < i_nb_channels; i++ )
+        const int32_t *restrict p_in = pp_in[pi_index[i]];
+        uint8_t *restrict p = p_out + 3 * i;
+
+        for( int j = 0; j < i_samples; j++, p += i_stride )
         {
-            const int i_index = pi_index[i];
+            const uint32_t i_sample = p_in[j];
 #ifdef WORDS_BIGENDIAN
-            p_out[3*(j * i_nb_channels + i)+0] = (pp_in[i_index][j] >> 16) & 0xff;
-            p_out[3*(j * i_nb_channels + i)+1] = (pp_in[i_index][j] >> 8 ) & 0xff;
-            p_out[3*(j * i_nb_channels + i)+2] = (pp_in[i_index][j] >> 0 ) & 0xff;
+            p[0] = i_sample >> 16;
+            p[1] = i_sample >> 8;
+            p[2] = i_sample;
 #else
-            p_out[3*(j * i_nb_channels + i)+2] = (pp_in[i_index][j] >> 16) & 0xff;
-            p_out[3*(j * i_nb_channels + i)+1] = (pp_in[i_index][j] >> 8 ) & 0xff;
-            p_out[3*(j * i_nb_channels + i)+0] = (pp_in[i_index][j] >> 0 ) & 0xff;
+            p[0] = i_sample;
+            p[1] = i_sample >> 8;
+            p[2] = i_sample >> 16;
 #endif
         }
     }
 }
 
-static void Interleave16( int16_t *p_out, const int32_t * const *pp_in,
+static void Interleave16( int16_t *restrict p_out,
+                          const int32_t * const *pp_in,
                           const int pi_index[],
                           int i_nb_channels, int i_samples )
 {
-    int i, j;
-    for ( j = 0; j < i_samples; j++ )
+    if( i_nb_channels == 2 )
     {
-        for ( i = 0; i < i_nb_channels; i++ )
+        const int32_t *restrict p_left = pp_in[pi_index[0]];
+        const int32_t *restrict p_right = pp_in[pi_index[1]];
+
+        for( int j = 0; j < i_samples; j++ )
         {
-            p_out[j * i_nb_channels + i] = (int32_t)(pp_in[pi_index[i]][j]);
+            p_out[2 * j + 0] = p_left[j];
+            p_out[2 * j + 1] = p_right[j];
         }
+        return;
+    }
+
+    for( int i = 0; i < i_nb_channels; i++ )
+    {
+        const int32_t *restrict p_in = pp_in[pi_index[i]];
+        int16_t *restrict p = p_out + i;
+
+        for( int j = 0; j < i_samples; j++, p += i_nb_channels )
+            *p = p_in[j];
     }
 }
 
@@ -221,7 +258,7 @@ DecoderWriteCallback( const FLAC__StreamDecoder *decoder,
                       frame->header.channels, frame->header.blocksize );
         break;
     case 24:
-        Interleave24( (int8_t *)p_sys->p_aout_buffer->p_buffer, buffer, pi_reorder,
+        Interleave24( (uint8_t *)p_sys->p_aout_buffer->p_buffer, buffer, pi_reorder,
                       frame->header.channels, frame->header.blocksize );
         break;
     default:
@@ -82,6 +82,10 @@ struct decoder_sys_t
 
     /* */
     ASS_Track      *p_track;
+
+    /* Number of ass_render_frame() calls, to know which subpicture
+     * libass compared the last frame with */
+    unsigned       i_render;
 };
 static void DecSysRelease( decoder_sys_t *p_sys );
 static void DecSysHold( decoder_sys_t *p_sys );
@@ -97,6 +101,26 @@ static void SubpictureUpdate( subpicture_t *,
                               mtime_t );
 static void SubpictureDestroy( subpicture_t * );
 
+typedef struct
+{
+    int x0;
+    int y0;
+    int x1;
+    int y1;
+} rectangle_t;
+
+#define MAX_REGION 4
+
+/* A region drawn for the previous frame, with the images it was drawn from
+ * (positions relative to the region) */
+typedef struct
+{
+    rectangle_t rect;
+    picture_t   *p_picture;
+    int         i_img;
+    ASS_Image   *p_img;
+} cached_region_t;
+
 struct subpicture_updater_sys_t
 {
     decoder_sys_t *p_dec_sys;
@@ -105,18 +129,19 @@ struct subpicture_updater_sys_t
     mtime_t       i_pts;
 
     ASS_Image     *p_img;
-};
 
-typedef struct
-{
-    int x0;
-    int y0;
-    int x1;
-    int y1;
-} rectangle_t;
+    /* */
+    unsigned        i_render;
+    bool            b_reuse;
+    int             i_cached;
+    cached_region_t cached[MAX_REGION];
+};
 
 static int BuildRegions( rectangle_t *p_region, int i_max_region, ASS_Image *p_img_list, int i_width, int i_height );
 static void RegionDraw( subpicture_region_t *p_region, ASS_Image *p_img );
+static picture_t *RegionFind( subpicture_updater_sys_t *, const rectangle_t *, ASS_Image * );
+static void RegionSave( cached_region_t *, const rectangle_t *, picture_t *, ASS_Image * );
+static void RegionFlush( subpicture_updater_sys_t * );
 
 //#define DEBUG_REGION
 
@@ -339,6 +364,8 @@ static subpicture_t *DecodeBlock( decoder_t *p_dec, block_t **pp_block )
     }
 
     p_spu_sys->p_img = NULL;
+    p_spu_sys->b_reuse = false;
+    p_spu_sys->i_cached = 0;
     p_spu_sys->p_dec_sys = p_sys;
     p_spu_sys->i_subs_len = p_block->i_buffer;
     p_spu_sys->p_subs_data = malloc( p_block->i_buffer );
@@ -360,6 +387,7 @@ static subpicture_t *DecodeBlock( decoder_t *p_dec, block_t **pp_block )
     p_sys->i_max_stop = p_spu->i_stop;
 
     vlc_mutex_lock( &p_sys->lock );
+    p_spu_sys->i_render = p_sys->i_render - 1;
     if( p_sys->p_track )
     {
         ass_process_chunk( p_sys->p_track, p_spu_sys->p_subs_data, p_spu_sys->i_subs_len,
@@ -382,7 +410,8 @@ static int SubpictureValidate( subpicture_t *p_subpic,
                                bool b_fmt_dst, const video_format_t *p_fmt_dst,
                                mtime_t i_ts )
 {
-    decoder_sys_t *p_sys = p_subpic->updater.p_sys->p_dec_sys;
+    subpicture_updater_sys_t *p_upd_sys = p_subpic->updater.p_sys;
+    decoder_sys_t *p_sys = p_upd_sys->p_dec_sys;
 
     vlc_mutex_lock( &p_sys->lock );
 
@@ -403,18 +432,24 @@ static int SubpictureValidate( subpicture_t *p_subpic,
     }
 
     /* */
-    const mtime_t i_stream_date = p_subpic->updater.p_sys->i_pts + (i_ts - p_subpic->i_start);
+    const mtime_t i_stream_date = p_upd_sys->i_pts + (i_ts - p_subpic->i_start);
     int i_changed;
     ASS_Image *p_img = ass_render_frame( p_sys->p_renderer, p_sys->p_track,
                                          i_stream_date/1000, &i_changed );
 
-    if( !i_changed && !b_fmt_src && !b_fmt_dst &&
+    /* libass compares with the frame it rendered last, which is only ours
+     * if no other subpicture of this decoder was rendered in between */
+    const bool b_last = p_upd_sys->i_render == p_sys->i_render;
+    p_upd_sys->i_render = ++p_sys->i_render;
+    p_upd_sys->b_reuse = b_last && !b_fmt_src && !b_fmt_dst;
+
+    if( p_upd_sys->b_reuse && !i_changed &&
         (p_img != NULL) == (p_subpic->p_region != NULL) )
     {
         vlc_mutex_unlock( &p_sys->lock );
         return VLC_SUCCESS;
     }
-    p_subpic->updater.p_sys->p_img = p_img;
+    p_upd_sys->p_img = p_img;
 
     /* The lock is released by SubpictureUpdate */
     return VLC_EGENERIC;
@@ -427,10 +462,11 @@ static void SubpictureUpdate( subpicture_t *p_subpic,
 {
     VLC_UNUSED( p_fmt_src ); VLC_UNUSED( p_fmt_dst ); VLC_UNUSED( i_ts );
 
-    decoder_sys_t *p_sys = p_subpic->updater.p_sys->p_dec_sys;
+    subpicture_updater_sys_t *p_upd_sys = p_subpic->updater.p_sys;
+    decoder_sys_t *p_sys = p_upd_sys->p_dec_sys;
 
     video_format_t fmt = p_sys->fmt;
-    ASS_Image *p_img = p_subpic->updater.p_sys->p_img;
+    ASS_Image *p_img = p_upd_sys->p_img;
 
     /* */
     p_subpic->i_original_picture_height = fmt.i_height;
@@ -442,18 +478,26 @@ static void SubpictureUpdate( subpicture_t *p_subpic,
      * reinstanciate a lot the scaler, and as we do not support subpel blending
      * it looks ugly (text unaligned).
      */
-    const int i_max_region = 4;
-    rectangle_t region[i_max_region];
-    const int i_region = BuildRegions( region, i_max_region, p_img, fmt.i_width, fmt.i_height );
+    rectangle_t region[MAX_REGION];
+    const int i_region = BuildRegions( region, MAX_REGION, p_img, fmt.i_width, fmt.i_height );
+
+    /* The pictures of the previous frame are only valid when libass
+     * compared the images with it */
+    if( !p_upd_sys->b_reuse )
+        RegionFlush( p_upd_sys );
 
     if( i_region <= 0 )
     {
+        RegionFlush( p_upd_sys );
         vlc_mutex_unlock( &p_sys->lock );
         return;
     }
 
-    /* Allocate the regions and draw them */
+    /* Allocate the regions and draw them, unless an identical one was
+     * drawn for the previous frame */
     subpicture_region_t **pp_region_last = &p_subpic->p_region;
+    cached_region_t cached[MAX_REGION];
+    int i_cached = 0;
 
     for( int i = 0; i < i_region; i++ )
     {
@@ -475,12 +519,28 @@ static void SubpictureUpdate( subpicture_t *p_subpic,
         r->i_align = SUBPICTURE_ALIGN_TOP | SUBPICTURE_ALIGN_LEFT;
 
         /* */
-        RegionDraw( r, p_img );
+        picture_t *p_picture = RegionFind( p_upd_sys, &region[i], p_img );
+        if( p_picture )
+        {
+            picture_Release( r->p_picture );
+            r->p_picture = picture_Hold( p_picture );
+        }
+        else
+        {
+            RegionDraw( r, p_img );
+        }
+        RegionSave( &cached[i_cached], &region[i], r->p_picture, p_img );
+        if( cached[i_cached].p_picture )
+            i_cached++;
 
         /* */
         *pp_region_last = r;
         pp_region_last = &r->p_next;
     }
+    RegionFlush( p_upd_sys );
+    memcpy( p_upd_sys->cached, cached, i_cached * sizeof(*cached) );
+    p_upd_sys->i_cached = i_cached;
+
     vlc_mutex_unlock( &p_sys->lock );
 
 }
@@ -488,6 +548,7 @@ static void SubpictureDestroy( subpicture_t *p_subpic )
 {
     subpicture_updater_sys_t *p_sys = p_subpic->updater.p_sys;
 
+    RegionFlush( p_sys );
     DecSysRelease( p_sys->p_dec_sys );
     free( p_sys->p_subs_data );
     free( p_sys );
@@ -644,39 +705,49 @@ static int BuildRegions( rectangle_t *p_region, int i_max_region, ASS_Image *p_i
     return i_region;
 }
 
+static bool r_contains_img( const rectangle_t *r, const ASS_Image *p_img )
+{
+    return p_img->dst_x >= r->x0 && p_img->dst_x + p_img->w <= r->x1 &&
+           p_img->dst_y >= r->y0 && p_img->dst_y + p_img->h <= r->y1;
+}
+
+/* x / 255, exact for x < 65535 */
+#define DIV255( x ) ( ( (x) + 1 + ( (x) >> 8 ) ) >> 8 )
+
 static void RegionDraw( subpicture_region_t *p_region, ASS_Image *p_img )
 {
     const plane_t *p = &p_region->p_picture->p[0];
-    const int i_x = p_region->i_x;
-    const int i_y = p_region->i_y;
-    const int i_width  = p_region->fmt.i_width;
-    const int i_height = p_region->fmt.i_height;
+    const rectangle_t rect = r_create( p_region->i_x, p_region->i_y,
+                                       p_region->i_x + p_region->fmt.i_width,
+                                       p_region->i_y + p_region->fmt.i_height );
 
     memset( p->p_pixels, 0x00, p->i_pitch * p->i_lines );
     for( ; p_img != NULL; p_img = p_img->next )
     {
-        if( p_img->dst_x < i_x || p_img->dst_x + p_img->w > i_x + i_width ||
-            p_img->dst_y < i_y || p_img->dst_y + p_img->h > i_y + i_height )
+        if( !r_contains_img( &rect, p_img ) )
             continue;
 
         const unsigned r = (p_img->color >> 24)&0xff;
         const unsigned g = (p_img->color >> 16)&0xff;
         const unsigned b = (p_img->color >>  8)&0xff;
         const unsigned a = (p_img->color      )&0xff;
-        int x, y;
 
-        for( y = 0; y < p_img->h; y++ )
+        for( int y = 0; y < p_img->h; y++ )
         {
-            for( x = 0; x < p_img->w; x++ )
+            const uint8_t *p_src = &p_img->bitmap[y * p_img->stride];
+            uint8_t *p_rgba = &p->p_pixels[(y + p_img->dst_y - rect.y0) * p->i_pitch +
+                                           4 * (p_img->dst_x - rect.x0)];
+
+            for( int x = 0; x < p_img->w; x++, p_rgba += 4 )
             {
-                const unsigned alpha = p_img->bitmap[y*p_img->stride+x];
-                const unsigned an = (255 - a) * alpha / 255;
+                const unsigned an = DIV255( (255 - a) * p_src[x] );
+                if( an == 0 )
+                    continue; /* Fully transparent, nothing to blend */
 
-                uint8_t *p_rgba = &p->p_pixels[(y+p_img->dst_y-i_y) * p->i_pitch + 4 * (x+p_img->dst_x-i_x)];
                 const unsigned ao = p_rgba[3];
 
                 /* Native endianness, but RGBA ordering */
-                if( ao == 0 )
+                if( ao == 0 || an == 255 )
                 {
                     /* Optimized but the else{} will produce the same result */
                     p_rgba[0] = r;
@@ -686,13 +757,15 @@ static void RegionDraw( subpicture_region_t *p_region, ASS_Image *p_img )
                 }
                 else
                 {
-                    p_rgba[3] = 255 - ( 255 - p_rgba[3] ) * ( 255 - an ) / 255;
-                    if( p_rgba[3] != 0 )
-                    {
-                        p_rgba[0] = ( p_rgba[0] * ao * (255-an) / 255 + r * an ) / p_rgba[3];
-                        p_rgba[1] = ( p_rgba[1] * ao * (255-an) / 255 + g * an ) / p_rgba[3];
-                        p_rgba[2] = ( p_rgba[2] * ao * (255-an) / 255 + b * an ) / p_rgba[3];
-                    }
+                    /* Resulting alpha, and what remains of the previous
+                     * color in it */
+                    const unsigned at = 255 - DIV255( (255 - ao) * (255 - an) );
+                    const unsigned wo = at - an;
+
+                    p_rgba[0] = ( p_rgba[0] * wo + r * an ) / at;
+                    p_rgba[1] = ( p_rgba[1] * wo + g * an ) / at;
+                    p_rgba[2] = ( p_rgba[2] * wo + b * an ) / at;
+                    p_rgba[3] = at;
                 }
             }
         }
@@ -709,3 +782,79 @@ static void RegionDraw( subpicture_region_t *p_region, ASS_Image *p_img )
 #endif
 }
 
+/* Returns the picture drawn for the previous frame in the same rectangle
+ * from the same images, if any */
+static picture_t *RegionFind( subpicture_updater_sys_t *p_sys,
+                              const rectangle_t *p_rect, ASS_Image *p_img )
+{
+    for( int i = 0; i < p_sys->i_cached; i++ )
+    {
+        const cached_region_t *p_cached = &p_sys->cached[i];
+
+        if( p_cached->rect.x1 - p_cached->rect.x0 != p_rect->x1 - p_rect->x0 ||
+            p_cached->rect.y1 - p_cached->rect.y0 != p_rect->y1 - p_rect->y0 )
+            continue;
+
+        /* Same comparison as libass does between two frames: the bitmaps
+         * of consecutive frames are the same when their pointers are */
+        int i_img = 0;
+        bool b_same = true;
+        for( ASS_Image *p = p_img; p != NULL && b_same; p = p->next )
+        {
+            if( !r_contains_img( p_rect, p ) )
+                continue;
+
+            const ASS_Image *p_old = &p_cached->p_img[i_img++];
+            b_same = i_img <= p_cached->i_img &&
+                     p_old->bitmap == p->bitmap && p_old->color == p->color &&
+                     p_old->w == p->w && p_old->h == p->h &&
+                     p_old->stride == p->stride &&
+                     p_old->dst_x == p->dst_x - p_rect->x0 &&
+                     p_old->dst_y == p->dst_y - p_rect->y0;
+        }
+        if( b_same && i_img == p_cached->i_img )
+            return p_cached->p_picture;
+    }
+    return NULL;
+}
+
+static void RegionSave( cached_region_t *p_cached, const rectangle_t *p_rect,
+                        picture_t *p_picture, ASS_Image *p_img )
+{
+    int i_img = 0;
+    for( ASS_Image *p = p_img; p != NULL; p = p->next )
+    {
+        if( r_contains_img( p_rect, p ) )
+            i_img++;
+    }
+
+    p_cached->rect = *p_rect;
+    p_cached->i_img = 0;
+    p_cached->p_img = malloc( __MAX( i_img, 1 ) * sizeof(*p_cached->p_img) );
+    p_cached->p_picture = NULL;
+    if( !p_cached->p_img )
+        return;
+
+    for( ASS_Image *p = p_img; p != NULL; p = p->next )
+    {
+        if( !r_contains_img( p_rect, p ) )
+            continue;
+
+        ASS_Image *p_copy = &p_cached->p_img[p_cached->i_img++];
+        *p_copy = *p;
+        p_copy->dst_x -= p_rect->x0;
+        p_copy->dst_y -= p_rect->y0;
+        p_copy->next = NULL;
+    }
+    p_cached->p_picture = picture_Hold( p_picture );
+}
+
+static void RegionFlush( subpicture_updater_sys_t *p_sys )
+{
+    for( int i = 0; i < p_sys->i_cached; i++ )
+    {
+        picture_Release( p_sys->cached[i].p_picture );
+        free( p_sys->cached[i].p_img );
+    }
+    p_sys->i_cached = 0;
+}
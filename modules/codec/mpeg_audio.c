@@ -112,11 +112,13 @@ vlc_module_begin ()
 #else
     set_capability( "decoder", 100 )
 #endif
+    add_codec( VLC_CODEC_MPGA )
     set_callbacks( OpenDecoder, CloseDecoder )
 
     add_submodule ()
     set_description( N_("MPEG audio layer I/II/III packetizer") )
     set_capability( "packetizer", 10 )
+    add_codec( VLC_CODEC_MPGA )
     set_callbacks( OpenPacketizer, CloseDecoder )
 vlc_module_end ()
 
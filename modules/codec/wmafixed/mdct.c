@@ -102,7 +102,9 @@ void ff_imdct_calc(MDCTContext *s,
     scale = fft_calc_unscaled(&s->fft, z1);
 
     /* post rotation + reordering */
-    for(k = 0; k < n4; k++)
+    if(s->post_rotate)
+        s->post_rotate(z2, z1, tcos, tsin, n4);
+    else for(k = 0; k < n4; k++)
     {
         CMUL(&z2[k].re, &z2[k].im, (z1[k].re), (z1[k].im), tcos[k], tsin[k]);
     }
@@ -30,6 +30,9 @@ typedef struct MDCTContext
     int32_t *tcos;
     int32_t *tsin;
     FFTContext fft;
+    /* optimized post rotation, NULL for the C version */
+    void (*post_rotate)(FFTComplex *z2, const FFTComplex *z1,
+                        const int32_t *tcos, const int32_t *tsin, int n4);
 }
 MDCTContext;
 
@@ -33,6 +33,7 @@
 #include <vlc_aout.h>
 #include <vlc_block_helper.h>
 #include <vlc_bits.h>
+#include <vlc_cpu.h>
 
 #include <assert.h>
 
@@ -51,6 +52,10 @@ struct decoder_sys_t
     /* to not give too much samples at once to the audio output */
     int8_t *p_samples; /* point into p_output */
     unsigned int i_samples; /* number of buffered samples available */
+
+    /* decoding speed */
+    mtime_t i_decode_time;
+    uint64_t i_decoded; /* samples per channel */
 };
 
 /* FIXME : check supported configurations */
@@ -182,6 +187,10 @@ static int OpenDecoder( vlc_object_t *p_this )
         free( p_sys );
         return VLC_EGENERIC;
     }
+#ifdef CAN_COMPILE_NEON
+    if( vlc_CPU() & CPU_CAPABILITY_NEON )
+        wma_decode_init_neon( &p_sys->wmadec );
+#endif
 
     /* Set callback */
     p_dec->pf_decode_audio = DecodeFrame;
@@ -272,6 +281,7 @@ static aout_buffer_t *DecodeFrame( decoder_t *p_dec, block_t **pp_block )
 
     p_sys->i_samples = 0;
 
+    mtime_t i_start = mdate();
     for( int i = 0 ; i < p_sys->wmadec.nb_frames; i++ )
     {
         int i_samples = 0;
@@ -290,6 +300,8 @@ static aout_buffer_t *DecodeFrame( decoder_t *p_dec, block_t **pp_block )
         }
         p_sys->i_samples += i_samples; /* advance in the samples buffer */
     }
+    p_sys->i_decode_time += mdate() - i_start;
+    p_sys->i_decoded += p_sys->i_samples;
 
     p_block->i_buffer = 0; /* this block has been decoded */
 
@@ -307,7 +319,18 @@ static aout_buffer_t *DecodeFrame( decoder_t *p_dec, block_t **pp_block )
  *****************************************************************************/
 static void CloseDecoder( vlc_object_t *p_this )
 {
-    decoder_sys_t *p_sys = ((decoder_t*)p_this)->p_sys;
+    decoder_t *p_dec = (decoder_t *)p_this;
+    decoder_sys_t *p_sys = p_dec->p_sys;
+
+    if( p_sys->i_decode_time > 0 )
+    {
+        mtime_t i_duration = p_sys->i_decoded * CLOCK_FREQ
+                           / p_dec->fmt_out.audio.i_rate;
+        msg_Dbg( p_dec, "decoded %"PRIu64" samples in %"PRId64" ms, "
+                 "%.1fx real time", p_sys->i_decoded,
+                 p_sys->i_decode_time / 1000,
+                 (double)i_duration / p_sys->i_decode_time );
+    }
 
     free( p_sys->p_output );
     free( p_sys );
@@ -129,6 +129,12 @@ typedef struct WMADecodeContext
     int nb_frames;
     int current_frame;
 
+    /* windowing, replaced by optimized versions where available */
+    void (*vector_fmul_add_add)(int32_t *dst, const int32_t *src0,
+                                const int32_t *src1, int len);
+    void (*vector_fmul_reverse)(int32_t *dst, const int32_t *src0,
+                                const int32_t *src1, int len);
+
 #ifdef TRACE
 
     int frame_count;
@@ -137,6 +143,9 @@ typedef struct WMADecodeContext
 WMADecodeContext;
 
 int wma_decode_init(WMADecodeContext* s, asf_waveformatex_t *wfx);
+#ifdef CAN_COMPILE_NEON
+void wma_decode_init_neon(WMADecodeContext* s);
+#endif
 int wma_decode_superframe_init(WMADecodeContext* s,
                                uint8_t *buf, int buf_size);
 int wma_decode_superframe_frame(WMADecodeContext* s,
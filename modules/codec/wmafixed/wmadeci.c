@@ -213,6 +213,28 @@ static inline void vector_fmul_reverse(int32_t *dst, const int32_t *src0, const
 
 #endif
 
+#ifdef CAN_COMPILE_NEON
+void wma_vector_fmul_add_add_neon(int32_t *dst, const int32_t *src0,
+                                  const int32_t *src1, int len);
+void wma_vector_fmul_reverse_neon(int32_t *dst, const int32_t *src0,
+                                  const int32_t *src1, int len);
+void wma_imdct_post_rotate_neon(FFTComplex *z2, const FFTComplex *z1,
+                                const int32_t *tcos, const int32_t *tsin,
+                                int n4);
+
+/* Block lengths are powers of two of at least 128 samples, as required by
+ * the NEON versions which process 4 samples at a time. */
+void wma_decode_init_neon(WMADecodeContext* s)
+{
+    int i;
+
+    s->vector_fmul_add_add = wma_vector_fmul_add_add_neon;
+    s->vector_fmul_reverse = wma_vector_fmul_reverse_neon;
+    for(i = 0; i < s->nb_block_sizes; ++i)
+        s->mdct_ctx[i].post_rotate = wma_imdct_post_rotate_neon;
+}
+#endif
+
 /**
   * Apply MDCT window and add into output.
   *
@@ -232,7 +254,7 @@ static void wma_window(WMADecodeContext *s, int32_t *in, int32_t *out)
          block_len = s->block_len;
          bsize = s->frame_len_bits - s->block_len_bits;
 
-         vector_fmul_add_add(out, in, s->windows[bsize], block_len);
+         s->vector_fmul_add_add(out, in, s->windows[bsize], block_len);
 
     } else {
          /*previous block was smaller or the same size, so use it's size to set the window length*/
@@ -241,7 +263,7 @@ static void wma_window(WMADecodeContext *s, int32_t *in, int32_t *out)
          n = (s->block_len - block_len) >> 1;
          bsize = s->frame_len_bits - s->prev_block_len_bits;
 
-         vector_fmul_add_add(out+n, in+n, s->windows[bsize],  block_len);
+         s->vector_fmul_add_add(out+n, in+n, s->windows[bsize],  block_len);
 
          memcpy(out+n+block_len, in+n+block_len, n*sizeof(int32_t));
     }
@@ -257,7 +279,7 @@ static void wma_window(WMADecodeContext *s, int32_t *in, int32_t *out)
          block_len = s->block_len;
          bsize = s->frame_len_bits - s->block_len_bits;
 
-         vector_fmul_reverse(out, in, s->windows[bsize], block_len);
+         s->vector_fmul_reverse(out, in, s->windows[bsize], block_len);
 
      } else {
          block_len = 1 << s->next_block_len_bits;
@@ -266,7 +288,7 @@ static void wma_window(WMADecodeContext *s, int32_t *in, int32_t *out)
 
          memcpy(out, in, n*sizeof(int32_t));
 
-         vector_fmul_reverse(out+n, in+n, s->windows[bsize], block_len);
+         s->vector_fmul_reverse(out+n, in+n, s->windows[bsize], block_len);
 
          memset(out+n+block_len, 0, n*sizeof(int32_t));
      }
@@ -587,6 +609,9 @@ int wma_decode_init(WMADecodeContext* s, asf_waveformatex_t *wfx)
 
     mdct_init_global();
 
+    s->vector_fmul_add_add = vector_fmul_add_add;
+    s->vector_fmul_reverse = vector_fmul_reverse;
+
     for(i = 0; i < s->nb_block_sizes; ++i)
     {
         ff_mdct_init(&s->mdct_ctx[i], s->frame_len_bits - i + 1, 1);
@@ -396,6 +396,23 @@ static void Close( vlc_object_t * );
      "Overridden by user settings." )
 #define PRESET_TEXT N_("Use preset as default settings. Overridden by user settings." )
 
+#define LATENCY_TEXT N_("Latency")
+#define LATENCY_LONGTEXT N_( "Trade encoding latency for throughput. " \
+    "\"low\" encodes each frame on sliced threads, without B-frames nor " \
+    "lookahead, and uses periodic intra refresh instead of key frames, " \
+    "for live contribution. \"throughput\" encodes several frames in " \
+    "parallel with a lookahead, for file transcoding. Applied after the " \
+    "preset and tune, overridden by user settings." )
+
+#define SLICED_THREADS_TEXT N_("Sliced threads")
+#define SLICED_THREADS_LONGTEXT N_( "Encode each frame by slices on several " \
+    "threads instead of several frames in parallel. This lowers the latency " \
+    "at some cost in compression efficiency." )
+
+#define ENC_STATS_TEXT N_("Statistics period")
+#define ENC_STATS_LONGTEXT N_( "Report the encoding speed and latency every " \
+    "this many seconds (0 to disable)." )
+
 static const char *const enc_me_list[] =
   { "dia", "hex", "umh", "esa", "tesa" };
 static const char *const enc_me_list_text[] =
@@ -417,6 +434,11 @@ static const char *const direct_pred_list[] =
 static const char *const direct_pred_list_text[] =
   { N_("none"), N_("spatial"), N_("temporal"), N_("auto") };
 
+static const char *const latency_list[] =
+  { "normal", "low", "throughput" };
+static const char *const latency_list_text[] =
+  { N_("Normal"), N_("Low"), N_("Throughput") };
+
 vlc_module_begin ()
     set_description( N_("H.264/MPEG4 AVC encoder (x264)"))
     set_capability( "encoder", 200 )
@@ -638,6 +660,9 @@ vlc_module_begin ()
     add_bool( SOUT_CFG_PREFIX "intra-refresh", false, INTRAREFRESH_TEXT,
               INTRAREFRESH_LONGTEXT, true )
 
+    add_bool( SOUT_CFG_PREFIX "sliced-threads", false, SLICED_THREADS_TEXT,
+              SLICED_THREADS_LONGTEXT, true )
+
     add_bool( SOUT_CFG_PREFIX "mbtree", true, MBTREE_TEXT, MBTREE_LONGTEXT, true )
 
     add_bool( SOUT_CFG_PREFIX "fast-pskip", true, FAST_PSKIP_TEXT,
@@ -686,6 +711,9 @@ vlc_module_begin ()
     add_bool( SOUT_CFG_PREFIX "verbose", false, VERBOSE_TEXT,
               VERBOSE_LONGTEXT, true )
 
+    add_integer( SOUT_CFG_PREFIX "enc-stats", 10, ENC_STATS_TEXT,
+                 ENC_STATS_LONGTEXT, true )
+
     add_string( SOUT_CFG_PREFIX "stats", "x264_2pass.log", STATS_TEXT,
                 STATS_LONGTEXT, true )
 
@@ -693,6 +721,9 @@ vlc_module_begin ()
         change_string_list( x264_preset_names, x264_preset_names, 0 );
     add_string( SOUT_CFG_PREFIX "tune", NULL , TUNE_TEXT, TUNE_TEXT, false )
         change_string_list( x264_tune_names, x264_tune_names, 0 );
+    add_string( SOUT_CFG_PREFIX "latency", "normal", LATENCY_TEXT,
+                LATENCY_LONGTEXT, false )
+        change_string_list( latency_list, latency_list_text, 0 );
 
 vlc_module_end ()
 
@@ -713,10 +744,12 @@ static const char *const ppsz_sout_options[] = {
     "verbose", "vbv-bufsize", "vbv-init", "vbv-maxrate", "weightb", "weightp",
     "aq-mode", "aq-strength", "psy-rd", "psy", "profile", "lookahead", "slices",
     "slice-max-size", "slice-max-mbs", "intra-refresh", "mbtree", "hrd",
-    "tune","preset", "opengop", "bluray-compat", NULL
+    "tune","preset", "opengop", "bluray-compat", "latency", "sliced-threads",
+    "enc-stats", NULL
 };
 
 static block_t *Encode( encoder_t *, picture_t * );
+static void Stats( encoder_t *, mtime_t, bool );
 
 struct encoder_sys_t
 {
@@ -728,6 +761,14 @@ struct encoder_sys_t
     char            *psz_stat_name;
     int             i_sei_size;
     uint8_t         *p_sei;
+
+    /* Encoding statistics */
+    mtime_t         i_stats_period;
+    mtime_t         i_stats_date;   /* start of the current period */
+    mtime_t         i_encode_time;  /* spent in x264 during the period */
+    unsigned        i_stats_frames;
+    unsigned        i_frames;
+    mtime_t         i_total_time;
 };
 
 #ifdef PTW32_STATIC_LIB
@@ -771,6 +812,13 @@ static int  Open ( vlc_object_t *p_this )
     p_sys->psz_stat_name = NULL;
     p_sys->i_sei_size = 0;
     p_sys->p_sei = NULL;
+    p_sys->i_stats_period = CLOCK_FREQ *
+        var_GetInteger( p_enc, SOUT_CFG_PREFIX "enc-stats" );
+    p_sys->i_stats_date = 0;
+    p_sys->i_encode_time = 0;
+    p_sys->i_stats_frames = 0;
+    p_sys->i_frames = 0;
+    p_sys->i_total_time = 0;
 
     x264_param_default( &p_sys->param );
     char *psz_preset = var_GetString( p_enc, SOUT_CFG_PREFIX  "preset" );
@@ -783,6 +831,28 @@ static int  Open ( vlc_object_t *p_this )
     x264_param_default_preset( &p_sys->param, psz_preset, psz_tune );
     free( psz_preset );
     free( psz_tune );
+
+    psz_val = var_GetString( p_enc, SOUT_CFG_PREFIX "latency" );
+    if( psz_val && !strcmp( psz_val, "low" ) )
+    {
+        /* Each frame thread or frame of lookahead delays the output by one
+         * frame, and B-frames by as many as they are */
+        msg_Dbg( p_enc, "using low latency settings" );
+        p_sys->param.b_sliced_threads = 1;
+        p_sys->param.i_sync_lookahead = 0;
+        p_sys->param.rc.i_lookahead = 0;
+        p_sys->param.rc.b_mb_tree = 0;
+        p_sys->param.i_bframe = 0;
+        p_sys->param.b_intra_refresh = 1;
+    }
+    else if( psz_val && !strcmp( psz_val, "throughput" ) )
+    {
+        msg_Dbg( p_enc, "using throughput settings" );
+        p_sys->param.b_sliced_threads = 0;
+        p_sys->param.i_sync_lookahead = X264_SYNC_LOOKAHEAD_AUTO;
+    }
+    free( psz_val );
+
     p_sys->param.i_width  = p_enc->fmt_in.video.i_width;
     p_sys->param.i_height = p_enc->fmt_in.video.i_height;
 
@@ -943,7 +1013,11 @@ static int  Open ( vlc_object_t *p_this )
     if( i_val >= 0 && i_val <= 16 && i_val != 3 )
         p_sys->param.i_bframe = i_val;
 
-    p_sys->param.b_intra_refresh = var_GetBool( p_enc, SOUT_CFG_PREFIX "intra-refresh" );
+    if( var_GetBool( p_enc, SOUT_CFG_PREFIX "intra-refresh" ) )
+        p_sys->param.b_intra_refresh = true;
+
+    if( var_GetBool( p_enc, SOUT_CFG_PREFIX "sliced-threads" ) )
+        p_sys->param.b_sliced_threads = true;
 
     psz_val = var_GetString( p_enc, SOUT_CFG_PREFIX "bpyramid" );
     if( !strcmp( psz_val, "normal" ) )
@@ -1312,6 +1386,8 @@ static block_t *Encode( encoder_t *p_enc, picture_t *p_pict )
     block_t *p_block;
     int i_nal=0, i_out=0, i=0;
 
+    const mtime_t i_start = mdate();
+
     /* init pic */
 #if X264_BUILD >= 98
     x264_picture_init( &pic );
@@ -1341,8 +1417,9 @@ static block_t *Encode( encoder_t *p_enc, picture_t *p_pict )
        }
     }
 
-    if( !i_nal ) return NULL;
+    Stats( p_enc, i_start, p_pict != NULL );
 
+    if( !i_nal ) return NULL;
 
     /* Get size of block we need */
     for( i = 0; i < i_nal; i++ )
@@ -1396,7 +1473,12 @@ static void Close( vlc_object_t *p_this )
     free( p_sys->psz_stat_name );
     free( p_sys->p_sei );
 
-    msg_Dbg( p_enc, "framecount still in libx264 buffer: %d", x264_encoder_delayed_frames( p_sys->h ) );
+    if( p_sys->h )
+        msg_Dbg( p_enc, "framecount still in libx264 buffer: %d", x264_encoder_delayed_frames( p_sys->h ) );
+    if( p_sys->i_total_time > 0 )
+        msg_Dbg( p_enc, "encoded %u frames in %"PRId64" ms (%.1f fps)",
+                 p_sys->i_frames, p_sys->i_total_time / 1000,
+                 (double)p_sys->i_frames * CLOCK_FREQ / p_sys->i_total_time );
 
     if( p_sys->h )
         x264_encoder_close( p_sys->h );
@@ -1417,3 +1499,48 @@ static void Close( vlc_object_t *p_this )
 
     free( p_sys );
 }
+
+/*****************************************************************************
+ * Stats: encoding speed and latency
+ *****************************************************************************
+ * The latency is the time spent in x264 by a frame plus the frames it
+ * keeps (frame threads, lookahead and B-frames) for the frame duration.
+ *****************************************************************************/
+static void Stats( encoder_t *p_enc, mtime_t i_start, bool b_input )
+{
+    encoder_sys_t *p_sys = p_enc->p_sys;
+    const mtime_t i_now = mdate();
+
+    p_sys->i_encode_time += i_now - i_start;
+    p_sys->i_total_time += i_now - i_start;
+    if( b_input )
+    {
+        p_sys->i_stats_frames++;
+        p_sys->i_frames++;
+    }
+
+    if( p_sys->i_stats_period <= 0 || p_sys->i_stats_frames == 0 )
+        return;
+    if( p_sys->i_stats_date == 0 )
+        p_sys->i_stats_date = i_start;
+    if( i_now - p_sys->i_stats_date < p_sys->i_stats_period )
+        return;
+
+    const int i_delayed = x264_encoder_delayed_frames( p_sys->h );
+    const mtime_t i_frame_time = p_sys->i_encode_time / p_sys->i_stats_frames;
+    mtime_t i_latency = i_frame_time;
+    if( p_enc->fmt_in.video.i_frame_rate > 0 )
+        i_latency += INT64_C(1000000) * i_delayed *
+                     p_enc->fmt_in.video.i_frame_rate_base /
+                     p_enc->fmt_in.video.i_frame_rate;
+
+    msg_Dbg( p_enc, "%.1f fps (%.1f ms per frame, %.0f%% of the time), "
+             "latency %"PRId64" ms (%d frames delayed)",
+             (double)p_sys->i_stats_frames * CLOCK_FREQ / (i_now - p_sys->i_stats_date),
+             i_frame_time / 1000., 100. * p_sys->i_encode_time / (i_now - p_sys->i_stats_date),
+             i_latency / 1000, i_delayed );
+
+    p_sys->i_stats_date = i_now;
+    p_sys->i_encode_time = 0;
+    p_sys->i_stats_frames = 0;
+}
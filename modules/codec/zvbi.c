@@ -350,18 +350,22 @@ static subpicture_t *Decode( decoder_t *p_dec, block_t **pp_block )
     const bool b_opaque = p_sys->b_opaque;
     vlc_mutex_unlock( &p_sys->lock );
 
-    /* Try to see if the page we want is in the cache yet */
+    /* libzvbi keeps the received pages in its cache: nothing needs to be
+     * formatted nor rendered until the wanted page changes or is received */
     memset( &p_page, 0, sizeof(vbi_page) );
+    if( i_wanted_page == p_sys->i_last_page && !p_sys->b_update )
+        goto error;
+
+    /* Try to see if the page we want is in the cache yet */
     b_cached = vbi_fetch_vt_page( p_sys->p_vbi_dec, &p_page,
                                   vbi_dec2bcd( i_wanted_page ),
                                   i_wanted_subpage, VBI_WST_LEVEL_3p5,
                                   25, true );
 
-    if( i_wanted_page == p_sys->i_last_page && !p_sys->b_update )
-        goto error;
-
     if( !b_cached )
     {
+        /* Wait for the page, EventHandler() flags its reception */
+        p_sys->b_update = false;
         if( p_sys->i_last_page != i_wanted_page )
         {
             /* We need to reset the subtitle */
@@ -372,7 +376,6 @@ static subpicture_t *Decode( decoder_t *p_dec, block_t **pp_block )
                 goto error;
             p_spu->p_region->psz_text = strdup("");
 
-            p_sys->b_update = true;
             p_sys->i_last_page = i_wanted_page;
             goto exit;
         }
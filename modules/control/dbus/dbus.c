@@ -228,6 +228,7 @@ static int Open( vlc_object_t *p_this )
     var_AddCallback( p_playlist, "volume", AllCallback, p_intf );
     var_AddCallback( p_playlist, "mute", AllCallback, p_intf );
     var_AddCallback( p_playlist, "playlist-item-append", AllCallback, p_intf );
+    var_AddCallback( p_playlist, "playlist-items-append", AllCallback, p_intf );
     var_AddCallback( p_playlist, "playlist-item-deleted", AllCallback, p_intf );
     var_AddCallback( p_playlist, "random", AllCallback, p_intf );
     var_AddCallback( p_playlist, "repeat", AllCallback, p_intf );
@@ -281,6 +282,7 @@ static void Close   ( vlc_object_t *p_this )
     var_DelCallback( p_playlist, "volume", AllCallback, p_intf );
     var_DelCallback( p_playlist, "mute", AllCallback, p_intf );
     var_DelCallback( p_playlist, "playlist-item-append", AllCallback, p_intf );
+    var_DelCallback( p_playlist, "playlist-items-append", AllCallback, p_intf );
     var_DelCallback( p_playlist, "playlist-item-deleted", AllCallback, p_intf );
     var_DelCallback( p_playlist, "random", AllCallback, p_intf );
     var_DelCallback( p_playlist, "repeat", AllCallback, p_intf );
@@ -980,6 +982,12 @@ static int AllCallback( vlc_object_t *p_this, const char *psz_var,
         info->i_node = ((playlist_add_t*)newval.p_address)->i_node;
     }
 
+    else if( !strcmp( "playlist-items-append", psz_var ) )
+    {
+        info->signal = SIGNAL_PLAYLIST_ITEM_APPEND;
+        info->i_node = ((playlist_add_range_t*)newval.p_address)->i_node;
+    }
+
     else if( !strcmp( "playlist-item-deleted", psz_var ) )
         info->signal = SIGNAL_PLAYLIST_ITEM_DELETED;
 
@@ -45,6 +45,7 @@
 #endif
 
 #include <vlc_network.h>
+#include <synchronicity/syn_clock.h>
 
 #define NETSYNC_PORT 9875
 
@@ -217,6 +218,11 @@ static void *Slave(void *handle)
     intf_thread_t *intf = handle;
     intf_sys_t *sys = intf->p_sys;
 
+    /* Offset to the master clock, filtered over the exchanges with the
+     * shortest round trips as for Synchronicity peers */
+    SynClock clock;
+    syn_clock_init(&clock);
+
     for (;;) {
         struct pollfd ufd = { .fd = sys->fd, .events = POLLIN, };
         uint64_t data[2];
@@ -242,8 +248,10 @@ static void *Slave(void *handle)
 
         const mtime_t master_date   = ntoh64(data[0]);
         const mtime_t master_system = ntoh64(data[1]);
-        const mtime_t diff_date = receive_date -
-                                  ((receive_date - send_date) / 2 + master_date);
+        syn_clock_add(&clock, receive_date,
+                      receive_date - ((receive_date - send_date) / 2 + master_date),
+                      receive_date - send_date);
+        const mtime_t diff_date = syn_clock_offset(&clock, receive_date);
 
         if (master_system > 0) {
             int canc = vlc_savecancel();
@@ -251,7 +259,9 @@ static void *Slave(void *handle)
             mtime_t client_system;
             if (!input_GetPcrSystem(sys->input, &client_system, NULL)) {
                 const mtime_t diff_system = client_system - master_system - diff_date;
-                if (diff_system != 0) {
+                /* Within the error of the estimate there is nothing to
+                 * correct, moving the clock would only add jitter */
+                if (llabs(diff_system) > syn_clock_error(&clock)) {
                     input_ModifyPcrSystem(sys->input, true, master_system - diff_date);
 #if 0
                     msg_Dbg(intf, "Slave clockref: %"PRId64" -> %"PRId64" -> %"PRId64","
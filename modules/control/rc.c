@@ -43,6 +43,7 @@
 #include <vlc_osd.h>
 #include <vlc_playlist.h>
 #include <vlc_keys.h>
+#include <vlc_memstats.h>
 
 #ifdef HAVE_UNISTD_H
 #    include <unistd.h>
@@ -109,6 +110,8 @@ static int  Menu         ( vlc_object_t *, char const *,
                            vlc_value_t, vlc_value_t, void * );
 static int  Statistics   ( vlc_object_t *, char const *,
                            vlc_value_t, vlc_value_t, void * );
+static int  MemoryStatistics( vlc_object_t *, char const *,
+                              vlc_value_t, vlc_value_t, void * );
 
 static int updateStatistics( intf_thread_t *, input_item_t *);
 
@@ -130,6 +133,10 @@ struct intf_sys_t
     playlist_t        *p_playlist;
     bool              b_input_buffering;
 
+    /* memory statistics at the previous memstats command */
+    vlc_memstats_t    mem_last[VLC_MEM_TAGS];
+    mtime_t           i_mem_last;
+
 #ifdef WIN32
     HANDLE hConsoleIn;
     bool b_quiet;
@@ -324,6 +331,7 @@ static int Activate( vlc_object_t *p_this )
     vlc_mutex_init( &p_intf->p_sys->status_lock );
     p_intf->p_sys->i_last_state = PLAYLIST_STOPPED;
     p_intf->p_sys->b_input_buffering = false;
+    p_intf->p_sys->i_mem_last = 0;
 
     /* Non-buffered stdout */
     setvbuf( stdout, (char *)NULL, _IOLBF, 0 );
@@ -429,6 +437,7 @@ static void RegisterCallbacks( intf_thread_t *p_intf )
 
     /* misc menu commands */
     ADD( "stats", BOOL, Statistics )
+    ADD( "memstats", VOID, MemoryStatistics )
 
 #undef ADD
 }
@@ -830,6 +839,7 @@ static void Help( intf_thread_t *p_intf, bool b_longhelp)
     msg_rc("%s", _("| f [on|off] . . . . . . . . . . . . toggle fullscreen"));
     msg_rc("%s", _("| info . . . . .  information about the current stream"));
     msg_rc("%s", _("| stats  . . . . . . . .  show statistical information"));
+    msg_rc("%s", _("| memstats . . . . . . . . . show memory per subsystem"));
     msg_rc("%s", _("| get_time . . seconds elapsed since stream's beginning"));
     msg_rc("%s", _("| is_playing . . . .  1 if a stream plays, 0 otherwise"));
     msg_rc("%s", _("| get_title . . . . .  the title of the current stream"));
@@ -1863,6 +1873,8 @@ static int updateStatistics( intf_thread_t *p_intf, input_item_t *p_item )
             p_item->p_stats->i_demux_corrupted );
     msg_rc(_("| discontinuities  :    %5"PRIi64),
             p_item->p_stats->i_demux_discontinuity );
+    msg_rc(_("| latency          :    %5"PRIi64" ms"),
+            p_item->p_stats->i_demux_latency / 1000 );
     msg_rc("|");
     /* Video */
     msg_rc("%s", _("+-[Video Decoding]"));
@@ -1898,6 +1910,44 @@ static int updateStatistics( intf_thread_t *p_intf, input_item_t *p_item )
     return VLC_SUCCESS;
 }
 
+static int MemoryStatistics( vlc_object_t *p_this, char const *psz_cmd,
+    vlc_value_t oldval, vlc_value_t newval, void *p_data )
+{
+    VLC_UNUSED(psz_cmd); VLC_UNUSED(oldval); VLC_UNUSED(newval); VLC_UNUSED(p_data);
+    intf_thread_t *p_intf = (intf_thread_t*)p_this;
+    intf_sys_t *p_sys = p_intf->p_sys;
+    vlc_memstats_t st;
+
+    if( vlc_memstats_Get( 0, &st ) )
+    {
+        msg_rc( "%s", _("Memory statistics are not compiled in.") );
+        return VLC_EGENERIC;
+    }
+
+    /* Allocation rates since the previous command */
+    const mtime_t i_now = mdate();
+    const double f_seconds = p_sys->i_mem_last > 0
+                           ? (i_now - p_sys->i_mem_last) / (double)CLOCK_FREQ
+                           : 0.;
+
+    msg_rc( "+----[ begin of memory statistics ]" );
+    msg_rc( "%s", _("| subsystem     live KiB   peak KiB     allocs/s") );
+    for( unsigned i = 0; i < VLC_MEM_TAGS; i++ )
+    {
+        vlc_memstats_Get( i, &st );
+        double f_rate = 0.;
+        if( f_seconds > 0. )
+            f_rate = (st.i_allocs - p_sys->mem_last[i].i_allocs) / f_seconds;
+        msg_rc( "| %-10s %11"PRId64" %10"PRId64" %12.1f",
+                vlc_memstats_Name( i ), st.i_live / 1024, st.i_peak / 1024,
+                f_rate );
+        p_sys->mem_last[i] = st;
+    }
+    msg_rc( "+----[ end of memory statistics ]" );
+    p_sys->i_mem_last = i_now;
+    return VLC_SUCCESS;
+}
+
 #ifdef WIN32
 static bool ReadWin32( intf_thread_t *p_intf, char *p_buffer, int *pi_size )
 {
@@ -41,6 +41,7 @@
 #include <vlc_codecs.h>
 #include <vlc_charset.h>
 #include <vlc_memory.h>
+#include <vlc_fs.h>
 
 #include "libavi.h"
 
@@ -56,6 +57,11 @@
     "Recreate a index for the AVI file. Use this if your AVI file is damaged "\
     "or incomplete (not seekable)." )
 
+#define INDEX_CACHE_TEXT N_("Keep the index")
+#define INDEX_CACHE_LONGTEXT N_( \
+    "Store the index of the AVI files in the cache directory, so that " \
+    "opening them again does not have to load or rebuild it." )
+
 static int  Open ( vlc_object_t * );
 static void Close( vlc_object_t * );
 
@@ -77,6 +83,8 @@ vlc_module_begin ()
     add_integer( "avi-index", 0,
               INDEX_TEXT, INDEX_LONGTEXT, false )
         change_integer_list( pi_index, ppsz_indexes )
+    add_bool( "avi-index-cache", false,
+              INDEX_CACHE_TEXT, INDEX_CACHE_LONGTEXT, true )
 
     set_callbacks( Open, Close )
 vlc_module_end ()
@@ -122,17 +130,75 @@ typedef struct
 
 } avi_entry_t;
 
+/* The index keeps 12 bytes an entry: the position and the cumulated length
+ * are relative to the group of at most AVI_INDEX_GROUP entries it belongs
+ * to, the key frame flag is the top bit of the length. */
+#define AVI_INDEX_GROUP 256
+#define AVI_INDEX_KEY   0x80000000
+
+typedef struct
+{
+    uint32_t i_pos;
+    uint32_t i_length;
+    uint32_t i_lengthtotal;
+
+} avi_index_entry_t;
+
+typedef struct
+{
+    unsigned int i_first;
+    off_t        i_pos;
+    int64_t      i_lengthtotal;
+
+} avi_index_group_t;
+
 typedef struct
 {
-    unsigned int    i_size;
-    unsigned int    i_max;
-    avi_entry_t     *p_entry;
+    unsigned int      i_size;
+    unsigned int      i_max;
+    avi_index_entry_t *p_entry;
+
+    unsigned int      i_group;
+    unsigned int      i_group_max;
+    avi_index_group_t *p_group;
 
 } avi_index_t;
 static void avi_index_Init( avi_index_t * );
 static void avi_index_Clean( avi_index_t * );
 static void avi_index_Append( avi_index_t *, off_t *, avi_entry_t * );
 
+static inline const avi_index_group_t *avi_index_Group( const avi_index_t *p_index,
+                                                         unsigned int i )
+{
+    unsigned int i_lo = 0, i_hi = p_index->i_group;
+    while( i_hi - i_lo > 1 )
+    {
+        unsigned int i_mid = ( i_lo + i_hi ) / 2;
+        if( p_index->p_group[i_mid].i_first <= i )
+            i_lo = i_mid;
+        else
+            i_hi = i_mid;
+    }
+    return &p_index->p_group[i_lo];
+}
+static inline off_t avi_index_Pos( const avi_index_t *p_index, unsigned int i )
+{
+    return avi_index_Group( p_index, i )->i_pos + p_index->p_entry[i].i_pos;
+}
+static inline uint32_t avi_index_Length( const avi_index_t *p_index, unsigned int i )
+{
+    return p_index->p_entry[i].i_length & ~AVI_INDEX_KEY;
+}
+static inline int64_t avi_index_LengthTotal( const avi_index_t *p_index, unsigned int i )
+{
+    return avi_index_Group( p_index, i )->i_lengthtotal +
+           p_index->p_entry[i].i_lengthtotal;
+}
+static inline bool avi_index_IsKey( const avi_index_t *p_index, unsigned int i )
+{
+    return p_index->p_entry[i].i_length & AVI_INDEX_KEY;
+}
+
 typedef struct
 {
     bool            b_activated;
@@ -184,6 +250,10 @@ struct demux_sys_t
 
     unsigned int       i_attachment;
     input_attachment_t **attachment;
+
+    /* index cache */
+    char *psz_index;
+    bool b_index_dirty;
 };
 
 static inline off_t __EVEN( off_t i )
@@ -197,6 +267,7 @@ static mtime_t AVI_GetDPTS   ( avi_track_t *, int64_t i_count );
 static mtime_t AVI_GetPTS    ( avi_track_t * );
 
 
+static void AVI_PrefetchHints( demux_t * );
 static int AVI_StreamChunkFind( demux_t *, unsigned int i_stream );
 static int AVI_StreamChunkSet ( demux_t *,
                                 unsigned int i_stream, unsigned int i_ck );
@@ -214,6 +285,10 @@ static int AVI_PacketSearch   ( demux_t * );
 static void AVI_IndexLoad    ( demux_t * );
 static void AVI_IndexCreate  ( demux_t * );
 
+static void AVI_IndexCacheOpen( demux_t * );
+static bool AVI_IndexCacheLoad( demux_t * );
+static void AVI_IndexCacheSave( demux_t * );
+
 static void AVI_ExtractSubtitle( demux_t *, unsigned int i_stream, avi_chunk_list_t *, avi_chunk_STRING_t * );
 
 static mtime_t  AVI_MovieGetLength( demux_t * );
@@ -625,6 +700,8 @@ static int Open( vlc_object_t * p_this )
         goto error;
     }
 
+    AVI_IndexCacheOpen( p_demux );
+
     i_do_index = var_InheritInteger( p_demux, "avi-index" );
     if( i_do_index == 1 ) /* Always fix */
     {
@@ -638,10 +715,12 @@ aviindex:
             msg_Warn( p_demux, "cannot create index (unseekable stream)" );
             AVI_IndexLoad( p_demux );
         }
+        p_sys->b_index_dirty = true;
     }
-    else
+    else if( !AVI_IndexCacheLoad( p_demux ) )
     {
         AVI_IndexLoad( p_demux );
+        p_sys->b_index_dirty = true;
     }
 
     /* *** movie length in sec *** */
@@ -719,8 +798,8 @@ aviindex:
             (unsigned int)tk->i_rate == p_auds->p_wf->nSamplesPerSec )
         {
             int64_t i_track_length =
-                tk->idx.p_entry[tk->idx.i_size-1].i_length +
-                tk->idx.p_entry[tk->idx.i_size-1].i_lengthtotal;
+                avi_index_Length( &tk->idx, tk->idx.i_size-1 ) +
+                avi_index_LengthTotal( &tk->idx, tk->idx.i_size-1 );
             mtime_t i_length = (mtime_t)p_avih->i_totalframes *
                                (mtime_t)p_avih->i_microsecperframe;
 
@@ -755,6 +834,7 @@ error:
         vlc_meta_Delete( p_sys->meta );
 
     AVI_ChunkFreeRoot( p_demux->s, &p_sys->ck_root );
+    free( p_sys->psz_index );
     free( p_sys );
     return vlc_object_alive( p_demux ) ? VLC_EGENERIC : VLC_ETIMEOUT;
 }
@@ -768,6 +848,9 @@ static void Close ( vlc_object_t * p_this )
     unsigned int i;
     demux_sys_t *p_sys = p_demux->p_sys  ;
 
+    AVI_IndexCacheSave( p_demux );
+    free( p_sys->psz_index );
+
     for( i = 0; i < p_sys->i_track; i++ )
     {
         if( p_sys->track[i] )
@@ -876,7 +959,7 @@ static int Demux_Seekable( demux_t *p_demux )
         toread[i_track].b_ok = tk->b_activated && !tk->b_eof;
         if( tk->i_idxposc < tk->idx.i_size )
         {
-            toread[i_track].i_posf = tk->idx.p_entry[tk->i_idxposc].i_pos;
+            toread[i_track].i_posf = avi_index_Pos( &tk->idx, tk->i_idxposc );
            if( tk->i_idxposb > 0 )
            {
                 toread[i_track].i_posf += 8 + tk->i_idxposb;
@@ -1013,6 +1096,7 @@ static int Demux_Seekable( demux_t *p_demux )
                     index.i_pos    = avi_pk.i_pos;
                     index.i_length = avi_pk.i_size;
                     avi_index_Append( &tk->idx, &p_sys->i_movi_lastchunk_pos, &index );
+                    p_sys->b_index_dirty = true;
 
                     /* do we will read this data ? */
                     if( AVI_GetDPTS( tk, toread[i_track].i_toread ) > -25*1000 )
@@ -1057,13 +1141,13 @@ static int Demux_Seekable( demux_t *p_demux )
                     i_toread = __MAX( i_toread, 100 );
                 }
             }
-            i_size = __MIN( tk->idx.p_entry[tk->i_idxposc].i_length -
+            i_size = __MIN( avi_index_Length( &tk->idx, tk->i_idxposc ) -
                                 tk->i_idxposb,
                             i_toread );
         }
         else
         {
-            i_size = tk->idx.p_entry[tk->i_idxposc].i_length;
+            i_size = avi_index_Length( &tk->idx, tk->i_idxposc );
         }
 
         if( tk->i_idxposb == 0 )
@@ -1089,7 +1173,7 @@ static int Demux_Seekable( demux_t *p_demux )
             p_frame->i_buffer -= 8;
         }
         p_frame->i_pts = AVI_GetPTS( tk ) + 1;
-        if( tk->idx.p_entry[tk->i_idxposc].i_flags&AVIIF_KEYFRAME )
+        if( avi_index_IsKey( &tk->idx, tk->i_idxposc ) )
         {
             p_frame->i_flags = BLOCK_FLAG_TYPE_I;
         }
@@ -1108,7 +1192,7 @@ static int Demux_Seekable( demux_t *p_demux )
             toread[i_track].i_toread -= i_size;
             tk->i_idxposb += i_size;
             if( tk->i_idxposb >=
-                    tk->idx.p_entry[tk->i_idxposc].i_length )
+                    avi_index_Length( &tk->idx, tk->i_idxposc ) )
             {
                 tk->i_idxposb = 0;
                 tk->i_idxposc++;
@@ -1116,7 +1200,7 @@ static int Demux_Seekable( demux_t *p_demux )
         }
         else
         {
-            int i_length = tk->idx.p_entry[tk->i_idxposc].i_length;
+            int i_length = avi_index_Length( &tk->idx, tk->i_idxposc );
 
             tk->i_idxposc++;
             if( tk->i_cat == AUDIO_ES )
@@ -1129,7 +1213,7 @@ static int Demux_Seekable( demux_t *p_demux )
         if( tk->i_idxposc < tk->idx.i_size)
         {
             toread[i_track].i_posf =
-                tk->idx.p_entry[tk->i_idxposc].i_pos;
+                avi_index_Pos( &tk->idx, tk->i_idxposc );
             if( tk->i_idxposb > 0 )
             {
                 toread[i_track].i_posf += 8 + tk->i_idxposb;
@@ -1356,8 +1440,8 @@ static int Seek( demux_t *p_demux, mtime_t i_date, int i_percent )
                 return VLC_EGENERIC;
             }
 
-            while( i_pos >= p_stream->idx.p_entry[p_stream->i_idxposc].i_pos +
-               p_stream->idx.p_entry[p_stream->i_idxposc].i_length + 8 )
+            while( i_pos >= avi_index_Pos( &p_stream->idx, p_stream->i_idxposc ) +
+               avi_index_Length( &p_stream->idx, p_stream->i_idxposc ) + 8 )
             {
                 /* search after i_idxposc */
                 if( AVI_StreamChunkSet( p_demux,
@@ -1383,6 +1467,7 @@ static int Seek( demux_t *p_demux, mtime_t i_date, int i_percent )
 
             p_stream->b_eof = AVI_TrackSeek( p_demux, i_stream, i_date ) != 0;
         }
+        AVI_PrefetchHints( p_demux );
         es_out_Control( p_demux->out, ES_OUT_SET_NEXT_DISPLAY_TIME, i_date );
         p_sys->i_time = i_date;
         msg_Dbg( p_demux, "seek: %"PRId64" seconds", p_sys->i_time /1000000 );
@@ -1418,8 +1503,8 @@ static double ControlGetPosition( demux_t *p_demux )
             avi_track_t *tk = p_sys->track[i];
             if( tk->b_activated && tk->i_idxposc < tk->idx.i_size )
             {
-                i_tmp = tk->idx.p_entry[tk->i_idxposc].i_pos +
-                        tk->idx.p_entry[tk->i_idxposc].i_length + 8;
+                i_tmp = avi_index_Pos( &tk->idx, tk->i_idxposc ) +
+                        avi_index_Length( &tk->idx, tk->i_idxposc ) + 8;
                 if( i_tmp > i64 )
                 {
                     i64 = i_tmp;
@@ -1580,13 +1665,13 @@ static mtime_t AVI_GetPTS( avi_track_t *tk )
             if( tk->i_idxposc )
             {
                 /* use the last entry */
-                i_count = tk->idx.p_entry[tk->idx.i_size - 1].i_lengthtotal
-                            + tk->idx.p_entry[tk->idx.i_size - 1].i_length;
+                i_count = avi_index_LengthTotal( &tk->idx, tk->idx.i_size - 1 )
+                            + avi_index_Length( &tk->idx, tk->idx.i_size - 1 );
             }
         }
         else
         {
-            i_count = tk->idx.p_entry[tk->i_idxposc].i_lengthtotal;
+            i_count = avi_index_LengthTotal( &tk->idx, tk->i_idxposc );
         }
         return AVI_GetDPTS( tk, i_count + tk->i_idxposb );
     }
@@ -1664,6 +1749,7 @@ static int AVI_StreamChunkFind( demux_t *p_demux, unsigned int i_stream )
             index.i_pos    = avi_pk.i_pos;
             index.i_length = avi_pk.i_size;
             avi_index_Append( &tk_pk->idx, &p_sys->i_movi_lastchunk_pos, &index );
+            p_sys->b_index_dirty = true;
 
             if( avi_pk.i_stream == i_stream  )
             {
@@ -1714,8 +1800,8 @@ static int AVI_StreamBytesSet( demux_t    *p_demux,
     avi_track_t *p_stream = p_sys->track[i_stream];
 
     if( ( p_stream->idx.i_size > 0 )
-        &&( i_byte < p_stream->idx.p_entry[p_stream->idx.i_size - 1].i_lengthtotal +
-                p_stream->idx.p_entry[p_stream->idx.i_size - 1].i_length ) )
+        &&( i_byte < avi_index_LengthTotal( &p_stream->idx, p_stream->idx.i_size - 1 ) +
+                avi_index_Length( &p_stream->idx, p_stream->idx.i_size - 1 ) ) )
     {
         /* index is valid to find the ck */
         /* uses dichototmie to be fast enougth */
@@ -1724,15 +1810,15 @@ static int AVI_StreamBytesSet( demux_t    *p_demux,
         int i_idxmin  = 0;
         for( ;; )
         {
-            if( p_stream->idx.p_entry[i_idxposc].i_lengthtotal > i_byte )
+            if( avi_index_LengthTotal( &p_stream->idx, i_idxposc ) > i_byte )
             {
                 i_idxmax  = i_idxposc ;
                 i_idxposc = ( i_idxmin + i_idxposc ) / 2 ;
             }
             else
             {
-                if( p_stream->idx.p_entry[i_idxposc].i_lengthtotal +
-                        p_stream->idx.p_entry[i_idxposc].i_length <= i_byte)
+                if( avi_index_LengthTotal( &p_stream->idx, i_idxposc ) +
+                        avi_index_Length( &p_stream->idx, i_idxposc ) <= i_byte)
                 {
                     i_idxmin  = i_idxposc ;
                     i_idxposc = (i_idxmax + i_idxposc ) / 2 ;
@@ -1741,7 +1827,7 @@ static int AVI_StreamBytesSet( demux_t    *p_demux,
                 {
                     p_stream->i_idxposc = i_idxposc;
                     p_stream->i_idxposb = i_byte -
-                            p_stream->idx.p_entry[i_idxposc].i_lengthtotal;
+                            avi_index_LengthTotal( &p_stream->idx, i_idxposc );
                     return VLC_SUCCESS;
                 }
             }
@@ -1760,15 +1846,45 @@ static int AVI_StreamBytesSet( demux_t    *p_demux,
                 return VLC_EGENERIC;
             }
 
-        } while( p_stream->idx.p_entry[p_stream->i_idxposc].i_lengthtotal +
-                    p_stream->idx.p_entry[p_stream->i_idxposc].i_length <= i_byte );
+        } while( avi_index_LengthTotal( &p_stream->idx, p_stream->i_idxposc ) +
+                    avi_index_Length( &p_stream->idx, p_stream->i_idxposc ) <= i_byte );
 
         p_stream->i_idxposb = i_byte -
-                       p_stream->idx.p_entry[p_stream->i_idxposc].i_lengthtotal;
+                       avi_index_LengthTotal( &p_stream->idx, p_stream->i_idxposc );
         return VLC_SUCCESS;
     }
 }
 
+/* Tell the stream which chunks are read right after a seek */
+#define AVI_HINT_CHUNKS 4
+static void AVI_PrefetchHints( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    stream_range_t *p_range;
+    int i_count = 0;
+
+    p_range = malloc( p_sys->i_track * AVI_HINT_CHUNKS * sizeof( *p_range ) );
+    if( !p_range )
+        return;
+
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+    {
+        avi_track_t *tk = p_sys->track[i];
+
+        if( !tk->b_activated || tk->b_eof )
+            continue;
+        for( unsigned j = tk->i_idxposc;
+             j < tk->idx.i_size && j < tk->i_idxposc + AVI_HINT_CHUNKS; j++ )
+        {
+            p_range[i_count].i_offset = avi_index_Pos( &tk->idx, j );
+            p_range[i_count].i_size = __EVEN( avi_index_Length( &tk->idx, j ) ) + 8;
+            i_count++;
+        }
+    }
+    stream_Control( p_demux->s, STREAM_SET_PREFETCH_HINTS, p_range, i_count );
+    free( p_range );
+}
+
 static int AVI_TrackSeek( demux_t *p_demux,
                            int i_stream,
                            mtime_t i_date )
@@ -1798,7 +1914,7 @@ static int AVI_TrackSeek( demux_t *p_demux,
             {
                 if( tk->i_blocksize > 0 )
                 {
-                    tk->i_blockno += ( tk->idx.p_entry[i].i_length + tk->i_blocksize - 1 ) / tk->i_blocksize;
+                    tk->i_blockno += ( avi_index_Length( &tk->idx, i ) + tk->i_blocksize - 1 ) / tk->i_blocksize;
                 }
                 else
                 {
@@ -1819,8 +1935,7 @@ static int AVI_TrackSeek( demux_t *p_demux,
             //if( i_date < i_oldpts || 1 )
             {
                 while( p_stream->i_idxposc > 0 &&
-                   !( p_stream->idx.p_entry[p_stream->i_idxposc].i_flags &
-                                                                AVIIF_KEYFRAME ) )
+                   !avi_index_IsKey( &p_stream->idx, p_stream->i_idxposc ) )
                 {
                     if( AVI_StreamChunkSet( p_demux,
                                             i_stream,
@@ -1834,8 +1949,7 @@ static int AVI_TrackSeek( demux_t *p_demux,
             else
             {
                 while( p_stream->i_idxposc < p_stream->idx.i_size &&
-                        !( p_stream->idx.p_entry[p_stream->i_idxposc].i_flags &
-                                                                AVIIF_KEYFRAME ) )
+                        !avi_index_IsKey( &p_stream->idx, p_stream->i_idxposc ) )
                 {
                     if( AVI_StreamChunkSet( p_demux,
                                             i_stream,
@@ -2100,10 +2214,14 @@ static void avi_index_Init( avi_index_t *p_index )
     p_index->i_size  = 0;
     p_index->i_max   = 0;
     p_index->p_entry = NULL;
+    p_index->i_group     = 0;
+    p_index->i_group_max = 0;
+    p_index->p_group     = NULL;
 }
 static void avi_index_Clean( avi_index_t *p_index )
 {
     free( p_index->p_entry );
+    free( p_index->p_group );
 }
 static void avi_index_Append( avi_index_t *p_index, off_t *pi_last_pos,
                               avi_entry_t *p_entry )
@@ -2119,21 +2237,55 @@ static void avi_index_Append( avi_index_t *p_index, off_t *pi_last_pos,
         p_index->p_entry = realloc_or_free( p_index->p_entry,
                                             p_index->i_max * sizeof( *p_index->p_entry ) );
         if( !p_index->p_entry )
+        {
+            avi_index_Clean( p_index );
+            avi_index_Init( p_index );
             return;
+        }
     }
     /* calculate cumulate length */
+    const uint32_t i_length = p_entry->i_length & ~AVI_INDEX_KEY;
+    int64_t i_lengthtotal = 0;
+    avi_index_group_t *p_group = NULL;
     if( p_index->i_size > 0 )
     {
-        p_entry->i_lengthtotal =
-            p_index->p_entry[p_index->i_size - 1].i_length +
-                p_index->p_entry[p_index->i_size - 1].i_lengthtotal;
+        const avi_index_entry_t *p_last = &p_index->p_entry[p_index->i_size - 1];
+
+        p_group = &p_index->p_group[p_index->i_group - 1];
+        i_lengthtotal = p_group->i_lengthtotal + p_last->i_lengthtotal +
+                        ( p_last->i_length & ~AVI_INDEX_KEY );
     }
-    else
+
+    /* start a group when full, or when the entry is too far from it */
+    if( !p_group ||
+        p_index->i_size - p_group->i_first >= AVI_INDEX_GROUP ||
+        p_entry->i_pos < p_group->i_pos ||
+        p_entry->i_pos - p_group->i_pos > UINT32_MAX ||
+        i_lengthtotal - p_group->i_lengthtotal > UINT32_MAX )
     {
-        p_entry->i_lengthtotal = 0;
+        if( p_index->i_group >= p_index->i_group_max )
+        {
+            p_index->i_group_max += 64;
+            p_index->p_group = realloc_or_free( p_index->p_group,
+                                                p_index->i_group_max * sizeof( *p_index->p_group ) );
+            if( !p_index->p_group )
+            {
+                avi_index_Clean( p_index );
+                avi_index_Init( p_index );
+                return;
+            }
+        }
+        p_group = &p_index->p_group[p_index->i_group++];
+        p_group->i_first       = p_index->i_size;
+        p_group->i_pos         = p_entry->i_pos;
+        p_group->i_lengthtotal = i_lengthtotal;
     }
 
-    p_index->p_entry[p_index->i_size++] = *p_entry;
+    avi_index_entry_t *p_new = &p_index->p_entry[p_index->i_size++];
+    p_new->i_pos         = p_entry->i_pos - p_group->i_pos;
+    p_new->i_length      = i_length |
+                           ( ( p_entry->i_flags & AVIIF_KEYFRAME ) ? AVI_INDEX_KEY : 0 );
+    p_new->i_lengthtotal = i_lengthtotal - p_group->i_lengthtotal;
 }
 
 static int AVI_IndexFind_idx1( demux_t *p_demux,
@@ -2354,12 +2506,12 @@ static void AVI_IndexLoad( demux_t *p_demux )
         /* Fix key flag */
         bool b_key = false;
         for( unsigned j = 0; !b_key && j < p_index->i_size; j++ )
-            b_key = p_index->p_entry[j].i_flags & AVIIF_KEYFRAME;
+            b_key = avi_index_IsKey( p_index, j );
         if( !b_key )
         {
             msg_Err( p_demux, "no key frame set for track %u", i );
             for( unsigned j = 0; j < p_index->i_size; j++ )
-                p_index->p_entry[j].i_flags |= AVIIF_KEYFRAME;
+                p_index->p_entry[j].i_length |= AVI_INDEX_KEY;
         }
 
         /* */
@@ -2496,6 +2648,187 @@ print_stat:
     }
 }
 
+/* The index cache file: magic, file size, last chunk position and number of
+ * tracks, then for each track the number of entries and of groups, the
+ * groups and the entries, all big endian. */
+#define AVI_INDEX_MAGIC "VLCAVIX1"
+#define AVI_INDEX_HEADER 32
+
+static void AVI_IndexCacheOpen( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( !var_InheritBool( p_demux, "avi-index-cache" ) || !p_sys->b_seekable )
+        return;
+
+    p_sys->psz_index = demux_IndexCachePath( p_demux, "avi-index" );
+}
+
+static bool AVI_IndexCacheLoadTrack( FILE *p_file, avi_index_t *p_index,
+                                     uint64_t i_file_size )
+{
+    uint8_t p_buf[20];
+
+    if( fread( p_buf, 8, 1, p_file ) != 1 )
+        return false;
+    const uint32_t i_size = GetDWBE( &p_buf[0] );
+    const uint32_t i_group = GetDWBE( &p_buf[4] );
+    /* a chunk takes 8 bytes at least */
+    if( i_size > i_file_size / 8 || i_group > i_size ||
+        ( i_size > 0 ) != ( i_group > 0 ) )
+        return false;
+    if( i_size == 0 )
+        return true;
+
+    p_index->p_group = malloc( i_group * sizeof( *p_index->p_group ) );
+    p_index->p_entry = malloc( i_size * sizeof( *p_index->p_entry ) );
+    if( !p_index->p_group || !p_index->p_entry )
+        return false;
+    p_index->i_group = p_index->i_group_max = i_group;
+    p_index->i_size = p_index->i_max = i_size;
+
+    for( uint32_t i = 0; i < i_group; i++ )
+    {
+        avi_index_group_t *p_group = &p_index->p_group[i];
+
+        if( fread( p_buf, 20, 1, p_file ) != 1 )
+            return false;
+        p_group->i_first = GetDWBE( &p_buf[0] );
+        p_group->i_pos = GetQWBE( &p_buf[4] );
+        p_group->i_lengthtotal = GetQWBE( &p_buf[12] );
+        if( p_group->i_first >= i_size ||
+            ( i == 0 && p_group->i_first != 0 ) ||
+            ( i > 0 && p_group->i_first <= p_group[-1].i_first ) ||
+            p_group->i_pos < 0 || (uint64_t)p_group->i_pos >= i_file_size ||
+            p_group->i_lengthtotal < 0 )
+            return false;
+    }
+
+    /* the entries are read in place, then byte swapped */
+    if( fread( p_index->p_entry, sizeof( *p_index->p_entry ), i_size,
+               p_file ) != i_size )
+        return false;
+    for( uint32_t i = 0; i < i_size; i++ )
+    {
+        avi_index_entry_t *p_entry = &p_index->p_entry[i];
+        const uint8_t *p_raw = (const uint8_t *)p_entry;
+        const uint32_t i_pos = GetDWBE( &p_raw[0] );
+        const uint32_t i_length = GetDWBE( &p_raw[4] );
+        const uint32_t i_lengthtotal = GetDWBE( &p_raw[8] );
+
+        p_entry->i_pos = i_pos;
+        p_entry->i_length = i_length;
+        p_entry->i_lengthtotal = i_lengthtotal;
+    }
+    return true;
+}
+
+static bool AVI_IndexCacheLoad( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    uint8_t p_head[AVI_INDEX_HEADER];
+    bool b_ok = false;
+
+    if( !p_sys->psz_index )
+        return false;
+
+    FILE *p_file = vlc_fopen( p_sys->psz_index, "rb" );
+    if( !p_file )
+        return false;
+
+    const uint64_t i_file_size = stream_Size( p_demux->s );
+    if( fread( p_head, sizeof( p_head ), 1, p_file ) != 1 ||
+        memcmp( p_head, AVI_INDEX_MAGIC, 8 ) ||
+        GetQWBE( &p_head[8] ) != i_file_size ||
+        GetQWBE( &p_head[16] ) >= i_file_size ||
+        GetDWBE( &p_head[24] ) != p_sys->i_track )
+        goto out;
+
+    avi_index_t *p_idx = calloc( p_sys->i_track, sizeof( *p_idx ) );
+    if( !p_idx )
+        goto out;
+
+    b_ok = true;
+    for( unsigned i = 0; b_ok && i < p_sys->i_track; i++ )
+        b_ok = AVI_IndexCacheLoadTrack( p_file, &p_idx[i], i_file_size );
+
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+    {
+        if( b_ok )
+        {
+            avi_index_Clean( &p_sys->track[i]->idx );
+            p_sys->track[i]->idx = p_idx[i];
+        }
+        else
+            avi_index_Clean( &p_idx[i] );
+    }
+    free( p_idx );
+
+    if( b_ok )
+    {
+        p_sys->i_movi_lastchunk_pos = GetQWBE( &p_head[16] );
+        msg_Dbg( p_demux, "index loaded from %s", p_sys->psz_index );
+    }
+out:
+    fclose( p_file );
+    return b_ok;
+}
+
+static void AVI_IndexCacheSave( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    uint8_t p_buf[AVI_INDEX_GROUP * sizeof( avi_index_entry_t )];
+
+    if( !p_sys->psz_index || !p_sys->b_index_dirty )
+        return;
+
+    FILE *p_file = demux_IndexCacheCreate( p_demux, p_sys->psz_index );
+    if( !p_file )
+        return;
+
+    memset( p_buf, 0, AVI_INDEX_HEADER );
+    memcpy( p_buf, AVI_INDEX_MAGIC, 8 );
+    SetQWBE( &p_buf[8], stream_Size( p_demux->s ) );
+    SetQWBE( &p_buf[16], p_sys->i_movi_lastchunk_pos );
+    SetDWBE( &p_buf[24], p_sys->i_track );
+    bool b_ok = fwrite( p_buf, AVI_INDEX_HEADER, 1, p_file ) == 1;
+
+    for( unsigned i = 0; b_ok && i < p_sys->i_track; i++ )
+    {
+        const avi_index_t *p_index = &p_sys->track[i]->idx;
+
+        SetDWBE( &p_buf[0], p_index->i_size );
+        SetDWBE( &p_buf[4], p_index->i_group );
+        b_ok = fwrite( p_buf, 8, 1, p_file ) == 1;
+
+        for( unsigned j = 0; b_ok && j < p_index->i_group; j++ )
+        {
+            const avi_index_group_t *p_group = &p_index->p_group[j];
+
+            SetDWBE( &p_buf[0], p_group->i_first );
+            SetQWBE( &p_buf[4], p_group->i_pos );
+            SetQWBE( &p_buf[12], p_group->i_lengthtotal );
+            b_ok = fwrite( p_buf, 20, 1, p_file ) == 1;
+        }
+        for( unsigned j = 0; b_ok && j < p_index->i_size; j += AVI_INDEX_GROUP )
+        {
+            const unsigned i_count = __MIN( p_index->i_size - j, AVI_INDEX_GROUP );
+
+            for( unsigned k = 0; k < i_count; k++ )
+            {
+                const avi_index_entry_t *p_entry = &p_index->p_entry[j + k];
+
+                SetDWBE( &p_buf[12 * k + 0], p_entry->i_pos );
+                SetDWBE( &p_buf[12 * k + 4], p_entry->i_length );
+                SetDWBE( &p_buf[12 * k + 8], p_entry->i_lengthtotal );
+            }
+            b_ok = fwrite( p_buf, 12, i_count, p_file ) == i_count;
+        }
+    }
+
+    demux_IndexCacheClose( p_demux, p_sys->psz_index, p_file, b_ok );
+}
+
 /* */
 static void AVI_MetaLoad( demux_t *p_demux,
                           avi_chunk_list_t *p_riff, avi_chunk_avih_t *p_avih )
@@ -2723,8 +3056,8 @@ static mtime_t  AVI_MovieGetLength( demux_t *p_demux )
         if( tk->i_samplesize )
         {
             i_length = AVI_GetDPTS( tk,
-                                    tk->idx.p_entry[tk->idx.i_size-1].i_lengthtotal +
-                                        tk->idx.p_entry[tk->idx.i_size-1].i_length );
+                                    avi_index_LengthTotal( &tk->idx, tk->idx.i_size-1 ) +
+                                        avi_index_Length( &tk->idx, tk->idx.i_size-1 ) );
         }
         else
         {
@@ -146,18 +146,26 @@ static int Open( vlc_object_t * p_this )
         return VLC_EGENERIC;
     }
 
-    /* Load the FLAC packetizer */
-    /* Store STREAMINFO for the decoder and packetizer */
-    p_streaminfo[4] |= 0x80; /* Fake this as the last metadata block */
-    es_format_Init( &fmt, AUDIO_ES, VLC_CODEC_FLAC );
-    fmt.i_extra = i_streaminfo;
-    fmt.p_extra = p_streaminfo;
-
-    p_sys->p_packetizer = demux_PacketizerNew( p_demux, &fmt, "flac" );
-    if( !p_sys->p_packetizer )
+    /* Load the FLAC packetizer, unless only the meta data are wanted */
+    if( p_demux->b_meta_only )
     {
-        free( p_sys );
-        return VLC_EGENERIC;
+        free( p_streaminfo );
+        p_sys->p_packetizer = NULL;
+    }
+    else
+    {
+        /* Store STREAMINFO for the decoder and packetizer */
+        p_streaminfo[4] |= 0x80; /* Fake this as the last metadata block */
+        es_format_Init( &fmt, AUDIO_ES, VLC_CODEC_FLAC );
+        fmt.i_extra = i_streaminfo;
+        fmt.p_extra = p_streaminfo;
+
+        p_sys->p_packetizer = demux_PacketizerNew( p_demux, &fmt, "flac" );
+        if( !p_sys->p_packetizer )
+        {
+            free( p_sys );
+            return VLC_EGENERIC;
+        }
     }
 
     if( p_sys->i_cover_idx < p_sys->i_attachments )
@@ -189,7 +197,8 @@ static void Close( vlc_object_t * p_this )
     TAB_CLEAN( p_sys->i_attachments, p_sys->attachments);
 
     /* Delete the decoder */
-    demux_PacketizerDestroy( p_sys->p_packetizer );
+    if( p_sys->p_packetizer )
+        demux_PacketizerDestroy( p_sys->p_packetizer );
 
     if( p_sys->p_meta )
         vlc_meta_Delete( p_sys->p_meta );
@@ -206,6 +215,8 @@ static int Demux( demux_t *p_demux )
     demux_sys_t *p_sys = p_demux->p_sys;
     block_t     *p_block_in, *p_block_out;
 
+    if( p_sys->p_packetizer == NULL )
+        return 0;
     if( !( p_block_in = stream_Block( p_demux->s, FLAC_PACKET_SIZE ) ) )
         return 0;
 
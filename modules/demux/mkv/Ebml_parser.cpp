@@ -26,6 +26,49 @@
 #include "Ebml_parser.hpp"
 #include "stream_io_callback.hpp"
 
+#define MKV_SIMPLEBLOCK_ID 0xA3
+
+/*****************************************************************************
+ * Ebml elements read in place
+ *****************************************************************************/
+/* Reads an EBML variable size integer, an ID keeps its length marker.
+ * Returns its length, 0 if invalid. An unknown size is UINT64_MAX */
+int EbmlReadVint( const uint8_t *p, int i_max, int i_len_max,
+                  bool b_id, uint64_t *pi_value )
+{
+    if( i_max < 1 || p[0] == 0 )
+        return 0;
+
+    int i_len = 1;
+    while( !( p[0] & ( 0x80 >> ( i_len - 1 ) ) ) )
+        i_len++;
+    if( i_len > i_len_max || i_len > i_max )
+        return 0;
+
+    uint64_t i_value = b_id ? p[0] : p[0] & ( 0xff >> i_len );
+    bool b_unknown = i_value == (uint64_t)( 0xff >> i_len );
+    for( int i = 1; i < i_len; i++ )
+    {
+        i_value = ( i_value << 8 ) | p[i];
+        b_unknown &= p[i] == 0xff;
+    }
+    *pi_value = ( !b_id && b_unknown ) ? UINT64_MAX : i_value;
+    return i_len;
+}
+
+/* Reads the ID and size of an element, returns the length of both */
+int EbmlReadHeader( const uint8_t *p, int i_max,
+                    uint64_t *pi_id, uint64_t *pi_size )
+{
+    int i_id = EbmlReadVint( p, i_max, 4, true, pi_id );
+    if( i_id == 0 )
+        return 0;
+    int i_size = EbmlReadVint( p + i_id, i_max - i_id, 8, false, pi_size );
+    if( i_size == 0 )
+        return 0;
+    return i_id + i_size;
+}
+
 /*****************************************************************************
  * Ebml Stream parser
  *****************************************************************************/
@@ -139,6 +182,22 @@ void EbmlParser::Reset( demux_t *p_demux )
     mb_dummy = var_InheritBool( p_demux, "mkv-use-dummy" );
 }
 
+void EbmlParser::SkipCurrent( void )
+{
+    if( m_el[mi_level] )
+    {
+        m_el[mi_level]->SkipData( *m_es, EBML_CONTEXT(m_el[mi_level]) );
+        if( !mb_keep )
+        {
+            if( MKV_IS_ID( m_el[mi_level], KaxBlockVirtual ) )
+                static_cast<KaxBlockVirtualWorkaround*>(m_el[mi_level])->Fix();
+            delete m_el[mi_level];
+        }
+        m_el[mi_level] = NULL;
+        mb_keep = false;
+    }
+}
+
 EbmlElement *EbmlParser::Get( void )
 {
     int i_ulev = 0;
@@ -155,17 +214,7 @@ EbmlElement *EbmlParser::Get( void )
         return ret;
     }
 
-    if( m_el[mi_level] )
-    {
-        m_el[mi_level]->SkipData( *m_es, EBML_CONTEXT(m_el[mi_level]) );
-        if( !mb_keep )
-        {
-            if( MKV_IS_ID( m_el[mi_level], KaxBlockVirtual ) )
-                static_cast<KaxBlockVirtualWorkaround*>(m_el[mi_level])->Fix();
-            delete m_el[mi_level];
-        }
-        mb_keep = false;
-    }
+    SkipCurrent();
     vlc_stream_io_callback & io_stream = (vlc_stream_io_callback &) m_es->I_O();
     uint64 i_size = io_stream.toRead();
     m_el[mi_level] = m_es->FindNextElement( EBML_CONTEXT(m_el[mi_level - 1]),
@@ -198,6 +247,39 @@ EbmlElement *EbmlParser::Get( void )
     return m_el[mi_level];
 }
 
+block_t *EbmlParser::GetSimpleBlock( void )
+{
+    if( mi_user_level != mi_level || m_got )
+        return NULL;
+
+    SkipCurrent();
+
+    stream_t *s = ((vlc_stream_io_callback &) m_es->I_O()).stream();
+    const uint8_t *p_peek;
+    int i_peek = stream_Peek( s, &p_peek, 12 );
+    uint64_t i_id, i_size;
+    int i_head = EbmlReadHeader( p_peek, i_peek, &i_id, &i_size );
+    if( i_head == 0 || i_id != MKV_SIMPLEBLOCK_ID || i_size > INT32_MAX )
+        return NULL;
+
+    /* it must not escape its parent, Get() copes with broken files */
+    EbmlElement *p_parent = m_el[mi_level - 1];
+    if( p_parent->IsFiniteSize() &&
+        stream_Tell( s ) + i_head + i_size >
+        p_parent->GetElementPosition() + p_parent->HeadSize() + p_parent->GetSize() )
+        return NULL;
+
+    if( stream_Read( s, NULL, i_head ) != i_head )
+        return NULL;
+    block_t *p_block = stream_Block( s, i_size );
+    if( p_block != NULL && p_block->i_buffer < i_size )
+    {
+        block_Release( p_block );
+        p_block = NULL;
+    }
+    return p_block;
+}
+
 bool EbmlParser::IsTopPresent( EbmlElement *el ) const
 {
     for( int i = 0; i < mi_level; i++ )
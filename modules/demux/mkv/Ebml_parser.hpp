@@ -27,6 +27,14 @@
 
 #include "mkv.hpp"
 
+/*****************************************************************************
+ * Ebml elements read in place, for the hot paths that do not want libebml
+ *****************************************************************************/
+int EbmlReadVint( const uint8_t *, int i_max, int i_len_max, bool b_id,
+                  uint64_t *pi_value );
+int EbmlReadHeader( const uint8_t *, int i_max, uint64_t *pi_id,
+                    uint64_t *pi_size );
+
 /*****************************************************************************
  * Ebml Stream parser
  *****************************************************************************/
@@ -42,6 +50,9 @@ class EbmlParser
     EbmlElement *Get( void );
     void        Keep( void );
     EbmlElement *UnGet( uint64 i_block_pos, uint64 i_cluster_pos );
+    /* Reads the next element in place if it is a SimpleBlock, and returns
+     * its payload. Otherwise it is left for Get() and NULL is returned */
+    block_t     *GetSimpleBlock( void );
 
     int  GetLevel( void ) const;
 
@@ -49,6 +60,8 @@ class EbmlParser
     bool IsTopPresent( EbmlElement * ) const;
 
   private:
+    void        SkipCurrent( void );
+
     EbmlStream  *m_es;
     int         mi_level;
     EbmlElement *m_el[10];
@@ -30,6 +30,8 @@
 
 #include "Ebml_parser.hpp"
 
+#include "stream_io_callback.hpp"
+
 extern "C" {
 #include "../vobsub.h"
 }
@@ -58,6 +60,7 @@ matroska_segment_c::matroska_segment_c( demux_sys_t & demuxer, EbmlStream & estr
     ,i_tags_position(-1)
     ,i_attachments_position(-1)
     ,cluster(NULL)
+    ,b_cluster_timecode(false)
     ,i_block_pos(0)
     ,i_cluster_pos(0)
     ,i_start_pos(0)
@@ -67,6 +70,10 @@ matroska_segment_c::matroska_segment_c( demux_sys_t & demuxer, EbmlStream & estr
     ,b_cues(false)
     ,i_index(0)
     ,i_index_max(1024)
+    ,p_index_stream(NULL)
+    ,i_index_end(0)
+    ,b_index_stop(false)
+    ,b_index_done(false)
     ,psz_muxing_application(NULL)
     ,psz_writing_application(NULL)
     ,psz_segment_filename(NULL)
@@ -79,10 +86,14 @@ matroska_segment_c::matroska_segment_c( demux_sys_t & demuxer, EbmlStream & estr
     ,b_ref_external_segments(false)
 {
     p_indexes = (mkv_index_t*)malloc( sizeof( mkv_index_t ) * i_index_max );
+    vlc_mutex_init( &index_lock );
 }
 
 matroska_segment_c::~matroska_segment_c()
 {
+    IndexStop();
+    vlc_mutex_destroy( &index_lock );
+
     for( size_t i_track = 0; i_track < tracks.size(); i_track++ )
     {
         delete tracks[i_track]->p_compression_data;
@@ -442,6 +453,247 @@ void matroska_segment_c::IndexAppendCluster( KaxCluster *cluster )
 #undef idx
 }
 
+/*****************************************************************************
+ * Cluster indexer
+ *****************************************************************************
+ * With sparse or no cues, a thread of its own reads the cluster headers over
+ * a second stream, skipping the clusters by their size, and the demuxer
+ * merges what it found into the index when it seeks. Once it got to the end
+ * of the segment, the index is as good as cues.
+ *****************************************************************************/
+#define MKV_CLUSTER_ID       0x1F43B675
+#define MKV_CLUSTER_TIMECODE 0xE7
+#define MKV_CRC32_ID         0xBF
+#define MKV_VOID_ID          0xEC
+
+/* The timecode of a cluster is its first child, but for a CRC or a void */
+static int64_t ClusterReadTimecode( const uint8_t *p, int i_max )
+{
+    while( i_max > 0 )
+    {
+        uint64_t i_id, i_size;
+        int i_head = EbmlReadHeader( p, i_max, &i_id, &i_size );
+        if( i_head == 0 || i_size > (uint64_t)( i_max - i_head ) )
+            return -1;
+        p += i_head;
+        i_max -= i_head;
+
+        if( i_id == MKV_CLUSTER_TIMECODE )
+        {
+            if( i_size > 7 )
+                return -1;
+            int64_t i_timecode = 0;
+            for( unsigned i = 0; i < i_size; i++ )
+                i_timecode = ( i_timecode << 8 ) | p[i];
+            return i_timecode;
+        }
+        if( i_id != MKV_CRC32_ID && i_id != MKV_VOID_ID )
+            return -1;
+        p += i_size;
+        i_max -= i_size;
+    }
+    return -1;
+}
+
+void matroska_segment_c::IndexClusters()
+{
+    stream_t *s = p_index_stream;
+    int64_t  i_pos = i_start_pos;
+    int      i_count = 0;
+
+    while( i_pos < i_index_end )
+    {
+        vlc_mutex_lock( &index_lock );
+        bool b_stop = b_index_stop;
+        vlc_mutex_unlock( &index_lock );
+        if( b_stop )
+            return;
+
+        const uint8_t *p_peek;
+        if( stream_Seek( s, i_pos ) )
+            break;
+        int i_peek = stream_Peek( s, &p_peek, 64 );
+
+        uint64_t i_id, i_size;
+        int i_head = EbmlReadHeader( p_peek, i_peek, &i_id, &i_size );
+        /* the first cluster is where the demuxer found it, or this stream
+         * does not have the same bytes */
+        if( i_head == 0 || i_size == UINT64_MAX ||
+            ( i_count == 0 && i_id != MKV_CLUSTER_ID ) )
+            break;
+
+        if( i_id == MKV_CLUSTER_ID )
+        {
+            int64_t i_timecode =
+                ClusterReadTimecode( p_peek + i_head,
+                                     __MIN( (uint64_t)( i_peek - i_head ), i_size ) );
+            if( i_timecode >= 0 )
+            {
+                mkv_index_t idx;
+                idx.i_track        = -1;
+                idx.i_block_number = -1;
+                idx.i_position     = i_pos;
+                idx.i_time         = i_timecode * i_timescale / (mtime_t)1000;
+                idx.b_key          = true;
+
+                vlc_mutex_lock( &index_lock );
+                index_found.push_back( idx );
+                vlc_mutex_unlock( &index_lock );
+                i_count++;
+            }
+        }
+        if( i_size > (uint64_t)( INT64_MAX - i_pos - i_head ) )
+            break;
+        i_pos += i_head + i_size;
+    }
+
+    vlc_mutex_lock( &index_lock );
+    b_index_done = i_pos >= i_index_end;
+    vlc_mutex_unlock( &index_lock );
+    msg_Dbg( &sys.demuxer, "indexed %d clusters up to %"PRId64"%s", i_count,
+             i_pos, i_pos >= i_index_end ? " (end of segment)" : "" );
+}
+
+void *matroska_segment_c::IndexThread( void *data )
+{
+    matroska_segment_c *p_segment = (matroska_segment_c *)data;
+
+    p_segment->IndexClusters();
+    return NULL;
+}
+
+void matroska_segment_c::IndexStart()
+{
+    stream_t *s = ((vlc_stream_io_callback &) es.I_O()).stream();
+    bool b_seekable;
+
+    if( p_index_stream != NULL || i_start_pos <= 0 )
+        return;
+    /* the cues are enough for seeking, one every 10s at least */
+    if( b_cues && i_index > 0 && i_duration / 10000 <= i_index )
+        return;
+    if( stream_Control( s, STREAM_CAN_SEEK, &b_seekable ) || !b_seekable )
+        return;
+
+    if( segment->IsFiniteSize() )
+        i_index_end = segment->GetElementPosition() + segment->HeadSize() +
+                      segment->GetSize();
+    else
+        i_index_end = stream_Size( s ) > 0 ? stream_Size( s ) : INT64_MAX;
+
+    char *psz_url;
+    if( asprintf( &psz_url, "%s://%s", s->psz_access, s->psz_path ) < 0 )
+        return;
+    p_index_stream = stream_UrlNew( &sys.demuxer, psz_url );
+    free( psz_url );
+    if( p_index_stream == NULL )
+        return;
+
+    if( vlc_clone( &index_thread, IndexThread, this, VLC_THREAD_PRIORITY_LOW ) )
+    {
+        stream_Delete( p_index_stream );
+        p_index_stream = NULL;
+        return;
+    }
+    msg_Dbg( &sys.demuxer, "indexing clusters from %"PRId64, i_start_pos );
+}
+
+void matroska_segment_c::IndexStop()
+{
+    if( p_index_stream == NULL )
+        return;
+
+    vlc_mutex_lock( &index_lock );
+    b_index_stop = true;
+    vlc_mutex_unlock( &index_lock );
+    /* the access does the reads, the stream hangs under it */
+    vlc_object_kill( p_index_stream->p_parent );
+    vlc_join( index_thread, NULL );
+    stream_Delete( p_index_stream );
+    p_index_stream = NULL;
+}
+
+/* Merges the clusters found by the indexer, the index stays sorted by
+ * position and so by time */
+void matroska_segment_c::IndexMerge()
+{
+    std::vector<mkv_index_t> found;
+
+    vlc_mutex_lock( &index_lock );
+    found.swap( index_found );
+    bool b_done = b_index_done;
+    b_index_done = false;
+    vlc_mutex_unlock( &index_lock );
+
+    if( !found.empty() )
+    {
+        int i_merged_max = i_index + found.size() + 1024;
+        mkv_index_t *p_merged =
+            (mkv_index_t*)xmalloc( sizeof( mkv_index_t ) * i_merged_max );
+        int    i_merged = 0;
+        int    i = 0;
+        size_t j = 0;
+
+        while( i < i_index || j < found.size() )
+        {
+            if( i < i_index && p_indexes[i].i_position < 0 )
+                i++; /* a cue without a cluster is no help */
+            else if( j == found.size() ||
+                     ( i < i_index && p_indexes[i].i_position <= found[j].i_position ) )
+            {
+                if( j < found.size() && p_indexes[i].i_position == found[j].i_position )
+                    j++; /* known already */
+                p_merged[i_merged++] = p_indexes[i++];
+            }
+            else
+                p_merged[i_merged++] = found[j++];
+        }
+        free( p_indexes );
+        p_indexes   = p_merged;
+        i_index     = i_merged;
+        i_index_max = i_merged_max;
+    }
+
+    if( b_done && !b_cues )
+    {
+        msg_Dbg( &sys.demuxer, "all %d clusters indexed", i_index );
+        b_cues = true;
+    }
+}
+
+/* Hints the stream at the cluster after the current one, so that it reads
+ * it ahead of the demuxer */
+void matroska_segment_c::ClusterPrefetch()
+{
+    if( !cluster->IsFiniteSize() )
+        return;
+
+    stream_range_t range;
+    range.i_offset = cluster->GetElementPosition() + cluster->HeadSize() +
+                     cluster->GetSize();
+    range.i_size   = cluster->HeadSize() + cluster->GetSize();
+
+    /* the index may know where it ends, else it is as big as this one */
+    int i_low = 0, i_high = i_index;
+    while( i_low < i_high )
+    {
+        int i_mid = ( i_low + i_high ) / 2;
+        if( p_indexes[i_mid].i_position < (int64_t)range.i_offset )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
+    while( i_low < i_index &&
+           p_indexes[i_low].i_position <= (int64_t)range.i_offset )
+        i_low++;
+    if( i_low < i_index && i_low > 0 &&
+        p_indexes[i_low - 1].i_position == (int64_t)range.i_offset )
+        range.i_size = p_indexes[i_low].i_position - range.i_offset;
+
+    stream_Control( ((vlc_stream_io_callback &) es.I_O()).stream(),
+                    STREAM_SET_PREFETCH_HINTS, &range, 1 );
+}
+
 bool matroska_segment_c::PreloadFamily( const matroska_segment_c & of_segment )
 {
     if ( b_preloaded )
@@ -694,6 +946,8 @@ void matroska_segment_c::Seek( mtime_t i_date, mtime_t i_time_offset, int64_t i_
     int i_cat;
     bool b_has_key = false;
 
+    IndexMerge();
+
     if( i_global_position >= 0 )
     {
         /* Special case for seeking in files with no cues */
@@ -749,10 +1003,16 @@ void matroska_segment_c::Seek( mtime_t i_date, mtime_t i_time_offset, int64_t i_
     int i_idx = 0;
     if ( i_index > 0 )
     {
-
-        for( ; i_idx < i_index; i_idx++ )
-            if( p_indexes[i_idx].i_time + i_time_offset > i_date )
-                break;
+        /* first entry after the date, the index is sorted */
+        int i_high = i_index;
+        while( i_idx < i_high )
+        {
+            int i_mid = ( i_idx + i_high ) / 2;
+            if( p_indexes[i_mid].i_time + i_time_offset > i_date )
+                i_high = i_mid;
+            else
+                i_idx = i_mid + 1;
+        }
 
         if( i_idx > 0 )
             i_idx--;
@@ -1429,7 +1689,102 @@ void matroska_segment_c::UnSelect( )
     ep = NULL;
 }
 
-int matroska_segment_c::BlockGet( KaxBlock * & pp_block, KaxSimpleBlock * & pp_simpleblock, bool *pb_key_picture, bool *pb_discardable_picture, int64_t *pi_duration )
+/* Parses the header and lacing of a SimpleBlock read in place */
+int matroska_segment_c::SimpleBlockParse( mkv_simple_block_t *p_raw )
+{
+    const uint8_t *p = p_raw->p_data->p_buffer;
+    size_t         i_max = p_raw->p_data->i_buffer;
+    uint64_t       i_number;
+
+    int i_len = EbmlReadVint( p, (int)i_max, 8, false, &i_number );
+    if( i_len == 0 || i_max < (size_t)i_len + 3 )
+        return VLC_EGENERIC;
+
+    for( p_raw->i_track = 0; p_raw->i_track < tracks.size(); p_raw->i_track++ )
+        if( tracks[p_raw->i_track]->i_number == i_number )
+            break;
+    if( p_raw->i_track >= tracks.size() )
+        return VLC_EGENERIC;
+
+    int16_t i_local = (int16_t)GetWBE( &p[i_len] );
+    uint8_t i_flags = p[i_len + 2];
+    p_raw->i_timecode    = cluster->GlobalTimecode() + (mtime_t)i_local * (mtime_t)i_timescale;
+    p_raw->b_key         = ( i_flags & 0x80 ) != 0;
+    p_raw->b_discardable = ( i_flags & 0x01 ) != 0;
+
+    size_t i_pos = i_len + 3;
+    if( ( i_flags & 0x06 ) == 0 )
+    {
+        p_raw->i_offset  = i_pos;
+        p_raw->i_frames  = 1;
+        p_raw->pi_size[0] = i_max - i_pos;
+        return VLC_SUCCESS;
+    }
+
+    if( i_pos >= i_max )
+        return VLC_EGENERIC;
+    p_raw->i_frames = p[i_pos++] + 1;
+
+    /* sizes of all frames but the last one, which takes what remains */
+    size_t i_laced = 0;
+    switch( i_flags & 0x06 )
+    {
+        case 0x02: /* Xiph */
+            for( unsigned i = 0; i < p_raw->i_frames - 1; i++ )
+            {
+                uint32_t i_size = 0;
+                do
+                {
+                    if( i_pos >= i_max )
+                        return VLC_EGENERIC;
+                    i_size += p[i_pos];
+                } while( p[i_pos++] == 0xff );
+                p_raw->pi_size[i] = i_size;
+                i_laced += i_size;
+            }
+            break;
+
+        case 0x04: /* fixed */
+            if( ( i_max - i_pos ) % p_raw->i_frames )
+                return VLC_EGENERIC;
+            for( unsigned i = 0; i < p_raw->i_frames - 1; i++ )
+            {
+                p_raw->pi_size[i] = ( i_max - i_pos ) / p_raw->i_frames;
+                i_laced += p_raw->pi_size[i];
+            }
+            break;
+
+        case 0x06: /* EBML, the sizes after the first one are differences */
+        {
+            int64_t i_size = 0;
+            for( unsigned i = 0; i < p_raw->i_frames - 1; i++ )
+            {
+                uint64_t i_value;
+                i_len = EbmlReadVint( &p[i_pos], (int)( i_max - i_pos ), 8, false, &i_value );
+                if( i_len == 0 || i_value == UINT64_MAX )
+                    return VLC_EGENERIC;
+                i_pos += i_len;
+                if( i == 0 )
+                    i_size = i_value;
+                else
+                    i_size += (int64_t)i_value - ( ( INT64_C(1) << ( 7 * i_len - 1 ) ) - 1 );
+                if( i_size < 0 || i_size > UINT32_MAX )
+                    return VLC_EGENERIC;
+                p_raw->pi_size[i] = i_size;
+                i_laced += i_size;
+            }
+            break;
+        }
+    }
+    if( i_pos > i_max || i_laced > i_max - i_pos )
+        return VLC_EGENERIC;
+
+    p_raw->i_offset = i_pos;
+    p_raw->pi_size[p_raw->i_frames - 1] = i_max - i_pos - i_laced;
+    return VLC_SUCCESS;
+}
+
+int matroska_segment_c::BlockGet( KaxBlock * & pp_block, KaxSimpleBlock * & pp_simpleblock, bool *pb_key_picture, bool *pb_discardable_picture, int64_t *pi_duration, mkv_simple_block_t *p_raw )
 {
     pp_simpleblock = NULL;
     pp_block = NULL;
@@ -1437,6 +1792,9 @@ int matroska_segment_c::BlockGet( KaxBlock * & pp_block, KaxSimpleBlock * & pp_s
     *pb_key_picture         = true;
     *pb_discardable_picture = false;
 
+    if( p_raw != NULL )
+        p_raw->p_data = NULL;
+
     for( ;; )
     {
         EbmlElement *el = NULL;
@@ -1445,6 +1803,24 @@ int matroska_segment_c::BlockGet( KaxBlock * & pp_block, KaxSimpleBlock * & pp_s
         if ( ep == NULL )
             return VLC_EGENERIC;
 
+        /* the SimpleBlocks of the demuxer are read in place, and sliced
+         * into frames without copies */
+        if( p_raw != NULL && pp_simpleblock == NULL && pp_block == NULL &&
+            cluster != NULL && b_cluster_timecode && ep->GetLevel() == 2 &&
+            ep->IsTopPresent( cluster ) &&
+            ( p_raw->p_data = ep->GetSimpleBlock() ) != NULL )
+        {
+            if( SimpleBlockParse( p_raw ) )
+            {
+                block_Release( p_raw->p_data );
+                p_raw->p_data = NULL;
+                continue;
+            }
+            *pb_key_picture         = p_raw->b_key;
+            *pb_discardable_picture = p_raw->b_discardable;
+            return VLC_SUCCESS;
+        }
+
         if( pp_simpleblock != NULL || ((el = ep->Get()) == NULL && pp_block != NULL) )
         {
             /* Check blocks validity to protect againts broken files */
@@ -1510,6 +1886,8 @@ int matroska_segment_c::BlockGet( KaxBlock * & pp_block, KaxSimpleBlock * & pp_s
             {
                 cluster = (KaxCluster*)el;
                 i_cluster_pos = cluster->GetElementPosition();
+                b_cluster_timecode = false;
+                ClusterPrefetch();
 
                 // reset silent tracks
                 for (size_t i=0; i<tracks.size(); i++)
@@ -1536,6 +1914,7 @@ int matroska_segment_c::BlockGet( KaxBlock * & pp_block, KaxSimpleBlock * & pp_s
 
                 ctc.ReadData( es.I_O(), SCOPE_ALL_DATA );
                 cluster->InitTimecode( uint64( ctc ), i_timescale );
+                b_cluster_timecode = true;
  
                 /* add it to the index */
                 if( i_index == 0 ||
@@ -35,6 +35,7 @@ class chapter_item_c;
 
 struct mkv_track_t;
 struct mkv_index_t;
+struct mkv_simple_block_t;
 
 class matroska_segment_c
 {
@@ -66,6 +67,7 @@ public:
     int64_t                 i_attachments_position;
 
     KaxCluster              *cluster;
+    bool                    b_cluster_timecode;
     uint64                  i_block_pos;
     uint64                  i_cluster_pos;
     int64_t                 i_start_pos;
@@ -78,6 +80,15 @@ public:
     int                     i_index_max;
     mkv_index_t             *p_indexes;
 
+    /* clusters found by the indexer thread, merged by IndexMerge() */
+    vlc_mutex_t             index_lock;
+    vlc_thread_t            index_thread;
+    stream_t                *p_index_stream;
+    int64_t                 i_index_end;
+    bool                    b_index_stop;
+    bool                    b_index_done;
+    std::vector<mkv_index_t> index_found;
+
     /* info */
     char                    *psz_muxing_application;
     char                    *psz_writing_application;
@@ -103,7 +114,10 @@ public:
     bool PreloadFamily( const matroska_segment_c & segment );
     void InformationCreate();
     void Seek( mtime_t i_date, mtime_t i_time_offset, int64_t i_global_position );
-    int BlockGet( KaxBlock * &, KaxSimpleBlock * &, bool *, bool *, int64_t *);
+    void IndexStart();
+    void IndexMerge();
+    int BlockGet( KaxBlock * &, KaxSimpleBlock * &, bool *, bool *, int64_t *,
+                  mkv_simple_block_t *p_raw = NULL );
 
     int BlockFindTrackIndex( size_t *pi_track,
                              const KaxBlock *, const KaxSimpleBlock * );
@@ -127,6 +141,11 @@ private:
     void ParseCluster( bool b_update_start_time = true );
     void ParseSimpleTags( KaxTagSimple *tag );
     void IndexAppendCluster( KaxCluster *cluster );
+    void IndexStop();
+    void IndexClusters();
+    static void *IndexThread( void * );
+    void ClusterPrefetch();
+    int SimpleBlockParse( mkv_simple_block_t * );
 };
 
 
@@ -66,6 +66,10 @@ vlc_module_begin ()
             N_("Seek based on percent not time"),
             N_("Seek based on percent not time."), true );
 
+    add_bool( "mkv-cluster-index", true,
+            N_("Index clusters in the background"),
+            N_("Find the clusters of files with few or no cues in the background, for faster seeking."), true );
+
     add_bool( "mkv-use-dummy", false,
             N_("Dummy Elements"),
             N_("Read and discard unknown EBML elements (not good for broken files)."), true );
@@ -141,7 +145,8 @@ static int Open( vlc_object_t * p_this )
         goto error;
     }
 
-    if (b_need_preload && var_InheritBool( p_demux, "mkv-preload-local-dir" ))
+    if (b_need_preload && !p_demux->b_meta_only &&
+        var_InheritBool( p_demux, "mkv-preload-local-dir" ))
     {
         msg_Dbg( p_demux, "Preloading local dir" );
         /* get the files from the same dir from the same family (based on p_demux->psz_path) */
@@ -246,6 +251,13 @@ static int Open( vlc_object_t * p_this )
         goto error;
     }
 
+    if( !p_demux->b_meta_only && var_InheritBool( p_demux, "mkv-cluster-index" ) )
+    {
+        for( size_t i = 0; i < p_sys->opened_segments.size(); i++ )
+            if( p_sys->opened_segments[i]->b_preloaded )
+                p_sys->opened_segments[i]->IndexStart();
+    }
+
     p_sys->InitUi();
 
     return VLC_SUCCESS;
@@ -440,6 +452,9 @@ static void Seek( demux_t *p_demux, mtime_t i_date, double f_percent, virtual_ch
         return;
     }
 
+    /* take what the cluster indexer found so far */
+    p_segment->IndexMerge();
+
     /* seek without index or without date */
     if( f_percent >= 0 && (var_InheritBool( p_demux, "mkv-seek-percent" ) || !p_segment->b_cues || i_date < 0 ))
     {
@@ -449,10 +464,20 @@ static void Seek( demux_t *p_demux, mtime_t i_date, double f_percent, virtual_ch
             int64_t i_pos = int64_t( f_percent * stream_Size( p_demux->s ) );
 
             msg_Dbg( p_demux, "lengthy way of seeking for pos:%"PRId64, i_pos );
-            for( i_index = 0; i_index < p_segment->i_index; i_index++ )
+            /* first entry from the position on, the index is sorted */
+            int i_high = p_segment->i_index;
+            i_index = 0;
+            while( i_index < i_high )
+            {
+                int i_mid = ( i_index + i_high ) / 2;
+                if( p_segment->p_indexes[i_mid].i_position < i_pos )
+                    i_index = i_mid + 1;
+                else
+                    i_high = i_mid;
+            }
+            for( ; i_index < p_segment->i_index; i_index++ )
             {
-                if( p_segment->p_indexes[i_index].i_position >= i_pos &&
-                    p_segment->p_indexes[i_index].i_time > 0 )
+                if( p_segment->p_indexes[i_index].i_time > 0 )
                     break;
             }
             if( i_index == p_segment->i_index )
@@ -484,7 +509,8 @@ static block_t *MemToBlock( uint8_t *p_mem, size_t i_mem, size_t offset)
 
 /* Needed by matroska_segment::Seek() and Seek */
 void BlockDecode( demux_t *p_demux, KaxBlock *block, KaxSimpleBlock *simpleblock,
-                         mtime_t i_pts, mtime_t i_duration, bool f_mandatory )
+                         mtime_t i_pts, mtime_t i_duration, bool f_mandatory,
+                         const mkv_simple_block_t *p_raw )
 {
     demux_sys_t        *p_sys = p_demux->p_sys;
     matroska_segment_c *p_segment = p_sys->p_current_segment->CurrentSegment();
@@ -492,7 +518,9 @@ void BlockDecode( demux_t *p_demux, KaxBlock *block, KaxSimpleBlock *simpleblock
     if( !p_segment ) return;
 
     size_t          i_track;
-    if( p_segment->BlockFindTrackIndex( &i_track, block, simpleblock ) )
+    if( p_raw != NULL )
+        i_track = p_raw->i_track;
+    else if( p_segment->BlockFindTrackIndex( &i_track, block, simpleblock ) )
     {
         msg_Err( p_demux, "invalid track number" );
         return;
@@ -538,39 +566,58 @@ void BlockDecode( demux_t *p_demux, KaxBlock *block, KaxSimpleBlock *simpleblock
     size_t frame_size = 0;
     size_t block_size = 0;
 
-    if( simpleblock != NULL )
+    if( p_raw != NULL )
+        frame_size = p_raw->i_offset;
+    else if( simpleblock != NULL )
         block_size = simpleblock->GetSize();
     else
         block_size = block->GetSize();
  
     for( unsigned int i = 0;
+         ( p_raw != NULL && i < p_raw->i_frames ) ||
          ( block != NULL && i < block->NumberFrames()) || ( simpleblock != NULL && i < simpleblock->NumberFrames() );
          i++ )
     {
         block_t *p_block;
         DataBuffer *data;
-        if( simpleblock != NULL )
+        if( p_raw != NULL )
         {
-            data = &simpleblock->GetBuffer(i);
-            // condition when the DTS is correct (keyframe or B frame == NOT P frame)
-            f_mandatory = simpleblock->IsDiscardable() || simpleblock->IsKeyframe();
+            size_t i_offset = frame_size;
+
+            frame_size += p_raw->pi_size[i];
+            f_mandatory = p_raw->b_discardable || p_raw->b_key;
+            /* a view of the frame, but when a header goes in front */
+            if( tk->i_compression_type == MATROSKA_COMPRESSION_HEADER && tk->p_compression_data != NULL )
+                p_block = MemToBlock( p_raw->p_data->p_buffer + i_offset, p_raw->pi_size[i],
+                                      tk->p_compression_data->GetSize() );
+            else
+                p_block = block_Slice( p_raw->p_data, i_offset, p_raw->pi_size[i] );
         }
         else
         {
-            data = &block->GetBuffer(i);
-            // condition when the DTS is correct (keyframe or B frame == NOT P frame)
-        }
-        frame_size += data->Size();
-        if( !data->Buffer() || data->Size() > SIZE_MAX || frame_size > block_size  )
-        {
-            msg_Warn( p_demux, "Cannot read frame (too long or no frame)" );
-            break;
-        }
+            if( simpleblock != NULL )
+            {
+                data = &simpleblock->GetBuffer(i);
+                // condition when the DTS is correct (keyframe or B frame == NOT P frame)
+                f_mandatory = simpleblock->IsDiscardable() || simpleblock->IsKeyframe();
+            }
+            else
+            {
+                data = &block->GetBuffer(i);
+                // condition when the DTS is correct (keyframe or B frame == NOT P frame)
+            }
+            frame_size += data->Size();
+            if( !data->Buffer() || data->Size() > SIZE_MAX || frame_size > block_size  )
+            {
+                msg_Warn( p_demux, "Cannot read frame (too long or no frame)" );
+                break;
+            }
 
-        if( tk->i_compression_type == MATROSKA_COMPRESSION_HEADER && tk->p_compression_data != NULL )
-            p_block = MemToBlock( data->Buffer(), data->Size(), tk->p_compression_data->GetSize() );
-        else
-            p_block = MemToBlock( data->Buffer(), data->Size(), 0 );
+            if( tk->i_compression_type == MATROSKA_COMPRESSION_HEADER && tk->p_compression_data != NULL )
+                p_block = MemToBlock( data->Buffer(), data->Size(), tk->p_compression_data->GetSize() );
+            else
+                p_block = MemToBlock( data->Buffer(), data->Size(), 0 );
+        }
 
         if( p_block == NULL )
         {
@@ -686,10 +733,11 @@ static int Demux( demux_t *p_demux)
 
         KaxBlock *block;
         KaxSimpleBlock *simpleblock;
+        mkv_simple_block_t raw;
         int64_t i_block_duration = 0;
         bool b_key_picture;
         bool b_discardable_picture;
-        if( p_segment->BlockGet( block, simpleblock, &b_key_picture, &b_discardable_picture, &i_block_duration ) )
+        if( p_segment->BlockGet( block, simpleblock, &b_key_picture, &b_discardable_picture, &i_block_duration, &raw ) )
         {
             if ( p_vsegment->CurrentEdition() && p_vsegment->CurrentEdition()->b_ordered )
             {
@@ -714,7 +762,9 @@ static int Demux( demux_t *p_demux)
             }
         }
 
-        if( simpleblock != NULL )
+        if( raw.p_data != NULL )
+            p_sys->i_pts = p_sys->i_chapter_time + ( raw.i_timecode / (mtime_t) 1000 );
+        else if( simpleblock != NULL )
             p_sys->i_pts = p_sys->i_chapter_time + ( simpleblock->GlobalTimecode() / (mtime_t) 1000 );
         else
             p_sys->i_pts = p_sys->i_chapter_time + ( block->GlobalTimecode() / (mtime_t) 1000 );
@@ -732,6 +782,8 @@ static int Demux( demux_t *p_demux)
             {
                 i_return = 1;
                 delete block;
+                if( raw.p_data != NULL )
+                    block_Release( raw.p_data );
                 break;
             }
         }
@@ -742,12 +794,17 @@ static int Demux( demux_t *p_demux)
         {
             /* nothing left to read in this ordered edition */
             delete block;
+            if( raw.p_data != NULL )
+                block_Release( raw.p_data );
             break;
         }
 
-        BlockDecode( p_demux, block, simpleblock, p_sys->i_pts, i_block_duration, b_key_picture || b_discardable_picture );
+        BlockDecode( p_demux, block, simpleblock, p_sys->i_pts, i_block_duration, b_key_picture || b_discardable_picture,
+                     raw.p_data != NULL ? &raw : NULL );
 
         delete block;
+        if( raw.p_data != NULL )
+            block_Release( raw.p_data );
         i_block_count++;
 
         // TODO optimize when there is need to leave or when seeking has been called
@@ -121,8 +121,10 @@ extern "C" {
 using namespace LIBMATROSKA_NAMESPACE;
 using namespace std;
 
+struct mkv_simple_block_t;
 void BlockDecode( demux_t *p_demux, KaxBlock *block, KaxSimpleBlock *simpleblock,
-                         mtime_t i_pts, mtime_t i_duration, bool f_mandatory );
+                         mtime_t i_pts, mtime_t i_duration, bool f_mandatory,
+                         const mkv_simple_block_t *p_raw = NULL );
 
 class attachment_c
 {
@@ -234,5 +236,20 @@ struct mkv_index_t
     bool       b_key;
 };
 
+/* A SimpleBlock read in place, see EbmlParser::GetSimpleBlock(). Its
+ * frames are consecutive in p_data from i_offset */
+struct mkv_simple_block_t
+{
+    block_t  *p_data;
+    size_t   i_track;        /* in the tracks of the segment */
+    mtime_t  i_timecode;     /* in ns, as GlobalTimecode() */
+    bool     b_key;
+    bool     b_discardable;
+
+    size_t   i_offset;
+    unsigned i_frames;
+    uint32_t pi_size[256];
+};
+
 
 #endif /* _MKV_HPP_ */
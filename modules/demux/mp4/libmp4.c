@@ -305,6 +305,11 @@ static int MP4_ReadBoxContainerRaw( stream_t *p_stream, MP4_Box_t *p_container )
         else p_container->p_last->p_next = p_box;
         p_container->p_last = p_box;
 
+        /* the movie fragments are read as playback reaches them */
+        if( p_container->i_type == ATOM_root && p_box->i_type == ATOM_moov &&
+            MP4_BoxGet( p_box, "mvex" ) )
+            break;
+
     } while( MP4_NextBox( p_stream, p_box ) == 1 );
 
     return 1;
@@ -543,6 +548,24 @@ static int MP4_ReadBox_tfhd(  stream_t *p_stream, MP4_Box_t *p_box )
     MP4_READBOX_EXIT( 1 );
 }
 
+static int MP4_ReadBox_tfdt( stream_t *p_stream, MP4_Box_t *p_box )
+{
+    MP4_READBOX_ENTER( MP4_Box_data_tfdt_t );
+
+    MP4_GETVERSIONFLAGS( p_box->data.p_tfdt );
+    if( p_box->data.p_tfdt->i_version == 1 )
+        MP4_GET8BYTES( p_box->data.p_tfdt->i_base_media_decode_time );
+    else /* version == 0 */
+        MP4_GET4BYTES( p_box->data.p_tfdt->i_base_media_decode_time );
+
+#ifdef MP4_VERBOSE
+    msg_Dbg( p_stream, "read box: \"tfdt\" base media decode time %"PRIu64,
+             p_box->data.p_tfdt->i_base_media_decode_time );
+#endif
+
+    MP4_READBOX_EXIT( 1 );
+}
+
 static int MP4_ReadBox_trun(  stream_t *p_stream, MP4_Box_t *p_box )
 {
     MP4_READBOX_ENTER( MP4_Box_data_trun_t );
@@ -1738,8 +1761,55 @@ static int MP4_ReadBox_stsd( stream_t *p_stream, MP4_Box_t *p_box )
 }
 
 
+/* Sample size tables of more entries are left in the file, the demuxer
+ * reads the part it is at as it goes */
+#define MP4_STSZ_LAZY 65536
+
+static int MP4_ReadBox_stsz_Lazily( stream_t *p_stream, MP4_Box_t *p_box )
+{
+    const uint8_t *p_peek;
+    bool b_seekable;
+
+    /* The offsets have to be those of the file, not of a cmov */
+    const MP4_Box_t *p_top = p_box;
+    while( p_top->p_father )
+        p_top = p_top->p_father;
+    if( p_top->i_type != ATOM_root ||
+        stream_Control( p_stream, STREAM_CAN_SEEK, &b_seekable ) ||
+        !b_seekable )
+        return 0;
+
+    const size_t i_header = mp4_box_headersize( p_box ) + 12;
+    if( p_box->i_size < i_header ||
+        stream_Peek( p_stream, &p_peek, i_header ) < (int)i_header )
+        return 0;
+    p_peek += i_header - 12;
+
+    const uint32_t i_sample_size = GetDWBE( &p_peek[4] );
+    const uint32_t i_sample_count = GetDWBE( &p_peek[8] );
+    if( i_sample_size != 0 || i_sample_count < MP4_STSZ_LAZY ||
+        ( p_box->i_size - i_header ) / 4 < i_sample_count )
+        return 0;
+
+    if( !( p_box->data.p_stsz = calloc( 1, sizeof( MP4_Box_data_stsz_t ) ) ) )
+        return 0;
+    p_box->data.p_stsz->i_version = p_peek[0];
+    p_box->data.p_stsz->i_flags = Get24bBE( &p_peek[1] );
+    p_box->data.p_stsz->i_sample_count = i_sample_count;
+    p_box->data.p_stsz->i_entry_offset = p_box->i_pos + i_header;
+
+#ifdef MP4_VERBOSE
+    msg_Dbg( p_stream, "read box: \"stsz\" sample-count %d left in the file",
+                      i_sample_count );
+#endif
+    return 1;
+}
+
 static int MP4_ReadBox_stsz( stream_t *p_stream, MP4_Box_t *p_box )
 {
+    if( MP4_ReadBox_stsz_Lazily( p_stream, p_box ) )
+        return 1;
+
     MP4_READBOX_ENTER( MP4_Box_data_stsz_t );
 
     MP4_GETVERSIONFLAGS( p_box->data.p_stsz );
@@ -3096,6 +3166,7 @@ static const struct
     { ATOM_traf,    MP4_ReadBoxContainer,     MP4_FreeBox_Common },
     { ATOM_mfhd,    MP4_ReadBox_mfhd,         MP4_FreeBox_Common },
     { ATOM_tfhd,    MP4_ReadBox_tfhd,         MP4_FreeBox_Common },
+    { ATOM_tfdt,    MP4_ReadBox_tfdt,         MP4_FreeBox_Common },
     { ATOM_trun,    MP4_ReadBox_trun,         MP4_FreeBox_trun },
     { ATOM_trex,    MP4_ReadBox_trex,         MP4_FreeBox_Common },
     { ATOM_mehd,    MP4_ReadBox_mehd,         MP4_FreeBox_Common },
@@ -3204,11 +3275,94 @@ void MP4_BoxFree( stream_t *s, MP4_Box_t *p_box )
     free( p_box );
 }
 
+/* Of a stream that cannot seek, the top level boxes before the movie data
+ * are read, as that is all a fragmented file needs before its moof */
+static int MP4_ReadRootForward( stream_t *p_stream, MP4_Box_t *p_root )
+{
+    for( ;; )
+    {
+        const uint8_t *p_peek;
+        if( stream_Peek( p_stream, &p_peek, 8 ) < 8 )
+            break;
+
+        const uint32_t i_type = VLC_FOURCC( p_peek[4], p_peek[5],
+                                            p_peek[6], p_peek[7] );
+        if( i_type == ATOM_moof || i_type == ATOM_mdat )
+            break;
+
+        MP4_Box_t *p_box = MP4_BoxGetNext( p_stream );
+        if( p_box == NULL )
+            break;
+
+        p_box->p_father = p_root;
+        if( !p_root->p_first ) p_root->p_first = p_box;
+        else p_root->p_last->p_next = p_box;
+        p_root->p_last = p_box;
+
+        if( i_type == ATOM_moov )
+            break;
+    }
+    return p_root->p_first != NULL;
+}
+
+static void MP4_BoxShift( MP4_Box_t *p_box, off_t i_offset )
+{
+    p_box->i_pos += i_offset;
+    for( MP4_Box_t *p_child = p_box->p_first; p_child; p_child = p_child->p_next )
+        MP4_BoxShift( p_child, i_offset );
+}
+
+/*****************************************************************************
+ * MP4_BoxGetNext : Load the box at the current position of the stream
+ *****************************************************************************
+ *  The box is copied to memory and parsed from there, the readers seek
+ *  within it when the stream may not. The positions are fixed up to those
+ *  in the stream afterwards.
+ *****************************************************************************/
+MP4_Box_t *MP4_BoxGetNext( stream_t *s )
+{
+    MP4_Box_t box;
+
+    if( !MP4_ReadBoxCommon( s, &box ) )
+        return NULL;
+    if( box.i_size < (uint64_t)mp4_box_headersize( &box ) ||
+        box.i_size > INT32_MAX )
+    {
+        msg_Warn( s, "cannot load box of size %"PRIu64, box.i_size );
+        return NULL;
+    }
+
+    block_t *p_block = stream_Block( s, box.i_size );
+    if( p_block == NULL )
+        return NULL;
+    if( p_block->i_buffer < box.i_size )
+    {
+        block_Release( p_block );
+        return NULL;
+    }
+
+    MP4_Box_t *p_box = NULL;
+    stream_t *p_stream_memory = stream_MemoryNew( VLC_OBJECT(s),
+                                                  p_block->p_buffer,
+                                                  p_block->i_buffer, true );
+    if( p_stream_memory )
+    {
+        p_box = MP4_ReadBox( p_stream_memory, NULL );
+        stream_Delete( p_stream_memory );
+    }
+    block_Release( p_block );
+
+    if( p_box )
+        MP4_BoxShift( p_box, box.i_pos );
+    return p_box;
+}
+
 /*****************************************************************************
  * MP4_BoxGetRoot : Parse the entire file, and create all boxes in memory
  *****************************************************************************
  *  The first box is a virtual box "root" and is the father for all first
  *  level boxes for the file, a sort of virtual contener
+ *  If the moov announces movie fragments (mvex), it is the last box read
  *****************************************************************************/
 MP4_Box_t *MP4_BoxGetRoot( stream_t *s )
 {
@@ -3234,7 +3388,13 @@ MP4_Box_t *MP4_BoxGetRoot( stream_t *s )
 
     p_stream = s;
 
-    i_result = MP4_ReadBoxContainerRaw( p_stream, p_root );
+    bool b_seekable;
+    if( stream_Control( p_stream, STREAM_CAN_SEEK, &b_seekable ) )
+        b_seekable = false;
+    if( b_seekable )
+        i_result = MP4_ReadBoxContainerRaw( p_stream, p_root );
+    else
+        i_result = MP4_ReadRootForward( p_stream, p_root );
 
     if( i_result )
     {
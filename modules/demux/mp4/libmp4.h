@@ -79,6 +79,7 @@
 #define ATOM_mfhd VLC_FOURCC( 'm', 'f', 'h', 'd' )
 #define ATOM_traf VLC_FOURCC( 't', 'r', 'a', 'f' )
 #define ATOM_tfhd VLC_FOURCC( 't', 'f', 'h', 'd' )
+#define ATOM_tfdt VLC_FOURCC( 't', 'f', 'd', 't' )
 #define ATOM_trun VLC_FOURCC( 't', 'r', 'u', 'n' )
 #define ATOM_cprt VLC_FOURCC( 'c', 'p', 'r', 't' )
 #define ATOM_iods VLC_FOURCC( 'i', 'o', 'd', 's' )
@@ -575,6 +576,8 @@ typedef struct MP4_Box_data_stsz_s
     uint32_t i_sample_count;
 
     uint32_t *i_entry_size; /* array , empty if i_sample_size != 0 */
+    uint64_t i_entry_offset; /* of the array in the file when it was not read,
+                                see MP4_STSZ_LAZY */
 
 } MP4_Box_data_stsz_t;
 
@@ -841,6 +844,7 @@ typedef struct MP4_Box_data_mfhd_s
 #define MP4_TFHD_DFLT_SAMPLE_DURATION (1LL<<3)
 #define MP4_TFHD_DFLT_SAMPLE_SIZE     (1LL<<4)
 #define MP4_TFHD_DFLT_SAMPLE_FLAGS    (1LL<<5)
+#define MP4_TFHD_DFLT_BASE_IS_MOOF    (1LL<<17)
 typedef struct MP4_Box_data_tfhd_s
 {
     uint8_t  i_version;
@@ -856,6 +860,15 @@ typedef struct MP4_Box_data_tfhd_s
 
 } MP4_Box_data_tfhd_t;
 
+typedef struct MP4_Box_data_tfdt_s
+{
+    uint8_t  i_version;
+    uint32_t i_flags;
+
+    uint64_t i_base_media_decode_time;
+
+} MP4_Box_data_tfdt_t;
+
 #define MP4_TRUN_DATA_OFFSET         (1<<0)
 #define MP4_TRUN_FIRST_FLAGS         (1<<2)
 #define MP4_TRUN_SAMPLE_DURATION     (1<<8)
@@ -1045,6 +1058,7 @@ typedef union MP4_Box_data_s
     MP4_Box_data_mvhd_t *p_mvhd;
     MP4_Box_data_mfhd_t *p_mfhd;
     MP4_Box_data_tfhd_t *p_tfhd;
+    MP4_Box_data_tfdt_t *p_tfdt;
     MP4_Box_data_trun_t *p_trun;
     MP4_Box_data_tkhd_t *p_tkhd;
     MP4_Box_data_mdhd_t *p_mdhd;
@@ -1142,9 +1156,18 @@ typedef struct MP4_Box_s
  *****************************************************************************
  *  The first box is a virtual box "root" and is the father for all first
  *  level boxes
+ *  If the moov announces movie fragments (mvex), it is the last box read
  *****************************************************************************/
 MP4_Box_t *MP4_BoxGetRoot( stream_t * );
 
+/*****************************************************************************
+ * MP4_BoxGetNext : Load the box at the current position of the stream
+ *****************************************************************************
+ *  The stream is only read forward and is left after the box, used for the
+ *  movie fragments that follow a moov with a mvex
+ *****************************************************************************/
+MP4_Box_t *MP4_BoxGetNext( stream_t * );
+
 /*****************************************************************************
  * MP4_FreeBox : free memory allocated after read with MP4_ReadBox
  *               or MP4_BoxGetRoot, this means also children boxes
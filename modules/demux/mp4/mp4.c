@@ -60,9 +60,18 @@ vlc_module_end ()
  *****************************************************************************/
 static int   Demux   ( demux_t * );
 static int   DemuxRef( demux_t *p_demux ){ (void)p_demux; return 0;}
+static int   DemuxFrag( demux_t * );
 static int   Seek    ( demux_t *, mtime_t );
 static int   Control ( demux_t *, int, va_list );
 
+/* How many sample sizes are read at once when the stsz table is left in
+ * the file */
+#define MP4_SAMPLE_SIZE_WINDOW 4096
+
+/* How far a stream that cannot seek is peeked for the moov of a fragmented
+ * file, nothing read to find out could be given back to the next demuxer */
+#define MP4_FRAG_PEEK_MAX (1 << 20)
+
 /* Contain all information about a chunk */
 typedef struct
 {
@@ -130,6 +139,12 @@ typedef struct
     uint32_t         i_sample_size;
     uint32_t         *p_sample_size; /* XXX perhaps add file offset if take
                                     too much time to do sumations each time*/
+    /* p_sample_size holds the sizes of i_sample_size_count samples from
+     * i_sample_size_first. Unless the table is in memory, those are read
+     * from i_sample_size_offset as needed, see MP4_TrackGetSampleSize() */
+    uint32_t         i_sample_size_first;
+    uint32_t         i_sample_size_count;
+    uint64_t         i_sample_size_offset;
 
     MP4_Box_t *p_stbl;  /* will contain all timing information */
     MP4_Box_t *p_stsd;  /* will contain all data to initialize decoder */
@@ -139,8 +154,25 @@ typedef struct
     void      *p_drms;
     MP4_Box_t *p_skcr;
 
+    /* movie fragments: defaults of the track (could be NULL), and decoding
+     * time of its next sample in track time scale */
+    MP4_Box_t       *p_trex;
+    uint64_t         i_frag_dts;
+
 } mp4_track_t;
 
+/* A sample of the movie fragment being played */
+typedef struct
+{
+    uint64_t     i_pos;     /* absolute position in the file */
+    uint32_t     i_size;
+    unsigned int i_track;
+
+    mtime_t      i_dts;
+    mtime_t      i_pts;     /* -1 if unknown */
+    mtime_t      i_pcr;     /* lowest dts of this sample and the next ones */
+} mp4_frag_sample_t;
+
 
 struct demux_sys_t
 {
@@ -161,6 +193,18 @@ struct demux_sys_t
 
     /* */
     input_title_t *p_title;
+
+    /* fragmented file: each moof is read when the previous one is played,
+     * only its own samples are kept */
+    bool         b_fragmented;
+    bool         b_seekable;
+    uint64_t     i_frag_first;  /* position of the first box after moov */
+    uint64_t     i_frag_next;   /* position of the next top level box */
+    mtime_t      i_frag_end;    /* end time of the current fragment */
+    mp4_frag_sample_t *p_frag;  /* samples of the current fragment */
+    unsigned int i_frag;
+    unsigned int i_frag_max;
+    unsigned int i_frag_sample; /* next one to send */
 };
 
 /*****************************************************************************
@@ -174,11 +218,17 @@ static void MP4_TrackUnselect(demux_t *, mp4_track_t * );
 
 static int  MP4_TrackSeek   ( demux_t *, mp4_track_t *, mtime_t );
 
-static uint64_t MP4_TrackGetPos    ( mp4_track_t * );
-static int      MP4_TrackSampleSize( mp4_track_t * );
+static uint64_t MP4_TrackGetPos    ( demux_t *, mp4_track_t * );
+static int      MP4_TrackSampleSize( demux_t *, mp4_track_t * );
 static int      MP4_TrackNextSample( demux_t *, mp4_track_t * );
 static void     MP4_TrackSetELST( demux_t *, mp4_track_t *, int64_t );
 
+static bool     MP4_BlockConvert( mp4_track_t *, block_t * );
+
+static int      FragmentSkip( demux_t *, uint64_t );
+static int      FragmentRead( demux_t * );
+static int      FragmentSeek( demux_t *, mtime_t );
+
 static void     MP4_UpdateSeekpoint( demux_t * );
 static const char *MP4_ConvertMacCode( uint16_t );
 
@@ -259,6 +309,59 @@ static inline int64_t MP4_GetMoviePTS(demux_sys_t *p_sys )
 
 static void LoadChapter( demux_t  *p_demux );
 
+/* Size and type of the box header at i_offset of the peeked data */
+static int MP4_PeekBoxHeader( stream_t *s, uint64_t i_offset,
+                              uint64_t *pi_size, uint32_t *pi_type )
+{
+    const uint8_t *p_peek;
+    const int i_peek = stream_Peek( s, &p_peek, i_offset + 16 ) - i_offset;
+
+    if( i_peek < 8 )
+        return VLC_EGENERIC;
+    p_peek += i_offset;
+
+    *pi_size = GetDWBE( p_peek );
+    *pi_type = VLC_FOURCC( p_peek[4], p_peek[5], p_peek[6], p_peek[7] );
+    if( *pi_size == 1 )
+    {
+        if( i_peek < 16 )
+            return VLC_EGENERIC;
+        *pi_size = GetQWBE( &p_peek[8] );
+    }
+    return VLC_SUCCESS;
+}
+
+/* Whether the stream starts with a moov announcing movie fragments */
+static bool MP4_PeekFragmented( stream_t *s )
+{
+    uint64_t i_offset = 0;
+    uint64_t i_size;
+    uint32_t i_type;
+
+    while( !MP4_PeekBoxHeader( s, i_offset, &i_size, &i_type ) )
+    {
+        if( i_size < 8 || i_type == ATOM_moof || i_type == ATOM_mdat ||
+            i_offset + i_size > MP4_FRAG_PEEK_MAX )
+            return false;
+
+        if( i_type == ATOM_moov )
+        {
+            const uint64_t i_end = i_offset + i_size;
+            for( i_offset += 8; i_offset + 8 <= i_end; i_offset += i_size )
+            {
+                if( MP4_PeekBoxHeader( s, i_offset, &i_size, &i_type ) ||
+                    i_size < 8 )
+                    return false;
+                if( i_type == ATOM_mvex )
+                    return true;
+            }
+            return false;
+        }
+        i_offset += i_size;
+    }
+    return false;
+}
+
 /*****************************************************************************
  * Open: check file and initializes MP4 structures
  *****************************************************************************/
@@ -302,9 +405,9 @@ static int Open( vlc_object_t * p_this )
             return VLC_EGENERIC;
     }
 
-    /* I need to seek */
+    /* I need to seek, unless the samples come in movie fragments */
     stream_Control( p_demux->s, STREAM_CAN_FASTSEEK, &b_seekable );
-    if( !b_seekable )
+    if( !b_seekable && !MP4_PeekFragmented( p_demux->s ) )
     {
         msg_Warn( p_demux, "MP4 plugin discarded (not fastseekable)" );
         return VLC_EGENERIC;
@@ -316,6 +419,7 @@ static int Open( vlc_object_t * p_this )
 
     /* create our structure that will contains all data */
     p_demux->p_sys = p_sys = calloc( 1, sizeof( demux_sys_t ) );
+    stream_Control( p_demux->s, STREAM_CAN_SEEK, &p_sys->b_seekable );
 
     /* Now load all boxes ( except raw data ) */
     if( ( p_sys->p_root = MP4_BoxGetRoot( p_demux->s ) ) == NULL )
@@ -491,6 +595,39 @@ static int Open( vlc_object_t * p_this )
         msg_Err( p_demux, "cannot find any /moov/trak" );
         goto error;
     }
+
+    /* Movie fragments are only played when the moov has no samples */
+    if( MP4_BoxGet( p_sys->p_root, "/moov/mvex" ) )
+    {
+        p_sys->b_fragmented = true;
+        for( i = 0; i < p_sys->i_tracks; i++ )
+        {
+            MP4_Box_t *p_stbl = MP4_BoxGet( p_sys->p_root,
+                                            "/moov/trak[%d]/mdia/minf/stbl", i );
+            MP4_Box_t *p_co64 = p_stbl ? MP4_BoxGet( p_stbl, "stco" ) : NULL;
+            if( !p_co64 && p_stbl )
+                p_co64 = MP4_BoxGet( p_stbl, "co64" );
+            if( p_co64 && p_co64->data.p_co64->i_entry_count > 0 )
+                p_sys->b_fragmented = false;
+        }
+    }
+    if( p_sys->b_fragmented )
+    {
+        MP4_Box_t *p_moov = MP4_BoxGet( p_sys->p_root, "/moov" );
+        MP4_Box_t *p_mehd = MP4_BoxGet( p_sys->p_root, "/moov/mvex/mehd" );
+
+        msg_Dbg( p_demux, "fragmented file" );
+        p_demux->pf_demux = DemuxFrag;
+        p_sys->i_frag_first = p_moov->i_pos + p_moov->i_size;
+        p_sys->i_frag_next = p_sys->i_frag_first;
+        if( p_sys->i_duration == 0 && p_mehd )
+            p_sys->i_duration = p_mehd->data.p_mehd->i_fragment_duration;
+    }
+    else if( !b_seekable )
+    {
+        msg_Warn( p_demux, "MP4 plugin discarded (not fastseekable)" );
+        goto error;
+    }
     msg_Dbg( p_demux, "found %d track%c",
                         p_sys->i_tracks,
                         p_sys->i_tracks ? 's':' ' );
@@ -519,6 +656,11 @@ static int Open( vlc_object_t * p_this )
             p_sys->p_tref_chap = p_chap;
     }
 
+    /* Preparsing for the meta data: the chunk and sample indexes of the
+     * tracks are not needed, and are the most costly part to build */
+    if( p_demux->b_meta_only )
+        return VLC_SUCCESS;
+
     /* now process each track and extract all useful information */
     for( i = 0; i < p_sys->i_tracks; i++ )
     {
@@ -665,13 +807,14 @@ static int Demux( demux_t *p_demux )
                      MP4_GetMoviePTS( p_sys ) );
 #endif
 
-            if( MP4_TrackSampleSize( tk ) > 0 )
+            const int i_size = MP4_TrackSampleSize( p_demux, tk );
+            if( i_size > 0 )
             {
                 block_t *p_block;
                 int64_t i_delta;
 
                 /* go,go go ! */
-                if( stream_Seek( p_demux->s, MP4_TrackGetPos( tk ) ) )
+                if( stream_Seek( p_demux->s, MP4_TrackGetPos( p_demux, tk ) ) )
                 {
                     msg_Warn( p_demux, "track[0x%x] will be disabled (eof?)",
                               tk->i_track_ID );
@@ -681,7 +824,7 @@ static int Demux( demux_t *p_demux )
 
                 /* now read pes */
                 if( !(p_block =
-                         stream_Block( p_demux->s, MP4_TrackSampleSize(tk) )) )
+                         stream_Block( p_demux->s, i_size )) )
                 {
                     msg_Warn( p_demux, "track[0x%x] will be disabled (eof?)",
                               tk->i_track_ID );
@@ -689,56 +832,8 @@ static int Demux( demux_t *p_demux )
                     break;
                 }
 
-                if( tk->b_drms && tk->p_drms )
-                {
-                    if( tk->p_skcr )
-                    {
-                        uint32_t p_key[4];
-                        drms_get_p_key( tk->p_drms, p_key );
+                const bool b_send = MP4_BlockConvert( tk, p_block );
 
-                        for( size_t i_pos = tk->p_skcr->data.p_skcr->i_init; i_pos < p_block->i_buffer; )
-                        {
-                            int n = __MIN( tk->p_skcr->data.p_skcr->i_encr, p_block->i_buffer - i_pos );
-                            drms_decrypt( tk->p_drms, (uint32_t*)&p_block->p_buffer[i_pos], n, p_key );
-                            i_pos += n;
-                            i_pos += __MIN( tk->p_skcr->data.p_skcr->i_decr, p_block->i_buffer - i_pos );
-                        }
-                    }
-                    else
-                    {
-                        drms_decrypt( tk->p_drms, (uint32_t*)p_block->p_buffer,
-                                      p_block->i_buffer, NULL );
-                    }
-                }
-                else if( tk->fmt.i_cat == SPU_ES )
-                {
-                    if( tk->fmt.i_codec == VLC_FOURCC( 's', 'u', 'b', 't' ) &&
-                        p_block->i_buffer >= 2 )
-                    {
-                        size_t i_size = GetWBE( p_block->p_buffer );
-
-                        if( i_size + 2 <= p_block->i_buffer )
-                        {
-                            char *p;
-                            /* remove the length field, and append a '\0' */
-                            memmove( &p_block->p_buffer[0],
-                                     &p_block->p_buffer[2], i_size );
-                            p_block->p_buffer[i_size] = '\0';
-                            p_block->i_buffer = i_size + 1;
-
-                            /* convert \r -> \n */
-                            while( ( p = strchr((char *) p_block->p_buffer, '\r' ) ) )
-                            {
-                                *p = '\n';
-                            }
-                        }
-                        else
-                        {
-                            /* Invalid */
-                            p_block->i_buffer = 0;
-                        }
-                    }
-                }
                 /* dts */
                 p_block->i_dts = VLC_TS_0 + MP4_TrackGetDTS( p_demux, tk );
                 /* pts */
@@ -750,8 +845,10 @@ static int Demux( demux_t *p_demux )
                 else
                     p_block->i_pts = VLC_TS_INVALID;
 
-                if( !tk->b_drms || ( tk->b_drms && tk->p_drms ) )
+                if( b_send )
                     es_out_Send( p_demux->out, tk->p_es, p_block );
+                else
+                    block_Release( p_block );
             }
 
             /* Next sample */
@@ -763,6 +860,383 @@ static int Demux( demux_t *p_demux )
     return 1;
 }
 
+/* Decrypts the sample or turns text samples into strings, returns whether
+ * it can be sent */
+static bool MP4_BlockConvert( mp4_track_t *tk, block_t *p_block )
+{
+    if( tk->b_drms && tk->p_drms )
+    {
+        if( tk->p_skcr )
+        {
+            uint32_t p_key[4];
+            drms_get_p_key( tk->p_drms, p_key );
+
+            for( size_t i_pos = tk->p_skcr->data.p_skcr->i_init; i_pos < p_block->i_buffer; )
+            {
+                int n = __MIN( tk->p_skcr->data.p_skcr->i_encr, p_block->i_buffer - i_pos );
+                drms_decrypt( tk->p_drms, (uint32_t*)&p_block->p_buffer[i_pos], n, p_key );
+                i_pos += n;
+                i_pos += __MIN( tk->p_skcr->data.p_skcr->i_decr, p_block->i_buffer - i_pos );
+            }
+        }
+        else
+        {
+            drms_decrypt( tk->p_drms, (uint32_t*)p_block->p_buffer,
+                          p_block->i_buffer, NULL );
+        }
+    }
+    else if( tk->fmt.i_cat == SPU_ES )
+    {
+        if( tk->fmt.i_codec == VLC_FOURCC( 's', 'u', 'b', 't' ) &&
+            p_block->i_buffer >= 2 )
+        {
+            size_t i_size = GetWBE( p_block->p_buffer );
+
+            if( i_size + 2 <= p_block->i_buffer )
+            {
+                char *p;
+                /* remove the length field, and append a '\0' */
+                memmove( &p_block->p_buffer[0],
+                         &p_block->p_buffer[2], i_size );
+                p_block->p_buffer[i_size] = '\0';
+                p_block->i_buffer = i_size + 1;
+
+                /* convert \r -> \n */
+                while( ( p = strchr((char *) p_block->p_buffer, '\r' ) ) )
+                {
+                    *p = '\n';
+                }
+            }
+            else
+            {
+                /* Invalid */
+                p_block->i_buffer = 0;
+            }
+        }
+    }
+    return !tk->b_drms || tk->p_drms != NULL;
+}
+
+/*****************************************************************************
+ * DemuxFrag: read the samples of the movie fragments as they come
+ *****************************************************************************/
+static int DemuxFrag( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( p_sys->i_frag_sample >= p_sys->i_frag )
+    {
+        if( FragmentRead( p_demux ) )
+            return 0;
+        if( p_sys->i_frag == 0 )
+            return 1; /* no track selected */
+    }
+
+    /* we will read 100ms of the fragment */
+    const mtime_t i_end = p_sys->p_frag[p_sys->i_frag_sample].i_pcr +
+                          CLOCK_FREQ / 10;
+
+    while( p_sys->i_frag_sample < p_sys->i_frag &&
+           p_sys->p_frag[p_sys->i_frag_sample].i_pcr < i_end )
+    {
+        const mp4_frag_sample_t *p_sample =
+            &p_sys->p_frag[p_sys->i_frag_sample++];
+        mp4_track_t *tk = &p_sys->track[p_sample->i_track];
+
+        if( p_sample->i_pcr != p_sys->i_pcr )
+        {
+            p_sys->i_pcr = p_sample->i_pcr;
+            p_sys->i_time = p_sys->i_pcr * p_sys->i_timescale / CLOCK_FREQ;
+            es_out_Control( p_demux->out, ES_OUT_SET_PCR,
+                            VLC_TS_0 + p_sys->i_pcr );
+        }
+
+        if( FragmentSkip( p_demux, p_sample->i_pos ) )
+        {
+            msg_Warn( p_demux, "track[0x%x] sample at %"PRIu64" is lost",
+                      tk->i_track_ID, p_sample->i_pos );
+            continue;
+        }
+
+        block_t *p_block = stream_Block( p_demux->s, p_sample->i_size );
+        if( p_block == NULL )
+            return 0;
+
+        const bool b_send = MP4_BlockConvert( tk, p_block );
+
+        p_block->i_dts = VLC_TS_0 + p_sample->i_dts;
+        if( p_sample->i_pts >= 0 )
+            p_block->i_pts = VLC_TS_0 + p_sample->i_pts;
+        else
+            p_block->i_pts = VLC_TS_INVALID;
+
+        if( b_send )
+            es_out_Send( p_demux->out, tk->p_es, p_block );
+        else
+            block_Release( p_block );
+    }
+    return 1;
+}
+
+/* Moves forward to the data at i_pos, a stream that cannot seek is read */
+static int FragmentSkip( demux_t *p_demux, uint64_t i_pos )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    uint64_t i_tell = stream_Tell( p_demux->s );
+
+    if( i_pos == i_tell )
+        return VLC_SUCCESS;
+    if( p_sys->b_seekable )
+        return stream_Seek( p_demux->s, i_pos );
+    if( i_pos < i_tell )
+        return VLC_EGENERIC;
+
+    uint8_t p_buffer[4096];
+    while( i_tell < i_pos )
+    {
+        const int i_read = stream_Read( p_demux->s, p_buffer,
+                                        __MIN( i_pos - i_tell, sizeof(p_buffer) ) );
+        if( i_read <= 0 )
+            return VLC_EGENERIC;
+        i_tell += i_read;
+    }
+    return VLC_SUCCESS;
+}
+
+/* Time of a track in microseconds, with the offset of its edit list */
+static mtime_t FragmentTime( mp4_track_t *tk, int64_t i_time )
+{
+    if( tk->p_elst && tk->p_elst->data.p_elst->i_entry_count > 0 )
+    {
+        const MP4_Box_data_elst_t *elst = tk->p_elst->data.p_elst;
+
+        if( ( elst->i_media_rate_integer[0] > 0 ||
+              elst->i_media_rate_fraction[0] > 0 ) &&
+            elst->i_media_time[0] > 0 )
+            i_time -= elst->i_media_time[0];
+        if( i_time < 0 )
+            i_time = 0;
+    }
+    return INT64_C(1000000) * i_time / tk->i_timescale;
+}
+
+static int FragmentSampleCompare( const void *a, const void *b )
+{
+    const mp4_frag_sample_t *p_a = a, *p_b = b;
+
+    if( p_a->i_pos != p_b->i_pos )
+        return p_a->i_pos < p_b->i_pos ? -1 : 1;
+    return 0;
+}
+
+/* Lists the samples of the selected tracks in a moof, in file order */
+static int FragmentParse( demux_t *p_demux, MP4_Box_t *p_moof )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    uint64_t i_traf_base = p_moof->i_pos;
+    uint64_t i_data_end = 0;
+
+    p_sys->i_frag = p_sys->i_frag_sample = 0;
+    p_sys->i_frag_end = 0;
+
+    for( MP4_Box_t *p_traf = p_moof->p_first; p_traf; p_traf = p_traf->p_next )
+    {
+        MP4_Box_t *p_tfhd = MP4_BoxGet( p_traf, "tfhd" );
+        if( p_traf->i_type != ATOM_traf || !p_tfhd )
+            continue;
+        const MP4_Box_data_tfhd_t *tfhd = p_tfhd->data.p_tfhd;
+
+        unsigned int i_track;
+        mp4_track_t *tk = NULL;
+        for( i_track = 0; i_track < p_sys->i_tracks; i_track++ )
+        {
+            if( p_sys->track[i_track].i_track_ID == tfhd->i_track_ID )
+            {
+                tk = &p_sys->track[i_track];
+                break;
+            }
+        }
+        const bool b_used = tk && tk->b_ok && !tk->b_chapter && tk->b_selected;
+
+        /* defaults of the fragment, or else of the track */
+        const MP4_Box_data_trex_t *trex = tk && tk->p_trex ?
+                                          tk->p_trex->data.p_trex : NULL;
+        uint32_t i_default_duration = trex ? trex->i_default_sample_duration : 0;
+        uint32_t i_default_size = trex ? trex->i_default_sample_size : 0;
+        if( tfhd->i_flags & MP4_TFHD_DFLT_SAMPLE_DURATION )
+            i_default_duration = tfhd->i_default_sample_duration;
+        if( tfhd->i_flags & MP4_TFHD_DFLT_SAMPLE_SIZE )
+            i_default_size = tfhd->i_default_sample_size;
+
+        uint64_t i_base = i_traf_base;
+        if( tfhd->i_flags & MP4_TFHD_BASE_DATA_OFFSET )
+            i_base = tfhd->i_base_data_offset;
+        else if( tfhd->i_flags & MP4_TFHD_DFLT_BASE_IS_MOOF )
+            i_base = p_moof->i_pos;
+
+        MP4_Box_t *p_tfdt = MP4_BoxGet( p_traf, "tfdt" );
+        if( tk && p_tfdt )
+            tk->i_frag_dts = p_tfdt->data.p_tfdt->i_base_media_decode_time;
+
+        uint64_t i_pos = i_base;
+        for( MP4_Box_t *p_trun = p_traf->p_first; p_trun; p_trun = p_trun->p_next )
+        {
+            if( p_trun->i_type != ATOM_trun )
+                continue;
+            const MP4_Box_data_trun_t *trun = p_trun->data.p_trun;
+
+            if( trun->i_flags & MP4_TRUN_DATA_OFFSET )
+                i_pos = i_base + (int32_t)trun->i_data_offset;
+
+            if( b_used && p_sys->i_frag + trun->i_sample_count > p_sys->i_frag_max )
+            {
+                unsigned int i_max = __MAX( 2 * p_sys->i_frag_max,
+                                            p_sys->i_frag + trun->i_sample_count );
+                mp4_frag_sample_t *p_frag = realloc( p_sys->p_frag,
+                                                     i_max * sizeof(*p_frag) );
+                if( p_frag == NULL )
+                    return VLC_ENOMEM;
+                p_sys->p_frag = p_frag;
+                p_sys->i_frag_max = i_max;
+            }
+
+            for( uint32_t i = 0; i < trun->i_sample_count; i++ )
+            {
+                const MP4_descriptor_trun_sample_t *p_trun_sample =
+                    &trun->p_samples[i];
+                const uint32_t i_duration =
+                    ( trun->i_flags & MP4_TRUN_SAMPLE_DURATION ) ?
+                    p_trun_sample->i_duration : i_default_duration;
+                const uint32_t i_size =
+                    ( trun->i_flags & MP4_TRUN_SAMPLE_SIZE ) ?
+                    p_trun_sample->i_size : i_default_size;
+
+                if( b_used && i_size > 0 )
+                {
+                    mp4_frag_sample_t *p_sample = &p_sys->p_frag[p_sys->i_frag++];
+
+                    p_sample->i_pos = i_pos;
+                    p_sample->i_size = i_size;
+                    p_sample->i_track = i_track;
+                    p_sample->i_dts = FragmentTime( tk, tk->i_frag_dts );
+                    if( trun->i_flags & MP4_TRUN_SAMPLE_TIME_OFFSET )
+                    {
+                        int64_t i_offset = trun->i_version == 0 ?
+                            (int64_t)p_trun_sample->i_composition_time_offset :
+                            (int32_t)p_trun_sample->i_composition_time_offset;
+                        p_sample->i_pts = FragmentTime( tk, tk->i_frag_dts + i_offset );
+                    }
+                    else if( tk->fmt.i_cat != VIDEO_ES )
+                        p_sample->i_pts = p_sample->i_dts;
+                    else
+                        p_sample->i_pts = -1;
+
+                    p_sys->i_frag_end = __MAX( p_sys->i_frag_end,
+                        FragmentTime( tk, tk->i_frag_dts + i_duration ) );
+                }
+                if( tk )
+                    tk->i_frag_dts += i_duration;
+                i_pos += i_size;
+            }
+        }
+        i_traf_base = i_pos;
+        i_data_end = __MAX( i_data_end, i_pos );
+    }
+
+    /* the data usually follow in a mdat, whatever is after the samples is
+     * the next box anyway */
+    uint64_t i_size;
+    uint32_t i_type;
+    if( !MP4_PeekBoxHeader( p_demux->s, 0, &i_size, &i_type ) &&
+        i_type == ATOM_mdat && i_size >= 8 )
+        p_sys->i_frag_next += i_size;
+    p_sys->i_frag_next = __MAX( p_sys->i_frag_next, i_data_end );
+
+    qsort( p_sys->p_frag, p_sys->i_frag, sizeof(*p_sys->p_frag),
+           FragmentSampleCompare );
+    if( p_sys->i_frag > 0 )
+    {
+        /* the pcr must not pass the dts of a sample still to be sent */
+        mtime_t i_pcr = p_sys->p_frag[p_sys->i_frag - 1].i_dts;
+        for( unsigned int i = p_sys->i_frag; i-- > 0; )
+        {
+            i_pcr = __MIN( i_pcr, p_sys->p_frag[i].i_dts );
+            p_sys->p_frag[i].i_pcr = i_pcr;
+        }
+    }
+    return VLC_SUCCESS;
+}
+
+/* Reads the next moof, skipping the boxes before it */
+static int FragmentRead( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    p_sys->i_frag = p_sys->i_frag_sample = 0;
+    p_sys->i_pcr = -1;
+
+    /* selected tracks are only checked between fragments */
+    for( unsigned int i = 0; i < p_sys->i_tracks; i++ )
+    {
+        mp4_track_t *tk = &p_sys->track[i];
+        bool b = false;
+
+        if( tk->b_ok && !tk->b_chapter && tk->p_es )
+            es_out_Control( p_demux->out, ES_OUT_GET_ES_STATE, tk->p_es, &b );
+        tk->b_selected = b;
+    }
+
+    for( ;; )
+    {
+        uint64_t i_size;
+        uint32_t i_type;
+
+        if( FragmentSkip( p_demux, p_sys->i_frag_next ) ||
+            MP4_PeekBoxHeader( p_demux->s, 0, &i_size, &i_type ) )
+            return VLC_EGENERIC;
+        if( i_size < 8 )
+            return VLC_EGENERIC; /* up to the end of the file */
+
+        if( i_type != ATOM_moof )
+        {
+            p_sys->i_frag_next += i_size;
+            continue;
+        }
+
+        MP4_Box_t *p_moof = MP4_BoxGetNext( p_demux->s );
+        if( p_moof == NULL )
+            return VLC_EGENERIC;
+        p_sys->i_frag_next += i_size;
+
+        int i_ret = FragmentParse( p_demux, p_moof );
+        MP4_BoxFree( p_demux->s, p_moof );
+        return i_ret;
+    }
+}
+
+/* Fragments are read again from the first one, up to the one with i_date */
+static int FragmentSeek( demux_t *p_demux, mtime_t i_date )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( !p_sys->b_seekable )
+        return VLC_EGENERIC;
+
+    for( unsigned int i = 0; i < p_sys->i_tracks; i++ )
+        p_sys->track[i].i_frag_dts = 0;
+    p_sys->i_frag_next = p_sys->i_frag_first;
+
+    while( !FragmentRead( p_demux ) && p_sys->i_frag_end <= i_date )
+        ;
+
+    p_sys->i_time = i_date * p_sys->i_timescale / 1000000;
+    MP4_UpdateSeekpoint( p_demux );
+
+    es_out_Control( p_demux->out, ES_OUT_SET_NEXT_DISPLAY_TIME, i_date );
+
+    return VLC_SUCCESS;
+}
+
 static void MP4_UpdateSeekpoint( demux_t *p_demux )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
@@ -792,6 +1266,9 @@ static int Seek( demux_t *p_demux, mtime_t i_date )
     demux_sys_t *p_sys = p_demux->p_sys;
     unsigned int i_track;
 
+    if( p_sys->b_fragmented )
+        return FragmentSeek( p_demux, i_date );
+
     /* First update update global time */
     p_sys->i_time = i_date * p_sys->i_timescale / 1000000;
     p_sys->i_pcr  = i_date;
@@ -1070,6 +1547,7 @@ static void Close ( vlc_object_t * p_this )
         MP4_TrackDestroy(  &p_sys->track[i_track] );
     }
     FREENULL( p_sys->track );
+    free( p_sys->p_frag );
 
     if( p_sys->p_title )
         vlc_input_title_Delete( p_sys->p_title );
@@ -1107,9 +1585,9 @@ static void LoadChapterApple( demux_t  *p_demux, mp4_track_t *tk )
     {
         const int64_t i_dts = MP4_TrackGetDTS( p_demux, tk );
         const int64_t i_pts_delta = MP4_TrackGetPTSDelta( tk );
-        const unsigned int i_size = MP4_TrackSampleSize( tk );
+        const unsigned int i_size = MP4_TrackSampleSize( p_demux, tk );
 
-        if( i_size > 0 && !stream_Seek( p_demux->s, MP4_TrackGetPos( tk ) ) )
+        if( i_size > 0 && !stream_Seek( p_demux->s, MP4_TrackGetPos( p_demux, tk ) ) )
         {
             char p_buffer[256];
             const int i_read = stream_Read( p_demux->s, p_buffer, __MIN( sizeof(p_buffer), i_size ) );
@@ -1309,9 +1787,22 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
         p_demux_track->i_sample_size = stsz->i_sample_size;
         p_demux_track->p_sample_size = NULL;
     }
+    else if( stsz->i_entry_size == NULL )
+    {
+        /* 2: each sample can have a different size, and the table
+         * was left in the file */
+        p_demux_track->i_sample_size = 0;
+        p_demux_track->p_sample_size =
+            calloc( MP4_SAMPLE_SIZE_WINDOW, sizeof( uint32_t ) );
+        if( p_demux_track->p_sample_size == NULL )
+            return VLC_ENOMEM;
+        p_demux_track->i_sample_size_first = 0;
+        p_demux_track->i_sample_size_count = 0;
+        p_demux_track->i_sample_size_offset = stsz->i_entry_offset;
+    }
     else
     {
-        /* 2: each sample can have a different size */
+        /* 3: each sample can have a different size */
         p_demux_track->i_sample_size = 0;
         p_demux_track->p_sample_size =
             calloc( p_demux_track->i_sample_count, sizeof( uint32_t ) );
@@ -1323,6 +1814,9 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
             p_demux_track->p_sample_size[i_sample] =
                     stsz->i_entry_size[i_sample];
         }
+        p_demux_track->i_sample_size_first = 0;
+        p_demux_track->i_sample_size_count = p_demux_track->i_sample_count;
+        p_demux_track->i_sample_size_offset = 0;
     }
 
     /* Use stts table to create a sample number -> dts table.
@@ -1469,6 +1963,41 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
  * It computes the sample rate for a video track using the given sample
  * description index
  */
+/* The samples of a fragmented file are described by its moof, only a chunk
+ * for the sample description is made up */
+static int TrackCreateFragmented( demux_t *p_demux, mp4_track_t *p_track )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    MP4_Box_t *p_trex;
+
+    p_track->p_trex = NULL;
+    for( int i = 0;
+         ( p_trex = MP4_BoxGet( p_sys->p_root, "/moov/mvex/trex[%d]", i ) ); i++ )
+    {
+        if( p_trex->data.p_trex->i_track_ID == p_track->i_track_ID )
+        {
+            p_track->p_trex = p_trex;
+            break;
+        }
+    }
+
+    p_track->chunk = calloc( 1, sizeof( mp4_chunk_t ) );
+    if( p_track->chunk == NULL )
+        return VLC_ENOMEM;
+    p_track->i_chunk_count = 1;
+    p_track->i_sample_count = 0;
+    p_track->chunk[0].i_sample_description_index = 1;
+    if( p_track->p_trex &&
+        p_track->p_trex->data.p_trex->i_default_sample_description_index )
+        p_track->chunk[0].i_sample_description_index =
+            p_track->p_trex->data.p_trex->i_default_sample_description_index;
+    p_track->i_frag_dts = 0;
+
+    msg_Dbg( p_demux, "track[Id 0x%x] samples are in movie fragments",
+             p_track->i_track_ID );
+    return VLC_SUCCESS;
+}
+
 static void TrackGetESSampleRate( unsigned *pi_num, unsigned *pi_den,
                                   const mp4_track_t *p_track,
                                   unsigned i_sd_index,
@@ -2490,8 +3019,13 @@ static void MP4_TrackCreate( demux_t *p_demux, mp4_track_t *p_track,
     }
 
     /* Create chunk index table and sample index table */
-    if( TrackCreateChunksIndex( p_demux,p_track  ) ||
-        TrackCreateSamplesIndex( p_demux, p_track ) )
+    if( p_sys->b_fragmented )
+    {
+        if( TrackCreateFragmented( p_demux, p_track ) )
+            return;
+    }
+    else if( TrackCreateChunksIndex( p_demux,p_track  ) ||
+             TrackCreateSamplesIndex( p_demux, p_track ) )
     {
         return; /* cannot create chunks index */
     }
@@ -2657,7 +3191,41 @@ static int MP4_TrackSeek( demux_t *p_demux, mp4_track_t *p_track,
  *
  */
 #define QT_V0_MAX_SAMPLES 1024
-static int MP4_TrackSampleSize( mp4_track_t *p_track )
+static uint32_t MP4_TrackGetSampleSize( demux_t *p_demux, mp4_track_t *p_track,
+                                        uint32_t i_sample )
+{
+    if( i_sample - p_track->i_sample_size_first >= p_track->i_sample_size_count )
+    {
+        /* Read the part of the table around the sample, and go back where
+         * the demuxer was */
+        uint8_t *p_buffer = (uint8_t *)p_track->p_sample_size;
+        const uint32_t i_first = i_sample - i_sample % MP4_SAMPLE_SIZE_WINDOW;
+        const uint32_t i_count = __MIN( (uint32_t)MP4_SAMPLE_SIZE_WINDOW,
+                                        p_track->i_sample_count - i_first );
+        const int64_t i_pos = stream_Tell( p_demux->s );
+
+        if( p_track->i_sample_size_offset == 0 || i_sample >= p_track->i_sample_count )
+            return 0;
+
+        p_track->i_sample_size_count = 0;
+        if( stream_Seek( p_demux->s, p_track->i_sample_size_offset + 4 * (uint64_t)i_first ) ||
+            stream_Read( p_demux->s, p_buffer, 4 * i_count ) < (int)( 4 * i_count ) )
+        {
+            msg_Warn( p_demux, "cannot read the size of sample %"PRIu32, i_sample );
+            stream_Seek( p_demux->s, i_pos );
+            return 0;
+        }
+        stream_Seek( p_demux->s, i_pos );
+
+        for( uint32_t i = 0; i < i_count; i++ )
+            p_track->p_sample_size[i] = GetDWBE( &p_buffer[4 * i] );
+        p_track->i_sample_size_first = i_first;
+        p_track->i_sample_size_count = i_count;
+    }
+    return p_track->p_sample_size[i_sample - p_track->i_sample_size_first];
+}
+
+static int MP4_TrackSampleSize( demux_t *p_demux, mp4_track_t *p_track )
 {
     int i_size;
     MP4_Box_data_sample_soun_t *p_soun;
@@ -2665,7 +3233,7 @@ static int MP4_TrackSampleSize( mp4_track_t *p_track )
     if( p_track->i_sample_size == 0 )
     {
         /* most simple case */
-        return p_track->p_sample_size[p_track->i_sample];
+        return MP4_TrackGetSampleSize( p_demux, p_track, p_track->i_sample );
     }
     if( p_track->fmt.i_cat != AUDIO_ES )
     {
@@ -2703,7 +3271,7 @@ static int MP4_TrackSampleSize( mp4_track_t *p_track )
     return i_size;
 }
 
-static uint64_t MP4_TrackGetPos( mp4_track_t *p_track )
+static uint64_t MP4_TrackGetPos( demux_t *p_demux, mp4_track_t *p_track )
 {
     unsigned int i_sample;
     uint64_t i_pos;
@@ -2734,7 +3302,7 @@ static uint64_t MP4_TrackGetPos( mp4_track_t *p_track )
         for( i_sample = p_track->chunk[p_track->i_chunk].i_sample_first;
              i_sample < p_track->i_sample; i_sample++ )
         {
-            i_pos += p_track->p_sample_size[i_sample];
+            i_pos += MP4_TrackGetSampleSize( p_demux, p_track, i_sample );
         }
     }
 
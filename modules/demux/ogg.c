@@ -34,6 +34,7 @@
 #include <vlc_demux.h>
 #include <vlc_meta.h>
 #include <vlc_input.h>
+#include <vlc_fs.h>
 
 #include <ogg/ogg.h>
 
@@ -51,6 +52,12 @@
 static int  Open ( vlc_object_t * );
 static void Close( vlc_object_t * );
 
+#define SEEK_INDEX_TEXT N_("Keep a seek index")
+#define SEEK_INDEX_LONGTEXT N_( \
+    "Remember where the pages of a file were found while playing it, in " \
+    "the cache directory, so that seeking to a time already played costs " \
+    "a single read. This helps with long files and network storage." )
+
 vlc_module_begin ()
     set_shortname ( "OGG" )
     set_description( N_("OGG demuxer" ) )
@@ -59,6 +66,8 @@ vlc_module_begin ()
     set_capability( "demux", 50 )
     set_callbacks( Open, Close )
     add_shortcut( "ogg" )
+    add_bool( "ogg-seek-index", false, SEEK_INDEX_TEXT, SEEK_INDEX_LONGTEXT,
+              true )
 vlc_module_end ()
 
 
@@ -121,6 +130,7 @@ static int  Control( demux_t *, int, va_list );
 
 /* Bitstream manipulation */
 static int  Ogg_ReadPage     ( demux_t *, ogg_page * );
+static void Ogg_ResetStreams ( demux_t * );
 static void Ogg_UpdatePCR    ( logical_stream_t *, ogg_packet * );
 static void Ogg_DecodePacket ( demux_t *, logical_stream_t *, ogg_packet * );
 static int  Ogg_OpusPacketDuration( logical_stream_t *, ogg_packet * );
@@ -147,6 +157,13 @@ static void Ogg_ReadFlacHeader( demux_t *, logical_stream_t *, ogg_packet * );
 static void Ogg_ReadAnnodexHeader( demux_t *, logical_stream_t *, ogg_packet * );
 static bool Ogg_ReadDiracHeader( logical_stream_t *, ogg_packet * );
 
+/* Seek index */
+static void Ogg_IndexOpen( demux_t * );
+static void Ogg_IndexLoad( demux_t * );
+static void Ogg_IndexSave( demux_t * );
+static void Ogg_IndexAdd( demux_t *, const ogg_page * );
+static int  Ogg_IndexSeek( demux_t *, mtime_t );
+
 /*****************************************************************************
  * Open: initializes ogg demux structures
  *****************************************************************************/
@@ -189,6 +206,9 @@ static int Open( vlc_object_t * p_this )
     /* */
     p_sys->p_meta = NULL;
 
+    Ogg_IndexOpen( p_demux );
+    Ogg_IndexLoad( p_demux );
+
     return VLC_SUCCESS;
 }
 
@@ -208,6 +228,10 @@ static void Close( vlc_object_t *p_this )
     if( p_sys->p_old_stream )
         Ogg_LogicalStreamDelete( p_demux, p_sys->p_old_stream );
 
+    Ogg_IndexSave( p_demux );
+    free( p_sys->psz_index );
+    free( p_sys->p_index );
+
     free( p_sys );
 }
 
@@ -229,6 +253,7 @@ static int Demux( demux_t * p_demux )
         if( p_sys->i_eos )
         {
             msg_Dbg( p_demux, "end of a group of logical streams" );
+            p_sys->b_chained = true;
             /* We keep the ES to try reusing it in Ogg_BeginningOfStream
              * only 1 ES is supported (common case for ogg web radio) */
             if( p_sys->i_streams == 1 )
@@ -269,6 +294,9 @@ static int Demux( demux_t * p_demux )
         if( Ogg_ReadPage( p_demux, &p_sys->current_page ) != VLC_SUCCESS )
             return 0; /* EOF */
 
+        if( p_sys->psz_index && !p_sys->b_chained )
+            Ogg_IndexAdd( p_demux, &p_sys->current_page );
+
         /* Test for End of Stream */
         if( ogg_page_eos( &p_sys->current_page ) )
             p_sys->i_eos++;
@@ -437,7 +465,6 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
     vlc_meta_t *p_meta;
     int64_t *pi64;
     bool *pb_bool;
-    int i;
 
     switch( i_query )
     {
@@ -458,7 +485,9 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
             return VLC_SUCCESS;
 
         case DEMUX_SET_TIME:
-            return VLC_EGENERIC;
+            if( p_sys->i_bos > 0 )
+                return VLC_EGENERIC;
+            return Ogg_IndexSeek( p_demux, (int64_t)va_arg( args, int64_t ) );
 
         case DEMUX_GET_ATTACHMENTS:
         {
@@ -485,18 +514,18 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
                 return VLC_EGENERIC;
             }
 
-            for( i = 0; i < p_sys->i_streams; i++ )
+            if( p_sys->i_length > 0 && p_sys->i_index > 0 )
             {
-                logical_stream_t *p_stream = p_sys->pp_stream[i];
+                va_list ap;
 
-                /* we'll trash all the data until we find the next pcr */
-                p_stream->b_reinit = true;
-                p_stream->i_pcr = -1;
-                p_stream->i_interpolated_pcr = -1;
-                p_stream->i_previous_granulepos = -1;
-                ogg_stream_reset( &p_stream->os );
+                va_copy( ap, args );
+                double f = va_arg( ap, double );
+                va_end( ap );
+                if( !Ogg_IndexSeek( p_demux, f * p_sys->i_length * CLOCK_FREQ ) )
+                    return VLC_SUCCESS;
             }
-            ogg_sync_reset( &p_sys->oy );
+
+            Ogg_ResetStreams( p_demux );
             return demux_vaControlHelper( p_demux->s, 0, -1, p_sys->i_bitrate,
                                           1, i_query, args );
         case DEMUX_GET_LENGTH:
@@ -540,6 +569,27 @@ static int Ogg_ReadPage( demux_t *p_demux, ogg_page *p_oggpage )
     return VLC_SUCCESS;
 }
 
+/****************************************************************************
+ * Ogg_ResetStreams: drop the state of the logical streams before a seek
+ ****************************************************************************/
+static void Ogg_ResetStreams( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    for( int i = 0; i < p_sys->i_streams; i++ )
+    {
+        logical_stream_t *p_stream = p_sys->pp_stream[i];
+
+        /* we'll trash all the data until we find the next pcr */
+        p_stream->b_reinit = true;
+        p_stream->i_pcr = -1;
+        p_stream->i_interpolated_pcr = -1;
+        p_stream->i_previous_granulepos = -1;
+        ogg_stream_reset( &p_stream->os );
+    }
+    ogg_sync_reset( &p_sys->oy );
+}
+
 /****************************************************************************
  * Ogg_UpdatePCR: update the PCR (90kHz program clock reference) for the
  *                current stream.
@@ -2308,3 +2358,191 @@ static bool Ogg_ReadDiracHeader( logical_stream_t *p_stream,
 
     return true;
 }
+
+/*****************************************************************************
+ * Seek index
+ *****************************************************************************
+ * The file: magic, file size, how many samples follow, then each of them as
+ * time and position, all big endian.
+ *****************************************************************************/
+#define OGG_INDEX_MAGIC "VLCOGIX1"
+#define OGG_INDEX_HEADER 20
+#define OGG_INDEX_MAX (1 << 20)
+#define OGG_INDEX_SPACING CLOCK_FREQ /* between samples at least */
+
+static void Ogg_IndexOpen( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    bool b_can_seek = false;
+
+    stream_Control( p_demux->s, STREAM_CAN_FASTSEEK, &b_can_seek );
+    if( !var_InheritBool( p_demux, "ogg-seek-index" ) || !b_can_seek )
+        return;
+
+    p_sys->psz_index = demux_IndexCachePath( p_demux, "ogg-index" );
+}
+
+static void Ogg_IndexLoad( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    uint8_t p_head[OGG_INDEX_HEADER], p_entry[16];
+
+    if( !p_sys->psz_index )
+        return;
+
+    FILE *p_file = vlc_fopen( p_sys->psz_index, "rb" );
+    if( !p_file )
+        return;
+
+    if( fread( p_head, sizeof( p_head ), 1, p_file ) != 1 ||
+        memcmp( p_head, OGG_INDEX_MAGIC, 8 ) ||
+        GetQWBE( &p_head[8] ) != (uint64_t)stream_Size( p_demux->s ) ||
+        GetDWBE( &p_head[16] ) > OGG_INDEX_MAX )
+        goto out;
+
+    const int i_index = GetDWBE( &p_head[16] );
+    ogg_index_t *p_index = malloc( __MAX( i_index, 1 ) * sizeof( *p_index ) );
+    if( !p_index )
+        goto out;
+    for( int i = 0; i < i_index; i++ )
+    {
+        if( fread( p_entry, sizeof( p_entry ), 1, p_file ) != 1 )
+        {
+            free( p_index );
+            goto out;
+        }
+        p_index[i].i_time = GetQWBE( &p_entry[0] );
+        p_index[i].i_pos = GetQWBE( &p_entry[8] );
+        /* Ogg_IndexSeek() looks them up by time and Ogg_IndexAdd() by
+         * position */
+        if( i > 0 && ( p_index[i].i_time <= p_index[i-1].i_time ||
+                       p_index[i].i_pos <= p_index[i-1].i_pos ) )
+        {
+            free( p_index );
+            goto out;
+        }
+    }
+
+    p_sys->i_index = p_sys->i_index_max = i_index;
+    p_sys->p_index = p_index;
+    msg_Dbg( p_demux, "seek index loaded (%d pages)", i_index );
+out:
+    fclose( p_file );
+}
+
+static void Ogg_IndexSave( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    uint8_t p_head[OGG_INDEX_HEADER], p_entry[16];
+
+    if( !p_sys->psz_index || !p_sys->b_index_dirty )
+        return;
+
+    FILE *p_file = demux_IndexCacheCreate( p_demux, p_sys->psz_index );
+    if( !p_file )
+        return;
+
+    memcpy( p_head, OGG_INDEX_MAGIC, 8 );
+    SetQWBE( &p_head[8], stream_Size( p_demux->s ) );
+    SetDWBE( &p_head[16], p_sys->i_index );
+    bool b_ok = fwrite( p_head, sizeof( p_head ), 1, p_file ) == 1;
+
+    for( int i = 0; b_ok && i < p_sys->i_index; i++ )
+    {
+        SetQWBE( &p_entry[0], p_sys->p_index[i].i_time );
+        SetQWBE( &p_entry[8], p_sys->p_index[i].i_pos );
+        b_ok = fwrite( p_entry, sizeof( p_entry ), 1, p_file ) == 1;
+    }
+
+    demux_IndexCacheClose( p_demux, p_sys->psz_index, p_file, b_ok );
+}
+
+/* Records a page that was just read, with the time reached before it */
+static void Ogg_IndexAdd( demux_t *p_demux, const ogg_page *p_page )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const mtime_t i_time = p_sys->i_pcr;
+
+    /* Packets continued from the previous page cannot be decoded from here,
+     * and the time is not known yet after a seek */
+    if( i_time < 0 || ogg_page_continued( p_page ) )
+        return;
+    for( int i = 0; i < p_sys->i_streams; i++ )
+        if( p_sys->pp_stream[i]->b_reinit )
+            return;
+
+    /* The page was read through the sync buffer, it ends where the data
+     * that was not returned yet starts */
+    const int64_t i_pos = stream_Tell( p_demux->s )
+                        - ( p_sys->oy.fill - p_sys->oy.returned )
+                        - p_page->header_len - p_page->body_len;
+    if( i_pos < 0 )
+        return;
+
+    int i_lo = 0, i_hi = p_sys->i_index;
+    while( i_lo < i_hi )
+    {
+        int i_mid = ( i_lo + i_hi ) / 2;
+        if( p_sys->p_index[i_mid].i_pos < i_pos )
+            i_lo = i_mid + 1;
+        else
+            i_hi = i_mid;
+    }
+
+    /* A sample a second is plenty, and the times have to go up with the
+     * positions (this also drops the ones already there) */
+    if( i_lo > 0 && i_time - p_sys->p_index[i_lo - 1].i_time < OGG_INDEX_SPACING )
+        return;
+    if( i_lo < p_sys->i_index &&
+        p_sys->p_index[i_lo].i_time - i_time < OGG_INDEX_SPACING )
+        return;
+
+    if( p_sys->i_index == p_sys->i_index_max )
+    {
+        if( p_sys->i_index_max >= OGG_INDEX_MAX )
+            return;
+        int i_max = p_sys->i_index_max ? 2 * p_sys->i_index_max : 256;
+        ogg_index_t *p_index = realloc( p_sys->p_index,
+                                        i_max * sizeof( *p_index ) );
+        if( !p_index )
+            return;
+        p_sys->p_index = p_index;
+        p_sys->i_index_max = i_max;
+    }
+
+    memmove( &p_sys->p_index[i_lo + 1], &p_sys->p_index[i_lo],
+             ( p_sys->i_index - i_lo ) * sizeof( *p_sys->p_index ) );
+    p_sys->p_index[i_lo].i_time = i_time;
+    p_sys->p_index[i_lo].i_pos = i_pos;
+    p_sys->i_index++;
+    p_sys->b_index_dirty = true;
+}
+
+/* Seeks to the last page recorded before a time, if it is close enough */
+static int Ogg_IndexSeek( demux_t *p_demux, mtime_t i_time )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    int i_lo = 0, i_hi = p_sys->i_index;
+    while( i_lo < i_hi )
+    {
+        int i_mid = ( i_lo + i_hi ) / 2;
+        if( p_sys->p_index[i_mid].i_time <= i_time )
+            i_lo = i_mid + 1;
+        else
+            i_hi = i_mid;
+    }
+    if( i_lo == 0 ||
+        i_time - p_sys->p_index[i_lo - 1].i_time > 2 * OGG_INDEX_SPACING )
+        return VLC_EGENERIC;
+
+    const ogg_index_t *p_before = &p_sys->p_index[i_lo - 1];
+    if( stream_Seek( p_demux->s, p_before->i_pos ) )
+        return VLC_EGENERIC;
+
+    Ogg_ResetStreams( p_demux );
+    p_sys->b_page_waiting = false;
+    msg_Dbg( p_demux, "seek to %"PRId64" found in the index at %"PRId64,
+             i_time, p_before->i_pos );
+    return VLC_SUCCESS;
+}
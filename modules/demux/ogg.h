@@ -36,6 +36,12 @@
 
 typedef struct oggseek_index_entry demux_index_entry_t;
 
+typedef struct
+{
+    mtime_t     i_time; /* reached by the pages before it */
+    int64_t     i_pos;  /* of the page */
+} ogg_index_t;
+
 
 typedef struct logical_stream_s
 {
@@ -143,4 +149,12 @@ struct demux_sys_t
 
     /* Length, if available. */
     int64_t i_length;
+
+    /* Pages met while playing, by position, see Ogg_IndexAdd() */
+    char        *psz_index; /* file it is kept in, NULL if it is not */
+    bool        b_index_dirty;
+    bool        b_chained; /* times start again after the first group */
+    int         i_index;
+    int         i_index_max;
+    ogg_index_t *p_index;
 };
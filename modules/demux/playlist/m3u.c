@@ -163,6 +163,7 @@ static int Demux( demux_t *p_demux )
     char *    (*pf_dup) (const char *) = p_demux->p_sys->pf_dup;
     int        i_options = 0;
     bool b_cleanup = false;
+    bool b_posted = false;
     input_item_t *p_input;
 
     input_item_t *p_current_input = GetCurrentItem(p_demux);
@@ -260,6 +261,7 @@ static int Demux( demux_t *p_demux )
 
             input_item_node_AppendItem( p_subitems, p_input );
             vlc_gc_decref( p_input );
+            PostParsedItems( p_subitems, &b_posted );
         }
 
  error:
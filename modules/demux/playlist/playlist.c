@@ -217,3 +217,19 @@ char *ProcessMRL( const char *psz_mrl, const char *psz_prefix )
 uri:
     return make_URI( psz_mrl, NULL );
 }
+
+/**
+ * Post the sub-items parsed so far, if there are enough of them: the first
+ * one alone, so that it can start playing, then by PLAYLIST_BATCH. Long
+ * playlists then appear while being parsed, and their items are not all
+ * kept in the node until the end.
+ * \param pb_posted false until the first item was posted
+ */
+void PostParsedItems( input_item_node_t *p_subitems, bool *pb_posted )
+{
+    if( p_subitems->i_children >= ( *pb_posted ? PLAYLIST_BATCH : 1 ) )
+    {
+        input_item_node_PostBatch( p_subitems );
+        *pb_posted = true;
+    }
+}
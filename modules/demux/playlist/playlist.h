@@ -27,6 +27,10 @@
 char *ProcessMRL( const char *, const char * );
 char *FindPrefix( demux_t * );
 
+/* Most sub-items posted at once while parsing a long playlist */
+#define PLAYLIST_BATCH 512
+void PostParsedItems( input_item_node_t *, bool * );
+
 int Import_Old ( vlc_object_t * );
 
 int Import_Native ( vlc_object_t * );
@@ -87,6 +87,7 @@ static int Demux( demux_t *p_demux )
     char          *psz_key;
     char          *psz_value;
     int            i_item = -1;
+    bool           b_posted = false;
     input_item_t *p_input;
 
     input_item_t *p_current_input = GetCurrentItem(p_demux);
@@ -146,6 +147,7 @@ static int Demux( demux_t *p_demux )
                 input_item_CopyOptions( p_current_input, p_input );
                 input_item_node_AppendItem( p_subitems, p_input );
                 vlc_gc_decref( p_input );
+                PostParsedItems( p_subitems, &b_posted );
                 free( psz_mrl_orig );
                 psz_mrl_orig = psz_mrl = NULL;
             }
@@ -37,6 +37,7 @@
 #include <vlc_memory.h>
 
 #include <ctype.h>
+#include <assert.h>
 
 #include <vlc_demux.h>
 #include <vlc_charset.h>
@@ -60,6 +61,11 @@ static void Close( vlc_object_t *p_this );
     " and \"auto\" (meaning autodetection, this should always work).")
 #define SUB_DESCRIPTION_LONGTEXT \
     N_("Override the default track description.")
+#define SUB_INDEX_TEXT N_("Index subtitles files larger than (kB)")
+#define SUB_INDEX_LONGTEXT \
+    N_("Subtitles files larger than this are not loaded in memory. Only " \
+    "the timestamps and the file offsets of the subtitles are kept, and " \
+    "each subtitle is read again when it is displayed. 0 disables it.")
 
 static const char *const ppsz_sub_type[] =
 {
@@ -86,6 +92,8 @@ vlc_module_begin ()
         change_string_list( ppsz_sub_type, NULL, NULL )
     add_string( "sub-description", NULL, N_("Subtitles description"),
                 SUB_DESCRIPTION_LONGTEXT, true )
+    add_integer( "sub-index-size", 4096, SUB_INDEX_TEXT,
+                 SUB_INDEX_LONGTEXT, true )
     set_callbacks( Open, Close )
 
     add_shortcut( "subtitle" )
@@ -119,22 +127,35 @@ enum
                          and Gnome subtitles SubViewer 1.0 */
 };
 
+#define TEXT_WINDOW 4 /* lines kept when reading them from the stream */
+
 typedef struct
 {
     int     i_line_count;
     int     i_line;
     char    **line;
+
+    /* When the lines are read from the stream on demand (indexed mode),
+     * only the last TEXT_WINDOW ones are kept, in line[i % TEXT_WINDOW] */
+    stream_t *s;
+    int64_t  pi_offset[TEXT_WINDOW];
+    bool     b_eof;
 } text_t;
 
 static int  TextLoad( text_t *, stream_t *s );
+static int  TextOpen( text_t *, stream_t *s );
 static void TextUnload( text_t * );
+static int64_t TextTell( text_t * );
+static int  TextSeek( text_t *, int64_t );
 
 typedef struct
 {
     int64_t i_start;
     int64_t i_stop;
 
-    char    *psz_text;
+    char    *psz_text; /* NULL in indexed mode */
+    int64_t i_offset;  /* in the stream, where to parse it again */
+    int     i_index;   /* in the file */
 } subtitle_t;
 
 
@@ -142,6 +163,7 @@ struct demux_sys_t
 {
     int         i_type;
     text_t      txt;
+    bool        b_index;
     es_out_id_t *es;
 
     int64_t     i_next_demux_date;
@@ -170,6 +192,8 @@ struct demux_sys_t
         float f_total;
         float f_factor;
     } mpsub;
+
+    int  (*pf_read)( demux_t *, subtitle_t*, int );
 };
 
 static int  ParseMicroDvd   ( demux_t *, subtitle_t *, int );
@@ -227,6 +251,7 @@ static int Demux( demux_t * );
 static int Control( demux_t *, int, va_list );
 
 static void Fix( demux_t * );
+static char *SubtitleLoad( demux_t *, const subtitle_t * );
 
 /*****************************************************************************
  * Module initializer
@@ -471,10 +496,30 @@ static int Open ( vlc_object_t *p_this )
         }
     }
 
-    msg_Dbg( p_demux, "loading all subtitles..." );
+    p_sys->pf_read = pf_read;
 
-    /* Load the whole file */
-    TextLoad( &p_sys->txt, p_demux->s );
+    /* Large files are indexed, unless the text of a subtitle depends on the
+     * previous ones (JacoSub directives, MPSub relative times) */
+    int64_t i_index_size = var_InheritInteger( p_demux, "sub-index-size" );
+
+    p_sys->b_index = false;
+    if( i_index_size > 0
+     && stream_Size( p_demux->s ) > i_index_size * 1024
+     && p_sys->i_type != SUB_TYPE_JACOSUB && p_sys->i_type != SUB_TYPE_MPSUB )
+        stream_Control( p_demux->s, STREAM_CAN_SEEK, &p_sys->b_index );
+
+    if( p_sys->b_index )
+    {
+        msg_Dbg( p_demux, "indexing subtitles..." );
+        TextOpen( &p_sys->txt, p_demux->s );
+    }
+    else
+    {
+        msg_Dbg( p_demux, "loading all subtitles..." );
+
+        /* Load the whole file */
+        TextLoad( &p_sys->txt, p_demux->s );
+    }
 
     /* Parse it */
     for( i_max = 0;; )
@@ -491,16 +536,31 @@ static int Open ( vlc_object_t *p_this )
             }
         }
 
-        if( pf_read( p_demux, &p_sys->subtitle[p_sys->i_subtitles],
-                     p_sys->i_subtitles ) )
+        subtitle_t *p_subtitle = &p_sys->subtitle[p_sys->i_subtitles];
+        int64_t i_offset = p_sys->b_index ? TextTell( &p_sys->txt ) : 0;
+
+        if( pf_read( p_demux, p_subtitle, p_sys->i_subtitles ) )
             break;
 
+        p_subtitle->i_offset = i_offset;
+        p_subtitle->i_index = p_sys->i_subtitles;
+        if( p_sys->b_index )
+        {   /* Keep the timestamps only */
+            free( p_subtitle->psz_text );
+            p_subtitle->psz_text = NULL;
+        }
         p_sys->i_subtitles++;
     }
-    /* Unload */
-    TextUnload( &p_sys->txt );
 
-    msg_Dbg(p_demux, "loaded %d subtitles", p_sys->i_subtitles );
+    if( p_sys->b_index )
+        msg_Dbg( p_demux, "indexed %d subtitles", p_sys->i_subtitles );
+    else
+    {
+        /* Unload */
+        TextUnload( &p_sys->txt );
+
+        msg_Dbg( p_demux, "loaded %d subtitles", p_sys->i_subtitles );
+    }
 
     /* Fix subtitle (order and time) *** */
     p_sys->i_subtitle = 0;
@@ -553,6 +613,8 @@ static void Close( vlc_object_t *p_this )
     for( i = 0; i < p_sys->i_subtitles; i++ )
         free( p_sys->subtitle[i].psz_text );
     free( p_sys->subtitle );
+    if( p_sys->b_index )
+        TextUnload( &p_sys->txt );
 
     free( p_sys );
 }
@@ -675,17 +737,25 @@ static int Demux( demux_t *p_demux )
         const subtitle_t *p_subtitle = &p_sys->subtitle[p_sys->i_subtitle];
 
         block_t *p_block;
-        int i_len = strlen( p_subtitle->psz_text ) + 1;
+        char *psz_loaded = NULL;
+        const char *psz_text = p_subtitle->psz_text;
 
-        if( i_len <= 1 || p_subtitle->i_start < 0 )
-        {
-            p_sys->i_subtitle++;
+        p_sys->i_subtitle++;
+        if( p_subtitle->i_start < 0 )
             continue;
+
+        if( p_sys->b_index )
+        {
+            psz_text = psz_loaded = SubtitleLoad( p_demux, p_subtitle );
+            if( psz_text == NULL )
+                continue;
         }
 
-        if( ( p_block = block_New( p_demux, i_len ) ) == NULL )
+        int i_len = strlen( psz_text ) + 1;
+
+        if( i_len <= 1 || ( p_block = block_New( p_demux, i_len ) ) == NULL )
         {
-            p_sys->i_subtitle++;
+            free( psz_loaded );
             continue;
         }
 
@@ -694,11 +764,10 @@ static int Demux( demux_t *p_demux )
         if( p_subtitle->i_stop >= 0 && p_subtitle->i_stop >= p_subtitle->i_start )
             p_block->i_length = p_subtitle->i_stop - p_subtitle->i_start;
 
-        memcpy( p_block->p_buffer, p_subtitle->psz_text, i_len );
+        memcpy( p_block->p_buffer, psz_text, i_len );
+        free( psz_loaded );
 
         es_out_Send( p_demux->out, p_sys->es, p_block );
-
-        p_sys->i_subtitle++;
     }
 
     /* */
@@ -743,6 +812,29 @@ static void Fix( demux_t *p_demux )
     } while( !b_done );
 }
 
+/*****************************************************************************
+ * SubtitleLoad: parse again the text of a subtitle (indexed mode)
+ *****************************************************************************/
+static char *SubtitleLoad( demux_t *p_demux, const subtitle_t *p_index )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    char *psz_header = p_sys->psz_header;
+    subtitle_t sub;
+
+    if( TextSeek( &p_sys->txt, p_index->i_offset ) )
+        return NULL;
+
+    /* The header was complete after indexing, do not extend it again */
+    p_sys->psz_header = NULL;
+    if( p_sys->pf_read( p_demux, &sub, p_index->i_index ) )
+        sub.psz_text = NULL;
+    free( p_sys->psz_header );
+    p_sys->psz_header = psz_header;
+
+    /* The timestamps of the index are the ones fixed at opening */
+    return sub.psz_text;
+}
+
 static int TextLoad( text_t *txt, stream_t *s )
 {
     int   i_line_max;
@@ -751,6 +843,7 @@ static int TextLoad( text_t *txt, stream_t *s )
     i_line_max          = 500;
     txt->i_line_count   = 0;
     txt->i_line         = 0;
+    txt->s              = NULL;
     txt->line           = calloc( i_line_max, sizeof( char * ) );
     if( !txt->line )
         return VLC_ENOMEM;
@@ -781,12 +874,25 @@ static int TextLoad( text_t *txt, stream_t *s )
 
     return VLC_SUCCESS;
 }
+static int TextOpen( text_t *txt, stream_t *s )
+{
+    txt->i_line_count   = 0;
+    txt->i_line         = 0;
+    txt->line           = calloc( TEXT_WINDOW, sizeof( char * ) );
+    if( !txt->line )
+        return VLC_ENOMEM;
+    txt->s              = s;
+    txt->b_eof          = false;
+    return VLC_SUCCESS;
+}
 static void TextUnload( text_t *txt )
 {
     int i;
 
     for( i = 0; i < txt->i_line_count; i++ )
     {
+        if( txt->s != NULL && i >= TEXT_WINDOW )
+            break;
         free( txt->line[i] );
     }
     free( txt->line );
@@ -794,8 +900,37 @@ static void TextUnload( text_t *txt )
     txt->i_line_count = 0;
 }
 
+/* Reads the next line from the stream, into the window (indexed mode) */
+static void TextReadLine( text_t *txt )
+{
+    if( txt->b_eof )
+        return;
+
+    int64_t i_offset = stream_Tell( txt->s );
+    char *psz = stream_ReadLine( txt->s );
+    if( psz == NULL )
+    {
+        txt->b_eof = true;
+        return;
+    }
+
+    int i_slot = txt->i_line_count++ % TEXT_WINDOW;
+    free( txt->line[i_slot] );
+    txt->line[i_slot] = psz;
+    txt->pi_offset[i_slot] = i_offset;
+}
+
 static char *TextGetLine( text_t *txt )
 {
+    if( txt->s != NULL )
+    {
+        if( txt->i_line >= txt->i_line_count )
+            TextReadLine( txt );
+        if( txt->i_line >= txt->i_line_count )
+            return( NULL );
+        return txt->line[txt->i_line++ % TEXT_WINDOW];
+    }
+
     if( txt->i_line >= txt->i_line_count )
         return( NULL );
 
@@ -805,6 +940,38 @@ static void TextPreviousLine( text_t *txt )
 {
     if( txt->i_line > 0 )
         txt->i_line--;
+    assert( txt->s == NULL || txt->i_line_count - txt->i_line <= TEXT_WINDOW );
+}
+static bool TextIsEnd( text_t *txt )
+{
+    if( txt->s != NULL && txt->i_line >= txt->i_line_count )
+        TextReadLine( txt );
+    return txt->i_line >= txt->i_line_count;
+}
+
+/* Offset of the next line in the stream (indexed mode) */
+static int64_t TextTell( text_t *txt )
+{
+    if( txt->i_line < txt->i_line_count )
+        return txt->pi_offset[txt->i_line % TEXT_WINDOW];
+    return stream_Tell( txt->s );
+}
+static int TextSeek( text_t *txt, int64_t i_offset )
+{
+    /* Subtitles are mostly read in order: the line is often in the window */
+    for( int i = __MAX( txt->i_line_count - TEXT_WINDOW, 0 );
+         i < txt->i_line_count; i++ )
+        if( txt->pi_offset[i % TEXT_WINDOW] == i_offset )
+        {
+            txt->i_line = i;
+            return VLC_SUCCESS;
+        }
+
+    txt->i_line = txt->i_line_count;
+    if( stream_Tell( txt->s ) == i_offset )
+        return VLC_SUCCESS;
+    txt->b_eof = false;
+    return stream_Seek( txt->s, i_offset );
 }
 
 /*****************************************************************************
@@ -1074,6 +1241,7 @@ static int  ParseSSA( demux_t *p_demux, subtitle_t *p_subtitle,
         if( asprintf( &psz_header, "%s%s\n",
                        p_sys->psz_header ? p_sys->psz_header : "", s ) == -1 )
             return VLC_ENOMEM;
+        free( p_sys->psz_header );
         p_sys->psz_header = psz_header;
     }
 }
@@ -1416,7 +1584,7 @@ static int ParseAQT( demux_t *p_demux, subtitle_t *p_subtitle, int i_idx )
                  return VLC_ENOMEM;
             strcat( psz_text, s );
             strcat( psz_text, "\n" );
-            if( txt->i_line == txt->i_line_count )
+            if( TextIsEnd( txt ) )
                 break;
         }
     }
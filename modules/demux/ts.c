@@ -143,6 +143,12 @@ static void Close ( vlc_object_t * );
     "Seek and position based on a percent byte position, not a PCR generated " \
     "time position. If seeking doesn't work property, turn on this option." )
 
+#define SEEK_INDEX_TEXT N_("Keep a seek index")
+#define SEEK_INDEX_LONGTEXT N_( \
+    "Remember where the PCR of a file were found, in the cache directory, " \
+    "so that opening it again and seeking in it do not have to look for " \
+    "them. This helps with files on network storage." )
+
 
 vlc_module_begin ()
     set_description( N_("MPEG Transport Stream demuxer") )
@@ -172,6 +178,7 @@ vlc_module_begin ()
                  DUMPSIZE_LONGTEXT, true )
     add_bool( "ts-split-es", true, SPLIT_ES_TEXT, SPLIT_ES_LONGTEXT, false )
     add_bool( "ts-seek-percent", false, SEEK_PERCENT_TEXT, SEEK_PERCENT_LONGTEXT, true )
+    add_bool( "ts-seek-index", false, SEEK_INDEX_TEXT, SEEK_INDEX_LONGTEXT, true )
 
     set_capability( "demux", 10 )
     set_callbacks( Open, Close )
@@ -333,6 +340,14 @@ typedef struct
 
 } ts_pid_t;
 
+#define TS_PID_SLAB 64
+
+typedef struct
+{
+    mtime_t     i_pcr;  /* with the wrap arounds added */
+    int64_t     i_pos;  /* of the packet carrying it */
+} ts_index_t;
+
 struct demux_sys_t
 {
     vlc_mutex_t     csa_lock;
@@ -353,8 +368,19 @@ struct demux_sys_t
     mtime_t     *p_pcrs;
     int64_t     *p_pos;
 
-    /* All pid */
-    ts_pid_t    pid[8192];
+    /* PCR met while playing, by position, see IndexAdd() */
+    char        *psz_index; /* file it is kept in, NULL if it is not */
+    bool        b_index_dirty;
+    int         i_index;
+    int         i_index_max;
+    ts_index_t  *p_index;
+
+    /* All pid, allocated the first time they are met: pid_index[] is 0
+     * for the others, the rank in the slabs plus one otherwise. Slabs are
+     * never moved, as pointers to the pid are kept around. */
+    uint16_t    pid_index[8192];
+    int         i_pids;
+    ts_pid_t    *pid_slab[8192 / TS_PID_SLAB];
 
     /* All PMT */
     bool        b_user_pmt;
@@ -416,6 +442,31 @@ static inline int PIDGet( block_t *p )
     return ( (p->p_buffer[1]&0x1f)<<8 )|p->p_buffer[2];
 }
 
+static inline ts_pid_t *PIDAt( demux_sys_t *p_sys, int i )
+{
+    return &p_sys->pid_slab[i / TS_PID_SLAB][i % TS_PID_SLAB];
+}
+
+static ts_pid_t *GetPID( demux_sys_t *p_sys, int i_pid )
+{
+    const int i_index = p_sys->pid_index[i_pid];
+    if( likely(i_index > 0) )
+        return PIDAt( p_sys, i_index - 1 );
+
+    const int i = p_sys->i_pids;
+    if( i % TS_PID_SLAB == 0 )
+        p_sys->pid_slab[i / TS_PID_SLAB] =
+            xmalloc( TS_PID_SLAB * sizeof( ts_pid_t ) );
+
+    ts_pid_t *pid = PIDAt( p_sys, i );
+    memset( pid, 0, sizeof( *pid ) );
+    pid->i_pid      = i_pid;
+    pid->b_seen     = false;
+    pid->b_valid    = false;
+    p_sys->pid_index[i_pid] = ++p_sys->i_pids;
+    return pid;
+}
+
 static bool GatherPES( demux_t *p_demux, ts_pid_t *pid, block_t *p_bk );
 
 static block_t* ReadTSPacket( demux_t *p_demux );
@@ -426,6 +477,10 @@ static void GetFirstPCR( demux_t *p_demux );
 static void GetLastPCR( demux_t *p_demux );
 static void CheckPCR( demux_t *p_demux );
 static void PCRHandle( demux_t *p_demux, ts_pid_t *, block_t * );
+static void IndexOpen( demux_t *p_demux );
+static bool IndexLoad( demux_t *p_demux );
+static void IndexSave( demux_t *p_demux );
+static void IndexAdd( demux_t *p_demux, mtime_t i_pcr, int64_t i_pos );
 
 static iod_descriptor_t *IODNew( int , uint8_t * );
 static void              IODFree( iod_descriptor_t * );
@@ -442,6 +497,26 @@ static void SetPrgFilter( demux_t *, int i_prg, bool b_selected );
 #define TS_PACKET_SIZE_MAX 204
 #define TS_TOPFIELD_HEADER 1320
 
+/* First sync byte of p_peek followed by another one a packet further, or
+ * i_peek - i_packet_size if there is none. The sync bytes are looked for
+ * with memchr(), which the C library vectorizes. */
+static int FindSync( const uint8_t *p_peek, int i_peek, int i_packet_size )
+{
+    const int i_end = i_peek - i_packet_size;
+
+    for( int i_skip = 0; i_skip < i_end; i_skip++ )
+    {
+        const uint8_t *p_sync = memchr( &p_peek[i_skip], 0x47,
+                                        i_end - i_skip );
+        if( p_sync == NULL )
+            break;
+        i_skip = p_sync - p_peek;
+        if( p_peek[i_skip + i_packet_size] == 0x47 )
+            return i_skip;
+    }
+    return i_end;
+}
+
 static int DetectPacketSize( demux_t *p_demux )
 {
     const uint8_t *p_peek;
@@ -520,8 +595,11 @@ static int DetectPacketSize( demux_t *p_demux )
 
     for( int i_sync = 0; i_sync < TS_PACKET_SIZE_MAX; i_sync++ )
     {
-        if( p_peek[i_sync] != 0x47 )
-            continue;
+        const uint8_t *p_sync = memchr( &p_peek[i_sync], 0x47,
+                                        TS_PACKET_SIZE_MAX - i_sync );
+        if( p_sync == NULL )
+            break;
+        i_sync = p_sync - p_peek;
 
         /* Check next 3 sync bytes */
         int i_peek = TS_PACKET_SIZE_MAX * 3 + i_sync + 1;
@@ -647,16 +725,8 @@ static int Open( vlc_object_t *p_this )
 
     p_sys->b_broken_charset = false;
 
-    for( int i = 0; i < 8192; i++ )
-    {
-        ts_pid_t *pid = &p_sys->pid[i];
-
-        pid->i_pid      = i;
-        pid->b_seen     = false;
-        pid->b_valid    = false;
-    }
     /* PID 8191 is padding */
-    p_sys->pid[8191].b_seen = true;
+    GetPID( p_sys, 8191 )->b_seen = true;
     p_sys->i_packet_size = i_packet_size;
     p_sys->b_udp_out = false;
     p_sys->fd = -1;
@@ -665,14 +735,14 @@ static int Open( vlc_object_t *p_this )
     p_sys->b_start_record = false;
 
     /* Init PAT handler */
-    pat = &p_sys->pid[0];
+    pat = GetPID( p_sys, 0 );
     PIDInit( pat, true, NULL );
     pat->psi->handle = dvbpsi_AttachPAT( (dvbpsi_pat_callback)PATCallBack,
                                          p_demux );
     if( p_sys->b_dvb_meta )
     {
-        ts_pid_t *sdt = &p_sys->pid[0x11];
-        ts_pid_t *eit = &p_sys->pid[0x12];
+        ts_pid_t *sdt = GetPID( p_sys, 0x11 );
+        ts_pid_t *eit = GetPID( p_sys, 0x12 );
 
         PIDInit( sdt, true, NULL );
         sdt->psi->handle =
@@ -683,7 +753,7 @@ static int Open( vlc_object_t *p_this )
             dvbpsi_AttachDemux( (dvbpsi_demux_new_cb_t)PSINewTableCallBack,
                                 p_demux );
 #ifdef TS_USE_TDT
-        ts_pid_t *tdt = &p_sys->pid[0x14];
+        ts_pid_t *tdt = GetPID( p_sys, 0x14 );
         PIDInit( tdt, true, NULL );
         tdt->psi->handle =
             dvbpsi_AttachDemux( (dvbpsi_demux_new_cb_t)PSINewTableCallBack,
@@ -810,11 +880,14 @@ static int Open( vlc_object_t *p_this )
 
     bool can_seek = false;
     stream_Control( p_demux->s, STREAM_CAN_FASTSEEK, &can_seek );
-    if( can_seek  )
+    if( can_seek )
+        IndexOpen( p_demux );
+    if( can_seek && !IndexLoad( p_demux ) )
     {
         GetFirstPCR( p_demux );
         CheckPCR( p_demux );
         GetLastPCR( p_demux );
+        p_sys->b_index_dirty = true;
     }
     if( p_sys->i_first_pcr < 0 || p_sys->i_last_pcr < 0 )
     {
@@ -841,9 +914,9 @@ static void Close( vlc_object_t *p_this )
     demux_sys_t *p_sys = p_demux->p_sys;
 
     msg_Dbg( p_demux, "pid list:" );
-    for( int i = 0; i < 8192; i++ )
+    for( int i = 0; i < p_sys->i_pids; i++ )
     {
-        ts_pid_t *pid = &p_sys->pid[i];
+        ts_pid_t *pid = PIDAt( p_sys, i );
 
         if( pid->b_valid && pid->psi )
         {
@@ -879,12 +952,12 @@ static void Close( vlc_object_t *p_this )
         {
             msg_Dbg( p_demux, "  - pid[%d] seen", pid->i_pid );
         }
-
-        /* too much */
-        if( pid->i_pid > 0 )
-            SetPIDFilter( p_demux, pid->i_pid, false );
     }
 
+    /* too much */
+    for( int i = 1; i < 8192; i++ )
+        SetPIDFilter( p_demux, i, false );
+
     vlc_mutex_lock( &p_sys->csa_lock );
     if( p_sys->csa )
     {
@@ -918,9 +991,16 @@ static void Close( vlc_object_t *p_this )
     free( p_sys->buffer );
     free( p_sys->psz_file );
 
+    IndexSave( p_demux );
+    free( p_sys->psz_index );
+    free( p_sys->p_index );
+
     free( p_sys->p_pcrs );
     free( p_sys->p_pos );
 
+    for( int i = 0; i < p_sys->i_pids; i += TS_PID_SLAB )
+        free( p_sys->pid_slab[i / TS_PID_SLAB] );
+
     vlc_mutex_destroy( &p_sys->csa_lock );
     free( p_sys );
 }
@@ -969,14 +1049,12 @@ static int DemuxFile( demux_t *p_demux )
         if( p_sys->buffer[i_pos] != 0x47 )
         {
             msg_Warn( p_demux, "lost sync" );
-            while( vlc_object_alive (p_demux) && (i_pos < i_data) )
-            {
-                i_pos++;
-                if( p_sys->buffer[i_pos] == 0x47 )
-                    break;
-            }
-            if( vlc_object_alive (p_demux) )
-                msg_Warn( p_demux, "sync found" );
+            const uint8_t *p_sync = memchr( &p_buffer[i_pos], 0x47,
+                                            i_data - i_pos );
+            if( p_sync == NULL )
+                break;
+            i_pos = p_sync - p_buffer;
+            msg_Warn( p_demux, "sync found" );
         }
 
         /* continuous when (one of this):
@@ -990,7 +1068,7 @@ static int DemuxFile( demux_t *p_demux )
         const bool b_adaptation = p_buffer[i_pos+3]&0x20;
 
         /* Get the PID */
-        ts_pid_t *p_pid = &p_sys->pid[ ((p_buffer[i_pos+1]&0x1f)<<8)|p_buffer[i_pos+2] ];
+        ts_pid_t *p_pid = GetPID( p_sys, ((p_buffer[i_pos+1]&0x1f)<<8)|p_buffer[i_pos+2] );
 
         /* Detect discontinuity indicator in adaptation field */
         if( b_adaptation && p_buffer[i_pos + 4] > 0 )
@@ -1081,7 +1159,7 @@ static int Demux( demux_t *p_demux )
         }
 
         /* Parse the TS packet */
-        ts_pid_t *p_pid = &p_sys->pid[PIDGet( p_pkt )];
+        ts_pid_t *p_pid = GetPID( p_sys, PIDGet( p_pkt ) );
 
         if( p_pid->b_valid )
         {
@@ -1356,7 +1434,7 @@ static int UserPmt( demux_t *p_demux, const char *psz_fmt )
         i_number = strtol( &psz[1], &psz, 0 );
 
     /* */
-    ts_pid_t *pmt = &p_sys->pid[i_pid];
+    ts_pid_t *pmt = GetPID( p_sys, i_pid );
     ts_prg_psi_t *prg;
 
     msg_Dbg( p_demux, "user pmt specified (pid=%d,number=%d)", i_pid, i_number );
@@ -1395,9 +1473,9 @@ static int UserPmt( demux_t *p_demux, const char *psz_fmt )
         {
             prg->i_pid_pcr = i_pid;
         }
-        else if( !p_sys->pid[i_pid].b_valid )
+        else if( !GetPID( p_sys, i_pid )->b_valid )
         {
-            ts_pid_t *pid = &p_sys->pid[i_pid];
+            ts_pid_t *pid = GetPID( p_sys, i_pid );
 
             char *psz_arg = strchr( psz_opt, '=' );
             if( psz_arg )
@@ -1500,11 +1578,11 @@ static void SetPrgFilter( demux_t *p_demux, int i_prg_id, bool b_selected )
         SetPIDFilter( p_demux, p_prg->i_pid_pcr, b_selected );
 
     /* All ES */
-    for( int i = 2; i < 8192; i++ )
+    for( int i = 0; i < p_sys->i_pids; i++ )
     {
-        ts_pid_t *pid = &p_sys->pid[i];
+        ts_pid_t *pid = PIDAt( p_sys, i );
 
-        if( !pid->b_valid || pid->psi )
+        if( pid->i_pid < 2 || !pid->b_valid || pid->psi )
             continue;
 
         for( int i_prg = 0; i_prg < pid->p_owner->i_prg; i_prg++ )
@@ -1512,7 +1590,7 @@ static void SetPrgFilter( demux_t *p_demux, int i_prg_id, bool b_selected )
             if( pid->p_owner->prg[i_prg]->i_pid_pmt == i_pmt_pid && pid->es->id )
             {
                 /* We only remove/select es that aren't defined by extra pmt */
-                SetPIDFilter( p_demux, i, b_selected );
+                SetPIDFilter( p_demux, pid->i_pid, b_selected );
                 break;
             }
         }
@@ -1883,15 +1961,7 @@ static block_t* ReadTSPacket( demux_t *p_demux )
                 return NULL;
             }
 
-            while( i_skip < i_peek - p_sys->i_packet_size )
-            {
-                if( p_peek[i_skip] == 0x47 &&
-                        p_peek[i_skip + p_sys->i_packet_size] == 0x47 )
-                {
-                    break;
-                }
-                i_skip++;
-            }
+            i_skip = FindSync( p_peek, i_peek, p_sys->i_packet_size );
             msg_Dbg( p_demux, "skipping %d bytes of garbage", i_skip );
             stream_Read( p_demux->s, NULL, i_skip );
 
@@ -2025,6 +2095,32 @@ static int Seek( demux_t *p_demux, double f_percent )
         i_head_pos = p_sys->p_pos[i-1];
         i_tail_pos = ( i < p_sys->i_pcrs_num ) ?  p_sys->p_pos[i] : stream_Size( p_demux->s );
     }
+
+    /* The PCR met before can be close enough, or narrow the search */
+    int i_lo = 0, i_hi = p_sys->i_index;
+    while( i_lo < i_hi )
+    {
+        int i_mid = ( i_lo + i_hi ) / 2;
+        if( p_sys->p_index[i_mid].i_pcr <= i_target_pcr )
+            i_lo = i_mid + 1;
+        else
+            i_hi = i_mid;
+    }
+    if( i_lo > 0 )
+    {
+        const ts_index_t *p_before = &p_sys->p_index[i_lo - 1];
+        if( i_target_pcr - p_before->i_pcr <= 45000 /* 500 ms */ &&
+            !SeekToPCR( p_demux, p_before->i_pos ) )
+        {
+            p_sys->i_current_pcr = AdjustPCRWrapAround( p_demux, p_sys->i_current_pcr );
+            msg_Dbg( p_demux, "Seek():found in the index at %"PRId64, p_before->i_pos );
+            return VLC_SUCCESS;
+        }
+        if( p_before->i_pos > i_head_pos )
+            i_head_pos = p_before->i_pos;
+    }
+    if( i_lo < p_sys->i_index && p_sys->p_index[i_lo].i_pos < i_tail_pos )
+        i_tail_pos = p_sys->p_index[i_lo].i_pos;
     msg_Dbg( p_demux, "Seek():i_head_pos:%"PRId64", i_tail_pos:%"PRId64, i_head_pos, i_tail_pos);
 
     bool b_found = false;
@@ -2170,6 +2266,172 @@ static void CheckPCR( demux_t *p_demux )
     p_sys->i_current_pcr = i_initial_pcr;
 }
 
+/* The seek index file: magic, file size, packet size, PCR pid, first and
+ * last PCR, how many of the CheckPCR() positions and of the samples follow,
+ * then each of those as PCR and position, all big endian. */
+#define TS_INDEX_MAGIC "VLCTSIX1"
+#define TS_INDEX_HEADER 48
+#define TS_INDEX_MAX (1 << 20)
+#define TS_INDEX_SPACING 90000 /* 1 s of PCR between samples at least */
+
+static void IndexOpen( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( !var_InheritBool( p_demux, "ts-seek-index" ) ||
+        p_sys->b_force_seek_per_percent )
+        return;
+
+    p_sys->psz_index = demux_IndexCachePath( p_demux, "ts-index" );
+}
+
+static bool IndexLoad( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    uint8_t p_head[TS_INDEX_HEADER], p_entry[16];
+    bool b_ok = false;
+
+    if( !p_sys->psz_index )
+        return false;
+
+    FILE *p_file = vlc_fopen( p_sys->psz_index, "rb" );
+    if( !p_file )
+        return false;
+
+    if( fread( p_head, sizeof( p_head ), 1, p_file ) != 1 ||
+        memcmp( p_head, TS_INDEX_MAGIC, 8 ) ||
+        GetQWBE( &p_head[8] ) != (uint64_t)stream_Size( p_demux->s ) ||
+        GetDWBE( &p_head[16] ) != (uint32_t)p_sys->i_packet_size ||
+        GetDWBE( &p_head[40] ) != (uint32_t)p_sys->i_pcrs_num ||
+        GetDWBE( &p_head[44] ) > TS_INDEX_MAX )
+        goto out;
+
+    for( int i = 0; i < p_sys->i_pcrs_num; i++ )
+    {
+        if( fread( p_entry, sizeof( p_entry ), 1, p_file ) != 1 )
+            goto out;
+        p_sys->p_pcrs[i] = GetQWBE( &p_entry[0] );
+        p_sys->p_pos[i] = GetQWBE( &p_entry[8] );
+    }
+
+    const int i_index = GetDWBE( &p_head[44] );
+    ts_index_t *p_index = malloc( __MAX( i_index, 1 ) * sizeof( *p_index ) );
+    if( !p_index )
+        goto out;
+    for( int i = 0; i < i_index; i++ )
+    {
+        if( fread( p_entry, sizeof( p_entry ), 1, p_file ) != 1 )
+        {
+            free( p_index );
+            goto out;
+        }
+        p_index[i].i_pcr = GetQWBE( &p_entry[0] );
+        p_index[i].i_pos = GetQWBE( &p_entry[8] );
+        /* Seek() looks them up by PCR and IndexAdd() by position */
+        if( i > 0 && ( p_index[i].i_pcr <= p_index[i-1].i_pcr ||
+                       p_index[i].i_pos <= p_index[i-1].i_pos ) )
+        {
+            free( p_index );
+            goto out;
+        }
+    }
+
+    p_sys->i_pid_ref_pcr = GetDWBE( &p_head[20] );
+    p_sys->i_first_pcr = GetQWBE( &p_head[24] );
+    p_sys->i_last_pcr = GetQWBE( &p_head[32] );
+    p_sys->i_current_pcr = p_sys->i_first_pcr;
+    p_sys->i_index = p_sys->i_index_max = i_index;
+    p_sys->p_index = p_index;
+    msg_Dbg( p_demux, "seek index loaded (%d PCR)", i_index );
+    b_ok = true;
+out:
+    fclose( p_file );
+    return b_ok;
+}
+
+static void IndexSave( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    uint8_t p_head[TS_INDEX_HEADER], p_entry[16];
+
+    if( !p_sys->psz_index || !p_sys->b_index_dirty ||
+        p_sys->i_first_pcr < 0 || p_sys->i_last_pcr < 0 ||
+        p_sys->b_force_seek_per_percent )
+        return;
+
+    FILE *p_file = demux_IndexCacheCreate( p_demux, p_sys->psz_index );
+    if( !p_file )
+        return;
+
+    memcpy( p_head, TS_INDEX_MAGIC, 8 );
+    SetQWBE( &p_head[8], stream_Size( p_demux->s ) );
+    SetDWBE( &p_head[16], p_sys->i_packet_size );
+    SetDWBE( &p_head[20], p_sys->i_pid_ref_pcr );
+    SetQWBE( &p_head[24], p_sys->i_first_pcr );
+    SetQWBE( &p_head[32], p_sys->i_last_pcr );
+    SetDWBE( &p_head[40], p_sys->i_pcrs_num );
+    SetDWBE( &p_head[44], p_sys->i_index );
+    bool b_ok = fwrite( p_head, sizeof( p_head ), 1, p_file ) == 1;
+
+    for( int i = 0; b_ok && i < p_sys->i_pcrs_num; i++ )
+    {
+        SetQWBE( &p_entry[0], p_sys->p_pcrs[i] );
+        SetQWBE( &p_entry[8], p_sys->p_pos[i] );
+        b_ok = fwrite( p_entry, sizeof( p_entry ), 1, p_file ) == 1;
+    }
+    for( int i = 0; b_ok && i < p_sys->i_index; i++ )
+    {
+        SetQWBE( &p_entry[0], p_sys->p_index[i].i_pcr );
+        SetQWBE( &p_entry[8], p_sys->p_index[i].i_pos );
+        b_ok = fwrite( p_entry, sizeof( p_entry ), 1, p_file ) == 1;
+    }
+
+    demux_IndexCacheClose( p_demux, p_sys->psz_index, p_file, b_ok );
+}
+
+static void IndexAdd( demux_t *p_demux, mtime_t i_pcr, int64_t i_pos )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    int i_lo = 0, i_hi = p_sys->i_index;
+    while( i_lo < i_hi )
+    {
+        int i_mid = ( i_lo + i_hi ) / 2;
+        if( p_sys->p_index[i_mid].i_pos < i_pos )
+            i_lo = i_mid + 1;
+        else
+            i_hi = i_mid;
+    }
+
+    /* A sample a second is plenty, and the PCR have to go up with the
+     * positions (this also drops the ones already there) */
+    if( i_lo > 0 && i_pcr - p_sys->p_index[i_lo - 1].i_pcr < TS_INDEX_SPACING )
+        return;
+    if( i_lo < p_sys->i_index &&
+        p_sys->p_index[i_lo].i_pcr - i_pcr < TS_INDEX_SPACING )
+        return;
+
+    if( p_sys->i_index == p_sys->i_index_max )
+    {
+        if( p_sys->i_index_max >= TS_INDEX_MAX )
+            return;
+        int i_max = p_sys->i_index_max ? 2 * p_sys->i_index_max : 256;
+        ts_index_t *p_index = realloc( p_sys->p_index,
+                                       i_max * sizeof( *p_index ) );
+        if( !p_index )
+            return;
+        p_sys->p_index = p_index;
+        p_sys->i_index_max = i_max;
+    }
+
+    memmove( &p_sys->p_index[i_lo + 1], &p_sys->p_index[i_lo],
+             ( p_sys->i_index - i_lo ) * sizeof( *p_sys->p_index ) );
+    p_sys->p_index[i_lo].i_pcr = i_pcr;
+    p_sys->p_index[i_lo].i_pos = i_pos;
+    p_sys->i_index++;
+    p_sys->b_index_dirty = true;
+}
+
 static void PCRHandle( demux_t *p_demux, ts_pid_t *pid, block_t *p_bk )
 {
     demux_sys_t   *p_sys = p_demux->p_sys;
@@ -2183,6 +2445,9 @@ static void PCRHandle( demux_t *p_demux, ts_pid_t *pid, block_t *p_bk )
         if( p_sys->i_pid_ref_pcr == pid->i_pid )
         {
             p_sys->i_current_pcr = AdjustPCRWrapAround( p_demux, i_pcr );
+            if( p_sys->psz_index )
+                IndexAdd( p_demux, p_sys->i_current_pcr,
+                          stream_Tell( p_demux->s ) - p_sys->i_packet_size );
         }
 
         /* Search program and set the PCR */
@@ -2901,7 +3166,7 @@ static void ValidateDVBMeta( demux_t *p_demux, int i_pid )
     for( int i = 0x11; i <= 0x14; i++ )
     {
         if( i == 0x13 ) continue;
-        ts_pid_t *p_pid = &p_sys->pid[i];
+        ts_pid_t *p_pid = GetPID( p_sys, i );
         if( p_pid->psi )
         {
             dvbpsi_DetachDemux( p_pid->psi->handle );
@@ -2928,7 +3193,7 @@ static char *EITConvertToUTF8( const unsigned char *psz_instring,
 static void SDTCallBack( demux_t *p_demux, dvbpsi_sdt_t *p_sdt )
 {
     demux_sys_t          *p_sys = p_demux->p_sys;
-    ts_pid_t             *sdt = &p_sys->pid[0x11];
+    ts_pid_t             *sdt = GetPID( p_sys, 0x11 );
     dvbpsi_sdt_service_t *p_srv;
 
     msg_Dbg( p_demux, "SDTCallBack called" );
@@ -3295,7 +3560,7 @@ static void PSINewTableCallBack( demux_t *p_demux, dvbpsi_handle h,
     msg_Dbg( p_demux, "PSINewTableCallBack: table 0x%x(%d) ext=0x%x(%d)",
              i_table_id, i_table_id, i_extension, i_extension );
 #endif
-    if( p_demux->p_sys->pid[0].psi->i_pat_version != -1 && i_table_id == 0x42 )
+    if( GetPID( p_demux->p_sys, 0 )->psi->i_pat_version != -1 && i_table_id == 0x42 )
     {
         msg_Dbg( p_demux, "PSINewTableCallBack: table 0x%x(%d) ext=0x%x(%d)",
                  i_table_id, i_table_id, i_extension, i_extension );
@@ -3303,7 +3568,7 @@ static void PSINewTableCallBack( demux_t *p_demux, dvbpsi_handle h,
         dvbpsi_AttachSDT( h, i_table_id, i_extension,
                           (dvbpsi_sdt_callback)SDTCallBack, p_demux );
     }
-    else if( p_demux->p_sys->pid[0x11].psi->i_sdt_version != -1 &&
+    else if( GetPID( p_demux->p_sys, 0x11 )->psi->i_sdt_version != -1 &&
              ( i_table_id == 0x4e || /* Current/Following */
                (i_table_id >= 0x50 && i_table_id <= 0x5f) ) ) /* Schedule */
     {
@@ -3316,7 +3581,7 @@ static void PSINewTableCallBack( demux_t *p_demux, dvbpsi_handle h,
         dvbpsi_AttachEIT( h, i_table_id, i_extension, cb, p_demux );
     }
 #ifdef TS_USE_TDT
-    else if( p_demux->p_sys->pid[0x11].psi->i_sdt_version != -1 &&
+    else if( GetPID( p_demux->p_sys, 0x11 )->psi->i_sdt_version != -1 &&
               i_table_id == 0x70 )  /* TDT */
     {
          msg_Dbg( p_demux, "PSINewTableCallBack: table 0x%x(%d) ext=0x%x(%d)",
@@ -4130,9 +4395,9 @@ static void PMTCallBack( demux_t *p_demux, dvbpsi_pmt_t *p_pmt )
     }
 
     /* Clean this program (remove all es) */
-    for( int i = 0; i < 8192; i++ )
+    for( int i = 0; i < p_sys->i_pids; i++ )
     {
-        ts_pid_t *pid = &p_sys->pid[i];
+        ts_pid_t *pid = PIDAt( p_sys, i );
 
         if( pid->b_valid && pid->p_owner == pmt->psi &&
             pid->i_owner_number == prg->i_number && pid->psi == NULL )
@@ -4204,7 +4469,7 @@ static void PMTCallBack( demux_t *p_demux, dvbpsi_pmt_t *p_pmt )
         /* Find out if the PID was already declared */
         for( int i = 0; i < i_clean; i++ )
         {
-            if( pp_clean[i] == &p_sys->pid[p_es->i_pid] )
+            if( pp_clean[i] == GetPID( p_sys, p_es->i_pid ) )
             {
                 old_pid = pp_clean[i];
                 break;
@@ -4212,7 +4477,7 @@ static void PMTCallBack( demux_t *p_demux, dvbpsi_pmt_t *p_pmt )
         }
         ValidateDVBMeta( p_demux, p_es->i_pid );
 
-        if( !old_pid && p_sys->pid[p_es->i_pid].b_valid )
+        if( !old_pid && GetPID( p_sys, p_es->i_pid )->b_valid )
         {
             msg_Warn( p_demux, "pmt error: pid=%d already defined",
                       p_es->i_pid );
@@ -4230,7 +4495,7 @@ static void PMTCallBack( demux_t *p_demux, dvbpsi_pmt_t *p_pmt )
         PIDFillFormat( pid, p_es->i_type );
         pid->i_owner_number = prg->i_number;
         pid->i_pid          = p_es->i_pid;
-        pid->b_seen         = p_sys->pid[p_es->i_pid].b_seen;
+        pid->b_seen         = GetPID( p_sys, p_es->i_pid )->b_seen;
 
         if( p_es->i_type == 0x10 || p_es->i_type == 0x11 ||
             p_es->i_type == 0x12 || p_es->i_type == 0x0f )
@@ -4332,7 +4597,7 @@ static void PMTCallBack( demux_t *p_demux, dvbpsi_pmt_t *p_pmt )
             PIDClean( p_demux, old_pid );
             TAB_REMOVE( i_clean, pp_clean, old_pid );
         }
-        p_sys->pid[p_es->i_pid] = *pid;
+        *GetPID( p_sys, p_es->i_pid ) = *pid;
 
         p_dr = PMTEsFindDescriptor( p_es, 0x09 );
         if( p_dr && p_dr->i_length >= 2 )
@@ -4373,7 +4638,7 @@ static void PATCallBack( demux_t *p_demux, dvbpsi_pat_t *p_pat )
 {
     demux_sys_t          *p_sys = p_demux->p_sys;
     dvbpsi_pat_program_t *p_program;
-    ts_pid_t             *pat = &p_sys->pid[0];
+    ts_pid_t             *pat = GetPID( p_sys, 0 );
 
     msg_Dbg( p_demux, "PATCallBack called" );
 
@@ -4427,11 +4692,11 @@ static void PATCallBack( demux_t *p_demux, dvbpsi_pat_t *p_pat )
         }
 
         /* Delete all ES attached to thoses PMT */
-        for( int i = 2; i < 8192; i++ )
+        for( int i = 0; i < p_sys->i_pids; i++ )
         {
-            ts_pid_t *pid = &p_sys->pid[i];
+            ts_pid_t *pid = PIDAt( p_sys, i );
 
-            if( !pid->b_valid || pid->psi )
+            if( pid->i_pid < 2 || !pid->b_valid || pid->psi )
                 continue;
 
             for( int j = 0; j < i_pmt_rm && pid->b_valid; j++ )
@@ -4443,7 +4708,7 @@ static void PATCallBack( demux_t *p_demux, dvbpsi_pat_t *p_pat )
                         continue;
 
                     if( pid->es->id )
-                        SetPIDFilter( p_demux, i, false );
+                        SetPIDFilter( p_demux, pid->i_pid, false );
 
                     PIDClean( p_demux, pid );
                     break;
@@ -4462,7 +4727,7 @@ static void PATCallBack( demux_t *p_demux, dvbpsi_pat_t *p_pat )
                 es_out_Control( p_demux->out, ES_OUT_DEL_GROUP, i_number );
             }
 
-            PIDClean( p_demux, &p_sys->pid[pmt_rm[i]->i_pid] );
+            PIDClean( p_demux, GetPID( p_sys, pmt_rm[i]->i_pid ) );
             TAB_REMOVE( p_sys->i_pmt, p_sys->pmt, pmt_rm[i] );
         }
 
@@ -4477,7 +4742,7 @@ static void PATCallBack( demux_t *p_demux, dvbpsi_pat_t *p_pat )
                  p_program->i_pid );
         if( p_program->i_number != 0 )
         {
-            ts_pid_t *pmt = &p_sys->pid[p_program->i_pid];
+            ts_pid_t *pmt = GetPID( p_sys, p_program->i_pid );
             bool b_add = true;
 
             ValidateDVBMeta( p_demux, p_program->i_pid );
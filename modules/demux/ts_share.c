@@ -0,0 +1,518 @@
+/*****************************************************************************
+ * ts_share.c: one TS demux shared by the inputs playing programs of a mux
+ *****************************************************************************
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ ****************************************************************************/
+
+/* Every input opening the same mux through this module gets its program
+ * out of a single access and a single ts demux:
+ *
+ *   mpts://udp://@239.0.0.1:1234 :mpts-program=1002
+ *
+ * The first one opens the mux, the last one closes it. The ts demux runs
+ * in its own thread and writes to an es_out of ours, which hands every ES
+ * to the inputs wanting its program (the group of the ES). */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_demux.h>
+
+#define PROGRAM_TEXT N_("Program")
+#define PROGRAM_LONGTEXT N_( \
+    "Number of the program to play out of the mux, 0 for all of them.")
+
+static int  Open (vlc_object_t *);
+static void Close (vlc_object_t *);
+
+vlc_module_begin ()
+    set_shortname (N_("Shared TS"))
+    set_description (N_("MPEG-TS demux shared between inputs"))
+    set_category (CAT_INPUT)
+    set_subcategory (SUBCAT_INPUT_DEMUX)
+    set_capability ("access_demux", 0)
+    add_shortcut ("mpts")
+    set_callbacks (Open, Close)
+
+    add_integer_with_range ("mpts-program", 0, 0, 65535,
+                            PROGRAM_TEXT, PROGRAM_LONGTEXT, false)
+        change_safe ()
+vlc_module_end ()
+
+/* How much of the mux is read at once (56 TS packets) */
+#define TS_SHARE_READ (56 * 188)
+
+typedef struct ts_share_t ts_share_t;
+
+struct demux_sys_t
+{
+    ts_share_t *share;
+    int         program; /* 0 for all */
+};
+
+typedef struct
+{
+    demux_t     *demux;
+    es_out_id_t *id;
+} ts_share_route_t;
+
+/* An ES of the mux, and its copies in the inputs playing its program */
+struct es_out_id_t
+{
+    es_format_t       fmt;
+    unsigned          routec;
+    ts_share_route_t *routev;
+};
+
+struct ts_share_t
+{
+    ts_share_t   *next;
+    char         *url;
+    unsigned      refs;
+
+    vlc_object_t *parent;  /* holds the mux while inputs come and go */
+    stream_t     *source;
+    stream_t     *demux;   /* the ts demux, fed from source */
+    es_out_t      out;
+    vlc_thread_t  thread;
+
+    vlc_mutex_t   lock;    /* protects the inputs and ES below */
+    int           demuxc;
+    demux_t     **demuxv;
+    int           esc;
+    es_out_id_t **esv;
+};
+
+static vlc_mutex_t share_lock = VLC_STATIC_MUTEX;
+static ts_share_t *share_list = NULL;
+
+static bool Wants (demux_t *demux, int group)
+{
+    int program = demux->p_sys->program;
+    return program == 0 || program == group;
+}
+
+/* Shared lock held */
+static void AddRoute (es_out_id_t *es, demux_t *demux)
+{
+    es_out_id_t *id = es_out_Add (demux->out, &es->fmt);
+    if (id == NULL)
+        return;
+
+    ts_share_route_t *routev = realloc (es->routev,
+                                        (es->routec + 1) * sizeof (*routev));
+    if (unlikely(routev == NULL))
+    {
+        es_out_Del (demux->out, id);
+        return;
+    }
+    routev[es->routec].demux = demux;
+    routev[es->routec].id = id;
+    es->routev = routev;
+    es->routec++;
+}
+
+/* Shared lock held */
+static void DelRoute (es_out_id_t *es, demux_t *demux)
+{
+    for (unsigned i = 0; i < es->routec; i++)
+        if (es->routev[i].demux == demux)
+        {
+            es_out_Del (demux->out, es->routev[i].id);
+            es->routev[i] = es->routev[--es->routec];
+            break;
+        }
+}
+
+static es_out_id_t *EsOutAdd (es_out_t *out, const es_format_t *fmt)
+{
+    ts_share_t *share = (ts_share_t *)out->p_sys;
+    es_out_id_t *es = malloc (sizeof (*es));
+    if (unlikely(es == NULL))
+        return NULL;
+
+    es_format_Copy (&es->fmt, fmt);
+    es->routec = 0;
+    es->routev = NULL;
+
+    vlc_mutex_lock (&share->lock);
+    TAB_APPEND (share->esc, share->esv, es);
+    for (int i = 0; i < share->demuxc; i++)
+        if (Wants (share->demuxv[i], fmt->i_group))
+            AddRoute (es, share->demuxv[i]);
+    vlc_mutex_unlock (&share->lock);
+    return es;
+}
+
+static int EsOutSend (es_out_t *out, es_out_id_t *es, block_t *block)
+{
+    ts_share_t *share = (ts_share_t *)out->p_sys;
+
+    vlc_mutex_lock (&share->lock);
+    if (es->routec == 0)
+        block_Release (block);
+    for (unsigned i = 0; i < es->routec; i++)
+    {
+        /* the last input takes the original */
+        block_t *copy = (i + 1 < es->routec) ? block_Duplicate (block)
+                                             : block;
+        if (likely(copy != NULL))
+            es_out_Send (es->routev[i].demux->out, es->routev[i].id, copy);
+    }
+    vlc_mutex_unlock (&share->lock);
+    return VLC_SUCCESS;
+}
+
+static void EsOutDel (es_out_t *out, es_out_id_t *es)
+{
+    ts_share_t *share = (ts_share_t *)out->p_sys;
+
+    vlc_mutex_lock (&share->lock);
+    TAB_REMOVE (share->esc, share->esv, es);
+    for (unsigned i = 0; i < es->routec; i++)
+        es_out_Del (es->routev[i].demux->out, es->routev[i].id);
+    vlc_mutex_unlock (&share->lock);
+
+    es_format_Clean (&es->fmt);
+    free (es->routev);
+    free (es);
+}
+
+static int EsOutControl (es_out_t *out, int query, va_list args)
+{
+    ts_share_t *share = (ts_share_t *)out->p_sys;
+    int ret = VLC_SUCCESS;
+
+    vlc_mutex_lock (&share->lock);
+    switch (query)
+    {
+        /* Which ES are decoded is up to every input */
+        case ES_OUT_SET_ES:
+        case ES_OUT_SET_ES_DEFAULT:
+        case ES_OUT_SET_ES_STATE:
+        case ES_OUT_SET_GROUP:
+            break;
+
+        case ES_OUT_GET_ES_STATE:
+        {
+            es_out_id_t *es = va_arg (args, es_out_id_t *);
+            bool *selected = va_arg (args, bool *);
+            *selected = es->routec > 0;
+            break;
+        }
+
+        case ES_OUT_RESTART_ES:
+        {
+            es_out_id_t *es = va_arg (args, es_out_id_t *);
+            for (unsigned i = 0; i < es->routec; i++)
+                es_out_Control (es->routev[i].demux->out, query,
+                                es->routev[i].id);
+            break;
+        }
+
+        case ES_OUT_SET_ES_FMT:
+        {
+            es_out_id_t *es = va_arg (args, es_out_id_t *);
+            es_format_t *fmt = va_arg (args, es_format_t *);
+            es_format_Clean (&es->fmt);
+            es_format_Copy (&es->fmt, fmt);
+            for (unsigned i = 0; i < es->routec; i++)
+                es_out_Control (es->routev[i].demux->out, query,
+                                es->routev[i].id, fmt);
+            break;
+        }
+
+        case ES_OUT_SET_ES_SCRAMBLED_STATE:
+        {
+            es_out_id_t *es = va_arg (args, es_out_id_t *);
+            int scrambled = va_arg (args, int);
+            for (unsigned i = 0; i < es->routec; i++)
+                es_out_Control (es->routev[i].demux->out, query,
+                                es->routev[i].id, scrambled);
+            break;
+        }
+
+        case ES_OUT_SET_GROUP_PCR:
+        {
+            int group = va_arg (args, int);
+            int64_t pcr = va_arg (args, int64_t);
+            for (int i = 0; i < share->demuxc; i++)
+                if (Wants (share->demuxv[i], group))
+                    es_out_Control (share->demuxv[i]->out, query, group, pcr);
+            break;
+        }
+
+        case ES_OUT_SET_GROUP_META:
+        case ES_OUT_SET_GROUP_EPG:
+        {
+            int group = va_arg (args, int);
+            const void *data = va_arg (args, const void *);
+            for (int i = 0; i < share->demuxc; i++)
+                if (Wants (share->demuxv[i], group))
+                    es_out_Control (share->demuxv[i]->out, query, group,
+                                    data);
+            break;
+        }
+
+        case ES_OUT_DEL_GROUP:
+        {
+            int group = va_arg (args, int);
+            for (int i = 0; i < share->demuxc; i++)
+                if (Wants (share->demuxv[i], group))
+                    es_out_Control (share->demuxv[i]->out, query, group);
+            break;
+        }
+
+        case ES_OUT_SET_PCR:
+        case ES_OUT_SET_NEXT_DISPLAY_TIME:
+        {
+            int64_t date = va_arg (args, int64_t);
+            for (int i = 0; i < share->demuxc; i++)
+                es_out_Control (share->demuxv[i]->out, query, date);
+            break;
+        }
+
+        case ES_OUT_RESET_PCR:
+            for (int i = 0; i < share->demuxc; i++)
+                es_out_Control (share->demuxv[i]->out, query);
+            break;
+
+        case ES_OUT_SET_META:
+        {
+            const vlc_meta_t *meta = va_arg (args, const vlc_meta_t *);
+            for (int i = 0; i < share->demuxc; i++)
+                es_out_Control (share->demuxv[i]->out, query, meta);
+            break;
+        }
+
+        case ES_OUT_GET_EMPTY:
+            *va_arg (args, bool *) = true;
+            break;
+
+        default:
+            ret = VLC_EGENERIC;
+    }
+    vlc_mutex_unlock (&share->lock);
+    return ret;
+}
+
+static void EsOutDestroy (es_out_t *out)
+{
+    (void) out;
+}
+
+static void *Thread (void *data)
+{
+    ts_share_t *share = data;
+    block_t *block;
+
+    while ((block = stream_Block (share->source, TS_SHARE_READ)) != NULL)
+        stream_DemuxSend (share->demux, block);
+    msg_Dbg (share->parent, "end of %s", share->url);
+    return NULL;
+}
+
+static void Kill (vlc_object_t *obj)
+{
+    vlc_object_kill (obj);
+
+    vlc_list_t *list = vlc_list_children (obj);
+    for (int i = 0; i < list->i_count; i++)
+        Kill (list->p_values[i].p_object);
+    vlc_list_release (list);
+}
+
+static void Delete (ts_share_t *share)
+{
+    if (share->demux != NULL)
+        stream_Delete (share->demux);
+    if (share->source != NULL)
+        stream_Delete (share->source);
+    if (share->parent != NULL)
+        vlc_object_release (share->parent);
+    for (int i = 0; i < share->esc; i++)
+    {
+        es_format_Clean (&share->esv[i]->fmt);
+        free (share->esv[i]->routev);
+        free (share->esv[i]);
+    }
+    TAB_CLEAN (share->esc, share->esv);
+    TAB_CLEAN (share->demuxc, share->demuxv);
+    vlc_mutex_destroy (&share->lock);
+    free (share->url);
+    free (share);
+}
+
+static ts_share_t *New (demux_t *demux, const char *url)
+{
+    ts_share_t *share = calloc (1, sizeof (*share));
+    if (unlikely(share == NULL))
+        return NULL;
+
+    share->url = strdup (url);
+    share->refs = 1;
+    share->out.pf_add = EsOutAdd;
+    share->out.pf_send = EsOutSend;
+    share->out.pf_del = EsOutDel;
+    share->out.pf_control = EsOutControl;
+    share->out.pf_destroy = EsOutDestroy;
+    share->out.p_sys = (es_out_sys_t *)share;
+    vlc_mutex_init (&share->lock);
+    TAB_INIT (share->demuxc, share->demuxv);
+    TAB_INIT (share->esc, share->esv);
+
+    /* The mux outlives the input opening it, its objects hang under
+     * libvlc. stream_DemuxNew() only wants an object and no input. */
+    share->parent = vlc_object_create (demux->p_libvlc, sizeof (demux_t));
+    if (unlikely(share->url == NULL || share->parent == NULL))
+        goto error;
+
+    share->source = stream_UrlNew (share->parent, url);
+    if (share->source == NULL)
+        goto error;
+
+    share->demux = stream_DemuxNew ((demux_t *)share->parent, "ts",
+                                    &share->out);
+    if (share->demux == NULL)
+        goto error;
+
+    if (vlc_clone (&share->thread, Thread, share, VLC_THREAD_PRIORITY_INPUT))
+        goto error;
+
+    msg_Dbg (demux, "opened shared mux %s", url);
+    return share;
+
+error:
+    Delete (share);
+    return NULL;
+}
+
+static void Release (ts_share_t *share)
+{
+    vlc_mutex_lock (&share_lock);
+    bool last = --share->refs == 0;
+    if (last)
+        for (ts_share_t **pp = &share_list; *pp != NULL; pp = &(*pp)->next)
+            if (*pp == share)
+            {
+                *pp = share->next;
+                break;
+            }
+    vlc_mutex_unlock (&share_lock);
+
+    if (!last)
+        return;
+
+    Kill (VLC_OBJECT(share->parent));
+    vlc_join (share->thread, NULL);
+    Delete (share);
+}
+
+static int Control (demux_t *demux, int query, va_list args)
+{
+    switch (query)
+    {
+        case DEMUX_GET_PTS_DELAY:
+        {
+            int64_t *v = va_arg (args, int64_t *);
+            *v = INT64_C(1000) * var_InheritInteger (demux, "network-caching");
+            return VLC_SUCCESS;
+        }
+
+        case DEMUX_CAN_PAUSE:
+        case DEMUX_CAN_CONTROL_PACE:
+        case DEMUX_CAN_CONTROL_RATE:
+        case DEMUX_CAN_SEEK:
+        {
+            bool *v = (bool *)va_arg (args, bool *);
+            *v = false;
+            return VLC_SUCCESS;
+        }
+    }
+    return VLC_EGENERIC;
+}
+
+static int Open (vlc_object_t *obj)
+{
+    demux_t *demux = (demux_t *)obj;
+
+    if (demux->psz_location == NULL || *demux->psz_location == '\0')
+        return VLC_EGENERIC;
+
+    demux_sys_t *sys = malloc (sizeof (*sys));
+    if (unlikely(sys == NULL))
+        return VLC_ENOMEM;
+    sys->program = var_InheritInteger (demux, "mpts-program");
+    demux->p_sys = sys;
+
+    vlc_mutex_lock (&share_lock);
+    ts_share_t *share;
+    for (share = share_list; share != NULL; share = share->next)
+        if (!strcmp (share->url, demux->psz_location))
+            break;
+    if (share != NULL)
+        share->refs++;
+    else
+    {
+        /* under the lock, or a second input could open the mux again */
+        share = New (demux, demux->psz_location);
+        if (share != NULL)
+        {
+            share->next = share_list;
+            share_list = share;
+        }
+    }
+    vlc_mutex_unlock (&share_lock);
+
+    if (share == NULL)
+    {
+        free (sys);
+        return VLC_EGENERIC;
+    }
+    sys->share = share;
+
+    /* Take the ES of our program the mux has already */
+    vlc_mutex_lock (&share->lock);
+    TAB_APPEND (share->demuxc, share->demuxv, demux);
+    for (int i = 0; i < share->esc; i++)
+        if (Wants (demux, share->esv[i]->fmt.i_group))
+            AddRoute (share->esv[i], demux);
+    vlc_mutex_unlock (&share->lock);
+
+    msg_Dbg (demux, "playing program %d of %s", sys->program,
+             demux->psz_location);
+    demux->pf_demux = NULL;
+    demux->pf_control = Control;
+    return VLC_SUCCESS;
+}
+
+static void Close (vlc_object_t *obj)
+{
+    demux_t *demux = (demux_t *)obj;
+    demux_sys_t *sys = demux->p_sys;
+    ts_share_t *share = sys->share;
+
+    vlc_mutex_lock (&share->lock);
+    TAB_REMOVE (share->demuxc, share->demuxv, demux);
+    for (int i = 0; i < share->esc; i++)
+        DelRoute (share->esv[i], demux);
+    vlc_mutex_unlock (&share->lock);
+
+    Release (share);
+    free (sys);
+}
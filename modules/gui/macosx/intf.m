@@ -585,6 +585,7 @@ static VLCMain *_o_sharedMainInstance = nil;
     var_AddCallback(p_playlist, "activity", PLItemChanged, self);
     var_AddCallback(p_playlist, "leaf-to-parent", PlaylistUpdated, self);
     var_AddCallback(p_playlist, "playlist-item-append", PlaylistUpdated, self);
+    var_AddCallback(p_playlist, "playlist-items-append", PlaylistUpdated, self);
     var_AddCallback(p_playlist, "playlist-item-deleted", PlaylistUpdated, self);
     var_AddCallback(p_playlist, "random", PlaybackModeUpdated, self);
     var_AddCallback(p_playlist, "repeat", PlaybackModeUpdated, self);
@@ -759,6 +760,7 @@ static VLCMain *_o_sharedMainInstance = nil;
     var_DelCallback(p_playlist, "activity", PLItemChanged, self);
     var_DelCallback(p_playlist, "leaf-to-parent", PlaylistUpdated, self);
     var_DelCallback(p_playlist, "playlist-item-append", PlaylistUpdated, self);
+    var_DelCallback(p_playlist, "playlist-items-append", PlaylistUpdated, self);
     var_DelCallback(p_playlist, "playlist-item-deleted", PlaylistUpdated, self);
     var_DelCallback(p_playlist, "random", PlaybackModeUpdated, self);
     var_DelCallback(p_playlist, "repeat", PlaybackModeUpdated, self);
@@ -1777,6 +1777,7 @@ static void Run(intf_thread_t *intf)
     var_AddCallback(p_playlist, "intf-change", PlaylistChanged, intf);
     var_AddCallback(p_playlist, "item-change", ItemChanged, intf);
     var_AddCallback(p_playlist, "playlist-item-append", PlaylistChanged, intf);
+    var_AddCallback(p_playlist, "playlist-items-append", PlaylistChanged, intf);
 
     while (vlc_object_alive(intf) && !sys->exit) {
         UpdateInput(sys, p_playlist);
@@ -1787,6 +1788,7 @@ static void Run(intf_thread_t *intf)
     var_DelCallback(p_playlist, "intf-change", PlaylistChanged, intf);
     var_DelCallback(p_playlist, "item-change", ItemChanged, intf);
     var_DelCallback(p_playlist, "playlist-item-append", PlaylistChanged, intf);
+    var_DelCallback(p_playlist, "playlist-items-append", PlaylistChanged, intf);
     vlc_restorecancel(canc);
 }
 
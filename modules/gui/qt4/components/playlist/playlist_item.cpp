@@ -49,6 +49,7 @@ void PLItem::init( playlist_item_t *_playlist_item, PLItem *parent )
     parentItem = parent;          /* Can be NULL, but only for the rootItem */
     i_id       = _playlist_item->i_id;           /* Playlist item specific id */
     p_input    = _playlist_item->p_input;
+    i_fetched  = 0;
     vlc_gc_incref( p_input );
 }
 
@@ -93,6 +94,7 @@ void PLItem::removeChildren()
 {
     qDeleteAll( children );
     children.clear();
+    i_fetched = 0;
 }
 
 void PLItem::takeChildAt( int index )
@@ -58,6 +58,7 @@ protected:
     PLItem *parentItem;
     int i_id;
     input_item_t *p_input;
+    int i_fetched; /* core children looked at so far, see PLModel::fetchMore */
 
 private:
     PLItem( playlist_item_t * );
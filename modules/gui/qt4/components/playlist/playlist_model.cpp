@@ -48,6 +48,7 @@
 #include <QDesktopServices>
 #include <QInputDialog>
 #include <QSignalMapper>
+#include <QSet>
 
 #define I_NEW_DIR \
     I_DIR_OR_FOLDER( N_("Create Directory"), N_( "Create Folder" ) )
@@ -55,6 +56,9 @@
     I_DIR_OR_FOLDER( N_( "Enter name for new directory:" ), \
                      N_( "Enter name for new folder:" ) )
 
+/* Rows created at once when populating a node, see PLModel::fetchMore() */
+#define FETCH_COUNT 256
+
 QIcon PLModel::icons[ITEM_TYPE_NUMBER];
 
 /*************************************************************************
@@ -98,6 +102,8 @@ PLModel::PLModel( playlist_t *_p_playlist,  /* THEPL */
               this, processInputItemUpdate( input_thread_t* ) );
     CONNECT( THEMIM, playlistItemAppended( int, int ),
              this, processItemAppend( int, int ) );
+    CONNECT( THEMIM, playlistItemsAppended( int, int, int ),
+             this, processItemsAppend( int, int, int ) );
     CONNECT( THEMIM, playlistItemRemoved( int ),
              this, processItemRemoval( int ) );
 }
@@ -512,6 +518,47 @@ int PLModel::rowCount( const QModelIndex &parent ) const
     return parentItem->childCount();
 }
 
+/* The model only holds the rows the views asked for so far: nodes get their
+ * children FETCH_COUNT at a time, when expanded or scrolled to. */
+bool PLModel::hasChildren( const QModelIndex &parent ) const
+{
+    const PLItem *parentItem = parent.isValid() ? getItem( parent ) : rootItem;
+    return parentItem->childCount() > 0 || canFetchMore( parent );
+}
+
+bool PLModel::canFetchMore( const QModelIndex &parent ) const
+{
+    const PLItem *parentItem = parent.isValid() ? getItem( parent ) : rootItem;
+
+    PL_LOCK;
+    playlist_item_t *p_node = playlist_ItemGetById( p_playlist,
+                                                    parentItem->i_id );
+    bool b_more = p_node && p_node->i_children > parentItem->i_fetched;
+    PL_UNLOCK;
+    return b_more;
+}
+
+void PLModel::fetchMore( const QModelIndex &parent )
+{
+    PLItem *parentItem = parent.isValid() ? getItem( parent ) : rootItem;
+    QList<PLItem*> items;
+
+    PL_LOCK;
+    playlist_item_t *p_node = playlist_ItemGetById( p_playlist,
+                                                    parentItem->i_id );
+    if( p_node )
+        items = fetchChildren( p_node, parentItem );
+    PL_UNLOCK;
+
+    if( items.isEmpty() ) return;
+
+    int i_pos = parentItem->childCount();
+    beginInsertRows( parent, i_pos, i_pos + items.count() - 1 );
+    foreach( PLItem *item, items )
+        parentItem->appendChild( item );
+    endInsertRows();
+}
+
 QStringList PLModel::selectedURIs()
 {
     QStringList lst;
@@ -543,6 +590,49 @@ PLItem *PLModel::findById( PLItem *root, int i_id ) const
     return findInner( root, i_id, false );
 }
 
+PLItem *PLModel::findChild( PLItem *node, int i_id, int i_from ) const
+{
+    for( int i = i_from; i < node->childCount(); i++ )
+        if( node->children[i]->i_id == i_id )
+            return node->children[i];
+    return NULL;
+}
+
+/* Fetches the nodes leading to an item, so that it has an index.
+ * Must be entered WITHOUT the playlist lock */
+PLItem *PLModel::fetchItem( int i_id )
+{
+    PLItem *item = findById( rootItem, i_id );
+    if( item ) return item;
+
+    /* Path from the root item */
+    QList<int> path;
+    PL_LOCK;
+    playlist_item_t *p_item = playlist_ItemGetById( p_playlist, i_id );
+    for( ; p_item && p_item->i_id != rootItem->id(); p_item = p_item->p_parent )
+        path.prepend( p_item->i_id );
+    bool b_below = p_item != NULL;
+    PL_UNLOCK;
+    if( !b_below ) return NULL;
+
+    item = rootItem;
+    foreach( int i_child, path )
+    {
+        QModelIndex parent = index( item, 0 );
+        int i_from = 0;
+        PLItem *child;
+
+        while( !( child = findChild( item, i_child, i_from ) ) )
+        {
+            if( !canFetchMore( parent ) ) return NULL;
+            i_from = item->childCount();
+            fetchMore( parent );
+        }
+        item = child;
+    }
+    return item;
+}
+
 PLItem *PLModel::findByInput( PLItem *root, int i_id ) const
 {
     PLItem *result = findInner( root, i_id, true );
@@ -599,7 +689,15 @@ void PLModel::processInputItemUpdate( input_thread_t *p_input )
     if( !p_input ) return;
     if( p_input && !( p_input->b_dead || !vlc_object_alive( p_input ) ) )
     {
-        PLItem *item = findByInput( rootItem, input_GetItem( p_input )->i_id );
+        /* The current item may not have been fetched yet */
+        PL_LOCK;
+        playlist_item_t *p_current = playlist_CurrentPlayingItem( p_playlist );
+        int i_current = p_current ? p_current->i_id : -1;
+        PL_UNLOCK;
+
+        PLItem *item = i_current != -1 ? fetchItem( i_current ) : NULL;
+        if( !item )
+            item = findByInput( rootItem, input_GetItem( p_input )->i_id );
         if( item ) emit currentIndexChanged( index( item, 0 ) );
     }
     processInputItemUpdate( input_GetItem( p_input ) );
@@ -644,9 +742,18 @@ void PLModel::processItemAppend( int i_item, int i_parent )
     for( pos = p_item->p_parent->i_children - 1; pos >= 0; pos-- )
         if( p_item->p_parent->pp_children[pos] == p_item ) break;
 
+    /* Not fetched yet: it will be with the rest, when needed */
+    if( pos < 0 || pos >= nodeParentItem->i_fetched )
+    {
+        PL_UNLOCK; return;
+    }
+
     newItem = new PLItem( p_item, nodeParentItem );
     PL_UNLOCK;
 
+    pos = qMin( pos, nodeParentItem->childCount() );
+    nodeParentItem->i_fetched++;
+
     /* We insert the newItem (children) inside the parent */
     beginInsertRows( index( nodeParentItem, 0 ), pos, pos );
     nodeParentItem->insertChild( newItem, pos );
@@ -659,6 +766,74 @@ void PLModel::processItemAppend( int i_item, int i_parent )
     search( latestSearch, index( rootItem, 0), false /*FIXME*/ );
 }
 
+void PLModel::processItemsAppend( int i_first, int i_count, int i_parent )
+{
+    /* Find the Parent */
+    PLItem *nodeParentItem = findById( rootItem, i_parent );
+    if( !nodeParentItem ) return;
+
+    /* Already known items, if the model was rebuilt in between */
+    QSet<int> known;
+    foreach( const PLItem *existing, nodeParentItem->children )
+        known.insert( existing->i_id );
+    if( known.contains( i_first ) ) return; /* fetched in the meantime */
+
+    QList<PLItem*> newItems;
+    int pos = -1;
+    bool b_later = false;
+
+    /* Find the children: they follow each other unless the playlist changed
+     * since, in which case the rest is handled one item at a time */
+    PL_LOCK;
+    playlist_item_t *p_item = playlist_ItemGetById( p_playlist, i_first );
+    if( p_item && p_item->p_parent && p_item->p_parent->i_id == i_parent )
+    {
+        playlist_item_t *p_node = p_item->p_parent;
+
+        for( pos = p_node->i_children - 1; pos >= 0; pos-- )
+            if( p_node->pp_children[pos] == p_item ) break;
+
+        /* Not fetched yet: they will be with the rest, when needed */
+        b_later = pos >= nodeParentItem->i_fetched;
+
+        for( int i = pos; !b_later && i >= 0 && i < p_node->i_children
+                       && newItems.count() < i_count; i++ )
+        {
+            p_item = p_node->pp_children[i];
+            if( p_item->i_id != i_first + newItems.count()
+             || p_item->i_flags & PLAYLIST_DBL_FLAG
+             || known.contains( p_item->i_id ) )
+                break;
+            newItems.append( new PLItem( p_item, nodeParentItem ) );
+        }
+    }
+    PL_UNLOCK;
+    if( b_later ) return;
+
+    if( !newItems.isEmpty() )
+    {
+        pos = qMin( pos, nodeParentItem->childCount() );
+        nodeParentItem->i_fetched += newItems.count();
+
+        /* We insert the new items (children) inside the parent, at once */
+        beginInsertRows( index( nodeParentItem, 0 ),
+                         pos, pos + newItems.count() - 1 );
+        for( int i = 0; i < newItems.count(); i++ )
+            nodeParentItem->insertChild( newItems[i], pos + i );
+        endInsertRows();
+
+        foreach( PLItem *newItem, newItems )
+            if( newItem->inputItem() == THEMIM->currentInputItem() )
+                emit currentIndexChanged( index( newItem, 0 ) );
+    }
+
+    for( int i = newItems.count(); i < i_count; i++ )
+        processItemAppend( i_first + i, i_parent );
+
+    if( newItems.isEmpty() || latestSearch.isEmpty() ) return;
+    search( latestSearch, index( rootItem, 0), false /*FIXME*/ );
+}
+
 void PLModel::rebuild( playlist_item_t *p_root )
 {
     /* Invalidate cache */
@@ -692,6 +867,7 @@ void PLModel::takeItem( PLItem *item )
 
     beginRemoveRows( index( parent, 0 ), i_index, i_index );
     parent->takeChildAt( i_index );
+    parent->i_fetched--;
     endRemoveRows();
 }
 
@@ -707,6 +883,7 @@ void PLModel::insertChildren( PLItem *node, QList<PLItem*>& items, int i_pos )
         node->children.insert( i_pos + i, items[i] );
         items[i]->parentItem = node;
     }
+    node->i_fetched += count;
     endInsertRows();
 }
 
@@ -721,6 +898,7 @@ void PLModel::removeItem( PLItem *item )
         int i = item->parent()->children.indexOf( item );
         beginRemoveRows( index( item->parent(), 0), i, i );
         item->parent()->children.removeAt(i);
+        item->parent()->i_fetched--;
         delete item;
         endRemoveRows();
     }
@@ -737,20 +915,40 @@ void PLModel::removeItem( PLItem *item )
 void PLModel::updateChildren( PLItem *root )
 {
     playlist_item_t *p_node = playlist_ItemGetById( p_playlist, root->id() );
-    updateChildren( p_node, root );
+    if( p_node )
+        updateChildren( p_node, root );
 }
 
-/* This function must be entered WITH the playlist lock */
+/* This function must be entered WITH the playlist lock.
+ * Only the first children are created, the others are fetched when needed */
 void PLModel::updateChildren( playlist_item_t *p_node, PLItem *root )
 {
-    for( int i = 0; i < p_node->i_children ; i++ )
-    {
-        if( p_node->pp_children[i]->i_flags & PLAYLIST_DBL_FLAG ) continue;
-        PLItem *newItem =  new PLItem( p_node->pp_children[i], root );
+    foreach( PLItem *newItem, fetchChildren( p_node, root ) )
         root->appendChild( newItem );
-        if( p_node->pp_children[i]->i_children != -1 )
-            updateChildren( p_node->pp_children[i], newItem );
+}
+
+/* Creates the items for the next children of p_node, FETCH_COUNT at most,
+ * without adding them to root.
+ * This function must be entered WITH the playlist lock */
+QList<PLItem*> PLModel::fetchChildren( playlist_item_t *p_node, PLItem *root )
+{
+    QList<PLItem*> items;
+    QSet<int> known;
+
+    /* Children added before the fetched ones shift those */
+    root->i_fetched = qMax( root->i_fetched, 0 );
+    foreach( const PLItem *child, root->children )
+        known.insert( child->i_id );
+
+    while( root->i_fetched < p_node->i_children && items.count() < FETCH_COUNT )
+    {
+        playlist_item_t *p_child = p_node->pp_children[root->i_fetched++];
+
+        if( p_child->i_flags & PLAYLIST_DBL_FLAG ) continue;
+        if( known.contains( p_child->i_id ) ) continue;
+        items.append( new PLItem( p_child, root ) );
     }
+    return items;
 }
 
 /* Function doesn't need playlist-lock, as we don't touch playlist_item_t stuff here*/
@@ -838,18 +1036,15 @@ void PLModel::sort( const int i_root_id, const int column, Qt::SortOrder order )
     }
 
     i_cached_id = i_cached_input_id = -1;
-
-    if( count )
-    {
-        beginInsertRows( qIndex, 0, count - 1 );
-        updateChildren( item );
-        endInsertRows( );
-    }
     PL_UNLOCK;
+
+    item->i_fetched = 0;
+    fetchMore( qIndex );
+
     /* if we have popup item, try to make sure that you keep that item visible */
     if( i_popup_item > -1 )
     {
-        PLItem *popupitem = findById( rootItem, i_popup_item );
+        PLItem *popupitem = fetchItem( i_popup_item );
         if( popupitem ) emit currentIndexChanged( index( popupitem, 0 ) );
         /* reset i_popup_item as we don't show it as selected anymore anyway */
         i_popup_item = -1;
@@ -873,15 +1068,17 @@ void PLModel::search( const QString& search_text, const QModelIndex & idx, bool
         {
             PLItem *searchRoot = getItem( idx );
 
-            beginRemoveRows( idx, 0, searchRoot->childCount() - 1 );
-            searchRoot->removeChildren();
-            endRemoveRows();
-
-            beginInsertRows( idx, 0, searchRoot->childCount() - 1 );
-            updateChildren( searchRoot ); // The PL_LOCK is needed here
-            endInsertRows();
-
             PL_UNLOCK;
+
+            if( searchRoot->childCount() )
+            {
+                beginRemoveRows( idx, 0, searchRoot->childCount() - 1 );
+                searchRoot->removeChildren();
+                endRemoveRows();
+            }
+            else
+                searchRoot->i_fetched = 0;
+            fetchMore( idx );
             return;
         }
     }
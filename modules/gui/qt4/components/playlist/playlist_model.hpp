@@ -82,6 +82,11 @@ public:
     virtual QModelIndex index( const int r, const int c, const QModelIndex &parent ) const;
     virtual QModelIndex parent( const QModelIndex &index ) const;
 
+    /* Lazy population */
+    virtual bool hasChildren( const QModelIndex &parent = QModelIndex() ) const;
+    virtual bool canFetchMore( const QModelIndex &parent ) const;
+    virtual void fetchMore( const QModelIndex &parent );
+
     /* Drag and Drop */
     virtual Qt::DropActions supportedDropActions() const;
     virtual QMimeData* mimeData( const QModelIndexList &indexes ) const;
@@ -146,6 +151,8 @@ private:
     /* ...of which  the following will not update the views */
     void updateChildren( PLItem * );
     void updateChildren( playlist_item_t *, PLItem * );
+    QList<PLItem*> fetchChildren( playlist_item_t *, PLItem * );
+    PLItem *fetchItem( int i_id );
 
     /* Deep actions (affect core playlist) */
     void dropAppendCopy( const PlMimeData * data, PLItem *target, int pos );
@@ -162,6 +169,7 @@ private:
 
     /* Lookups */
     PLItem *findById( PLItem *, int ) const;
+    PLItem *findChild( PLItem *, int, int i_from = 0 ) const;
     PLItem *findByInput( PLItem *, int ) const;
     PLItem *findInner(PLItem *, int , bool ) const;
     bool canEdit() const;
@@ -191,6 +199,7 @@ private slots:
     void processInputItemUpdate( input_thread_t* p_input );
     void processItemRemoval( int i_id );
     void processItemAppend( int item, int parent );
+    void processItemsAppend( int firstItem, int count, int parent );
     void activateItem( playlist_item_t *p_item );
     void increaseZoom();
     void decreaseZoom();
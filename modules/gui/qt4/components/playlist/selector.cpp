@@ -136,6 +136,8 @@ PLSelector::PLSelector( QWidget *p, intf_thread_t *_p_intf )
     /* Podcast connects */
     CONNECT( THEMIM, playlistItemAppended( int, int ),
              this, plItemAdded( int, int ) );
+    CONNECT( THEMIM, playlistItemsAppended( int, int, int ),
+             this, plItemsAdded( int, int, int ) );
     CONNECT( THEMIM, playlistItemRemoved( int ),
              this, plItemRemoved( int ) );
     DCONNECT( THEMIM->getIM(), metaChanged( input_item_t *),
@@ -444,6 +446,14 @@ void PLSelector::plItemAdded( int item, int parent )
     podcastsParent->setExpanded( true );
 }
 
+void PLSelector::plItemsAdded( int first, int count, int parent )
+{
+    if( parent != podcastsParentId ) return;
+
+    for( int i = 0; i < count; i++ )
+        plItemAdded( first + i, parent );
+}
+
 void PLSelector::plItemRemoved( int id )
 {
     if( !podcastsParent ) return;
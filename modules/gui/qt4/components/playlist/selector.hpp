@@ -143,6 +143,7 @@ private:
 private slots:
     void setSource( QTreeWidgetItem *item );
     void plItemAdded( int, int );
+    void plItemsAdded( int, int, int );
     void plItemRemoved( int );
     void inputItemUpdate( input_item_t * );
     void podcastAdd( PLSelItem* );
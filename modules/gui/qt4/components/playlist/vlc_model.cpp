@@ -53,14 +53,17 @@ QPixmap VLCModel::getArtPixmap( const QModelIndex & index, const QSize & size )
     {
         if( artUrl.isEmpty() || !artPix.load( artUrl ) )
         {
-            key = QString("noart%1%2").arg(size.width()).arg(size.height());
-            if( !QPixmapCache::find( key, artPix ) )
+            QString noartKey = QString("noart%1%2").arg(size.width()).arg(size.height());
+            if( !QPixmapCache::find( noartKey, artPix ) )
             {
                 artPix = QPixmap( ":/noart" ).scaled( size,
                                                       Qt::KeepAspectRatio,
                                                       Qt::SmoothTransformation );
-                QPixmapCache::insert( key, artPix );
+                QPixmapCache::insert( noartKey, artPix );
             }
+            /* Do not try to load a missing or broken file at each paint */
+            if( !artUrl.isEmpty() )
+                QPixmapCache::insert( key, artPix );
         }
         else
         {
@@ -25,6 +25,7 @@
 #endif
 
 #include "dialogs/synchronicity.hpp"
+#include "input_manager.hpp"
 #include "util/qt_dirs.hpp"
 #include "../qt4.hpp"
 #include "../dialogs_provider.hpp"
@@ -55,7 +56,6 @@ SynchDialog::SynchDialog( intf_thread_t *_p_intf ) : QVLCFrame( _p_intf )
     setWindowTitle( qtr( "Connect to a peer" ) );
     setWindowRole( "vlc-help" );
     setMinimumSize( 200, 75 );
-    setMaximumSize( 200, 75 );
 
     QGridLayout *layout = new QGridLayout( this );
     QPushButton *closeButton = new QPushButton( qtr( "&Close" ) );
@@ -64,15 +64,19 @@ SynchDialog::SynchDialog( intf_thread_t *_p_intf ) : QVLCFrame( _p_intf )
     QPushButton *connectButton = new QPushButton ( qtr( "Connect" ) );
     QPushButton *hostButton = new QPushButton ( qtr( "Host" ) );
     connection_key_text = new QLineEdit( "" );
+    stats_label = new QLabel( qtr( "Not synchronized" ) );
 
     layout->addWidget( connection_key_text, 0, 0, 1, 4 );
     layout->addWidget( closeButton, 1, 3 );
     layout->addWidget( connectButton, 1, 0, 1, 2 );
     layout->addWidget( hostButton, 1, 2 );
+    layout->addWidget( stats_label, 2, 0, 1, 4 );
 
     BUTTONACT( connectButton, connectButton_Click() );
     BUTTONACT( hostButton, hostButton_Click() );
     BUTTONACT( closeButton, close() );
+    DCONNECT( THEMIM->getIM(), statisticsUpdated( input_item_t* ),
+              this, updateStats( input_item_t* ) );
     readSettings( "Help", QSize( 500, 450 ) );
 }
 
@@ -114,3 +118,30 @@ void SynchDialog::synConnectionReady()
   connection_key_text->setReadOnly(true);
   delete[] addr;
 }
+
+void SynchDialog::updateStats( input_item_t *p_item )
+{
+    if( !isVisible() )
+        return;
+
+    input_stats_t *p_stats = p_item->p_stats;
+    vlc_mutex_lock( &p_stats->lock );
+    if( 0 == p_stats->i_syn_beacons && 0 == p_stats->i_syn_received_bytes )
+        stats_label->setText( qtr( "Not synchronized" ) );
+    else
+        stats_label->setText( qtr( "Round trip: %1 ms\n"
+                                   "Clock offset: %2 ms (+/- %3 ms)\n"
+                                   "Sent: %4 kB, received: %5 kB\n"
+                                   "Beacons: %6 sent, %7 answered\n"
+                                   "Corrections: %8 seeks, %9 rate changes" )
+            .arg( p_stats->i_syn_rtt / 1000.0, 0, 'f', 1 )
+            .arg( p_stats->i_syn_offset / 1000.0, 0, 'f', 1 )
+            .arg( p_stats->i_syn_offset_error / 1000.0, 0, 'f', 1 )
+            .arg( (qulonglong)( p_stats->i_syn_sent_bytes / 1024 ) )
+            .arg( (qulonglong)( p_stats->i_syn_received_bytes / 1024 ) )
+            .arg( (qulonglong)p_stats->i_syn_beacons )
+            .arg( (qulonglong)p_stats->i_syn_beacon_replies )
+            .arg( (qulonglong)p_stats->i_syn_seeks )
+            .arg( (qulonglong)p_stats->i_syn_slews ) );
+    vlc_mutex_unlock( &p_stats->lock );
+}
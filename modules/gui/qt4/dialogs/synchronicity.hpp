@@ -48,6 +48,7 @@ class SynchDialog : public QVLCFrame, public Singleton<SynchDialog>
     Q_OBJECT
 private:
     QLineEdit *connection_key_text;
+    QLabel *stats_label;
     SynConnection connection;
     SynchDialog( intf_thread_t * );
     virtual ~SynchDialog();
@@ -57,6 +58,7 @@ public slots:
     void connectButton_Click();
     void hostButton_Click();
     void synConnectionReady();
+    void updateStats( input_item_t * );
 
     friend class    Singleton<SynchDialog>;
 };
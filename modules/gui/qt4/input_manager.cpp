@@ -38,6 +38,7 @@
 #include <vlc_aout_intf.h>
 
 #include <QApplication>
+#include <QTimer>
 
 #include <assert.h>
 #include <synchronicity/syn_error_codes.h>  /* error codes for synchronicity */
@@ -50,6 +51,8 @@ static int PLItemChanged( vlc_object_t *, const char *,
                         vlc_value_t, vlc_value_t, void * );
 static int PLItemAppended( vlc_object_t *, const char *,
                         vlc_value_t, vlc_value_t, void * );
+static int PLItemsAppended( vlc_object_t *, const char *,
+                        vlc_value_t, vlc_value_t, void * );
 static int PLItemRemoved( vlc_object_t *, const char *,
                         vlc_value_t, vlc_value_t, void * );
 static int VolumeChanged( vlc_object_t *, const char *,
@@ -99,11 +102,29 @@ InputManager::InputManager( QObject *parent, intf_thread_t *_p_intf) :
     timeA        = 0;
     timeB        = 0;
     f_cache      = -1.; /* impossible initial value, different from all */
+
+    vlc_mutex_init( &pending_lock );
+    i_pending      = 0;
+    b_flush_posted = false;
+    i_last_flush   = 0;
+    i_last_stats   = 0;
+    i_update_interval = var_InheritInteger( p_intf, "qt-update-interval" )
+                      * 1000;
+    i_stats_interval = var_InheritInteger( p_intf, "qt-stats-interval" )
+                     * 1000;
+
+    flushTimer = new QTimer( this );
+    flushTimer->setSingleShot( true );
+    CONNECT( flushTimer, timeout(), this, flushEvents() );
+    statsTimer = new QTimer( this );
+    statsTimer->setSingleShot( true );
+    CONNECT( statsTimer, timeout(), this, flushStats() );
 }
 
 InputManager::~InputManager()
 {
     delInput();
+    vlc_mutex_destroy( &pending_lock );
 }
 
 /* Define the Input used.
@@ -164,6 +185,12 @@ void InputManager::delInput()
     vlc_object_release( p_input );
     p_input = NULL;
 
+    /* The pending events were for that input */
+    vlc_mutex_lock( &pending_lock );
+    i_pending = 0;
+    vlc_mutex_unlock( &pending_lock );
+    statsTimer->stop();
+
     emit positionUpdated( -1.0, 0 ,0 );
     emit rateChanged( var_InheritFloat( p_intf, "rate" ) );
     emit nameChanged( "" );
@@ -187,14 +214,86 @@ void InputManager::delInput()
     emit cachingChanged( 1 );
 }
 
+/* Called from the input callbacks: only the first event of a burst is
+   posted, the following ones are merged with it */
+void InputManager::postCoalesced( int i_type )
+{
+    assert( i_type >= PositionUpdate_Type &&
+            i_type < PositionUpdate_Type + 32 );
+
+    vlc_mutex_lock( &pending_lock );
+    i_pending |= 1U << ( i_type - PositionUpdate_Type );
+    bool b_post = !b_flush_posted;
+    b_flush_posted = true;
+    vlc_mutex_unlock( &pending_lock );
+
+    if( b_post )
+        QApplication::postEvent( this, new IMEvent( InputEventsPending_Type ) );
+}
+
+/* Handle the pending events, at most once per update interval */
+void InputManager::flushEvents()
+{
+    vlc_mutex_lock( &pending_lock );
+    unsigned i_events = i_pending;
+    i_pending = 0;
+    b_flush_posted = false;
+    vlc_mutex_unlock( &pending_lock );
+
+    mtime_t now = mdate();
+    i_last_flush = now;
+
+    /* The statistics panel is slow to update: rate-limit it separately */
+    const unsigned i_stats = 1U << ( StatisticsUpdate_Type - PositionUpdate_Type );
+    if( i_events & i_stats )
+    {
+        i_events &= ~i_stats;
+        if( !statsTimer->isActive() )
+        {
+            mtime_t i_wait = i_last_stats + i_stats_interval - now;
+            if( i_wait > 0 )
+                statsTimer->start( ( i_wait + 999 ) / 1000 );
+            else
+                flushStats();
+        }
+    }
+
+    for( int i = 0; i_events != 0; i++, i_events >>= 1 )
+        if( i_events & 1 )
+            handleEvent( PositionUpdate_Type + i, NULL );
+}
+
+void InputManager::flushStats()
+{
+    i_last_stats = mdate();
+    if( hasInput() )
+        UpdateStats();
+}
+
 /* Convert the event from the callbacks in actions */
 void InputManager::customEvent( QEvent *event )
 {
     int i_type = event->type();
     IMEvent *ple = static_cast<IMEvent *>(event);
 
+    if( i_type == InputEventsPending_Type )
+    {
+        /* The timer will flush the events, if it is running */
+        mtime_t i_wait = i_last_flush + i_update_interval - mdate();
+        if( i_wait <= 0 )
+            flushEvents();
+        else if( !flushTimer->isActive() )
+            flushTimer->start( ( i_wait + 999 ) / 1000 );
+        return;
+    }
+
+    handleEvent( i_type, ple->p_item );
+}
+
+void InputManager::handleEvent( int i_type, input_item_t *p_event_item )
+{
     if( i_type == ItemChanged_Type )
-        UpdateMeta( ple->p_item );
+        UpdateMeta( p_event_item );
 
     if( !hasInput() )
         return;
@@ -210,7 +309,7 @@ void InputManager::customEvent( QEvent *event )
         break;
     case ItemChanged_Type:
         /* Ignore ItemChanged_Type event that does not apply to our input */
-        if( p_item == ple->p_item )
+        if( p_item == p_event_item )
         {
             UpdateStatus();
             // UpdateName();
@@ -313,92 +412,92 @@ static int InputEvent( vlc_object_t *p_this, const char *,
     VLC_UNUSED( p_this );
 
     InputManager *im = (InputManager*)param;
-    IMEvent *event;
+    int i_type;
 
+    /* The handlers read the current state of the input: the events of a
+     * given type can be merged, except the state changes (play/pause) */
     switch( newval.i_int )
     {
     case INPUT_EVENT_STATE:
-        event = new IMEvent( ItemStateChanged_Type );
-        break;
+        QApplication::postEvent( im, new IMEvent( ItemStateChanged_Type ) );
+        return VLC_SUCCESS;
     case INPUT_EVENT_RATE:
-        event = new IMEvent( ItemRateChanged_Type );
+        i_type = ItemRateChanged_Type;
         break;
     case INPUT_EVENT_POSITION:
     //case INPUT_EVENT_LENGTH:
-        event = new IMEvent( PositionUpdate_Type );
+        i_type = PositionUpdate_Type;
         break;
 
     case INPUT_EVENT_TITLE:
     case INPUT_EVENT_CHAPTER:
-        event = new IMEvent( ItemTitleChanged_Type );
+        i_type = ItemTitleChanged_Type;
         break;
 
     case INPUT_EVENT_ES:
-        event = new IMEvent( ItemEsChanged_Type );
+        i_type = ItemEsChanged_Type;
         break;
     case INPUT_EVENT_TELETEXT:
-        event = new IMEvent( ItemTeletextChanged_Type );
+        i_type = ItemTeletextChanged_Type;
         break;
 
     case INPUT_EVENT_STATISTICS:
-        event = new IMEvent( StatisticsUpdate_Type );
+        i_type = StatisticsUpdate_Type;
         break;
 
     case INPUT_EVENT_VOUT:
-        event = new IMEvent( InterfaceVoutUpdate_Type );
+        i_type = InterfaceVoutUpdate_Type;
         break;
     case INPUT_EVENT_AOUT:
-        event = new IMEvent( InterfaceAoutUpdate_Type );
+        i_type = InterfaceAoutUpdate_Type;
         break;
 
     case INPUT_EVENT_ITEM_META: /* Codec MetaData + Art */
-        event = new IMEvent( MetaChanged_Type );
+        i_type = MetaChanged_Type;
         break;
     case INPUT_EVENT_ITEM_INFO: /* Codec Info */
-        event = new IMEvent( InfoChanged_Type );
+        i_type = InfoChanged_Type;
         break;
     case INPUT_EVENT_ITEM_NAME:
-        event = new IMEvent( NameChanged_Type );
+        i_type = NameChanged_Type;
         break;
 
     case INPUT_EVENT_AUDIO_DELAY:
     case INPUT_EVENT_SUBTITLE_DELAY:
-        event = new IMEvent( SynchroChanged_Type );
+        i_type = SynchroChanged_Type;
         break;
 
     case INPUT_EVENT_CACHE:
-        event = new IMEvent( CachingEvent_Type );
+        i_type = CachingEvent_Type;
         break;
 
     case INPUT_EVENT_BOOKMARK:
-        event = new IMEvent( BookmarksChanged_Type );
+        i_type = BookmarksChanged_Type;
         break;
 
     case INPUT_EVENT_RECORD:
-        event = new IMEvent( RecordingEvent_Type );
+        i_type = RecordingEvent_Type;
         break;
 
     case INPUT_EVENT_PROGRAM:
         /* This is for PID changes */
-        event = new IMEvent( ProgramChanged_Type );
+        i_type = ProgramChanged_Type;
         break;
 
     case INPUT_EVENT_ITEM_EPG:
         /* EPG data changed */
-        event = new IMEvent( EPGEvent_Type );
+        i_type = EPGEvent_Type;
         break;
 
     case INPUT_EVENT_SIGNAL:
         /* This is for capture-card signals */
-        /* event = new IMEvent( SignalChanged_Type );
+        /* i_type = SignalChanged_Type;
         break; */
     default:
-        event = NULL;
-        break;
+        return VLC_SUCCESS;
     }
 
-    if( event )
-        QApplication::postEvent( im, event );
+    im->postCoalesced( i_type );
     return VLC_SUCCESS;
 }
 
@@ -406,9 +505,8 @@ static int VbiEvent( vlc_object_t *, const char *,
                      vlc_value_t, vlc_value_t, void *param )
 {
     InputManager *im = (InputManager*)param;
-    IMEvent *event = new IMEvent( ItemTeletextChanged_Type );
 
-    QApplication::postEvent( im, event );
+    im->postCoalesced( ItemTeletextChanged_Type );
     return VLC_SUCCESS;
 }
 
@@ -946,11 +1044,16 @@ MainInputManager::MainInputManager( intf_thread_t *_p_intf )
     p_input = NULL;
     im = new InputManager( this, p_intf );
 
+    vlc_mutex_init( &synchro_lock );
+    i_synchro_state = 0;
+    b_synchro_posted = false;
+
     var_AddCallback( THEPL, "item-change", ItemChanged, im );
     var_AddCallback( THEPL, "item-current", PLItemChanged, this );
     var_AddCallback( THEPL, "activity", PLItemChanged, this );
     var_AddCallback( THEPL, "leaf-to-parent", LeafToParent, this );
     var_AddCallback( THEPL, "playlist-item-append", PLItemAppended, this );
+    var_AddCallback( THEPL, "playlist-items-append", PLItemsAppended, this );
     var_AddCallback( THEPL, "playlist-item-deleted", PLItemRemoved, this );
     var_AddCallback( THEPL, "random", RandomChanged, this );
     var_AddCallback( THEPL, "repeat", RepeatChanged, this );
@@ -995,6 +1098,7 @@ MainInputManager::~MainInputManager()
 
     var_DelCallback( THEPL, "item-current", PLItemChanged, this );
     var_DelCallback( THEPL, "playlist-item-append", PLItemAppended, this );
+    var_DelCallback( THEPL, "playlist-items-append", PLItemsAppended, this );
     var_DelCallback( THEPL, "playlist-item-deleted", PLItemRemoved, this );
     var_DelCallback( THEPL, "random", RandomChanged, this );
     var_DelCallback( THEPL, "repeat", RepeatChanged, this );
@@ -1002,6 +1106,8 @@ MainInputManager::~MainInputManager()
 
     if( var_InheritBool( p_intf, "qt-autosave-volume" ) )
         config_PutInt( p_intf, "volume", aout_VolumeGet( THEPL ) );
+
+    vlc_mutex_destroy( &synchro_lock );
 }
 
 vout_thread_t* MainInputManager::getVout()
@@ -1033,6 +1139,11 @@ void MainInputManager::customEvent( QEvent *event )
         plEv = static_cast<PLEvent*>( event );
         emit playlistItemAppended( plEv->i_item, plEv->i_parent );
         return;
+    case PLItemsAppended_Type:
+        plEv = static_cast<PLEvent*>( event );
+        emit playlistItemsAppended( plEv->i_item, plEv->i_count,
+                                    plEv->i_parent );
+        return;
     case PLItemRemoved_Type:
         plEv = static_cast<PLEvent*>( event );
         emit playlistItemRemoved( plEv->i_item );
@@ -1052,30 +1163,15 @@ void MainInputManager::customEvent( QEvent *event )
         plEv = static_cast<PLEvent*>( event );
         emit leafBecameParent( plEv->i_item );
         return;
-    case SynchronicityChanged_CON_SUCCESS_Type:
-        emit synchronicityChanged( CONNECT_SUCCESS );
-        return;
-    case SynchronicityChanged_HOST_SUCCESS_Type:
-        emit synchronicityChanged( HOST_SUCCESS );
-        return;
-    case SynchronicityChanged_CLIENT_CONNECT_Type:
-        emit synchronicityChanged( CLIENT_CONNECTED );
-        return;
-    case SynchronicityChanged_PEER_SNAP_Type:
-        emit synchronicityChanged( PEER_SNAP );
-        return;
-    case SynchronicityChanged_CON_FAIL_Type:
-        emit synchronicityChanged( CONNECTION_FAILURE );
-        return;
-    case SynchronicityChanged_PEER_DIS_Type:
-        emit synchronicityChanged( PEER_DISCONNECT );
-        return;
-    case SynchronicityChanged_ITEM_PLAY_Type:
-        emit synchronicityChanged( ITEM_PLAYING );
-        return;
-    case SynchronicityChanged_ITEM_STOP_Type:
-        emit synchronicityChanged( ITEM_STOPPED );
+    case SynchronicityChanged_Type:
+    {
+        vlc_mutex_lock( &synchro_lock );
+        int i_state = i_synchro_state;
+        b_synchro_posted = false;
+        vlc_mutex_unlock( &synchro_lock );
+        emit synchronicityChanged( i_state );
         return;
+    }
     case SynchronicityUserChanged_Type:
         emit synchronicityUserChanged( var_GetString( THEPL, "synchronicity-user" ) );
     default:
@@ -1290,22 +1386,36 @@ static int SynchronicityChanged (vlc_object_t *p_this, const char *psz_var,
                             vlc_value_t oldval, vlc_value_t newval, void *param )
 {
     MainInputManager *mim = (MainInputManager*)param;
-    IMEvent *event;
-
-    int newValue = newval.i_int;
-    if ( CONNECT_SUCCESS == newValue ) event = new IMEvent( SynchronicityChanged_CON_SUCCESS_Type );
-    else if ( HOST_SUCCESS == newValue ) event = new IMEvent( SynchronicityChanged_HOST_SUCCESS_Type );
-    else if ( CLIENT_CONNECTED == newValue ) event = new IMEvent( SynchronicityChanged_CLIENT_CONNECT_Type );
-    else if ( PEER_SNAP == newValue ) event = new IMEvent( SynchronicityChanged_PEER_SNAP_Type );
-    else if ( CONNECTION_FAILURE == newValue ) event = new IMEvent( SynchronicityChanged_CON_FAIL_Type );
-    else if ( PEER_DISCONNECT == newValue ) event = new IMEvent( SynchronicityChanged_PEER_DIS_Type );
-    else if ( ITEM_PLAYING == newValue ) event = new IMEvent( SynchronicityChanged_ITEM_PLAY_Type );
-    else if ( ITEM_STOPPED == newValue ) event = new IMEvent( SynchronicityChanged_ITEM_STOP_Type );
 
-    QApplication::postEvent( mim, event );
+    switch( newval.i_int )
+    {
+    case CONNECT_SUCCESS:
+    case HOST_SUCCESS:
+    case CLIENT_CONNECTED:
+    case PEER_SNAP:
+    case CONNECTION_FAILURE:
+    case PEER_DISCONNECT:
+    case ITEM_PLAYING:
+    case ITEM_STOPPED:
+        mim->postSynchronicity( newval.i_int );
+        break;
+    }
     return VLC_SUCCESS;
 }
 
+/* Only the latest state matters to the interface */
+void MainInputManager::postSynchronicity( int i_state )
+{
+    vlc_mutex_lock( &synchro_lock );
+    i_synchro_state = i_state;
+    bool b_post = !b_synchro_posted;
+    b_synchro_posted = true;
+    vlc_mutex_unlock( &synchro_lock );
+
+    if( b_post )
+        QApplication::postEvent( this, new IMEvent( SynchronicityChanged_Type ) );
+}
+
 static int SynchronicityUserChanged (vlc_object_t *p_this, const char *psz_var,
                                 vlc_value_t oldval, vlc_value_t newval, void *param )
 {
@@ -1328,6 +1438,20 @@ static int PLItemAppended
     QApplication::postEvent( mim, event );
     return VLC_SUCCESS;
 }
+static int PLItemsAppended
+( vlc_object_t * obj, const char *var, vlc_value_t old, vlc_value_t cur, void *data )
+{
+    VLC_UNUSED( obj ); VLC_UNUSED( var ); VLC_UNUSED( old );
+    MainInputManager *mim = static_cast<MainInputManager*>(data);
+    playlist_add_range_t *p_add = static_cast<playlist_add_range_t*>( cur.p_address );
+
+    PLEvent *event = new PLEvent( PLItemsAppended_Type, p_add->i_item,
+                                  p_add->i_node, p_add->i_count );
+    QApplication::postEvent( mim, event );
+    event = new PLEvent( PLEmpty_Type, p_add->i_item, 0  );
+    QApplication::postEvent( mim, event );
+    return VLC_SUCCESS;
+}
 static int PLItemRemoved
 ( vlc_object_t * obj, const char *var, vlc_value_t old, vlc_value_t cur, void *data )
 {
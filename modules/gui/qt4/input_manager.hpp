@@ -37,6 +37,8 @@
 #include <QObject>
 #include <QEvent>
 
+class QTimer;
+
 enum {
     PositionUpdate_Type = QEvent::User + IMEventType + 1,
     ItemChanged_Type,
@@ -63,15 +65,9 @@ enum {
     RepeatChanged_Type,
     LeafToParent_Type,
     EPGEvent_Type,
-    SynchronicityChanged_CON_SUCCESS_Type,
-    SynchronicityChanged_HOST_SUCCESS_Type,
-    SynchronicityChanged_CLIENT_CONNECT_Type,
-    SynchronicityChanged_PEER_SNAP_Type,
-    SynchronicityChanged_CON_FAIL_Type,
-    SynchronicityChanged_PEER_DIS_Type,
-    SynchronicityChanged_ITEM_PLAY_Type,
-    SynchronicityChanged_ITEM_STOP_Type,
+    SynchronicityChanged_Type,
     SynchronicityUserChanged_Type,
+    InputEventsPending_Type,
 /*    SignalChanged_Type, */
 
     FullscreenControlToggle_Type = QEvent::User + IMEventType + 20,
@@ -110,20 +106,23 @@ enum PLEventTypes
 {
     PLItemAppended_Type = QEvent::User + PLEventType + 1,
     PLItemRemoved_Type,
-    PLEmpty_Type
+    PLEmpty_Type,
+    PLItemsAppended_Type
 };
 
 class PLEvent : public QEvent
 {
 public:
-    PLEvent( int t, int i, int p = 0 )
-        : QEvent( (QEvent::Type)(t) ), i_item(i), i_parent(p) {}
+    PLEvent( int t, int i, int p = 0, int c = 1 )
+        : QEvent( (QEvent::Type)(t) ), i_item(i), i_parent(p), i_count(c) {}
 
     /* Needed for "playlist-item*" and "leaf-to-parent" callbacks
      * !! Can be a input_item_t->i_id or a playlist_item_t->i_id */
     int i_item;
     // Needed for "playlist-item-append" callback, notably
     int i_parent;
+    // Needed for "playlist-items-append": items i_item to i_item + i_count - 1
+    int i_count;
 };
 
 class InputManager : public QObject
@@ -153,6 +152,9 @@ public:
     QString getName() { return oldName; }
     static const QString decodeArtURL( input_item_t *p_item );
 
+    /// Queue an event from an input callback, coalesced with the pending ones
+    void postCoalesced( int i_type );
+
 private:
     intf_thread_t  *p_intf;
     input_thread_t *p_input;
@@ -166,7 +168,19 @@ private:
     bool            b_video;
     mtime_t         timeA, timeB;
 
+    /* Input events are coalesced: the callbacks only flag their type, and
+     * the flagged types are handled at most once per update interval. The
+     * statistics have their own, longer, interval. */
+    vlc_mutex_t     pending_lock;
+    unsigned        i_pending;      ///< bit mask of the pending event types
+    bool            b_flush_posted; ///< an event or a timer will flush them
+    QTimer         *flushTimer;
+    QTimer         *statsTimer;
+    mtime_t         i_last_flush, i_last_stats;
+    mtime_t         i_update_interval, i_stats_interval;
+
     void customEvent( QEvent * );
+    void handleEvent( int i_type, input_item_t * );
 
     void addCallbacks();
     void delCallbacks();
@@ -216,6 +230,8 @@ public slots:
 
 private slots:
     void AtoBLoop( float, int64_t, int );
+    void flushEvents();
+    void flushStats();
 
 signals:
     /// Send new position, new time and new length
@@ -272,6 +288,9 @@ public:
     bool getPlayExitState();
     bool hasEmptyPlaylist();
 
+    /// Keep the latest synchronicity state, to be signaled once
+    void postSynchronicity( int i_state );
+
     void requestVoutUpdate() { return im->UpdateVout(); }
 private:
     MainInputManager( intf_thread_t * );
@@ -283,6 +302,10 @@ private:
     input_thread_t          *p_input;
     intf_thread_t           *p_intf;
 
+    vlc_mutex_t              synchro_lock;
+    int                      i_synchro_state; ///< latest state
+    bool                     b_synchro_posted;
+
     void notifyRepeatLoop();
 public slots:
     void togglePlayPause();
@@ -304,6 +327,7 @@ signals:
     void synchronicityUserChanged(char* name);
     void soundMuteChanged();
     void playlistItemAppended( int itemId, int parentId );
+    void playlistItemsAppended( int firstItemId, int count, int parentId );
     void playlistItemRemoved( int itemId );
     void playlistNotEmpty( bool );
     void randomChanged( bool );
@@ -183,6 +183,14 @@ static void ShowDialog   ( intf_thread_t *, int, int, intf_dialog_args_t * );
 #define ICONCHANGE_LONGTEXT N_( \
     "This option allows the interface to change its icon on various occasions.")
 
+#define UPDATE_INTERVAL_TEXT N_( "Playback update interval (ms)" )
+#define UPDATE_INTERVAL_LONGTEXT N_( \
+    "The events of the playback (position, tracks, meta data...) that occur " \
+    "within this interval are merged into a single update of the interface." )
+#define STATS_INTERVAL_TEXT N_( "Statistics update interval (ms)" )
+#define STATS_INTERVAL_LONGTEXT N_( \
+    "Minimum interval between two updates of the statistics panel." )
+
 /**********************************************************************/
 vlc_module_begin ()
     set_shortname( "Qt" )
@@ -274,6 +282,11 @@ vlc_module_begin ()
 
     add_bool( "qt-icon-change", true, ICONCHANGE_TEXT, ICONCHANGE_LONGTEXT, true )
 
+    add_integer_with_range( "qt-update-interval", 40, 0, 1000,
+                            UPDATE_INTERVAL_TEXT, UPDATE_INTERVAL_LONGTEXT, true )
+    add_integer_with_range( "qt-stats-interval", 1000, 0, 10000,
+                            STATS_INTERVAL_TEXT, STATS_INTERVAL_LONGTEXT, true )
+
     add_obsolete_bool( "qt-blingbling" )      /* Suppressed since 1.0.0 */
     add_obsolete_integer( "qt-display-mode" ) /* Suppressed since 1.1.0 */
 
@@ -39,3 +39,10 @@ void CmdLayout::execute()
     if( p_theme )
         p_theme->getWindowManager().setActiveLayout( m_rWindow, m_rLayout );
 }
+
+
+void CmdRefreshLayout::execute()
+{
+    if( m_pLayout )
+        m_pLayout->refreshDirty();
+}
@@ -45,4 +45,22 @@ private:
     GenericLayout &m_rLayout;
 };
 
+
+/// Command to redraw the dirty rectangles of a layout
+class CmdRefreshLayout: public CmdGeneric
+{
+public:
+    CmdRefreshLayout( intf_thread_t *pIntf, GenericLayout *pLayout )
+        : CmdGeneric( pIntf ), m_pLayout( pLayout ) { }
+    virtual ~CmdRefreshLayout() { }
+    virtual void execute();
+    virtual string getType() const { return "refresh layout"; }
+
+    /// Called when the layout is destroyed before the command is run
+    void detach() { m_pLayout = NULL; }
+
+private:
+    GenericLayout *m_pLayout;
+};
+
 #endif
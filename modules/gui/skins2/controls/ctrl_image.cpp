@@ -28,7 +28,6 @@
 #include "../src/os_factory.hpp"
 #include "../src/os_graphics.hpp"
 #include "../src/vlcproc.hpp"
-#include "../src/scaled_bitmap.hpp"
 #include "../src/art_manager.hpp"
 #include "../utils/position.hpp"
 
@@ -144,7 +143,7 @@ void CtrlImage::draw( OSGraphics &rImage, int xDest, int yDest, int w, int h )
         {
             OSFactory *pOsFactory = OSFactory::instance( getIntf() );
             // Rescale the image with the actual size of the control
-            ScaledBitmap bmp( getIntf(), *m_pBitmap, width, height );
+            const GenericBitmap &bmp = m_pBitmap->getScaled( width, height );
             delete m_pImage;
             m_pImage = pOsFactory->createOSGraphics( width, height );
             m_pImage->drawBitmap( bmp, 0, 0 );
@@ -217,7 +216,7 @@ void CtrlImage::draw( OSGraphics &rImage, int xDest, int yDest, int w, int h )
             h != m_pImage->getHeight() )
         {
             OSFactory *pOsFactory = OSFactory::instance( getIntf() );
-            ScaledBitmap bmp( getIntf(), *m_pBitmap, w, h );
+            const GenericBitmap &bmp = m_pBitmap->getScaled( w, h );
             delete m_pImage;
             m_pImage = pOsFactory->createOSGraphics( w, h );
             m_pImage->drawBitmap( bmp, 0, 0 );
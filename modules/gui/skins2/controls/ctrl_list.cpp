@@ -28,7 +28,6 @@
 #include "../src/os_graphics.hpp"
 #include "../src/generic_bitmap.hpp"
 #include "../src/generic_font.hpp"
-#include "../src/scaled_bitmap.hpp"
 #include "../utils/position.hpp"
 #include "../utils/ustring.hpp"
 #include "../events/evt_key.hpp"
@@ -434,7 +433,7 @@ void CtrlList::makeImage()
     {
         // A background bitmap is given, so we scale it, ignoring the
         // background colors
-        ScaledBitmap bmp( getIntf(), *m_pBitmap, width, height );
+        const GenericBitmap &bmp = m_pBitmap->getScaled( width, height );
         m_pImage->drawBitmap( bmp, 0, 0 );
 
         // Take care of the selection color
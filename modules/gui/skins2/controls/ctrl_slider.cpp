@@ -27,7 +27,6 @@
 #include "../events/evt_mouse.hpp"
 #include "../events/evt_scroll.hpp"
 #include "../src/generic_bitmap.hpp"
-#include "../src/scaled_bitmap.hpp"
 #include "../src/top_window.hpp"
 #include "../src/os_factory.hpp"
 #include "../src/os_graphics.hpp"
@@ -368,7 +367,7 @@ CtrlSliderBg::CtrlSliderBg( intf_thread_t *pIntf,
     CtrlGeneric( pIntf, rHelp, pVisible ), m_pCursor( NULL ),
     m_rVariable( rVariable ), m_thickness( thickness ), m_rCurve( rCurve ),
     m_width( rCurve.getWidth() ), m_height( rCurve.getHeight() ),
-    m_pImgSeq( pBackground ), m_pScaledBmp( NULL ), m_nbHoriz( nbHoriz ),
+    m_pImgSeq( pBackground ), m_nbHoriz( nbHoriz ),
     m_nbVert( nbVert ), m_padHoriz( padHoriz ), m_padVert( padVert ),
     m_bgWidth( 0 ), m_bgHeight( 0 ), m_position( 0 )
 {
@@ -396,8 +395,6 @@ CtrlSliderBg::~CtrlSliderBg()
 {
     if( m_pImgSeq )
         m_rVariable.delObserver( this );
-
-    delete m_pScaledBmp;
 }
 
 
@@ -425,13 +422,7 @@ void CtrlSliderBg::draw( OSGraphics &rImage, int xDest, int yDest, int w, int h
     int height = m_bgHeight * m_nbVert - (int)(m_padVert * factorY);
 
     // Rescale the image with the actual size of the control if needed
-    if( !m_pScaledBmp ||
-        m_pScaledBmp->getWidth() != width ||
-        m_pScaledBmp->getHeight() != height )
-    {
-        delete m_pScaledBmp;
-        m_pScaledBmp = new ScaledBitmap( getIntf(), *m_pImgSeq, width, height );
-    }
+    const GenericBitmap &rScaledBmp = m_pImgSeq->getScaled( width, height );
 
     // Locate the right image in the background bitmap
     int x = m_bgWidth * ( m_position % m_nbHoriz );
@@ -445,7 +436,7 @@ void CtrlSliderBg::draw( OSGraphics &rImage, int xDest, int yDest, int w, int h
     rect clip( xDest, yDest, w, h );
     rect inter;
     if( rect::intersect( region, clip, &inter ) )
-        rImage.drawBitmap( *m_pScaledBmp,
+        rImage.drawBitmap( rScaledBmp,
                            x + inter.x - region.x,
                            y + inter.y - region.y,
                            inter.x, inter.y,
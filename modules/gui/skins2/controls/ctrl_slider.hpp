@@ -32,7 +32,6 @@
 
 
 class GenericBitmap;
-class ScaledBitmap;
 class OSGraphics;
 class VarPercent;
 
@@ -169,8 +168,6 @@ private:
     int m_width, m_height;
     /// Background image sequence (optional)
     GenericBitmap *m_pImgSeq;
-    /// Scaled bitmap if needed
-    ScaledBitmap *m_pScaledBmp;
     /// Number of images in the background bitmap
     int m_nbHoriz, m_nbVert;
     /// Number of pixels between two images
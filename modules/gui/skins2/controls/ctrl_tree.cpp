@@ -30,7 +30,6 @@
 #include "../src/os_graphics.hpp"
 #include "../src/generic_bitmap.hpp"
 #include "../src/generic_font.hpp"
-#include "../src/scaled_bitmap.hpp"
 #include "../utils/position.hpp"
 #include "../utils/ustring.hpp"
 #include "../events/evt_key.hpp"
@@ -61,7 +60,7 @@ CtrlTree::CtrlTree( intf_thread_t *pIntf,
     CtrlGeneric( pIntf,rHelp, pVisible), m_rTree( rTree), m_rFont( rFont ),
     m_pBgBitmap( pBgBitmap ), m_pItemBitmap( pItemBitmap ),
     m_pOpenBitmap( pOpenBitmap ), m_pClosedBitmap( pClosedBitmap ),
-    m_pScaledBitmap( NULL ), m_pImage( NULL ),
+    m_pImage( NULL ),
     m_fgColor( fgColor ), m_playColor( playColor ),
     m_bgColor1( bgColor1 ), m_bgColor2( bgColor2 ), m_selColor( selColor ),
     m_firstPos( m_rTree.end() ), m_lastClicked( m_rTree.end() ),
@@ -77,7 +76,6 @@ CtrlTree::~CtrlTree()
 {
     m_rTree.delObserver( this );
     delete m_pImage;
-    delete m_pScaledBitmap;
 }
 
 int CtrlTree::itemHeight()
@@ -589,15 +587,7 @@ void CtrlTree::makeImage()
     if( m_pBgBitmap )
     {
         // Draw the background bitmap
-        if( !m_pScaledBitmap ||
-            m_pScaledBitmap->getWidth() != width ||
-            m_pScaledBitmap->getHeight() != height )
-        {
-            delete m_pScaledBitmap;
-            m_pScaledBitmap =
-                new ScaledBitmap( getIntf(), *m_pBgBitmap, width, height );
-        }
-        m_pImage->drawBitmap( *m_pScaledBitmap, 0, 0 );
+        m_pImage->drawBitmap( m_pBgBitmap->getScaled( width, height ), 0, 0 );
 
         for( int yPos = 0;
              yPos < height && it != m_rTree.end();
@@ -97,8 +97,6 @@ private:
     const GenericBitmap *m_pOpenBitmap;
     /// Closed node bitmap
     const GenericBitmap *m_pClosedBitmap;
-    /// scaled bitmap
-    GenericBitmap *m_pScaledBitmap;
     /// Image of the control
     OSGraphics *m_pImage;
 
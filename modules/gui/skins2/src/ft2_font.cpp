@@ -42,6 +42,9 @@ FT2Font::FT2Font( intf_thread_t *pIntf, const string &rName, int size ):
 
 FT2Font::~FT2Font()
 {
+    StringList_t::const_iterator it;
+    for( it = m_stringCache.begin(); it != m_stringCache.end(); ++it )
+        delete (*it).m_pBitmap;
     GlyphMap_t::iterator iter;
     for( iter = m_glyphCache.begin(); iter != m_glyphCache.end(); ++iter )
         FT_Done_Glyph( (*iter).second.m_glyph );
@@ -138,6 +141,49 @@ bool FT2Font::init()
 
 GenericBitmap *FT2Font::drawString( const UString &rString, uint32_t color,
                                     int maxWidth ) const
+{
+    // Texts such as the scrolling titles, the time or the playlist items
+    // are drawn again and again: look for the string in the cache first
+    FT2Bitmap *pCached = NULL;
+    StringList_t::iterator it;
+    for( it = m_stringCache.begin(); it != m_stringCache.end(); ++it )
+    {
+        if( (*it).m_color == color && (*it).m_maxWidth == maxWidth &&
+            (*it).m_string == rString )
+        {
+            // Move it to the front
+            m_stringCache.splice( m_stringCache.begin(), m_stringCache, it );
+            pCached = m_stringCache.front().m_pBitmap;
+            break;
+        }
+    }
+
+    if( !pCached )
+    {
+        pCached = renderString( rString, color, maxWidth );
+        if( !pCached )
+            return NULL;
+
+        if( m_stringCache.size() >= 32 )
+        {
+            delete m_stringCache.back().m_pBitmap;
+            m_stringCache.pop_back();
+        }
+        m_stringCache.push_front( RenderedString( rString, color, maxWidth,
+                                                  pCached ) );
+    }
+
+    // The caller owns the returned bitmap
+    int width = pCached->getWidth();
+    int height = pCached->getHeight();
+    FT2Bitmap *pBmp = new FT2Bitmap( getIntf(), width, height );
+    memcpy( pBmp->getData(), pCached->getData(), width * height * 4 );
+    return pBmp;
+}
+
+
+FT2Bitmap *FT2Font::renderString( const UString &rString, uint32_t color,
+                                  int maxWidth ) const
 {
     uint32_t code;
     int n;
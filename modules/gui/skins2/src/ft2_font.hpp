@@ -30,10 +30,12 @@
 #include FT_GLYPH_H
 #include <string>
 #include <map>
+#include <list>
 
 #include "generic_font.hpp"
+#include "../utils/ustring.hpp"
 
-class UString;
+class FT2Bitmap;
 
 
 /// Freetype2 font
@@ -64,6 +66,21 @@ private:
     } Glyph_t;
     typedef map<uint32_t,Glyph_t> GlyphMap_t;
 
+    /// Rendered string
+    struct RenderedString
+    {
+        RenderedString( const UString &rString, uint32_t color,
+                        int maxWidth, FT2Bitmap *pBitmap ):
+            m_string( rString ), m_color( color ), m_maxWidth( maxWidth ),
+            m_pBitmap( pBitmap ) { }
+
+        UString m_string;
+        uint32_t m_color;
+        int m_maxWidth;
+        FT2Bitmap *m_pBitmap;
+    };
+    typedef list<RenderedString> StringList_t;
+
     /// File name
     const string m_name;
     /// Buffer to store the font
@@ -78,9 +95,14 @@ private:
     int m_height, m_ascender, m_descender;
     /// Glyph cache
     mutable GlyphMap_t m_glyphCache;
+    /// Cache of the last rendered strings, most recently used first
+    mutable StringList_t m_stringCache;
 
     /// Get the glyph corresponding to the given code
     Glyph_t &getGlyph( uint32_t code ) const;
+    /// Render a string on a new bitmap
+    FT2Bitmap *renderString( const UString &rString, uint32_t color,
+                             int maxWidth ) const;
     bool error( unsigned err, const char *msg );
 };
 
@@ -22,6 +22,7 @@
  *****************************************************************************/
 
 #include "generic_bitmap.hpp"
+#include "scaled_bitmap.hpp"
 
 
 GenericBitmap::GenericBitmap( intf_thread_t *pIntf,
@@ -32,6 +33,46 @@ GenericBitmap::GenericBitmap( intf_thread_t *pIntf,
 }
 
 
+GenericBitmap::~GenericBitmap()
+{
+    list<ScaledBitmap*>::const_iterator it;
+    for( it = m_scaledList.begin(); it != m_scaledList.end(); ++it )
+    {
+        delete *it;
+    }
+}
+
+
+const GenericBitmap &GenericBitmap::getScaled( int width, int height ) const
+{
+    if( width == getWidth() && height == getHeight() )
+        return *this;
+
+    list<ScaledBitmap*>::iterator it;
+    for( it = m_scaledList.begin(); it != m_scaledList.end(); ++it )
+    {
+        if( (*it)->getWidth() == width && (*it)->getHeight() == height )
+        {
+            // Move it to the front
+            ScaledBitmap *pBmp = *it;
+            m_scaledList.erase( it );
+            m_scaledList.push_front( pBmp );
+            return *pBmp;
+        }
+    }
+
+    // Keep the last sizes only (e.g. the sizes of the different layouts)
+    if( m_scaledList.size() >= 4 )
+    {
+        delete m_scaledList.back();
+        m_scaledList.pop_back();
+    }
+    ScaledBitmap *pBmp = new ScaledBitmap( getIntf(), *this, width, height );
+    m_scaledList.push_front( pBmp );
+    return *pBmp;
+}
+
+
 BitmapImpl::BitmapImpl( intf_thread_t *pIntf, int width, int height,
                         int nbFrames, int fps, int nbLoops ):
     GenericBitmap( pIntf, nbFrames, fps, nbLoops ), m_width( width ),
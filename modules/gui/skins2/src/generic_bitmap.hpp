@@ -29,12 +29,15 @@
 #include "../utils/pointer.hpp"
 #include "../utils/position.hpp"
 
+#include <list>
+
+class ScaledBitmap;
 
 /// Generic interface for bitmaps
 class GenericBitmap: public SkinObject, public Box
 {
 public:
-    virtual ~GenericBitmap() { }
+    virtual ~GenericBitmap();
 
     /// Get a linear buffer containing the image data.
     /// Each pixel is stored in 4 bytes in the order B,G,R,A
@@ -49,6 +52,15 @@ public:
     /// Get the number of Loops (for animated bitmaps)
     int getNbLoops() const { return m_nbLoops; }
 
+    /// Get this bitmap scaled to the given size
+    /**
+     * The last few scaled versions are kept with the bitmap, so that they
+     * are not computed again on each redraw. Therefore the image data must
+     * not change once the bitmap has been scaled.
+     * The returned bitmap belongs to this one.
+     */
+    const GenericBitmap &getScaled( int width, int height ) const;
+
 protected:
     GenericBitmap( intf_thread_t *pIntf, int nbFrames = 1, int fps = 0, int nbLoops = 0);
 
@@ -59,6 +71,8 @@ private:
     int m_frameRate;
     /// Number of Loops
     int m_nbLoops;
+    /// Scaled versions of the bitmap, most recently used first
+    mutable list<ScaledBitmap*> m_scaledList;
 };
 
 
@@ -30,6 +30,8 @@
 #include "anchor.hpp"
 #include "../controls/ctrl_generic.hpp"
 #include "../controls/ctrl_video.hpp"
+#include "../commands/async_queue.hpp"
+#include "../commands/cmd_layout.hpp"
 #include "../utils/var_bool.hpp"
 #include <set>
 
@@ -55,6 +57,10 @@ GenericLayout::GenericLayout( intf_thread_t *pIntf, int width, int height,
 
 GenericLayout::~GenericLayout()
 {
+    // The refresh command may still be in the queue
+    if( m_cmdRefresh.get() )
+        ((CmdRefreshLayout*)m_cmdRefresh.get())->detach();
+
     delete m_pImage;
 
     list<Anchor*>::const_iterator it;
@@ -164,9 +170,84 @@ void GenericLayout::onControlUpdate( const CtrlGeneric &rCtrl,
         rect inter;
         if( rect::intersect( layout, region, &inter ) )
         {
-            refreshRect( inter.x, inter.y, inter.width, inter.height );
+            addDirtyRect( inter );
+        }
+    }
+}
+
+
+void GenericLayout::addDirtyRect( const rect &rRect )
+{
+    // Merge the overlapping rectangles, so that nothing is drawn twice
+    rect dirty = rRect;
+    list<rect>::iterator it = m_dirtyList.begin();
+    while( it != m_dirtyList.end() )
+    {
+        rect inter;
+        if( rect::intersect( *it, dirty, &inter ) )
+        {
+            rect::join( *it, dirty, &dirty );
+            m_dirtyList.erase( it );
+            // The union may overlap the previous rectangles
+            it = m_dirtyList.begin();
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    m_dirtyList.push_back( dirty );
+
+    // Beyond a few rectangles, the bounding box is cheaper
+    if( m_dirtyList.size() > 8 )
+    {
+        dirty = m_dirtyList.front();
+        for( it = m_dirtyList.begin(); it != m_dirtyList.end(); ++it )
+        {
+            rect::join( *it, dirty, &dirty );
+        }
+        m_dirtyList.clear();
+        m_dirtyList.push_back( dirty );
+    }
+
+    if( !m_cmdRefresh.get() )
+    {
+        m_cmdRefresh = CmdGenericPtr( new CmdRefreshLayout( getIntf(), this ) );
+        AsyncQueue::instance( getIntf() )->push( m_cmdRefresh, false );
+    }
+}
+
+
+void GenericLayout::refreshDirty()
+{
+    m_cmdRefresh = CmdGenericPtr();
+
+    // Do nothing if the layout is hidden
+    if( !m_visible || m_dirtyList.empty() )
+    {
+        m_dirtyList.clear();
+        return;
+    }
+
+    list<rect>::const_iterator it;
+    for( it = m_dirtyList.begin(); it != m_dirtyList.end(); ++it )
+    {
+        drawRect( it->x, it->y, it->width, it->height );
+    }
+
+    // Refresh the associated window
+    TopWindow *pWindow = getWindow();
+    if( pWindow )
+    {
+        // first apply new shape to the window, once for all the rectangles
+        pWindow->updateShape();
+
+        for( it = m_dirtyList.begin(); it != m_dirtyList.end(); ++it )
+        {
+            pWindow->invalidateRect( it->x, it->y, it->width, it->height );
         }
     }
+    m_dirtyList.clear();
 }
 
 
@@ -204,6 +285,8 @@ void GenericLayout::resize( int width, int height )
 
 void GenericLayout::refreshAll()
 {
+    // The pending rectangles are included
+    m_dirtyList.clear();
     refreshRect( 0, 0, m_rect.getWidth(), m_rect.getHeight() );
 }
 
@@ -214,6 +297,22 @@ void GenericLayout::refreshRect( int x, int y, int width, int height )
     if( !m_visible )
         return;
 
+    drawRect( x, y, width, height );
+
+    // Refresh the associated window
+    TopWindow *pWindow = getWindow();
+    if( pWindow )
+    {
+        // first apply new shape to the window
+        pWindow->updateShape();
+
+        pWindow->invalidateRect( x, y, width, height );
+    }
+}
+
+
+void GenericLayout::drawRect( int x, int y, int width, int height )
+{
     // update the transparency global mask
     m_pImage->clear( x, y, width, height );
 
@@ -227,16 +326,6 @@ void GenericLayout::refreshRect( int x, int y, int width, int height )
             pCtrl->draw( *m_pImage, x, y, width, height );
         }
     }
-
-    // Refresh the associated window
-    TopWindow *pWindow = getWindow();
-    if( pWindow )
-    {
-        // first apply new shape to the window
-        pWindow->updateShape();
-
-        pWindow->invalidateRect( x, y, width, height );
-    }
 }
 
 
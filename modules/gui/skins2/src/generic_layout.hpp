@@ -29,6 +29,7 @@
 #include "top_window.hpp"
 #include "../utils/pointer.hpp"
 #include "../utils/position.hpp"
+#include "../commands/cmd_generic.hpp"
 
 #include <list>
 
@@ -79,6 +80,10 @@ public:
     /// Refresh a rectangular portion of the window
     virtual void refreshRect( int x, int y, int width, int height );
 
+    /// Refresh the portions of the window changed by the controls since
+    /// the last time
+    virtual void refreshDirty();
+
     /// Get the image of the layout
     virtual OSGraphics *getImage() const { return m_pImage; }
 
@@ -122,7 +127,9 @@ public:
     /**
      * The arguments indicate the size of the rectangle to refresh,
      * and the offset (from the control position) of this rectangle.
-     * Use a negative width or height to refresh the layout completely
+     * Use a negative width or height to refresh the layout completely.
+     * The rectangle is not redrawn at once: the rectangles changed until
+     * the async queue is flushed are merged, then redrawn together.
      */
     virtual void onControlUpdate( const CtrlGeneric &rCtrl,
                                   int width, int height,
@@ -168,6 +175,15 @@ private:
      * layout). This way, we avoid using a setActiveLayoutInner method.
      */
     mutable VarBoolImpl *m_pVarActive;
+    /// Rectangles to refresh (disjoint)
+    list<rect> m_dirtyList;
+    /// Pending command to refresh them, if any
+    CmdGenericPtr m_cmdRefresh;
+
+    /// Add a rectangle to the dirty list
+    void addDirtyRect( const rect &rRect );
+    /// Draw the controls in the given rectangle of the image
+    void drawRect( int x, int y, int width, int height );
 };
 
 
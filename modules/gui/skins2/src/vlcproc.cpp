@@ -173,6 +173,8 @@ VlcProc::VlcProc( intf_thread_t *pIntf ): SkinObject( pIntf ),
     // Called when a playlist item is added
     var_AddCallback( pIntf->p_sys->p_playlist, "playlist-item-append",
                      onItemAppend, this );
+    var_AddCallback( pIntf->p_sys->p_playlist, "playlist-items-append",
+                     onItemsAppend, this );
     // Called when a playlist item is deleted
     // TODO: properly handle item-deleted
     var_AddCallback( pIntf->p_sys->p_playlist, "playlist-item-deleted",
@@ -229,6 +231,8 @@ VlcProc::~VlcProc()
 
     var_DelCallback( getIntf()->p_sys->p_playlist, "playlist-item-append",
                      onItemAppend, this );
+    var_DelCallback( getIntf()->p_sys->p_playlist, "playlist-items-append",
+                     onItemsAppend, this );
     var_DelCallback( getIntf()->p_sys->p_playlist, "playlist-item-deleted",
                      onItemDelete, this );
     var_DelCallback( getIntf()->p_sys->p_playlist, "input-current",
@@ -313,6 +317,33 @@ int VlcProc::onItemAppend( vlc_object_t *pObj, const char *pVariable,
     return VLC_SUCCESS;
 }
 
+int VlcProc::onItemsAppend( vlc_object_t *pObj, const char *pVariable,
+                            vlc_value_t oldVal, vlc_value_t newVal,
+                            void *pParam )
+{
+    (void)pObj; (void)pVariable; (void)oldVal;
+    VlcProc *pThis = (VlcProc*)pParam;
+
+    playlist_add_range_t *p_range =
+        static_cast<playlist_add_range_t*>(newVal.p_address);
+    AsyncQueue *pQueue = AsyncQueue::instance( pThis->getIntf() );
+
+    for( int i = 0; i < p_range->i_count; i++ )
+    {
+        playlist_add_t add;
+        add.i_node = p_range->i_node;
+        add.i_item = p_range->i_item + i;
+
+        CmdPlaytreeAppend *pCmdTree =
+            new CmdPlaytreeAppend( pThis->getIntf(), &add );
+
+        // Push the command in the asynchronous command queue
+        pQueue->push( CmdGenericPtr( pCmdTree ), false );
+    }
+
+    return VLC_SUCCESS;
+}
+
 int VlcProc::onItemDelete( vlc_object_t *pObj, const char *pVariable,
                            vlc_value_t oldVal, vlc_value_t newVal,
                            void *pParam )
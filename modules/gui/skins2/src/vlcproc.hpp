@@ -206,6 +206,11 @@ private:
                              vlc_value_t oldVal, vlc_value_t newVal,
                              void *pParam );
 
+    /// Callback for playlist-items-append variable
+    static int onItemsAppend( vlc_object_t *pObj, const char *pVariable,
+                              vlc_value_t oldVal, vlc_value_t newVal,
+                              void *pParam );
+
     /// Callback for item-change variable
     static int onItemDelete( vlc_object_t *pObj, const char *pVariable,
                              vlc_value_t oldVal, vlc_value_t newVal,
@@ -34,6 +34,8 @@
 #include <vlc_demux.h>
 #include <vlc_url.h>
 #include <vlc_strings.h>
+#include <vlc_fs.h>
+#include <sys/stat.h>
 
 #include "vlc.h"
 #include "libs.h"
@@ -122,6 +124,149 @@ static const luaL_Reg p_reg_parse[] =
     { NULL, NULL }
 };
 
+/*****************************************************************************
+ * Index of the probe hints
+ *****************************************************************************
+ * Most scripts only handle a few web sites. They can declare it with a
+ * global probe_hints table: { access = { ... }, path = { ... } }, where
+ * access lists the accepted vlc.access values, and path substrings of which
+ * vlc.path must contain one. The hints are read once, the first time the
+ * script is probed, so that other URLs are then rejected without creating
+ * a Lua state, nor loading the script. Scripts without hints are always
+ * probed.
+ *****************************************************************************/
+typedef struct probe_hints_t probe_hints_t;
+
+struct probe_hints_t
+{
+    probe_hints_t *p_next;
+    time_t         i_mtime;
+    bool           b_hints;
+    char         **ppsz_access; /* NULL-terminated, NULL if any */
+    char         **ppsz_path;   /* NULL-terminated, NULL if any */
+    char           psz_filename[];
+};
+
+static vlc_mutex_t hints_lock = VLC_STATIC_MUTEX;
+static probe_hints_t *p_hints_index = NULL;
+
+static void hints_list_free( char **ppsz_list )
+{
+    if( ppsz_list == NULL )
+        return;
+    for( char **ppsz = ppsz_list; *ppsz != NULL; ppsz++ )
+        free( *ppsz );
+    free( ppsz_list );
+}
+
+/* Reads a string, or a table of strings, at the top of the stack */
+static char **hints_list_get( lua_State *L )
+{
+    char **ppsz_list = NULL;
+
+    if( lua_isstring( L, -1 ) )
+    {
+        ppsz_list = calloc( 2, sizeof( char * ) );
+        if( likely(ppsz_list != NULL) )
+            ppsz_list[0] = strdup( lua_tostring( L, -1 ) );
+    }
+    else if( lua_istable( L, -1 ) )
+    {
+        size_t i_count = lua_objlen( L, -1 ), j = 0;
+
+        ppsz_list = calloc( i_count + 1, sizeof( char * ) );
+        for( size_t i = 1; ppsz_list != NULL && i <= i_count; i++ )
+        {
+            lua_rawgeti( L, -1, i );
+            if( lua_isstring( L, -1 ) )
+                ppsz_list[j++] = strdup( lua_tostring( L, -1 ) );
+            lua_pop( L, 1 );
+        }
+    }
+    return ppsz_list;
+}
+
+static bool hints_list_match( char *const *ppsz_list, const char *psz,
+                              bool b_substring )
+{
+    if( ppsz_list == NULL )
+        return true;
+    if( psz == NULL )
+        return false;
+    for( ; *ppsz_list != NULL; ppsz_list++ )
+        if( b_substring ? strstr( psz, *ppsz_list ) != NULL
+                        : !strcmp( psz, *ppsz_list ) )
+            return true;
+    return false;
+}
+
+static probe_hints_t **hints_find( const char *psz_filename )
+{
+    probe_hints_t **pp = &p_hints_index;
+
+    while( *pp != NULL && strcmp( (*pp)->psz_filename, psz_filename ) )
+        pp = &(*pp)->p_next;
+    return pp;
+}
+
+/* Returns true if the hints of the script rule the URL out */
+static bool hints_reject( demux_t *p_demux, const char *psz_filename,
+                          time_t i_mtime )
+{
+    bool b_reject = false;
+
+    vlc_mutex_lock( &hints_lock );
+    probe_hints_t *p = *hints_find( psz_filename );
+    if( p != NULL && p->b_hints && p->i_mtime == i_mtime )
+        b_reject =
+            !hints_list_match( p->ppsz_access, p_demux->psz_access, false )
+         || !hints_list_match( p->ppsz_path, p_demux->psz_location, true );
+    vlc_mutex_unlock( &hints_lock );
+    return b_reject;
+}
+
+/* Records the hints of a script that was just loaded in L */
+static void hints_store( lua_State *L, const char *psz_filename,
+                         time_t i_mtime )
+{
+    probe_hints_t *p_new = malloc( sizeof( *p_new )
+                                   + strlen( psz_filename ) + 1 );
+    if( unlikely(p_new == NULL) )
+        return;
+
+    strcpy( p_new->psz_filename, psz_filename );
+    p_new->i_mtime = i_mtime;
+    p_new->ppsz_access = p_new->ppsz_path = NULL;
+
+    lua_getglobal( L, "probe_hints" );
+    p_new->b_hints = lua_istable( L, -1 );
+    if( p_new->b_hints )
+    {
+        lua_getfield( L, -1, "access" );
+        p_new->ppsz_access = hints_list_get( L );
+        lua_pop( L, 1 );
+        lua_getfield( L, -1, "path" );
+        p_new->ppsz_path = hints_list_get( L );
+        lua_pop( L, 1 );
+    }
+    lua_pop( L, 1 );
+
+    vlc_mutex_lock( &hints_lock );
+    probe_hints_t **pp = hints_find( psz_filename );
+    probe_hints_t *p_old = *pp;
+
+    p_new->p_next = (p_old != NULL) ? p_old->p_next : NULL;
+    *pp = p_new;
+    vlc_mutex_unlock( &hints_lock );
+
+    if( p_old != NULL )
+    {
+        hints_list_free( p_old->ppsz_access );
+        hints_list_free( p_old->ppsz_path );
+        free( p_old );
+    }
+}
+
 /*****************************************************************************
  * Called through lua_scripts_batch_execute to call 'probe' on
  * the script pointed by psz_filename.
@@ -131,6 +276,14 @@ static int probe_luascript( vlc_object_t *p_this, const char * psz_filename,
 {
     VLC_UNUSED(user_data);
     demux_t * p_demux = (demux_t *)p_this;
+    struct stat st;
+    time_t i_mtime = 0;
+
+    /* An edited script is loaded again */
+    if( !vlc_stat( psz_filename, &st ) )
+        i_mtime = st.st_mtime;
+    if( hints_reject( p_demux, psz_filename, i_mtime ) )
+        return VLC_EGENERIC;
 
     p_demux->p_sys->psz_filename = strdup(psz_filename);
 
@@ -176,6 +329,8 @@ static int probe_luascript( vlc_object_t *p_this, const char * psz_filename,
         goto error;
     }
 
+    hints_store( L, psz_filename, i_mtime );
+
     lua_getglobal( L, "probe" );
 
     if( !lua_isfunction( L, -1 ) )
@@ -32,8 +32,14 @@
 # include "config.h"
 #endif
 
+#include <assert.h>
+
 #include <vlc_common.h>
 #include <vlc_httpd.h>
+#include <vlc_playlist.h>
+#include <vlc_input.h>
+#include <vlc_aout_intf.h>
+#include <vlc_charset.h>
 
 #include <lua.h>        /* Low level lua C API */
 #include <lauxlib.h>    /* Higher level C API */
@@ -54,6 +60,8 @@ static int vlclua_httpd_file_new( lua_State * );
 static int vlclua_httpd_file_delete( lua_State * );
 static int vlclua_httpd_redirect_new( lua_State * );
 static int vlclua_httpd_redirect_delete( lua_State * );
+static int vlclua_httpd_events_new( lua_State * );
+static int vlclua_httpd_events_delete( lua_State * );
 
 /*****************************************************************************
  * HTTPD Host
@@ -62,6 +70,7 @@ static const luaL_Reg vlclua_httpd_reg[] = {
     { "handler", vlclua_httpd_handler_new },
     { "file", vlclua_httpd_file_new },
     { "redirect", vlclua_httpd_redirect_new },
+    { "events", vlclua_httpd_events_new },
     { NULL, NULL }
 };
 
@@ -323,6 +332,182 @@ static int vlclua_httpd_redirect_delete( lua_State *L )
     return 0;
 }
 
+/*****************************************************************************
+ * HTTPd Events
+ *****************************************************************************/
+/* Server-sent events telling the clients what changed, so that they do not
+ * need to poll. The Lua handlers run on the thread of the host, and would
+ * block each other while waiting: this has a thread of its own.
+ *  - "playlist": the tree changed, data is {"revision":N} (see
+ *    playlist_GetChanges()),
+ *  - "status": the state, volume, rate or playback modes changed,
+ *  - "tick": the playback time changed, data has the time and position. */
+typedef struct
+{
+    httpd_stream_t *p_stream;
+    playlist_t     *p_playlist;
+    vlc_thread_t    thread;
+} vlclua_httpd_events_t;
+
+typedef struct
+{
+    input_thread_t *p_input; /* compared only, not held */
+    int             i_status;
+    audio_volume_t  i_volume;
+    float           f_rate;
+    bool            b_random;
+    bool            b_loop;
+    bool            b_repeat;
+    int64_t         i_length;
+    int64_t         i_time;
+} vlclua_httpd_status_t;
+
+static void vlclua_httpd_events_send( httpd_stream_t *p_stream, char *psz )
+{
+    if( psz != NULL )
+    {
+        httpd_StreamSend( p_stream, (uint8_t *)psz, strlen( psz ) );
+        free( psz );
+    }
+}
+
+static void *vlclua_httpd_events_thread( void *data )
+{
+    vlclua_httpd_events_t *p_sys = data;
+    playlist_t *p_playlist = p_sys->p_playlist;
+    vlclua_httpd_status_t last;
+    uint64_t i_revision = 0;
+    char *psz;
+
+    memset( &last, 0, sizeof( last ) );
+    last.i_status = -1;
+
+    for( ;; )
+    {
+        uint64_t i_new = playlist_WaitChange( p_playlist, i_revision,
+                                              mdate() + CLOCK_FREQ );
+        int canc = vlc_savecancel();
+
+        if( i_new != i_revision )
+        {
+            i_revision = i_new;
+            if( asprintf( &psz, "event: playlist\ndata: {\"revision\":%"
+                          PRIu64"}\n\n", i_revision ) < 0 )
+                psz = NULL;
+            vlclua_httpd_events_send( p_sys->p_stream, psz );
+        }
+
+        vlclua_httpd_status_t cur;
+        memset( &cur, 0, sizeof( cur ) );
+        playlist_Lock( p_playlist );
+        cur.i_status = playlist_Status( p_playlist );
+        playlist_Unlock( p_playlist );
+        cur.i_volume = aout_VolumeGet( p_playlist );
+        cur.b_random = var_GetBool( p_playlist, "random" );
+        cur.b_loop = var_GetBool( p_playlist, "loop" );
+        cur.b_repeat = var_GetBool( p_playlist, "repeat" );
+        cur.f_rate = 1.f;
+
+        float f_position = 0.f;
+        input_thread_t *p_input = playlist_CurrentInput( p_playlist );
+        if( p_input != NULL )
+        {
+            cur.p_input = p_input;
+            cur.f_rate = var_GetFloat( p_input, "rate" );
+            cur.i_length = var_GetTime( p_input, "length" ) / CLOCK_FREQ;
+            cur.i_time = var_GetTime( p_input, "time" ) / CLOCK_FREQ;
+            f_position = var_GetFloat( p_input, "position" );
+            vlc_object_release( p_input );
+        }
+
+        if( cur.p_input != last.p_input || cur.i_status != last.i_status
+         || cur.i_volume != last.i_volume || cur.f_rate != last.f_rate
+         || cur.b_random != last.b_random || cur.b_loop != last.b_loop
+         || cur.b_repeat != last.b_repeat || cur.i_length != last.i_length )
+        {
+            static const char *const ppsz_status[] = {
+                [PLAYLIST_RUNNING] = "playing",
+                [PLAYLIST_STOPPED] = "stopped",
+                [PLAYLIST_PAUSED] = "paused",
+            };
+            if( asprintf( &psz, "event: status\ndata: {\"state\":\"%s\"}"
+                          "\n\n", ppsz_status[cur.i_status] ) < 0 )
+                psz = NULL;
+            vlclua_httpd_events_send( p_sys->p_stream, psz );
+        }
+        if( cur.p_input != last.p_input || cur.i_time != last.i_time
+         || cur.i_length != last.i_length )
+        {
+            if( us_asprintf( &psz, "event: tick\ndata: {\"time\":%"PRId64
+                             ",\"length\":%"PRId64",\"position\":%f}\n\n",
+                             cur.i_time, cur.i_length, f_position ) < 0 )
+                psz = NULL;
+            vlclua_httpd_events_send( p_sys->p_stream, psz );
+        }
+        last = cur;
+        vlc_restorecancel( canc );
+    }
+    assert( 0 );
+}
+
+static int vlclua_httpd_events_new( lua_State *L )
+{
+    httpd_host_t **pp_host = (httpd_host_t **)luaL_checkudata( L, 1, "httpd_host" );
+    const char *psz_url = luaL_checkstring( L, 2 );
+    const char *psz_user = luaL_nilorcheckstring( L, 3 );
+    const char *psz_password = luaL_nilorcheckstring( L, 4 );
+    const vlc_acl_t **pp_acl = lua_isnil( L, 5 ) ? NULL : luaL_checkudata( L, 5, "acl" );
+    vlclua_httpd_events_t *p_sys = malloc( sizeof( *p_sys ) );
+    if( !p_sys )
+        return luaL_error( L, "Failed to allocate private buffer." );
+
+    p_sys->p_playlist = pl_Get( vlclua_get_this( L ) );
+    p_sys->p_stream = httpd_StreamNew( *pp_host, psz_url, "text/event-stream",
+                                       psz_user, psz_password,
+                                       pp_acl?*pp_acl:NULL );
+    if( !p_sys->p_stream )
+    {
+        free( p_sys );
+        return luaL_error( L, "Failed to create HTTPd events." );
+    }
+    /* Sent to each new client, before the last event */
+    static const char psz_retry[] = "retry: 2000\n\n";
+    httpd_StreamHeader( p_sys->p_stream, (uint8_t *)psz_retry,
+                        sizeof( psz_retry ) - 1 );
+
+    if( vlc_clone( &p_sys->thread, vlclua_httpd_events_thread, p_sys,
+                   VLC_THREAD_PRIORITY_LOW ) )
+    {
+        httpd_StreamDelete( p_sys->p_stream );
+        free( p_sys );
+        return luaL_error( L, "Failed to create HTTPd events." );
+    }
+
+    vlclua_httpd_events_t **pp_sys = lua_newuserdata( L, sizeof( *pp_sys ) );
+    *pp_sys = p_sys;
+
+    if( luaL_newmetatable( L, "httpd_events" ) )
+    {
+        lua_pushcfunction( L, vlclua_httpd_events_delete );
+        lua_setfield( L, -2, "__gc" );
+    }
+
+    lua_setmetatable( L, -2 );
+    return 1;
+}
+
+static int vlclua_httpd_events_delete( lua_State *L )
+{
+    vlclua_httpd_events_t **pp_sys = (vlclua_httpd_events_t **)luaL_checkudata( L, 1, "httpd_events" );
+    vlclua_httpd_events_t *p_sys = *pp_sys;
+
+    vlc_cancel( p_sys->thread );
+    vlc_join( p_sys->thread, NULL );
+    httpd_StreamDelete( p_sys->p_stream );
+    free( p_sys );
+    return 0;
+}
+
 /*****************************************************************************
  * Utils
  *****************************************************************************/
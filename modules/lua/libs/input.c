@@ -195,6 +195,12 @@ static int vlclua_input_item_stats( lua_State *L )
         STATS_FLOAT( send_bitrate )
         STATS_INT( played_abuffers )
         STATS_INT( lost_abuffers )
+        STATS_INT( audio_filter_time )
+        STATS_INT( audio_resampler_time )
+        STATS_INT( audio_output_time )
+        STATS_INT( audio_allocations )
+        STATS_INT( audio_buffered )
+        STATS_INT( audio_delay )
 #undef STATS_INT
 #undef STATS_FLOAT
         vlc_mutex_unlock( &p_item->p_stats->lock );
@@ -245,8 +251,11 @@ static int vlclua_input_item_delete( lua_State *L )
     return 1;
 }
 
-static int vlclua_input_item_get( lua_State *L, input_item_t *p_item )
+int vlclua_input_item_get( lua_State *L, input_item_t *p_item )
 {
+    if( vlclua_handle_get( L, vlclua_input_item_get, p_item ) )
+        return 1;
+
     vlc_gc_incref( p_item );
     input_item_t **pp = lua_newuserdata( L, sizeof( input_item_t* ) );
     *pp = p_item;
@@ -261,6 +270,7 @@ static int vlclua_input_item_get( lua_State *L, input_item_t *p_item )
     }
 
     lua_setmetatable(L, -2);
+    vlclua_handle_set( L, vlclua_input_item_get, p_item );
 
     return 1;
 }
@@ -296,13 +306,17 @@ static int vlclua_input_item_is_preparsed( lua_State *L )
 
 static int vlclua_input_item_uri( lua_State *L )
 {
-    lua_pushstring( L, input_item_GetURI( vlclua_input_item_get_internal( L ) ) );
+    char *psz_uri = input_item_GetURI( vlclua_input_item_get_internal( L ) );
+    lua_pushstring( L, psz_uri );
+    free( psz_uri );
     return 1;
 }
 
 static int vlclua_input_item_name( lua_State *L )
 {
-    lua_pushstring( L, input_item_GetName( vlclua_input_item_get_internal( L ) ) );
+    char *psz_name = input_item_GetName( vlclua_input_item_get_internal( L ) );
+    lua_pushstring( L, psz_name );
+    free( psz_name );
     return 1;
 }
 
@@ -25,5 +25,6 @@
 #define VLC_LUA_INPUT_H
 
 input_thread_t * vlclua_get_input_internal( lua_State * );
+int vlclua_input_item_get( lua_State *, input_item_t * );
 
 #endif
@@ -40,6 +40,7 @@
 #include <vlc_aout.h>
 #include <vlc_interface.h>
 #include <vlc_keys.h>
+#include <vlc_memstats.h>
 
 #include <lua.h>        /* Low level lua C API */
 #include <lauxlib.h>    /* Higher level C API */
@@ -88,6 +89,59 @@ static intf_sys_t * vlclua_get_intf( lua_State *L )
     return vlclua_get_object( L, vlclua_set_intf );
 }
 
+/*****************************************************************************
+ * Handles: a single userdata per VLC pointer, while the scripts use it
+ *****************************************************************************/
+/* Pushes the handles of a kind, a table with weak values */
+static void vlclua_push_handles( lua_State *L, const void *kind )
+{
+    lua_pushlightuserdata( L, (void *)kind );
+    lua_rawget( L, LUA_REGISTRYINDEX );
+    if( lua_isnil( L, -1 ) )
+    {
+        lua_pop( L, 1 );
+        lua_newtable( L );
+        lua_createtable( L, 0, 1 );
+        lua_pushliteral( L, "v" );
+        lua_setfield( L, -2, "__mode" );
+        lua_setmetatable( L, -2 );
+        lua_pushlightuserdata( L, (void *)kind );
+        lua_pushvalue( L, -2 );
+        lua_rawset( L, LUA_REGISTRYINDEX );
+    }
+}
+
+/**
+ * Pushes the handle of a pointer if there is one.
+ * \return true if a handle was pushed
+ */
+bool vlclua_handle_get( lua_State *L, const void *kind, void *p )
+{
+    vlclua_push_handles( L, kind );
+    lua_pushlightuserdata( L, p );
+    lua_rawget( L, -2 );
+    lua_remove( L, -2 );
+    if( lua_isnil( L, -1 ) )
+    {
+        lua_pop( L, 1 );
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Remembers the userdata on top of the stack as the handle of a pointer.
+ * It is forgotten when collected.
+ */
+void vlclua_handle_set( lua_State *L, const void *kind, void *p )
+{
+    vlclua_push_handles( L, kind );
+    lua_pushlightuserdata( L, p );
+    lua_pushvalue( L, -3 );
+    lua_rawset( L, -3 );
+    lua_pop( L, 1 );
+}
+
 /*****************************************************************************
  * VLC error code translation
  *****************************************************************************/
@@ -221,6 +275,34 @@ static int vlclua_datadir_list( lua_State *L )
     return 1;
 }
 
+/*****************************************************************************
+ * Memory statistics: { subsystem = { live, peak, allocs, frees } }
+ *****************************************************************************/
+static int vlclua_memstats( lua_State *L )
+{
+    vlc_memstats_t st;
+
+    if( vlc_memstats_Get( 0, &st ) )
+        return 0; /* not compiled in */
+
+    lua_newtable( L );
+    for( unsigned i = 0; i < VLC_MEM_TAGS; i++ )
+    {
+        vlc_memstats_Get( i, &st );
+        lua_newtable( L );
+        lua_pushnumber( L, st.i_live );
+        lua_setfield( L, -2, "live" );
+        lua_pushnumber( L, st.i_peak );
+        lua_setfield( L, -2, "peak" );
+        lua_pushnumber( L, st.i_allocs );
+        lua_setfield( L, -2, "allocs" );
+        lua_pushnumber( L, st.i_frees );
+        lua_setfield( L, -2, "frees" );
+        lua_setfield( L, -2, vlc_memstats_Name( i ) );
+    }
+    return 1;
+}
+
 /*****************************************************************************
  *
  *****************************************************************************/
@@ -419,6 +501,8 @@ static const luaL_Reg vlclua_misc_reg[] = {
     { "mdate", vlclua_mdate },
     { "mwait", vlclua_mwait },
 
+    { "memstats", vlclua_memstats },
+
     { "lock_and_wait", vlclua_lock_and_wait },
 
     { "should_die", vlclua_intf_should_die },
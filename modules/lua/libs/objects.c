@@ -94,8 +94,17 @@ static int vlclua_get_input( lua_State *L )
 }
 
 #undef vlclua_push_vlc_object
+/* Consumes a reference to p_obj. Scripts calling vlc.object.input() over and
+ * over get the same handle rather than a new one to collect each time. */
 int vlclua_push_vlc_object( lua_State *L, vlc_object_t *p_obj )
 {
+    if( vlclua_handle_get( L, vlclua_push_vlc_object, p_obj ) )
+    {
+        /* the handle already has a reference */
+        vlc_object_release( p_obj );
+        return 1;
+    }
+
     vlc_object_t **udata = (vlc_object_t **)
         lua_newuserdata( L, sizeof( vlc_object_t * ) );
     *udata = p_obj;
@@ -110,6 +119,7 @@ int vlclua_push_vlc_object( lua_State *L, vlc_object_t *p_obj )
         lua_setfield( L, -2, "__gc" );
     }
     lua_setmetatable( L, -2 );
+    vlclua_handle_set( L, vlclua_push_vlc_object, p_obj );
     return 1;
 }
 static int vlclua_get_vout( lua_State *L )
@@ -171,6 +171,41 @@ static int vlclua_playlist_enqueue( lua_State *L )
     return 1;
 }
 
+/* The input item of a playlist item is only wrapped when a script asks for
+ * it: dumping the playlist does not create a handle per item. */
+static int vlclua_playlist_item_index( lua_State *L )
+{
+    if( lua_type( L, 2 ) != LUA_TSTRING
+     || strcmp( lua_tostring( L, 2 ), "item" ) )
+        return 0;
+
+    lua_pushliteral( L, "id" );
+    lua_rawget( L, 1 );
+    int i_id = lua_tointeger( L, -1 );
+    lua_pop( L, 1 );
+
+    playlist_t *p_playlist = vlclua_get_playlist_internal( L );
+    input_item_t *p_input = NULL;
+    PL_LOCK;
+    playlist_item_t *p_item = playlist_ItemGetById( p_playlist, i_id );
+    if( p_item != NULL && p_item->p_input != NULL )
+    {
+        p_input = p_item->p_input;
+        vlc_gc_incref( p_input );
+    }
+    PL_UNLOCK;
+    if( p_input == NULL )
+        return 0;
+
+    vlclua_input_item_get( L, p_input );
+    vlc_gc_decref( p_input );
+    /* the next accesses do not come here */
+    lua_pushliteral( L, "item" );
+    lua_pushvalue( L, -2 );
+    lua_rawset( L, 1 );
+    return 1;
+}
+
 static void push_playlist_item( lua_State *L, playlist_item_t *p_item )
 {
     input_item_t *p_input = p_item->p_input;
@@ -209,9 +244,14 @@ static void push_playlist_item( lua_State *L, playlist_item_t *p_item )
         lua_setfield( L, -2, "duration" );
         lua_pushinteger( L, p_input->i_nb_played );
         lua_setfield( L, -2, "nb_played" );
-        luaopen_input_item( L, p_input );
         /* TODO: add (optional) info categories, meta, options, es */
     }
+    if( luaL_newmetatable( L, "playlist_item" ) )
+    {
+        lua_pushcfunction( L, vlclua_playlist_item_index );
+        lua_setfield( L, -2, "__index" );
+    }
+    lua_setmetatable( L, -2 );
     if( p_item->i_children >= 0 )
     {
         int i;
@@ -367,6 +407,55 @@ static int vlclua_playlist_status( lua_State *L )
     return 1;
 }
 
+static int vlclua_playlist_changes( lua_State *L )
+{
+    static const char *const ppsz_types[] = {
+        [PLAYLIST_CHANGE_ADDED] = "added",
+        [PLAYLIST_CHANGE_DELETED] = "deleted",
+        [PLAYLIST_CHANGE_UPDATED] = "updated",
+        [PLAYLIST_CHANGE_REORDERED] = "reordered",
+    };
+    playlist_t *p_playlist = vlclua_get_playlist_internal( L );
+    uint64_t i_since = luaL_optnumber( L, 1, 0 );
+    playlist_change_t *p_changes;
+    unsigned i_count;
+    uint64_t i_revision;
+
+    int i_ret = playlist_GetChanges( p_playlist, i_since, &p_changes,
+                                     &i_count, &i_revision );
+    lua_pushnumber( L, i_revision );
+    if( i_ret != VLC_SUCCESS )
+    {
+        /* Too late: the whole playlist must be read again */
+        lua_pushnil( L );
+        return 2;
+    }
+
+    lua_createtable( L, i_count, 0 );
+    for( unsigned i = 0; i < i_count; i++ )
+    {
+        const playlist_change_t *p_change = &p_changes[i];
+
+        lua_createtable( L, 0, 5 );
+        lua_pushnumber( L, p_change->i_revision );
+        lua_setfield( L, -2, "revision" );
+        lua_pushstring( L, ppsz_types[p_change->i_type] );
+        lua_setfield( L, -2, "type" );
+        lua_pushinteger( L, p_change->i_id );
+        lua_setfield( L, -2, "id" );
+        if( p_change->i_type == PLAYLIST_CHANGE_ADDED )
+        {
+            lua_pushinteger( L, p_change->i_node );
+            lua_setfield( L, -2, "node" );
+            lua_pushinteger( L, p_change->i_count );
+            lua_setfield( L, -2, "count" );
+        }
+        lua_rawseti( L, -2, i + 1 );
+    }
+    free( p_changes );
+    return 2;
+}
+
 /*****************************************************************************
  *
  *****************************************************************************/
@@ -391,6 +480,7 @@ static const luaL_Reg vlclua_playlist_reg[] = {
     { "current", vlclua_playlist_current },
     { "sort", vlclua_playlist_sort },
     { "status", vlclua_playlist_status },
+    { "changes", vlclua_playlist_changes },
     { "delete", vlclua_playlist_delete },
     { NULL, NULL }
 };
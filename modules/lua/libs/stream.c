@@ -189,6 +189,279 @@ static int vlclua_stream_delete( lua_State *L )
     return 0;
 }
 
+/*****************************************************************************
+ * Parallel fetching
+ *****************************************************************************
+ * vlc.stream() blocks until the data is read, so that the scripts which
+ * need several documents wait for each of them in turn. vlc.fetch() reads
+ * whole URLs on a few threads at once, and f:wait() returns them as they
+ * complete. The Lua state is only ever touched by the calling thread.
+ *****************************************************************************/
+#define FETCH_MAX_THREADS 8
+#define FETCH_MAX_SIZE    (64 << 20)
+
+typedef struct
+{
+    char       *psz_url;
+    char       *p_data;
+    size_t      i_data;
+    const char *psz_error;
+} vlclua_fetch_item_t;
+
+typedef struct
+{
+    vlc_object_t        *p_obj;
+    vlc_mutex_t          lock;
+    vlc_cond_t           wait;
+    vlclua_fetch_item_t *p_items;
+    unsigned            *p_done;    /* indexes, in order of completion */
+    unsigned             i_items;
+    unsigned             i_next;    /* next item to fetch */
+    unsigned             i_done;
+    unsigned             i_returned;
+    unsigned             i_threads;
+    vlc_thread_t         threads[FETCH_MAX_THREADS];
+} vlclua_fetch_t;
+
+typedef struct
+{
+    stream_t *p_stream;
+    char     *p_data;
+} vlclua_fetch_ctx_t;
+
+static void vlclua_fetch_cleanup( void *data )
+{
+    vlclua_fetch_ctx_t *p_ctx = data;
+
+    if( p_ctx->p_stream != NULL )
+        stream_Delete( p_ctx->p_stream );
+    free( p_ctx->p_data );
+}
+
+static void *vlclua_fetch_thread( void *data )
+{
+    vlclua_fetch_t *p_fetch = data;
+
+    for( ;; )
+    {
+        vlc_mutex_lock( &p_fetch->lock );
+        unsigned i = p_fetch->i_next;
+        if( i < p_fetch->i_items )
+            p_fetch->i_next++;
+        vlc_mutex_unlock( &p_fetch->lock );
+        if( i >= p_fetch->i_items )
+            break;
+
+        vlclua_fetch_item_t *p_item = &p_fetch->p_items[i];
+        vlclua_fetch_ctx_t ctx = { NULL, NULL };
+        size_t i_data = 0;
+        const char *psz_error = NULL;
+
+        vlc_cleanup_push( vlclua_fetch_cleanup, &ctx );
+        ctx.p_stream = stream_UrlNew( p_fetch->p_obj, p_item->psz_url );
+        if( ctx.p_stream == NULL )
+            psz_error = "Error when opening stream";
+
+        while( psz_error == NULL )
+        {
+            char *p_new = realloc( ctx.p_data, i_data + 65536 );
+            if( unlikely(p_new == NULL) )
+            {
+                psz_error = "Not enough memory";
+                break;
+            }
+            ctx.p_data = p_new;
+
+            int i_read = stream_Read( ctx.p_stream, ctx.p_data + i_data,
+                                      65536 );
+            vlc_testcancel();
+            if( i_read <= 0 )
+                break;
+            i_data += i_read;
+            if( i_data > FETCH_MAX_SIZE )
+                psz_error = "Document too large";
+        }
+        vlc_cleanup_pop();
+
+        if( ctx.p_stream != NULL )
+            stream_Delete( ctx.p_stream );
+        if( psz_error != NULL )
+        {
+            free( ctx.p_data );
+            ctx.p_data = NULL;
+            i_data = 0;
+        }
+
+        vlc_mutex_lock( &p_fetch->lock );
+        p_item->p_data = ctx.p_data;
+        p_item->i_data = i_data;
+        p_item->psz_error = psz_error;
+        p_fetch->p_done[p_fetch->i_done++] = i;
+        vlc_cond_signal( &p_fetch->wait );
+        vlc_mutex_unlock( &p_fetch->lock );
+    }
+    return NULL;
+}
+
+static void vlclua_fetch_free( vlclua_fetch_t *p_fetch )
+{
+    for( unsigned i = 0; i < p_fetch->i_items; i++ )
+    {
+        free( p_fetch->p_items[i].psz_url );
+        free( p_fetch->p_items[i].p_data );
+    }
+    free( p_fetch->p_items );
+    free( p_fetch->p_done );
+    vlc_cond_destroy( &p_fetch->wait );
+    vlc_mutex_destroy( &p_fetch->lock );
+    free( p_fetch );
+}
+
+static int vlclua_fetch_wait( lua_State * );
+static int vlclua_fetch_delete( lua_State * );
+
+static const luaL_Reg vlclua_fetch_reg[] = {
+    { "wait", vlclua_fetch_wait },
+    { NULL, NULL }
+};
+
+static int vlclua_fetch_new( lua_State *L )
+{
+    luaL_checktype( L, 1, LUA_TTABLE );
+    unsigned i_max = luaL_optint( L, 2, 4 );
+    size_t i_items = lua_objlen( L, 1 );
+
+    if( i_max < 1 )
+        i_max = 1;
+    if( i_max > FETCH_MAX_THREADS )
+        i_max = FETCH_MAX_THREADS;
+
+    vlclua_fetch_t *p_fetch = malloc( sizeof( *p_fetch ) );
+    if( unlikely(p_fetch == NULL) )
+        return vlclua_error( L );
+
+    p_fetch->p_obj = vlclua_get_this( L );
+    vlc_mutex_init( &p_fetch->lock );
+    vlc_cond_init( &p_fetch->wait );
+    p_fetch->p_items = calloc( i_items, sizeof( *p_fetch->p_items ) );
+    p_fetch->p_done = calloc( i_items, sizeof( *p_fetch->p_done ) );
+    p_fetch->i_items = 0;
+    p_fetch->i_next = p_fetch->i_done = p_fetch->i_returned = 0;
+    p_fetch->i_threads = 0;
+    if( i_items > 0
+     && unlikely(p_fetch->p_items == NULL || p_fetch->p_done == NULL) )
+    {
+        vlclua_fetch_free( p_fetch );
+        return vlclua_error( L );
+    }
+
+    for( size_t i = 1; i <= i_items; i++ )
+    {
+        lua_rawgeti( L, 1, i );
+        const char *psz_url = lua_tostring( L, -1 );
+        p_fetch->p_items[i - 1].psz_url =
+            (psz_url != NULL) ? strdup( psz_url ) : NULL;
+        p_fetch->i_items++;
+        lua_pop( L, 1 );
+        if( psz_url == NULL || p_fetch->p_items[i - 1].psz_url == NULL )
+        {
+            vlclua_fetch_free( p_fetch );
+            return luaL_error( L, "vlc.fetch: URL %d is not a string",
+                               (int)i );
+        }
+    }
+
+    while( p_fetch->i_threads < i_max
+        && p_fetch->i_threads < p_fetch->i_items )
+    {
+        if( vlc_clone( &p_fetch->threads[p_fetch->i_threads],
+                       vlclua_fetch_thread, p_fetch,
+                       VLC_THREAD_PRIORITY_LOW ) )
+            break;
+        p_fetch->i_threads++;
+    }
+    if( p_fetch->i_threads == 0 && p_fetch->i_items > 0 )
+    {
+        vlclua_fetch_free( p_fetch );
+        return luaL_error( L, "vlc.fetch: cannot create threads" );
+    }
+
+    vlclua_fetch_t **pp_fetch = lua_newuserdata( L, sizeof( *pp_fetch ) );
+    *pp_fetch = p_fetch;
+
+    if( luaL_newmetatable( L, "fetch" ) )
+    {
+        lua_newtable( L );
+        luaL_register( L, NULL, vlclua_fetch_reg );
+        lua_setfield( L, -2, "__index" );
+        lua_pushcfunction( L, vlclua_fetch_delete );
+        lua_setfield( L, -2, "__gc" );
+    }
+
+    lua_setmetatable( L, -2 );
+    return 1;
+}
+
+static int vlclua_fetch_wait( lua_State *L )
+{
+    vlclua_fetch_t *p_fetch =
+        *(vlclua_fetch_t **)luaL_checkudata( L, 1, "fetch" );
+    vlclua_fetch_item_t *p_item = NULL;
+    unsigned i = 0;
+    mtime_t deadline = 0;
+
+    if( !lua_isnoneornil( L, 2 ) )
+        deadline = mdate() + (mtime_t)( luaL_checknumber( L, 2 ) * CLOCK_FREQ );
+
+    vlc_mutex_lock( &p_fetch->lock );
+    mutex_cleanup_push( &p_fetch->lock );
+    while( p_fetch->i_returned == p_fetch->i_done
+        && p_fetch->i_done < p_fetch->i_items )
+    {
+        if( deadline == 0 )
+            vlc_cond_wait( &p_fetch->wait, &p_fetch->lock );
+        else if( vlc_cond_timedwait( &p_fetch->wait, &p_fetch->lock,
+                                     deadline ) )
+            break;
+    }
+
+    if( p_fetch->i_returned < p_fetch->i_done )
+    {
+        i = p_fetch->p_done[p_fetch->i_returned++];
+        p_item = &p_fetch->p_items[i];
+    }
+    vlc_cleanup_run();
+
+    if( p_item == NULL )
+        return 0;
+
+    /* The item is not touched by the threads anymore */
+    lua_pushinteger( L, i + 1 );
+    if( p_item->psz_error == NULL )
+    {
+        lua_pushlstring( L, p_item->p_data ? p_item->p_data : "",
+                         p_item->i_data );
+        FREENULL( p_item->p_data );
+        return 2;
+    }
+    lua_pushnil( L );
+    lua_pushstring( L, p_item->psz_error );
+    return 3;
+}
+
+static int vlclua_fetch_delete( lua_State *L )
+{
+    vlclua_fetch_t *p_fetch =
+        *(vlclua_fetch_t **)luaL_checkudata( L, 1, "fetch" );
+
+    for( unsigned i = 0; i < p_fetch->i_threads; i++ )
+        vlc_cancel( p_fetch->threads[i] );
+    for( unsigned i = 0; i < p_fetch->i_threads; i++ )
+        vlc_join( p_fetch->threads[i], NULL );
+    vlclua_fetch_free( p_fetch );
+    return 0;
+}
+
 /*****************************************************************************
  *
  *****************************************************************************/
@@ -198,4 +471,6 @@ void luaopen_stream( lua_State *L )
     lua_setfield( L, -2, "stream" );
     lua_pushcfunction( L, vlclua_memory_stream_new );
     lua_setfield( L, -2, "memory_stream" );
+    lua_pushcfunction( L, vlclua_fetch_new );
+    lua_setfield( L, -2, "fetch" );
 }
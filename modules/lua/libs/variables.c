@@ -151,18 +151,33 @@ static int vlclua_var_inherit( lua_State *L )
     return vlclua_pushvalue( L, i_type, val, true );
 }
 
+/* vlc.var.get( object, name [, name...] ): one value per name, so that
+ * scripts reading many variables cross the bridge once */
 static int vlclua_var_get( lua_State *L )
 {
-    vlc_value_t val;
     vlc_object_t **pp_obj = luaL_checkudata( L, 1, "vlc_object" );
-    const char *psz_var = luaL_checkstring( L, 2 );
+    int i_vars = lua_gettop( L ) - 1;
 
-    int i_type = var_Type( *pp_obj, psz_var );
-    if( var_Get( *pp_obj, psz_var, &val ) != VLC_SUCCESS )
-        return 0;
+    luaL_checkstring( L, 2 );
+    luaL_checkstack( L, i_vars, "too many variables" );
+    for( int i = 0; i < i_vars; i++ )
+    {
+        const char *psz_var = luaL_checkstring( L, 2 + i );
+        vlc_value_t val;
 
-    lua_pop( L, 2 );
-    return vlclua_pushvalue( L, i_type, val, true );
+        int i_type = var_Type( *pp_obj, psz_var );
+        if( var_Get( *pp_obj, psz_var, &val ) != VLC_SUCCESS )
+        {
+            if( i_vars == 1 )
+                return 0;
+            lua_pushnil( L );
+            continue;
+        }
+        vlclua_pushvalue( L, i_type, val, true );
+        if( (i_type & VLC_VAR_CLASS) == VLC_VAR_STRING )
+            free( val.psz_string );
+    }
+    return i_vars;
 }
 
 static int vlclua_var_set( lua_State *L )
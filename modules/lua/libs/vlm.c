@@ -110,10 +110,38 @@ static void push_message( lua_State *L, vlm_message_t *message )
 static int vlclua_vlm_execute_command( lua_State *L )
 {
     vlm_t **pp_vlm = (vlm_t**)luaL_checkudata( L, 1, "vlm" );
-    const char *psz_command = luaL_checkstring( L, 2 );
     vlm_message_t *message;
     int i_ret;
-    i_ret = vlm_ExecuteCommand( *pp_vlm, psz_command, &message );
+
+    if( lua_istable( L, 2 ) )
+    {
+        /* A list of commands is run as a single batch */
+        int i_command = lua_objlen( L, 2 );
+        const char **ppsz_command = malloc( (i_command ? i_command : 1)
+                                            * sizeof( *ppsz_command ) );
+        if( !ppsz_command )
+            return luaL_error( L, "Out of memory" );
+        for( int i = 0; i < i_command; i++ )
+        {
+            lua_rawgeti( L, 2, i + 1 );
+            ppsz_command[i] = lua_tostring( L, -1 );
+            if( !ppsz_command[i] )
+            {
+                free( ppsz_command );
+                return luaL_error( L, "VLM commands must be strings" );
+            }
+            /* the string stays referenced by the table */
+            lua_pop( L, 1 );
+        }
+        i_ret = vlm_ExecuteCommands( *pp_vlm, i_command, ppsz_command,
+                                     &message );
+        free( ppsz_command );
+    }
+    else
+    {
+        const char *psz_command = luaL_checkstring( L, 2 );
+        i_ret = vlm_ExecuteCommand( *pp_vlm, psz_command, &message );
+    }
     lua_settop( L, 0 );
     push_message( L, message );
     vlm_MessageDelete( message );
@@ -110,6 +110,9 @@ vlc_object_t * vlclua_get_this( lua_State * );
 struct intf_sys_t;
 void vlclua_set_intf( lua_State *, struct intf_sys_t * );
 
+bool vlclua_handle_get( lua_State *, const void *kind, void * );
+void vlclua_handle_set( lua_State *, const void *kind, void * );
+
 /*****************************************************************************
  * Lua function bridge
  *****************************************************************************/
@@ -36,6 +36,9 @@ static int watch_PlaylistItemCurrent( vlc_object_t *p_this, char const *psz_var,
 static int watch_PlaylistItemAppend( vlc_object_t *p_this, char const *psz_var,
                                   vlc_value_t oldval, vlc_value_t newval,
                                   void *data );
+static int watch_PlaylistItemsAppend( vlc_object_t *p_this, char const *psz_var,
+                                  vlc_value_t oldval, vlc_value_t newval,
+                                  void *data );
 static int watch_PlaylistItemDeleted( vlc_object_t *p_this, char const *psz_var,
                                   vlc_value_t oldval, vlc_value_t newval,
                                   void *data );
@@ -102,6 +105,7 @@ int watch_Init( media_library_t *p_ml )
 
     /* Wait on playlist events
      * playlist-item-append -> entry to playlist
+     * playlist-items-append -> entries to playlist
      * item-current -> to ensure that we catch played item only!
      * playlist-item-deleted -> exit from playlist
      * item-change -> Currently not required, as we monitor input_item events
@@ -109,6 +113,7 @@ int watch_Init( media_library_t *p_ml )
     playlist_t *p_pl = pl_Get( p_ml );
     var_AddCallback( p_pl, "item-current", watch_PlaylistItemCurrent, p_ml );
     var_AddCallback( p_pl, "playlist-item-append", watch_PlaylistItemAppend, p_ml );
+    var_AddCallback( p_pl, "playlist-items-append", watch_PlaylistItemsAppend, p_ml );
     var_AddCallback( p_pl, "playlist-item-deleted", watch_PlaylistItemDeleted, p_ml );
 
     /* Initialise item append queue */
@@ -168,6 +173,7 @@ void watch_Close( media_library_t *p_ml )
 {
     playlist_t *p_pl = pl_Get( p_ml );
     var_DelCallback( p_pl, "playlist-item-deleted", watch_PlaylistItemDeleted, p_ml );
+    var_DelCallback( p_pl, "playlist-items-append", watch_PlaylistItemsAppend, p_ml );
     var_DelCallback( p_pl, "playlist-item-append", watch_PlaylistItemAppend, p_ml );
     var_DelCallback( p_pl, "item-current", watch_PlaylistItemCurrent, p_ml );
 
@@ -300,20 +306,12 @@ static void watch_ItemChange( const vlc_event_t *event, void *data )
 }
 
 /**
- * @brief Callback when item is added to playlist
+ * @brief Queue a playlist item for watching
  */
-static int watch_PlaylistItemAppend( vlc_object_t *p_this, char const *psz_var,
-                                  vlc_value_t oldval, vlc_value_t newval,
-                                  void *data )
+static void watch_QueuePlaylistItem( media_library_t* p_ml, int i_id )
 {
-    VLC_UNUSED( oldval );
-    VLC_UNUSED( p_this );
-    VLC_UNUSED( psz_var );
-    media_library_t* p_ml = ( media_library_t* ) data;
     playlist_t* p_playlist = pl_Get( p_ml );
-    playlist_add_t* p_add;
-    p_add = ( playlist_add_t* ) newval.p_address;
-    playlist_item_t* p_pitem = playlist_ItemGetById( p_playlist, p_add->i_item );
+    playlist_item_t* p_pitem = playlist_ItemGetById( p_playlist, i_id );
     input_item_t* p_item = p_pitem->p_input;
     watch_thread_t* p_wt = p_ml->p_sys->p_watch;
 
@@ -339,6 +337,41 @@ static int watch_PlaylistItemAppend( vlc_object_t *p_this, char const *psz_var,
     p_wt->item_append_queue[ p_wt->item_append_queue_count - 1 ] = p_item;
     vlc_mutex_unlock( &p_wt->item_append_queue_lock );
 quit_playlistitemappend:
+    return;
+}
+
+/**
+ * @brief Callback when item is added to playlist
+ */
+static int watch_PlaylistItemAppend( vlc_object_t *p_this, char const *psz_var,
+                                  vlc_value_t oldval, vlc_value_t newval,
+                                  void *data )
+{
+    VLC_UNUSED( oldval );
+    VLC_UNUSED( p_this );
+    VLC_UNUSED( psz_var );
+    media_library_t* p_ml = ( media_library_t* ) data;
+    playlist_add_t* p_add = ( playlist_add_t* ) newval.p_address;
+
+    watch_QueuePlaylistItem( p_ml, p_add->i_item );
+    return VLC_SUCCESS;
+}
+
+/**
+ * @brief Callback when several items are added to playlist
+ */
+static int watch_PlaylistItemsAppend( vlc_object_t *p_this, char const *psz_var,
+                                  vlc_value_t oldval, vlc_value_t newval,
+                                  void *data )
+{
+    VLC_UNUSED( oldval );
+    VLC_UNUSED( p_this );
+    VLC_UNUSED( psz_var );
+    media_library_t* p_ml = ( media_library_t* ) data;
+    playlist_add_range_t* p_add = ( playlist_add_range_t* ) newval.p_address;
+
+    for( int i = 0; i < p_add->i_count; i++ )
+        watch_QueuePlaylistItem( p_ml, p_add->i_item + i );
     return VLC_SUCCESS;
 }
 
@@ -32,19 +32,42 @@
  *****************************************************************************/
 
 /**
- * @brief Add element to ML based on a ml_media_t (media ID ignored)
+ * @brief Run a cached statement inserting a media and its people
+ */
+static int InsertMediaPeople( media_library_t *p_ml, int i_media_id,
+                              int i_people_id )
+{
+    sql_t *p_sql = p_ml->p_sys->p_sql;
+    int i_ret = VLC_EGENERIC;
+
+    sql_stmt_t *p_stmt = sql_GetStatement( p_sql,
+            "INSERT INTO media_to_people ( media_id, people_id ) "
+            "VALUES ( ?, ? )" );
+    if( !p_stmt )
+        return VLC_EGENERIC;
+    if( sql_BindInteger( p_sql, p_stmt, 1, i_media_id ) == VLC_SUCCESS
+     && sql_BindInteger( p_sql, p_stmt, 2, i_people_id ) == VLC_SUCCESS
+     && sql_Run( p_sql, p_stmt ) == VLC_SQL_DONE )
+        i_ret = VLC_SUCCESS;
+    sql_PutStatement( p_sql, p_stmt );
+    return i_ret;
+}
+
+/**
+ * @brief Insert a ml_media_t in the database (media ID ignored)
+ *
  * @param p_ml This media_library_t object
- * @param p_media media item to add in the DB. The media_id is ignored
+ * @param p_media media item to add in the DB, locked by the caller
  * @return VLC_SUCCESS or VLC_EGENERIC
- * @note This function is threadsafe
+ * @note This must be called within a transaction, which the caller rolls
+ * back on error. The media is neither pooled nor announced.
  */
-int AddMedia( media_library_t *p_ml, ml_media_t *p_media )
+int InsertMedia( media_library_t *p_ml, ml_media_t *p_media )
 {
+    sql_t *p_sql = p_ml->p_sys->p_sql;
     int i_ret = VLC_SUCCESS;
     int i_album_artist = 0;
 
-    Begin( p_ml );
-    ml_LockMedia( p_media );
     assert( p_media->i_id == 0 );
     /* Add any people */
     ml_person_t* person = p_media->p_people;
@@ -89,7 +112,7 @@ int AddMedia( media_library_t *p_ml, ml_media_t *p_media )
                     return i_ret;
                 i_album_id = ml_GetAlbumId( p_ml, p_media->psz_album );
                 if( i_album_id <= 0 )
-                    return i_ret;
+                    return VLC_EGENERIC;
             }
             p_media->i_album_id = i_album_id;
         }
@@ -102,85 +125,111 @@ int AddMedia( media_library_t *p_ml, ml_media_t *p_media )
         return VLC_EGENERIC;
     }
 
-    i_ret = QuerySimple( p_ml,
+    /* The statements are cached: scanning a library runs them many times */
+    sql_stmt_t *p_stmt = sql_GetStatement( p_sql,
             "INSERT INTO media ( uri, title, original_title, genre, type, "
             "comment, cover, preview, year, track, disc, album_id, vote, score, "
             "duration, first_played, played_count, last_played, "
             "skipped_count, last_skipped, import_time, filesize ) "
-            "VALUES ( %Q, %Q, %Q, %Q, '%d',%Q, %Q, %Q, '%d', '%d', '%d', '%d',"
-            "'%d', '%d', '%d', '%d', '%d', '%d', '%d', '%d', '%d', '%d' )",
-                p_media->psz_uri,
-                p_media->psz_title,
-                p_media->psz_orig_title,
-                p_media->psz_genre,
-                (int)p_media->i_type,
-                p_media->psz_comment,
-                p_media->psz_cover,
-                p_media->psz_preview,
-                (int)p_media->i_year,
-                (int)p_media->i_track_number,
-                (int)p_media->i_disc_number,
-                (int)p_media->i_album_id,
-                (int)p_media->i_vote,
-                (int)p_media->i_score,
-                (int)p_media->i_duration,
-                (int)p_media->i_first_played,
-                (int)p_media->i_played_count,
-                (int)p_media->i_last_played,
-                (int)p_media->i_skipped_count,
-                (int)p_media->i_last_skipped,
-                (int)p_media->i_import_time,
-                (int)p_media->i_filesize );
+            "VALUES ( ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, "
+            "?, ?, ?, ? )" );
+    if( !p_stmt )
+        return VLC_EGENERIC;
+
+    char *ppsz_text[] = { p_media->psz_uri, p_media->psz_title,
+        p_media->psz_orig_title, p_media->psz_genre };
+    char *ppsz_text2[] = { p_media->psz_comment, p_media->psz_cover,
+        p_media->psz_preview };
+    const int pi_int[] = { (int)p_media->i_year,
+        (int)p_media->i_track_number, (int)p_media->i_disc_number,
+        (int)p_media->i_album_id, (int)p_media->i_vote,
+        (int)p_media->i_score, (int)p_media->i_duration,
+        (int)p_media->i_first_played, (int)p_media->i_played_count,
+        (int)p_media->i_last_played, (int)p_media->i_skipped_count,
+        (int)p_media->i_last_skipped, (int)p_media->i_import_time,
+        (int)p_media->i_filesize };
+    int i_pos = 1;
+
+    for( unsigned i = 0; i < sizeof( ppsz_text ) / sizeof( *ppsz_text ); i++ )
+        i_ret |= sql_BindText( p_sql, p_stmt, i_pos++, ppsz_text[i], -1 );
+    i_ret |= sql_BindInteger( p_sql, p_stmt, i_pos++, (int)p_media->i_type );
+    for( unsigned i = 0; i < sizeof( ppsz_text2 ) / sizeof( *ppsz_text2 ); i++ )
+        i_ret |= sql_BindText( p_sql, p_stmt, i_pos++, ppsz_text2[i], -1 );
+    for( unsigned i = 0; i < sizeof( pi_int ) / sizeof( *pi_int ); i++ )
+        i_ret |= sql_BindInteger( p_sql, p_stmt, i_pos++, pi_int[i] );
+    if( i_ret == VLC_SUCCESS && sql_Run( p_sql, p_stmt ) != VLC_SQL_DONE )
+        i_ret = VLC_EGENERIC;
+    sql_PutStatement( p_sql, p_stmt );
     if( i_ret != VLC_SUCCESS )
-        goto quit_addmedia;
+        return VLC_EGENERIC;
 
     int id = GetMediaIdOfURI( p_ml, p_media->psz_uri );
     if( id <= 0 )
-    {
-        i_ret = VLC_EGENERIC;
-        goto quit_addmedia;
-    }
+        return VLC_EGENERIC;
 
     p_media->i_id = id;
     person = p_media->p_people;
     if( !person )
     {
         /* If there is no person, set it to "Unknown", ie. people_id=0 */
-        i_ret = QuerySimple( p_ml, "INSERT into media_to_people ( media_id, "
-                                     "people_id ) VALUES ( %d, %d )",
-                                     id, 0 );
+        i_ret = InsertMediaPeople( p_ml, id, 0 );
         if( i_ret != VLC_SUCCESS )
-            goto quit_addmedia;
+            return i_ret;
     } else {
         while( person )
         {
-            i_ret = QuerySimple( p_ml, "INSERT into media_to_people ( media_id, "
-                                         "people_id ) VALUES ( %d, %d )",
-                                         id, person->i_id );
+            i_ret = InsertMediaPeople( p_ml, id, person->i_id );
             if( i_ret != VLC_SUCCESS )
-                goto quit_addmedia;
+                return i_ret;
             person = person->p_next;
         }
     }
 
-    i_ret = QuerySimple( p_ml, "INSERT into extra ( id, extra, language, bitrate, "
-            "samplerate, bpm ) VALUES ( '%d', %Q, %Q, '%d', '%d', '%d' )",
-            id, p_media->psz_extra, p_media->psz_language,
-            p_media->i_bitrate, p_media->i_samplerate, p_media->i_bpm );
+    p_stmt = sql_GetStatement( p_sql,
+            "INSERT into extra ( id, extra, language, bitrate, samplerate, "
+            "bpm ) VALUES ( ?, ?, ?, ?, ?, ? )" );
+    if( !p_stmt )
+        return VLC_EGENERIC;
+    i_ret = sql_BindInteger( p_sql, p_stmt, 1, id )
+          | sql_BindText( p_sql, p_stmt, 2, p_media->psz_extra, -1 )
+          | sql_BindText( p_sql, p_stmt, 3, p_media->psz_language, -1 )
+          | sql_BindInteger( p_sql, p_stmt, 4, p_media->i_bitrate )
+          | sql_BindInteger( p_sql, p_stmt, 5, p_media->i_samplerate )
+          | sql_BindInteger( p_sql, p_stmt, 6, p_media->i_bpm );
+    if( i_ret == VLC_SUCCESS && sql_Run( p_sql, p_stmt ) != VLC_SQL_DONE )
+        i_ret = VLC_EGENERIC;
+    sql_PutStatement( p_sql, p_stmt );
     if( i_ret != VLC_SUCCESS )
-        goto quit_addmedia;
-    i_ret = pool_InsertMedia( p_ml, p_media, true );
+        return VLC_EGENERIC;
+
+    return UpdateSearchIndex( p_ml, id );
+}
+
+/**
+ * @brief Add element to ML based on a ml_media_t (media ID ignored)
+ *
+ * @param p_ml This media_library_t object
+ * @param p_media media item to add in the DB. The media_id is ignored
+ * @return VLC_SUCCESS or VLC_EGENERIC
+ * @note This function is threadsafe
+ */
+int AddMedia( media_library_t *p_ml, ml_media_t *p_media )
+{
+    int i_ret;
+
+    Begin( p_ml );
+    ml_LockMedia( p_media );
+    i_ret = InsertMedia( p_ml, p_media );
+    if( i_ret == VLC_SUCCESS )
+        i_ret = pool_InsertMedia( p_ml, p_media, true );
 
-quit_addmedia:
     if( i_ret == VLC_SUCCESS )
-    {
         Commit( p_ml );
-    }
     else
         Rollback( p_ml );
     ml_UnlockMedia( p_media );
     if( i_ret == VLC_SUCCESS )
-        var_SetInteger( p_ml, "media-added", id );
+        var_SetInteger( p_ml, "media-added", p_media->i_id );
     return i_ret;
 }
 
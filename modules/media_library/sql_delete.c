@@ -105,6 +105,10 @@ int Delete( media_library_t *p_ml, vlc_array_t *p_array )
     if( i_return != VLC_SUCCESS )
         goto quit;
 
+    if( p_ml->p_sys->b_search_index )
+        i_return = QuerySimple( p_ml,
+                "DELETE FROM media_search WHERE docid IN %s", psz_idlist );
+
 quit:
     if( i_return == VLC_SUCCESS )
     {
@@ -164,11 +164,21 @@ static int load( vlc_object_t *obj )
     var_Create( p_ml, "media-deleted", VLC_VAR_INTEGER );
     var_Create( p_ml, "media-meta-change", VLC_VAR_INTEGER );
 
+    /* Launching the thread writing the scanned media */
+    if( import_Init( p_ml ) != VLC_SUCCESS )
+    {
+        vlc_mutex_destroy( &p_ml->p_sys->lock );
+        sql_Destroy( p_ml->p_sys->p_sql );
+        free( p_ml->p_sys );
+        return VLC_EGENERIC;
+    }
+
     /* Launching the directory monitoring thread */
     monitoring_thread_t *p_mon =
             vlc_object_create( p_ml, sizeof( monitoring_thread_t ) );
     if( !p_mon )
     {
+        import_Close( p_ml );
         vlc_mutex_destroy( &p_ml->p_sys->lock );
         sql_Destroy( p_ml->p_sys->p_sql );
         free( p_ml->p_sys );
@@ -182,6 +192,7 @@ static int load( vlc_object_t *obj )
                 VLC_THREAD_PRIORITY_LOW ) )
     {
         msg_Err( p_ml, "cannot spawn the media library monitoring thread" );
+        import_Close( p_ml );
         vlc_mutex_destroy( &p_ml->p_sys->lock );
         sql_Destroy( p_ml->p_sys->p_sql );
         free( p_ml->p_sys );
@@ -215,6 +226,9 @@ static void unload( vlc_object_t *obj )
     vlc_join( p_ml->p_sys->p_mon->thread, NULL );
     vlc_object_release( p_ml->p_sys->p_mon );
 
+    /* Stop the import thread, once no more scan results can come */
+    import_Close( p_ml );
+
     /* Destroy the variable */
     var_Destroy( p_ml, "media-meta-change" );
     var_Destroy( p_ml, "media-deleted" );
@@ -332,6 +346,118 @@ int QuerySimpleVa( media_library_t *p_ml,
     return i_ret;
 }
 
+/**
+ * @brief Run a query through a cached prepared statement
+ *
+ * The result has the layout of Query() results (a row of column names, then
+ * i_rows rows) but must be released with FreeStatementResult()
+ * @param p_ml the media library object
+ * @param ppp_res char *** in which to store the table of results (allocated)
+ * @param pi_rows resulting row number in table
+ * @param pi_cols resulting column number in table
+ * @param psz_query query command, with '?' for each bound value
+ * @param p_binds values bound to the parameters of the query, or NULL
+ * @return VLC_SUCCESS or a VLC error code
+ */
+int QueryStatement( media_library_t *p_ml, char ***ppp_res,
+                    int *pi_rows, int *pi_cols, const char *psz_query,
+                    const ml_binds_t *p_binds )
+{
+    assert( p_ml );
+    sql_t *p_sql = p_ml->p_sys->p_sql;
+    int i_ret = VLC_EGENERIC;
+    char **pp_res = NULL;
+    int i_rows = 0, i_size = 0;
+
+    sql_stmt_t *p_stmt = sql_GetStatement( p_sql, psz_query );
+    if( !p_stmt )
+        return VLC_EGENERIC;
+
+    for( int i = 0; p_binds && i < p_binds->i_size; i++ )
+        if( sql_BindText( p_sql, p_stmt, i + 1, p_binds->p_elems[i], -1 )
+                != VLC_SUCCESS )
+            goto error;
+
+    const int i_cols = sql_GetColumnCount( p_sql, p_stmt );
+    if( i_cols > 0 )
+    {
+        i_size = 16;
+        pp_res = calloc( i_size * i_cols, sizeof( char * ) );
+        if( !pp_res )
+        {
+            i_ret = VLC_ENOMEM;
+            goto error;
+        }
+        for( int j = 0; j < i_cols; j++ )
+        {
+            const char *psz_name = sql_GetColumnName( p_sql, p_stmt, j );
+            pp_res[j] = strdup( psz_name ? psz_name : "" );
+        }
+    }
+
+    while( ( i_ret = sql_Run( p_sql, p_stmt ) ) == VLC_SQL_ROW )
+    {
+        if( i_cols <= 0 )
+            continue;
+        if( i_rows + 2 > i_size )
+        {
+            char **pp_new = realloc( pp_res,
+                                     2 * i_size * i_cols * sizeof( char * ) );
+            if( !pp_new )
+            {
+                i_ret = VLC_ENOMEM;
+                goto error;
+            }
+            memset( pp_new + i_size * i_cols, 0,
+                    i_size * i_cols * sizeof( char * ) );
+            pp_res = pp_new;
+            i_size *= 2;
+        }
+        i_rows++;
+        for( int j = 0; j < i_cols; j++ )
+        {
+            sql_value_t value;
+            value.value.psz = NULL;
+            sql_GetColumn( p_sql, p_stmt, j, SQL_TEXT, &value );
+            pp_res[i_rows * i_cols + j] = value.value.psz;
+        }
+    }
+    if( i_ret != VLC_SQL_DONE )
+    {
+        i_ret = VLC_EGENERIC;
+        goto error;
+    }
+
+    sql_PutStatement( p_sql, p_stmt );
+    /* Like Query(), no columns when there is no row */
+    if( i_rows == 0 )
+    {
+        FreeStatementResult( pp_res, 0, i_cols );
+        pp_res = NULL;
+    }
+    *ppp_res = pp_res;
+    *pi_rows = i_rows;
+    *pi_cols = i_rows > 0 ? i_cols : 0;
+    return VLC_SUCCESS;
+
+error:
+    sql_PutStatement( p_sql, p_stmt );
+    FreeStatementResult( pp_res, i_rows, i_cols );
+    return i_ret;
+}
+
+/**
+ * @brief Free the result of QueryStatement()
+ */
+void FreeStatementResult( char **pp_results, int i_rows, int i_cols )
+{
+    if( !pp_results )
+        return;
+    for( int i = 0; i < ( i_rows + 1 ) * i_cols; i++ )
+        free( pp_results[i] );
+    free( pp_results );
+}
+
 /**
  * @brief Transforms a string to a ml_result_t, with given type and id (as psz)
  *
@@ -1068,6 +1194,23 @@ int InitDatabase( media_library_t *p_ml )
     else if( i_version != ML_DBVERSION )
         return VLC_EGENERIC;
 
+    if( !strcmp( module_get_name( p_ml->p_sys->p_sql->p_module, false ),
+                 "SQLite" ) )
+    {
+        /* Commits are cheaper with a write-ahead log, and readers are not
+         * blocked by the scans */
+        QuerySimple( p_ml, "PRAGMA journal_mode=WAL" );
+        QuerySimple( p_ml, "PRAGMA synchronous=NORMAL" );
+        /* Media are looked up by URI for each scanned file */
+        QuerySimple( p_ml, "CREATE INDEX IF NOT EXISTS media_uri "
+                           "ON media ( uri COLLATE NOCASE )" );
+        QuerySimple( p_ml, "CREATE INDEX IF NOT EXISTS media_directory "
+                           "ON media ( directory_id )" );
+    }
+
+    if( InitSearchIndex( p_ml ) != VLC_SUCCESS )
+        msg_Warn( p_ml, "no full-text index, searching will be slow" );
+
     /**
      * The below code ensures that correct code is written
      * when database versions are changed
@@ -1081,6 +1224,96 @@ int InitDatabase( media_library_t *p_ml )
     return VLC_SUCCESS;
 }
 
+/**
+ * @brief Create the full-text index of the media if needed, and enable it
+ *
+ * The media_search table is an SQLite FTS4 table whose docid is the media id.
+ * It is not part of the database version: it is built on the first start,
+ * and kept up to date by AddMedia(), Update() and Delete().
+ * @param p_ml This ML
+ * @return VLC_SUCCESS or VLC_EGENERIC if the index is not available
+ */
+int InitSearchIndex( media_library_t *p_ml )
+{
+    char **pp_results = NULL;
+    int i_rows = 0, i_cols = 0;
+
+    p_ml->p_sys->b_search_index = false;
+    if( strcmp( module_get_name( p_ml->p_sys->p_sql->p_module, false ),
+                "SQLite" ) )
+        return VLC_EGENERIC;
+
+    if( Query( p_ml, &pp_results, &i_rows, &i_cols,
+               "SELECT name FROM sqlite_master "
+               "WHERE type = 'table' AND name = 'media_search'" )
+            != VLC_SUCCESS )
+        return VLC_EGENERIC;
+    FreeSQLResult( p_ml, pp_results );
+
+    if( i_rows == 0 )
+    {
+        msg_Dbg( p_ml, "building the full-text search index" );
+        Begin( p_ml );
+        /* The unicode61 tokenizer (SQLite 3.7.13) also folds non-ASCII case */
+        int i_ret = QuerySimple( p_ml,
+                "CREATE VIRTUAL TABLE media_search USING "
+                "fts4( title, genre, tokenize=unicode61 )" );
+        if( i_ret != VLC_SUCCESS )
+            i_ret = QuerySimple( p_ml,
+                "CREATE VIRTUAL TABLE media_search USING fts4( title, genre )" );
+        if( i_ret == VLC_SUCCESS )
+            i_ret = QuerySimple( p_ml,
+                "INSERT INTO media_search ( docid, title, genre ) "
+                "SELECT id, title, genre FROM media" );
+        if( i_ret != VLC_SUCCESS )
+        {
+            Rollback( p_ml );
+            return VLC_EGENERIC;
+        }
+        Commit( p_ml );
+    }
+
+    p_ml->p_sys->b_search_index = true;
+    return VLC_SUCCESS;
+}
+
+static int RunMediaStatement( media_library_t *p_ml, const char *psz_query,
+                              int i_media_id )
+{
+    sql_t *p_sql = p_ml->p_sys->p_sql;
+    int i_ret = VLC_EGENERIC;
+
+    sql_stmt_t *p_stmt = sql_GetStatement( p_sql, psz_query );
+    if( !p_stmt )
+        return VLC_EGENERIC;
+    if( sql_BindInteger( p_sql, p_stmt, 1, i_media_id ) == VLC_SUCCESS
+     && sql_Run( p_sql, p_stmt ) == VLC_SQL_DONE )
+        i_ret = VLC_SUCCESS;
+    sql_PutStatement( p_sql, p_stmt );
+    return i_ret;
+}
+
+/**
+ * @brief Refresh the full-text index entry of a media
+ *
+ * @param p_ml This ML
+ * @param i_media_id the media, which may have been removed
+ * @return VLC_SUCCESS or VLC_EGENERIC
+ */
+int UpdateSearchIndex( media_library_t *p_ml, int i_media_id )
+{
+    if( !p_ml->p_sys->b_search_index )
+        return VLC_SUCCESS;
+
+    if( RunMediaStatement( p_ml,
+            "DELETE FROM media_search WHERE docid = ?", i_media_id )
+            != VLC_SUCCESS )
+        return VLC_EGENERIC;
+    return RunMediaStatement( p_ml,
+            "INSERT INTO media_search ( docid, title, genre ) "
+            "SELECT id, title, genre FROM media WHERE id = ?", i_media_id );
+}
+
 /**
  * @brief Gets the current version number from the database
  *
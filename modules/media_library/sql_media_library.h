@@ -72,8 +72,12 @@
  * Structures and types definitions
  *****************************************************************************/
 typedef struct monitoring_thread_t monitoring_thread_t;
+typedef struct import_thread_t     import_thread_t;
 typedef struct ml_poolobject_t     ml_poolobject_t;
 
+/* Values bound to the '?' parameters of a generated query, in order */
+TYPEDEF_ARRAY( char *, ml_binds_t )
+
 struct ml_poolobject_t
 {
     ml_media_t* p_media;
@@ -91,6 +95,9 @@ struct media_library_sys_t
     /* Monitoring thread */
     monitoring_thread_t *p_mon;
 
+    /* Writer of the media found by the monitoring thread */
+    import_thread_t *p_import;
+
     /* Watch thread */
     watch_thread_t *p_watch;
 
@@ -102,9 +109,19 @@ struct media_library_sys_t
     /* Info on update/collection rebuilding */
     bool b_updating;
     bool b_rebuilding;
+
+    /* Full-text index of the media (media_search table) is available */
+    bool b_search_index;
 };
 
 /* Directory Monitoring thread */
+typedef struct
+{
+    int i_wd;           /* inotify watch descriptor */
+    int i_dir_id;       /* id in the directories table */
+    bool b_dirty;       /* changed since the last scan */
+} ml_dir_watch_t;
+
 struct monitoring_thread_t
 {
     VLC_COMMON_MEMBERS;
@@ -113,6 +130,11 @@ struct monitoring_thread_t
     vlc_mutex_t lock;
     vlc_thread_t thread;
     media_library_t *p_ml;
+
+    /* Change notifications: -1 if not available, then the directories are
+     * checked every MONITORING_DELAY seconds */
+    int i_notify;
+    DECL_ARRAY( ml_dir_watch_t ) watches;
 };
 
 /* Media status Watching thread */
@@ -141,6 +163,8 @@ struct watch_thread_t
 /* General functions */
 int CreateEmptyDatabase( media_library_t *p_ml );
 int InitDatabase( media_library_t *p_ml );
+int InitSearchIndex( media_library_t *p_ml );
+int UpdateSearchIndex( media_library_t *p_ml, int i_media_id );
 
 /* Module Control */
 int Control( media_library_t *p_ml,
@@ -150,6 +174,8 @@ int Control( media_library_t *p_ml,
 /* Add functions */
 int AddMedia( media_library_t *p_ml,
               ml_media_t *p_media );
+int InsertMedia( media_library_t *p_ml,
+                 ml_media_t *p_media );
 int AddAlbum( media_library_t *p_ml, const char *psz_title,
               const char *psz_cover, const int i_album_artist );
 int AddPeople( media_library_t *p_ml,
@@ -180,10 +206,12 @@ int GetMediaIdOfURI( media_library_t *p_ml,
 /* Search in the database */
 int BuildSelectVa( media_library_t *p_ml,
                    char **ppsz_query,
+                   ml_binds_t *p_binds,
                    ml_result_type_e *p_result_type,
                    va_list criterias );
 int BuildSelect( media_library_t *p_ml,
                  char **ppsz_query,
+                 ml_binds_t *p_binds,
                  ml_result_type_e *p_result_type,
                  const char *psz_selected_type_lvalue,
                  ml_select_e selected_type,
@@ -240,6 +268,13 @@ int QueryVa( media_library_t *p_ml,
 int QuerySimpleVa( media_library_t *p_ml,
                    const char *psz_fmt,
                    va_list argp );
+int QueryStatement( media_library_t *p_ml,
+                    char ***ppp_res,
+                    int *pi_rows,
+                    int *pi_cols,
+                    const char *psz_query,
+                    const ml_binds_t *p_binds );
+void FreeStatementResult( char **pp_results, int i_rows, int i_cols );
 
 /* Convert SQL results to ML results */
 int StringToResult( ml_result_t *res,
@@ -294,6 +329,8 @@ static inline void Rollback( media_library_t* p_ml )
  * Scanning/monitoring functions
  *****************************************************************************/
 void *RunMonitoringThread( void *p_mon );
+int import_Init( media_library_t *p_ml );
+void import_Close( media_library_t *p_ml );
 int AddDirToMonitor( media_library_t *p_ml,
                      const char *psz_dir );
 int ListMonitoredDirs( media_library_t *p_ml,
@@ -37,6 +37,11 @@
 #include "vlc_url.h"
 #include "vlc_fs.h"
 
+#include <unistd.h>
+#ifdef HAVE_SYS_INOTIFY_H
+#   include <sys/inotify.h>
+#endif
+
 static const char* ppsz_MediaExtensions[] =
                         { EXTENSIONS_AUDIO_CSV, EXTENSIONS_VIDEO_CSV, NULL };
 
@@ -45,6 +50,8 @@ static const char* ppsz_MediaExtensions[] =
 typedef struct stat_list_t stat_list_t;
 typedef struct preparsed_item_t preparsed_item_t;
 static void UpdateLibrary( monitoring_thread_t *p_mon );
+static void UpdateChangedDirs( monitoring_thread_t *p_mon );
+static void WatchDirectory( monitoring_thread_t *, int, const char * );
 static void ScanFiles( monitoring_thread_t *, int, bool, stat_list_t *stparent );
 static int Sort( const char **, const char ** );
 
@@ -58,11 +65,33 @@ struct stat_list_t
 struct preparsed_item_t
 {
     monitoring_thread_t *p_mon;
+    input_item_t *p_input;
     char* psz_uri;
     int i_dir_id;
     int i_mtime;
     int i_update_id;
     bool b_update;
+
+    preparsed_item_t *p_next;   /* in the import queue */
+    ml_media_t *p_media;        /* added within the current batch */
+};
+
+/* Most media added in one transaction */
+#define IMPORT_BATCH 512
+/* Longest wait for a batch to fill up */
+#define IMPORT_DELAY ( INT64_C(1000000) )
+
+/* Writes the preparsed media in large transactions, so that scanning is not
+ * bound by the synchronous writes of each commit */
+struct import_thread_t
+{
+    media_library_t *p_ml;
+    vlc_thread_t thread;
+    vlc_mutex_t lock;
+    vlc_cond_t wait;
+    preparsed_item_t *p_first;
+    preparsed_item_t **pp_last;
+    int i_count;
 };
 
 /**
@@ -200,36 +229,111 @@ static int Sort( const char **a, const char **b )
 #endif
 }
 
+static void CloseWatches( void *data )
+{
+    monitoring_thread_t *p_mon = data;
+
+    if( p_mon->i_notify != -1 )
+        close( p_mon->i_notify );
+    p_mon->i_notify = -1;
+    ARRAY_RESET( p_mon->watches );
+}
+
 /**
  * @brief Directory Monitoring thread loop
+ *
+ * All the directories are checked at start, and when the media library asks
+ * for it. The modification time of each directory is kept in the database,
+ * so that only the changed ones are scanned again.
+ * Afterwards, if the system notifies of changes, only the directories which
+ * changed are scanned. Otherwise all the directories are checked every
+ * MONITORING_DELAY seconds.
  */
 void *RunMonitoringThread( void *p_this )
 {
     monitoring_thread_t *p_mon = (monitoring_thread_t*) p_this;
+    bool b_full = true;
+
     vlc_cond_init( &p_mon->wait );
     vlc_mutex_init( &p_mon->lock );
 
     var_Create( p_mon, "ml-recursive-scan", VLC_VAR_BOOL | VLC_VAR_DOINHERIT );
 
+    ARRAY_INIT( p_mon->watches );
+#ifdef HAVE_SYS_INOTIFY_H
+    p_mon->i_notify = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+    if( p_mon->i_notify == -1 )
+        msg_Warn( p_mon, "no change notifications (%m), "
+                  "directories will be checked periodically" );
+#else
+    p_mon->i_notify = -1;
+#endif
+    vlc_cleanup_push( CloseWatches, p_mon );
+
     while( vlc_object_alive( p_mon ) )
     {
         vlc_mutex_lock( &p_mon->lock );
 
         /* Update */
-        UpdateLibrary( p_mon );
+        if( b_full || p_mon->i_notify == -1 )
+            UpdateLibrary( p_mon );
+        else
+            UpdateChangedDirs( p_mon );
 
         /* We wait MONITORING_DELAY seconds or wait that the media library
            signals us to do something */
-        vlc_cond_timedwait( &p_mon->wait, &p_mon->lock,
-                            mdate() + 1000000*MONITORING_DELAY );
+        b_full = vlc_cond_timedwait( &p_mon->wait, &p_mon->lock,
+                            mdate() + 1000000*MONITORING_DELAY ) == 0;
 
         vlc_mutex_unlock( &p_mon->lock );
     }
+    vlc_cleanup_run();
     vlc_cond_destroy( &p_mon->wait );
     vlc_mutex_destroy( &p_mon->lock );
     return NULL;
 }
 
+/**
+ * @brief Check a monitored directory, and scan it if needed
+ * @param b_force scan even if its modification time did not change
+ */
+static void CheckDirectory( monitoring_thread_t *p_mon, int id,
+                            const char *psz_dir, int timestamp,
+                            bool b_force, bool b_recursive )
+{
+    media_library_t *p_ml = p_mon->p_ml;
+    struct stat s_stat;
+
+    if( vlc_stat( psz_dir, &s_stat ) == -1 )
+    {
+        int err = errno;
+        if( err == ENOTDIR || err == ENOENT )
+        {
+            msg_Dbg( p_mon, "Removing `%s'", psz_dir );
+            RemoveDirToMonitor( p_ml, psz_dir );
+        }
+        else
+            msg_Err( p_mon, "%s: %m", psz_dir );
+        errno = err;
+        return;
+    }
+
+    if( !S_ISDIR( s_stat.st_mode ) )
+    {
+        msg_Dbg( p_mon, "Removing `%s'", psz_dir );
+        RemoveDirToMonitor( p_ml, psz_dir );
+        return;
+    }
+
+    if( b_force || timestamp < s_stat.st_mtime )
+    {
+        msg_Dbg( p_mon, "Adding `%s'", psz_dir );
+        ScanFiles( p_mon, id, b_recursive, NULL );
+    }
+    else
+        WatchDirectory( p_mon, id, psz_dir );
+}
+
 /**
  * @brief Update library if new files found or updated
  */
@@ -239,15 +343,19 @@ static void UpdateLibrary( monitoring_thread_t *p_mon )
     char **pp_results;
     media_library_t *p_ml = p_mon->p_ml;
 
-    struct stat s_stat;
-
     bool b_recursive = var_GetBool( p_mon, "ml-recursive-scan" );
 
     msg_Dbg( p_mon, "Scanning directories" );
 
-    Query( p_ml, &pp_results, &i_rows, &i_cols,
+    /* Events queued so far are covered by this pass */
+    UpdateChangedDirs( p_mon );
+    for( i = 0; i < p_mon->watches.i_size; i++ )
+        p_mon->watches.p_elems[i].b_dirty = false;
+
+    if( Query( p_ml, &pp_results, &i_rows, &i_cols,
               "SELECT id AS directory_id, uri AS directory_uri, "
-              "timestamp AS directory_ts FROM directories" );
+              "timestamp AS directory_ts FROM directories" ) != VLC_SUCCESS )
+        return;
     msg_Dbg( p_mon, "%d directories to scan", i_rows );
 
     for( i = 1; i <= i_rows; i++ )
@@ -256,75 +364,377 @@ static void UpdateLibrary( monitoring_thread_t *p_mon )
         char *psz_dir = pp_results[i*i_cols+1];
         int timestamp = atoi( pp_results[i*i_cols+2] );
 
-        if( vlc_stat( psz_dir, &s_stat ) == -1 )
-        {
-            int err = errno;
-            if( err == ENOTDIR || err == ENOENT )
-            {
-                msg_Dbg( p_mon, "Removing `%s'", psz_dir );
-                RemoveDirToMonitor( p_ml, psz_dir );
-            }
-            else
-            {
-                msg_Err( p_mon, "%s: %m", psz_dir );
-                FreeSQLResult( p_ml, pp_results );
-                return;
-            }
-            errno = err;
-        }
+        CheckDirectory( p_mon, id, psz_dir, timestamp, false, b_recursive );
+    }
+    FreeSQLResult( p_ml, pp_results );
+}
+
+/**
+ * @brief Ask to be notified of the changes in a directory
+ */
+static void WatchDirectory( monitoring_thread_t *p_mon, int i_dir_id,
+                            const char *psz_dir )
+{
+#ifdef HAVE_SYS_INOTIFY_H
+    if( p_mon->i_notify == -1 )
+        return;
+
+    const char *psz_path = ToLocale( psz_dir );
+    int i_wd = inotify_add_watch( p_mon->i_notify, psz_path,
+                                  IN_CREATE | IN_DELETE | IN_MOVED_FROM |
+                                  IN_MOVED_TO | IN_CLOSE_WRITE | IN_ATTRIB |
+                                  IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR );
+    LocaleFree( psz_path );
+    if( i_wd == -1 )
+    {
+        /* Typically, max_user_watches is reached */
+        msg_Warn( p_mon, "cannot watch `%s' (%m), "
+                  "directories will be checked periodically", psz_dir );
+        CloseWatches( p_mon );
+        return;
+    }
 
-        if( !S_ISDIR( s_stat.st_mode ) )
+    /* The same directory gives back the same watch */
+    for( int i = 0; i < p_mon->watches.i_size; i++ )
+        if( p_mon->watches.p_elems[i].i_wd == i_wd )
         {
-            msg_Dbg( p_mon, "Removing `%s'", psz_dir );
-            RemoveDirToMonitor( p_ml, psz_dir );
+            p_mon->watches.p_elems[i].i_dir_id = i_dir_id;
+            return;
         }
 
-        if( timestamp < s_stat.st_mtime )
+    ml_dir_watch_t watch = { .i_wd = i_wd, .i_dir_id = i_dir_id,
+                             .b_dirty = false };
+    ARRAY_APPEND( p_mon->watches, watch );
+#else
+    VLC_UNUSED( p_mon ); VLC_UNUSED( i_dir_id ); VLC_UNUSED( psz_dir );
+#endif
+}
+
+/**
+ * @brief Read the pending change notifications
+ * @return false if some were lost
+ */
+static bool ReadNotifications( monitoring_thread_t *p_mon )
+{
+#ifdef HAVE_SYS_INOTIFY_H
+    char buf[4096]
+        __attribute__ ((aligned(__alignof__(struct inotify_event))));
+    const struct inotify_event *p_event;
+    ssize_t i_len;
+    bool b_complete = true;
+
+    while( ( i_len = read( p_mon->i_notify, buf, sizeof( buf ) ) ) > 0 )
+    {
+        for( char *p = buf; p < buf + i_len;
+             p += sizeof( struct inotify_event ) + p_event->len )
         {
-            msg_Dbg( p_mon, "Adding `%s'", psz_dir );
-            ScanFiles( p_mon, id, b_recursive, NULL );
+            p_event = (const struct inotify_event *)p;
+
+            if( p_event->mask & IN_Q_OVERFLOW )
+                b_complete = false;
+
+            for( int i = 0; i < p_mon->watches.i_size; i++ )
+            {
+                if( p_mon->watches.p_elems[i].i_wd != p_event->wd )
+                    continue;
+                if( p_event->mask & IN_IGNORED )
+                    ARRAY_REMOVE( p_mon->watches, i );
+                else
+                    p_mon->watches.p_elems[i].b_dirty = true;
+                break;
+            }
         }
     }
-    FreeSQLResult( p_ml, pp_results );
+    return b_complete;
+#else
+    VLC_UNUSED( p_mon );
+    return true;
+#endif
 }
 
 /**
- * @brief Callback for input item preparser to directory monitor
+ * @brief Scan the directories which changed since the last pass
  */
-static void PreparseComplete( const vlc_event_t * p_event, void *p_data )
+static void UpdateChangedDirs( monitoring_thread_t *p_mon )
 {
-    int i_ret = VLC_SUCCESS;
-    preparsed_item_t* p_itemobject = (preparsed_item_t*) p_data;
-    monitoring_thread_t *p_mon = p_itemobject->p_mon;
-    media_library_t *p_ml = (media_library_t *)p_mon->p_ml;
-    input_item_t *p_input = (input_item_t*) p_event->p_obj;
+    media_library_t *p_ml = p_mon->p_ml;
+    char **pp_results;
+    int i_rows, i_cols;
+
+    if( p_mon->i_notify == -1 )
+        return;
+    if( !ReadNotifications( p_mon ) )
+    {
+        msg_Warn( p_mon, "change notifications lost, checking all directories" );
+        for( int i = 0; i < p_mon->watches.i_size; i++ )
+            p_mon->watches.p_elems[i].b_dirty = true;
+    }
+
+    bool b_recursive = var_GetBool( p_mon, "ml-recursive-scan" );
+
+    /* Scanning can add watches (new sub-directories), the array may move */
+    for( int i = 0; i < p_mon->watches.i_size; i++ )
+    {
+        if( !p_mon->watches.p_elems[i].b_dirty )
+            continue;
+        p_mon->watches.p_elems[i].b_dirty = false;
+
+        int id = p_mon->watches.p_elems[i].i_dir_id;
+        if( Query( p_ml, &pp_results, &i_rows, &i_cols,
+                   "SELECT uri AS directory_uri FROM directories WHERE id = %d",
+                   id ) != VLC_SUCCESS )
+            continue;
+        if( i_rows >= 1 )
+            CheckDirectory( p_mon, id, pp_results[1], 0, true, b_recursive );
+        FreeSQLResult( p_ml, pp_results );
+    }
+}
+
+static void FreePreparsedItem( preparsed_item_t *p_itemobject )
+{
+    if( p_itemobject->p_media )
+        ml_gc_decref( p_itemobject->p_media );
+    vlc_gc_decref( p_itemobject->p_input );
+    free( p_itemobject->psz_uri );
+    free( p_itemobject );
+}
+
+static int SetMediaDirectory( media_library_t *p_ml, int i_media_id,
+                              int i_dir_id, int i_mtime )
+{
+    sql_t *p_sql = p_ml->p_sys->p_sql;
+    int i_ret = VLC_EGENERIC;
+
+    sql_stmt_t *p_stmt = sql_GetStatement( p_sql,
+            "UPDATE media SET directory_id = ?, timestamp = ? WHERE id = ?" );
+    if( !p_stmt )
+        return VLC_EGENERIC;
+    if( sql_BindInteger( p_sql, p_stmt, 1, i_dir_id ) == VLC_SUCCESS
+     && sql_BindInteger( p_sql, p_stmt, 2, i_mtime ) == VLC_SUCCESS
+     && sql_BindInteger( p_sql, p_stmt, 3, i_media_id ) == VLC_SUCCESS
+     && sql_Run( p_sql, p_stmt ) == VLC_SQL_DONE )
+        i_ret = VLC_SUCCESS;
+    sql_PutStatement( p_sql, p_stmt );
+    return i_ret;
+}
+
+/**
+ * @brief Add a new media within the batch transaction
+ *
+ * A savepoint isolates the media, so that a failure only drops this one.
+ */
+static void ImportItem( media_library_t *p_ml, preparsed_item_t *p_itemobject )
+{
+    input_item_t *p_input = p_itemobject->p_input;
+
+    int i_id = GetMediaIdOfInputItem( p_ml, p_input );
+    if( i_id > 0 )
+    {
+        msg_Dbg( p_ml, "Item already in Media Library (id: %d)", i_id );
+        SetMediaDirectory( p_ml, i_id, p_itemobject->i_dir_id,
+                           p_itemobject->i_mtime );
+        return;
+    }
+
+    ml_media_t *p_media = media_New( p_ml, 0, ML_MEDIA, false );
+    if( !p_media )
+        return;
+    CopyInputItemToMedia( p_media, p_input );
+
+    QuerySimple( p_ml, "SAVEPOINT import_item" );
+    ml_LockMedia( p_media );
+    int i_ret = InsertMedia( p_ml, p_media );
+    ml_UnlockMedia( p_media );
+    if( i_ret == VLC_SUCCESS )
+        i_ret = SetMediaDirectory( p_ml, p_media->i_id,
+                                   p_itemobject->i_dir_id,
+                                   p_itemobject->i_mtime );
+    if( i_ret == VLC_SUCCESS )
+    {
+        QuerySimple( p_ml, "RELEASE import_item" );
+        p_itemobject->p_media = p_media;
+    }
+    else
+    {
+        msg_Dbg( p_ml, "Item could not be added during scan: %s",
+                 p_input->psz_uri );
+        QuerySimple( p_ml, "ROLLBACK TO import_item" );
+        QuerySimple( p_ml, "RELEASE import_item" );
+        ml_gc_decref( p_media );
+    }
+}
+
+/**
+ * @brief Write a batch of preparsed items to the database
+ */
+static void ImportBatch( media_library_t *p_ml, preparsed_item_t *p_batch )
+{
+    preparsed_item_t *p_itemobject;
+    bool b_done = false;
+
+    if( Begin( p_ml ) == VLC_SUCCESS )
+    {
+        for( p_itemobject = p_batch; p_itemobject;
+             p_itemobject = p_itemobject->p_next )
+            if( !p_itemobject->b_update
+             && input_item_IsPreparsed( p_itemobject->p_input ) )
+                ImportItem( p_ml, p_itemobject );
+
+        if( sql_CommitTransaction( p_ml->p_sys->p_sql ) == VLC_SUCCESS )
+            b_done = true;
+        else
+            Rollback( p_ml );
+    }
+    if( !b_done )
+        msg_Warn( p_ml, "batch import failed, adding media one by one" );
 
-    if( input_item_IsPreparsed( p_input ) )
+    while( ( p_itemobject = p_batch ) != NULL )
     {
-        if( p_itemobject->b_update )
+        input_item_t *p_input = p_itemobject->p_input;
+        ml_media_t *p_media = p_itemobject->p_media;
+        int i_ret = VLC_SUCCESS;
+
+        p_batch = p_itemobject->p_next;
+        if( !input_item_IsPreparsed( p_input ) )
+            ;
+        else if( p_itemobject->b_update )
         {
             //TODO: Perhaps we don't have to load everything?
-            ml_media_t* p_media = GetMedia( p_ml, p_itemobject->i_update_id,
-                    ML_MEDIA_SPARSE, true );
+            p_media = GetMedia( p_ml, p_itemobject->i_update_id,
+                                ML_MEDIA_SPARSE, true );
             CopyInputItemToMedia( p_media, p_input );
             i_ret = UpdateMedia( p_ml, p_media );
             ml_gc_decref( p_media );
+            SetMediaDirectory( p_ml, p_itemobject->i_update_id,
+                               p_itemobject->i_dir_id, p_itemobject->i_mtime );
+        }
+        else if( b_done )
+        {
+            /* Announce the media once they are committed */
+            if( p_media && pool_InsertMedia( p_ml, p_media, false )
+                                                            == VLC_SUCCESS )
+            {
+                watch_add_Item( p_ml, p_input, p_media );
+                var_SetInteger( p_ml, "media-added", p_media->i_id );
+            }
         }
         else
+        {
             i_ret = AddInputItem( p_ml, p_input );
+            SetMediaDirectory( p_ml, GetMediaIdOfURI( p_ml, p_input->psz_uri ),
+                               p_itemobject->i_dir_id, p_itemobject->i_mtime );
+        }
+
+        if( i_ret != VLC_SUCCESS )
+            msg_Dbg( p_ml, "Item could not be correctly added"
+                    " or updated during scan: %s", p_input->psz_uri );
+        FreePreparsedItem( p_itemobject );
+    }
+}
+
+static void *RunImportThread( void *data )
+{
+    import_thread_t *p_imp = data;
+
+    for( ;; )
+    {
+        preparsed_item_t *p_batch;
+
+        vlc_mutex_lock( &p_imp->lock );
+        mutex_cleanup_push( &p_imp->lock );
+        while( p_imp->p_first == NULL )
+            vlc_cond_wait( &p_imp->wait, &p_imp->lock );
+
+        /* Let the preparsers fill the batch up */
+        mtime_t deadline = mdate() + IMPORT_DELAY;
+        while( p_imp->i_count < IMPORT_BATCH
+            && vlc_cond_timedwait( &p_imp->wait, &p_imp->lock, deadline ) == 0 );
+
+        p_batch = p_imp->p_first;
+        p_imp->p_first = NULL;
+        p_imp->pp_last = &p_imp->p_first;
+        p_imp->i_count = 0;
+        vlc_cleanup_run();
+
+        int canc = vlc_savecancel();
+        ImportBatch( p_imp->p_ml, p_batch );
+        vlc_restorecancel( canc );
+    }
+    return NULL;
+}
+
+/**
+ * @brief Start the thread writing the media found by the scans
+ */
+int import_Init( media_library_t *p_ml )
+{
+    import_thread_t *p_imp = malloc( sizeof( *p_imp ) );
+    if( !p_imp )
+        return VLC_ENOMEM;
+
+    p_imp->p_ml = p_ml;
+    p_imp->p_first = NULL;
+    p_imp->pp_last = &p_imp->p_first;
+    p_imp->i_count = 0;
+    vlc_mutex_init( &p_imp->lock );
+    vlc_cond_init( &p_imp->wait );
+
+    if( vlc_clone( &p_imp->thread, RunImportThread, p_imp,
+                   VLC_THREAD_PRIORITY_LOW ) )
+    {
+        msg_Err( p_ml, "cannot spawn the media library import thread" );
+        vlc_cond_destroy( &p_imp->wait );
+        vlc_mutex_destroy( &p_imp->lock );
+        free( p_imp );
+        return VLC_EGENERIC;
     }
+    p_ml->p_sys->p_import = p_imp;
+    return VLC_SUCCESS;
+}
+
+/**
+ * @brief Stop the import thread, dropping the items not written yet
+ */
+void import_Close( media_library_t *p_ml )
+{
+    import_thread_t *p_imp = p_ml->p_sys->p_import;
+
+    vlc_cancel( p_imp->thread );
+    vlc_join( p_imp->thread, NULL );
+
+    while( p_imp->p_first )
+    {
+        preparsed_item_t *p_itemobject = p_imp->p_first;
+        p_imp->p_first = p_itemobject->p_next;
+        FreePreparsedItem( p_itemobject );
+    }
+    vlc_cond_destroy( &p_imp->wait );
+    vlc_mutex_destroy( &p_imp->lock );
+    free( p_imp );
+    p_ml->p_sys->p_import = NULL;
+}
+
+/**
+ * @brief Callback for input item preparser to directory monitor
+ *
+ * This runs on the preparser threads: the database is written by the import
+ * thread, in batches.
+ */
+static void PreparseComplete( const vlc_event_t * p_event, void *p_data )
+{
+    preparsed_item_t* p_itemobject = (preparsed_item_t*) p_data;
+    import_thread_t *p_imp = p_itemobject->p_mon->p_ml->p_sys->p_import;
+    input_item_t *p_input = (input_item_t*) p_event->p_obj;
 
-    if( i_ret != VLC_SUCCESS )
-        msg_Dbg( p_mon, "Item could not be correctly added"
-                " or updated during scan: %s", p_input->psz_uri );
-    QuerySimple( p_ml, "UPDATE media SET directory_id=%d, timestamp=%d "
-                          "WHERE id=%d",
-                    p_itemobject->i_dir_id, p_itemobject->i_mtime,
-                    GetMediaIdOfURI( p_ml, p_input->psz_uri ) );
     vlc_event_detach( &p_input->event_manager, vlc_InputItemPreparsedChanged,
                   PreparseComplete, p_itemobject );
-    vlc_gc_decref( p_input );
-    free( p_itemobject->psz_uri );
+
+    vlc_mutex_lock( &p_imp->lock );
+    *p_imp->pp_last = p_itemobject;
+    p_imp->pp_last = &p_itemobject->p_next;
+    if( ++p_imp->i_count == 1 || p_imp->i_count >= IMPORT_BATCH )
+        vlc_cond_signal( &p_imp->wait );
+    vlc_mutex_unlock( &p_imp->lock );
 }
 
 /**
@@ -381,6 +791,9 @@ static void ScanFiles( monitoring_thread_t *p_mon, int i_dir_id,
 #endif
     stself.parent = stparent;
 
+    /* Before reading it, so that no change can be missed */
+    WatchDirectory( p_mon, i_dir_id, psz_dir );
+
     QuerySimple( p_ml, "UPDATE directories SET timestamp=%d WHERE id = %d",
                     stself.st.st_mtime, i_dir_id );
     Query( p_ml, &ppsz_monitored_files, &i_mon_rows, &i_mon_cols,
@@ -485,6 +898,9 @@ static void ScanFiles( monitoring_thread_t *p_mon, int i_dir_id,
                 playlist_t* p_pl = pl_Get( p_mon );
                 preparsed_item_t* p_itemobject;
                 p_itemobject = malloc( sizeof( preparsed_item_t ) );
+                p_itemobject->p_input = p_input;
+                p_itemobject->p_next = NULL;
+                p_itemobject->p_media = NULL;
                 p_itemobject->i_dir_id = i_dir_id;
                 p_itemobject->psz_uri = psz_encoded_uri;
                 p_itemobject->i_mtime = s_stat.st_mtime;
@@ -27,6 +27,41 @@
 
 #include "sql_media_library.h"
 
+static void FreeBinds( ml_binds_t *p_binds )
+{
+    char *psz_value;
+    FOREACH_ARRAY( psz_value, (*p_binds) )
+        free( psz_value );
+    FOREACH_END()
+    ARRAY_RESET( (*p_binds) );
+}
+
+/**
+ * @brief Run a query from BuildSelect() and convert its results
+ */
+static int RunSelect( media_library_t *p_ml, vlc_array_t *p_result_array,
+                      char *psz_query, const ml_binds_t *p_binds,
+                      ml_result_type_e result_type )
+{
+    char **pp_results = NULL;
+    int i_cols, i_rows;
+
+    int i_ret = QueryStatement( p_ml, &pp_results, &i_rows, &i_cols,
+                                psz_query, p_binds );
+    free( psz_query );
+    if( i_ret != VLC_SUCCESS )
+    {
+        msg_Err( p_ml, "Error occured while making the query to the database" );
+        return VLC_EGENERIC;
+    }
+
+    i_ret = SQLToResultArray( p_ml, p_result_array, pp_results, i_rows, i_cols,
+                              result_type );
+
+    FreeStatementResult( pp_results, i_rows, i_cols );
+    return i_ret;
+}
+
 int Find( media_library_t *p_ml, vlc_array_t *p_result_array, ... )
 {
     va_list args;
@@ -52,30 +87,19 @@ int FindVa( media_library_t *p_ml,
 {
     int i_ret = VLC_SUCCESS;
     char *psz_query;
+    ml_binds_t binds;
     ml_result_type_e result_type;
-    char **pp_results = NULL;
-    int i_cols, i_rows;
 
     if( !p_result_array )
         return VLC_EGENERIC;
 
-    i_ret = BuildSelectVa( p_ml, &psz_query, &result_type, criterias );
-    if( i_ret != VLC_SUCCESS )
-        return i_ret;
-
-    if( Query( p_ml, &pp_results, &i_rows, &i_cols, "%s", psz_query )
-        != VLC_SUCCESS )
-    {
-        msg_Err( p_ml, "Error occured while making the query to the database" );
-        return VLC_EGENERIC;
-    }
-
-    i_ret = SQLToResultArray( p_ml, p_result_array, pp_results, i_rows, i_cols,
-                              result_type );
-
-    free( psz_query);
-    FreeSQLResult( p_ml, pp_results );
+    ARRAY_INIT( binds );
+    i_ret = BuildSelectVa( p_ml, &psz_query, &binds, &result_type, criterias );
+    if( i_ret == VLC_SUCCESS )
+        i_ret = RunSelect( p_ml, p_result_array, psz_query, &binds,
+                           result_type );
 
+    FreeBinds( &binds );
     return i_ret;
 }
 
@@ -94,32 +118,20 @@ int FindAdv( media_library_t *p_ml, vlc_array_t *p_result_array,
 {
     int i_ret = VLC_SUCCESS;
     char *psz_query;
+    ml_binds_t binds;
     ml_result_type_e result_type;
-    char **pp_results = NULL;
-    int i_cols, i_rows;
 
     if( !p_result_array )
         return VLC_EGENERIC;
 
-    i_ret = BuildSelect( p_ml, &psz_query, &result_type, psz_lvalue,
+    ARRAY_INIT( binds );
+    i_ret = BuildSelect( p_ml, &psz_query, &binds, &result_type, psz_lvalue,
                          selected_type, tree );
+    if( i_ret == VLC_SUCCESS )
+        i_ret = RunSelect( p_ml, p_result_array, psz_query, &binds,
+                           result_type );
 
-    if( i_ret != VLC_SUCCESS )
-        return i_ret;
-
-    if( Query( p_ml, &pp_results, &i_rows, &i_cols, "%s", psz_query )
-        != VLC_SUCCESS )
-    {
-        msg_Err( p_ml, "Error occured while making the query to the database" );
-        return VLC_EGENERIC;
-    }
-
-    i_ret = SQLToResultArray( p_ml, p_result_array, pp_results, i_rows, i_cols,
-                              result_type );
-
-    free( psz_query);
-    FreeSQLResult( p_ml, pp_results );
-
+    FreeBinds( &binds );
     return i_ret;
 }
 
@@ -128,6 +140,7 @@ int FindAdv( media_library_t *p_ml, vlc_array_t *p_result_array,
  *
  * @param p_ml This media_library_t object
  * @param ppsz_query *ppsz_query will contain query
+ * @param p_binds will contain the values bound to the query parameters
  * @param p_result_type see enum ml_result_type_e
  * @param criterias list of criterias used in SELECT
  * @return VLC_SUCCESS or a VLC error code
@@ -137,7 +150,8 @@ int FindAdv( media_library_t *p_ml, vlc_array_t *p_result_array,
  * of 'normal' types: int and strings
  */
 int BuildSelectVa( media_library_t *p_ml, char **ppsz_query,
-                   ml_result_type_e *p_result_type, va_list criterias )
+                   ml_binds_t *p_binds, ml_result_type_e *p_result_type,
+                   va_list criterias )
 {
     int i_continue = 1;
     ml_ftree_t* p_ftree = NULL;
@@ -202,8 +216,8 @@ int BuildSelectVa( media_library_t *p_ml, char **ppsz_query,
         }
     }
 
-    int i_ret = BuildSelect( p_ml, ppsz_query, p_result_type, psz_lvalue,
-                             selected_type, p_ftree );
+    int i_ret = BuildSelect( p_ml, ppsz_query, p_binds, p_result_type,
+                             psz_lvalue, selected_type, p_ftree );
 
     ml_ShallowFreeFindTree( p_ftree );
     return i_ret;
@@ -260,7 +274,7 @@ static int AppendStringFmt( media_library_t *p_ml,
 /* Early Declaration of Where String Generator */
 static int BuildWhere( media_library_t* p_ml, char **ppsz_where, ml_ftree_t* tree,
        char** sort, int* limit, const char** distinct, char*** pppsz_frompersons,
-       int* i_frompersons, int* join );
+       int* i_frompersons, int* join, ml_binds_t* binds );
 
 #   define table_media             (1 << 0)
 #   define table_album             (1 << 1)
@@ -287,13 +301,15 @@ static void PackFromPersons( char*** pppsz_frompersons, int i_num_frompersons )
  *
  * @param p_ml This media_library_t object
  * @param ppsz_query *ppsz_query will contain query
+ * @param p_binds will contain the values bound to the query parameters
  * @param p_result_type see enum ml_result_type_e
  * @param selected_type the type of the element we're selecting
  * @param tree the find tree
  * @return VLC_SUCCESS or VLC_EGENERIC
  */
 int BuildSelect( media_library_t *p_ml,
-                 char **ppsz_query, ml_result_type_e *p_result_type,
+                 char **ppsz_query, ml_binds_t *p_binds,
+                 ml_result_type_e *p_result_type,
                  const char *psz_selected_type_lvalue, ml_select_e selected_type,
                  ml_ftree_t *tree )
 {
@@ -338,7 +354,8 @@ int BuildSelect( media_library_t *p_ml,
 
     /* Build the WHERE condition */
     BuildWhere( p_ml, &psz_where, tree, &psz_sort, &i_limit,
-            &psz_distinct, &ppsz_frompersons, &i_num_frompersons, &i_join );
+            &psz_distinct, &ppsz_frompersons, &i_num_frompersons, &i_join,
+            p_binds );
 
     PackFromPersons( &ppsz_frompersons, i_num_frompersons );
 
@@ -880,24 +897,118 @@ break
 #undef CASE_PSZ
 #define CASE_PSZ( casestr, fmt, table )                                       \
 case casestr:                                                                 \
-    assert( tree->comp == ML_COMP_HAS || tree->comp == ML_COMP_EQUAL          \
-        || tree->comp == ML_COMP_STARTS_WITH                                  \
-        || tree->comp == ML_COMP_ENDS_WITH );                                 \
-    *ppsz_where = sql_Printf( p_ml->p_sys->p_sql, "%s LIKE '%s%q%s'", fmt,    \
-        tree->comp == ML_COMP_HAS                                             \
-        || tree->comp == ML_COMP_STARTS_WITH? "%%" : "",                      \
-            tree->value.str,                                                  \
-        tree->comp == ML_COMP_HAS                                             \
-        || tree->comp == ML_COMP_ENDS_WITH? "%%" : "" );                      \
+    *ppsz_where = BuildStringCond( p_ml, binds, fmt, NULL, tree );            \
     if( *ppsz_where == NULL )                                                 \
         goto parsefail;                                                       \
     *join |= table;                                                           \
     break
 
-#define SLDPJ sort, limit, distinct, pppsz_frompersons, i_frompersons, join
+/* Same as CASE_PSZ, for media columns indexed in the media_search table */
+#undef CASE_FTS
+#define CASE_FTS( casestr, fmt, fts )                                         \
+case casestr:                                                                 \
+    *ppsz_where = BuildStringCond( p_ml, binds, fmt, fts, tree );             \
+    if( *ppsz_where == NULL )                                                 \
+        goto parsefail;                                                       \
+    *join |= table_media;                                                     \
+    break
+
+/**
+ * @brief Turn a searched string into a full-text query, matching the text
+ * with words starting with each word of the string
+ *
+ * Words are split as by the FTS "simple" tokenizer: runs of ASCII letters
+ * and digits, and of non-ASCII characters. Each word is quoted so that
+ * FTS operators (OR, NEAR...) in the string are searched for as words.
+ * @return the query, or NULL if the string has no word
+ */
+static char *BuildMatchQuery( const char *psz_value )
+{
+    /* Worst case: one-letter words, each becoming '"x*" ' */
+    char *psz_match = malloc( 5 * strlen( psz_value ) + 1 );
+    if( !psz_match )
+        return NULL;
+
+    char *psz_out = psz_match;
+    while( *psz_value )
+    {
+        size_t i_word = 0;
+        for( ;; )
+        {
+            unsigned char c = psz_value[i_word];
+            if( !( c >= 0x80 || ( c >= '0' && c <= '9' )
+                || ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' ) ) )
+                break;
+            i_word++;
+        }
+        if( i_word == 0 )
+        {
+            psz_value++;
+            continue;
+        }
+        if( psz_out != psz_match )
+            *psz_out++ = ' ';
+        *psz_out++ = '"';
+        memcpy( psz_out, psz_value, i_word );
+        psz_out += i_word;
+        *psz_out++ = '*';
+        *psz_out++ = '"';
+        psz_value += i_word;
+    }
+    *psz_out = '\0';
+
+    if( psz_out == psz_match )
+    {
+        free( psz_match );
+        return NULL;
+    }
+    return psz_match;
+}
+
+/**
+ * @brief Build the condition on a string column, and bind its value
+ *
+ * @param psz_column the column
+ * @param psz_fts the media_search column indexing psz_column, or NULL
+ * @return the condition or NULL on error
+ * @note With the full-text index, ML_COMP_HAS matches the words starting
+ * with the searched words, rather than any substring.
+ */
+static char *BuildStringCond( media_library_t *p_ml, ml_binds_t *p_binds,
+                              const char *psz_column, const char *psz_fts,
+                              const ml_ftree_t *tree )
+{
+    assert( tree->comp == ML_COMP_HAS || tree->comp == ML_COMP_EQUAL
+        || tree->comp == ML_COMP_STARTS_WITH
+        || tree->comp == ML_COMP_ENDS_WITH );
+    const char *psz_value = tree->value.str ? tree->value.str : "";
+    char *psz_bind = NULL;
+
+    if( psz_fts && tree->comp == ML_COMP_HAS && p_ml->p_sys->b_search_index
+     && ( psz_bind = BuildMatchQuery( psz_value ) ) != NULL )
+    {
+        ARRAY_APPEND( (*p_binds), psz_bind );
+        return sql_Printf( p_ml->p_sys->p_sql, "media.id IN ( SELECT docid "
+                           "FROM media_search WHERE %s MATCH ? )", psz_fts );
+    }
+
+    if( asprintf( &psz_bind, "%s%s%s",
+            tree->comp == ML_COMP_HAS
+            || tree->comp == ML_COMP_STARTS_WITH ? "%" : "",
+            psz_value,
+            tree->comp == ML_COMP_HAS
+            || tree->comp == ML_COMP_ENDS_WITH ? "%" : "" ) == -1 )
+        return NULL;
+    ARRAY_APPEND( (*p_binds), psz_bind );
+    return sql_Printf( p_ml->p_sys->p_sql, "%s LIKE ?", psz_column );
+}
+
+#define SLDPJ sort, limit, distinct, pppsz_frompersons, i_frompersons, join, \
+              binds
 static int BuildWhere( media_library_t* p_ml, char **ppsz_where, ml_ftree_t* tree,
        char** sort, int* limit, const char** distinct,
-       char*** pppsz_frompersons, int* i_frompersons, int* join )
+       char*** pppsz_frompersons, int* i_frompersons, int* join,
+       ml_binds_t* binds )
 {
     assert( ppsz_where && sort && distinct );
     if( !tree ) /* Base case */
@@ -906,6 +1017,7 @@ static int BuildWhere( media_library_t* p_ml, char **ppsz_where, ml_ftree_t* tre
     }
 
     int i_ret = VLC_EGENERIC;
+    int i_binds;
     char* psz_left = NULL;
     char* psz_right = NULL;
 
@@ -949,9 +1061,16 @@ static int BuildWhere( media_library_t* p_ml, char **ppsz_where, ml_ftree_t* tre
             }
             break;
         case ML_OP_SPECIAL:
+            i_binds = binds->i_size;
             i_ret = BuildWhere( p_ml, &psz_right, tree->right, SLDPJ );
             if( i_ret != VLC_SUCCESS )
                 goto parsefail;
+            /* The values of the right tree are not in the condition */
+            while( binds->i_size > i_binds )
+            {
+                free( ARRAY_VAL( (*binds), binds->i_size - 1 ) );
+                ARRAY_REMOVE( (*binds), binds->i_size - 1 );
+            }
             i_ret = BuildWhere( p_ml, &psz_left, tree->left, SLDPJ );
             if( i_ret != VLC_SUCCESS )
                 goto parsefail;
@@ -971,15 +1090,14 @@ static int BuildWhere( media_library_t* p_ml, char **ppsz_where, ml_ftree_t* tre
                             || tree->comp == ML_COMP_EQUAL
                             || tree->comp == ML_COMP_STARTS_WITH
                             || tree->comp == ML_COMP_ENDS_WITH );
-                    *ppsz_where = sql_Printf( p_ml->p_sys->p_sql,
-                            "people%s%s.name LIKE '%s%q%s'",
+                    psz_left = sql_Printf( p_ml->p_sys->p_sql,
+                            "people%s%s.name",
                             tree->lvalue.str ? "_" : "",
-                            tree->lvalue.str ? tree->lvalue.str : "",
-                            tree->comp == ML_COMP_HAS
-                            || tree->comp == ML_COMP_STARTS_WITH ? "%%" : "",
-                            tree->value.str,
-                            tree->comp == ML_COMP_HAS
-                            || tree->comp == ML_COMP_ENDS_WITH ? "%%" : "" );
+                            tree->lvalue.str ? tree->lvalue.str : "" );
+                    if( psz_left == NULL )
+                        goto parsefail;
+                    *ppsz_where = BuildStringCond( p_ml, binds, psz_left,
+                                                   NULL, tree );
                     if( *ppsz_where == NULL )
                         goto parsefail;
                     *pppsz_frompersons = realloc( *pppsz_frompersons,
@@ -1005,15 +1123,14 @@ static int BuildWhere( media_library_t* p_ml, char **ppsz_where, ml_ftree_t* tre
                             || tree->comp == ML_COMP_EQUAL
                             || tree->comp == ML_COMP_STARTS_WITH
                             || tree->comp == ML_COMP_ENDS_WITH );
-                    *ppsz_where = sql_Printf( p_ml->p_sys->p_sql,
-                            "people%s%s.role LIKE '%s%q%s'",
+                    psz_left = sql_Printf( p_ml->p_sys->p_sql,
+                            "people%s%s.role",
                             tree->lvalue.str ? "_" : "",
-                            tree->lvalue.str ? tree->lvalue.str : "",
-                            tree->comp == ML_COMP_HAS
-                            || tree->comp == ML_COMP_STARTS_WITH ? "%%" : "",
-                            tree->value.str,
-                            tree->comp == ML_COMP_HAS
-                            || tree->comp == ML_COMP_ENDS_WITH ? "%%" : "" );
+                            tree->lvalue.str ? tree->lvalue.str : "" );
+                    if( psz_left == NULL )
+                        goto parsefail;
+                    *ppsz_where = BuildStringCond( p_ml, binds, psz_left,
+                                                   NULL, tree );
                     if( *ppsz_where == NULL )
                         goto parsefail;
                     *pppsz_frompersons = realloc( *pppsz_frompersons,
@@ -1036,7 +1153,7 @@ static int BuildWhere( media_library_t* p_ml, char **ppsz_where, ml_ftree_t* tre
                 CASE_INT( ML_DURATION, "media.duration", table_media );
                 CASE_PSZ( ML_EXTRA, "extra.extra", table_extra );
                 CASE_INT( ML_FILESIZE, "media.filesize", table_media );
-                CASE_PSZ( ML_GENRE, "media.genre", table_media );
+                CASE_FTS( ML_GENRE, "media.genre", "genre" );
                 case ML_ID:
                     assert( tree->comp == ML_COMP_EQUAL );
                     *ppsz_where = sql_Printf( p_ml->p_sys->p_sql,
@@ -1051,7 +1168,7 @@ static int BuildWhere( media_library_t* p_ml, char **ppsz_where, ml_ftree_t* tre
                    msg_Warn( p_ml, "Deprecated Played Count tags" );
                 CASE_INT( ML_PLAYED_COUNT, "media.played_count", table_media );
                 CASE_INT( ML_SCORE, "media.score", table_media );
-                CASE_PSZ( ML_TITLE, "media.title", table_media );
+                CASE_FTS( ML_TITLE, "media.title", "title" );
                 CASE_INT( ML_TRACK_NUMBER, "media.track", table_media);
                 CASE_INT( ML_TYPE, "media.type", table_media );
                 CASE_PSZ( ML_URI, "media.uri", table_media );
@@ -1103,6 +1220,7 @@ parsefail:
 
 #   undef CASE_INT
 #   undef CASE_PSZ
+#   undef CASE_FTS
 
 #   undef table_media
 #   undef table_album
@@ -69,6 +69,13 @@ int Update( media_library_t *p_ml, ml_select_e selected_type,
             != VLC_SUCCESS )
         goto quitdelete;
 
+    /* Rows 1 to i_rows hold the ids of the updated media */
+    if( selected_type == ML_MEDIA )
+        for( int i = 1; i <= i_rows; i++ )
+            if( UpdateSearchIndex( p_ml, atoi( pp_results[i*i_cols] ) )
+                    != VLC_SUCCESS )
+                goto quitdelete;
+
     i_ret = VLC_SUCCESS;
 quitdelete:
     if( i_ret != VLC_SUCCESS )
@@ -53,6 +53,9 @@
 #include <gcrypt.h>
 #include <gnutls/gnutls.h>
 #include <gnutls/x509.h>
+#if (GNUTLS_VERSION_NUMBER >= 0x030703)
+# include <gnutls/socket.h>
+#endif
 
 #include <vlc_gcrypt.h>
 #include "dhparams.h"
@@ -201,6 +204,78 @@ struct vlc_tls_sys
 };
 
 
+/*
+ * Client sessions kept for resumption, by server name, so that reconnecting
+ * to the same server (e.g. for each HTTP Live Streaming or DASH segment)
+ * skips the key exchange and certificate transmission. They are kept until
+ * the process exits, as the plugin stays loaded.
+ */
+#define SESSION_CACHE_SIZE 16
+
+static struct
+{
+    char          *hostname;
+    gnutls_datum_t data;
+} session_cache[SESSION_CACHE_SIZE];
+static unsigned session_cache_next = 0;
+static vlc_mutex_t session_cache_mutex = VLC_STATIC_MUTEX;
+
+/**
+ * Sets the parameters of the last session with a server, if any, so that
+ * the handshake tries to resume it.
+ */
+static void gnutls_SessionLoad (gnutls_session_t session, const char *hostname)
+{
+    vlc_mutex_lock (&session_cache_mutex);
+    for (unsigned i = 0; i < SESSION_CACHE_SIZE; i++)
+        if (session_cache[i].hostname != NULL
+         && !strcmp (session_cache[i].hostname, hostname))
+        {
+            gnutls_session_set_data (session, session_cache[i].data.data,
+                                     session_cache[i].data.size);
+            break;
+        }
+    vlc_mutex_unlock (&session_cache_mutex);
+}
+
+/**
+ * Keeps the parameters of a session for later resumption. This is done when
+ * closing the session, as TLS 1.3 servers send tickets after the handshake.
+ */
+static void gnutls_SessionSave (gnutls_session_t session, const char *hostname)
+{
+    gnutls_datum_t data;
+
+    if (gnutls_session_get_data2 (session, &data))
+        return;
+
+    vlc_mutex_lock (&session_cache_mutex);
+    unsigned i;
+    for (i = 0; i < SESSION_CACHE_SIZE; i++)
+        if (session_cache[i].hostname != NULL
+         && !strcmp (session_cache[i].hostname, hostname))
+            break;
+
+    if (i == SESSION_CACHE_SIZE)
+    {   /* replace the oldest entry */
+        char *dup = strdup (hostname);
+        if (unlikely(dup == NULL))
+        {
+            vlc_mutex_unlock (&session_cache_mutex);
+            gnutls_free (data.data);
+            return;
+        }
+        i = session_cache_next;
+        session_cache_next = (i + 1) % SESSION_CACHE_SIZE;
+        free (session_cache[i].hostname);
+        session_cache[i].hostname = dup;
+    }
+    gnutls_free (session_cache[i].data.data);
+    session_cache[i].data = data;
+    vlc_mutex_unlock (&session_cache_mutex);
+}
+
+
 /**
  * Sends data through a TLS session.
  */
@@ -256,6 +331,14 @@ static int gnutls_ContinueHandshake (vlc_tls_t *session)
     }
 
     sys->handshaked = true;
+    if (gnutls_session_is_resumed (sys->session))
+        msg_Dbg (session, "TLS session resumed");
+#if (GNUTLS_VERSION_NUMBER >= 0x030703)
+    /* Records are then encrypted and decrypted by the kernel, if GnuTLS is
+     * configured to offload them (ktls = true in its system configuration) */
+    if (gnutls_transport_is_ktls_enabled (sys->session) == GNUTLS_KTLS_DUPLEX)
+        msg_Dbg (session, "TLS records offloaded to the kernel");
+#endif
     return 0;
 }
 
@@ -620,6 +703,11 @@ static int OpenClient (vlc_tls_t *session, int fd, const char *hostname)
         sys->hostname = strdup (hostname);
         if (unlikely(sys->hostname == NULL))
             goto s_error;
+
+#if (GNUTLS_VERSION_NUMBER >= 0x020a00)
+        gnutls_session_ticket_enable_client (sys->session);
+#endif
+        gnutls_SessionLoad (sys->session, hostname);
     }
     else
         sys->hostname = NULL;
@@ -643,7 +731,11 @@ static void CloseClient (vlc_tls_t *session)
     vlc_tls_sys_t *sys = session->sys;
 
     if (sys->handshaked)
+    {
+        if (sys->hostname != NULL)
+            gnutls_SessionSave (sys->session, sys->hostname);
         gnutls_bye (sys->session, GNUTLS_SHUT_WR);
+    }
     gnutls_deinit (sys->session);
     /* credentials must be free'd *after* gnutls_deinit() */
     gnutls_certificate_free_credentials (sys->x509_cred);
@@ -661,6 +753,7 @@ struct vlc_tls_creds_sys
 {
     gnutls_certificate_credentials_t x509_cred;
     gnutls_dh_params_t               dh_params;
+    gnutls_datum_t                   ticket_key; /* for session resumption */
     int                            (*handshake) (vlc_tls_t *);
 };
 
@@ -732,6 +825,11 @@ static vlc_tls_t *gnutls_SessionOpen (vlc_tls_creds_t *server, int fd)
         goto error;
     }
 
+#if (GNUTLS_VERSION_NUMBER >= 0x020a00)
+    if (ssys->ticket_key.data != NULL)
+        gnutls_session_ticket_enable_server (sys->session, &ssys->ticket_key);
+#endif
+
     if (session->handshake == gnutls_HandshakeAndValidate)
         gnutls_certificate_server_set_request (sys->session,
                                                GNUTLS_CERT_REQUIRE);
@@ -879,6 +977,19 @@ static int OpenServer (vlc_object_t *obj)
                  gnutls_strerror (val));
     }
 
+    /* Session tickets let returning clients skip the key exchange. The key
+     * protecting them lives as long as the credentials. */
+    sys->ticket_key.data = NULL;
+#if (GNUTLS_VERSION_NUMBER >= 0x020a00)
+    val = gnutls_session_ticket_key_generate (&sys->ticket_key);
+    if (val < 0)
+    {
+        msg_Warn (server, "cannot generate session ticket key: %s",
+                  gnutls_strerror (val));
+        sys->ticket_key.data = NULL;
+    }
+#endif
+
     return VLC_SUCCESS;
 
 error:
@@ -898,6 +1009,7 @@ static void CloseServer (vlc_object_t *obj)
     /* all sessions depending on the server are now deinitialized */
     gnutls_certificate_free_credentials (sys->x509_cred);
     gnutls_dh_params_deinit (sys->dh_params);
+    gnutls_free (sys->ticket_key.data);
     free (sys);
 
     gnutls_Deinit (obj);
@@ -106,6 +106,11 @@ static int GetColumnTypeFromStatement( sql_t* p_sql,
 static int GetColumnSize( sql_t* p_sql,
                           sql_stmt_t* p_stmt,
                           int i_col );
+static int GetColumnCount( sql_t* p_sql,
+                           sql_stmt_t* p_stmt );
+static const char* GetColumnName( sql_t* p_sql,
+                                  sql_stmt_t* p_stmt,
+                                  int i_col );
 
 /*****************************************************************************
  * Module description
@@ -141,9 +146,9 @@ static int load( vlc_object_t *p_this )
         msg_Dbg( p_sql, "sqlite module loaded" );
     else
     {
-        free( p_sql->p_sys );
         vlc_mutex_destroy( &p_sql->p_sys->lock );
         vlc_mutex_destroy( &p_sql->p_sys->trans_lock );
+        free( p_sql->p_sys );
         return VLC_EGENERIC;
     }
 
@@ -163,6 +168,8 @@ static int load( vlc_object_t *p_this )
     p_sql->pf_gettype = GetColumnTypeFromStatement;
     p_sql->pf_getcolumn = GetColumnFromStatement;
     p_sql->pf_getcolumnsize = GetColumnSize;
+    p_sql->pf_getcolumncount = GetColumnCount;
+    p_sql->pf_getcolumnname = GetColumnName;
 
     return VLC_SUCCESS;
 }
@@ -584,7 +591,7 @@ static int StatementStep( sql_t* p_sql, sql_stmt_t* p_stmt )
     int i_ret = VLC_EGENERIC;
     if( i_sqlret == SQLITE_ROW )
         i_ret = VLC_SQL_ROW;
-    else if( i_ret == SQLITE_DONE )
+    else if( i_sqlret == SQLITE_DONE )
         i_ret = VLC_SQL_DONE;
     else
     {
@@ -753,3 +760,33 @@ static int GetColumnSize( sql_t* p_sql, sql_stmt_t* p_stmt, int i_col )
     assert( p_stmt->p_sqlitestmt );
     return sqlite3_column_bytes( p_stmt->p_sqlitestmt, i_col );
 }
+
+/**
+ * @brief Get the number of columns in the results of a statement
+ * @param p_sql The SQL object
+ * @param p_stmt The sql statement object
+ * @return Number of columns, 0 if the statement returns no data
+ */
+static int GetColumnCount( sql_t* p_sql, sql_stmt_t* p_stmt )
+{
+    assert( p_sql->p_sys->db );
+    assert( p_stmt->p_sqlitestmt );
+    return sqlite3_column_count( p_stmt->p_sqlitestmt );
+}
+
+/**
+ * @brief Get the name of a column in the results of a statement
+ * @param p_sql The SQL object
+ * @param p_stmt The sql statement object
+ * @param i_col The column
+ * @return Name of the column, NULL on error
+ */
+static const char* GetColumnName( sql_t* p_sql, sql_stmt_t* p_stmt, int i_col )
+{
+    assert( p_sql->p_sys->db );
+    assert( p_stmt->p_sqlitestmt );
+    vlc_mutex_lock( &p_sql->p_sys->lock );
+    const char* psz_name = sqlite3_column_name( p_stmt->p_sqlitestmt, i_col );
+    vlc_mutex_unlock( &p_sql->p_sys->lock );
+    return psz_name;
+}
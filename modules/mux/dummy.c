@@ -164,13 +164,12 @@ static int Mux( sout_mux_t *p_mux )
 
         p_fifo = p_mux->pp_inputs[i]->p_fifo;
         i_count = block_FifoCount( p_fifo );
-        while( i_count > 0 )
+        if( i_count > 0 )
         {
-            block_t *p_data = block_FifoGet( p_fifo );
+            /* the access writes chains as they are */
+            block_t *p_data = block_FifoGetUpTo( p_fifo, i_count, SIZE_MAX );
 
             sout_AccessOutWrite( p_mux->p_access, p_data );
-
-            i_count--;
         }
     }
     p_sys->b_header = false;
@@ -149,6 +149,11 @@ static void    Close  ( vlc_object_t * );
   "stream, compared to the PCRs. This allows for some buffering inside " \
   "the client decoder.")
 
+#define PKTS_TEXT N_("TS packets per output block")
+#define PKTS_LONGTEXT N_("Number of TS packets gathered in each block " \
+  "handed to the access output. 0 picks 7 packets (one UDP datagram) for " \
+  "network outputs, and larger blocks for files." )
+
 #define ACRYPT_TEXT N_("Crypt audio")
 #define ACRYPT_LONGTEXT N_("Crypt audio using CSA")
 #define VCRYPT_TEXT N_("Crypt video")
@@ -173,6 +178,8 @@ static void    Close  ( vlc_object_t * );
 
 #define SOUT_CFG_PREFIX "sout-ts-"
 #define MAX_PMT 64       /* Maximum number of programs. FIXME: I just chose an arbitrary number. Where is the maximum in the spec? */
+#define FILE_PACKETS_PER_BLOCK 348   /* 64 KiB of TS packets */
+#define NET_PACKETS_PER_BLOCK  7     /* one 1316 bytes UDP datagram */
 #define MAX_PMT_PID 64       /* Maximum pids in each pmt.  FIXME: I just chose an arbitrary number. Where is the maximum in the spec? */
 
 vlc_module_begin ()
@@ -217,6 +224,8 @@ vlc_module_begin ()
                  true )
     add_integer( SOUT_CFG_PREFIX "dts-delay", 400, DTS_TEXT,
                  DTS_LONGTEXT, true )
+    add_integer( SOUT_CFG_PREFIX "packets-per-block", 0, PKTS_TEXT,
+                 PKTS_LONGTEXT, true )
 
     add_bool( SOUT_CFG_PREFIX "crypt-audio", true, ACRYPT_TEXT,
               ACRYPT_LONGTEXT, true )
@@ -242,7 +251,7 @@ static const char *const ppsz_sout_options[] = {
     "netid", "sdtdesc",
     "es-id-pid", "shaping", "pcr", "bmin", "bmax", "use-key-frames",
     "dts-delay", "csa-ck", "csa2-ck", "csa-use", "csa-pkt", "crypt-audio", "crypt-video",
-    "muxpmt", "program-pmt", "alignment",
+    "muxpmt", "program-pmt", "alignment", "packets-per-block",
     NULL
 };
 
@@ -402,6 +411,8 @@ struct sout_mux_sys_t
 
     bool            b_use_key_frames;
 
+    unsigned        i_packets_per_block;
+
     mtime_t         i_pcr;  /* last PCR emited */
 
     csa_t           *csa;
@@ -759,6 +770,18 @@ static int Open( vlc_object_t *p_this )
 
     p_sys->b_use_key_frames = var_GetBool( p_mux, SOUT_CFG_PREFIX "use-key-frames" );
 
+    val.i_int = var_GetInteger( p_mux, SOUT_CFG_PREFIX "packets-per-block" );
+    if( val.i_int <= 0 )
+    {
+        const char *psz_access = p_mux->p_access->psz_access;
+
+        if( psz_access != NULL && !strcmp( psz_access, "file" ) )
+            val.i_int = FILE_PACKETS_PER_BLOCK;
+        else
+            val.i_int = NET_PACKETS_PER_BLOCK;
+    }
+    p_sys->i_packets_per_block = __MIN( val.i_int, FILE_PACKETS_PER_BLOCK );
+
     /* for TS generation */
     p_sys->i_pcr    = 0;
 
@@ -1916,6 +1939,7 @@ static void TSDate( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
 {
     sout_mux_sys_t  *p_sys = p_mux->p_sys;
     int i_packet_count = p_chain_ts->i_depth;
+    block_t *p_out = NULL;
     int i;
 
     if ( i_pcr_length / 1000 > 0 )
@@ -1970,8 +1994,52 @@ static void TSDate( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
         /* latency */
         p_ts->i_dts += p_sys->i_shaping_delay * 3 / 2;
 
-        sout_AccessOutWrite( p_mux->p_access, p_ts );
+        if( p_sys->i_packets_per_block <= 1 )
+        {
+            sout_AccessOutWrite( p_mux->p_access, p_ts );
+            continue;
+        }
+
+        /* Gather the packets, keeping random access points and PCRs at
+         * the head of an output block as the access outputs expect */
+        if( p_out != NULL &&
+            ( p_ts->i_flags & BLOCK_FLAG_TYPE_I ||
+              p_ts->i_flags & p_out->i_flags & BLOCK_FLAG_CLOCK ) )
+        {
+            sout_AccessOutWrite( p_mux->p_access, p_out );
+            p_out = NULL;
+        }
+        if( p_out == NULL )
+        {
+            unsigned i_count = __MIN( (unsigned)(i_packet_count - i),
+                                      p_sys->i_packets_per_block );
+
+            p_out = block_Alloc( i_count * 188 );
+            if( p_out == NULL )
+            {
+                block_Release( p_ts );
+                continue;
+            }
+            p_out->i_buffer = 0;
+            p_out->i_dts    = p_ts->i_dts;
+            p_out->i_length = 0;
+        }
+
+        memcpy( &p_out->p_buffer[p_out->i_buffer], p_ts->p_buffer, 188 );
+        p_out->i_buffer += 188;
+        p_out->i_length += p_ts->i_length;
+        p_out->i_flags  |= p_ts->i_flags & (BLOCK_FLAG_CLOCK|BLOCK_FLAG_TYPE_I);
+        block_Release( p_ts );
+
+        if( p_out->i_buffer == p_sys->i_packets_per_block * 188 )
+        {
+            sout_AccessOutWrite( p_mux->p_access, p_out );
+            p_out = NULL;
+        }
     }
+
+    if( p_out != NULL )
+        sout_AccessOutWrite( p_mux->p_access, p_out );
 }
 
 static block_t *TSNew( sout_mux_t *p_mux, ts_stream_t *p_stream,
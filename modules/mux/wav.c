@@ -295,19 +295,25 @@ static int Mux( sout_mux_t *p_mux )
     p_sys->b_header = false;
 
     p_input = p_mux->pp_inputs[0];
-    while( block_FifoCount( p_input->p_fifo ) > 0 )
+    size_t i_count = block_FifoCount( p_input->p_fifo );
+    if( i_count > 0 )
     {
-        block_t *p_block = block_FifoGet( p_input->p_fifo );
-        p_sys->i_data += p_block->i_buffer;
+        block_t *p_chain = block_FifoGetUpTo( p_input->p_fifo, i_count,
+                                              SIZE_MAX );
 
-        /* Do the channel reordering */
-        if( p_sys->b_chan_reorder )
-            aout_ChannelReorder( p_block->p_buffer, p_block->i_buffer,
-                                 p_input->p_fmt->audio.i_channels,
-                                 p_sys->pi_chan_table,
-                                 p_input->p_fmt->audio.i_bitspersample );
+        for( block_t *p_block = p_chain; p_block; p_block = p_block->p_next )
+        {
+            p_sys->i_data += p_block->i_buffer;
+
+            /* Do the channel reordering */
+            if( p_sys->b_chan_reorder )
+                aout_ChannelReorder( p_block->p_buffer, p_block->i_buffer,
+                                     p_input->p_fmt->audio.i_channels,
+                                     p_sys->pi_chan_table,
+                                     p_input->p_fmt->audio.i_bitspersample );
+        }
 
-        sout_AccessOutWrite( p_mux->p_access, p_block );
+        sout_AccessOutWrite( p_mux->p_access, p_chain );
     }
 
     return VLC_SUCCESS;
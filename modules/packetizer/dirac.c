@@ -86,6 +86,7 @@ vlc_module_begin()
     set_subcategory( SUBCAT_SOUT_PACKETIZER )
     set_description( N_("Dirac packetizer") )
     set_capability( "packetizer", 50 )
+    add_codec( VLC_CODEC_DIRAC )
     set_callbacks( Open, Close )
 vlc_module_end()
 
@@ -681,7 +682,7 @@ static block_t *dirac_DoSync( decoder_t *p_dec )
         case NOT_SYNCED:
         {
             if( VLC_SUCCESS !=
-                block_FindStartcodeFromOffset( &p_sys->bytestream, &p_sys->i_offset, p_parsecode, 4 ) )
+                block_FindStartcodeFromOffset( &p_sys->bytestream, &p_sys->i_offset, p_parsecode, 4, NULL ) )
             {
                 /* p_sys->i_offset will have been set to:
                  *   end of bytestream - amount of prefix found
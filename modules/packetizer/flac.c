@@ -36,6 +36,7 @@
 
 #include <vlc_block_helper.h>
 #include <vlc_bits.h>
+#include <vlc_crc.h>
 #include "packetizer_helper.h"
 
 /*****************************************************************************
@@ -49,6 +50,7 @@ vlc_module_begin()
     set_subcategory( SUBCAT_SOUT_PACKETIZER )
     set_description( N_("Flac audio packetizer") )
     set_capability( "packetizer", 50 )
+    add_codec( VLC_CODEC_FLAC )
     set_callbacks( Open, Close )
 vlc_module_end()
 
@@ -99,7 +101,14 @@ static int SyncInfo( decoder_t *, uint8_t *, unsigned int *,
                      unsigned int *, unsigned int * );
 
 static uint64_t read_utf8( const uint8_t *p_buf, int *pi_read );
-static uint8_t flac_crc8( const uint8_t *data, unsigned len );
+
+/* Sync codes begin with 0xFF, whose occurrences memchr() finds quickly */
+static const uint8_t p_flac_sync[1] = { 0xFF };
+
+static const uint8_t *FindSyncByte( const uint8_t *p, const uint8_t *end )
+{
+    return memchr( p, 0xFF, end - p );
+}
 
 static int Open( vlc_object_t *p_this )
 {
@@ -225,16 +234,24 @@ static block_t *Packetize( decoder_t *p_dec, block_t **pp_block )
         switch( p_sys->i_state )
         {
         case STATE_NOSYNC:
-            while( block_PeekBytes( &p_sys->bytestream, p_header, 2 )
+        {
+            size_t i_offset = 0;
+
+            while( block_FindStartcodeFromOffset( &p_sys->bytestream,
+                                &i_offset, p_flac_sync, 1, FindSyncByte )
                    == VLC_SUCCESS )
             {
-                if( p_header[0] == 0xFF && (p_header[1] & 0xFE) == 0xF8 )
+                if( block_PeekOffsetBytes( &p_sys->bytestream, i_offset,
+                                           p_header, 2 ) != VLC_SUCCESS )
+                    break;
+                if( (p_header[1] & 0xFE) == 0xF8 )
                 {
                     p_sys->i_state = STATE_SYNC;
                     break;
                 }
-                block_SkipByte( &p_sys->bytestream );
+                i_offset++;
             }
+            block_SkipBytes( &p_sys->bytestream, i_offset );
             if( p_sys->i_state != STATE_SYNC )
             {
                 block_BytestreamFlush( &p_sys->bytestream );
@@ -242,6 +259,7 @@ static block_t *Packetize( decoder_t *p_dec, block_t **pp_block )
                 /* Need more data */
                 return NULL;
             }
+        }
 
         case STATE_SYNC:
             /* New frame, set the Presentation Time Stamp */
@@ -290,12 +308,15 @@ static block_t *Packetize( decoder_t *p_dec, block_t **pp_block )
              * next sync word */
 
             /* Check if next expected frame contains the sync word */
-            while( block_PeekOffsetBytes( &p_sys->bytestream,
+            while( block_FindStartcodeFromOffset( &p_sys->bytestream,
+                                &p_sys->i_frame_size, p_flac_sync, 1,
+                                FindSyncByte ) == VLC_SUCCESS
+                && block_PeekOffsetBytes( &p_sys->bytestream,
                                           p_sys->i_frame_size, p_header,
                                           MAX_FLAC_HEADER_SIZE )
                    == VLC_SUCCESS )
             {
-                if( p_header[0] == 0xFF && (p_header[1] & 0xFE) == 0xF8 )
+                if( (p_header[1] & 0xFE) == 0xF8 )
                 {
                     /* Check if frame is valid and get frame info */
                     int i_frame_length =
@@ -569,7 +590,7 @@ static int SyncInfo( decoder_t *p_dec, uint8_t *p_buf,
     }
 
     /* Check the CRC-8 byte */
-    if( flac_crc8( p_buf, i_header ) != p_buf[i_header] )
+    if( vlc_crc8( 0, p_buf, i_header ) != p_buf[i_header] )
     {
         return 0;
     }
@@ -646,50 +667,3 @@ static uint64_t read_utf8( const uint8_t *p_buf, int *pi_read )
     *pi_read = i;
     return i_result;
 }
-
-/* CRC-8, poly = x^8 + x^2 + x^1 + x^0, init = 0 */
-static const uint8_t flac_crc8_table[256] = {
-        0x00, 0x07, 0x0E, 0x09, 0x1C, 0x1B, 0x12, 0x15,
-        0x38, 0x3F, 0x36, 0x31, 0x24, 0x23, 0x2A, 0x2D,
-        0x70, 0x77, 0x7E, 0x79, 0x6C, 0x6B, 0x62, 0x65,
-        0x48, 0x4F, 0x46, 0x41, 0x54, 0x53, 0x5A, 0x5D,
-        0xE0, 0xE7, 0xEE, 0xE9, 0xFC, 0xFB, 0xF2, 0xF5,
-        0xD8, 0xDF, 0xD6, 0xD1, 0xC4, 0xC3, 0xCA, 0xCD,
-        0x90, 0x97, 0x9E, 0x99, 0x8C, 0x8B, 0x82, 0x85,
-        0xA8, 0xAF, 0xA6, 0xA1, 0xB4, 0xB3, 0xBA, 0xBD,
-        0xC7, 0xC0, 0xC9, 0xCE, 0xDB, 0xDC, 0xD5, 0xD2,
-        0xFF, 0xF8, 0xF1, 0xF6, 0xE3, 0xE4, 0xED, 0xEA,
-        0xB7, 0xB0, 0xB9, 0xBE, 0xAB, 0xAC, 0xA5, 0xA2,
-        0x8F, 0x88, 0x81, 0x86, 0x93, 0x94, 0x9D, 0x9A,
-        0x27, 0x20, 0x29, 0x2E, 0x3B, 0x3C, 0x35, 0x32,
-        0x1F, 0x18, 0x11, 0x16, 0x03, 0x04, 0x0D, 0x0A,
-        0x57, 0x50, 0x59, 0x5E, 0x4B, 0x4C, 0x45, 0x42,
-        0x6F, 0x68, 0x61, 0x66, 0x73, 0x74, 0x7D, 0x7A,
-        0x89, 0x8E, 0x87, 0x80, 0x95, 0x92, 0x9B, 0x9C,
-        0xB1, 0xB6, 0xBF, 0xB8, 0xAD, 0xAA, 0xA3, 0xA4,
-        0xF9, 0xFE, 0xF7, 0xF0, 0xE5, 0xE2, 0xEB, 0xEC,
-        0xC1, 0xC6, 0xCF, 0xC8, 0xDD, 0xDA, 0xD3, 0xD4,
-        0x69, 0x6E, 0x67, 0x60, 0x75, 0x72, 0x7B, 0x7C,
-        0x51, 0x56, 0x5F, 0x58, 0x4D, 0x4A, 0x43, 0x44,
-        0x19, 0x1E, 0x17, 0x10, 0x05, 0x02, 0x0B, 0x0C,
-        0x21, 0x26, 0x2F, 0x28, 0x3D, 0x3A, 0x33, 0x34,
-        0x4E, 0x49, 0x40, 0x47, 0x52, 0x55, 0x5C, 0x5B,
-        0x76, 0x71, 0x78, 0x7F, 0x6A, 0x6D, 0x64, 0x63,
-        0x3E, 0x39, 0x30, 0x37, 0x22, 0x25, 0x2C, 0x2B,
-        0x06, 0x01, 0x08, 0x0F, 0x1A, 0x1D, 0x14, 0x13,
-        0xAE, 0xA9, 0xA0, 0xA7, 0xB2, 0xB5, 0xBC, 0xBB,
-        0x96, 0x91, 0x98, 0x9F, 0x8A, 0x8D, 0x84, 0x83,
-        0xDE, 0xD9, 0xD0, 0xD7, 0xC2, 0xC5, 0xCC, 0xCB,
-        0xE6, 0xE1, 0xE8, 0xEF, 0xFA, 0xFD, 0xF4, 0xF3
-};
-
-static uint8_t flac_crc8( const uint8_t *data, unsigned len )
-{
-    uint8_t crc = 0;
-
-    while(len--)
-        crc = flac_crc8_table[crc ^ *data++];
-
-    return crc;
-}
-
@@ -41,15 +41,26 @@
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
-static int  Open ( vlc_object_t * );
-static void Close( vlc_object_t * );
+static int  OpenPacketizer( vlc_object_t * );
+static int  OpenDecoder   ( vlc_object_t * );
+static void Close         ( vlc_object_t * );
 
 vlc_module_begin ()
     set_category( CAT_SOUT )
     set_subcategory( SUBCAT_SOUT_PACKETIZER )
     set_description( N_("MLP/TrueHD parser") )
     set_capability( "packetizer", 50 )
-    set_callbacks( Open, Close )
+    add_codec( VLC_CODEC_MLP )
+    add_codec( VLC_CODEC_TRUEHD )
+    set_callbacks( OpenPacketizer, Close )
+
+    add_submodule ()
+    set_category( CAT_INPUT )
+    set_subcategory( SUBCAT_INPUT_ACODEC )
+    set_description( N_("TrueHD pass-through") )
+    set_capability( "decoder", 100 )
+    add_codec( VLC_CODEC_TRUEHD )
+    set_callbacks( OpenDecoder, Close )
 vlc_module_end ()
 
 /*****************************************************************************
@@ -72,6 +83,9 @@ typedef struct
 
 struct decoder_sys_t
 {
+    /* Module mode */
+    bool b_packetizer;
+
     /*
      * Input properties
      */
@@ -95,6 +109,10 @@ struct decoder_sys_t
 #define MLP_HEADER_SYNC (28)
 #define MLP_HEADER_SIZE (4 + MLP_HEADER_SYNC + 4 * MLP_MAX_SUBSTREAMS)
 
+/* Size of the slot of an access unit in a MAT frame, see the tospdif
+ * converter */
+#define MLP_MAT_UNIT_SIZE (2560)
+
 static const uint8_t pu_start_code[3] = { 0xf8, 0x72, 0x6f };
 
 /****************************************************************************
@@ -105,9 +123,9 @@ static int SyncInfo( const uint8_t *p_hdr, bool *pb_mlp, mlp_header_t *p_mlp );
 static int SyncInfoDolby( const uint8_t *p_buf );
 
 /*****************************************************************************
- * Open: probe the decoder/packetizer and return score
+ * OpenCommon: probe the decoder/packetizer and return score
  *****************************************************************************/
-static int Open( vlc_object_t *p_this )
+static int OpenCommon( vlc_object_t *p_this, bool b_packetizer )
 {
     decoder_t *p_dec = (decoder_t*)p_this;
     decoder_sys_t *p_sys;
@@ -122,6 +140,7 @@ static int Open( vlc_object_t *p_this )
         return VLC_ENOMEM;
 
     /* */
+    p_sys->b_packetizer = b_packetizer;
     p_sys->i_state = STATE_NOSYNC;
     date_Set( &p_sys->end_date, 0 );
 
@@ -134,10 +153,31 @@ static int Open( vlc_object_t *p_this )
     p_dec->fmt_out.audio.i_rate = 0;
 
     /* Set callback */
-    p_dec->pf_packetize = Packetize;
+    if( b_packetizer )
+        p_dec->pf_packetize    = Packetize;
+    else
+        p_dec->pf_decode_audio = Packetize;
     return VLC_SUCCESS;
 }
 
+static int OpenPacketizer( vlc_object_t *p_this )
+{
+    return OpenCommon( p_this, true );
+}
+
+/*****************************************************************************
+ * OpenDecoder: only pass TrueHD through, there is no MLP decoder here
+ *****************************************************************************/
+static int OpenDecoder( vlc_object_t *p_this )
+{
+    decoder_t *p_dec = (decoder_t*)p_this;
+
+    if( p_dec->fmt_in.i_codec != VLC_CODEC_TRUEHD ||
+        !var_InheritBool( p_dec, "spdif" ) )
+        return VLC_EGENERIC;
+    return OpenCommon( p_this, false );
+}
+
 /****************************************************************************
  * Packetize:
  ****************************************************************************/
@@ -272,18 +312,12 @@ static block_t *Packetize( decoder_t *p_dec, block_t **pp_block )
         case STATE_SEND_DATA:
             /* When we reach this point we already know we have enough
              * data available. */
-            p_out_buffer = block_New( p_dec, p_sys->i_frame_size );
-            if( !p_out_buffer )
-                return NULL;
-
-            /* Copy the whole frame into the buffer */
-            block_GetBytes( &p_sys->bytestream,
-                            p_out_buffer->p_buffer, p_out_buffer->i_buffer );
 
             /* Just ignore (E)AC3 frames */
-            if( SyncInfoDolby( p_out_buffer->p_buffer ) > 0 )
+            block_PeekBytes( &p_sys->bytestream, p_header, MLP_HEADER_SIZE );
+            if( SyncInfoDolby( p_header ) > 0 )
             {
-                block_Release( p_out_buffer );
+                block_SkipBytes( &p_sys->bytestream, p_sys->i_frame_size );
                 p_sys->i_state = STATE_NOSYNC;
                 break;
             }
@@ -304,6 +338,40 @@ static block_t *Packetize( decoder_t *p_dec, block_t **pp_block )
             p_dec->fmt_out.audio.i_original_channels = p_sys->mlp.i_channels_conf;
             p_dec->fmt_out.audio.i_physical_channels = p_sys->mlp.i_channels_conf & AOUT_CHAN_PHYSMASK;
 
+            if( p_sys->b_packetizer )
+            {
+                p_out_buffer = block_New( p_dec, p_sys->i_frame_size );
+            }
+            else
+            {
+                /* The S/PDIF converter gives each access unit a fixed slot
+                 * in the MAT frame, so are the audio buffers */
+                if( p_sys->i_frame_size > MLP_MAT_UNIT_SIZE )
+                {
+                    msg_Warn( p_dec, "access unit too large (%d bytes), "
+                              "dropping", p_sys->i_frame_size );
+                    block_SkipBytes( &p_sys->bytestream, p_sys->i_frame_size );
+                    p_sys->i_state = STATE_NOSYNC;
+                    break;
+                }
+                p_dec->fmt_out.audio.i_bytes_per_frame = MLP_MAT_UNIT_SIZE;
+                p_dec->fmt_out.audio.i_frame_length = p_sys->mlp.i_samples;
+
+                p_out_buffer = decoder_NewAudioBuffer( p_dec,
+                                                       p_sys->mlp.i_samples );
+                if( p_out_buffer )
+                {
+                    p_out_buffer->i_nb_samples = p_sys->mlp.i_samples;
+                    p_out_buffer->i_buffer = p_sys->i_frame_size;
+                }
+            }
+            if( !p_out_buffer )
+                return NULL;
+
+            /* Copy the whole frame into the buffer */
+            block_GetBytes( &p_sys->bytestream,
+                            p_out_buffer->p_buffer, p_out_buffer->i_buffer );
+
             p_out_buffer->i_pts = p_out_buffer->i_dts = date_Get( &p_sys->end_date );
 
             p_out_buffer->i_length =
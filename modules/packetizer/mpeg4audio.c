@@ -174,6 +174,7 @@ vlc_module_begin ()
     set_subcategory( SUBCAT_SOUT_PACKETIZER )
     set_description( N_("MPEG4 audio packetizer") )
     set_capability( "packetizer", 50 )
+    add_codec( VLC_CODEC_MP4A )
     set_callbacks( OpenPacketizer, ClosePacketizer )
 vlc_module_end ()
 
@@ -49,6 +49,7 @@ typedef struct
 
     int i_startcode;
     const uint8_t *p_startcode;
+    block_startcode_helper_t pf_startcode_helper;
 
     int i_au_prepend;
     const uint8_t *p_au_prepend;
@@ -64,6 +65,7 @@ typedef struct
 
 static inline void packetizer_Init( packetizer_t *p_pack,
                                     const uint8_t *p_startcode, int i_startcode,
+                                    block_startcode_helper_t pf_startcode_helper,
                                     const uint8_t *p_au_prepend, int i_au_prepend,
                                     unsigned i_au_min_size,
                                     packetizer_reset_t pf_reset,
@@ -82,6 +84,7 @@ static inline void packetizer_Init( packetizer_t *p_pack,
 
     p_pack->i_startcode = i_startcode;
     p_pack->p_startcode = p_startcode;
+    p_pack->pf_startcode_helper = pf_startcode_helper;
     p_pack->pf_reset = pf_reset;
     p_pack->pf_parse = pf_parse;
     p_pack->pf_validate = pf_validate;
@@ -125,7 +128,8 @@ static inline block_t *packetizer_Packetize( packetizer_t *p_pack, block_t **pp_
         case STATE_NOSYNC:
             /* Find a startcode */
             if( !block_FindStartcodeFromOffset( &p_pack->bytestream, &p_pack->i_offset,
-                                                p_pack->p_startcode, p_pack->i_startcode ) )
+                                                p_pack->p_startcode, p_pack->i_startcode,
+                                                p_pack->pf_startcode_helper ) )
                 p_pack->i_state = STATE_NEXT_SYNC;
 
             if( p_pack->i_offset )
@@ -143,7 +147,8 @@ static inline block_t *packetizer_Packetize( packetizer_t *p_pack, block_t **pp_
         case STATE_NEXT_SYNC:
             /* Find the next startcode */
             if( block_FindStartcodeFromOffset( &p_pack->bytestream, &p_pack->i_offset,
-                                               p_pack->p_startcode, p_pack->i_startcode ) )
+                                               p_pack->p_startcode, p_pack->i_startcode,
+                                               p_pack->pf_startcode_helper ) )
             {
                 if( !p_pack->b_flushing || !p_pack->bytestream.p_chain )
                     return NULL; /* Need more data */
@@ -162,16 +167,35 @@ static inline block_t *packetizer_Packetize( packetizer_t *p_pack, block_t **pp_
 
             /* Get the new fragment and set the pts/dts */
             block_t *p_block_bytestream = p_pack->bytestream.p_block;
-
-            p_pic = block_New( p_dec, p_pack->i_offset + p_pack->i_au_prepend );
+            const size_t i_pos = p_pack->bytestream.i_offset;
+            const size_t i_prepend = p_pack->i_au_prepend;
+
+            /* Within one block, and after what would be prepended (as the
+             * first zero of a 4 bytes startcode): no need to copy. The
+             * fragments do not overlap, h264 drops the trailing zeroes. */
+            p_pic = NULL;
+            if( i_pos >= i_prepend
+             && p_block_bytestream->i_buffer - i_pos >= p_pack->i_offset
+             && ( i_prepend == 0
+               || !memcmp( &p_block_bytestream->p_buffer[i_pos - i_prepend],
+                           p_pack->p_au_prepend, i_prepend ) ) )
+            {
+                p_pic = block_Slice( p_block_bytestream, i_pos - i_prepend,
+                                     p_pack->i_offset + i_prepend );
+                if( p_pic )
+                    block_SkipBytes( &p_pack->bytestream, p_pack->i_offset );
+            }
+            if( !p_pic )
+            {
+                p_pic = block_New( p_dec, p_pack->i_offset + i_prepend );
+                block_GetBytes( &p_pack->bytestream, &p_pic->p_buffer[i_prepend],
+                                p_pic->i_buffer - i_prepend );
+                if( i_prepend > 0 )
+                    memcpy( p_pic->p_buffer, p_pack->p_au_prepend, i_prepend );
+            }
             p_pic->i_pts = p_block_bytestream->i_pts;
             p_pic->i_dts = p_block_bytestream->i_dts;
 
-            block_GetBytes( &p_pack->bytestream, &p_pic->p_buffer[p_pack->i_au_prepend],
-                            p_pic->i_buffer - p_pack->i_au_prepend );
-            if( p_pack->i_au_prepend > 0 )
-                memcpy( p_pic->p_buffer, p_pack->p_au_prepend, p_pack->i_au_prepend );
-
             p_pack->i_offset = 0;
 
             /* Parse the NAL */
@@ -0,0 +1,121 @@
+/*****************************************************************************
+ * startcode_helper.h: Startcodes helpers
+ *****************************************************************************
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_STARTCODE_HELPER_H_
+#define VLC_STARTCODE_HELPER_H_
+
+#include <vlc_cpu.h>
+
+/* Looks for a startcode (00 00 01) beginning among p[a] to p[a+3], reading
+ * up to p[a+5]. Any such startcode puts a zero in p[a+1] or p[a+3]. */
+#define TRY_MATCH(p,a) {\
+     if (p[a+1] == 0) {\
+            if (p[a+0] == 0 && p[a+2] == 1)\
+                return a+p;\
+            if (p[a+2] == 0 && p[a+3] == 1)\
+                return a+p+1;\
+        }\
+        if (p[a+3] == 0) {\
+            if (p[a+2] == 0 && p[a+4] == 1)\
+                return a+p+2;\
+            if (p[a+4] == 0 && p[a+5] == 1)\
+                return a+p+3;\
+        }\
+    }
+
+#ifdef CAN_COMPILE_SSE2
+VLC_SSE
+static inline const uint8_t *startcode_FindAnnexB_SSE2( const uint8_t *p, const uint8_t *end )
+{
+    /* First align to 16 */
+    const uint8_t *alignedend = p + 16 - ((intptr_t)p & 15);
+    for (end -= 3; p < alignedend && p <= end; p++) {
+        if (p[0] == 0 && p[1] == 0 && p[2] == 1)
+            return p;
+    }
+
+    /* Then 16 bytes at a time, TRY_MATCH() reading 2 bytes past them */
+    alignedend = end + 1 - ((intptr_t)(end + 1) & 15);
+    for (; p + 16 <= alignedend; p += 16) {
+        uint32_t match;
+        asm volatile(
+            "pxor     %%xmm1, %%xmm1\n"
+            "movdqa   0(%[v]), %%xmm0\n"
+            "pcmpeqb  %%xmm1, %%xmm0\n"
+            "pmovmskb %%xmm0, %[match]\n"
+            : [match]"=r"(match)
+            : [v]"r"(p)
+            : "xmm0", "xmm1"
+        );
+        if (match & 0x000F)
+            TRY_MATCH(p, 0);
+        if (match & 0x00F0)
+            TRY_MATCH(p, 4);
+        if (match & 0x0F00)
+            TRY_MATCH(p, 8);
+        if (match & 0xF000)
+            TRY_MATCH(p, 12);
+    }
+
+    for (; p <= end; p++) {
+        if (p[0] == 0 && p[1] == 0 && p[2] == 1)
+            return p;
+    }
+
+    return NULL;
+}
+#endif
+
+/* 4 bytes at a time, skipping the words without a zero byte, as libav's
+ * ff_avc_find_startcode does, see
+ * http://graphics.stanford.edu/~seander/bithacks.html#ZeroInWord */
+static inline const uint8_t *startcode_FindAnnexB_Bits( const uint8_t *p, const uint8_t *end )
+{
+    const uint8_t *a = p + 4 - ((intptr_t)p & 3);
+
+    for (end -= 3; p < a && p <= end; p++) {
+        if (p[0] == 0 && p[1] == 0 && p[2] == 1)
+            return p;
+    }
+
+    for (end -= 3; p < end; p += 4) {
+        uint32_t x = *(const uint32_t*)p;
+        if ((x - 0x01010101) & (~x) & 0x80808080)
+            TRY_MATCH(p, 0);
+    }
+
+    for (end += 3; p <= end; p++) {
+        if (p[0] == 0 && p[1] == 0 && p[2] == 1)
+            return p;
+    }
+
+    return NULL;
+}
+#undef TRY_MATCH
+
+/* Returns the first 00 00 01 startcode in [p, end), or NULL */
+static inline const uint8_t *startcode_FindAnnexB( const uint8_t *p, const uint8_t *end )
+{
+#ifdef CAN_COMPILE_SSE2
+    if (vlc_CPU() & CPU_CAPABILITY_SSE2)
+        return startcode_FindAnnexB_SSE2(p, end);
+#endif
+    return startcode_FindAnnexB_Bits(p, end);
+}
+
+#endif
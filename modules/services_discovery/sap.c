@@ -144,6 +144,12 @@ typedef struct sdp_t sdp_t;
 typedef struct attribute_t attribute_t;
 typedef struct sap_announce_t sap_announce_t;
 
+/* Announces are found by (origin, message id hash) in a hash table, and
+ * expired by a wheel of one-second slots, so that neither costs more with
+ * thousands of sessions. */
+#define SAP_HASH_SIZE  1024
+#define SAP_WHEEL_SIZE 64
+#define SAP_TICK       CLOCK_FREQ
 
 struct sdp_media_t
 {
@@ -206,6 +212,11 @@ struct sap_announce_t
     sdp_t       *p_sdp;
 
     input_item_t * p_item;
+
+    unsigned        i_bucket;
+    sap_announce_t *p_hash_next;
+    sap_announce_t *p_timer_next;
+    sap_announce_t **pp_timer_prev; /* NULL if not in the wheel */
 };
 
 struct services_discovery_sys_t
@@ -217,8 +228,13 @@ struct services_discovery_sys_t
     int *pi_fd;
 
     /* Table of announces */
-    int i_announces;
-    struct sap_announce_t **pp_announces;
+    unsigned i_announces;
+    sap_announce_t *pp_hash[SAP_HASH_SIZE];
+
+    /* Expiry wheel: slot N % SAP_WHEEL_SIZE holds the announces that expire
+     * before tick N, or in a later turn of the wheel */
+    sap_announce_t *pp_wheel[SAP_WHEEL_SIZE];
+    mtime_t i_wheel_tick; /* next tick to run */
 
     /* Modes */
     bool  b_strict;
@@ -248,6 +264,7 @@ struct demux_sys_t
     static sdp_t *ParseSDP (vlc_object_t *p_sd, const char *psz_sdp);
     static sap_announce_t *CreateAnnounce( services_discovery_t *, uint32_t *, uint16_t, sdp_t * );
     static int RemoveAnnounce( services_discovery_t *p_sd, sap_announce_t *p_announce );
+    static void RefreshAnnounce( services_discovery_t *, sap_announce_t * );
 
 /* Helper functions */
     static inline attribute_t *MakeAttribute (const char *str);
@@ -261,9 +278,76 @@ struct demux_sys_t
     static int Decompress( const unsigned char *psz_src, unsigned char **_dst, int i_len );
     static void FreeSDP( sdp_t *p_sdp );
 
-static inline int min_int( int a, int b )
+static unsigned HashMix( uint32_t h )
+{
+    h ^= h >> 16;
+    h *= 0x45d9f3b;
+    h ^= h >> 16;
+    return h % SAP_HASH_SIZE;
+}
+
+/* Bucket of a SAPv1 announce */
+static unsigned HashSource( const uint32_t *i_source, uint16_t i_hash )
+{
+    uint32_t h = i_hash;
+    for( int i = 0; i < 4; i++ )
+        h = h * 31 + i_source[i];
+    return HashMix( h );
+}
+
+/* Bucket of a SAPv0 announce (no message id hash), see IsSameSession() */
+static unsigned HashSession( const sdp_t *p_sdp )
+{
+    uint32_t h = p_sdp->session_id ^ (p_sdp->session_id >> 32)
+               ^ p_sdp->orig_ip_version;
+    for( const char *p = p_sdp->username; *p; p++ )
+        h = h * 31 + (unsigned char)*p;
+    for( const char *p = p_sdp->orig_host; *p; p++ )
+        h = h * 31 + (unsigned char)*p;
+    return HashMix( h );
+}
+
+/* Time after which an announce is removed: if the last announcement was
+ * received sap-timeout ago, or 3 times the average period ago */
+static mtime_t AnnounceDeadline( const services_discovery_sys_t *p_sys,
+                                 const sap_announce_t *p_announce )
 {
-    return a > b ? b : a;
+    mtime_t i_deadline = p_announce->i_last
+                       + (mtime_t)CLOCK_FREQ * p_sys->i_timeout;
+
+    if( p_announce->i_period_trust > 5 )
+    {
+        mtime_t i_implicit = p_announce->i_last + 3 * p_announce->i_period;
+        if( i_implicit < i_deadline )
+            i_deadline = i_implicit;
+    }
+    return i_deadline;
+}
+
+static void TimerUnlink( sap_announce_t *p_announce )
+{
+    if( p_announce->pp_timer_prev == NULL )
+        return;
+    *(p_announce->pp_timer_prev) = p_announce->p_timer_next;
+    if( p_announce->p_timer_next != NULL )
+        p_announce->p_timer_next->pp_timer_prev = p_announce->pp_timer_prev;
+    p_announce->pp_timer_prev = NULL;
+}
+
+static void TimerInsert( services_discovery_sys_t *p_sys,
+                         sap_announce_t *p_announce )
+{
+    /* First tick not before the deadline */
+    mtime_t i_tick = AnnounceDeadline( p_sys, p_announce ) / SAP_TICK + 1;
+    if( i_tick < p_sys->i_wheel_tick )
+        i_tick = p_sys->i_wheel_tick;
+
+    sap_announce_t **pp_slot = &p_sys->pp_wheel[i_tick % SAP_WHEEL_SIZE];
+    p_announce->p_timer_next = *pp_slot;
+    if( *pp_slot != NULL )
+        (*pp_slot)->pp_timer_prev = &p_announce->p_timer_next;
+    p_announce->pp_timer_prev = pp_slot;
+    *pp_slot = p_announce;
 }
 
 static bool IsWellKnownPayload (int type)
@@ -306,7 +390,9 @@ static int Open( vlc_object_t *p_this )
     p_sys->b_parse = var_CreateGetBool( p_sd, "sap-parse" );
 
     p_sys->i_announces = 0;
-    p_sys->pp_announces = NULL;
+    memset( p_sys->pp_hash, 0, sizeof( p_sys->pp_hash ) );
+    memset( p_sys->pp_wheel, 0, sizeof( p_sys->pp_wheel ) );
+    p_sys->i_wheel_tick = mdate() / SAP_TICK;
     /* TODO: create sockets here, and fix racy sockets table */
     if (vlc_clone (&p_sys->thread, Run, p_sd, VLC_THREAD_PRIORITY_LOW))
     {
@@ -422,11 +508,9 @@ static void Close( vlc_object_t *p_this )
     }
     FREENULL( p_sys->pi_fd );
 
-    for( i = p_sys->i_announces  - 1;  i>= 0; i-- )
-    {
-        RemoveAnnounce( p_sd, p_sys->pp_announces[i] );
-    }
-    FREENULL( p_sys->pp_announces );
+    for( i = 0; i < SAP_HASH_SIZE; i++ )
+        while( p_sys->pp_hash[i] != NULL )
+            RemoveAnnounce( p_sd, p_sys->pp_hash[i] );
 
     free( p_sys );
 }
@@ -454,7 +538,6 @@ static void *Run( void *data )
 {
     services_discovery_t *p_sd = data;
     char *psz_addr;
-    int i;
     int timeout = -1;
     int canc = vlc_savecancel ();
 
@@ -565,40 +648,47 @@ static void *Run( void *data )
             }
         }
 
+        services_discovery_sys_t *p_sys = p_sd->p_sys;
         mtime_t now = mdate();
 
-        /* A 1 hour timeout correspond to the RFC Implicit timeout.
-         * This timeout is tuned in the following loop. */
-        timeout = 1000 * 60 * 60;
-
-        /* Check for items that need deletion */
-        for( i = 0; i < p_sd->p_sys->i_announces; i++ )
+        /* Run the elapsed ticks of the wheel. Only the announces that expire
+         * around now are looked at. */
+        mtime_t i_tick = now / SAP_TICK;
+        if( i_tick - p_sys->i_wheel_tick >= SAP_WHEEL_SIZE )
+            p_sys->i_wheel_tick = i_tick - SAP_WHEEL_SIZE + 1;
+        for( ; p_sys->i_wheel_tick <= i_tick; p_sys->i_wheel_tick++ )
         {
-            mtime_t i_timeout = ( mtime_t ) 1000000 * p_sd->p_sys->i_timeout;
-            sap_announce_t * p_announce = p_sd->p_sys->pp_announces[i];
-            mtime_t i_last_period = now - p_announce->i_last;
-
-            /* Remove the announcement, if the last announcement was 1 hour ago
-             * or if the last packet emitted was 3 times the average time
-             * between two packets */
-            if( ( p_announce->i_period_trust > 5 && i_last_period > 3 * p_announce->i_period ) ||
-                i_last_period > i_timeout )
-            {
-                RemoveAnnounce( p_sd, p_announce );
-            }
-            else
+            sap_announce_t **pp_slot =
+                &p_sys->pp_wheel[p_sys->i_wheel_tick % SAP_WHEEL_SIZE];
+            sap_announce_t *p_list = *pp_slot;
+
+            *pp_slot = NULL;
+            while( p_list != NULL )
             {
-                /* Compute next timeout */
-                if( p_announce->i_period_trust > 5 )
-                    timeout = min_int((3 * p_announce->i_period - i_last_period) / 1000, timeout);
-                timeout = min_int((i_timeout - i_last_period)/1000, timeout);
+                sap_announce_t *p_announce = p_list;
+
+                p_list = p_announce->p_timer_next;
+                p_announce->pp_timer_prev = NULL;
+                if( AnnounceDeadline( p_sys, p_announce ) <= now )
+                    RemoveAnnounce( p_sd, p_announce );
+                else /* refreshed, or due in a later turn of the wheel */
+                    TimerInsert( p_sys, p_announce );
             }
         }
 
-        if( !p_sd->p_sys->i_announces )
+        if( !p_sys->i_announces )
             timeout = -1; /* We can safely poll indefinitely. */
-        else if( timeout < 200 )
-            timeout = 200; /* Don't wakeup too fast. */
+        else
+        {
+            /* Wake up at the next non-empty slot */
+            mtime_t i_next = p_sys->i_wheel_tick;
+            while( p_sys->pp_wheel[i_next % SAP_WHEEL_SIZE] == NULL
+                && i_next < p_sys->i_wheel_tick + SAP_WHEEL_SIZE )
+                i_next++;
+            timeout = (i_next * SAP_TICK - now) / 1000;
+            if( timeout < 200 )
+                timeout = 200; /* Don't wakeup too fast. */
+        }
     }
     assert (0);
 }
@@ -660,7 +750,6 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 static int ParseSAP( services_discovery_t *p_sd, const uint8_t *buf,
                      size_t len )
 {
-    int i;
     const char          *psz_sdp;
     const uint8_t *end = buf + len;
     sdp_t               *p_sdp;
@@ -714,6 +803,26 @@ static int ParseSAP( services_discovery_t *p_sd, const uint8_t *buf,
     if (buf > end)
         return VLC_EGENERIC;
 
+    /* The message id hash changes whenever the SDP changes: a known
+     * (origin, hash) pair is a mere re-announcement, no need to parse it. */
+    if( i_hash != 0 )
+    {
+        for( sap_announce_t *p_announce =
+                 p_sd->p_sys->pp_hash[HashSource( i_source, i_hash )];
+             p_announce != NULL; p_announce = p_announce->p_hash_next )
+            if( p_announce->i_hash == i_hash
+             && !memcmp(p_announce->i_source, i_source, sizeof(i_source)) )
+            {
+                /* We don't support delete announcement as they can easily
+                 * Be used to highjack an announcement by a third party.
+                 * Instead we cleverly implement Implicit Announcement
+                 * removal. */
+                if( !b_need_delete )
+                    RefreshAnnounce( p_sd, p_announce );
+                return VLC_SUCCESS;
+            }
+    }
+
     uint8_t *decomp = NULL;
     if( b_compressed )
     {
@@ -785,39 +894,20 @@ static int ParseSAP( services_discovery_t *p_sd, const uint8_t *buf,
         return VLC_EGENERIC;
     }
 
-    for( i = 0 ; i< p_sd->p_sys->i_announces ; i++ )
-    {
-        sap_announce_t * p_announce = p_sd->p_sys->pp_announces[i];
-        /* FIXME: slow */
-        if( ( !i_hash && IsSameSession( p_announce->p_sdp, p_sdp ) )
-            || ( i_hash && p_announce->i_hash == i_hash
-                 && !memcmp(p_announce->i_source, i_source, sizeof(i_source)) ) )
-        {
-            /* We don't support delete announcement as they can easily
-             * Be used to highjack an announcement by a third party.
-             * Instead we cleverly implement Implicit Announcement removal.
-             *
-             * if( b_need_delete )
-             *    RemoveAnnounce( p_sd, p_sd->p_sys->pp_announces[i]);
-             * else
-             */
-
-            if( !b_need_delete )
+    /* SAPv0 announces are identified by their SDP origin */
+    if( !i_hash )
+        for( sap_announce_t *p_announce =
+                 p_sd->p_sys->pp_hash[HashSession( p_sdp )];
+             p_announce != NULL; p_announce = p_announce->p_hash_next )
+            if( !p_announce->i_hash
+             && IsSameSession( p_announce->p_sdp, p_sdp ) )
             {
-                /* No need to go after six, as we start to trust the
-                 * average period at six */
-                if( p_announce->i_period_trust <= 5 )
-                    p_announce->i_period_trust++;
-
-                /* Compute the average period */
-                mtime_t now = mdate();
-                p_announce->i_period = ( p_announce->i_period * (p_announce->i_period_trust-1) + (now - p_announce->i_last) ) / p_announce->i_period_trust;
-                p_announce->i_last = now;
+                if( !b_need_delete )
+                    RefreshAnnounce( p_sd, p_announce );
+                FreeSDP( p_sdp ); p_sdp = NULL;
+                free (decomp);
+                return VLC_SUCCESS;
             }
-            FreeSDP( p_sdp ); p_sdp = NULL;
-            return VLC_SUCCESS;
-        }
-    }
 
     CreateAnnounce( p_sd, i_source, i_hash, p_sdp );
 
@@ -899,11 +989,35 @@ sap_announce_t *CreateAnnounce( services_discovery_t *p_sd, uint32_t *i_source,
         services_discovery_AddItem(p_sd, p_input, psz_value);
     }
 
-    TAB_APPEND( p_sys->i_announces, p_sys->pp_announces, p_sap );
+    p_sap->i_bucket = i_hash ? HashSource( i_source, i_hash )
+                             : HashSession( p_sdp );
+    p_sap->p_hash_next = p_sys->pp_hash[p_sap->i_bucket];
+    p_sys->pp_hash[p_sap->i_bucket] = p_sap;
+    p_sys->i_announces++;
+    TimerInsert( p_sys, p_sap );
 
     return p_sap;
 }
 
+/* Records that an announce was received again */
+static void RefreshAnnounce( services_discovery_t *p_sd,
+                             sap_announce_t *p_announce )
+{
+    /* No need to go after six, as we start to trust the
+     * average period at six */
+    if( p_announce->i_period_trust <= 5 )
+        p_announce->i_period_trust++;
+
+    /* Compute the average period */
+    mtime_t now = mdate();
+    p_announce->i_period = ( p_announce->i_period * (p_announce->i_period_trust-1) + (now - p_announce->i_last) ) / p_announce->i_period_trust;
+    p_announce->i_last = now;
+
+    /* The deadline may be earlier once the period is trusted */
+    TimerUnlink( p_announce );
+    TimerInsert( p_sd->p_sys, p_announce );
+}
+
 
 static const char *FindAttribute (const sdp_t *sdp, unsigned media,
                                   const char *name)
@@ -1530,7 +1644,17 @@ static void FreeSDP( sdp_t *p_sdp )
 static int RemoveAnnounce( services_discovery_t *p_sd,
                            sap_announce_t *p_announce )
 {
-    int i;
+    services_discovery_sys_t *p_sys = p_sd->p_sys;
+
+    for( sap_announce_t **pp = &p_sys->pp_hash[p_announce->i_bucket];
+         *pp != NULL; pp = &(*pp)->p_hash_next )
+        if( *pp == p_announce )
+        {
+            *pp = p_announce->p_hash_next;
+            p_sys->i_announces--;
+            break;
+        }
+    TimerUnlink( p_announce );
 
     if( p_announce->p_sdp )
     {
@@ -1545,16 +1669,6 @@ static int RemoveAnnounce( services_discovery_t *p_sd,
         p_announce->p_item = NULL;
     }
 
-    for( i = 0; i< p_sd->p_sys->i_announces; i++)
-    {
-        if( p_sd->p_sys->pp_announces[i] == p_announce )
-        {
-            REMOVE_ELEM( p_sd->p_sys->pp_announces, p_sd->p_sys->i_announces,
-                         i);
-            break;
-        }
-    }
-
     free( p_announce );
 
     return VLC_SUCCESS;
@@ -36,6 +36,9 @@
 
 #include <vlc_plugin.h>
 #include <vlc_services_discovery.h>
+#include <vlc_access.h>
+#include <vlc_url.h>
+#include <vlc_strings.h>
 
 #include <assert.h>
 #include <limits.h>
@@ -46,6 +49,11 @@
 const char* MEDIA_SERVER_DEVICE_TYPE = "urn:schemas-upnp-org:device:MediaServer:1";
 const char* CONTENT_DIRECTORY_SERVICE_TYPE = "urn:schemas-upnp-org:service:ContentDirectory:1";
 
+/* Children of a container are browsed by pages of this size. The pages
+ * after the first one are requested concurrently. */
+#define BROWSE_PAGE_SIZE 200
+#define BROWSE_THREADS   4
+
 /*
  * VLC handle
  */
@@ -53,14 +61,28 @@ struct services_discovery_sys_t
 {
     UpnpClient_Handle client_handle;
     MediaServerList* p_server_list;
-    vlc_mutex_t callback_lock;
 };
 
+/*
+ * libupnp can be initialized only once per process. It is shared by the
+ * services discovery and by the access that browses containers.
+ */
+static vlc_mutex_t upnp_init_lock = VLC_STATIC_MUTEX;
+static unsigned upnp_refs = 0;
+static UpnpClient_Handle upnp_handle;
+
+/* The services discovery receiving the events, if any. This is held during
+ * the event callbacks. */
+static vlc_mutex_t upnp_sd_lock = VLC_STATIC_MUTEX;
+static services_discovery_t* upnp_sd = NULL;
+
 /*
  * VLC callback prototypes
  */
 static int Open( vlc_object_t* );
 static void Close( vlc_object_t* );
+static int AccessOpen( vlc_object_t* );
+static void AccessClose( vlc_object_t* );
 VLC_SD_PROBE_HELPER( "upnp", "Universal Plug'n'Play", SD_CAT_LAN )
 
 /*
@@ -74,6 +96,13 @@ vlc_module_begin();
     set_capability( "services_discovery", 0 );
     set_callbacks( Open, Close );
 
+    add_submodule();
+        set_category( CAT_INPUT );
+        set_subcategory( SUBCAT_INPUT_ACCESS );
+        set_capability( "access", 0 );
+        add_shortcut( "upnp" );
+        set_callbacks( AccessOpen, AccessClose );
+
     VLC_SD_PROBE_SUBMODULE
 vlc_module_end();
 
@@ -98,22 +127,24 @@ int parseBrowseNumberValue( IXML_Document* p_doc,
                             const char*    psz_tag_name );
 
 /*
- * Initializes UPNP instance.
+ * Initializes libupnp and registers a control point, on first use.
  */
-static int Open( vlc_object_t *p_this )
+static int UpnpHold( vlc_object_t* p_obj, UpnpClient_Handle* p_handle )
 {
     int i_res;
-    services_discovery_t *p_sd = ( services_discovery_t* )p_this;
-    services_discovery_sys_t *p_sys  = ( services_discovery_sys_t * )
-            calloc( 1, sizeof( services_discovery_sys_t ) );
+    vlc_mutex_locker locker( &upnp_init_lock );
 
-    if( !( p_sd->p_sys = p_sys ) )
-        return VLC_ENOMEM;
+    if( upnp_refs > 0 )
+    {
+        upnp_refs++;
+        *p_handle = upnp_handle;
+        return VLC_SUCCESS;
+    }
 
 #ifdef UPNP_ENABLE_IPV6
     char* psz_miface;
-    psz_miface = var_InheritString( p_sd, "miface" );
-    msg_Info( p_sd, "Initializing libupnp on '%s' interface", psz_miface );
+    psz_miface = var_InheritString( p_obj, "miface" );
+    msg_Info( p_obj, "Initializing libupnp on '%s' interface", psz_miface );
     i_res = UpnpInit2( psz_miface, 0 );
     free( psz_miface );
 #else
@@ -122,41 +153,87 @@ static int Open( vlc_object_t *p_this )
 #endif
     if( i_res != UPNP_E_SUCCESS )
     {
-        msg_Err( p_sd, "Initialization failed: %s", UpnpGetErrorMessage( i_res ) );
-        free( p_sys );
+        msg_Err( p_obj, "Initialization failed: %s", UpnpGetErrorMessage( i_res ) );
         return VLC_EGENERIC;
     }
 
-    p_sys->p_server_list = new MediaServerList( p_sd );
-    vlc_mutex_init( &p_sys->callback_lock );
+    /* libupnp does not treat a maximum content length of 0 as unlimited
+     * until 64dedf (~ pupnp v1.6.7) and provides no sane way to discriminate
+     * between versions */
+    if( (i_res = UpnpSetMaxContentLength( INT_MAX )) != UPNP_E_SUCCESS )
+    {
+        msg_Err( p_obj, "Failed to set maximum content length: %s",
+                UpnpGetErrorMessage( i_res ));
+        UpnpFinish();
+        return VLC_EGENERIC;
+    }
 
     /* Register a control point */
-    i_res = UpnpRegisterClient( Callback, p_sd, &p_sys->client_handle );
+    i_res = UpnpRegisterClient( Callback, NULL, &upnp_handle );
     if( i_res != UPNP_E_SUCCESS )
     {
-        msg_Err( p_sd, "Client registration failed: %s", UpnpGetErrorMessage( i_res ) );
-        Close( (vlc_object_t*) p_sd );
+        msg_Err( p_obj, "Client registration failed: %s", UpnpGetErrorMessage( i_res ) );
+        UpnpFinish();
         return VLC_EGENERIC;
     }
 
-    /* Search for media servers */
-    i_res = UpnpSearchAsync( p_sys->client_handle, 5,
-            MEDIA_SERVER_DEVICE_TYPE, p_sd );
-    if( i_res != UPNP_E_SUCCESS )
+    upnp_refs = 1;
+    *p_handle = upnp_handle;
+    return VLC_SUCCESS;
+}
+
+static void UpnpRelease( void )
+{
+    vlc_mutex_locker locker( &upnp_init_lock );
+
+    assert( upnp_refs > 0 );
+    if( --upnp_refs > 0 )
+        return;
+
+    UpnpUnRegisterClient( upnp_handle );
+    UpnpFinish();
+}
+
+/*
+ * Initializes UPNP instance.
+ */
+static int Open( vlc_object_t *p_this )
+{
+    int i_res;
+    services_discovery_t *p_sd = ( services_discovery_t* )p_this;
+    services_discovery_sys_t *p_sys  = ( services_discovery_sys_t * )
+            calloc( 1, sizeof( services_discovery_sys_t ) );
+
+    if( !( p_sd->p_sys = p_sys ) )
+        return VLC_ENOMEM;
+
+    if( UpnpHold( p_this, &p_sys->client_handle ) != VLC_SUCCESS )
     {
-        msg_Err( p_sd, "Error sending search request: %s", UpnpGetErrorMessage( i_res ) );
-        Close( (vlc_object_t*) p_sd );
+        free( p_sys );
         return VLC_EGENERIC;
     }
 
-    /* libupnp does not treat a maximum content length of 0 as unlimited
-     * until 64dedf (~ pupnp v1.6.7) and provides no sane way to discriminate
-     * between versions */
-    if( (i_res = UpnpSetMaxContentLength( INT_MAX )) != UPNP_E_SUCCESS )
+    p_sys->p_server_list = new MediaServerList( p_sd );
+
+    vlc_mutex_lock( &upnp_sd_lock );
+    if( upnp_sd != NULL )
     {
-        msg_Err( p_sd, "Failed to set maximum content length: %s",
-                UpnpGetErrorMessage( i_res ));
+        vlc_mutex_unlock( &upnp_sd_lock );
+        msg_Err( p_sd, "UPnP discovery is already running" );
+        delete p_sys->p_server_list;
+        UpnpRelease();
+        free( p_sys );
+        return VLC_EGENERIC;
+    }
+    upnp_sd = p_sd;
+    vlc_mutex_unlock( &upnp_sd_lock );
 
+    /* Search for media servers */
+    i_res = UpnpSearchAsync( p_sys->client_handle, 5,
+            MEDIA_SERVER_DEVICE_TYPE, p_sd );
+    if( i_res != UPNP_E_SUCCESS )
+    {
+        msg_Err( p_sd, "Error sending search request: %s", UpnpGetErrorMessage( i_res ) );
         Close( (vlc_object_t*) p_sd );
         return VLC_EGENERIC;
     }
@@ -171,11 +248,14 @@ static void Close( vlc_object_t *p_this )
 {
     services_discovery_t *p_sd = ( services_discovery_t* )p_this;
 
-    UpnpUnRegisterClient( p_sd->p_sys->client_handle );
-    UpnpFinish();
+    /* Wait for the pending event callbacks */
+    vlc_mutex_lock( &upnp_sd_lock );
+    upnp_sd = NULL;
+    vlc_mutex_unlock( &upnp_sd_lock );
+
+    UpnpRelease();
 
     delete p_sd->p_sys->p_server_list;
-    vlc_mutex_destroy( &p_sd->p_sys->callback_lock );
 
     free( p_sd->p_sys );
 }
@@ -295,9 +375,13 @@ int parseBrowseNumberValue( IXML_Document* p_doc,
  */
 static int Callback( Upnp_EventType event_type, void* p_event, void* p_user_data )
 {
-    services_discovery_t* p_sd = ( services_discovery_t* ) p_user_data;
+    VLC_UNUSED( p_user_data );
+    vlc_mutex_locker locker( &upnp_sd_lock );
+    services_discovery_t* p_sd = upnp_sd;
+    if( p_sd == NULL )
+        return UPNP_E_SUCCESS; /* only the access is running */
+
     services_discovery_sys_t* p_sys = p_sd->p_sys;
-    vlc_mutex_locker locker( &p_sys->callback_lock );
 
     switch( event_type )
     {
@@ -635,27 +719,26 @@ void MediaServer::subscribeToContentDirectory()
 /*
  * Constructs UpnpAction to browse available content.
  */
-IXML_Document* MediaServer::_browseAction( const char* psz_object_id_,
-                                           const char* psz_browser_flag_,
-                                           const char* psz_filter_,
-                                           const char* psz_starting_index_,
-                                           const char* psz_requested_count_,
-                                           const char* psz_sort_criteria_ )
+static IXML_Document* browseAction( vlc_object_t* p_obj,
+                                    UpnpClient_Handle handle,
+                                    const char* psz_url,
+                                    const char* psz_object_id_,
+                                    const char* psz_browser_flag_,
+                                    const char* psz_filter_,
+                                    const char* psz_starting_index_,
+                                    const char* psz_requested_count_,
+                                    const char* psz_sort_criteria_ )
 {
     IXML_Document* p_action = 0;
     IXML_Document* p_response = 0;
-    const char* psz_url = getContentDirectoryControlURL();
 
-    if ( !psz_url )
+    if ( !psz_url || !*psz_url )
     {
-        msg_Dbg( _p_sd, "No subscription url set!" );
+        msg_Dbg( p_obj, "No subscription url set!" );
         return 0;
     }
 
-    char* psz_service_type = strdup( CONTENT_DIRECTORY_SERVICE_TYPE );
-
-    psz_service_type[strlen( psz_service_type ) - 1] =
-	_i_content_directory_service_version;
+    const char* psz_service_type = CONTENT_DIRECTORY_SERVICE_TYPE;
 
     int i_res;
 
@@ -664,7 +747,7 @@ IXML_Document* MediaServer::_browseAction( const char* psz_object_id_,
 
     if ( i_res != UPNP_E_SUCCESS )
     {
-        msg_Dbg( _p_sd, "AddToAction 'ObjectID' failed: %s",
+        msg_Dbg( p_obj, "AddToAction 'ObjectID' failed: %s",
                 UpnpGetErrorMessage( i_res ) );
         goto browseActionCleanup;
     }
@@ -674,7 +757,7 @@ IXML_Document* MediaServer::_browseAction( const char* psz_object_id_,
 
     if ( i_res != UPNP_E_SUCCESS )
     {
-        msg_Dbg( _p_sd, "AddToAction 'BrowseFlag' failed: %s", 
+        msg_Dbg( p_obj, "AddToAction 'BrowseFlag' failed: %s", 
                 UpnpGetErrorMessage( i_res ) );
         goto browseActionCleanup;
     }
@@ -684,7 +767,7 @@ IXML_Document* MediaServer::_browseAction( const char* psz_object_id_,
 
     if ( i_res != UPNP_E_SUCCESS )
     {
-        msg_Dbg( _p_sd, "AddToAction 'Filter' failed: %s",
+        msg_Dbg( p_obj, "AddToAction 'Filter' failed: %s",
                 UpnpGetErrorMessage( i_res ) );
         goto browseActionCleanup;
     }
@@ -694,7 +777,7 @@ IXML_Document* MediaServer::_browseAction( const char* psz_object_id_,
 
     if ( i_res != UPNP_E_SUCCESS )
     {
-        msg_Dbg( _p_sd, "AddToAction 'StartingIndex' failed: %s",
+        msg_Dbg( p_obj, "AddToAction 'StartingIndex' failed: %s",
                 UpnpGetErrorMessage( i_res ) );
         goto browseActionCleanup;
     }
@@ -704,7 +787,7 @@ IXML_Document* MediaServer::_browseAction( const char* psz_object_id_,
 
     if ( i_res != UPNP_E_SUCCESS )
     {
-        msg_Dbg( _p_sd, "AddToAction 'RequestedCount' failed: %s",
+        msg_Dbg( p_obj, "AddToAction 'RequestedCount' failed: %s",
                 UpnpGetErrorMessage( i_res ) );
         goto browseActionCleanup;
     }
@@ -714,12 +797,12 @@ IXML_Document* MediaServer::_browseAction( const char* psz_object_id_,
 
     if ( i_res != UPNP_E_SUCCESS )
     {
-        msg_Dbg( _p_sd, "AddToAction 'SortCriteria' failed: %s",
+        msg_Dbg( p_obj, "AddToAction 'SortCriteria' failed: %s",
                 UpnpGetErrorMessage( i_res ) );
         goto browseActionCleanup;
     }
 
-    i_res = UpnpSendAction( _p_sd->p_sys->client_handle,
+    i_res = UpnpSendAction( handle,
               psz_url,
               psz_service_type,
               0, /* ignored in SDK, must be NULL */
@@ -728,7 +811,7 @@ IXML_Document* MediaServer::_browseAction( const char* psz_object_id_,
 
     if ( i_res != UPNP_E_SUCCESS )
     {
-        msg_Err( _p_sd, "%s when trying the send() action with URL: %s",
+        msg_Err( p_obj, "%s when trying the send() action with URL: %s",
                 UpnpGetErrorMessage( i_res ), psz_url );
 
         ixmlDocument_free( p_response );
@@ -737,86 +820,158 @@ IXML_Document* MediaServer::_browseAction( const char* psz_object_id_,
 
 browseActionCleanup:
 
-    free( psz_service_type );
-
     ixmlDocument_free( p_action );
     return p_response;
 }
 
-void MediaServer::fetchContents()
+/*
+ * Browses the children of a container, from i_start, at most i_count of
+ * them (0 means all). Servers may return less than requested: the
+ * remaining ones are requested again. The DIDL documents are appended to
+ * results, and the total number of children is returned.
+ */
+static int browsePage( vlc_object_t* p_obj, UpnpClient_Handle handle,
+                       const char* psz_url, const char* psz_object_id,
+                       int i_start, int i_count,
+                       std::vector<IXML_Document*>& results )
 {
-    /* Delete previous contents to prevent duplicate entries */
-    if ( _p_contents )
-    {
-        delete _p_contents;
-        services_discovery_RemoveItem( _p_sd, _p_input_item );
-        services_discovery_AddItem( _p_sd, _p_input_item, NULL );
-    }
+    int i_total = -1;
 
-    Container* root = new Container( 0, "0", getFriendlyName() );
+    for( ;; )
+    {
+        char psz_starting_index[16], psz_requested_count[16];
+
+        snprintf( psz_starting_index, sizeof( psz_starting_index ),
+                  "%d", i_start );
+        snprintf( psz_requested_count, sizeof( psz_requested_count ),
+                  "%d", i_count );
+
+        IXML_Document* p_response = browseAction( p_obj, handle, psz_url,
+                                          psz_object_id,
+                                          "BrowseDirectChildren",
+                                          "*", /* Filter */
+                                          psz_starting_index,
+                                          psz_requested_count,
+                                          "" /* SortCriteria */
+                                          );
+        if ( !p_response )
+        {
+            msg_Err( p_obj, "No response from browse() action" );
+            break;
+        }
 
-    _fetchContents( root, 0 );
+        IXML_Document* p_result = parseBrowseResult( p_response );
+        int i_number_returned = parseBrowseNumberValue( p_response, "NumberReturned" );
+        i_total = parseBrowseNumberValue( p_response, "TotalMatches" );
+#ifndef NDEBUG
+        msg_Dbg( p_obj, "i_starting_index[%d]i_number_returned[%d]_total_matches[%d]\n",
+                 i_start, i_number_returned, i_total );
+#endif
+        ixmlDocument_free( p_response );
 
-    _p_contents = root;
-    _p_contents->setInputItem( _p_input_item );
+        if ( !p_result )
+        {
+            msg_Err( p_obj, "browse() response parsing failed" );
+            break;
+        }
+        results.push_back( p_result );
 
-    _buildPlaylist( _p_contents, NULL );
+        if( i_number_returned <= 0 || i_start + i_number_returned >= i_total )
+            break;
+        i_start += i_number_returned;
+        if( i_count > 0 )
+        {
+            i_count -= i_number_returned;
+            if( i_count <= 0 )
+                break;
+        }
+    }
+    return i_total;
 }
 
-/*
- * Fetches and parses the UPNP response
- */
-bool MediaServer::_fetchContents( Container* p_parent, int i_starting_index )
+/* State of the concurrent browsing of a container */
+struct browse_sys_t
 {
-    if (!p_parent)
-    {
-        msg_Err( _p_sd, "No parent" );
-        return false;
-    }
+    vlc_object_t*      p_obj;
+    UpnpClient_Handle  handle;
+    const char*        psz_url;
+    const char*        psz_object_id;
+    vlc_mutex_t        lock;
+    int                i_next_page;
+    int                i_pages;
+    std::vector<std::vector<IXML_Document*> > pages;
+};
 
-    char* psz_starting_index;
-    if( asprintf( &psz_starting_index, "%d", i_starting_index ) < 0 )
-    {
-        msg_Err( _p_sd, "asprintf error:%d", i_starting_index );
-        return false;
-    }
+static void* browseThread( void* data )
+{
+    browse_sys_t* p_sys = ( browse_sys_t* )data;
 
-    IXML_Document* p_response = _browseAction( p_parent->getObjectID(),
-                                      "BrowseDirectChildren",
-                                      "*", /* Filter */
-                                      psz_starting_index, /* StartingIndex */
-                                      "0", /* RequestedCount */
-                                      "" /* SortCriteria */
-                                      );
-    free( psz_starting_index );
-    if ( !p_response )
+    for( ;; )
     {
-        msg_Err( _p_sd, "No response from browse() action" );
-        return false;
-    }
-
-    IXML_Document* p_result = parseBrowseResult( p_response );
-    int i_number_returned = parseBrowseNumberValue( p_response, "NumberReturned" );
-    int i_total_matches = parseBrowseNumberValue( p_response , "TotalMatches" );
-#ifndef NDEBUG
-    msg_Dbg( _p_sd, "i_starting_index[%d]i_number_returned[%d]_total_matches[%d]\n",
-             i_starting_index, i_number_returned, i_total_matches );
-#endif
-    ixmlDocument_free( p_response );
+        vlc_mutex_lock( &p_sys->lock );
+        int i_page = p_sys->i_next_page++;
+        vlc_mutex_unlock( &p_sys->lock );
+        if( i_page >= p_sys->i_pages )
+            break;
 
-    if ( !p_result )
-    {
-        msg_Err( _p_sd, "browse() response parsing failed" );
-        return false;
+        /* Each thread writes to its own pages only */
+        browsePage( p_sys->p_obj, p_sys->handle, p_sys->psz_url,
+                    p_sys->psz_object_id, i_page * BROWSE_PAGE_SIZE,
+                    BROWSE_PAGE_SIZE, p_sys->pages[i_page] );
     }
-#ifndef NDEBUG
-    else
-    {
-        msg_Dbg( _p_sd, "Got DIDL document: %s",
-                ixmlPrintDocument( p_result ) );
-    }
-#endif
+    return NULL;
+}
 
+/*
+ * Fetches the DIDL documents describing the children of a container, in
+ * order. The first page tells how many children there are; the other pages
+ * are then requested concurrently.
+ */
+static std::vector<IXML_Document*> browseChildren( vlc_object_t* p_obj,
+                                                   UpnpClient_Handle handle,
+                                                   const char* psz_url,
+                                                   const char* psz_object_id )
+{
+    std::vector<IXML_Document*> results;
+
+    int i_total = browsePage( p_obj, handle, psz_url, psz_object_id,
+                              0, BROWSE_PAGE_SIZE, results );
+    if( i_total <= BROWSE_PAGE_SIZE || results.empty() )
+        return results;
+
+    browse_sys_t sys;
+    sys.p_obj = p_obj;
+    sys.handle = handle;
+    sys.psz_url = psz_url;
+    sys.psz_object_id = psz_object_id;
+    vlc_mutex_init( &sys.lock );
+    sys.i_next_page = 1;
+    sys.i_pages = ( i_total + BROWSE_PAGE_SIZE - 1 ) / BROWSE_PAGE_SIZE;
+    sys.pages.resize( sys.i_pages );
+
+    vlc_thread_t threads[BROWSE_THREADS];
+    int i_threads = 0;
+    while( i_threads < BROWSE_THREADS && i_threads < sys.i_pages - 1
+        && !vlc_clone( &threads[i_threads], browseThread, &sys,
+                       VLC_THREAD_PRIORITY_LOW ) )
+        i_threads++;
+    if( i_threads == 0 )
+        browseThread( &sys );
+    for( int i = 0; i < i_threads; i++ )
+        vlc_join( threads[i], NULL );
+    vlc_mutex_destroy( &sys.lock );
+
+    for( int i = 1; i < sys.i_pages; i++ )
+        results.insert( results.end(), sys.pages[i].begin(),
+                        sys.pages[i].end() );
+    return results;
+}
+
+/*
+ * Adds the children described by a DIDL document to a container
+ */
+static void parseDIDL( IXML_Document* p_result, Container* p_parent )
+{
     IXML_NodeList* containerNodeList =
                 ixmlDocument_getElementsByTagName( p_result, "container" );
 
@@ -839,9 +994,9 @@ bool MediaServer::_fetchContents( Container* p_parent, int i_starting_index )
             if ( !title )
                 continue;
 
+            /* Its children are browsed when it is opened */
             Container* container = new Container( p_parent, objectID, title );
             p_parent->addContainer( container );
-            _fetchContents( container, 0 );
         }
         ixmlNodeList_free( containerNodeList );
     }
@@ -895,18 +1050,66 @@ bool MediaServer::_fetchContents( Container* p_parent, int i_starting_index )
         }
         ixmlNodeList_free( itemNodeList );
     }
+}
 
-    ixmlDocument_free( p_result );
+/*
+ * Fetches the children of a container (but not their own children)
+ */
+static bool fetchChildren( vlc_object_t* p_obj, UpnpClient_Handle handle,
+                           const char* psz_url, Container* p_parent )
+{
+    std::vector<IXML_Document*> results =
+        browseChildren( p_obj, handle, psz_url, p_parent->getObjectID() );
 
-    if( i_starting_index + i_number_returned < i_total_matches )
+    for ( unsigned int i = 0; i < results.size(); i++ )
     {
-        if( !_fetchContents( p_parent, i_starting_index + i_number_returned ) )
-        {
-            return false;
-        }
+#ifndef NDEBUG
+        msg_Dbg( p_obj, "Got DIDL document: %s",
+                ixmlPrintDocument( results[i] ) );
+#endif
+        parseDIDL( results[i], p_parent );
+        ixmlDocument_free( results[i] );
     }
+    return !results.empty();
+}
 
-    return true;
+/*
+ * Returns the MRL of a container, browsed by the access when it is opened
+ */
+static char* containerMRL( const char* psz_url, const char* psz_object_id )
+{
+    char* psz_mrl = NULL;
+    char* psz_enc_url = encode_URI_component( psz_url );
+    char* psz_enc_id = encode_URI_component( psz_object_id );
+
+    if( psz_enc_url && psz_enc_id
+     && asprintf( &psz_mrl, "upnp://%s?ObjectID=%s",
+                  psz_enc_url, psz_enc_id ) < 0 )
+        psz_mrl = NULL;
+    free( psz_enc_url );
+    free( psz_enc_id );
+    return psz_mrl;
+}
+
+void MediaServer::fetchContents()
+{
+    /* Delete previous contents to prevent duplicate entries */
+    if ( _p_contents )
+    {
+        delete _p_contents;
+        services_discovery_RemoveItem( _p_sd, _p_input_item );
+        services_discovery_AddItem( _p_sd, _p_input_item, NULL );
+    }
+
+    Container* root = new Container( 0, "0", getFriendlyName() );
+
+    fetchChildren( VLC_OBJECT( _p_sd ), _p_sd->p_sys->client_handle,
+                   getContentDirectoryControlURL(), root );
+
+    _p_contents = root;
+    _p_contents->setInputItem( _p_input_item );
+
+    _buildPlaylist( _p_contents, NULL );
 }
 
 // TODO: Create a permanent fix for the item duplication bug. The current fix
@@ -956,13 +1159,20 @@ void MediaServer::_buildPlaylist( Container* p_parent, input_item_node_t *p_inpu
     {
         Container* p_container = p_parent->getContainer( i );
 
-        input_item_t* p_input_item = input_item_New( "vlc://nop",
+        /* Browsed by the access, when opened */
+        char* psz_mrl = containerMRL( getContentDirectoryControlURL(),
+                                      p_container->getObjectID() );
+        if( !psz_mrl )
+            continue;
+
+        input_item_t* p_input_item = input_item_New( psz_mrl,
                                                     p_container->getTitle() );
-        input_item_node_t *p_new_node =
-            input_item_node_AppendItem( p_input_node, p_input_item );
+        free( psz_mrl );
+        if( !p_input_item )
+            continue;
+        input_item_node_AppendItem( p_input_node, p_input_item );
 
         p_container->setInputItem( p_input_item );
-        _buildPlaylist( p_container, p_new_node );
     }
 
     for ( unsigned int i = 0; i < p_parent->getNumItems(); i++ )
@@ -1246,3 +1456,167 @@ input_item_t* Container::getInputItem() const
 {
     return _p_input_item;
 }
+
+
+/*
+ * Access browsing a container of a media server, when its item is opened.
+ * The children are sent as an XSPF playlist: items can be played at once,
+ * and containers are browsed in turn when opened.
+ */
+struct access_sys_t
+{
+    block_t* p_playlist;
+};
+
+static void appendXML( std::string& xspf, const char* psz_text )
+{
+    char* psz_xml = convert_xml_special_chars( psz_text );
+    if( psz_xml )
+    {
+        xspf += psz_xml;
+        free( psz_xml );
+    }
+}
+
+static block_t* AccessBlock( access_t* p_access )
+{
+    block_t* p_block = p_access->p_sys->p_playlist;
+
+    p_access->p_sys->p_playlist = NULL;
+    if( p_block == NULL )
+        p_access->info.b_eof = true;
+    return p_block;
+}
+
+static int AccessControl( access_t* p_access, int i_query, va_list args )
+{
+    switch( i_query )
+    {
+        case ACCESS_CAN_SEEK:
+        case ACCESS_CAN_FASTSEEK:
+            *va_arg( args, bool* ) = false;
+            break;
+
+        case ACCESS_CAN_PAUSE:
+        case ACCESS_CAN_CONTROL_PACE:
+            *va_arg( args, bool* ) = true;
+            break;
+
+        case ACCESS_GET_PTS_DELAY:
+            *va_arg( args, int64_t* ) = DEFAULT_PTS_DELAY;
+            break;
+
+        default:
+            VLC_UNUSED( p_access );
+            return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+static int AccessOpen( vlc_object_t *p_this )
+{
+    access_t* p_access = ( access_t* )p_this;
+
+    char* psz_url = strdup( p_access->psz_location );
+    if( !psz_url )
+        return VLC_ENOMEM;
+
+    char* psz_object_id = strstr( psz_url, "?ObjectID=" );
+    if( !psz_object_id )
+    {
+        free( psz_url );
+        return VLC_EGENERIC;
+    }
+    *psz_object_id = '\0';
+    psz_object_id += strlen( "?ObjectID=" );
+    decode_URI( psz_url );
+    decode_URI( psz_object_id );
+
+    UpnpClient_Handle handle;
+    if( UpnpHold( p_this, &handle ) != VLC_SUCCESS )
+    {
+        free( psz_url );
+        return VLC_EGENERIC;
+    }
+
+    Container container( NULL, psz_object_id, "" );
+    bool b_ok = fetchChildren( p_this, handle, psz_url, &container );
+    UpnpRelease();
+    if( !b_ok )
+    {
+        msg_Err( p_access, "cannot browse container %s", psz_object_id );
+        free( psz_url );
+        return VLC_EGENERIC;
+    }
+
+    std::string xspf =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<playlist version=\"1\" xmlns=\"http://xspf.org/ns/0/\">\n"
+        " <trackList>\n";
+
+    for( unsigned int i = 0; i < container.getNumContainers(); i++ )
+    {
+        Container* p_container = container.getContainer( i );
+        char* psz_mrl = containerMRL( psz_url, p_container->getObjectID() );
+        if( !psz_mrl )
+            continue;
+
+        xspf += "  <track><location>";
+        appendXML( xspf, psz_mrl );
+        xspf += "</location><title>";
+        appendXML( xspf, p_container->getTitle() );
+        xspf += "</title></track>\n";
+        free( psz_mrl );
+    }
+
+    for( unsigned int i = 0; i < container.getNumItems(); i++ )
+    {
+        Item* p_item = container.getItem( i );
+        char psz_duration[32] = "";
+
+        if( p_item->getDuration() >= 0 )
+            snprintf( psz_duration, sizeof( psz_duration ),
+                      "<duration>%" PRId64 "</duration>",
+                      p_item->getDuration() / 1000 );
+
+        xspf += "  <track><location>";
+        appendXML( xspf, p_item->getResource() );
+        xspf += "</location><title>";
+        appendXML( xspf, p_item->getTitle() );
+        xspf += "</title>";
+        xspf += psz_duration;
+        xspf += "</track>\n";
+    }
+    xspf += " </trackList>\n</playlist>\n";
+    free( psz_url );
+
+    access_sys_t* p_sys = ( access_sys_t* )malloc( sizeof( *p_sys ) );
+    if( !p_sys )
+        return VLC_ENOMEM;
+    p_sys->p_playlist = block_Alloc( xspf.length() );
+    if( !p_sys->p_playlist )
+    {
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+    memcpy( p_sys->p_playlist->p_buffer, xspf.c_str(), xspf.length() );
+
+    access_InitFields( p_access );
+    p_access->p_sys = p_sys;
+    p_access->pf_read = NULL;
+    p_access->pf_block = AccessBlock;
+    p_access->pf_seek = NULL;
+    p_access->pf_control = AccessControl;
+    free( p_access->psz_demux );
+    p_access->psz_demux = strdup( "xspf-open" );
+    return VLC_SUCCESS;
+}
+
+static void AccessClose( vlc_object_t *p_this )
+{
+    access_t* p_access = ( access_t* )p_this;
+
+    if( p_access->p_sys->p_playlist )
+        block_Release( p_access->p_sys->p_playlist );
+    free( p_access->p_sys );
+}
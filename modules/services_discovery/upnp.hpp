@@ -69,12 +69,8 @@ public:
 
 private:
 
-    bool _fetchContents( Container* p_parent, int i_starting_index );
     void _buildPlaylist( Container* p_container, input_item_node_t *p_item_node );
 
-    IXML_Document* _browseAction( const char*, const char*,
-            const char*, const char*, const char*, const char* );
-
     services_discovery_t* _p_sd;
 
     Container* _p_contents;
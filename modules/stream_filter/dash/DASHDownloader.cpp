@@ -0,0 +1,130 @@
+/*
+ * DASHDownloader.cpp
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "DASHDownloader.h"
+
+using namespace dash;
+using namespace dash::http;
+using namespace dash::logic;
+using namespace dash::buffer;
+using namespace dash::exception;
+
+DASHDownloader::DASHDownloader  (HTTPConnectionManager *conManager,
+                                 IAdaptationLogic *adaptationLogic,
+                                 BlockBuffer *buffer) :
+    conManager( conManager ),
+    adaptationLogic( adaptationLogic ),
+    buffer( buffer ),
+    isStarted( false )
+{
+}
+/* The buffer must have been closed first */
+DASHDownloader::~DASHDownloader ()
+{
+    if(this->isStarted)
+        vlc_join(this->thread, NULL);
+}
+
+bool            DASHDownloader::start       ()
+{
+    if(this->isStarted)
+        return true;
+    if(vlc_clone(&this->thread, download, this, VLC_THREAD_PRIORITY_INPUT))
+        return false;
+    this->isStarted = true;
+    return true;
+}
+
+void*           DASHDownloader::download    (void *thread_sys)
+{
+    DASHDownloader  *downloader = (DASHDownloader *) thread_sys;
+    int             canc        = vlc_savecancel();
+
+    downloader->run();
+
+    vlc_restorecancel(canc);
+    return NULL;
+}
+
+void            DASHDownloader::run         ()
+{
+    std::deque<Chunk *> pending;
+    bool                isEOF = false;
+
+    while(this->buffer->waitForRoom())
+    {
+        /* Keep the next requests in flight while reading the current one */
+        while(!isEOF && pending.size() < PIPELINE_DEPTH)
+        {
+            Chunk *chunk = this->nextChunk();
+            if(chunk == NULL)
+            {
+                isEOF = true;
+                break;
+            }
+            this->conManager->addChunk(chunk);
+            pending.push_back(chunk);
+        }
+        if(pending.empty())
+            break;
+
+        block_t *block = block_Alloc(DOWNLOAD_BLOCK_SIZE);
+        if(block == NULL)
+            break;
+
+        Chunk   *chunk      = pending.front();
+        int     bitrate     = chunk->getBitrate();
+        int     ret         = this->conManager->read(chunk, block->p_buffer, DOWNLOAD_BLOCK_SIZE);
+        if(ret <= 0)
+        {
+            /* The chunk is done, and deleted by the connection manager */
+            block_Release(block);
+            pending.pop_front();
+            if(ret < 0)
+                break;
+            continue;
+        }
+
+        block->i_buffer = ret;
+        block->i_length = bitrate > 0 ? (mtime_t)ret * 8 * CLOCK_FREQ / bitrate : 0;
+        this->buffer->put(block);
+    }
+
+    for(size_t i = 0; i < pending.size(); i++)
+        this->conManager->closeConnection(pending.at(i));
+    this->buffer->setEOF();
+}
+
+Chunk*          DASHDownloader::nextChunk   ()
+{
+    /* Let the logic see the buffer level before it picks a representation */
+    this->buffer->notify();
+    try
+    {
+        return this->adaptationLogic->getNextChunk();
+    }
+    catch(EOFException &e)
+    {
+        return NULL;
+    }
+}
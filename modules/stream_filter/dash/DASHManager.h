@@ -33,6 +33,8 @@
 #include "mpd/MPDManagerFactory.h"
 #include "exceptions/EOFException.h"
 #include "mpd/MPD.h"
+#include "buffer/BlockBuffer.h"
+#include "DASHDownloader.h"
 
 namespace dash
 {
@@ -40,7 +42,7 @@ namespace dash
     {
         public:
             DASHManager( http::HTTPConnectionManager *conManager, mpd::MPD *mpd,
-                         logic::IAdaptationLogic::LogicType type );
+                         logic::IAdaptationLogic::LogicType type, mtime_t bufferMicroSec );
             virtual ~DASHManager    ();
 
             int read( void *p_buffer, size_t len );
@@ -50,11 +52,12 @@ namespace dash
 
         private:
             http::HTTPConnectionManager         *conManager;
-            http::Chunk                         *currentChunk;
             logic::IAdaptationLogic             *adaptationLogic;
             logic::IAdaptationLogic::LogicType  logicType;
             mpd::IMPDManager                    *mpdManager;
             mpd::MPD                            *mpd;
+            buffer::BlockBuffer                 *buffer;
+            DASHDownloader                      *downloader;
     };
 }
 
@@ -34,9 +34,11 @@ using namespace dash::exception;
 
 AbstractAdaptationLogic::AbstractAdaptationLogic    (IMPDManager *mpdManager)
 {
-    this->bpsAvg        = -1;
-    this->bpsLastChunk  = 0;
-    this->mpdManager    = mpdManager;
+    this->bpsAvg            = -1;
+    this->bpsLastChunk      = 0;
+    this->bufferedMicroSec  = 0;
+    this->bufferedPercent   = 0;
+    this->mpdManager        = mpdManager;
 }
 AbstractAdaptationLogic::~AbstractAdaptationLogic   ()
 {
@@ -47,6 +49,11 @@ void AbstractAdaptationLogic::downloadRateChanged    (long bpsAvg, long bpsLastC
     this->bpsAvg        = bpsAvg;
     this->bpsLastChunk  = bpsLastChunk;
 }
+void AbstractAdaptationLogic::bufferLevelChanged     (mtime_t bufferedMicroSec, int bufferedPercent)
+{
+    this->bufferedMicroSec  = bufferedMicroSec;
+    this->bufferedPercent   = bufferedPercent;
+}
 long AbstractAdaptationLogic::getBpsAvg              ()
 {
     return this->bpsAvg;
@@ -55,3 +62,11 @@ long AbstractAdaptationLogic::getBpsLastChunk        ()
 {
     return this->bpsLastChunk;
 }
+mtime_t AbstractAdaptationLogic::getBufferedMicroSec ()
+{
+    return this->bufferedMicroSec;
+}
+int  AbstractAdaptationLogic::getBufferPercent       ()
+{
+    return this->bufferedPercent;
+}
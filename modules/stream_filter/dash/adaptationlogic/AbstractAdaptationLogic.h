@@ -46,13 +46,18 @@ namespace dash
                 virtual ~AbstractAdaptationLogic    ();
 
                 virtual void                downloadRateChanged     (long bpsAvg, long bpsLastChunk);
+                virtual void                bufferLevelChanged      (mtime_t bufferedMicroSec, int bufferedPercent);
 
                 long                        getBpsAvg               ();
                 long                        getBpsLastChunk         ();
+                mtime_t                     getBufferedMicroSec     ();
+                int                         getBufferPercent        ();
 
             private:
                 int                     bpsAvg;
                 long                    bpsLastChunk;
+                mtime_t                 bufferedMicroSec;
+                int                     bufferedPercent;
                 dash::mpd::IMPDManager  *mpdManager;
         };
     }
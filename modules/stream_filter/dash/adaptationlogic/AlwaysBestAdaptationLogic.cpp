@@ -57,6 +57,7 @@ Chunk*  AlwaysBestAdaptationLogic::getNextChunk() throw(EOFException)
         {
             Chunk *chunk = new Chunk();
             chunk->setUrl(this->schedule.at(i)->getSourceUrl());
+            chunk->setBitrate(this->bitrates.at(i));
             this->count++;
             return chunk;
         }
@@ -79,6 +80,7 @@ void    AlwaysBestAdaptationLogic::initSchedule ()
                 for(size_t j = 0; j < segments.size(); j++)
                 {
                     this->schedule.push_back(segments.at(j));
+                    this->bitrates.push_back(best->getBandwidth());
                 }
             }
         }
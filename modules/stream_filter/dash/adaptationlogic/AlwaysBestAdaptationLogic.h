@@ -49,6 +49,7 @@ namespace dash
 
             private:
                 std::vector<mpd::Segment *>         schedule;
+                std::vector<int>                    bitrates;
                 dash::mpd::IMPDManager              *mpdManager;
                 size_t                              count;
 
@@ -0,0 +1,128 @@
+/*
+ * BufferBasedAdaptationLogic.cpp
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "BufferBasedAdaptationLogic.h"
+
+using namespace dash::logic;
+using namespace dash::http;
+using namespace dash::mpd;
+using namespace dash::exception;
+
+BufferBasedAdaptationLogic::BufferBasedAdaptationLogic  (IMPDManager *mpdManager) :
+    AbstractAdaptationLogic( mpdManager ),
+    mpdManager( mpdManager ),
+    count( 0 ),
+    currentPeriod( mpdManager->getFirstPeriod() ),
+    currentRepresentation( NULL )
+{
+}
+
+Chunk*  BufferBasedAdaptationLogic::getNextChunk() throw(EOFException)
+{
+    if(this->mpdManager == NULL)
+        throw EOFException();
+
+    if(this->currentPeriod == NULL)
+        throw EOFException();
+
+    Representation *rep = this->selectRepresentation();
+
+    if ( rep == NULL )
+        throw EOFException();
+
+    std::vector<Segment *> segments = this->mpdManager->getSegments(rep);
+
+    if ( this->count == segments.size() )
+    {
+        this->currentPeriod         = this->mpdManager->getNextPeriod(this->currentPeriod);
+        this->currentRepresentation = NULL;
+        this->count = 0;
+        return this->getNextChunk();
+    }
+
+    if ( segments.size() > this->count )
+    {
+        Segment *seg = segments.at( this->count );
+        Chunk *chunk = new Chunk;
+        chunk->setUrl( seg->getSourceUrl() );
+        chunk->setBitrate( rep->getBandwidth() );
+        //In case of UrlTemplate, we must stay on the same segment.
+        if ( seg->isSingleShot() == true )
+            this->count++;
+        seg->done();
+        this->currentRepresentation = rep;
+        return chunk;
+    }
+    return NULL;
+}
+
+Representation* BufferBasedAdaptationLogic::selectRepresentation ()
+{
+    long    rate    = this->getBpsAvg();
+    long    last    = this->getBpsLastChunk();
+    int     level   = this->getBufferPercent();
+
+    /* Follow drops at once, rises on average */
+    if ( last > 0 && last < rate )
+        rate = last;
+
+    long target;
+    if ( level < BUFFER_LOW )
+        target = rate / 2;
+    else if ( level < BUFFER_HIGH )
+        target = rate * 3 / 4;
+    else
+        target = rate * 9 / 10;
+
+    Representation *lowest  = NULL;
+    Representation *best    = NULL;
+    const std::vector<Group *> &groups = this->currentPeriod->getGroups();
+
+    for ( size_t i = 0; i < groups.size(); i++ )
+    {
+        std::vector<Representation *> reps = groups.at(i)->getRepresentations();
+        for ( size_t j = 0; j < reps.size(); j++ )
+        {
+            Representation *rep = reps.at(j);
+
+            if ( lowest == NULL || rep->getBandwidth() < lowest->getBandwidth() )
+                lowest = rep;
+            if ( rep->getBandwidth() <= target &&
+                 ( best == NULL || rep->getBandwidth() > best->getBandwidth() ) )
+                best = rep;
+        }
+    }
+    if ( best == NULL )
+        best = lowest;
+
+    Representation *current = this->currentRepresentation;
+    if ( current == NULL || best == NULL )
+        return best;
+
+    if ( best->getBandwidth() > current->getBandwidth() && level < BUFFER_HIGH )
+        return current;
+    if ( best->getBandwidth() < current->getBandwidth() && level >= BUFFER_HIGH &&
+         current->getBandwidth() <= rate )
+        return current;
+    return best;
+}
@@ -0,0 +1,63 @@
+/*
+ * BufferBasedAdaptationLogic.h
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef BUFFERBASEDADAPTATIONLOGIC_H_
+#define BUFFERBASEDADAPTATIONLOGIC_H_
+
+#include "adaptationlogic/AbstractAdaptationLogic.h"
+#include "mpd/IMPDManager.h"
+#include "mpd/Period.h"
+#include "mpd/Representation.h"
+#include "http/Chunk.h"
+#include "exceptions/EOFException.h"
+
+/* Buffer levels, in percent of its capacity */
+#define BUFFER_LOW      20
+#define BUFFER_HIGH     50
+
+namespace dash
+{
+    namespace logic
+    {
+        /*
+         * Picks the representation from the download rate, with a safety
+         * margin that shrinks as the buffer fills. It only switches up with a
+         * comfortable buffer, and does not switch down while the buffer can
+         * absorb a short drop of the rate, so as not to oscillate.
+         */
+        class BufferBasedAdaptationLogic : public AbstractAdaptationLogic
+        {
+            public:
+                BufferBasedAdaptationLogic          (dash::mpd::IMPDManager *mpdManager);
+
+                dash::http::Chunk*      getNextChunk() throw(dash::exception::EOFException);
+
+            private:
+                dash::mpd::IMPDManager      *mpdManager;
+                size_t                      count;
+                dash::mpd::Period           *currentPeriod;
+                dash::mpd::Representation   *currentRepresentation;
+
+                dash::mpd::Representation*  selectRepresentation    ();
+        };
+    }
+}
+
+#endif /* BUFFERBASEDADAPTATIONLOGIC_H_ */
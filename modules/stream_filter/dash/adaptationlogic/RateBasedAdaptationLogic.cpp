@@ -70,6 +70,7 @@ Chunk*  RateBasedAdaptationLogic::getNextChunk() throw(EOFException)
         Segment *seg = segments.at( this->count );
         Chunk *chunk = new Chunk;
         chunk->setUrl( seg->getSourceUrl() );
+        chunk->setBitrate( rep->getBandwidth() );
         //In case of UrlTemplate, we must stay on the same segment.
         if ( seg->isSingleShot() == true )
             this->count++;
@@ -0,0 +1,217 @@
+/*
+ * BlockBuffer.cpp
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "BlockBuffer.h"
+
+#include <cstring>
+
+using namespace dash::buffer;
+
+BlockBuffer::BlockBuffer    (mtime_t capacityMicroSec) :
+    peekBlock( NULL ),
+    sizeBytes( 0 ),
+    sizeMicroSec( 0 ),
+    capacityMicroSec( capacityMicroSec ),
+    isEOF( false ),
+    isClosed( false )
+{
+    vlc_mutex_init(&this->monitorMutex);
+    vlc_cond_init(&this->dataAvailable);
+    vlc_cond_init(&this->roomAvailable);
+}
+BlockBuffer::~BlockBuffer   ()
+{
+    for(std::deque<block_t *>::iterator it = this->blocks.begin(); it != this->blocks.end(); ++it)
+        block_Release(*it);
+    if(this->peekBlock != NULL)
+        block_Release(this->peekBlock);
+
+    vlc_cond_destroy(&this->roomAvailable);
+    vlc_cond_destroy(&this->dataAvailable);
+    vlc_mutex_destroy(&this->monitorMutex);
+}
+
+void    BlockBuffer::put            (block_t *block)
+{
+    vlc_mutex_lock(&this->monitorMutex);
+    if(this->isClosed)
+    {
+        vlc_mutex_unlock(&this->monitorMutex);
+        block_Release(block);
+        return;
+    }
+    this->blocks.push_back(block);
+    this->sizeBytes     += block->i_buffer;
+    this->sizeMicroSec  += block->i_length;
+    vlc_cond_signal(&this->dataAvailable);
+    vlc_mutex_unlock(&this->monitorMutex);
+}
+
+/* Waits for len bytes, or for the end of the stream. p_data may be NULL to skip data. */
+int     BlockBuffer::get            (void *p_data, unsigned int len)
+{
+    uint8_t *p_dst  = (uint8_t *)p_data;
+    size_t  done    = 0;
+
+    vlc_mutex_lock(&this->monitorMutex);
+    while(done < len)
+    {
+        while(this->sizeBytes == 0 && !this->isEOF && !this->isClosed)
+            vlc_cond_wait(&this->dataAvailable, &this->monitorMutex);
+        if(this->sizeBytes == 0)
+            break;
+
+        size_t size = __MIN(len - done, this->sizeBytes);
+        this->consume(p_dst != NULL ? p_dst + done : NULL, size);
+        done += size;
+        vlc_cond_signal(&this->roomAvailable);
+    }
+    vlc_mutex_unlock(&this->monitorMutex);
+    return done;
+}
+
+/* The peeked data stays valid until the next get() */
+int     BlockBuffer::peek           (const uint8_t **pp_peek, unsigned int len)
+{
+    vlc_mutex_lock(&this->monitorMutex);
+    /* Do not wait for more than the buffer can hold */
+    while(this->sizeBytes < len && !this->isEOF && !this->isClosed && !this->isFull())
+        vlc_cond_wait(&this->dataAvailable, &this->monitorMutex);
+
+    size_t size = __MIN(len, this->sizeBytes);
+    if(size == 0)
+    {
+        vlc_mutex_unlock(&this->monitorMutex);
+        return 0;
+    }
+
+    block_t *front = this->blocks.front();
+    if(front->i_buffer >= size)
+    {
+        /* Most peeks fit in the first block: no copy */
+        *pp_peek = front->p_buffer;
+        vlc_mutex_unlock(&this->monitorMutex);
+        return size;
+    }
+
+    if(this->peekBlock == NULL || this->peekBlock->i_buffer < size)
+    {
+        if(this->peekBlock != NULL)
+            block_Release(this->peekBlock);
+        this->peekBlock = block_Alloc(size);
+        if(this->peekBlock == NULL)
+        {
+            vlc_mutex_unlock(&this->monitorMutex);
+            return -1;
+        }
+    }
+
+    uint8_t *p_dst = this->peekBlock->p_buffer;
+    size_t  left   = size;
+    for(std::deque<block_t *>::const_iterator it = this->blocks.begin(); left > 0; ++it)
+    {
+        size_t copy = __MIN(left, (*it)->i_buffer);
+        memcpy(p_dst, (*it)->p_buffer, copy);
+        p_dst   += copy;
+        left    -= copy;
+    }
+    *pp_peek = this->peekBlock->p_buffer;
+    vlc_mutex_unlock(&this->monitorMutex);
+    return size;
+}
+
+/* Returns false once the buffer is closed */
+bool    BlockBuffer::waitForRoom    ()
+{
+    vlc_mutex_lock(&this->monitorMutex);
+    while(this->isFull() && !this->isClosed)
+        vlc_cond_wait(&this->roomAvailable, &this->monitorMutex);
+    bool ret = !this->isClosed;
+    vlc_mutex_unlock(&this->monitorMutex);
+    return ret;
+}
+void    BlockBuffer::setEOF         ()
+{
+    vlc_mutex_lock(&this->monitorMutex);
+    this->isEOF = true;
+    vlc_cond_broadcast(&this->dataAvailable);
+    vlc_mutex_unlock(&this->monitorMutex);
+}
+void    BlockBuffer::close          ()
+{
+    vlc_mutex_lock(&this->monitorMutex);
+    this->isClosed = true;
+    vlc_cond_broadcast(&this->dataAvailable);
+    vlc_cond_broadcast(&this->roomAvailable);
+    vlc_mutex_unlock(&this->monitorMutex);
+}
+void    BlockBuffer::attach         (IBufferObserver *observer)
+{
+    this->bufferObservers.push_back(observer);
+}
+void    BlockBuffer::notify         ()
+{
+    vlc_mutex_lock(&this->monitorMutex);
+    mtime_t buffered    = this->sizeMicroSec;
+    int     percent     = 0;
+    if(this->capacityMicroSec > 0)
+        percent = __MIN(100, buffered * 100 / this->capacityMicroSec);
+    vlc_mutex_unlock(&this->monitorMutex);
+
+    for(size_t i = 0; i < this->bufferObservers.size(); i++)
+        this->bufferObservers.at(i)->bufferLevelChanged(buffered, percent);
+}
+
+bool    BlockBuffer::isFull         () const
+{
+    return this->sizeMicroSec >= this->capacityMicroSec ||
+           this->sizeBytes >= BLOCKBUFFER_MAX_BYTES;
+}
+void    BlockBuffer::consume        (uint8_t *p_data, size_t len)
+{
+    while(len > 0)
+    {
+        block_t *block  = this->blocks.front();
+        size_t  size    = __MIN(len, block->i_buffer);
+        mtime_t length  = block->i_length * size / block->i_buffer;
+
+        if(p_data != NULL)
+        {
+            memcpy(p_data, block->p_buffer, size);
+            p_data += size;
+        }
+        block->p_buffer     += size;
+        block->i_buffer     -= size;
+        block->i_length     -= length;
+        this->sizeBytes     -= size;
+        this->sizeMicroSec  -= length;
+        len                 -= size;
+
+        if(block->i_buffer == 0)
+        {
+            this->sizeMicroSec -= block->i_length;
+            this->blocks.pop_front();
+            block_Release(block);
+        }
+    }
+}
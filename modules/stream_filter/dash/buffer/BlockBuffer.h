@@ -0,0 +1,77 @@
+/*
+ * BlockBuffer.h
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef BLOCKBUFFER_H_
+#define BLOCKBUFFER_H_
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+
+#include <deque>
+#include <vector>
+
+#include "buffer/IBufferObserver.h"
+
+#define BLOCKBUFFER_MAX_BYTES   (32 * 1024 * 1024)
+
+namespace dash
+{
+    namespace buffer
+    {
+        /*
+         * Thread-safe queue of downloaded data, between the download thread
+         * and the reads of the stream. Each block carries the duration of
+         * the media it holds in i_length, so that the buffer is sized in time.
+         */
+        class BlockBuffer
+        {
+            public:
+                BlockBuffer             (mtime_t capacityMicroSec);
+                virtual ~BlockBuffer    ();
+
+                void    put             (block_t *block);
+                int     get             (void *p_data, unsigned int len);
+                int     peek            (const uint8_t **pp_peek, unsigned int len);
+                bool    waitForRoom     ();
+                void    setEOF          ();
+                void    close           ();
+                void    attach          (IBufferObserver *observer);
+                void    notify          ();
+
+            private:
+                std::deque<block_t *>           blocks;
+                std::vector<IBufferObserver *>  bufferObservers;
+                block_t                         *peekBlock;
+                size_t                          sizeBytes;
+                mtime_t                         sizeMicroSec;
+                mtime_t                         capacityMicroSec;
+                bool                            isEOF;
+                bool                            isClosed;
+                vlc_mutex_t                     monitorMutex;
+                vlc_cond_t                      dataAvailable;
+                vlc_cond_t                      roomAvailable;
+
+                bool    isFull          () const;
+                void    consume         (uint8_t *p_data, size_t len);
+        };
+    }
+}
+
+#endif /* BLOCKBUFFER_H_ */
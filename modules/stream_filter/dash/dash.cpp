@@ -48,12 +48,19 @@
 static int  Open    (vlc_object_t *);
 static void Close   (vlc_object_t *);
 
+#define BUFFER_TEXT N_("Buffer size (seconds)")
+#define BUFFER_LONGTEXT N_("How much media is downloaded ahead of playback. " \
+                           "The quality is raised only once the buffer is " \
+                           "half full.")
+
 vlc_module_begin ()
         set_shortname( N_("DASH"))
         set_description( N_("Dynamic Adaptive Streaming over HTTP") )
         set_capability( "stream_filter", 19 )
         set_category( CAT_INPUT )
         set_subcategory( SUBCAT_INPUT_STREAM_FILTER )
+        add_integer( "dash-buffersize", 30, BUFFER_TEXT, BUFFER_LONGTEXT, true )
+            change_integer_range( 5, 300 )
         set_callbacks( Open, Close )
 vlc_module_end ()
 
@@ -107,14 +114,15 @@ static int Open(vlc_object_t *p_obj)
                               new dash::http::HTTPConnectionManager( p_stream );
     dash::DASHManager*p_dashManager =
             new dash::DASHManager( p_conManager, p_sys->p_mpd,
-                                   dash::logic::IAdaptationLogic::RateBased );
+                                   dash::logic::IAdaptationLogic::BufferBased,
+                                   var_InheritInteger( p_obj, "dash-buffersize" ) * CLOCK_FREQ );
 
     if ( p_dashManager->getMpdManager() == NULL ||
          p_dashManager->getMpdManager()->getMPD() == NULL ||
          p_dashManager->getAdaptionLogic() == NULL )
     {
-        delete p_conManager;
         delete p_dashManager;
+        delete p_conManager;
         free( p_sys );
         return VLC_EGENERIC;
     }
@@ -141,8 +149,9 @@ static void Close(vlc_object_t *p_obj)
     dash::DASHManager                   *p_dashManager  = p_sys->p_dashManager;
     dash::http::HTTPConnectionManager   *p_conManager   = p_sys->p_conManager;
 
-    delete(p_conManager);
+    /* Stops the download thread, which uses the connection manager */
     delete(p_dashManager);
+    delete(p_conManager);
     free(p_sys);
 }
 /*****************************************************************************
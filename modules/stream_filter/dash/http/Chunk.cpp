@@ -30,7 +30,8 @@
 using namespace dash::http;
 
 Chunk::Chunk() : startByte( 0 ),
-    endByte( 0 )
+    endByte( 0 ),
+    bitrate( -1 )
 {
 }
 
@@ -47,6 +48,10 @@ const std::string& Chunk::getUrl       () const
 {
     return url;
 }
+int         Chunk::getBitrate   () const
+{
+    return bitrate;
+}
 void        Chunk::setEndByte   (int endByte)
 {
     this->endByte = endByte;
@@ -59,3 +64,7 @@ void        Chunk::setUrl       ( const std::string& url )
 {
     this->url = url;
 }
+void        Chunk::setBitrate   (int bitrate)
+{
+    this->bitrate = bitrate;
+}
@@ -40,15 +40,18 @@ namespace dash
                 int                 getEndByte      () const;
                 int                 getStartByte    () const;
                 const std::string&  getUrl          () const;
+                int                 getBitrate      () const;
                 void                setEndByte      (int endByte);
                 void                setStartByte    (int startByte);
                 void                setUrl          (const std::string& url);
+                void                setBitrate      (int bitrate);
 
             private:
                 std::string                 url;
                 std::vector<std::string>    optionalUrls;
                 int                         startByte;
                 int                         endByte;
+                int                         bitrate;
 
         };
     }
@@ -49,10 +49,6 @@ int             HTTPConnection::read            (void *p_buffer, size_t len)
 
     return size;
 }
-int             HTTPConnection::peek            (const uint8_t **pp_peek, size_t i_peek)
-{
-    return stream_Peek(this->urlStream, pp_peek, i_peek);
-}
 void            HTTPConnection::parseURL        ()
 {
     this->hostname = this->url;
@@ -51,7 +51,6 @@ namespace dash
                 void        closeSocket     ();
 
                 virtual int     read        (void *p_buffer, size_t len);
-                virtual int     peek        (const uint8_t **pp_peek, size_t i_peek);
 
             private:
                 int                     httpSocket;
@@ -40,6 +40,7 @@ HTTPConnectionManager::HTTPConnectionManager    (stream_t *stream)
     this->bpsLastChunk      = 0;
     this->chunkCount        = 0;
     this->stream            = stream;
+    this->currentChunk      = NULL;
 }
 HTTPConnectionManager::~HTTPConnectionManager   ()
 {
@@ -59,14 +60,35 @@ bool                HTTPConnectionManager::closeConnection( IHTTPConnection *con
             return true;
         }
     }
+    for(std::vector<PersistentConnection *>::iterator it = this->connectionPool.begin();
+        it != this->connectionPool.end(); ++it)
+    {
+        if(*it == con)
+        {
+            /* Keep it for the next chunks, unless the server closed it */
+            if((*it)->isReusable() || (*it)->getChunkCount() > 0)
+                return true;
+            delete(*it);
+            this->connectionPool.erase(it);
+            return true;
+        }
+    }
     return false;
 }
 
 bool                HTTPConnectionManager::closeConnection( Chunk *chunk )
 {
-    HTTPConnection *con = this->chunkMap[chunk];
-    bool ret = this->closeConnection(con);
-    this->chunkMap.erase(chunk);
+    std::map<Chunk *, IHTTPConnection *>::iterator it = this->chunkMap.find(chunk);
+    bool ret = false;
+
+    if(it != this->chunkMap.end())
+    {
+        IHTTPConnection *con = it->second;
+        this->chunkMap.erase(it);
+        ret = this->closeConnection(con);
+    }
+    if(this->currentChunk == chunk)
+        this->currentChunk = NULL;
     delete(chunk);
     return ret;
 }
@@ -79,9 +101,12 @@ void                HTTPConnectionManager::closeAllConnections      ()
         delete(*it);
     }
     this->connections.clear();
-    this->urlMap.clear();
 
-    std::map<Chunk *, HTTPConnection *>::iterator it;
+    for(std::vector<PersistentConnection *>::iterator it = this->connectionPool.begin(); it != this->connectionPool.end(); ++it)
+        delete(*it);
+    this->connectionPool.clear();
+
+    std::map<Chunk *, IHTTPConnection *>::iterator it;
 
     for(it = this->chunkMap.begin(); it != this->chunkMap.end(); ++it)
     {
@@ -89,17 +114,32 @@ void                HTTPConnectionManager::closeAllConnections      ()
     }
 
     this->chunkMap.clear();
+    this->currentChunk = NULL;
+}
+
+/* Sends the request for a chunk ahead of reading it */
+bool                HTTPConnectionManager::addChunk( Chunk *chunk )
+{
+    if(this->chunkMap.find(chunk) != this->chunkMap.end())
+        return true;
+    return this->initConnection( chunk ) != NULL;
 }
 
+/* The chunk is deleted once this returns 0 or less */
 int                 HTTPConnectionManager::read( Chunk *chunk, void *p_buffer, size_t len )
 {
-    if(this->chunkMap.find(chunk) == this->chunkMap.end())
+    if(this->chunkMap.find(chunk) == this->chunkMap.end() &&
+       this->initConnection( chunk ) == NULL)
+    {
+        this->closeConnection( chunk );
+        return -1;
+    }
+
+    if(this->currentChunk != chunk)
     {
+        this->currentChunk      = chunk;
         this->bytesReadChunk    = 0;
         this->timeSecChunk      = 0;
-
-        if ( this->initConnection( chunk ) == NULL )
-            return -1;
     }
 
     mtime_t start = mdate();
@@ -135,22 +175,51 @@ int                 HTTPConnectionManager::read( Chunk *chunk, void *p_buffer, s
     return ret;
 }
 
-int                 HTTPConnectionManager::peek                     (Chunk *chunk, const uint8_t **pp_peek, size_t i_peek)
+IHTTPConnection*     HTTPConnectionManager::initConnection(Chunk *chunk)
 {
-    if(this->chunkMap.find(chunk) == this->chunkMap.end())
+    std::string hostname, path;
+    int         port;
+
+    if(!PersistentConnection::parseUrl(chunk->getUrl(), hostname, port, path))
     {
-        if ( this->initConnection(chunk) == NULL )
-            return -1;
+        /* Not plain HTTP: let an access module fetch it */
+        HTTPConnection *con = new HTTPConnection(chunk->getUrl(), this->stream);
+        if ( con->init() == false )
+        {
+            delete con;
+            return NULL;
+        }
+        this->connections.push_back(con);
+        this->chunkMap[chunk] = con;
+        this->chunkCount++;
+        return con;
     }
-    return this->chunkMap[chunk]->peek(pp_peek, i_peek);
-}
 
-IHTTPConnection*     HTTPConnectionManager::initConnection(Chunk *chunk)
-{
-    HTTPConnection *con = new HTTPConnection(chunk->getUrl(), this->stream);
-    if ( con->init() == false )
+    PersistentConnection *con = NULL;
+    for(size_t i = 0; i < this->connectionPool.size(); i++)
+    {
+        PersistentConnection *pooled = this->connectionPool.at(i);
+        if(pooled->isServing(hostname, port) && pooled->isReusable() &&
+           pooled->getChunkCount() < PIPELINE_DEPTH)
+        {
+            con = pooled;
+            break;
+        }
+    }
+
+    if(con == NULL)
+    {
+        con = new PersistentConnection(this->stream, hostname, port);
+        if(con->addChunk(chunk) == false)
+        {
+            delete con;
+            return NULL;
+        }
+        this->connectionPool.push_back(con);
+    }
+    else if(con->addChunk(chunk) == false)
         return NULL;
-    this->connections.push_back(con);
+
     this->chunkMap[chunk] = con;
     this->chunkCount++;
     return con;
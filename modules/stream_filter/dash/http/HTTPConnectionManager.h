@@ -35,9 +35,13 @@
 #include <limits.h>
 
 #include "http/HTTPConnection.h"
+#include "http/PersistentConnection.h"
 #include "http/Chunk.h"
 #include "adaptationlogic/IDownloadRateObserver.h"
 
+/* Requests sent ahead on one persistent connection */
+#define PIPELINE_DEPTH  2
+
 namespace dash
 {
     namespace http
@@ -50,15 +54,16 @@ namespace dash
 
                 void                closeAllConnections ();
                 bool                closeConnection     (IHTTPConnection *con);
+                bool                closeConnection     (Chunk *chunk);
+                bool                addChunk            (Chunk *chunk);
                 int                 read                (Chunk *chunk, void *p_buffer, size_t len);
-                int                 peek                (Chunk *chunk, const uint8_t **pp_peek, size_t i_peek);
                 void                attach              (dash::logic::IDownloadRateObserver *observer);
                 void                notify              ();
 
             private:
                 std::vector<HTTPConnection *>                       connections;
-                std::map<Chunk *, HTTPConnection *>                 chunkMap;
-                std::map<std::string, HTTPConnection *>             urlMap;
+                std::vector<PersistentConnection *>                 connectionPool;
+                std::map<Chunk *, IHTTPConnection *>                chunkMap;
                 std::vector<dash::logic::IDownloadRateObserver *>   rateObservers;
                 long                                                bpsAvg;
                 long                                                bpsLastChunk;
@@ -68,8 +73,8 @@ namespace dash
                 double                                              timeSecChunk;
                 stream_t                                            *stream;
                 int                                                 chunkCount;
+                Chunk                                               *currentChunk;
 
-                bool                closeConnection( Chunk *chunk );
                 IHTTPConnection*    initConnection( Chunk *chunk );
 
         };
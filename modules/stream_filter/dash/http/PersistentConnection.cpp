@@ -0,0 +1,293 @@
+/*
+ * PersistentConnection.cpp
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "PersistentConnection.h"
+
+#include <vlc_url.h>
+
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+
+using namespace dash::http;
+
+PersistentConnection::PersistentConnection  (stream_t *stream, const std::string& hostname, int port) :
+    stream( stream ),
+    hostname( hostname ),
+    port( port ),
+    httpSocket( -1 ),
+    keepAlive( true ),
+    headerRead( false ),
+    chunkedBody( false ),
+    firstBodyChunk( false ),
+    bodyLeft( 0 )
+{
+}
+PersistentConnection::~PersistentConnection ()
+{
+    this->disconnect();
+}
+
+bool    PersistentConnection::parseUrl      (const std::string& url, std::string& hostname,
+                                             int& port, std::string& path)
+{
+    vlc_url_t   parsed;
+    bool        ret = false;
+
+    vlc_UrlParse(&parsed, url.c_str(), 0);
+    if(parsed.psz_protocol != NULL && !strcasecmp(parsed.psz_protocol, "http") &&
+       parsed.psz_host != NULL && *parsed.psz_host != '\0')
+    {
+        hostname    = parsed.psz_host;
+        port        = parsed.i_port > 0 ? parsed.i_port : 80;
+        path        = parsed.psz_path != NULL ? parsed.psz_path : "/";
+        ret         = true;
+    }
+    vlc_UrlClean(&parsed);
+    return ret;
+}
+
+bool    PersistentConnection::addChunk      (Chunk *chunk)
+{
+    this->chunkQueue.push_back(chunk);
+
+    /* A closed connection has lost the requests sent on it, if any */
+    if(this->httpSocket != -1 && this->sendRequest(chunk))
+        return true;
+    if(this->resendRequests())
+        return true;
+
+    this->chunkQueue.pop_back();
+    return false;
+}
+
+int     PersistentConnection::read          (void *p_buffer, size_t len)
+{
+    if(this->chunkQueue.empty())
+        return -1;
+
+    if(!this->headerRead)
+    {
+        int status = this->readHeader();
+
+        /* The server may close an idle keep-alive connection at any time */
+        if(status < 0 && this->resendRequests())
+            status = this->readHeader();
+
+        if(status / 100 != 2)
+        {
+            if(status >= 0)
+                msg_Err(this->stream, "%s: HTTP error %d",
+                        this->chunkQueue.front()->getUrl().c_str(), status);
+            this->disconnect();
+            this->nextResponse();
+            return -1;
+        }
+        this->headerRead = true;
+    }
+
+    int ret = this->readBody(p_buffer, len);
+    if(ret <= 0)
+    {
+        if(ret < 0 || !this->keepAlive)
+            this->disconnect();
+        this->nextResponse();
+    }
+    return ret;
+}
+
+size_t  PersistentConnection::getChunkCount () const
+{
+    return this->chunkQueue.size();
+}
+bool    PersistentConnection::isReusable    () const
+{
+    return this->keepAlive;
+}
+bool    PersistentConnection::isServing     (const std::string& hostname, int port) const
+{
+    return this->port == port && this->hostname == hostname;
+}
+
+bool    PersistentConnection::connect       ()
+{
+    this->httpSocket    = net_ConnectTCP(this->stream, this->hostname.c_str(), this->port);
+    this->keepAlive     = true;
+    this->headerRead    = false;
+    return this->httpSocket != -1;
+}
+void    PersistentConnection::disconnect    ()
+{
+    if(this->httpSocket != -1)
+        net_Close(this->httpSocket);
+    this->httpSocket = -1;
+}
+
+bool    PersistentConnection::sendRequest   (const Chunk *chunk)
+{
+    std::string hostname, path;
+    int         port;
+
+    if(!parseUrl(chunk->getUrl(), hostname, port, path))
+        return false;
+
+    std::stringstream request;
+    request << "GET " << path << " HTTP/1.1\r\n" << "Host: " << hostname;
+    if(port != 80)
+        request << ":" << port;
+    request << "\r\n";
+    if(chunk->getEndByte() > 0)
+        request << "Range: bytes=" << chunk->getStartByte() << "-" << chunk->getEndByte() << "\r\n";
+    request << "Connection: keep-alive\r\n\r\n";
+
+    std::string data = request.str();
+    return net_Write(this->stream, this->httpSocket, NULL, data.c_str(), data.size()) == (ssize_t)data.size();
+}
+bool    PersistentConnection::resendRequests()
+{
+    this->disconnect();
+    if(this->chunkQueue.empty() || !this->connect())
+        return false;
+
+    for(std::deque<Chunk *>::const_iterator it = this->chunkQueue.begin(); it != this->chunkQueue.end(); ++it)
+    {
+        if(!this->sendRequest(*it))
+        {
+            this->disconnect();
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Returns the status code of the response, or -1 if the connection is lost */
+int     PersistentConnection::readHeader    ()
+{
+    if(this->httpSocket == -1)
+        return -1;
+
+    char *line = net_Gets(this->stream, this->httpSocket, NULL);
+    if(line == NULL)
+        return -1;
+
+    int version, status;
+    if(sscanf(line, "HTTP/1.%d %3d", &version, &status) != 2)
+    {
+        free(line);
+        return -1;
+    }
+    free(line);
+
+    this->keepAlive     = version >= 1;
+    this->chunkedBody   = false;
+    this->bodyLeft      = -1;
+
+    while((line = net_Gets(this->stream, this->httpSocket, NULL)) != NULL && *line != '\0')
+    {
+        char *value = strchr(line, ':');
+        if(value != NULL)
+        {
+            *value++ = '\0';
+            value += strspn(value, " \t");
+
+            if(!strcasecmp(line, "Content-Length"))
+                this->bodyLeft = strtoll(value, NULL, 10);
+            else if(!strcasecmp(line, "Transfer-Encoding") && !strcasecmp(value, "chunked"))
+                this->chunkedBody = true;
+            else if(!strcasecmp(line, "Connection"))
+                this->keepAlive = strcasecmp(value, "close") != 0;
+        }
+        free(line);
+    }
+    if(line == NULL)
+        return -1;
+    free(line);
+
+    if(this->chunkedBody)
+    {
+        this->bodyLeft          = 0;
+        this->firstBodyChunk    = true;
+    }
+    else if(this->bodyLeft < 0)
+        this->keepAlive = false; /* the body ends with the connection */
+
+    return status;
+}
+bool    PersistentConnection::readBodyChunkSize ()
+{
+    char *line;
+
+    /* Skip the CRLF ending the data of the previous chunk */
+    if(!this->firstBodyChunk)
+    {
+        line = net_Gets(this->stream, this->httpSocket, NULL);
+        if(line == NULL)
+            return false;
+        free(line);
+    }
+    this->firstBodyChunk = false;
+
+    line = net_Gets(this->stream, this->httpSocket, NULL);
+    if(line == NULL)
+        return false;
+    this->bodyLeft = strtoll(line, NULL, 16);
+    free(line);
+
+    if(this->bodyLeft < 0)
+        return false;
+    if(this->bodyLeft == 0)
+    {
+        /* Last chunk: skip the trailer */
+        while((line = net_Gets(this->stream, this->httpSocket, NULL)) != NULL && *line != '\0')
+            free(line);
+        if(line == NULL)
+            return false;
+        free(line);
+        this->chunkedBody = false;
+    }
+    return true;
+}
+int     PersistentConnection::readBody      (void *p_buffer, size_t len)
+{
+    if(this->chunkedBody && this->bodyLeft == 0 && !this->readBodyChunkSize())
+        return -1;
+    if(this->bodyLeft == 0)
+        return 0;
+    if(this->bodyLeft > 0 && (int64_t)len > this->bodyLeft)
+        len = this->bodyLeft;
+
+    ssize_t ret = net_Read(this->stream, this->httpSocket, NULL, p_buffer, len, false);
+    if(ret <= 0)
+        return (ret == 0 && this->bodyLeft < 0) ? 0 : -1;
+
+    if(this->bodyLeft > 0)
+        this->bodyLeft -= ret;
+    return ret;
+}
+void    PersistentConnection::nextResponse  ()
+{
+    this->chunkQueue.pop_front();
+    this->headerRead = false;
+}
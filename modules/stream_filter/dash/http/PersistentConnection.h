@@ -0,0 +1,85 @@
+/*
+ * PersistentConnection.h
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef PERSISTENTCONNECTION_H_
+#define PERSISTENTCONNECTION_H_
+
+#include <vlc_common.h>
+#include <vlc_stream.h>
+#include <vlc_network.h>
+
+#include <string>
+#include <deque>
+#include <stdint.h>
+
+#include "http/IHTTPConnection.h"
+#include "http/Chunk.h"
+
+namespace dash
+{
+    namespace http
+    {
+        /*
+         * HTTP/1.1 keep-alive connection to one server. Requests for several
+         * chunks can be sent ahead (pipelined); read() returns the body of
+         * the oldest one, and 0 at its end, after which the next one is read.
+         * Requests still waiting for their response are sent again, once, if
+         * the server closes the connection.
+         */
+        class PersistentConnection : public IHTTPConnection
+        {
+            public:
+                PersistentConnection            (stream_t *stream, const std::string& hostname, int port);
+                virtual ~PersistentConnection   ();
+
+                bool                addChunk        (Chunk *chunk);
+                virtual int         read            (void *p_buffer, size_t len);
+                size_t              getChunkCount   () const;
+                bool                isReusable      () const;
+                bool                isServing       (const std::string& hostname, int port) const;
+
+                static bool         parseUrl        (const std::string& url, std::string& hostname,
+                                                     int& port, std::string& path);
+
+            private:
+                stream_t                *stream;
+                std::string             hostname;
+                int                     port;
+                int                     httpSocket;
+                std::deque<Chunk *>     chunkQueue;
+                bool                    keepAlive;
+                bool                    headerRead;
+                bool                    chunkedBody;
+                bool                    firstBodyChunk;
+                int64_t                 bodyLeft;
+
+                bool            connect         ();
+                void            disconnect      ();
+                bool            sendRequest     (const Chunk *chunk);
+                bool            resendRequests  ();
+                int             readHeader      ();
+                bool            readBodyChunkSize();
+                int             readBody        (void *p_buffer, size_t len);
+                void            nextResponse    ();
+        };
+    }
+}
+
+#endif /* PERSISTENTCONNECTION_H_ */
@@ -62,6 +62,8 @@ vlc_module_end()
  *
  *****************************************************************************/
 #define AES_BLOCK_SIZE 16 /* Only support AES-128 */
+#define HLS_DOWNLOADS   3  /* segments downloaded at once */
+#define HLS_BW_SAMPLES  5  /* throughput samples of the bandwidth estimate */
 typedef struct segment_s
 {
     int         sequence;   /* unique sequence number */
@@ -102,7 +104,8 @@ struct stream_sys_t
 {
     char         *m3u8;         /* M3U8 url */
     vlc_thread_t  reload;       /* HLS m3u8 reload thread */
-    vlc_thread_t  thread;       /* HLS segment download thread */
+    vlc_thread_t  thread[HLS_DOWNLOADS]; /* HLS segment download threads */
+    int           threads;
 
     block_t      *peeked;
 
@@ -118,8 +121,21 @@ struct stream_sys_t
         int         seek;       /* segment requested by seek (default -1) */
         vlc_mutex_t lock_wait;  /* protect segment download counter */
         vlc_cond_t  wait;       /* some condition to wait on */
+        vlc_mutex_t lock_keys;  /* serializes the loading of AES keys */
     } download;
 
+    /* Bandwidth estimation, shared by the download threads */
+    struct hls_bandwidth_s
+    {
+        vlc_mutex_t lock;
+        int         active;     /* downloads in progress */
+        mtime_t     since;      /* last change of the active downloads */
+        mtime_t     busy;       /* time spent downloading, not sampled yet */
+        uint64_t    bytes;      /* bytes downloaded, not sampled yet */
+        uint64_t    samples[HLS_BW_SAMPLES]; /* throughput (bits per second) */
+        unsigned    count;      /* samples taken */
+    } bw;
+
     /* Playback */
     struct hls_playback_s
     {
@@ -1188,7 +1204,12 @@ static int hls_DecodeSegmentData(stream_t *s, hls_stream_t *hls, segment_t *segm
     if (!segment->b_key_loaded)
     {
         /* No ? try to download it now */
-        if (hls_ManageSegmentKeys(s, hls) != VLC_SUCCESS)
+        stream_sys_t *p_sys = s->p_sys;
+
+        vlc_mutex_lock(&p_sys->download.lock_keys);
+        int ret = hls_ManageSegmentKeys(s, hls);
+        vlc_mutex_unlock(&p_sys->download.lock_keys);
+        if (ret != VLC_SUCCESS)
             return VLC_EGENERIC;
     }
 
@@ -1215,17 +1236,20 @@ static int hls_DecodeSegmentData(stream_t *s, hls_stream_t *hls, segment_t *segm
         return VLC_EGENERIC;
     }
 
+    /* Segments are decoded concurrently: the IV is not stored */
+    uint8_t iv[AES_BLOCK_SIZE];
     if (hls->b_iv_loaded == false)
     {
-        memset(hls->psz_AES_IV, 0, AES_BLOCK_SIZE);
-        hls->psz_AES_IV[15] = segment->sequence & 0xff;
-        hls->psz_AES_IV[14] = (segment->sequence >> 8)& 0xff;
-        hls->psz_AES_IV[13] = (segment->sequence >> 16)& 0xff;
-        hls->psz_AES_IV[12] = (segment->sequence >> 24)& 0xff;
+        memset(iv, 0, AES_BLOCK_SIZE);
+        iv[15] = segment->sequence & 0xff;
+        iv[14] = (segment->sequence >> 8)& 0xff;
+        iv[13] = (segment->sequence >> 16)& 0xff;
+        iv[12] = (segment->sequence >> 24)& 0xff;
     }
+    else
+        memcpy(iv, hls->psz_AES_IV, AES_BLOCK_SIZE);
 
-    i_gcrypt_err = gcry_cipher_setiv(aes_ctx, hls->psz_AES_IV,
-                                      sizeof(hls->psz_AES_IV));
+    i_gcrypt_err = gcry_cipher_setiv(aes_ctx, iv, sizeof(iv));
 
     if (i_gcrypt_err)
     {
@@ -1443,13 +1467,71 @@ static int hls_ReloadPlaylist(stream_t *s)
 /****************************************************************************
  * hls_Thread
  ****************************************************************************/
-static int BandwidthAdaptation(stream_t *s, int progid, uint64_t *bandwidth)
+/* Downloads overlap, so the throughput is measured over the time at least one
+ * of them was in progress, rather than per segment */
+static void bandwidth_Start(stream_sys_t *p_sys)
+{
+    vlc_mutex_lock(&p_sys->bw.lock);
+    mtime_t now = mdate();
+    if (p_sys->bw.active++ > 0)
+        p_sys->bw.busy += now - p_sys->bw.since;
+    p_sys->bw.since = now;
+    vlc_mutex_unlock(&p_sys->bw.lock);
+}
+
+/* Returns the bandwidth estimate (bits per second), 0 if there is none yet */
+static uint64_t bandwidth_Stop(stream_sys_t *p_sys, uint64_t size)
+{
+    uint64_t estimate = 0;
+
+    vlc_mutex_lock(&p_sys->bw.lock);
+    mtime_t now = mdate();
+    p_sys->bw.busy += now - p_sys->bw.since;
+    p_sys->bw.since = now;
+    p_sys->bw.active--;
+
+    /* the time spent on failed downloads counts against the next sample */
+    p_sys->bw.bytes += size;
+    if (p_sys->bw.bytes > 0 && p_sys->bw.busy > 0)
+    {
+        p_sys->bw.samples[p_sys->bw.count++ % HLS_BW_SAMPLES] =
+            p_sys->bw.bytes * 8 * CLOCK_FREQ / p_sys->bw.busy;
+        p_sys->bw.bytes = 0;
+        p_sys->bw.busy = 0;
+    }
+
+    /* The harmonic mean follows drops quickly, and is not fooled by a
+     * single fast segment */
+    unsigned n = __MIN(p_sys->bw.count, HLS_BW_SAMPLES);
+    if (n > 0)
+    {
+        double inverse = 0.;
+        for (unsigned i = 0; i < n; i++)
+            inverse += 1. / __MAX(p_sys->bw.samples[i], 1);
+        estimate = n / inverse;
+    }
+    p_sys->bandwidth = estimate;
+    vlc_mutex_unlock(&p_sys->bw.lock);
+    return estimate;
+}
+
+/* Picks the stream to download from, given the bandwidth estimate and the
+ * amount of media downloaded ahead of playback (seconds). */
+static int BandwidthAdaptation(stream_t *s, int progid, uint64_t bw, int buffered,
+                               int duration)
 {
     stream_sys_t *p_sys = s->p_sys;
-    int candidate = -1;
-    uint64_t bw = *bandwidth;
+    int candidate = -1, lowest = -1;
     uint64_t bw_candidate = 0;
 
+    /* The less is buffered, the less the estimate can be trusted */
+    if (buffered < duration)
+        bw = 0;
+    else if (buffered < 3 * duration)
+        bw = bw * 7 / 10;
+    else
+        bw = bw * 9 / 10;
+
     int count = vlc_array_count(p_sys->hls_stream);
     for (int n = 0; n < count; n++)
     {
@@ -1460,6 +1542,8 @@ static int BandwidthAdaptation(stream_t *s, int progid, uint64_t *bandwidth)
         /* only consider streams with the same PROGRAM-ID */
         if (hls->id == progid)
         {
+            if (lowest < 0)
+                lowest = n; /* streams are sorted by bandwidth */
             if ((bw >= hls->bandwidth) && (bw_candidate < hls->bandwidth))
             {
                 msg_Dbg(s, "candidate %d bandwidth (bits/s) %"PRIu64" >= %"PRIu64,
@@ -1469,8 +1553,7 @@ static int BandwidthAdaptation(stream_t *s, int progid, uint64_t *bandwidth)
             }
         }
     }
-    *bandwidth = bw_candidate;
-    return candidate;
+    return (candidate >= 0) ? candidate : lowest;
 }
 
 static int hls_DownloadSegmentData(stream_t *s, hls_stream_t *hls, segment_t *segment, int *cur_stream)
@@ -1489,10 +1572,11 @@ static int hls_DownloadSegmentData(stream_t *s, hls_stream_t *hls, segment_t *se
     }
 
     /* sanity check - can we download this segment on time? */
-    if ((p_sys->bandwidth > 0) && (hls->bandwidth > 0))
+    uint64_t estimate = p_sys->bandwidth;
+    if ((estimate > 0) && (hls->bandwidth > 0))
     {
         uint64_t size = (segment->duration * hls->bandwidth); /* bits */
-        int estimated = (int)(size / p_sys->bandwidth);
+        int estimated = (int)(size / estimate);
         if (estimated > segment->duration)
         {
             msg_Warn(s,"downloading of segment %d takes %ds, which is longer than its playback (%ds)",
@@ -1500,15 +1584,16 @@ static int hls_DownloadSegmentData(stream_t *s, hls_stream_t *hls, segment_t *se
         }
     }
 
-    mtime_t start = mdate();
+    bandwidth_Start(p_sys);
     if (hls_Download(s, segment) != VLC_SUCCESS)
     {
+        bandwidth_Stop(p_sys, 0);
         msg_Err(s, "downloaded segment %d from stream %d failed",
                     segment->sequence, *cur_stream);
         vlc_mutex_unlock(&segment->lock);
         return VLC_EGENERIC;
     }
-    mtime_t duration = mdate() - start;
+    estimate = bandwidth_Stop(p_sys, segment->size);
     if (hls->bandwidth == 0 && segment->duration > 0)
     {
         /* Try to estimate the bandwidth for this stream */
@@ -1527,23 +1612,29 @@ static int hls_DownloadSegmentData(stream_t *s, hls_stream_t *hls, segment_t *se
     msg_Info(s, "downloaded segment %d from stream %d",
                 segment->sequence, *cur_stream);
 
-    uint64_t bw = segment->size * 8 * 1000000 / __MAX(1, duration); /* bits / s */
-    p_sys->bandwidth = bw;
-    if (p_sys->b_meta && (hls->bandwidth != bw))
+    if (p_sys->b_meta && estimate > 0)
     {
-        int newstream = BandwidthAdaptation(s, hls->id, &bw);
+        /* Segments downloaded and not played yet */
+        vlc_mutex_lock(&p_sys->bw.lock);
+        int active = p_sys->bw.active;
+        vlc_mutex_unlock(&p_sys->bw.lock);
+        int ahead = p_sys->download.segment - p_sys->playback.segment - active;
 
-        /* FIXME: we need an average here */
+        int newstream = BandwidthAdaptation(s, hls->id, estimate,
+                                            __MAX(ahead, 0) * hls->duration,
+                                            hls->duration);
         if ((newstream >= 0) && (newstream != *cur_stream))
         {
             msg_Info(s, "detected %s bandwidth (%"PRIu64") stream",
-                     (bw >= hls->bandwidth) ? "faster" : "lower", bw);
+                     (newstream > *cur_stream) ? "faster" : "lower", estimate);
             *cur_stream = newstream;
         }
     }
     return VLC_SUCCESS;
 }
 
+/* Each download thread takes the next segment to download, so that the
+ * following ones are already on their way while one is being received. */
 static void* hls_Thread(void *p_this)
 {
     stream_t *s = (stream_t *)p_this;
@@ -1553,47 +1644,43 @@ static void* hls_Thread(void *p_this)
 
     while (vlc_object_alive(s))
     {
-        hls_stream_t *hls = hls_Get(p_sys->hls_stream, p_sys->download.stream);
-        assert(hls);
-
-        /* Sliding window (~60 seconds worth of movie) */
-        vlc_mutex_lock(&hls->lock);
-        int count = vlc_array_count(hls->segments);
-        vlc_mutex_unlock(&hls->lock);
-
-        /* Is there a new segment to process? */
-        if ((!p_sys->b_live && (p_sys->playback.segment < (count - 6))) ||
-            (p_sys->download.segment >= count))
+        /* Is there a new segment to process?
+         * Sliding window (~60 seconds worth of movie) */
+        vlc_mutex_lock(&p_sys->download.lock_wait);
+        for (;;)
         {
-            /* wait */
-            vlc_mutex_lock(&p_sys->download.lock_wait);
-            while (((p_sys->download.segment - p_sys->playback.segment > 6) ||
-                    (p_sys->download.segment >= count)) &&
-                   (p_sys->download.seek == -1))
-            {
-                vlc_cond_wait(&p_sys->download.wait, &p_sys->download.lock_wait);
-                if (p_sys->b_live /*&& (mdate() >= p_sys->playlist.wakeup)*/)
-                    break;
-                if (!vlc_object_alive(s))
-                    break;
-            }
-            /* */
             if (p_sys->download.seek >= 0)
             {
                 p_sys->download.segment = p_sys->download.seek;
                 p_sys->download.seek = -1;
             }
-            vlc_mutex_unlock(&p_sys->download.lock_wait);
+
+            hls_stream_t *hls = hls_Get(p_sys->hls_stream, p_sys->download.stream);
+            assert(hls);
+            vlc_mutex_lock(&hls->lock);
+            int count = vlc_array_count(hls->segments);
+            vlc_mutex_unlock(&hls->lock);
+
+            if (!vlc_object_alive(s) ||
+                ((p_sys->download.segment < count) &&
+                 (p_sys->download.segment - p_sys->playback.segment <= 6)))
+                break;
+            vlc_cond_wait(&p_sys->download.wait, &p_sys->download.lock_wait);
         }
+        int current = p_sys->download.segment++;
+        int stream = p_sys->download.stream;
+        vlc_mutex_unlock(&p_sys->download.lock_wait);
 
         if (!vlc_object_alive(s)) break;
 
+        hls_stream_t *hls = hls_Get(p_sys->hls_stream, stream);
         vlc_mutex_lock(&hls->lock);
-        segment_t *segment = segment_GetSegment(hls, p_sys->download.segment);
+        segment_t *segment = segment_GetSegment(hls, current);
         vlc_mutex_unlock(&hls->lock);
 
+        int newstream = stream;
         if ((segment != NULL) &&
-            (hls_DownloadSegmentData(s, hls, segment, &p_sys->download.stream) != VLC_SUCCESS))
+            (hls_DownloadSegmentData(s, hls, segment, &newstream) != VLC_SUCCESS))
         {
             if (!vlc_object_alive(s)) break;
 
@@ -1604,17 +1691,12 @@ static void* hls_Thread(void *p_this)
             }
         }
 
-        /* download succeeded */
-        /* determine next segment to download */
+        /* download done: switch stream if needed, wake up playback and
+         * the other download threads */
         vlc_mutex_lock(&p_sys->download.lock_wait);
-        if (p_sys->download.seek >= 0)
-        {
-            p_sys->download.segment = p_sys->download.seek;
-            p_sys->download.seek = -1;
-        }
-        else if (p_sys->download.segment < count)
-            p_sys->download.segment++;
-        vlc_cond_signal(&p_sys->download.wait);
+        if (newstream != stream)
+            p_sys->download.stream = newstream;
+        vlc_cond_broadcast(&p_sys->download.wait);
         vlc_mutex_unlock(&p_sys->download.lock_wait);
     }
 
@@ -1657,6 +1739,11 @@ static void* hls_Reload(void *p_this)
             {
                 p_sys->playlist.tries = 0;
                 wait = 0.5;
+
+                /* new segments may be available */
+                vlc_mutex_lock(&p_sys->download.lock_wait);
+                vlc_cond_broadcast(&p_sys->download.wait);
+                vlc_mutex_unlock(&p_sys->download.lock_wait);
             }
 
             hls_stream_t *hls = hls_Get(p_sys->hls_stream, p_sys->download.stream);
@@ -1929,6 +2016,9 @@ static int Open(vlc_object_t *p_this)
     s->pf_peek = Peek;
     s->pf_control = Control;
 
+    vlc_mutex_init(&p_sys->bw.lock);
+    vlc_mutex_init(&p_sys->download.lock_keys);
+
     /* Parse HLS m3u8 content. */
     uint8_t *buffer = NULL;
     ssize_t len = read_M3U8_from_stream(s->p_source, &buffer);
@@ -1984,7 +2074,11 @@ static int Open(vlc_object_t *p_this)
         }
     }
 
-    if (vlc_clone(&p_sys->thread, hls_Thread, s, VLC_THREAD_PRIORITY_INPUT))
+    for (p_sys->threads = 0; p_sys->threads < HLS_DOWNLOADS; p_sys->threads++)
+        if (vlc_clone(&p_sys->thread[p_sys->threads], hls_Thread, s,
+                      VLC_THREAD_PRIORITY_INPUT))
+            break;
+    if (p_sys->threads == 0)
     {
         if (p_sys->b_live)
             vlc_join(p_sys->reload, NULL);
@@ -1998,6 +2092,9 @@ fail_thread:
     vlc_cond_destroy(&p_sys->download.wait);
 
 fail:
+    vlc_mutex_destroy(&p_sys->bw.lock);
+    vlc_mutex_destroy(&p_sys->download.lock_keys);
+
     /* Free hls streams */
     for (int i = 0; i < vlc_array_count(p_sys->hls_stream); i++)
     {
@@ -2024,15 +2121,18 @@ static void Close(vlc_object_t *p_this)
 
     /* */
     vlc_mutex_lock(&p_sys->download.lock_wait);
-    vlc_cond_signal(&p_sys->download.wait);
+    vlc_cond_broadcast(&p_sys->download.wait);
     vlc_mutex_unlock(&p_sys->download.lock_wait);
 
     /* */
     if (p_sys->b_live)
         vlc_join(p_sys->reload, NULL);
-    vlc_join(p_sys->thread, NULL);
+    for (int i = 0; i < p_sys->threads; i++)
+        vlc_join(p_sys->thread[i], NULL);
     vlc_mutex_destroy(&p_sys->download.lock_wait);
     vlc_cond_destroy(&p_sys->download.wait);
+    vlc_mutex_destroy(&p_sys->download.lock_keys);
+    vlc_mutex_destroy(&p_sys->bw.lock);
 
     /* Free hls streams */
     for (int i = 0; i < vlc_array_count(p_sys->hls_stream); i++)
@@ -2184,7 +2284,7 @@ static ssize_t hls_Read(stream_t *s, uint8_t *p_read, unsigned int i_read)
 
             /* signal download thread */
             vlc_mutex_lock(&p_sys->download.lock_wait);
-            vlc_cond_signal(&p_sys->download.wait);
+            vlc_cond_broadcast(&p_sys->download.wait);
             vlc_mutex_unlock(&p_sys->download.lock_wait);
             continue;
         }
@@ -2450,7 +2550,7 @@ static int segment_Seek(stream_t *s, const uint64_t pos)
         /* Wake up download thread */
         vlc_mutex_lock(&p_sys->download.lock_wait);
         p_sys->download.seek = p_sys->playback.segment;
-        vlc_cond_signal(&p_sys->download.wait);
+        vlc_cond_broadcast(&p_sys->download.wait);
 
         /* Wait for download to be finished */
         msg_Info(s, "seek to segment %d", p_sys->playback.segment);
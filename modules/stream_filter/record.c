@@ -35,7 +35,11 @@
 #include <vlc_stream.h>
 #include <vlc_input.h>
 #include <vlc_fs.h>
+#include <vlc_block.h>
 
+#include <fcntl.h>
+
+#include "../access_output/writer.h"
 
 /*****************************************************************************
  * Module descriptor
@@ -43,11 +47,34 @@
 static int  Open ( vlc_object_t * );
 static void Close( vlc_object_t * );
 
+#define QUEUE_TEXT N_("Record queue size (MiB)")
+#define QUEUE_LONGTEXT N_( \
+    "Recorded data waiting to be written, at most. The data is written " \
+    "from a dedicated thread, so that a slow storage does not stall " \
+    "the playback." )
+#define OVERFLOW_TEXT N_("Record queue overflow")
+#define OVERFLOW_LONGTEXT N_( \
+    "What to do when the storage is too slow for the recording." )
+#define DIRECT_TEXT N_("Record with direct I/O")
+#define DIRECT_LONGTEXT N_( \
+    "Write the recording around the page cache (O_DIRECT)." )
+
+static const char *const ppsz_overflow[] = { "drop", "block" };
+static const char *const ppsz_overflow_text[] = {
+    N_("Drop data"), N_("Wait (stalls the playback)") };
+
 vlc_module_begin()
     set_category( CAT_INPUT )
     set_subcategory( SUBCAT_INPUT_STREAM_FILTER )
     set_description( N_("Internal stream record") )
     set_capability( "stream_filter", 0 )
+    add_integer( "stream-record-queue", 32, QUEUE_TEXT, QUEUE_LONGTEXT, true )
+        change_integer_range( 1, 1024 )
+    add_string( "stream-record-overflow", "drop", OVERFLOW_TEXT,
+                OVERFLOW_LONGTEXT, true )
+        change_string_list( ppsz_overflow, ppsz_overflow_text, NULL )
+    add_bool( "stream-record-direct", false, DIRECT_TEXT, DIRECT_LONGTEXT,
+              true )
     set_callbacks( Open, Close )
 vlc_module_end()
 
@@ -56,8 +83,7 @@ vlc_module_end()
  *****************************************************************************/
 struct stream_sys_t
 {
-    FILE *f;        /* TODO it could be replaced by access_output_t one day */
-    bool b_error;
+    async_writer_t *writer; /* TODO it could be replaced by access_output_t one day */
 };
 
 
@@ -85,7 +111,7 @@ static int Open ( vlc_object_t *p_this )
     if( !p_sys )
         return VLC_ENOMEM;
 
-    p_sys->f = NULL;
+    p_sys->writer = NULL;
 
     /* */
     s->pf_read = Read;
@@ -103,7 +129,7 @@ static void Close( vlc_object_t *p_this )
     stream_t *s = (stream_t*)p_this;
     stream_sys_t *p_sys = s->p_sys;
 
-    if( p_sys->f )
+    if( p_sys->writer )
         Stop( s );
 
     free( p_sys );
@@ -118,14 +144,14 @@ static int Read( stream_t *s, void *p_read, unsigned int i_read )
     void *p_record = p_read;
 
     /* Allocate a temporary buffer for record when no p_read */
-    if( p_sys->f && !p_record )
+    if( p_sys->writer && !p_record )
         p_record = malloc( i_read );
 
     /* */
     const int i_record = stream_Read( s->p_source, p_record, i_read );
 
     /* Dump read data */
-    if( p_sys->f )
+    if( p_sys->writer )
     {
         if( p_record && i_record > 0 )
             Write( s, p_record, i_record );
@@ -151,7 +177,7 @@ static int Control( stream_t *s, int i_query, va_list args )
     if( b_active )
         psz_extension = (const char*)va_arg( args, const char* );
 
-    if( !s->p_sys->f == !b_active )
+    if( !s->p_sys->writer == !b_active )
         return VLC_SUCCESS;
 
     if( b_active )
@@ -168,7 +194,7 @@ static int Start( stream_t *s, const char *psz_extension )
     stream_sys_t *p_sys = s->p_sys;
 
     char *psz_file;
-    FILE *f;
+    int fd;
 
     /* */
     if( !psz_extension )
@@ -191,33 +217,48 @@ static int Start( stream_t *s, const char *psz_extension )
     if( !psz_file )
         return VLC_ENOMEM;
 
-    f = vlc_fopen( psz_file, "wb" );
-    if( !f )
+    fd = vlc_open( psz_file, O_WRONLY | O_CREAT | O_TRUNC, 0666 );
+    if( fd == -1 )
     {
         free( psz_file );
         return VLC_EGENERIC;
     }
 
+    /* Written by another thread, not to stall the playback */
+    char *psz_overflow = var_InheritString( s, "stream-record-overflow" );
+    enum async_writer_overflow overflow = ASYNC_WRITER_DROP;
+
+    if( psz_overflow != NULL && !strcmp( psz_overflow, "block" ) )
+        overflow = ASYNC_WRITER_BLOCK;
+    free( psz_overflow );
+
+    p_sys->writer = async_writer_New( s, fd,
+        (size_t)var_InheritInteger( s, "stream-record-queue" ) << 20,
+        overflow, var_InheritBool( s, "stream-record-direct" ) );
+    if( !p_sys->writer )
+    {
+        close( fd );
+        free( psz_file );
+        return VLC_ENOMEM;
+    }
+
     /* signal new record file */
     var_SetString( s->p_libvlc, "record-file", psz_file );
 
     msg_Dbg( s, "Recording into %s", psz_file );
     free( psz_file );
 
-    /* */
-    p_sys->f = f;
-    p_sys->b_error = false;
     return VLC_SUCCESS;
 }
 static int Stop( stream_t *s )
 {
     stream_sys_t *p_sys = s->p_sys;
 
-    assert( p_sys->f );
+    assert( p_sys->writer );
 
+    async_writer_Delete( p_sys->writer );
+    p_sys->writer = NULL;
     msg_Dbg( s, "Recording completed" );
-    fclose( p_sys->f );
-    p_sys->f = NULL;
     return VLC_SUCCESS;
 }
 
@@ -225,19 +266,17 @@ static void Write( stream_t *s, const uint8_t *p_buffer, size_t i_buffer )
 {
     stream_sys_t *p_sys = s->p_sys;
 
-    assert( p_sys->f );
+    assert( p_sys->writer );
 
     if( i_buffer > 0 )
     {
-        const bool b_previous_error = p_sys->b_error;
-        const size_t i_written = fwrite( p_buffer, 1, i_buffer, p_sys->f );
-
-        p_sys->b_error = i_written != i_buffer;
-
-        /* TODO maybe a intf_UserError or something like that ? */
-        if( p_sys->b_error && !b_previous_error )
-            msg_Err( s, "Failed to record data (begin)" );
-        else if( !p_sys->b_error && b_previous_error )
-            msg_Err( s, "Failed to record data (end)" );
+        block_t *p_block = block_Alloc( i_buffer );
+        if( unlikely(p_block == NULL) )
+            return;
+
+        /* The write errors are reported by the writer thread
+         * TODO maybe a intf_UserError or something like that ? */
+        memcpy( p_block->p_buffer, p_buffer, i_buffer );
+        async_writer_Write( p_sys->writer, p_block );
     }
 }
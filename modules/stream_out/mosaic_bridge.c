@@ -384,6 +384,9 @@ static sout_stream_id_t * Add( sout_stream_t *p_stream, es_format_t *p_fmt )
     p_es->p_picture = NULL;
     p_es->pp_last = &p_es->p_picture;
     p_es->b_empty = false;
+    p_es->i_tile_width = 0;
+    p_es->i_tile_height = 0;
+    p_es->b_tile_ar = false;
 
     vlc_global_unlock( VLC_MOSAIC_MUTEX );
 
@@ -529,8 +532,39 @@ static int Send( sout_stream_t *p_stream, sout_stream_id_t *id,
                                                         &p_buffer )) )
     {
         picture_t *p_new_pic;
+        int i_tile_width = 0, i_tile_height = 0;
+        bool b_tile_ar = false;
 
-        if( p_sys->i_height || p_sys->i_width )
+        if( !p_sys->i_height && !p_sys->i_width )
+        {
+            /* Scale to the tile of the mosaic if it asked for it */
+            vlc_global_lock( VLC_MOSAIC_MUTEX );
+            i_tile_width = p_sys->p_es->i_tile_width;
+            i_tile_height = p_sys->p_es->i_tile_height;
+            b_tile_ar = p_sys->p_es->b_tile_ar;
+            vlc_global_unlock( VLC_MOSAIC_MUTEX );
+
+            if( i_tile_width > 0 && i_tile_height > 0 && !p_sys->p_image )
+                p_sys->p_image = image_HandlerCreate( p_stream );
+        }
+
+        if( i_tile_width > 0 && i_tile_height > 0 && p_sys->p_image )
+        {
+            video_format_t fmt_out, fmt_in = p_sys->p_decoder->fmt_out.video;
+
+            GetTileFormat( &fmt_out, &fmt_in,
+                           i_tile_width, i_tile_height, b_tile_ar );
+
+            p_new_pic = image_Convert( p_sys->p_image, p_pic,
+                                       &fmt_in, &fmt_out );
+            if( p_new_pic == NULL )
+            {
+                msg_Err( p_stream, "image conversion failed" );
+                picture_Release( p_pic );
+                continue;
+            }
+        }
+        else if( p_sys->i_height || p_sys->i_width )
         {
             video_format_t fmt_out, fmt_in;
 
@@ -324,7 +324,7 @@ static int OutputNew( sout_stream_t *p_stream,
     }
     free( psz_tmp );
 
-    if( asprintf( &psz_output, "std{access=file,mux='%s',dst='%s'}",
+    if( asprintf( &psz_output, "std{access=file{async},mux='%s',dst='%s'}",
                   psz_muxer, psz_file ) < 0 )
     {
         psz_output = NULL;
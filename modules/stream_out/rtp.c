@@ -174,6 +174,12 @@ static const char *const ppsz_protocols[] = {
     "negative value or zero disables timeouts. The default is 60 (one " \
     "minute)." )
 
+#define VOD_SHARE_TEXT N_( "VoD sharing window (ms)" )
+#define VOD_SHARE_LONGTEXT N_( "RTSP VoD sessions starting within this " \
+    "distance of the current position of a running instance of the same " \
+    "media join that instance, instead of reading and packetizing the " \
+    "media on their own. Zero disables the sharing." )
+
 #define RTSP_USER_TEXT N_("Username")
 #define RTSP_USER_LONGTEXT N_("User name that will be " \
                               "requested to access the stream." )
@@ -255,6 +261,8 @@ vlc_module_begin ()
     add_shortcut( "rtsp" )
     add_integer( "rtsp-timeout", 60, RTSP_TIMEOUT_TEXT,
                  RTSP_TIMEOUT_LONGTEXT, true )
+    add_integer( "rtsp-vod-share", 2000, VOD_SHARE_TEXT,
+                 VOD_SHARE_LONGTEXT, true )
     add_string( "sout-rtsp-user", "",
                 RTSP_USER_TEXT, RTSP_USER_LONGTEXT, true )
     add_password( "sout-rtsp-pwd", "",
@@ -351,6 +359,8 @@ typedef struct rtp_sink_t
 {
     int rtp_fd;
     rtcp_sender_t *rtcp;
+    bool b_shared;  /* RTSP VoD client of an instance shared with others */
+    uint8_t ssrc[4]; /* SSRC announced to that client */
 } rtp_sink_t;
 
 struct sout_stream_id_t
@@ -1401,8 +1411,6 @@ static int  HttpCallback( httpd_file_sys_t *p_args,
 /****************************************************************************
  * RTP send
  ****************************************************************************/
-static void* ThreadSend( void *data )
-{
 #ifdef WIN32
 # define ECONNREFUSED WSAECONNREFUSED
 # define ENOPROTOOPT  WSAENOPROTOOPT
@@ -1413,6 +1421,86 @@ static void* ThreadSend( void *data )
 # define EAGAIN       WSAEWOULDBLOCK
 # define EWOULDBLOCK  WSAEWOULDBLOCK
 #endif
+
+/* Maximum number of due packets sent to a sink in one go */
+#define RTP_BATCH_MAX 64
+
+#ifdef HAVE_SRTP
+static block_t *rtp_protect( sout_stream_id_t *id, block_t *out )
+{   /* FIXME: this is awfully inefficient */
+    size_t len = out->i_buffer;
+    out = block_Realloc( out, 0, len + 10 );
+    out->i_buffer = len;
+
+    int canc = vlc_savecancel ();
+    int val = srtp_send( id->srtp, out->p_buffer, &len, len + 10 );
+    vlc_restorecancel (canc);
+    if( val )
+    {
+        errno = val;
+        msg_Dbg( id->p_stream, "SRTP sending error: %m" );
+        block_Release( out );
+        return NULL;
+    }
+    out->i_buffer = len;
+    return out;
+}
+#endif
+
+/**
+ * Sends packets to one sink.
+ * @return -1 if the connection is broken, 0 otherwise
+ */
+static int rtp_send_packets( int fd, block_t *const *outv, unsigned outc )
+{
+#ifdef HAVE_SENDMMSG
+    struct mmsghdr msgv[RTP_BATCH_MAX];
+    struct iovec iov[RTP_BATCH_MAX];
+
+    memset( msgv, 0, outc * sizeof (*msgv) );
+    for( unsigned i = 0; i < outc; i++ )
+    {
+        iov[i].iov_base = outv[i]->p_buffer;
+        iov[i].iov_len = outv[i]->i_buffer;
+        msgv[i].msg_hdr.msg_iov = &iov[i];
+        msgv[i].msg_hdr.msg_iovlen = 1;
+    }
+#endif
+
+    for( unsigned i = 0; i < outc; )
+    {
+#ifdef HAVE_SENDMMSG
+        int val = sendmmsg( fd, &msgv[i], outc - i, 0 );
+        if( val >= 0 )
+        {
+            i += val;
+            continue;
+        }
+#else
+        if( send( fd, outv[i]->p_buffer, outv[i]->i_buffer, 0 ) != -1 )
+        {
+            i++;
+            continue;
+        }
+#endif
+        if( net_errno != EAGAIN && net_errno != EWOULDBLOCK
+         && net_errno != ENOBUFS && net_errno != ENOMEM )
+        {
+            int type;
+            getsockopt( fd, SOL_SOCKET, SO_TYPE,
+                        &type, &(socklen_t){ sizeof(type) });
+            if( type != SOCK_DGRAM )
+                return -1; /* Broken connection */
+            /* ICMP soft error: ignore and retry */
+            send( fd, outv[i]->p_buffer, outv[i]->i_buffer, 0 );
+        }
+        i++;
+    }
+    return 0;
+}
+
+static void* ThreadSend( void *data )
+{
     sout_stream_id_t *id = data;
     unsigned i_caching = id->i_caching;
 
@@ -1423,24 +1511,7 @@ static void* ThreadSend( void *data )
 
 #ifdef HAVE_SRTP
         if( id->srtp )
-        {   /* FIXME: this is awfully inefficient */
-            size_t len = out->i_buffer;
-            out = block_Realloc( out, 0, len + 10 );
-            out->i_buffer = len;
-
-            int canc = vlc_savecancel ();
-            int val = srtp_send( id->srtp, out->p_buffer, &len, len + 10 );
-            vlc_restorecancel (canc);
-            if( val )
-            {
-                errno = val;
-                msg_Dbg( id->p_stream, "SRTP sending error: %m" );
-                block_Release( out );
-                out = NULL;
-            }
-            else
-                out->i_buffer = len;
-        }
+            out = rtp_protect( id, out );
         if (out)
             mwait (out->i_dts + i_caching);
         vlc_cleanup_pop ();
@@ -1451,8 +1522,28 @@ static void* ThreadSend( void *data )
         vlc_cleanup_pop ();
 #endif
 
-        ssize_t len = out->i_buffer;
         int canc = vlc_savecancel ();
+        block_t *outv[RTP_BATCH_MAX];
+        unsigned outc = 0;
+
+        /* Packets that are already due (typically the rest of the same
+         * frame) are sent together */
+        outv[outc++] = out;
+        while( outc < RTP_BATCH_MAX && block_FifoCount( id->p_fifo ) > 0
+            && block_FifoShow( id->p_fifo )->i_dts + i_caching <= mdate() )
+        {
+            out = block_FifoGet( id->p_fifo );
+#ifdef HAVE_SRTP
+            if( id->srtp && (out = rtp_protect( id, out )) == NULL )
+                continue;
+#endif
+            outv[outc++] = out;
+        }
+
+        /* Sequence number of the original packets */
+        uint16_t i_seq_last = GetWBE( outv[outc - 1]->p_buffer + 2 );
+        /* SSRC currently in the packets */
+        const uint8_t *ssrc = id->ssrc;
 
         vlc_mutex_lock( &id->lock_sink );
         unsigned deadc = 0; /* How many dead sockets? */
@@ -1460,29 +1551,35 @@ static void* ThreadSend( void *data )
 
         for( int i = 0; i < id->sinkc; i++ )
         {
+            /* The clients of a shared VoD instance each know their own
+             * SSRC. The packets are rewritten in place between sinks, as
+             * they are copied by the kernel anyway. */
+            const uint8_t *sink_ssrc = id->sinkv[i].b_shared
+                                       ? id->sinkv[i].ssrc : id->ssrc;
 #ifdef HAVE_SRTP
-            if( !id->srtp ) /* FIXME: SRTCP support */
+            if( id->srtp ) /* cannot rewrite authenticated packets */
+                sink_ssrc = ssrc;
 #endif
-                SendRTCP( id->sinkv[i].rtcp, out );
-
-            if( send( id->sinkv[i].rtp_fd, out->p_buffer, len, 0 ) == -1
-             && net_errno != EAGAIN && net_errno != EWOULDBLOCK
-             && net_errno != ENOBUFS && net_errno != ENOMEM )
+            if( memcmp( sink_ssrc, ssrc, 4 ) )
             {
-                int type;
-                getsockopt( id->sinkv[i].rtp_fd, SOL_SOCKET, SO_TYPE,
-                            &type, &(socklen_t){ sizeof(type) });
-                if( type == SOCK_DGRAM )
-                    /* ICMP soft error: ignore and retry */
-                    send( id->sinkv[i].rtp_fd, out->p_buffer, len, 0 );
-                else
-                    /* Broken connection */
-                    deadv[deadc++] = id->sinkv[i].rtp_fd;
+                for( unsigned j = 0; j < outc; j++ )
+                    memcpy( outv[j]->p_buffer + 8, sink_ssrc, 4 );
+                ssrc = sink_ssrc;
             }
+
+#ifdef HAVE_SRTP
+            if( !id->srtp ) /* FIXME: SRTCP support */
+#endif
+                for( unsigned j = 0; j < outc; j++ )
+                    SendRTCP( id->sinkv[i].rtcp, outv[j] );
+
+            if( rtp_send_packets( id->sinkv[i].rtp_fd, outv, outc ) )
+                deadv[deadc++] = id->sinkv[i].rtp_fd;
         }
-        id->i_seq_sent_next = ntohs(((uint16_t *) out->p_buffer)[1]) + 1;
+        id->i_seq_sent_next = i_seq_last + 1;
         vlc_mutex_unlock( &id->lock_sink );
-        block_Release( out );
+        for( unsigned i = 0; i < outc; i++ )
+            block_Release( outv[i] );
 
         for( unsigned i = 0; i < deadc; i++ )
         {
@@ -1516,11 +1613,11 @@ static void *rtp_listen_thread( void *data )
 }
 
 
-int rtp_add_sink( sout_stream_id_t *id, int fd, bool rtcp_mux, uint16_t *seq )
+static int rtp_insert_sink( sout_stream_id_t *id, rtp_sink_t sink,
+                            bool rtcp_mux, uint16_t *seq )
 {
-    rtp_sink_t sink = { fd, NULL };
-    sink.rtcp = OpenRTCP( VLC_OBJECT( id->p_stream ), fd, IPPROTO_UDP,
-                          rtcp_mux );
+    sink.rtcp = OpenRTCP( VLC_OBJECT( id->p_stream ), sink.rtp_fd,
+                          IPPROTO_UDP, rtcp_mux );
     if( sink.rtcp == NULL )
         msg_Err( id->p_stream, "RTCP failed!" );
 
@@ -1532,9 +1629,27 @@ int rtp_add_sink( sout_stream_id_t *id, int fd, bool rtcp_mux, uint16_t *seq )
     return VLC_SUCCESS;
 }
 
+int rtp_add_sink( sout_stream_id_t *id, int fd, bool rtcp_mux, uint16_t *seq )
+{
+    rtp_sink_t sink = { fd, NULL, false, { 0 } };
+    return rtp_insert_sink( id, sink, rtcp_mux, seq );
+}
+
+/**
+ * Adds the sink of an RTSP VoD client watching an instance it shares with
+ * other clients. Its packets carry the SSRC that was announced to it.
+ */
+int rtp_add_shared_sink( sout_stream_id_t *id, int fd, uint32_t ssrc,
+                         uint16_t *seq )
+{
+    rtp_sink_t sink = { fd, NULL, true, { 0 } };
+    SetDWBE( sink.ssrc, ssrc );
+    return rtp_insert_sink( id, sink, false, seq );
+}
+
 void rtp_del_sink( sout_stream_id_t *id, int fd )
 {
-    rtp_sink_t sink = { fd, NULL };
+    rtp_sink_t sink = { fd, NULL, false, { 0 } };
 
     /* NOTE: must be safe to use if fd is not included */
     vlc_mutex_lock( &id->lock_sink );
@@ -47,6 +47,8 @@ char *SDPGenerateVoD( const vod_media_t *p_media, const char *rtsp_url );
 
 uint32_t rtp_compute_ts( unsigned i_clock_rate, int64_t i_pts );
 int rtp_add_sink( sout_stream_id_t *id, int fd, bool rtcp_mux, uint16_t *seq );
+int rtp_add_shared_sink( sout_stream_id_t *id, int fd, uint32_t ssrc,
+                         uint16_t *seq );
 void rtp_del_sink( sout_stream_id_t *id, int fd );
 uint16_t rtp_get_seq( sout_stream_id_t *id );
 int64_t rtp_get_ts( const sout_stream_t *p_stream, const sout_stream_id_t *id,
@@ -99,6 +101,7 @@ void vod_play(vod_media_t *p_media, const char *psz_session,
               int64_t *start, int64_t end);
 void vod_pause(vod_media_t *p_media, const char *psz_session, int64_t *npt);
 void vod_stop(vod_media_t *p_media, const char *psz_session);
+void vod_play_feed(vod_media_t *p_media, const char *psz_feed, int64_t start);
 
 const char *vod_get_mux(const vod_media_t *p_media);
 int vod_init_id(vod_media_t *p_media, const char *psz_session, int es_id,
@@ -71,6 +71,8 @@ struct rtsp_stream_t
 
     int             timeout;
     vlc_timer_t     timer;
+
+    mtime_t         share_window; /* VoD instance sharing, 0 if disabled */
 };
 
 
@@ -81,6 +83,7 @@ static int  RtspCallbackId( httpd_callback_sys_t *p_args,
                             httpd_client_t *cl, httpd_message_t *answer,
                             const httpd_message_t *query );
 static void RtspClientDel( rtsp_stream_t *rtsp, rtsp_session_t *session );
+static void RtspFeedsForget( rtsp_stream_t *rtsp );
 
 static void RtspTimeOut( void *data );
 
@@ -105,6 +108,20 @@ rtsp_stream_t *RtspSetup( vlc_object_t *owner, vod_media_t *media,
     rtsp->track_id = 0;
     vlc_mutex_init( &rtsp->lock );
 
+    rtsp->share_window = 0;
+    if (media != NULL)
+    {
+        rtsp->share_window =
+            var_InheritInteger(owner, "rtsp-vod-share") * INT64_C(1000);
+        /* SRTP packets cannot be rewritten for each client */
+        char *key = var_InheritString(owner, "sout-rtp-key");
+        if (key != NULL && *key)
+            rtsp->share_window = 0;
+        free(key);
+        if (rtsp->share_window < 0)
+            rtsp->share_window = 0;
+    }
+
     rtsp->timeout = var_InheritInteger(owner, "rtsp-timeout");
     if (rtsp->timeout > 0)
     {
@@ -155,6 +172,8 @@ void RtspUnsetup( rtsp_stream_t *rtsp )
     if( rtsp->host )
         httpd_HostDelete( rtsp->host );
 
+    /* The VLM stops the instances of the media on its own */
+    RtspFeedsForget( rtsp );
     while( rtsp->sessionc > 0 )
         RtspClientDel( rtsp, rtsp->sessionv[0] );
 
@@ -192,6 +211,14 @@ struct rtsp_session_t
     /* output (id-access) */
     int            trackc;
     rtsp_strack_t *trackv;
+
+    /* VoD instance sharing: the instances are started for feed sessions,
+     * that no client knows of. Each playing client watches one feed. */
+    rtsp_session_t *feed;   /* client: the feed it watches, or NULL */
+    unsigned       viewers; /* feed: how many clients watch it */
+    bool           is_feed;
+    bool           ended;   /* feed: its instance has stopped */
+    int64_t        npt;     /* feed: start NPT; client: NPT when paused */
 };
 
 
@@ -207,6 +234,7 @@ struct rtsp_strack_t
 };
 
 static void RtspTrackClose( rtsp_strack_t *tr );
+static void RtspFeedLeave( rtsp_stream_t *rtsp, rtsp_session_t *ses );
 
 #define TRACK_PATH_SIZE (sizeof("/trackID=999") - 1)
 
@@ -316,6 +344,8 @@ static void RtspUpdateTimer( rtsp_stream_t *rtsp )
     mtime_t timeout = 0;
     for (int i = 0; i < rtsp->sessionc; i++)
     {
+        if (rtsp->sessionv[i]->is_feed)
+            continue;
         if (timeout == 0 || rtsp->sessionv[i]->last_seen < timeout)
             timeout = rtsp->sessionv[i]->last_seen;
     }
@@ -333,6 +363,9 @@ static void RtspTimeOut( void *data )
     mtime_t now = mdate();
     for (int i = rtsp->sessionc - 1; i >= 0; i--)
     {
+        /* Deleting a client may have deleted the feed it watched too */
+        if (i >= rtsp->sessionc || rtsp->sessionv[i]->is_feed)
+            continue;
         if (rtsp->sessionv[i]->last_seen + rtsp->timeout * CLOCK_FREQ < now)
         {
             if (rtsp->vod_media != NULL)
@@ -362,6 +395,11 @@ rtsp_session_t *RtspClientNew( rtsp_stream_t *rtsp )
     vlc_rand_bytes (&s->id, sizeof (s->id));
     s->trackc = 0;
     s->trackv = NULL;
+    s->feed = NULL;
+    s->viewers = 0;
+    s->is_feed = false;
+    s->ended = false;
+    s->npt = 0;
 
     TAB_APPEND( rtsp->sessionc, rtsp->sessionv, s );
 
@@ -400,6 +438,7 @@ static
 void RtspClientDel( rtsp_stream_t *rtsp, rtsp_session_t *session )
 {
     int i;
+    RtspFeedLeave( rtsp, session );
     TAB_REMOVE( rtsp->sessionc, rtsp->sessionv, session );
 
     for( i = 0; i < session->trackc; i++ )
@@ -434,6 +473,163 @@ static int dup_socket(int oldfd)
     return newfd;
 }
 
+/** rtsp must be locked */
+static rtsp_strack_t *RtspTrackFind( rtsp_session_t *session,
+                                     const rtsp_stream_id_t *id )
+{
+    for (int i = 0; i < session->trackc; i++)
+        if (session->trackv[i].id == id)
+            return session->trackv + i;
+    return NULL;
+}
+
+/** rtsp must be locked. Starts sending a running RTP id to a track. */
+static int RtspTrackPlay( rtsp_session_t *session, rtsp_strack_t *tr,
+                          uint16_t *seq )
+{
+    assert(tr->sout_id != NULL && tr->setup_fd != -1);
+    tr->rtp_fd = dup_socket(tr->setup_fd);
+    if (tr->rtp_fd == -1)
+        return VLC_EGENERIC;
+
+    if (session->feed != NULL)
+        return rtp_add_shared_sink(tr->sout_id, tr->rtp_fd, tr->ssrc, seq);
+    return rtp_add_sink(tr->sout_id, tr->rtp_fd, false, seq);
+}
+
+/*
+ * VoD instance sharing: rather than one instance per session, the playing
+ * sessions of a media are pooled on feeds. A feed is a session of its own,
+ * for which the VLM runs the instance: it reads, demuxes and packetizes the
+ * media once, and its RTP ids send the packets to the tracks of all the
+ * clients that watch it. A client starting within the sharing window of the
+ * position of a feed watches it, otherwise it starts a new feed. Seeking or
+ * pausing leaves the feed, which stops once nobody watches it anymore.
+ */
+
+/** rtsp must be locked */
+static void RtspFeedName( const rtsp_session_t *feed, char *buf, size_t len )
+{
+    snprintf( buf, len, "%"PRIx64, feed->id );
+}
+
+/** rtsp must be locked */
+static int64_t RtspFeedNPT( const rtsp_session_t *feed )
+{
+    for (int i = 0; i < feed->trackc; i++)
+    {
+        if (feed->trackv[i].sout_id != NULL)
+        {
+            int64_t npt;
+            rtp_get_ts(NULL, feed->trackv[i].sout_id, NULL, NULL, &npt);
+            return feed->npt + npt;
+        }
+    }
+    return feed->npt;
+}
+
+/** rtsp must be locked */
+static rtsp_session_t *RtspFeedFind( rtsp_stream_t *rtsp, int64_t start )
+{
+    rtsp_session_t *best = NULL;
+    int64_t best_dist = 0;
+
+    for (int i = 0; i < rtsp->sessionc; i++)
+    {
+        rtsp_session_t *feed = rtsp->sessionv[i];
+        if (!feed->is_feed || feed->ended)
+            continue;
+
+        int64_t dist = llabs(RtspFeedNPT(feed) - start);
+        if (dist <= rtsp->share_window && (best == NULL || dist < best_dist))
+        {
+            best = feed;
+            best_dist = dist;
+        }
+    }
+    return best;
+}
+
+/** rtsp must be locked */
+static rtsp_session_t *RtspFeedNew( rtsp_stream_t *rtsp, int64_t start )
+{
+    rtsp_session_t *feed = RtspClientNew(rtsp);
+    if (feed == NULL)
+        return NULL;
+
+    feed->is_feed = true;
+    feed->npt = start;
+    return feed;
+}
+
+/** rtsp must be locked */
+static void RtspFeedJoin( rtsp_session_t *ses, rtsp_session_t *feed )
+{
+    for (int i = 0; i < ses->trackc; i++)
+    {
+        rtsp_strack_t *tr = ses->trackv + i;
+        if (tr->setup_fd == -1)
+            continue;
+
+        rtsp_strack_t *ftr = RtspTrackFind(feed, tr->id);
+        if (ftr == NULL)
+        {
+            /* The feed is not running yet: choose the parameters that its
+             * RTP id will start with, as they go in our RTP-Info. */
+            rtsp_strack_t track = { .id = tr->id, .sout_id = NULL,
+                                    .setup_fd = -1, .rtp_fd = -1 };
+            vlc_rand_bytes (&track.seq_init, sizeof (track.seq_init));
+            vlc_rand_bytes (&track.ssrc, sizeof (track.ssrc));
+            INSERT_ELEM(feed->trackv, feed->trackc, feed->trackc, track);
+            ftr = feed->trackv + feed->trackc - 1;
+        }
+        tr->sout_id = ftr->sout_id;
+    }
+
+    ses->feed = feed;
+    feed->viewers++;
+}
+
+/** rtsp must be locked */
+static void RtspFeedLeave( rtsp_stream_t *rtsp, rtsp_session_t *ses )
+{
+    rtsp_session_t *feed = ses->feed;
+    if (feed == NULL)
+        return;
+
+    for (int i = ses->trackc - 1; i >= 0; i--)
+    {
+        rtsp_strack_t *tr = ses->trackv + i;
+        if (tr->sout_id == NULL)
+            continue;
+        if (tr->rtp_fd != -1)
+        {
+            rtp_del_sink(tr->sout_id, tr->rtp_fd);
+            tr->rtp_fd = -1;
+        }
+        tr->sout_id = NULL;
+        if (tr->setup_fd == -1)
+            REMOVE_ELEM( ses->trackv, ses->trackc, i );
+    }
+    ses->feed = NULL;
+
+    if (--feed->viewers == 0)
+    {
+        char name[17];
+        RtspFeedName(feed, name, sizeof (name));
+        msg_Dbg(rtsp->owner, "RTSP: stopping feed %s", name);
+        vod_stop(rtsp->vod_media, name);
+        RtspClientDel(rtsp, feed);
+    }
+}
+
+/** rtsp must be locked */
+static void RtspFeedsForget( rtsp_stream_t *rtsp )
+{
+    for (int i = 0; i < rtsp->sessionc; i++)
+        rtsp->sessionv[i]->feed = NULL;
+}
+
 /* Attach a starting VoD RTP id to its RTSP track, and let it
  * initialize with the parameters of the SETUP request */
 int RtspTrackAttach( rtsp_stream_t *rtsp, const char *name,
@@ -462,7 +658,8 @@ int RtspTrackAttach( rtsp_stream_t *rtsp, const char *name,
     if (tr != NULL)
     {
         tr->sout_id = sout_id;
-        tr->rtp_fd = dup_socket(tr->setup_fd);
+        if (tr->setup_fd != -1)
+            tr->rtp_fd = dup_socket(tr->setup_fd);
     }
     else
     {
@@ -490,6 +687,23 @@ int RtspTrackAttach( rtsp_stream_t *rtsp, const char *name,
         assert(tr->seq_init == seq);
     }
 
+    /* Start sending to the clients watching the feed */
+    for (int i = 0; session->is_feed && i < rtsp->sessionc; i++)
+    {
+        rtsp_session_t *ses = rtsp->sessionv[i];
+        if (ses->feed != session)
+            continue;
+
+        rtsp_strack_t *ctr = RtspTrackFind(ses, id);
+        if (ctr == NULL || ctr->setup_fd == -1 || ctr->rtp_fd != -1)
+            continue;
+
+        uint16_t seq;
+        ctr->sout_id = sout_id;
+        if (RtspTrackPlay(ses, ctr, &seq) == VLC_SUCCESS)
+            assert(tr->seq_init == seq);
+    }
+
     val = VLC_SUCCESS;
 out:
     vlc_mutex_unlock(&rtsp->lock);
@@ -509,6 +723,33 @@ void RtspTrackDetach( rtsp_stream_t *rtsp, const char *name,
     if (session == NULL)
         goto out;
 
+    if (session->is_feed)
+    {
+        /* Stop sending to the clients watching the feed */
+        session->ended = true;
+        for (int i = 0; i < rtsp->sessionc; i++)
+        {
+            rtsp_session_t *ses = rtsp->sessionv[i];
+            if (ses->feed != session)
+                continue;
+
+            for (int j = ses->trackc - 1; j >= 0; j--)
+            {
+                rtsp_strack_t *tr = ses->trackv + j;
+                if (tr->sout_id != sout_id)
+                    continue;
+                if (tr->rtp_fd != -1)
+                {
+                    rtp_del_sink(tr->sout_id, tr->rtp_fd);
+                    tr->rtp_fd = -1;
+                }
+                tr->sout_id = NULL;
+                if (tr->setup_fd == -1)
+                    REMOVE_ELEM( ses->trackv, ses->trackc, j );
+            }
+        }
+    }
+
     for (int i = 0; i < session->trackc; i++)
     {
         rtsp_strack_t *tr = session->trackv + i;
@@ -980,8 +1221,47 @@ static int RtspHandler( rtsp_stream_t *rtsp, rtsp_stream_id_t *id,
                     break;
                 }
             }
+            bool b_shared = false;
+
             vlc_mutex_lock( &rtsp->lock );
             ses = RtspClientGet( rtsp, psz_session );
+            if( ses != NULL && vod && rtsp->share_window > 0 )
+            {
+                b_shared = true;
+                if (start < 0)
+                    start = (ses->feed != NULL) ? RtspFeedNPT(ses->feed)
+                                                : ses->npt;
+                /* Branch off when seeking away from the feed */
+                if (ses->feed != NULL
+                 && llabs(RtspFeedNPT(ses->feed) - start) > rtsp->share_window)
+                    RtspFeedLeave(rtsp, ses);
+
+                if (ses->feed == NULL)
+                {
+                    rtsp_session_t *feed = RtspFeedFind(rtsp, start);
+                    if (feed == NULL)
+                    {
+                        feed = RtspFeedNew(rtsp, start);
+                        if (feed != NULL)
+                        {
+                            /* Queued with the lock held, so that it cannot
+                             * come after the stop of the feed */
+                            char name[17];
+                            RtspFeedName(feed, name, sizeof (name));
+                            msg_Dbg(owner, "RTSP: starting feed %s", name);
+                            vod_play_feed(rtsp->vod_media, name, start);
+                        }
+                    }
+                    if (feed == NULL)
+                    {
+                        vlc_mutex_unlock( &rtsp->lock );
+                        answer->i_status = 500;
+                        break;
+                    }
+                    RtspFeedJoin(ses, feed);
+                }
+                npt = RtspFeedNPT(ses->feed);
+            }
             if( ses != NULL )
             {
                 char info[ses->trackc * ( strlen( control ) + TRACK_PATH_SIZE
@@ -990,6 +1270,16 @@ static int RtspHandler( rtsp_stream_t *rtsp, rtsp_stream_id_t *id,
                 size_t infolen = 0;
                 RtspClientAlive(ses);
 
+                /* The RTP ids of a shared instance are those of the feed */
+                const char *psz_ts_session = psz_session;
+                char psz_feedbuf[17];
+                if (ses->feed != NULL)
+                {
+                    RtspFeedName(ses->feed, psz_feedbuf,
+                                 sizeof (psz_feedbuf));
+                    psz_ts_session = psz_feedbuf;
+                }
+
                 sout_stream_id_t *sout_id = NULL;
                 if (vod)
                 {
@@ -1003,8 +1293,8 @@ static int RtspHandler( rtsp_stream_t *rtsp, rtsp_stream_id_t *id,
                     }
                 }
                 int64_t ts = rtp_get_ts(vod ? NULL : (sout_stream_t *)owner,
-                                        sout_id, rtsp->vod_media, psz_session,
-                                        vod ? NULL : &npt);
+                                        sout_id, rtsp->vod_media,
+                                        psz_ts_session, vod ? NULL : &npt);
 
                 for( int i = 0; i < ses->trackc; i++ )
                 {
@@ -1020,17 +1310,19 @@ static int RtspHandler( rtsp_stream_t *rtsp, rtsp_stream_id_t *id,
                         {
                             /* Track not PLAYing yet */
                             if (tr->sout_id == NULL)
+                            {
                                 /* Instance not running yet (VoD) */
-                                seq = tr->seq_init;
+                                rtsp_strack_t *ftr = NULL;
+                                if (ses->feed != NULL)
+                                    ftr = RtspTrackFind(ses->feed, tr->id);
+                                seq = (ftr != NULL) ? ftr->seq_init
+                                                    : tr->seq_init;
+                            }
                             else
                             {
                                 /* Instance running, add a sink to it */
-                                tr->rtp_fd = dup_socket(tr->setup_fd);
-                                if (tr->rtp_fd == -1)
+                                if (RtspTrackPlay(ses, tr, &seq))
                                     continue;
-
-                                rtp_add_sink( tr->sout_id, tr->rtp_fd,
-                                              false, &seq );
                             }
                         }
                         else
@@ -1057,7 +1349,7 @@ static int RtspHandler( rtsp_stream_t *rtsp, rtsp_stream_id_t *id,
 
             if (ses != NULL)
             {
-                if (vod)
+                if (vod && !b_shared)
                 {
                     vod_play(rtsp->vod_media, psz_session, &start, end);
                     npt = start;
@@ -1084,6 +1376,7 @@ static int RtspHandler( rtsp_stream_t *rtsp, rtsp_stream_id_t *id,
             }
 
             rtsp_session_t *ses;
+            int64_t npt = 0;
             answer->i_status = 200;
             psz_session = httpd_MsgGet( query, "Session" );
             vlc_mutex_lock( &rtsp->lock );
@@ -1113,6 +1406,16 @@ static int RtspHandler( rtsp_stream_t *rtsp, rtsp_stream_id_t *id,
                     if (!found)
                         answer->i_status = 455;
                 }
+                else if (rtsp->share_window > 0)
+                {
+                    /* Leave the feed, and resume from here later */
+                    if (ses->feed != NULL)
+                    {
+                        ses->npt = RtspFeedNPT(ses->feed);
+                        RtspFeedLeave(rtsp, ses);
+                    }
+                    npt = ses->npt;
+                }
                 RtspClientAlive(ses);
             }
             vlc_mutex_unlock( &rtsp->lock );
@@ -1120,8 +1423,8 @@ static int RtspHandler( rtsp_stream_t *rtsp, rtsp_stream_id_t *id,
             if (ses != NULL && id == NULL)
             {
                 assert(vod);
-                int64_t npt = 0;
-                vod_pause(rtsp->vod_media, psz_session, &npt);
+                if (rtsp->share_window <= 0)
+                    vod_pause(rtsp->vod_media, psz_session, &npt);
                 double f_npt = (double) npt / CLOCK_FREQ;
                 httpd_MsgAdd( answer, "Range", "npt=%f-", f_npt );
             }
@@ -0,0 +1,150 @@
+/*****************************************************************************
+ * tap.c: stream output to the libvlc packet callbacks
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * This module hands the elementary streams over to the packet callbacks of
+ * the libvlc media player, without copying them. Unlike smem, the callbacks
+ * are passed as address variables, and the blocks themselves are given
+ * away: the callback owns them.
+ *
+ *   sout-tap-add:  void *(*)( void *data, const es_format_t * )
+ *                  returns the handle of the ES, or NULL to drop it
+ *   sout-tap-send: void (*)( void *data, void *es, block_t * )
+ *                  receives one block, and must release it
+ *   sout-tap-del:  void (*)( void *data, void *es )
+ */
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_block.h>
+#include <vlc_sout.h>
+
+/*****************************************************************************
+ * Module descriptor
+ *****************************************************************************/
+static int  Open ( vlc_object_t * );
+static void Close( vlc_object_t * );
+
+vlc_module_begin ()
+    set_shortname( N_("Tap") )
+    set_description( N_("Stream output to the libvlc packet callbacks") )
+    set_capability( "sout stream", 0 )
+    add_shortcut( "tap" )
+    set_category( CAT_SOUT )
+    set_subcategory( SUBCAT_SOUT_STREAM )
+    set_callbacks( Open, Close )
+vlc_module_end ()
+
+/*****************************************************************************
+ * Local prototypes
+ *****************************************************************************/
+typedef void *(*tap_add_cb)( void *, const es_format_t * );
+typedef void (*tap_send_cb)( void *, void *, block_t * );
+typedef void (*tap_del_cb)( void *, void * );
+
+struct sout_stream_id_t
+{
+    void        *opaque;
+    void        *es;
+    tap_send_cb  send;
+    tap_del_cb   del;
+};
+
+static sout_stream_id_t *Add ( sout_stream_t *, es_format_t * );
+static int               Del ( sout_stream_t *, sout_stream_id_t * );
+static int               Send( sout_stream_t *, sout_stream_id_t *, block_t * );
+
+static int Open( vlc_object_t *p_this )
+{
+    sout_stream_t *p_stream = (sout_stream_t *)p_this;
+
+    if( var_InheritAddress( p_stream, "sout-tap-send" ) == NULL )
+    {
+        msg_Err( p_stream, "no packet callback" );
+        return VLC_EGENERIC;
+    }
+
+    p_stream->pf_add  = Add;
+    p_stream->pf_del  = Del;
+    p_stream->pf_send = Send;
+    p_stream->p_sys   = NULL;
+    return VLC_SUCCESS;
+}
+
+static void Close( vlc_object_t *p_this )
+{
+    (void)p_this;
+}
+
+static sout_stream_id_t *Add( sout_stream_t *p_stream, es_format_t *p_fmt )
+{
+    /* The stream output may be reused by the next input: the callbacks are
+     * read for every ES, so that the ES follow the current ones. */
+    tap_add_cb add = var_InheritAddress( p_stream, "sout-tap-add" );
+    sout_stream_id_t *id = malloc( sizeof( *id ) );
+    if( unlikely(id == NULL) )
+        return NULL;
+
+    id->opaque = var_InheritAddress( p_stream, "sout-tap-data" );
+    id->send = var_InheritAddress( p_stream, "sout-tap-send" );
+    id->del = var_InheritAddress( p_stream, "sout-tap-del" );
+    id->es = (add != NULL) ? add( id->opaque, p_fmt ) : NULL;
+
+    if( id->send == NULL || (add != NULL && id->es == NULL) )
+    {
+        msg_Dbg( p_stream, "dropping ES %d (%4.4s)", p_fmt->i_id,
+                 (const char *)&p_fmt->i_codec );
+        free( id );
+        return NULL;
+    }
+    return id;
+}
+
+static int Del( sout_stream_t *p_stream, sout_stream_id_t *id )
+{
+    VLC_UNUSED(p_stream);
+    if( id->del != NULL )
+        id->del( id->opaque, id->es );
+    free( id );
+    return VLC_SUCCESS;
+}
+
+static int Send( sout_stream_t *p_stream, sout_stream_id_t *id,
+                 block_t *p_buffer )
+{
+    VLC_UNUSED(p_stream);
+    while( p_buffer != NULL )
+    {
+        block_t *p_next = p_buffer->p_next;
+
+        p_buffer->p_next = NULL;
+        id->send( id->opaque, id->es, p_buffer );
+        p_buffer = p_next;
+    }
+    return VLC_SUCCESS;
+}
@@ -88,6 +88,60 @@ static aout_buffer_t *audio_new_buffer( decoder_t *p_dec, int i_samples )
     return p_block;
 }
 
+static block_t *transcode_audio_filter( sout_stream_id_t *id,
+                                        block_t *p_audio_buf )
+{
+    /* Run filter chain */
+    if( id->p_uf_chain )
+    {
+        p_audio_buf = filter_chain_AudioFilter( id->p_uf_chain,
+                                                p_audio_buf );
+        if( !p_audio_buf )
+            abort();
+    }
+
+    p_audio_buf = filter_chain_AudioFilter( id->p_f_chain, p_audio_buf );
+    if( !p_audio_buf )
+        abort();
+
+    p_audio_buf->i_dts = p_audio_buf->i_pts;
+    return p_audio_buf;
+}
+
+static block_t *transcode_audio_encode( encoder_t *p_enc,
+                                        block_t *p_audio_buf )
+{
+    block_t *p_block;
+
+    audio_timer_start( p_enc );
+    p_block = p_enc->pf_encode_audio( p_enc, p_audio_buf );
+    audio_timer_stop( p_enc );
+    block_Release( p_audio_buf );
+    return p_block;
+}
+
+/* Pipeline stages */
+static void transcode_audio_filter_run( void *opaque, void *item )
+{
+    sout_stream_id_t *id = opaque;
+
+    transcode_stage_Push( id->p_encoder_stage,
+                          transcode_audio_filter( id, item ) );
+}
+
+static void transcode_audio_encode_run( void *opaque, void *item )
+{
+    sout_stream_id_t *id = opaque;
+
+    transcode_pipeline_Output( id,
+                               transcode_audio_encode( id->p_encoder, item ) );
+}
+
+static void transcode_audio_drop( void *item )
+{
+    block_Release( item );
+}
+
 static int transcode_audio_filter_allocation_init( filter_t *p_filter,
                                                    void *data )
 {
@@ -306,11 +360,23 @@ int transcode_audio_new( sout_stream_t *p_stream,
     id->p_encoder->fmt_out.i_codec =
         vlc_fourcc_GetCodec( AUDIO_ES, id->p_encoder->fmt_out.i_codec );
 
+    if( p_sys->i_threads >= 1
+     && transcode_pipeline_New( p_stream, id, transcode_audio_filter_run,
+                                transcode_audio_encode_run,
+                                transcode_audio_drop, AUDIO_QUEUE_SIZE,
+                                VLC_THREAD_PRIORITY_AUDIO ) )
+    {
+        transcode_audio_close( id );
+        return VLC_EGENERIC;
+    }
+
     return VLC_SUCCESS;
 }
 
 void transcode_audio_close( sout_stream_id_t *id )
 {
+    transcode_pipeline_Delete( id );
+
     audio_timer_close( id->p_encoder );
 
     /* Close decoder */
@@ -339,9 +405,19 @@ int transcode_audio_process( sout_stream_t *p_stream,
                                     block_t *in, block_t **out )
 {
     sout_stream_sys_t *p_sys = p_stream->p_sys;
-    block_t *p_block, *p_audio_buf;
+    block_t *p_audio_buf;
     *out = NULL;
 
+    if( unlikely( in == NULL ) )
+    {
+        if( p_sys->i_threads >= 1 )
+        {
+            transcode_pipeline_Drain( id );
+            *out = transcode_pipeline_GetOutput( id );
+        }
+        return VLC_SUCCESS;
+    }
+
     while( (p_audio_buf = id->p_decoder->pf_decode_audio( id->p_decoder,
                                                           &in )) )
     {
@@ -362,29 +438,20 @@ int transcode_audio_process( sout_stream_t *p_stream,
 
         p_audio_buf->i_dts = p_audio_buf->i_pts;
 
-        /* Run filter chain */
-        if( id->p_uf_chain )
+        if( p_sys->i_threads >= 1 )
         {
-            p_audio_buf = filter_chain_AudioFilter( id->p_uf_chain,
-                                                    p_audio_buf );
-            if( !p_audio_buf )
-                abort();
+            transcode_stage_Push( id->p_filter_stage, p_audio_buf );
+            continue;
         }
 
-        p_audio_buf = filter_chain_AudioFilter( id->p_f_chain, p_audio_buf );
-        if( !p_audio_buf )
-            abort();
-
-        p_audio_buf->i_dts = p_audio_buf->i_pts;
-
-        audio_timer_start( id->p_encoder );
-        p_block = id->p_encoder->pf_encode_audio( id->p_encoder, p_audio_buf );
-        audio_timer_stop( id->p_encoder );
-
-        block_ChainAppend( out, p_block );
-        block_Release( p_audio_buf );
+        p_audio_buf = transcode_audio_filter( id, p_audio_buf );
+        block_ChainAppend( out, transcode_audio_encode( id->p_encoder,
+                                                        p_audio_buf ) );
     }
 
+    if( p_sys->i_threads >= 1 )
+        *out = transcode_pipeline_GetOutput( id );
+
     return VLC_SUCCESS;
 }
 
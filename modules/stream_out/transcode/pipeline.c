@@ -0,0 +1,256 @@
+/*****************************************************************************
+ * pipeline.c: transcoding stream output module (pipelined stages)
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+
+#include "transcode.h"
+
+#include <assert.h>
+
+struct transcode_stage_t
+{
+    vlc_thread_t thread;
+    vlc_mutex_t  lock;
+    vlc_cond_t   wait;  /* signaled on every change of the state below */
+
+    void       **pp_items;
+    unsigned     i_depth;
+    unsigned     i_first;
+    unsigned     i_count;
+    bool         b_busy;
+    bool         b_abort;
+
+    void       (*pf_run)( void *, void * );
+    void       (*pf_drop)( void * );
+    void        *p_opaque;
+};
+
+static void *StageThread( void *data )
+{
+    transcode_stage_t *p_stage = data;
+    int canc = vlc_savecancel();
+
+    vlc_mutex_lock( &p_stage->lock );
+    for( ;; )
+    {
+        while( !p_stage->b_abort && p_stage->i_count == 0 )
+            vlc_cond_wait( &p_stage->wait, &p_stage->lock );
+        if( p_stage->b_abort )
+            break;
+
+        void *p_item = p_stage->pp_items[p_stage->i_first];
+        p_stage->i_first = (p_stage->i_first + 1) % p_stage->i_depth;
+        p_stage->i_count--;
+        p_stage->b_busy = true;
+        vlc_cond_broadcast( &p_stage->wait );
+        vlc_mutex_unlock( &p_stage->lock );
+
+        p_stage->pf_run( p_stage->p_opaque, p_item );
+
+        vlc_mutex_lock( &p_stage->lock );
+        p_stage->b_busy = false;
+        vlc_cond_broadcast( &p_stage->wait );
+    }
+    vlc_mutex_unlock( &p_stage->lock );
+
+    vlc_restorecancel( canc );
+    return NULL;
+}
+
+/**
+ * Creates a stage: a thread running pf_run() on each pushed item, in order.
+ * @param i_depth number of items that can wait before Push() blocks
+ * @param pf_drop releases the items left over when the stage is deleted
+ */
+transcode_stage_t *transcode_stage_New( vlc_object_t *p_obj,
+                                        void (*pf_run)( void *, void * ),
+                                        void (*pf_drop)( void * ),
+                                        void *p_opaque, unsigned i_depth,
+                                        int i_priority )
+{
+    transcode_stage_t *p_stage = malloc( sizeof(*p_stage) );
+    if( !p_stage )
+        return NULL;
+
+    assert( i_depth > 0 );
+    p_stage->pp_items = malloc( i_depth * sizeof(*p_stage->pp_items) );
+    if( !p_stage->pp_items )
+    {
+        free( p_stage );
+        return NULL;
+    }
+    p_stage->i_depth = i_depth;
+    p_stage->i_first = 0;
+    p_stage->i_count = 0;
+    p_stage->b_busy = false;
+    p_stage->b_abort = false;
+    p_stage->pf_run = pf_run;
+    p_stage->pf_drop = pf_drop;
+    p_stage->p_opaque = p_opaque;
+    vlc_mutex_init( &p_stage->lock );
+    vlc_cond_init( &p_stage->wait );
+
+    if( vlc_clone( &p_stage->thread, StageThread, p_stage, i_priority ) )
+    {
+        msg_Err( p_obj, "cannot spawn transcoding thread" );
+        vlc_cond_destroy( &p_stage->wait );
+        vlc_mutex_destroy( &p_stage->lock );
+        free( p_stage->pp_items );
+        free( p_stage );
+        return NULL;
+    }
+    return p_stage;
+}
+
+/**
+ * Stops the stage thread. Items not processed yet are dropped.
+ */
+void transcode_stage_Delete( transcode_stage_t *p_stage )
+{
+    vlc_mutex_lock( &p_stage->lock );
+    p_stage->b_abort = true;
+    vlc_cond_broadcast( &p_stage->wait );
+    vlc_mutex_unlock( &p_stage->lock );
+    vlc_join( p_stage->thread, NULL );
+
+    for( ; p_stage->i_count > 0; p_stage->i_count-- )
+    {
+        p_stage->pf_drop( p_stage->pp_items[p_stage->i_first] );
+        p_stage->i_first = (p_stage->i_first + 1) % p_stage->i_depth;
+    }
+    vlc_cond_destroy( &p_stage->wait );
+    vlc_mutex_destroy( &p_stage->lock );
+    free( p_stage->pp_items );
+    free( p_stage );
+}
+
+/**
+ * Queues an item, waiting for room if the stage is behind.
+ */
+void transcode_stage_Push( transcode_stage_t *p_stage, void *p_item )
+{
+    vlc_mutex_lock( &p_stage->lock );
+    while( p_stage->i_count == p_stage->i_depth )
+        vlc_cond_wait( &p_stage->wait, &p_stage->lock );
+
+    p_stage->pp_items[(p_stage->i_first + p_stage->i_count)
+                      % p_stage->i_depth] = p_item;
+    p_stage->i_count++;
+    vlc_cond_broadcast( &p_stage->wait );
+    vlc_mutex_unlock( &p_stage->lock );
+}
+
+/**
+ * Waits until every queued item has been processed.
+ */
+void transcode_stage_Drain( transcode_stage_t *p_stage )
+{
+    vlc_mutex_lock( &p_stage->lock );
+    while( p_stage->i_count > 0 || p_stage->b_busy )
+        vlc_cond_wait( &p_stage->wait, &p_stage->lock );
+    vlc_mutex_unlock( &p_stage->lock );
+}
+
+/**
+ * Starts the filter and encoder stages of a transcoded stream.
+ * pf_filter runs on the filter stage and should pass its output on to
+ * id->p_encoder_stage; pf_encode runs on the encoder stage and should hand
+ * its blocks to transcode_pipeline_Output().
+ */
+int transcode_pipeline_New( sout_stream_t *p_stream, sout_stream_id_t *id,
+                            void (*pf_filter)( void *, void * ),
+                            void (*pf_encode)( void *, void * ),
+                            void (*pf_drop)( void * ),
+                            unsigned i_depth, int i_priority )
+{
+    int i_enc_priority = p_stream->p_sys->b_high_priority
+                       ? VLC_THREAD_PRIORITY_OUTPUT : i_priority;
+
+    id->p_stream = p_stream;
+    id->p_buffers = NULL;
+    vlc_mutex_init( &id->lock_out );
+
+    id->p_encoder_stage = transcode_stage_New( VLC_OBJECT(p_stream),
+                                               pf_encode, pf_drop, id,
+                                               i_depth, i_enc_priority );
+    if( !id->p_encoder_stage )
+        goto error;
+    id->p_filter_stage = transcode_stage_New( VLC_OBJECT(p_stream),
+                                              pf_filter, pf_drop, id,
+                                              i_depth, i_priority );
+    if( !id->p_filter_stage )
+    {
+        transcode_stage_Delete( id->p_encoder_stage );
+        id->p_encoder_stage = NULL;
+        goto error;
+    }
+    return VLC_SUCCESS;
+
+error:
+    vlc_mutex_destroy( &id->lock_out );
+    return VLC_EGENERIC;
+}
+
+void transcode_pipeline_Delete( sout_stream_id_t *id )
+{
+    if( !id->p_filter_stage )
+        return;
+
+    /* The filter stage feeds the encoder stage: stop it first */
+    transcode_stage_Delete( id->p_filter_stage );
+    transcode_stage_Delete( id->p_encoder_stage );
+    id->p_filter_stage = id->p_encoder_stage = NULL;
+
+    block_ChainRelease( id->p_buffers );
+    id->p_buffers = NULL;
+    vlc_mutex_destroy( &id->lock_out );
+}
+
+/**
+ * Waits until everything queued so far has been encoded.
+ */
+void transcode_pipeline_Drain( sout_stream_id_t *id )
+{
+    transcode_stage_Drain( id->p_filter_stage );
+    transcode_stage_Drain( id->p_encoder_stage );
+}
+
+void transcode_pipeline_Output( sout_stream_id_t *id, block_t *p_block )
+{
+    vlc_mutex_lock( &id->lock_out );
+    block_ChainAppend( &id->p_buffers, p_block );
+    vlc_mutex_unlock( &id->lock_out );
+}
+
+/**
+ * Takes the blocks encoded so far.
+ */
+block_t *transcode_pipeline_GetOutput( sout_stream_id_t *id )
+{
+    block_t *p_out;
+
+    vlc_mutex_lock( &id->lock_out );
+    p_out = id->p_buffers;
+    id->p_buffers = NULL;
+    vlc_mutex_unlock( &id->lock_out );
+    return p_out;
+}
@@ -75,6 +75,13 @@
 #define MAXHEIGHT_TEXT N_("Maximum video height")
 #define MAXHEIGHT_LONGTEXT N_( \
     "Maximum output video height." )
+#define RENDITIONS_TEXT N_("Additional renditions")
+#define RENDITIONS_LONGTEXT N_( \
+    "Comma-separated list of extra video renditions, as " \
+    "WIDTHxHEIGHT@KBPS. They are encoded with the same codec from the same " \
+    "decoded and deinterlaced pictures, and output as additional video " \
+    "elementary streams, with the identifier of the source stream plus " \
+    "1000 for the first one, 2000 for the second one and so on." )
 #define VFILTER_TEXT N_("Video filter")
 #define VFILTER_LONGTEXT N_( \
     "Video filters will be applied to the video streams (after overlays " \
@@ -125,11 +132,13 @@
 
 #define THREADS_TEXT N_("Number of threads")
 #define THREADS_LONGTEXT N_( \
-    "Number of threads used for the transcoding." )
+    "Number of threads used for the transcoding. When not zero, the " \
+    "filters and the encoder of each transcoded stream also run in " \
+    "threads of their own, in parallel with decoding." )
 #define HP_TEXT N_("High priority")
 #define HP_LONGTEXT N_( \
-    "Runs the optional encoder thread at the OUTPUT priority instead of " \
-    "VIDEO." )
+    "Runs the optional encoder threads at the OUTPUT priority instead of " \
+    "VIDEO or AUDIO." )
 
 #define ASYNC_TEXT N_("Synchronise on audio track")
 #define ASYNC_LONGTEXT N_( \
@@ -185,6 +194,8 @@ vlc_module_begin ()
                  MAXWIDTH_LONGTEXT, true )
     add_integer( SOUT_CFG_PREFIX "maxheight", 0, MAXHEIGHT_TEXT,
                  MAXHEIGHT_LONGTEXT, true )
+    add_string( SOUT_CFG_PREFIX "renditions", NULL, RENDITIONS_TEXT,
+                RENDITIONS_LONGTEXT, true )
     add_module_list( SOUT_CFG_PREFIX "vfilter", "video filter2",
                      NULL, VFILTER_TEXT, VFILTER_LONGTEXT, false )
 
@@ -234,7 +245,7 @@ static const char *const ppsz_sout_options[] = {
     "deinterlace-module", "threads", "hurry-up", "aenc", "acodec", "ab", "alang",
     "afilter", "samplerate", "channels", "senc", "scodec", "soverlay",
     "sfilter", "osd", "audio-sync", "high-priority", "maxwidth", "maxheight",
-    NULL
+    "renditions", NULL
 };
 
 /*****************************************************************************
@@ -358,6 +369,39 @@ static int Open( vlc_object_t *p_this )
 
     p_sys->i_maxheight = var_GetInteger( p_stream, SOUT_CFG_PREFIX "maxheight" );
 
+    p_sys->p_renditions = NULL;
+    p_sys->i_renditions = 0;
+    psz_string = var_GetString( p_stream, SOUT_CFG_PREFIX "renditions" );
+    if( psz_string )
+    {
+        char *psz_save;
+
+        for( char *psz_tok = strtok_r( psz_string, ",", &psz_save );
+             psz_tok != NULL; psz_tok = strtok_r( NULL, ",", &psz_save ) )
+        {
+            transcode_rendition_cfg_t *p_cfg;
+            unsigned i_width, i_height, i_kbps;
+
+            if( sscanf( psz_tok, "%ux%u@%u", &i_width, &i_height,
+                        &i_kbps ) != 3 || i_width < 2 || i_height < 2 )
+            {
+                msg_Warn( p_stream, "invalid rendition `%s'", psz_tok );
+                continue;
+            }
+
+            p_cfg = realloc( p_sys->p_renditions,
+                             (p_sys->i_renditions + 1) * sizeof(*p_cfg) );
+            if( !p_cfg )
+                break;
+            p_sys->p_renditions = p_cfg;
+            p_cfg += p_sys->i_renditions++;
+            p_cfg->i_width = i_width & ~1;
+            p_cfg->i_height = i_height & ~1;
+            p_cfg->i_bitrate = i_kbps * 1000;
+        }
+    }
+    free( psz_string );
+
     psz_string = var_GetString( p_stream, SOUT_CFG_PREFIX "vfilter" );
     if( psz_string && *psz_string )
         p_sys->psz_vf2 = strdup(psz_string );
@@ -392,7 +436,6 @@ static int Open( vlc_object_t *p_this )
 
     /* Subpictures transcoding parameters */
     p_sys->p_spu = NULL;
-    p_sys->p_spu_blend = NULL;
     p_sys->psz_senc = NULL;
     p_sys->p_spu_cfg = NULL;
     p_sys->i_scodec = 0;
@@ -489,6 +532,7 @@ static void Close( vlc_object_t * p_this )
     free( p_sys->psz_alang );
 
     free( p_sys->psz_vf2 );
+    free( p_sys->p_renditions );
 
     config_ChainDestroy( p_sys->p_video_cfg );
     free( p_sys->psz_venc );
@@ -500,7 +544,6 @@ static void Close( vlc_object_t * p_this )
     free( p_sys->psz_senc );
 
     if( p_sys->p_spu ) spu_Destroy( p_sys->p_spu );
-    if( p_sys->p_spu_blend ) filter_DeleteBlend( p_sys->p_spu_blend );
 
     config_ChainDestroy( p_sys->p_osd_cfg );
     free( p_sys->psz_osdenc );
@@ -601,6 +644,7 @@ static int Del( sout_stream_t *p_stream, sout_stream_id_t *id )
         switch( id->p_decoder->fmt_in.i_cat )
         {
         case AUDIO_ES:
+            Send( p_stream, id, NULL );
             transcode_audio_close( id );
             break;
         case VIDEO_ES:
@@ -10,22 +10,37 @@
 #include <vlc_codec.h>
 
 
-#define PICTURE_RING_SIZE 64
+/* Items waiting between two pipeline stages */
+#define PICTURE_QUEUE_SIZE 8
+#define AUDIO_QUEUE_SIZE 32
 #define SUBPICTURE_RING_SIZE 20
 
 #define MASTER_SYNC_MAX_DRIFT 100000
 
-struct sout_stream_sys_t
+typedef struct transcode_stage_t transcode_stage_t;
+
+/* Extra video rendition, as configured */
+typedef struct
+{
+    unsigned        i_width;
+    unsigned        i_height;
+    int             i_bitrate;
+} transcode_rendition_cfg_t;
+
+/* Extra video rendition, encoded from the pictures of a transcoded stream */
+typedef struct
 {
-    sout_stream_id_t *id_video;
-    block_t         *p_buffers;
-    vlc_mutex_t     lock_out;
-    vlc_cond_t      cond;
-    bool            b_abort;
-    picture_t *     pp_pics[PICTURE_RING_SIZE];
-    int             i_first_pic, i_last_pic;
-    vlc_thread_t    thread;
+    encoder_t         *p_encoder;
+    filter_chain_t    *p_f_chain; /* scaling and chroma conversion */
+    void              *id;        /* id of the out stream */
+    transcode_stage_t *p_stage;   /* when threads are enabled */
+
+    vlc_mutex_t       lock_out;
+    block_t           *p_buffers; /* encoded, not sent yet */
+} transcode_rendition_t;
 
+struct sout_stream_sys_t
+{
     /* Audio */
     vlc_fourcc_t    i_acodec;   /* codec audio (0 if not transcode) */
     char            *psz_aenc;
@@ -55,13 +70,15 @@ struct sout_stream_sys_t
 
     char            *psz_vf2;
 
+    transcode_rendition_cfg_t *p_renditions;
+    unsigned        i_renditions;
+
     /* SPU */
     vlc_fourcc_t    i_scodec;   /* codec spu (0 if not transcode) */
     char            *psz_senc;
     bool            b_soverlay;
     config_chain_t  *p_spu_cfg;
     spu_t           *p_spu;
-    filter_t        *p_spu_blend;
 
     /* OSD Menu */
     vlc_fourcc_t    i_osdcodec; /* codec osd menu (0 if not transcode) */
@@ -85,17 +102,51 @@ struct sout_stream_id_t
     decoder_t       *p_decoder;
 
     /* Filters */
+    filter_chain_t  *p_di_chain; /* deinterlacing, shared by renditions */
     filter_chain_t  *p_f_chain;
     /* User specified filters */
     filter_chain_t  *p_uf_chain;
+    /* Subpicture overlay */
+    filter_t        *p_spu_blend;
 
     /* Encoder */
     encoder_t       *p_encoder;
 
     /* Sync */
     date_t          interpolated_pts;
+
+    /* Extra video renditions */
+    transcode_rendition_t *p_renditions;
+    unsigned          i_renditions;
+
+    /* Pipeline, when threads are enabled: the decoder runs on the calling
+     * thread, then filters and encoder each run in their own stage */
+    sout_stream_t     *p_stream;
+    transcode_stage_t *p_filter_stage;
+    transcode_stage_t *p_encoder_stage;
+    vlc_mutex_t       lock_out;
+    block_t           *p_buffers; /* encoded, not sent yet */
 };
 
+/* PIPELINE */
+
+transcode_stage_t *transcode_stage_New( vlc_object_t *,
+                                        void (*)( void *, void * ),
+                                        void (*)( void * ), void *,
+                                        unsigned, int );
+void transcode_stage_Delete( transcode_stage_t * );
+void transcode_stage_Push  ( transcode_stage_t *, void * );
+void transcode_stage_Drain ( transcode_stage_t * );
+
+int  transcode_pipeline_New      ( sout_stream_t *, sout_stream_id_t *,
+                                   void (*)( void *, void * ),
+                                   void (*)( void *, void * ),
+                                   void (*)( void * ), unsigned, int );
+void transcode_pipeline_Delete   ( sout_stream_id_t * );
+void transcode_pipeline_Drain    ( sout_stream_id_t * );
+void transcode_pipeline_Output   ( sout_stream_id_t *, block_t * );
+block_t *transcode_pipeline_GetOutput( sout_stream_id_t * );
+
 /* OSD */
 
 int transcode_osd_new( sout_stream_t *p_stream, sout_stream_id_t *id );
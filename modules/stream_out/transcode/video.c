@@ -79,23 +79,6 @@ static void video_unlink_picture_decoder( decoder_t *p_dec, picture_t *p_pic )
 
 static picture_t *video_new_buffer_decoder( decoder_t *p_dec )
 {
-    sout_stream_sys_t *p_ssys = p_dec->p_owner->p_sys;
-    if( p_ssys->i_threads >= 1 )
-    {
-        int i_first_pic = p_ssys->i_first_pic;
-
-        if( p_ssys->i_first_pic != p_ssys->i_last_pic )
-        {
-            /* Encoder still has stuff to encode, wait to clear-up the list */
-            while( p_ssys->i_first_pic == i_first_pic )
-            {
-#warning THERE IS DEFINITELY A BUG! LOCKING IS INSUFFICIENT!
-                msleep( 10000 );
-                barrier ();
-            }
-        }
-    }
-
     p_dec->fmt_out.video.i_chroma = p_dec->fmt_out.i_codec;
     return picture_NewFromFormat( &p_dec->fmt_out.video );
 }
@@ -125,52 +108,200 @@ static void transcode_video_filter_allocation_clear( filter_t *p_filter )
     VLC_UNUSED(p_filter);
 }
 
-static void* EncoderThread( void *obj )
+static block_t *transcode_video_encode( encoder_t *p_enc, picture_t *p_pic )
 {
-    sout_stream_sys_t *p_sys = (sout_stream_sys_t*)obj;
-    sout_stream_id_t *id = p_sys->id_video;
-    picture_t *p_pic;
-    int canc = vlc_savecancel ();
+    block_t *p_block;
+
+    video_timer_start( p_enc );
+    p_block = p_enc->pf_encode_video( p_enc, p_pic );
+    video_timer_stop( p_enc );
+    return p_block;
+}
+
+static void transcode_video_drop( void *item )
+{
+    picture_Release( item );
+}
+
+/*
+ * Extra renditions
+ */
+static void transcode_rendition_run( void *opaque, void *item )
+{
+    transcode_rendition_t *p_rend = opaque;
+    picture_t *p_pic = item;
+    block_t *p_block;
+
+    if( p_rend->p_f_chain )
+        p_pic = filter_chain_VideoFilter( p_rend->p_f_chain, p_pic );
+    if( !p_pic )
+        return;
+
+    p_block = transcode_video_encode( p_rend->p_encoder, p_pic );
+    picture_Release( p_pic );
+
+    vlc_mutex_lock( &p_rend->lock_out );
+    block_ChainAppend( &p_rend->p_buffers, p_block );
+    vlc_mutex_unlock( &p_rend->lock_out );
+}
 
-    for( ;; )
+static void transcode_video_renditions_feed( sout_stream_id_t *id,
+                                             picture_t *p_pic )
+{
+    for( unsigned i = 0; i < id->i_renditions; i++ )
     {
-        block_t *p_block;
+        transcode_rendition_t *p_rend = &id->p_renditions[i];
 
-        vlc_mutex_lock( &p_sys->lock_out );
-        while( !p_sys->b_abort && p_sys->i_last_pic == p_sys->i_first_pic )
-            vlc_cond_wait( &p_sys->cond, &p_sys->lock_out );
+        picture_Hold( p_pic );
+        if( p_rend->p_stage )
+            transcode_stage_Push( p_rend->p_stage, p_pic );
+        else
+            transcode_rendition_run( p_rend, p_pic );
+    }
+}
 
-        if( p_sys->b_abort )
-        {
-            vlc_mutex_unlock( &p_sys->lock_out );
-            break;
-        }
+static void transcode_video_renditions_send( sout_stream_t *p_stream,
+                                             sout_stream_id_t *id )
+{
+    for( unsigned i = 0; i < id->i_renditions; i++ )
+    {
+        transcode_rendition_t *p_rend = &id->p_renditions[i];
+        block_t *p_out;
 
-        p_pic = p_sys->pp_pics[p_sys->i_first_pic++];
-        p_sys->i_first_pic %= PICTURE_RING_SIZE;
-        vlc_mutex_unlock( &p_sys->lock_out );
+        vlc_mutex_lock( &p_rend->lock_out );
+        p_out = p_rend->p_buffers;
+        p_rend->p_buffers = NULL;
+        vlc_mutex_unlock( &p_rend->lock_out );
 
-        video_timer_start( id->p_encoder );
-        p_block = id->p_encoder->pf_encode_video( id->p_encoder, p_pic );
-        video_timer_stop( id->p_encoder );
+        if( p_out )
+            sout_StreamIdSend( p_stream->p_next, p_rend->id, p_out );
+    }
+}
 
-        vlc_mutex_lock( &p_sys->lock_out );
-        block_ChainAppend( &p_sys->p_buffers, p_block );
+static void transcode_video_renditions_flush( sout_stream_t *p_stream,
+                                              sout_stream_id_t *id )
+{
+    for( unsigned i = 0; i < id->i_renditions; i++ )
+    {
+        transcode_rendition_t *p_rend = &id->p_renditions[i];
+        block_t *p_block;
 
-        vlc_mutex_unlock( &p_sys->lock_out );
-        picture_Release( p_pic );
+        if( p_rend->p_stage )
+            transcode_stage_Drain( p_rend->p_stage );
+        do {
+            p_block = transcode_video_encode( p_rend->p_encoder, NULL );
+            block_ChainAppend( &p_rend->p_buffers, p_block );
+        } while( p_block );
     }
+    transcode_video_renditions_send( p_stream, id );
+}
 
-    while( p_sys->i_last_pic != p_sys->i_first_pic )
+static void transcode_video_renditions_close( sout_stream_t *p_stream,
+                                              sout_stream_id_t *id )
+{
+    for( unsigned i = 0; i < id->i_renditions; i++ )
     {
-        p_pic = p_sys->pp_pics[p_sys->i_first_pic++];
-        p_sys->i_first_pic %= PICTURE_RING_SIZE;
-        picture_Release( p_pic );
+        transcode_rendition_t *p_rend = &id->p_renditions[i];
+
+        if( p_rend->p_stage )
+            transcode_stage_Delete( p_rend->p_stage );
+        block_ChainRelease( p_rend->p_buffers );
+        vlc_mutex_destroy( &p_rend->lock_out );
+        if( p_rend->p_f_chain )
+            filter_chain_Delete( p_rend->p_f_chain );
+
+        video_timer_close( p_rend->p_encoder );
+        module_unneed( p_rend->p_encoder, p_rend->p_encoder->p_module );
+        sout_StreamIdDel( p_stream->p_next, p_rend->id );
+        es_format_Clean( &p_rend->p_encoder->fmt_out );
+        vlc_object_release( p_rend->p_encoder );
+    }
+    free( id->p_renditions );
+    id->p_renditions = NULL;
+    id->i_renditions = 0;
+}
+
+static picture_t *transcode_video_filter( sout_stream_t *p_stream,
+                                          sout_stream_id_t *id,
+                                          picture_t *p_pic )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+
+    /* Run deinterlacing, shared with the other renditions */
+    if( id->p_di_chain )
+        p_pic = filter_chain_VideoFilter( id->p_di_chain, p_pic );
+    if( !p_pic )
+        return NULL;
+    transcode_video_renditions_feed( id, p_pic );
+
+    /* Run filter chain */
+    if( id->p_f_chain )
+        p_pic = filter_chain_VideoFilter( id->p_f_chain, p_pic );
+
+    /* Run user specified filter chain */
+    if( id->p_uf_chain && p_pic )
+        p_pic = filter_chain_VideoFilter( id->p_uf_chain, p_pic );
+
+    if( !p_pic )
+        return NULL;
+
+    /* Check if we have a subpicture to overlay */
+    if( p_sys->p_spu )
+    {
+        video_format_t fmt = id->p_encoder->fmt_in.video;
+        if( fmt.i_visible_width <= 0 || fmt.i_visible_height <= 0 )
+        {
+            fmt.i_visible_width  = fmt.i_width;
+            fmt.i_visible_height = fmt.i_height;
+            fmt.i_x_offset       = 0;
+            fmt.i_y_offset       = 0;
+        }
+
+        subpicture_t *p_subpic = spu_Render( p_sys->p_spu, NULL, &fmt, &fmt,
+                                             p_pic->date, p_pic->date, false );
+
+        /* Overlay subpicture */
+        if( p_subpic )
+        {
+            if( picture_IsReferenced( p_pic ) && !filter_chain_GetLength( id->p_f_chain ) )
+            {
+                /* We can't modify the picture, we need to duplicate it */
+                picture_t *p_tmp = picture_NewFromFormat( &p_pic->format );
+                if( likely( p_tmp ) )
+                {
+                    picture_Copy( p_tmp, p_pic );
+                    picture_Release( p_pic );
+                    p_pic = p_tmp;
+                }
+            }
+            if( unlikely( !id->p_spu_blend ) )
+                id->p_spu_blend = filter_NewBlend( VLC_OBJECT( p_sys->p_spu ), &fmt );
+            if( likely( id->p_spu_blend ) )
+                picture_BlendSubpicture( p_pic, id->p_spu_blend, p_subpic );
+            subpicture_Delete( p_subpic );
+        }
     }
-    block_ChainRelease( p_sys->p_buffers );
+    return p_pic;
+}
+
+/* Pipeline stages */
+static void transcode_video_filter_run( void *opaque, void *item )
+{
+    sout_stream_id_t *id = opaque;
+    picture_t *p_pic = transcode_video_filter( id->p_stream, id, item );
+
+    if( p_pic )
+        transcode_stage_Push( id->p_encoder_stage, p_pic );
+}
 
-    vlc_restorecancel (canc);
-    return NULL;
+static void transcode_video_encode_run( void *opaque, void *item )
+{
+    sout_stream_id_t *id = opaque;
+    picture_t *p_pic = item;
+
+    transcode_pipeline_Output( id,
+                               transcode_video_encode( id->p_encoder, p_pic ) );
+    picture_Release( p_pic );
 }
 
 int transcode_video_new( sout_stream_t *p_stream, sout_stream_id_t *id )
@@ -263,19 +394,11 @@ int transcode_video_new( sout_stream_t *p_stream, sout_stream_id_t *id )
 
     if( p_sys->i_threads >= 1 )
     {
-        int i_priority = p_sys->b_high_priority ? VLC_THREAD_PRIORITY_OUTPUT :
-                           VLC_THREAD_PRIORITY_VIDEO;
-        p_sys->id_video = id;
-        vlc_mutex_init( &p_sys->lock_out );
-        vlc_cond_init( &p_sys->cond );
-        memset( p_sys->pp_pics, 0, sizeof(p_sys->pp_pics) );
-        p_sys->i_first_pic = 0;
-        p_sys->i_last_pic = 0;
-        p_sys->p_buffers = NULL;
-        p_sys->b_abort = 0;
-        if( vlc_clone( &p_sys->thread, EncoderThread, p_sys, i_priority ) )
+        if( transcode_pipeline_New( p_stream, id, transcode_video_filter_run,
+                                    transcode_video_encode_run,
+                                    transcode_video_drop, PICTURE_QUEUE_SIZE,
+                                    VLC_THREAD_PRIORITY_VIDEO ) )
         {
-            msg_Err( p_stream, "cannot spawn encoder thread" );
             module_unneed( id->p_decoder, id->p_decoder->p_module );
             id->p_decoder->p_module = 0;
             free( id->p_decoder->p_owner );
@@ -289,20 +412,27 @@ static void transcode_video_filter_init( sout_stream_t *p_stream,
                                          sout_stream_id_t *id )
 {
 
+    /* Deinterlace, once for all the renditions */
+    if( p_stream->p_sys->b_deinterlace )
+    {
+        id->p_di_chain = filter_chain_New( p_stream, "video filter2",
+                                      false,
+                                      transcode_video_filter_allocation_init,
+                                      transcode_video_filter_allocation_clear,
+                                      p_stream->p_sys );
+        if( id->p_di_chain )
+            filter_chain_AppendFilter( id->p_di_chain,
+                                       p_stream->p_sys->psz_deinterlace,
+                                       p_stream->p_sys->p_deinterlace_cfg,
+                                       &id->p_decoder->fmt_out,
+                                       &id->p_decoder->fmt_out );
+    }
+
     id->p_f_chain = filter_chain_New( p_stream, "video filter2",
                                      false,
                                      transcode_video_filter_allocation_init,
                                      transcode_video_filter_allocation_clear,
                                      p_stream->p_sys );
-    /* Deinterlace */
-    if( p_stream->p_sys->b_deinterlace )
-    {
-       filter_chain_AppendFilter( id->p_f_chain,
-                                  p_stream->p_sys->psz_deinterlace,
-                                  p_stream->p_sys->p_deinterlace_cfg,
-                                  &id->p_decoder->fmt_out,
-                                  &id->p_decoder->fmt_out );
-    }
 
     /* Take care of the scaling and chroma conversions */
     if( ( id->p_decoder->fmt_out.video.i_chroma !=
@@ -344,7 +474,8 @@ static void transcode_video_filter_init( sout_stream_t *p_stream,
 }
 
 static void transcode_video_encoder_init( sout_stream_t *p_stream,
-                                          sout_stream_id_t *id )
+                                          sout_stream_id_t *id,
+                                          encoder_t *p_enc )
 {
     sout_stream_sys_t *p_sys = p_stream->p_sys;
 
@@ -374,8 +505,8 @@ static void transcode_video_encoder_init( sout_stream_t *p_stream,
     msg_Dbg( p_stream, "source pixel aspect is %f:1", f_aspect );
 
     /* Calculate scaling factor for specified parameters */
-    if( id->p_encoder->fmt_out.video.i_width <= 0 &&
-        id->p_encoder->fmt_out.video.i_height <= 0 && p_sys->f_scale )
+    if( p_enc->fmt_out.video.i_width <= 0 &&
+        p_enc->fmt_out.video.i_height <= 0 && p_sys->f_scale )
     {
         /* Global scaling. Make sure width will remain a factor of 16 */
         float f_real_scale;
@@ -394,26 +525,26 @@ static void transcode_video_encoder_init( sout_stream_t *p_stream,
         f_scale_width = f_real_scale;
         f_scale_height = (float) i_new_height / (float) i_src_height;
     }
-    else if( id->p_encoder->fmt_out.video.i_width > 0 &&
-             id->p_encoder->fmt_out.video.i_height <= 0 )
+    else if( p_enc->fmt_out.video.i_width > 0 &&
+             p_enc->fmt_out.video.i_height <= 0 )
     {
         /* Only width specified */
-        f_scale_width = (float)id->p_encoder->fmt_out.video.i_width/i_src_width;
+        f_scale_width = (float)p_enc->fmt_out.video.i_width/i_src_width;
         f_scale_height = f_scale_width;
     }
-    else if( id->p_encoder->fmt_out.video.i_width <= 0 &&
-             id->p_encoder->fmt_out.video.i_height > 0 )
+    else if( p_enc->fmt_out.video.i_width <= 0 &&
+             p_enc->fmt_out.video.i_height > 0 )
     {
          /* Only height specified */
-         f_scale_height = (float)id->p_encoder->fmt_out.video.i_height/i_src_height;
+         f_scale_height = (float)p_enc->fmt_out.video.i_height/i_src_height;
          f_scale_width = f_scale_height;
      }
-     else if( id->p_encoder->fmt_out.video.i_width > 0 &&
-              id->p_encoder->fmt_out.video.i_height > 0 )
+     else if( p_enc->fmt_out.video.i_width > 0 &&
+              p_enc->fmt_out.video.i_height > 0 )
      {
          /* Width and height specified */
-         f_scale_width = (float)id->p_encoder->fmt_out.video.i_width/i_src_width;
-         f_scale_height = (float)id->p_encoder->fmt_out.video.i_height/i_src_height;
+         f_scale_width = (float)p_enc->fmt_out.video.i_width/i_src_width;
+         f_scale_height = (float)p_enc->fmt_out.video.i_height/i_src_height;
      }
 
      /* check maxwidth and maxheight */
@@ -445,15 +576,15 @@ static void transcode_video_encoder_init( sout_stream_t *p_stream,
      f_aspect = f_aspect * i_dst_width / i_dst_height;
 
      /* Store calculated values */
-     id->p_encoder->fmt_out.video.i_width =
-     id->p_encoder->fmt_out.video.i_visible_width = i_dst_width;
-     id->p_encoder->fmt_out.video.i_height =
-     id->p_encoder->fmt_out.video.i_visible_height = i_dst_height;
+     p_enc->fmt_out.video.i_width =
+     p_enc->fmt_out.video.i_visible_width = i_dst_width;
+     p_enc->fmt_out.video.i_height =
+     p_enc->fmt_out.video.i_visible_height = i_dst_height;
 
-     id->p_encoder->fmt_in.video.i_width =
-     id->p_encoder->fmt_in.video.i_visible_width = i_dst_width;
-     id->p_encoder->fmt_in.video.i_height =
-     id->p_encoder->fmt_in.video.i_visible_height = i_dst_height;
+     p_enc->fmt_in.video.i_width =
+     p_enc->fmt_in.video.i_visible_width = i_dst_width;
+     p_enc->fmt_in.video.i_height =
+     p_enc->fmt_in.video.i_visible_height = i_dst_height;
 
      msg_Dbg( p_stream, "source %ix%i, destination %ix%i",
          i_src_width, i_src_height,
@@ -461,63 +592,59 @@ static void transcode_video_encoder_init( sout_stream_t *p_stream,
      );
 
     /* Handle frame rate conversion */
-    if( !id->p_encoder->fmt_out.video.i_frame_rate ||
-        !id->p_encoder->fmt_out.video.i_frame_rate_base )
+    if( !p_enc->fmt_out.video.i_frame_rate ||
+        !p_enc->fmt_out.video.i_frame_rate_base )
     {
         if( id->p_decoder->fmt_out.video.i_frame_rate &&
             id->p_decoder->fmt_out.video.i_frame_rate_base )
         {
-            id->p_encoder->fmt_out.video.i_frame_rate =
+            p_enc->fmt_out.video.i_frame_rate =
                 id->p_decoder->fmt_out.video.i_frame_rate;
-            id->p_encoder->fmt_out.video.i_frame_rate_base =
+            p_enc->fmt_out.video.i_frame_rate_base =
                 id->p_decoder->fmt_out.video.i_frame_rate_base;
         }
         else
         {
             /* Pick a sensible default value */
-            id->p_encoder->fmt_out.video.i_frame_rate = ENC_FRAMERATE;
-            id->p_encoder->fmt_out.video.i_frame_rate_base = ENC_FRAMERATE_BASE;
+            p_enc->fmt_out.video.i_frame_rate = ENC_FRAMERATE;
+            p_enc->fmt_out.video.i_frame_rate_base = ENC_FRAMERATE_BASE;
         }
     }
 
-    id->p_encoder->fmt_in.video.i_frame_rate =
-        id->p_encoder->fmt_out.video.i_frame_rate;
-    id->p_encoder->fmt_in.video.i_frame_rate_base =
-        id->p_encoder->fmt_out.video.i_frame_rate_base;
-
-    date_Init( &id->interpolated_pts,
-               id->p_encoder->fmt_out.video.i_frame_rate,
-               id->p_encoder->fmt_out.video.i_frame_rate_base );
+    p_enc->fmt_in.video.i_frame_rate =
+        p_enc->fmt_out.video.i_frame_rate;
+    p_enc->fmt_in.video.i_frame_rate_base =
+        p_enc->fmt_out.video.i_frame_rate_base;
 
     /* Check whether a particular aspect ratio was requested */
-    if( id->p_encoder->fmt_out.video.i_sar_num <= 0 ||
-        id->p_encoder->fmt_out.video.i_sar_den <= 0 )
+    if( p_enc->fmt_out.video.i_sar_num <= 0 ||
+        p_enc->fmt_out.video.i_sar_den <= 0 )
     {
-        vlc_ureduce( &id->p_encoder->fmt_out.video.i_sar_num,
-                     &id->p_encoder->fmt_out.video.i_sar_den,
+        vlc_ureduce( &p_enc->fmt_out.video.i_sar_num,
+                     &p_enc->fmt_out.video.i_sar_den,
                      (uint64_t)id->p_decoder->fmt_out.video.i_sar_num * i_src_width  * i_dst_height,
                      (uint64_t)id->p_decoder->fmt_out.video.i_sar_den * i_src_height * i_dst_width,
                      0 );
     }
     else
     {
-        vlc_ureduce( &id->p_encoder->fmt_out.video.i_sar_num,
-                     &id->p_encoder->fmt_out.video.i_sar_den,
-                     id->p_encoder->fmt_out.video.i_sar_num,
-                     id->p_encoder->fmt_out.video.i_sar_den,
+        vlc_ureduce( &p_enc->fmt_out.video.i_sar_num,
+                     &p_enc->fmt_out.video.i_sar_den,
+                     p_enc->fmt_out.video.i_sar_num,
+                     p_enc->fmt_out.video.i_sar_den,
                      0 );
     }
 
-    id->p_encoder->fmt_in.video.i_sar_num =
-        id->p_encoder->fmt_out.video.i_sar_num;
-    id->p_encoder->fmt_in.video.i_sar_den =
-        id->p_encoder->fmt_out.video.i_sar_den;
+    p_enc->fmt_in.video.i_sar_num =
+        p_enc->fmt_out.video.i_sar_num;
+    p_enc->fmt_in.video.i_sar_den =
+        p_enc->fmt_out.video.i_sar_den;
 
     msg_Dbg( p_stream, "encoder aspect is %i:%i",
-             id->p_encoder->fmt_out.video.i_sar_num * id->p_encoder->fmt_out.video.i_width,
-             id->p_encoder->fmt_out.video.i_sar_den * id->p_encoder->fmt_out.video.i_height );
+             p_enc->fmt_out.video.i_sar_num * p_enc->fmt_out.video.i_width,
+             p_enc->fmt_out.video.i_sar_den * p_enc->fmt_out.video.i_height );
 
-    id->p_encoder->fmt_in.video.i_chroma = id->p_encoder->fmt_in.i_codec;
+    p_enc->fmt_in.video.i_chroma = p_enc->fmt_in.i_codec;
 }
 
 static int transcode_video_encoder_open( sout_stream_t *p_stream,
@@ -556,20 +683,111 @@ static int transcode_video_encoder_open( sout_stream_t *p_stream,
     return VLC_SUCCESS;
 }
 
-void transcode_video_close( sout_stream_t *p_stream,
-                                   sout_stream_id_t *id )
+static void transcode_video_renditions_open( sout_stream_t *p_stream,
+                                             sout_stream_id_t *id )
 {
-    if( p_stream->p_sys->i_threads >= 1 )
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+
+    if( p_sys->i_renditions == 0 )
+        return;
+    id->p_renditions = calloc( p_sys->i_renditions,
+                               sizeof(*id->p_renditions) );
+    if( !id->p_renditions )
+        return;
+
+    for( unsigned i = 0; i < p_sys->i_renditions; i++ )
     {
-        vlc_mutex_lock( &p_stream->p_sys->lock_out );
-        p_stream->p_sys->b_abort = true;
-        vlc_cond_signal( &p_stream->p_sys->cond );
-        vlc_mutex_unlock( &p_stream->p_sys->lock_out );
-
-        vlc_join( p_stream->p_sys->thread, NULL );
-        vlc_mutex_destroy( &p_stream->p_sys->lock_out );
-        vlc_cond_destroy( &p_stream->p_sys->cond );
+        const transcode_rendition_cfg_t *p_cfg = &p_sys->p_renditions[i];
+        transcode_rendition_t *p_rend = &id->p_renditions[id->i_renditions];
+        encoder_t *p_enc = sout_EncoderCreate( p_stream );
+        if( !p_enc )
+            break;
+
+        es_format_Init( &p_enc->fmt_out, VIDEO_ES, p_sys->i_vcodec );
+        p_enc->fmt_out.i_id = id->p_encoder->fmt_out.i_id + 1000 * (i + 1);
+        p_enc->fmt_out.i_group = id->p_encoder->fmt_out.i_group;
+        p_enc->fmt_out.i_bitrate = p_cfg->i_bitrate;
+        p_enc->fmt_out.video.i_width = p_cfg->i_width;
+        p_enc->fmt_out.video.i_height = p_cfg->i_height;
+        p_enc->fmt_out.video.i_frame_rate =
+            id->p_encoder->fmt_out.video.i_frame_rate;
+        p_enc->fmt_out.video.i_frame_rate_base =
+            id->p_encoder->fmt_out.video.i_frame_rate_base;
+        es_format_Init( &p_enc->fmt_in, VIDEO_ES,
+                        id->p_decoder->fmt_out.i_codec );
+        p_enc->i_threads = p_sys->i_threads;
+        p_enc->p_cfg = p_sys->p_video_cfg;
+
+        transcode_video_encoder_init( p_stream, id, p_enc );
+
+        p_enc->p_module = module_need( p_enc, "encoder", p_sys->psz_venc,
+                                       true );
+        if( !p_enc->p_module )
+        {
+            msg_Err( p_stream, "cannot find video encoder for rendition "
+                     "%ux%u", p_cfg->i_width, p_cfg->i_height );
+            goto error;
+        }
+        p_enc->fmt_in.video.i_chroma = p_enc->fmt_in.i_codec;
+        p_enc->fmt_out.i_codec =
+            vlc_fourcc_GetCodec( VIDEO_ES, p_enc->fmt_out.i_codec );
+
+        p_rend->id = sout_StreamIdAdd( p_stream->p_next, &p_enc->fmt_out );
+        if( !p_rend->id )
+        {
+            msg_Err( p_stream, "cannot add rendition %ux%u",
+                     p_cfg->i_width, p_cfg->i_height );
+            module_unneed( p_enc, p_enc->p_module );
+            goto error;
+        }
+        p_rend->p_encoder = p_enc;
+
+        /* Scaling and chroma conversion from the deinterlaced pictures */
+        p_rend->p_f_chain = filter_chain_New( p_stream, "video filter2",
+                                      false,
+                                      transcode_video_filter_allocation_init,
+                                      transcode_video_filter_allocation_clear,
+                                      p_sys );
+        if( p_rend->p_f_chain &&
+            ( id->p_decoder->fmt_out.video.i_chroma !=
+              p_enc->fmt_in.video.i_chroma ||
+              id->p_decoder->fmt_out.video.i_width !=
+              p_enc->fmt_in.video.i_width ||
+              id->p_decoder->fmt_out.video.i_height !=
+              p_enc->fmt_in.video.i_height ) )
+            filter_chain_AppendFilter( p_rend->p_f_chain, NULL, NULL,
+                                       &id->p_decoder->fmt_out,
+                                       &p_enc->fmt_in );
+
+        vlc_mutex_init( &p_rend->lock_out );
+        p_rend->p_buffers = NULL;
+        p_rend->p_stage = NULL;
+        if( p_sys->i_threads >= 1 )
+            p_rend->p_stage = transcode_stage_New( VLC_OBJECT(p_stream),
+                                      transcode_rendition_run,
+                                      transcode_video_drop, p_rend,
+                                      PICTURE_QUEUE_SIZE,
+                                      p_sys->b_high_priority
+                                        ? VLC_THREAD_PRIORITY_OUTPUT
+                                        : VLC_THREAD_PRIORITY_VIDEO );
+
+        msg_Dbg( p_stream, "rendition %ux%u at %d kb/s",
+                 p_enc->fmt_out.video.i_width, p_enc->fmt_out.video.i_height,
+                 p_cfg->i_bitrate / 1000 );
+        id->i_renditions++;
+        continue;
+
+error:
+        es_format_Clean( &p_enc->fmt_out );
+        vlc_object_release( p_enc );
     }
+}
+
+void transcode_video_close( sout_stream_t *p_stream,
+                                   sout_stream_id_t *id )
+{
+    transcode_pipeline_Delete( id );
+    transcode_video_renditions_close( p_stream, id );
 
     video_timer_close( id->p_encoder );
 
@@ -586,10 +804,35 @@ void transcode_video_close( sout_stream_t *p_stream,
         module_unneed( id->p_encoder, id->p_encoder->p_module );
 
     /* Close filters */
+    if( id->p_di_chain )
+        filter_chain_Delete( id->p_di_chain );
     if( id->p_f_chain )
         filter_chain_Delete( id->p_f_chain );
     if( id->p_uf_chain )
         filter_chain_Delete( id->p_uf_chain );
+    if( id->p_spu_blend )
+        filter_DeleteBlend( id->p_spu_blend );
+    id->p_spu_blend = NULL;
+}
+
+/* Filters and encodes a decoded picture, or hands it to the pipeline */
+static void transcode_video_push( sout_stream_t *p_stream,
+                                  sout_stream_id_t *id, picture_t *p_pic,
+                                  block_t **out )
+{
+    if( id->p_filter_stage )
+    {
+        transcode_stage_Push( id->p_filter_stage, p_pic );
+        return;
+    }
+
+    p_pic = transcode_video_filter( p_stream, id, p_pic );
+    if( p_pic )
+    {
+        block_ChainAppend( out, transcode_video_encode( id->p_encoder,
+                                                        p_pic ) );
+        picture_Release( p_pic );
+    }
 }
 
 int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_t *id,
@@ -597,34 +840,34 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_t *id,
 {
     sout_stream_sys_t *p_sys = p_stream->p_sys;
     bool b_need_duplicate = false;
-    picture_t *p_pic, *p_pic2 = NULL;
+    picture_t *p_pic;
     *out = NULL;
 
     if( unlikely( in == NULL ) )
     {
-        if( p_sys->i_threads == 0 )
+        block_t *p_block;
+
+        if( id->p_filter_stage )
+        {
+            transcode_pipeline_Drain( id );
+            *out = transcode_pipeline_GetOutput( id );
+        }
+        /* The encoder stage is idle now: flush from here */
+        if( id->p_encoder->p_module )
         {
-            block_t *p_block;
             do {
-                video_timer_start( id->p_encoder );
-                p_block = id->p_encoder->pf_encode_video(id->p_encoder, NULL );
-                video_timer_stop( id->p_encoder );
+                p_block = transcode_video_encode( id->p_encoder, NULL );
                 block_ChainAppend( out, p_block );
             } while( p_block );
         }
-        else
-        {
-            /*
-             * FIXME: we need EncoderThread() to flush buffers and signal us
-             * when it's done so we can send the last frames to the chain
-             */
-        }
+        transcode_video_renditions_flush( p_stream, id );
         return VLC_SUCCESS;
     }
 
 
     while( (p_pic = id->p_decoder->pf_decode_video( id->p_decoder, &in )) )
     {
+        mtime_t i_duplicate_date = VLC_TS_INVALID;
 
         if( p_stream->p_sout->i_out_pace_nocontrol && p_sys->b_hurry_up )
         {
@@ -675,11 +918,27 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_t *id,
 #endif
                 b_need_duplicate = true;
             }
+
+            i_pts = date_Get( &id->interpolated_pts ) + 1;
+            if (unlikely ( p_pic->date - i_pts > MASTER_SYNC_MAX_DRIFT
+                  || p_pic->date - i_pts < -MASTER_SYNC_MAX_DRIFT ) )
+            {
+                msg_Dbg( p_stream, "drift is too high, resetting master sync" );
+                date_Set( &id->interpolated_pts, p_pic->date );
+                i_pts = p_pic->date + 1;
+            }
+            date_Increment( &id->interpolated_pts, 1 );
+
+            if( unlikely( b_need_duplicate ) )
+                i_duplicate_date = i_pts;
         }
 
         if( unlikely( !id->p_encoder->p_module ) )
         {
-            transcode_video_encoder_init( p_stream, id );
+            transcode_video_encoder_init( p_stream, id, id->p_encoder );
+            date_Init( &id->interpolated_pts,
+                       id->p_encoder->fmt_out.video.i_frame_rate,
+                       id->p_encoder->fmt_out.video.i_frame_rate_base );
 
             transcode_video_filter_init( p_stream, id );
 
@@ -690,126 +949,32 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_t *id,
                 id->b_transcode = false;
                 return VLC_EGENERIC;
             }
-        }
-
-        /* Run filter chain */
-        if( id->p_f_chain )
-            p_pic = filter_chain_VideoFilter( id->p_f_chain, p_pic );
 
-        /* Run user specified filter chain */
-        if( id->p_uf_chain )
-            p_pic = filter_chain_VideoFilter( id->p_uf_chain, p_pic );
-
-        /*
-         * Encoding
-         */
-
-        /* Check if we have a subpicture to overlay */
-        if( p_sys->p_spu )
-        {
-            video_format_t fmt = id->p_encoder->fmt_in.video;
-            if( fmt.i_visible_width <= 0 || fmt.i_visible_height <= 0 )
-            {
-                fmt.i_visible_width  = fmt.i_width;
-                fmt.i_visible_height = fmt.i_height;
-                fmt.i_x_offset       = 0;
-                fmt.i_y_offset       = 0;
-            }
-
-            subpicture_t *p_subpic = spu_Render( p_sys->p_spu, NULL, &fmt, &fmt,
-                                                 p_pic->date, p_pic->date, false );
-
-            /* Overlay subpicture */
-            if( p_subpic )
-            {
-                if( picture_IsReferenced( p_pic ) && !filter_chain_GetLength( id->p_f_chain ) )
-                {
-                    /* We can't modify the picture, we need to duplicate it */
-                    picture_t *p_tmp = video_new_buffer_decoder( id->p_decoder );
-                    if( likely( p_tmp ) )
-                    {
-                        picture_Copy( p_tmp, p_pic );
-                        picture_Release( p_pic );
-                        p_pic = p_tmp;
-                    }
-                }
-                if( unlikely( !p_sys->p_spu_blend ) )
-                    p_sys->p_spu_blend = filter_NewBlend( VLC_OBJECT( p_sys->p_spu ), &fmt );
-                if( likely( p_sys->p_spu_blend ) )
-                    picture_BlendSubpicture( p_pic, p_sys->p_spu_blend, p_subpic );
-                subpicture_Delete( p_subpic );
-            }
+            transcode_video_renditions_open( p_stream, id );
         }
 
-        if( p_sys->i_threads == 0 )
+        /* The duplicate is made before filtering, so that it goes through
+         * the whole chain, and to every rendition, like any other picture */
+        picture_t *p_pic2 = NULL;
+        if( i_duplicate_date != VLC_TS_INVALID )
         {
-            block_t *p_block;
-
-            video_timer_start( id->p_encoder );
-            p_block = id->p_encoder->pf_encode_video( id->p_encoder, p_pic );
-            video_timer_stop( id->p_encoder );
-
-            block_ChainAppend( out, p_block );
-        }
-
-        if( p_sys->b_master_sync )
-        {
-            mtime_t i_pts = date_Get( &id->interpolated_pts ) + 1;
-            if (unlikely ( p_pic->date - i_pts > MASTER_SYNC_MAX_DRIFT
-                  || p_pic->date - i_pts < -MASTER_SYNC_MAX_DRIFT ) )
+            p_pic2 = picture_NewFromFormat( &p_pic->format );
+            if( likely( p_pic2 != NULL ) )
             {
-                msg_Dbg( p_stream, "drift is too high, resetting master sync" );
-                date_Set( &id->interpolated_pts, p_pic->date );
-                i_pts = p_pic->date + 1;
+                picture_Copy( p_pic2, p_pic );
+                p_pic2->date = i_duplicate_date;
             }
-            date_Increment( &id->interpolated_pts, 1 );
-
-            if( unlikely( b_need_duplicate ) )
-            {
-
-               if( p_sys->i_threads >= 1 )
-               {
-                   /* We can't modify the picture, we need to duplicate it */
-                   p_pic2 = video_new_buffer_decoder( id->p_decoder );
-                   if( likely( p_pic2 != NULL ) )
-                   {
-                       picture_Copy( p_pic2, p_pic );
-                       p_pic2->date = i_pts;
-                   }
-               }
-               else
-               {
-                   block_t *p_block;
-                   p_pic->date = i_pts;
-                   video_timer_start( id->p_encoder );
-                   p_block = id->p_encoder->pf_encode_video(id->p_encoder, p_pic);
-                   video_timer_stop( id->p_encoder );
-                   block_ChainAppend( out, p_block );
-               }
-           }
         }
 
-        if( p_sys->i_threads == 0 )
-        {
-            picture_Release( p_pic );
-        }
-        else
-        {
-            vlc_mutex_lock( &p_sys->lock_out );
-            p_sys->pp_pics[p_sys->i_last_pic++] = p_pic;
-            p_sys->i_last_pic %= PICTURE_RING_SIZE;
-            *out = p_sys->p_buffers;
-            p_sys->p_buffers = NULL;
-            if( p_pic2 != NULL )
-            {
-                p_sys->pp_pics[p_sys->i_last_pic++] = p_pic2;
-                p_sys->i_last_pic %= PICTURE_RING_SIZE;
-            }
-            vlc_cond_signal( &p_sys->cond );
-            vlc_mutex_unlock( &p_sys->lock_out );
-        }
+        transcode_video_push( p_stream, id, p_pic, out );
+        if( p_pic2 != NULL )
+            transcode_video_push( p_stream, id, p_pic2, out );
     }
 
+    if( id->p_filter_stage )
+        *out = transcode_pipeline_GetOutput( id );
+    transcode_video_renditions_send( p_stream, id );
+
     return VLC_SUCCESS;
 }
 
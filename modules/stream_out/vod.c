@@ -88,6 +88,7 @@ struct vod_sys_t
 typedef enum
 {
     RTSP_CMD_TYPE_STOP,
+    RTSP_CMD_TYPE_PLAY,
     RTSP_CMD_TYPE_ADD,
     RTSP_CMD_TYPE_DEL,
 } rtsp_cmd_type_t;
@@ -98,6 +99,7 @@ typedef struct
     int i_type;
     vod_media_t *p_media;
     char *psz_arg;
+    int64_t i_arg;
 } rtsp_cmd_t;
 
 static vod_media_t *MediaNew( vod_t *, const char *, input_item_t * );
@@ -106,7 +108,7 @@ static void         MediaAskDel ( vod_t *, vod_media_t * );
 
 static void* CommandThread( void *obj );
 static void  CommandPush( vod_t *, rtsp_cmd_type_t, vod_media_t *,
-                          const char *psz_arg );
+                          const char *psz_arg, int64_t i_arg );
 
 /*****************************************************************************
  * Open: Starts the RTSP server module
@@ -262,7 +264,7 @@ static vod_media_t *MediaNew( vod_t *p_vod, const char *psz_name,
 
     msg_Dbg(p_vod, "adding media '%s'", psz_name);
 
-    CommandPush( p_vod, RTSP_CMD_TYPE_ADD, p_media, psz_name );
+    CommandPush( p_vod, RTSP_CMD_TYPE_ADD, p_media, psz_name, 0 );
     return p_media;
 
 error:
@@ -296,7 +298,7 @@ static void MediaSetup( vod_t *p_vod, vod_media_t *p_media,
 static void MediaAskDel ( vod_t *p_vod, vod_media_t *p_media )
 {
     msg_Dbg( p_vod, "deleting media" );
-    CommandPush( p_vod, RTSP_CMD_TYPE_DEL, p_media, NULL );
+    CommandPush( p_vod, RTSP_CMD_TYPE_DEL, p_media, NULL, 0 );
 }
 
 static void MediaDel( vod_t *p_vod, vod_media_t *p_media )
@@ -327,7 +329,8 @@ static void MediaDel( vod_t *p_vod, vod_media_t *p_media )
 }
 
 static void CommandPush( vod_t *p_vod, rtsp_cmd_type_t i_type,
-                         vod_media_t *p_media, const char *psz_arg )
+                         vod_media_t *p_media, const char *psz_arg,
+                         int64_t i_arg )
 {
     rtsp_cmd_t cmd;
     block_t *p_cmd;
@@ -338,6 +341,7 @@ static void CommandPush( vod_t *p_vod, rtsp_cmd_type_t i_type,
         cmd.psz_arg = strdup(psz_arg);
     else
         cmd.psz_arg = NULL;
+    cmd.i_arg = i_arg;
 
     p_cmd = block_New( p_vod, sizeof(rtsp_cmd_t) );
     memcpy( p_cmd->p_buffer, &cmd, sizeof(cmd) );
@@ -374,6 +378,10 @@ static void* CommandThread( void *obj )
         case RTSP_CMD_TYPE_STOP:
             vod_MediaControl( p_vod, cmd.p_media, cmd.psz_arg, VOD_MEDIA_STOP );
             break;
+        case RTSP_CMD_TYPE_PLAY:
+            vod_MediaControl( p_vod, cmd.p_media, cmd.psz_arg, VOD_MEDIA_PLAY,
+                              "vod", &cmd.i_arg );
+            break;
 
         default:
             break;
@@ -494,7 +502,14 @@ void vod_pause(vod_media_t *p_media, const char *psz_session, int64_t *npt)
 
 void vod_stop(vod_media_t *p_media, const char *psz_session)
 {
-    CommandPush(p_media->p_vod, RTSP_CMD_TYPE_STOP, p_media, psz_session);
+    CommandPush(p_media->p_vod, RTSP_CMD_TYPE_STOP, p_media, psz_session, 0);
+}
+
+/* Start the instance of a feed shared by several sessions. This goes
+ * through the command thread, so as to stay ordered with vod_stop(). */
+void vod_play_feed(vod_media_t *p_media, const char *psz_feed, int64_t start)
+{
+    CommandPush(p_media->p_vod, RTSP_CMD_TYPE_PLAY, p_media, psz_feed, start);
 }
 
 
@@ -288,6 +288,43 @@ struct line_desc_t
     line_character_t *p_character;
 };
 
+/* Faces loaded for the styles used by the texts */
+#define FACE_CACHE_SIZE     8
+
+typedef struct
+{
+    char          *psz_fontname;
+    int            i_style_flags;   /* STYLE_BOLD and STYLE_ITALIC only */
+    FT_Face        p_face;          /* NULL to use the default face */
+} face_cache_entry_t;
+
+/* The same strings are often rendered again and again (marquee, scrolling
+ * text, karaoke), so the rendered glyphs are kept, up to a memory budget */
+#define GLYPH_CACHE_BUDGET  (2 << 20)
+#define GLYPH_CACHE_BUCKETS 256
+
+typedef struct glyph_cache_entry_t glyph_cache_entry_t;
+struct glyph_cache_entry_t
+{
+    glyph_cache_entry_t *p_hash_next;
+    glyph_cache_entry_t *p_lru_prev;   /* more recently used */
+    glyph_cache_entry_t *p_lru_next;   /* less recently used */
+
+    FT_Face        p_face;
+    int            i_font_size;
+    int            i_style_flags;
+    FT_UInt        i_glyph_index;
+    uint8_t        i_pen_x, i_pen_y;        /* 1/64th of pixel offsets */
+    uint8_t        i_shadow_x, i_shadow_y;  /* of the rendering origins */
+
+    /* Bitmaps rendered at the above offsets */
+    FT_Glyph       glyph;
+    FT_Glyph       outline;
+    FT_Glyph       shadow;
+    FT_Vector      advance;
+    size_t         i_bytes;
+};
+
 typedef struct font_stack_t font_stack_t;
 struct font_stack_t
 {
@@ -339,6 +376,17 @@ struct filter_sys_t
 
     input_attachment_t **pp_font_attachments;
     int                  i_font_attachments;
+
+    face_cache_entry_t   faces[FACE_CACHE_SIZE]; /* most recently used first */
+    int                  i_faces;
+
+    struct
+    {
+        glyph_cache_entry_t *pp_buckets[GLYPH_CACHE_BUCKETS];
+        glyph_cache_entry_t *p_lru_first;
+        glyph_cache_entry_t *p_lru_last;
+        size_t               i_bytes;
+    } glyphs;
 };
 
 /* */
@@ -1881,16 +1929,159 @@ static bool FaceStyleEquals( const text_style_t *p_style1,
            !strcmp( p_style1->psz_fontname, p_style2->psz_fontname );
 }
 
-static int GetGlyph( filter_t *p_filter,
-                     FT_Glyph *pp_glyph,   FT_BBox *p_glyph_bbox,
-                     FT_Glyph *pp_outline, FT_BBox *p_outline_bbox,
-                     FT_Glyph *pp_shadow,  FT_BBox *p_shadow_bbox,
+static unsigned GlyphCacheHash( FT_Face p_face, int i_font_size,
+                                FT_UInt i_glyph_index )
+{
+    uintptr_t i_hash = (uintptr_t)p_face / sizeof(void *);
+    i_hash = i_hash * 31 + i_font_size;
+    i_hash = i_hash * 31 + i_glyph_index;
+    return i_hash % GLYPH_CACHE_BUCKETS;
+}
 
-                     FT_Face  p_face,
-                     int i_glyph_index,
-                     int i_style_flags,
-                     FT_Vector *p_pen,
-                     FT_Vector *p_pen_shadow )
+static void GlyphCacheUnlink( filter_sys_t *p_sys, glyph_cache_entry_t *p_entry )
+{
+    if( p_entry->p_lru_prev )
+        p_entry->p_lru_prev->p_lru_next = p_entry->p_lru_next;
+    else
+        p_sys->glyphs.p_lru_first = p_entry->p_lru_next;
+    if( p_entry->p_lru_next )
+        p_entry->p_lru_next->p_lru_prev = p_entry->p_lru_prev;
+    else
+        p_sys->glyphs.p_lru_last = p_entry->p_lru_prev;
+}
+
+static void GlyphCacheLinkFirst( filter_sys_t *p_sys, glyph_cache_entry_t *p_entry )
+{
+    p_entry->p_lru_prev = NULL;
+    p_entry->p_lru_next = p_sys->glyphs.p_lru_first;
+    if( p_entry->p_lru_next )
+        p_entry->p_lru_next->p_lru_prev = p_entry;
+    else
+        p_sys->glyphs.p_lru_last = p_entry;
+    p_sys->glyphs.p_lru_first = p_entry;
+}
+
+static void GlyphCacheRemove( filter_sys_t *p_sys, glyph_cache_entry_t *p_entry )
+{
+    glyph_cache_entry_t **pp = &p_sys->glyphs.pp_buckets[
+        GlyphCacheHash( p_entry->p_face, p_entry->i_font_size,
+                        p_entry->i_glyph_index )];
+    while( *pp != p_entry )
+        pp = &(*pp)->p_hash_next;
+    *pp = p_entry->p_hash_next;
+    GlyphCacheUnlink( p_sys, p_entry );
+
+    p_sys->glyphs.i_bytes -= p_entry->i_bytes;
+    FT_Done_Glyph( p_entry->glyph );
+    if( p_entry->outline )
+        FT_Done_Glyph( p_entry->outline );
+    if( p_entry->shadow )
+        FT_Done_Glyph( p_entry->shadow );
+    free( p_entry );
+}
+
+/* Drop the glyphs of a face, or of all the faces if NULL */
+static void GlyphCacheFlush( filter_sys_t *p_sys, FT_Face p_face )
+{
+    glyph_cache_entry_t *p_entry = p_sys->glyphs.p_lru_first;
+    while( p_entry )
+    {
+        glyph_cache_entry_t *p_next = p_entry->p_lru_next;
+        if( !p_face || p_entry->p_face == p_face )
+            GlyphCacheRemove( p_sys, p_entry );
+        p_entry = p_next;
+    }
+}
+
+static size_t BitmapGlyphSize( FT_Glyph glyph )
+{
+    if( !glyph )
+        return 0;
+    const FT_Bitmap *p_bitmap = &((FT_BitmapGlyph)glyph)->bitmap;
+    return sizeof(FT_BitmapGlyphRec) + abs( p_bitmap->pitch ) * p_bitmap->rows;
+}
+
+/* Copy a cached bitmap glyph, moved by whole pixels */
+static FT_Glyph GlyphCacheCopy( FT_Glyph glyph, const FT_Vector *p_pen,
+                                FT_BBox *p_bbox )
+{
+    FT_Glyph copy;
+    if( FT_Glyph_Copy( glyph, &copy ) )
+        return NULL;
+
+    FT_BitmapGlyph copy_bmp = (FT_BitmapGlyph)copy;
+    copy_bmp->left += FT_FLOOR(p_pen->x);
+    copy_bmp->top  += FT_FLOOR(p_pen->y);
+    FT_Glyph_Get_CBox( copy, ft_glyph_bbox_pixels, p_bbox );
+    return copy;
+}
+
+/* Load a face for a style, or NULL for the default face */
+static FT_Face GetFace( filter_t *p_filter, const text_style_t *p_style )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const int i_style_flags = p_style->i_style_flags & (STYLE_BOLD | STYLE_ITALIC);
+    face_cache_entry_t entry;
+    int i;
+
+    for( i = 0; i < p_sys->i_faces; i++ )
+        if( p_sys->faces[i].i_style_flags == i_style_flags &&
+            !strcmp( p_sys->faces[i].psz_fontname, p_style->psz_fontname ) )
+            break;
+
+    if( i < p_sys->i_faces )
+        entry = p_sys->faces[i];
+    else
+    {
+        entry.psz_fontname = strdup( p_style->psz_fontname );
+        if( unlikely(entry.psz_fontname == NULL) )
+            return NULL;
+        entry.i_style_flags = i_style_flags;
+        entry.p_face = LoadFace( p_filter, p_style );
+
+        if( p_sys->i_faces == FACE_CACHE_SIZE )
+        {
+            face_cache_entry_t *p_last = &p_sys->faces[FACE_CACHE_SIZE - 1];
+            if( p_last->p_face )
+            {
+                GlyphCacheFlush( p_sys, p_last->p_face );
+                FT_Done_Face( p_last->p_face );
+            }
+            free( p_last->psz_fontname );
+            i = FACE_CACHE_SIZE - 1;
+        }
+        else
+            i = p_sys->i_faces++;
+    }
+
+    memmove( &p_sys->faces[1], &p_sys->faces[0], i * sizeof(p_sys->faces[0]) );
+    p_sys->faces[0] = entry;
+    return entry.p_face;
+}
+
+static void FlushFaces( filter_sys_t *p_sys )
+{
+    GlyphCacheFlush( p_sys, NULL );
+    for( int i = 0; i < p_sys->i_faces; i++ )
+    {
+        if( p_sys->faces[i].p_face )
+            FT_Done_Face( p_sys->faces[i].p_face );
+        free( p_sys->faces[i].psz_fontname );
+    }
+    p_sys->i_faces = 0;
+}
+
+static int RenderGlyph( filter_t *p_filter,
+                        FT_Glyph *pp_glyph,
+                        FT_Glyph *pp_outline,
+                        FT_Glyph *pp_shadow,
+                        FT_Vector *p_advance,
+
+                        FT_Face  p_face,
+                        int i_glyph_index,
+                        int i_style_flags,
+                        FT_Vector *p_pen,
+                        FT_Vector *p_pen_shadow )
 {
     if( FT_Load_Glyph( p_face, i_glyph_index, FT_LOAD_NO_BITMAP | FT_LOAD_DEFAULT ) &&
         FT_Load_Glyph( p_face, i_glyph_index, FT_LOAD_DEFAULT ) )
@@ -1928,13 +2119,7 @@ static int GetGlyph( filter_t *p_filter,
     {
         shadow = outline ? outline : glyph;
         if( FT_Glyph_To_Bitmap( &shadow, FT_RENDER_MODE_NORMAL, p_pen_shadow, 0  ) )
-        {
             shadow = NULL;
-        }
-        else
-        {
-            FT_Glyph_Get_CBox( shadow, ft_glyph_bbox_pixels, p_shadow_bbox );
-        }
     }
     *pp_shadow = shadow;
 
@@ -1947,32 +2132,132 @@ static int GetGlyph( filter_t *p_filter,
             FT_Done_Glyph( shadow );
         return VLC_EGENERIC;
     }
-    FT_Glyph_Get_CBox( glyph, ft_glyph_bbox_pixels, p_glyph_bbox );
     *pp_glyph = glyph;
 
-    if( outline )
+    if( outline && FT_Glyph_To_Bitmap( &outline, FT_RENDER_MODE_NORMAL, p_pen, 1 ) )
     {
-        FT_Glyph_To_Bitmap( &outline, FT_RENDER_MODE_NORMAL, p_pen, 1 );
-        FT_Glyph_Get_CBox( outline, ft_glyph_bbox_pixels, p_outline_bbox );
+        FT_Done_Glyph( outline );
+        outline = NULL;
     }
     *pp_outline = outline;
+    *p_advance = p_face->glyph->advance;
+
+    return VLC_SUCCESS;
+}
+
+static int GetGlyph( filter_t *p_filter,
+                     FT_Glyph *pp_glyph,   FT_BBox *p_glyph_bbox,
+                     FT_Glyph *pp_outline, FT_BBox *p_outline_bbox,
+                     FT_Glyph *pp_shadow,  FT_BBox *p_shadow_bbox,
+                     FT_Vector *p_advance,
+
+                     FT_Face  p_face,
+                     int i_font_size,
+                     int i_glyph_index,
+                     int i_style_flags,
+                     FT_Vector *p_pen,
+                     FT_Vector *p_pen_shadow )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    /* Only the faked styles change the glyphs of a face */
+    i_style_flags &= STYLE_BOLD | STYLE_ITALIC;
+
+    /* The glyphs are rendered at the sub-pixel offsets of the pens, then
+     * moved by whole pixels */
+    FT_Vector pen = { .x = p_pen->x & 63, .y = p_pen->y & 63 };
+    FT_Vector pen_shadow = { .x = p_pen_shadow->x & 63,
+                             .y = p_pen_shadow->y & 63 };
+
+    const unsigned i_hash = GlyphCacheHash( p_face, i_font_size, i_glyph_index );
+    glyph_cache_entry_t *p_entry;
+    for( p_entry = p_sys->glyphs.pp_buckets[i_hash]; p_entry != NULL;
+         p_entry = p_entry->p_hash_next )
+        if( p_entry->p_face == p_face &&
+            p_entry->i_font_size == i_font_size &&
+            p_entry->i_glyph_index == (FT_UInt)i_glyph_index &&
+            p_entry->i_style_flags == i_style_flags &&
+            p_entry->i_pen_x == pen.x && p_entry->i_pen_y == pen.y &&
+            p_entry->i_shadow_x == pen_shadow.x &&
+            p_entry->i_shadow_y == pen_shadow.y )
+            break;
+
+    if( p_entry )
+    {
+        GlyphCacheUnlink( p_sys, p_entry );
+        GlyphCacheLinkFirst( p_sys, p_entry );
+    }
+    else
+    {
+        p_entry = malloc( sizeof(*p_entry) );
+        if( unlikely(p_entry == NULL) )
+            return VLC_ENOMEM;
+
+        if( RenderGlyph( p_filter, &p_entry->glyph, &p_entry->outline,
+                         &p_entry->shadow, &p_entry->advance,
+                         p_face, i_glyph_index, i_style_flags,
+                         &pen, &pen_shadow ) )
+        {
+            free( p_entry );
+            return VLC_EGENERIC;
+        }
+        p_entry->p_face = p_face;
+        p_entry->i_font_size = i_font_size;
+        p_entry->i_style_flags = i_style_flags;
+        p_entry->i_glyph_index = i_glyph_index;
+        p_entry->i_pen_x = pen.x;
+        p_entry->i_pen_y = pen.y;
+        p_entry->i_shadow_x = pen_shadow.x;
+        p_entry->i_shadow_y = pen_shadow.y;
+        p_entry->i_bytes = sizeof(*p_entry) +
+                           BitmapGlyphSize( p_entry->glyph ) +
+                           BitmapGlyphSize( p_entry->outline ) +
+                           BitmapGlyphSize( p_entry->shadow );
+
+        /* Make room, keeping at least this one */
+        while( p_sys->glyphs.p_lru_last &&
+               p_sys->glyphs.i_bytes + p_entry->i_bytes > GLYPH_CACHE_BUDGET )
+            GlyphCacheRemove( p_sys, p_sys->glyphs.p_lru_last );
+
+        p_entry->p_hash_next = p_sys->glyphs.pp_buckets[i_hash];
+        p_sys->glyphs.pp_buckets[i_hash] = p_entry;
+        GlyphCacheLinkFirst( p_sys, p_entry );
+        p_sys->glyphs.i_bytes += p_entry->i_bytes;
+    }
+
+    FT_Vector pen_int = { .x = p_pen->x - pen.x, .y = p_pen->y - pen.y };
+    FT_Vector pen_shadow_int = { .x = p_pen_shadow->x - pen_shadow.x,
+                                 .y = p_pen_shadow->y - pen_shadow.y };
+
+    *pp_glyph = GlyphCacheCopy( p_entry->glyph, &pen_int, p_glyph_bbox );
+    if( !*pp_glyph )
+        return VLC_ENOMEM;
+    *pp_outline = NULL;
+    if( p_entry->outline )
+        *pp_outline = GlyphCacheCopy( p_entry->outline, &pen_int,
+                                      p_outline_bbox );
+    *pp_shadow = NULL;
+    if( p_entry->shadow )
+        *pp_shadow = GlyphCacheCopy( p_entry->shadow, &pen_shadow_int,
+                                     p_shadow_bbox );
+    *p_advance = p_entry->advance;
 
     return VLC_SUCCESS;
 }
 
-static void FixGlyph( FT_Glyph glyph, FT_BBox *p_bbox, FT_Face face, const FT_Vector *p_pen )
+static void FixGlyph( FT_Glyph glyph, FT_BBox *p_bbox, const FT_Vector *p_advance,
+                      const FT_Vector *p_pen )
 {
     FT_BitmapGlyph glyph_bmp = (FT_BitmapGlyph)glyph;
     if( p_bbox->xMin >= p_bbox->xMax )
     {
         p_bbox->xMin = FT_CEIL(p_pen->x);
-        p_bbox->xMax = FT_CEIL(p_pen->x + face->glyph->advance.x);
+        p_bbox->xMax = FT_CEIL(p_pen->x + p_advance->x);
         glyph_bmp->left = p_bbox->xMin;
     }
     if( p_bbox->yMin >= p_bbox->yMax )
     {
         p_bbox->yMax = FT_CEIL(p_pen->y);
-        p_bbox->yMin = FT_CEIL(p_pen->y + face->glyph->advance.y);
+        p_bbox->yMin = FT_CEIL(p_pen->y + p_advance->y);
         glyph_bmp->top  = p_bbox->yMax;
     }
 }
@@ -2161,11 +2446,9 @@ static int ProcessLines( filter_t *p_filter,
             /* (Re)load/reconfigure the face if needed */
             if( !FaceStyleEquals( p_current_style, p_previous_style ) )
             {
-                if( p_face )
-                    FT_Done_Face( p_face );
                 p_previous_style = NULL;
 
-                p_face = LoadFace( p_filter, p_current_style );
+                p_face = GetFace( p_filter, p_current_style );
             }
             FT_Face p_current_face = p_face ? p_face : p_sys->p_face;
             if( !p_previous_style || p_previous_style->i_font_size != p_current_style->i_font_size )
@@ -2215,20 +2498,23 @@ static int ProcessLines( filter_t *p_filter,
                 FT_BBox  outline_bbox;
                 FT_Glyph shadow;
                 FT_BBox  shadow_bbox;
+                FT_Vector advance;
 
                 if( GetGlyph( p_filter,
                               &glyph, &glyph_bbox,
                               &outline, &outline_bbox,
                               &shadow, &shadow_bbox,
-                              p_current_face, i_glyph_index, p_glyph_style->i_style_flags,
+                              &advance,
+                              p_current_face, p_current_style->i_font_size,
+                              i_glyph_index, p_glyph_style->i_style_flags,
                               &pen_new, &pen_shadow_new ) )
                     goto next;
 
-                FixGlyph( glyph, &glyph_bbox, p_current_face, &pen_new );
+                FixGlyph( glyph, &glyph_bbox, &advance, &pen_new );
                 if( outline )
-                    FixGlyph( outline, &outline_bbox, p_current_face, &pen_new );
+                    FixGlyph( outline, &outline_bbox, &advance, &pen_new );
                 if( shadow )
-                    FixGlyph( shadow, &shadow_bbox, p_current_face, &pen_shadow_new );
+                    FixGlyph( shadow, &shadow_bbox, &advance, &pen_shadow_new );
 
                 /* FIXME and what about outline */
 
@@ -2327,8 +2613,8 @@ static int ProcessLines( filter_t *p_filter,
                     .i_line_thickness = i_line_thickness,
                 };
 
-                pen.x = pen_new.x + p_current_face->glyph->advance.x;
-                pen.y = pen_new.y + p_current_face->glyph->advance.y;
+                pen.x = pen_new.x + advance.x;
+                pen.y = pen_new.y + advance.y;
                 line_bbox = line_bbox_new;
             next:
                 i_glyph_last = i_glyph_index;
@@ -2392,9 +2678,6 @@ static int ProcessLines( filter_t *p_filter,
             break;
         }
     }
-    if( p_face )
-        FT_Done_Face( p_face );
-
     free( pp_fribidi_styles );
     free( p_fribidi_string );
     free( pi_karaoke_bar );
@@ -2641,6 +2924,8 @@ static int Create( vlc_object_t *p_this )
 #endif
     p_sys->p_face           = 0;
     p_sys->p_library        = 0;
+    p_sys->i_faces          = 0;
+    memset( &p_sys->glyphs, 0, sizeof(p_sys->glyphs) );
     p_sys->i_font_size      = 0;
     p_sys->i_display_height = 0;
 
@@ -2829,6 +3114,7 @@ static void Destroy( vlc_object_t *p_this )
      * even if no other library functions have been made since FcInit(),
      * so don't call it. */
 
+    FlushFaces( p_sys );
     if( p_sys->p_stroker )
         FT_Stroker_Done( p_sys->p_stroker );
     FT_Done_Face( p_sys->p_face );
@@ -62,9 +62,12 @@
  *****************************************************************************/
 static int  Activate ( vlc_object_t * );
 
-static void I420_YUY2           ( filter_t *, picture_t *, picture_t * );
-static void I420_YVYU           ( filter_t *, picture_t *, picture_t * );
-static void I420_UYVY           ( filter_t *, picture_t *, picture_t * );
+static int  ActivateScaled ( vlc_object_t * );
+static void DeactivateScaled ( vlc_object_t * );
+
+static void I420_YUY2           ( picture_t *, picture_t *, int, int );
+static void I420_YVYU           ( picture_t *, picture_t *, int, int );
+static void I420_UYVY           ( picture_t *, picture_t *, int, int );
 static picture_t *I420_YUY2_Filter    ( filter_t *, picture_t * );
 static picture_t *I420_YVYU_Filter    ( filter_t *, picture_t * );
 static picture_t *I420_UYVY_Filter    ( filter_t *, picture_t * );
@@ -75,9 +78,10 @@ static picture_t *I420_IUYV_Filter    ( filter_t *, picture_t * );
 static picture_t *I420_cyuv_Filter    ( filter_t *, picture_t * );
 #endif
 #if defined (MODULE_NAME_IS_i420_yuy2)
-static void I420_Y211           ( filter_t *, picture_t *, picture_t * );
+static void I420_Y211           ( picture_t *, picture_t *, int, int );
 static picture_t *I420_Y211_Filter    ( filter_t *, picture_t * );
 #endif
+static picture_t *I420_Scaled_Filter  ( filter_t *, picture_t * );
 
 #ifdef MODULE_NAME_IS_i420_yuy2_mmx
 /* Initialize MMX-specific constants */
@@ -108,6 +112,17 @@ vlc_module_begin ()
 # define CPU_CAPABILITY CPU_CAPABILITY_ALTIVEC
 #endif
     set_callbacks( Activate, NULL )
+
+    /* Conversion and scaling in one pass, below swscale which filters */
+    add_submodule ()
+#if defined (MODULE_NAME_IS_i420_yuy2)
+    set_capability( "video filter2", 70 )
+#elif defined (MODULE_NAME_IS_i420_yuy2_mmx)
+    set_capability( "video filter2", 140 )
+#else
+    set_capability( "video filter2", 145 )
+#endif
+    set_callbacks( ActivateScaled, DeactivateScaled )
 vlc_module_end ()
 
 /*****************************************************************************
@@ -178,6 +193,107 @@ static int Activate( vlc_object_t *p_this )
     return 0;
 }
 
+/*****************************************************************************
+ * ActivateScaled: allocate a chroma function scaling the picture
+ *****************************************************************************
+ * The output is converted two lines at a time: the source pixels of both
+ * lines are picked into a band at the output width, then the band is
+ * converted by the same functions as the unscaled pictures. The source is
+ * thus read once and the output written once.
+ *****************************************************************************/
+struct filter_sys_t
+{
+    void (*pf_convert)( picture_t *, picture_t *, int, int );
+    picture_t *p_band;      /* two lines at the output width */
+    int       *pi_column;   /* source column of each luma column */
+    int       *pi_column_c; /* source column of each chroma column */
+};
+
+static int ActivateScaled( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+    const video_format_t *p_in = &p_filter->fmt_in.video;
+    const video_format_t *p_out = &p_filter->fmt_out.video;
+    void (*pf_convert)( picture_t *, picture_t *, int, int );
+
+#if CPU_CAPABILITY
+    if( !(vlc_CPU() & CPU_CAPABILITY) )
+        return VLC_EGENERIC;
+#endif
+    if( (p_in->i_width & 1) || (p_in->i_height & 1)
+     || (p_out->i_width & 1) || (p_out->i_height & 1) )
+        return VLC_EGENERIC;
+
+    /* Activate() handles the pictures of the same size */
+    if( p_in->i_width == p_out->i_width && p_in->i_height == p_out->i_height )
+        return VLC_EGENERIC;
+
+    if( p_in->i_chroma != VLC_CODEC_I420 && p_in->i_chroma != VLC_CODEC_YV12 )
+        return VLC_EGENERIC;
+
+    switch( p_out->i_chroma )
+    {
+        case VLC_CODEC_YUYV:
+            pf_convert = I420_YUY2;
+            break;
+        case VLC_CODEC_YVYU:
+            pf_convert = I420_YVYU;
+            break;
+        case VLC_CODEC_UYVY:
+            pf_convert = I420_UYVY;
+            break;
+#if defined (MODULE_NAME_IS_i420_yuy2)
+        case VLC_CODEC_Y211:
+            pf_convert = I420_Y211;
+            break;
+#endif
+        default:
+            return VLC_EGENERIC;
+    }
+
+    filter_sys_t *p_sys = malloc( sizeof(*p_sys) );
+    if( !p_sys )
+        return VLC_ENOMEM;
+
+    video_format_t band;
+    video_format_Init( &band, p_in->i_chroma );
+    band.i_width  = band.i_visible_width  = p_out->i_width;
+    band.i_height = band.i_visible_height = 2;
+
+    p_sys->pf_convert = pf_convert;
+    p_sys->p_band = picture_NewFromFormat( &band );
+    p_sys->pi_column = malloc( (p_out->i_width + p_out->i_width / 2)
+                               * sizeof(*p_sys->pi_column) );
+    if( !p_sys->p_band || !p_sys->pi_column )
+    {
+        if( p_sys->p_band )
+            picture_Release( p_sys->p_band );
+        free( p_sys->pi_column );
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+    p_sys->pi_column_c = &p_sys->pi_column[p_out->i_width];
+
+    for( unsigned x = 0; x < p_out->i_width; x++ )
+        p_sys->pi_column[x] = x * p_in->i_width / p_out->i_width;
+    for( unsigned x = 0; x < p_out->i_width / 2; x++ )
+        p_sys->pi_column_c[x] = x * p_in->i_width / p_out->i_width;
+
+    p_filter->p_sys = p_sys;
+    p_filter->pf_video_filter = I420_Scaled_Filter;
+    return VLC_SUCCESS;
+}
+
+static void DeactivateScaled( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    picture_Release( p_sys->p_band );
+    free( p_sys->pi_column );
+    free( p_sys );
+}
+
 #if 0
 static inline unsigned long long read_cycles(void)
 {
@@ -190,23 +306,98 @@ static inline unsigned long long read_cycles(void)
 
 /* Following functions are local */
 
-VIDEO_FILTER_WRAPPER( I420_YUY2 )
-VIDEO_FILTER_WRAPPER( I420_YVYU )
-VIDEO_FILTER_WRAPPER( I420_UYVY )
+/* Same as VIDEO_FILTER_WRAPPER, for the conversions taking their size as
+ * parameters, so that the scaled filter can run them on bands of lines */
+#define I420_FILTER_WRAPPER( name )                                     \
+    static picture_t *name ## _Filter ( filter_t *p_filter,             \
+                                        picture_t *p_pic )              \
+    {                                                                   \
+        picture_t *p_outpic = filter_NewPicture( p_filter );            \
+        if( p_outpic )                                                  \
+        {                                                               \
+            name( p_pic, p_outpic, p_filter->fmt_in.video.i_width,      \
+                  p_filter->fmt_in.video.i_height );                    \
+            picture_CopyProperties( p_outpic, p_pic );                  \
+        }                                                               \
+        picture_Release( p_pic );                                       \
+        return p_outpic;                                                \
+    }
+
+I420_FILTER_WRAPPER( I420_YUY2 )
+I420_FILTER_WRAPPER( I420_YVYU )
+I420_FILTER_WRAPPER( I420_UYVY )
 #if !defined (MODULE_NAME_IS_i420_yuy2_altivec)
 VIDEO_FILTER_WRAPPER( I420_IUYV )
 VIDEO_FILTER_WRAPPER( I420_cyuv )
 #endif
 #if defined (MODULE_NAME_IS_i420_yuy2)
-VIDEO_FILTER_WRAPPER( I420_Y211 )
+I420_FILTER_WRAPPER( I420_Y211 )
 #endif
 
+static void ScaleLine( uint8_t *p_dst, const uint8_t *p_src,
+                       const int *pi_column, int i_count )
+{
+    for( int x = 0; x < i_count; x++ )
+        p_dst[x] = p_src[pi_column[x]];
+}
+
+static picture_t *I420_Scaled_Filter( filter_t *p_filter, picture_t *p_pic )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const int i_height_in = p_filter->fmt_in.video.i_height;
+    const int i_width = p_filter->fmt_out.video.i_width;
+    const int i_height = p_filter->fmt_out.video.i_height;
+
+    picture_t *p_outpic = filter_NewPicture( p_filter );
+    if( !p_outpic )
+    {
+        picture_Release( p_pic );
+        return NULL;
+    }
+
+    picture_t *p_band = p_sys->p_band;
+    const plane_t *p_y = &p_pic->p[Y_PLANE];
+    const plane_t *p_u = &p_pic->p[U_PLANE];
+    const plane_t *p_v = &p_pic->p[V_PLANE];
+    uint8_t *p_band_y = p_band->p[Y_PLANE].p_pixels;
+
+    /* The conversion only looks at the planes of the destination */
+    picture_t dest = *p_outpic;
+
+    for( int y = 0; y < i_height; y += 2 )
+    {
+        const int i_src_y1 = y * i_height_in / i_height;
+        const int i_src_y2 = (y + 1) * i_height_in / i_height;
+        /* Both lines share a chroma line, as in the unscaled conversion */
+        const int i_src_c = (y / 2) * i_height_in / i_height;
+
+        ScaleLine( p_band_y, &p_y->p_pixels[i_src_y1 * p_y->i_pitch],
+                   p_sys->pi_column, i_width );
+        ScaleLine( p_band_y + p_band->p[Y_PLANE].i_pitch,
+                   &p_y->p_pixels[i_src_y2 * p_y->i_pitch],
+                   p_sys->pi_column, i_width );
+        ScaleLine( p_band->p[U_PLANE].p_pixels,
+                   &p_u->p_pixels[i_src_c * p_u->i_pitch],
+                   p_sys->pi_column_c, i_width / 2 );
+        ScaleLine( p_band->p[V_PLANE].p_pixels,
+                   &p_v->p_pixels[i_src_c * p_v->i_pitch],
+                   p_sys->pi_column_c, i_width / 2 );
+
+        dest.p->p_pixels = &p_outpic->p->p_pixels[y * p_outpic->p->i_pitch];
+        p_sys->pf_convert( p_band, &dest, i_width, 2 );
+    }
+
+    picture_CopyProperties( p_outpic, p_pic );
+    picture_Release( p_pic );
+    return p_outpic;
+}
+
 /*****************************************************************************
  * I420_YUY2: planar YUV 4:2:0 to packed YUYV 4:2:2
  *****************************************************************************/
 VLC_TARGET
-static void I420_YUY2( filter_t *p_filter, picture_t *p_source,
-                                           picture_t *p_dest )
+static void I420_YUY2( picture_t *p_source, picture_t *p_dest,
+                       int i_width, int i_height )
 {
     uint8_t *p_line1, *p_line2 = p_dest->p->p_pixels;
     uint8_t *p_y1, *p_y2 = p_source->Y_PIXELS;
@@ -240,14 +431,14 @@ static void I420_YUY2( filter_t *p_filter, picture_t *p_source,
     vector unsigned char uv_vec;
     vector unsigned char y_vec;
 
-    if( !( ( p_filter->fmt_in.video.i_width % 32 ) |
-           ( p_filter->fmt_in.video.i_height % 2 ) ) )
+    if( !( ( i_width % 32 ) |
+           ( i_height % 2 ) ) )
     {
         /* Width is a multiple of 32, we take 2 lines at a time */
-        for( i_y = p_filter->fmt_in.video.i_height / 2 ; i_y-- ; )
+        for( i_y = i_height / 2 ; i_y-- ; )
         {
             VEC_NEXT_LINES( );
-            for( i_x = p_filter->fmt_in.video.i_width / 32 ; i_x-- ; )
+            for( i_x = i_width / 32 ; i_x-- ; )
             {
                 VEC_LOAD_UV( );
                 VEC_MERGE( vec_mergeh );
@@ -257,15 +448,15 @@ static void I420_YUY2( filter_t *p_filter, picture_t *p_source,
     }
 #warning FIXME: converting widths % 16 but !widths % 32 is broken on altivec
 #if 0
-    else if( !( ( p_filter->fmt_in.video.i_width % 16 ) |
-                ( p_filter->fmt_in.video.i_height % 4 ) ) )
+    else if( !( ( i_width % 16 ) |
+                ( i_height % 4 ) ) )
     {
         /* Width is only a multiple of 16, we take 4 lines at a time */
-        for( i_y = p_filter->fmt_in.video.i_height / 4 ; i_y-- ; )
+        for( i_y = i_height / 4 ; i_y-- ; )
         {
             /* Line 1 and 2, pixels 0 to ( width - 16 ) */
             VEC_NEXT_LINES( );
-            for( i_x = p_filter->fmt_in.video.i_width / 32 ; i_x-- ; )
+            for( i_x = i_width / 32 ; i_x-- ; )
             {
                 VEC_LOAD_UV( );
                 VEC_MERGE( vec_mergeh );
@@ -281,7 +472,7 @@ static void I420_YUY2( filter_t *p_filter, picture_t *p_source,
             VEC_MERGE( vec_mergel );
 
             /* Line 3 and 4, pixels 16 to ( width ) */
-            for( i_x = p_filter->fmt_in.video.i_width / 32 ; i_x-- ; )
+            for( i_x = i_width / 32 ; i_x-- ; )
             {
                 VEC_LOAD_UV( );
                 VEC_MERGE( vec_mergeh );
@@ -306,7 +497,7 @@ static void I420_YUY2( filter_t *p_filter, picture_t *p_source,
                                - p_dest->p->i_visible_pitch;
 
 #if !defined(MODULE_NAME_IS_i420_yuy2_sse2)
-    for( i_y = p_filter->fmt_in.video.i_height / 2 ; i_y-- ; )
+    for( i_y = i_height / 2 ; i_y-- ; )
     {
         p_line1 = p_line2;
         p_line2 += p_dest->p->i_pitch;
@@ -315,7 +506,7 @@ static void I420_YUY2( filter_t *p_filter, picture_t *p_source,
         p_y2 += p_source->p[Y_PLANE].i_pitch;
 
 #if !defined (MODULE_NAME_IS_i420_yuy2_mmx)
-        for( i_x = p_filter->fmt_in.video.i_width / 8; i_x-- ; )
+        for( i_x = i_width / 8; i_x-- ; )
         {
             C_YUV420_YUYV( );
             C_YUV420_YUYV( );
@@ -323,12 +514,12 @@ static void I420_YUY2( filter_t *p_filter, picture_t *p_source,
             C_YUV420_YUYV( );
         }
 #else
-        for( i_x = p_filter->fmt_in.video.i_width / 8 ; i_x-- ; )
+        for( i_x = i_width / 8 ; i_x-- ; )
         {
             MMX_CALL( MMX_YUV420_YUYV );
         }
 #endif
-        for( i_x = ( p_filter->fmt_in.video.i_width % 8 ) / 2; i_x-- ; )
+        for( i_x = ( i_width % 8 ) / 2; i_x-- ; )
         {
             C_YUV420_YUYV( );
         }
@@ -360,7 +551,7 @@ static void I420_YUY2( filter_t *p_filter, picture_t *p_source,
         ((intptr_t)p_line2|(intptr_t)p_y2))) )
     {
         /* use faster SSE2 aligned fetch and store */
-        for( i_y = p_filter->fmt_in.video.i_height / 2 ; i_y-- ; )
+        for( i_y = i_height / 2 ; i_y-- ; )
         {
             p_line1 = p_line2;
             p_line2 += p_dest->p->i_pitch;
@@ -368,11 +559,11 @@ static void I420_YUY2( filter_t *p_filter, picture_t *p_source,
             p_y1 = p_y2;
             p_y2 += p_source->p[Y_PLANE].i_pitch;
 
-            for( i_x = p_filter->fmt_in.video.i_width / 16 ; i_x-- ; )
+            for( i_x = i_width / 16 ; i_x-- ; )
             {
                 SSE2_CALL( SSE2_YUV420_YUYV_ALIGNED );
             }
-            for( i_x = ( p_filter->fmt_in.video.i_width % 16 ) / 2; i_x-- ; )
+            for( i_x = ( i_width % 16 ) / 2; i_x-- ; )
             {
                 C_YUV420_YUYV( );
             }
@@ -388,7 +579,7 @@ static void I420_YUY2( filter_t *p_filter, picture_t *p_source,
     else
     {
         /* use slower SSE2 unaligned fetch and store */
-        for( i_y = p_filter->fmt_in.video.i_height / 2 ; i_y-- ; )
+        for( i_y = i_height / 2 ; i_y-- ; )
         {
             p_line1 = p_line2;
             p_line2 += p_dest->p->i_pitch;
@@ -396,11 +587,11 @@ static void I420_YUY2( filter_t *p_filter, picture_t *p_source,
             p_y1 = p_y2;
             p_y2 += p_source->p[Y_PLANE].i_pitch;
 
-            for( i_x = p_filter->fmt_in.video.i_width / 16 ; i_x-- ; )
+            for( i_x = i_width / 16 ; i_x-- ; )
             {
                 SSE2_CALL( SSE2_YUV420_YUYV_UNALIGNED );
             }
-            for( i_x = ( p_filter->fmt_in.video.i_width % 16 ) / 2; i_x-- ; )
+            for( i_x = ( i_width % 16 ) / 2; i_x-- ; )
             {
                 C_YUV420_YUYV( );
             }
@@ -423,8 +614,8 @@ static void I420_YUY2( filter_t *p_filter, picture_t *p_source,
  * I420_YVYU: planar YUV 4:2:0 to packed YVYU 4:2:2
  *****************************************************************************/
 VLC_TARGET
-static void I420_YVYU( filter_t *p_filter, picture_t *p_source,
-                                           picture_t *p_dest )
+static void I420_YVYU( picture_t *p_source, picture_t *p_dest,
+                       int i_width, int i_height )
 {
     uint8_t *p_line1, *p_line2 = p_dest->p->p_pixels;
     uint8_t *p_y1, *p_y2 = p_source->Y_PIXELS;
@@ -458,14 +649,14 @@ static void I420_YVYU( filter_t *p_filter, picture_t *p_source,
     vector unsigned char vu_vec;
     vector unsigned char y_vec;
 
-    if( !( ( p_filter->fmt_in.video.i_width % 32 ) |
-           ( p_filter->fmt_in.video.i_height % 2 ) ) )
+    if( !( ( i_width % 32 ) |
+           ( i_height % 2 ) ) )
     {
         /* Width is a multiple of 32, we take 2 lines at a time */
-        for( i_y = p_filter->fmt_in.video.i_height / 2 ; i_y-- ; )
+        for( i_y = i_height / 2 ; i_y-- ; )
         {
             VEC_NEXT_LINES( );
-            for( i_x = p_filter->fmt_in.video.i_width / 32 ; i_x-- ; )
+            for( i_x = i_width / 32 ; i_x-- ; )
             {
                 VEC_LOAD_UV( );
                 VEC_MERGE( vec_mergeh );
@@ -473,15 +664,15 @@ static void I420_YVYU( filter_t *p_filter, picture_t *p_source,
             }
         }
     }
-    else if( !( ( p_filter->fmt_in.video.i_width % 16 ) |
-                ( p_filter->fmt_in.video.i_height % 4 ) ) )
+    else if( !( ( i_width % 16 ) |
+                ( i_height % 4 ) ) )
     {
         /* Width is only a multiple of 16, we take 4 lines at a time */
-        for( i_y = p_filter->fmt_in.video.i_height / 4 ; i_y-- ; )
+        for( i_y = i_height / 4 ; i_y-- ; )
         {
             /* Line 1 and 2, pixels 0 to ( width - 16 ) */
             VEC_NEXT_LINES( );
-            for( i_x = p_filter->fmt_in.video.i_width / 32 ; i_x-- ; )
+            for( i_x = i_width / 32 ; i_x-- ; )
             {
                 VEC_LOAD_UV( );
                 VEC_MERGE( vec_mergeh );
@@ -497,7 +688,7 @@ static void I420_YVYU( filter_t *p_filter, picture_t *p_source,
             VEC_MERGE( vec_mergel );
 
             /* Line 3 and 4, pixels 16 to ( width ) */
-            for( i_x = p_filter->fmt_in.video.i_width / 32 ; i_x-- ; )
+            for( i_x = i_width / 32 ; i_x-- ; )
             {
                 VEC_LOAD_UV( );
                 VEC_MERGE( vec_mergeh );
@@ -521,7 +712,7 @@ static void I420_YVYU( filter_t *p_filter, picture_t *p_source,
                                - p_dest->p->i_visible_pitch;
 
 #if !defined(MODULE_NAME_IS_i420_yuy2_sse2)
-    for( i_y = p_filter->fmt_in.video.i_height / 2 ; i_y-- ; )
+    for( i_y = i_height / 2 ; i_y-- ; )
     {
         p_line1 = p_line2;
         p_line2 += p_dest->p->i_pitch;
@@ -529,7 +720,7 @@ static void I420_YVYU( filter_t *p_filter, picture_t *p_source,
         p_y1 = p_y2;
         p_y2 += p_source->p[Y_PLANE].i_pitch;
 
-        for( i_x = p_filter->fmt_in.video.i_width / 8 ; i_x-- ; )
+        for( i_x = i_width / 8 ; i_x-- ; )
         {
 #if !defined (MODULE_NAME_IS_i420_yuy2_mmx)
             C_YUV420_YVYU( );
@@ -540,7 +731,7 @@ static void I420_YVYU( filter_t *p_filter, picture_t *p_source,
             MMX_CALL( MMX_YUV420_YVYU );
 #endif
         }
-        for( i_x = ( p_filter->fmt_in.video.i_width % 8 ) / 2; i_x-- ; )
+        for( i_x = ( i_width % 8 ) / 2; i_x-- ; )
         {
             C_YUV420_YVYU( );
         }
@@ -571,7 +762,7 @@ static void I420_YVYU( filter_t *p_filter, picture_t *p_source,
         ((intptr_t)p_line2|(intptr_t)p_y2))) )
     {
         /* use faster SSE2 aligned fetch and store */
-        for( i_y = p_filter->fmt_in.video.i_height / 2 ; i_y-- ; )
+        for( i_y = i_height / 2 ; i_y-- ; )
         {
             p_line1 = p_line2;
             p_line2 += p_dest->p->i_pitch;
@@ -579,11 +770,11 @@ static void I420_YVYU( filter_t *p_filter, picture_t *p_source,
             p_y1 = p_y2;
             p_y2 += p_source->p[Y_PLANE].i_pitch;
 
-            for( i_x = p_filter->fmt_in.video.i_width / 16 ; i_x-- ; )
+            for( i_x = i_width / 16 ; i_x-- ; )
             {
                 SSE2_CALL( SSE2_YUV420_YVYU_ALIGNED );
             }
-            for( i_x = ( p_filter->fmt_in.video.i_width % 16 ) / 2; i_x-- ; )
+            for( i_x = ( i_width % 16 ) / 2; i_x-- ; )
             {
                 C_YUV420_YVYU( );
             }
@@ -599,7 +790,7 @@ static void I420_YVYU( filter_t *p_filter, picture_t *p_source,
     else
     {
         /* use slower SSE2 unaligned fetch and store */
-        for( i_y = p_filter->fmt_in.video.i_height / 2 ; i_y-- ; )
+        for( i_y = i_height / 2 ; i_y-- ; )
         {
             p_line1 = p_line2;
             p_line2 += p_dest->p->i_pitch;
@@ -607,11 +798,11 @@ static void I420_YVYU( filter_t *p_filter, picture_t *p_source,
             p_y1 = p_y2;
             p_y2 += p_source->p[Y_PLANE].i_pitch;
 
-            for( i_x = p_filter->fmt_in.video.i_width / 16 ; i_x-- ; )
+            for( i_x = i_width / 16 ; i_x-- ; )
             {
                 SSE2_CALL( SSE2_YUV420_YVYU_UNALIGNED );
             }
-            for( i_x = ( p_filter->fmt_in.video.i_width % 16 ) / 2; i_x-- ; )
+            for( i_x = ( i_width % 16 ) / 2; i_x-- ; )
             {
                 C_YUV420_YVYU( );
             }
@@ -633,8 +824,8 @@ static void I420_YVYU( filter_t *p_filter, picture_t *p_source,
  * I420_UYVY: planar YUV 4:2:0 to packed UYVY 4:2:2
  *****************************************************************************/
 VLC_TARGET
-static void I420_UYVY( filter_t *p_filter, picture_t *p_source,
-                                           picture_t *p_dest )
+static void I420_UYVY( picture_t *p_source, picture_t *p_dest,
+                       int i_width, int i_height )
 {
     uint8_t *p_line1, *p_line2 = p_dest->p->p_pixels;
     uint8_t *p_y1, *p_y2 = p_source->Y_PIXELS;
@@ -668,14 +859,14 @@ static void I420_UYVY( filter_t *p_filter, picture_t *p_source,
     vector unsigned char uv_vec;
     vector unsigned char y_vec;
 
-    if( !( ( p_filter->fmt_in.video.i_width % 32 ) |
-           ( p_filter->fmt_in.video.i_height % 2 ) ) )
+    if( !( ( i_width % 32 ) |
+           ( i_height % 2 ) ) )
     {
         /* Width is a multiple of 32, we take 2 lines at a time */
-        for( i_y = p_filter->fmt_in.video.i_height / 2 ; i_y-- ; )
+        for( i_y = i_height / 2 ; i_y-- ; )
         {
             VEC_NEXT_LINES( );
-            for( i_x = p_filter->fmt_in.video.i_width / 32 ; i_x-- ; )
+            for( i_x = i_width / 32 ; i_x-- ; )
             {
                 VEC_LOAD_UV( );
                 VEC_MERGE( vec_mergeh );
@@ -683,15 +874,15 @@ static void I420_UYVY( filter_t *p_filter, picture_t *p_source,
             }
         }
     }
-    else if( !( ( p_filter->fmt_in.video.i_width % 16 ) |
-                ( p_filter->fmt_in.video.i_height % 4 ) ) )
+    else if( !( ( i_width % 16 ) |
+                ( i_height % 4 ) ) )
     {
         /* Width is only a multiple of 16, we take 4 lines at a time */
-        for( i_y = p_filter->fmt_in.video.i_height / 4 ; i_y-- ; )
+        for( i_y = i_height / 4 ; i_y-- ; )
         {
             /* Line 1 and 2, pixels 0 to ( width - 16 ) */
             VEC_NEXT_LINES( );
-            for( i_x = p_filter->fmt_in.video.i_width / 32 ; i_x-- ; )
+            for( i_x = i_width / 32 ; i_x-- ; )
             {
                 VEC_LOAD_UV( );
                 VEC_MERGE( vec_mergeh );
@@ -707,7 +898,7 @@ static void I420_UYVY( filter_t *p_filter, picture_t *p_source,
             VEC_MERGE( vec_mergel );
 
             /* Line 3 and 4, pixels 16 to ( width ) */
-            for( i_x = p_filter->fmt_in.video.i_width / 32 ; i_x-- ; )
+            for( i_x = i_width / 32 ; i_x-- ; )
             {
                 VEC_LOAD_UV( );
                 VEC_MERGE( vec_mergeh );
@@ -731,7 +922,7 @@ static void I420_UYVY( filter_t *p_filter, picture_t *p_source,
                                - p_dest->p->i_visible_pitch;
 
 #if !defined(MODULE_NAME_IS_i420_yuy2_sse2)
-    for( i_y = p_filter->fmt_in.video.i_height / 2 ; i_y-- ; )
+    for( i_y = i_height / 2 ; i_y-- ; )
     {
         p_line1 = p_line2;
         p_line2 += p_dest->p->i_pitch;
@@ -739,7 +930,7 @@ static void I420_UYVY( filter_t *p_filter, picture_t *p_source,
         p_y1 = p_y2;
         p_y2 += p_source->p[Y_PLANE].i_pitch;
 
-        for( i_x = p_filter->fmt_in.video.i_width / 8 ; i_x-- ; )
+        for( i_x = i_width / 8 ; i_x-- ; )
         {
 #if !defined (MODULE_NAME_IS_i420_yuy2_mmx)
             C_YUV420_UYVY( );
@@ -750,7 +941,7 @@ static void I420_UYVY( filter_t *p_filter, picture_t *p_source,
             MMX_CALL( MMX_YUV420_UYVY );
 #endif
         }
-        for( i_x = ( p_filter->fmt_in.video.i_width % 8 ) / 2; i_x--; )
+        for( i_x = ( i_width % 8 ) / 2; i_x--; )
         {
             C_YUV420_UYVY( );
         }
@@ -781,7 +972,7 @@ static void I420_UYVY( filter_t *p_filter, picture_t *p_source,
         ((intptr_t)p_line2|(intptr_t)p_y2))) )
     {
         /* use faster SSE2 aligned fetch and store */
-        for( i_y = p_filter->fmt_in.video.i_height / 2 ; i_y-- ; )
+        for( i_y = i_height / 2 ; i_y-- ; )
         {
             p_line1 = p_line2;
             p_line2 += p_dest->p->i_pitch;
@@ -789,11 +980,11 @@ static void I420_UYVY( filter_t *p_filter, picture_t *p_source,
             p_y1 = p_y2;
             p_y2 += p_source->p[Y_PLANE].i_pitch;
 
-            for( i_x = p_filter->fmt_in.video.i_width / 16 ; i_x-- ; )
+            for( i_x = i_width / 16 ; i_x-- ; )
             {
                 SSE2_CALL( SSE2_YUV420_UYVY_ALIGNED );
             }
-            for( i_x = ( p_filter->fmt_in.video.i_width % 16 ) / 2; i_x-- ; )
+            for( i_x = ( i_width % 16 ) / 2; i_x-- ; )
             {
                 C_YUV420_UYVY( );
             }
@@ -809,7 +1000,7 @@ static void I420_UYVY( filter_t *p_filter, picture_t *p_source,
     else
     {
         /* use slower SSE2 unaligned fetch and store */
-        for( i_y = p_filter->fmt_in.video.i_height / 2 ; i_y-- ; )
+        for( i_y = i_height / 2 ; i_y-- ; )
         {
             p_line1 = p_line2;
             p_line2 += p_dest->p->i_pitch;
@@ -817,11 +1008,11 @@ static void I420_UYVY( filter_t *p_filter, picture_t *p_source,
             p_y1 = p_y2;
             p_y2 += p_source->p[Y_PLANE].i_pitch;
 
-            for( i_x = p_filter->fmt_in.video.i_width / 16 ; i_x-- ; )
+            for( i_x = i_width / 16 ; i_x-- ; )
             {
                 SSE2_CALL( SSE2_YUV420_UYVY_UNALIGNED );
             }
-            for( i_x = ( p_filter->fmt_in.video.i_width % 16 ) / 2; i_x-- ; )
+            for( i_x = ( i_width % 16 ) / 2; i_x-- ; )
             {
                 C_YUV420_UYVY( );
             }
@@ -986,8 +1177,8 @@ static void I420_cyuv( filter_t *p_filter, picture_t *p_source,
  * I420_Y211: planar YUV 4:2:0 to packed YUYV 2:1:1
  *****************************************************************************/
 #if defined (MODULE_NAME_IS_i420_yuy2)
-static void I420_Y211( filter_t *p_filter, picture_t *p_source,
-                                           picture_t *p_dest )
+static void I420_Y211( picture_t *p_source, picture_t *p_dest,
+                       int i_width, int i_height )
 {
     uint8_t *p_line1, *p_line2 = p_dest->p->p_pixels;
     uint8_t *p_y1, *p_y2 = p_source->Y_PIXELS;
@@ -1003,7 +1194,7 @@ static void I420_Y211( filter_t *p_filter, picture_t *p_source,
     const int i_dest_margin = p_dest->p->i_pitch
                                - p_dest->p->i_visible_pitch;
 
-    for( i_y = p_filter->fmt_in.video.i_height / 2 ; i_y-- ; )
+    for( i_y = i_height / 2 ; i_y-- ; )
     {
         p_line1 = p_line2;
         p_line2 += p_dest->p->i_pitch;
@@ -1011,7 +1202,7 @@ static void I420_Y211( filter_t *p_filter, picture_t *p_source,
         p_y1 = p_y2;
         p_y2 += p_source->p[Y_PLANE].i_pitch;
 
-        for( i_x = p_filter->fmt_in.video.i_width / 8 ; i_x-- ; )
+        for( i_x = i_width / 8 ; i_x-- ; )
         {
             C_YUV420_Y211( );
             C_YUV420_Y211( );
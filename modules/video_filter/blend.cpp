@@ -32,8 +32,18 @@
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_filter.h>
+#include <vlc_cpu.h>
 #include "filter_picture.h"
 
+#if defined(CAN_COMPILE_AVX2)
+#   include <immintrin.h>
+#elif defined(HAVE_SSE2_INTRINSICS)
+#   include <emmintrin.h>
+#endif
+#if defined(__ARM_NEON__)
+#   include <arm_neon.h>
+#endif
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -79,6 +89,18 @@ public:
     {
         return fmt;
     }
+    const picture_t *getPicture() const
+    {
+        return picture;
+    }
+    unsigned getX() const
+    {
+        return x;
+    }
+    unsigned getY() const
+    {
+        return y;
+    }
     bool isFull(unsigned) const
     {
         return true;
@@ -523,6 +545,522 @@ void Blend(const CPicture &dst_data, const CPicture &src_data,
 typedef void (*blend_function_t)(const CPicture &dst_data, const CPicture &src_data,
                                  unsigned width, unsigned height, int alpha);
 
+/* Vectorized blending of YUVA/RGBA onto 8 bits planar, semi-planar and
+ * 32 bits RGB pictures.
+ *
+ * The kernels work on 16 bits lanes and give exactly the same results as
+ * Blend() above: with an 8 bits alpha, all the intermediate values of
+ * div255() fit in 16 bits.
+ *
+ * A kernel class provides, for count output samples:
+ *  - full():        dst[i] with src[i] and srca[i],
+ *  - half():        dst[i] with src[2*i] and srca[2*i] (subsampled chroma),
+ *  - interleaved(): dst[2*i] with srcu[2*i], dst[2*i+1] with srcv[2*i] and
+ *                   srca[2*i] (semi-planar chroma),
+ *  - rgba():        RGBA pixels onto RGB32 pixels using the 3 first bytes
+ *                   (in reverse order if swap_rb) and keeping the last one.
+ * half() and interleaved() may read one source sample past 2*(count-1).
+ */
+static inline void blendScalar(uint8_t *dst, unsigned src, unsigned srca,
+                               unsigned alpha)
+{
+    merge(dst, src, div255(alpha * srca));
+}
+
+static inline void blendFullScalar(uint8_t *dst, const uint8_t *src,
+                                   const uint8_t *srca,
+                                   unsigned i, unsigned count, unsigned alpha)
+{
+    for (; i < count; i++)
+        blendScalar(&dst[i], src[i], srca[i], alpha);
+}
+
+static inline void blendHalfScalar(uint8_t *dst, const uint8_t *src,
+                                   const uint8_t *srca,
+                                   unsigned i, unsigned count, unsigned alpha)
+{
+    for (; i < count; i++)
+        blendScalar(&dst[i], src[2 * i], srca[2 * i], alpha);
+}
+
+static inline void blendInterleavedScalar(uint8_t *dst, const uint8_t *srcu,
+                                          const uint8_t *srcv,
+                                          const uint8_t *srca,
+                                          unsigned i, unsigned count,
+                                          unsigned alpha)
+{
+    for (; i < count; i++) {
+        blendScalar(&dst[2 * i + 0], srcu[2 * i], srca[2 * i], alpha);
+        blendScalar(&dst[2 * i + 1], srcv[2 * i], srca[2 * i], alpha);
+    }
+}
+
+static inline void blendRgbaScalar(uint8_t *dst, const uint8_t *src,
+                                   unsigned i, unsigned count, unsigned alpha,
+                                   bool swap_rb)
+{
+    for (; i < count; i++) {
+        const uint8_t *s = &src[4 * i];
+        uint8_t *d = &dst[4 * i];
+        blendScalar(&d[swap_rb ? 2 : 0], s[0], s[3], alpha);
+        blendScalar(&d[1],               s[1], s[3], alpha);
+        blendScalar(&d[swap_rb ? 0 : 2], s[2], s[3], alpha);
+    }
+}
+
+#if defined(HAVE_SSE2_INTRINSICS)
+VLC_SSE2
+static inline __m128i div255SSE2(__m128i v)
+{
+    const __m128i one = _mm_set1_epi16(1);
+    return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(v, _mm_srli_epi16(v, 8)),
+                                        one), 8);
+}
+
+/* a is the source alpha, it is first multiplied by the global alpha */
+VLC_SSE2
+static inline __m128i mergeSSE2(__m128i d, __m128i s, __m128i a, __m128i alpha)
+{
+    const __m128i c255 = _mm_set1_epi16(255);
+    a = div255SSE2(_mm_mullo_epi16(a, alpha));
+    return div255SSE2(_mm_add_epi16(_mm_mullo_epi16(d, _mm_sub_epi16(c255, a)),
+                                    _mm_mullo_epi16(s, a)));
+}
+
+struct CBlendSSE2 {
+    VLC_SSE2
+    static void full(uint8_t *dst, const uint8_t *src, const uint8_t *srca,
+                     unsigned count, unsigned alpha)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i va   = _mm_set1_epi16(alpha);
+        unsigned i = 0;
+        for (; i + 16 <= count; i += 16) {
+            __m128i d = _mm_loadu_si128((const __m128i *)&dst[i]);
+            __m128i s = _mm_loadu_si128((const __m128i *)&src[i]);
+            __m128i a = _mm_loadu_si128((const __m128i *)&srca[i]);
+            __m128i lo = mergeSSE2(_mm_unpacklo_epi8(d, zero),
+                                   _mm_unpacklo_epi8(s, zero),
+                                   _mm_unpacklo_epi8(a, zero), va);
+            __m128i hi = mergeSSE2(_mm_unpackhi_epi8(d, zero),
+                                   _mm_unpackhi_epi8(s, zero),
+                                   _mm_unpackhi_epi8(a, zero), va);
+            _mm_storeu_si128((__m128i *)&dst[i], _mm_packus_epi16(lo, hi));
+        }
+        blendFullScalar(dst, src, srca, i, count, alpha);
+    }
+    VLC_SSE2
+    static void half(uint8_t *dst, const uint8_t *src, const uint8_t *srca,
+                     unsigned count, unsigned alpha)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i even = _mm_set1_epi16(0x00ff);
+        const __m128i va   = _mm_set1_epi16(alpha);
+        unsigned i = 0;
+        for (; i + 16 < count; i += 16) {
+            __m128i d = _mm_loadu_si128((const __m128i *)&dst[i]);
+            __m128i s0 = _mm_loadu_si128((const __m128i *)&src[2 * i]);
+            __m128i s1 = _mm_loadu_si128((const __m128i *)&src[2 * i + 16]);
+            __m128i a0 = _mm_loadu_si128((const __m128i *)&srca[2 * i]);
+            __m128i a1 = _mm_loadu_si128((const __m128i *)&srca[2 * i + 16]);
+            __m128i lo = mergeSSE2(_mm_unpacklo_epi8(d, zero),
+                                   _mm_and_si128(s0, even),
+                                   _mm_and_si128(a0, even), va);
+            __m128i hi = mergeSSE2(_mm_unpackhi_epi8(d, zero),
+                                   _mm_and_si128(s1, even),
+                                   _mm_and_si128(a1, even), va);
+            _mm_storeu_si128((__m128i *)&dst[i], _mm_packus_epi16(lo, hi));
+        }
+        blendHalfScalar(dst, src, srca, i, count, alpha);
+    }
+    VLC_SSE2
+    static void interleaved(uint8_t *dst, const uint8_t *srcu,
+                            const uint8_t *srcv, const uint8_t *srca,
+                            unsigned count, unsigned alpha)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i even = _mm_set1_epi16(0x00ff);
+        const __m128i va   = _mm_set1_epi16(alpha);
+        unsigned i = 0;
+        for (; i + 8 < count; i += 8) {
+            __m128i d = _mm_loadu_si128((const __m128i *)&dst[2 * i]);
+            __m128i u = _mm_and_si128(_mm_loadu_si128((const __m128i *)&srcu[2 * i]), even);
+            __m128i v = _mm_and_si128(_mm_loadu_si128((const __m128i *)&srcv[2 * i]), even);
+            __m128i a = _mm_and_si128(_mm_loadu_si128((const __m128i *)&srca[2 * i]), even);
+            __m128i lo = mergeSSE2(_mm_unpacklo_epi8(d, zero),
+                                   _mm_unpacklo_epi16(u, v),
+                                   _mm_unpacklo_epi16(a, a), va);
+            __m128i hi = mergeSSE2(_mm_unpackhi_epi8(d, zero),
+                                   _mm_unpackhi_epi16(u, v),
+                                   _mm_unpackhi_epi16(a, a), va);
+            _mm_storeu_si128((__m128i *)&dst[2 * i], _mm_packus_epi16(lo, hi));
+        }
+        blendInterleavedScalar(dst, srcu, srcv, srca, i, count, alpha);
+    }
+    VLC_SSE2
+    static void rgba(uint8_t *dst, const uint8_t *src,
+                     unsigned count, unsigned alpha, bool swap_rb)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        /* Never modify the 4th destination byte */
+        const __m128i rgb  = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+        const __m128i va   = _mm_set1_epi16(alpha);
+        unsigned i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128i d = _mm_loadu_si128((const __m128i *)&dst[4 * i]);
+            __m128i s = _mm_loadu_si128((const __m128i *)&src[4 * i]);
+            __m128i s_lo = _mm_unpacklo_epi8(s, zero);
+            __m128i s_hi = _mm_unpackhi_epi8(s, zero);
+            __m128i a_lo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s_lo, _MM_SHUFFLE(3,3,3,3)),
+                                               _MM_SHUFFLE(3,3,3,3));
+            __m128i a_hi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s_hi, _MM_SHUFFLE(3,3,3,3)),
+                                               _MM_SHUFFLE(3,3,3,3));
+            if (swap_rb) {
+                s_lo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s_lo, _MM_SHUFFLE(3,0,1,2)),
+                                           _MM_SHUFFLE(3,0,1,2));
+                s_hi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s_hi, _MM_SHUFFLE(3,0,1,2)),
+                                           _MM_SHUFFLE(3,0,1,2));
+            }
+            __m128i lo = mergeSSE2(_mm_unpacklo_epi8(d, zero), s_lo,
+                                   _mm_and_si128(a_lo, rgb), va);
+            __m128i hi = mergeSSE2(_mm_unpackhi_epi8(d, zero), s_hi,
+                                   _mm_and_si128(a_hi, rgb), va);
+            _mm_storeu_si128((__m128i *)&dst[4 * i], _mm_packus_epi16(lo, hi));
+        }
+        blendRgbaScalar(dst, src, i, count, alpha, swap_rb);
+    }
+};
+#endif
+
+#if defined(CAN_COMPILE_AVX2)
+VLC_AVX2
+static inline __m256i div255AVX2(__m256i v)
+{
+    const __m256i one = _mm256_set1_epi16(1);
+    return _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(v, _mm256_srli_epi16(v, 8)),
+                                              one), 8);
+}
+
+VLC_AVX2
+static inline __m256i mergeAVX2(__m256i d, __m256i s, __m256i a, __m256i alpha)
+{
+    const __m256i c255 = _mm256_set1_epi16(255);
+    a = div255AVX2(_mm256_mullo_epi16(a, alpha));
+    return div255AVX2(_mm256_add_epi16(_mm256_mullo_epi16(d, _mm256_sub_epi16(c255, a)),
+                                       _mm256_mullo_epi16(s, a)));
+}
+
+/* Loads 16 bytes into 16 bits lanes */
+VLC_AVX2
+static inline __m256i load16AVX2(const uint8_t *p)
+{
+    return _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)p));
+}
+
+/* Packs 2x16 lanes back into 32 bytes in order */
+VLC_AVX2
+static inline void storeAVX2(uint8_t *p, __m256i lo, __m256i hi)
+{
+    _mm256_storeu_si256((__m256i *)p,
+                        _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi),
+                                                 _MM_SHUFFLE(3,1,2,0)));
+}
+
+struct CBlendAVX2 {
+    VLC_AVX2
+    static void full(uint8_t *dst, const uint8_t *src, const uint8_t *srca,
+                     unsigned count, unsigned alpha)
+    {
+        const __m256i va = _mm256_set1_epi16(alpha);
+        unsigned i = 0;
+        for (; i + 32 <= count; i += 32) {
+            __m256i lo = mergeAVX2(load16AVX2(&dst[i]), load16AVX2(&src[i]),
+                                   load16AVX2(&srca[i]), va);
+            __m256i hi = mergeAVX2(load16AVX2(&dst[i + 16]), load16AVX2(&src[i + 16]),
+                                   load16AVX2(&srca[i + 16]), va);
+            storeAVX2(&dst[i], lo, hi);
+        }
+        blendFullScalar(dst, src, srca, i, count, alpha);
+    }
+    VLC_AVX2
+    static void half(uint8_t *dst, const uint8_t *src, const uint8_t *srca,
+                     unsigned count, unsigned alpha)
+    {
+        const __m256i even = _mm256_set1_epi16(0x00ff);
+        const __m256i va   = _mm256_set1_epi16(alpha);
+        unsigned i = 0;
+        for (; i + 32 < count; i += 32) {
+            __m256i s0 = _mm256_loadu_si256((const __m256i *)&src[2 * i]);
+            __m256i s1 = _mm256_loadu_si256((const __m256i *)&src[2 * i + 32]);
+            __m256i a0 = _mm256_loadu_si256((const __m256i *)&srca[2 * i]);
+            __m256i a1 = _mm256_loadu_si256((const __m256i *)&srca[2 * i + 32]);
+            __m256i lo = mergeAVX2(load16AVX2(&dst[i]),
+                                   _mm256_and_si256(s0, even),
+                                   _mm256_and_si256(a0, even), va);
+            __m256i hi = mergeAVX2(load16AVX2(&dst[i + 16]),
+                                   _mm256_and_si256(s1, even),
+                                   _mm256_and_si256(a1, even), va);
+            storeAVX2(&dst[i], lo, hi);
+        }
+        blendHalfScalar(dst, src, srca, i, count, alpha);
+    }
+    VLC_AVX2
+    static void interleaved(uint8_t *dst, const uint8_t *srcu,
+                            const uint8_t *srcv, const uint8_t *srca,
+                            unsigned count, unsigned alpha)
+    {
+        const __m256i even = _mm256_set1_epi16(0x00ff);
+        const __m256i va   = _mm256_set1_epi16(alpha);
+        unsigned i = 0;
+        for (; i + 16 < count; i += 16) {
+            __m256i u = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)&srcu[2 * i]), even);
+            __m256i v = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)&srcv[2 * i]), even);
+            __m256i a = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)&srca[2 * i]), even);
+            /* The unpacks work inside each 128 bits lane */
+            __m256i uv_lo = _mm256_unpacklo_epi16(u, v);
+            __m256i uv_hi = _mm256_unpackhi_epi16(u, v);
+            __m256i aa_lo = _mm256_unpacklo_epi16(a, a);
+            __m256i aa_hi = _mm256_unpackhi_epi16(a, a);
+            __m256i lo = mergeAVX2(load16AVX2(&dst[2 * i]),
+                                   _mm256_permute2x128_si256(uv_lo, uv_hi, 0x20),
+                                   _mm256_permute2x128_si256(aa_lo, aa_hi, 0x20), va);
+            __m256i hi = mergeAVX2(load16AVX2(&dst[2 * i + 16]),
+                                   _mm256_permute2x128_si256(uv_lo, uv_hi, 0x31),
+                                   _mm256_permute2x128_si256(aa_lo, aa_hi, 0x31), va);
+            storeAVX2(&dst[2 * i], lo, hi);
+        }
+        blendInterleavedScalar(dst, srcu, srcv, srca, i, count, alpha);
+    }
+    VLC_AVX2
+    static void rgba(uint8_t *dst, const uint8_t *src,
+                     unsigned count, unsigned alpha, bool swap_rb)
+    {
+        const __m256i rgb = _mm256_set_epi16(0, -1, -1, -1, 0, -1, -1, -1,
+                                             0, -1, -1, -1, 0, -1, -1, -1);
+        const __m256i va  = _mm256_set1_epi16(alpha);
+        unsigned i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256i r[2];
+            for (int k = 0; k < 2; k++) {
+                __m256i s = load16AVX2(&src[4 * i + 16 * k]);
+                __m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s, _MM_SHUFFLE(3,3,3,3)),
+                                                   _MM_SHUFFLE(3,3,3,3));
+                if (swap_rb)
+                    s = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s, _MM_SHUFFLE(3,0,1,2)),
+                                               _MM_SHUFFLE(3,0,1,2));
+                r[k] = mergeAVX2(load16AVX2(&dst[4 * i + 16 * k]), s,
+                                 _mm256_and_si256(a, rgb), va);
+            }
+            storeAVX2(&dst[4 * i], r[0], r[1]);
+        }
+        blendRgbaScalar(dst, src, i, count, alpha, swap_rb);
+    }
+};
+#endif
+
+#if defined(__ARM_NEON__)
+static inline uint16x8_t div255NEON(uint16x8_t v)
+{
+    return vshrq_n_u16(vaddq_u16(vaddq_u16(v, vshrq_n_u16(v, 8)),
+                                 vdupq_n_u16(1)), 8);
+}
+
+static inline uint8x8_t mergeNEON(uint8x8_t d, uint8x8_t s, uint8x8_t sa,
+                                  uint16x8_t alpha)
+{
+    uint16x8_t a = div255NEON(vmulq_u16(vmovl_u8(sa), alpha));
+    uint16x8_t v = vmulq_u16(vmovl_u8(d), vsubq_u16(vdupq_n_u16(255), a));
+    return vmovn_u16(div255NEON(vmlaq_u16(v, vmovl_u8(s), a)));
+}
+
+struct CBlendNEON {
+    static void full(uint8_t *dst, const uint8_t *src, const uint8_t *srca,
+                     unsigned count, unsigned alpha)
+    {
+        const uint16x8_t va = vdupq_n_u16(alpha);
+        unsigned i = 0;
+        for (; i + 8 <= count; i += 8)
+            vst1_u8(&dst[i], mergeNEON(vld1_u8(&dst[i]), vld1_u8(&src[i]),
+                                       vld1_u8(&srca[i]), va));
+        blendFullScalar(dst, src, srca, i, count, alpha);
+    }
+    static void half(uint8_t *dst, const uint8_t *src, const uint8_t *srca,
+                     unsigned count, unsigned alpha)
+    {
+        const uint16x8_t va = vdupq_n_u16(alpha);
+        unsigned i = 0;
+        for (; i + 8 < count; i += 8)
+            vst1_u8(&dst[i], mergeNEON(vld1_u8(&dst[i]),
+                                       vld2_u8(&src[2 * i]).val[0],
+                                       vld2_u8(&srca[2 * i]).val[0], va));
+        blendHalfScalar(dst, src, srca, i, count, alpha);
+    }
+    static void interleaved(uint8_t *dst, const uint8_t *srcu,
+                            const uint8_t *srcv, const uint8_t *srca,
+                            unsigned count, unsigned alpha)
+    {
+        const uint16x8_t va = vdupq_n_u16(alpha);
+        unsigned i = 0;
+        for (; i + 8 < count; i += 8) {
+            uint8x8x2_t d = vld2_u8(&dst[2 * i]);
+            uint8x8_t   a = vld2_u8(&srca[2 * i]).val[0];
+            d.val[0] = mergeNEON(d.val[0], vld2_u8(&srcu[2 * i]).val[0], a, va);
+            d.val[1] = mergeNEON(d.val[1], vld2_u8(&srcv[2 * i]).val[0], a, va);
+            vst2_u8(&dst[2 * i], d);
+        }
+        blendInterleavedScalar(dst, srcu, srcv, srca, i, count, alpha);
+    }
+    static void rgba(uint8_t *dst, const uint8_t *src,
+                     unsigned count, unsigned alpha, bool swap_rb)
+    {
+        const uint16x8_t va = vdupq_n_u16(alpha);
+        unsigned i = 0;
+        for (; i + 8 <= count; i += 8) {
+            uint8x8x4_t s = vld4_u8(&src[4 * i]);
+            uint8x8x4_t d = vld4_u8(&dst[4 * i]);
+            d.val[swap_rb ? 2 : 0] = mergeNEON(d.val[swap_rb ? 2 : 0], s.val[0], s.val[3], va);
+            d.val[1]               = mergeNEON(d.val[1],               s.val[1], s.val[3], va);
+            d.val[swap_rb ? 0 : 2] = mergeNEON(d.val[swap_rb ? 0 : 2], s.val[2], s.val[3], va);
+            vst4_u8(&dst[4 * i], d);
+        }
+        blendRgbaScalar(dst, src, i, count, alpha, swap_rb);
+    }
+};
+#endif
+
+static inline const uint8_t *getSourceLine(const picture_t *src, unsigned plane,
+                                           unsigned x, unsigned y, unsigned bytes)
+{
+    return &src->p[plane].p_pixels[y * src->p[plane].i_pitch + x * bytes];
+}
+
+/* YUVA onto 8 bits planar YUV, with rx and ry in {1, 2} */
+template <class TKernel, unsigned rx, unsigned ry, bool swap_uv>
+void BlendYUVAToPlanar(const CPicture &dst_data, const CPicture &src_data,
+                       unsigned width, unsigned height, int alpha)
+{
+    const picture_t *dst = dst_data.getPicture();
+    const picture_t *src = src_data.getPicture();
+    const unsigned dx = dst_data.getX();
+    const unsigned dy = dst_data.getY();
+
+    /* The chroma is only blended at the co-sited positions, as done by
+     * CPictureYUVPlanar::isFull() */
+    const unsigned start = dx % rx ? rx - dx % rx : 0;
+    const unsigned count = width > start ? (width - start + rx - 1) / rx : 0;
+
+    for (unsigned y = 0; y < height; y++) {
+        const uint8_t *s[4];
+        for (unsigned plane = 0; plane < 4; plane++)
+            s[plane] = getSourceLine(src, plane, src_data.getX(),
+                                     src_data.getY() + y, 1);
+
+        TKernel::full(&dst->p[0].p_pixels[(dy + y) * dst->p[0].i_pitch + dx],
+                      s[0], s[3], width, alpha);
+        if ((dy + y) % ry || count <= 0)
+            continue;
+
+        for (unsigned plane = 1; plane <= 2; plane++) {
+            const unsigned dplane = swap_uv ? 3 - plane : plane;
+            uint8_t *d = &dst->p[dplane].p_pixels[(dy + y) / ry * dst->p[dplane].i_pitch +
+                                                  (dx + start) / rx];
+            if (rx == 1)
+                TKernel::full(d, s[plane], s[3], count, alpha);
+            else
+                TKernel::half(d, &s[plane][start], &s[3][start], count, alpha);
+        }
+    }
+}
+
+/* YUVA onto NV12/NV21 */
+template <class TKernel, bool swap_uv>
+void BlendYUVAToSemiPlanar(const CPicture &dst_data, const CPicture &src_data,
+                           unsigned width, unsigned height, int alpha)
+{
+    const picture_t *dst = dst_data.getPicture();
+    const picture_t *src = src_data.getPicture();
+    const unsigned dx = dst_data.getX();
+    const unsigned dy = dst_data.getY();
+
+    const unsigned start = dx % 2;
+    const unsigned count = width > start ? (width - start + 1) / 2 : 0;
+
+    for (unsigned y = 0; y < height; y++) {
+        const uint8_t *s[4];
+        for (unsigned plane = 0; plane < 4; plane++)
+            s[plane] = getSourceLine(src, plane, src_data.getX(),
+                                     src_data.getY() + y, 1);
+
+        TKernel::full(&dst->p[0].p_pixels[(dy + y) * dst->p[0].i_pitch + dx],
+                      s[0], s[3], width, alpha);
+        if ((dy + y) % 2 || count <= 0)
+            continue;
+
+        uint8_t *d = &dst->p[1].p_pixels[(dy + y) / 2 * dst->p[1].i_pitch +
+                                         (dx + start) / 2 * 2];
+        TKernel::interleaved(d, &s[swap_uv ? 2 : 1][start],
+                                &s[swap_uv ? 1 : 2][start],
+                                &s[3][start], count, alpha);
+    }
+}
+
+/* RGBA onto RGB32 with the color in the 3 first bytes */
+template <class TKernel, bool swap_rb>
+void BlendRGBAToRGB32(const CPicture &dst_data, const CPicture &src_data,
+                      unsigned width, unsigned height, int alpha)
+{
+    const picture_t *dst = dst_data.getPicture();
+    const picture_t *src = src_data.getPicture();
+
+    for (unsigned y = 0; y < height; y++) {
+        uint8_t *d = &dst->p[0].p_pixels[(dst_data.getY() + y) * dst->p[0].i_pitch +
+                                         dst_data.getX() * 4];
+        TKernel::rgba(d, getSourceLine(src, 0, src_data.getX(),
+                                       src_data.getY() + y, 4),
+                      width, alpha, swap_rb);
+    }
+}
+
+template <class TKernel>
+static blend_function_t GetFastBlend(vlc_fourcc_t dst, vlc_fourcc_t src,
+                                     const video_format_t *dst_fmt)
+{
+    if (src == VLC_CODEC_YUVA) {
+        switch (dst) {
+        case VLC_CODEC_I420:
+        case VLC_CODEC_J420:
+            return BlendYUVAToPlanar<TKernel, 2, 2, false>;
+        case VLC_CODEC_YV12:
+            return BlendYUVAToPlanar<TKernel, 2, 2, true>;
+        case VLC_CODEC_I422:
+        case VLC_CODEC_J422:
+            return BlendYUVAToPlanar<TKernel, 2, 1, false>;
+        case VLC_CODEC_I444:
+        case VLC_CODEC_J444:
+            return BlendYUVAToPlanar<TKernel, 1, 1, false>;
+        case VLC_CODEC_NV12:
+            return BlendYUVAToSemiPlanar<TKernel, false>;
+        case VLC_CODEC_NV21:
+            return BlendYUVAToSemiPlanar<TKernel, true>;
+        }
+    }
+#ifndef WORDS_BIGENDIAN
+    if (src == VLC_CODEC_RGBA && dst == VLC_CODEC_RGB32) {
+        video_format_t fmt = *dst_fmt;
+        video_format_FixRgb(&fmt);
+        if (fmt.i_lgshift == 8) {
+            if (fmt.i_lrshift == 0 && fmt.i_lbshift == 16)
+                return BlendRGBAToRGB32<TKernel, false>;
+            if (fmt.i_lrshift == 16 && fmt.i_lbshift == 0)
+                return BlendRGBAToRGB32<TKernel, true>;
+        }
+    }
+#else
+    VLC_UNUSED(dst_fmt);
+#endif
+    return NULL;
+}
+
 static const struct {
     vlc_fourcc_t     dst;
     vlc_fourcc_t     src;
@@ -633,7 +1171,20 @@ static int Open(vlc_object_t *object)
     const vlc_fourcc_t dst = filter->fmt_out.video.i_chroma;
 
     filter_sys_t *sys = new filter_sys_t();
-    for (size_t i = 0; i < sizeof(blends) / sizeof(*blends); i++) {
+    const video_format_t *dst_fmt = &filter->fmt_out.video;
+#if defined(CAN_COMPILE_AVX2)
+    if (!sys->blend && (vlc_CPU() & CPU_CAPABILITY_AVX2))
+        sys->blend = GetFastBlend<CBlendAVX2>(dst, src, dst_fmt);
+#endif
+#if defined(HAVE_SSE2_INTRINSICS)
+    if (!sys->blend && (vlc_CPU() & CPU_CAPABILITY_SSE2))
+        sys->blend = GetFastBlend<CBlendSSE2>(dst, src, dst_fmt);
+#endif
+#if defined(__ARM_NEON__)
+    if (!sys->blend && (vlc_CPU() & CPU_CAPABILITY_NEON))
+        sys->blend = GetFastBlend<CBlendNEON>(dst, src, dst_fmt);
+#endif
+    for (size_t i = 0; !sys->blend && i < sizeof(blends) / sizeof(*blends); i++) {
         if (blends[i].src == src && blends[i].dst == dst)
             sys->blend = blends[i].blend;
     }
@@ -56,17 +56,24 @@ static picture_t *Filter( filter_t *, picture_t * );
 #define ALPHA_LONGTEXT N_("Alpha with which the blend image is blended")
 
 #define BASE_IMAGE_TEXT N_("Image to be blended onto")
-#define BASE_IMAGE_LONGTEXT N_("The image which will be used to blend onto")
+#define BASE_IMAGE_LONGTEXT N_("The image which will be used to blend onto. " \
+                               "Generated pictures are used if not set.")
 
-#define BASE_CHROMA_TEXT N_("Chroma for the base image")
-#define BASE_CHROMA_LONGTEXT N_("Chroma which the base image will be loaded in")
+#define BASE_CHROMA_TEXT N_("Chromas for the base image")
+#define BASE_CHROMA_LONGTEXT N_("Comma separated list of the chromas in " \
+                                "which the base image will be loaded")
 
 #define BLEND_IMAGE_TEXT N_("Image which will be blended")
-#define BLEND_IMAGE_LONGTEXT N_("The image blended onto the base image")
+#define BLEND_IMAGE_LONGTEXT N_("The image blended onto the base image. " \
+                                "Generated pictures are used if not set.")
 
-#define BLEND_CHROMA_TEXT N_("Chroma for the blend image")
-#define BLEND_CHROMA_LONGTEXT N_("Chroma which the blend image will be loaded" \
-                                 " in")
+#define BLEND_CHROMA_TEXT N_("Chromas for the blend image")
+#define BLEND_CHROMA_LONGTEXT N_("Comma separated list of the chromas in " \
+                                 "which the blend image will be loaded")
+
+#define SIZES_TEXT N_("Sizes of the generated pictures")
+#define SIZES_LONGTEXT N_("Comma separated list of WIDTHxHEIGHT sizes " \
+                          "used when no image is given")
 
 #define CFG_PREFIX "blendbench-"
 
@@ -82,24 +89,26 @@ vlc_module_begin ()
               LOOPS_LONGTEXT, false )
     add_integer_with_range( CFG_PREFIX "alpha", 128, 0, 255, ALPHA_TEXT,
               ALPHA_LONGTEXT, false )
+    add_string( CFG_PREFIX "sizes", "720x576,1920x1080,3840x2160",
+                SIZES_TEXT, SIZES_LONGTEXT, false )
 
     set_section( N_("Base image"), NULL )
     add_loadfile( CFG_PREFIX "base-image", NULL, BASE_IMAGE_TEXT,
                   BASE_IMAGE_LONGTEXT, false )
-    add_string( CFG_PREFIX "base-chroma", "I420", BASE_CHROMA_TEXT,
+    add_string( CFG_PREFIX "base-chroma", "I420,NV12,RV32", BASE_CHROMA_TEXT,
               BASE_CHROMA_LONGTEXT, false )
 
     set_section( N_("Blend image"), NULL )
     add_loadfile( CFG_PREFIX "blend-image", NULL, BLEND_IMAGE_TEXT,
                   BLEND_IMAGE_LONGTEXT, false )
-    add_string( CFG_PREFIX "blend-chroma", "YUVA", BLEND_CHROMA_TEXT,
+    add_string( CFG_PREFIX "blend-chroma", "YUVA,RGBA", BLEND_CHROMA_TEXT,
               BLEND_CHROMA_LONGTEXT, false )
 
     set_callbacks( Create, Destroy )
 vlc_module_end ()
 
 static const char *const ppsz_filter_options[] = {
-    "loops", "alpha", "base-image", "base-chroma", "blend-image",
+    "loops", "alpha", "sizes", "base-image", "base-chroma", "blend-image",
     "blend-chroma", NULL
 };
 
@@ -111,11 +120,11 @@ struct filter_sys_t
     bool b_done;
     int i_loops, i_alpha;
 
-    picture_t *p_base_image;
-    picture_t *p_blend_image;
-
-    vlc_fourcc_t i_base_chroma;
-    vlc_fourcc_t i_blend_chroma;
+    char *psz_sizes;
+    char *psz_base_image;
+    char *psz_base_chroma;
+    char *psz_blend_image;
+    char *psz_blend_chroma;
 };
 
 static int blendbench_LoadImage( vlc_object_t *p_this, picture_t **pp_pic,
@@ -145,6 +154,50 @@ static int blendbench_LoadImage( vlc_object_t *p_this, picture_t **pp_pic,
     return VLC_SUCCESS;
 }
 
+/* Creates a picture filled with a pattern, so that the alpha of the blend
+ * picture covers transparent, opaque and intermediate values */
+static picture_t *blendbench_NewPicture( vlc_fourcc_t i_chroma,
+                                         int i_width, int i_height )
+{
+    picture_t *p_pic = picture_New( i_chroma, i_width, i_height, 1, 1 );
+    if( !p_pic )
+        return NULL;
+
+    for( int i = 0; i < p_pic->i_planes; i++ )
+    {
+        plane_t *p = &p_pic->p[i];
+        for( int y = 0; y < p->i_lines; y++ )
+            for( int x = 0; x < p->i_pitch; x++ )
+                p->p_pixels[y * p->i_pitch + x] = x * 7 + y * 3 + i * 37;
+    }
+    return p_pic;
+}
+
+static picture_t *blendbench_GetPicture( filter_t *p_filter,
+                                         vlc_fourcc_t i_chroma,
+                                         char *psz_file, const char *psz_name,
+                                         int i_width, int i_height )
+{
+    if( psz_file && *psz_file )
+    {
+        picture_t *p_pic;
+        if( blendbench_LoadImage( VLC_OBJECT(p_filter), &p_pic, i_chroma,
+                                  psz_file, psz_name ) )
+            return NULL;
+        return p_pic;
+    }
+    return blendbench_NewPicture( i_chroma, i_width, i_height );
+}
+
+static vlc_fourcc_t blendbench_ParseChroma( const char *psz )
+{
+    char psz_fourcc[4] = { ' ', ' ', ' ', ' ' };
+    for( int i = 0; i < 4 && psz[i]; i++ )
+        psz_fourcc[i] = psz[i];
+    return VLC_FOURCC( psz_fourcc[0], psz_fourcc[1],
+                       psz_fourcc[2], psz_fourcc[3] );
+}
+
 /*****************************************************************************
  * Create: allocates video thread output method
  *****************************************************************************/
@@ -152,8 +205,6 @@ static int Create( vlc_object_t *p_this )
 {
     filter_t *p_filter = (filter_t *)p_this;
     filter_sys_t *p_sys;
-    char *psz_temp, *psz_cmd;
-    int i_ret;
 
     /* Allocate structure */
     p_filter->p_sys = malloc( sizeof( filter_sys_t ) );
@@ -174,30 +225,16 @@ static int Create( vlc_object_t *p_this )
                                                   CFG_PREFIX "loops" );
     p_sys->i_alpha = var_CreateGetIntegerCommand( p_filter,
                                                   CFG_PREFIX "alpha" );
-
-    psz_temp = var_CreateGetStringCommand( p_filter, CFG_PREFIX "base-chroma" );
-    p_sys->i_base_chroma = VLC_FOURCC( psz_temp[0], psz_temp[1],
-                                       psz_temp[2], psz_temp[3] );
-    psz_cmd = var_CreateGetStringCommand( p_filter, CFG_PREFIX "base-image" );
-    i_ret = blendbench_LoadImage( p_this, &p_sys->p_base_image,
-                                  p_sys->i_base_chroma, psz_cmd, "Base" );
-    free( psz_temp );
-    free( psz_cmd );
-    if( i_ret != VLC_SUCCESS )
-    {
-        free( p_sys );
-        return i_ret;
-    }
-
-    psz_temp = var_CreateGetStringCommand( p_filter,
-                                           CFG_PREFIX "blend-chroma" );
-    p_sys->i_blend_chroma = VLC_FOURCC( psz_temp[0], psz_temp[1],
-                                        psz_temp[2], psz_temp[3] );
-    psz_cmd = var_CreateGetStringCommand( p_filter, CFG_PREFIX "blend-image" );
-    blendbench_LoadImage( p_this, &p_sys->p_blend_image, p_sys->i_blend_chroma,
-                          psz_cmd, "Blend" );
-    free( psz_temp );
-    free( psz_cmd );
+    p_sys->psz_sizes = var_CreateGetStringCommand( p_filter,
+                                                   CFG_PREFIX "sizes" );
+    p_sys->psz_base_image = var_CreateGetStringCommand( p_filter,
+                                                CFG_PREFIX "base-image" );
+    p_sys->psz_base_chroma = var_CreateGetStringCommand( p_filter,
+                                                CFG_PREFIX "base-chroma" );
+    p_sys->psz_blend_image = var_CreateGetStringCommand( p_filter,
+                                                CFG_PREFIX "blend-image" );
+    p_sys->psz_blend_chroma = var_CreateGetStringCommand( p_filter,
+                                                CFG_PREFIX "blend-chroma" );
 
     return VLC_SUCCESS;
 }
@@ -210,8 +247,69 @@ static void Destroy( vlc_object_t *p_this )
     filter_t *p_filter = (filter_t *)p_this;
     filter_sys_t *p_sys = p_filter->p_sys;
 
-    picture_Release( p_sys->p_base_image );
-    picture_Release( p_sys->p_blend_image );
+    free( p_sys->psz_sizes );
+    free( p_sys->psz_base_image );
+    free( p_sys->psz_base_chroma );
+    free( p_sys->psz_blend_image );
+    free( p_sys->psz_blend_chroma );
+    free( p_sys );
+}
+
+/*****************************************************************************
+ * Bench: blends a picture onto another one and reports the throughput
+ *****************************************************************************/
+static void Bench( filter_t *p_filter, vlc_fourcc_t i_base_chroma,
+                   vlc_fourcc_t i_blend_chroma, int i_width, int i_height )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    filter_t *p_blend_filter = NULL;
+
+    picture_t *p_base = blendbench_GetPicture( p_filter, i_base_chroma,
+                                               p_sys->psz_base_image, "Base",
+                                               i_width, i_height );
+    picture_t *p_blend = blendbench_GetPicture( p_filter, i_blend_chroma,
+                                                p_sys->psz_blend_image, "Blend",
+                                                i_width, i_height );
+    if( p_base && p_blend )
+        p_blend_filter = filter_NewBlend( VLC_OBJECT(p_filter),
+                                          &p_base->format );
+    if( !p_blend_filter )
+        goto exit;
+
+    /* Warm up, and check that the chromas are supported */
+    if( filter_ConfigureBlend( p_blend_filter, p_base->format.i_width,
+                               p_base->format.i_height, &p_blend->format ) ||
+        filter_Blend( p_blend_filter, p_base, 0, 0, p_blend, p_sys->i_alpha ) )
+    {
+        msg_Warn( p_filter, "%4.4s on %4.4s is not supported",
+                  (const char *)&i_blend_chroma, (const char *)&i_base_chroma );
+        goto exit;
+    }
+
+    mtime_t time = mdate();
+    for( int i_iter = 0; i_iter < p_sys->i_loops; ++i_iter )
+        filter_Blend( p_blend_filter, p_base, 0, 0, p_blend, p_sys->i_alpha );
+    time = __MAX( mdate() - time, 1 );
+
+    const float f_pixels = (float)__MIN( p_base->format.i_visible_width,
+                                         p_blend->format.i_visible_width ) *
+                           __MIN( p_base->format.i_visible_height,
+                                  p_blend->format.i_visible_height );
+    msg_Info( p_filter, "%4.4s on %4.4s %ux%u: %f images/second, "
+              "%f Mpixels/second", (const char *)&i_blend_chroma,
+              (const char *)&i_base_chroma,
+              p_blend->format.i_visible_width,
+              p_blend->format.i_visible_height,
+              (float) p_sys->i_loops / time * 1000000,
+              (float) p_sys->i_loops / time * f_pixels );
+
+exit:
+    if( p_blend_filter )
+        filter_DeleteBlend( p_blend_filter );
+    if( p_base )
+        picture_Release( p_base );
+    if( p_blend )
+        picture_Release( p_blend );
 }
 
 /*****************************************************************************
@@ -220,48 +318,48 @@ static void Destroy( vlc_object_t *p_this )
 static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
-    filter_t *p_blend;
 
     if( p_sys->b_done )
         return p_pic;
+    p_sys->b_done = true;
 
-    p_blend = vlc_object_create( p_filter, sizeof(filter_t) );
-    if( !p_blend )
-    {
-        picture_Release( p_pic );
-        return NULL;
-    }
-    p_blend->fmt_out.video = p_sys->p_base_image->format;
-    p_blend->fmt_in.video = p_sys->p_blend_image->format;
-    p_blend->p_module = module_need( p_blend, "video blending", NULL, false );
-    if( !p_blend->p_module )
-    {
-        picture_Release( p_pic );
-        vlc_object_release( p_blend );
-        return NULL;
-    }
+    /* Images are loaded at their own size, so they need a single run */
+    const bool b_images = p_sys->psz_base_image && *p_sys->psz_base_image &&
+                          p_sys->psz_blend_image && *p_sys->psz_blend_image;
+    char *psz_sizes = strdup( b_images ? "0x0" : p_sys->psz_sizes );
+    if( !psz_sizes )
+        return p_pic;
 
-    mtime_t time = mdate();
-    for( int i_iter = 0; i_iter < p_sys->i_loops; ++i_iter )
+    char *psz_size_save;
+    for( char *psz_size = strtok_r( psz_sizes, ",", &psz_size_save );
+         psz_size; psz_size = strtok_r( NULL, ",", &psz_size_save ) )
     {
-        p_blend->pf_video_blend( p_blend,
-                                 p_sys->p_base_image, p_sys->p_blend_image,
-                                 0, 0, p_sys->i_alpha );
+        int i_width, i_height;
+        if( sscanf( psz_size, "%dx%d", &i_width, &i_height ) != 2 ||
+            i_width < 0 || i_height < 0 )
+        {
+            msg_Err( p_filter, "invalid size %s", psz_size );
+            continue;
+        }
+
+        char *psz_base = strdup( p_sys->psz_base_chroma );
+        char *psz_base_save;
+        for( char *psz_b = psz_base ? strtok_r( psz_base, ",", &psz_base_save ) : NULL;
+             psz_b; psz_b = strtok_r( NULL, ",", &psz_base_save ) )
+        {
+            char *psz_blend = strdup( p_sys->psz_blend_chroma );
+            char *psz_blend_save;
+            for( char *psz_s = psz_blend ? strtok_r( psz_blend, ",", &psz_blend_save ) : NULL;
+                 psz_s; psz_s = strtok_r( NULL, ",", &psz_blend_save ) )
+            {
+                Bench( p_filter, blendbench_ParseChroma( psz_b ),
+                       blendbench_ParseChroma( psz_s ), i_width, i_height );
+            }
+            free( psz_blend );
+        }
+        free( psz_base );
     }
-    time = mdate() - time;
-
-    msg_Info( p_filter, "Blended %d images in %f sec", p_sys->i_loops,
-              time / 1000000.0f );
-    msg_Info( p_filter, "Speed is: %f images/second, %f pixels/second",
-              (float) p_sys->i_loops / time * 1000000,
-              (float) p_sys->i_loops / time * 1000000 *
-                  p_sys->p_blend_image->p[Y_PLANE].i_visible_pitch *
-                  p_sys->p_blend_image->p[Y_PLANE].i_visible_lines );
+    free( psz_sizes );
 
-    module_unneed( p_blend, p_blend->p_module );
-
-    vlc_object_release( p_blend );
-
-    p_sys->b_done = true;
     return p_pic;
 }
@@ -414,15 +414,19 @@ static void IVTCLowLevelDetect( filter_t *p_filter )
 
     /* Compute interlace scores for TNBN, TNBC and TCBN.
         Note that p_next contains TNBN. */
-    p_ivtc->pi_scores[FIELD_PAIR_TNBN] = CalculateInterlaceScore( p_next,
+    p_ivtc->pi_scores[FIELD_PAIR_TNBN] = CalculateInterlaceScore( p_filter,
+                                                                  p_next,
                                                                   p_next );
-    p_ivtc->pi_scores[FIELD_PAIR_TNBC] = CalculateInterlaceScore( p_next,
+    p_ivtc->pi_scores[FIELD_PAIR_TNBC] = CalculateInterlaceScore( p_filter,
+                                                                  p_next,
                                                                   p_curr );
-    p_ivtc->pi_scores[FIELD_PAIR_TCBN] = CalculateInterlaceScore( p_curr,
+    p_ivtc->pi_scores[FIELD_PAIR_TCBN] = CalculateInterlaceScore( p_filter,
+                                                                  p_curr,
                                                                   p_next );
 
     int i_top = 0, i_bot = 0;
-    int i_motion = EstimateNumBlocksWithMotion(p_curr, p_next, &i_top, &i_bot);
+    int i_motion = EstimateNumBlocksWithMotion( p_filter, p_curr, p_next,
+                                                &i_top, &i_bot );
     p_ivtc->pi_motion[IVTC_LATEST] = i_motion;
 
     /* If one field changes "clearly more" than the other, we know the
@@ -1534,7 +1538,7 @@ int RenderIVTC( filter_t *p_filter, picture_t *p_dst )
            TPBP by the time the actual filter starts. Note that the sliding of
            final scores only starts when the filter has started (third frame).
         */
-        int i_score = CalculateInterlaceScore( p_next, p_next );
+        int i_score = CalculateInterlaceScore( p_filter, p_next, p_next );
         p_ivtc->pi_scores[FIELD_PAIR_TNBN] = i_score;
         p_ivtc->pi_final_scores[0]         = i_score;
 
@@ -121,6 +121,14 @@ int RenderYadif( filter_t *p_filter, picture_t *p_dst, picture_t *p_src,
         if( vlc_CPU() & CPU_CAPABILITY_SSSE3 )
             filter = yadif_filter_line_ssse3;
 #endif
+#if defined(HAVE_YADIF_AVX2)
+        if( vlc_CPU() & CPU_CAPABILITY_AVX2 )
+            filter = yadif_filter_line_avx2;
+#endif
+#if defined(HAVE_YADIF_NEON)
+        if( vlc_CPU() & CPU_CAPABILITY_NEON )
+            filter = yadif_filter_line_neon;
+#endif
 
         for( int n = 0; n < p_dst->i_planes; n++ )
         {
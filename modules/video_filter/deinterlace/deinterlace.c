@@ -58,6 +58,13 @@
 
 #define FILTER_CFG_PREFIX "sout-deinterlace-"
 
+#define DETECT_TEXT N_("Deinterlace only combed frames")
+#define DETECT_LONGTEXT N_("Look for combing in each frame, and let the " \
+                           "frames without any through unchanged, even if " \
+                           "they are flagged as interlaced. This does not " \
+                           "apply to the Phosphor and IVTC modes, nor to " \
+                           "the modes that halve the height.")
+
 /* Tooltips drop linefeeds (at least in the Qt GUI);
    thus the space before each set of consecutive \n.
 
@@ -112,6 +119,9 @@ vlc_module_begin ()
                 PHOSPHOR_DIMMER_LONGTEXT, true )
         change_integer_list( phosphor_dimmer_list, phosphor_dimmer_list_text )
         change_safe ()
+    add_bool( FILTER_CFG_PREFIX "detect", true, DETECT_TEXT,
+              DETECT_LONGTEXT, true )
+        change_safe ()
     add_shortcut( "deinterlace" )
     set_callbacks( Open, Close )
 vlc_module_end ()
@@ -127,7 +137,7 @@ vlc_module_end ()
  * and reading logic for them implemented in Open().
  */
 static const char *const ppsz_filter_options[] = {
-    "mode", "phosphor-chroma", "phosphor-dimmer",
+    "mode", "phosphor-chroma", "phosphor-dimmer", "detect",
     NULL
 };
 
@@ -455,8 +465,21 @@ picture_t *Deinterlace( filter_t *p_filter, picture_t *p_pic )
     assert( p_sys->b_double_rate  ||  p_dst[1] == NULL );
     assert( i_nb_fields > 2  ||  p_dst[2] == NULL );
 
+    /* The input frame that corresponds to the outgoing one */
+    const picture_t *p_src = NULL;
+    if( p_sys->b_detect && i_frame_offset != CUSTOM_PTS )
+        p_src = i_frame_offset == 0 ? p_pic
+              : p_sys->pp_history[HISTORY_SIZE-1 - i_frame_offset];
+
     /* Render */
-    switch( p_sys->i_mode )
+    if( p_src != NULL && !HasCombing( p_filter, p_src ) )
+    {
+        /* Without combing, the fields agree: show the frame as it is */
+        for( int i = 0; i < DEINTERLACE_DST_SIZE; ++i )
+            if( p_dst[i] )
+                picture_CopyPixels( p_dst[i], p_src );
+    }
+    else switch( p_sys->i_mode )
     {
         case DEINTERLACE_DISCARD:
             RenderDiscard( p_filter, p_dst[0], p_pic, 0 );
@@ -649,6 +672,7 @@ int Open( vlc_object_t *p_this )
         p_sys->pp_history[i] = NULL;
 
     IVTCClearState( p_filter );
+    GetMetricsKernels( &p_sys->pf_comb_line, &p_sys->pf_motion_row );
 
 #if defined(CAN_COMPILE_C_ALTIVEC)
     if( vlc_CPU() & CPU_CAPABILITY_ALTIVEC )
@@ -658,6 +682,14 @@ int Open( vlc_object_t *p_this )
     }
     else
 #endif
+#if defined(CAN_COMPILE_AVX2)
+    if( vlc_CPU() & CPU_CAPABILITY_AVX2 )
+    {
+        p_sys->pf_merge = MergeAVX2;
+        p_sys->pf_end_merge = NULL;
+    }
+    else
+#endif
 #if defined(CAN_COMPILE_SSE)
     if( vlc_CPU() & CPU_CAPABILITY_SSE2 )
     {
@@ -739,6 +771,13 @@ int Open( vlc_object_t *p_this )
         p_sys->phosphor.i_dimmer_strength = 1;
     }
 
+    /* Only where the output frames can be the input ones, and where the
+       algorithm does not tell interlaced frames itself (IVTC) */
+    p_sys->b_detect = var_GetBool( p_filter, FILTER_CFG_PREFIX "detect" )
+                   && !p_sys->b_half_height
+                   && p_sys->i_mode != DEINTERLACE_PHOSPHOR
+                   && p_sys->i_mode != DEINTERLACE_IVTC;
+
     /* */
     video_format_t fmt;
     GetOutputFormat( p_filter, &fmt, &p_filter->fmt_in.video );
@@ -42,6 +42,7 @@ struct vlc_object_t;
 #include "algo_yadif.h"
 #include "algo_phosphor.h"
 #include "algo_ivtc.h"
+#include "metrics.h"
 
 /*****************************************************************************
  * Local data
@@ -101,6 +102,13 @@ struct filter_sys_t
     /** Merge finalization routine: C, MMX, SSE, ALTIVEC, NEON, ... */
     void (*pf_end_merge) ( void );
 
+    /** Metrics kernels: C, MMX, SSE2, NEON */
+    comb_line_t  pf_comb_line;
+    motion_row_t pf_motion_row;
+
+    /** Let the frames without combing through? @see HasCombing() */
+    bool b_detect;
+
     /**
      * Metadata history (PTS, nb_fields, TFF). Used for framerate doublers.
      * @see metadata_history_t
@@ -25,10 +25,6 @@
 #   include "config.h"
 #endif
 
-#ifdef CAN_COMPILE_MMXEXT
-#   include "mmx.h"
-#endif
-
 #include <stdint.h>
 #include <assert.h>
 
@@ -40,6 +36,7 @@
 #include "deinterlace.h" /* definition of p_sys, needed for Merge() */
 #include "common.h"      /* FFMIN3 et al. */
 #include "merge.h"
+#include "metrics.h"
 
 #include "helpers.h"
 
@@ -96,131 +93,20 @@ static void FieldFromPlane( plane_t *p_dst, const plane_t *p_src, int i_field )
 
 /**
  * Internal helper function for EstimateNumBlocksWithMotion():
- * estimates whether there is motion in the given 8x8 block on one plane
- * between two images. The block as a whole and its fields are evaluated
- * separately, and use different motion thresholds.
- *
- * This is a low-level function only used by EstimateNumBlocksWithMotion().
- * There is no need to call this function manually.
- *
- * For interpretation of pi_top and pi_bot, it is assumed that the block
- * starts on an even-numbered line (belonging to the top field).
+ * estimates whether there is motion in an 8x8 block, from the number of
+ * pixels that changed in each of its fields. The block as a whole and its
+ * fields use different motion thresholds.
  *
- * The b_mmx parameter avoids the need to call vlc_CPU() separately
- * for each block.
- *
- * @param[in] p_pix_p Base pointer to the block in previous picture
- * @param[in] p_pix_c Base pointer to the same block in current picture
- * @param i_pitch_prev i_pitch of previous picture
- * @param i_pitch_curr i_pitch of current picture
- * @param b_mmx (vlc_CPU() & CPU_CAPABILITY_MMXEXT) or false.
+ * @param i_top Number of pixels of the top field that changed
+ * @param i_bot Number of pixels of the bottom field that changed
  * @param[out] pi_top 1 if top field of the block had motion, 0 if no
  * @param[out] pi_bot 1 if bottom field of the block had motion, 0 if no
  * @return 1 if the block had motion, 0 if no
  * @see EstimateNumBlocksWithMotion()
  */
-static inline int TestForMotionInBlock( uint8_t *p_pix_p, uint8_t *p_pix_c,
-                                        int i_pitch_prev, int i_pitch_curr,
-                                        bool b_mmx,
+static inline int TestForMotionInBlock( int i_top, int i_bot,
                                         int* pi_top, int* pi_bot )
 {
-/* Pixel luma/chroma difference threshold to detect motion. */
-#define T 10
-
-    int32_t i_motion = 0;
-    int32_t i_top_motion = 0;
-    int32_t i_bot_motion = 0;
-
-/* See below for the C version to see more quickly what this does. */
-#ifdef CAN_COMPILE_MMXEXT
-    if( b_mmx )
-    {
-        static const mmx_t bT   = { .ub = { T, T, T, T, T, T, T, T } };
-        pxor_r2r( mm6, mm6 ); /* zero, used in psadbw */
-        movq_m2r( bT,  mm5 );
-
-        pxor_r2r( mm3, mm3 ); /* score (top field) */
-        pxor_r2r( mm4, mm4 ); /* score (bottom field) */
-        for( int y = 0; y < 8; y+=2 )
-        {
-            /* top field */
-            movq_m2r( *((uint64_t*)p_pix_c), mm0 );
-            movq_m2r( *((uint64_t*)p_pix_p), mm1 );
-            movq_r2r( mm0, mm2 );
-            psubusb_r2r( mm1, mm2 );
-            psubusb_r2r( mm0, mm1 );
-
-            pcmpgtb_r2r( mm5, mm2 );
-            pcmpgtb_r2r( mm5, mm1 );
-            psadbw_r2r(  mm6, mm2 );
-            psadbw_r2r(  mm6, mm1 );
-
-            paddd_r2r( mm2, mm1 );
-            paddd_r2r( mm1, mm3 ); /* add to top field score */
-
-            p_pix_c += i_pitch_curr;
-            p_pix_p += i_pitch_prev;
-
-            /* bottom field - handling identical to top field, except... */
-            movq_m2r( *((uint64_t*)p_pix_c), mm0 );
-            movq_m2r( *((uint64_t*)p_pix_p), mm1 );
-            movq_r2r( mm0, mm2 );
-            psubusb_r2r( mm1, mm2 );
-            psubusb_r2r( mm0, mm1 );
-
-            pcmpgtb_r2r( mm5, mm2 );
-            pcmpgtb_r2r( mm5, mm1 );
-            psadbw_r2r(  mm6, mm2 );
-            psadbw_r2r(  mm6, mm1 );
-
-            paddd_r2r( mm2, mm1 );
-            paddd_r2r( mm1, mm4 ); /* ...here we add to bottom field score */
-
-            p_pix_c += i_pitch_curr;
-            p_pix_p += i_pitch_prev;
-        }
-        movq_r2r(  mm3, mm7 ); /* score (total) */
-        paddd_r2r( mm4, mm7 );
-        movd_r2m( mm3, i_top_motion );
-        movd_r2m( mm4, i_bot_motion );
-        movd_r2m( mm7, i_motion );
-
-        /* The loop counts actual score * 255. */
-        i_top_motion /= 255;
-        i_bot_motion /= 255;
-        i_motion     /= 255;
-
-        emms();
-    }
-    else
-#endif
-    {
-        for( int y = 0; y < 8; ++y )
-        {
-            uint8_t *pc = p_pix_c;
-            uint8_t *pp = p_pix_p;
-            int score = 0;
-            for( int x = 0; x < 8; ++x )
-            {
-                int_fast16_t C = abs((*pc) - (*pp));
-                if( C > T )
-                    ++score;
-
-                ++pc;
-                ++pp;
-            }
-
-            i_motion += score;
-            if( y % 2 == 0 )
-                i_top_motion += score;
-            else
-                i_bot_motion += score;
-
-            p_pix_c += i_pitch_curr;
-            p_pix_p += i_pitch_prev;
-        }
-    }
-
     /* Field motion thresholds.
 
        Empirical value - works better in practice than the "4" that
@@ -232,14 +118,13 @@ static inline int TestForMotionInBlock( uint8_t *p_pix_p, uint8_t *p_pix_c,
        leading to more interlacing artifacts than by just using the emergency
        mode frame composer.
     */
-    (*pi_top) = ( i_top_motion >= 8 );
-    (*pi_bot) = ( i_bot_motion >= 8 );
+    (*pi_top) = ( i_top >= 8 );
+    (*pi_bot) = ( i_bot >= 8 );
 
     /* Full-block threshold = (8*8)/8: motion is detected if 1/8 of the block
        changes "enough". */
-    return (i_motion >= 8);
+    return (i_top + i_bot >= 8);
 }
-#undef T
 
 /*****************************************************************************
  * Public functions
@@ -380,10 +265,12 @@ void ComposeFrame( filter_t *p_filter, picture_t *p_outpic,
 }
 
 /* See header for function doc. */
-int EstimateNumBlocksWithMotion( const picture_t* p_prev,
+int EstimateNumBlocksWithMotion( filter_t *p_filter,
+                                 const picture_t* p_prev,
                                  const picture_t* p_curr,
                                  int *pi_top, int *pi_bot)
 {
+    motion_row_t pf_motion_row = p_filter->p_sys->pf_motion_row;
     assert( p_prev != NULL );
     assert( p_curr != NULL );
 
@@ -393,13 +280,6 @@ int EstimateNumBlocksWithMotion( const picture_t* p_prev,
     if( p_prev->i_planes != p_curr->i_planes )
         return -1;
 
-    /* We must tell our inline helper whether to use MMX acceleration. */
-#ifdef CAN_COMPILE_MMXEXT
-    bool b_mmx = ( vlc_CPU() & CPU_CAPABILITY_MMXEXT );
-#else
-    bool b_mmx = false;
-#endif
-
     int i_score = 0;
     for( int i_plane = 0 ; i_plane < p_prev->i_planes ; i_plane++ )
     {
@@ -423,18 +303,25 @@ int EstimateNumBlocksWithMotion( const picture_t* p_prev,
             uint8_t *p_pix_p = &p_prev->p[i_plane].p_pixels[i_pitch_prev*8*by];
             uint8_t *p_pix_c = &p_curr->p[i_plane].p_pixels[i_pitch_curr*8*by];
 
-            for( int bx = 0; bx < i_mbx; ++bx )
+            /* The kernel counts the changed pixels of several blocks */
+            for( int bx = 0; bx < i_mbx; bx += 64 )
             {
-                int i_top_temp, i_bot_temp;
-                i_score += TestForMotionInBlock( p_pix_p, p_pix_c,
-                                                 i_pitch_prev, i_pitch_curr,
-                                                 b_mmx,
-                                                 &i_top_temp, &i_bot_temp );
-                i_score_top += i_top_temp;
-                i_score_bot += i_bot_temp;
-
-                p_pix_p += 8;
-                p_pix_c += 8;
+                uint8_t p_counts[2*64];
+                const int i_blocks = __MIN( i_mbx - bx, 64 );
+
+                pf_motion_row( &p_pix_p[8*bx], i_pitch_prev,
+                               &p_pix_c[8*bx], i_pitch_curr,
+                               i_blocks, p_counts );
+                for( int i = 0; i < i_blocks; ++i )
+                {
+                    int i_top_temp, i_bot_temp;
+                    i_score += TestForMotionInBlock( p_counts[2*i],
+                                                     p_counts[2*i+1],
+                                                     &i_top_temp,
+                                                     &i_bot_temp );
+                    i_score_top += i_top_temp;
+                    i_score_bot += i_bot_temp;
+                }
             }
         }
     }
@@ -448,7 +335,8 @@ int EstimateNumBlocksWithMotion( const picture_t* p_prev,
 }
 
 /* See header for function doc. */
-int CalculateInterlaceScore( const picture_t* p_pic_top,
+int CalculateInterlaceScore( filter_t *p_filter,
+                             const picture_t* p_pic_top,
                              const picture_t* p_pic_bot )
 {
     /*
@@ -467,17 +355,8 @@ int CalculateInterlaceScore( const picture_t* p_pic_top,
     if( p_pic_top->i_planes != p_pic_bot->i_planes )
         return -1;
 
-    /* Amount of bits must be known for MMX, thus int32_t.
-       Doesn't hurt the C implementation. */
-    int32_t i_score_mmx = 0; /* this must be divided by 255 when finished  */
-    int32_t i_score_c   = 0; /* this counts as-is (used for non-MMX parts) */
-
-#ifdef CAN_COMPILE_MMXEXT
-    unsigned u_cpu = vlc_CPU();
-
-    if( u_cpu & CPU_CAPABILITY_MMXEXT )
-        pxor_r2r( mm7, mm7 ); /* we will keep score in mm7 */
-#endif
+    comb_line_t pf_comb_line = p_filter->p_sys->pf_comb_line;
+    int i_score = 0;
 
     for( int i_plane = 0 ; i_plane < p_pic_top->i_planes ; ++i_plane )
     {
@@ -489,8 +368,6 @@ int CalculateInterlaceScore( const picture_t* p_pic_top,
         const int i_lasty = p_pic_top->p[i_plane].i_visible_lines-1;
         const int w = FFMIN( p_pic_top->p[i_plane].i_visible_pitch,
                              p_pic_bot->p[i_plane].i_visible_pitch );
-        const int wm8 = w % 8;   /* remainder */
-        const int w8  = w - wm8; /* part of width that is divisible by 8 */
 
         /* Current line / neighbouring lines picture pointers */
         const picture_t *cur = p_pic_bot;
@@ -508,84 +385,7 @@ int CalculateInterlaceScore( const picture_t* p_pic_top,
             uint8_t *p_p = &ngh->p[i_plane].p_pixels[(y-1)*wn]; /* prev line */
             uint8_t *p_n = &ngh->p[i_plane].p_pixels[(y+1)*wn]; /* next line */
 
-            int x = 0;
-
-/* Threshold (value from Transcode 1.1.5) */
-#define T 100
-#ifdef CAN_COMPILE_MMXEXT
-            /* Easy-to-read C version further below.
-
-               Assumptions: 0 < T < 127
-                            # of pixels < (2^32)/255
-               Note: calculates score * 255
-            */
-            if( u_cpu & CPU_CAPABILITY_MMXEXT )
-            {
-                static const mmx_t b0   = { .uq = 0x0000000000000000ULL };
-                static const mmx_t b128 = { .uq = 0x8080808080808080ULL };
-                static const mmx_t bT   = { .ub = { T, T, T, T, T, T, T, T } };
-
-                for( ; x < w8; x += 8 )
-                {
-                    movq_m2r( *((int64_t*)p_c), mm0 );
-                    movq_m2r( *((int64_t*)p_p), mm1 );
-                    movq_m2r( *((int64_t*)p_n), mm2 );
-
-                    psubb_m2r( b128, mm0 );
-                    psubb_m2r( b128, mm1 );
-                    psubb_m2r( b128, mm2 );
-
-                    psubsb_r2r( mm0, mm1 );
-                    psubsb_r2r( mm0, mm2 );
-
-                    pxor_r2r( mm3, mm3 );
-                    pxor_r2r( mm4, mm4 );
-                    pxor_r2r( mm5, mm5 );
-                    pxor_r2r( mm6, mm6 );
-
-                    punpcklbw_r2r( mm1, mm3 );
-                    punpcklbw_r2r( mm2, mm4 );
-                    punpckhbw_r2r( mm1, mm5 );
-                    punpckhbw_r2r( mm2, mm6 );
-
-                    pmulhw_r2r( mm3, mm4 );
-                    pmulhw_r2r( mm5, mm6 );
-
-                    packsswb_r2r(mm4, mm6);
-                    pcmpgtb_m2r( bT, mm6 );
-                    psadbw_m2r( b0, mm6 );
-                    paddd_r2r( mm6, mm7 );
-
-                    p_c += 8;
-                    p_p += 8;
-                    p_n += 8;
-                }
-            }
-#endif
-            for( ; x < w; ++x )
-            {
-                /* Worst case: need 17 bits for "comb". */
-                int_fast32_t C = *p_c;
-                int_fast32_t P = *p_p;
-                int_fast32_t N = *p_n;
-
-                /* Comments in Transcode's filter_ivtc.c attribute this
-                   combing metric to Gunnar Thalin.
-
-                    The idea is that if the picture is interlaced, both
-                    expressions will have the same sign, and this comes
-                    up positive. The value T = 100 has been chosen such
-                    that a pixel difference of 10 (on average) will
-                    trigger the detector.
-                */
-                int_fast32_t comb = (P - C) * (N - C);
-                if( comb > T )
-                    ++i_score_c;
-
-                ++p_c;
-                ++p_p;
-                ++p_n;
-            }
+            i_score += pf_comb_line( p_c, p_p, p_n, w );
 
             /* Now the other field - swap current and neighbour pictures */
             const picture_t *tmp = cur;
@@ -597,15 +397,50 @@ int CalculateInterlaceScore( const picture_t* p_pic_top,
         }
     }
 
-#ifdef CAN_COMPILE_MMXEXT
-    if( u_cpu & CPU_CAPABILITY_MMXEXT )
+    return i_score;
+}
+
+/* Blocks of the combing detector: COMB_BLOCK_WIDTH pixels by
+   COMB_BLOCK_LINES lines, of which one in COMB_SAMPLING is tested */
+#define COMB_BLOCK_WIDTH  32
+#define COMB_BLOCK_LINES  16
+#define COMB_SAMPLING     4
+
+/* See header for function doc. */
+bool HasCombing( filter_t *p_filter, const picture_t *p_pic )
+{
+    assert( p_pic != NULL );
+
+    comb_line_t pf_comb_line = p_filter->p_sys->pf_comb_line;
+    const plane_t *p_plane = &p_pic->p[Y_PLANE];
+    const int i_lasty = p_plane->i_visible_lines - 1;
+    const int i_pitch = p_plane->i_pitch;
+
+    /* A block is combed if a quarter of its tested pixels are. A frame
+       with a combed area as small as a block has to be deinterlaced, as
+       when only the mouths move in a talking scene. */
+    const unsigned i_block_threshold =
+        COMB_BLOCK_WIDTH * (COMB_BLOCK_LINES / COMB_SAMPLING) / 4;
+
+    for( int y0 = 0; y0 + COMB_BLOCK_LINES <= i_lasty;
+         y0 += COMB_BLOCK_LINES )
     {
-        movd_r2m( mm7, i_score_mmx );
-        emms();
-        i_score_mmx /= 255;
-    }
-#endif
+        for( int x = 0; x + COMB_BLOCK_WIDTH <= p_plane->i_visible_pitch;
+             x += COMB_BLOCK_WIDTH )
+        {
+            unsigned i_score = 0;
+
+            for( int y = y0 + 1; y < y0 + COMB_BLOCK_LINES;
+                 y += COMB_SAMPLING )
+            {
+                const uint8_t *p_c = &p_plane->p_pixels[y*i_pitch + x];
 
-    return i_score_mmx + i_score_c;
+                i_score += pf_comb_line( p_c, p_c - i_pitch, p_c + i_pitch,
+                                         COMB_BLOCK_WIDTH );
+            }
+            if( i_score > i_block_threshold )
+                return true;
+        }
+    }
+    return false;
 }
-#undef T
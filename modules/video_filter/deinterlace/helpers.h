@@ -119,6 +119,7 @@ void ComposeFrame( filter_t *p_filter, picture_t *p_outpic,
  * chroma, and odd-numbered chroma lines the "bottom field" for chroma.
  * This is correct for IVTC purposes.
  *
+ * @param p_filter The filter instance (for the motion kernel).
  * @param[in] p_prev Previous picture
  * @param[in] p_curr Current picture
  * @param[out] pi_top Number of 8x8 blocks where top field has motion.
@@ -128,7 +129,8 @@ void ComposeFrame( filter_t *p_filter, picture_t *p_outpic,
  * @see TestForMotionInBlock()
  * @see RenderIVTC()
  */
-int EstimateNumBlocksWithMotion( const picture_t* p_prev,
+int EstimateNumBlocksWithMotion( filter_t *p_filter,
+                                 const picture_t* p_prev,
                                  const picture_t* p_curr,
                                  int *pi_top, int *pi_bot);
 
@@ -154,6 +156,7 @@ int EstimateNumBlocksWithMotion( const picture_t* p_prev,
  * each other locally (in the temporal sense) to make meaningful decisions
  * about progressive or interlaced frames.
  *
+ * @param p_filter The filter instance (for the comb kernel).
  * @param p_pic_top Picture to take the top field from.
  * @param p_pic_bot Picture to take the bottom field from (same or different).
  * @return Interlace score, >= 0. Higher values mean more interlaced.
@@ -161,7 +164,24 @@ int EstimateNumBlocksWithMotion( const picture_t* p_prev,
  * @see RenderIVTC()
  * @see ComposeFrame()
  */
-int CalculateInterlaceScore( const picture_t* p_pic_top,
+int CalculateInterlaceScore( filter_t *p_filter,
+                             const picture_t* p_pic_top,
                              const picture_t* p_pic_bot );
 
+/**
+ * Helper function: tells whether a frame shows combing anywhere, and thus
+ * needs deinterlacing. Used by Deinterlace() to let the other frames through.
+ *
+ * Unlike CalculateInterlaceScore(), this is meant to be cheap: it tests one
+ * luma line in four, by blocks, and stops at the first combed block. It uses
+ * the same comb metric.
+ *
+ * @param p_filter The filter instance (for the comb kernel).
+ * @param p_pic The frame to test.
+ * @return Whether the frame has a combed block.
+ * @see CalculateInterlaceScore()
+ * @see Deinterlace()
+ */
+bool HasCombing( filter_t *p_filter, const picture_t *p_pic );
+
 #endif
@@ -41,6 +41,12 @@
 #   include <altivec.h>
 #endif
 
+#ifdef CAN_COMPILE_AVX2
+#   include <vlc_common.h>
+#   include <vlc_cpu.h>
+#   include <immintrin.h>
+#endif
+
 /*****************************************************************************
  * Merge (line blending) routines
  *****************************************************************************/
@@ -165,6 +171,37 @@ void MergeSSE2( void *_p_dest, const void *_p_s1, const void *_p_s2,
 }
 #endif
 
+#if defined(CAN_COMPILE_AVX2)
+VLC_AVX2
+void MergeAVX2( void *_p_dest, const void *_p_s1, const void *_p_s2,
+                size_t i_bytes )
+{
+    uint8_t* p_dest = (uint8_t*)_p_dest;
+    const uint8_t *p_s1 = (const uint8_t *)_p_s1;
+    const uint8_t *p_s2 = (const uint8_t *)_p_s2;
+    const __m256i one = _mm256_set1_epi8( 1 );
+
+    /* vpavgb rounds up: remove the carry to match MergeGeneric */
+    for( ; i_bytes >= 32; i_bytes -= 32 )
+    {
+        __m256i s1 = _mm256_loadu_si256( (const __m256i *)p_s1 );
+        __m256i s2 = _mm256_loadu_si256( (const __m256i *)p_s2 );
+        __m256i avg = _mm256_avg_epu8( s1, s2 );
+        __m256i odd = _mm256_and_si256( _mm256_xor_si256( s1, s2 ), one );
+
+        _mm256_storeu_si256( (__m256i *)p_dest, _mm256_sub_epi8( avg, odd ) );
+        p_dest += 32;
+        p_s1 += 32;
+        p_s2 += 32;
+    }
+
+    while( i_bytes-- > 0 )
+    {
+        *p_dest++ = ( (uint16_t)(*p_s1++) + (uint16_t)(*p_s2++) ) >> 1;
+    }
+}
+#endif
+
 #ifdef CAN_COMPILE_C_ALTIVEC
 void MergeAltivec( void *_p_dest, const void *_p_s1,
                    const void *_p_s2, size_t i_bytes )
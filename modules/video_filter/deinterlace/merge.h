@@ -128,6 +128,19 @@ void Merge3DNow   ( void *, const void *, const void *, size_t );
 void MergeSSE2    ( void *, const void *, const void *, size_t );
 #endif
 
+#if defined(CAN_COMPILE_AVX2)
+/**
+ * AVX2 routine to blend pixels from two picture lines.
+ * Unlike the other SIMD versions, it rounds down like MergeGeneric.
+ *
+ * @param _p_dest Target
+ * @param _p_s1 Source line A
+ * @param _p_s2 Source line B
+ * @param i_bytes Number of bytes to merge
+ */
+void MergeAVX2    ( void *, const void *, const void *, size_t );
+#endif
+
 #if defined __ARM_NEON__
 /**
  * ARM NEON routine to blend pixels from two picture lines.
@@ -0,0 +1,409 @@
+/*****************************************************************************
+ * metrics.c : Field difference and combing metrics for the VLC deinterlacer
+ *****************************************************************************
+ * Copyright (C) 2011 the VideoLAN team
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * Author: Juha Jeronen <juha.jeronen@jyu.fi> (C and MMXEXT versions)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#   include "config.h"
+#endif
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+
+#ifdef CAN_COMPILE_MMXEXT
+#   include "mmx.h"
+#endif
+
+#include "metrics.h"
+
+#ifdef HAVE_METRICS_SSE2
+#   include <emmintrin.h>
+#endif
+#ifdef HAVE_METRICS_NEON
+#   include <arm_neon.h>
+#endif
+
+/*****************************************************************************
+ * Comb metric
+ *****************************************************************************/
+
+unsigned CombLineC( const uint8_t *p_c, const uint8_t *p_p,
+                    const uint8_t *p_n, int i_width )
+{
+    unsigned i_score = 0;
+
+    for( int x = 0; x < i_width; ++x )
+    {
+        /* Worst case: need 17 bits for "comb". */
+        int_fast32_t C = p_c[x];
+        int_fast32_t P = p_p[x];
+        int_fast32_t N = p_n[x];
+
+        int_fast32_t comb = (P - C) * (N - C);
+        if( comb > COMB_THRESHOLD )
+            ++i_score;
+    }
+    return i_score;
+}
+
+/* The SIMD versions compute the differences with signed saturation. This
+   keeps the result exact: a product above the threshold (0 < T < 127) needs
+   both differences of the same sign and non-zero, and a saturated difference
+   is still at least 127 in absolute value. */
+
+#if defined(CAN_COMPILE_MMXEXT)
+unsigned CombLineMMXEXT( const uint8_t *p_c, const uint8_t *p_p,
+                         const uint8_t *p_n, int i_width )
+{
+    static const mmx_t b0   = { .uq = 0x0000000000000000ULL };
+    static const mmx_t b128 = { .uq = 0x8080808080808080ULL };
+    static const mmx_t bT   = { .ub = { COMB_THRESHOLD, COMB_THRESHOLD,
+                                        COMB_THRESHOLD, COMB_THRESHOLD,
+                                        COMB_THRESHOLD, COMB_THRESHOLD,
+                                        COMB_THRESHOLD, COMB_THRESHOLD } };
+    int32_t i_score_mmx; /* score * 255 */
+    int x = 0;
+
+    pxor_r2r( mm7, mm7 ); /* we will keep score in mm7 */
+    for( ; x + 8 <= i_width; x += 8 )
+    {
+        movq_m2r( *((const int64_t*)&p_c[x]), mm0 );
+        movq_m2r( *((const int64_t*)&p_p[x]), mm1 );
+        movq_m2r( *((const int64_t*)&p_n[x]), mm2 );
+
+        psubb_m2r( b128, mm0 );
+        psubb_m2r( b128, mm1 );
+        psubb_m2r( b128, mm2 );
+
+        psubsb_r2r( mm0, mm1 );
+        psubsb_r2r( mm0, mm2 );
+
+        pxor_r2r( mm3, mm3 );
+        pxor_r2r( mm4, mm4 );
+        pxor_r2r( mm5, mm5 );
+        pxor_r2r( mm6, mm6 );
+
+        punpcklbw_r2r( mm1, mm3 );
+        punpcklbw_r2r( mm2, mm4 );
+        punpckhbw_r2r( mm1, mm5 );
+        punpckhbw_r2r( mm2, mm6 );
+
+        pmulhw_r2r( mm3, mm4 );
+        pmulhw_r2r( mm5, mm6 );
+
+        packsswb_r2r(mm4, mm6);
+        pcmpgtb_m2r( bT, mm6 );
+        psadbw_m2r( b0, mm6 );
+        paddd_r2r( mm6, mm7 );
+    }
+    movd_r2m( mm7, i_score_mmx );
+    emms();
+
+    return i_score_mmx / 255
+         + CombLineC( &p_c[x], &p_p[x], &p_n[x], i_width - x );
+}
+#endif
+
+#if defined(HAVE_METRICS_SSE2)
+/* 0xFF for the combed pixels among 16 */
+VLC_SSE2
+static inline __m128i CombSSE2( const uint8_t *p_c, const uint8_t *p_p,
+                                const uint8_t *p_n )
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i b128 = _mm_set1_epi8( (char)0x80 );
+
+    __m128i c = _mm_xor_si128( _mm_loadu_si128( (const __m128i *)p_c ), b128 );
+    __m128i p = _mm_xor_si128( _mm_loadu_si128( (const __m128i *)p_p ), b128 );
+    __m128i n = _mm_xor_si128( _mm_loadu_si128( (const __m128i *)p_n ), b128 );
+    __m128i dp = _mm_subs_epi8( p, c );
+    __m128i dn = _mm_subs_epi8( n, c );
+
+    /* (d << 8) * (d' << 8) >> 16 = d * d' */
+    __m128i lo = _mm_mulhi_epi16( _mm_unpacklo_epi8( zero, dp ),
+                                  _mm_unpacklo_epi8( zero, dn ) );
+    __m128i hi = _mm_mulhi_epi16( _mm_unpackhi_epi8( zero, dp ),
+                                  _mm_unpackhi_epi8( zero, dn ) );
+    return _mm_cmpgt_epi8( _mm_packs_epi16( lo, hi ),
+                           _mm_set1_epi8( COMB_THRESHOLD ) );
+}
+
+VLC_SSE2
+unsigned CombLineSSE2( const uint8_t *p_c, const uint8_t *p_p,
+                       const uint8_t *p_n, int i_width )
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i score = zero; /* on 64-bit lanes */
+    int x = 0;
+
+    while( x + 16 <= i_width )
+    {
+        /* Counted on bytes, summed before they can overflow */
+        __m128i count = zero;
+        for( int i = 0; i < 255 && x + 16 <= i_width; i++, x += 16 )
+            count = _mm_sub_epi8( count,
+                                  CombSSE2( &p_c[x], &p_p[x], &p_n[x] ) );
+        score = _mm_add_epi64( score, _mm_sad_epu8( count, zero ) );
+    }
+
+    unsigned i_score = _mm_cvtsi128_si32( score )
+                     + _mm_cvtsi128_si32( _mm_srli_si128( score, 8 ) );
+    return i_score + CombLineC( &p_c[x], &p_p[x], &p_n[x], i_width - x );
+}
+#endif
+
+#if defined(HAVE_METRICS_NEON)
+unsigned CombLineNEON( const uint8_t *p_c, const uint8_t *p_p,
+                       const uint8_t *p_n, int i_width )
+{
+    const int16x8_t hT = vdupq_n_s16( COMB_THRESHOLD );
+    uint16x8_t acc = vdupq_n_u16( 0 );
+    int x = 0;
+
+    /* Lanes cannot overflow below 2^19 pixels per line */
+    for( ; x + 8 <= i_width; x += 8 )
+    {
+        int16x8_t c = vreinterpretq_s16_u16( vmovl_u8( vld1_u8( &p_c[x] ) ) );
+        int16x8_t p = vreinterpretq_s16_u16( vmovl_u8( vld1_u8( &p_p[x] ) ) );
+        int16x8_t n = vreinterpretq_s16_u16( vmovl_u8( vld1_u8( &p_n[x] ) ) );
+        int16x8_t comb = vmull_s8( vqmovn_s16( vsubq_s16( p, c ) ),
+                                   vqmovn_s16( vsubq_s16( n, c ) ) );
+
+        acc = vsraq_n_u16( acc, vcgtq_s16( comb, hT ), 15 );
+    }
+
+    uint64x2_t sum = vpaddlq_u32( vpaddlq_u16( acc ) );
+    return vgetq_lane_u64( sum, 0 ) + vgetq_lane_u64( sum, 1 )
+         + CombLineC( &p_c[x], &p_p[x], &p_n[x], i_width - x );
+}
+#endif
+
+/*****************************************************************************
+ * Motion detection
+ *****************************************************************************/
+
+void MotionRowC( const uint8_t *p_prev, int i_pitch_prev,
+                 const uint8_t *p_curr, int i_pitch_curr,
+                 int i_blocks, uint8_t *p_counts )
+{
+    for( int b = 0; b < i_blocks; ++b )
+    {
+        const uint8_t *pp = &p_prev[8*b];
+        const uint8_t *pc = &p_curr[8*b];
+
+        p_counts[2*b] = p_counts[2*b+1] = 0;
+        for( int y = 0; y < 8; ++y )
+        {
+            for( int x = 0; x < 8; ++x )
+                if( abs( pc[x] - pp[x] ) > MOTION_THRESHOLD )
+                    p_counts[2*b + (y % 2)]++;
+
+            pc += i_pitch_curr;
+            pp += i_pitch_prev;
+        }
+    }
+}
+
+/* The SIMD versions count the pixels whose difference does not vanish when
+   the threshold is subtracted from it, with unsigned saturation. */
+
+#if defined(CAN_COMPILE_MMXEXT)
+void MotionRowMMXEXT( const uint8_t *p_prev, int i_pitch_prev,
+                      const uint8_t *p_curr, int i_pitch_curr,
+                      int i_blocks, uint8_t *p_counts )
+{
+    static const mmx_t bT = { .ub = { MOTION_THRESHOLD, MOTION_THRESHOLD,
+                                      MOTION_THRESHOLD, MOTION_THRESHOLD,
+                                      MOTION_THRESHOLD, MOTION_THRESHOLD,
+                                      MOTION_THRESHOLD, MOTION_THRESHOLD } };
+
+    pxor_r2r( mm6, mm6 ); /* zero, used in pcmpeqb and psadbw */
+    movq_m2r( bT,  mm5 );
+    for( int b = 0; b < i_blocks; ++b )
+    {
+        const uint8_t *pp = &p_prev[8*b];
+        const uint8_t *pc = &p_curr[8*b];
+        int32_t i_top_still, i_bot_still; /* times 255 */
+
+        pxor_r2r( mm3, mm3 ); /* still pixels (top field) */
+        pxor_r2r( mm4, mm4 ); /* still pixels (bottom field) */
+        for( int y = 0; y < 8; y += 2 )
+        {
+            /* top field */
+            movq_m2r( *((const uint64_t*)pc), mm0 );
+            movq_m2r( *((const uint64_t*)pp), mm1 );
+            movq_r2r( mm0, mm2 );
+            psubusb_r2r( mm1, mm2 );
+            psubusb_r2r( mm0, mm1 );
+            por_r2r( mm2, mm1 );      /* |c - p| */
+            psubusb_r2r( mm5, mm1 );
+            pcmpeqb_r2r( mm6, mm1 );
+            psadbw_r2r( mm6, mm1 );
+            paddd_r2r( mm1, mm3 );
+
+            pc += i_pitch_curr;
+            pp += i_pitch_prev;
+
+            /* bottom field - handling identical to top field, except... */
+            movq_m2r( *((const uint64_t*)pc), mm0 );
+            movq_m2r( *((const uint64_t*)pp), mm1 );
+            movq_r2r( mm0, mm2 );
+            psubusb_r2r( mm1, mm2 );
+            psubusb_r2r( mm0, mm1 );
+            por_r2r( mm2, mm1 );
+            psubusb_r2r( mm5, mm1 );
+            pcmpeqb_r2r( mm6, mm1 );
+            psadbw_r2r( mm6, mm1 );
+            paddd_r2r( mm1, mm4 ); /* ...here we add to bottom field */
+
+            pc += i_pitch_curr;
+            pp += i_pitch_prev;
+        }
+        movd_r2m( mm3, i_top_still );
+        movd_r2m( mm4, i_bot_still );
+        p_counts[2*b]   = 32 - i_top_still / 255;
+        p_counts[2*b+1] = 32 - i_bot_still / 255;
+    }
+    emms();
+}
+#endif
+
+#if defined(HAVE_METRICS_SSE2)
+/* Two blocks at a time */
+VLC_SSE2
+void MotionRowSSE2( const uint8_t *p_prev, int i_pitch_prev,
+                    const uint8_t *p_curr, int i_pitch_curr,
+                    int i_blocks, uint8_t *p_counts )
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one  = _mm_set1_epi8( 1 );
+    const __m128i bT   = _mm_set1_epi8( MOTION_THRESHOLD );
+    int b = 0;
+
+    for( ; b + 2 <= i_blocks; b += 2 )
+    {
+        const uint8_t *pp = &p_prev[8*b];
+        const uint8_t *pc = &p_curr[8*b];
+        __m128i field[2] = { zero, zero };
+
+        for( int y = 0; y < 8; ++y )
+        {
+            __m128i p = _mm_loadu_si128( (const __m128i *)pp );
+            __m128i c = _mm_loadu_si128( (const __m128i *)pc );
+            __m128i d = _mm_or_si128( _mm_subs_epu8( c, p ),
+                                      _mm_subs_epu8( p, c ) );
+            __m128i still = _mm_cmpeq_epi8( _mm_subs_epu8( d, bT ), zero );
+
+            /* one byte per moving pixel, summed by block */
+            field[y % 2] = _mm_add_epi32( field[y % 2],
+                _mm_sad_epu8( _mm_andnot_si128( still, one ), zero ) );
+
+            pc += i_pitch_curr;
+            pp += i_pitch_prev;
+        }
+        p_counts[2*b]   = _mm_cvtsi128_si32( field[0] );
+        p_counts[2*b+1] = _mm_cvtsi128_si32( field[1] );
+        p_counts[2*b+2] = _mm_cvtsi128_si32( _mm_srli_si128( field[0], 8 ) );
+        p_counts[2*b+3] = _mm_cvtsi128_si32( _mm_srli_si128( field[1], 8 ) );
+    }
+    if( b < i_blocks )
+        MotionRowC( &p_prev[8*b], i_pitch_prev, &p_curr[8*b], i_pitch_curr,
+                    i_blocks - b, &p_counts[2*b] );
+}
+#endif
+
+#if defined(HAVE_METRICS_NEON)
+void MotionRowNEON( const uint8_t *p_prev, int i_pitch_prev,
+                    const uint8_t *p_curr, int i_pitch_curr,
+                    int i_blocks, uint8_t *p_counts )
+{
+    const uint8x8_t bT = vdup_n_u8( MOTION_THRESHOLD );
+
+    for( int b = 0; b < i_blocks; ++b )
+    {
+        const uint8_t *pp = &p_prev[8*b];
+        const uint8_t *pc = &p_curr[8*b];
+        uint8x8_t field[2] = { vdup_n_u8( 0 ), vdup_n_u8( 0 ) };
+
+        for( int y = 0; y < 8; ++y )
+        {
+            uint8x8_t moving = vcgt_u8( vabd_u8( vld1_u8( pc ),
+                                                 vld1_u8( pp ) ), bT );
+            field[y % 2] = vsra_n_u8( field[y % 2], moving, 7 );
+
+            pc += i_pitch_curr;
+            pp += i_pitch_prev;
+        }
+        for( int i = 0; i < 2; ++i )
+        {
+            uint64x1_t sum = vpaddl_u32( vpaddl_u16( vpaddl_u8( field[i] ) ) );
+            p_counts[2*b + i] = vget_lane_u64( sum, 0 );
+        }
+    }
+}
+#endif
+
+/*****************************************************************************
+ * Selection
+ *****************************************************************************/
+
+static const struct
+{
+    comb_line_t func;
+    unsigned    cpu;
+} comb_kernels[] = {
+#if defined(HAVE_METRICS_SSE2)
+    { CombLineSSE2,   CPU_CAPABILITY_SSE2 },
+#endif
+#if defined(CAN_COMPILE_MMXEXT)
+    { CombLineMMXEXT, CPU_CAPABILITY_MMXEXT },
+#endif
+#if defined(HAVE_METRICS_NEON)
+    { CombLineNEON,   CPU_CAPABILITY_NEON },
+#endif
+    { CombLineC,      0 },
+};
+
+static const struct
+{
+    motion_row_t func;
+    unsigned     cpu;
+} motion_kernels[] = {
+#if defined(HAVE_METRICS_SSE2)
+    { MotionRowSSE2,   CPU_CAPABILITY_SSE2 },
+#endif
+#if defined(CAN_COMPILE_MMXEXT)
+    { MotionRowMMXEXT, CPU_CAPABILITY_MMXEXT },
+#endif
+#if defined(HAVE_METRICS_NEON)
+    { MotionRowNEON,   CPU_CAPABILITY_NEON },
+#endif
+    { MotionRowC,      0 },
+};
+
+void GetMetricsKernels( comb_line_t *pf_comb, motion_row_t *pf_motion )
+{
+    *pf_comb = vlc_CPU_select( comb_kernels );
+    *pf_motion = vlc_CPU_select( motion_kernels );
+}
@@ -0,0 +1,104 @@
+/*****************************************************************************
+ * metrics.h : Field difference and combing metrics for the VLC deinterlacer
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_DEINTERLACE_METRICS_H
+#define VLC_DEINTERLACE_METRICS_H 1
+
+/**
+ * \file
+ * Line kernels of the metrics shared by IVTC and the combing detector.
+ * All the versions of a kernel return exactly the same result.
+ */
+
+#include <stdint.h>
+
+/* Threshold of the comb metric (value from Transcode 1.1.5) */
+#define COMB_THRESHOLD 100
+/* Pixel luma/chroma difference threshold to detect motion */
+#define MOTION_THRESHOLD 10
+
+/**
+ * Counts the combed pixels of a line.
+ *
+ * Comments in Transcode's filter_ivtc.c attribute this combing metric to
+ * Gunnar Thalin. A pixel is combed if (P - C) * (N - C) > COMB_THRESHOLD,
+ * P and N being the pixels above and below it, in the other field. If the
+ * picture is interlaced, both differences have the same sign, and this
+ * comes up positive. The threshold is such that a pixel difference of 10
+ * (on average) triggers the detector.
+ *
+ * @param p_c Current line
+ * @param p_p Previous line, from the other field
+ * @param p_n Next line, from the other field
+ * @param i_width Number of pixels
+ * @return Number of combed pixels
+ */
+typedef unsigned (*comb_line_t)( const uint8_t *p_c, const uint8_t *p_p,
+                                 const uint8_t *p_n, int i_width );
+
+/**
+ * Counts, for each 8x8 block of a row of blocks, the pixels that changed by
+ * more than MOTION_THRESHOLD between two pictures, field by field.
+ *
+ * @param p_prev First line of the row in the previous picture
+ * @param i_pitch_prev Pitch of the previous picture
+ * @param p_curr First line of the row in the current picture
+ * @param i_pitch_curr Pitch of the current picture
+ * @param i_blocks Number of blocks
+ * @param[out] p_counts For block i, p_counts[2*i] for the top field (even
+ *                      lines), p_counts[2*i+1] for the bottom field.
+ */
+typedef void (*motion_row_t)( const uint8_t *p_prev, int i_pitch_prev,
+                              const uint8_t *p_curr, int i_pitch_curr,
+                              int i_blocks, uint8_t *p_counts );
+
+unsigned CombLineC( const uint8_t *, const uint8_t *, const uint8_t *, int );
+void MotionRowC( const uint8_t *, int, const uint8_t *, int, int, uint8_t * );
+
+#if defined(CAN_COMPILE_MMXEXT)
+unsigned CombLineMMXEXT( const uint8_t *, const uint8_t *, const uint8_t *,
+                         int );
+void MotionRowMMXEXT( const uint8_t *, int, const uint8_t *, int, int,
+                      uint8_t * );
+#endif
+
+#if defined(CAN_COMPILE_SSE2)
+# define HAVE_METRICS_SSE2
+unsigned CombLineSSE2( const uint8_t *, const uint8_t *, const uint8_t *,
+                       int );
+void MotionRowSSE2( const uint8_t *, int, const uint8_t *, int, int,
+                    uint8_t * );
+#endif
+
+#if defined(__ARM_NEON__)
+# define HAVE_METRICS_NEON
+unsigned CombLineNEON( const uint8_t *, const uint8_t *, const uint8_t *,
+                       int );
+void MotionRowNEON( const uint8_t *, int, const uint8_t *, int, int,
+                    uint8_t * );
+#endif
+
+/**
+ * Picks the best versions of the kernels that the CPU supports.
+ * This is meant to be called once, when the filter is opened.
+ */
+void GetMetricsKernels( comb_line_t *, motion_row_t * );
+
+#endif
@@ -139,3 +139,229 @@ static void yadif_filter_line_c(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8
     }
 }
 
+#if defined(CAN_COMPILE_AVX2) && VLC_GCC_VERSION(4, 9)
+// ================ AVX2 =================
+/* Same computation as yadif_filter_line_c, 16 pixels at a time on 16-bit
+   lanes, so that the result is bit-exact. */
+#define HAVE_YADIF_AVX2
+#include <immintrin.h>
+
+VLC_AVX2
+static inline __m256i yadif_load_avx2(const uint8_t *p)
+{
+    return _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)p));
+}
+
+VLC_AVX2
+static inline __m256i yadif_absdiff_avx2(__m256i a, __m256i b)
+{
+    return _mm256_abs_epi16(_mm256_sub_epi16(a, b));
+}
+
+#define YADIF_CHECK_AVX2(j, mask) \
+    { \
+        __m256i score = _mm256_add_epi16(_mm256_add_epi16( \
+            yadif_absdiff_avx2(yadif_load_avx2(&cur[mrefs-1+(j)]), \
+                               yadif_load_avx2(&cur[prefs-1-(j)])), \
+            yadif_absdiff_avx2(yadif_load_avx2(&cur[mrefs  +(j)]), \
+                               yadif_load_avx2(&cur[prefs  -(j)]))), \
+            yadif_absdiff_avx2(yadif_load_avx2(&cur[mrefs+1+(j)]), \
+                               yadif_load_avx2(&cur[prefs+1-(j)]))); \
+        __m256i pred = _mm256_srli_epi16(_mm256_add_epi16( \
+            yadif_load_avx2(&cur[mrefs+(j)]), \
+            yadif_load_avx2(&cur[prefs-(j)])), 1); \
+        mask = _mm256_and_si256(mask, \
+                                _mm256_cmpgt_epi16(spatial_score, score)); \
+        spatial_score = _mm256_blendv_epi8(spatial_score, score, mask); \
+        spatial_pred  = _mm256_blendv_epi8(spatial_pred, pred, mask); \
+    }
+
+VLC_AVX2
+static void yadif_filter_line_avx2(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8_t *next, int w, int prefs, int mrefs, int parity, int mode) {
+    uint8_t *prev2= parity ? prev : cur ;
+    uint8_t *next2= parity ? cur  : next;
+    const __m256i all = _mm256_set1_epi16(-1);
+    const __m256i one = _mm256_set1_epi16(1);
+    int x;
+
+    for(x=0; x+16<=w; x+=16){
+        __m256i c = yadif_load_avx2(&cur[mrefs]);
+        __m256i e = yadif_load_avx2(&cur[prefs]);
+        __m256i p2 = yadif_load_avx2(prev2);
+        __m256i n2 = yadif_load_avx2(next2);
+        __m256i d = _mm256_srli_epi16(_mm256_add_epi16(p2, n2), 1);
+        __m256i temporal_diff0 = yadif_absdiff_avx2(p2, n2);
+        __m256i temporal_diff1 = _mm256_srli_epi16(_mm256_add_epi16(
+            yadif_absdiff_avx2(yadif_load_avx2(&prev[mrefs]), c),
+            yadif_absdiff_avx2(yadif_load_avx2(&prev[prefs]), e)), 1);
+        __m256i temporal_diff2 = _mm256_srli_epi16(_mm256_add_epi16(
+            yadif_absdiff_avx2(yadif_load_avx2(&next[mrefs]), c),
+            yadif_absdiff_avx2(yadif_load_avx2(&next[prefs]), e)), 1);
+        __m256i diff = _mm256_max_epi16(_mm256_max_epi16(
+            _mm256_srli_epi16(temporal_diff0, 1), temporal_diff1),
+            temporal_diff2);
+        __m256i spatial_pred = _mm256_srli_epi16(_mm256_add_epi16(c, e), 1);
+        __m256i spatial_score = _mm256_sub_epi16(_mm256_add_epi16(
+            _mm256_add_epi16(
+                yadif_absdiff_avx2(yadif_load_avx2(&cur[mrefs-1]),
+                                   yadif_load_avx2(&cur[prefs-1])),
+                yadif_absdiff_avx2(c, e)),
+            yadif_absdiff_avx2(yadif_load_avx2(&cur[mrefs+1]),
+                               yadif_load_avx2(&cur[prefs+1]))), one);
+        __m256i mask;
+
+        /* The second check only applies where the first one succeeded */
+        mask = all;
+        YADIF_CHECK_AVX2(-1, mask)
+        YADIF_CHECK_AVX2(-2, mask)
+        mask = all;
+        YADIF_CHECK_AVX2( 1, mask)
+        YADIF_CHECK_AVX2( 2, mask)
+
+        if(mode<2){
+            __m256i b = _mm256_srli_epi16(_mm256_add_epi16(
+                yadif_load_avx2(&prev2[2*mrefs]),
+                yadif_load_avx2(&next2[2*mrefs])), 1);
+            __m256i f = _mm256_srli_epi16(_mm256_add_epi16(
+                yadif_load_avx2(&prev2[2*prefs]),
+                yadif_load_avx2(&next2[2*prefs])), 1);
+            __m256i dc = _mm256_sub_epi16(d, c);
+            __m256i de = _mm256_sub_epi16(d, e);
+            __m256i bc = _mm256_sub_epi16(b, c);
+            __m256i fe = _mm256_sub_epi16(f, e);
+            __m256i max = _mm256_max_epi16(_mm256_max_epi16(de, dc),
+                                           _mm256_min_epi16(bc, fe));
+            __m256i min = _mm256_min_epi16(_mm256_min_epi16(de, dc),
+                                           _mm256_max_epi16(bc, fe));
+
+            diff = _mm256_max_epi16(_mm256_max_epi16(diff, min),
+                                    _mm256_sub_epi16(_mm256_setzero_si256(), max));
+        }
+
+        spatial_pred = _mm256_min_epi16(spatial_pred, _mm256_add_epi16(d, diff));
+        spatial_pred = _mm256_max_epi16(spatial_pred, _mm256_sub_epi16(d, diff));
+
+        __m256i packed = _mm256_packus_epi16(spatial_pred, spatial_pred);
+        packed = _mm256_permute4x64_epi64(packed, 0x08);
+        _mm_storeu_si128((__m128i *)dst, _mm256_castsi256_si128(packed));
+
+        dst += 16;
+        cur += 16;
+        prev += 16;
+        next += 16;
+        prev2 += 16;
+        next2 += 16;
+    }
+    if(x < w)
+        yadif_filter_line_c(dst, prev, cur, next, w - x, prefs, mrefs, parity, mode);
+}
+#undef YADIF_CHECK_AVX2
+#endif
+
+#if defined(__ARM_NEON__)
+// ================ NEON =================
+/* Same computation as yadif_filter_line_c, 8 pixels at a time on 16-bit
+   lanes, so that the result is bit-exact. */
+#define HAVE_YADIF_NEON
+#include <arm_neon.h>
+
+static inline int16x8_t yadif_load_neon(const uint8_t *p)
+{
+    return vreinterpretq_s16_u16(vmovl_u8(vld1_u8(p)));
+}
+
+static inline int16x8_t yadif_absdiff_neon(int16x8_t a, int16x8_t b)
+{
+    return vabdq_s16(a, b);
+}
+
+#define YADIF_CHECK_NEON(j, mask) \
+    { \
+        int16x8_t score = vaddq_s16(vaddq_s16( \
+            yadif_absdiff_neon(yadif_load_neon(&cur[mrefs-1+(j)]), \
+                               yadif_load_neon(&cur[prefs-1-(j)])), \
+            yadif_absdiff_neon(yadif_load_neon(&cur[mrefs  +(j)]), \
+                               yadif_load_neon(&cur[prefs  -(j)]))), \
+            yadif_absdiff_neon(yadif_load_neon(&cur[mrefs+1+(j)]), \
+                               yadif_load_neon(&cur[prefs+1-(j)]))); \
+        int16x8_t pred = vshrq_n_s16(vaddq_s16( \
+            yadif_load_neon(&cur[mrefs+(j)]), \
+            yadif_load_neon(&cur[prefs-(j)])), 1); \
+        mask = vandq_u16(mask, vcltq_s16(score, spatial_score)); \
+        spatial_score = vbslq_s16(mask, score, spatial_score); \
+        spatial_pred  = vbslq_s16(mask, pred, spatial_pred); \
+    }
+
+static void yadif_filter_line_neon(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8_t *next, int w, int prefs, int mrefs, int parity, int mode) {
+    uint8_t *prev2= parity ? prev : cur ;
+    uint8_t *next2= parity ? cur  : next;
+    const uint16x8_t all = vdupq_n_u16(0xFFFF);
+    const int16x8_t one = vdupq_n_s16(1);
+    int x;
+
+    for(x=0; x+8<=w; x+=8){
+        int16x8_t c = yadif_load_neon(&cur[mrefs]);
+        int16x8_t e = yadif_load_neon(&cur[prefs]);
+        int16x8_t p2 = yadif_load_neon(prev2);
+        int16x8_t n2 = yadif_load_neon(next2);
+        int16x8_t d = vshrq_n_s16(vaddq_s16(p2, n2), 1);
+        int16x8_t temporal_diff0 = yadif_absdiff_neon(p2, n2);
+        int16x8_t temporal_diff1 = vshrq_n_s16(vaddq_s16(
+            yadif_absdiff_neon(yadif_load_neon(&prev[mrefs]), c),
+            yadif_absdiff_neon(yadif_load_neon(&prev[prefs]), e)), 1);
+        int16x8_t temporal_diff2 = vshrq_n_s16(vaddq_s16(
+            yadif_absdiff_neon(yadif_load_neon(&next[mrefs]), c),
+            yadif_absdiff_neon(yadif_load_neon(&next[prefs]), e)), 1);
+        int16x8_t diff = vmaxq_s16(vmaxq_s16(
+            vshrq_n_s16(temporal_diff0, 1), temporal_diff1), temporal_diff2);
+        int16x8_t spatial_pred = vshrq_n_s16(vaddq_s16(c, e), 1);
+        int16x8_t spatial_score = vsubq_s16(vaddq_s16(vaddq_s16(
+            yadif_absdiff_neon(yadif_load_neon(&cur[mrefs-1]),
+                               yadif_load_neon(&cur[prefs-1])),
+            yadif_absdiff_neon(c, e)),
+            yadif_absdiff_neon(yadif_load_neon(&cur[mrefs+1]),
+                               yadif_load_neon(&cur[prefs+1]))), one);
+        uint16x8_t mask;
+
+        /* The second check only applies where the first one succeeded */
+        mask = all;
+        YADIF_CHECK_NEON(-1, mask)
+        YADIF_CHECK_NEON(-2, mask)
+        mask = all;
+        YADIF_CHECK_NEON( 1, mask)
+        YADIF_CHECK_NEON( 2, mask)
+
+        if(mode<2){
+            int16x8_t b = vshrq_n_s16(vaddq_s16(
+                yadif_load_neon(&prev2[2*mrefs]),
+                yadif_load_neon(&next2[2*mrefs])), 1);
+            int16x8_t f = vshrq_n_s16(vaddq_s16(
+                yadif_load_neon(&prev2[2*prefs]),
+                yadif_load_neon(&next2[2*prefs])), 1);
+            int16x8_t dc = vsubq_s16(d, c);
+            int16x8_t de = vsubq_s16(d, e);
+            int16x8_t bc = vsubq_s16(b, c);
+            int16x8_t fe = vsubq_s16(f, e);
+            int16x8_t max = vmaxq_s16(vmaxq_s16(de, dc), vminq_s16(bc, fe));
+            int16x8_t min = vminq_s16(vminq_s16(de, dc), vmaxq_s16(bc, fe));
+
+            diff = vmaxq_s16(vmaxq_s16(diff, min), vnegq_s16(max));
+        }
+
+        spatial_pred = vminq_s16(spatial_pred, vaddq_s16(d, diff));
+        spatial_pred = vmaxq_s16(spatial_pred, vsubq_s16(d, diff));
+
+        vst1_u8(dst, vqmovun_s16(spatial_pred));
+
+        dst += 8;
+        cur += 8;
+        prev += 8;
+        next += 8;
+        prev2 += 8;
+        next2 += 8;
+    }
+    if(x < w)
+        yadif_filter_line_c(dst, prev, cur, next, w - x, prefs, mrefs, parity, mode);
+}
+#undef YADIF_CHECK_NEON
+#endif
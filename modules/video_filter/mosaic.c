@@ -64,6 +64,7 @@ struct filter_sys_t
     int i_position;           /* Mosaic positioning method */
     bool b_ar;          /* Do we keep the aspect ratio ? */
     bool b_keep;        /* Do we keep the original picture format ? */
+    bool b_prescale;    /* Do the bridges scale the pictures ? */
     int i_width, i_height;    /* Mosaic height and width */
     int i_cols, i_rows;       /* Mosaic rows and cols */
     int i_align;              /* Mosaic alignment in background video */
@@ -139,6 +140,12 @@ struct filter_sys_t
 #define KEEP_LONGTEXT N_( \
         "Keep the original size of mosaic elements." )
 
+#define PRESCALE_TEXT N_("Scale in the bridges")
+#define PRESCALE_LONGTEXT N_( \
+        "Let each mosaic bridge scale its pictures to the size of its " \
+        "tile, in its own thread, instead of scaling all of them in the " \
+        "mosaic." )
+
 #define ORDER_TEXT N_("Elements order" )
 #define ORDER_LONGTEXT N_( \
         "You can enforce the order of the elements on " \
@@ -214,6 +221,8 @@ vlc_module_begin ()
               AR_TEXT, AR_LONGTEXT, false )
     add_bool( CFG_PREFIX "keep-picture", false,
               KEEP_TEXT, KEEP_LONGTEXT, false )
+    add_bool( CFG_PREFIX "prescale", false,
+              PRESCALE_TEXT, PRESCALE_LONGTEXT, true )
 
     add_string( CFG_PREFIX "order", "",
                 ORDER_TEXT, ORDER_LONGTEXT, false )
@@ -228,7 +237,7 @@ vlc_module_end ()
 static const char *const ppsz_filter_options[] = {
     "alpha", "height", "width", "align", "xoffset", "yoffset",
     "borderw", "borderh", "position", "rows", "cols",
-    "keep-aspect-ratio", "keep-picture", "order", "offsets",
+    "keep-aspect-ratio", "keep-picture", "prescale", "order", "offsets",
     "delay", NULL
 };
 
@@ -333,6 +342,8 @@ static int CreateFilter( vlc_object_t *p_this )
         p_sys->p_image = image_HandlerCreate( p_filter );
     }
 
+    p_sys->b_prescale = var_CreateGetBool( p_filter, CFG_PREFIX "prescale" );
+
     p_sys->i_order_length = 0;
     p_sys->ppsz_order = NULL;
     psz_order = var_CreateGetStringCommand( p_filter, CFG_PREFIX "order" );
@@ -421,10 +432,41 @@ static void DestroyFilter( vlc_object_t *p_this )
         p_sys->i_offsets_length = 0;
     }
 
+    if( p_sys->b_prescale )
+    {
+        /* Let the bridges send the pictures unscaled again */
+        vlc_global_lock( VLC_MOSAIC_MUTEX );
+        bridge_t *p_bridge = GetBridge( p_filter );
+        for( int i = 0; p_bridge && i < p_bridge->i_es_num; i++ )
+        {
+            p_bridge->pp_es[i]->i_tile_width = 0;
+            p_bridge->pp_es[i]->i_tile_height = 0;
+        }
+        vlc_global_unlock( VLC_MOSAIC_MUTEX );
+    }
+
     vlc_mutex_destroy( &p_sys->lock );
     free( p_sys );
 }
 
+/*****************************************************************************
+ * IsTileScaled: tell whether a picture already has the size of its tile
+ *****************************************************************************/
+static bool IsTileScaled( const video_format_t *p_fmt, vlc_fourcc_t i_chroma,
+                          int i_width, int i_height, bool b_ar )
+{
+    if( p_fmt->i_chroma != i_chroma )
+        return false;
+    if( !b_ar )
+        return (int)p_fmt->i_width == i_width &&
+               (int)p_fmt->i_height == i_height;
+
+    /* The bridge scaled from the original aspect ratio, which the
+     * rounding of the scaled picture does not keep exactly */
+    return (int)p_fmt->i_width <= i_width && (int)p_fmt->i_height <= i_height &&
+           ( (int)p_fmt->i_width == i_width || (int)p_fmt->i_height == i_height );
+}
+
 /*****************************************************************************
  * Filter
  *****************************************************************************/
@@ -592,44 +634,40 @@ static subpicture_t *Filter( filter_t *p_filter, mtime_t date )
             fmt_in.i_height = p_es->p_picture->format.i_height;
             fmt_in.i_width = p_es->p_picture->format.i_width;
 
-            if( fmt_in.i_chroma == VLC_CODEC_YUVA ||
-                fmt_in.i_chroma == VLC_CODEC_RGBA )
-                fmt_out.i_chroma = VLC_CODEC_YUVA;
-            else
-                fmt_out.i_chroma = VLC_CODEC_I420;
-            fmt_out.i_width = col_inner_width;
-            fmt_out.i_height = row_inner_height;
+            GetTileFormat( &fmt_out, &fmt_in, col_inner_width,
+                           row_inner_height, p_sys->b_ar );
 
-            if( p_sys->b_ar ) /* keep aspect ratio */
+            if( p_sys->b_prescale )
             {
-                if( (float)fmt_out.i_width / (float)fmt_out.i_height
-                      > (float)fmt_in.i_width / (float)fmt_in.i_height )
-                {
-                    fmt_out.i_width = ( fmt_out.i_height * fmt_in.i_width )
-                                         / fmt_in.i_height;
-                }
-                else
-                {
-                    fmt_out.i_height = ( fmt_out.i_width * fmt_in.i_height )
-                                        / fmt_in.i_width;
-                }
-             }
-
-            fmt_out.i_visible_width = fmt_out.i_width;
-            fmt_out.i_visible_height = fmt_out.i_height;
+                /* Let the bridge scale the next pictures */
+                p_es->i_tile_width = col_inner_width;
+                p_es->i_tile_height = row_inner_height;
+                p_es->b_tile_ar = p_sys->b_ar;
+            }
 
-            p_converted = image_Convert( p_sys->p_image, p_es->p_picture,
-                                         &fmt_in, &fmt_out );
-            if( !p_converted )
+            if( p_sys->b_prescale &&
+                IsTileScaled( &fmt_in, fmt_out.i_chroma, col_inner_width,
+                              row_inner_height, p_sys->b_ar ) )
             {
-                msg_Warn( p_filter,
-                           "image resizing and chroma conversion failed" );
-                continue;
+                p_converted = picture_Hold( p_es->p_picture );
+                fmt_out.i_width = fmt_out.i_visible_width = fmt_in.i_width;
+                fmt_out.i_height = fmt_out.i_visible_height = fmt_in.i_height;
+            }
+            else
+            {
+                p_converted = image_Convert( p_sys->p_image, p_es->p_picture,
+                                             &fmt_in, &fmt_out );
+                if( !p_converted )
+                {
+                    msg_Warn( p_filter,
+                               "image resizing and chroma conversion failed" );
+                    continue;
+                }
             }
         }
         else
         {
-            p_converted = p_es->p_picture;
+            p_converted = picture_Hold( p_es->p_picture );
             fmt_in.i_width = fmt_out.i_width = p_converted->format.i_width;
             fmt_in.i_height = fmt_out.i_height = p_converted->format.i_height;
             fmt_in.i_chroma = fmt_out.i_chroma = p_converted->format.i_chroma;
@@ -637,11 +675,15 @@ static subpicture_t *Filter( filter_t *p_filter, mtime_t date )
             fmt_out.i_visible_height = fmt_out.i_height;
         }
 
+        /* The region references the picture, the blending does not
+         * modify it */
         p_region = subpicture_region_New( &fmt_out );
-        /* FIXME the copy is probably not needed anymore */
         if( p_region )
-            picture_Copy( p_region->p_picture, p_converted );
-        if( !p_sys->b_keep )
+        {
+            picture_Release( p_region->p_picture );
+            p_region->p_picture = p_converted;
+        }
+        else
             picture_Release( p_converted );
 
         if( !p_region )
@@ -33,6 +33,12 @@ typedef struct bridged_es_t
     int i_alpha;
     int i_x;
     int i_y;
+
+    /* Tile the mosaic shows the pictures in (0 if unknown), so that the
+     * bridge can scale them on its own thread */
+    int i_tile_width;
+    int i_tile_height;
+    bool b_tile_ar;
 } bridged_es_t;
 
 typedef struct bridge_t
@@ -57,3 +63,39 @@ static bridge_t *GetBridge( vlc_object_t *p_object )
 }
 #define GetBridge(a) GetBridge( VLC_OBJECT(a) )
 
+/**
+ * Computes the format of a picture shown in a tile of the mosaic.
+ */
+static inline void GetTileFormat( video_format_t *p_fmt_out,
+                                  const video_format_t *p_fmt_in,
+                                  int i_width, int i_height, bool b_ar )
+{
+    memset( p_fmt_out, 0, sizeof( video_format_t ) );
+
+    if( p_fmt_in->i_chroma == VLC_CODEC_YUVA ||
+        p_fmt_in->i_chroma == VLC_CODEC_RGBA )
+        p_fmt_out->i_chroma = VLC_CODEC_YUVA;
+    else
+        p_fmt_out->i_chroma = VLC_CODEC_I420;
+    p_fmt_out->i_width = i_width;
+    p_fmt_out->i_height = i_height;
+
+    if( b_ar ) /* keep aspect ratio */
+    {
+        if( (float)p_fmt_out->i_width / (float)p_fmt_out->i_height
+              > (float)p_fmt_in->i_width / (float)p_fmt_in->i_height )
+        {
+            p_fmt_out->i_width = ( p_fmt_out->i_height * p_fmt_in->i_width )
+                                   / p_fmt_in->i_height;
+        }
+        else
+        {
+            p_fmt_out->i_height = ( p_fmt_out->i_width * p_fmt_in->i_height )
+                                    / p_fmt_in->i_width;
+        }
+    }
+
+    p_fmt_out->i_visible_width = p_fmt_out->i_width;
+    p_fmt_out->i_visible_height = p_fmt_out->i_height;
+}
+
@@ -130,6 +130,7 @@ static int Create( vlc_object_t *p_this )
         return VLC_ENOMEM;
 
     p_filter->pf_video_filter = Filter;
+    p_filter->b_slice_threads = true;
 
     config_ChainParse( p_filter, FILTER_PREFIX, ppsz_filter_options,
                    p_filter->p_cfg );
@@ -160,53 +161,41 @@ static void Destroy( vlc_object_t *p_this )
     free( p_sys );
 }
 
-/*****************************************************************************
- * Render: displays previously rendered output
- *****************************************************************************
- * This function send the currently rendered image to Invert image, waits
- * until it is displayed and switch the two rendering buffers, preparing next
- * frame.
- *****************************************************************************/
-static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+typedef struct
 {
-    picture_t *p_outpic;
-    int i, j;
-    uint8_t *p_src = NULL;
-    uint8_t *p_out = NULL;
-    int i_src_pitch;
-    int i_out_pitch;
+    const picture_t *p_pic;
+    picture_t       *p_outpic;
+} sharpen_slice_t;
+
+static void FilterSlice( filter_t *p_filter, void *p_data,
+                         int i_slice, int i_slice_count )
+{
+    const sharpen_slice_t *p_slice = p_data;
+    const plane_t *p_src_plane = &p_slice->p_pic->p[Y_PLANE];
+    const uint8_t *p_src = p_src_plane->p_pixels;
+    uint8_t *p_out = p_slice->p_outpic->p[Y_PLANE].p_pixels;
+    const int i_src_pitch = p_src_plane->i_pitch;
+    const int i_out_pitch = p_slice->p_outpic->p[Y_PLANE].i_pitch;
+    const int i_lines = p_src_plane->i_visible_lines;
+    int i_first, i_count;
     int pix;
     const int v1 = -1;
     const int v2 = 3; /* 2^3 = 8 */
 
-    if( !p_pic ) return NULL;
-
-    p_outpic = filter_NewPicture( p_filter );
-    if( !p_outpic )
-    {
-        picture_Release( p_pic );
-        return NULL;
-    }
-
-    /* process the Y plane */
-    p_src = p_pic->p[Y_PLANE].p_pixels;
-    p_out = p_outpic->p[Y_PLANE].p_pixels;
-    i_src_pitch = p_pic->p[Y_PLANE].i_pitch;
-    i_out_pitch = p_outpic->p[Y_PLANE].i_pitch;
+    plane_GetSlice( p_src_plane, i_slice, i_slice_count, &i_first, &i_count );
 
     /* perform convolution only on Y plane. Avoid border line. */
-    vlc_mutex_lock( &p_filter->p_sys->lock );
-    for( i = 0; i < p_pic->p[Y_PLANE].i_visible_lines; i++ )
+    for( int i = i_first; i < i_first + i_count; i++ )
     {
-        if( (i == 0) || (i == p_pic->p[Y_PLANE].i_visible_lines - 1) )
+        if( (i == 0) || (i == i_lines - 1) )
         {
-            for( j = 0; j < p_pic->p[Y_PLANE].i_visible_pitch; j++ )
+            for( int j = 0; j < p_src_plane->i_visible_pitch; j++ )
                 p_out[i * i_out_pitch + j] = clip( p_src[i * i_src_pitch + j] );
             continue ;
         }
-        for( j = 0; j < p_pic->p[Y_PLANE].i_visible_pitch; j++ )
+        for( int j = 0; j < p_src_plane->i_visible_pitch; j++ )
         {
-            if( (j == 0) || (j == p_pic->p[Y_PLANE].i_visible_pitch - 1) )
+            if( (j == 0) || (j == p_src_plane->i_visible_pitch - 1) )
             {
                 p_out[i * i_out_pitch + j] = p_src[i * i_src_pitch + j];
                 continue ;
@@ -227,6 +216,33 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
                p_filter->p_sys->tab_precalc[pix + 256] );
         }
     }
+}
+
+/*****************************************************************************
+ * Render: displays previously rendered output
+ *****************************************************************************
+ * This function send the currently rendered image to Invert image, waits
+ * until it is displayed and switch the two rendering buffers, preparing next
+ * frame.
+ *****************************************************************************/
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+{
+    picture_t *p_outpic;
+
+    if( !p_pic ) return NULL;
+
+    p_outpic = filter_NewPicture( p_filter );
+    if( !p_outpic )
+    {
+        picture_Release( p_pic );
+        return NULL;
+    }
+
+    /* process the Y plane, the slices only read the source picture */
+    sharpen_slice_t slice = { .p_pic = p_pic, .p_outpic = p_outpic };
+
+    vlc_mutex_lock( &p_filter->p_sys->lock );
+    filter_ExecuteSlices( p_filter, FilterSlice, &slice );
     vlc_mutex_unlock( &p_filter->p_sys->lock );
 
     plane_CopyPixels( &p_outpic->p[U_PLANE], &p_pic->p[U_PLANE] );
@@ -78,15 +78,25 @@ vlc_module_end ()
 
 void *( *swscale_fast_memcpy )( void *, const void *, size_t );
 
+/* Maximum number of bands a picture is scaled in by the slice threads */
+#define SCALER_BAND_MAX (16)
+
 /**
- * Internal swscale filter structure.
+ * Scaler for one band of lines, used when scaling without vertical
+ * resampling in parallel.
  */
-struct filter_sys_t
+typedef struct
 {
-    SwsFilter *p_src_filter;
-    SwsFilter *p_dst_filter;
-    int i_cpu_mask, i_sws_flags;
+    struct SwsContext *ctx;
+    int i_line;
+    int i_lines;
+} ScalerBand;
 
+/**
+ * Everything depending on the input and output formats.
+ */
+typedef struct
+{
     video_format_t fmt_in;
     video_format_t fmt_out;
 
@@ -101,6 +111,36 @@ struct filter_sys_t
     bool b_copy;
     bool b_swap_uvi;
     bool b_swap_uvo;
+
+    /* Slice threading, set up on the first picture as the slice threads
+     * are only attached to the filter once opened */
+    int  i_fmti;
+    int  i_fmto;
+    int  i_sws_flags;
+    bool b_bands_init;
+    int  i_band_count;
+    ScalerBand band[SCALER_BAND_MAX];
+
+    unsigned i_last_use;
+} ScalerContext;
+
+/* Number of format configurations kept, so that a filter alternating
+ * between a few sizes (subpictures, vout resizing) does not rebuild the
+ * scaler tables on each switch */
+#define SCALER_CACHE_SIZE (4)
+
+/**
+ * Internal swscale filter structure.
+ */
+struct filter_sys_t
+{
+    SwsFilter *p_src_filter;
+    SwsFilter *p_dst_filter;
+    int i_cpu_mask, i_sws_flags;
+
+    ScalerContext *p_ctx;
+    ScalerContext cache[SCALER_CACHE_SIZE];
+    unsigned i_use;
 };
 
 static picture_t *Filter( filter_t *, picture_t * );
@@ -184,14 +224,12 @@ static int OpenScaler( vlc_object_t *p_this )
     p_sys->p_dst_filter = NULL;
 
     /* Misc init */
-    p_sys->ctx = NULL;
-    p_sys->ctxA = NULL;
-    p_sys->p_src_a = NULL;
-    p_sys->p_dst_a = NULL;
-    p_sys->p_src_e = NULL;
-    p_sys->p_dst_e = NULL;
-    memset( &p_sys->fmt_in,  0, sizeof(p_sys->fmt_in) );
-    memset( &p_sys->fmt_out, 0, sizeof(p_sys->fmt_out) );
+    p_sys->p_ctx = NULL;
+    memset( p_sys->cache, 0, sizeof(p_sys->cache) );
+    p_sys->i_use = 0;
+
+    /* Large pictures without vertical scaling are converted in bands */
+    p_filter->b_slice_threads = true;
 
     if( Init( p_filter ) )
     {
@@ -344,19 +382,87 @@ static int GetParameters( ScalerConfiguration *p_cfg,
     return VLC_SUCCESS;
 }
 
+static void CleanBands( ScalerContext *p_ctx )
+{
+    for( int i = 0; i < p_ctx->i_band_count; i++ )
+        sws_freeContext( p_ctx->band[i].ctx );
+    p_ctx->i_band_count = 0;
+}
+
+static void CleanContext( ScalerContext *p_ctx )
+{
+    CleanBands( p_ctx );
+
+    if( p_ctx->p_src_e )
+        picture_Release( p_ctx->p_src_e );
+    if( p_ctx->p_dst_e )
+        picture_Release( p_ctx->p_dst_e );
+
+    if( p_ctx->p_src_a )
+        picture_Release( p_ctx->p_src_a );
+    if( p_ctx->p_dst_a )
+        picture_Release( p_ctx->p_dst_a );
+
+    if( p_ctx->ctxA )
+        sws_freeContext( p_ctx->ctxA );
+
+    if( p_ctx->ctx )
+        sws_freeContext( p_ctx->ctx );
+
+    /* We have to set it to null has the entry is reused :( */
+    p_ctx->ctx = NULL;
+    p_ctx->ctxA = NULL;
+    p_ctx->p_src_a = NULL;
+    p_ctx->p_dst_a = NULL;
+    p_ctx->p_src_e = NULL;
+    p_ctx->p_dst_e = NULL;
+    p_ctx->b_bands_init = false;
+}
+
 static int Init( filter_t *p_filter )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
     const video_format_t *p_fmti = &p_filter->fmt_in.video;
     video_format_t       *p_fmto = &p_filter->fmt_out.video;
 
-    if( IsFmtSimilar( p_fmti, &p_sys->fmt_in ) &&
-        IsFmtSimilar( p_fmto, &p_sys->fmt_out ) &&
-        p_sys->ctx )
+    if( p_sys->p_ctx &&
+        IsFmtSimilar( p_fmti, &p_sys->p_ctx->fmt_in ) &&
+        IsFmtSimilar( p_fmto, &p_sys->p_ctx->fmt_out ) )
     {
         return VLC_SUCCESS;
     }
-    Clean( p_filter );
+
+    /* Look for a cached configuration, or else the least recently used
+     * entry to replace */
+    ScalerContext *p_ctx = NULL;
+    ScalerContext *p_lru = &p_sys->cache[0];
+    for( int i = 0; i < SCALER_CACHE_SIZE; i++ )
+    {
+        ScalerContext *p_entry = &p_sys->cache[i];
+
+        if( p_entry->ctx &&
+            IsFmtSimilar( p_fmti, &p_entry->fmt_in ) &&
+            IsFmtSimilar( p_fmto, &p_entry->fmt_out ) )
+        {
+            p_ctx = p_entry;
+            break;
+        }
+        if( p_lru->ctx &&
+            ( !p_entry->ctx || p_entry->i_last_use < p_lru->i_last_use ) )
+            p_lru = p_entry;
+    }
+    p_sys->p_ctx = NULL;
+
+    if( p_ctx )
+    {
+        p_ctx->i_last_use = ++p_sys->i_use;
+        p_sys->p_ctx = p_ctx;
+
+        video_format_ScaleCropAr( p_fmto, p_fmti );
+        return VLC_SUCCESS;
+    }
+    p_ctx = p_lru;
+    CleanContext( p_ctx );
 
     /* Init with new parameters */
     ScalerConfiguration cfg;
@@ -372,12 +478,12 @@ static int Init( filter_t *p_filter )
     }
 
     /* swscale does not like too small width */
-    p_sys->i_extend_factor = 1;
-    while( __MIN( p_fmti->i_width, p_fmto->i_width ) * p_sys->i_extend_factor < MINIMUM_WIDTH)
-        p_sys->i_extend_factor++;
+    p_ctx->i_extend_factor = 1;
+    while( __MIN( p_fmti->i_width, p_fmto->i_width ) * p_ctx->i_extend_factor < MINIMUM_WIDTH)
+        p_ctx->i_extend_factor++;
 
-    const unsigned i_fmti_width = p_fmti->i_width * p_sys->i_extend_factor;
-    const unsigned i_fmto_width = p_fmto->i_width * p_sys->i_extend_factor;
+    const unsigned i_fmti_width = p_fmti->i_width * p_ctx->i_extend_factor;
+    const unsigned i_fmto_width = p_fmto->i_width * p_ctx->i_extend_factor;
     for( int n = 0; n < (cfg.b_has_a ? 2 : 1); n++ )
     {
         const int i_fmti = n == 0 ? cfg.i_fmti : PIX_FMT_GRAY8;
@@ -389,48 +495,53 @@ static int Init( filter_t *p_filter )
                               cfg.i_sws_flags | p_sys->i_cpu_mask,
                               p_sys->p_src_filter, p_sys->p_dst_filter, 0 );
         if( n == 0 )
-            p_sys->ctx = ctx;
+            p_ctx->ctx = ctx;
         else
-            p_sys->ctxA = ctx;
+            p_ctx->ctxA = ctx;
     }
-    if( p_sys->ctxA )
+    if( p_ctx->ctxA )
     {
-        p_sys->p_src_a = picture_New( VLC_CODEC_GREY, i_fmti_width, p_fmti->i_height, 0, 1 );
-        p_sys->p_dst_a = picture_New( VLC_CODEC_GREY, i_fmto_width, p_fmto->i_height, 0, 1 );
+        p_ctx->p_src_a = picture_New( VLC_CODEC_GREY, i_fmti_width, p_fmti->i_height, 0, 1 );
+        p_ctx->p_dst_a = picture_New( VLC_CODEC_GREY, i_fmto_width, p_fmto->i_height, 0, 1 );
     }
-    if( p_sys->i_extend_factor != 1 )
+    if( p_ctx->i_extend_factor != 1 )
     {
-        p_sys->p_src_e = picture_New( p_fmti->i_chroma, i_fmti_width, p_fmti->i_height, 0, 1 );
-        p_sys->p_dst_e = picture_New( p_fmto->i_chroma, i_fmto_width, p_fmto->i_height, 0, 1 );
+        p_ctx->p_src_e = picture_New( p_fmti->i_chroma, i_fmti_width, p_fmti->i_height, 0, 1 );
+        p_ctx->p_dst_e = picture_New( p_fmto->i_chroma, i_fmto_width, p_fmto->i_height, 0, 1 );
 
-        if( p_sys->p_src_e )
-            memset( p_sys->p_src_e->p[0].p_pixels, 0, p_sys->p_src_e->p[0].i_pitch * p_sys->p_src_e->p[0].i_lines );
-        if( p_sys->p_dst_e )
-            memset( p_sys->p_dst_e->p[0].p_pixels, 0, p_sys->p_dst_e->p[0].i_pitch * p_sys->p_dst_e->p[0].i_lines );
+        if( p_ctx->p_src_e )
+            memset( p_ctx->p_src_e->p[0].p_pixels, 0, p_ctx->p_src_e->p[0].i_pitch * p_ctx->p_src_e->p[0].i_lines );
+        if( p_ctx->p_dst_e )
+            memset( p_ctx->p_dst_e->p[0].p_pixels, 0, p_ctx->p_dst_e->p[0].i_pitch * p_ctx->p_dst_e->p[0].i_lines );
     }
 
-    if( !p_sys->ctx ||
-        ( cfg.b_has_a && ( !p_sys->ctxA || !p_sys->p_src_a || !p_sys->p_dst_a ) ) ||
-        ( p_sys->i_extend_factor != 1 && ( !p_sys->p_src_e || !p_sys->p_dst_e ) ) )
+    if( !p_ctx->ctx ||
+        ( cfg.b_has_a && ( !p_ctx->ctxA || !p_ctx->p_src_a || !p_ctx->p_dst_a ) ) ||
+        ( p_ctx->i_extend_factor != 1 && ( !p_ctx->p_src_e || !p_ctx->p_dst_e ) ) )
     {
         msg_Err( p_filter, "could not init SwScaler and/or allocate memory" );
-        Clean( p_filter );
+        CleanContext( p_ctx );
         return VLC_EGENERIC;
     }
 
-    p_sys->b_add_a = cfg.b_add_a;
-    p_sys->b_copy = cfg.b_copy;
-    p_sys->fmt_in  = *p_fmti;
-    p_sys->fmt_out = *p_fmto;
-    p_sys->b_swap_uvi = cfg.b_swap_uvi;
-    p_sys->b_swap_uvo = cfg.b_swap_uvo;
+    p_ctx->b_add_a = cfg.b_add_a;
+    p_ctx->b_copy = cfg.b_copy;
+    p_ctx->fmt_in  = *p_fmti;
+    p_ctx->fmt_out = *p_fmto;
+    p_ctx->b_swap_uvi = cfg.b_swap_uvi;
+    p_ctx->b_swap_uvo = cfg.b_swap_uvo;
+    p_ctx->i_fmti = cfg.i_fmti;
+    p_ctx->i_fmto = cfg.i_fmto;
+    p_ctx->i_sws_flags = cfg.i_sws_flags;
+    p_ctx->i_last_use = ++p_sys->i_use;
+    p_sys->p_ctx = p_ctx;
 
     video_format_ScaleCropAr( p_fmto, p_fmti );
 #if 0
     msg_Dbg( p_filter, "%ix%i chroma: %4.4s -> %ix%i chroma: %4.4s extend by %d",
              p_fmti->i_width, p_fmti->i_height, (char *)&p_fmti->i_chroma,
              p_fmto->i_width, p_fmto->i_height, (char *)&p_fmto->i_chroma,
-             p_sys->i_extend_factor );
+             p_ctx->i_extend_factor );
 #endif
     return VLC_SUCCESS;
 }
@@ -438,29 +549,67 @@ static void Clean( filter_t *p_filter )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
 
-    if( p_sys->p_src_e )
-        picture_Release( p_sys->p_src_e );
-    if( p_sys->p_dst_e )
-        picture_Release( p_sys->p_dst_e );
-
-    if( p_sys->p_src_a )
-        picture_Release( p_sys->p_src_a );
-    if( p_sys->p_dst_a )
-        picture_Release( p_sys->p_dst_a );
-
-    if( p_sys->ctxA )
-        sws_freeContext( p_sys->ctxA );
-
-    if( p_sys->ctx )
-        sws_freeContext( p_sys->ctx );
-
-    /* We have to set it to null has we call be called again :( */
-    p_sys->ctx = NULL;
-    p_sys->ctxA = NULL;
-    p_sys->p_src_a = NULL;
-    p_sys->p_dst_a = NULL;
-    p_sys->p_src_e = NULL;
-    p_sys->p_dst_e = NULL;
+    for( int i = 0; i < SCALER_CACHE_SIZE; i++ )
+        CleanContext( &p_sys->cache[i] );
+    p_sys->p_ctx = NULL;
+}
+
+/* Minimum picture size and band height worth the slice threads */
+#define SCALER_BAND_MIN_PIXELS (1280 * 720)
+#define SCALER_BAND_MIN_LINES  (64)
+
+/**
+ * Creates one scaler per band of lines.
+ *
+ * Only conversions without vertical resampling are split: the vertical
+ * filters would otherwise need the lines around the band boundaries and
+ * show seams. On failure the picture is simply converted in one piece.
+ */
+static void InitBands( filter_t *p_filter, ScalerContext *p_ctx )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const int i_height = p_ctx->fmt_in.i_height;
+
+    p_ctx->b_bands_init = true;
+    p_ctx->i_band_count = 0;
+
+    if( p_ctx->b_copy || p_ctx->ctxA || p_ctx->i_extend_factor != 1 ||
+        p_ctx->fmt_out.i_height != p_ctx->fmt_in.i_height ||
+        __MAX( p_ctx->fmt_in.i_width, p_ctx->fmt_out.i_width ) * i_height
+            < SCALER_BAND_MIN_PIXELS )
+        return;
+
+    int i_count = __MIN( filter_GetSliceCount( p_filter ), SCALER_BAND_MAX );
+    i_count = __MIN( i_count, i_height / SCALER_BAND_MIN_LINES );
+    if( i_count <= 1 )
+        return;
+
+    for( int i = 0; i < i_count; i++ )
+    {
+        ScalerBand *p_band = &p_ctx->band[i];
+
+        /* Multiple of 4 lines to keep subsampled chroma lines whole */
+        const int i_first = (i_height * i / i_count) & ~3;
+        const int i_last  = i + 1 < i_count ?
+                            (i_height * (i + 1) / i_count) & ~3 : i_height;
+
+        p_band->i_line  = i_first;
+        p_band->i_lines = i_last - i_first;
+        p_band->ctx = sws_getContext( p_ctx->fmt_in.i_width, p_band->i_lines,
+                                      p_ctx->i_fmti,
+                                      p_ctx->fmt_out.i_width, p_band->i_lines,
+                                      p_ctx->i_fmto,
+                                      p_ctx->i_sws_flags | p_sys->i_cpu_mask,
+                                      p_sys->p_src_filter,
+                                      p_sys->p_dst_filter, 0 );
+        if( !p_band->ctx )
+        {
+            CleanBands( p_ctx );
+            return;
+        }
+        p_ctx->i_band_count = i + 1;
+    }
+    msg_Dbg( p_filter, "scaling in %d bands", i_count );
 }
 
 static void GetPixels( uint8_t *pp_pixel[4], int pi_pitch[4],
@@ -483,6 +632,22 @@ static void GetPixels( uint8_t *pp_pixel[4], int pi_pitch[4],
     }
 }
 
+/* Moves the plane pointers from GetPixels() to the given luma line */
+static void OffsetPixels( uint8_t *pp_pixel[4], const int pi_pitch[4],
+                          const picture_t *p_picture, int i_line )
+{
+    if( i_line == 0 )
+        return;
+
+    /* The planes swapped by GetPixels() share the same subsampling */
+    for( int n = 0; n < __MIN( 4, p_picture->i_planes ); n++ )
+    {
+        if( pp_pixel[n] )
+            pp_pixel[n] += pi_pitch[n] * ( i_line * p_picture->p[n].i_lines /
+                                           p_picture->p[0].i_lines );
+    }
+}
+
 static void ExtractA( picture_t *p_dst, const picture_t *p_src, unsigned i_width, unsigned i_height )
 {
     plane_t *d = &p_dst->p[0];
@@ -533,7 +698,8 @@ static void SwapUV( picture_t *p_dst, const picture_t *p_src )
     picture_CopyPixels( p_dst, &tmp );
 }
 static void Convert( filter_t *p_filter, struct SwsContext *ctx,
-                     picture_t *p_dst, picture_t *p_src, int i_height, int i_plane_start, int i_plane_count,
+                     picture_t *p_dst, picture_t *p_src, int i_line, int i_height,
+                     int i_plane_start, int i_plane_count,
                      bool b_swap_uvi, bool b_swap_uvo )
 {
     uint8_t palette[AVPALETTE_SIZE];
@@ -542,6 +708,7 @@ static void Convert( filter_t *p_filter, struct SwsContext *ctx,
     uint8_t *dst[4]; int dst_stride[4];
 
     GetPixels( src, src_stride, p_src, i_plane_start, i_plane_count, b_swap_uvi );
+    OffsetPixels( src, src_stride, p_src, i_line );
     if( p_filter->fmt_in.video.i_chroma == VLC_CODEC_RGBP )
     {
         memset( palette, 0, sizeof(palette) );
@@ -553,6 +720,7 @@ static void Convert( filter_t *p_filter, struct SwsContext *ctx,
     }
 
     GetPixels( dst, dst_stride, p_dst, i_plane_start, i_plane_count, b_swap_uvo );
+    OffsetPixels( dst, dst_stride, p_dst, i_line );
 
 #if LIBSWSCALE_VERSION_INT  >= ((0<<16)+(5<<8)+0)
     sws_scale( ctx, src, src_stride, 0, i_height,
@@ -563,6 +731,26 @@ static void Convert( filter_t *p_filter, struct SwsContext *ctx,
 #endif
 }
 
+typedef struct
+{
+    ScalerContext *p_ctx;
+    picture_t *p_dst;
+    picture_t *p_src;
+} scaler_slice_t;
+
+static void ConvertSlice( filter_t *p_filter, void *p_data,
+                          int i_slice, int i_slice_count )
+{
+    const scaler_slice_t *p_slice = p_data;
+    const ScalerContext *p_ctx = p_slice->p_ctx;
+
+    /* Each band has its own context, so only one slice may use it */
+    for( int i = i_slice; i < p_ctx->i_band_count; i += i_slice_count )
+        Convert( p_filter, p_ctx->band[i].ctx, p_slice->p_dst, p_slice->p_src,
+                 p_ctx->band[i].i_line, p_ctx->band[i].i_lines, 0, 3,
+                 p_ctx->b_swap_uvi, p_ctx->b_swap_uvo );
+}
+
 /****************************************************************************
  * Filter: the whole thing
  ****************************************************************************
@@ -581,6 +769,9 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
         picture_Release( p_pic );
         return NULL;
     }
+    ScalerContext *p_ctx = p_sys->p_ctx;
+    if( !p_ctx->b_bands_init )
+        InitBands( p_filter, p_ctx );
 
     /* Request output picture */
     p_pic_dst = filter_NewPicture( p_filter );
@@ -593,36 +784,41 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
     /* */
     picture_t *p_src = p_pic;
     picture_t *p_dst = p_pic_dst;
-    if( p_sys->i_extend_factor != 1 )
+    if( p_ctx->i_extend_factor != 1 )
     {
-        p_src = p_sys->p_src_e;
-        p_dst = p_sys->p_dst_e;
+        p_src = p_ctx->p_src_e;
+        p_dst = p_ctx->p_dst_e;
 
         CopyPad( p_src, p_pic );
     }
 
-    if( p_sys->b_copy && p_sys->b_swap_uvi == p_sys->b_swap_uvo )
+    if( p_ctx->b_copy && p_ctx->b_swap_uvi == p_ctx->b_swap_uvo )
         picture_CopyPixels( p_dst, p_src );
-    else if( p_sys->b_copy )
+    else if( p_ctx->b_copy )
         SwapUV( p_dst, p_src );
+    else if( p_ctx->i_band_count > 0 )
+    {
+        scaler_slice_t slice = { .p_ctx = p_ctx, .p_dst = p_dst, .p_src = p_src };
+        filter_ExecuteSlices( p_filter, ConvertSlice, &slice );
+    }
     else
-        Convert( p_filter, p_sys->ctx, p_dst, p_src, p_fmti->i_height, 0, 3,
-                 p_sys->b_swap_uvi, p_sys->b_swap_uvo );
-    if( p_sys->ctxA )
+        Convert( p_filter, p_ctx->ctx, p_dst, p_src, 0, p_fmti->i_height, 0, 3,
+                 p_ctx->b_swap_uvi, p_ctx->b_swap_uvo );
+    if( p_ctx->ctxA )
     {
         /* We extract the A plane to rescale it, and then we reinject it. */
         if( p_fmti->i_chroma == VLC_CODEC_RGBA )
-            ExtractA( p_sys->p_src_a, p_src, p_fmti->i_width * p_sys->i_extend_factor, p_fmti->i_height );
+            ExtractA( p_ctx->p_src_a, p_src, p_fmti->i_width * p_ctx->i_extend_factor, p_fmti->i_height );
         else
-            plane_CopyPixels( p_sys->p_src_a->p, p_src->p+A_PLANE );
+            plane_CopyPixels( p_ctx->p_src_a->p, p_src->p+A_PLANE );
 
-        Convert( p_filter, p_sys->ctxA, p_sys->p_dst_a, p_sys->p_src_a, p_fmti->i_height, 0, 1, false, false );
+        Convert( p_filter, p_ctx->ctxA, p_ctx->p_dst_a, p_ctx->p_src_a, 0, p_fmti->i_height, 0, 1, false, false );
         if( p_fmto->i_chroma == VLC_CODEC_RGBA )
-            InjectA( p_dst, p_sys->p_dst_a, p_fmto->i_width * p_sys->i_extend_factor, p_fmto->i_height );
+            InjectA( p_dst, p_ctx->p_dst_a, p_fmto->i_width * p_ctx->i_extend_factor, p_fmto->i_height );
         else
-            plane_CopyPixels( p_dst->p+A_PLANE, p_sys->p_dst_a->p );
+            plane_CopyPixels( p_dst->p+A_PLANE, p_ctx->p_dst_a->p );
     }
-    else if( p_sys->b_add_a )
+    else if( p_ctx->b_add_a )
     {
         /* We inject a complete opaque alpha plane */
         if( p_fmto->i_chroma == VLC_CODEC_RGBA )
@@ -631,7 +827,7 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
             FillA( &p_dst->p[A_PLANE], 0 );
     }
 
-    if( p_sys->i_extend_factor != 1 )
+    if( p_ctx->i_extend_factor != 1 )
     {
         picture_CopyPixels( p_pic_dst, p_dst );
     }
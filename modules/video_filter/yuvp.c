@@ -114,8 +114,20 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
         return NULL;
     }
 
+    /* The palette is expanded into 256 entries lookup tables, the pixels
+     * out of the palette being transparent, so that the inner loops are
+     * free of tests. */
+    const unsigned i_entries = __MIN( p_yuvp->i_entries, 256 );
+
     if( p_filter->fmt_out.video.i_chroma == VLC_CODEC_YUVA )
     {
+        uint8_t lut[4][256];
+
+        memset( lut, 0, sizeof(lut) );
+        for( unsigned i = 0; i < i_entries; i++ )
+            for( unsigned j = 0; j < 4; j++ )
+                lut[j][i] = p_yuvp->palette[i][j];
+
         for( unsigned int y = 0; y < p_filter->fmt_in.video.i_height; y++ )
         {
             const uint8_t *p_line = &p_pic->p->p_pixels[y*p_pic->p->i_pitch];
@@ -126,15 +138,12 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
 
             for( unsigned int x = 0; x < p_filter->fmt_in.video.i_width; x++ )
             {
-                const int v = p_line[x];
+                const uint8_t v = p_line[x];
 
-                if( v > p_yuvp->i_entries )  /* maybe assert ? */
-                    continue;
-
-                p_y[x] = p_yuvp->palette[v][0];
-                p_u[x] = p_yuvp->palette[v][1];
-                p_v[x] = p_yuvp->palette[v][2];
-                p_a[x] = p_yuvp->palette[v][3];
+                p_y[x] = lut[0][v];
+                p_u[x] = lut[1][v];
+                p_v[x] = lut[2][v];
+                p_a[x] = lut[3][v];
             }
         }
     }
@@ -142,14 +151,18 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
     {
         assert( p_filter->fmt_out.video.i_chroma == VLC_CODEC_RGBA );
 
-        /* Create a RGBA palette */
-        video_palette_t rgbp;
-        rgbp.i_entries = p_yuvp->i_entries;
-        for( int i = 0; i < p_yuvp->i_entries; i++ )
+        /* Create a RGBA palette, one pixel per word */
+        uint32_t lut[256];
+
+        memset( lut, 0, sizeof(lut) );
+        for( unsigned i = 0; i < i_entries; i++ )
         {
-            Yuv2Rgb( &rgbp.palette[i][0], &rgbp.palette[i][1], &rgbp.palette[i][2],
+            uint8_t rgba[4];
+
+            Yuv2Rgb( &rgba[0], &rgba[1], &rgba[2],
                      p_yuvp->palette[i][0], p_yuvp->palette[i][1], p_yuvp->palette[i][2] );
-            rgbp.palette[i][3] = p_yuvp->palette[i][3];
+            rgba[3] = p_yuvp->palette[i][3];
+            memcpy( &lut[i], rgba, 4 );
         }
 
         /* */
@@ -159,17 +172,7 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
             uint8_t *p_rgba = &p_out->p->p_pixels[y*p_out->p->i_pitch];
 
             for( unsigned int x = 0; x < p_filter->fmt_in.video.i_width; x++ )
-            {
-                const int v = p_line[x];
-
-                if( v >= rgbp.i_entries )  /* maybe assert ? */
-                    continue;
-
-                p_rgba[4*x+0] = rgbp.palette[v][0];
-                p_rgba[4*x+1] = rgbp.palette[v][1];
-                p_rgba[4*x+2] = rgbp.palette[v][2];
-                p_rgba[4*x+3] = rgbp.palette[v][3];
-            }
+                memcpy( &p_rgba[4*x], &lut[p_line[x]], 4 );
         }
     }
 
@@ -44,6 +44,12 @@
 # define PFNGLPROGRAMLOCALPARAMETER4FVARBPROC typeof(glProgramLocalParameter4fvARB)*
 # define PFNGLACTIVETEXTUREARBPROC            typeof(glActiveTextureARB)*
 # define PFNGLMULTITEXCOORD2FARBPROC          typeof(glMultiTexCoord2fARB)*
+# define PFNGLGENBUFFERSARBPROC               typeof(glGenBuffersARB)*
+# define PFNGLBINDBUFFERARBPROC               typeof(glBindBufferARB)*
+# define PFNGLBUFFERDATAARBPROC               typeof(glBufferDataARB)*
+# define PFNGLMAPBUFFERARBPROC                typeof(glMapBufferARB)*
+# define PFNGLUNMAPBUFFERARBPROC              typeof(glUnmapBufferARB)*
+# define PFNGLDELETEBUFFERSARBPROC            typeof(glDeleteBuffersARB)*
 #endif
 
 /* RV16 */
@@ -54,11 +60,24 @@
 # define GL_CLAMP_TO_EDGE 0x812F
 #endif
 
+/* Pixel buffer objects */
+#ifndef GL_PIXEL_UNPACK_BUFFER_ARB
+# define GL_PIXEL_UNPACK_BUFFER_ARB 0x88EC
+#endif
+#ifndef GL_STREAM_DRAW_ARB
+# define GL_STREAM_DRAW_ARB 0x88E0
+#endif
+#ifndef GL_WRITE_ONLY_ARB
+# define GL_WRITE_ONLY_ARB 0x88B9
+#endif
+
 #if USE_OPENGL_ES
 #   define VLCGL_TEXTURE_COUNT 1
 #   define VLCGL_PICTURE_MAX 1
 #else
-#   define VLCGL_TEXTURE_COUNT 1
+/* The textures are used in turn, so that the upload of a picture does not
+ * wait for the GPU to be done drawing the previous ones */
+#   define VLCGL_TEXTURE_COUNT 3
 #   define VLCGL_PICTURE_MAX 128
 #endif
 
@@ -76,6 +95,10 @@ typedef struct {
 
     float    alpha;
 
+    /* Content of the texture, held to detect unchanged regions */
+    picture_t *picture;
+    int        pixels_offset;
+
     float    top;
     float    left;
     float    bottom;
@@ -89,14 +112,18 @@ struct vout_display_opengl_t {
     const vlc_chroma_description_t *chroma;
 
     int        tex_target;
-    int        tex_format;
-    int        tex_internal;
+    int        tex_format[PICTURE_PLANE_MAX];
+    int        tex_internal[PICTURE_PLANE_MAX];
     int        tex_type;
+    /* Number of chroma samples packed in one texel (2 for NV12 UV) */
+    unsigned   tex_samples[PICTURE_PLANE_MAX];
 
     int        tex_width[PICTURE_PLANE_MAX];
     int        tex_height[PICTURE_PLANE_MAX];
 
     GLuint     texture[VLCGL_TEXTURE_COUNT][PICTURE_PLANE_MAX];
+    GLuint     buffer[VLCGL_TEXTURE_COUNT][PICTURE_PLANE_MAX];
+    unsigned   texture_index; /* last prepared texture */
 
     int         region_count;
     gl_region_t *region;
@@ -119,6 +146,15 @@ struct vout_display_opengl_t {
     bool use_multitexture;
     PFNGLACTIVETEXTUREARBPROC   ActiveTextureARB;
     PFNGLMULTITEXCOORD2FARBPROC MultiTexCoord2fARB;
+
+    /* pixel_buffer_object */
+    bool use_pbo;
+    PFNGLGENBUFFERSARBPROC    GenBuffersARB;
+    PFNGLBINDBUFFERARBPROC    BindBufferARB;
+    PFNGLBUFFERDATAARBPROC    BufferDataARB;
+    PFNGLMAPBUFFERARBPROC     MapBufferARB;
+    PFNGLUNMAPBUFFERARBPROC   UnmapBufferARB;
+    PFNGLDELETEBUFFERSARBPROC DeleteBuffersARB;
 };
 
 static inline int GetAlignedSize(unsigned size)
@@ -217,6 +253,34 @@ vout_display_opengl_t *vout_display_opengl_New(video_format_t *fmt,
             glGetIntegerv(GL_MAX_TEXTURE_UNITS_ARB, &max_texture_units);
     }
 
+    /* Pixel buffer objects let the driver DMA the planes to the texture
+     * asynchronously instead of blocking glTexSubImage2D on the copy */
+#if !USE_OPENGL_ES
+    if (HasExtension(extensions, "GL_ARB_pixel_buffer_object")) {
+# if !defined(MACOS_OPENGL)
+        vgl->GenBuffersARB    = (PFNGLGENBUFFERSARBPROC)vlc_gl_GetProcAddress(vgl->gl, "glGenBuffersARB");
+        vgl->BindBufferARB    = (PFNGLBINDBUFFERARBPROC)vlc_gl_GetProcAddress(vgl->gl, "glBindBufferARB");
+        vgl->BufferDataARB    = (PFNGLBUFFERDATAARBPROC)vlc_gl_GetProcAddress(vgl->gl, "glBufferDataARB");
+        vgl->MapBufferARB     = (PFNGLMAPBUFFERARBPROC)vlc_gl_GetProcAddress(vgl->gl, "glMapBufferARB");
+        vgl->UnmapBufferARB   = (PFNGLUNMAPBUFFERARBPROC)vlc_gl_GetProcAddress(vgl->gl, "glUnmapBufferARB");
+        vgl->DeleteBuffersARB = (PFNGLDELETEBUFFERSARBPROC)vlc_gl_GetProcAddress(vgl->gl, "glDeleteBuffersARB");
+# else
+        vgl->GenBuffersARB    = glGenBuffersARB;
+        vgl->BindBufferARB    = glBindBufferARB;
+        vgl->BufferDataARB    = glBufferDataARB;
+        vgl->MapBufferARB     = glMapBufferARB;
+        vgl->UnmapBufferARB   = glUnmapBufferARB;
+        vgl->DeleteBuffersARB = glDeleteBuffersARB;
+# endif
+        vgl->use_pbo = vgl->GenBuffersARB &&
+                       vgl->BindBufferARB &&
+                       vgl->BufferDataARB &&
+                       vgl->MapBufferARB &&
+                       vgl->UnmapBufferARB &&
+                       vgl->DeleteBuffersARB;
+    }
+#endif
+
     /* Initialize with default chroma */
     vgl->fmt = *fmt;
 #if USE_OPENGL_ES
@@ -231,8 +295,8 @@ vout_display_opengl_t *vout_display_opengl_New(video_format_t *fmt,
     vgl->fmt.i_bmask  = 0x001f;
 #   endif
     vgl->tex_target   = GL_TEXTURE_2D;
-    vgl->tex_format   = GL_RGB;
-    vgl->tex_internal = GL_RGB;
+    vgl->tex_format[0]   = GL_RGB;
+    vgl->tex_internal[0] = GL_RGB;
     vgl->tex_type     = GL_UNSIGNED_SHORT_5_6_5;
 #else
     vgl->fmt.i_chroma = VLC_CODEC_RGB32;
@@ -246,37 +310,61 @@ vout_display_opengl_t *vout_display_opengl_New(video_format_t *fmt,
     vgl->fmt.i_bmask  = 0x00ff0000;
 #   endif
     vgl->tex_target   = GL_TEXTURE_2D;
-    vgl->tex_format   = GL_RGBA;
-    vgl->tex_internal = GL_RGBA;
+    vgl->tex_format[0]   = GL_RGBA;
+    vgl->tex_internal[0] = GL_RGBA;
     vgl->tex_type     = GL_UNSIGNED_BYTE;
 #endif
+    vgl->tex_samples[0] = 1;
     /* Use YUV if possible and needed */
     bool need_fs_yuv = false;
     float yuv_range_correction = 1.0;
-    if (supports_fp && supports_multitexture && max_texture_units >= 3 &&
+    if (supports_fp && supports_multitexture && max_texture_units >= 2 &&
         vlc_fourcc_IsYUV(fmt->i_chroma) && !vlc_fourcc_IsYUV(vgl->fmt.i_chroma)) {
         const vlc_fourcc_t *list = vlc_fourcc_GetYUVFallback(fmt->i_chroma);
         while (*list) {
             const vlc_chroma_description_t *dsc = vlc_fourcc_GetChromaDescription(*list);
-            if (dsc && dsc->plane_count == 3 && dsc->pixel_size == 1) {
+            if (dsc && dsc->plane_count == 3 && dsc->pixel_size == 1 &&
+                max_texture_units >= 3) {
                 need_fs_yuv       = true;
                 vgl->fmt          = *fmt;
                 vgl->fmt.i_chroma = *list;
-                vgl->tex_format   = GL_LUMINANCE;
-                vgl->tex_internal = GL_LUMINANCE;
+                for (unsigned j = 0; j < 3; j++) {
+                    vgl->tex_format[j]   = GL_LUMINANCE;
+                    vgl->tex_internal[j] = GL_LUMINANCE;
+                    vgl->tex_samples[j]  = 1;
+                }
                 vgl->tex_type     = GL_UNSIGNED_BYTE;
                 yuv_range_correction = 1.0;
                 break;
             } else if (dsc && dsc->plane_count == 3 && dsc->pixel_size == 2 &&
+                       max_texture_units >= 3 &&
                        IsLuminance16Supported(vgl->tex_target)) {
                 need_fs_yuv       = true;
                 vgl->fmt          = *fmt;
                 vgl->fmt.i_chroma = *list;
-                vgl->tex_format   = GL_LUMINANCE;
-                vgl->tex_internal = GL_LUMINANCE16;
+                for (unsigned j = 0; j < 3; j++) {
+                    vgl->tex_format[j]   = GL_LUMINANCE;
+                    vgl->tex_internal[j] = GL_LUMINANCE16;
+                    vgl->tex_samples[j]  = 1;
+                }
                 vgl->tex_type     = GL_UNSIGNED_SHORT;
                 yuv_range_correction = (float)((1 << 16) - 1) / ((1 << dsc->pixel_bits) - 1);
                 break;
+            } else if (dsc && dsc->plane_count == 2 && dsc->pixel_size == 1) {
+                /* NV12/NV21: the interleaved chroma plane is uploaded as a
+                 * half width luminance/alpha texture */
+                need_fs_yuv       = true;
+                vgl->fmt          = *fmt;
+                vgl->fmt.i_chroma = *list;
+                vgl->tex_format[0]   = GL_LUMINANCE;
+                vgl->tex_internal[0] = GL_LUMINANCE;
+                vgl->tex_samples[0]  = 1;
+                vgl->tex_format[1]   = GL_LUMINANCE_ALPHA;
+                vgl->tex_internal[1] = GL_LUMINANCE_ALPHA;
+                vgl->tex_samples[1]  = 2;
+                vgl->tex_type     = GL_UNSIGNED_BYTE;
+                yuv_range_correction = 1.0;
+                break;
             }
             list++;
         }
@@ -288,7 +376,7 @@ vout_display_opengl_t *vout_display_opengl_New(video_format_t *fmt,
      * an ATI Radeon 9200 or a NVIDIA GeForceFX 5200 Ultra. */
     else
     {
-        vgl->tex_format   = GL_YCBCR_422_APPLE;
+        vgl->tex_format[0] = GL_YCBCR_422_APPLE;
         vgl->tex_type     = GL_UNSIGNED_SHORT_8_8_APPLE;
         vgl->fmt.i_chroma = VLC_CODEC_YUYV;
     }
@@ -307,7 +395,7 @@ vout_display_opengl_t *vout_display_opengl_New(video_format_t *fmt,
 
     /* Texture size */
     for (unsigned j = 0; j < vgl->chroma->plane_count; j++) {
-        int w = vgl->fmt.i_width  * vgl->chroma->p[j].w.num / vgl->chroma->p[j].w.den;
+        int w = vgl->fmt.i_width  * vgl->chroma->p[j].w.num / vgl->chroma->p[j].w.den / vgl->tex_samples[j];
         int h = vgl->fmt.i_height * vgl->chroma->p[j].h.num / vgl->chroma->p[j].h.den;
         if (supports_npot) {
             vgl->tex_width[j]  = w;
@@ -356,16 +444,41 @@ vout_display_opengl_t *vout_display_opengl_New(video_format_t *fmt,
 
                 "PARAM coefficient[4] = { program.local[0..3] };"
 
+                "TEMP tmp;"
+                "MAD  tmp.rgb,          src.xxxx, coefficient[0], coefficient[3];"
+                "MAD  tmp.rgb,          src.yyyy, coefficient[1], tmp;"
+                "MAD  result.color.rgb, src.zzzz, coefficient[2], tmp;"
+                "END";
+            /* Same with the chroma read from the luminance (first) and
+             * alpha (second) components of a single texture */
+            const char *template_nv =
+                "!!ARBfp1.0"
+                "OPTION ARB_precision_hint_fastest;"
+
+                "TEMP src;"
+                "TEMP uv;"
+                "TEX src.x, fragment.texcoord[0], texture[0], 2D;"
+                "TEX uv,    fragment.texcoord[1], texture[1], 2D;"
+                "MOV src.yz, uv.%s;"
+
+                "PARAM coefficient[4] = { program.local[0..3] };"
+
                 "TEMP tmp;"
                 "MAD  tmp.rgb,          src.xxxx, coefficient[0], coefficient[3];"
                 "MAD  tmp.rgb,          src.yyyy, coefficient[1], tmp;"
                 "MAD  result.color.rgb, src.zzzz, coefficient[2], tmp;"
                 "END";
             bool swap_uv = vgl->fmt.i_chroma == VLC_CODEC_YV12 ||
-                           vgl->fmt.i_chroma == VLC_CODEC_YV9;
-            if (asprintf(&code, template_yuv,
-                         swap_uv ? 'z' : 'y',
-                         swap_uv ? 'y' : 'z') < 0)
+                           vgl->fmt.i_chroma == VLC_CODEC_YV9 ||
+                           vgl->fmt.i_chroma == VLC_CODEC_NV21;
+            int ret;
+            if (vgl->chroma->plane_count == 2)
+                ret = asprintf(&code, template_nv, swap_uv ? "xwxx" : "xxwx");
+            else
+                ret = asprintf(&code, template_yuv,
+                               swap_uv ? 'z' : 'y',
+                               swap_uv ? 'y' : 'z');
+            if (ret < 0)
                 code = NULL;
 
             for (int i = 0; i < 4; i++) {
@@ -411,9 +524,12 @@ vout_display_opengl_t *vout_display_opengl_New(video_format_t *fmt,
 
     /* */
     for (int i = 0; i < VLCGL_TEXTURE_COUNT; i++) {
-        for (int j = 0; j < PICTURE_PLANE_MAX; j++)
+        for (int j = 0; j < PICTURE_PLANE_MAX; j++) {
             vgl->texture[i][j] = 0;
+            vgl->buffer[i][j] = 0;
+        }
     }
+    vgl->texture_index = 0;
     vgl->region_count = 0;
     vgl->region = NULL;
     vgl->pool = NULL;
@@ -436,11 +552,16 @@ void vout_display_opengl_Delete(vout_display_opengl_t *vgl)
 
         glFinish();
         glFlush();
-        for (int i = 0; i < VLCGL_TEXTURE_COUNT; i++)
+        for (int i = 0; i < VLCGL_TEXTURE_COUNT; i++) {
             glDeleteTextures(vgl->chroma->plane_count, vgl->texture[i]);
+            if (vgl->use_pbo && vgl->buffer[i][0])
+                vgl->DeleteBuffersARB(vgl->chroma->plane_count, vgl->buffer[i]);
+        }
         for (int i = 0; i < vgl->region_count; i++) {
             if (vgl->region[i].texture)
                 glDeleteTextures(1, &vgl->region[i].texture);
+            if (vgl->region[i].picture)
+                picture_Release(vgl->region[i].picture);
         }
         free(vgl->region);
 
@@ -504,10 +625,14 @@ picture_pool_t *vout_display_opengl_GetPool(vout_display_opengl_t *vgl, unsigned
 
             /* Call glTexImage2D only once, and use glTexSubImage2D later */
             glTexImage2D(vgl->tex_target, 0,
-                         vgl->tex_internal, vgl->tex_width[j], vgl->tex_height[j],
-                         0, vgl->tex_format, vgl->tex_type, NULL);
+                         vgl->tex_internal[j], vgl->tex_width[j], vgl->tex_height[j],
+                         0, vgl->tex_format[j], vgl->tex_type, NULL);
         }
     }
+    if (vgl->use_pbo) {
+        for (int i = 0; i < VLCGL_TEXTURE_COUNT; i++)
+            vgl->GenBuffersARB(vgl->chroma->plane_count, vgl->buffer[i]);
+    }
 
     vlc_gl_Unlock(vgl->gl);
 
@@ -541,18 +666,49 @@ int vout_display_opengl_Prepare(vout_display_opengl_t *vgl,
     if (vlc_gl_Lock(vgl->gl))
         return VLC_EGENERIC;
 
-    /* Update the texture */
+    /* Update the texture that was displayed the longest time ago */
+    const unsigned index = (vgl->texture_index + 1) % VLCGL_TEXTURE_COUNT;
     for (unsigned j = 0; j < vgl->chroma->plane_count; j++) {
+        const void *pixels = picture->p[j].p_pixels;
+        const GLuint buffer = vgl->buffer[index][j];
+
         if (vgl->use_multitexture)
             vgl->ActiveTextureARB(GL_TEXTURE0_ARB + j);
-        glBindTexture(vgl->tex_target, vgl->texture[0][j]);
-        glPixelStorei(GL_UNPACK_ROW_LENGTH, picture->p[j].i_pitch / picture->p[j].i_pixel_pitch);
+        glBindTexture(vgl->tex_target, vgl->texture[index][j]);
+
+        if (vgl->use_pbo && buffer) {
+            /* Orphan the previous storage so that the copy never waits for
+             * the transfer of the last frame, and let the driver upload
+             * from the buffer asynchronously */
+            const size_t size = picture->p[j].i_pitch * picture->p[j].i_lines;
+            vgl->BindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, buffer);
+            vgl->BufferDataARB(GL_PIXEL_UNPACK_BUFFER_ARB, size, NULL,
+                               GL_STREAM_DRAW_ARB);
+            void *mapped = vgl->MapBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB,
+                                             GL_WRITE_ONLY_ARB);
+            if (mapped) {
+                memcpy(mapped, pixels, size);
+                vgl->UnmapBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB);
+                pixels = NULL; /* offset in the buffer */
+            } else {
+                vgl->BindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+            }
+        }
+
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, picture->p[j].i_pitch
+                      / picture->p[j].i_pixel_pitch / vgl->tex_samples[j]);
         glTexSubImage2D(vgl->tex_target, 0,
                         0, 0,
-                        vgl->fmt.i_width  * vgl->chroma->p[j].w.num / vgl->chroma->p[j].w.den,
+                        vgl->fmt.i_width  * vgl->chroma->p[j].w.num / vgl->chroma->p[j].w.den / vgl->tex_samples[j],
                         vgl->fmt.i_height * vgl->chroma->p[j].h.num / vgl->chroma->p[j].h.den,
-                        vgl->tex_format, vgl->tex_type, picture->p[j].p_pixels);
+                        vgl->tex_format[j], vgl->tex_type, pixels);
+
+        if (vgl->use_pbo && buffer)
+            vgl->BindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
     }
+    vgl->texture_index = index;
+    /* Start the transfers now rather than when the picture is displayed */
+    glFlush();
 
     int         last_count = vgl->region_count;
     gl_region_t *last = vgl->region;
@@ -585,22 +741,33 @@ int vout_display_opengl_Prepare(vout_display_opengl_t *vgl,
             glr->right  =  2.0 * (r->i_x + r->fmt.i_visible_width ) / subpicture->i_original_picture_width  - 1.0;
             glr->bottom = -2.0 * (r->i_y + r->fmt.i_visible_height) / subpicture->i_original_picture_height + 1.0;
 
+            const int pixels_offset = r->fmt.i_y_offset * r->p_picture->p->i_pitch +
+                                      r->fmt.i_x_offset * r->p_picture->p->i_pixel_pitch;
+            glr->picture       = picture_Hold(r->p_picture);
+            glr->pixels_offset = pixels_offset;
+
             glr->texture = 0;
+            bool unchanged = false;
             for (int j = 0; j < last_count; j++) {
                 if (last[j].texture &&
                     last[j].width  == glr->width &&
                     last[j].height == glr->height &&
                     last[j].format == glr->format &&
                     last[j].type   == glr->type) {
+                    /* Static subtitles and OSD keep the same picture */
+                    unchanged = last[j].picture       == glr->picture &&
+                                last[j].pixels_offset == pixels_offset;
                     glr->texture = last[j].texture;
+                    if (last[j].picture)
+                        picture_Release(last[j].picture);
                     memset(&last[j], 0, sizeof(last[j]));
                     break;
                 }
             }
 
-            const int pixels_offset = r->fmt.i_y_offset * r->p_picture->p->i_pitch +
-                                      r->fmt.i_x_offset * r->p_picture->p->i_pixel_pitch;
-            if (glr->texture) {
+            if (unchanged) {
+                /* Nothing to upload */
+            } else if (glr->texture) {
                 glBindTexture(GL_TEXTURE_2D, glr->texture);
                 /* TODO set GL_UNPACK_ALIGNMENT */
                 glPixelStorei(GL_UNPACK_ROW_LENGTH, r->p_picture->p->i_pitch / r->p_picture->p->i_pixel_pitch);
@@ -627,6 +794,8 @@ int vout_display_opengl_Prepare(vout_display_opengl_t *vgl,
     for (int i = 0; i < last_count; i++) {
         if (last[i].texture)
             glDeleteTextures(1, &last[i].texture);
+        if (last[i].picture)
+            picture_Release(last[i].picture);
     }
     free(last);
 
@@ -650,7 +819,7 @@ int vout_display_opengl_Display(vout_display_opengl_t *vgl,
     for (unsigned j = 0; j < vgl->chroma->plane_count; j++) {
         float scale_w, scale_h;
         if (vgl->tex_target == GL_TEXTURE_2D) {
-            scale_w = (float)vgl->chroma->p[j].w.num / vgl->chroma->p[j].w.den / vgl->tex_width[j];
+            scale_w = (float)vgl->chroma->p[j].w.num / vgl->chroma->p[j].w.den / vgl->tex_samples[j] / vgl->tex_width[j];
             scale_h = (float)vgl->chroma->p[j].h.num / vgl->chroma->p[j].h.den / vgl->tex_height[j];
 
         } else {
@@ -703,7 +872,7 @@ int vout_display_opengl_Display(vout_display_opengl_t *vgl,
     for (unsigned j = 0; j < vgl->chroma->plane_count; j++) {
         if (vgl->use_multitexture)
             vgl->ActiveTextureARB(GL_TEXTURE0_ARB + j);
-        glBindTexture(vgl->tex_target, vgl->texture[0][j]);
+        glBindTexture(vgl->tex_target, vgl->texture[vgl->texture_index][j]);
     }
     glBegin(GL_POLYGON);
 
@@ -84,6 +84,7 @@ vlc_module_end()
 struct picture_sys_t {
     vout_display_sys_t *sys;
     void *id;
+    unsigned index; /* in the application pool */
 };
 
 /* NOTE: the callback prototypes must match those of LibVLC */
@@ -97,6 +98,12 @@ struct vout_display_sys_t {
     void (*display)(void *sys, void *id);
     void (*cleanup)(void *sys);
 
+    /* Pool of application buffers, instead of lock/unlock */
+    int  (*buffer)(void *sys, unsigned index, unsigned count, void **plane);
+    void (*acquire)(void *sys, unsigned index);
+    void (*release)(void *sys, unsigned index);
+    void (*present)(void *sys, unsigned index);
+
     unsigned pitches[PICTURE_PLANE_MAX];
     unsigned lines[PICTURE_PLANE_MAX];
 };
@@ -110,6 +117,8 @@ static int            Control(vout_display_t *, int, va_list);
 
 static int            Lock(picture_t *);
 static void           Unlock(picture_t *);
+static int            Acquire(picture_t *);
+static void           Release(picture_t *);
 
 /*****************************************************************************
  * Open: allocates video thread
@@ -127,11 +136,20 @@ static int Open(vlc_object_t *object)
     vlc_format_cb setup = var_InheritAddress(vd, "vmem-setup");
 
     sys->lock = var_InheritAddress(vd, "vmem-lock");
-    if (sys->lock == NULL) {
+    sys->buffer = var_InheritAddress(vd, "vmem-buffer");
+    if (sys->lock == NULL && sys->buffer == NULL) {
         msg_Err(vd, "missing lock callback");
         free(sys);
         return VLC_EGENERIC;
     }
+    if (sys->buffer != NULL && setup == NULL) {
+        msg_Err(vd, "missing format callback for the buffer pool");
+        free(sys);
+        return VLC_EGENERIC;
+    }
+    sys->acquire = var_InheritAddress(vd, "vmem-acquire");
+    sys->release = var_InheritAddress(vd, "vmem-release");
+    sys->present = var_InheritAddress(vd, "vmem-present");
     sys->unlock = var_InheritAddress(vd, "vmem-unlock");
     sys->display = var_InheritAddress(vd, "vmem-display");
     sys->cleanup = var_InheritAddress(vd, "vmem-cleanup");
@@ -254,6 +272,16 @@ static picture_pool_t *Pool(vout_display_t *vd, unsigned count)
 
     for (unsigned i = 0; i < count; i++) {
         picture_resource_t rsc;
+        void *planes[PICTURE_PLANE_MAX] = { NULL };
+
+        /* The application buffers are mapped once and for all: the decoder
+         * can render straight into them. Otherwise, vmem-lock provides the
+         * pixels whenever a picture is taken from the pool. */
+        if (sys->buffer != NULL
+         && sys->buffer(sys->opaque, i, count, planes)) {
+            count = i;
+            break;
+        }
 
         rsc.p_sys = malloc(sizeof(*rsc.p_sys));
         if (unlikely(!rsc.p_sys)) {
@@ -263,10 +291,10 @@ static picture_pool_t *Pool(vout_display_t *vd, unsigned count)
 
         rsc.p_sys->sys = sys;
         rsc.p_sys->id = NULL;
+        rsc.p_sys->index = i;
 
         for (unsigned i = 0; i < PICTURE_PLANE_MAX; i++) {
-            /* vmem-lock is responsible for the allocation */
-            rsc.p[i].p_pixels = NULL;
+            rsc.p[i].p_pixels = planes[i];
             rsc.p[i].i_lines  = sys->lines[i];
             rsc.p[i].i_pitch  = sys->pitches[i];
         }
@@ -284,8 +312,8 @@ static picture_pool_t *Pool(vout_display_t *vd, unsigned count)
     memset(&pool, 0, sizeof(pool));
     pool.picture_count = count;
     pool.picture       = pictures;
-    pool.lock          = Lock;
-    pool.unlock        = Unlock;
+    pool.lock          = (sys->buffer != NULL) ? Acquire : Lock;
+    pool.unlock        = (sys->buffer != NULL) ? Release : Unlock;
     sys->pool = picture_pool_NewExtended(&pool);
     if (!sys->pool) {
         for (unsigned i = 0; i < count; i++)
@@ -300,7 +328,10 @@ static void Display(vout_display_t *vd, picture_t *picture, subpicture_t *subpic
     vout_display_sys_t *sys = vd->sys;
 
     assert(!picture_IsReferenced(picture));
-    if (sys->display != NULL)
+    if (sys->buffer != NULL) {
+        if (sys->present != NULL)
+            sys->present(sys->opaque, picture->p_sys->index);
+    } else if (sys->display != NULL)
         sys->display(sys->opaque, picture->p_sys->id);
     picture_Release(picture);
     VLC_UNUSED(subpicture);
@@ -352,3 +383,24 @@ static void Unlock(picture_t *picture)
     if (sys->unlock != NULL)
         sys->unlock(sys->opaque, picsys->id, planes);
 }
+
+/* Application buffer pool: the pixels never move, the application is only
+ * told when LibVLC takes a buffer and gives it back */
+static int Acquire(picture_t *picture)
+{
+    picture_sys_t *picsys = picture->p_sys;
+    vout_display_sys_t *sys = picsys->sys;
+
+    if (sys->acquire != NULL)
+        sys->acquire(sys->opaque, picsys->index);
+    return VLC_SUCCESS;
+}
+
+static void Release(picture_t *picture)
+{
+    picture_sys_t *picsys = picture->p_sys;
+    vout_display_sys_t *sys = picsys->sys;
+
+    if (sys->release != NULL)
+        sys->release(sys->opaque, picsys->index);
+}
@@ -36,8 +36,6 @@
 #include "visual.h"
 #include <math.h>
 
-#include "fft.h"
-
 #define PEAK_SPEED 1
 #define BAR_DECREASE_SPEED 5
 
@@ -49,10 +47,11 @@
  * dummy_Run
  *****************************************************************************/
 int dummy_Run( visual_effect_t * p_effect, vlc_object_t *p_aout,
-               const block_t * p_buffer , picture_t * p_picture)
+               const block_t * p_buffer ,
+               const visual_analysis_t * p_analysis, picture_t * p_picture)
 {
     VLC_UNUSED(p_effect); VLC_UNUSED(p_aout); VLC_UNUSED(p_buffer);
-    VLC_UNUSED(p_picture);
+    VLC_UNUSED(p_analysis); VLC_UNUSED(p_picture);
     return 0;
 }
 
@@ -60,10 +59,11 @@ int dummy_Run( visual_effect_t * p_effect, vlc_object_t *p_aout,
  * spectrum_Run: spectrum analyser
  *****************************************************************************/
 int spectrum_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
-                 const block_t * p_buffer , picture_t * p_picture)
+                 const block_t * p_buffer ,
+                 const visual_analysis_t * p_analysis, picture_t * p_picture)
 {
+    VLC_UNUSED(p_buffer);
     spectrum_data *p_data = p_effect->p_data;
-    float p_output[FFT_BUFFER_SIZE];  /* Raw FFT Result  */
     int *height;                      /* Bar heights */
     int *peaks;                       /* Peaks */
     int *prev_heights;                /* Previous bar heights */
@@ -86,19 +86,9 @@ int spectrum_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
      110,115,121,130,141,152,163,174,185,200,255};
     const int *xscale;
 
-    fft_state *p_state;                 /* internal FFT data */
-
     int i , j , y , k;
     int i_line;
-    int16_t p_dest[FFT_BUFFER_SIZE];      /* Adapted FFT result */
-    int16_t p_buffer1[FFT_BUFFER_SIZE];   /* Buffer on which we perform
-                                             the FFT (first channel) */
-
-    float *p_buffl =                     /* Original buffer */
-            (float*)p_buffer->p_buffer;
-
-    int16_t  *p_buffs;                    /* int16_t converted buffer */
-    int16_t  *p_s16_buff;                 /* int16_t converted buffer */
+    int16_t p_dest[FFT_BUFFER_SIZE / 2 + 1]; /* Adapted FFT result */
 
     /* Create p_data if needed */
     if( !p_data )
@@ -109,26 +99,10 @@ int spectrum_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
 
         p_data->peaks = calloc( 80, sizeof(int) );
         p_data->prev_heights = calloc( 80, sizeof(int) );
-
-        p_data->i_prev_nb_samples = 0;
-        p_data->p_prev_s16_buff = NULL;
     }
     peaks = (int *)p_data->peaks;
     prev_heights = (int *)p_data->prev_heights;
 
-    /* Allocate the buffer only if the number of samples change */
-    if( p_buffer->i_nb_samples != p_data->i_prev_nb_samples )
-    {
-        free( p_data->p_prev_s16_buff );
-        p_data->p_prev_s16_buff = malloc( p_buffer->i_nb_samples *
-                                          p_effect->i_nb_chans *
-                                          sizeof(int16_t));
-        p_data->i_prev_nb_samples = p_buffer->i_nb_samples;
-        if( !p_data->p_prev_s16_buff )
-            return -1;
-    }
-    p_buffs = p_s16_buff = p_data->p_prev_s16_buff;
-
     i_80_bands = var_InheritInteger( p_aout, "visual-80-bands" );
     i_peak     = var_InheritInteger( p_aout, "visual-peaks" );
 
@@ -148,39 +122,8 @@ int spectrum_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
     {
         return -1;
     }
-    /* Convert the buffer to int16_t  */
-    /* Pasted from float32tos16.c */
-    for (i = p_buffer->i_nb_samples * p_effect->i_nb_chans; i--; )
-    {
-        union { float f; int32_t i; } u;
-        u.f = *p_buffl + 384.0;
-        if(u.i >  0x43c07fff ) * p_buffs = 32767;
-        else if ( u.i < 0x43bf8000 ) *p_buffs = -32768;
-        else *p_buffs = u.i - 0x43c00000;
-
-        p_buffl++ ; p_buffs++ ;
-    }
-    p_state  = visual_fft_init();
-    if( !p_state)
-    {
-        free( height );
-        msg_Err(p_aout,"unable to initialize FFT transform");
-        return -1;
-    }
-    p_buffs = p_s16_buff;
-    for ( i = 0 ; i < FFT_BUFFER_SIZE ; i++)
-    {
-        p_output[i]  = 0;
-        p_buffer1[i] = *p_buffs;
-
-        p_buffs += p_effect->i_nb_chans;
-        if( p_buffs >= &p_s16_buff[p_buffer->i_nb_samples * p_effect->i_nb_chans] )
-            p_buffs = p_s16_buff;
-
-    }
-    fft_perform( p_buffer1, p_output, p_state);
-    for( i = 0; i< FFT_BUFFER_SIZE ; i++ )
-        p_dest[i] = p_output[i] *  ( 2 ^ 16 ) / ( ( FFT_BUFFER_SIZE / 2 * 32768 ) ^ 2 );
+    for( i = 0; i < FFT_BUFFER_SIZE / 2 + 1; i++ )
+        p_dest[i] = p_analysis->fft[i] *  ( 2 ^ 16 ) / ( ( FFT_BUFFER_SIZE / 2 * 32768 ) ^ 2 );
 
     /* Compute the horizontal position of the first band */
     i_band_width = floor( p_effect->i_width / i_nb_bands);
@@ -325,8 +268,6 @@ int spectrum_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
         }
     }
 
-    fft_close( p_state );
-
     free( height );
 
     return 0;
@@ -337,12 +278,14 @@ int spectrum_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
  * spectrometer_Run: derivative spectrum analysis
  *****************************************************************************/
 int spectrometer_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
-                     const block_t * p_buffer , picture_t * p_picture)
+                     const block_t * p_buffer ,
+                     const visual_analysis_t * p_analysis,
+                     picture_t * p_picture)
 {
 #define Y(R,G,B) ((uint8_t)( (R * .299) + (G * .587) + (B * .114) ))
 #define U(R,G,B) ((uint8_t)( (R * -.169) + (G * -.332) + (B * .500) + 128 ))
 #define V(R,G,B) ((uint8_t)( (R * .500) + (G * -.419) + (B * -.0813) + 128 ))
-    float p_output[FFT_BUFFER_SIZE];  /* Raw FFT Result  */
+    VLC_UNUSED(p_buffer);
     int *height;                      /* Bar heights */
     int *peaks;                       /* Peaks */
     int i_80_bands;                   /* number of bands : 80 if true else 20 */
@@ -383,18 +326,9 @@ int spectrometer_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
     const int *xscale;
     const double y_scale =  3.60673760222;  /* (log 256) */
 
-    fft_state *p_state;                 /* internal FFT data */
-
     int i , j , k;
     int i_line = 0;
-    int16_t p_dest[FFT_BUFFER_SIZE];      /* Adapted FFT result */
-    int16_t p_buffer1[FFT_BUFFER_SIZE];   /* Buffer on which we perform
-                                             the FFT (first channel) */
-    float *p_buffl =                     /* Original buffer */
-            (float*)p_buffer->p_buffer;
-
-    int16_t  *p_buffs;                    /* int16_t converted buffer */
-    int16_t  *p_s16_buff;                /* int16_t converted buffer */
+    int16_t p_dest[FFT_BUFFER_SIZE / 2 + 1]; /* Adapted FFT result */
 
     /* Create the data struct if needed */
     spectrometer_data *p_data = p_effect->p_data;
@@ -409,25 +343,10 @@ int spectrometer_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
             free( p_data );
             return -1;
         }
-        p_data->i_prev_nb_samples = 0;
-        p_data->p_prev_s16_buff = NULL;
         p_effect->p_data = (void*)p_data;
     }
     peaks = p_data->peaks;
 
-    /* Allocate the buffer only if the number of samples change */
-    if( p_buffer->i_nb_samples != p_data->i_prev_nb_samples )
-    {
-        free( p_data->p_prev_s16_buff );
-        p_data->p_prev_s16_buff = malloc( p_buffer->i_nb_samples *
-                                          p_effect->i_nb_chans *
-                                          sizeof(int16_t));
-        p_data->i_prev_nb_samples = p_buffer->i_nb_samples;
-        if( !p_data->p_prev_s16_buff )
-            return -1;
-    }
-    p_buffs = p_s16_buff = p_data->p_prev_s16_buff;
-
     i_original     = var_InheritInteger( p_aout, "spect-show-original" );
     i_80_bands     = var_InheritInteger( p_aout, "spect-80-bands" );
     i_separ        = var_InheritInteger( p_aout, "spect-separ" );
@@ -456,39 +375,9 @@ int spectrometer_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
     if( !height)
         return -1;
 
-    /* Convert the buffer to int16_t  */
-    /* Pasted from float32tos16.c */
-    for (i = p_buffer->i_nb_samples * p_effect->i_nb_chans; i--; )
+    for(i = 0; i < FFT_BUFFER_SIZE / 2 + 1; i++)
     {
-        union { float f; int32_t i; } u;
-        u.f = *p_buffl + 384.0;
-        if(u.i >  0x43c07fff ) * p_buffs = 32767;
-        else if ( u.i < 0x43bf8000 ) *p_buffs = -32768;
-        else *p_buffs = u.i - 0x43c00000;
-
-        p_buffl++ ; p_buffs++ ;
-    }
-    p_state  = visual_fft_init();
-    if( !p_state)
-    {
-        msg_Err(p_aout,"unable to initialize FFT transform");
-        free( height );
-        return -1;
-    }
-    p_buffs = p_s16_buff;
-    for ( i = 0 ; i < FFT_BUFFER_SIZE; i++)
-    {
-        p_output[i]    = 0;
-        p_buffer1[i] = *p_buffs;
-
-        p_buffs += p_effect->i_nb_chans;
-        if( p_buffs >= &p_s16_buff[p_buffer->i_nb_samples * p_effect->i_nb_chans] )
-            p_buffs = p_s16_buff;
-    }
-    fft_perform( p_buffer1, p_output, p_state);
-    for(i = 0; i < FFT_BUFFER_SIZE; i++)
-    {
-        int sqrti = sqrt(p_output[i]);
+        int sqrti = sqrt(p_analysis->fft[i]);
         p_dest[i] = sqrti >> 8;
     }
 
@@ -782,8 +671,6 @@ int spectrometer_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
         }
     }
 
-    fft_close( p_state );
-
     free( height );
 
     return 0;
@@ -794,9 +681,10 @@ int spectrometer_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
  * scope_Run: scope effect
  *****************************************************************************/
 int scope_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
-              const block_t * p_buffer , picture_t * p_picture)
+              const block_t * p_buffer ,
+              const visual_analysis_t * p_analysis, picture_t * p_picture)
 {
-    VLC_UNUSED(p_aout);
+    VLC_UNUSED(p_aout); VLC_UNUSED(p_analysis);
 
     int i_index;
     float *p_sample ;
@@ -851,31 +739,14 @@ int scope_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
  * vuMeter_Run: vu meter effect
  *****************************************************************************/
 int vuMeter_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
-                const block_t * p_buffer , picture_t * p_picture)
+                const block_t * p_buffer ,
+                const visual_analysis_t * p_analysis, picture_t * p_picture)
 {
-    VLC_UNUSED(p_aout);
-    float i_value_l = 0;
-    float i_value_r = 0;
-
-    /* Compute the peack values */
-    for ( unsigned i = 0 ; i < p_buffer->i_nb_samples; i++ )
-    {
-        const float *p_sample = (float *)p_buffer->p_buffer;
-        float ch;
-
-        ch = p_sample[p_effect->i_idx_left] * 256;
-        if (ch > i_value_l)
-            i_value_l = ch;
-
-        ch = p_sample[p_effect->i_idx_right] * 256;
-        if (ch > i_value_r)
-            i_value_r = ch;
-
-        p_sample += p_effect->i_nb_chans;
-    }
+    VLC_UNUSED(p_aout); VLC_UNUSED(p_buffer);
 
-    i_value_l = abs(i_value_l);
-    i_value_r = abs(i_value_r);
+    /* Scale the RMS so that a full scale sine reaches the former peak value */
+    float i_value_l = p_analysis->rms[p_effect->i_idx_left] * 256 * M_SQRT2;
+    float i_value_r = p_analysis->rms[p_effect->i_idx_right] * 256 * M_SQRT2;
 
     /* Stay under maximum value admited */
     if ( i_value_l > 200 * M_PI_2 )
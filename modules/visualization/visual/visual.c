@@ -33,6 +33,7 @@
 #include <vlc_vout.h>
 #include <vlc_aout.h>
 #include <vlc_filter.h>
+#include <math.h>
 
 #include "visual.h"
 
@@ -152,11 +153,12 @@ vlc_module_end ()
  * Local prototypes
  *****************************************************************************/
 static block_t *DoWork( filter_t *, block_t * );
+static void *Thread( void * );
 static const struct
 {
     const char *psz_name;
     int  (*pf_run)( visual_effect_t *, vlc_object_t *,
-                    const block_t *, picture_t *);
+                    const block_t *, const visual_analysis_t *, picture_t *);
 } pf_effect_run[]=
 {
     { "scope",        scope_Run },
@@ -200,6 +202,7 @@ static int Open( vlc_object_t *p_this )
 
     p_sys->i_effect = 0;
     p_sys->effect   = NULL;
+    p_sys->i_nb_chans = aout_FormatNbChannels( &p_filter->fmt_in.audio );
 
     /* Parse the effect list */
     psz_parser = psz_effects = var_CreateGetString( p_filter, "effect-list" );
@@ -213,7 +216,7 @@ static int Open( vlc_object_t *p_this )
             break;
         p_effect->i_width     = p_sys->i_width;
         p_effect->i_height    = p_sys->i_height;
-        p_effect->i_nb_chans  = aout_FormatNbChannels( &p_filter->fmt_in.audio);
+        p_effect->i_nb_chans  = p_sys->i_nb_chans;
         p_effect->i_idx_left  = 0;
         p_effect->i_idx_right = __MIN( 1, p_effect->i_nb_chans-1 );
 
@@ -297,37 +300,139 @@ static int Open( vlc_object_t *p_this )
     if( p_sys->p_vout == NULL )
     {
         msg_Err( p_filter, "no suitable vout module" );
-        for( int i = 0; i < p_sys->i_effect; i++ )
-        {
-            free( p_sys->effect[i]->psz_args );
-            free( p_sys->effect[i] );
-        }
-        free( p_sys->effect );
-        free( p_sys );
-        return VLC_EGENERIC;
+        goto error;
+    }
+
+    /* The analysis is done once per buffer for all the effects */
+    p_sys->p_fft = visual_fft_init();
+    if( p_sys->p_fft == NULL )
+    {
+        msg_Err( p_filter, "unable to initialize FFT transform" );
+        goto error;
+    }
+    for( unsigned i = 0; i < FFT_BUFFER_SIZE; i++ )
+        p_sys->window[i] = 0.5 - 0.5 * cos( 2 * M_PI * i / FFT_BUFFER_SIZE );
+
+    /* Drawing and waiting for pictures is done away from the audio path */
+    p_sys->p_fifo = block_FifoNew();
+    if( p_sys->p_fifo == NULL )
+        goto error;
+    if( vlc_clone( &p_sys->thread, Thread, p_filter,
+                   VLC_THREAD_PRIORITY_LOW ) )
+    {
+        msg_Err( p_filter, "cannot launch visualizer thread" );
+        block_FifoRelease( p_sys->p_fifo );
+        goto error;
     }
 
     p_filter->pf_audio_filter = DoWork;
 
     return VLC_SUCCESS;
+
+error:
+    if( p_sys->p_vout != NULL )
+    {
+        fft_close( p_sys->p_fft );
+        /* Releasing the video output returns NULL */
+        p_sys->p_vout = aout_filter_RequestVout( p_filter, p_sys->p_vout,
+                                                 NULL );
+    }
+    for( int i = 0; i < p_sys->i_effect; i++ )
+    {
+        free( p_sys->effect[i]->psz_args );
+        free( p_sys->effect[i] );
+    }
+    free( p_sys->effect );
+    free( p_sys );
+    return VLC_EGENERIC;
 }
 
+/* Maximum number of buffers waiting for the rendering thread */
+#define MAX_BLOCKS 8
+
 /*****************************************************************************
- * DoWork: convert a buffer
+ * DoWork: queue a copy of the buffer for the rendering thread
  *****************************************************************************
  * Audio part pasted from trivial.c
  ****************************************************************************/
 static block_t *DoWork( filter_t *p_filter, block_t *p_in_buf )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    /* If the rendering is late, skip a picture rather than the audio */
+    if( block_FifoCount( p_sys->p_fifo ) < MAX_BLOCKS )
+    {
+        block_t *p_block = block_Duplicate( p_in_buf );
+        if( likely(p_block != NULL) )
+            block_FifoPut( p_sys->p_fifo, p_block );
+    }
+    return p_in_buf;
+}
+
+/*****************************************************************************
+ * Analyse: compute what the effects need from a buffer
+ *****************************************************************************/
+static void Analyse( filter_sys_t *p_sys, const block_t *p_block )
+{
+    visual_analysis_t *p_analysis = &p_sys->analysis;
+    const float *p_sample = (const float *)p_block->p_buffer;
+    const unsigned i_nb_chans = p_sys->i_nb_chans;
+    const unsigned i_nb_samples = p_block->i_nb_samples;
+    sound_sample p_fft_in[FFT_BUFFER_SIZE];
+    float sum[AOUT_CHAN_MAX] = { 0. };
+
+    if( i_nb_samples == 0 )
+    {
+        memset( p_analysis, 0, sizeof(*p_analysis) );
+        return;
+    }
+
+    /* Windowed spectrum of the first channel. Short buffers are repeated to
+     * fill the transform. */
+    for( unsigned i = 0, j = 0; i < FFT_BUFFER_SIZE; i++ )
+    {
+        float f = p_sample[j * i_nb_chans] * p_sys->window[i] * 32768.f;
+
+        if( f >= 32767.f )
+            p_fft_in[i] = 32767;
+        else if( f <= -32768.f )
+            p_fft_in[i] = -32768;
+        else
+            p_fft_in[i] = f;
+        if( ++j == i_nb_samples )
+            j = 0;
+    }
+    fft_perform( p_fft_in, p_analysis->fft, p_sys->p_fft );
+    /* Make up for the window, which halves the amplitude */
+    for( unsigned i = 0; i < FFT_BUFFER_SIZE / 2 + 1; i++ )
+        p_analysis->fft[i] *= 4.f;
+
+    for( unsigned i = 0; i < i_nb_samples; i++ )
+        for( unsigned c = 0; c < i_nb_chans; c++ )
+        {
+            const float f = *(p_sample++);
+            sum[c] += f * f;
+        }
+    for( unsigned c = 0; c < i_nb_chans; c++ )
+        p_analysis->rms[c] = sqrtf( sum[c] / i_nb_samples );
+}
+
+/*****************************************************************************
+ * Render: draw the effects for a buffer
+ *****************************************************************************/
+static void Render( filter_t *p_filter, block_t *p_in_buf )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
     picture_t *p_outpic;
 
+    Analyse( p_sys, p_in_buf );
+
     /* First, get a new picture */
     while( ( p_outpic = vout_GetPicture( p_sys->p_vout ) ) == NULL)
     {   /* XXX: This looks like a bad idea. Don't run to me for sympathy if it
          * dead locks... */
         if( !vlc_object_alive (p_sys->p_vout) )
-            return NULL;
+            return;
         msleep( VOUT_OUTMEM_SLEEP );
     }
 
@@ -345,7 +450,7 @@ static block_t *DoWork( filter_t *p_filter, block_t *p_in_buf )
         if( p_effect->pf_run )
         {
             p_effect->pf_run( p_effect, VLC_OBJECT(p_filter),
-                              p_in_buf, p_outpic );
+                              p_in_buf, &p_sys->analysis, p_outpic );
         }
 #undef p_effect
     }
@@ -353,7 +458,25 @@ static block_t *DoWork( filter_t *p_filter, block_t *p_in_buf )
     p_outpic->date = p_in_buf->i_pts + (p_in_buf->i_length / 2);
 
     vout_PutPicture( p_sys->p_vout, p_outpic );
-    return p_in_buf;
+}
+
+/*****************************************************************************
+ * Thread: render the queued buffers
+ *****************************************************************************/
+static void *Thread( void *p_data )
+{
+    filter_t *p_filter = p_data;
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    for( ;; )
+    {
+        block_t *p_block = block_FifoGet( p_sys->p_fifo );
+
+        vlc_cleanup_push( (void (*)(void *))block_Release, p_block );
+        Render( p_filter, p_block );
+        vlc_cleanup_run();
+    }
+    return NULL;
 }
 
 /*****************************************************************************
@@ -364,9 +487,15 @@ static void Close( vlc_object_t *p_this )
     filter_t * p_filter = (filter_t *)p_this;
     filter_sys_t *p_sys = p_filter->p_sys;
 
+    vlc_cancel( p_sys->thread );
+    vlc_join( p_sys->thread, NULL );
+    block_FifoRelease( p_sys->p_fifo );
+    fft_close( p_sys->p_fft );
+
     if( p_filter->p_sys->p_vout )
     {
-        aout_filter_RequestVout( p_filter, p_filter->p_sys->p_vout, 0 );
+        p_sys->p_vout = aout_filter_RequestVout( p_filter, p_sys->p_vout,
+                                                 NULL );
     }
 
     /* Free the list */
@@ -380,13 +509,11 @@ static void Close( vlc_object_t *p_this )
                 spectrum_data* p_data = p_effect->p_data;
                 free( p_data->peaks );
                 free( p_data->prev_heights );
-                free( p_data->p_prev_s16_buff );
             }
             if( !strncmp( p_effect->psz_name, "spectrometer", strlen( "spectrometer" ) ) )
             {
                 spectrometer_data* p_data = p_effect->p_data;
                 free( p_data->peaks );
-                free( p_data->p_prev_s16_buff );
             }
             free( p_effect->p_data );
         }
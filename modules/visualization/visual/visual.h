@@ -21,12 +21,24 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
  *****************************************************************************/
 
+#include "fft.h"
+
+/* Analysis of an audio buffer, computed once and shared by all effects */
+typedef struct
+{
+    /* Power spectrum of the first channel, Hann windowed */
+    float fft[FFT_BUFFER_SIZE / 2 + 1];
+    /* Root mean square of each channel */
+    float rms[AOUT_CHAN_MAX];
+} visual_analysis_t;
+
 typedef struct visual_effect_t
 {
     const char *psz_name;    /* Filter name*/
 
     int        (*pf_run)( struct visual_effect_t * , vlc_object_t *,
-                          const block_t *, picture_t *);
+                          const block_t *, const visual_analysis_t *,
+                          picture_t *);
     void *     p_data; /* The effect stores whatever it wants here */
     int        i_width;
     int        i_height;
@@ -42,17 +54,11 @@ typedef struct spectrum_data
 {
     int *peaks;
     int *prev_heights;
-
-    unsigned i_prev_nb_samples;
-    int16_t *p_prev_s16_buff;
 } spectrum_data;
 
 typedef struct
 {
     int *peaks;
-
-    unsigned i_prev_nb_samples;
-    int16_t *p_prev_s16_buff;
 } spectrometer_data;
 
 /*****************************************************************************
@@ -70,21 +76,37 @@ struct filter_sys_t
 
     int             i_effect;
     visual_effect_t **effect;
+
+    /* Rendering thread, fed with copies of the audio buffers */
+    vlc_thread_t    thread;
+    block_fifo_t    *p_fifo;
+
+    /* Shared analysis */
+    unsigned        i_nb_chans;
+    fft_state       *p_fft;
+    float           window[FFT_BUFFER_SIZE];
+    visual_analysis_t analysis;
 };
 
 /* Prototypes */
 int scope_Run
-        (visual_effect_t * , vlc_object_t *, const block_t *, picture_t *);
+        (visual_effect_t * , vlc_object_t *, const block_t *,
+         const visual_analysis_t *, picture_t *);
 int vuMeter_Run
-        (visual_effect_t * , vlc_object_t *, const block_t *, picture_t *);
+        (visual_effect_t * , vlc_object_t *, const block_t *,
+         const visual_analysis_t *, picture_t *);
 int dummy_Run
-        (visual_effect_t * , vlc_object_t *, const block_t *, picture_t *);
+        (visual_effect_t * , vlc_object_t *, const block_t *,
+         const visual_analysis_t *, picture_t *);
 int random_Run
-        (visual_effect_t * , vlc_object_t *, const block_t *, picture_t *);
+        (visual_effect_t * , vlc_object_t *, const block_t *,
+         const visual_analysis_t *, picture_t *);
 int spectrum_Run
-        (visual_effect_t * , vlc_object_t *, const block_t *, picture_t *);
+        (visual_effect_t * , vlc_object_t *, const block_t *,
+         const visual_analysis_t *, picture_t *);
 int spectrometer_Run
-        (visual_effect_t * , vlc_object_t *, const block_t *, picture_t *);
+        (visual_effect_t * , vlc_object_t *, const block_t *,
+         const visual_analysis_t *, picture_t *);
 
 /* Default vout size */
 #define VOUT_WIDTH  800
@@ -3,6 +3,8 @@ var currentArt = null;
 var current_que = 'main';
 var previous_title = null;
 var current_title = null;
+var pushStatus = false;
+var playlist_revision = null;
 
 function updateArt(url) {
     $('#albumArt').fadeOut(500, function () {
@@ -17,13 +19,8 @@ function updateStatus() {
             if (current_que == 'main') {
                 $('.dynamic').empty();
                 $('#mediaTitle').append($('[name="filename"]', data).text());
-                $('#totalTime').append(format_time($('length', data).text()));
-                $('#currentTime').append(format_time($('time', data).text()));
-                if (!$('#seekSlider').data('clicked')) {
-                    $('#seekSlider').slider({
-                        value: toFloat($('position', data).text()) * 100
-                    });
-                }
+                updateTime($('time', data).text(), $('length', data).text(),
+                           toFloat($('position', data).text()));
                 $('#currentVolume').append(Math.round($('volume', data).text() / 2.56) + '%');
                 /* Don't interfere with the user's action */
                 if (!$('#volumeSlider').data('clicked')) {
@@ -43,7 +40,6 @@ function updateStatus() {
                     value: ($('subtitledelay', data).text())
                 });
                 $('#currentSubtitleDelay').append(Math.round($('subtitledelay', data).text() * 100) / 100 + 's');
-                $('#seekSlider').attr('totalLength', $('length', data).text());
                 $('#buttonPlay').attr('state', $('state', data).text()).attr('mrl', $('[name="filename"]', data).text());
                 if ($('state', data).text() == 'playing') {
                     $('#buttonPlay').removeClass('paused').addClass('playing');
@@ -81,7 +77,7 @@ function updateStatus() {
                 }
                 previous_title = current_title;
 
-                if (pollStatus) {
+                if (pollStatus && !pushStatus) {
                     setTimeout(updateStatus, 1000);
                 }
 
@@ -128,6 +124,51 @@ function updateStatus() {
     });
 }
 
+function updateTime(time, length, position) {
+    $('#totalTime').empty().append(format_time(length));
+    $('#currentTime').empty().append(format_time(time));
+    if (!$('#seekSlider').data('clicked')) {
+        $('#seekSlider').slider({
+            value: position * 100
+        });
+    }
+    $('#seekSlider').attr('totalLength', length);
+}
+
+/* Let VLC tell what changed rather than polling, if the browser can */
+function startEvents() {
+    if (!pollStatus || !window.EventSource) {
+        return;
+    }
+    var events = new EventSource('requests/events');
+    events.addEventListener('status', function (e) {
+        updateStatus();
+    });
+    events.addEventListener('tick', function (e) {
+        var tick = JSON.parse(e.data);
+        if (current_que == 'main') {
+            updateTime(tick.time, tick.length, tick.position);
+        }
+    });
+    events.addEventListener('playlist', function (e) {
+        var revision = JSON.parse(e.data).revision;
+        if (playlist_revision != null && playlist_revision != revision) {
+            updatePlayList(true);
+        }
+        playlist_revision = revision;
+    });
+    events.onopen = function () {
+        pushStatus = true;
+    };
+    events.onerror = function () {
+        /* The browser reconnects by itself, poll meanwhile */
+        if (pushStatus) {
+            pushStatus = false;
+            setTimeout(updateStatus, 1000);
+        }
+    };
+}
+
 function updatePlayList(force_refresh) {
     if (force_refresh) {
         //refresh playlist..
@@ -528,4 +569,5 @@ $(function () {
     updateStatus();
     updateStreams();
     updateEQ();
+    startEvents();
 });
@@ -307,6 +307,9 @@ getplaylist = function ()
     return p
 end
 
+--uri of the item being played, looked up once per dump
+local current_uri=nil
+
 parseplaylist = function (item)
     if item.flags.disabled then return end
 
@@ -334,13 +337,10 @@ parseplaylist = function (item)
         local result={}
         local name, path = item.name or ""
         local path = item.path or ""
-        local current_item = vlc.input.item()
 
         -- Is the item the one currently played
-        if(current_item ~= nil) then
-            if(vlc.input.item().uri(current_item) == path) then
-                result.current = "current"
-            end
+        if current_uri == path then
+            result.current = "current"
         end
 
         result["type"]="leaf"
@@ -357,9 +357,76 @@ end
 
 playlisttable = function ()
 
+    --taken first: what changes while the tree is read is sent again later
+    local revision=vlc.playlist.changes()
+    local current_item=vlc.input.item()
+    current_uri=current_item and current_item:uri()
     local basePlaylist=getplaylist()
 
-    return parseplaylist(basePlaylist)
+    local result=parseplaylist(basePlaylist)
+    if result and not _GET["search"] then
+        result.revision=revision
+    end
+    return result
+end
+
+--the changes of the playlist after the revision the client has seen
+--returns nil if the client is too late and must read the whole playlist
+playlistchanges = function (since)
+
+    local revision, changes = vlc.playlist.changes(since)
+    if not changes then return nil end
+
+    local current_item=vlc.input.item()
+    current_uri=current_item and current_item:uri()
+
+    --items updated many times are sent once, as they are now
+    local lastupdate={}
+    for i, c in ipairs(changes) do
+        if c.type=="updated" or c.type=="reordered" then
+            lastupdate[c.type..c.id]=i
+        end
+    end
+
+    local result={}
+    result.revision=revision
+    result.changes={}
+    result.changes._array={}
+
+    for i, c in ipairs(changes) do
+        local change=nil
+
+        if c.type=="added" then
+            change={}
+            change.node=tostring(c.node)
+            change.items={}
+            change.items._array={}
+            --the ids of items added together follow
+            for id=c.id,c.id+c.count-1 do
+                local item=vlc.playlist.get(id)
+                if item then
+                    table.insert(change.items._array,parseplaylist(item))
+                end
+            end
+        elseif c.type=="deleted" then
+            change={}
+        elseif lastupdate[c.type..c.id]==i then
+            --reordered nodes are sent with their children
+            change={}
+            local item=vlc.playlist.get(c.id)
+            if item then
+                change.item=parseplaylist(item)
+            end
+        end
+
+        if change then
+            change.type=c.type
+            change.id=tostring(c.id)
+            table.insert(result.changes._array,change)
+        end
+    end
+
+    return result
 end
 
 getbrowsetable = function ()
@@ -431,6 +498,63 @@ getbrowsetable = function ()
 end
 
 
+--status snapshots, to send only what changed since one of them
+local statusrevision=(os.time()%65536)*65536
+local statushistory={}
+
+--the keys of the status that changed after the revision the client has seen
+--returns the revision of the status, and nil as changes if the client is too
+--late and must read the whole status
+statuschanges = function (s, since)
+
+    local encoded={}
+    for k,v in pairs(s) do
+        if type(v)=="table" then
+            v=removeArrayIndicators(v)
+        end
+        encoded[k]=dkjson.encode(v)
+    end
+
+    local last=statushistory[#statushistory]
+    local changed=(last==nil)
+    if last then
+        for k,v in pairs(encoded) do
+            if last.encoded[k]~=v then changed=true end
+        end
+        for k,_ in pairs(last.encoded) do
+            if encoded[k]==nil then changed=true end
+        end
+    end
+    if changed then
+        statusrevision=statusrevision+1
+        table.insert(statushistory,{revision=statusrevision,encoded=encoded})
+        if #statushistory>16 then table.remove(statushistory,1) end
+    end
+
+    local old=nil
+    for _,snapshot in ipairs(statushistory) do
+        if snapshot.revision==since then old=snapshot end
+    end
+    if not old then return statusrevision, nil end
+
+    local result={}
+    result.revision=statusrevision
+    result.changes={}
+    result.removed={}
+    result.removed._array={}
+    for k,v in pairs(s) do
+        if old.encoded[k]~=encoded[k] then
+            result.changes[k]=v
+        end
+    end
+    for k,_ in pairs(old.encoded) do
+        if encoded[k]==nil then
+            table.insert(result.removed._array,k)
+        end
+    end
+    return statusrevision, result
+end
+
 getstatus = function (includecategories)
 
 
@@ -448,12 +572,10 @@ local aout = vlc.object.aout()
     s.volume=vlc.volume.get()
 
     if input then
-        s.length=math.floor(vlc.var.get(input,"length"))
-        s.time=math.floor(vlc.var.get(input,"time"))
-        s.position=vlc.var.get(input,"position")
-        s.audiodelay=vlc.var.get(input,"audio-delay")
-        s.rate=vlc.var.get(input,"rate")
-        s.subtitledelay=vlc.var.get(input,"spu-delay")
+        s.length,s.time,s.position,s.audiodelay,s.rate,s.subtitledelay=
+            vlc.var.get(input,"length","time","position","audio-delay","rate","spu-delay")
+        s.length=math.floor(s.length)
+        s.time=math.floor(s.time)
     else
         s.length=0
         s.time=0
@@ -490,9 +612,7 @@ local aout = vlc.object.aout()
     s.videoeffects.gamma=round(vlc.config.get("gamma"),2)
 
     s.state=vlc.playlist.status()
-    s.random=vlc.var.get(playlist,"random")
-    s.loop=vlc.var.get(playlist,"loop")
-    s["repeat"]=vlc.var.get(playlist,"repeat")
+    s.random,s.loop,s["repeat"]=vlc.var.get(playlist,"random","loop","repeat")
 
         s.equalizer={}
         s.equalizer.preamp=round(vlc.equalizer.preampget(),2)
@@ -530,6 +650,9 @@ local aout = vlc.object.aout()
       	s.information.titles=vlc.var.get_list(input, "title")
 
     end
+
+    -- live bytes per subsystem, if VLC was built with --enable-memstats
+    s.memory=vlc.misc.memstats()
     return s
 end
 
@@ -24,6 +24,9 @@
  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
 --]]
 
+-- Probe hints: probe() is not even called for other URLs
+probe_hints = { access = "http", path = "list_streams.idp" }
+
 -- Probe function.
 function probe()
     return vlc.access == "http"
@@ -22,6 +22,9 @@
  51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
 --]]
 
+-- Probe hints: probe() is not even called for other URLs
+probe_hints = { access = "http", path = "/ws/Mgmt/" }
+
 -- Probe function.
 function probe()
     return vlc.access == "http"
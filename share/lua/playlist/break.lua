@@ -18,6 +18,9 @@
  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
 --]]
 
+-- Probe hints: probe() is not even called for other URLs
+probe_hints = { access = "http", path = "break.com" }
+
 -- Probe function.
 function probe()
     return vlc.access == "http"
@@ -31,6 +31,9 @@ function get_prefres()
     return prefres
 end
 
+-- Probe hints: probe() is not even called for other URLs
+probe_hints = { path = { "extreme.com/", "freecaster.tv/" } }
+
 -- Probe function.
 function probe()
     return vlc.access == "http"
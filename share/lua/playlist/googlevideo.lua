@@ -23,6 +23,9 @@ function get_url_param( url, name )
     return ret
 end
 
+-- Probe hints: probe() is not even called for other URLs
+probe_hints = { access = "http", path = "video.google.com" }
+
 -- Probe function.
 function probe()
     return vlc.access == "http"
@@ -22,6 +22,9 @@
 
 require "simplexml"
 
+-- Probe hints: probe() is not even called for other URLs
+probe_hints = { access = "http", path = "api.jamendo.com/" }
+
 -- Probe function.
 function probe()
     return vlc.access == "http"
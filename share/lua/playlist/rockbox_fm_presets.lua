@@ -1,6 +1,9 @@
 -- Parser script from Rockbox FM radio presets
 -- See http://www.rockbox.org/wiki/FmPresets
 
+-- Probe hints: probe() is not even called for other URLs
+probe_hints = { path = "fmr" }
+
 function probe()
 	if not string.match( vlc.path, ".fmr$" ) then return false end
 	local line = vlc.peek(256)
@@ -32,6 +32,9 @@ function get_prefres()
     return prefres
 end
 
+-- Probe hints: probe() is not even called for other URLs
+probe_hints = { access = "http", path = "vimeo.com/" }
+
 -- Probe function.
 function probe()
     return vlc.access == "http"
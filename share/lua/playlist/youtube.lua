@@ -93,6 +93,9 @@ function pick_url( url_map, fmt )
     return path
 end
 
+-- Probe hints: probe() is not even called for other URLs
+probe_hints = { access = { "http", "https" }, path = "youtube" }
+
 -- Probe function.
 function probe()
     if vlc.access ~= "http" and vlc.access ~= "https" then
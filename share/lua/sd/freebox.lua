@@ -24,53 +24,49 @@ function descriptor()
     return { title="Freebox TV" }
 end
 
+function parse_logos( logos, data )
+    local channel, logourl
+    for line in string.gmatch( data, "[^\n]+" ) do
+        if( string.find( line, "tv%-chaine%-" ) ) then
+            _, _, channel, logourl = string.find( line, "\"tv%-chaine%-(%d+)\".*<img%s*src=\"([^\"]*)\"" )
+            -- fix spaces
+            logourl = string.gsub( logourl, " ", "%%20" )
+            logos[channel] = "http://free.fr" .. logourl
+        end
+    end
+end
+
 function main()
     local logos = {}
 
-    -- fetch urls for basic channels logos
-    local fd, msg = vlc.stream( "http://free.fr/adsl/pages/television/services-de-television/acces-a-plus-250-chaines/bouquet-basique.html" )
-    if not fd then
-        vlc.msg.warn(msg)
-        -- not fatal
-    else
-        local channel, logourl
-        local line = fd:readline()
-        while line ~= nil do
-            if( string.find( line, "tv%-chaine%-" ) ) then
-                _, _, channel, logourl = string.find( line, "\"tv%-chaine%-(%d+)\".*<img%s*src=\"([^\"]*)\"" )
-                -- fix spaces
-                logourl = string.gsub( logourl, " ", "%%20" )
-                logos[channel] = "http://free.fr" .. logourl
-            end
-            line = fd:readline()
+    -- fetch the urls for basic and optional channels logos, and the
+    -- playlist, all at once
+    local urls = { "http://free.fr/adsl/pages/television/services-de-television/acces-a-plus-250-chaines/bouquet-basique.html",
+                   "http://www.free.fr/adsl/pages/television/services-de-television/acces-a-plus-250-chaines/en-option.html",
+                   "http://mafreebox.freebox.fr/freeboxtv/playlist.m3u" }
+    local data = {}
+    local f = vlc.fetch( urls )
+    while true do
+        local i, content, msg = f:wait()
+        if not i then break end
+        if not content then
+            vlc.msg.warn(msg)
+            -- not fatal for the logos
         end
+        data[i] = content
     end
 
-    -- fetch urls for optional channels logos
-    local fd, msg = vlc.stream( "http://www.free.fr/adsl/pages/television/services-de-television/acces-a-plus-250-chaines/en-option.html" )
-    if not fd then
-        vlc.msg.warn(msg)
-        -- not fatal
-    else
-        local channel, logourl
-        local line = fd:readline()
-        while line ~= nil do
-            if( string.find( line, "tv%-chaine%-" ) ) then
-                _, _, channel, logourl = string.find( line, "\"tv%-chaine%-(%d+)\".*<img%s*src=\"([^\"]*)\"" )
-                -- fix spaces
-                logourl = string.gsub( logourl, " ", "%%20" )
-                logos[channel] = "http://free.fr" .. logourl
-            end
-            line = fd:readline()
+    for i = 1, 2 do
+        if data[i] then
+            parse_logos( logos, data[i] )
         end
     end
 
-    -- fetch the playlist
-    fd, msg = vlc.stream( "http://mafreebox.freebox.fr/freeboxtv/playlist.m3u" )
-    if not fd then
-        vlc.msg.warn(msg)
+    -- parse the playlist
+    if not data[3] then
         return nil
     end
+    local fd = vlc.memory_stream( data[3] )
     local line=  fd:readline()
     if line ~= "#EXTM3U" then
         return nil
@@ -75,6 +75,17 @@ struct aout_input_t
     aout_request_vout_t request_vout;
 };
 
+/** Audio pipeline instrumentation */
+typedef struct
+{
+    mtime_t filters; /**< Time spent in the input filters */
+    mtime_t resamplers; /**< Time spent in the resamplers */
+    mtime_t output; /**< Time spent in the output filters and plug-in */
+    unsigned allocations; /**< Buffers allocated by the pipeline */
+    mtime_t buffered; /**< Duration queued ahead of the playback clock */
+    mtime_t delay; /**< Delay reported by the output, or -1 if unknown */
+} aout_stats_t;
+
 typedef struct
 {
     vlc_mutex_t lock;
@@ -107,6 +118,9 @@ typedef struct
     int       nb_filters;
 
     vlc_atomic_t restart;
+
+    aout_stats_t stats; /**< Counters since the last aout_DecGetResetStats() */
+    vlc_atomic_t decoder_allocations; /**< Buffers allocated for decoders */
 } aout_owner_t;
 
 typedef struct
@@ -138,7 +152,7 @@ int aout_FiltersCreatePipeline( vlc_object_t *, filter_t **, int *,
 #define aout_FiltersCreatePipeline(o, pv, pc, inf, outf) \
         aout_FiltersCreatePipeline(VLC_OBJECT(o), pv, pc, inf, outf)
 void aout_FiltersDestroyPipeline( filter_t *const *, unsigned );
-void aout_FiltersPlay( filter_t *const *, unsigned, aout_buffer_t ** );
+unsigned aout_FiltersPlay( filter_t *const *, unsigned, aout_buffer_t ** );
 
 /* From mixer.c : */
 struct audio_mixer *aout_MixerNew(vlc_object_t *, vlc_fourcc_t);
@@ -166,6 +180,7 @@ int aout_OutputNew( audio_output_t * p_aout,
 void aout_OutputPlay( audio_output_t * p_aout, aout_buffer_t * p_buffer );
 void aout_OutputPause( audio_output_t * p_aout, bool, mtime_t );
 void aout_OutputFlush( audio_output_t * p_aout, bool );
+int aout_OutputTimeGet( audio_output_t *, mtime_t * );
 void aout_OutputDelete( audio_output_t * p_aout );
 
 
@@ -198,6 +213,7 @@ block_t *aout_DecNewBuffer(audio_output_t *, size_t);
 void aout_DecDeleteBuffer(audio_output_t *, block_t *);
 int aout_DecPlay(audio_output_t *, block_t *, int i_input_rate);
 int aout_DecGetResetLost(audio_output_t *);
+void aout_DecGetResetStats(audio_output_t *, aout_stats_t *);
 void aout_DecChangePause(audio_output_t *, bool b_paused, mtime_t i_date);
 void aout_DecFlush(audio_output_t *);
 bool aout_DecIsEmpty(audio_output_t *);
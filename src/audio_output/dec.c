@@ -109,15 +109,19 @@ int aout_DecNew( audio_output_t *p_aout,
 
     owner->input_format = *p_format;
     vlc_atomic_set (&owner->restart, 0);
+    memset (&owner->stats, 0, sizeof (owner->stats));
+    vlc_atomic_set (&owner->decoder_allocations, 0);
     if( aout_OutputNew( p_aout, p_format ) < 0 )
     {
         ret = -1;
         goto error;
     }
 
-    /* Allocate a software mixer */
+    /* Allocate a software mixer (pass-through cannot be mixed) */
     assert (owner->volume.mixer == NULL);
-    owner->volume.mixer = aout_MixerNew (p_aout, owner->mixer_format.i_format);
+    if (AOUT_FMT_LINEAR(&owner->mixer_format))
+        owner->volume.mixer = aout_MixerNew (p_aout,
+                                             owner->mixer_format.i_format);
 
     aout_ReplayGainInit (&owner->gain.data, p_replay_gain);
     var_AddCallback (p_aout, "audio-replay-gain-mode",
@@ -266,9 +270,20 @@ block_t *aout_DecNewBuffer (audio_output_t *aout, size_t samples)
 
     size_t length = samples * owner->input_format.i_bytes_per_frame
                             / owner->input_format.i_frame_length;
-    block_t *block = block_Alloc( length );
+    size_t size = length;
+
+    /* A/52 pass-through frames are framed in place for S/PDIF: reserve room
+     * for the whole burst so that the output filter does not reallocate. */
+    if (owner->input_format.i_format == VLC_CODEC_A52
+     && (aout->format.i_format == VLC_CODEC_SPDIFL
+      || aout->format.i_format == VLC_CODEC_SPDIFB))
+        size = __MAX(length, AOUT_SPDIF_SIZE);
+
+    block_t *block = block_Alloc( size );
     if( likely(block != NULL) )
     {
+        vlc_atomic_inc (&owner->decoder_allocations);
+        block->i_buffer = length;
         block->i_nb_samples = samples;
         block->i_pts = block->i_length = 0;
     }
@@ -352,6 +367,28 @@ int aout_DecGetResetLost (audio_output_t *aout)
     return val;
 }
 
+/**
+ * Retrieves and resets the audio pipeline counters.
+ */
+void aout_DecGetResetStats (audio_output_t *aout, aout_stats_t *stats)
+{
+    aout_owner_t *owner = aout_owner (aout);
+
+    aout_lock (aout);
+    *stats = owner->stats;
+    memset (&owner->stats, 0, sizeof (owner->stats));
+
+    /* Everything processed but not yet played */
+    mtime_t date = date_Get (&owner->sync.date);
+    if (date != VLC_TS_INVALID)
+        stats->buffered = __MAX(date - mdate (), 0);
+    if (aout_OutputTimeGet (aout, &stats->delay))
+        stats->delay = -1;
+    aout_unlock (aout);
+
+    stats->allocations += vlc_atomic_swap (&owner->decoder_allocations, 0);
+}
+
 void aout_DecChangePause (audio_output_t *aout, bool paused, mtime_t date)
 {
     aout_owner_t *owner = aout_owner (aout);
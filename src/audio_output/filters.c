@@ -201,20 +201,27 @@ void aout_FiltersDestroyPipeline( filter_t *const *filters, unsigned n )
 
 /**
  * Filters an audio buffer through a chain of filters.
+ * @return the number of filters which output a new buffer instead of
+ * processing in place
  */
-void aout_FiltersPlay( filter_t *const *pp_filters,
-                       unsigned i_nb_filters, block_t ** pp_block )
+unsigned aout_FiltersPlay( filter_t *const *pp_filters,
+                           unsigned i_nb_filters, block_t ** pp_block )
 {
     block_t *p_block = *pp_block;
+    unsigned i_allocations = 0;
 
     /* TODO: use filter chain */
     for( unsigned i = 0; (i < i_nb_filters) && (p_block != NULL); i++ )
     {
         filter_t * p_filter = pp_filters[i];
+        block_t *p_in = p_block;
 
         /* Please note that p_block->i_nb_samples & i_buffer
          * shall be set by the filter plug-in. */
         p_block = p_filter->pf_audio_filter( p_filter, p_block );
+        if( p_block != NULL && p_block != p_in )
+            i_allocations++;
     }
     *pp_block = p_block;
+    return i_allocations;
 }
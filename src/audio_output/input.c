@@ -447,7 +447,13 @@ block_t *aout_InputPlay(audio_output_t *p_aout, aout_input_t *p_input,
 
 #ifndef AOUT_PROCESS_BEFORE_CHEKS
     /* Run pre-filters. */
-    aout_FiltersPlay( p_input->pp_filters, p_input->i_nb_filters, &p_buffer );
+    aout_stats_t *p_stats = &aout_owner( p_aout )->stats;
+    mtime_t i_start = mdate();
+
+    p_stats->allocations += aout_FiltersPlay( p_input->pp_filters,
+                                              p_input->i_nb_filters,
+                                              &p_buffer );
+    p_stats->filters += mdate() - i_start;
     if( !p_buffer )
         return NULL;
 #endif
@@ -526,8 +532,11 @@ block_t *aout_InputPlay(audio_output_t *p_aout, aout_input_t *p_input,
     /* Actually run the resampler now. */
     if ( p_input->i_nb_resamplers > 0 )
     {
-        aout_FiltersPlay( p_input->pp_resamplers, p_input->i_nb_resamplers,
-                          &p_buffer );
+        i_start = mdate();
+        p_stats->allocations += aout_FiltersPlay( p_input->pp_resamplers,
+                                                  p_input->i_nb_resamplers,
+                                                  &p_buffer );
+        p_stats->resamplers += mdate() - i_start;
     }
 
     if( !p_buffer )
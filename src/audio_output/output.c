@@ -34,8 +34,10 @@
 #include <vlc_common.h>
 #include <vlc_aout.h>
 #include <vlc_aout_intf.h>
+#include <vlc_atomic.h>
 #include <vlc_cpu.h>
 #include <vlc_modules.h>
+#include <vlc_tracer.h>
 
 #include "libvlc.h"
 #include "aout_internal.h"
@@ -162,7 +164,10 @@ int aout_OutputNew( audio_output_t *p_aout,
     /* Choose the mixer format. */
     owner->mixer_format = p_aout->format;
     if (!AOUT_FMT_LINEAR(&p_aout->format))
-        owner->mixer_format.i_format = p_format->i_format;
+        /* Pass-through: the compressed frames are left untouched until the
+         * output filters frame them for the link, whose rate and channels
+         * may differ from the stream (e.g. HDMI high bitrate bursts). */
+        owner->mixer_format = *p_format;
     else
     /* Most audio filters can only deal with single-precision,
      * so lets always use that when hardware supports floating point. */
@@ -212,6 +217,7 @@ void aout_OutputDelete (audio_output_t *aout)
     aout->pf_play = aout_DecDeleteBuffer; /* gruik */
     aout->pf_pause = NULL;
     aout->pf_flush = NULL;
+    aout->pf_time_get = NULL;
     aout_VolumeNoneInit (aout);
     owner->module = NULL;
     aout_FiltersDestroyPipeline (owner->filters, owner->nb_filters);
@@ -226,16 +232,37 @@ void aout_OutputPlay (audio_output_t *aout, block_t *block)
 
     aout_assert_locked (aout);
 
-    aout_FiltersPlay (owner->filters, owner->nb_filters, &block);
+    mtime_t start = mdate ();
+
+    VLC_TRACE_BEGIN ("aout play");
+    owner->stats.allocations +=
+        aout_FiltersPlay (owner->filters, owner->nb_filters, &block);
     if (block == NULL)
-        return;
+        goto out;
     if (block->i_buffer == 0)
     {
         block_Release (block);
-        return;
+        goto out;
     }
 
     aout->pf_play (aout, block);
+out:
+    VLC_TRACE_END ("aout play");
+    owner->stats.output += mdate () - start;
+}
+
+/**
+ * Queries the delay reported by the audio output plug-in, that is the time
+ * until a sample queued now would be heard.
+ * @return 0 on success, -1 if the plug-in does not report its delay
+ */
+int aout_OutputTimeGet (audio_output_t *aout, mtime_t *delay)
+{
+    aout_assert_locked (aout);
+
+    if (aout->pf_time_get == NULL)
+        return -1;
+    return aout->pf_time_get (aout, delay);
 }
 
 /**
@@ -623,3 +650,222 @@ out:
     vlc_mutex_unlock( &p->lock );
     return NULL;
 }
+
+
+/*** Ring buffer audio output support ***/
+
+/* The ring has a single producer, aout_RingPlay() called with the audio
+ * output lock held, and a single consumer, the output real-time callback
+ * calling aout_RingRead(). Each side only ever updates its own position,
+ * so neither takes a lock. The positions are free-running frame counters.
+ * Positions are published and loaded with read-modify-write operations
+ * for their full memory barrier. */
+
+static inline aout_ring_t *aout_ring (audio_output_t *aout)
+{
+    return (aout_ring_t *)(aout->sys);
+}
+
+static inline uintptr_t aout_RingLoad (vlc_atomic_t *pos)
+{
+    return vlc_atomic_add (pos, 0);
+}
+
+/**
+ * Initializes the ring buffer helper. The ring must be the first member of
+ * the audio output private data, and the output format must be linear.
+ * @param duration minimum capacity of the ring
+ */
+int aout_RingInit (audio_output_t *aout, aout_ring_t *r, mtime_t duration)
+{
+    assert (r == aout_ring (aout));
+    assert (AOUT_FMT_LINEAR(&aout->format));
+
+    uint64_t frames = duration * aout->format.i_rate / CLOCK_FREQ;
+    unsigned size = 1024;
+    while (size < frames)
+        size <<= 1;
+
+    r->framesize = aout_BitsPerSample (aout->format.i_format) / 8
+                 * aout_FormatNbChannels (&aout->format);
+    r->size = size;
+    r->buffer = malloc (size * r->framesize);
+    if (unlikely(r->buffer == NULL))
+        return VLC_ENOMEM;
+    vlc_atomic_set (&r->read, 0);
+    vlc_atomic_set (&r->write, 0);
+    vlc_atomic_set (&r->flush, 0);
+    vlc_atomic_set (&r->paused, false);
+    vlc_atomic_set (&r->latency, 0);
+    return VLC_SUCCESS;
+}
+
+void aout_RingDestroy (audio_output_t *aout)
+{
+    aout_ring_t *r = aout_ring (aout);
+
+    free (r->buffer);
+}
+
+/**
+ * Copies frames into the ring, or silence if p is NULL.
+ * @return the number of frames actually queued
+ */
+static unsigned aout_RingWrite (audio_output_t *aout, const uint8_t *p,
+                                unsigned frames)
+{
+    aout_ring_t *r = aout_ring (aout);
+    const uintptr_t write = vlc_atomic_get (&r->write);
+    unsigned avail = r->size - (write - aout_RingLoad (&r->read));
+
+    /* Wait once for the callback to make room, or to apply a flush (which it
+     * does even while paused) */
+    if (avail < frames
+     && (!vlc_atomic_get (&r->paused) || vlc_atomic_get (&r->flush)))
+    {
+        msleep ((frames - avail) * CLOCK_FREQ / aout->format.i_rate);
+        avail = r->size - (write - aout_RingLoad (&r->read));
+    }
+    if (avail < frames)
+    {
+        msg_Warn (aout, "ring buffer overflow: dropping %u frames",
+                  frames - avail);
+        frames = avail;
+    }
+
+    const unsigned offset = write & (r->size - 1);
+    const unsigned first = __MIN(frames, r->size - offset);
+    uint8_t *dst = r->buffer + offset * r->framesize;
+
+    if (p != NULL)
+    {
+        memcpy (dst, p, first * r->framesize);
+        memcpy (r->buffer, p + first * r->framesize,
+                (frames - first) * r->framesize);
+    }
+    else
+    {
+        memset (dst, 0, first * r->framesize);
+        memset (r->buffer, 0, (frames - first) * r->framesize);
+    }
+    vlc_atomic_add (&r->write, frames);
+    return frames;
+}
+
+/**
+ * Queues an audio buffer for the output callback. The first buffer after a
+ * starvation is preceded with silence until its due date, the following
+ * ones report the drift to the audio output core.
+ */
+void aout_RingPlay (audio_output_t *aout, block_t *block)
+{
+    aout_ring_t *r = aout_ring (aout);
+    const unsigned rate = aout->format.i_rate;
+    const uintptr_t flush = vlc_atomic_get (&r->flush);
+    const uintptr_t read = flush ? flush - 1 : aout_RingLoad (&r->read);
+    const unsigned queued = vlc_atomic_get (&r->write) - read;
+    const mtime_t delay = (mtime_t)queued * CLOCK_FREQ / rate
+                        + vlc_atomic_get (&r->latency);
+
+    if (queued == 0)
+    {
+        mtime_t advance = block->i_pts - (mdate () + delay);
+
+        if (advance > 0)
+        {
+            uint64_t frames = advance * rate / CLOCK_FREQ;
+
+            msg_Dbg (aout, "prepending %"PRIu64" zeroes", frames);
+            aout_RingWrite (aout, NULL, __MIN(frames, r->size / 2));
+        }
+        else
+            msg_Dbg (aout, "starting late (%"PRId64" us)", -advance);
+    }
+    else
+        aout_TimeReport (aout, block->i_pts - delay);
+
+    aout_RingWrite (aout, block->p_buffer, block->i_nb_samples);
+    block_Release (block);
+}
+
+void aout_RingPause (audio_output_t *aout, bool pause, mtime_t date)
+{
+    aout_ring_t *r = aout_ring (aout);
+
+    vlc_atomic_set (&r->paused, pause);
+    (void) date;
+}
+
+void aout_RingFlush (audio_output_t *aout, bool drain)
+{
+    aout_ring_t *r = aout_ring (aout);
+    const uintptr_t write = vlc_atomic_get (&r->write);
+
+    if (drain)
+    {
+        const unsigned queued = write - aout_RingLoad (&r->read);
+
+        if (!vlc_atomic_get (&r->paused))
+            msleep ((mtime_t)queued * CLOCK_FREQ / aout->format.i_rate);
+    }
+    else
+        vlc_atomic_set (&r->flush, write + 1);
+}
+
+/**
+ * Reports the duration of the queued frames plus the output latency.
+ * This is suitable for audio_output_t.pf_time_get.
+ */
+int aout_RingTimeGet (audio_output_t *aout, mtime_t *delay)
+{
+    aout_ring_t *r = aout_ring (aout);
+    const uintptr_t flush = vlc_atomic_get (&r->flush);
+    const uintptr_t read = flush ? flush - 1 : aout_RingLoad (&r->read);
+    const unsigned queued = vlc_atomic_get (&r->write) - read;
+
+    *delay = (mtime_t)queued * CLOCK_FREQ / aout->format.i_rate
+           + vlc_atomic_get (&r->latency);
+    return 0;
+}
+
+/**
+ * Dequeues interleaved audio frames for the output callback. This never
+ * blocks nor takes a lock, and is meant to be called from real-time threads.
+ * Missing frames are filled with silence.
+ * @param buf buffer for the frames
+ * @param frames number of frames to fill
+ * @return the number of frames dequeued (the rest is silence)
+ */
+unsigned aout_RingRead (audio_output_t *aout, void *buf, unsigned frames)
+{
+    aout_ring_t *r = aout_ring (aout);
+    const uintptr_t flush = vlc_atomic_swap (&r->flush, 0);
+    uintptr_t read = vlc_atomic_get (&r->read);
+    unsigned count = 0;
+
+    if (flush != 0)
+    {
+        vlc_atomic_add (&r->read, (flush - 1) - read);
+        read = flush - 1;
+    }
+
+    if (!vlc_atomic_get (&r->paused))
+    {
+        const unsigned queued = aout_RingLoad (&r->write) - read;
+        const unsigned offset = read & (r->size - 1);
+
+        count = __MIN(frames, queued);
+
+        const unsigned first = __MIN(count, r->size - offset);
+
+        memcpy (buf, r->buffer + offset * r->framesize,
+                first * r->framesize);
+        memcpy ((uint8_t *)buf + first * r->framesize, r->buffer,
+                (count - first) * r->framesize);
+        vlc_atomic_add (&r->read, count);
+    }
+
+    memset ((uint8_t *)buf + count * r->framesize, 0,
+            (frames - count) * r->framesize);
+    return count;
+}
@@ -327,26 +327,25 @@ void config_PutFloat( vlc_object_t *p_this,
     vlc_rwlock_unlock (&config_lock);
 }
 
-static int confcmp (const void *a, const void *b)
+static struct
 {
-    const module_config_t *const *ca = a, *const *cb = b;
-
-    return strcmp ((*ca)->psz_name, (*cb)->psz_name);
-}
+    module_config_t **hash; /* open addressing, linear probing */
+    size_t hash_mask;
+} config = { NULL, 0 };
 
-static int confnamecmp (const void *key, const void *elem)
+/* FNV-1a */
+static uint32_t confhash (const char *name)
 {
-    const module_config_t *const *conf = elem;
+    uint32_t h = 2166136261u;
 
-    return strcmp (key, (*conf)->psz_name);
+    while (*name)
+    {
+        h ^= (unsigned char)*(name++);
+        h *= 16777619u;
+    }
+    return h;
 }
 
-static struct
-{
-    module_config_t **list;
-    size_t count;
-} config = { NULL, 0 };
-
 /**
  * Index the configuration items by name for faster lookups.
  */
@@ -361,14 +360,19 @@ int config_SortConfig (void)
     for (size_t i = 0; i < nmod; i++)
          nconf  += mlist[i]->confsize;
 
-    module_config_t **clist = malloc (sizeof (*clist) * nconf);
-    if (unlikely(clist == NULL))
+    /* Items are looked up by name on every option read. The table is at
+     * most half full. */
+    size_t hsize = 64;
+    while (hsize < 2 * nconf)
+        hsize *= 2;
+
+    module_config_t **hash = calloc (hsize, sizeof (*hash));
+    if (unlikely(hash == NULL))
     {
         module_list_free (mlist);
         return VLC_ENOMEM;
     }
 
-    nconf = 0;
     for (size_t i = 0; i < nmod; i++)
     {
         module_t *parser = mlist[i];
@@ -380,27 +384,31 @@ int config_SortConfig (void)
         {
             if (!CONFIG_ITEM(item->i_type))
                 continue; /* ignore hints */
-            clist[nconf++] = item;
+
+            size_t slot = confhash (item->psz_name) & (hsize - 1);
+            while (hash[slot] != NULL
+                && strcmp (hash[slot]->psz_name, item->psz_name))
+                slot = (slot + 1) & (hsize - 1);
+            if (hash[slot] == NULL) /* else keep the first item of a name */
+                hash[slot] = item;
         }
     }
     module_list_free (mlist);
 
-    qsort (clist, nconf, sizeof (*clist), confcmp);
-
-    config.list = clist;
-    config.count = nconf;
+    config.hash = hash;
+    config.hash_mask = hsize - 1;
     return VLC_SUCCESS;
 }
 
 void config_UnsortConfig (void)
 {
-    module_config_t **clist;
+    module_config_t **hash;
 
-    clist = config.list;
-    config.list = NULL;
-    config.count = 0;
+    hash = config.hash;
+    config.hash = NULL;
+    config.hash_mask = 0;
 
-    free (clist);
+    free (hash);
 }
 
 /*****************************************************************************
@@ -412,12 +420,17 @@ module_config_t *config_FindConfig (vlc_object_t *p_this, const char *name)
 {
     VLC_UNUSED(p_this);
 
-    if (unlikely(name == NULL))
+    if (unlikely(name == NULL) || config.hash == NULL)
         return NULL;
 
-    module_config_t *const *p;
-    p = bsearch (name, config.list, config.count, sizeof (*p), confnamecmp);
-    return p ? *p : NULL;
+    for (size_t slot = confhash (name) & config.hash_mask;
+         config.hash[slot] != NULL;
+         slot = (slot + 1) & config.hash_mask)
+    {
+        if (!strcmp (config.hash[slot]->psz_name, name))
+            return config.hash[slot];
+    }
+    return NULL;
 }
 
 /**
@@ -99,6 +99,22 @@
 /* Due to some problems in es_out, we cannot use a large value yet */
 #define CR_BUFFERING_TARGET (100000)
 
+/* Drift samples further from the average than CR_OUTLIER_FACTOR times the
+ * measured jitter (and at least CR_OUTLIER_MIN) are network bursts, and are
+ * ignored unless CR_OUTLIER_COUNT of them come in a row.
+ * The jitter is the mean deviation of the samples, averaged over
+ * CR_JITTER_DIVIDER samples (as RFC 3550 does) */
+#define CR_OUTLIER_FACTOR (4)
+#define CR_OUTLIER_MIN (20000)
+#define CR_OUTLIER_COUNT (5)
+#define CR_JITTER_DIVIDER (16)
+
+/* When catching up, the pts_delay is lowered at CR_CATCHUP_RATE/256 of the
+ * real time (the audio output resamples meanwhile), until the data arrives
+ * only CR_CATCHUP_MARGIN plus the maximal jitter before being due */
+#define CR_CATCHUP_RATE (8)
+#define CR_CATCHUP_MARGIN (50000)
+
 /*****************************************************************************
  * Structures
  *****************************************************************************/
@@ -158,6 +174,16 @@ struct input_clock_t
     mtime_t i_next_drift_update;
     average_t drift;
 
+    /* Drift jitter and count of samples rejected in a row */
+    mtime_t i_drift_jitter;
+    int     i_drift_rejected;
+
+    /* Time between the reception of the clock points and their
+     * presentation, and the (slowly raising) minimum of it */
+    mtime_t i_latency;
+    mtime_t i_latency_min;
+    bool    b_catch_up;
+
     /* Late statistics */
     struct
     {
@@ -207,6 +233,12 @@ input_clock_t *input_clock_New( int i_rate )
 
     cl->i_next_drift_update = VLC_TS_INVALID;
     AvgInit( &cl->drift, 10 );
+    cl->i_drift_jitter = 0;
+    cl->i_drift_rejected = 0;
+
+    cl->i_latency = 0;
+    cl->i_latency_min = INT64_MAX;
+    cl->b_catch_up = false;
 
     cl->late.i_index = 0;
     for( int i = 0; i < INPUT_CLOCK_LATE_COUNT; i++ )
@@ -272,6 +304,8 @@ void input_clock_Update( input_clock_t *cl, vlc_object_t *p_log,
     {
         cl->i_next_drift_update = VLC_TS_INVALID;
         AvgReset( &cl->drift );
+        cl->i_drift_rejected = 0;
+        cl->i_latency_min = INT64_MAX;
 
         /* Feed synchro with a new reference point. */
         cl->b_has_reference = true;
@@ -285,8 +319,21 @@ void input_clock_Update( input_clock_t *cl, vlc_object_t *p_log,
     if( !b_can_pace_control && cl->i_next_drift_update < i_ck_system )
     {
         const mtime_t i_converted = ClockSystemToStream( cl, i_ck_system );
+        const mtime_t i_drift = i_converted - i_ck_stream;
+        const mtime_t i_deviation = llabs( i_drift - AvgGet( &cl->drift ) );
 
-        AvgUpdate( &cl->drift, i_converted - i_ck_stream );
+        if( cl->drift.i_count >= CR_OUTLIER_COUNT &&
+            cl->i_drift_rejected < CR_OUTLIER_COUNT &&
+            i_deviation > __MAX( CR_OUTLIER_FACTOR * cl->i_drift_jitter, CR_OUTLIER_MIN ) )
+        {
+            cl->i_drift_rejected++;
+        }
+        else
+        {
+            cl->i_drift_rejected = 0;
+            cl->i_drift_jitter += ( i_deviation - cl->i_drift_jitter ) / CR_JITTER_DIVIDER;
+            AvgUpdate( &cl->drift, i_drift );
+        }
 
         cl->i_next_drift_update = i_ck_system + CLOCK_FREQ/5; /* FIXME why that */
     }
@@ -310,6 +357,7 @@ void input_clock_Update( input_clock_t *cl, vlc_object_t *p_log,
     //fprintf( stderr, "input_clock_Update: %d :: %lld\n", b_buffering_allowed, cl->i_buffering_duration/1000 );
 
     /* */
+    const mtime_t i_elapsed = b_reset_reference ? 0 : i_ck_system - cl->last.i_system;
     cl->last = clock_point_Create( i_ck_stream, i_ck_system );
 
     /* It does not take the decoder latency into account but it is not really
@@ -323,6 +371,28 @@ void input_clock_Update( input_clock_t *cl, vlc_object_t *p_log,
         cl->late.i_index = ( cl->late.i_index + 1 ) % INPUT_CLOCK_LATE_COUNT;
     }
 
+    /* Lower the latency toward what the jitter requires */
+    cl->i_latency = -i_late;
+    if( cl->i_latency < cl->i_latency_min )
+        cl->i_latency_min = cl->i_latency;
+    else
+        cl->i_latency_min += ( cl->i_latency - cl->i_latency_min ) / CR_JITTER_DIVIDER;
+
+    if( cl->b_catch_up && !b_can_pace_control && i_elapsed > 0 )
+    {
+        const mtime_t i_target = CR_CATCHUP_MARGIN +
+            __MAX( CR_OUTLIER_FACTOR * cl->i_drift_jitter, CR_OUTLIER_MIN );
+        const mtime_t i_excess = __MIN( cl->i_latency_min - i_target, cl->i_pts_delay );
+
+        if( i_excess > 0 )
+        {
+            const mtime_t i_step = __MIN( i_excess, i_elapsed * CR_CATCHUP_RATE / 256 );
+
+            cl->i_pts_delay   -= i_step;
+            cl->i_latency_min -= i_step;
+        }
+    }
+
     vlc_mutex_unlock( &cl->lock );
 }
 
@@ -568,6 +638,22 @@ void input_clock_SetJitter( input_clock_t *cl,
     vlc_mutex_unlock( &cl->lock );
 }
 
+void input_clock_SetCatchUp( input_clock_t *cl, bool b_catch_up )
+{
+    vlc_mutex_lock( &cl->lock );
+    cl->b_catch_up = b_catch_up;
+    vlc_mutex_unlock( &cl->lock );
+}
+
+mtime_t input_clock_GetLatency( input_clock_t *cl )
+{
+    vlc_mutex_lock( &cl->lock );
+    const mtime_t i_latency = cl->i_latency;
+    vlc_mutex_unlock( &cl->lock );
+
+    return i_latency;
+}
+
 mtime_t input_clock_GetJitter( input_clock_t *cl )
 {
     vlc_mutex_lock( &cl->lock );
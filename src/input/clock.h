@@ -131,8 +131,21 @@ void input_clock_SetJitter( input_clock_t *,
 
 /**
  * This function returns an estimation of the pts_delay needed to avoid rebufferization.
- * XXX in the current implementation, the pts_delay will never be decreased.
+ * XXX in the current implementation, the pts_delay will never be decreased
+ * (except by catching up, see input_clock_SetCatchUp).
  */
 mtime_t input_clock_GetJitter( input_clock_t * );
 
+/**
+ * This function allows the clock to slowly lower the pts_delay of a source
+ * whose pace cannot be controlled, down to what its measured jitter needs.
+ */
+void input_clock_SetCatchUp( input_clock_t *, bool b_catch_up );
+
+/**
+ * This function returns the delay between the reception of the last clock
+ * reference point and its presentation.
+ */
+mtime_t input_clock_GetLatency( input_clock_t * );
+
 #endif
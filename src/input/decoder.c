@@ -42,6 +42,8 @@
 #include <vlc_meta.h>
 #include <vlc_dialog.h>
 #include <vlc_modules.h>
+#include <vlc_atomic.h>
+#include <vlc_tracer.h>
 
 #include "audio_output/aout_internal.h"
 #include "stream_output/stream_output.h"
@@ -59,10 +61,14 @@ static decoder_t *CreateDecoder( vlc_object_t *, input_thread_t *,
 static void       DeleteDecoder( decoder_t * );
 
 static void      *DecoderThread( void * );
+static void      *DecoderPacketizerThread( void * );
 static void       DecoderProcess( decoder_t *, block_t * );
+static void       DecoderPacketize( decoder_t *, block_t * );
+static void       DecoderProcessPacketized( decoder_t *, block_t * );
 static void       DecoderError( decoder_t *p_dec, block_t *p_block );
 static void       DecoderOutputChangePause( decoder_t *, bool b_paused, mtime_t i_date );
 static void       DecoderFlush( decoder_t * );
+static void       DecoderProcessOnFlush( decoder_t * );
 static void       DecoderSignalBuffering( decoder_t *, bool );
 static void       DecoderFlushBuffering( decoder_t * );
 
@@ -111,9 +117,21 @@ struct decoder_owner_sys_t
     es_format_t    fmt_description;
     vlc_meta_t     *p_description;
 
+    /* Copies of b_fmt_description and cc.pb_present[] (as a mask), so that
+     * the es_out can check them for every block without locking */
+    vlc_atomic_t   fmt_changed;
+    vlc_atomic_t   cc_present;
+
     /* fifo */
     block_fifo_t *p_fifo;
 
+    /* Pipeline: when set, the packetizer runs in its own thread, that feeds
+     * the decoder thread through p_packetized_fifo */
+    bool          b_pipeline;
+    vlc_thread_t  packetizer_thread;
+    block_fifo_t *p_packetized_fifo;
+    es_format_t  *p_packetized_fmt; /* Format for the decoder, if any */
+
     /* Lock for communication with decoder thread */
     vlc_mutex_t lock;
     vlc_cond_t  wait_request;
@@ -295,10 +313,26 @@ static decoder_t *decoder_New( vlc_object_t *p_parent, input_thread_t *p_input,
     else
         i_priority = VLC_THREAD_PRIORITY_VIDEO;
 
+    /* Spawn the packetizer thread of the pipeline */
+    if( p_dec->p_owner->b_pipeline &&
+        vlc_clone( &p_dec->p_owner->packetizer_thread, DecoderPacketizerThread,
+                   p_dec, i_priority ) )
+    {
+        msg_Err( p_dec, "cannot spawn packetizer thread" );
+        module_unneed( p_dec, p_dec->p_module );
+        DeleteDecoder( p_dec );
+        return NULL;
+    }
+
     /* Spawn the decoder thread */
     if( vlc_clone( &p_dec->p_owner->thread, DecoderThread, p_dec, i_priority ) )
     {
         msg_Err( p_dec, "cannot spawn decoder thread" );
+        if( p_dec->p_owner->b_pipeline )
+        {
+            vlc_cancel( p_dec->p_owner->packetizer_thread );
+            vlc_join( p_dec->p_owner->packetizer_thread, NULL );
+        }
         module_unneed( p_dec, p_dec->p_module );
         DeleteDecoder( p_dec );
         return NULL;
@@ -345,6 +379,8 @@ void input_DecoderDelete( decoder_t *p_dec )
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
 
     vlc_cancel( p_owner->thread );
+    if( p_owner->b_pipeline )
+        vlc_cancel( p_owner->packetizer_thread );
 
     /* Make sure we aren't paused/buffering/waiting/decoding anymore */
     vlc_mutex_lock( &p_owner->lock );
@@ -357,6 +393,8 @@ void input_DecoderDelete( decoder_t *p_dec )
     vlc_mutex_unlock( &p_owner->lock );
 
     vlc_join( p_owner->thread, NULL );
+    if( p_owner->b_pipeline )
+        vlc_join( p_owner->packetizer_thread, NULL );
     p_owner->b_paused = b_was_paused;
 
     module_unneed( p_dec, p_dec->p_module );
@@ -415,6 +453,8 @@ bool input_DecoderIsEmpty( decoder_t * p_dec )
     assert( !p_owner->b_buffering );
 
     bool b_empty = block_FifoCount( p_dec->p_owner->p_fifo ) <= 0;
+    if( b_empty && p_owner->b_pipeline )
+        b_empty = block_FifoCount( p_owner->p_packetized_fifo ) <= 0;
     if( b_empty )
     {
         vlc_mutex_lock( &p_owner->lock );
@@ -431,12 +471,10 @@ bool input_DecoderIsEmpty( decoder_t * p_dec )
 void input_DecoderIsCcPresent( decoder_t *p_dec, bool pb_present[4] )
 {
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
-    int i;
+    const uintptr_t i_present = vlc_atomic_get( &p_owner->cc_present );
 
-    vlc_mutex_lock( &p_owner->lock );
-    for( i = 0; i < 4; i++ )
-        pb_present[i] =  p_owner->cc.pb_present[i];
-    vlc_mutex_unlock( &p_owner->lock );
+    for( int i = 0; i < 4; i++ )
+        pb_present[i] = ( i_present >> i ) & 1;
 }
 int input_DecoderSetCcState( decoder_t *p_dec, bool b_decode, int i_channel )
 {
@@ -630,6 +668,9 @@ bool input_DecoderHasFormatChanged( decoder_t *p_dec, es_format_t *p_fmt, vlc_me
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
     bool b_changed;
 
+    if( !vlc_atomic_get( &p_owner->fmt_changed ) )
+        return false;
+
     vlc_mutex_lock( &p_owner->lock );
     b_changed = p_owner->b_fmt_description;
     if( b_changed )
@@ -648,6 +689,7 @@ bool input_DecoderHasFormatChanged( decoder_t *p_dec, es_format_t *p_fmt, vlc_me
             }
         }
         p_owner->b_fmt_description = false;
+        vlc_atomic_set( &p_owner->fmt_changed, false );
     }
     vlc_mutex_unlock( &p_owner->lock );
     return b_changed;
@@ -657,7 +699,10 @@ size_t input_DecoderGetFifoSize( decoder_t *p_dec )
 {
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
 
-    return block_FifoSize( p_owner->p_fifo );
+    size_t i_size = block_FifoSize( p_owner->p_fifo );
+    if( p_owner->b_pipeline )
+        i_size += block_FifoSize( p_owner->p_packetized_fifo );
+    return i_size;
 }
 
 void input_DecoderGetObjects( decoder_t *p_dec,
@@ -785,7 +830,8 @@ static decoder_t * CreateDecoder( vlc_object_t *p_parent,
     p_owner->b_packetizer = b_packetizer;
 
     /* decoder fifo */
-    p_owner->p_fifo = block_FifoNew();
+    /* only the decoder thread gets blocks */
+    p_owner->p_fifo = block_FifoNewSPSC();
     if( unlikely(p_owner->p_fifo == NULL) )
     {
         free( p_owner );
@@ -807,10 +853,14 @@ static decoder_t * CreateDecoder( vlc_object_t *p_parent,
     p_dec->pf_get_display_rate = DecoderGetDisplayRate;
 
     /* Find a suitable decoder/packetizer module */
+    const vlc_fourcc_t i_codec = vlc_fourcc_GetCodec( fmt->i_cat,
+                                                      fmt->i_codec );
     if( !b_packetizer )
-        p_dec->p_module = module_need( p_dec, "decoder", "$codec", false );
+        p_dec->p_module = module_need_codec( p_dec, "decoder", "$codec",
+                                             false, i_codec );
     else
-        p_dec->p_module = module_need( p_dec, "packetizer", "$packetizer", false );
+        p_dec->p_module = module_need_codec( p_dec, "packetizer",
+                                             "$packetizer", false, i_codec );
 
     /* Check if decoder requires already packetized data */
     if( !b_packetizer &&
@@ -827,8 +877,9 @@ static decoder_t * CreateDecoder( vlc_object_t *p_parent,
                             &null_es_format );
 
             p_owner->p_packetizer->p_module =
-                module_need( p_owner->p_packetizer,
-                             "packetizer", "$packetizer", false );
+                module_need_codec( p_owner->p_packetizer,
+                                   "packetizer", "$packetizer", false,
+                                   i_codec );
 
             if( !p_owner->p_packetizer->p_module )
             {
@@ -864,6 +915,8 @@ static decoder_t * CreateDecoder( vlc_object_t *p_parent,
     p_owner->b_fmt_description = false;
     es_format_Init( &p_owner->fmt_description, UNKNOWN_ES, 0 );
     p_owner->p_description = NULL;
+    vlc_atomic_set( &p_owner->fmt_changed, false );
+    vlc_atomic_set( &p_owner->cc_present, 0 );
 
     p_owner->b_exit = false;
 
@@ -898,6 +951,19 @@ static decoder_t * CreateDecoder( vlc_object_t *p_parent,
         p_owner->cc.pp_decoder[i] = NULL;
     }
     p_owner->i_ts_delay = 0;
+
+    /* Packetize the video in its own thread, decoding (and the conversions
+     * of the video output) then overlap packetizing */
+    p_owner->b_pipeline = false;
+    p_owner->p_packetized_fifo = NULL;
+    p_owner->p_packetized_fmt = NULL;
+    if( !b_packetizer && p_owner->p_packetizer &&
+        p_dec->fmt_out.i_cat == VIDEO_ES &&
+        var_InheritBool( p_dec, "decoder-pipeline" ) )
+    {
+        p_owner->p_packetized_fifo = block_FifoNew();
+        p_owner->b_pipeline = p_owner->p_packetized_fifo != NULL;
+    }
     return p_dec;
 }
 
@@ -914,7 +980,9 @@ static void *DecoderThread( void *p_data )
     /* The decoder's main loop */
     for( ;; )
     {
-        block_t *p_block = block_FifoGet( p_owner->p_fifo );
+        block_t *p_block = block_FifoGet( p_owner->b_pipeline ?
+                                          p_owner->p_packetized_fifo :
+                                          p_owner->p_fifo );
 
         /* Make sure there is no cancellation point other than this one^^.
          * If you need one, be sure to push cleanup of p_block. */
@@ -932,10 +1000,14 @@ static void *DecoderThread( void *p_data )
                 p_block = NULL;
             }
 
+            VLC_TRACE_BEGIN( "decoder" );
             if( p_dec->b_error )
                 DecoderError( p_dec, p_block );
+            else if( p_owner->b_pipeline )
+                DecoderProcessPacketized( p_dec, p_block );
             else
                 DecoderProcess( p_dec, p_block );
+            VLC_TRACE_END( "decoder" );
 
             vlc_restorecancel( canc );
         }
@@ -943,6 +1015,43 @@ static void *DecoderThread( void *p_data )
     return NULL;
 }
 
+/**
+ * The packetizing main loop of the pipeline
+ *
+ * \param p_dec the decoder
+ */
+static void *DecoderPacketizerThread( void *p_data )
+{
+    decoder_t *p_dec = (decoder_t *)p_data;
+    decoder_owner_sys_t *p_owner = p_dec->p_owner;
+
+    for( ;; )
+    {
+        /* Do not pile up packetized blocks when the decoder waits */
+        block_FifoPace( p_owner->p_packetized_fifo, 10, SIZE_MAX );
+
+        block_t *p_block = block_FifoGet( p_owner->p_fifo );
+        if( !p_block )
+        {
+            /* Forward the wake up of input_DecoderWaitBuffering() */
+            block_FifoWake( p_owner->p_packetized_fifo );
+            continue;
+        }
+
+        int canc = vlc_savecancel();
+
+        if( p_block->i_flags & BLOCK_FLAG_CORE_EOS )
+        {
+            block_Release( p_block );
+            p_block = NULL;
+        }
+        DecoderPacketize( p_dec, p_block );
+
+        vlc_restorecancel( canc );
+    }
+    return NULL;
+}
+
 static block_t *DecoderBlockFlushNew()
 {
     block_t *p_null = block_Alloc( 128 );
@@ -965,6 +1074,8 @@ static void DecoderFlush( decoder_t *p_dec )
 
     /* Empty the fifo */
     block_FifoEmpty( p_owner->p_fifo );
+    if( p_owner->b_pipeline )
+        block_FifoEmpty( p_owner->p_packetized_fifo );
 
     /* Monitor for flush end */
     p_owner->b_flushing = true;
@@ -1287,11 +1398,22 @@ static void DecoderDecodeAudio( decoder_t *p_dec, block_t *p_block )
     int i_decoded = 0;
     int i_lost = 0;
     int i_played = 0;
+    mtime_t i_start = mdate();
 
     while( (p_aout_buf = p_dec->pf_decode_audio( p_dec, &p_block )) )
     {
         audio_output_t *p_aout = p_owner->p_aout;
 
+        if( p_owner->p_input != NULL )
+        {
+            const mtime_t i_now = mdate();
+
+            stats_HistogramAdd(
+                &p_owner->p_input->p->counters.audio_decode_time,
+                i_now - i_start );
+            i_start = i_now;
+        }
+
         if( DecoderIsExitRequested( p_dec ) )
         {
             /* It prevent freezing VLC in case of broken decoder */
@@ -1318,6 +1440,7 @@ static void DecoderDecodeAudio( decoder_t *p_dec, block_t *p_block )
             p_owner->i_preroll_end = VLC_TS_INVALID;
         }
 
+        VLC_TRACE_INSTANT( "decoder audio out" );
         DecoderPlayAudio( p_dec, p_aout_buf, &i_played, &i_lost );
     }
 
@@ -1326,16 +1449,26 @@ static void DecoderDecodeAudio( decoder_t *p_dec, block_t *p_block )
 
     if( p_input != NULL && (i_decoded > 0 || i_lost > 0 || i_played > 0) )
     {
-        vlc_mutex_lock( &p_input->p->counters.counters_lock);
+        vlc_atomic_add( &p_input->p->counters.lost_abuffers, i_lost );
+        vlc_atomic_add( &p_input->p->counters.played_abuffers, i_played );
+        vlc_atomic_add( &p_input->p->counters.decoded_audio, i_decoded );
 
-        stats_UpdateInteger( p_dec, p_input->p->counters.p_lost_abuffers,
-                             i_lost, NULL );
-        stats_UpdateInteger( p_dec, p_input->p->counters.p_played_abuffers,
-                             i_played, NULL );
-        stats_UpdateInteger( p_dec, p_input->p->counters.p_decoded_audio,
-                             i_decoded, NULL );
+        if( p_owner->p_aout != NULL )
+        {
+            aout_stats_t stats;
 
-        vlc_mutex_unlock( &p_input->p->counters.counters_lock);
+            aout_DecGetResetStats( p_owner->p_aout, &stats );
+#define UPDATE_COUNTER( c, v ) \
+    vlc_atomic_add( &p_input->p->counters.audio_##c, v )
+            UPDATE_COUNTER( filter_time, stats.filters );
+            UPDATE_COUNTER( resampler_time, stats.resamplers );
+            UPDATE_COUNTER( output_time, stats.output );
+            UPDATE_COUNTER( allocations, stats.allocations );
+#undef UPDATE_COUNTER
+            vlc_atomic_set( &p_input->p->counters.audio_buffered,
+                            stats.buffered );
+            vlc_atomic_set( &p_input->p->counters.audio_delay, stats.delay );
+        }
     }
 }
 static void DecoderGetCc( decoder_t *p_dec, decoder_t *p_dec_cc )
@@ -1358,12 +1491,17 @@ static void DecoderGetCc( decoder_t *p_dec, decoder_t *p_dec_cc )
         return;
 
     vlc_mutex_lock( &p_owner->lock );
+    uintptr_t i_present = 0;
     for( i = 0, i_cc_decoder = 0; i < 4; i++ )
     {
         p_owner->cc.pb_present[i] |= pb_present[i];
+        if( p_owner->cc.pb_present[i] )
+            i_present |= 1 << i;
         if( p_owner->cc.pp_decoder[i] )
             i_cc_decoder++;
     }
+    if( vlc_atomic_get( &p_owner->cc_present ) != i_present )
+        vlc_atomic_set( &p_owner->cc_present, i_present );
 
     for( i = 0; i < 4; i++ )
     {
@@ -1475,6 +1613,10 @@ static void DecoderPlayVideo( decoder_t *p_dec, picture_t *p_picture,
                 vout_Flush( p_vout, p_picture->date );
                 p_owner->i_last_rate = i_rate;
             }
+            if( p_owner->p_input != NULL && !p_picture->b_force )
+                stats_HistogramAdd(
+                    &p_owner->p_input->p->counters.video_latency,
+                    p_picture->date - mdate() );
             vout_PutPicture( p_vout, p_picture );
         }
         else
@@ -1513,10 +1655,22 @@ static void DecoderDecodeVideo( decoder_t *p_dec, block_t *p_block )
     int i_lost = 0;
     int i_decoded = 0;
     int i_displayed = 0;
+    mtime_t i_start = mdate();
 
     while( (p_pic = p_dec->pf_decode_video( p_dec, &p_block )) )
     {
         vout_thread_t  *p_vout = p_owner->p_vout;
+
+        if( p_owner->p_input != NULL )
+        {
+            const mtime_t i_now = mdate();
+
+            stats_HistogramAdd(
+                &p_owner->p_input->p->counters.video_decode_time,
+                i_now - i_start );
+            i_start = i_now;
+        }
+
         if( DecoderIsExitRequested( p_dec ) )
         {
             /* It prevent freezing VLC in case of broken decoder */
@@ -1540,13 +1694,16 @@ static void DecoderDecodeVideo( decoder_t *p_dec, block_t *p_block )
             if( p_vout )
                 vout_Flush( p_vout, VLC_TS_INVALID+1 );
             /* */
+            vlc_mutex_lock( &p_owner->lock ); /* see DecoderPacketize() */
             p_owner->i_preroll_end = VLC_TS_INVALID;
+            vlc_mutex_unlock( &p_owner->lock );
         }
 
         if( p_dec->pf_get_cc &&
             ( !p_owner->p_packetizer || !p_owner->p_packetizer->pf_get_cc ) )
             DecoderGetCc( p_dec, p_dec );
 
+        VLC_TRACE_INSTANT( "decoder picture out" );
         DecoderPlayVideo( p_dec, p_pic, &i_displayed, &i_lost );
     }
 
@@ -1555,17 +1712,10 @@ static void DecoderDecodeVideo( decoder_t *p_dec, block_t *p_block )
 
     if( p_input != NULL && (i_decoded > 0 || i_lost > 0 || i_displayed > 0) )
     {
-        vlc_mutex_lock( &p_input->p->counters.counters_lock );
-
-        stats_UpdateInteger( p_dec, p_input->p->counters.p_decoded_video,
-                             i_decoded, NULL );
-        stats_UpdateInteger( p_dec, p_input->p->counters.p_lost_pictures,
-                             i_lost , NULL);
-
-        stats_UpdateInteger( p_dec, p_input->p->counters.p_displayed_pictures,
-                             i_displayed, NULL);
-
-        vlc_mutex_unlock( &p_input->p->counters.counters_lock );
+        vlc_atomic_add( &p_input->p->counters.decoded_video, i_decoded );
+        vlc_atomic_add( &p_input->p->counters.lost_pictures, i_lost );
+        vlc_atomic_add( &p_input->p->counters.displayed_pictures,
+                        i_displayed );
     }
 }
 
@@ -1892,6 +2042,91 @@ static void DecoderProcessVideo( decoder_t *p_dec, block_t *p_block, bool b_flus
         vout_Flush( p_owner->p_vout, VLC_TS_INVALID+1 );
 }
 
+/* This function packetizes a video block in the packetizer thread of the
+ * pipeline, and sends the result to the decoder thread
+ */
+static void DecoderPacketize( decoder_t *p_dec, block_t *p_block )
+{
+    decoder_owner_sys_t *p_owner = p_dec->p_owner;
+    decoder_t *p_packetizer = p_owner->p_packetizer;
+    const bool b_flush_request = p_block && (p_block->i_flags & BLOCK_FLAG_CORE_FLUSH);
+    block_t *p_packetized_block;
+
+    if( p_block && p_block->i_buffer <= 0 )
+    {
+        assert( !b_flush_request );
+        block_Release( p_block );
+        return;
+    }
+
+    if( p_block )
+    {
+        /* The decoder thread resets it too */
+        vlc_mutex_lock( &p_owner->lock );
+        DecoderUpdatePreroll( &p_owner->i_preroll_end, p_block );
+        vlc_mutex_unlock( &p_owner->lock );
+
+        p_block->i_flags &= ~BLOCK_FLAG_CORE_PRIVATE_MASK;
+    }
+
+    while( (p_packetized_block =
+            p_packetizer->pf_packetize( p_packetizer, p_block ? &p_block : NULL )) )
+    {
+        /* The decoder thread takes the format from p_packetized_fmt */
+        if( p_packetizer->fmt_out.i_extra && !p_owner->p_packetized_fmt )
+        {
+            es_format_t *p_fmt = malloc( sizeof(*p_fmt) );
+            if( p_fmt )
+            {
+                es_format_Copy( p_fmt, &p_packetizer->fmt_out );
+                vlc_mutex_lock( &p_owner->lock );
+                p_owner->p_packetized_fmt = p_fmt;
+                vlc_mutex_unlock( &p_owner->lock );
+            }
+        }
+        if( p_packetizer->pf_get_cc )
+            DecoderGetCc( p_dec, p_packetizer );
+
+        block_FifoPut( p_owner->p_packetized_fifo, p_packetized_block );
+    }
+
+    /* The decoder thread flushes the decoder and acknowledges the request */
+    if( b_flush_request )
+    {
+        block_t *p_null = DecoderBlockFlushNew();
+        if( p_null )
+            block_FifoPut( p_owner->p_packetized_fifo, p_null );
+        else
+            DecoderProcessOnFlush( p_dec );
+    }
+}
+
+/* This function decodes a block sent by DecoderPacketize()
+ */
+static void DecoderProcessPacketized( decoder_t *p_dec, block_t *p_block )
+{
+    decoder_owner_sys_t *p_owner = p_dec->p_owner;
+
+    if( p_block->i_flags & BLOCK_FLAG_CORE_FLUSH )
+    {
+        DecoderDecodeVideo( p_dec, p_block );
+        if( p_owner->p_vout )
+            vout_Flush( p_owner->p_vout, VLC_TS_INVALID+1 );
+        DecoderProcessOnFlush( p_dec );
+        return;
+    }
+
+    vlc_mutex_lock( &p_owner->lock );
+    if( p_owner->p_packetized_fmt && !p_dec->fmt_in.i_extra )
+    {
+        es_format_Clean( &p_dec->fmt_in );
+        es_format_Copy( &p_dec->fmt_in, p_owner->p_packetized_fmt );
+    }
+    vlc_mutex_unlock( &p_owner->lock );
+
+    DecoderDecodeVideo( p_dec, p_block );
+}
+
 /* This function process a audio block
  */
 static void DecoderProcessAudio( decoder_t *p_dec, block_t *p_block, bool b_flush )
@@ -1954,12 +2189,7 @@ static void DecoderProcessSpu( decoder_t *p_dec, block_t *p_block, bool b_flush
     while( (p_spu = p_dec->pf_decode_sub( p_dec, p_block ? &p_block : NULL ) ) )
     {
         if( p_input != NULL )
-        {
-            vlc_mutex_lock( &p_input->p->counters.counters_lock );
-            stats_UpdateInteger( p_dec, p_input->p->counters.p_decoded_sub, 1,
-                                 NULL );
-            vlc_mutex_unlock( &p_input->p->counters.counters_lock );
-        }
+            vlc_atomic_inc( &p_input->p->counters.decoded_sub );
 
         p_vout = input_resource_HoldVout( p_owner->p_resource );
         if( p_vout && p_owner->p_spu_vout == p_vout )
@@ -2108,6 +2338,16 @@ static void DeleteDecoder( decoder_t * p_dec )
     /* Free all packets still in the decoder fifo. */
     block_FifoEmpty( p_owner->p_fifo );
     block_FifoRelease( p_owner->p_fifo );
+    if( p_owner->p_packetized_fifo )
+    {
+        block_FifoEmpty( p_owner->p_packetized_fifo );
+        block_FifoRelease( p_owner->p_packetized_fifo );
+    }
+    if( p_owner->p_packetized_fmt )
+    {
+        es_format_Clean( p_owner->p_packetized_fmt );
+        free( p_owner->p_packetized_fmt );
+    }
 
     /* */
     vlc_mutex_lock( &p_owner->lock );
@@ -2196,6 +2436,7 @@ static void DecoderUpdateFormatLocked( decoder_t *p_dec )
     vlc_assert_locked( &p_owner->lock );
 
     p_owner->b_fmt_description = true;
+    vlc_atomic_set( &p_owner->fmt_changed, true );
 
     /* Copy es_format */
     es_format_Clean( &p_owner->fmt_description );
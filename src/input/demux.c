@@ -31,9 +31,15 @@
 #include <vlc_meta.h>
 #include <vlc_url.h>
 #include <vlc_modules.h>
+#include <vlc_md5.h>
+#include <vlc_fs.h>
+#include <vlc_memory.h>
+
+#include <sys/stat.h>
 
 static bool SkipID3Tag( demux_t * );
 static bool SkipAPETag( demux_t *p_demux );
+static const char *ProbeSignature( stream_t * );
 
 /* Decode URL (which has had its scheme stripped earlier) to a file path. */
 /* XXX: evil code duplication from access.c */
@@ -92,6 +98,8 @@ demux_t *demux_New( vlc_object_t *p_obj, input_thread_t *p_parent_input,
 
     p_demux->s          = s;
     p_demux->out        = out;
+    p_demux->b_meta_only = b_quick && var_InheritBool( p_obj,
+                                                       "preparse-meta-only" );
 
     p_demux->pf_demux   = NULL;
     p_demux->pf_control = NULL;
@@ -186,6 +194,15 @@ demux_t *demux_New( vlc_object_t *p_obj, input_thread_t *p_parent_input,
           ;
         SkipAPETag( p_demux );
 
+        /* A known signature tells better than the extension which module
+         * to try first. The others still come after it. */
+        if( *p_demux->psz_demux == '\0' )
+        {
+            const char *psz_probe = ProbeSignature( s );
+            if( psz_probe != NULL )
+                psz_module = psz_probe;
+        }
+
         p_demux->p_module =
             module_need( p_demux, "demux", psz_module,
                          !strcmp( psz_module, p_demux->psz_demux ) );
@@ -210,6 +227,64 @@ demux_t *demux_New( vlc_object_t *p_obj, input_thread_t *p_parent_input,
     return p_demux;
 }
 
+/*****************************************************************************
+ * ProbeSignature: finds the demux for the first bytes of a stream
+ *****************************************************************************
+ * XXX: add only signatures that cannot be mistaken for anything else, as
+ * for the extensions above (no raw audio, and no wav then).
+ *****************************************************************************/
+static const char *ProbeSignature( stream_t *s )
+{
+    /* p_magic at i_offset, after the 4 bytes of p_riff if any */
+    static const struct
+    {
+        char    p_riff[5];
+        uint8_t i_offset;
+        uint8_t i_size;
+        char    p_magic[9];
+        char    demux[6];
+    } signatures[] =
+    {
+        { "",     0, 4, "\x1A\x45\xDF\xA3",      "mkv" },
+        { "",     4, 4, "ftyp",                    "mp4" },
+        { "",     4, 4, "moov",                    "mp4" },
+        { "",     4, 4, "mdat",                    "mp4" },
+        { "",     0, 4, "OggS",                    "ogg" },
+        { "",     0, 4, "fLaC",                    "flac" },
+        { "RIFF", 8, 4, "AVI ",                    "avi" },
+        { "FORM", 8, 4, "AIFF",                    "aiff" },
+        { "",     0, 8, "\x30\x26\xB2\x75\x8E\x66\xCF\x11", "asf" },
+        { "",     0, 4, "\x00\x00\x01\xBA",      "ps" },
+        { "",     0, 4, "MThd",                    "smf" },
+        { "",     0, 4, ".snd",                    "au" },
+        { "",     0, 4, "NSVf",                    "nsv" },
+        { "",     0, 4, "BBCD",                    "dirac" },
+        { "",     0, 7, "#EXTM3U",                 "m3u" },
+        { "",     0, 0, "",                        "" },
+    };
+    const uint8_t *p_peek;
+    int i_peek = stream_Peek( s, &p_peek, 3 * 188 );
+
+    if( i_peek < 16 )
+        return NULL;
+
+    for( unsigned i = 0; signatures[i].i_size; i++ )
+    {
+        if( !memcmp( &p_peek[signatures[i].i_offset], signatures[i].p_magic,
+                     signatures[i].i_size ) &&
+            ( !signatures[i].p_riff[0] ||
+              !memcmp( p_peek, signatures[i].p_riff, 4 ) ) )
+            return signatures[i].demux;
+    }
+
+    /* Three TS packets in a row */
+    if( i_peek >= 2 * 188 + 1 &&
+        p_peek[0] == 0x47 && p_peek[188] == 0x47 && p_peek[2 * 188] == 0x47 )
+        return "ts";
+
+    return NULL;
+}
+
 /*****************************************************************************
  * demux_Delete:
  *****************************************************************************/
@@ -350,7 +425,10 @@ decoder_t *demux_PacketizerNew( demux_t *p_demux, es_format_t *p_fmt, const char
     p_packetizer->fmt_in = *p_fmt;
     es_format_Init( &p_packetizer->fmt_out, UNKNOWN_ES, 0 );
 
-    p_packetizer->p_module = module_need( p_packetizer, "packetizer", NULL, false );
+    p_packetizer->p_module =
+        module_need_codec( p_packetizer, "packetizer", NULL, false,
+                           vlc_fourcc_GetCodec( p_fmt->i_cat,
+                                                p_fmt->i_codec ) );
     if( !p_packetizer->p_module )
     {
         es_format_Clean( p_fmt );
@@ -372,6 +450,179 @@ void demux_PacketizerDestroy( decoder_t *p_packetizer )
     vlc_object_release( p_packetizer );
 }
 
+/*****************************************************************************
+ * demux_IndexCache*: files of what demuxers learnt scanning their input
+ *****************************************************************************
+ * Each directory keeps the most recently written files only, within these.
+ *****************************************************************************/
+#define INDEX_CACHE_MAX_FILES 100
+#define INDEX_CACHE_MAX_SIZE  (64 << 20)
+
+typedef struct
+{
+    char   *psz_path;
+    time_t i_mtime;
+    off_t  i_size;
+} index_cache_file_t;
+
+static int IndexCacheCompare( const void *a, const void *b )
+{
+    const index_cache_file_t *p_a = a, *p_b = b;
+
+    return ( p_a->i_mtime > p_b->i_mtime ) - ( p_a->i_mtime < p_b->i_mtime );
+}
+
+/* Removes the oldest files of psz_dir, leaving room for one more */
+static void IndexCachePrune( const char *psz_dir )
+{
+    DIR *p_dir = vlc_opendir( psz_dir );
+    if( !p_dir )
+        return;
+
+    index_cache_file_t *p_files = NULL;
+    int i_files = 0, i_max = 0;
+    int64_t i_total = 0;
+    char *psz_name;
+
+    while( ( psz_name = vlc_readdir( p_dir ) ) != NULL )
+    {
+        char *psz_path;
+        struct stat st;
+
+        if( psz_name[0] == '.' ||
+            asprintf( &psz_path, "%s"DIR_SEP"%s", psz_dir, psz_name ) < 0 )
+        {
+            free( psz_name );
+            continue;
+        }
+        free( psz_name );
+        if( vlc_stat( psz_path, &st ) || !S_ISREG( st.st_mode ) )
+        {
+            free( psz_path );
+            continue;
+        }
+        if( i_files == i_max )
+        {
+            i_max = i_max ? 2 * i_max : 64;
+            p_files = realloc_or_free( p_files, i_max * sizeof( *p_files ) );
+            if( !p_files )
+            {
+                free( psz_path );
+                closedir( p_dir );
+                return;
+            }
+        }
+        p_files[i_files].psz_path = psz_path;
+        p_files[i_files].i_mtime = st.st_mtime;
+        p_files[i_files].i_size = st.st_size;
+        i_total += st.st_size;
+        i_files++;
+    }
+    closedir( p_dir );
+
+    qsort( p_files, i_files, sizeof( *p_files ), IndexCacheCompare );
+    for( int i = 0; i < i_files; i++ )
+    {
+        if( i_files - i >= INDEX_CACHE_MAX_FILES ||
+            i_total > INDEX_CACHE_MAX_SIZE )
+        {
+            vlc_unlink( p_files[i].psz_path );
+            i_total -= p_files[i].i_size;
+        }
+        free( p_files[i].psz_path );
+    }
+    free( p_files );
+}
+
+char *demux_IndexCachePath( demux_t *p_demux, const char *psz_name )
+{
+    const char *psz_access = p_demux->psz_access;
+    struct stat st;
+
+    /* Only local files tell when they changed */
+    if( p_demux->s == NULL || p_demux->psz_file == NULL ||
+        ( psz_access && *psz_access && strcmp( psz_access, "file" ) ) ||
+        vlc_stat( p_demux->psz_file, &st ) || !S_ISREG( st.st_mode ) )
+        return NULL;
+
+    const int64_t i_size = stream_Size( p_demux->s );
+    if( i_size <= 0 )
+        return NULL;
+
+    char *psz_dir = config_GetUserDir( VLC_CACHE_DIR );
+    if( !psz_dir )
+        return NULL;
+
+    /* Files are told apart by their location, size and modification date */
+    char psz_stamp[42];
+    struct md5_s md5;
+    snprintf( psz_stamp, sizeof( psz_stamp ), "%"PRId64" %"PRId64,
+              i_size, (int64_t)st.st_mtime );
+    InitMD5( &md5 );
+    if( psz_access )
+        AddMD5( &md5, psz_access, strlen( psz_access ) );
+    AddMD5( &md5, "://", 3 );
+    AddMD5( &md5, p_demux->psz_location, strlen( p_demux->psz_location ) );
+    AddMD5( &md5, psz_stamp, strlen( psz_stamp ) );
+    EndMD5( &md5 );
+
+    char *psz_md5 = psz_md5_hash( &md5 );
+    char *psz_path;
+    if( !psz_md5 || asprintf( &psz_path, "%s"DIR_SEP"%s"DIR_SEP"%s",
+                              psz_dir, psz_name, psz_md5 ) < 0 )
+        psz_path = NULL;
+    free( psz_md5 );
+    free( psz_dir );
+    return psz_path;
+}
+
+FILE *demux_IndexCacheCreate( demux_t *p_demux, const char *psz_path )
+{
+    /* The cache directory and ours in it */
+    char *psz_dir = strdup( psz_path );
+    if( !psz_dir )
+        return NULL;
+    *strrchr( psz_dir, DIR_SEP_CHAR ) = '\0';
+    char *psz_sep = strrchr( psz_dir, DIR_SEP_CHAR );
+    if( psz_sep )
+    {
+        *psz_sep = '\0';
+        vlc_mkdir( psz_dir, 0700 );
+        *psz_sep = DIR_SEP_CHAR;
+    }
+    vlc_mkdir( psz_dir, 0700 );
+    IndexCachePrune( psz_dir );
+    free( psz_dir );
+
+    char *psz_tmp;
+    if( asprintf( &psz_tmp, "%s.tmp", psz_path ) < 0 )
+        return NULL;
+    FILE *p_file = vlc_fopen( psz_tmp, "wb" );
+    if( !p_file )
+        msg_Warn( p_demux, "cannot write index %s", psz_tmp );
+    free( psz_tmp );
+    return p_file;
+}
+
+int demux_IndexCacheClose( demux_t *p_demux, const char *psz_path,
+                           FILE *p_file, bool b_ok )
+{
+    char *psz_tmp;
+
+    b_ok = !fclose( p_file ) && b_ok;
+    if( asprintf( &psz_tmp, "%s.tmp", psz_path ) < 0 )
+        return VLC_ENOMEM;
+    if( !b_ok || vlc_rename( psz_tmp, psz_path ) )
+    {
+        msg_Warn( p_demux, "cannot write index %s", psz_tmp );
+        vlc_unlink( psz_tmp );
+        free( psz_tmp );
+        return VLC_EGENERIC;
+    }
+    free( psz_tmp );
+    return VLC_SUCCESS;
+}
+
 static bool SkipID3Tag( demux_t *p_demux )
 {
     const uint8_t *p_peek;
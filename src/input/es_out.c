@@ -1079,6 +1079,7 @@ static es_out_pgrm_t *EsOutProgramAdd( es_out_t *out, int i_group )
     if( p_sys->b_paused )
         input_clock_ChangePause( p_pgrm->p_clock, p_sys->b_paused, p_sys->i_pause_date );
     input_clock_SetJitter( p_pgrm->p_clock, p_sys->i_pts_delay, p_sys->i_cr_average );
+    input_clock_SetCatchUp( p_pgrm->p_clock, var_InheritBool( p_input, "clock-catchup" ) );
 
     /* Append it */
     TAB_APPEND( p_sys->i_pgrm, p_sys->pgrm, p_pgrm );
@@ -2329,6 +2330,15 @@ static int EsOutControlLocked( es_out_t *out, int i_query, va_list args )
 
             if( p_pgrm == p_sys->p_pgrm )
             {
+                input_thread_t *p_input = p_sys->p_input;
+                if( libvlc_stats( p_input ) )
+                {
+                    vlc_mutex_lock( &p_input->p->counters.counters_lock );
+                    stats_UpdateInteger( p_input, p_input->p->counters.p_demux_latency,
+                                         input_clock_GetLatency( p_pgrm->p_clock ), NULL );
+                    vlc_mutex_unlock( &p_input->p->counters.counters_lock );
+                }
+
                 if( p_sys->b_buffering )
                 {
                     /* Check buffering state on master clock update */
@@ -2593,6 +2603,10 @@ static int EsOutControlLocked( es_out_t *out, int i_query, va_list args )
         {
             const mtime_t i_date = (mtime_t)va_arg( args, mtime_t );
 
+            /* Only the timeshift buffer can jump to a given time */
+            if( i_date >= 0 )
+                return VLC_EGENERIC;
+
             assert( i_date == -1 );
             EsOutChangePosition( out );
 
@@ -40,6 +40,12 @@
 #ifdef HAVE_UNISTD_H
 # include <unistd.h>
 #endif
+#ifdef HAVE_MMAP
+# include <sys/mman.h>
+#endif
+#ifdef HAVE_POSIX_FALLOCATE
+# include <fcntl.h>
+#endif
 
 #include <vlc_common.h>
 #include <vlc_fs.h>
@@ -49,6 +55,7 @@
 #include <vlc_input.h>
 #include <vlc_es_out.h>
 #include <vlc_block.h>
+#include <vlc_memstats.h>
 #include "input_internal.h"
 #include "es_out.h"
 #include "es_out_timeshift.h"
@@ -154,6 +161,12 @@ typedef struct attribute_packed
     } u;
 } ts_cmd_t;
 
+typedef struct
+{
+    mtime_t i_time; /* Time reported by the ES_OUT_SET_TIMES command */
+    int     i_cmd;  /* Index of the command */
+} ts_seekpoint_t;
+
 typedef struct ts_storage_t ts_storage_t;
 struct ts_storage_t
 {
@@ -165,12 +178,20 @@ struct ts_storage_t
     int64_t i_file_size;/* Current size in bytes */
     FILE    *p_filew;   /* FILE handle for data writing */
     FILE    *p_filer;   /* FILE handle for data reading */
+#ifdef HAVE_MMAP
+    uint8_t *p_map;     /* Mapping of the i_file_max first bytes, if any */
+#endif
 
     /* */
     int      i_cmd_r;
     int      i_cmd_w;
     int      i_cmd_max;
     ts_cmd_t *p_cmd;
+
+    /* Time index of the commands */
+    int            i_seekpoint;
+    int            i_seekpoint_max;
+    ts_seekpoint_t *p_seekpoint;
 };
 
 typedef struct
@@ -204,6 +225,9 @@ typedef struct
 
     mtime_t        i_cmd_delay;
 
+    /* Incremented on each seek */
+    unsigned       i_seek_count;
+
 } ts_thread_t;
 
 struct es_out_id_t
@@ -254,6 +278,7 @@ static bool         TsHasCmd( ts_thread_t * );
 static bool         TsIsUnused( ts_thread_t * );
 static int          TsChangePause( ts_thread_t *, bool b_source_paused, bool b_paused, mtime_t i_date );
 static int          TsChangeRate( ts_thread_t *, int i_src_rate, int i_rate );
+static int          TsSeek( ts_thread_t *, mtime_t i_time );
 
 static void         *TsRun( void * );
 
@@ -264,6 +289,7 @@ static bool         TsStorageIsFull( ts_storage_t *, const ts_cmd_t *p_cmd );
 static bool         TsStorageIsEmpty( ts_storage_t * );
 static void         TsStoragePushCmd( ts_storage_t *, const ts_cmd_t *p_cmd, bool b_flush );
 static void         TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush );
+static int          TsStorageFindTime( ts_storage_t *, mtime_t i_time );
 
 static void CmdClean( ts_cmd_t * );
 static void cmd_cleanup_routine( void *p ) { CmdClean( p ); }
@@ -283,6 +309,7 @@ static void CmdExecuteAdd    ( es_out_t *, ts_cmd_t * );
 static int  CmdExecuteSend   ( es_out_t *, ts_cmd_t * );
 static void CmdExecuteDel    ( es_out_t *, ts_cmd_t * );
 static int  CmdExecuteControl( es_out_t *, ts_cmd_t * );
+static bool CmdIsClock       ( const ts_cmd_t * );
 
 /* File helpers */
 static char *GetTmpPath( char *psz_path );
@@ -415,8 +442,8 @@ static int Send( es_out_t *p_out, es_out_id_t *p_es, block_t *p_block )
 
     vlc_mutex_lock( &p_sys->lock );
 
-    TsAutoStop( p_out );
-
+    /* Not checking TsAutoStop() here saves locking the thread for every
+     * block, the controls (PCR at least) are frequent enough for it */
     CmdInitSend( &cmd, p_es, p_block );
     if( p_sys->b_delayed )
         TsPushCmd( p_sys->p_ts, &cmd );
@@ -563,6 +590,10 @@ static int ControlLockedSetTime( es_out_t *p_out, mtime_t i_date )
     if( !p_sys->b_delayed )
         return es_out_SetTime( p_sys->p_out, i_date );
 
+    /* Jump inside the timeshift buffer */
+    if( i_date >= 0 )
+        return TsSeek( p_sys->p_ts, i_date );
+
     /* TODO */
     msg_Err( p_sys->p_input, "EsOutTimeshift does not yet support time change" );
     return VLC_EGENERIC;
@@ -758,6 +789,7 @@ static int TsStart( es_out_t *p_out )
     p_ts->i_rate_delay = 0;
     p_ts->i_buffering_delay = 0;
     p_ts->i_cmd_delay = 0;
+    p_ts->i_seek_count = 0;
     p_ts->p_storage_r = NULL;
     p_ts->p_storage_w = NULL;
 
@@ -935,6 +967,79 @@ static int TsChangeRate( ts_thread_t *p_ts, int i_src_rate, int i_rate )
 
     return i_ret;
 }
+static int TsSeek( ts_thread_t *p_ts, mtime_t i_time )
+{
+    vlc_mutex_lock( &p_ts->lock );
+
+    /* Find the first buffered command reporting a time not before i_time.
+     * Already played commands are not kept, so only forward jumps within
+     * the buffer are possible */
+    ts_storage_t *p_storage;
+    int i_cmd = -1;
+    for( p_storage = p_ts->p_storage_r; p_storage; p_storage = p_storage->p_next )
+    {
+        i_cmd = TsStorageFindTime( p_storage, i_time );
+        if( i_cmd >= 0 )
+            break;
+    }
+    if( !p_storage ||
+        ( p_storage == p_ts->p_storage_r && i_cmd < p_storage->i_cmd_r ) )
+    {
+        vlc_mutex_unlock( &p_ts->lock );
+        return VLC_EGENERIC;
+    }
+
+    /* Skip the commands up to it, the blocks are not even read back, but
+     * the ES and program state changes still have to be applied */
+    while( p_ts->p_storage_r != p_storage || p_storage->i_cmd_r < i_cmd )
+    {
+        ts_cmd_t cmd;
+
+        if( TsPopCmdLocked( p_ts, &cmd, true ) )
+            break;
+
+        switch( cmd.i_type )
+        {
+        case C_ADD:
+            CmdExecuteAdd( p_ts->p_out, &cmd );
+            CmdCleanAdd( &cmd );
+            break;
+        case C_CONTROL:
+            if( !CmdIsClock( &cmd ) )
+                CmdExecuteControl( p_ts->p_out, &cmd );
+            CmdCleanControl( &cmd );
+            break;
+        case C_DEL:
+            CmdExecuteDel( p_ts->p_out, &cmd );
+            break;
+        default:
+            CmdClean( &cmd );
+            break;
+        }
+    }
+
+    /* Reset the decoders and the clock, and play the new first command now */
+    es_out_SetTime( p_ts->p_out, -1 );
+
+    const mtime_t i_now = mdate();
+    if( !TsStorageIsEmpty( p_ts->p_storage_r ) )
+    {
+        const ts_cmd_t *p_next = &p_ts->p_storage_r->p_cmd[p_ts->p_storage_r->i_cmd_r];
+
+        p_ts->i_cmd_delay = i_now - p_next->i_date - p_ts->i_buffering_delay;
+    }
+    p_ts->i_rate_date = -1;
+    p_ts->i_rate_delay = 0;
+    if( p_ts->b_paused )
+        p_ts->i_pause_date = i_now;
+    p_ts->i_seek_count++;
+
+    vlc_cond_signal( &p_ts->wait );
+    vlc_mutex_unlock( &p_ts->lock );
+
+    msg_Dbg( p_ts->p_input, "es out timeshift: seek to %"PRId64, i_time );
+    return VLC_SUCCESS;
+}
 
 static void *TsRun( void *p_data )
 {
@@ -945,6 +1050,7 @@ static void *TsRun( void *p_data )
     {
         ts_cmd_t cmd;
         mtime_t  i_deadline;
+        unsigned i_seek_count;
         bool b_buffering;
 
         /* Pop a command to execute */
@@ -1014,6 +1120,7 @@ static void *TsRun( void *p_data )
             vlc_restorecancel( canc );
         }
         i_deadline = cmd.i_date + p_ts->i_cmd_delay + p_ts->i_rate_delay + p_ts->i_buffering_delay;
+        i_seek_count = p_ts->i_seek_count;
 
         vlc_cleanup_run();
 
@@ -1025,8 +1132,20 @@ static void *TsRun( void *p_data )
 
         vlc_cleanup_pop();
 
-        /* Execute the command  */
+        /* A seek happened meanwhile, the command predates it */
+        vlc_mutex_lock( &p_ts->lock );
+        const bool b_seeked = i_seek_count != p_ts->i_seek_count;
+        vlc_mutex_unlock( &p_ts->lock );
+
         const int canc = vlc_savecancel();
+        if( b_seeked && ( cmd.i_type == C_SEND || CmdIsClock( &cmd ) ) )
+        {
+            CmdClean( &cmd );
+            vlc_restorecancel( canc );
+            continue;
+        }
+
+        /* Execute the command  */
         switch( cmd.i_type )
         {
         case C_ADD:
@@ -1077,7 +1196,8 @@ static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_
     p_storage->i_cmd_w = 0;
     p_storage->i_cmd_r = 0;
     p_storage->i_cmd_max = 30000;
-    p_storage->p_cmd = malloc( p_storage->i_cmd_max * sizeof(*p_storage->p_cmd) );
+    p_storage->p_cmd = vlc_malloc_tagged( VLC_MEM_TIMESHIFT,
+                            p_storage->i_cmd_max * sizeof(*p_storage->p_cmd) );
     //fprintf( stderr, "\nSTORAGE name=%s size=%d KiB\n", p_storage->psz_file, p_storage->i_cmd_max * sizeof(*p_storage->p_cmd) /1024 );
 
     if( !p_storage->p_cmd || !p_storage->p_filew || !p_storage->p_filer )
@@ -1085,6 +1205,23 @@ static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_
         TsStorageDelete( p_storage );
         return NULL;
     }
+
+#if defined(HAVE_MMAP) && defined(HAVE_POSIX_FALLOCATE)
+    /* Reserve the file up front, so that writing to the mapping cannot
+     * fail on a full disk, and copy the blocks in and out of it instead
+     * of going through stdio */
+    const int fd = fileno( p_storage->p_filew );
+    if( !posix_fallocate( fd, 0, p_storage->i_file_max ) )
+    {
+        void *p_map = mmap( NULL, p_storage->i_file_max,
+                            PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0 );
+        if( p_map != MAP_FAILED )
+        {
+            p_storage->p_map = p_map;
+            VLC_MEM_ALLOC( VLC_MEM_TIMESHIFT, p_storage->i_file_max );
+        }
+    }
+#endif
     return p_storage;
 }
 static void TsStorageDelete( ts_storage_t *p_storage )
@@ -1097,8 +1234,17 @@ static void TsStorageDelete( ts_storage_t *p_storage )
 
         CmdClean( &cmd );
     }
-    free( p_storage->p_cmd );
+    vlc_free_tagged( VLC_MEM_TIMESHIFT, p_storage->p_cmd,
+                     p_storage->i_cmd_max * sizeof(*p_storage->p_cmd) );
+    free( p_storage->p_seekpoint );
 
+#ifdef HAVE_MMAP
+    if( p_storage->p_map )
+    {
+        munmap( p_storage->p_map, p_storage->i_file_max );
+        VLC_MEM_FREE( VLC_MEM_TIMESHIFT, p_storage->i_file_max );
+    }
+#endif
     if( p_storage->p_filer )
         fclose( p_storage->p_filer );
     if( p_storage->p_filew )
@@ -1118,11 +1264,17 @@ static void TsStoragePack( ts_storage_t *p_storage )
     if( p_storage->i_cmd_w >= p_storage->i_cmd_max )
         return;
 
-    p_storage->i_cmd_max = __MAX( p_storage->i_cmd_w, 1 );
+    const int i_cmd_max = __MAX( p_storage->i_cmd_w, 1 );
 
-    ts_cmd_t *p_new = realloc( p_storage->p_cmd, p_storage->i_cmd_max * sizeof(*p_storage->p_cmd) );
+    ts_cmd_t *p_new = realloc( p_storage->p_cmd, i_cmd_max * sizeof(*p_storage->p_cmd) );
     if( p_new )
+    {
+        VLC_MEM_FREE( VLC_MEM_TIMESHIFT,
+                      p_storage->i_cmd_max * sizeof(*p_storage->p_cmd) );
+        VLC_MEM_ALLOC( VLC_MEM_TIMESHIFT, i_cmd_max * sizeof(*p_new) );
         p_storage->p_cmd = p_new;
+        p_storage->i_cmd_max = i_cmd_max;
+    }
 }
 static bool TsStorageIsFull( ts_storage_t *p_storage, const ts_cmd_t *p_cmd )
 {
@@ -1150,9 +1302,27 @@ static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd, bo
         block_t *p_block = cmd.u.send.p_block;
 
         cmd.u.send.p_block = NULL;
-        cmd.u.send.i_offset = ftell( p_storage->p_filew );
+        cmd.u.send.i_offset = p_storage->i_file_size;
+
+#ifdef HAVE_MMAP
+        /* Only a first block larger than the file misses the mapping */
+        if( p_storage->p_map &&
+            p_storage->i_file_size + sizeof(*p_block) + p_block->i_buffer <= p_storage->i_file_max )
+        {
+            uint8_t *p_dst = &p_storage->p_map[p_storage->i_file_size];
+
+            memcpy( p_dst, p_block, sizeof(*p_block) );
+            if( p_block->i_buffer > 0 )
+                memcpy( &p_dst[sizeof(*p_block)], p_block->p_buffer, p_block->i_buffer );
+            p_storage->i_file_size += sizeof(*p_block) + p_block->i_buffer;
+            block_Release( p_block );
 
-        if( fwrite( p_block, sizeof(*p_block), 1, p_storage->p_filew ) != 1 )
+            p_storage->p_cmd[p_storage->i_cmd_w++] = cmd;
+            return;
+        }
+#endif
+        if( fseek( p_storage->p_filew, p_storage->i_file_size, SEEK_SET ) ||
+            fwrite( p_block, sizeof(*p_block), 1, p_storage->p_filew ) != 1 )
         {
             block_Release( p_block );
             return;
@@ -1169,9 +1339,36 @@ static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd, bo
         p_storage->i_file_size += p_block->i_buffer;
         block_Release( p_block );
 
+#ifdef HAVE_MMAP
+        if( p_storage->p_map ) /* it is read back through the mapping */
+            b_flush = true;
+#endif
         if( b_flush )
             fflush( p_storage->p_filew );
     }
+    else if( cmd.i_type == C_CONTROL &&
+             cmd.u.control.i_query == ES_OUT_SET_TIMES &&
+             cmd.u.control.u.times.i_time >= 0 )
+    {
+        if( p_storage->i_seekpoint >= p_storage->i_seekpoint_max )
+        {
+            const int i_max = __MAX( 2 * p_storage->i_seekpoint_max, 64 );
+            ts_seekpoint_t *p_new = realloc( p_storage->p_seekpoint,
+                                             i_max * sizeof(*p_new) );
+            if( p_new )
+            {
+                p_storage->p_seekpoint = p_new;
+                p_storage->i_seekpoint_max = i_max;
+            }
+        }
+        if( p_storage->i_seekpoint < p_storage->i_seekpoint_max )
+        {
+            ts_seekpoint_t *p_seekpoint = &p_storage->p_seekpoint[p_storage->i_seekpoint++];
+
+            p_seekpoint->i_time = cmd.u.control.u.times.i_time;
+            p_seekpoint->i_cmd = p_storage->i_cmd_w;
+        }
+    }
     p_storage->p_cmd[p_storage->i_cmd_w++] = cmd;
 }
 static void TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush )
@@ -1179,6 +1376,32 @@ static void TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_fl
     assert( !TsStorageIsEmpty( p_storage ) );
 
     *p_cmd = p_storage->p_cmd[p_storage->i_cmd_r++];
+#ifdef HAVE_MMAP
+    if( p_cmd->i_type == C_SEND && !b_flush && p_storage->p_map &&
+        p_cmd->u.send.i_offset + sizeof(block_t) <= p_storage->i_file_max )
+    {
+        const uint8_t *p_src = &p_storage->p_map[p_cmd->u.send.i_offset];
+        block_t block;
+
+        /* The block may have been written past the mapping, see above */
+        memcpy( &block, p_src, sizeof(block) );
+        if( p_cmd->u.send.i_offset + sizeof(block) + block.i_buffer <= p_storage->i_file_max )
+        {
+            block_t *p_block = block_Alloc( block.i_buffer );
+            if( p_block )
+            {
+                p_block->i_dts      = block.i_dts;
+                p_block->i_pts      = block.i_pts;
+                p_block->i_flags    = block.i_flags;
+                p_block->i_length   = block.i_length;
+                p_block->i_nb_samples = block.i_nb_samples;
+                memcpy( p_block->p_buffer, &p_src[sizeof(block)], block.i_buffer );
+            }
+            p_cmd->u.send.p_block = p_block;
+            return;
+        }
+    }
+#endif
     if( p_cmd->i_type == C_SEND )
     {
         block_t block;
@@ -1206,6 +1429,24 @@ static void TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_fl
         }
     }
 }
+static int TsStorageFindTime( ts_storage_t *p_storage, mtime_t i_time )
+{
+    /* The times are reported in increasing order */
+    int i_low = 0;
+    int i_high = p_storage->i_seekpoint;
+    while( i_low < i_high )
+    {
+        const int i_mid = ( i_low + i_high ) / 2;
+
+        if( p_storage->p_seekpoint[i_mid].i_time < i_time )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
+    if( i_low >= p_storage->i_seekpoint )
+        return -1;
+    return p_storage->p_seekpoint[i_low].i_cmd;
+}
 
 /*****************************************************************************
  *
@@ -1533,6 +1774,25 @@ static void CmdCleanControl( ts_cmd_t *p_cmd )
         free( p_cmd->u.control.u.es_fmt.p_fmt );
     }
 }
+static bool CmdIsClock( const ts_cmd_t *p_cmd )
+{
+    /* Commands only meaningful at their place in the stream, dropped when
+     * jumping over them */
+    if( p_cmd->i_type != C_CONTROL )
+        return false;
+
+    switch( p_cmd->u.control.i_query )
+    {
+    case ES_OUT_SET_PCR:
+    case ES_OUT_SET_GROUP_PCR:
+    case ES_OUT_RESET_PCR:
+    case ES_OUT_SET_NEXT_DISPLAY_TIME:
+    case ES_OUT_SET_TIMES:
+        return true;
+    default:
+        return false;
+    }
+}
 
 
 /*****************************************************************************
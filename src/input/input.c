@@ -44,6 +44,7 @@
 #include "stream.h"
 #include "item.h"
 #include "resource.h"
+#include "info.h"
 
 #include <vlc_sout.h>
 #include "../stream_output/stream_output.h"
@@ -54,6 +55,8 @@
 #include <vlc_fs.h>
 #include <vlc_strings.h>
 #include <vlc_modules.h>
+#include <vlc_atomic.h>
+#include <vlc_tracer.h>
 
 #ifdef HAVE_SYS_STAT_H
 #   include <sys/stat.h>
@@ -537,6 +540,34 @@ static void Destructor( input_thread_t * p_input )
     free( p_input->p );
 }
 
+/*****************************************************************************
+ * BindNode: keeps the threads of the input on one NUMA node
+ *****************************************************************************/
+static void BindNode( input_thread_t *p_input )
+{
+    static vlc_atomic_t next_node = VLC_ATOMIC_INIT(0);
+    int i_node = var_InheritInteger( p_input, "numa-node" );
+
+    if( i_node == -1 )
+        return;
+
+    const unsigned i_count = vlc_numa_GetNodeCount();
+    if( i_count < 2 )
+        return;
+    if( i_node < 0 )
+        i_node = (vlc_atomic_inc( &next_node ) - 1) % i_count;
+
+    /* The threads created from now on by this one inherit the binding */
+    int val = vlc_numa_Bind( i_node );
+    if( val )
+    {
+        errno = val;
+        msg_Warn( p_input, "cannot bind to NUMA node %d: %m", i_node );
+    }
+    else
+        msg_Dbg( p_input, "bound to NUMA node %d", i_node );
+}
+
 /*****************************************************************************
  * Run: main thread loop
  * This is the "normal" thread that spawns the input processing chain,
@@ -547,6 +578,7 @@ static void *Run( void *obj )
     input_thread_t *p_input = (input_thread_t *)obj;
     const int canc = vlc_savecancel();
 
+    BindNode( p_input );
     if( Init( p_input ) )
         goto exit;
 
@@ -588,7 +620,11 @@ static void MainLoopDemux( input_thread_t *p_input, bool *pb_changed, bool *pb_d
         ( p_input->p->i_run > 0 && i_start_mdate+p_input->p->i_run < mdate() ) )
         i_ret = 0; /* EOF */
     else
+    {
+        VLC_TRACE_BEGIN( "demux" );
         i_ret = demux_Demux( p_input->p->input.p_demux );
+        VLC_TRACE_END( "demux" );
+    }
 
     if( i_ret > 0 )
     {
@@ -713,6 +749,53 @@ static void MainLoopInterface( input_thread_t *p_input )
     vlc_mutex_unlock( &p_input->p->p_item->lock );
 }
 
+/**
+ * UpdateAudioInfo
+ * It publishes the audio pipeline statistics as an info category
+ */
+static void UpdateAudioInfo( input_thread_t *p_input )
+{
+    input_stats_t *p_stats = p_input->p->p_item->p_stats;
+
+    if( !libvlc_stats( p_input ) )
+        return;
+
+    vlc_mutex_lock( &p_stats->lock );
+    const int64_t i_buffers = p_stats->i_played_abuffers;
+    const int64_t i_filter = p_stats->i_audio_filter_time;
+    const int64_t i_resampler = p_stats->i_audio_resampler_time;
+    const int64_t i_output = p_stats->i_audio_output_time;
+    const int64_t i_allocations = p_stats->i_audio_allocations;
+    const int64_t i_buffered = p_stats->i_audio_buffered;
+    const int64_t i_delay = p_stats->i_audio_delay;
+    vlc_mutex_unlock( &p_stats->lock );
+
+    if( i_buffers <= 0 )
+        return;
+
+    info_category_t *p_cat = info_category_New( _("Audio output") );
+    if( unlikely(p_cat == NULL) )
+        return;
+
+    info_category_AddInfo( p_cat, _("Buffered"), "%"PRId64" ms",
+                           i_buffered / 1000 );
+    if( i_delay >= 0 )
+        info_category_AddInfo( p_cat, _("Output delay"), "%"PRId64" ms",
+                               i_delay / 1000 );
+    else
+        info_category_AddInfo( p_cat, _("Output delay"), _("Unknown") );
+    info_category_AddInfo( p_cat, _("Filters time per buffer"),
+                           "%"PRId64" us", i_filter / i_buffers );
+    info_category_AddInfo( p_cat, _("Resamplers time per buffer"),
+                           "%"PRId64" us", i_resampler / i_buffers );
+    info_category_AddInfo( p_cat, _("Output time per buffer"),
+                           "%"PRId64" us", i_output / i_buffers );
+    info_category_AddInfo( p_cat, _("Allocations per buffer"), "%.2f",
+                           (double)i_allocations / i_buffers );
+
+    input_Control( p_input, INPUT_REPLACE_INFOS, p_cat );
+}
+
 /**
  * MainLoopStatistic
  * It updates the globals statics
@@ -721,6 +804,7 @@ static void MainLoopStatistic( input_thread_t *p_input )
 {
     stats_ComputeInputStats( p_input, p_input->p->p_item->p_stats );
     input_SendEventStatistics( p_input );
+    UpdateAudioInfo( p_input );
 }
 
 /**
@@ -873,13 +957,7 @@ static void InitStatistics( input_thread_t * p_input )
         INIT_COUNTER( demux_bitrate, FLOAT, DERIVATIVE );
         INIT_COUNTER( demux_corrupted, INTEGER, COUNTER );
         INIT_COUNTER( demux_discontinuity, INTEGER, COUNTER );
-        INIT_COUNTER( played_abuffers, INTEGER, COUNTER );
-        INIT_COUNTER( lost_abuffers, INTEGER, COUNTER );
-        INIT_COUNTER( displayed_pictures, INTEGER, COUNTER );
-        INIT_COUNTER( lost_pictures, INTEGER, COUNTER );
-        INIT_COUNTER( decoded_audio, INTEGER, COUNTER );
-        INIT_COUNTER( decoded_video, INTEGER, COUNTER );
-        INIT_COUNTER( decoded_sub, INTEGER, COUNTER );
+        INIT_COUNTER( demux_latency, INTEGER, LAST );
         p_input->p->counters.p_sout_send_bitrate = NULL;
         p_input->p->counters.p_sout_sent_packets = NULL;
         p_input->p->counters.p_sout_sent_bytes = NULL;
@@ -1358,13 +1436,7 @@ error:
         EXIT_COUNTER( demux_bitrate );
         EXIT_COUNTER( demux_corrupted );
         EXIT_COUNTER( demux_discontinuity );
-        EXIT_COUNTER( played_abuffers );
-        EXIT_COUNTER( lost_abuffers );
-        EXIT_COUNTER( displayed_pictures );
-        EXIT_COUNTER( lost_pictures );
-        EXIT_COUNTER( decoded_audio );
-        EXIT_COUNTER( decoded_video );
-        EXIT_COUNTER( decoded_sub );
+        EXIT_COUNTER( demux_latency );
 
         if( p_input->p->p_sout )
         {
@@ -1431,13 +1503,7 @@ static void End( input_thread_t * p_input )
             CL_CO( demux_bitrate );
             CL_CO( demux_corrupted );
             CL_CO( demux_discontinuity );
-            CL_CO( played_abuffers );
-            CL_CO( lost_abuffers );
-            CL_CO( displayed_pictures );
-            CL_CO( lost_pictures );
-            CL_CO( decoded_audio) ;
-            CL_CO( decoded_video );
-            CL_CO( decoded_sub) ;
+            CL_CO( demux_latency );
         }
 
         /* Close optional stream output instance */
@@ -1750,6 +1816,13 @@ static bool Control( input_thread_t *p_input,
             if( i_time < 0 )
                 i_time = 0;
 
+            /* Jump within the timeshift buffer when it holds that time */
+            if( !es_out_SetTime( p_input->p->p_es_out, i_time ) )
+            {
+                b_force_update = true;
+                break;
+            }
+
             /* Reset the decoders states and clock sync (before calling the demuxer */
             es_out_SetTime( p_input->p->p_es_out, -1 );
 
@@ -3206,19 +3279,25 @@ void input_UpdateStatistic( input_thread_t *p_input,
 {
     assert( p_input->p->i_state != INIT_S );
 
-    vlc_mutex_lock( &p_input->p->counters.counters_lock);
     switch( i_type )
     {
-#define I(c) stats_UpdateInteger( p_input, p_input->p->counters.c, i_delta, NULL )
     case INPUT_STATISTIC_DECODED_VIDEO:
-        I(p_decoded_video);
-        break;
+        vlc_atomic_add( &p_input->p->counters.decoded_video, i_delta );
+        return;
     case INPUT_STATISTIC_DECODED_AUDIO:
-        I(p_decoded_audio);
-        break;
+        vlc_atomic_add( &p_input->p->counters.decoded_audio, i_delta );
+        return;
     case INPUT_STATISTIC_DECODED_SUBTITLE:
-        I(p_decoded_sub);
+        vlc_atomic_add( &p_input->p->counters.decoded_sub, i_delta );
+        return;
+    default:
         break;
+    }
+
+    vlc_mutex_lock( &p_input->p->counters.counters_lock);
+    switch( i_type )
+    {
+#define I(c) stats_UpdateInteger( p_input, p_input->p->counters.c, i_delta, NULL )
     case INPUT_STATISTIC_SENT_PACKET:
         I(p_sout_sent_packets);
         break;
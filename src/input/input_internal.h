@@ -144,17 +144,30 @@ struct input_thread_private_t
         counter_t *p_demux_bitrate;
         counter_t *p_demux_corrupted;
         counter_t *p_demux_discontinuity;
-        counter_t *p_decoded_audio;
-        counter_t *p_decoded_video;
-        counter_t *p_decoded_sub;
+        counter_t *p_demux_latency;
         counter_t *p_sout_sent_packets;
         counter_t *p_sout_sent_bytes;
         counter_t *p_sout_send_bitrate;
-        counter_t *p_played_abuffers;
-        counter_t *p_lost_abuffers;
-        counter_t *p_displayed_pictures;
-        counter_t *p_lost_pictures;
         vlc_mutex_t counters_lock;
+
+        /* Updated per block or picture by the decoder threads, without
+         * counters_lock; they are only summed up when read */
+        vlc_atomic_t decoded_audio;
+        vlc_atomic_t decoded_video;
+        vlc_atomic_t decoded_sub;
+        vlc_atomic_t played_abuffers;
+        vlc_atomic_t lost_abuffers;
+        vlc_atomic_t audio_filter_time;
+        vlc_atomic_t audio_resampler_time;
+        vlc_atomic_t audio_output_time;
+        vlc_atomic_t audio_allocations;
+        vlc_atomic_t audio_buffered; /* last value */
+        vlc_atomic_t audio_delay; /* last value */
+        vlc_atomic_t displayed_pictures;
+        vlc_atomic_t lost_pictures;
+        stats_histogram_t video_decode_time;
+        stats_histogram_t audio_decode_time;
+        stats_histogram_t video_latency;
     } counters;
 
     /* Buffer of pending actions */
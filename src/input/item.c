@@ -33,6 +33,7 @@
 #include "vlc_interface.h"
 #include <vlc_charset.h>
 #include <vlc_atomic.h>
+#include <vlc_memstats.h>
 
 #include "item.h"
 #include "info.h"
@@ -451,6 +452,7 @@ static void input_item_Destroy ( gc_object_t *p_gc )
     input_item_t *p_item = vlc_priv( p_gc, input_item_t );
 
     input_item_Clean( p_item );
+    VLC_MEM_FREE( VLC_MEM_PLAYLIST, sizeof( *p_item ) );
     free( p_item );
 }
 
@@ -814,6 +816,7 @@ input_item_NewWithType( const char *psz_uri, const char *psz_name,
     input_item_t* p_input = calloc( 1, sizeof( *p_input ) );
     if( !p_input )
         return NULL;
+    VLC_MEM_ALLOC( VLC_MEM_PLAYLIST, sizeof( *p_input ) );
     vlc_event_manager_t * p_em = &p_input->event_manager;
 
     p_input->i_id = vlc_atomic_inc(&last_input_id);
@@ -1034,18 +1037,37 @@ void input_item_node_AppendNode( input_item_node_t *p_parent, input_item_node_t
     p_child->p_parent = p_parent;
 }
 
-void input_item_node_PostAndDelete( input_item_node_t *p_root )
+static void post_tree( input_item_node_t *p_root, bool b_partial )
 {
     post_subitems( p_root );
 
     vlc_event_t event;
     event.type = vlc_InputItemSubItemTreeAdded;
     event.u.input_item_subitem_tree_added.p_root = p_root;
+    event.u.input_item_subitem_tree_added.b_partial = b_partial;
     vlc_event_send( &p_root->p_item->event_manager, &event );
+}
 
+void input_item_node_PostAndDelete( input_item_node_t *p_root )
+{
+    post_tree( p_root, false );
     input_item_node_Delete( p_root );
 }
 
+void input_item_node_PostBatch( input_item_node_t *p_root )
+{
+    if( p_root->i_children == 0 )
+        return;
+
+    post_tree( p_root, true );
+
+    for( int i = 0; i < p_root->i_children; i++ )
+        RecursiveNodeDelete( p_root->pp_children[i] );
+    free( p_root->pp_children );
+    p_root->pp_children = NULL;
+    p_root->i_children = 0;
+}
+
 /* Called by es_out when a new Elementary Stream is added or updated. */
 void input_item_UpdateTracksInfo(input_item_t *item, const es_format_t *fmt)
 {
@@ -37,15 +37,160 @@
 #include "input_internal.h"
 #include "../playlist/art.h"
 
+/* Only the fields that are set are stored, in no particular order */
+typedef struct
+{
+    vlc_meta_type_t type;
+    const char *value; /* interned */
+} vlc_meta_field_t;
+
 struct vlc_meta_t
 {
-    char * ppsz_meta[VLC_META_TYPE_COUNT];
-    
-    vlc_dictionary_t extra_tags;
-    
+    vlc_meta_field_t *fields;
+    unsigned i_fields;
+
+    vlc_dictionary_t extra_tags; /* interned values */
+
     int i_status;
 };
 
+/*****************************************************************************
+ * Interned strings
+ *****************************************************************************
+ * Huge playlists repeat the same few values (artist, album, genre, date...)
+ * in thousands of items. The values are stored once, with a reference count,
+ * in a process-wide table.
+ */
+typedef struct meta_string meta_string_t;
+
+struct meta_string
+{
+    meta_string_t *next;
+    uint32_t       hash;
+    unsigned       refs;
+    char           str[];
+};
+
+static vlc_mutex_t intern_lock = VLC_STATIC_MUTEX;
+static struct
+{
+    meta_string_t **buckets;
+    size_t size; /* power of two */
+    size_t count;
+} intern = { NULL, 0, 0 };
+
+static uint32_t MetaHash( const char *psz )
+{
+    uint32_t h = 2166136261u; /* FNV-1a */
+
+    while( *psz )
+        h = (h ^ (unsigned char)*psz++) * 16777619u;
+    return h;
+}
+
+static meta_string_t *MetaString( const char *psz )
+{
+    return (meta_string_t *)(psz - offsetof(meta_string_t, str));
+}
+
+/* Grows the table, so that the chains stay short (intern_lock held) */
+static void MetaInternGrow( void )
+{
+    size_t size = intern.size ? 2 * intern.size : 256;
+    meta_string_t **buckets = calloc( size, sizeof(*buckets) );
+    if( unlikely(buckets == NULL) )
+        return; /* keep the longer chains */
+
+    for( size_t i = 0; i < intern.size; i++ )
+        for( meta_string_t *s = intern.buckets[i], *next; s != NULL; s = next )
+        {
+            next = s->next;
+            s->next = buckets[s->hash & (size - 1)];
+            buckets[s->hash & (size - 1)] = s;
+        }
+    free( intern.buckets );
+    intern.buckets = buckets;
+    intern.size = size;
+}
+
+/**
+ * Returns the interned copy of a string, with a new reference.
+ * MetaRelease() must be called when it is no longer used.
+ */
+static const char *MetaIntern( const char *psz )
+{
+    uint32_t hash = MetaHash( psz );
+    meta_string_t *s;
+
+    vlc_mutex_lock( &intern_lock );
+    if( intern.count >= intern.size )
+        MetaInternGrow();
+    if( unlikely(intern.size == 0) )
+        goto error;
+
+    meta_string_t **pp = &intern.buckets[hash & (intern.size - 1)];
+    for( s = *pp; s != NULL; s = s->next )
+        if( s->hash == hash && !strcmp( s->str, psz ) )
+        {
+            s->refs++;
+            goto out;
+        }
+
+    size_t len = strlen( psz ) + 1;
+    s = malloc( sizeof(*s) + len );
+    if( unlikely(s == NULL) )
+        goto error;
+    s->hash = hash;
+    s->refs = 1;
+    memcpy( s->str, psz, len );
+    s->next = *pp;
+    *pp = s;
+    intern.count++;
+out:
+    vlc_mutex_unlock( &intern_lock );
+    return s->str;
+error:
+    vlc_mutex_unlock( &intern_lock );
+    return NULL;
+}
+
+/** Adds a reference to an interned string */
+static const char *MetaHold( const char *psz )
+{
+    vlc_mutex_lock( &intern_lock );
+    MetaString( psz )->refs++;
+    vlc_mutex_unlock( &intern_lock );
+    return psz;
+}
+
+/** Releases a reference to an interned string (NULL is ignored) */
+static void MetaRelease( const char *psz )
+{
+    if( psz == NULL )
+        return;
+
+    meta_string_t *s = MetaString( psz );
+
+    vlc_mutex_lock( &intern_lock );
+    if( --s->refs == 0 )
+    {
+        meta_string_t **pp = &intern.buckets[s->hash & (intern.size - 1)];
+
+        while( *pp != s )
+            pp = &(*pp)->next;
+        *pp = s->next;
+        free( s );
+
+        if( --intern.count == 0 )
+        {   /* do not leak the table at exit */
+            free( intern.buckets );
+            intern.buckets = NULL;
+            intern.size = 0;
+        }
+    }
+    vlc_mutex_unlock( &intern_lock );
+}
+
 /* FIXME bad name convention */
 const char * vlc_meta_TypeToLocalizedString( vlc_meta_type_t meta_type )
 {
@@ -84,24 +229,25 @@ vlc_meta_t *vlc_meta_New( void )
     vlc_meta_t *m = (vlc_meta_t*)malloc( sizeof(*m) );
     if( !m )
         return NULL;
-    memset( m->ppsz_meta, 0, sizeof(m->ppsz_meta) );
+    m->fields = NULL;
+    m->i_fields = 0;
     m->i_status = 0;
     vlc_dictionary_init( &m->extra_tags, 0 );
     return m;
 }
 
-/* Free a dictonary key allocated by strdup() in vlc_meta_AddExtra() */
+/* Release a dictonary value interned in vlc_meta_AddExtra() */
 static void vlc_meta_FreeExtraKey( void *p_data, void *p_obj )
 {
     VLC_UNUSED( p_obj );
-    free( p_data );
+    MetaRelease( p_data );
 }
 
 void vlc_meta_Delete( vlc_meta_t *m )
 {
-    int i;
-    for( i = 0; i < VLC_META_TYPE_COUNT ; i++ )
-        free( m->ppsz_meta[i] );
+    for( unsigned i = 0; i < m->i_fields; i++ )
+        MetaRelease( m->fields[i].value );
+    free( m->fields );
     vlc_dictionary_clear( &m->extra_tags, vlc_meta_FreeExtraKey, NULL );
     free( m );
 }
@@ -112,15 +258,58 @@ void vlc_meta_Delete( vlc_meta_t *m )
  * FIXME - Why don't we merge those two?
  */ 
 
+static vlc_meta_field_t *vlc_meta_Find( const vlc_meta_t *p_meta,
+                                        vlc_meta_type_t meta_type )
+{
+    for( unsigned i = 0; i < p_meta->i_fields; i++ )
+        if( p_meta->fields[i].type == meta_type )
+            return &p_meta->fields[i];
+    return NULL;
+}
+
+/* Takes over the reference to an interned value (or NULL to clear) */
+static void vlc_meta_SetInterned( vlc_meta_t *p_meta, vlc_meta_type_t meta_type,
+                                  const char *psz_val )
+{
+    vlc_meta_field_t *p_field = vlc_meta_Find( p_meta, meta_type );
+
+    if( p_field != NULL )
+    {
+        MetaRelease( p_field->value );
+        if( psz_val != NULL )
+            p_field->value = psz_val;
+        else
+            *p_field = p_meta->fields[--p_meta->i_fields];
+        return;
+    }
+    if( psz_val == NULL )
+        return;
+
+    p_field = realloc( p_meta->fields,
+                       (p_meta->i_fields + 1) * sizeof(*p_field) );
+    if( unlikely(p_field == NULL) )
+    {
+        MetaRelease( psz_val );
+        return;
+    }
+    p_meta->fields = p_field;
+    p_field += p_meta->i_fields++;
+    p_field->type = meta_type;
+    p_field->value = psz_val;
+}
+
 void vlc_meta_Set( vlc_meta_t *p_meta, vlc_meta_type_t meta_type, const char *psz_val )
 {
-    free( p_meta->ppsz_meta[meta_type] );
-    p_meta->ppsz_meta[meta_type] = psz_val ? strdup( psz_val ) : NULL;
+    assert( meta_type < VLC_META_TYPE_COUNT );
+    vlc_meta_SetInterned( p_meta, meta_type,
+                          psz_val ? MetaIntern( psz_val ) : NULL );
 }
 
 const char *vlc_meta_Get( const vlc_meta_t *p_meta, vlc_meta_type_t meta_type )
 {
-    return p_meta->ppsz_meta[meta_type];
+    const vlc_meta_field_t *p_field = vlc_meta_Find( p_meta, meta_type );
+
+    return p_field ? p_field->value : NULL;
 }
 
 void vlc_meta_AddExtra( vlc_meta_t *m, const char *psz_name, const char *psz_value )
@@ -129,7 +318,8 @@ void vlc_meta_AddExtra( vlc_meta_t *m, const char *psz_name, const char *psz_val
     if( psz_oldvalue != kVLCDictionaryNotFound )
         vlc_dictionary_remove_value_for_key( &m->extra_tags, psz_name,
                                             vlc_meta_FreeExtraKey, NULL );
-    vlc_dictionary_insert( &m->extra_tags, psz_name, strdup(psz_value) );
+    vlc_dictionary_insert( &m->extra_tags, psz_name,
+                           (void *)MetaIntern( psz_value ) );
 }
 
 const char * vlc_meta_GetExtra( const vlc_meta_t *m, const char *psz_name )
@@ -172,14 +362,9 @@ void vlc_meta_Merge( vlc_meta_t *dst, const vlc_meta_t *src )
     if( !dst || !src )
         return;
     
-    for( i = 0; i < VLC_META_TYPE_COUNT; i++ )
-    {
-        if( src->ppsz_meta[i] )
-        {
-            free( dst->ppsz_meta[i] );
-            dst->ppsz_meta[i] = strdup( src->ppsz_meta[i] );
-        }
-    }
+    for( unsigned j = 0; j < src->i_fields; j++ )
+        vlc_meta_SetInterned( dst, src->fields[j].type,
+                              MetaHold( src->fields[j].value ) );
     
     /* XXX: If speed up are needed, it is possible */
     ppsz_all_keys = vlc_dictionary_all_keys( &src->extra_tags );
@@ -189,7 +374,9 @@ void vlc_meta_Merge( vlc_meta_t *dst, const vlc_meta_t *src )
         vlc_dictionary_remove_value_for_key( &dst->extra_tags, ppsz_all_keys[i], vlc_meta_FreeExtraKey, NULL );
         
         void *p_value = vlc_dictionary_value_for_key( &src->extra_tags, ppsz_all_keys[i] );
-        vlc_dictionary_insert( &dst->extra_tags, ppsz_all_keys[i], strdup( (const char*)p_value ) );
+        if( p_value != NULL )
+            MetaHold( p_value );
+        vlc_dictionary_insert( &dst->extra_tags, ppsz_all_keys[i], p_value );
         free( ppsz_all_keys[i] );
     }
     free( ppsz_all_keys );
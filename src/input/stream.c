@@ -27,10 +27,14 @@
 
 #include <dirent.h>
 #include <assert.h>
+#ifdef HAVE_POSIX_MADVISE
+#   include <sys/mman.h>
+#endif
 
 #include <vlc_common.h>
 #include <vlc_strings.h>
 #include <vlc_memory.h>
+#include <vlc_memstats.h>
 
 #include <libvlc.h>
 
@@ -58,15 +62,22 @@
  *      It should probably defaulted (instead of the stream method (2)).
  */
 
-/* How many tracks we have, currently only used for stream mode */
+/* How many tracks we have by default, currently only used for stream mode
+ * ("stream-cache-tracks") */
 #ifdef OPTIMIZE_MEMORY
 #   define STREAM_CACHE_TRACK 1
     /* Max size of our cache 128Ko per track */
 #   define STREAM_CACHE_SIZE  (STREAM_CACHE_TRACK*1024*128)
+    /* Tracks never grow past this by default ("stream-track-size") */
+#   define STREAM_CACHE_TRACK_MAX (128*1024)
+    /* Default for all the tracks of all streams ("stream-cache-budget") */
+#   define STREAM_CACHE_BUDGET (1024*1024)
 #else
 #   define STREAM_CACHE_TRACK 3
     /* Max size of our cache 4Mo per track */
 #   define STREAM_CACHE_SIZE  (4*STREAM_CACHE_TRACK*1024*1024)
+#   define STREAM_CACHE_TRACK_MAX (32*1024*1024)
+#   define STREAM_CACHE_BUDGET (256*1024*1024)
 #endif
 
 /* How many data we try to prebuffer
@@ -87,13 +98,49 @@
  *          if close enough, read data and use this ring
  *          else use the oldest ring, seek and use it.
  *
+ *  - Every STREAM_CACHE_PERIOD, the tracks are resized to hold about
+ *      STREAM_CACHE_DURATION at the rate data was read, within
+ *      STREAM_CACHE_TRACK_MIN and "stream-track-size" and as long as all
+ *      the streams stay within "stream-cache-budget".
+ *  - i_read_size doubles while reading goes on without hard seek, and
+ *      falls back to "stream-read-size" when seeks jump around.
+ *
  *  TODO: - with access non seekable: use all space available for only one ring, but
  *          we have to support seekable/non-seekable switch on the fly.
- *        - compute a good value for i_read_size
  *        - ?
  */
 #define STREAM_READ_ATONCE 1024
+#define STREAM_READ_MAX (64*1024)
 #define STREAM_CACHE_TRACK_SIZE (STREAM_CACHE_SIZE/STREAM_CACHE_TRACK)
+#define STREAM_CACHE_TRACK_MIN (256*1024)
+#define STREAM_CACHE_PERIOD (2*CLOCK_FREQ)
+#define STREAM_CACHE_DURATION (8*CLOCK_FREQ)
+
+/* Read-ahead for method 2 ("stream-readahead")
+ *  A thread reads from the access into a ring buffer below the tracks, so
+ *  that the tracks are refilled from memory. It keeps enough data for
+ *  STREAM_AHEAD_DURATION at the rate the tracks consume it, within
+ *  STREAM_AHEAD_MIN and STREAM_AHEAD_SIZE, and more after an underrun.
+ */
+#ifdef OPTIMIZE_MEMORY
+#   define STREAM_AHEAD_SIZE (256*1024)
+#else
+#   define STREAM_AHEAD_SIZE (4*1024*1024)
+#endif
+#define STREAM_AHEAD_MIN (64*1024)
+#define STREAM_AHEAD_READ (32*1024)          /* at most per access read */
+#define STREAM_AHEAD_DURATION (2*CLOCK_FREQ)
+#define STREAM_AHEAD_PERIOD (CLOCK_FREQ/2)   /* of the rate estimation */
+
+/* Prefetch hints (STREAM_SET_PREFETCH_HINTS), for methods 2 and 3
+ *  The ranges are sorted, and merged across gaps under STREAM_HINT_GAP
+ *  that are cheaper to read through than to seek over. A hard seek into
+ *  one refills the track with the whole range at once, instead of growing
+ *  the reads from "stream-read-size" again, and uses the hint up. With a
+ *  mapping, the kernel is asked to read every range in the background.
+ */
+#define STREAM_HINT_MAX 64
+#define STREAM_HINT_GAP (64*1024)
 
 typedef struct
 {
@@ -113,10 +160,17 @@ typedef struct
 
 } access_entry_t;
 
+/* Method3: Zero-copy, for accesses that map the whole input (ACCESS_GET_MMAP)
+ *  Peek returns pointers into the mapping, read copies once out of it.
+ *  Reaching the end maps the input again, in case it grew.
+ */
+#define STREAM_MMAP_WILLNEED (1024*1024) /* hinted after a seek */
+
 typedef enum
 {
     STREAM_METHOD_BLOCK,
-    STREAM_METHOD_STREAM
+    STREAM_METHOD_STREAM,
+    STREAM_METHOD_MMAP
 } stream_read_method_t;
 
 struct stream_sys_t
@@ -145,17 +199,69 @@ struct stream_sys_t
     {
         unsigned i_offset;   /* Buffer offset in the current track */
         int      i_tk;       /* Current track */
-        stream_track_t tk[STREAM_CACHE_TRACK];
+        stream_track_t *tk;
+        int      i_tk_count;
+        unsigned i_tk_size;  /* Size of every track */
+        unsigned i_tk_max;
 
-        /* Global buffer */
+        /* Global buffer, accounted in the budget */
         uint8_t *p_buffer;
+        size_t   i_budget;
+        size_t   i_budget_max;  /* For all the streams */
 
         /* */
         unsigned i_used; /* Used since last read */
         unsigned i_read_size;
+        unsigned i_read_min;
+
+        /* Adaptation */
+        int64_t  i_adapt_date;
+        uint64_t i_adapt_bytes; /* stat.i_bytes at i_adapt_date */
+        uint64_t i_byterate;
+        unsigned i_hard_seeks;  /* Since the last refill */
 
     } stream;
 
+    /* Method 3: mapped input */
+    struct
+    {
+        block_t *p_block;
+    } mmap;
+
+    /* Read-ahead, for method 2 only */
+    struct
+    {
+        bool         b_on;
+        vlc_thread_t thread;
+        vlc_mutex_t  lock;
+        vlc_cond_t   wait;        /* data, EOF or the thread left the access */
+        vlc_cond_t   wait_thread; /* room, resume or exit */
+
+        uint8_t  *p_buffer;       /* STREAM_AHEAD_SIZE ring */
+        size_t   i_begin;         /* Ring offset of the first byte */
+        size_t   i_fill;          /* Bytes in the ring */
+        uint64_t i_pos;           /* Stream position of the first byte */
+        size_t   i_target;        /* Bytes to keep in the ring */
+
+        bool     b_pause;         /* The access is needed by the reader */
+        bool     b_busy;          /* The thread is reading from the access */
+        bool     b_eof;
+        bool     b_exit;
+
+        /* Consumption, seen by the reader only */
+        int64_t  i_rate_date;
+        uint64_t i_rate_bytes;
+        uint64_t i_rate;          /* Bytes per second */
+
+    } ahead;
+
+    /* Prefetch hints, by offset */
+    struct
+    {
+        stream_range_t p_range[STREAM_HINT_MAX];
+        int            i_count;
+    } hint;
+
     /* Peek temporary buffer */
     unsigned int i_peek;
     uint8_t *p_peek;
@@ -196,8 +302,27 @@ static int  AStreamPeekStream( stream_t *s, const uint8_t **pp_peek, unsigned in
 static int  AStreamSeekStream( stream_t *s, uint64_t i_pos );
 static void AStreamPrebufferStream( stream_t *s );
 static int  AReadStream( stream_t *s, void *p_read, unsigned int i_read );
+static int  AStreamCacheSetup( stream_t *s );
+static void AStreamCacheRelease( size_t i_bytes );
+
+/* Method 2 read-ahead */
+static int  AStreamAheadStart( stream_t *s );
+static void AStreamAheadStop( stream_t *s );
+static int  AStreamAheadRead( stream_t *s, void *p_read, unsigned int i_read );
+static int  AStreamAheadSeek( stream_t *s, uint64_t i_pos );
+static void AStreamAheadPause( stream_t *s );
+static void AStreamAheadResume( stream_t *s, bool b_flush );
+
+/* Method 3 */
+static int  AStreamReadMmap( stream_t *s, void *p_read, unsigned int i_read );
+static int  AStreamPeekMmap( stream_t *s, const uint8_t **pp_peek, unsigned int i_read );
+static int  AStreamSeekMmap( stream_t *s, uint64_t i_pos );
+static int  AStreamRefreshMmap( stream_t *s );
 
 /* Common */
+static int  AStreamSetHints( stream_t *s, const stream_range_t *, int );
+static uint64_t AStreamTakeHint( stream_t *s, uint64_t i_pos );
+
 static int AStreamControl( stream_t *s, int i_query, va_list );
 static void AStreamDestroy( stream_t *s );
 static void UStreamDestroy( stream_t *s );
@@ -307,6 +432,11 @@ stream_t *stream_AccessNew( access_t *p_access, char **ppsz_list )
         p_sys->method = STREAM_METHOD_STREAM;
 
     p_sys->i_pos = p_access->info.i_pos;
+    p_sys->ahead.b_on = false;
+    p_sys->stream.tk = NULL;
+    p_sys->stream.p_buffer = NULL;
+    p_sys->stream.i_budget = 0;
+    p_sys->hint.i_count = 0;
 
     /* Stats */
     access_Control( p_access, ACCESS_CAN_FASTSEEK, &p_sys->stat.b_fastseek );
@@ -369,6 +499,13 @@ stream_t *stream_AccessNew( access_t *p_access, char **ppsz_list )
     p_sys->i_peek = 0;
     p_sys->p_peek = NULL;
 
+    /* Local files may be mapped rather than read */
+    p_sys->mmap.p_block = NULL;
+    if( p_sys->method == STREAM_METHOD_STREAM && !p_sys->i_list &&
+        p_sys->stat.b_fastseek &&
+        !access_Control( p_access, ACCESS_GET_MMAP, &p_sys->mmap.p_block ) )
+        p_sys->method = STREAM_METHOD_MMAP;
+
     if( p_sys->method == STREAM_METHOD_BLOCK )
     {
         msg_Dbg( s, "Using block method for AStream*" );
@@ -392,6 +529,12 @@ stream_t *stream_AccessNew( access_t *p_access, char **ppsz_list )
             goto error;
         }
     }
+    else if( p_sys->method == STREAM_METHOD_MMAP )
+    {
+        msg_Dbg( s, "Using mmap method for AStream*" );
+        s->pf_read = AStreamReadMmap;
+        s->pf_peek = AStreamPeekMmap;
+    }
     else
     {
         int i;
@@ -406,22 +549,20 @@ stream_t *stream_AccessNew( access_t *p_access, char **ppsz_list )
         /* Allocate/Setup our tracks */
         p_sys->stream.i_offset = 0;
         p_sys->stream.i_tk     = 0;
-        p_sys->stream.p_buffer = malloc( STREAM_CACHE_SIZE );
-        if( p_sys->stream.p_buffer == NULL )
+        if( AStreamCacheSetup( s ) )
             goto error;
         p_sys->stream.i_used   = 0;
-        p_sys->stream.i_read_size = STREAM_READ_ATONCE;
 #if STREAM_READ_ATONCE < 256
 #   error "Invalid STREAM_READ_ATONCE value"
 #endif
 
-        for( i = 0; i < STREAM_CACHE_TRACK; i++ )
+        for( i = 0; i < p_sys->stream.i_tk_count; i++ )
         {
             p_sys->stream.tk[i].i_date  = 0;
             p_sys->stream.tk[i].i_start = p_sys->i_pos;
             p_sys->stream.tk[i].i_end   = p_sys->i_pos;
             p_sys->stream.tk[i].p_buffer=
-                &p_sys->stream.p_buffer[i * STREAM_CACHE_TRACK_SIZE];
+                &p_sys->stream.p_buffer[i * p_sys->stream.i_tk_size];
         }
 
         /* Do the prebuffering */
@@ -432,6 +573,10 @@ stream_t *stream_AccessNew( access_t *p_access, char **ppsz_list )
             msg_Err( s, "cannot pre fill buffer" );
             goto error;
         }
+
+        if( var_InheritBool( s, "stream-readahead" ) &&
+            AStreamAheadStart( s ) )
+            msg_Warn( s, "cannot read ahead, reading from the tracks" );
     }
 
     return s;
@@ -443,7 +588,11 @@ error:
     }
     else
     {
-        free( p_sys->stream.p_buffer );
+        vlc_free_tagged( VLC_MEM_STREAM, p_sys->stream.p_buffer,
+                         (size_t)p_sys->stream.i_tk_count
+                                 * p_sys->stream.i_tk_size );
+        free( p_sys->stream.tk );
+        AStreamCacheRelease( p_sys->stream.i_budget );
     }
     while( p_sys->i_list > 0 )
         free( p_sys->list[--(p_sys->i_list)] );
@@ -460,10 +609,21 @@ static void AStreamDestroy( stream_t *s )
 {
     stream_sys_t *p_sys = s->p_sys;
 
+    if( p_sys->ahead.b_on )
+        AStreamAheadStop( s );
+
     if( p_sys->method == STREAM_METHOD_BLOCK )
         block_ChainRelease( p_sys->block.p_first );
+    else if( p_sys->method == STREAM_METHOD_MMAP )
+        block_Release( p_sys->mmap.p_block );
     else
-        free( p_sys->stream.p_buffer );
+    {
+        vlc_free_tagged( VLC_MEM_STREAM, p_sys->stream.p_buffer,
+                         (size_t)p_sys->stream.i_tk_count
+                                 * p_sys->stream.i_tk_size );
+        free( p_sys->stream.tk );
+        AStreamCacheRelease( p_sys->stream.i_budget );
+    }
 
     free( p_sys->p_peek );
 
@@ -496,6 +656,10 @@ static void AStreamControlReset( stream_t *s )
 {
     stream_sys_t *p_sys = s->p_sys;
 
+    /* The mapping does not follow the access */
+    if( p_sys->method == STREAM_METHOD_MMAP )
+        return;
+
     p_sys->i_pos = p_sys->p_access->info.i_pos;
 
     if( p_sys->method == STREAM_METHOD_BLOCK )
@@ -524,7 +688,7 @@ static void AStreamControlReset( stream_t *s )
         p_sys->stream.i_tk     = 0;
         p_sys->stream.i_used   = 0;
 
-        for( i = 0; i < STREAM_CACHE_TRACK; i++ )
+        for( i = 0; i < p_sys->stream.i_tk_count; i++ )
         {
             p_sys->stream.tk[i].i_date  = 0;
             p_sys->stream.tk[i].i_start = p_sys->i_pos;
@@ -543,6 +707,21 @@ static void AStreamControlUpdate( stream_t *s )
 {
     stream_sys_t *p_sys = s->p_sys;
 
+    if( p_sys->method == STREAM_METHOD_MMAP )
+    {
+        AStreamRefreshMmap( s );
+        return;
+    }
+
+    if( p_sys->ahead.b_on )
+    {
+        /* What the thread read ahead is not read yet */
+        vlc_mutex_lock( &p_sys->ahead.lock );
+        p_sys->i_pos = p_sys->ahead.i_pos;
+        vlc_mutex_unlock( &p_sys->ahead.lock );
+        return;
+    }
+
     p_sys->i_pos = p_sys->p_access->info.i_pos;
 
     if( p_sys->i_list )
@@ -605,6 +784,8 @@ static int AStreamControl( stream_t *s, int i_query, va_list args )
                 return AStreamSeekBlock( s, i_64 );
             case STREAM_METHOD_STREAM:
                 return AStreamSeekStream( s, i_64 );
+            case STREAM_METHOD_MMAP:
+                return AStreamSeekMmap( s, i_64 );
             default:
                 assert(0);
                 return VLC_EGENERIC;
@@ -623,8 +804,14 @@ static int AStreamControl( stream_t *s, int i_query, va_list args )
                             "DON'T USE STREAM_CONTROL_ACCESS !!!" );
                 return VLC_EGENERIC;
             }
+            bool b_reset = i_int == ACCESS_SET_TITLE ||
+                           i_int == ACCESS_SET_SEEKPOINT;
+            if( p_sys->ahead.b_on )
+                AStreamAheadPause( s );
             int i_ret = access_vaControl( p_access, i_int, args );
-            if( i_int == ACCESS_SET_TITLE || i_int == ACCESS_SET_SEEKPOINT )
+            if( p_sys->ahead.b_on )
+                AStreamAheadResume( s, b_reset );
+            if( b_reset )
                 AStreamControlReset( s );
             return i_ret;
         }
@@ -636,6 +823,15 @@ static int AStreamControl( stream_t *s, int i_query, va_list args )
         case STREAM_GET_CONTENT_TYPE:
             return access_Control( p_access, ACCESS_GET_CONTENT_TYPE,
                                     va_arg( args, char ** ) );
+
+        case STREAM_SET_PREFETCH_HINTS:
+        {
+            const stream_range_t *p_range =
+                va_arg( args, const stream_range_t * );
+            i_int = va_arg( args, int );
+            return AStreamSetHints( s, p_range, i_int );
+        }
+
         case STREAM_SET_RECORD_STATE:
         default:
             msg_Err( s, "invalid stream_vaControl query=0x%x", i_query );
@@ -644,6 +840,93 @@ static int AStreamControl( stream_t *s, int i_query, va_list args )
     return VLC_SUCCESS;
 }
 
+static int AStreamCompareHints( const void *a, const void *b )
+{
+    const stream_range_t *ra = a, *rb = b;
+
+    if( ra->i_offset != rb->i_offset )
+        return ra->i_offset < rb->i_offset ? -1 : 1;
+    return 0;
+}
+
+static int AStreamSetHints( stream_t *s, const stream_range_t *p_range,
+                            int i_count )
+{
+    stream_sys_t *p_sys = s->p_sys;
+    stream_range_t *tab = p_sys->hint.p_range;
+
+    p_sys->hint.i_count = 0;
+    if( p_sys->method == STREAM_METHOD_BLOCK )
+        return VLC_EGENERIC;
+    if( i_count <= 0 )
+        return VLC_SUCCESS;
+
+    /* The nearest come first, they are kept */
+    i_count = __MIN( i_count, STREAM_HINT_MAX );
+    memcpy( tab, p_range, i_count * sizeof( *tab ) );
+    qsort( tab, i_count, sizeof( *tab ), AStreamCompareHints );
+
+    int n = 0;
+    for( int i = 0; i < i_count; i++ )
+    {
+        if( tab[i].i_size == 0 )
+            continue;
+
+        stream_range_t *p_last = n > 0 ? &tab[n - 1] : NULL;
+        if( p_last &&
+            tab[i].i_offset <= p_last->i_offset + p_last->i_size + STREAM_HINT_GAP )
+        {
+            uint64_t i_end = __MAX( p_last->i_offset + p_last->i_size,
+                                    tab[i].i_offset + tab[i].i_size );
+            p_last->i_size = i_end - p_last->i_offset;
+        }
+        else
+            tab[n++] = tab[i];
+    }
+    p_sys->hint.i_count = n;
+
+#ifdef HAVE_POSIX_MADVISE
+    if( p_sys->method == STREAM_METHOD_MMAP )
+    {
+        const uint64_t i_size = p_sys->mmap.p_block->i_buffer;
+        for( int i = 0; i < n; i++ )
+        {
+            if( tab[i].i_offset >= i_size )
+                break;
+
+            size_t i_start = tab[i].i_offset & ~UINT64_C(0xffff);
+            uint64_t i_end = __MIN( tab[i].i_offset + tab[i].i_size, i_size );
+            posix_madvise( &p_sys->mmap.p_block->p_buffer[i_start],
+                           i_end - i_start, POSIX_MADV_WILLNEED );
+        }
+        p_sys->hint.i_count = 0;
+    }
+#endif
+    return VLC_SUCCESS;
+}
+
+/* Bytes hinted from i_pos on, the hint is then dropped */
+static uint64_t AStreamTakeHint( stream_t *s, uint64_t i_pos )
+{
+    stream_sys_t *p_sys = s->p_sys;
+    stream_range_t *tab = p_sys->hint.p_range;
+
+    for( int i = 0; i < p_sys->hint.i_count; i++ )
+    {
+        if( tab[i].i_offset > i_pos )
+            break;
+        if( i_pos >= tab[i].i_offset + tab[i].i_size )
+            continue;
+
+        uint64_t i_left = tab[i].i_offset + tab[i].i_size - i_pos;
+        p_sys->hint.i_count--;
+        memmove( &tab[i], &tab[i + 1],
+                 ( p_sys->hint.i_count - i ) * sizeof( *tab ) );
+        return i_left;
+    }
+    return 0;
+}
+
 /****************************************************************************
  * Method 1:
  ****************************************************************************/
@@ -1038,10 +1321,200 @@ static int AStreamRefillBlock( stream_t *s )
 static int AStreamRefillStream( stream_t *s );
 static int AStreamReadNoSeekStream( stream_t *s, void *p_read, unsigned int i_read );
 
+/* Bytes of tracks of all the streams */
+static vlc_mutex_t stream_cache_lock = VLC_STATIC_MUTEX;
+static size_t stream_cache_used = 0;
+
+static bool AStreamCacheReserve( size_t i_bytes, size_t i_max, bool b_force )
+{
+    vlc_mutex_lock( &stream_cache_lock );
+    bool b_ok = b_force || ( stream_cache_used <= i_max &&
+                             i_bytes <= i_max - stream_cache_used );
+    if( b_ok )
+        stream_cache_used += i_bytes;
+    vlc_mutex_unlock( &stream_cache_lock );
+    return b_ok;
+}
+
+static void AStreamCacheRelease( size_t i_bytes )
+{
+    vlc_mutex_lock( &stream_cache_lock );
+    assert( stream_cache_used >= i_bytes );
+    stream_cache_used -= i_bytes;
+    vlc_mutex_unlock( &stream_cache_lock );
+}
+
+/* A track needs no more than the whole stream */
+static unsigned AStreamTrackSize( stream_t *s, uint64_t i_want )
+{
+    stream_sys_t *p_sys = s->p_sys;
+    uint64_t i_size = p_sys->p_access->info.i_size;
+
+    if( p_sys->i_list )
+    {
+        i_size = 0;
+        for( int i = 0; i < p_sys->i_list; i++ )
+            i_size += p_sys->list[i]->i_size;
+    }
+    if( i_size > 0 && i_want > i_size )
+        i_want = i_size;
+
+    i_want = ( i_want + 0xffff ) & ~UINT64_C(0xffff);
+    return VLC_CLIP( i_want, STREAM_CACHE_TRACK_MIN, p_sys->stream.i_tk_max );
+}
+
+static int AStreamCacheSetup( stream_t *s )
+{
+    stream_sys_t *p_sys = s->p_sys;
+
+    int64_t i_count = var_InheritInteger( s, "stream-cache-tracks" );
+    int64_t i_max = var_InheritInteger( s, "stream-track-size" );
+    int64_t i_read = var_InheritInteger( s, "stream-read-size" );
+    int64_t i_budget = var_InheritInteger( s, "stream-cache-budget" );
+
+    p_sys->stream.i_tk_count = i_count > 0 ? __MIN( i_count, 16 )
+                                           : STREAM_CACHE_TRACK;
+    p_sys->stream.i_tk_max = i_max > 0 ? VLC_CLIP( i_max * 1024,
+                                                   STREAM_CACHE_TRACK_MIN,
+                                                   1024 * 1024 * 1024 )
+                                       : STREAM_CACHE_TRACK_MAX;
+    p_sys->stream.i_read_min = i_read > 0 ? VLC_CLIP( i_read, 256,
+                                                      STREAM_READ_MAX )
+                                          : STREAM_READ_ATONCE;
+    p_sys->stream.i_read_size = p_sys->stream.i_read_min;
+    p_sys->stream.i_budget_max = i_budget > 0 ? i_budget * 1024
+                                              : STREAM_CACHE_BUDGET;
+
+    /* Halve the tracks until they fit in what the other streams left */
+    const size_t i_count_tk = p_sys->stream.i_tk_count;
+    unsigned i_size = AStreamTrackSize( s, STREAM_CACHE_TRACK_SIZE );
+    while( !AStreamCacheReserve( i_count_tk * i_size,
+                                 p_sys->stream.i_budget_max,
+                                 i_size <= STREAM_CACHE_TRACK_MIN ) )
+        i_size = __MAX( i_size / 2, STREAM_CACHE_TRACK_MIN );
+    p_sys->stream.i_budget = i_count_tk * i_size;
+    p_sys->stream.i_tk_size = i_size;
+
+    p_sys->stream.tk = calloc( i_count_tk, sizeof( *p_sys->stream.tk ) );
+    p_sys->stream.p_buffer = vlc_malloc_tagged( VLC_MEM_STREAM,
+                                                i_count_tk * i_size );
+    if( !p_sys->stream.tk || !p_sys->stream.p_buffer )
+        return VLC_ENOMEM;
+
+    p_sys->stream.i_adapt_date = mdate();
+    p_sys->stream.i_adapt_bytes = 0;
+    p_sys->stream.i_byterate = 0;
+    p_sys->stream.i_hard_seeks = 0;
+    msg_Dbg( s, "%d tracks of %u KiB", p_sys->stream.i_tk_count,
+             i_size / 1024 );
+    return VLC_SUCCESS;
+}
+
+/* Copy the bytes of stream positions [i_from, i_to) between rings */
+static void AStreamTrackCopy( uint8_t *p_dst, unsigned i_dst_size,
+                              const uint8_t *p_src, unsigned i_src_size,
+                              uint64_t i_from, uint64_t i_to )
+{
+    while( i_from < i_to )
+    {
+        unsigned i_dst = i_from % i_dst_size;
+        unsigned i_src = i_from % i_src_size;
+        size_t i_copy = __MIN( i_to - i_from,
+                               __MIN( i_dst_size - i_dst, i_src_size - i_src ) );
+
+        memcpy( &p_dst[i_dst], &p_src[i_src], i_copy );
+        i_from += i_copy;
+    }
+}
+
+/* Keep the newest i_size bytes of every track, and what is left to read
+ * of the current one */
+static int AStreamResizeTracks( stream_t *s, unsigned i_size )
+{
+    stream_sys_t *p_sys = s->p_sys;
+    stream_track_t *p_current = &p_sys->stream.tk[p_sys->stream.i_tk];
+
+    if( p_current->i_end - p_current->i_start - p_sys->stream.i_offset > i_size )
+        return VLC_EGENERIC;
+
+    uint8_t *p_buffer = vlc_malloc_tagged( VLC_MEM_STREAM,
+                                   (size_t)p_sys->stream.i_tk_count * i_size );
+    if( !p_buffer )
+        return VLC_ENOMEM;
+
+    for( int i = 0; i < p_sys->stream.i_tk_count; i++ )
+    {
+        stream_track_t *tk = &p_sys->stream.tk[i];
+        uint64_t i_start = tk->i_end - __MIN( tk->i_end - tk->i_start, i_size );
+
+        AStreamTrackCopy( &p_buffer[i * i_size], i_size,
+                          tk->p_buffer, p_sys->stream.i_tk_size,
+                          i_start, tk->i_end );
+        if( tk == p_current )
+            p_sys->stream.i_offset -= i_start - tk->i_start;
+        tk->i_start = i_start;
+        tk->p_buffer = &p_buffer[i * i_size];
+    }
+    vlc_free_tagged( VLC_MEM_STREAM, p_sys->stream.p_buffer,
+                     (size_t)p_sys->stream.i_tk_count * p_sys->stream.i_tk_size );
+    p_sys->stream.p_buffer = p_buffer;
+    p_sys->stream.i_tk_size = i_size;
+    return VLC_SUCCESS;
+}
+
+/* Follow the rate the access is read at, between two reads */
+static void AStreamAdaptStream( stream_t *s )
+{
+    stream_sys_t *p_sys = s->p_sys;
+    const int64_t i_now = mdate();
+    const int64_t i_period = i_now - p_sys->stream.i_adapt_date;
+
+    if( i_period < STREAM_CACHE_PERIOD )
+        return;
+
+    uint64_t i_bytes = 0;
+    if( p_sys->stat.i_bytes > p_sys->stream.i_adapt_bytes )
+        i_bytes = p_sys->stat.i_bytes - p_sys->stream.i_adapt_bytes;
+    uint64_t i_byterate = i_bytes * CLOCK_FREQ / i_period;
+
+    if( p_sys->stream.i_byterate > 0 )
+        i_byterate = ( 3 * p_sys->stream.i_byterate + i_byterate ) / 4;
+    p_sys->stream.i_byterate = i_byterate;
+    p_sys->stream.i_adapt_date = i_now;
+    p_sys->stream.i_adapt_bytes = p_sys->stat.i_bytes;
+
+    const unsigned i_old = p_sys->stream.i_tk_size;
+    const unsigned i_size = AStreamTrackSize( s, i_byterate * STREAM_CACHE_DURATION /
+                                                 CLOCK_FREQ );
+    if( i_size <= i_old * 3 / 2 && i_size >= i_old / 2 )
+        return;
+
+    const size_t i_count = p_sys->stream.i_tk_count;
+    if( i_size > i_old &&
+        !AStreamCacheReserve( i_count * ( i_size - i_old ),
+                              p_sys->stream.i_budget_max, false ) )
+        return;
+
+    if( AStreamResizeTracks( s, i_size ) )
+    {
+        if( i_size > i_old )
+            AStreamCacheRelease( i_count * ( i_size - i_old ) );
+        return;
+    }
+    if( i_size < i_old )
+        AStreamCacheRelease( i_count * ( i_old - i_size ) );
+    p_sys->stream.i_budget = i_count * i_size;
+
+    msg_Dbg( s, "tracks resized from %u to %u KiB at %"PRIu64" KiB/s",
+             i_old / 1024, i_size / 1024, i_byterate / 1024 );
+}
+
 static int AStreamReadStream( stream_t *s, void *p_read, unsigned int i_read )
 {
     stream_sys_t *p_sys = s->p_sys;
 
+    AStreamAdaptStream( s );
+
     if( !p_read )
     {
         const uint64_t i_pos_wanted = p_sys->i_pos + i_read;
@@ -1072,8 +1545,8 @@ static int AStreamPeekStream( stream_t *s, const uint8_t **pp_peek, unsigned int
 #endif
 
     /* Avoid problem, but that should *never* happen */
-    if( i_read > STREAM_CACHE_TRACK_SIZE / 2 )
-        i_read = STREAM_CACHE_TRACK_SIZE / 2;
+    if( i_read > p_sys->stream.i_tk_size / 2 )
+        i_read = p_sys->stream.i_tk_size / 2;
 
     while( tk->i_end < tk->i_start + p_sys->stream.i_offset + i_read )
     {
@@ -1092,8 +1565,9 @@ static int AStreamPeekStream( stream_t *s, const uint8_t **pp_peek, unsigned int
 
 
     /* Now, direct pointer or a copy ? */
-    i_off = (tk->i_start + p_sys->stream.i_offset) % STREAM_CACHE_TRACK_SIZE;
-    if( i_off + i_read <= STREAM_CACHE_TRACK_SIZE )
+    const unsigned i_tk_size = p_sys->stream.i_tk_size;
+    i_off = (tk->i_start + p_sys->stream.i_offset) % i_tk_size;
+    if( i_off + i_read <= i_tk_size )
     {
         *pp_peek = &tk->p_buffer[i_off];
         return i_read;
@@ -1110,10 +1584,9 @@ static int AStreamPeekStream( stream_t *s, const uint8_t **pp_peek, unsigned int
         p_sys->i_peek = i_read;
     }
 
-    memcpy( p_sys->p_peek, &tk->p_buffer[i_off],
-            STREAM_CACHE_TRACK_SIZE - i_off );
-    memcpy( &p_sys->p_peek[STREAM_CACHE_TRACK_SIZE - i_off],
-            &tk->p_buffer[0], i_read - (STREAM_CACHE_TRACK_SIZE - i_off) );
+    memcpy( p_sys->p_peek, &tk->p_buffer[i_off], i_tk_size - i_off );
+    memcpy( &p_sys->p_peek[i_tk_size - i_off],
+            &tk->p_buffer[0], i_read - (i_tk_size - i_off) );
 
     *pp_peek = p_sys->p_peek;
     return i_read;
@@ -1162,6 +1635,7 @@ static int AStreamSeekStream( stream_t *s, uint64_t i_pos )
     /* Search a new track slot */
     stream_track_t *tk = NULL;
     int i_tk_idx = -1;
+    uint64_t i_hint = 0;
 
     /* Prefer the current track */
     if( p_current->i_start <= i_pos && i_pos <= p_current->i_end + i_skip_threshold )
@@ -1172,7 +1646,7 @@ static int AStreamSeekStream( stream_t *s, uint64_t i_pos )
     if( !tk )
     {
         /* Try to maximize already read data */
-        for( int i = 0; i < STREAM_CACHE_TRACK; i++ )
+        for( int i = 0; i < p_sys->stream.i_tk_count; i++ )
         {
             stream_track_t *t = &p_sys->stream.tk[i];
 
@@ -1189,7 +1663,7 @@ static int AStreamSeekStream( stream_t *s, uint64_t i_pos )
     if( !tk )
     {
         /* Use the oldest unused */
-        for( int i = 0; i < STREAM_CACHE_TRACK; i++ )
+        for( int i = 0; i < p_sys->stream.i_tk_count; i++ )
         {
             stream_track_t *t = &p_sys->stream.tk[i];
 
@@ -1200,7 +1674,7 @@ static int AStreamSeekStream( stream_t *s, uint64_t i_pos )
             }
         }
     }
-    assert( i_tk_idx >= 0 && i_tk_idx < STREAM_CACHE_TRACK );
+    assert( i_tk_idx >= 0 && i_tk_idx < p_sys->stream.i_tk_count );
 
     if( tk != p_current )
         i_skip_threshold = 0;
@@ -1245,6 +1719,10 @@ static int AStreamSeekStream( stream_t *s, uint64_t i_pos )
 
         tk->i_start = i_pos;
         tk->i_end   = i_pos;
+        p_sys->stream.i_hard_seeks++;
+
+        /* The demuxer told what it reads from there */
+        i_hint = AStreamTakeHint( s, i_pos );
     }
     p_sys->stream.i_offset = i_pos - tk->i_start;
     p_sys->stream.i_tk = i_tk_idx;
@@ -1257,8 +1735,10 @@ static int AStreamSeekStream( stream_t *s, uint64_t i_pos )
      */
     if( tk->i_end < tk->i_start + p_sys->stream.i_offset + p_sys->stream.i_read_size )
     {
-        if( p_sys->stream.i_used < STREAM_READ_ATONCE / 2 )
-            p_sys->stream.i_used = STREAM_READ_ATONCE / 2;
+        unsigned i_want = __MAX( p_sys->stream.i_read_size / 2,
+                                 __MIN( i_hint, p_sys->stream.i_tk_size ) );
+        if( p_sys->stream.i_used < i_want )
+            p_sys->stream.i_used = i_want;
 
         if( AStreamRefillStream( s ) && i_pos == tk->i_end )
             return VLC_EGENERIC;
@@ -1286,10 +1766,11 @@ static int AStreamReadNoSeekStream( stream_t *s, void *p_read, unsigned int i_re
 
     while( i_data < i_read )
     {
-        unsigned i_off = (tk->i_start + p_sys->stream.i_offset) % STREAM_CACHE_TRACK_SIZE;
+        const unsigned i_tk_size = p_sys->stream.i_tk_size;
+        unsigned i_off = (tk->i_start + p_sys->stream.i_offset) % i_tk_size;
         unsigned int i_current =
             __MIN( tk->i_end - tk->i_start - p_sys->stream.i_offset,
-                   STREAM_CACHE_TRACK_SIZE - i_off );
+                   i_tk_size - i_off );
         int i_copy = __MIN( i_current, i_read - i_data );
 
         if( i_copy <= 0 ) break; /* EOF */
@@ -1313,8 +1794,8 @@ static int AStreamReadNoSeekStream( stream_t *s, void *p_read, unsigned int i_re
         if( tk->i_end + i_data <= tk->i_start + p_sys->stream.i_offset + i_read )
         {
             const unsigned i_read_requested = VLC_CLIP( i_read - i_data,
-                                                    STREAM_READ_ATONCE / 2,
-                                                    STREAM_READ_ATONCE * 10 );
+                                                    p_sys->stream.i_read_size / 2,
+                                                    p_sys->stream.i_read_size * 10 );
 
             if( p_sys->stream.i_used < i_read_requested )
                 p_sys->stream.i_used = i_read_requested;
@@ -1338,7 +1819,7 @@ static int AStreamRefillStream( stream_t *s )
 
     /* We read but won't increase i_start after initial start + offset */
     int i_toread =
-        __MIN( p_sys->stream.i_used, STREAM_CACHE_TRACK_SIZE -
+        __MIN( p_sys->stream.i_used, p_sys->stream.i_tk_size -
                (tk->i_end - tk->i_start - p_sys->stream.i_offset) );
     bool b_read = false;
     int64_t i_start, i_stop;
@@ -1353,13 +1834,14 @@ static int AStreamRefillStream( stream_t *s )
     i_start = mdate();
     while( i_toread > 0 )
     {
-        int i_off = tk->i_end % STREAM_CACHE_TRACK_SIZE;
+        int i_off = tk->i_end % p_sys->stream.i_tk_size;
         int i_read;
 
         if( s->b_die )
             return VLC_EGENERIC;
 
-        i_read = __MIN( i_toread, STREAM_CACHE_TRACK_SIZE - i_off );
+        /* i_toread > 0 here, and i_off < i_tk_size */
+        i_read = __MIN( (unsigned)i_toread, p_sys->stream.i_tk_size - i_off );
         i_read = AReadStream( s, &tk->p_buffer[i_off], i_read );
 
         /* msg_Dbg( s, "AStreamRefillStream: read=%d", i_read ); */
@@ -1378,10 +1860,10 @@ static int AStreamRefillStream( stream_t *s )
         /* Update end */
         tk->i_end += i_read;
 
-        /* Windows of STREAM_CACHE_TRACK_SIZE */
-        if( tk->i_start + STREAM_CACHE_TRACK_SIZE < tk->i_end )
+        /* Windows of i_tk_size */
+        if( tk->i_start + p_sys->stream.i_tk_size < tk->i_end )
         {
-            unsigned i_invalid = tk->i_end - tk->i_start - STREAM_CACHE_TRACK_SIZE;
+            unsigned i_invalid = tk->i_end - tk->i_start - p_sys->stream.i_tk_size;
 
             tk->i_start += i_invalid;
             p_sys->stream.i_offset -= i_invalid;
@@ -1397,6 +1879,16 @@ static int AStreamRefillStream( stream_t *s )
 
     p_sys->stat.i_read_time += i_stop - i_start;
 
+    /* Larger reads while the access is read in sequence */
+    if( p_sys->stream.i_hard_seeks > 0 )
+        p_sys->stream.i_read_size = p_sys->stream.i_read_min;
+    else
+        p_sys->stream.i_read_size =
+            __MIN( 2 * p_sys->stream.i_read_size,
+                   __MAX( p_sys->stream.i_read_min,
+                          __MIN( STREAM_READ_MAX, p_sys->stream.i_tk_size / 8 ) ) );
+    p_sys->stream.i_hard_seeks = 0;
+
     return VLC_SUCCESS;
 }
 
@@ -1436,7 +1928,7 @@ static void AStreamPrebufferStream( stream_t *s )
         }
 
         /* */
-        i_read = STREAM_CACHE_TRACK_SIZE - i_buffered;
+        i_read = p_sys->stream.i_tk_size - i_buffered;
         i_read = __MIN( (int)p_sys->stream.i_read_size, i_read );
         i_read = AReadStream( s, &tk->p_buffer[i_buffered], i_read );
         if( i_read <  0 )
@@ -1457,6 +1949,98 @@ static void AStreamPrebufferStream( stream_t *s )
     }
 }
 
+/****************************************************************************
+ * Method 3:
+ ****************************************************************************/
+static int AStreamRefreshMmap( stream_t *s )
+{
+    stream_sys_t *p_sys = s->p_sys;
+    block_t *p_block;
+
+    if( access_Control( p_sys->p_access, ACCESS_GET_MMAP, &p_block ) )
+        return VLC_EGENERIC;
+    if( p_block->i_buffer <= p_sys->mmap.p_block->i_buffer )
+    {
+        block_Release( p_block );
+        return VLC_EGENERIC;
+    }
+    msg_Dbg( s, "input grew to %zu bytes", p_block->i_buffer );
+    block_Release( p_sys->mmap.p_block );
+    p_sys->mmap.p_block = p_block;
+    return VLC_SUCCESS;
+}
+
+/* How much of i_want is mapped from the current position on */
+static unsigned AStreamLeftMmap( stream_t *s, unsigned i_want )
+{
+    stream_sys_t *p_sys = s->p_sys;
+
+    if( p_sys->i_pos + i_want > p_sys->mmap.p_block->i_buffer )
+        AStreamRefreshMmap( s );
+
+    const uint64_t i_size = p_sys->mmap.p_block->i_buffer;
+    if( p_sys->i_pos >= i_size )
+        return 0;
+    return __MIN( i_want, i_size - p_sys->i_pos );
+}
+
+static int AStreamReadMmap( stream_t *s, void *p_read, unsigned int i_read )
+{
+    stream_sys_t *p_sys = s->p_sys;
+    input_thread_t *p_input = s->p_input;
+
+    i_read = AStreamLeftMmap( s, i_read );
+    if( p_read )
+        memcpy( p_read, &p_sys->mmap.p_block->p_buffer[p_sys->i_pos], i_read );
+    p_sys->i_pos += i_read;
+
+    if( p_input && i_read > 0 )
+    {
+        int i_total = 0;
+
+        vlc_mutex_lock( &p_input->p->counters.counters_lock );
+        stats_UpdateInteger( s, p_input->p->counters.p_read_bytes, i_read,
+                             &i_total );
+        stats_UpdateFloat( s, p_input->p->counters.p_input_bitrate,
+                           (float)i_total, NULL );
+        stats_UpdateInteger( s, p_input->p->counters.p_read_packets, 1, NULL );
+        vlc_mutex_unlock( &p_input->p->counters.counters_lock );
+    }
+    return i_read;
+}
+
+static int AStreamPeekMmap( stream_t *s, const uint8_t **pp_peek, unsigned int i_read )
+{
+    stream_sys_t *p_sys = s->p_sys;
+
+    i_read = AStreamLeftMmap( s, i_read );
+    *pp_peek = &p_sys->mmap.p_block->p_buffer[p_sys->i_pos];
+    return i_read;
+}
+
+static int AStreamSeekMmap( stream_t *s, uint64_t i_pos )
+{
+    stream_sys_t *p_sys = s->p_sys;
+
+    /* Like an access, the position may go past the end */
+    if( i_pos > p_sys->mmap.p_block->i_buffer )
+        AStreamRefreshMmap( s );
+    p_sys->i_pos = i_pos;
+
+#ifdef HAVE_POSIX_MADVISE
+    /* The mapping was set up for sequential reading */
+    const uint64_t i_size = p_sys->mmap.p_block->i_buffer;
+    if( i_pos < i_size )
+    {
+        size_t i_start = i_pos & ~UINT64_C(0xffff); /* page aligned */
+        posix_madvise( &p_sys->mmap.p_block->p_buffer[i_start],
+                       __MIN( STREAM_MMAP_WILLNEED, i_size - i_start ),
+                       POSIX_MADV_WILLNEED );
+    }
+#endif
+    return VLC_SUCCESS;
+}
+
 /****************************************************************************
  * stream_ReadLine:
  ****************************************************************************/
@@ -1678,7 +2262,7 @@ error:
 /****************************************************************************
  * Access reading/seeking wrappers to handle concatenated streams.
  ****************************************************************************/
-static int AReadStream( stream_t *s, void *p_read, unsigned int i_read )
+static int AReadAccess( stream_t *s, void *p_read, unsigned int i_read )
 {
     stream_sys_t *p_sys = s->p_sys;
     access_t *p_access = p_sys->p_access;
@@ -1727,7 +2311,7 @@ static int AReadStream( stream_t *s, void *p_read, unsigned int i_read )
         p_sys->p_list_access = p_list_access;
 
         /* We have to read some data */
-        return AReadStream( s, p_read, i_read_orig );
+        return AReadAccess( s, p_read, i_read_orig );
     }
 
     /* Update read bytes in input */
@@ -1743,6 +2327,13 @@ static int AReadStream( stream_t *s, void *p_read, unsigned int i_read )
     return i_read;
 }
 
+static int AReadStream( stream_t *s, void *p_read, unsigned int i_read )
+{
+    if( s->p_sys->ahead.b_on )
+        return AStreamAheadRead( s, p_read, i_read );
+    return AReadAccess( s, p_read, i_read );
+}
+
 static block_t *AReadBlock( stream_t *s, bool *pb_eof )
 {
     stream_sys_t *p_sys = s->p_sys;
@@ -1814,7 +2405,7 @@ static block_t *AReadBlock( stream_t *s, bool *pb_eof )
     return p_block;
 }
 
-static int ASeek( stream_t *s, uint64_t i_pos )
+static int ASeekAccess( stream_t *s, uint64_t i_pos )
 {
     stream_sys_t *p_sys = s->p_sys;
     access_t *p_access = p_sys->p_access;
@@ -1863,6 +2454,253 @@ static int ASeek( stream_t *s, uint64_t i_pos )
     return p_access->pf_seek( p_access, i_pos );
 }
 
+static int ASeek( stream_t *s, uint64_t i_pos )
+{
+    if( s->p_sys->ahead.b_on )
+        return AStreamAheadSeek( s, i_pos );
+    return ASeekAccess( s, i_pos );
+}
+
+/****************************************************************************
+ * Method 2 read-ahead:
+ *  The thread owns the access unless paused. The ring holds the bytes from
+ *  ahead.i_pos on, what the access would have returned to AReadStream.
+ ****************************************************************************/
+static void *AStreamAheadThread( void *data )
+{
+    stream_t *s = data;
+    stream_sys_t *p_sys = s->p_sys;
+
+    vlc_mutex_lock( &p_sys->ahead.lock );
+    for( ;; )
+    {
+        while( !p_sys->ahead.b_exit &&
+               ( p_sys->ahead.b_pause || p_sys->ahead.b_eof ||
+                 p_sys->ahead.i_fill >= p_sys->ahead.i_target ) )
+            vlc_cond_wait( &p_sys->ahead.wait_thread, &p_sys->ahead.lock );
+        if( p_sys->ahead.b_exit )
+            break;
+
+        /* The reader only touches the filled part of the ring */
+        size_t i_off = ( p_sys->ahead.i_begin + p_sys->ahead.i_fill ) %
+                       STREAM_AHEAD_SIZE;
+        size_t i_read = __MIN( p_sys->ahead.i_target - p_sys->ahead.i_fill,
+                               STREAM_AHEAD_SIZE - i_off );
+        i_read = __MIN( i_read, STREAM_AHEAD_READ );
+        p_sys->ahead.b_busy = true;
+        vlc_mutex_unlock( &p_sys->ahead.lock );
+
+        int i_ret = AReadAccess( s, &p_sys->ahead.p_buffer[i_off], i_read );
+
+        vlc_mutex_lock( &p_sys->ahead.lock );
+        p_sys->ahead.b_busy = false;
+        if( i_ret > 0 )
+            p_sys->ahead.i_fill += i_ret;
+        else if( i_ret == 0 || s->b_die )
+            p_sys->ahead.b_eof = true;
+        vlc_cond_broadcast( &p_sys->ahead.wait );
+    }
+    vlc_mutex_unlock( &p_sys->ahead.lock );
+    return NULL;
+}
+
+static int AStreamAheadStart( stream_t *s )
+{
+    stream_sys_t *p_sys = s->p_sys;
+    stream_track_t *tk = &p_sys->stream.tk[p_sys->stream.i_tk];
+
+    p_sys->ahead.p_buffer = vlc_malloc_tagged( VLC_MEM_STREAM,
+                                               STREAM_AHEAD_SIZE );
+    if( p_sys->ahead.p_buffer == NULL )
+        return VLC_ENOMEM;
+
+    vlc_mutex_init( &p_sys->ahead.lock );
+    vlc_cond_init( &p_sys->ahead.wait );
+    vlc_cond_init( &p_sys->ahead.wait_thread );
+    p_sys->ahead.i_begin = 0;
+    p_sys->ahead.i_fill = 0;
+    p_sys->ahead.i_pos = tk->i_end; /* where the access is */
+    p_sys->ahead.i_target = STREAM_AHEAD_MIN;
+    p_sys->ahead.b_pause = false;
+    p_sys->ahead.b_busy = false;
+    p_sys->ahead.b_eof = false;
+    p_sys->ahead.b_exit = false;
+    p_sys->ahead.i_rate_date = mdate();
+    p_sys->ahead.i_rate_bytes = 0;
+    p_sys->ahead.i_rate = 0;
+
+    if( vlc_clone( &p_sys->ahead.thread, AStreamAheadThread, s,
+                   VLC_THREAD_PRIORITY_INPUT ) )
+    {
+        vlc_cond_destroy( &p_sys->ahead.wait_thread );
+        vlc_cond_destroy( &p_sys->ahead.wait );
+        vlc_mutex_destroy( &p_sys->ahead.lock );
+        vlc_free_tagged( VLC_MEM_STREAM, p_sys->ahead.p_buffer,
+                         STREAM_AHEAD_SIZE );
+        return VLC_EGENERIC;
+    }
+    p_sys->ahead.b_on = true;
+    msg_Dbg( s, "reading ahead up to %d KiB", STREAM_AHEAD_SIZE / 1024 );
+    return VLC_SUCCESS;
+}
+
+static void AStreamAheadStop( stream_t *s )
+{
+    stream_sys_t *p_sys = s->p_sys;
+
+    vlc_mutex_lock( &p_sys->ahead.lock );
+    p_sys->ahead.b_exit = true;
+    vlc_cond_signal( &p_sys->ahead.wait_thread );
+    /* Access modules are not cancellation safe, a blocking read has to be
+     * interrupted the usual way */
+    if( p_sys->ahead.b_busy )
+        vlc_object_kill( p_sys->p_access );
+    vlc_mutex_unlock( &p_sys->ahead.lock );
+
+    vlc_join( p_sys->ahead.thread, NULL );
+    vlc_cond_destroy( &p_sys->ahead.wait_thread );
+    vlc_cond_destroy( &p_sys->ahead.wait );
+    vlc_mutex_destroy( &p_sys->ahead.lock );
+    vlc_free_tagged( VLC_MEM_STREAM, p_sys->ahead.p_buffer, STREAM_AHEAD_SIZE );
+    p_sys->ahead.b_on = false;
+}
+
+/* Take the access back from the thread */
+static void AStreamAheadPause( stream_t *s )
+{
+    stream_sys_t *p_sys = s->p_sys;
+
+    vlc_mutex_lock( &p_sys->ahead.lock );
+    p_sys->ahead.b_pause = true;
+    while( p_sys->ahead.b_busy )
+        vlc_cond_wait( &p_sys->ahead.wait, &p_sys->ahead.lock );
+    vlc_mutex_unlock( &p_sys->ahead.lock );
+}
+
+/* Hand the access back, after dropping what was read ahead if it moved */
+static void AStreamAheadResume( stream_t *s, bool b_flush )
+{
+    stream_sys_t *p_sys = s->p_sys;
+
+    vlc_mutex_lock( &p_sys->ahead.lock );
+    if( b_flush )
+    {
+        p_sys->ahead.i_begin = 0;
+        p_sys->ahead.i_fill = 0;
+        p_sys->ahead.i_pos = p_sys->p_access->info.i_pos;
+        p_sys->ahead.b_eof = false;
+    }
+    p_sys->ahead.b_pause = false;
+    vlc_cond_signal( &p_sys->ahead.wait_thread );
+    vlc_mutex_unlock( &p_sys->ahead.lock );
+}
+
+/* Reader side: follow the consumption rate, with the lock held */
+static void AStreamAheadRate( stream_t *s, size_t i_read, bool b_underrun )
+{
+    stream_sys_t *p_sys = s->p_sys;
+    int64_t i_now = mdate();
+    size_t i_target = p_sys->ahead.i_target;
+
+    p_sys->ahead.i_rate_bytes += i_read;
+    if( i_now - p_sys->ahead.i_rate_date >= STREAM_AHEAD_PERIOD )
+    {
+        uint64_t i_rate = p_sys->ahead.i_rate_bytes * CLOCK_FREQ /
+                          ( i_now - p_sys->ahead.i_rate_date );
+
+        p_sys->ahead.i_rate = ( 3 * p_sys->ahead.i_rate + i_rate ) / 4;
+        p_sys->ahead.i_rate_date = i_now;
+        p_sys->ahead.i_rate_bytes = 0;
+
+        uint64_t i_want = p_sys->ahead.i_rate * STREAM_AHEAD_DURATION /
+                          CLOCK_FREQ;
+        /* shrink slowly, an underrun may have lowered the rate seen */
+        if( i_want < i_target )
+            i_want = ( i_want + 3 * (uint64_t)i_target ) / 4;
+        i_target = i_want;
+    }
+    if( b_underrun )
+        i_target *= 2;
+
+    p_sys->ahead.i_target = VLC_CLIP( i_target, STREAM_AHEAD_MIN,
+                                      STREAM_AHEAD_SIZE );
+}
+
+static int AStreamAheadRead( stream_t *s, void *p_read, unsigned int i_read )
+{
+    stream_sys_t *p_sys = s->p_sys;
+    bool b_underrun = false;
+
+    vlc_mutex_lock( &p_sys->ahead.lock );
+    while( p_sys->ahead.i_fill == 0 && !p_sys->ahead.b_eof )
+    {
+        b_underrun = true;
+        vlc_cond_wait( &p_sys->ahead.wait, &p_sys->ahead.lock );
+    }
+    size_t i_begin = p_sys->ahead.i_begin;
+    size_t i_copy = __MIN( (size_t)i_read, p_sys->ahead.i_fill );
+    vlc_mutex_unlock( &p_sys->ahead.lock );
+
+    if( i_copy == 0 )
+        return 0; /* EOF */
+
+    /* The thread does not write the filled part */
+    size_t i_first = __MIN( i_copy, STREAM_AHEAD_SIZE - i_begin );
+    memcpy( p_read, &p_sys->ahead.p_buffer[i_begin], i_first );
+    memcpy( (uint8_t *)p_read + i_first, p_sys->ahead.p_buffer,
+            i_copy - i_first );
+
+    vlc_mutex_lock( &p_sys->ahead.lock );
+    p_sys->ahead.i_begin = ( i_begin + i_copy ) % STREAM_AHEAD_SIZE;
+    p_sys->ahead.i_fill -= i_copy;
+    p_sys->ahead.i_pos += i_copy;
+    AStreamAheadRate( s, i_copy, b_underrun );
+    if( p_sys->ahead.i_fill < p_sys->ahead.i_target )
+        vlc_cond_signal( &p_sys->ahead.wait_thread );
+    vlc_mutex_unlock( &p_sys->ahead.lock );
+
+    return i_copy;
+}
+
+static int AStreamAheadSeek( stream_t *s, uint64_t i_pos )
+{
+    stream_sys_t *p_sys = s->p_sys;
+
+    vlc_mutex_lock( &p_sys->ahead.lock );
+    if( i_pos >= p_sys->ahead.i_pos &&
+        i_pos - p_sys->ahead.i_pos <= p_sys->ahead.i_fill )
+    {
+        /* Forward within what was read ahead */
+        size_t i_skip = i_pos - p_sys->ahead.i_pos;
+
+        p_sys->ahead.i_begin = ( p_sys->ahead.i_begin + i_skip ) %
+                               STREAM_AHEAD_SIZE;
+        p_sys->ahead.i_fill -= i_skip;
+        p_sys->ahead.i_pos = i_pos;
+        vlc_cond_signal( &p_sys->ahead.wait_thread );
+        vlc_mutex_unlock( &p_sys->ahead.lock );
+        return VLC_SUCCESS;
+    }
+    vlc_mutex_unlock( &p_sys->ahead.lock );
+
+    AStreamAheadPause( s );
+    int i_ret = ASeekAccess( s, i_pos );
+
+    /* If the seek failed, the access is still where the ring ends */
+    vlc_mutex_lock( &p_sys->ahead.lock );
+    if( i_ret == VLC_SUCCESS )
+    {
+        p_sys->ahead.i_begin = 0;
+        p_sys->ahead.i_fill = 0;
+        p_sys->ahead.i_pos = i_pos;
+        p_sys->ahead.b_eof = false;
+    }
+    p_sys->ahead.b_pause = false;
+    vlc_cond_signal( &p_sys->ahead.wait_thread );
+    vlc_mutex_unlock( &p_sys->ahead.lock );
+    return i_ret;
+}
+
 
 /**
  * Try to read "i_read" bytes into a buffer pointed by "p_read".  If
@@ -0,0 +1,476 @@
+/*****************************************************************************
+ * thumbnailer.c: extraction of video frames without playback
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_executor.h>
+#include <vlc_thumbnailer.h>
+#include <vlc_input_item.h>
+#include <vlc_codec.h>
+#include <vlc_es_out.h>
+#include <vlc_modules.h>
+
+#include "demux.h"
+#include "stream.h"
+#include "input_internal.h"
+
+struct vlc_thumbnailer_t
+{
+    VLC_COMMON_MEMBERS
+
+    vlc_executor_t            *p_executor;
+    vlc_mutex_t                lock;
+    vlc_thumbnailer_request_t *p_first; /* pending requests */
+};
+
+struct vlc_thumbnailer_request_t
+{
+    vlc_task_t                 task;
+    vlc_thumbnailer_t         *p_owner;
+    vlc_thumbnailer_request_t *p_next;
+    input_item_t              *p_item;
+    mtime_t                    i_time;
+    mtime_t                    i_deadline;
+    vlc_thumbnailer_cb         pf_cb;
+    void                      *p_data;
+    bool                       b_canceled; /* Cancel() frees the request */
+};
+
+/*****************************************************************************
+ * Decoding
+ *****************************************************************************/
+struct es_out_id_t
+{
+    int i_cat;
+};
+
+struct es_out_sys_t
+{
+    vlc_object_t *p_obj;
+    es_out_id_t  *p_video;      /* the ES being decoded */
+    decoder_t    *p_packetizer; /* if the demuxer does not packetize */
+    decoder_t    *p_decoder;
+    picture_t    *p_pic;        /* the result */
+};
+
+static picture_t *VideoNewBuffer( decoder_t *p_dec )
+{
+    p_dec->fmt_out.video.i_chroma = p_dec->fmt_out.i_codec;
+    return picture_NewFromFormat( &p_dec->fmt_out.video );
+}
+
+static void VideoDelBuffer( decoder_t *p_dec, picture_t *p_pic )
+{
+    VLC_UNUSED(p_dec);
+    picture_Release( p_pic );
+}
+
+static void VideoLinkPicture( decoder_t *p_dec, picture_t *p_pic )
+{
+    VLC_UNUSED(p_dec);
+    picture_Hold( p_pic );
+}
+
+static void VideoUnlinkPicture( decoder_t *p_dec, picture_t *p_pic )
+{
+    VLC_UNUSED(p_dec);
+    picture_Release( p_pic );
+}
+
+static void DeleteDecoder( decoder_t *p_dec )
+{
+    if( p_dec->p_module != NULL )
+        module_unneed( p_dec, p_dec->p_module );
+    es_format_Clean( &p_dec->fmt_in );
+    es_format_Clean( &p_dec->fmt_out );
+    if( p_dec->p_description != NULL )
+        vlc_meta_Delete( p_dec->p_description );
+    vlc_object_release( p_dec );
+}
+
+static decoder_t *CreateDecoder( vlc_object_t *p_obj, const es_format_t *p_fmt,
+                                 bool b_packetizer )
+{
+    decoder_t *p_dec = vlc_custom_create( p_obj, sizeof( *p_dec ),
+                                          b_packetizer ? "packetizer"
+                                                       : "decoder" );
+    if( unlikely(p_dec == NULL) )
+        return NULL;
+
+    es_format_Copy( &p_dec->fmt_in, p_fmt );
+    es_format_Init( &p_dec->fmt_out, UNKNOWN_ES, 0 );
+    p_dec->b_pace_control = true;
+    p_dec->pf_vout_buffer_new = VideoNewBuffer;
+    p_dec->pf_vout_buffer_del = VideoDelBuffer;
+    p_dec->pf_picture_link = VideoLinkPicture;
+    p_dec->pf_picture_unlink = VideoUnlinkPicture;
+
+    if( b_packetizer )
+        p_dec->p_module = module_need( p_dec, "packetizer", "$packetizer",
+                                       false );
+    else
+        p_dec->p_module = module_need( p_dec, "decoder", "$codec", false );
+    if( p_dec->p_module == NULL )
+    {
+        DeleteDecoder( p_dec );
+        return NULL;
+    }
+    return p_dec;
+}
+
+static void CloseDecoders( es_out_sys_t *p_sys )
+{
+    if( p_sys->p_decoder != NULL )
+        DeleteDecoder( p_sys->p_decoder );
+    if( p_sys->p_packetizer != NULL )
+        DeleteDecoder( p_sys->p_packetizer );
+    p_sys->p_decoder = p_sys->p_packetizer = NULL;
+    p_sys->p_video = NULL;
+}
+
+static void Decode( es_out_sys_t *p_sys, block_t *p_block )
+{
+    picture_t *p_pic;
+
+    while( (p_pic = p_sys->p_decoder->pf_decode_video( p_sys->p_decoder,
+                                                       &p_block )) != NULL )
+    {
+        if( p_sys->p_pic == NULL )
+            p_sys->p_pic = p_pic;
+        else
+            picture_Release( p_pic );
+    }
+}
+
+static es_out_id_t *EsOutAdd( es_out_t *out, const es_format_t *p_fmt )
+{
+    es_out_sys_t *p_sys = out->p_sys;
+    es_out_id_t *id = malloc( sizeof( *id ) );
+    if( unlikely(id == NULL) )
+        return NULL;
+
+    id->i_cat = p_fmt->i_cat;
+    if( p_fmt->i_cat != VIDEO_ES || p_sys->p_video != NULL )
+        return id;
+
+    /* Decode the first video ES that can be */
+    const es_format_t *p_dec_fmt = p_fmt;
+    if( !p_fmt->b_packetized )
+    {
+        p_sys->p_packetizer = CreateDecoder( p_sys->p_obj, p_fmt, true );
+        if( p_sys->p_packetizer == NULL )
+            return id;
+        p_dec_fmt = &p_sys->p_packetizer->fmt_out;
+    }
+    p_sys->p_decoder = CreateDecoder( p_sys->p_obj, p_dec_fmt, false );
+    if( p_sys->p_decoder == NULL )
+    {
+        msg_Dbg( p_sys->p_obj, "cannot decode ES %d (%4.4s)", p_fmt->i_id,
+                 (const char *)&p_fmt->i_codec );
+        CloseDecoders( p_sys );
+        return id;
+    }
+    p_sys->p_video = id;
+    return id;
+}
+
+static int EsOutSend( es_out_t *out, es_out_id_t *id, block_t *p_block )
+{
+    es_out_sys_t *p_sys = out->p_sys;
+
+    if( id != p_sys->p_video || p_sys->p_pic != NULL )
+    {
+        block_Release( p_block );
+        return VLC_SUCCESS;
+    }
+
+    if( p_sys->p_packetizer != NULL )
+    {
+        decoder_t *p_pack = p_sys->p_packetizer;
+        block_t *p_chain;
+
+        while( (p_chain = p_pack->pf_packetize( p_pack, &p_block )) != NULL )
+            while( p_chain != NULL )
+            {
+                block_t *p_next = p_chain->p_next;
+
+                p_chain->p_next = NULL;
+                if( p_sys->p_pic == NULL )
+                    Decode( p_sys, p_chain );
+                else
+                    block_Release( p_chain );
+                p_chain = p_next;
+            }
+    }
+    else
+        Decode( p_sys, p_block );
+    return VLC_SUCCESS;
+}
+
+static void EsOutDel( es_out_t *out, es_out_id_t *id )
+{
+    es_out_sys_t *p_sys = out->p_sys;
+
+    if( id == p_sys->p_video )
+        CloseDecoders( p_sys );
+    free( id );
+}
+
+static int EsOutControl( es_out_t *out, int i_query, va_list args )
+{
+    es_out_sys_t *p_sys = out->p_sys;
+
+    switch( i_query )
+    {
+        case ES_OUT_GET_ES_STATE:
+        {
+            es_out_id_t *id = va_arg( args, es_out_id_t * );
+            *va_arg( args, bool * ) = id == p_sys->p_video;
+            return VLC_SUCCESS;
+        }
+        case ES_OUT_GET_EMPTY:
+            *va_arg( args, bool * ) = true;
+            return VLC_SUCCESS;
+        case ES_OUT_SET_PCR:
+        case ES_OUT_SET_GROUP_PCR:
+        case ES_OUT_RESET_PCR:
+        case ES_OUT_SET_ES:
+        case ES_OUT_SET_ES_DEFAULT:
+        case ES_OUT_SET_ES_STATE:
+        case ES_OUT_SET_ES_FMT:
+        case ES_OUT_SET_NEXT_DISPLAY_TIME:
+        case ES_OUT_SET_GROUP:
+        case ES_OUT_SET_GROUP_META:
+        case ES_OUT_SET_GROUP_EPG:
+        case ES_OUT_DEL_GROUP:
+        case ES_OUT_SET_META:
+            return VLC_SUCCESS;
+        default:
+            return VLC_EGENERIC;
+    }
+}
+
+static picture_t *Extract( vlc_thumbnailer_request_t *p_req )
+{
+    vlc_thumbnailer_t *p_th = p_req->p_owner;
+    char *psz_uri = input_item_GetURI( p_req->p_item );
+    picture_t *p_pic = NULL;
+
+    if( psz_uri == NULL )
+        return NULL;
+
+    stream_t *s = stream_UrlNew( p_th, psz_uri );
+    if( s == NULL )
+        goto out;
+
+    const char *psz_access, *psz_demux, *psz_path, *psz_anchor;
+    input_SplitMRL( &psz_access, &psz_demux, &psz_path, &psz_anchor,
+                    psz_uri );
+
+    es_out_sys_t sys = { .p_obj = VLC_OBJECT(p_th) };
+    es_out_t out = {
+        .pf_add = EsOutAdd, .pf_send = EsOutSend, .pf_del = EsOutDel,
+        .pf_control = EsOutControl, .p_sys = &sys,
+    };
+    demux_t *p_demux = demux_New( p_th, NULL, s->psz_access, psz_demux,
+                                  psz_path, s, &out, false );
+    if( p_demux == NULL )
+    {
+        stream_Delete( s );
+        goto out;
+    }
+
+    /* Seek to the nearest keyframe, not precisely */
+    if( p_req->i_time > 0
+     && demux_Control( p_demux, DEMUX_SET_TIME, p_req->i_time, false ) )
+    {
+        int64_t i_length;
+        if( !demux_Control( p_demux, DEMUX_GET_LENGTH, &i_length )
+         && i_length > p_req->i_time )
+            demux_Control( p_demux, DEMUX_SET_POSITION,
+                           (double)p_req->i_time / i_length, false );
+    }
+
+    while( sys.p_pic == NULL && mdate() < p_req->i_deadline
+        && !vlc_executor_IsCanceled( p_th->p_executor, &p_req->task ) )
+        if( demux_Demux( p_demux ) <= 0 )
+            break;
+
+    p_pic = sys.p_pic;
+    demux_Delete( p_demux );
+    CloseDecoders( &sys );
+    stream_Delete( s );
+out:
+    if( p_pic == NULL )
+        msg_Dbg( p_th, "no frame extracted from %s", psz_uri );
+    free( psz_uri );
+    return p_pic;
+}
+
+/*****************************************************************************
+ * Requests
+ *****************************************************************************/
+static void RequestDelete( vlc_thumbnailer_request_t *p_req )
+{
+    vlc_gc_decref( p_req->p_item );
+    free( p_req );
+}
+
+/* Must be called with the lock held */
+static void RequestUnlink( vlc_thumbnailer_request_t *p_req )
+{
+    vlc_thumbnailer_t *p_th = p_req->p_owner;
+
+    for( vlc_thumbnailer_request_t **pp = &p_th->p_first; *pp != NULL;
+         pp = &(*pp)->p_next )
+        if( *pp == p_req )
+        {
+            *pp = p_req->p_next;
+            break;
+        }
+}
+
+static void RequestRun( void *data )
+{
+    vlc_thumbnailer_request_t *p_req = data;
+    vlc_thumbnailer_t *p_th = p_req->p_owner;
+    picture_t *p_pic = Extract( p_req );
+
+    vlc_mutex_lock( &p_th->lock );
+    bool b_canceled = p_req->b_canceled;
+    vlc_mutex_unlock( &p_th->lock );
+
+    if( !b_canceled )
+        p_req->pf_cb( p_req->p_data, p_pic );
+    else if( p_pic != NULL )
+        picture_Release( p_pic );
+
+    vlc_mutex_lock( &p_th->lock );
+    RequestUnlink( p_req );
+    b_canceled = p_req->b_canceled;
+    vlc_mutex_unlock( &p_th->lock );
+
+    if( !b_canceled )
+        RequestDelete( p_req );
+}
+
+#undef vlc_thumbnailer_Create
+vlc_thumbnailer_t *vlc_thumbnailer_Create( vlc_object_t *p_parent )
+{
+    vlc_thumbnailer_t *p_th = vlc_custom_create( p_parent, sizeof( *p_th ),
+                                                 "thumbnailer" );
+    if( unlikely(p_th == NULL) )
+        return NULL;
+
+    /* Requests run concurrently: one decoding thread each. Only the
+     * keyframe is decoded, and it need not be filtered. */
+    var_Create( p_th, "ffmpeg-threads", VLC_VAR_INTEGER );
+    var_SetInteger( p_th, "ffmpeg-threads", 1 );
+    var_Create( p_th, "ffmpeg-skip-frame", VLC_VAR_INTEGER );
+    var_SetInteger( p_th, "ffmpeg-skip-frame", 2 /* non-key frames */ );
+    var_Create( p_th, "ffmpeg-skiploopfilter", VLC_VAR_INTEGER );
+    var_SetInteger( p_th, "ffmpeg-skiploopfilter", 4 /* all */ );
+    var_Create( p_th, "ffmpeg-hw", VLC_VAR_BOOL );
+    var_SetBool( p_th, "ffmpeg-hw", true );
+
+    p_th->p_executor = vlc_executor_Get( p_th );
+    vlc_mutex_init( &p_th->lock );
+    p_th->p_first = NULL;
+    return p_th;
+}
+
+void vlc_thumbnailer_Release( vlc_thumbnailer_t *p_th )
+{
+    vlc_mutex_lock( &p_th->lock );
+    while( p_th->p_first != NULL )
+    {
+        vlc_thumbnailer_request_t *p_req = p_th->p_first;
+
+        /* Marked under the lock, so that the task leaves it to us */
+        p_req->b_canceled = true;
+        vlc_mutex_unlock( &p_th->lock );
+        vlc_executor_Cancel( p_th->p_executor, &p_req->task );
+        vlc_mutex_lock( &p_th->lock );
+        RequestUnlink( p_req );
+        vlc_mutex_unlock( &p_th->lock );
+        RequestDelete( p_req );
+        vlc_mutex_lock( &p_th->lock );
+    }
+    vlc_mutex_unlock( &p_th->lock );
+
+    vlc_mutex_destroy( &p_th->lock );
+    vlc_object_release( p_th );
+}
+
+vlc_thumbnailer_request_t *
+vlc_thumbnailer_Request( vlc_thumbnailer_t *p_th, input_item_t *p_item,
+                         mtime_t i_time, mtime_t i_timeout,
+                         vlc_thumbnailer_cb pf_cb, void *p_data )
+{
+    vlc_thumbnailer_request_t *p_req = malloc( sizeof( *p_req ) );
+    if( unlikely(p_req == NULL) )
+        return NULL;
+
+    vlc_task_Init( &p_req->task, RequestRun, p_req );
+    p_req->p_owner = p_th;
+    p_req->p_item = p_item;
+    vlc_gc_incref( p_item );
+    p_req->i_time = i_time;
+    p_req->i_deadline = mdate() + i_timeout;
+    p_req->pf_cb = pf_cb;
+    p_req->p_data = p_data;
+    p_req->b_canceled = false;
+
+    vlc_mutex_lock( &p_th->lock );
+    p_req->p_next = p_th->p_first;
+    p_th->p_first = p_req;
+    vlc_mutex_unlock( &p_th->lock );
+
+    if( vlc_executor_Submit( p_th->p_executor, &p_req->task ) )
+    {
+        vlc_mutex_lock( &p_th->lock );
+        RequestUnlink( p_req );
+        vlc_mutex_unlock( &p_th->lock );
+        RequestDelete( p_req );
+        return NULL;
+    }
+    return p_req;
+}
+
+void vlc_thumbnailer_Cancel( vlc_thumbnailer_t *p_th,
+                             vlc_thumbnailer_request_t *p_req )
+{
+    vlc_mutex_lock( &p_th->lock );
+    p_req->b_canceled = true;
+    vlc_mutex_unlock( &p_th->lock );
+
+    /* Either the task is dequeued, or it is waited for */
+    vlc_executor_Cancel( p_th->p_executor, &p_req->task );
+
+    vlc_mutex_lock( &p_th->lock );
+    RequestUnlink( p_req );
+    vlc_mutex_unlock( &p_th->lock );
+    RequestDelete( p_req );
+}
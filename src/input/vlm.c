@@ -113,8 +113,16 @@ static int InputEvent( vlc_object_t *p_this, char const *psz_cmd,
         }
         vlm_SendEventMediaInstanceState( p_vlm, p_media->cfg.id, p_media->cfg.psz_name, psz_instance_name, var_GetInteger( p_input, "state" ) );
 
+        /* Only this media needs to be checked by the vlm thread */
+        int64_t id = p_media->cfg.id;
+        int i;
+
         vlc_mutex_lock( &p_vlm->lock_manage );
-        p_vlm->input_state_changed = true;
+        for( i = 0; i < p_vlm->i_changed; i++ )
+            if( p_vlm->changed[i] == id )
+                break;
+        if( i == p_vlm->i_changed )
+            TAB_APPEND( p_vlm->i_changed, p_vlm->changed, id );
         vlc_cond_signal( &p_vlm->wait_manage );
         vlc_mutex_unlock( &p_vlm->lock_manage );
     }
@@ -161,9 +169,11 @@ vlm_t *vlm_New ( vlc_object_t *p_this )
     vlc_cond_init_daytime( &p_vlm->wait_manage );
     p_vlm->users = 1;
     p_vlm->input_state_changed = false;
+    TAB_INIT( p_vlm->i_changed, p_vlm->changed );
     p_vlm->i_id = 1;
     TAB_INIT( p_vlm->i_media, p_vlm->media );
     TAB_INIT( p_vlm->i_schedule, p_vlm->schedule );
+    TAB_INIT( p_vlm->i_queue, p_vlm->queue );
     p_vlm->p_vod = NULL;
     var_Create( p_vlm, "intf-event", VLC_VAR_ADDRESS );
 
@@ -231,6 +241,7 @@ void vlm_Delete( vlm_t *p_vlm )
 
     vlm_ControlInternal( p_vlm, VLM_CLEAR_SCHEDULES );
     TAB_CLEAN( p_vlm->i_schedule, p_vlm->schedule );
+    free( p_vlm->queue );
     vlc_mutex_unlock( &p_vlm->lock );
 
     vlc_object_kill( p_vlm );
@@ -252,6 +263,7 @@ void vlm_Delete( vlm_t *p_vlm )
     /*vlc_cancel( p_vlm->thread ); */
     vlc_join( p_vlm->thread, NULL );
 
+    TAB_CLEAN( p_vlm->i_changed, p_vlm->changed );
     vlc_cond_destroy( &p_vlm->wait_manage );
     vlc_mutex_destroy( &p_vlm->lock );
     vlc_mutex_destroy( &p_vlm->lock_manage );
@@ -273,6 +285,36 @@ int vlm_ExecuteCommand( vlm_t *p_vlm, const char *psz_command,
     return i_result;
 }
 
+/*****************************************************************************
+ * vlm_ExecuteCommands:
+ *****************************************************************************
+ * Executes several commands, taking the VLM lock once. The message has one
+ * child per command, and the result is the first error, if any.
+ *****************************************************************************/
+int vlm_ExecuteCommands( vlm_t *p_vlm, int i_command,
+                         const char *const *ppsz_command,
+                         vlm_message_t **pp_message )
+{
+    vlm_message_t *p_message = vlm_MessageSimpleNew( "batch" );
+    int i_result = VLC_SUCCESS;
+
+    vlc_mutex_lock( &p_vlm->lock );
+    for( int i = 0; i < i_command; i++ )
+    {
+        vlm_message_t *p_status = NULL;
+        int i_ret = ExecuteCommand( p_vlm, ppsz_command[i], &p_status );
+
+        if( i_ret != VLC_SUCCESS && i_result == VLC_SUCCESS )
+            i_result = i_ret;
+        if( p_status != NULL && vlm_MessageAdd( p_message, p_status ) == NULL )
+            vlm_MessageDelete( p_status );
+    }
+    vlc_mutex_unlock( &p_vlm->lock );
+
+    *pp_message = p_message;
+    return i_result;
+}
+
 
 int64_t vlm_Date(void)
 {
@@ -407,28 +449,198 @@ static int vlm_MediaVodControl( void *p_private, vod_media_t *p_vod_media,
 }
 
 
+/*****************************************************************************
+ * Schedule queue:
+ *****************************************************************************
+ * The enabled schedules are kept in a binary heap ordered by their next
+ * execution date, so that the vlm thread sleeps until the first one is due
+ * instead of walking every schedule on each wake up.
+ *****************************************************************************/
+static void ScheduleQueueSet( vlm_t *vlm, int i, vlm_schedule_sys_t *sched )
+{
+    vlm->queue[i] = sched;
+    sched->i_queue = i;
+}
+
+static void ScheduleQueueUp( vlm_t *vlm, int i )
+{
+    vlm_schedule_sys_t *sched = vlm->queue[i];
+
+    while( i > 0 )
+    {
+        int i_parent = (i - 1) / 2;
+        if( vlm->queue[i_parent]->i_next <= sched->i_next )
+            break;
+        ScheduleQueueSet( vlm, i, vlm->queue[i_parent] );
+        i = i_parent;
+    }
+    ScheduleQueueSet( vlm, i, sched );
+}
+
+static void ScheduleQueueDown( vlm_t *vlm, int i )
+{
+    vlm_schedule_sys_t *sched = vlm->queue[i];
+
+    for( ;; )
+    {
+        int i_child = 2 * i + 1;
+        if( i_child >= vlm->i_queue )
+            break;
+        if( i_child + 1 < vlm->i_queue &&
+            vlm->queue[i_child + 1]->i_next < vlm->queue[i_child]->i_next )
+            i_child++;
+        if( sched->i_next <= vlm->queue[i_child]->i_next )
+            break;
+        ScheduleQueueSet( vlm, i, vlm->queue[i_child] );
+        i = i_child;
+    }
+    ScheduleQueueSet( vlm, i, sched );
+}
+
+void vlm_ScheduleUnqueue( vlm_t *vlm, vlm_schedule_sys_t *sched )
+{
+    int i = sched->i_queue;
+
+    if( i < 0 )
+        return;
+    sched->i_queue = -1;
+
+    vlm_schedule_sys_t *p_last = vlm->queue[--vlm->i_queue];
+    if( p_last == sched )
+        return;
+    ScheduleQueueSet( vlm, i, p_last );
+    ScheduleQueueUp( vlm, i );
+    ScheduleQueueDown( vlm, p_last->i_queue );
+}
+
+static void ScheduleQueue( vlm_t *vlm, vlm_schedule_sys_t *sched )
+{
+    if( sched->i_queue >= 0 )
+    {
+        ScheduleQueueUp( vlm, sched->i_queue );
+        ScheduleQueueDown( vlm, sched->i_queue );
+        return;
+    }
+
+    vlm_schedule_sys_t **pp_queue =
+        realloc( vlm->queue, (vlm->i_queue + 1) * sizeof(*pp_queue) );
+    if( unlikely(pp_queue == NULL) )
+    {
+        msg_Err( vlm, "cannot queue schedule %s", sched->psz_name );
+        return;
+    }
+    vlm->queue = pp_queue;
+    ScheduleQueueSet( vlm, vlm->i_queue++, sched );
+    ScheduleQueueUp( vlm, sched->i_queue );
+}
+
+/* Returns the first execution date after i_after, or 0 if there is none */
+static mtime_t ScheduleNextDate( const vlm_schedule_sys_t *sched,
+                                 mtime_t i_after )
+{
+    if( sched->i_date > i_after )
+        return sched->i_date;
+    if( sched->i_period <= 0 )
+        return 0;
+
+    int64_t j = (i_after - sched->i_date) / sched->i_period + 1;
+    if( sched->i_repeat >= 0 && j > sched->i_repeat )
+        return 0;
+    return sched->i_date + j * sched->i_period;
+}
+
+/**
+ * Computes the next execution of a schedule after its setup has changed,
+ * and wakes the vlm thread up. Must be called with the vlm lock held.
+ */
+void vlm_ScheduleUpdate( vlm_t *vlm, vlm_schedule_sys_t *sched )
+{
+    mtime_t i_time = vlm_Date();
+
+    if( sched->b_enabled && sched->i_date == 0 ) // now !
+    {
+        sched->i_date = (i_time / 1000000) * 1000000;
+        sched->i_next = i_time;
+    }
+    else if( sched->b_enabled )
+        sched->i_next = ScheduleNextDate( sched, i_time );
+    else
+        sched->i_next = 0;
+
+    if( sched->i_next != 0 )
+        ScheduleQueue( vlm, sched );
+    else
+        vlm_ScheduleUnqueue( vlm, sched );
+
+    vlc_mutex_lock( &vlm->lock_manage );
+    vlm->input_state_changed = true;
+    vlc_cond_signal( &vlm->wait_manage );
+    vlc_mutex_unlock( &vlm->lock_manage );
+}
+
 /*****************************************************************************
  * Manage:
  *****************************************************************************/
+static void ManageMedia( vlm_t *vlm, int64_t id )
+{
+    vlm_media_sys_t *p_media = NULL;
+
+    for( int i = 0; i < vlm->i_media; i++ )
+        if( vlm->media[i]->cfg.id == id )
+        {
+            p_media = vlm->media[i];
+            break;
+        }
+    if( p_media == NULL ) /* deleted meanwhile */
+        return;
+
+    /* destroy the inputs that wants to die, and launch the next input */
+    for( int j = 0; j < p_media->i_instance; )
+    {
+        vlm_media_instance_sys_t *p_instance = p_media->instance[j];
+
+        if( p_instance->p_input && ( p_instance->p_input->b_eof || p_instance->p_input->b_error ) )
+        {
+            int i_new_input_index;
+
+            /* */
+            i_new_input_index = p_instance->i_index + 1;
+            if( !p_media->cfg.b_vod && p_media->cfg.broadcast.b_loop && i_new_input_index >= p_media->cfg.i_input )
+                i_new_input_index = 0;
+
+            /* FIXME implement multiple input with VOD */
+            if( p_media->cfg.b_vod || i_new_input_index >= p_media->cfg.i_input )
+                vlm_ControlInternal( vlm, VLM_STOP_MEDIA_INSTANCE, p_media->cfg.id, p_instance->psz_name );
+            else
+                vlm_ControlInternal( vlm, VLM_START_MEDIA_BROADCAST_INSTANCE, p_media->cfg.id, p_instance->psz_name, i_new_input_index );
+
+            j = 0;
+        }
+        else
+        {
+            j++;
+        }
+    }
+}
+
 static void* Manage( void* p_object )
 {
     vlm_t *vlm = (vlm_t*)p_object;
-    int i, j;
-    mtime_t i_lastcheck;
-    mtime_t i_time;
     mtime_t i_nextschedule = 0;
 
     int canc = vlc_savecancel ();
-    i_lastcheck = vlm_Date();
 
     while( !vlm->b_die )
     {
         char **ppsz_scheduled_commands = NULL;
         int    i_scheduled_commands = 0;
+        int64_t *p_changed;
+        int      i_changed;
         bool scheduled_command = false;
 
         vlc_mutex_lock( &vlm->lock_manage );
-        while( !vlm->input_state_changed && !scheduled_command )
+        while( !vlm->input_state_changed && vlm->i_changed == 0 &&
+               !scheduled_command )
         {
             if( i_nextschedule )
                 scheduled_command = vlc_cond_timedwait( &vlm->wait_manage, &vlm->lock_manage, i_nextschedule ) != 0;
@@ -436,107 +648,53 @@ static void* Manage( void* p_object )
                 vlc_cond_wait( &vlm->wait_manage, &vlm->lock_manage );
         }
         vlm->input_state_changed = false;
+        i_changed = vlm->i_changed;
+        p_changed = vlm->changed;
+        TAB_INIT( vlm->i_changed, vlm->changed );
         vlc_mutex_unlock( &vlm->lock_manage );
-        /* destroy the inputs that wants to die, and launch the next input */
-        vlc_mutex_lock( &vlm->lock );
-        for( i = 0; i < vlm->i_media; i++ )
-        {
-            vlm_media_sys_t *p_media = vlm->media[i];
-
-            for( j = 0; j < p_media->i_instance; )
-            {
-                vlm_media_instance_sys_t *p_instance = p_media->instance[j];
 
-                if( p_instance->p_input && ( p_instance->p_input->b_eof || p_instance->p_input->b_error ) )
-                {
-                    int i_new_input_index;
-
-                    /* */
-                    i_new_input_index = p_instance->i_index + 1;
-                    if( !p_media->cfg.b_vod && p_media->cfg.broadcast.b_loop && i_new_input_index >= p_media->cfg.i_input )
-                        i_new_input_index = 0;
-
-                    /* FIXME implement multiple input with VOD */
-                    if( p_media->cfg.b_vod || i_new_input_index >= p_media->cfg.i_input )
-                        vlm_ControlInternal( vlm, VLM_STOP_MEDIA_INSTANCE, p_media->cfg.id, p_instance->psz_name );
-                    else
-                        vlm_ControlInternal( vlm, VLM_START_MEDIA_BROADCAST_INSTANCE, p_media->cfg.id, p_instance->psz_name, i_new_input_index );
-
-                    j = 0;
-                }
-                else
-                {
-                    j++;
-                }
-            }
-        }
+        vlc_mutex_lock( &vlm->lock );
+        for( int i = 0; i < i_changed; i++ )
+            ManageMedia( vlm, p_changed[i] );
+        free( p_changed );
 
         /* scheduling */
-        i_time = vlm_Date();
-        i_nextschedule = 0;
+        mtime_t i_time = vlm_Date();
 
-        for( i = 0; i < vlm->i_schedule; i++ )
+        while( vlm->i_queue > 0 && vlm->queue[0]->i_next <= i_time )
         {
-            mtime_t i_real_date = vlm->schedule[i]->i_date;
+            vlm_schedule_sys_t *p_sched = vlm->queue[0];
 
-            if( vlm->schedule[i]->b_enabled )
-            {
-                if( vlm->schedule[i]->i_date == 0 ) // now !
-                {
-                    vlm->schedule[i]->i_date = (i_time / 1000000) * 1000000 ;
-                    i_real_date = i_time;
-                }
-                else if( vlm->schedule[i]->i_period != 0 )
-                {
-                    int j = 0;
-                    while( vlm->schedule[i]->i_date + j *
-                           vlm->schedule[i]->i_period <= i_lastcheck &&
-                           ( vlm->schedule[i]->i_repeat > j ||
-                             vlm->schedule[i]->i_repeat == -1 ) )
-                    {
-                        j++;
-                    }
-
-                    i_real_date = vlm->schedule[i]->i_date + j *
-                        vlm->schedule[i]->i_period;
-                }
-
-                if( i_real_date <= i_time )
-                {
-                    if( i_real_date > i_lastcheck )
-                    {
-                        for( j = 0; j < vlm->schedule[i]->i_command; j++ )
-                        {
-                            TAB_APPEND( i_scheduled_commands,
-                                        ppsz_scheduled_commands,
-                                        strdup(vlm->schedule[i]->command[j] ) );
-                        }
-                    }
-                }
-                else if( i_nextschedule == 0 || i_real_date < i_nextschedule )
-                {
-                    i_nextschedule = i_real_date;
-                }
-            }
+            for( int j = 0; j < p_sched->i_command; j++ )
+                TAB_APPEND( i_scheduled_commands, ppsz_scheduled_commands,
+                            strdup( p_sched->command[j] ) );
+
+            /* Missed periods (e.g. after a suspend) are skipped */
+            p_sched->i_next = ScheduleNextDate( p_sched, i_time );
+            if( p_sched->i_next != 0 )
+                ScheduleQueueDown( vlm, 0 );
+            else
+                vlm_ScheduleUnqueue( vlm, p_sched );
         }
 
-        while( i_scheduled_commands )
+        for( int i = 0; i < i_scheduled_commands; i++ )
         {
             vlm_message_t *message = NULL;
-            char *psz_command = ppsz_scheduled_commands[0];
-            ExecuteCommand( vlm, psz_command,&message );
+            char *psz_command = ppsz_scheduled_commands[i];
+
+            if( psz_command != NULL )
+                ExecuteCommand( vlm, psz_command, &message );
 
             /* for now, drop the message */
-            vlm_MessageDelete( message );
-            TAB_REMOVE( i_scheduled_commands,
-                        ppsz_scheduled_commands,
-                        psz_command );
+            if( message != NULL )
+                vlm_MessageDelete( message );
             free( psz_command );
         }
+        free( ppsz_scheduled_commands );
 
-        i_lastcheck = i_time;
+        /* the commands may have changed the schedules */
+        i_nextschedule = vlm->i_queue > 0 ? vlm->queue[0]->i_next : 0;
         vlc_mutex_unlock( &vlm->lock );
-
     }
 
     vlc_restorecancel (canc);
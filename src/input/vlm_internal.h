@@ -78,6 +78,10 @@ typedef struct
     /* number of times you have to repeat
        i_repeat < 0 : endless repeat     */
     int i_repeat;
+
+    /* date of the next execution, and index in the queue (-1 if none) */
+    mtime_t i_next;
+    int     i_queue;
 } vlm_schedule_sys_t;
 
 
@@ -93,6 +97,9 @@ struct vlm_t
 
     /* tell vlm thread there is work to do */
     bool         input_state_changed;
+    /* media whose inputs changed state (protected by lock_manage) */
+    int          i_changed;
+    int64_t      *changed;
     /* */
     int64_t        i_id;
 
@@ -106,11 +113,17 @@ struct vlm_t
     /* Schedule list */
     int            i_schedule;
     vlm_schedule_sys_t **schedule;
+
+    /* Enabled schedules, as a binary heap ordered by next execution date */
+    int            i_queue;
+    vlm_schedule_sys_t **queue;
 };
 
 int64_t vlm_Date(void);
 int vlm_ControlInternal( vlm_t *p_vlm, int i_query, ... );
 int ExecuteCommand( vlm_t *, const char *, vlm_message_t ** );
 void vlm_ScheduleDelete( vlm_t *vlm, vlm_schedule_sys_t *sched );
+void vlm_ScheduleUpdate( vlm_t *vlm, vlm_schedule_sys_t *sched );
+void vlm_ScheduleUnqueue( vlm_t *vlm, vlm_schedule_sys_t *sched );
 
 #endif
@@ -631,16 +631,14 @@ static int ExecuteScheduleProperty( vlm_t *p_vlm, vlm_schedule_sys_t *p_schedule
     }
     *pp_status = vlm_MessageSimpleNew( psz_cmd );
 
-    vlc_mutex_lock( &p_vlm->lock_manage );
-    p_vlm->input_state_changed = true;
-    vlc_cond_signal( &p_vlm->wait_manage );
-    vlc_mutex_unlock( &p_vlm->lock_manage );
-
+    vlm_ScheduleUpdate( p_vlm, p_schedule );
     return VLC_SUCCESS;
 
 error:
     *pp_status = vlm_MessageNew( psz_cmd, "Error while setting the property '%s' to the schedule",
                                  ppsz_property[i] );
+    /* the properties before the faulty one are set nevertheless */
+    vlm_ScheduleUpdate( p_vlm, p_schedule );
     return VLC_EGENERIC;
 }
 
@@ -983,6 +981,8 @@ static vlm_schedule_sys_t *vlm_ScheduleNew( vlm_t *vlm, const char *psz_name )
     p_sched->i_date = 0;
     p_sched->i_period = 0;
     p_sched->i_repeat = -1;
+    p_sched->i_next = 0;
+    p_sched->i_queue = -1;
 
     TAB_APPEND( vlm->i_schedule, vlm->schedule, p_sched );
 
@@ -994,6 +994,7 @@ void vlm_ScheduleDelete( vlm_t *vlm, vlm_schedule_sys_t *sched )
 {
     if( sched == NULL ) return;
 
+    vlm_ScheduleUnqueue( vlm, sched );
     TAB_REMOVE( vlm->i_schedule, vlm->schedule, sched );
 
     if( vlm->i_schedule == 0 ) free( vlm->schedule );
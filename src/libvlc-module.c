@@ -539,6 +539,11 @@ static const char *const ppsz_pos_descriptions[] =
     "picture quality, for instance deinterlacing, or distort " \
     "the video.")
 
+#define FILTER_THREADS_TEXT N_("Video filter threads")
+#define FILTER_THREADS_LONGTEXT N_( \
+    "Number of threads the video filters supporting it may split their " \
+    "work on (0 = one per CPU, 1 = no threading).")
+
 #define SNAP_PATH_TEXT N_("Video snapshot directory (or filename)")
 #define SNAP_PATH_LONGTEXT N_( \
     "Directory where the video snapshots will be stored.")
@@ -683,6 +688,12 @@ static const char *const ppsz_pos_descriptions[] =
     "This defines the maximum input delay jitter that the synchronization " \
     "algorithms should try to compensate (in milliseconds)." )
 
+#define CLOCK_CATCHUP_TEXT N_("Catch up live streams")
+#define CLOCK_CATCHUP_LONGTEXT N_( \
+    "This slowly lowers the caching of the real-time sources down to what " \
+    "their measured jitter requires, so that the latency they accumulated " \
+    "is recovered (the audio is played slightly faster meanwhile).")
+
 #define NETSYNC_TEXT N_("Network synchronisation" )
 #define NETSYNC_LONGTEXT N_( "This allows you to remotely " \
         "synchronise clocks for server and client. The detailed settings " \
@@ -790,6 +801,33 @@ static const char *const ppsz_prefres[] = {
 #define INPUT_FAST_SEEK_LONGTEXT N_( \
     "Favor speed over precision while seeking" )
 
+#define STREAM_READAHEAD_TEXT N_("Read ahead")
+#define STREAM_READAHEAD_LONGTEXT N_( \
+    "Read from the input in a separate thread, ahead of the demuxer, so " \
+    "that slow disk or network reads do not stall playback. How far ahead " \
+    "follows the reading rate." )
+
+#define STREAM_CACHE_TRACKS_TEXT N_("Stream cache tracks")
+#define STREAM_CACHE_TRACKS_LONGTEXT N_( \
+    "How many parts of a seekable input are kept in memory at once, so " \
+    "that seeking back to them does not read them again (0 for the " \
+    "default)." )
+
+#define STREAM_TRACK_SIZE_TEXT N_("Stream cache track size (kB)")
+#define STREAM_TRACK_SIZE_LONGTEXT N_( \
+    "Each part kept in memory grows and shrinks with the bitrate of the " \
+    "input, up to this size (0 for the default)." )
+
+#define STREAM_READ_SIZE_TEXT N_("Stream read size (bytes)")
+#define STREAM_READ_SIZE_LONGTEXT N_( \
+    "Smallest amount of data read from the input at once. Reads get " \
+    "larger while the input is read in sequence (0 for the default)." )
+
+#define STREAM_CACHE_BUDGET_TEXT N_("Stream cache budget (kB)")
+#define STREAM_CACHE_BUDGET_LONGTEXT N_( \
+    "Memory for the caches of all the inputs open at once. Caches do not " \
+    "grow past it, and new inputs start smaller (0 for the default)." )
+
 #define INPUT_RATE_TEXT N_("Playback speed")
 #define INPUT_RATE_LONGTEXT N_( \
     "This defines the playback speed (nominal speed is 1.0)." )
@@ -1054,6 +1092,11 @@ static const char *const ppsz_prefres[] = {
     "This allows you to select a list of encoders that VLC will use in " \
     "priority.")
 
+#define DECODER_PIPELINE_TEXT N_("Packetize video in a separate thread")
+#define DECODER_PIPELINE_LONGTEXT N_( \
+    "Run the packetizer of the video decoders that need one in its own " \
+    "thread, so that packetizing and decoding overlap.")
+
 /*****************************************************************************
  * Sout
  ****************************************************************************/
@@ -1182,6 +1225,13 @@ static const char *const ppsz_prefres[] = {
     "priorities. You can use it to tune VLC priority against other " \
     "programs, or against other VLC instances.")
 
+#define NUMA_NODE_TEXT N_("NUMA node")
+#define NUMA_NODE_LONGTEXT N_( \
+    "Runs the threads of each input (demux, decoders, outputs and stream " \
+    "output) on the CPUs of this NUMA node, with memory from the node. " \
+    "-1 leaves the placement to the system, -2 puts the inputs on the " \
+    "nodes in turn. It can be set per input, e.g. as a VLM media option.")
+
 #define USE_STREAM_IMMEDIATE N_("(Experimental) Don't do caching at the access level.")
 #define USE_STREAM_IMMEDIATE_LONGTEXT N_( \
      "This option is useful if you want to lower the latency when " \
@@ -1208,6 +1258,12 @@ static const char *const ppsz_prefres[] = {
 #define STATS_LONGTEXT N_( \
      "Collect miscellaneous local statistics about the playing media.")
 
+#define TRACE_FILE_TEXT N_("Trace file")
+#define TRACE_FILE_LONGTEXT N_( \
+     "Records the timing of the playback pipeline (packets, demux, " \
+     "decoders, filters, outputs) and writes it to this file on exit, in " \
+     "the Chrome trace format (see chrome://tracing or Perfetto).")
+
 #define DAEMON_TEXT N_("Run as daemon process")
 #define DAEMON_LONGTEXT N_( \
      "Runs VLC as a background daemon process.")
@@ -1281,6 +1337,15 @@ static const char *const ppsz_prefres[] = {
     "Automatically preparse files added to the playlist " \
     "(to retrieve some metadata)." )
 
+#define PREPARSE_THREADS_TEXT N_( "Preparser threads" )
+#define PREPARSE_THREADS_LONGTEXT N_( \
+    "Maximum number of items preparsed at the same time." )
+
+#define PREPARSE_META_TEXT N_( "Preparse meta data only" )
+#define PREPARSE_META_LONGTEXT N_( \
+    "Only retrieve the meta data of preparsed items, not the tracks " \
+    "information. This is much faster with some formats." )
+
 #define ALBUM_ART_TEXT N_( "Album art policy" )
 #define ALBUM_ART_LONGTEXT N_( \
     "Choose how album art will be downloaded." )
@@ -1297,6 +1362,33 @@ static const char *const ppsz_prefres[] = {
 #define SYNCHRONICITY_OFFLINE_SYNC_THRESHOLD_TEXT N_( "Offline Sync Threshold" )
 #define SYNCHRONICITY_OFFLINE_SYNC_THRESHOLD_LONGTEXT N_( "How close do you want the two video players to sync up to (in ms)" )
 
+#define SYNCHRONICITY_REACTOR_TEXT N_( "Single I/O thread for all peers" )
+#define SYNCHRONICITY_REACTOR_LONGTEXT N_( \
+    "Drive every viewing with friend connection from one thread instead " \
+    "of two threads per peer. Meant for hosts with many peers." )
+
+#define SYNCHRONICITY_UDP_TEXT N_( "Sync clocks over UDP" )
+#define SYNCHRONICITY_UDP_LONGTEXT N_( \
+    "Send clock sync messages as UDP datagrams through the relay server, " \
+    "so lost packets do not disturb the sync. Falls back to the TCP " \
+    "connection when UDP does not get through." )
+
+#define SYNCHRONICITY_RESUME_TEXT N_( "Resume after network loss" )
+#define SYNCHRONICITY_RESUME_LONGTEXT N_( \
+    "Ask the relay server to keep the viewing for a while when the " \
+    "connection drops, and reconnect to it without a new key and without " \
+    "syncing the clocks again." )
+
+#define SYNCHRONICITY_PARTY_TEXT N_( "Host a watch party" )
+#define SYNCHRONICITY_PARTY_LONGTEXT N_( \
+    "Let any number of friends join the key when hosting. Every command " \
+    "is sent once and the relay server copies it to each of them." )
+
+#define SYNCHRONICITY_STREAM_TEXT N_( "Stream to the peers" )
+#define SYNCHRONICITY_STREAM_LONGTEXT N_( \
+    "Also mux what is played for the relay server, so that peers without " \
+    "the file can open syn:// and watch it along when we host." )
+
 static const int pi_albumart_values[] = { ALBUM_ART_WHEN_ASKED,
                                           ALBUM_ART_WHEN_PLAYED,
                                           ALBUM_ART_ALL };
@@ -1794,6 +1886,8 @@ vlc_module_begin ()
                 VIDEO_FILTER_TEXT, VIDEO_FILTER_LONGTEXT, false )
     add_module_list_cat( "video-splitter", SUBCAT_VIDEO_VFILTER, NULL,
                         VIDEO_SPLITTER_TEXT, VIDEO_SPLITTER_LONGTEXT, false )
+    add_integer_with_range( "filter-threads", 0, 0, 32,
+                FILTER_THREADS_TEXT, FILTER_THREADS_LONGTEXT, true )
     add_obsolete_string( "vout-filter" ) /* since 2.0.0 */
 #if 0
     add_string( "pixel-ratio", "1", PIXEL_RATIO_TEXT, PIXEL_RATIO_TEXT )
@@ -1885,6 +1979,20 @@ vlc_module_begin ()
     add_bool( "input-fast-seek", false,
               INPUT_FAST_SEEK_TEXT, INPUT_FAST_SEEK_LONGTEXT, false )
         change_safe ()
+    add_bool( "stream-readahead", false,
+              STREAM_READAHEAD_TEXT, STREAM_READAHEAD_LONGTEXT, true )
+        change_safe ()
+    add_integer_with_range( "stream-cache-tracks", 0, 0, 16,
+                            STREAM_CACHE_TRACKS_TEXT,
+                            STREAM_CACHE_TRACKS_LONGTEXT, true )
+    add_integer_with_range( "stream-track-size", 0, 0, 1024 * 1024,
+                            STREAM_TRACK_SIZE_TEXT,
+                            STREAM_TRACK_SIZE_LONGTEXT, true )
+    add_integer_with_range( "stream-read-size", 0, 0, 65536,
+                            STREAM_READ_SIZE_TEXT,
+                            STREAM_READ_SIZE_LONGTEXT, true )
+    add_integer( "stream-cache-budget", 0,
+                 STREAM_CACHE_BUDGET_TEXT, STREAM_CACHE_BUDGET_LONGTEXT, true )
     add_float( "rate", 1.,
                INPUT_RATE_TEXT, INPUT_RATE_LONGTEXT, false )
 
@@ -2023,6 +2131,9 @@ vlc_module_begin ()
     add_integer( "clock-jitter", 5 * CLOCK_FREQ/1000, CLOCK_JITTER_TEXT,
               CLOCK_JITTER_LONGTEXT, true )
         change_safe()
+    add_bool( "clock-catchup", false, CLOCK_CATCHUP_TEXT,
+              CLOCK_CATCHUP_LONGTEXT, true )
+        change_safe()
 
     add_bool( "network-synchronisation", false, NETSYNC_TEXT,
               NETSYNC_LONGTEXT, true )
@@ -2045,6 +2156,8 @@ vlc_module_begin ()
                 CODEC_LONGTEXT, true )
     add_string( "encoder",  NULL, ENCODER_TEXT,
                 ENCODER_LONGTEXT, true )
+    add_bool( "decoder-pipeline", false, DECODER_PIPELINE_TEXT,
+              DECODER_PIPELINE_LONGTEXT, true )
 
     set_subcategory( SUBCAT_INPUT_ACCESS )
     add_category_hint( N_("Input"), INPUT_CAT_LONGTEXT , false )
@@ -2155,6 +2268,9 @@ vlc_module_begin ()
     add_integer( "rt-offset", 0, RT_OFFSET_TEXT,
                  RT_OFFSET_LONGTEXT, true )
 #endif
+    add_integer( "numa-node", -1, NUMA_NODE_TEXT, NUMA_NODE_LONGTEXT, true )
+        change_integer_range( -2, 63 )
+        change_safe()
 
 #if defined(HAVE_DBUS)
     add_bool( "inhibit", 1, INHIBIT_TEXT,
@@ -2210,6 +2326,11 @@ vlc_module_begin ()
 
     add_bool( "auto-preparse", true, PREPARSE_TEXT,
               PREPARSE_LONGTEXT, false )
+    add_integer_with_range( "preparse-threads", 2, 1, 16,
+                            PREPARSE_THREADS_TEXT, PREPARSE_THREADS_LONGTEXT,
+                            true )
+    add_bool( "preparse-meta-only", false, PREPARSE_META_TEXT,
+              PREPARSE_META_LONGTEXT, true )
 
     add_integer( "album-art", ALBUM_ART_WHEN_ASKED, ALBUM_ART_TEXT,
                  ALBUM_ART_LONGTEXT, false )
@@ -2231,6 +2352,17 @@ vlc_module_begin ()
         SYNCHRONICITY_OFFLINE_SYNC_THRESHOLD_TEXT,
         SYNCHRONICITY_OFFLINE_SYNC_THRESHOLD_LONGTEXT, true);
 
+    add_bool( "synchronicity-reactor", false, SYNCHRONICITY_REACTOR_TEXT,
+              SYNCHRONICITY_REACTOR_LONGTEXT, true);
+    add_bool( "synchronicity-udp", true, SYNCHRONICITY_UDP_TEXT,
+              SYNCHRONICITY_UDP_LONGTEXT, true);
+    add_bool( "synchronicity-resume", true, SYNCHRONICITY_RESUME_TEXT,
+              SYNCHRONICITY_RESUME_LONGTEXT, true);
+    add_bool( "synchronicity-party", false, SYNCHRONICITY_PARTY_TEXT,
+              SYNCHRONICITY_PARTY_LONGTEXT, true);
+    add_bool( "synchronicity-stream", false, SYNCHRONICITY_STREAM_TEXT,
+              SYNCHRONICITY_STREAM_LONGTEXT, true);
+
     set_subcategory( SUBCAT_PLAYLIST_SD )
     add_string( "services-discovery", "", SD_TEXT, SD_LONGTEXT, true )
         change_short('S')
@@ -2274,6 +2406,10 @@ vlc_module_begin ()
               INTERACTION_LONGTEXT, false )
 
     add_bool ( "stats", true, STATS_TEXT, STATS_LONGTEXT, true )
+#ifdef ENABLE_TRACE
+    add_savefile( "trace-file", NULL, TRACE_FILE_TEXT, TRACE_FILE_LONGTEXT,
+                  true )
+#endif
 
     set_subcategory( SUBCAT_INTERFACE_MAIN )
     add_module_cat( "intf", SUBCAT_INTERFACE_MAIN, NULL, INTF_TEXT,
@@ -75,6 +75,7 @@
 #include <vlc_url.h>
 #include <vlc_atomic.h>
 #include <vlc_modules.h>
+#include <vlc_executor.h>
 
 #include "libvlc.h"
 
@@ -195,6 +196,18 @@ libvlc_int_t * libvlc_InternalCreate( void )
     vlc_mutex_init( &priv->ml_lock );
     vlc_mutex_init( &priv->timer_lock );
     vlc_ExitInit( &priv->exit );
+    priv->image_cache = image_CacheNew();
+    priv->executor = vlc_executor_New( 0, VLC_THREAD_PRIORITY_LOW );
+    if( unlikely(priv->executor == NULL) )
+    {
+        if( priv->image_cache )
+            image_CacheDelete( priv->image_cache );
+        vlc_ExitDestroy( &priv->exit );
+        vlc_mutex_destroy( &priv->timer_lock );
+        vlc_mutex_destroy( &priv->ml_lock );
+        vlc_object_release( p_libvlc );
+        return NULL;
+    }
 
     return p_libvlc;
 }
@@ -217,6 +230,9 @@ int libvlc_InternalInit( libvlc_int_t *p_libvlc, int i_argc,
     playlist_t  *p_playlist = NULL;
     char        *psz_val;
 
+    /* Messages are dispatched by a background thread from now on */
+    vlc_LogInit ();
+
     /* System specific initialization code */
     system_Init();
 
@@ -523,6 +539,14 @@ int libvlc_InternalInit( libvlc_int_t *p_libvlc, int i_argc,
     vlc_object_set_name( p_libvlc, "main" );
 
     priv->b_stats = var_InheritBool( p_libvlc, "stats" );
+#ifdef ENABLE_TRACE
+    char *psz_trace = var_InheritString( p_libvlc, "trace-file" );
+    if( psz_trace != NULL )
+    {
+        vlc_tracer_Start();
+        free( psz_trace );
+    }
+#endif
     priv->i_timers = 0;
     priv->pp_timers = NULL;
 
@@ -777,6 +801,24 @@ void libvlc_InternalCleanup( libvlc_int_t *p_libvlc )
 
     /* Free playlist now, all threads are gone */
     playlist_Destroy( p_playlist );
+
+    if( priv->image_cache )
+    {
+        image_CacheDelete( priv->image_cache );
+        priv->image_cache = NULL;
+    }
+    /* Tasks are cancelled by their owners, which are all gone */
+    vlc_executor_Delete( priv->executor );
+    priv->executor = NULL;
+#ifdef ENABLE_TRACE
+    char *psz_trace = var_InheritString( p_libvlc, "trace-file" );
+    if( psz_trace != NULL )
+    {
+        vlc_tracer_Stop( VLC_OBJECT(p_libvlc), psz_trace );
+        free( psz_trace );
+    }
+#endif
+    vlc_memstats_Dump( VLC_OBJECT(p_libvlc) );
     stats_TimersDumpAll( p_libvlc );
     stats_TimersCleanAll( p_libvlc );
 
@@ -829,6 +871,7 @@ void libvlc_InternalDestroy( libvlc_int_t *p_libvlc )
     libvlc_priv_t *priv = libvlc_priv( p_libvlc );
 
     system_End( );
+    vlc_LogDeinit ();
 
     /* Destroy mutexes */
     vlc_ExitDestroy( &priv->exit );
@@ -43,8 +43,25 @@ void system_Init      ( void );
 void system_Configure ( libvlc_int_t *, int, const char *const [] );
 void system_End       ( void );
 
+/*
+ * Logging
+ */
+void vlc_LogInit (void);
+void vlc_LogDeinit (void);
+
 void vlc_CPU_init(void);
 void vlc_CPU_dump(vlc_object_t *);
+/* Copies of at least this size skip the caches: the destination would not
+ * be read back before being evicted anyway (pictures) */
+#define VLC_MEMCPY_STREAM_MIN (256 * 1024)
+void *vlc_memcpy_stream(void *, const void *, size_t);
+
+/* Tracing */
+void vlc_tracer_Start(void);
+void vlc_tracer_Stop(vlc_object_t *, const char *);
+
+/* Memory accounting */
+void vlc_memstats_Dump(vlc_object_t *);
 
 /*
  * Threads subsystem
@@ -59,6 +76,9 @@ int vlc_set_priority( vlc_thread_t, int );
 
 void vlc_threads_setup (libvlc_int_t *);
 
+unsigned vlc_numa_GetNodeCount (void);
+int vlc_numa_Bind (int node);
+
 void vlc_trace (const char *fn, const char *file, unsigned line);
 #define vlc_backtrace() vlc_trace(__func__, __FILE__, __LINE__)
 
@@ -132,8 +152,10 @@ struct vlc_object_internals
 {
     char           *psz_name; /* given name */
 
-    /* Object variables */
-    void           *var_root;
+    /* Object variables, hashed by name */
+    variable_t    **var_table; /**< var_mask + 1 buckets, or NULL */
+    unsigned        var_mask;
+    unsigned        var_count;
     vlc_mutex_t     var_lock;
     vlc_cond_t      var_wait;
 
@@ -162,6 +184,14 @@ struct vlc_object_internals
 
 typedef struct sap_handler_t sap_handler_t;
 
+/*
+ * Images
+ */
+typedef struct image_cache_t image_cache_t;
+
+image_cache_t *image_CacheNew( void );
+void image_CacheDelete( image_cache_t * );
+
 /**
  * Private LibVLC instance data.
  */
@@ -192,6 +222,8 @@ typedef struct libvlc_priv_t
     sap_handler_t     *p_sap; ///< SAP SDP advertiser
 #endif
     struct vlc_actions *actions; ///< Hotkeys handler
+    image_cache_t     *image_cache; ///< Decoded images (or NULL)
+    struct vlc_executor_t *executor; ///< Shared thread pool
 
     /* Interfaces */
     struct intf_thread_t *p_intf; ///< Interfaces linked-list
@@ -289,6 +321,20 @@ static inline int stats_UpdateFloat( vlc_object_t *p_obj, counter_t *p_co,
 }
 #define stats_UpdateFloat(a,b,c,d) stats_UpdateFloat( VLC_OBJECT(a),b,c,d )
 
+/**
+ * Distribution of durations, in buckets of 1/8 octave from 1 us to 16 s.
+ * Samples are added without locking.
+ */
+#define STATS_HISTOGRAM_BUCKETS 176
+
+typedef struct
+{
+    vlc_atomic_t buckets[STATS_HISTOGRAM_BUCKETS];
+} stats_histogram_t;
+
+void stats_HistogramAdd (stats_histogram_t *, mtime_t);
+mtime_t stats_HistogramPercentile (const stats_histogram_t *, unsigned);
+
 void stats_ComputeInputStats(input_thread_t*, input_stats_t*);
 void stats_ReinitInputStats(input_stats_t *);
 void stats_DumpInputStats(input_stats_t *);
@@ -37,21 +37,188 @@
 #endif
 
 #include "vlc_block.h"
+#include <vlc_atomic.h>
+#include <vlc_memstats.h>
 
 /**
  * @section Block handling functions.
  */
 
+/* Blocks up to BLOCK_POOL_MAX bytes come from per-thread free lists, one
+ * per power of two size class. A block released by another thread than
+ * the one that allocated it goes back to that thread's lists through a
+ * lock-free return stack, which the owner drains once its own list runs
+ * empty. The lists of a thread that exits go to the next thread that
+ * allocates. The pool needs pthread_once(), other systems use malloc(). */
+#if defined (LIBVLC_USE_PTHREAD) && !defined (BLOCK_NO_POOL)
+# define BLOCK_POOL 1
+#endif
+#define BLOCK_POOL_MIN_SHIFT 9   /* 512 bytes */
+#define BLOCK_POOL_CLASSES   8   /* up to 64 KiB */
+#define BLOCK_POOL_MAX       (1 << (BLOCK_POOL_MIN_SHIFT + BLOCK_POOL_CLASSES - 1))
+/* Bytes a thread keeps per size class from its own releases, on top of
+ * what others handed back */
+#define BLOCK_POOL_KEEP      (256 << 10)
+
+typedef struct block_pool_t block_pool_t;
+
 /**
  * Internal state for heap block.
   */
 struct block_sys_t
 {
     block_t     self;
+    block_pool_t *p_pool; /* NULL if from malloc() alone */
+    unsigned    i_class;
+    vlc_atomic_t refs;    /* once sliced, see block_Slice() */
     size_t      i_allocated_buffer;
     uint8_t     p_allocated_buffer[];
 };
 
+#ifdef BLOCK_POOL
+struct block_pool_t
+{
+    block_pool_t *p_next; /* in the orphans list */
+    struct
+    {
+        block_sys_t *p_free; /* owner thread only */
+        unsigned     i_free; /* of those, released by the owner */
+        vlc_atomic_t returned; /* block_sys_t stack, pushed by others */
+    } classes[BLOCK_POOL_CLASSES];
+};
+
+static pthread_once_t pool_once = PTHREAD_ONCE_INIT;
+static vlc_threadvar_t pool_key;
+static bool pool_ready = false;
+static vlc_mutex_t pool_lock = VLC_STATIC_MUTEX;
+static block_pool_t *pool_orphans = NULL;
+
+static unsigned BlockPoolKeep( unsigned i_class )
+{
+    unsigned keep = BLOCK_POOL_KEEP >> (BLOCK_POOL_MIN_SHIFT + i_class);
+    return keep > 4 ? keep : 4;
+}
+
+/* The thread exits: frees what it kept, others may still return blocks */
+static void BlockPoolOrphan( void *data )
+{
+    block_pool_t *p_pool = data;
+
+    for( unsigned i = 0; i < BLOCK_POOL_CLASSES; i++ )
+    {
+        block_sys_t *p_sys = p_pool->classes[i].p_free;
+        while( p_sys != NULL )
+        {
+            block_sys_t *p_next = (block_sys_t *)p_sys->self.p_next;
+            free( p_sys );
+            p_sys = p_next;
+        }
+        p_pool->classes[i].p_free = NULL;
+        p_pool->classes[i].i_free = 0;
+    }
+    vlc_mutex_lock( &pool_lock );
+    p_pool->p_next = pool_orphans;
+    pool_orphans = p_pool;
+    vlc_mutex_unlock( &pool_lock );
+}
+
+static void BlockPoolInit( void )
+{
+    pool_ready = vlc_threadvar_create( &pool_key, BlockPoolOrphan ) == 0;
+}
+
+/* The calling thread's pool, or NULL */
+static block_pool_t *BlockPoolGet( void )
+{
+    pthread_once( &pool_once, BlockPoolInit );
+    if( unlikely(!pool_ready) )
+        return NULL;
+
+    block_pool_t *p_pool = vlc_threadvar_get( pool_key );
+    if( likely(p_pool != NULL) )
+        return p_pool;
+
+    vlc_mutex_lock( &pool_lock );
+    p_pool = pool_orphans;
+    if( p_pool != NULL )
+        pool_orphans = p_pool->p_next;
+    vlc_mutex_unlock( &pool_lock );
+    if( p_pool == NULL )
+    {
+        p_pool = calloc( 1, sizeof(*p_pool) );
+        if( unlikely(p_pool == NULL) )
+            return NULL;
+    }
+    if( unlikely(vlc_threadvar_set( pool_key, p_pool )) )
+    {
+        BlockPoolOrphan( p_pool );
+        return NULL;
+    }
+    return p_pool;
+}
+
+static block_sys_t *BlockPoolTake( block_pool_t *p_pool, unsigned i_class )
+{
+    block_sys_t *p_sys = p_pool->classes[i_class].p_free;
+
+    if( p_sys == NULL )
+    {   /* take back whatever other threads released: as many blocks are
+         * in flight, they are likely soon needed again */
+        uintptr_t i_returned =
+            vlc_atomic_swap( &p_pool->classes[i_class].returned, 0 );
+        p_sys = (block_sys_t *)i_returned;
+        if( p_sys == NULL )
+            return NULL;
+        p_pool->classes[i_class].i_free = 0;
+    }
+    p_pool->classes[i_class].p_free = (block_sys_t *)p_sys->self.p_next;
+    if( p_pool->classes[i_class].i_free > 0 )
+        p_pool->classes[i_class].i_free--;
+    return p_sys;
+}
+
+static void BlockPoolPut( block_sys_t *p_sys )
+{
+    block_pool_t *p_pool = p_sys->p_pool;
+    const unsigned i_class = p_sys->i_class;
+
+    if( vlc_threadvar_get( pool_key ) == p_pool )
+    {
+        if( p_pool->classes[i_class].i_free >= BlockPoolKeep( i_class ) )
+        {
+            free( p_sys );
+            return;
+        }
+        p_sys->self.p_next = (block_t *)p_pool->classes[i_class].p_free;
+        p_pool->classes[i_class].p_free = p_sys;
+        p_pool->classes[i_class].i_free++;
+        return;
+    }
+
+    vlc_atomic_t *returned = &p_pool->classes[i_class].returned;
+    uintptr_t head;
+    do
+    {
+        head = vlc_atomic_get( returned );
+        p_sys->self.p_next = (block_t *)head;
+    }
+    while( vlc_atomic_compare_swap( returned, head, (uintptr_t)p_sys ) != head );
+}
+
+/* Size class of an allocation of i_alloc bytes, BLOCK_POOL_CLASSES if
+ * it is too large for the pool */
+static unsigned BlockClass( size_t i_alloc )
+{
+    if( i_alloc > BLOCK_POOL_MAX )
+        return BLOCK_POOL_CLASSES;
+
+    unsigned i_class = 0;
+    while( ((size_t)1 << (BLOCK_POOL_MIN_SHIFT + i_class)) < i_alloc )
+        i_class++;
+    return i_class;
+}
+#endif
+
 #ifndef NDEBUG
 static void BlockNoRelease( block_t *b )
 {
@@ -78,6 +245,16 @@ void block_Init( block_t *restrict b, void *buf, size_t size )
 
 static void BlockRelease( block_t *p_block )
 {
+    block_sys_t *p_sys = (block_sys_t *)p_block;
+
+    VLC_MEM_FREE( VLC_MEM_BLOCK, sizeof(*p_sys) + p_sys->i_allocated_buffer );
+#ifdef BLOCK_POOL
+    if( p_sys->p_pool != NULL )
+    {
+        BlockPoolPut( p_sys );
+        return;
+    }
+#endif
     free( p_block );
 }
 
@@ -100,8 +277,7 @@ static void BlockMetaCopy( block_t *restrict out, const block_t *in )
 
 block_t *block_Alloc( size_t i_size )
 {
-    /* We do only one malloc
-     * TODO: bench if doing 2 malloc but keeping a pool of buffer is better
+    /* We do only one malloc, of a size class of the pool if small enough
      * 2 * BLOCK_PADDING -> pre + post padding
      */
     block_sys_t *p_sys;
@@ -123,14 +299,30 @@ block_t *block_Alloc( size_t i_size )
     buf = p_sys->p_allocated_buffer + (-sizeof(*p_sys) & (BLOCK_ALIGN - 1));
 
 #else
-    const size_t i_alloc = sizeof(*p_sys) + BLOCK_ALIGN + (2 * BLOCK_PADDING)
-                         + ALIGN(i_size);
+    size_t i_alloc = sizeof(*p_sys) + BLOCK_ALIGN + (2 * BLOCK_PADDING)
+                   + ALIGN(i_size);
     if( unlikely(i_alloc <= i_size) )
         return NULL;
 
-    p_sys = malloc( i_alloc );
+    block_pool_t *p_pool = NULL;
+    unsigned i_class = BLOCK_POOL_CLASSES;
+    p_sys = NULL;
+#ifdef BLOCK_POOL
+    i_class = BlockClass( i_alloc );
+    if( i_class < BLOCK_POOL_CLASSES && (p_pool = BlockPoolGet()) != NULL )
+    {
+        i_alloc = (size_t)1 << (BLOCK_POOL_MIN_SHIFT + i_class);
+        p_sys = BlockPoolTake( p_pool, i_class );
+    }
+    else
+        i_class = BLOCK_POOL_CLASSES;
+#endif
+    if( p_sys == NULL )
+        p_sys = malloc( i_alloc );
     if( p_sys == NULL )
         return NULL;
+    p_sys->p_pool = p_pool;
+    p_sys->i_class = i_class;
 
     buf = (void *)ALIGN((uintptr_t)p_sys->p_allocated_buffer);
 
@@ -141,6 +333,7 @@ block_t *block_Alloc( size_t i_size )
     p_sys->self.pf_release    = BlockRelease;
     /* Fill opaque data */
     p_sys->i_allocated_buffer = i_alloc - sizeof(*p_sys);
+    VLC_MEM_ALLOC( VLC_MEM_BLOCK, i_alloc );
 
     return &p_sys->self;
 }
@@ -234,9 +427,16 @@ block_t *block_Realloc( block_t *p_block, ssize_t i_prebody, size_t i_body )
         p_block = p_rea;
     }
     else
-    /* We have a very large reserved footer now? Release some of it.
+    /* We have a very large reserved footer now? Release some of it,
+     * unless the block would take as much from the pool again.
      * XXX it might not preserve the alignment of p_buffer */
-    if( p_end - (p_block->p_buffer + i_body) > BLOCK_WASTE_SIZE )
+    if( p_end - (p_block->p_buffer + i_body) > BLOCK_WASTE_SIZE
+#ifdef BLOCK_POOL
+     && ( p_sys->p_pool == NULL
+       || BlockClass( sizeof(*p_sys) + BLOCK_ALIGN + (2 * BLOCK_PADDING)
+                    + ALIGN(requested) ) < p_sys->i_class )
+#endif
+      )
     {
         block_t *p_rea = block_Alloc( requested );
         if( p_rea )
@@ -269,6 +469,121 @@ block_t *block_Realloc( block_t *p_block, ssize_t i_prebody, size_t i_body )
     return p_block;
 }
 
+/* A slice views the buffer of a heap block, which is released once
+ * neither the block itself nor any slice references it. */
+typedef struct
+{
+    block_t      self;
+    block_sys_t *p_sys;
+} block_slice_t;
+
+static void BlockUnref( block_sys_t *p_sys )
+{
+    if( vlc_atomic_dec( &p_sys->refs ) == 0 )
+        BlockRelease( &p_sys->self );
+}
+
+/* pf_release of a heap block once it has been sliced */
+static void BlockSharedRelease( block_t *p_block )
+{
+    BlockUnref( (block_sys_t *)p_block );
+}
+
+static void BlockSliceRelease( block_t *p_block )
+{
+    block_slice_t *p_slice = (block_slice_t *)p_block;
+
+    BlockUnref( p_slice->p_sys );
+    free( p_slice );
+}
+
+/* The heap block whose buffer p_block views, or NULL */
+static block_sys_t *BlockViewed( const block_t *p_block )
+{
+    if( p_block->pf_release == BlockSliceRelease )
+        return ((const block_slice_t *)p_block)->p_sys;
+    if( p_block->pf_release == BlockSharedRelease )
+        return (block_sys_t *)p_block;
+    return NULL;
+}
+
+static block_t *BlockSliceNew( block_sys_t *p_sys, uint8_t *p_buffer,
+                               size_t i_size )
+{
+    block_slice_t *p_slice = malloc( sizeof( *p_slice ) );
+    if( unlikely(p_slice == NULL) )
+        return NULL;
+
+    block_Init( &p_slice->self, p_buffer, i_size );
+    p_slice->self.pf_release = BlockSliceRelease;
+    p_slice->p_sys = p_sys;
+    vlc_atomic_inc( &p_sys->refs );
+    return &p_slice->self;
+}
+
+/**
+ * Creates a block viewing i_size bytes of the payload of p_block from
+ * i_offset, without copying them if p_block comes from block_Alloc() or
+ * is such a view itself. The new block has default metadata, and
+ * p_block stays valid: the buffer is freed once both were released.
+ *
+ * The bytes are shared. Do not modify them while other blocks may view
+ * them; block_Realloc() makes a copy of a shared block.
+ *
+ * @return the new block, or NULL on error.
+ */
+block_t *block_Slice( block_t *p_block, size_t i_offset, size_t i_size )
+{
+    assert( i_offset <= p_block->i_buffer );
+    assert( i_size <= p_block->i_buffer - i_offset );
+
+    uint8_t *p_buffer = p_block->p_buffer + i_offset;
+    block_sys_t *p_sys = BlockViewed( p_block );
+
+    if( p_sys == NULL && p_block->pf_release == BlockRelease )
+    {   /* the caller owns it, nobody else can look yet */
+        p_sys = (block_sys_t *)p_block;
+        vlc_atomic_set( &p_sys->refs, 1 );
+        p_block->pf_release = BlockSharedRelease;
+    }
+    if( p_sys != NULL )
+        return BlockSliceNew( p_sys, p_buffer, i_size );
+
+    block_t *p_copy = block_Alloc( i_size );
+    if( likely(p_copy != NULL) )
+        memcpy( p_copy->p_buffer, p_buffer, i_size );
+    return p_copy;
+}
+
+/**
+ * If the blocks of a chain view consecutive bytes of one buffer, as
+ * the slices of a block do, replaces them with a single view of all of
+ * them. The new block has default metadata.
+ *
+ * @return the new block, or NULL if the blocks are not consecutive or
+ * on error, the chain is left as it is then.
+ */
+block_t *block_ChainJoin( block_t *p_list )
+{
+    block_sys_t *p_sys = BlockViewed( p_list );
+    if( p_sys == NULL )
+        return NULL;
+
+    size_t i_size = p_list->i_buffer;
+    for( const block_t *b = p_list; b->p_next != NULL; b = b->p_next )
+    {
+        if( BlockViewed( b->p_next ) != p_sys
+         || b->p_next->p_buffer != b->p_buffer + b->i_buffer )
+            return NULL;
+        i_size += b->p_next->i_buffer;
+    }
+
+    block_t *p_join = BlockSliceNew( p_sys, p_list->p_buffer, i_size );
+    if( p_join != NULL )
+        block_ChainRelease( p_list );
+    return p_join;
+}
+
 
 typedef struct
 {
@@ -506,6 +821,20 @@ struct block_fifo_t
     size_t              i_depth;
     size_t              i_size;
     bool          b_force_wake;
+
+    /* Lock-free mode, see block_FifoNewSPSC(). The lock only protects
+     * the waits. */
+    bool          b_spsc;
+    vlc_atomic_t  incoming;     /**< blocks put, newest first */
+    block_t      *p_out;        /**< blocks to get, oldest first */
+    vlc_atomic_t  put_depth;    /**< counted in by the putters */
+    vlc_atomic_t  put_size;
+    size_t        got_depth;    /**< and out by the getter alone */
+    size_t        got_size;
+    vlc_atomic_t  flush;        /**< drop p_out before the next get */
+    vlc_atomic_t  force_wake;
+    vlc_atomic_t  getter_waits; /**< the getter sleeps or is about to */
+    vlc_atomic_t  putters_wait; /**< threads sleeping in block_FifoPace() */
 };
 
 block_fifo_t *block_FifoNew( void )
@@ -522,12 +851,85 @@ block_fifo_t *block_FifoNew( void )
     p_fifo->i_depth = p_fifo->i_size = 0;
     p_fifo->b_force_wake = false;
 
+    p_fifo->b_spsc = false;
+    vlc_atomic_set( &p_fifo->incoming, 0 );
+    p_fifo->p_out = NULL;
+    vlc_atomic_set( &p_fifo->put_depth, 0 );
+    vlc_atomic_set( &p_fifo->put_size, 0 );
+    p_fifo->got_depth = p_fifo->got_size = 0;
+    vlc_atomic_set( &p_fifo->flush, 0 );
+    vlc_atomic_set( &p_fifo->force_wake, 0 );
+    vlc_atomic_set( &p_fifo->getter_waits, 0 );
+    vlc_atomic_set( &p_fifo->putters_wait, 0 );
+
     return p_fifo;
 }
 
+/**
+ * Creates a FIFO for exactly one thread getting blocks at a time, as a
+ * decoder does. Blocks are put and got without locking: the lock and the
+ * condition variables are only used when the getter finds the FIFO empty
+ * and when block_FifoPace() has to wait. Puts may come from several
+ * threads, block_FifoEmpty() from any thread.
+ */
+block_fifo_t *block_FifoNewSPSC( void )
+{
+    block_fifo_t *p_fifo = block_FifoNew();
+    if( p_fifo != NULL )
+        p_fifo->b_spsc = true;
+    return p_fifo;
+}
+
+/* Where block_FifoEmpty() left the incoming stack of a lock-free FIFO:
+ * the blocks below it were put before, the getter drops what it holds
+ * when it comes across it. */
+#define FIFO_EMPTIED ((block_t *)(uintptr_t)1)
+
+static void BlockChainRelease( block_t *block )
+{
+    while( block != NULL && block != FIFO_EMPTIED )
+    {
+        block_t *buf = block->p_next;
+        block_Release( block );
+        block = buf;
+    }
+}
+
+/* Takes the blocks of a chain, which the getter does not hold, out of
+ * the lock-free counters */
+static void FifoSPSCAccount( block_fifo_t *p_fifo, const block_t *block )
+{
+    size_t i_depth = 0, i_size = 0;
+
+    for( ; block != NULL && block != FIFO_EMPTIED; block = block->p_next )
+    {
+        i_depth++;
+        i_size += block->i_buffer;
+    }
+    if( i_depth > 0 )
+    {
+        vlc_atomic_sub( &p_fifo->put_depth, i_depth );
+        vlc_atomic_sub( &p_fifo->put_size, i_size );
+    }
+}
+
+/* What was got is read first, so that it never exceeds what was put */
+static size_t FifoSPSCDepth( const block_fifo_t *p_fifo )
+{
+    size_t i_got = p_fifo->got_depth;
+    return vlc_atomic_get( &p_fifo->put_depth ) - i_got;
+}
+
+static size_t FifoSPSCSize( const block_fifo_t *p_fifo )
+{
+    size_t i_got = p_fifo->got_size;
+    return vlc_atomic_get( &p_fifo->put_size ) - i_got;
+}
+
 void block_FifoRelease( block_fifo_t *p_fifo )
 {
     block_FifoEmpty( p_fifo );
+    BlockChainRelease( p_fifo->p_out );
     vlc_cond_destroy( &p_fifo->wait_room );
     vlc_cond_destroy( &p_fifo->wait );
     vlc_mutex_destroy( &p_fifo->lock );
@@ -538,6 +940,20 @@ void block_FifoEmpty( block_fifo_t *p_fifo )
 {
     block_t *block;
 
+    if( p_fifo->b_spsc )
+    {   /* p_out belongs to the getter, it drops it on its next get */
+        uintptr_t i_incoming = vlc_atomic_swap( &p_fifo->incoming,
+                                                (uintptr_t)FIFO_EMPTIED );
+        block = (block_t *)i_incoming;
+        FifoSPSCAccount( p_fifo, block );
+        vlc_atomic_set( &p_fifo->flush, 1 );
+        vlc_mutex_lock( &p_fifo->lock );
+        vlc_cond_broadcast( &p_fifo->wait_room );
+        vlc_mutex_unlock( &p_fifo->lock );
+        BlockChainRelease( block );
+        return;
+    }
+
     vlc_mutex_lock( &p_fifo->lock );
     block = p_fifo->p_first;
     if (block != NULL)
@@ -576,10 +992,45 @@ void block_FifoEmpty( block_fifo_t *p_fifo )
  *                  (use SIZE_MAX to ignore this constraint)
  * @return nothing.
  */
+static void FifoPaceCleanup (void *data)
+{
+    block_fifo_t *fifo = data;
+
+    vlc_atomic_dec (&fifo->putters_wait);
+    vlc_mutex_unlock (&fifo->lock);
+}
+
+static void FifoSPSCPace (block_fifo_t *fifo, size_t max_depth,
+                          size_t max_size)
+{
+#define FIFO_FULL() (FifoSPSCDepth (fifo) > max_depth \
+                  || FifoSPSCSize (fifo) > max_size)
+    /* unordered first look, a wrong guess only costs the lock */
+    if (fifo->put_depth.u - fifo->got_depth <= max_depth
+     && fifo->put_size.u - fifo->got_size <= max_size)
+        return;
+
+    vlc_mutex_lock (&fifo->lock);
+    /* the getter checks for us after it took a block: either it sees
+     * us or we see the room it made */
+    vlc_atomic_inc (&fifo->putters_wait);
+    vlc_cleanup_push (FifoPaceCleanup, fifo);
+    while (FIFO_FULL ())
+        vlc_cond_wait (&fifo->wait_room, &fifo->lock);
+    vlc_cleanup_run ();
+#undef FIFO_FULL
+}
+
 void block_FifoPace (block_fifo_t *fifo, size_t max_depth, size_t max_size)
 {
     vlc_testcancel ();
 
+    if (fifo->b_spsc)
+    {
+        FifoSPSCPace (fifo, max_depth, max_size);
+        return;
+    }
+
     vlc_mutex_lock (&fifo->lock);
     while ((fifo->i_depth > max_depth) || (fifo->i_size > max_size))
     {
@@ -611,6 +1062,42 @@ size_t block_FifoPut( block_fifo_t *p_fifo, block_t *p_block )
             break;
     }
 
+    if (p_fifo->b_spsc)
+    {
+        /* counted first, the getter takes them out once it has them */
+        vlc_atomic_add (&p_fifo->put_depth, i_depth);
+        vlc_atomic_add (&p_fifo->put_size, i_size);
+
+        /* the stack is newest first */
+        block_t *p_rev = NULL;
+        for (block_t *b = p_block, *next; b != NULL; b = next)
+        {
+            next = b->p_next;
+            b->p_next = p_rev;
+            p_rev = b;
+        }
+        uintptr_t head = p_fifo->incoming.u, seen;
+        for (;;)
+        {
+            p_block->p_next = (block_t *)head;
+            seen = vlc_atomic_compare_swap (&p_fifo->incoming, head,
+                                            (uintptr_t)p_rev);
+            if (seen == head)
+                break;
+            head = seen;
+        }
+
+        /* either the getter sees the blocks or we see it waiting; the
+         * swap was a full barrier already */
+        if (p_fifo->getter_waits.u)
+        {
+            vlc_mutex_lock (&p_fifo->lock);
+            vlc_cond_signal (&p_fifo->wait);
+            vlc_mutex_unlock (&p_fifo->lock);
+        }
+        return i_size;
+    }
+
     vlc_mutex_lock (&p_fifo->lock);
     *p_fifo->pp_last = p_block;
     p_fifo->pp_last = &p_last->p_next;
@@ -625,6 +1112,16 @@ size_t block_FifoPut( block_fifo_t *p_fifo, block_t *p_block )
 
 void block_FifoWake( block_fifo_t *p_fifo )
 {
+    if( p_fifo->b_spsc )
+    {
+        vlc_mutex_lock( &p_fifo->lock );
+        if( FifoSPSCDepth( p_fifo ) == 0 )
+            vlc_atomic_set( &p_fifo->force_wake, 1 );
+        vlc_cond_broadcast( &p_fifo->wait );
+        vlc_mutex_unlock( &p_fifo->lock );
+        return;
+    }
+
     vlc_mutex_lock( &p_fifo->lock );
     if( p_fifo->p_first == NULL )
         p_fifo->b_force_wake = true;
@@ -632,6 +1129,134 @@ void block_FifoWake( block_fifo_t *p_fifo )
     vlc_mutex_unlock( &p_fifo->lock );
 }
 
+static void FifoGetCleanup( void *data )
+{
+    block_fifo_t *p_fifo = data;
+
+    vlc_atomic_set( &p_fifo->getter_waits, 0 );
+    vlc_mutex_unlock( &p_fifo->lock );
+}
+
+static void FifoSPSCRoom( block_fifo_t *p_fifo )
+{
+    /* either a pacing putter sees the room or we see it waiting */
+    if( vlc_atomic_get( &p_fifo->putters_wait ) )
+    {
+        vlc_mutex_lock( &p_fifo->lock );
+        vlc_cond_broadcast( &p_fifo->wait_room );
+        vlc_mutex_unlock( &p_fifo->lock );
+    }
+}
+
+/* Moves what was put behind p_out, oldest first */
+static void FifoSPSCRefill( block_fifo_t *p_fifo )
+{
+    uintptr_t i_incoming = vlc_atomic_swap( &p_fifo->incoming, 0 );
+    block_t *b = (block_t *)i_incoming;
+    block_t *p_new = NULL;
+
+    while( b != NULL && b != FIFO_EMPTIED )
+    {
+        block_t *next = b->p_next;
+        b->p_next = p_new;
+        p_new = b;
+        b = next;
+    }
+
+    if( b == FIFO_EMPTIED )
+    {   /* what we held was put before block_FifoEmpty() */
+        for( b = p_fifo->p_out; b != NULL; b = b->p_next )
+        {
+            p_fifo->got_depth++;
+            p_fifo->got_size += b->i_buffer;
+        }
+        BlockChainRelease( p_fifo->p_out );
+        p_fifo->p_out = NULL;
+        FifoSPSCRoom( p_fifo );
+    }
+
+    block_t **pp_last = &p_fifo->p_out;
+    while( *pp_last != NULL )
+        pp_last = &(*pp_last)->p_next;
+    *pp_last = p_new;
+}
+
+/* Getter side of a lock-free FIFO: the first block, left in p_out. If
+ * necessary, wait until there is one, or return NULL if b_wakeable and
+ * block_FifoWake() was called. */
+static block_t *FifoSPSCFirst( block_fifo_t *p_fifo, bool b_wakeable )
+{
+    if( likely(p_fifo->p_out != NULL) && likely(!p_fifo->flush.u) )
+        return p_fifo->p_out;
+
+    /* cleared first, so block_FifoEmpty() leaves a new mark if it comes
+     * again while we look */
+    if( p_fifo->flush.u )
+        vlc_atomic_set( &p_fifo->flush, 0 );
+    if( p_fifo->incoming.u != 0 )
+        FifoSPSCRefill( p_fifo );
+
+    while( p_fifo->p_out == NULL )
+    {
+        if( b_wakeable && p_fifo->force_wake.u )
+            break;
+
+        vlc_mutex_lock( &p_fifo->lock );
+        vlc_cleanup_push( FifoGetCleanup, p_fifo );
+        /* a put either sees us waiting or we see its blocks */
+        vlc_atomic_set( &p_fifo->getter_waits, 1 );
+        while( p_fifo->incoming.u == 0
+            && !(b_wakeable && p_fifo->force_wake.u) )
+            vlc_cond_wait( &p_fifo->wait, &p_fifo->lock );
+        vlc_cleanup_run();
+
+        if( p_fifo->incoming.u != 0 )
+            FifoSPSCRefill( p_fifo );
+    }
+    if( b_wakeable && p_fifo->force_wake.u )
+        vlc_atomic_set( &p_fifo->force_wake, 0 );
+    return p_fifo->p_out;
+}
+
+/* Cuts the head of a chain, at least its first block, then up to
+ * max_blocks and max_bytes. Returns the last block taken. */
+static block_t *BlockChainCut( block_t *b, size_t max_blocks,
+                               size_t max_bytes, size_t *pi_depth,
+                               size_t *pi_size )
+{
+    size_t i_depth = 1, i_size = b->i_buffer;
+
+    while( b->p_next != NULL && i_depth < max_blocks
+        && i_size <= max_bytes
+        && b->p_next->i_buffer <= max_bytes - i_size )
+    {
+        b = b->p_next;
+        i_depth++;
+        i_size += b->i_buffer;
+    }
+    *pi_depth = i_depth;
+    *pi_size = i_size;
+    return b;
+}
+
+static block_t *FifoSPSCGetUpTo( block_fifo_t *p_fifo, size_t max_blocks,
+                                 size_t max_bytes )
+{
+    size_t i_depth, i_size;
+    block_t *b = FifoSPSCFirst( p_fifo, true );
+    if( b == NULL )
+        return NULL;
+
+    block_t *p_last = BlockChainCut( b, max_blocks, max_bytes,
+                                     &i_depth, &i_size );
+    p_fifo->p_out = p_last->p_next;
+    p_last->p_next = NULL;
+    p_fifo->got_depth += i_depth;
+    p_fifo->got_size += i_size;
+    FifoSPSCRoom( p_fifo );
+    return b;
+}
+
 /**
  * Dequeue the first block from the FIFO. If necessary, wait until there is
  * one block in the queue. This function is (always) cancellation point.
@@ -640,10 +1265,29 @@ void block_FifoWake( block_fifo_t *p_fifo )
  */
 block_t *block_FifoGet( block_fifo_t *p_fifo )
 {
-    block_t *b;
+    return block_FifoGetUpTo( p_fifo, 1, SIZE_MAX );
+}
+
+/**
+ * Dequeue the first blocks from the FIFO as a chain, under a single lock:
+ * the first block whatever its size, then as many as follow within
+ * max_blocks and max_bytes. As block_FifoGet(), wait until there is one
+ * block in the queue. This function is (always) cancellation point.
+ *
+ * @return a chain of at least one block, or NULL if block_FifoWake() was
+ * called.
+ */
+block_t *block_FifoGetUpTo( block_fifo_t *p_fifo, size_t max_blocks,
+                            size_t max_bytes )
+{
+    block_t *b, *p_last;
+    size_t i_depth, i_size;
 
     vlc_testcancel( );
 
+    if( p_fifo->b_spsc )
+        return FifoSPSCGetUpTo( p_fifo, max_blocks, max_bytes );
+
     vlc_mutex_lock( &p_fifo->lock );
     mutex_cleanup_push( &p_fifo->lock );
 
@@ -663,9 +1307,10 @@ block_t *block_FifoGet( block_fifo_t *p_fifo )
         return NULL;
     }
 
-    p_fifo->p_first = b->p_next;
-    p_fifo->i_depth--;
-    p_fifo->i_size -= b->i_buffer;
+    p_last = BlockChainCut( b, max_blocks, max_bytes, &i_depth, &i_size );
+    p_fifo->p_first = p_last->p_next;
+    p_fifo->i_depth -= i_depth;
+    p_fifo->i_size -= i_size;
 
     if( p_fifo->p_first == NULL )
     {
@@ -676,7 +1321,7 @@ block_t *block_FifoGet( block_fifo_t *p_fifo )
     vlc_cond_broadcast( &p_fifo->wait_room );
     vlc_mutex_unlock( &p_fifo->lock );
 
-    b->p_next = NULL;
+    p_last->p_next = NULL;
     return b;
 }
 
@@ -697,6 +1342,9 @@ block_t *block_FifoShow( block_fifo_t *p_fifo )
 
     vlc_testcancel( );
 
+    if( p_fifo->b_spsc )
+        return FifoSPSCFirst( p_fifo, false );
+
     vlc_mutex_lock( &p_fifo->lock );
     mutex_cleanup_push( &p_fifo->lock );
 
@@ -712,11 +1360,15 @@ block_t *block_FifoShow( block_fifo_t *p_fifo )
 /* FIXME: not thread-safe */
 size_t block_FifoSize( const block_fifo_t *p_fifo )
 {
+    if( p_fifo->b_spsc )
+        return FifoSPSCSize( p_fifo );
     return p_fifo->i_size;
 }
 
 /* FIXME: not thread-safe */
 size_t block_FifoCount( const block_fifo_t *p_fifo )
 {
+    if( p_fifo->b_spsc )
+        return FifoSPSCDepth( p_fifo );
     return p_fifo->i_depth;
 }
@@ -47,6 +47,10 @@
 #include <sys/sysctl.h>
 #endif
 
+#if defined (__aarch64__) && defined (__linux__)
+#include <sys/auxv.h>
+#endif
+
 #if defined(__OpenBSD__) && defined(__powerpc__)
 #include <sys/param.h>
 #include <sys/sysctl.h>
@@ -144,6 +148,67 @@ static void Altivec_test (void)
 #endif
 #endif
 
+/* Instruction sets, each tier including the ones above it */
+static const struct
+{
+    char     name[8];
+    uint32_t flags;
+} cpu_tiers[] = {
+#if defined (__i386__) || defined (__x86_64__)
+    { "mmx",    CPU_CAPABILITY_MMX },
+    { "mmxext", CPU_CAPABILITY_MMXEXT },
+    { "sse",    CPU_CAPABILITY_SSE },
+    { "sse2",   CPU_CAPABILITY_SSE2 },
+    { "sse3",   CPU_CAPABILITY_SSE3 },
+    { "ssse3",  CPU_CAPABILITY_SSSE3 },
+    { "sse4.1", CPU_CAPABILITY_SSE4_1 },
+    { "sse4.2", CPU_CAPABILITY_SSE4_2 },
+    { "avx",    CPU_CAPABILITY_AVX },
+    { "avx2",   CPU_CAPABILITY_AVX2 },
+    { "avx512", CPU_CAPABILITY_AVX512 },
+#elif defined (__arm__)
+    { "neon",   CPU_CAPABILITY_NEON },
+#elif defined (__aarch64__)
+    { "neon",   CPU_CAPABILITY_NEON },
+    { "sve",    CPU_CAPABILITY_SVE },
+#elif defined (__powerpc__) || defined (__ppc__) || defined (__ppc64__)
+    { "altivec", CPU_CAPABILITY_ALTIVEC },
+#endif
+};
+
+/**
+ * Limits the capabilities to the tier named by the VLC_CPU environment
+ * variable, so that the lower tiers can be tested on recent CPUs. The
+ * capabilities outside of the tiers (3DNow!, SSE4A) are dropped too.
+ */
+static uint32_t CPU_Override (uint32_t flags)
+{
+    const char *tier = getenv ("VLC_CPU");
+    if (tier == NULL || *tier == '\0')
+        return flags;
+
+    const size_t count = sizeof (cpu_tiers) / sizeof (cpu_tiers[0]);
+    uint32_t mask = 0;
+
+    if (strcmp (tier, "none"))
+    {
+        size_t i;
+
+        for (i = 0; i < count; i++)
+        {
+            mask |= cpu_tiers[i].flags;
+            if (!strcmp (cpu_tiers[i].name, tier))
+                break;
+        }
+        if (i == count)
+        {
+            fprintf (stderr, "Warning: unknown CPU tier \"%s\"\n", tier);
+            return flags;
+        }
+    }
+    return flags & mask;
+}
+
 /**
  * Determines the CPU capabilities and stores them in cpu_flags.
  * The result can be retrieved with vlc_CPU().
@@ -163,13 +228,13 @@ void vlc_CPU_init (void)
                    "cpuid\n\t" \
                    "xchgl %%ebx,%1\n\t" \
                    : "=a" (i_eax), "=r" (i_ebx), "=c" (i_ecx), "=d" (i_edx) \
-                   : "a" (reg) \
+                   : "a" (reg), "c" (0) \
                    : "cc");
 # else
 #  define cpuid(reg) \
      asm volatile ("cpuid\n\t" \
                    : "=a" (i_eax), "=b" (i_ebx), "=c" (i_ecx), "=d" (i_edx) \
-                   : "a" (reg) \
+                   : "a" (reg), "c" (0) \
                    : "cc");
 # endif
      /* Check if the OS really supports the requested instructions */
@@ -268,6 +333,39 @@ void vlc_CPU_init (void)
         i_capabilities |= CPU_CAPABILITY_SSE4_2;
 # endif
 
+    /* AVX and later need the OS to save the YMM (and ZMM) registers:
+     * OSXSAVE and AVX bits, then XCR0 */
+    if ((i_ecx & 0x18000000) == 0x18000000)
+    {
+        unsigned int i_xcr0, i_xcr0_high;
+
+        asm volatile (".byte 0x0f, 0x01, 0xd0\n" /* xgetbv */
+                      : "=a" (i_xcr0), "=d" (i_xcr0_high) : "c" (0));
+        (void) i_xcr0_high;
+        if ((i_xcr0 & 0x06) == 0x06)
+        {
+            i_capabilities |= CPU_CAPABILITY_AVX;
+
+            cpuid( 0x00000000 );
+            if (i_eax >= 7)
+            {
+                cpuid( 0x00000007 );
+                if (i_ebx & 0x00000020)
+                    i_capabilities |= CPU_CAPABILITY_AVX2;
+                /* AVX-512 F and BW, with the opmask and ZMM states */
+                if ((i_ebx & 0x40010000) == 0x40010000
+                 && (i_xcr0 & 0xE6) == 0xE6)
+                    i_capabilities |= CPU_CAPABILITY_AVX512;
+            }
+        }
+    }
+# if defined (__AVX__)
+    i_capabilities |= CPU_CAPABILITY_AVX;
+# endif
+# if defined (__AVX2__)
+    i_capabilities |= CPU_CAPABILITY_AVX2;
+# endif
+
     /* test for additional capabilities */
     cpuid( 0x80000000 );
 
@@ -329,6 +427,17 @@ out:
 #  endif
 # endif
 
+#elif defined (__aarch64__)
+    /* Advanced SIMD is mandatory */
+    i_capabilities |= CPU_CAPABILITY_NEON;
+
+# if defined (__ARM_FEATURE_SVE)
+    i_capabilities |= CPU_CAPABILITY_SVE;
+# elif defined (__linux__)
+    if (getauxval (AT_HWCAP) & (1 << 22)) /* HWCAP_SVE */
+        i_capabilities |= CPU_CAPABILITY_SVE;
+# endif
+
 #elif defined( __powerpc__ ) || defined( __ppc__ ) || defined( __powerpc64__ ) \
     || defined( __ppc64__ )
 
@@ -353,7 +462,7 @@ out:
 
 #endif
 
-    cpu_flags = i_capabilities;
+    cpu_flags = CPU_Override (i_capabilities);
 }
 
 /**
@@ -390,6 +499,9 @@ void vlc_CPU_dump (vlc_object_t *obj)
     PRINT_CAPABILITY(CPU_CAPABILITY_SSE4_1, "SSE4.1");
     PRINT_CAPABILITY(CPU_CAPABILITY_SSE4_2, "SSE4.2");
     PRINT_CAPABILITY(CPU_CAPABILITY_SSE4A,  "SSE4A");
+    PRINT_CAPABILITY(CPU_CAPABILITY_AVX,    "AVX");
+    PRINT_CAPABILITY(CPU_CAPABILITY_AVX2,   "AVX2");
+    PRINT_CAPABILITY(CPU_CAPABILITY_AVX512, "AVX-512");
 
 #elif defined (__powerpc__) || defined (__ppc__) || defined (__ppc64__)
     PRINT_CAPABILITY(CPU_CAPABILITY_ALTIVEC, "AltiVec");
@@ -397,6 +509,10 @@ void vlc_CPU_dump (vlc_object_t *obj)
 #elif defined (__arm__)
     PRINT_CAPABILITY(CPU_CAPABILITY_NEON, "NEONv1");
 
+#elif defined (__aarch64__)
+    PRINT_CAPABILITY(CPU_CAPABILITY_NEON, "NEON");
+    PRINT_CAPABILITY(CPU_CAPABILITY_SVE, "SVE");
+
 #endif
 
 #if HAVE_FPU
@@ -416,10 +532,107 @@ void vlc_fastmem_register (vlc_memcpy_t cpy)
     pf_vlc_memcpy = cpy;
 }
 
+#if defined (HAVE_SSE2_INTRINSICS) || defined (CAN_COMPILE_AVX2)
+# include <immintrin.h>
+
+/* Copies the unaligned head with memcpy, so that the stores are aligned */
+static size_t StreamHead (void *tgt, const void *src, size_t n, size_t align)
+{
+    size_t head = __MIN(-(uintptr_t)tgt & (align - 1), n);
+
+    memcpy (tgt, src, head);
+    return head;
+}
+#endif
+
+#if defined (HAVE_SSE2_INTRINSICS)
+VLC_SSE2
+static void *StreamCopySSE2 (void *tgt, const void *src, size_t n)
+{
+    uint8_t *dst = tgt;
+    const uint8_t *s = src;
+    size_t i = StreamHead (dst, s, n, 16);
+
+    for (; i + 64 <= n; i += 64)
+    {
+        __m128i a = _mm_loadu_si128 ((const __m128i *)(s + i));
+        __m128i b = _mm_loadu_si128 ((const __m128i *)(s + i + 16));
+        __m128i c = _mm_loadu_si128 ((const __m128i *)(s + i + 32));
+        __m128i d = _mm_loadu_si128 ((const __m128i *)(s + i + 48));
+        _mm_stream_si128 ((__m128i *)(dst + i), a);
+        _mm_stream_si128 ((__m128i *)(dst + i + 16), b);
+        _mm_stream_si128 ((__m128i *)(dst + i + 32), c);
+        _mm_stream_si128 ((__m128i *)(dst + i + 48), d);
+    }
+    _mm_sfence ();
+    memcpy (dst + i, s + i, n - i);
+    return tgt;
+}
+#endif
+
+#if defined (CAN_COMPILE_AVX2)
+VLC_AVX
+static void *StreamCopyAVX (void *tgt, const void *src, size_t n)
+{
+    uint8_t *dst = tgt;
+    const uint8_t *s = src;
+    size_t i = StreamHead (dst, s, n, 32);
+
+    for (; i + 128 <= n; i += 128)
+    {
+        __m256i a = _mm256_loadu_si256 ((const __m256i *)(s + i));
+        __m256i b = _mm256_loadu_si256 ((const __m256i *)(s + i + 32));
+        __m256i c = _mm256_loadu_si256 ((const __m256i *)(s + i + 64));
+        __m256i d = _mm256_loadu_si256 ((const __m256i *)(s + i + 96));
+        _mm256_stream_si256 ((__m256i *)(dst + i), a);
+        _mm256_stream_si256 ((__m256i *)(dst + i + 32), b);
+        _mm256_stream_si256 ((__m256i *)(dst + i + 64), c);
+        _mm256_stream_si256 ((__m256i *)(dst + i + 96), d);
+    }
+    _mm_sfence ();
+    _mm256_zeroupper ();
+    memcpy (dst + i, s + i, n - i);
+    return tgt;
+}
+#endif
+
+/* Falls back to the memcpy plugin, if any, for old CPUs */
+static void *StreamCopy (void *tgt, const void *src, size_t n)
+{
+    return pf_vlc_memcpy (tgt, src, n);
+}
+
+static const struct
+{
+    vlc_memcpy_t func;
+    unsigned     cpu;
+} stream_copies[] = {
+#if defined (CAN_COMPILE_AVX2)
+    { StreamCopyAVX,  CPU_CAPABILITY_AVX },
+#endif
+#if defined (HAVE_SSE2_INTRINSICS)
+    { StreamCopySSE2, CPU_CAPABILITY_SSE2 },
+#endif
+    { StreamCopy,     0 },
+};
+
+/**
+ * Copies a large buffer, bypassing the caches if possible.
+ * This is meant for the lines of a picture, which are small on their own
+ * but add up to more than the caches.
+ */
+void *vlc_memcpy_stream (void *tgt, const void *src, size_t n)
+{
+    return vlc_CPU_select (stream_copies) (tgt, src, n);
+}
+
 /**
  * vlc_memcpy: fast CPU-dependent memcpy
+ * The C library is best for small copies. Large ones are streamed to memory.
  */
 void *vlc_memcpy (void *tgt, const void *src, size_t n)
 {
-    return pf_vlc_memcpy (tgt, src, n);
+    if (n < VLC_MEMCPY_STREAM_MIN)
+        return memcpy (tgt, src, n);
+    return vlc_memcpy_stream (tgt, src, n);
 }
@@ -0,0 +1,322 @@
+/*****************************************************************************
+ * executor.c: thread pool running tasks
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_executor.h>
+#include "libvlc.h"
+
+/* Tasks are expected to be coarse (decoding a picture, preparsing an item),
+ * so all the queues share one lock, rather than using lock-free deques. */
+
+typedef struct
+{
+    vlc_executor_t *p_owner;
+    vlc_thread_t    thread;
+    vlc_cond_t      wait;       /**< signaled when a task is queued */
+    bool            b_idle;
+    bool            b_canceled; /**< p_current was canceled */
+    vlc_task_t     *p_current;  /**< running task (never dereferenced) */
+
+    /* Queued tasks, by priority */
+    vlc_task_t     *p_first[VLC_TASK_PRIORITIES];
+    vlc_task_t    **pp_last[VLC_TASK_PRIORITIES];
+} executor_worker_t;
+
+struct vlc_executor_t
+{
+    vlc_mutex_t lock;
+    vlc_cond_t  wait_done;      /**< signaled when a task ends */
+    int         i_priority;
+    bool        b_exit;
+    unsigned    i_next;         /**< next queue for tasks without affinity */
+    unsigned    i_started;
+    unsigned    i_threads;
+    executor_worker_t workers[];
+};
+
+static void *Thread( void * );
+
+vlc_executor_t *vlc_executor_New( unsigned i_threads, int i_priority )
+{
+    if( i_threads == 0 )
+        i_threads = vlc_GetCPUCount();
+    if( i_threads == 0 )
+        i_threads = 1;
+
+    vlc_executor_t *p_exec = malloc( sizeof(*p_exec)
+                                   + i_threads * sizeof(*p_exec->workers) );
+    if( unlikely(p_exec == NULL) )
+        return NULL;
+
+    vlc_mutex_init( &p_exec->lock );
+    vlc_cond_init( &p_exec->wait_done );
+    p_exec->i_priority = i_priority;
+    p_exec->b_exit = false;
+    p_exec->i_next = 0;
+    p_exec->i_started = 0;
+    p_exec->i_threads = i_threads;
+
+    for( unsigned i = 0; i < i_threads; i++ )
+    {
+        executor_worker_t *p_worker = &p_exec->workers[i];
+
+        p_worker->p_owner = p_exec;
+        vlc_cond_init( &p_worker->wait );
+        p_worker->b_idle = false;
+        p_worker->b_canceled = false;
+        p_worker->p_current = NULL;
+        for( int j = 0; j < VLC_TASK_PRIORITIES; j++ )
+        {
+            p_worker->p_first[j] = NULL;
+            p_worker->pp_last[j] = &p_worker->p_first[j];
+        }
+    }
+    return p_exec;
+}
+
+void vlc_executor_Delete( vlc_executor_t *p_exec )
+{
+    vlc_mutex_lock( &p_exec->lock );
+    p_exec->b_exit = true;
+    for( unsigned i = 0; i < p_exec->i_threads; i++ )
+    {
+        executor_worker_t *p_worker = &p_exec->workers[i];
+
+        for( int j = 0; j < VLC_TASK_PRIORITIES; j++ )
+        {
+            for( vlc_task_t *p_task = p_worker->p_first[j];
+                 p_task != NULL; p_task = p_task->p_next )
+                p_task->b_queued = false;
+            p_worker->p_first[j] = NULL;
+            p_worker->pp_last[j] = &p_worker->p_first[j];
+        }
+        vlc_cond_signal( &p_worker->wait );
+    }
+    vlc_mutex_unlock( &p_exec->lock );
+
+    for( unsigned i = 0; i < p_exec->i_started; i++ )
+        vlc_join( p_exec->workers[i].thread, NULL );
+    for( unsigned i = 0; i < p_exec->i_threads; i++ )
+        vlc_cond_destroy( &p_exec->workers[i].wait );
+
+    vlc_cond_destroy( &p_exec->wait_done );
+    vlc_mutex_destroy( &p_exec->lock );
+    free( p_exec );
+}
+
+#undef vlc_executor_Get
+vlc_executor_t *vlc_executor_Get( vlc_object_t *p_obj )
+{
+    return libvlc_priv( p_obj->p_libvlc )->executor;
+}
+
+unsigned vlc_executor_GetThreadCount( vlc_executor_t *p_exec )
+{
+    return p_exec->i_threads;
+}
+
+/* Must be called with the lock held */
+static int StartWorker( vlc_executor_t *p_exec )
+{
+    executor_worker_t *p_worker = &p_exec->workers[p_exec->i_started];
+
+    if( vlc_clone( &p_worker->thread, Thread, p_worker, p_exec->i_priority ) )
+        return VLC_EGENERIC;
+    p_exec->i_started++;
+    return VLC_SUCCESS;
+}
+
+int vlc_executor_Submit( vlc_executor_t *p_exec, vlc_task_t *p_task )
+{
+    assert( p_task->i_priority >= 0
+         && p_task->i_priority < VLC_TASK_PRIORITIES );
+
+    vlc_mutex_lock( &p_exec->lock );
+    assert( !p_task->b_queued );
+
+    /* Start a thread if all are busy */
+    bool b_idle = false;
+    for( unsigned i = 0; i < p_exec->i_started && !b_idle; i++ )
+        b_idle = p_exec->workers[i].b_idle;
+    if( !b_idle && p_exec->i_started < p_exec->i_threads
+     && StartWorker( p_exec ) && p_exec->i_started == 0 )
+    {
+        vlc_mutex_unlock( &p_exec->lock );
+        return VLC_EGENERIC;
+    }
+
+    unsigned i_queue;
+    if( p_task->i_affinity >= 0 )
+        i_queue = p_task->i_affinity % p_exec->i_threads;
+    else
+        i_queue = p_exec->i_next++ % p_exec->i_started;
+
+    executor_worker_t *p_worker = &p_exec->workers[i_queue];
+    p_task->p_next = NULL;
+    p_task->i_queue = i_queue;
+    p_task->b_queued = true;
+    *p_worker->pp_last[p_task->i_priority] = p_task;
+    p_worker->pp_last[p_task->i_priority] = &p_task->p_next;
+
+    /* Wake up the owner of the queue, or else any idle thread to steal it */
+    if( i_queue >= p_exec->i_started || !p_worker->b_idle )
+        for( unsigned i = 0; i < p_exec->i_started; i++ )
+            if( p_exec->workers[i].b_idle )
+            {
+                p_worker = &p_exec->workers[i];
+                break;
+            }
+    if( p_worker->b_idle )
+    {
+        p_worker->b_idle = false;
+        vlc_cond_signal( &p_worker->wait );
+    }
+    vlc_mutex_unlock( &p_exec->lock );
+    return VLC_SUCCESS;
+}
+
+/* Must be called with the lock held */
+static void Dequeue( vlc_executor_t *p_exec, vlc_task_t *p_task )
+{
+    executor_worker_t *p_worker = &p_exec->workers[p_task->i_queue];
+    vlc_task_t **pp = &p_worker->p_first[p_task->i_priority];
+
+    while( *pp != p_task )
+        pp = &(*pp)->p_next;
+    *pp = p_task->p_next;
+    if( p_worker->pp_last[p_task->i_priority] == &p_task->p_next )
+        p_worker->pp_last[p_task->i_priority] = pp;
+    p_task->b_queued = false;
+}
+
+/* Must be called with the lock held */
+static executor_worker_t *FindRunning( vlc_executor_t *p_exec,
+                                       const vlc_task_t *p_task )
+{
+    for( unsigned i = 0; i < p_exec->i_started; i++ )
+        if( p_exec->workers[i].p_current == p_task )
+            return &p_exec->workers[i];
+    return NULL;
+}
+
+bool vlc_executor_Cancel( vlc_executor_t *p_exec, vlc_task_t *p_task )
+{
+    executor_worker_t *p_worker;
+    bool b_removed = false;
+
+    vlc_mutex_lock( &p_exec->lock );
+    if( p_task->b_queued )
+    {
+        Dequeue( p_exec, p_task );
+        b_removed = true;
+    }
+    else
+    {
+        if( (p_worker = FindRunning( p_exec, p_task )) != NULL )
+            p_worker->b_canceled = true;
+        while( FindRunning( p_exec, p_task ) != NULL )
+            vlc_cond_wait( &p_exec->wait_done, &p_exec->lock );
+    }
+    vlc_mutex_unlock( &p_exec->lock );
+    return b_removed;
+}
+
+void vlc_executor_Wait( vlc_executor_t *p_exec, vlc_task_t *p_task )
+{
+    vlc_mutex_lock( &p_exec->lock );
+    while( p_task->b_queued || FindRunning( p_exec, p_task ) != NULL )
+        vlc_cond_wait( &p_exec->wait_done, &p_exec->lock );
+    vlc_mutex_unlock( &p_exec->lock );
+}
+
+bool vlc_executor_IsCanceled( vlc_executor_t *p_exec, vlc_task_t *p_task )
+{
+    vlc_mutex_lock( &p_exec->lock );
+    executor_worker_t *p_worker = FindRunning( p_exec, p_task );
+    bool b_canceled = p_worker != NULL && p_worker->b_canceled;
+    vlc_mutex_unlock( &p_exec->lock );
+    return b_canceled;
+}
+
+/* Takes the first task of the highest priority, from the own queue of the
+ * worker or else from the others. Must be called with the lock held. */
+static vlc_task_t *Pick( executor_worker_t *p_self )
+{
+    vlc_executor_t *p_exec = p_self->p_owner;
+    const unsigned i_self = p_self - p_exec->workers;
+
+    for( int i_prio = VLC_TASK_PRIORITIES - 1; i_prio >= 0; i_prio-- )
+        for( unsigned i = 0; i < p_exec->i_threads; i++ )
+        {
+            const unsigned i_queue = (i_self + i) % p_exec->i_threads;
+            vlc_task_t *p_task = p_exec->workers[i_queue].p_first[i_prio];
+
+            if( p_task != NULL )
+            {
+                Dequeue( p_exec, p_task );
+                return p_task;
+            }
+        }
+    return NULL;
+}
+
+static void *Thread( void *data )
+{
+    executor_worker_t *p_self = data;
+    vlc_executor_t *p_exec = p_self->p_owner;
+
+    vlc_mutex_lock( &p_exec->lock );
+    while( !p_exec->b_exit )
+    {
+        vlc_task_t *p_task = Pick( p_self );
+        if( p_task == NULL )
+        {
+            p_self->b_idle = true;
+            vlc_cond_wait( &p_self->wait, &p_exec->lock );
+            p_self->b_idle = false;
+            continue;
+        }
+
+        /* The task may be freed or submitted again by its own function */
+        void (*pf_run)( void * ) = p_task->pf_run;
+        void *p_data = p_task->p_data;
+
+        p_self->p_current = p_task;
+        p_self->b_canceled = false;
+        vlc_mutex_unlock( &p_exec->lock );
+
+        int canc = vlc_savecancel();
+        pf_run( p_data );
+        vlc_restorecancel( canc );
+
+        vlc_mutex_lock( &p_exec->lock );
+        p_self->p_current = NULL;
+        vlc_cond_broadcast( &p_exec->wait_done );
+    }
+    vlc_mutex_unlock( &p_exec->lock );
+    return NULL;
+}
@@ -28,6 +28,7 @@
 #include <vlc_filter.h>
 #include <vlc_osd.h>
 #include <vlc_modules.h>
+#include <vlc_tracer.h>
 #include <libvlc.h>
 #include <assert.h>
 
@@ -83,6 +84,7 @@ struct filter_chain_t
     es_format_t fmt_out; /**< Chain current output format */
     unsigned length; /**< Number of filters */
     bool b_allow_fmt_out_change; /**< Can the output format be changed? */
+    filter_slice_pool_t *p_slice_pool; /**< Workers of the sliced filters */
     char psz_capability[1]; /**< Module capability for all chained filters */
 };
 
@@ -101,6 +103,9 @@ static int UpdateBufferFunctions( filter_chain_t * );
 
 static void FilterDeletePictures( filter_t *, picture_t * );
 
+static filter_slice_pool_t *SlicePoolNew( unsigned );
+static void SlicePoolDelete( filter_slice_pool_t * );
+
 #undef filter_chain_New
 /**
  * Filter chain initialisation
@@ -128,6 +133,7 @@ filter_chain_t *filter_chain_New( vlc_object_t *p_this,
     es_format_Init( &p_chain->fmt_in, UNKNOWN_ES, 0 );
     es_format_Init( &p_chain->fmt_out, UNKNOWN_ES, 0 );
     p_chain->b_allow_fmt_out_change = b_allow_fmt_out_change;
+    p_chain->p_slice_pool = NULL;
 
     p_chain->allocator.pf_init = pf_buffer_allocation_init;
     p_chain->allocator.pf_clean = pf_buffer_allocation_clean;
@@ -143,6 +149,9 @@ void filter_chain_Delete( filter_chain_t *p_chain )
 {
     filter_chain_Reset( p_chain, NULL, NULL );
 
+    if( p_chain->p_slice_pool )
+        SlicePoolDelete( p_chain->p_slice_pool );
+
     es_format_Clean( &p_chain->fmt_in );
     es_format_Clean( &p_chain->fmt_out );
 
@@ -229,7 +238,9 @@ static picture_t *FilterChainVideoFilter( chained_filter_t *f, picture_t *p_pic
     for( ; f != NULL; f = f->next )
     {
         filter_t *p_filter = &f->filter;
+        VLC_TRACE_BEGIN( "video filter" );
         p_pic = p_filter->pf_video_filter( p_filter, p_pic );
+        VLC_TRACE_END( "video filter" );
         if( !p_pic )
             break;
         if( f->pending )
@@ -402,6 +413,21 @@ static filter_t *filter_chain_AppendFilterInternal( filter_chain_t *p_chain,
     if( !p_filter->p_module )
         goto error;
 
+    if( p_filter->b_slice_threads )
+    {
+        if( !p_chain->p_slice_pool )
+        {
+            unsigned i_threads = var_InheritInteger( p_chain->p_this,
+                                                     "filter-threads" );
+            if( i_threads == 0 )
+                i_threads = vlc_GetCPUCount();
+            /* The calling thread processes a slice too */
+            if( i_threads > 1 )
+                p_chain->p_slice_pool = SlicePoolNew( i_threads - 1 );
+        }
+        p_filter->p_slice_pool = p_chain->p_slice_pool;
+    }
+
     if( p_filter->b_allow_fmt_out_change )
     {
         es_format_Clean( &p_chain->fmt_out );
@@ -640,3 +666,146 @@ static void AllocatorClean( const filter_chain_allocator_t *p_alloc,
         p_alloc->pf_clean( &p_filter->filter );
 }
 
+/* Slice threading */
+struct filter_slice_pool_t
+{
+    vlc_mutex_t lock;
+    vlc_cond_t  wait_job;
+    vlc_cond_t  wait_done;
+    bool        b_exit;
+    unsigned    i_generation;
+
+    /* Current job */
+    filter_t          *p_filter;
+    filter_slice_cb_t pf_slice;
+    void              *p_data;
+    int               i_slice_count;
+    int               i_next_slice;
+    int               i_done;
+
+    unsigned     i_threads;
+    vlc_thread_t threads[];
+};
+
+/* Must be called with the pool lock held */
+static void SlicePoolRun( filter_slice_pool_t *p_pool )
+{
+    filter_t *p_filter = p_pool->p_filter;
+    filter_slice_cb_t pf_slice = p_pool->pf_slice;
+    void *p_data = p_pool->p_data;
+    const int i_slice_count = p_pool->i_slice_count;
+
+    while( p_pool->i_next_slice < i_slice_count )
+    {
+        const int i_slice = p_pool->i_next_slice++;
+
+        vlc_mutex_unlock( &p_pool->lock );
+        pf_slice( p_filter, p_data, i_slice, i_slice_count );
+        vlc_mutex_lock( &p_pool->lock );
+
+        if( ++p_pool->i_done == i_slice_count )
+            vlc_cond_signal( &p_pool->wait_done );
+    }
+}
+
+static void *SlicePoolThread( void *data )
+{
+    filter_slice_pool_t *p_pool = data;
+    unsigned i_generation = 0;
+
+    vlc_mutex_lock( &p_pool->lock );
+    for( ;; )
+    {
+        while( !p_pool->b_exit && p_pool->i_generation == i_generation )
+            vlc_cond_wait( &p_pool->wait_job, &p_pool->lock );
+        if( p_pool->b_exit )
+            break;
+        i_generation = p_pool->i_generation;
+
+        SlicePoolRun( p_pool );
+    }
+    vlc_mutex_unlock( &p_pool->lock );
+    return NULL;
+}
+
+static filter_slice_pool_t *SlicePoolNew( unsigned i_threads )
+{
+    filter_slice_pool_t *p_pool =
+        malloc( sizeof(*p_pool) + i_threads * sizeof(*p_pool->threads) );
+    if( !p_pool )
+        return NULL;
+
+    vlc_mutex_init( &p_pool->lock );
+    vlc_cond_init( &p_pool->wait_job );
+    vlc_cond_init( &p_pool->wait_done );
+    p_pool->b_exit = false;
+    p_pool->i_generation = 0;
+    p_pool->i_slice_count = 0;
+    p_pool->i_next_slice = 0;
+    p_pool->i_done = 0;
+
+    for( p_pool->i_threads = 0; p_pool->i_threads < i_threads; p_pool->i_threads++ )
+    {
+        if( vlc_clone( &p_pool->threads[p_pool->i_threads], SlicePoolThread,
+                       p_pool, VLC_THREAD_PRIORITY_VIDEO ) )
+            break;
+    }
+    if( p_pool->i_threads == 0 )
+    {
+        SlicePoolDelete( p_pool );
+        return NULL;
+    }
+    return p_pool;
+}
+
+static void SlicePoolDelete( filter_slice_pool_t *p_pool )
+{
+    vlc_mutex_lock( &p_pool->lock );
+    p_pool->b_exit = true;
+    vlc_cond_broadcast( &p_pool->wait_job );
+    vlc_mutex_unlock( &p_pool->lock );
+
+    for( unsigned i = 0; i < p_pool->i_threads; i++ )
+        vlc_join( p_pool->threads[i], NULL );
+
+    vlc_cond_destroy( &p_pool->wait_done );
+    vlc_cond_destroy( &p_pool->wait_job );
+    vlc_mutex_destroy( &p_pool->lock );
+    free( p_pool );
+}
+
+int filter_GetSliceCount( const filter_t *p_filter )
+{
+    filter_slice_pool_t *p_pool = p_filter->p_slice_pool;
+
+    return p_pool ? p_pool->i_threads + 1 : 1;
+}
+
+void filter_ExecuteSlices( filter_t *p_filter, filter_slice_cb_t pf_slice,
+                           void *p_data )
+{
+    filter_slice_pool_t *p_pool = p_filter->p_slice_pool;
+
+    if( !p_pool )
+    {
+        pf_slice( p_filter, p_data, 0, 1 );
+        return;
+    }
+
+    vlc_mutex_lock( &p_pool->lock );
+    assert( p_pool->i_done == p_pool->i_slice_count );
+    p_pool->p_filter = p_filter;
+    p_pool->pf_slice = pf_slice;
+    p_pool->p_data = p_data;
+    p_pool->i_slice_count = p_pool->i_threads + 1;
+    p_pool->i_next_slice = 0;
+    p_pool->i_done = 0;
+    p_pool->i_generation++;
+    vlc_cond_broadcast( &p_pool->wait_job );
+
+    /* The calling thread takes its share */
+    SlicePoolRun( p_pool );
+    while( p_pool->i_done < p_pool->i_slice_count )
+        vlc_cond_wait( &p_pool->wait_done, &p_pool->lock );
+    vlc_mutex_unlock( &p_pool->lock );
+}
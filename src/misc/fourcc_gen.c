@@ -0,0 +1,174 @@
+/*****************************************************************************
+ * fourcc_gen.c: generator of the fourcc tables
+ *****************************************************************************
+ * Copyright © 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * This tool runs on the build system, at build time. It writes the lists of
+ * fourcc_list.h as tables sorted by fourcc, each entry with its canonical
+ * fourcc and description, for fourcc.c to look them up by binary search.
+ * It must not depend on LibVLC nor on the configuration of the target.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define VLC_COMMON_H 1 /* not needed, and not for the build system */
+#define VLC_API
+typedef uint32_t vlc_fourcc_t;
+/* Characters in order, whatever the endianness of either system */
+#define VLC_FOURCC(a,b,c,d) { a, b, c, d }
+
+#include <vlc_fourcc.h>
+
+typedef struct
+{
+    unsigned char p_class[4];
+    unsigned char p_fourcc[4];
+    const char *psz_description;
+} entry_t;
+
+#define NULL4 { 0, 0, 0, 0 }
+
+/* Begin a new class */
+#define B(a, c) { .p_class = a, .p_fourcc = a, .psz_description = c }
+/* Create a sub-class entry with description */
+#define E(b, c) { .p_class = NULL4, .p_fourcc = b, .psz_description = c }
+/* Create a sub-class entry without description (alias) */
+#define A(b) E(b, "")
+
+#include "misc/fourcc_list.h"
+
+typedef struct
+{
+    const unsigned char *alias;
+    const unsigned char *fourcc;
+    const char *description;
+    size_t index; /* in the list, the first one wins */
+} mapping_t;
+
+static int cmp_mapping( const void *a, const void *b )
+{
+    const mapping_t *ma = a, *mb = b;
+    int val = memcmp( ma->alias, mb->alias, 4 );
+
+    if( val == 0 )
+        val = (ma->index > mb->index) - (ma->index < mb->index);
+    return val;
+}
+
+static void print_char( unsigned char c )
+{
+    if( c >= 0x20 && c < 0x7f && c != '\'' && c != '\\' )
+        printf( "'%c'", c );
+    else
+        printf( "'\\x%02x'", c );
+}
+
+static void print_fourcc( const unsigned char *p )
+{
+    for( unsigned i = 0; i < 4; i++ )
+    {
+        if( i > 0 )
+            fputs( ", ", stdout );
+        print_char( p[i] );
+    }
+}
+
+static void print_string( const char *psz )
+{
+    putchar( '"' );
+    for( const unsigned char *p = (const unsigned char *)psz; *p; p++ )
+    {
+        if( *p >= 0x20 && *p < 0x7f && *p != '"' && *p != '\\' )
+            putchar( *p );
+        else
+            printf( "\\%03o", *p );
+    }
+    putchar( '"' );
+}
+
+static int process_list( const char *name, const entry_t *list, size_t n )
+{
+    mapping_t *mappings = malloc( n * sizeof (*mappings) );
+    if( mappings == NULL )
+        return -1;
+
+    const entry_t *class = NULL;
+    size_t count = 0;
+
+    for( size_t i = 0; i < n; i++ )
+    {
+        const entry_t *e = &list[i];
+
+        if( memcmp( e->p_class, "\0\0\0\0", 4 ) )
+            class = e;
+        if( class == NULL )
+        {
+            fprintf( stderr, "%s: entry %zu before any class\n", name, i );
+            free( mappings );
+            return -1;
+        }
+
+        mappings[count].alias = e->p_fourcc;
+        mappings[count].fourcc = class->p_class;
+        mappings[count].description = e->psz_description
+                                      ? e->psz_description
+                                      : class->psz_description;
+        mappings[count].index = i;
+        count++;
+    }
+
+    qsort( mappings, count, sizeof (*mappings), cmp_mapping );
+
+    printf( "static const struct fourcc_mapping mapping_%s[] = {\n", name );
+    for( size_t i = 0; i < count; i++ )
+    {
+        const mapping_t *m = &mappings[i];
+
+        if( i > 0 && !memcmp( m->alias, mappings[i - 1].alias, 4 ) )
+            continue; /* duplicate: the linear search never saw it */
+
+        fputs( "    { { ", stdout );
+        print_fourcc( m->alias );
+        fputs( " }, VLC_FOURCC(", stdout );
+        print_fourcc( m->fourcc );
+        fputs( "), ", stdout );
+        print_string( m->description );
+        fputs( " },\n", stdout );
+    }
+    puts( "};\n" );
+    free( mappings );
+    return 0;
+}
+
+#define LIST(name) \
+    process_list( #name, p_list_##name, \
+                  sizeof (p_list_##name) / sizeof (p_list_##name[0]) )
+
+int main( void )
+{
+    puts( "/* This file is generated by fourcc_gen from fourcc_list.h."
+          " Do not edit. */\n" );
+    if( LIST(video) || LIST(audio) || LIST(spu) )
+        return 1;
+    return 0;
+}
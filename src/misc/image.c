@@ -220,6 +220,171 @@ static picture_t *ImageRead( image_handler_t *p_image, block_t *p_block,
     return p_pic;
 }
 
+/*
+ * Cache of the pictures last decoded from URLs, most recently used first.
+ * Slideshows, logos and album arts keep reloading the same few images: the
+ * file is still read, but an entry is reused, without decoding nor
+ * converting anything, when its encoded data and formats are unchanged.
+ */
+#define IMAGE_CACHE_ENTRIES 16
+#define IMAGE_CACHE_MAX_SIZE (32 << 20) /* bytes of decoded pixels */
+
+typedef struct
+{
+    char           *psz_url;
+    block_t        *p_data;     /* encoded image */
+    video_format_t  fmt_req;    /* requested output format */
+    video_format_t  fmt_out;    /* resulting output format */
+    picture_t      *p_pic;
+    size_t          i_size;     /* bytes of pixels */
+} image_cache_entry_t;
+
+struct image_cache_t
+{
+    vlc_mutex_t          lock;
+    image_cache_entry_t *pp_entries[IMAGE_CACHE_ENTRIES];
+    unsigned             i_entries;
+    size_t               i_size;
+};
+
+image_cache_t *image_CacheNew( void )
+{
+    image_cache_t *p_cache = malloc( sizeof(*p_cache) );
+    if( !p_cache )
+        return NULL;
+
+    vlc_mutex_init( &p_cache->lock );
+    p_cache->i_entries = 0;
+    p_cache->i_size = 0;
+    return p_cache;
+}
+
+static void CacheEntryDelete( image_cache_entry_t *p_entry )
+{
+    free( p_entry->psz_url );
+    block_Release( p_entry->p_data );
+    picture_Release( p_entry->p_pic );
+    free( p_entry );
+}
+
+void image_CacheDelete( image_cache_t *p_cache )
+{
+    for( unsigned i = 0; i < p_cache->i_entries; i++ )
+        CacheEntryDelete( p_cache->pp_entries[i] );
+    vlc_mutex_destroy( &p_cache->lock );
+    free( p_cache );
+}
+
+static bool CacheFormatEqual( const video_format_t *a,
+                              const video_format_t *b )
+{
+    return a->i_chroma == b->i_chroma &&
+           a->i_width == b->i_width && a->i_height == b->i_height &&
+           a->i_visible_width == b->i_visible_width &&
+           a->i_visible_height == b->i_visible_height &&
+           a->i_sar_num == b->i_sar_num && a->i_sar_den == b->i_sar_den;
+}
+
+static image_cache_t *CacheGet( image_handler_t *p_image )
+{
+    return libvlc_priv( p_image->p_parent->p_libvlc )->image_cache;
+}
+
+/* Returns a copy of the cached picture, or NULL */
+static picture_t *CacheFind( image_cache_t *p_cache, const char *psz_url,
+                             const block_t *p_data,
+                             video_format_t *p_fmt_out )
+{
+    picture_t *p_pic = NULL;
+
+    vlc_mutex_lock( &p_cache->lock );
+    for( unsigned i = 0; i < p_cache->i_entries; i++ )
+    {
+        image_cache_entry_t *p_entry = p_cache->pp_entries[i];
+
+        if( strcmp( p_entry->psz_url, psz_url ) ||
+            !CacheFormatEqual( &p_entry->fmt_req, p_fmt_out ) ||
+            p_entry->p_data->i_buffer != p_data->i_buffer ||
+            memcmp( p_entry->p_data->p_buffer, p_data->p_buffer,
+                    p_data->i_buffer ) )
+            continue;
+
+        p_pic = picture_NewFromFormat( &p_entry->p_pic->format );
+        if( p_pic )
+        {
+            picture_Copy( p_pic, p_entry->p_pic );
+            *p_fmt_out = p_entry->fmt_out;
+        }
+
+        /* Move it to the front */
+        memmove( &p_cache->pp_entries[1], &p_cache->pp_entries[0],
+                 i * sizeof(*p_cache->pp_entries) );
+        p_cache->pp_entries[0] = p_entry;
+        break;
+    }
+    vlc_mutex_unlock( &p_cache->lock );
+    return p_pic;
+}
+
+static void CachePut( image_cache_t *p_cache, const char *psz_url,
+                      block_t *p_data, const video_format_t *p_fmt_req,
+                      const video_format_t *p_fmt_out, picture_t *p_pic )
+{
+    image_cache_entry_t *p_entry = malloc( sizeof(*p_entry) );
+    if( !p_entry )
+        goto error;
+    p_entry->psz_url = strdup( psz_url );
+    if( !p_entry->psz_url )
+    {
+        free( p_entry );
+        goto error;
+    }
+    p_entry->p_data = p_data;
+    p_entry->fmt_req = *p_fmt_req;
+    p_entry->fmt_out = *p_fmt_out;
+    p_entry->p_pic = picture_Hold( p_pic );
+    p_entry->i_size = 0;
+    for( int i = 0; i < p_pic->i_planes; i++ )
+        p_entry->i_size += p_pic->p[i].i_pitch * p_pic->p[i].i_lines;
+
+    vlc_mutex_lock( &p_cache->lock );
+    /* Drop a previous version of the same image, then the least recently
+     * used ones until the new one fits */
+    for( unsigned i = 0; i < p_cache->i_entries; i++ )
+    {
+        image_cache_entry_t *p_old = p_cache->pp_entries[i];
+
+        if( strcmp( p_old->psz_url, psz_url ) ||
+            !CacheFormatEqual( &p_old->fmt_req, p_fmt_req ) )
+            continue;
+        p_cache->i_size -= p_old->i_size;
+        CacheEntryDelete( p_old );
+        memmove( &p_cache->pp_entries[i], &p_cache->pp_entries[i + 1],
+                 (--p_cache->i_entries - i) * sizeof(*p_cache->pp_entries) );
+        break;
+    }
+    while( p_cache->i_entries > 0 &&
+           ( p_cache->i_entries >= IMAGE_CACHE_ENTRIES ||
+             p_cache->i_size + p_entry->i_size > IMAGE_CACHE_MAX_SIZE ) )
+    {
+        image_cache_entry_t *p_old = p_cache->pp_entries[--p_cache->i_entries];
+
+        p_cache->i_size -= p_old->i_size;
+        CacheEntryDelete( p_old );
+    }
+
+    memmove( &p_cache->pp_entries[1], &p_cache->pp_entries[0],
+             p_cache->i_entries * sizeof(*p_cache->pp_entries) );
+    p_cache->pp_entries[0] = p_entry;
+    p_cache->i_entries++;
+    p_cache->i_size += p_entry->i_size;
+    vlc_mutex_unlock( &p_cache->lock );
+    return;
+
+error:
+    block_Release( p_data );
+}
+
 static picture_t *ImageReadUrl( image_handler_t *p_image, const char *psz_url,
                                 video_format_t *p_fmt_in,
                                 video_format_t *p_fmt_out )
@@ -260,8 +425,29 @@ static picture_t *ImageReadUrl( image_handler_t *p_image, const char *psz_url,
         p_fmt_in->i_chroma = image_Ext2Fourcc( psz_url );
     }
 
+    image_cache_t *p_cache = CacheGet( p_image );
+    if( !p_cache || i_size <= 0 || i_size > IMAGE_CACHE_MAX_SIZE )
+        return ImageRead( p_image, p_block, p_fmt_in, p_fmt_out );
+
+    p_pic = CacheFind( p_cache, psz_url, p_block, p_fmt_out );
+    if( p_pic )
+    {
+        block_Release( p_block );
+        return p_pic;
+    }
+
+    const video_format_t fmt_req = *p_fmt_out;
+    block_t *p_data = block_Duplicate( p_block );
+
     p_pic = ImageRead( p_image, p_block, p_fmt_in, p_fmt_out );
 
+    if( p_data )
+    {
+        if( p_pic && !p_fmt_out->p_palette )
+            CachePut( p_cache, psz_url, p_data, &fmt_req, p_fmt_out, p_pic );
+        else
+            block_Release( p_data );
+    }
     return p_pic;
 }
 
@@ -0,0 +1,128 @@
+/*****************************************************************************
+ * memstats.c: per-subsystem memory accounting
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_atomic.h>
+#include <vlc_memstats.h>
+#include "libvlc.h"
+
+static const char names[VLC_MEM_TAGS][10] = {
+    "block", "picture", "stream", "timeshift", "playlist", "modules", "other",
+};
+
+#ifdef ENABLE_MEMSTATS
+/* The atoms are as wide as pointers: the byte counts cannot overflow, the
+ * allocation counts wrap around on 32-bits systems. */
+static struct
+{
+    vlc_atomic_t live;
+    vlc_atomic_t peak;
+    vlc_atomic_t allocs;
+    vlc_atomic_t frees;
+} counters[VLC_MEM_TAGS];
+#endif
+
+/**
+ * Accounts an allocation (i_bytes > 0) or a release (i_bytes < 0).
+ * Use the VLC_MEM_ALLOC() and VLC_MEM_FREE() macros. This does nothing
+ * unless memory accounting is compiled in.
+ */
+void vlc_memstats_Add( unsigned i_tag, ssize_t i_bytes )
+{
+#ifdef ENABLE_MEMSTATS
+    assert( i_tag < VLC_MEM_TAGS );
+
+    if( i_bytes < 0 )
+    {
+        vlc_atomic_sub( &counters[i_tag].live, -i_bytes );
+        vlc_atomic_inc( &counters[i_tag].frees );
+        return;
+    }
+
+    intptr_t i_live = vlc_atomic_add( &counters[i_tag].live, i_bytes );
+    vlc_atomic_inc( &counters[i_tag].allocs );
+
+    uintptr_t i_peak = vlc_atomic_get( &counters[i_tag].peak );
+    while( i_live > (intptr_t)i_peak )
+    {
+        uintptr_t i_old = vlc_atomic_compare_swap( &counters[i_tag].peak,
+                                                   i_peak, i_live );
+        if( i_old == i_peak )
+            break;
+        i_peak = i_old;
+    }
+#else
+    VLC_UNUSED(i_tag); VLC_UNUSED(i_bytes);
+#endif
+}
+
+/**
+ * Reads the counters of a tag.
+ * @return VLC_EGENERIC if memory accounting is not compiled in
+ */
+int vlc_memstats_Get( unsigned i_tag, vlc_memstats_t *p_stats )
+{
+#ifdef ENABLE_MEMSTATS
+    assert( i_tag < VLC_MEM_TAGS );
+
+    p_stats->i_live = (intptr_t)vlc_atomic_get( &counters[i_tag].live );
+    p_stats->i_peak = (intptr_t)vlc_atomic_get( &counters[i_tag].peak );
+    p_stats->i_allocs = vlc_atomic_get( &counters[i_tag].allocs );
+    p_stats->i_frees = vlc_atomic_get( &counters[i_tag].frees );
+    return VLC_SUCCESS;
+#else
+    VLC_UNUSED(i_tag);
+    memset( p_stats, 0, sizeof(*p_stats) );
+    return VLC_EGENERIC;
+#endif
+}
+
+/**
+ * Returns the name of a tag, e.g. to label statistics.
+ */
+const char *vlc_memstats_Name( unsigned i_tag )
+{
+    assert( i_tag < VLC_MEM_TAGS );
+    return names[i_tag];
+}
+
+/**
+ * Prints the counters of all tags to the debug log.
+ */
+void vlc_memstats_Dump( vlc_object_t *p_obj )
+{
+    vlc_memstats_t st;
+
+    for( unsigned i = 0; i < VLC_MEM_TAGS; i++ )
+    {
+        if( vlc_memstats_Get( i, &st ) )
+            return;
+        msg_Dbg( p_obj, "memory %-9s: %8"PRId64" KiB live, %8"PRId64" KiB "
+                 "peak, %"PRIu64" allocations, %"PRIu64" releases",
+                 names[i], st.i_live / 1024, st.i_peak / 1024, st.i_allocs,
+                 st.i_frees );
+    }
+}
@@ -49,6 +49,7 @@
 #include <assert.h>
 
 #include <vlc_charset.h>
+#include <vlc_atomic.h>
 #include "../libvlc.h"
 
 /**
@@ -56,6 +57,9 @@
  */
 vlc_rwlock_t msg_lock = VLC_STATIC_RWLOCK;
 msg_subscription_t *msg_head;
+static vlc_atomic_t log_subscribers = VLC_ATOMIC_INIT(0);
+
+static void LogFlush (void);
 
 struct msg_subscription_t
 {
@@ -86,6 +90,7 @@ msg_subscription_t *vlc_Subscribe (msg_callback_t cb, void *opaque)
     vlc_rwlock_wrlock (&msg_lock);
     sub->next = msg_head;
     msg_head = sub;
+    vlc_atomic_inc (&log_subscribers);
     vlc_rwlock_unlock (&msg_lock);
 
     return sub;
@@ -97,6 +102,8 @@ msg_subscription_t *vlc_Subscribe (msg_callback_t cb, void *opaque)
  */
 void vlc_Unsubscribe (msg_subscription_t *sub)
 {
+    LogFlush ();
+
     vlc_rwlock_wrlock (&msg_lock);
     if (sub->next != NULL)
         sub->next->prev = sub->prev;
@@ -107,6 +114,7 @@ void vlc_Unsubscribe (msg_subscription_t *sub)
         assert (msg_head == sub);
         msg_head = sub->next;
     }
+    vlc_atomic_dec (&log_subscribers);
     vlc_rwlock_unlock (&msg_lock);
     free (sub);
 }
@@ -133,6 +141,228 @@ static void PrintColorMsg (void *, int, const msg_item_t *,
                            const char *, va_list);
 static void PrintMsg (void *, int, const msg_item_t *, const char *, va_list);
 
+/*
+ * Messages are formatted by the emitting thread, then queued in a lock-free
+ * ring, and printed and passed to the subscribers by a background thread.
+ * Emitting a message thus costs neither standard error output nor any
+ * lock. Messages nobody would see are discarded before formatting.
+ *
+ * The ring follows D. Vyukov's bounded queue: each slot has a sequence
+ * number telling whether it is free for a given producer turn or filled for
+ * the consumer. When the ring is full, messages are dropped and counted.
+ */
+#define LOG_RING_SIZE 1024 /* power of two */
+
+/** A formatted message */
+typedef struct
+{
+    msg_item_t item; /* strings point into text[] */
+    int        type;
+    bool       print; /* to the standard error */
+    bool       color;
+    char       text[]; /* message, then item strings */
+} log_entry_t;
+
+static struct
+{
+    vlc_atomic_t seq;
+    log_entry_t *entry;
+} log_ring[LOG_RING_SIZE];
+
+static vlc_atomic_t log_tail = VLC_ATOMIC_INIT(0); /* next slot to fill */
+static uintptr_t log_head; /* next slot to read, by the log thread only */
+static vlc_atomic_t log_dropped = VLC_ATOMIC_INIT(0);
+static vlc_atomic_t log_running = VLC_ATOMIC_INIT(0);
+
+static vlc_mutex_t log_init_lock = VLC_STATIC_MUTEX; /* start and stop */
+static vlc_rwlock_t log_state_lock = VLC_STATIC_RWLOCK; /* log_running */
+static vlc_mutex_t log_lock = VLC_STATIC_MUTEX;
+static vlc_cond_t log_wait; /* signaled whenever log_done changes */
+static uintptr_t log_done; /* number of messages handled */
+static unsigned log_refs = 0;
+static vlc_sem_t log_sem; /* one post per published message and stop */
+static vlc_thread_t log_thread;
+static locale_t log_c_locale = (locale_t)0;
+
+static void LogCall (msg_callback_t func, void *opaque, int type,
+                     const msg_item_t *item, const char *format, ...)
+{
+    va_list ap;
+
+    va_start (ap, format);
+    func (opaque, type, item, format, ap);
+    va_end (ap);
+}
+
+/**
+ * Prints a message and passes it to the subscribers.
+ */
+static void LogDispatch (log_entry_t *entry)
+{
+    int verbose = VLC_MSG_DBG; /* the level was checked at emission */
+
+    if (entry->print)
+        LogCall (entry->color ? PrintColorMsg : PrintMsg, &verbose,
+                 entry->type, &entry->item, "%s", entry->text);
+
+    vlc_rwlock_rdlock (&msg_lock);
+    for (msg_subscription_t *sub = msg_head; sub != NULL; sub = sub->next)
+        LogCall (sub->func, sub->opaque, entry->type, &entry->item,
+                 "%s", entry->text);
+    vlc_rwlock_unlock (&msg_lock);
+    free (entry);
+}
+
+static bool LogPush (log_entry_t *entry)
+{
+    uintptr_t pos = vlc_atomic_get (&log_tail);
+
+    for (;;)
+    {
+        intptr_t diff = vlc_atomic_get (&log_ring[pos % LOG_RING_SIZE].seq)
+                      - pos;
+        if (diff == 0)
+        {
+            uintptr_t cur = vlc_atomic_compare_swap (&log_tail, pos, pos + 1);
+            if (cur == pos)
+                break;
+            pos = cur;
+        }
+        else if (diff < 0)
+            return false; /* full */
+        else
+            pos = vlc_atomic_get (&log_tail);
+    }
+
+    log_ring[pos % LOG_RING_SIZE].entry = entry;
+    vlc_atomic_set (&log_ring[pos % LOG_RING_SIZE].seq, pos + 1);
+    vlc_sem_post (&log_sem);
+    return true;
+}
+
+static log_entry_t *LogPop (void)
+{
+    unsigned slot = log_head % LOG_RING_SIZE;
+
+    if (vlc_atomic_get (&log_ring[slot].seq) != log_head + 1)
+        return NULL;
+
+    log_entry_t *entry = log_ring[slot].entry;
+    vlc_atomic_set (&log_ring[slot].seq, log_head + LOG_RING_SIZE);
+    log_head++;
+    return entry;
+}
+
+static void *LogThread (void *data)
+{
+    vlc_savecancel ();
+    (void) data;
+
+    for (;;)
+    {
+        log_entry_t *entry = LogPop ();
+        if (entry == NULL)
+        {
+            /* Once stopped, no message gets queued anymore: the thread is
+             * done when the reserved slots are all handled. Otherwise, the
+             * next slot may be reserved but not filled yet; its producer
+             * posts when it is. */
+            if (!vlc_atomic_get (&log_running)
+             && log_head == vlc_atomic_get (&log_tail))
+                break;
+            vlc_sem_wait (&log_sem);
+            continue;
+        }
+
+        uintptr_t dropped = vlc_atomic_swap (&log_dropped, 0);
+        if (dropped > 0)
+            fprintf (stderr, "[log] %"PRIuPTR" message(s) dropped\n",
+                     dropped);
+
+        LogDispatch (entry);
+
+        vlc_mutex_lock (&log_lock);
+        log_done++;
+        vlc_cond_broadcast (&log_wait);
+        vlc_mutex_unlock (&log_lock);
+    }
+    return NULL;
+}
+
+/**
+ * Waits until the messages queued so far have been dispatched.
+ */
+static void LogFlush (void)
+{
+    uintptr_t target = vlc_atomic_get (&log_tail);
+
+    vlc_mutex_lock (&log_lock);
+    while (vlc_atomic_get (&log_running) && (intptr_t)(log_done - target) < 0)
+        vlc_cond_wait (&log_wait, &log_lock);
+    vlc_mutex_unlock (&log_lock);
+}
+
+/**
+ * Starts the log thread, if not started yet.
+ * Until then, messages are dispatched synchronously.
+ */
+void vlc_LogInit (void)
+{
+    vlc_mutex_lock (&log_init_lock);
+    if (log_refs++ > 0)
+        goto out;
+
+    if (log_c_locale == (locale_t)0) /* kept for the process lifetime */
+        log_c_locale = newlocale (LC_MESSAGES_MASK, "C", (locale_t)0);
+
+    for (unsigned i = 0; i < LOG_RING_SIZE; i++)
+        vlc_atomic_set (&log_ring[i].seq, i);
+    vlc_atomic_set (&log_tail, 0);
+    log_head = 0;
+    log_done = 0;
+    vlc_cond_init (&log_wait);
+    vlc_sem_init (&log_sem, 0);
+
+    if (vlc_clone (&log_thread, LogThread, NULL, VLC_THREAD_PRIORITY_LOW))
+    {
+        vlc_sem_destroy (&log_sem);
+        vlc_cond_destroy (&log_wait);
+        log_refs = 0; /* stay synchronous */
+        goto out;
+    }
+    vlc_atomic_set (&log_running, 1);
+out:
+    vlc_mutex_unlock (&log_init_lock);
+}
+
+/**
+ * Dispatches the pending messages and stops the log thread, once every
+ * vlc_LogInit() call is matched.
+ */
+void vlc_LogDeinit (void)
+{
+    vlc_mutex_lock (&log_init_lock);
+    if (log_refs == 0 || --log_refs > 0)
+        goto out;
+
+    LogFlush ();
+    /* No producer is queuing past this: later messages are dispatched
+     * synchronously, and those queued before are all published. */
+    vlc_rwlock_wrlock (&log_state_lock);
+    vlc_atomic_set (&log_running, 0);
+    vlc_rwlock_unlock (&log_state_lock);
+    vlc_sem_post (&log_sem);
+    vlc_join (log_thread, NULL);
+
+    for (log_entry_t *entry; (entry = LogPop ()) != NULL;)
+        LogDispatch (entry);
+
+    vlc_sem_destroy (&log_sem);
+    vlc_cond_destroy (&log_wait);
+out:
+    vlc_mutex_unlock (&log_init_lock);
+}
+
 /**
  * Emit a log message. This function is the variable argument list equivalent
  * to vlc_Log().
@@ -143,8 +373,16 @@ void vlc_vaLog (vlc_object_t *obj, int type, const char *module,
     if (obj != NULL && obj->i_flags & OBJECT_FLAGS_QUIET)
         return;
 
+    libvlc_priv_t *priv = libvlc_priv (obj->p_libvlc);
+    bool print = priv->i_verbose >= 0 && priv->i_verbose >= (type - VLC_MSG_ERR);
+
+    if (!print && vlc_atomic_get (&log_subscribers) == 0)
+        return; /* nobody would see it */
+
     /* C locale to get error messages in English in the logs */
-    locale_t c = newlocale (LC_MESSAGES_MASK, "C", (locale_t)0);
+    locale_t c = log_c_locale;
+    if (c == (locale_t)0)
+        c = newlocale (LC_MESSAGES_MASK, "C", (locale_t)0);
     locale_t locale = uselocale (c);
 
 #ifndef __GLIBC__
@@ -204,43 +442,75 @@ void vlc_vaLog (vlc_object_t *obj, int type, const char *module,
 #endif
 
     /* Fill message information fields */
-    msg_item_t msg;
-
-    msg.i_object_id = (uintptr_t)obj;
-    msg.psz_object_type = (obj != NULL) ? obj->psz_object_type : "generic";
-    msg.psz_module = module;
-    msg.psz_header = NULL;
+    const char *object_type = (obj != NULL) ? obj->psz_object_type
+                                            : "generic";
+    const char *header = NULL;
 
     for (vlc_object_t *o = obj; o != NULL; o = o->p_parent)
         if (o->psz_header != NULL)
         {
-            msg.psz_header = o->psz_header;
+            header = o->psz_header;
             break;
         }
 
-    /* Pass message to subscribers */
-    libvlc_priv_t *priv = libvlc_priv (obj->p_libvlc);
-
+    /* Format the message, and copy the strings the emitter may free */
+    char small[256];
     va_list ap;
 
     va_copy (ap, args);
-    if (priv->b_color)
-        PrintColorMsg (&priv->i_verbose, type, &msg, format, ap);
-    else
-        PrintMsg (&priv->i_verbose, type, &msg, format, ap);
+    int len = vsnprintf (small, sizeof (small), format, ap);
     va_end (ap);
-
-    vlc_rwlock_rdlock (&msg_lock);
-    for (msg_subscription_t *sub = msg_head; sub != NULL; sub = sub->next)
+    if (len < 0)
+        len = 0;
+
+    size_t modlen = strlen (module) + 1, typelen = strlen (object_type) + 1;
+    size_t headlen = (header != NULL) ? strlen (header) + 1 : 0;
+    log_entry_t *entry = malloc (sizeof (*entry) + len + 1
+                                 + modlen + typelen + headlen);
+    if (unlikely(entry == NULL))
+        goto out;
+
+    if ((size_t)len < sizeof (small))
+        memcpy (entry->text, small, len + 1);
+    else
     {
         va_copy (ap, args);
-        sub->func (sub->opaque, type, &msg, format, ap);
+        vsnprintf (entry->text, len + 1, format, ap);
         va_end (ap);
     }
-    vlc_rwlock_unlock (&msg_lock);
 
+    char *p = entry->text + len + 1;
+    entry->item.i_object_id = (uintptr_t)obj;
+    entry->item.psz_module = memcpy (p, module, modlen);
+    p += modlen;
+    entry->item.psz_object_type = memcpy (p, object_type, typelen);
+    p += typelen;
+    entry->item.psz_header = (header != NULL) ? memcpy (p, header, headlen)
+                                              : NULL;
+    entry->type = type;
+    entry->print = print;
+    entry->color = priv->b_color;
+
+    /* Pass message to subscribers */
+    vlc_rwlock_rdlock (&log_state_lock);
+    if (!vlc_atomic_get (&log_running))
+    {
+        vlc_rwlock_unlock (&log_state_lock);
+        LogDispatch (entry);
+    }
+    else
+    {
+        if (!LogPush (entry))
+        {
+            vlc_atomic_inc (&log_dropped);
+            free (entry);
+        }
+        vlc_rwlock_unlock (&log_state_lock);
+    }
+out:
     uselocale (locale);
-    freelocale (c);
+    if (c != log_c_locale)
+        freelocale (c);
 }
 
 static const char msg_type[4][9] = { "", " error", " warning", " debug" };
@@ -48,10 +48,6 @@
 
 #include "variables.h"
 
-#ifdef HAVE_SEARCH_H
-# include <search.h>
-#endif
-
 #ifdef __OS2__
 # include <sys/socket.h>
 # include <netinet/in.h>
@@ -129,7 +125,9 @@ void *vlc_custom_create (vlc_object_t *parent, size_t length,
     if (unlikely(priv == NULL))
         return NULL;
     priv->psz_name = NULL;
-    priv->var_root = NULL;
+    priv->var_table = NULL;
+    priv->var_mask = 0;
+    priv->var_count = 0;
     vlc_mutex_init (&priv->var_lock);
     vlc_cond_init (&priv->var_wait);
     priv->pipes[0] = priv->pipes[1] = -1;
@@ -554,13 +552,8 @@ vlc_list_t *vlc_list_children( vlc_object_t *obj )
     return l;
 }
 
-static void DumpVariable (const void *data, const VISIT which, const int depth)
+static void DumpVariable (const variable_t *p_var)
 {
-    if (which != postorder && which != leaf)
-        return;
-    (void) depth;
-
-    const variable_t *p_var = *(const variable_t **)data;
     const char *psz_type = "unknown";
 
     switch( p_var->i_type & VLC_VAR_TYPE )
@@ -659,12 +652,17 @@ static int DumpCommand( vlc_object_t *p_this, char const *psz_cmd,
             p_object = p_this->p_libvlc ? VLC_OBJECT(p_this->p_libvlc) : p_this;
 
         PrintObject( vlc_internals(p_object), "" );
-        vlc_mutex_lock( &vlc_internals( p_object )->var_lock );
-        if( vlc_internals( p_object )->var_root == NULL )
+        vlc_object_internals_t *priv = vlc_internals( p_object );
+
+        vlc_mutex_lock( &priv->var_lock );
+        if( priv->var_count == 0 )
             puts( " `-o No variables" );
         else
-            twalk( vlc_internals( p_object )->var_root, DumpVariable );
-        vlc_mutex_unlock( &vlc_internals( p_object )->var_lock );
+            for( unsigned i = 0; i <= priv->var_mask; i++ )
+                for( const variable_t *p_var = priv->var_table[i];
+                     p_var != NULL; p_var = p_var->p_hash_next )
+                    DumpVariable( p_var );
+        vlc_mutex_unlock( &priv->var_lock );
     }
     libvlc_unlock (p_this->p_libvlc);
 
@@ -37,6 +37,9 @@
 #include <vlc_picture.h>
 #include <vlc_image.h>
 #include <vlc_block.h>
+#include <vlc_cpu.h>
+#include <vlc_memstats.h>
+#include "libvlc.h"
 
 /**
  * Allocate a new picture in the heap.
@@ -77,6 +80,7 @@ static int vout_AllocatePicture( picture_t *p_pic,
         return VLC_EGENERIC;
     }
     p_pic->p_data_orig = p_data; /* TODO: get rid of this */
+    VLC_MEM_ALLOC( VLC_MEM_PICTURE, i_bytes );
 
     /* Fill the p_pixels field for each plane */
     p_pic->p[0].p_pixels = p_data;
@@ -269,6 +273,15 @@ void picture_Delete( picture_t *p_picture )
     assert( p_picture->p_release_sys == NULL );
 
     free( p_picture->p_q );
+#ifdef ENABLE_MEMSTATS
+    if( p_picture->p_data_orig != NULL )
+    {   /* the planes are as AllocatePicture() laid them out */
+        size_t i_bytes = 0;
+        for( int i = 0; i < p_picture->i_planes; i++ )
+            i_bytes += p_picture->p[i].i_pitch * p_picture->p[i].i_lines;
+        VLC_MEM_FREE( VLC_MEM_PICTURE, i_bytes );
+    }
+#endif
     vlc_free( p_picture->p_data_orig );
     free( p_picture->p_sys );
     free( p_picture );
@@ -313,9 +326,14 @@ void plane_CopyPixels( plane_t *p_dst, const plane_t *p_src )
         assert( p_in );
         assert( p_out );
 
+        /* Lines of a large picture are streamed, as the whole would not fit
+         * in the caches anyway */
+        vlc_memcpy_t pf_copy = (size_t)i_width * i_height >= VLC_MEMCPY_STREAM_MIN
+                             ? vlc_memcpy_stream : memcpy;
+
         for( i_line = i_height; i_line--; )
         {
-            vlc_memcpy( p_out, p_in, i_width );
+            pf_copy( p_out, p_in, i_width );
             p_in += p_src->i_pitch;
             p_out += p_dst->i_pitch;
         }
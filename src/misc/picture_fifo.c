@@ -32,6 +32,7 @@
 #include <assert.h>
 
 #include <vlc_common.h>
+#include <vlc_atomic.h>
 #include <vlc_picture_fifo.h>
 
 /*****************************************************************************
@@ -41,6 +42,12 @@ struct picture_fifo_t {
     vlc_mutex_t lock;
     picture_t   *first;
     picture_t   **last_ptr;
+
+    /* Lock-free mode, see picture_fifo_NewSPSC(). first and last_ptr then
+     * belong to the getter. */
+    bool         spsc;
+    vlc_atomic_t incoming;  /* pictures pushed, newest first */
+    vlc_atomic_t count;     /* pictures pushed and not popped nor flushed */
 };
 
 static void PictureFifoReset(picture_fifo_t *fifo)
@@ -67,6 +74,42 @@ static picture_t *PictureFifoPop(picture_fifo_t *fifo)
     return picture;
 }
 
+/* Moves the pictures pushed since the last call behind the ones of the
+ * getter, in order (lock-free mode, getter thread only) */
+static void PictureFifoGather(picture_fifo_t *fifo)
+{
+    uintptr_t incoming = vlc_atomic_swap(&fifo->incoming, 0);
+    picture_t *picture = (picture_t *)incoming;
+    picture_t *first = NULL;
+
+    while (picture) {
+        picture_t *next = picture->p_next;
+
+        picture->p_next = first;
+        first = picture;
+        picture = next;
+    }
+    if (first) {
+        *fifo->last_ptr = first;
+        while (first->p_next)
+            first = first->p_next;
+        fifo->last_ptr = &first->p_next;
+    }
+}
+
+static void PictureFifoLock(picture_fifo_t *fifo)
+{
+    if (fifo->spsc)
+        PictureFifoGather(fifo);
+    else
+        vlc_mutex_lock(&fifo->lock);
+}
+static void PictureFifoUnlock(picture_fifo_t *fifo)
+{
+    if (!fifo->spsc)
+        vlc_mutex_unlock(&fifo->lock);
+}
+
 picture_fifo_t *picture_fifo_New(void)
 {
     picture_fifo_t *fifo = malloc(sizeof(*fifo));
@@ -75,38 +118,79 @@ picture_fifo_t *picture_fifo_New(void)
 
     vlc_mutex_init(&fifo->lock);
     PictureFifoReset(fifo);
+    fifo->spsc = false;
+    vlc_atomic_set(&fifo->incoming, 0);
+    vlc_atomic_set(&fifo->count, 0);
+    return fifo;
+}
+
+/**
+ * Creates a fifo for exactly one thread getting pictures (pop, peek, flush
+ * and offset) at a time, as the video output thread does. Pictures are then
+ * pushed and popped without locking.
+ */
+picture_fifo_t *picture_fifo_NewSPSC(void)
+{
+    picture_fifo_t *fifo = picture_fifo_New();
+    if (fifo)
+        fifo->spsc = true;
     return fifo;
 }
 
 void picture_fifo_Push(picture_fifo_t *fifo, picture_t *picture)
 {
+    if (fifo->spsc) {
+        assert(!picture->p_next);
+        /* counted first, so that it is never below what can be popped */
+        vlc_atomic_inc(&fifo->count);
+
+        uintptr_t head = vlc_atomic_get(&fifo->incoming);
+        for (;;) {
+            picture->p_next = (picture_t *)head;
+            uintptr_t prev = vlc_atomic_compare_swap(&fifo->incoming, head,
+                                                     (uintptr_t)picture);
+            if (prev == head)
+                break;
+            head = prev;
+        }
+        return;
+    }
+
     vlc_mutex_lock(&fifo->lock);
     PictureFifoPush(fifo, picture);
+    vlc_atomic_inc(&fifo->count);
     vlc_mutex_unlock(&fifo->lock);
 }
 picture_t *picture_fifo_Pop(picture_fifo_t *fifo)
 {
-    vlc_mutex_lock(&fifo->lock);
+    PictureFifoLock(fifo);
     picture_t *picture = PictureFifoPop(fifo);
-    vlc_mutex_unlock(&fifo->lock);
+    if (picture)
+        vlc_atomic_dec(&fifo->count);
+    PictureFifoUnlock(fifo);
 
     return picture;
 }
 picture_t *picture_fifo_Peek(picture_fifo_t *fifo)
 {
-    vlc_mutex_lock(&fifo->lock);
+    PictureFifoLock(fifo);
     picture_t *picture = fifo->first;
     if (picture)
         picture_Hold(picture);
-    vlc_mutex_unlock(&fifo->lock);
+    PictureFifoUnlock(fifo);
 
     return picture;
 }
+bool picture_fifo_IsEmpty(picture_fifo_t *fifo)
+{
+    return vlc_atomic_get(&fifo->count) == 0;
+}
 void picture_fifo_Flush(picture_fifo_t *fifo, mtime_t date, bool flush_before)
 {
     picture_t *picture;
+    unsigned count = 0;
 
-    vlc_mutex_lock(&fifo->lock);
+    PictureFifoLock(fifo);
 
     picture = fifo->first;
     PictureFifoReset(fifo);
@@ -119,13 +203,16 @@ void picture_fifo_Flush(picture_fifo_t *fifo, mtime_t date, bool flush_before)
 
         picture->p_next = NULL;
         if (( flush_before && picture->date <= date) ||
-            (!flush_before && picture->date >= date))
+            (!flush_before && picture->date >= date)) {
             PictureFifoPush(&tmp, picture);
-        else
+            count++;
+        } else
             PictureFifoPush(fifo, picture);
         picture = next;
     }
-    vlc_mutex_unlock(&fifo->lock);
+    if (count > 0)
+        vlc_atomic_sub(&fifo->count, count);
+    PictureFifoUnlock(fifo);
 
     for (;;) {
         picture_t *picture = PictureFifoPop(&tmp);
@@ -136,12 +223,12 @@ void picture_fifo_Flush(picture_fifo_t *fifo, mtime_t date, bool flush_before)
 }
 void picture_fifo_OffsetDate(picture_fifo_t *fifo, mtime_t delta)
 {
-    vlc_mutex_lock(&fifo->lock);
+    PictureFifoLock(fifo);
     for (picture_t *picture = fifo->first; picture != NULL;) {
         picture->date += delta;
         picture = picture->p_next;
     }
-    vlc_mutex_unlock(&fifo->lock);
+    PictureFifoUnlock(fifo);
 }
 void picture_fifo_Delete(picture_fifo_t *fifo)
 {
@@ -48,16 +48,30 @@ struct picture_release_sys_t {
 
     /* */
     int64_t tick;
+
+    /* Pool the picture is currently attached to, protected by root->lock */
+    picture_pool_t *root;
+    picture_pool_t *pool;
+    bool           in_free;
 };
 
 struct picture_pool_t {
     /* */
     picture_pool_t *master;
+    picture_pool_t *root;
     int64_t        tick;
     /* */
     int            picture_count;
     picture_t      **picture;
-    bool           *picture_reserved;
+
+    /* Free pictures, used as a stack; only valid in the root pool for lock */
+    vlc_mutex_t    lock;
+    int            free_count;
+    picture_t      **free;
+
+    /* Statistics */
+    unsigned       used_max;
+    unsigned       starved;
 };
 
 static void Release(picture_t *);
@@ -71,19 +85,51 @@ static picture_pool_t *Create(picture_pool_t *master, int picture_count)
         return NULL;
 
     pool->master = master;
+    pool->root = master ? master->root : pool;
     pool->tick = master ? master->tick : 1;
     pool->picture_count = picture_count;
     pool->picture = calloc(pool->picture_count, sizeof(*pool->picture));
-    pool->picture_reserved = calloc(pool->picture_count, sizeof(*pool->picture_reserved));
-    if (!pool->picture || !pool->picture_reserved) {
+    pool->free = calloc(pool->picture_count, sizeof(*pool->free));
+    if (!pool->picture || !pool->free) {
         free(pool->picture);
-        free(pool->picture_reserved);
+        free(pool->free);
         free(pool);
         return NULL;
     }
+    pool->free_count = 0;
+    if (!master)
+        vlc_mutex_init(&pool->lock);
     return pool;
 }
 
+/* Must be called with the root lock held */
+static void PushFree(picture_pool_t *pool, picture_t *picture)
+{
+    picture_release_sys_t *release_sys = picture->p_release_sys;
+
+    assert(release_sys->pool == pool);
+    if (release_sys->in_free)
+        return;
+    assert(pool->free_count < pool->picture_count);
+    pool->free[pool->free_count++] = picture;
+    release_sys->in_free = true;
+}
+
+/* Must be called with the root lock held */
+static picture_t *PopFree(picture_pool_t *pool)
+{
+    if (pool->free_count <= 0)
+        return NULL;
+
+    picture_t *picture = pool->free[--pool->free_count];
+    picture->p_release_sys->in_free = false;
+
+    unsigned used = pool->picture_count - pool->free_count;
+    if (used > pool->used_max)
+        pool->used_max = used;
+    return picture;
+}
+
 picture_pool_t *picture_pool_NewExtended(const picture_pool_configuration_t *cfg)
 {
     picture_pool_t *pool = Create(NULL, cfg->picture_count);
@@ -105,6 +151,9 @@ picture_pool_t *picture_pool_NewExtended(const picture_pool_configuration_t *cfg
         release_sys->lock        = cfg->lock;
         release_sys->unlock      = cfg->unlock;
         release_sys->tick        = 0;
+        release_sys->root        = pool;
+        release_sys->pool        = pool;
+        release_sys->in_free     = false;
 
         /* */
         picture->i_refcount    = 0;
@@ -113,7 +162,7 @@ picture_pool_t *picture_pool_NewExtended(const picture_pool_configuration_t *cfg
 
         /* */
         pool->picture[i] = picture;
-        pool->picture_reserved[i] = false;
+        PushFree(pool, picture);
     }
     return pool;
 
@@ -160,39 +209,57 @@ picture_pool_t *picture_pool_Reserve(picture_pool_t *master, int count)
     if (!pool)
         return NULL;
 
-    int found = 0;
-    for (int i = 0; i < master->picture_count && found < count; i++) {
-        if (master->picture_reserved[i])
-            continue;
-
-        assert(master->picture[i]->i_refcount == 0);
-        master->picture_reserved[i] = true;
-
-        pool->picture[found]          = master->picture[i];
-        pool->picture_reserved[found] = false;
-        found++;
-    }
-    if (found < count) {
+    /* Only the unreserved pictures not in use can be reserved, that is
+     * exactly the free list of the master */
+    vlc_mutex_lock(&pool->root->lock);
+    if (master->free_count < count) {
+        vlc_mutex_unlock(&pool->root->lock);
         picture_pool_Delete(pool);
         return NULL;
     }
+    for (int i = 0; i < count; i++) {
+        picture_t *picture = master->free[--master->free_count];
+        picture_release_sys_t *release_sys = picture->p_release_sys;
+
+        assert(picture->i_refcount == 0);
+        release_sys->in_free = false;
+        release_sys->pool    = pool;
+
+        pool->picture[i] = picture;
+        PushFree(pool, picture);
+    }
+    vlc_mutex_unlock(&pool->root->lock);
     return pool;
 }
 
 void picture_pool_Delete(picture_pool_t *pool)
 {
-    for (int i = 0; i < pool->picture_count; i++) {
-        picture_t *picture = pool->picture[i];
-        if (pool->master) {
-            for (int j = 0; j < pool->master->picture_count; j++) {
-                if (pool->master->picture[j] == picture)
-                    pool->master->picture_reserved[j] = false;
-            }
-        } else {
+    if (pool->master) {
+        picture_pool_t *master = pool->master;
+
+        /* Give the pictures back to the master, the ones still in use will
+         * be returned to it on release */
+        vlc_mutex_lock(&pool->root->lock);
+        for (int i = 0; i < pool->picture_count; i++) {
+            picture_t *picture = pool->picture[i];
+            if (!picture)
+                break;
+            picture_release_sys_t *release_sys = picture->p_release_sys;
+            bool in_free = release_sys->in_free;
+
+            release_sys->in_free = false;
+            release_sys->pool    = master;
+            if (in_free)
+                PushFree(master, picture);
+        }
+        vlc_mutex_unlock(&pool->root->lock);
+    } else {
+        for (int i = 0; i < pool->picture_count; i++) {
+            picture_t *picture = pool->picture[i];
             picture_release_sys_t *release_sys = picture->p_release_sys;
 
             assert(picture->i_refcount == 0);
-            assert(!pool->picture_reserved[i]);
+            assert(release_sys->pool == pool);
 
             /* Restore old release callback */
             picture->i_refcount    = 1;
@@ -203,57 +270,99 @@ void picture_pool_Delete(picture_pool_t *pool)
 
             free(release_sys);
         }
+        vlc_mutex_destroy(&pool->lock);
     }
-    free(pool->picture_reserved);
+    free(pool->free);
     free(pool->picture);
     free(pool);
 }
 
 picture_t *picture_pool_Get(picture_pool_t *pool)
 {
-    for (int i = 0; i < pool->picture_count; i++) {
-        if (pool->picture_reserved[i])
-            continue;
-
-        picture_t *picture = pool->picture[i];
-        if (picture->i_refcount > 0)
-            continue;
+    vlc_mutex_t *lock = &pool->root->lock;
+    picture_t *failed = NULL;
+    picture_t *picture;
+
+    vlc_mutex_lock(lock);
+    while ((picture = PopFree(pool)) != NULL) {
+        /* The lock callback may release other pictures */
+        vlc_mutex_unlock(lock);
+
+        assert(picture->i_refcount == 0);
+        if (!Lock(picture)) {
+            if (failed) {
+                vlc_mutex_lock(lock);
+                goto restore;
+            }
+            goto out;
+        }
 
-        if (Lock(picture))
-            continue;
+        /* Keep it aside so that it is not tried again */
+        picture->p_next = failed;
+        failed = picture;
+        vlc_mutex_lock(lock);
+    }
+    pool->starved++;
 
-        /* */
-        picture->p_next = NULL;
-        picture->p_release_sys->tick = pool->tick++;
-        picture_Hold(picture);
-        return picture;
+restore:
+    while (failed) {
+        picture_t *next = failed->p_next;
+        PushFree(pool, failed);
+        failed = next;
     }
-    return NULL;
+    vlc_mutex_unlock(lock);
+    if (!picture)
+        return NULL;
+
+out:
+    /* */
+    picture->p_next = NULL;
+    picture->p_release_sys->tick = pool->tick++;
+    picture_Hold(picture);
+    return picture;
 }
 
 void picture_pool_NonEmpty(picture_pool_t *pool, bool reset)
 {
+    vlc_mutex_t *lock = &pool->root->lock;
     picture_t *old = NULL;
 
+    vlc_mutex_lock(lock);
+    if (!reset && pool->free_count > 0) {
+        vlc_mutex_unlock(lock);
+        return;
+    }
+
+    picture_t *used[pool->picture_count];
+    int used_count = 0;
     for (int i = 0; i < pool->picture_count; i++) {
-        if (pool->picture_reserved[i])
+        picture_t *picture = pool->picture[i];
+        picture_release_sys_t *release_sys = picture->p_release_sys;
+
+        /* Skip the reserved and the free pictures */
+        if (release_sys->pool != pool || release_sys->in_free)
             continue;
 
-        picture_t *picture = pool->picture[i];
-        if (reset) {
-            if (picture->i_refcount > 0)
-                Unlock(picture);
-            picture->i_refcount = 0;
-        } else if (picture->i_refcount == 0) {
-            return;
-        } else if (!old || picture->p_release_sys->tick < old->p_release_sys->tick) {
+        if (reset)
+            used[used_count++] = picture;
+        else if (!old || release_sys->tick < old->p_release_sys->tick)
             old = picture;
-        }
     }
-    if (!reset && old) {
-        if (old->i_refcount > 0)
-            Unlock(old);
-        old->i_refcount = 0;
+    vlc_mutex_unlock(lock);
+
+    if (!reset && old)
+        used[used_count++] = old;
+
+    for (int i = 0; i < used_count; i++) {
+        picture_t *picture = used[i];
+
+        if (picture->i_refcount > 0)
+            Unlock(picture);
+        picture->i_refcount = 0;
+
+        vlc_mutex_lock(lock);
+        PushFree(pool, picture);
+        vlc_mutex_unlock(lock);
     }
 }
 int picture_pool_GetSize(picture_pool_t *pool)
@@ -261,6 +370,14 @@ int picture_pool_GetSize(picture_pool_t *pool)
     return pool->picture_count;
 }
 
+void picture_pool_GetStats(picture_pool_t *pool, unsigned *used_max, unsigned *starved)
+{
+    vlc_mutex_lock(&pool->root->lock);
+    *used_max = pool->used_max;
+    *starved  = pool->starved;
+    vlc_mutex_unlock(&pool->root->lock);
+}
+
 static void Release(picture_t *picture)
 {
     assert(picture->i_refcount > 0);
@@ -268,6 +385,11 @@ static void Release(picture_t *picture)
     if (--picture->i_refcount > 0)
         return;
     Unlock(picture);
+
+    picture_release_sys_t *release_sys = picture->p_release_sys;
+    vlc_mutex_lock(&release_sys->root->lock);
+    PushFree(release_sys->pool, picture);
+    vlc_mutex_unlock(&release_sys->root->lock);
 }
 
 static int Lock(picture_t *picture)
@@ -31,6 +31,31 @@
 #include <assert.h>
 #include "libvlc.h"
 
+/* Prepared statements kept per connection */
+#define SQL_STMT_CACHE 32
+
+typedef struct
+{
+    char       *psz_query;
+    sql_stmt_t *p_stmt;
+    uint64_t    i_last_use;
+    bool        b_busy;
+} sql_cached_stmt_t;
+
+typedef struct
+{
+    sql_t             sql;
+
+    vlc_mutex_t       cache_lock;
+    sql_cached_stmt_t cache[SQL_STMT_CACHE];
+    uint64_t          i_cache_clock;
+} sql_priv_t;
+
+static inline sql_priv_t *sql_priv( sql_t *p_sql )
+{
+    return (sql_priv_t *)p_sql;
+}
+
 #undef sql_Create
 sql_t *sql_Create( vlc_object_t *p_this, const char *psz_name,
         const char* psz_host, int i_port,
@@ -38,12 +63,17 @@ sql_t *sql_Create( vlc_object_t *p_this, const char *psz_name,
 {
     sql_t *p_sql;
 
-    p_sql = ( sql_t * ) vlc_custom_create( p_this, sizeof( sql_t ), "sql" );
-    if( !p_sql )
+    sql_priv_t *p_priv = vlc_custom_create( p_this, sizeof( *p_priv ), "sql" );
+    if( !p_priv )
     {
         msg_Err( p_this, "unable to create sql object" );
         return NULL;
     }
+    p_sql = &p_priv->sql;
+
+    vlc_mutex_init( &p_priv->cache_lock );
+    memset( p_priv->cache, 0, sizeof( p_priv->cache ) );
+    p_priv->i_cache_clock = 0;
 
     p_sql->psz_host = strdup( psz_host );
     p_sql->psz_user = strdup( psz_user );
@@ -57,6 +87,7 @@ sql_t *sql_Create( vlc_object_t *p_this, const char *psz_name,
         free( p_sql->psz_host );
         free( p_sql->psz_user );
         free( p_sql->psz_pass );
+        vlc_mutex_destroy( &p_priv->cache_lock );
         vlc_object_release( p_sql );
         msg_Err( p_this, "SQL provider not found" );
         return NULL;
@@ -69,8 +100,20 @@ sql_t *sql_Create( vlc_object_t *p_this, const char *psz_name,
 void sql_Destroy( vlc_object_t* obj )
 {
     sql_t *p_sql = (sql_t *)obj;
+    sql_priv_t *p_priv = sql_priv( p_sql );
     assert( p_sql );
 
+    for( int i = 0; i < SQL_STMT_CACHE; i++ )
+    {
+        sql_cached_stmt_t *p_entry = &p_priv->cache[i];
+        if( !p_entry->p_stmt )
+            continue;
+        assert( !p_entry->b_busy );
+        sql_Finalize( p_sql, p_entry->p_stmt );
+        free( p_entry->psz_query );
+    }
+    vlc_mutex_destroy( &p_priv->cache_lock );
+
     free( p_sql->psz_host );
     free( p_sql->psz_user );
     free( p_sql->psz_pass );
@@ -79,3 +122,91 @@ void sql_Destroy( vlc_object_t* obj )
 
     vlc_object_release( obj );
 }
+
+sql_stmt_t *sql_GetStatement( sql_t *p_sql, const char *psz_query )
+{
+    sql_priv_t *p_priv = sql_priv( p_sql );
+    sql_cached_stmt_t *p_victim = NULL;
+
+    vlc_mutex_lock( &p_priv->cache_lock );
+    for( int i = 0; i < SQL_STMT_CACHE; i++ )
+    {
+        sql_cached_stmt_t *p_entry = &p_priv->cache[i];
+
+        if( p_entry->b_busy )
+            continue;
+        if( p_entry->p_stmt && !strcmp( p_entry->psz_query, psz_query ) )
+        {
+            p_entry->b_busy = true;
+            p_entry->i_last_use = ++p_priv->i_cache_clock;
+            vlc_mutex_unlock( &p_priv->cache_lock );
+            return p_entry->p_stmt;
+        }
+        /* Empty slots first, then the least recently used statement */
+        if( !p_victim || ( p_victim->p_stmt
+         && ( !p_entry->p_stmt || p_entry->i_last_use < p_victim->i_last_use ) ) )
+            p_victim = p_entry;
+    }
+
+    /* Take the slot now, so that the query can be prepared unlocked */
+    sql_stmt_t *p_old = NULL;
+    char *psz_old = NULL;
+    if( p_victim )
+    {
+        p_old = p_victim->p_stmt;
+        psz_old = p_victim->psz_query;
+        p_victim->p_stmt = NULL;
+        p_victim->psz_query = NULL;
+        p_victim->b_busy = true;
+    }
+    vlc_mutex_unlock( &p_priv->cache_lock );
+
+    if( p_old )
+    {
+        sql_Finalize( p_sql, p_old );
+        free( psz_old );
+    }
+
+    sql_stmt_t *p_stmt = sql_Prepare( p_sql, psz_query, -1 );
+    char *psz_copy = p_stmt && p_victim ? strdup( psz_query ) : NULL;
+
+    if( p_victim )
+    {
+        vlc_mutex_lock( &p_priv->cache_lock );
+        if( psz_copy )
+        {
+            p_victim->psz_query = psz_copy;
+            p_victim->p_stmt = p_stmt;
+            p_victim->i_last_use = ++p_priv->i_cache_clock;
+        }
+        else
+            p_victim->b_busy = false;
+        vlc_mutex_unlock( &p_priv->cache_lock );
+    }
+    /* If the statement could not be cached, sql_PutStatement() finalizes it */
+    return p_stmt;
+}
+
+void sql_PutStatement( sql_t *p_sql, sql_stmt_t *p_stmt )
+{
+    sql_priv_t *p_priv = sql_priv( p_sql );
+
+    /* The next user starts over from the first row */
+    sql_Reset( p_sql, p_stmt );
+
+    vlc_mutex_lock( &p_priv->cache_lock );
+    for( int i = 0; i < SQL_STMT_CACHE; i++ )
+    {
+        sql_cached_stmt_t *p_entry = &p_priv->cache[i];
+        if( p_entry->p_stmt == p_stmt )
+        {
+            assert( p_entry->b_busy );
+            p_entry->b_busy = false;
+            vlc_mutex_unlock( &p_priv->cache_lock );
+            return;
+        }
+    }
+    vlc_mutex_unlock( &p_priv->cache_lock );
+
+    sql_Finalize( p_sql, p_stmt );
+}
@@ -30,9 +30,12 @@
 #endif
 
 #include <vlc_common.h>
+#include <vlc_atomic.h>
+#include <vlc_playlist.h>
 #include <stdio.h>                                               /* required */
 
 #include "input/input_internal.h"
+#include "playlist/playlist_internal.h"
 
 /*****************************************************************************
  * Local prototypes
@@ -177,12 +180,21 @@ void stats_ComputeInputStats( input_thread_t *p_input, input_stats_t *p_stats )
                       &p_stats->i_demux_corrupted );
     stats_GetInteger( p_input, p_input->p->counters.p_demux_discontinuity,
                       &p_stats->i_demux_discontinuity );
+    stats_GetInteger( p_input, p_input->p->counters.p_demux_latency,
+                      &p_stats->i_demux_latency );
 
+#define GET( c ) (int64_t)(intptr_t)vlc_atomic_get( &p_input->p->counters.c )
     /* Decoders */
-    stats_GetInteger( p_input, p_input->p->counters.p_decoded_video,
-                      &p_stats->i_decoded_video );
-    stats_GetInteger( p_input, p_input->p->counters.p_decoded_audio,
-                      &p_stats->i_decoded_audio );
+    p_stats->i_decoded_video = GET( decoded_video );
+    p_stats->i_decoded_audio = GET( decoded_audio );
+#define PERCENTILE( c, pct ) \
+    stats_HistogramPercentile( &p_input->p->counters.c, pct )
+    p_stats->i_video_decode_time_p50 = PERCENTILE( video_decode_time, 50 );
+    p_stats->i_video_decode_time_p90 = PERCENTILE( video_decode_time, 90 );
+    p_stats->i_video_decode_time_p99 = PERCENTILE( video_decode_time, 99 );
+    p_stats->i_audio_decode_time_p50 = PERCENTILE( audio_decode_time, 50 );
+    p_stats->i_audio_decode_time_p90 = PERCENTILE( audio_decode_time, 90 );
+    p_stats->i_audio_decode_time_p99 = PERCENTILE( audio_decode_time, 99 );
 
     /* Sout */
     if( p_input->p->counters.p_sout_send_bitrate )
@@ -196,16 +208,28 @@ void stats_ComputeInputStats( input_thread_t *p_input, input_stats_t *p_stats )
     }
 
     /* Aout */
-    stats_GetInteger( p_input, p_input->p->counters.p_played_abuffers,
-                      &p_stats->i_played_abuffers );
-    stats_GetInteger( p_input, p_input->p->counters.p_lost_abuffers,
-                      &p_stats->i_lost_abuffers );
+    p_stats->i_played_abuffers = GET( played_abuffers );
+    p_stats->i_lost_abuffers = GET( lost_abuffers );
+    p_stats->i_audio_filter_time = GET( audio_filter_time );
+    p_stats->i_audio_resampler_time = GET( audio_resampler_time );
+    p_stats->i_audio_output_time = GET( audio_output_time );
+    p_stats->i_audio_allocations = GET( audio_allocations );
+    p_stats->i_audio_buffered = GET( audio_buffered );
+    p_stats->i_audio_delay = GET( audio_delay );
 
     /* Vouts */
-    stats_GetInteger( p_input, p_input->p->counters.p_displayed_pictures,
-                      &p_stats->i_displayed_pictures );
-    stats_GetInteger( p_input, p_input->p->counters.p_lost_pictures,
-                      &p_stats->i_lost_pictures );
+    p_stats->i_displayed_pictures = GET( displayed_pictures );
+    p_stats->i_lost_pictures = GET( lost_pictures );
+    p_stats->i_video_latency_p50 = PERCENTILE( video_latency, 50 );
+    p_stats->i_video_latency_p90 = PERCENTILE( video_latency, 90 );
+    p_stats->i_video_latency_p99 = PERCENTILE( video_latency, 99 );
+#undef PERCENTILE
+#undef GET
+
+    /* Synchronicity */
+    playlist_t *p_playlist = libvlc_priv( p_input->p_libvlc )->p_playlist;
+    if( p_playlist )
+        playlist_SynComputeStats( p_playlist, p_stats );
 
     vlc_mutex_unlock( &p_stats->lock );
     vlc_mutex_unlock( &p_input->p->counters.counters_lock );
@@ -219,10 +243,24 @@ void stats_ReinitInputStats( input_stats_t *p_stats )
     p_stats->i_demux_read_packets = p_stats->i_demux_read_bytes =
     p_stats->f_demux_bitrate = p_stats->f_average_demux_bitrate =
     p_stats->i_demux_corrupted = p_stats->i_demux_discontinuity =
+    p_stats->i_demux_latency =
     p_stats->i_displayed_pictures = p_stats->i_lost_pictures =
     p_stats->i_played_abuffers = p_stats->i_lost_abuffers =
+    p_stats->i_audio_filter_time = p_stats->i_audio_resampler_time =
+    p_stats->i_audio_output_time = p_stats->i_audio_allocations =
+    p_stats->i_audio_buffered = p_stats->i_audio_delay =
     p_stats->i_decoded_video = p_stats->i_decoded_audio =
-    p_stats->i_sent_bytes = p_stats->i_sent_packets = p_stats->f_send_bitrate
+    p_stats->i_video_decode_time_p50 = p_stats->i_video_decode_time_p90 =
+    p_stats->i_video_decode_time_p99 =
+    p_stats->i_audio_decode_time_p50 = p_stats->i_audio_decode_time_p90 =
+    p_stats->i_audio_decode_time_p99 =
+    p_stats->i_video_latency_p50 = p_stats->i_video_latency_p90 =
+    p_stats->i_video_latency_p99 =
+    p_stats->i_sent_bytes = p_stats->i_sent_packets = p_stats->f_send_bitrate =
+    p_stats->i_syn_rtt = p_stats->i_syn_offset = p_stats->i_syn_offset_error =
+    p_stats->i_syn_sent_bytes = p_stats->i_syn_received_bytes =
+    p_stats->i_syn_beacons = p_stats->i_syn_beacon_replies =
+    p_stats->i_syn_seeks = p_stats->i_syn_slews
      = 0;
     vlc_mutex_unlock( &p_stats->lock );
 }
@@ -245,6 +283,60 @@ void stats_DumpInputStats( input_stats_t *p_stats  )
     vlc_mutex_unlock( &p_stats->lock );
 }
 
+/* Bucket of a duration: exact below 8 us, then 8 buckets per octave */
+static unsigned HistogramIndex( mtime_t i_value )
+{
+    if( i_value < 8 )
+        return i_value > 0 ? i_value : 0;
+    if( i_value >= (1 << 24) )
+        return STATS_HISTOGRAM_BUCKETS - 1;
+
+    unsigned v = i_value;
+    unsigned e = 31 - clz32( v );
+    return (e - 2) * 8 + ((v >> (e - 3)) & 7);
+}
+
+/* Upper bound of a bucket */
+static mtime_t HistogramValue( unsigned i )
+{
+    if( i < 8 )
+        return i;
+    return ((mtime_t)(9 + i % 8) << (i / 8 - 1)) - 1;
+}
+
+/**
+ * Adds a duration to a histogram. This is lock-free, so it can be used on
+ * per-block and per-picture paths.
+ */
+void stats_HistogramAdd( stats_histogram_t *p_hist, mtime_t i_value )
+{
+    vlc_atomic_inc( &p_hist->buckets[HistogramIndex( i_value )] );
+}
+
+/**
+ * Gets a percentile of a histogram, as the upper bound of its bucket.
+ * \return the duration, or 0 if the histogram is empty
+ */
+mtime_t stats_HistogramPercentile( const stats_histogram_t *p_hist,
+                                   unsigned i_percent )
+{
+    uint64_t i_total = 0, i_count = 0;
+
+    for( unsigned i = 0; i < STATS_HISTOGRAM_BUCKETS; i++ )
+        i_total += vlc_atomic_get( &p_hist->buckets[i] );
+    if( i_total == 0 )
+        return 0;
+
+    const uint64_t i_rank = (i_total * i_percent + 99) / 100;
+    for( unsigned i = 0; i < STATS_HISTOGRAM_BUCKETS; i++ )
+    {
+        i_count += vlc_atomic_get( &p_hist->buckets[i] );
+        if( i_count >= i_rank )
+            return HistogramValue( i );
+    }
+    return HistogramValue( STATS_HISTOGRAM_BUCKETS - 1 );
+}
+
 #undef stats_TimerStart
 void stats_TimerStart( vlc_object_t *p_obj, const char *psz_name,
                        unsigned int i_id )
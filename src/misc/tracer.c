@@ -0,0 +1,176 @@
+/*****************************************************************************
+ * tracer.c: hot path tracing
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_atomic.h>
+#include <vlc_fs.h>
+#include <vlc_tracer.h>
+#include "libvlc.h"
+
+/* Latest events kept per thread (power of two) */
+#define TRACE_RING 8192
+
+typedef struct
+{
+    mtime_t     date;
+    const char *name;
+    int64_t     value;
+    char        phase;
+} trace_event_t;
+
+typedef struct trace_ring_t trace_ring_t;
+struct trace_ring_t
+{
+    trace_ring_t *next;
+    unsigned      tid;
+    vlc_atomic_t  count;    /* events written, only by the owner thread */
+    trace_event_t events[TRACE_RING];
+};
+
+static vlc_mutex_t lock = VLC_STATIC_MUTEX;
+static unsigned users = 0;
+static vlc_atomic_t enabled = VLC_ATOMIC_INIT(0);
+static vlc_threadvar_t ring_key; /* ring of the calling thread */
+static trace_ring_t *rings = NULL;
+static unsigned next_tid;
+
+void vlc_tracer_Start( void )
+{
+    vlc_mutex_lock( &lock );
+    if( users > 0 || vlc_threadvar_create( &ring_key, NULL ) == 0 )
+    {
+        if( users++ == 0 )
+        {
+            next_tid = 1;
+            vlc_atomic_set( &enabled, 1 );
+        }
+    }
+    vlc_mutex_unlock( &lock );
+}
+
+static trace_ring_t *NewRing( void )
+{
+    trace_ring_t *ring = malloc( sizeof(*ring) );
+    if( unlikely(ring == NULL) )
+        return NULL;
+
+    vlc_atomic_set( &ring->count, 0 );
+    vlc_mutex_lock( &lock );
+    ring->tid = next_tid++;
+    ring->next = rings;
+    rings = ring;
+    vlc_mutex_unlock( &lock );
+
+    vlc_threadvar_set( ring_key, ring );
+    return ring;
+}
+
+void vlc_tracer_Event( const char *psz_name, char phase, int64_t i_value )
+{
+    if( likely(!vlc_atomic_get( &enabled )) )
+        return;
+
+    trace_ring_t *ring = vlc_threadvar_get( ring_key );
+    if( unlikely(ring == NULL) && (ring = NewRing()) == NULL )
+        return;
+
+    uintptr_t n = vlc_atomic_get( &ring->count );
+    trace_event_t *ev = &ring->events[n & (TRACE_RING - 1)];
+
+    ev->date = mdate();
+    ev->name = psz_name;
+    ev->value = i_value;
+    ev->phase = phase;
+    vlc_atomic_set( &ring->count, n + 1 );
+}
+
+/* Writes the events as a Chrome trace (JSON array format) */
+static void Dump( FILE *stream )
+{
+    const char *psz_sep = "";
+
+    fputs( "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", stream );
+    for( const trace_ring_t *ring = rings; ring != NULL; ring = ring->next )
+    {
+        uintptr_t end = vlc_atomic_get( &ring->count );
+        uintptr_t i = end > TRACE_RING ? end - TRACE_RING : 0;
+
+        for( ; i < end; i++ )
+        {
+            const trace_event_t *ev = &ring->events[i & (TRACE_RING - 1)];
+
+            fprintf( stream, "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%"PRId64
+                     ",\"pid\":1,\"tid\":%u", psz_sep, ev->name, ev->phase,
+                     ev->date, ring->tid );
+            if( ev->phase == 'C' )
+                fprintf( stream, ",\"args\":{\"value\":%"PRId64"}",
+                         ev->value );
+            else if( ev->phase == 'i' )
+                fputs( ",\"s\":\"t\"", stream );
+            fputc( '}', stream );
+            psz_sep = ",\n";
+        }
+    }
+    fputs( "\n]}\n", stream );
+}
+
+/**
+ * Stops tracing, once all LibVLC instances are done, and writes the trace.
+ * The threads that recorded events must be gone (or at least idle).
+ */
+void vlc_tracer_Stop( vlc_object_t *p_obj, const char *psz_path )
+{
+    vlc_mutex_lock( &lock );
+    if( users == 0 || --users > 0 ) /* not started, or still in use */
+    {
+        vlc_mutex_unlock( &lock );
+        return;
+    }
+    vlc_atomic_set( &enabled, 0 );
+
+    FILE *stream = vlc_fopen( psz_path, "wt" );
+    if( stream != NULL )
+    {
+        Dump( stream );
+        if( fclose( stream ) == 0 )
+            msg_Info( p_obj, "trace written to %s", psz_path );
+        else
+            msg_Err( p_obj, "cannot write trace to %s: %m", psz_path );
+    }
+    else
+        msg_Err( p_obj, "cannot create trace file %s: %m", psz_path );
+
+    while( rings != NULL )
+    {
+        trace_ring_t *ring = rings;
+
+        rings = ring->next;
+        free( ring );
+    }
+    vlc_threadvar_delete( &ring_key );
+    vlc_mutex_unlock( &lock );
+}
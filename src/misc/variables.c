@@ -32,10 +32,6 @@
 #include <vlc_charset.h>
 #include "variables.h"
 
-#ifdef HAVE_SEARCH_H
-# include <search.h>
-#endif
-
 #include "libvlc.h"
 #include "config/configuration.h"
 
@@ -138,23 +134,91 @@ static void     CheckValue  ( variable_t *, vlc_value_t * );
 static int      TriggerCallback( vlc_object_t *, variable_t *, const char *,
                                  vlc_value_t );
 
-static int varcmp( const void *a, const void *b )
+/* FNV-1a */
+static unsigned VarHash( const char *psz_name )
 {
-    const variable_t *va = a, *vb = b;
+    uint32_t i_hash = 2166136261u;
 
-    /* psz_name must be first */
-    assert( va == (const void *)&va->psz_name );
-    return strcmp( va->psz_name, vb->psz_name );
+    while( *psz_name )
+        i_hash = (i_hash ^ (unsigned char)*psz_name++) * 16777619u;
+    return i_hash;
+}
+
+static variable_t *LookupHash( vlc_object_internals_t *priv,
+                               const char *psz_name, unsigned i_hash )
+{
+    vlc_assert_locked( &priv->var_lock );
+    if( priv->var_table == NULL )
+        return NULL;
+
+    for( variable_t *p_var = priv->var_table[i_hash & priv->var_mask];
+         p_var != NULL; p_var = p_var->p_hash_next )
+        if( p_var->i_hash == i_hash && !strcmp( p_var->psz_name, psz_name ) )
+            return p_var;
+    return NULL;
 }
 
 static variable_t *Lookup( vlc_object_t *obj, const char *psz_name )
 {
-    vlc_object_internals_t *priv = vlc_internals( obj );
-    variable_t **pp_var;
+    return LookupHash( vlc_internals( obj ), psz_name, VarHash( psz_name ) );
+}
 
+/**
+ * Adds a variable to the hash table of its object. The table grows to keep
+ * about one variable per bucket.
+ */
+static int Insert( vlc_object_internals_t *priv, variable_t *p_var )
+{
     vlc_assert_locked( &priv->var_lock );
-    pp_var = tfind( &psz_name, &priv->var_root, varcmp );
-    return (pp_var != NULL) ? *pp_var : NULL;
+
+    if( priv->var_table == NULL || priv->var_count > priv->var_mask )
+    {
+        unsigned i_mask = (priv->var_table != NULL) ? 2 * priv->var_mask + 1
+                                                    : 15;
+        variable_t **pp_table = calloc( i_mask + 1, sizeof( *pp_table ) );
+
+        if( unlikely(pp_table == NULL) )
+        {
+            if( priv->var_table == NULL )
+                return VLC_ENOMEM;
+        }
+        else
+        {
+            for( unsigned i = 0; priv->var_table != NULL
+                              && i <= priv->var_mask; i++ )
+                for( variable_t *p_cur = priv->var_table[i], *p_next;
+                     p_cur != NULL; p_cur = p_next )
+                {
+                    p_next = p_cur->p_hash_next;
+                    p_cur->p_hash_next = pp_table[p_cur->i_hash & i_mask];
+                    pp_table[p_cur->i_hash & i_mask] = p_cur;
+                }
+            free( priv->var_table );
+            priv->var_table = pp_table;
+            priv->var_mask = i_mask;
+        }
+    }
+
+    variable_t **pp_bucket = &priv->var_table[p_var->i_hash & priv->var_mask];
+    p_var->p_hash_next = *pp_bucket;
+    *pp_bucket = p_var;
+    priv->var_count++;
+    return VLC_SUCCESS;
+}
+
+static void Remove( vlc_object_internals_t *priv, variable_t *p_var )
+{
+    vlc_assert_locked( &priv->var_lock );
+
+    for( variable_t **pp = &priv->var_table[p_var->i_hash & priv->var_mask];
+         *pp != NULL; pp = &(*pp)->p_hash_next )
+        if( *pp == p_var )
+        {
+            *pp = p_var->p_hash_next;
+            priv->var_count--;
+            return;
+        }
+    assert( 0 );
 }
 
 static void Destroy( variable_t *p_var )
@@ -199,9 +263,9 @@ static void Destroy( variable_t *p_var )
 /**
  * Initialize a vlc variable
  *
- * We hash the given string and insert it into the sorted list. The insertion
- * may require slow memory copies, but think about what we gain in the log(n)
- * lookup phase when setting/getting the variable value!
+ * We hash the given string and insert it into the hash table of the object,
+ * so that getting and setting the variable value only compares names with
+ * the same hash.
  *
  * \param p_this The object in which to create the variable
  * \param psz_name The name of the variable
@@ -217,6 +281,7 @@ int var_Create( vlc_object_t *p_this, const char *psz_name, int i_type )
         return VLC_ENOMEM;
 
     p_var->psz_name = strdup( psz_name );
+    p_var->i_hash = VarHash( psz_name );
     p_var->psz_text = NULL;
 
     p_var->i_type = i_type & ~VLC_VAR_DOINHERIT;
@@ -294,16 +359,18 @@ int var_Create( vlc_object_t *p_this, const char *psz_name, int i_type )
     }
 
     vlc_object_internals_t *p_priv = vlc_internals( p_this );
-    variable_t **pp_var, *p_oldvar;
+    variable_t *p_oldvar;
     int ret = VLC_SUCCESS;
 
     vlc_mutex_lock( &p_priv->var_lock );
 
-    pp_var = tsearch( p_var, &p_priv->var_root, varcmp );
-    if( unlikely(pp_var == NULL) )
-        ret = VLC_ENOMEM;
-    else if( (p_oldvar = *pp_var) == p_var )
-        p_var = NULL;
+    p_oldvar = LookupHash( p_priv, psz_name, p_var->i_hash );
+    if( p_oldvar == NULL )
+    {
+        ret = Insert( p_priv, p_var );
+        if( likely(ret == VLC_SUCCESS) )
+            p_var = NULL;
+    }
     else if( unlikely((i_type ^ p_oldvar->i_type) & VLC_VAR_CLASS) )
     {    /* If the types differ, variable creation failed. */
          msg_Err( p_this, "Variable '%s' (0x%04x) already exist "
@@ -328,8 +395,8 @@ int var_Create( vlc_object_t *p_this, const char *psz_name, int i_type )
 /**
  * Destroy a vlc variable
  *
- * Look for the variable and destroy it if it is found. As in var_Create we
- * do a call to memmove() but we have performance counterparts elsewhere.
+ * Look for the variable and destroy it if it is found, unless it was created
+ * (or its handle taken) more times than it was destroyed.
  *
  * \param p_this The object that holds the variable
  * \param psz_name The name of the variable
@@ -354,7 +421,7 @@ int var_Destroy( vlc_object_t *p_this, const char *psz_name )
     WaitUnused( p_this, p_var );
 
     if( --p_var->i_usage == 0 )
-        tdelete( p_var, &p_priv->var_root, varcmp );
+        Remove( p_priv, p_var );
     else
         p_var = NULL;
     vlc_mutex_unlock( &p_priv->var_lock );
@@ -364,17 +431,21 @@ int var_Destroy( vlc_object_t *p_this, const char *psz_name )
     return VLC_SUCCESS;
 }
 
-static void CleanupVar( void *var )
-{
-    Destroy( var );
-}
-
 void var_DestroyAll( vlc_object_t *obj )
 {
     vlc_object_internals_t *priv = vlc_internals( obj );
 
-    tdestroy( priv->var_root, CleanupVar );
-    priv->var_root = NULL;
+    for( unsigned i = 0; priv->var_table != NULL && i <= priv->var_mask; i++ )
+        for( variable_t *p_var = priv->var_table[i], *p_next;
+             p_var != NULL; p_var = p_next )
+        {
+            p_next = p_var->p_hash_next;
+            Destroy( p_var );
+        }
+    free( priv->var_table );
+    priv->var_table = NULL;
+    priv->var_mask = 0;
+    priv->var_count = 0;
 }
 
 #undef var_Change
@@ -718,33 +789,19 @@ int var_Type( vlc_object_t *p_this, const char *psz_name )
     return i_type;
 }
 
-#undef var_SetChecked
-int var_SetChecked( vlc_object_t *p_this, const char *psz_name,
-                    int expected_type, vlc_value_t val )
+/* Sets a variable value, with the variables lock held */
+static int SetLocked( vlc_object_t *p_this, variable_t *p_var,
+                      int expected_type, vlc_value_t val )
 {
-    int i_ret = VLC_SUCCESS;
-    variable_t *p_var;
+    int i_ret;
     vlc_value_t oldval;
 
-    assert( p_this );
-
-    vlc_object_internals_t *p_priv = vlc_internals( p_this );
-
-    vlc_mutex_lock( &p_priv->var_lock );
-
-    p_var = Lookup( p_this, psz_name );
-    if( p_var == NULL )
-    {
-        vlc_mutex_unlock( &p_priv->var_lock );
-        return VLC_ENOVAR;
-    }
-
     assert( expected_type == 0 ||
             (p_var->i_type & VLC_VAR_CLASS) == expected_type );
 #ifndef NDEBUG
         /* Alert if the type is VLC_VAR_VOID */
         if( ( p_var->i_type & VLC_VAR_TYPE ) == VLC_VAR_VOID )
-            msg_Warn( p_this, "Calling var_Set on the void variable '%s' (0x%04x)", psz_name, p_var->i_type );
+            msg_Warn( p_this, "Calling var_Set on the void variable '%s' (0x%04x)", p_var->psz_name, p_var->i_type );
 #endif
 
 
@@ -761,12 +818,31 @@ int var_SetChecked( vlc_object_t *p_this, const char *psz_name,
     p_var->val = val;
 
     /* Deal with callbacks */
-    i_ret = TriggerCallback( p_this, p_var, psz_name, oldval );
+    i_ret = TriggerCallback( p_this, p_var, p_var->psz_name, oldval );
 
     WaitUnused( p_this, p_var );
 
     /* Free data if needed */
     p_var->ops->pf_free( &oldval );
+    return i_ret;
+}
+
+#undef var_SetChecked
+int var_SetChecked( vlc_object_t *p_this, const char *psz_name,
+                    int expected_type, vlc_value_t val )
+{
+    int i_ret = VLC_ENOVAR;
+    variable_t *p_var;
+
+    assert( p_this );
+
+    vlc_object_internals_t *p_priv = vlc_internals( p_this );
+
+    vlc_mutex_lock( &p_priv->var_lock );
+
+    p_var = Lookup( p_this, psz_name );
+    if( p_var != NULL )
+        i_ret = SetLocked( p_this, p_var, expected_type, val );
 
     vlc_mutex_unlock( &p_priv->var_lock );
 
@@ -786,6 +862,28 @@ int var_Set( vlc_object_t *p_this, const char *psz_name, vlc_value_t val )
     return var_SetChecked( p_this, psz_name, 0, val );
 }
 
+/* Gets a variable value, with the variables lock held */
+static void GetLocked( vlc_object_t *p_this, variable_t *p_var,
+                       int expected_type, vlc_value_t *p_val )
+{
+    assert( expected_type == 0 ||
+            (p_var->i_type & VLC_VAR_CLASS) == expected_type );
+
+    /* Really get the variable */
+    *p_val = p_var->val;
+
+#ifndef NDEBUG
+    /* Alert if the type is VLC_VAR_VOID */
+    if( ( p_var->i_type & VLC_VAR_TYPE ) == VLC_VAR_VOID )
+        msg_Warn( p_this, "Calling var_Get on the void variable '%s' (0x%04x)", p_var->psz_name, p_var->i_type );
+#else
+    (void) p_this;
+#endif
+
+    /* Duplicate value if needed */
+    p_var->ops->pf_dup( p_val );
+}
+
 #undef var_GetChecked
 int var_GetChecked( vlc_object_t *p_this, const char *psz_name,
                     int expected_type, vlc_value_t *p_val )
@@ -800,22 +898,7 @@ int var_GetChecked( vlc_object_t *p_this, const char *psz_name,
 
     p_var = Lookup( p_this, psz_name );
     if( p_var != NULL )
-    {
-        assert( expected_type == 0 ||
-                (p_var->i_type & VLC_VAR_CLASS) == expected_type );
-
-        /* Really get the variable */
-        *p_val = p_var->val;
-
-#ifndef NDEBUG
-        /* Alert if the type is VLC_VAR_VOID */
-        if( ( p_var->i_type & VLC_VAR_TYPE ) == VLC_VAR_VOID )
-            msg_Warn( p_this, "Calling var_Get on the void variable '%s' (0x%04x)", psz_name, p_var->i_type );
-#endif
-
-        /* Duplicate value if needed */
-        p_var->ops->pf_dup( p_val );
-    }
+        GetLocked( p_this, p_var, expected_type, p_val );
     else
         err = VLC_ENOVAR;
 
@@ -837,6 +920,83 @@ int var_Get( vlc_object_t *p_this, const char *psz_name, vlc_value_t *p_val )
     return var_GetChecked( p_this, psz_name, 0, p_val );
 }
 
+#undef var_Handle
+/**
+ * Gets a handle to an existing variable, to get and set its value
+ * repeatedly without looking its name up each time.
+ *
+ * The handle counts as a creation of the variable: the variable exists at
+ * least until var_HandleRelease() is called, which must happen before the
+ * object is destroyed.
+ *
+ * \param p_this The object that holds the variable
+ * \param psz_name The name of the variable
+ * \return the handle, or NULL if the variable does not exist
+ */
+vlc_var_handle_t *var_Handle( vlc_object_t *p_this, const char *psz_name )
+{
+    vlc_object_internals_t *p_priv = vlc_internals( p_this );
+    variable_t *p_var;
+
+    vlc_mutex_lock( &p_priv->var_lock );
+    p_var = Lookup( p_this, psz_name );
+    if( p_var != NULL )
+        p_var->i_usage++;
+    vlc_mutex_unlock( &p_priv->var_lock );
+    return p_var;
+}
+
+#undef var_HandleRelease
+/**
+ * Releases a handle from var_Handle(), like var_Destroy().
+ */
+void var_HandleRelease( vlc_object_t *p_this, vlc_var_handle_t *p_var )
+{
+    vlc_object_internals_t *p_priv = vlc_internals( p_this );
+
+    vlc_mutex_lock( &p_priv->var_lock );
+    WaitUnused( p_this, p_var );
+    if( --p_var->i_usage == 0 )
+        Remove( p_priv, p_var );
+    else
+        p_var = NULL;
+    vlc_mutex_unlock( &p_priv->var_lock );
+
+    if( p_var != NULL )
+        Destroy( p_var );
+}
+
+#undef var_HandleGet
+/**
+ * Gets the value of a variable through its handle, see var_GetChecked().
+ */
+int var_HandleGet( vlc_object_t *p_this, vlc_var_handle_t *p_var,
+                   int expected_type, vlc_value_t *p_val )
+{
+    vlc_object_internals_t *p_priv = vlc_internals( p_this );
+
+    vlc_mutex_lock( &p_priv->var_lock );
+    GetLocked( p_this, p_var, expected_type, p_val );
+    vlc_mutex_unlock( &p_priv->var_lock );
+    return VLC_SUCCESS;
+}
+
+#undef var_HandleSet
+/**
+ * Sets the value of a variable through its handle, see var_SetChecked().
+ */
+int var_HandleSet( vlc_object_t *p_this, vlc_var_handle_t *p_var,
+                   int expected_type, vlc_value_t val )
+{
+    vlc_object_internals_t *p_priv = vlc_internals( p_this );
+    int i_ret;
+
+    vlc_mutex_lock( &p_priv->var_lock );
+    i_ret = SetLocked( p_this, p_var, expected_type, val );
+    vlc_mutex_unlock( &p_priv->var_lock );
+    return i_ret;
+}
+
 #undef var_AddCallback
 /**
  * Register a callback in a variable
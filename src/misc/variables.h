@@ -39,7 +39,9 @@ typedef struct variable_ops_t
  */
 struct variable_t
 {
-    char *       psz_name; /**< The variable unique name (must be first) */
+    char *       psz_name; /**< The variable unique name */
+    unsigned     i_hash;   /**< Hash of the name */
+    struct variable_t *p_hash_next; /**< Next variable in the same bucket */
 
     /** The variable's exported value */
     vlc_value_t  val;
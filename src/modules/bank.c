@@ -31,6 +31,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 #include <assert.h>
 
 #include <sys/types.h>
@@ -49,12 +50,25 @@
 #include "config/configuration.h"
 #include "modules/modules.h"
 
+/** Modules of a capability, by decreasing score */
+typedef struct
+{
+    const char *name;
+    module_t  **modules;
+    size_t      count;
+} module_cap_t;
+
 static struct
 {
     vlc_mutex_t lock;
     module_t *head;
     unsigned usage;
-} modules = { VLC_STATIC_MUTEX, NULL, 0 };
+
+    /* Capability index, sorted by name */
+    module_cap_t *caps;
+    size_t cap_count;
+    module_t **cap_modules;
+} modules = { VLC_STATIC_MUTEX, NULL, 0, NULL, 0, NULL };
 
 /*****************************************************************************
  * Local prototypes
@@ -63,6 +77,8 @@ static struct
 static void AllocateAllPlugins (vlc_object_t *);
 #endif
 static module_t *module_InitStatic (vlc_plugin_cb);
+static void module_IndexCaps (void);
+static void module_UnindexCaps (void);
 
 static void module_StoreBank (module_t *module)
 {
@@ -117,6 +133,7 @@ void module_InitBank (void)
 
         module_InitStaticModules();
         config_SortConfig ();
+        module_IndexCaps ();
     }
     modules.usage++;
 
@@ -137,6 +154,9 @@ void module_InitBank (void)
 void module_EndBank (bool b_plugins)
 {
     module_t *head = NULL;
+#ifdef HAVE_DYNAMIC_PLUGINS
+    module_cache_file_t *files = NULL;
+#endif
 
     /* If plugins were _not_ loaded, then the caller still has the bank lock
      * from module_InitBank(). */
@@ -149,8 +169,12 @@ void module_EndBank (bool b_plugins)
     if (--modules.usage == 0)
     {
         config_UnsortConfig ();
+        module_UnindexCaps ();
         head = modules.head;
         modules.head = NULL;
+#ifdef HAVE_DYNAMIC_PLUGINS
+        files = CacheTakeFiles ();
+#endif
     }
     vlc_mutex_unlock (&modules.lock);
 
@@ -168,6 +192,10 @@ void module_EndBank (bool b_plugins)
 #endif
         vlc_module_destroy (module);
     }
+#ifdef HAVE_DYNAMIC_PLUGINS
+    /* Cached modules use the cache files: release them last */
+    CacheReleaseFiles (files);
+#endif
 }
 
 #undef module_LoadPlugins
@@ -189,6 +217,8 @@ size_t module_LoadPlugins (vlc_object_t *obj)
         AllocateAllPlugins (obj);
         config_UnsortConfig ();
         config_SortConfig ();
+        module_UnindexCaps ();
+        module_IndexCaps ();
     }
 #endif
     vlc_mutex_unlock (&modules.lock);
@@ -200,6 +230,93 @@ size_t module_LoadPlugins (vlc_object_t *obj)
     return count;
 }
 
+static int modulecapcmp (const void *a, const void *b)
+{
+    const module_t *ma = *(module_t *const *)a, *mb = *(module_t *const *)b;
+    int ret = strcmp (ma->psz_capability, mb->psz_capability);
+
+    return ret ? ret : (mb->i_score - ma->i_score);
+}
+
+/**
+ * Indexes the modules by capability, so that module_list_cap() need not
+ * scan the whole module bank each time.
+ */
+static void module_IndexCaps (void)
+{
+    /*vlc_assert_locked (&modules.lock); not for static mutexes :( */
+    size_t count;
+    module_t **list = module_list_get (&count);
+    if (list == NULL)
+        return;
+
+    /* Keep only the modules that have a capability */
+    size_t n = 0;
+    for (size_t i = 0; i < count; i++)
+        if (list[i]->psz_capability != NULL)
+            list[n++] = list[i];
+    qsort (list, n, sizeof (*list), modulecapcmp);
+
+    module_cap_t *caps = malloc (n * sizeof (*caps));
+    if (unlikely(caps == NULL && n > 0))
+    {
+        module_list_free (list);
+        return;
+    }
+
+    size_t cap_count = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        if (cap_count == 0 || strcmp (caps[cap_count - 1].name,
+                                      list[i]->psz_capability))
+        {
+            caps[cap_count].name = list[i]->psz_capability;
+            caps[cap_count].modules = list + i;
+            caps[cap_count].count = 0;
+            cap_count++;
+        }
+        caps[cap_count - 1].count++;
+    }
+
+    modules.caps = caps;
+    modules.cap_count = cap_count;
+    modules.cap_modules = list;
+}
+
+static void module_UnindexCaps (void)
+{
+    free (modules.caps);
+    module_list_free (modules.cap_modules);
+    modules.caps = NULL;
+    modules.cap_count = 0;
+    modules.cap_modules = NULL;
+}
+
+static int modulecapfind (const void *key, const void *cap)
+{
+    return strcmp (key, ((const module_cap_t *)cap)->name);
+}
+
+/**
+ * Gets the modules providing a capability.
+ * @param list [OUT] table of the modules, by decreasing score. It belongs to
+ *             the module bank and must not be freed.
+ * @param cap capability
+ * @return number of modules in the table
+ */
+size_t module_list_cap (module_t *const **list, const char *cap)
+{
+    const module_cap_t *c = bsearch (cap, modules.caps, modules.cap_count,
+                                     sizeof (*c), modulecapfind);
+    if (c == NULL)
+    {
+        *list = NULL;
+        return 0;
+    }
+    *list = c->modules;
+    return c->count;
+}
+
 /**
  * Frees the flat list of VLC modules.
  * @param list list obtained by module_list_get()
@@ -311,10 +428,16 @@ typedef struct module_bank
 
     int            i_loaded_cache;
     module_cache_t *loaded_cache;
+    bool           uptodate;
+
+    size_t         i_dirs;
+    module_cache_dir_t *dirs;
+    time_t         start;
 } module_bank_t;
 
 static void AllocatePluginDir (module_bank_t *, unsigned,
                                const char *, const char *);
+static void AllocateCachedPlugins (module_bank_t *);
 
 /**
  * Scans for plug-ins within a file system hierarchy.
@@ -326,11 +449,12 @@ static void AllocatePluginPath (vlc_object_t *p_this, const char *path,
     module_bank_t bank;
     module_cache_t *cache = NULL;
     size_t count = 0;
+    bool uptodate = false;
 
     switch( mode )
     {
         case CACHE_USE:
-            count = CacheLoad( p_this, path, &cache );
+            count = CacheLoad( p_this, path, &cache, &uptodate );
             break;
         case CACHE_RESET:
             CacheDelete( p_this, path );
@@ -339,8 +463,6 @@ static void AllocatePluginPath (vlc_object_t *p_this, const char *path,
             msg_Dbg( p_this, "ignoring plugins cache file" );
     }
 
-    msg_Dbg( p_this, "recursively browsing `%s'", path );
-
     bank.obj = p_this;
     bank.base = path;
     bank.mode = mode;
@@ -348,23 +470,39 @@ static void AllocatePluginPath (vlc_object_t *p_this, const char *path,
     bank.i_cache = 0;
     bank.loaded_cache = cache;
     bank.i_loaded_cache = count;
+    bank.uptodate = uptodate;
+    bank.dirs = NULL;
+    bank.i_dirs = 0;
+    bank.start = time (NULL);
 
-    /* Don't go deeper than 5 subdirectories */
-    AllocatePluginDir (&bank, 5, path, NULL);
+    if (uptodate)
+    {
+        msg_Dbg( p_this, "plugins cache of `%s' is up to date", path );
+        AllocateCachedPlugins (&bank);
+    }
+    else
+    {
+        msg_Dbg( p_this, "recursively browsing `%s'", path );
+        /* Don't go deeper than 5 subdirectories */
+        AllocatePluginDir (&bank, 5, path, NULL);
+    }
 
     switch( mode )
     {
         case CACHE_USE:
-            /* Discard unmatched cache entries */
+            /* Discard unmatched cache entries. Their paths belong to the
+             * cache file. */
             for( size_t i = 0; i < count; i++ )
             {
                 if (cache[i].p_module != NULL)
                    vlc_module_destroy (cache[i].p_module);
-                free (cache[i].path);
             }
             free( cache );
+            if (uptodate)
+                break; /* nothing to save */
         case CACHE_RESET:
-            CacheSave (p_this, path, bank.cache, bank.i_cache);
+            CacheSave (p_this, path, bank.cache, bank.i_cache,
+                       bank.dirs, bank.i_dirs);
         case CACHE_IGNORE:
             break;
     }
@@ -373,6 +511,37 @@ static void AllocatePluginPath (vlc_object_t *p_this, const char *path,
 static int AllocatePluginFile (module_bank_t *, const char *,
                                const char *, const struct stat *);
 
+/**
+ * Registers the plug-ins of an up-to-date cache, without browsing the
+ * plug-in directories.
+ */
+static void AllocateCachedPlugins (module_bank_t *bank)
+{
+    module_cache_t *cache = bank->loaded_cache;
+    size_t count = bank->i_loaded_cache;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        char *abspath;
+        struct stat st;
+
+        if (asprintf (&abspath, "%s"DIR_SEP"%s", bank->base,
+                      cache[i].path) == -1)
+            continue;
+
+        memset (&st, 0, sizeof (st));
+        st.st_mtime = cache[i].mtime;
+        st.st_size = cache[i].size;
+        /* Only the matching entry needs to be looked up */
+        bank->loaded_cache = cache + i;
+        bank->i_loaded_cache = 1;
+        AllocatePluginFile (bank, abspath, cache[i].path, &st);
+        free (abspath);
+    }
+    bank->loaded_cache = cache;
+    bank->i_loaded_cache = count;
+}
+
 /**
  * Recursively browses a directory to look for plug-ins.
  */
@@ -383,6 +552,17 @@ static void AllocatePluginDir (module_bank_t *bank, unsigned maxdepth,
         return;
     maxdepth--;
 
+    /* Check the directory mtime before reading it, for the cache */
+    struct stat dirst;
+    uint32_t hash = 0;
+    bool record = bank->mode != CACHE_IGNORE
+               && vlc_stat (absdir, &dirst) == 0;
+
+    /* A later change within the same second would go unnoticed: do not
+     * trust a directory modified since the scan started. */
+    if (record && dirst.st_mtime >= bank->start)
+        dirst.st_mtime = (time_t)-1;
+
     DIR *dh = vlc_opendir (absdir);
     if (dh == NULL)
         return;
@@ -393,6 +573,7 @@ static void AllocatePluginDir (module_bank_t *bank, unsigned maxdepth,
         char *file = vlc_readdir (dh), *relpath = NULL, *abspath = NULL;
         if (file == NULL)
             break;
+        CacheHashEntry (&hash, file);
 
         /* Skip ".", ".." */
         if (!strcmp (file, ".") || !strcmp (file, ".."))
@@ -448,6 +629,10 @@ static void AllocatePluginDir (module_bank_t *bank, unsigned maxdepth,
         free (file);
     }
     closedir (dh);
+
+    if (record)
+        CacheAddDir (&bank->dirs, &bank->i_dirs,
+                     (reldir != NULL) ? reldir : "", &dirst, hash);
 }
 
 static module_t *module_InitDynamic (vlc_object_t *, const char *, bool);
@@ -506,7 +691,8 @@ static int AllocatePluginFile (module_bank_t *bank, const char *abspath,
 
     module_StoreBank (module);
 
-    if (bank->mode != CACHE_IGNORE) /* Add entry to cache */
+    /* Add entry to cache, unless it is up to date already */
+    if (bank->mode != CACHE_IGNORE && !bank->uptodate)
         CacheAdd (&bank->cache, &bank->i_cache, relpath, st, module);
     /* TODO: deal with errors */
     return  0;
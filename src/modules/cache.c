@@ -35,13 +35,18 @@
 #include <stdio.h>                                              /* sprintf() */
 #include <string.h>                                              /* strdup() */
 #include <vlc_plugin.h>
+#include <vlc_memstats.h>
 #include <errno.h>
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <fcntl.h>
 #ifdef HAVE_UNISTD_H
 #   include <unistd.h>
 #endif
+#ifdef HAVE_MMAP
+#   include <sys/mman.h>
+#endif
 #include <assert.h>
 
 #include "config/configuration.h"
@@ -51,21 +56,111 @@
 #include "modules/modules.h"
 
 
-/*****************************************************************************
- * Local prototypes
- *****************************************************************************/
 #ifdef HAVE_DYNAMIC_PLUGINS
-static int    CacheLoadConfig  ( module_t *, FILE * );
-
 /* Sub-version number
  * (only used to avoid breakage in dev version when cache structure changes) */
-#define CACHE_SUBVERSION_NUM 18
+#define CACHE_SUBVERSION_NUM 20
 
 /* Cache filename */
 #define CACHE_NAME "plugins.dat"
 /* Magic for the cache filename */
 #define CACHE_STRING "cache "PACKAGE_NAME" "PACKAGE_VERSION
+#ifdef DISTRO_VERSION
+/* Allow binary maintaner to pass a string to detect new binary version */
+# define CACHE_MAGIC CACHE_STRING DISTRO_VERSION
+#else
+# define CACHE_MAGIC CACHE_STRING
+#endif
+
+/*
+ * The cache file is mapped and used in place: the module descriptors point
+ * to the strings therein, and nothing is parsed. Records are found by their
+ * offset from the start of the file, zero standing for NULL (it is the magic
+ * string). Strings are stored once, however many modules use them.
+ *
+ * Each browsed directory is recorded too, with a hash of its entry names
+ * and its mtime. If none changed, the cached plug-ins are registered as they
+ * are, without browsing nor stat'ing any plug-in file. The base directory
+ * mtime is not checked, as saving the cache itself changes it.
+ */
+typedef uint32_t cache_ref_t;
+
+#define CACHE_ALIGN(x) (((x) + 7) & ~(size_t)7)
+#define CACHE_HEADER   CACHE_ALIGN(sizeof (CACHE_MAGIC) - 1)
+
+typedef struct
+{
+    uint32_t    subversion;
+    uint32_t    size;       /* file size */
+    uint32_t    plugins;
+    cache_ref_t plugin;     /* table of cache_plugin_t */
+    uint32_t    dirs;
+    cache_ref_t dir;        /* table of cache_dir_t */
+} cache_header_t;
+
+typedef struct
+{
+    int64_t     mtime;
+    int64_t     size;
+    cache_ref_t path;
+    cache_ref_t module;     /* cache_module_t */
+} cache_plugin_t;
+
+typedef struct
+{
+    int64_t     mtime;
+    cache_ref_t path;       /* relative to the plug-ins base directory */
+    uint32_t    hash;       /* hash of the entry names */
+} cache_dir_t;
+
+typedef struct
+{
+    cache_ref_t shortname;
+    cache_ref_t longname;
+    cache_ref_t help;
+    cache_ref_t capability;
+    cache_ref_t domain;
+    cache_ref_t shortcuts;  /* table of i_shortcuts strings */
+    uint32_t    i_shortcuts;
+    int32_t     i_score;
+    uint32_t    b_unloadable;
+    uint32_t    i_config_items;
+    uint32_t    i_bool_items;
+    uint32_t    confsize;
+    cache_ref_t config;     /* table of cache_config_t */
+    uint32_t    submodules;
+    cache_ref_t submodule;  /* table of cache_module_t */
+    uint32_t    i_codecs;
+    cache_ref_t codecs;     /* table of i_codecs FourCCs */
+    uint32_t    reserved;
+} cache_module_t;
+
+typedef struct
+{
+    module_config_t item;   /* pointers therein are meaningless */
+    cache_ref_t type;
+    cache_ref_t name;
+    cache_ref_t text;
+    cache_ref_t longtext;
+    cache_ref_t orig;
+    cache_ref_t list;       /* table of i_list strings */
+    cache_ref_t list_text;  /* table of i_list strings */
+    cache_ref_t int_list;   /* table of i_list integers */
+    cache_ref_t action_text;/* table of i_action strings */
+    uint32_t    reserved;
+} cache_config_t;
+
+/** A loaded cache file */
+struct module_cache_file_t
+{
+    module_cache_file_t *next;
+    const uint8_t       *base;
+    size_t               size;
+};
 
+/* Loaded cache files. They are released with the module bank, and protected
+ * by its lock. */
+static module_cache_file_t *cache_files = NULL;
 
 void CacheDelete( vlc_object_t *obj, const char *dir )
 {
@@ -80,6 +175,334 @@ void CacheDelete( vlc_object_t *obj, const char *dir )
     free( path );
 }
 
+static module_cache_file_t *CacheMap (int fd, size_t size)
+{
+    module_cache_file_t *file = malloc (sizeof (*file));
+    if (unlikely(file == NULL))
+        return NULL;
+
+#ifdef HAVE_MMAP
+    void *addr = mmap (NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED)
+    {
+        free (file);
+        return NULL;
+    }
+#else
+    uint8_t *addr = malloc (size);
+    if (unlikely(addr == NULL))
+    {
+        free (file);
+        return NULL;
+    }
+    for (size_t done = 0; done < size;)
+    {
+        ssize_t val = read (fd, addr + done, size - done);
+        if (val <= 0)
+        {
+            free (addr);
+            free (file);
+            return NULL;
+        }
+        done += val;
+    }
+#endif
+    file->next = NULL;
+    file->base = addr;
+    file->size = size;
+    VLC_MEM_ALLOC (VLC_MEM_MODULES, size);
+    return file;
+}
+
+static void CacheUnmap (module_cache_file_t *file)
+{
+    VLC_MEM_FREE (VLC_MEM_MODULES, file->size);
+#ifdef HAVE_MMAP
+    munmap ((void *)file->base, file->size);
+#else
+    free ((void *)file->base);
+#endif
+    free (file);
+}
+
+/**
+ * Takes the list of the loaded cache files, once the module bank is empty.
+ */
+module_cache_file_t *CacheTakeFiles (void)
+{
+    module_cache_file_t *files = cache_files;
+
+    cache_files = NULL;
+    return files;
+}
+
+/**
+ * Releases cache files, once no modules use them anymore.
+ */
+void CacheReleaseFiles (module_cache_file_t *files)
+{
+    while (files != NULL)
+    {
+        module_cache_file_t *next = files->next;
+
+        CacheUnmap (files);
+        files = next;
+    }
+}
+
+/* Looks up a table of count records of the given size */
+static bool CacheTable (const module_cache_file_t *file, cache_ref_t ref,
+                        size_t count, size_t size, const void **tab)
+{
+    *tab = NULL;
+    if (count == 0)
+        return true;
+    if (ref == 0 || (ref & 7) || ref > file->size
+     || count > (file->size - ref) / size)
+        return false;
+    *tab = file->base + ref;
+    return true;
+}
+
+/* Looks up a string. The file ends with a nul byte, so any string in it
+ * is terminated. */
+static bool CacheString (const module_cache_file_t *file, cache_ref_t ref,
+                         char **str)
+{
+    if (ref >= file->size)
+        return false;
+    *str = (ref != 0) ? (char *)(file->base + ref) : NULL;
+    return true;
+}
+
+/* Looks up a table of count strings, into a new NULL-terminated array */
+static bool CacheStrings (const module_cache_file_t *file, cache_ref_t ref,
+                          size_t count, char ***tabp)
+{
+    const cache_ref_t *refs;
+
+    *tabp = NULL;
+    if (!CacheTable (file, ref, count, sizeof (*refs), (const void **)&refs))
+        return false;
+
+    char **tab = malloc ((count + 1) * sizeof (*tab));
+    if (unlikely(tab == NULL))
+        return false;
+    for (size_t i = 0; i < count; i++)
+        if (!CacheString (file, refs[i], tab + i))
+        {
+            free (tab);
+            return false;
+        }
+    tab[count] = NULL;
+    *tabp = tab;
+    return true;
+}
+
+static bool CacheLoadConfig (const module_cache_file_t *file,
+                             module_config_t *item, const cache_config_t *rec)
+{
+    *item = rec->item;
+    item->value.psz = NULL;
+    item->ppsz_list = NULL;
+    item->pi_list = NULL;
+    item->ppsz_list_text = NULL;
+    item->ppf_action = NULL;
+    item->ppsz_action_text = NULL;
+    item->b_dirty = false;
+
+    if (!CacheString (file, rec->type, &item->psz_type)
+     || !CacheString (file, rec->name, &item->psz_name)
+     || !CacheString (file, rec->text, &item->psz_text)
+     || !CacheString (file, rec->longtext, &item->psz_longtext))
+        return false;
+
+    if (IsConfigStringType (item->i_type))
+    {
+        if (!CacheString (file, rec->orig, &item->orig.psz))
+            return false;
+        if (item->orig.psz != NULL)
+        {
+            item->value.psz = strdup (item->orig.psz);
+            if (unlikely(item->value.psz == NULL))
+                return false;
+        }
+    }
+    else
+        item->value = item->orig;
+
+    if (item->i_list < 0 || item->i_action < 0)
+        return false;
+    if (item->i_list > 0)
+    {
+        const void *ints;
+
+        if ((rec->list != 0
+          && !CacheStrings (file, rec->list, item->i_list, &item->ppsz_list))
+         || (rec->list_text != 0
+          && !CacheStrings (file, rec->list_text, item->i_list,
+                            &item->ppsz_list_text)))
+            return false;
+        if (rec->int_list != 0)
+        {
+            if (!CacheTable (file, rec->int_list, item->i_list, sizeof (int),
+                             &ints))
+                return false;
+            item->pi_list = (int *)ints;
+        }
+    }
+
+    if (item->i_action > 0)
+    {
+        item->ppf_action = calloc (item->i_action, sizeof (vlc_callback_t));
+        if (unlikely(item->ppf_action == NULL)
+         || !CacheStrings (file, rec->action_text, item->i_action,
+                           &item->ppsz_action_text))
+            return false;
+    }
+    return true;
+}
+
+static module_t *CacheLoadModule (const module_cache_file_t *file,
+                                  const cache_module_t *rec, module_t *parent)
+{
+    const cache_config_t *config;
+    const cache_module_t *submodules;
+
+    module_t *module = vlc_module_create (parent);
+    if (unlikely(module == NULL))
+        return NULL;
+    module->b_cached = true;
+
+    if (rec->i_shortcuts > MODULE_SHORTCUT_MAX
+     || !CacheString (file, rec->shortname, &module->psz_shortname)
+     || !CacheString (file, rec->longname, &module->psz_longname)
+     || !CacheString (file, rec->help, &module->psz_help)
+     || !CacheString (file, rec->capability, &module->psz_capability)
+     || !CacheString (file, rec->domain, &module->domain)
+     || !CacheStrings (file, rec->shortcuts, rec->i_shortcuts,
+                       &module->pp_shortcuts))
+        goto error;
+    module->i_shortcuts = rec->i_shortcuts;
+    module->i_score = rec->i_score;
+
+    const void *codecs;
+    if (!CacheTable (file, rec->codecs, rec->i_codecs, sizeof (vlc_fourcc_t),
+                     &codecs))
+        goto error;
+    module->p_codecs = (vlc_fourcc_t *)codecs;
+    module->i_codecs = rec->i_codecs;
+    if (parent != NULL)
+        return module;
+
+    module->b_unloadable = rec->b_unloadable != 0;
+
+    /* Config stuff */
+    if (!CacheTable (file, rec->config, rec->confsize, sizeof (*config),
+                     (const void **)&config))
+        goto error;
+    if (rec->confsize > 0)
+    {
+        module->p_config = calloc (rec->confsize, sizeof (module_config_t));
+        if (unlikely(module->p_config == NULL))
+            goto error;
+    }
+    for (size_t i = 0; i < rec->confsize; i++)
+    {
+        module->confsize = i + 1;
+        if (!CacheLoadConfig (file, module->p_config + i, config + i))
+            goto error;
+    }
+    module->i_config_items = rec->i_config_items;
+    module->i_bool_items = rec->i_bool_items;
+
+    if (module->domain != NULL)
+        vlc_bindtextdomain (module->domain);
+
+    /* Submodules are prepended, so load them backward */
+    if (!CacheTable (file, rec->submodule, rec->submodules,
+                     sizeof (*submodules), (const void **)&submodules))
+        goto error;
+    for (size_t i = rec->submodules; i > 0; i--)
+        if (CacheLoadModule (file, submodules + i - 1, module) == NULL)
+            goto error;
+    return module;
+
+error:
+    if (parent == NULL)
+        vlc_module_destroy (module);
+    return NULL;
+}
+
+/**
+ * Accounts for a directory entry in the hash of its directory.
+ * The hash does not depend on the order of the entries.
+ */
+void CacheHashEntry (uint32_t *hash, const char *name)
+{
+    /* Skip the cache file, and the temporary copies of it */
+    if (!strncmp (name, CACHE_NAME, strlen (CACHE_NAME)))
+        return;
+
+    uint32_t h = 2166136261u;
+    while (*name)
+        h = (h ^ (unsigned char)*(name++)) * 16777619u;
+    *hash += h;
+}
+
+static bool CacheDirUpToDate (const char *path, const cache_dir_t *rec,
+                              bool base)
+{
+    struct stat st;
+
+    if (!base && (vlc_stat (path, &st) != 0 || st.st_mtime != rec->mtime))
+        return false;
+
+    DIR *dh = vlc_opendir (path);
+    if (dh == NULL)
+        return false;
+
+    uint32_t hash = 0;
+    char *name;
+    while ((name = vlc_readdir (dh)) != NULL)
+    {
+        CacheHashEntry (&hash, name);
+        free (name);
+    }
+    closedir (dh);
+    return hash == rec->hash;
+}
+
+/* Checks that none of the browsed directories changed since the cache
+ * was saved. */
+static bool CacheUpToDate (const module_cache_file_t *file, const char *dir,
+                           const cache_dir_t *dirs, size_t count)
+{
+    if (count == 0)
+        return false;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        char *rel, *path;
+        bool ok;
+
+        if (!CacheString (file, dirs[i].path, &rel) || rel == NULL)
+            return false;
+        if (*rel == '\0')
+            path = strdup (dir);
+        else if (asprintf (&path, "%s"DIR_SEP"%s", dir, rel) == -1)
+            path = NULL;
+        if (unlikely(path == NULL))
+            return false;
+
+        ok = CacheDirUpToDate (path, dirs + i, *rel == '\0');
+        free (path);
+        if (!ok)
+            return false;
+    }
+    return true;
+}
+
 /**
  * Loads a plugins cache file.
  *
@@ -87,26 +510,27 @@ void CacheDelete( vlc_object_t *obj, const char *dir )
  * will in turn be queried by AllocateAllPlugins() to see if it needs to
  * actually load the dynamically loadable module.
  * This allows us to only fully load plugins when they are actually used.
+ *
+ * \param uptodate set if the plug-in directories were not modified since
+ *                 the cache was saved, so that they need not be browsed
  */
-size_t CacheLoad( vlc_object_t *p_this, const char *dir, module_cache_t **r )
+size_t CacheLoad( vlc_object_t *p_this, const char *dir, module_cache_t **r,
+                  bool *uptodate )
 {
     char *psz_filename;
-    FILE *file;
-    int i_size, i_read;
-    char p_cachestring[sizeof(CACHE_STRING)];
-    size_t i_cache;
-    int32_t i_marker;
+    struct stat st;
 
     assert( dir != NULL );
 
     *r = NULL;
+    *uptodate = false;
     if( asprintf( &psz_filename, "%s"DIR_SEP CACHE_NAME, dir ) == -1 )
         return 0;
 
     msg_Dbg( p_this, "loading plugins cache file %s", psz_filename );
 
-    file = vlc_fopen( psz_filename, "rb" );
-    if( !file )
+    int fd = vlc_open( psz_filename, O_RDONLY );
+    if( fd == -1 )
     {
         msg_Warn( p_this, "cannot read %s (%m)",
                   psz_filename );
@@ -115,286 +539,123 @@ size_t CacheLoad( vlc_object_t *p_this, const char *dir, module_cache_t **r )
     }
     free( psz_filename );
 
-    /* Check the file is a plugins cache */
-    i_size = sizeof(CACHE_STRING) - 1;
-    i_read = fread( p_cachestring, 1, i_size, file );
-    if( i_read != i_size ||
-        memcmp( p_cachestring, CACHE_STRING, i_size ) )
+    module_cache_file_t *file = NULL;
+    if( fstat( fd, &st ) == 0
+     && st.st_size >= (off_t)(CACHE_HEADER + sizeof (cache_header_t))
+     && (uintmax_t)st.st_size <= UINT32_MAX )
+        file = CacheMap( fd, st.st_size );
+    close( fd );
+    if( file == NULL )
     {
         msg_Warn( p_this, "This doesn't look like a valid plugins cache" );
-        fclose( file );
         return 0;
     }
 
-#ifdef DISTRO_VERSION
-    /* Check for distribution specific version */
-    char p_distrostring[sizeof( DISTRO_VERSION )];
-    i_size = sizeof( DISTRO_VERSION ) - 1;
-    i_read = fread( p_distrostring, 1, i_size, file );
-    if( i_read != i_size ||
-        memcmp( p_distrostring, DISTRO_VERSION, i_size ) )
+    /* Check the file is a plugins cache */
+    if( memcmp( file->base, CACHE_MAGIC, sizeof (CACHE_MAGIC) - 1 ) )
     {
         msg_Warn( p_this, "This doesn't look like a valid plugins cache" );
-        fclose( file );
+        CacheUnmap( file );
         return 0;
     }
-#endif
 
-    /* Check Sub-version number */
-    i_read = fread( &i_marker, 1, sizeof(i_marker), file );
-    if( i_read != sizeof(i_marker) || i_marker != CACHE_SUBVERSION_NUM )
+    /* Check Sub-version number and size */
+    const cache_header_t *hdr =
+        (const cache_header_t *)(file->base + CACHE_HEADER);
+    if( hdr->subversion != CACHE_SUBVERSION_NUM || hdr->size != file->size
+     || file->base[file->size - 1] != '\0' )
     {
         msg_Warn( p_this, "This doesn't look like a valid plugins cache "
                   "(corrupted header)" );
-        fclose( file );
-        return 0;
-    }
-
-    /* Check header marker */
-    i_read = fread( &i_marker, 1, sizeof(i_marker), file );
-    if( i_read != sizeof(i_marker) ||
-        i_marker != ftell( file ) - (int)sizeof(i_marker) )
-    {
-        msg_Warn( p_this, "This doesn't look like a valid plugins cache "
-                  "(corrupted header)" );
-        fclose( file );
-        return 0;
-    }
-
-    if (fread( &i_cache, 1, sizeof(i_cache), file ) != sizeof(i_cache) )
-    {
-        msg_Warn( p_this, "This doesn't look like a valid plugins cache "
-                  "(file too short)" );
-        fclose( file );
+        CacheUnmap( file );
         return 0;
     }
 
+    const cache_plugin_t *plugins;
+    const cache_dir_t *dirs;
     module_cache_t *cache = NULL;
+    size_t count = 0;
 
-#define LOAD_IMMEDIATE(a) \
-    if( fread( (void *)&a, sizeof(char), sizeof(a), file ) != sizeof(a) ) goto error
-#define LOAD_STRING(a) \
-{ \
-    a = NULL; \
-    if( ( fread( &i_size, sizeof(i_size), 1, file ) != 1 ) \
-     || ( i_size > 16384 ) ) \
-        goto error; \
-    if( i_size ) { \
-        char *psz = xmalloc( i_size ); \
-        if( fread( psz, i_size, 1, file ) != 1 ) { \
-            free( psz ); \
-            goto error; \
-        } \
-        if( psz[i_size-1] ) { \
-            free( psz ); \
-            goto error; \
-        } \
-        a = psz; \
-    } \
-}
+    if( !CacheTable( file, hdr->plugin, hdr->plugins, sizeof (*plugins),
+                     (const void **)&plugins )
+     || !CacheTable( file, hdr->dir, hdr->dirs, sizeof (*dirs),
+                     (const void **)&dirs ) )
+        goto error;
 
-    for (size_t count = 0; count < i_cache;)
+    if( hdr->plugins > 0 )
     {
-        module_t *module;
-        uint16_t i_size;
-        int i_submodules;
-
-        module = vlc_module_create (NULL);
-
-        /* Load additional infos */
-        LOAD_STRING(module->psz_shortname);
-        LOAD_STRING(module->psz_longname);
-        LOAD_STRING(module->psz_help);
-
-        LOAD_IMMEDIATE(module->i_shortcuts);
-        if (module->i_shortcuts > MODULE_SHORTCUT_MAX)
+        cache = malloc( hdr->plugins * sizeof (*cache) );
+        if( unlikely(cache == NULL) )
             goto error;
-        else
-        {
-            module->pp_shortcuts =
-                              xmalloc (sizeof (char **) * module->i_shortcuts);
-            for (unsigned j = 0; j < module->i_shortcuts; j++)
-                LOAD_STRING(module->pp_shortcuts[j]);
-        }
+    }
 
-        LOAD_STRING(module->psz_capability);
-        LOAD_IMMEDIATE(module->i_score);
-        LOAD_IMMEDIATE(module->b_unloadable);
+    for( ; count < hdr->plugins; count++ )
+    {
+        const cache_plugin_t *plugin = plugins + count;
+        const cache_module_t *rec;
 
-        /* Config stuff */
-        if (CacheLoadConfig (module, file) != VLC_SUCCESS)
+        if( !CacheString( file, plugin->path, &cache[count].path )
+         || cache[count].path == NULL
+         || !CacheTable( file, plugin->module, 1, sizeof (*rec),
+                         (const void **)&rec ) )
             goto error;
-
-        LOAD_STRING(module->domain);
-        if (module->domain != NULL)
-            vlc_bindtextdomain (module->domain);
-
-        LOAD_IMMEDIATE( i_submodules );
-
-        while( i_submodules-- )
-        {
-            module_t *submodule = vlc_module_create (module);
-            free (submodule->pp_shortcuts);
-            LOAD_STRING(submodule->psz_shortname);
-            LOAD_STRING(submodule->psz_longname);
-
-            LOAD_IMMEDIATE(submodule->i_shortcuts);
-            if (submodule->i_shortcuts > MODULE_SHORTCUT_MAX)
-                goto error;
-            else
-            {
-                submodule->pp_shortcuts =
-                           xmalloc (sizeof (char **) * submodule->i_shortcuts);
-                for (unsigned j = 0; j < submodule->i_shortcuts; j++)
-                    LOAD_STRING(submodule->pp_shortcuts[j]);
-            }
-
-            LOAD_STRING(submodule->psz_capability);
-            LOAD_IMMEDIATE(submodule->i_score);
-        }
-
-        char *path;
-        struct stat st;
-
-        /* Load common info */
-        LOAD_STRING(path);
-        if (path == NULL)
+        cache[count].mtime = plugin->mtime;
+        cache[count].size = plugin->size;
+        cache[count].p_module = CacheLoadModule( file, rec, NULL );
+        if( cache[count].p_module == NULL )
             goto error;
-        LOAD_IMMEDIATE(st.st_mtime);
-        LOAD_IMMEDIATE(st.st_size);
-
-        CacheAdd (&cache, &count, path, &st, module);
-        free (path);
-        /* TODO: deal with errors */
     }
-    fclose( file );
 
+    *uptodate = CacheUpToDate( file, dir, dirs, hdr->dirs );
+
+    file->next = cache_files;
+    cache_files = file;
     *r = cache;
-    return i_cache;
+    return count;
 
 error:
     msg_Warn( p_this, "plugins cache not loaded (corrupted)" );
 
-    /* TODO: cleanup */
-    fclose( file );
+    while( count > 0 )
+        vlc_module_destroy( cache[--count].p_module );
+    free( cache );
+    CacheUnmap( file );
     return 0;
 }
 
-
-static int CacheLoadConfig( module_t *p_module, FILE *file )
+/**
+ * Destroys a module loaded from the cache; its strings belong to the cache.
+ * Submodules must have been destroyed already.
+ */
+void CacheFreeModule (module_t *module)
 {
-    uint32_t i_lines;
-    uint16_t i_size;
-
-    /* Calculate the structure length */
-    LOAD_IMMEDIATE( p_module->i_config_items );
-    LOAD_IMMEDIATE( p_module->i_bool_items );
-
-    LOAD_IMMEDIATE( i_lines );
-
-    /* Allocate memory */
-    if (i_lines)
+    for (size_t i = 0; i < module->confsize; i++)
     {
-        p_module->p_config =
-            (module_config_t *)calloc( i_lines, sizeof(module_config_t) );
-        if( p_module->p_config == NULL )
-        {
-            p_module->confsize = 0;
-            return VLC_ENOMEM;
-        }
+        module_config_t *item = module->p_config + i;
+
+        if (IsConfigStringType (item->i_type))
+            free (item->value.psz);
+        free (item->ppsz_list);
+        free (item->ppsz_list_text);
+        free (item->ppf_action);
+        free (item->ppsz_action_text);
     }
-    p_module->confsize = i_lines;
-
-    /* Do the duplication job */
-    for (size_t i = 0; i < i_lines; i++ )
-    {
-        LOAD_IMMEDIATE( p_module->p_config[i] );
-
-        LOAD_STRING( p_module->p_config[i].psz_type );
-        LOAD_STRING( p_module->p_config[i].psz_name );
-        LOAD_STRING( p_module->p_config[i].psz_text );
-        LOAD_STRING( p_module->p_config[i].psz_longtext );
-
-        if (IsConfigStringType (p_module->p_config[i].i_type))
-        {
-            LOAD_STRING (p_module->p_config[i].orig.psz);
-            p_module->p_config[i].value.psz =
-                    (p_module->p_config[i].orig.psz != NULL)
-                        ? strdup (p_module->p_config[i].orig.psz) : NULL;
-        }
-        else
-            memcpy (&p_module->p_config[i].value, &p_module->p_config[i].orig,
-                    sizeof (p_module->p_config[i].value));
-
-        p_module->p_config[i].b_dirty = false;
-
-        if( p_module->p_config[i].i_list )
-        {
-            if( p_module->p_config[i].ppsz_list )
-            {
-                int j;
-                p_module->p_config[i].ppsz_list =
-                    xmalloc( (p_module->p_config[i].i_list+1) * sizeof(char *));
-                if( p_module->p_config[i].ppsz_list )
-                {
-                    for( j = 0; j < p_module->p_config[i].i_list; j++ )
-                        LOAD_STRING( p_module->p_config[i].ppsz_list[j] );
-                    p_module->p_config[i].ppsz_list[j] = NULL;
-                }
-            }
-            if( p_module->p_config[i].ppsz_list_text )
-            {
-                int j;
-                p_module->p_config[i].ppsz_list_text =
-                    xmalloc( (p_module->p_config[i].i_list+1) * sizeof(char *));
-                if( p_module->p_config[i].ppsz_list_text )
-                {
-                  for( j = 0; j < p_module->p_config[i].i_list; j++ )
-                      LOAD_STRING( p_module->p_config[i].ppsz_list_text[j] );
-                  p_module->p_config[i].ppsz_list_text[j] = NULL;
-                }
-            }
-            if( p_module->p_config[i].pi_list )
-            {
-                p_module->p_config[i].pi_list =
-                    xmalloc( (p_module->p_config[i].i_list + 1) * sizeof(int) );
-                if( p_module->p_config[i].pi_list )
-                {
-                    for (int j = 0; j < p_module->p_config[i].i_list; j++)
-                        LOAD_IMMEDIATE( p_module->p_config[i].pi_list[j] );
-                }
-            }
-        }
-
-        if( p_module->p_config[i].i_action )
-        {
-            p_module->p_config[i].ppf_action =
-                xmalloc( p_module->p_config[i].i_action * sizeof(void *) );
-            p_module->p_config[i].ppsz_action_text =
-                xmalloc( p_module->p_config[i].i_action * sizeof(char *) );
-
-            for (int j = 0; j < p_module->p_config[i].i_action; j++)
-            {
-                p_module->p_config[i].ppf_action[j] = NULL;
-                LOAD_STRING( p_module->p_config[i].ppsz_action_text[j] );
-            }
-        }
-    }
-
-    return VLC_SUCCESS;
-
- error:
-
-    return VLC_EGENERIC;
+    free (module->p_config);
+    free (module->psz_filename);
+    free (module->pp_shortcuts);
+    vlc_free_tagged (VLC_MEM_MODULES, module, sizeof (*module));
 }
 
-static int CacheSaveBank( FILE *file, const module_cache_t *, size_t );
+static int CacheSaveBank (FILE *file, const module_cache_t *, size_t,
+                          const module_cache_dir_t *, size_t);
 
 /**
  * Saves a module cache to disk, and release cache data from memory.
+ * \param dirs browsed directories, relative to dir, and their mtime
  */
 void CacheSave (vlc_object_t *p_this, const char *dir,
-               module_cache_t *entries, size_t n)
+               module_cache_t *entries, size_t n,
+               module_cache_dir_t *dirs, size_t n_dirs)
 {
     char *filename = NULL, *tmpname = NULL;
 
@@ -413,7 +674,7 @@ void CacheSave (vlc_object_t *p_this, const char *dir,
         goto out;
     }
 
-    if (CacheSaveBank (file, entries, n))
+    if (CacheSaveBank (file, entries, n, dirs, n_dirs))
     {
         msg_Warn (p_this, "cannot write %s (%m)", tmpname);
         clearerr (file);
@@ -437,160 +698,275 @@ out:
     for (size_t i = 0; i < n; i++)
         free (entries[i].path);
     free (entries);
+    for (size_t i = 0; i < n_dirs; i++)
+        free (dirs[i].path);
+    free (dirs);
 }
 
-static int CacheSaveConfig (FILE *, const module_t *);
-static int CacheSaveSubmodule (FILE *, const module_t *);
-
-static int CacheSaveBank (FILE *file, const module_cache_t *cache,
-                          size_t i_cache)
+/** Cache file being built in memory */
+typedef struct
 {
-    uint32_t i_file_size = 0;
-
-    /* Contains version number */
-    if (fputs (CACHE_STRING, file) == EOF)
-        goto error;
-#ifdef DISTRO_VERSION
-    /* Allow binary maintaner to pass a string to detect new binary version*/
-    if (fputs( DISTRO_VERSION, file ) == EOF)
-        goto error;
-#endif
-    /* Sub-version number (to avoid breakage in the dev version when cache
-     * structure changes) */
-    i_file_size = CACHE_SUBVERSION_NUM;
-    if (fwrite (&i_file_size, sizeof (i_file_size), 1, file) != 1 )
-        goto error;
-
-    /* Header marker */
-    i_file_size = ftell( file );
-    if (fwrite (&i_file_size, sizeof (i_file_size), 1, file) != 1)
-        goto error;
+    uint8_t     *data;
+    size_t       size;
+    size_t       alloc;
+    bool         failed;
+
+    /* Strings already stored, hashed */
+    cache_ref_t *strings;
+    size_t       str_mask;
+    size_t       str_count;
+} cache_writer_t;
+
+/* Appends len zero bytes, returns their offset (0 on error) */
+static cache_ref_t CacheReserve (cache_writer_t *w, size_t len, size_t align)
+{
+    size_t offset = (w->size + align - 1) & ~(align - 1);
 
-    if (fwrite( &i_cache, sizeof (i_cache), 1, file) != 1)
+    if (w->failed)
+        return 0;
+    if (offset + len > UINT32_MAX)
         goto error;
-
-#define SAVE_IMMEDIATE( a ) \
-    if (fwrite (&a, sizeof(a), 1, file) != 1) \
-        goto error
-#define SAVE_STRING( a ) \
-    { \
-        uint16_t i_size = (a != NULL) ? (strlen (a) + 1) : 0; \
-        if ((fwrite (&i_size, sizeof (i_size), 1, file) != 1) \
-         || (a && (fwrite (a, 1, i_size, file) != i_size))) \
-            goto error; \
-    } while(0)
-
-    for (unsigned i = 0; i < i_cache; i++)
+    if (offset + len > w->alloc)
     {
-        module_t *module = cache[i].p_module;
-        uint32_t i_submodule;
+        size_t alloc = w->alloc ? w->alloc : 65536;
+        while (alloc < offset + len)
+            alloc *= 2;
 
-        /* Save additional infos */
-        SAVE_STRING(module->psz_shortname);
-        SAVE_STRING(module->psz_longname);
-        SAVE_STRING(module->psz_help);
-        SAVE_IMMEDIATE(module->i_shortcuts);
-        for (unsigned j = 0; j < module->i_shortcuts; j++)
-            SAVE_STRING(module->pp_shortcuts[j]);
+        uint8_t *data = realloc (w->data, alloc);
+        if (unlikely(data == NULL))
+            goto error;
+        w->data = data;
+        w->alloc = alloc;
+    }
+    memset (w->data + w->size, 0, offset + len - w->size);
+    w->size = offset + len;
+    return offset;
+error:
+    w->failed = true;
+    return 0;
+}
 
-        SAVE_STRING(module->psz_capability);
-        SAVE_IMMEDIATE(module->i_score);
-        SAVE_IMMEDIATE(module->b_unloadable);
+static void CacheWrite (cache_writer_t *w, cache_ref_t ref,
+                        const void *data, size_t len)
+{
+    if (!w->failed && len > 0)
+        memcpy (w->data + ref, data, len);
+}
 
-        /* Config stuff */
-        if (CacheSaveConfig (file, module))
-            goto error;
+static size_t CacheHash (const char *str)
+{
+    size_t hash = 2166136261u;
 
-        SAVE_STRING(module->domain);
+    while (*str)
+        hash = (hash ^ (unsigned char)*(str++)) * 16777619u;
+    return hash;
+}
 
-        i_submodule = module->submodule_count;
-        SAVE_IMMEDIATE( i_submodule );
-        if (CacheSaveSubmodule (file, module->submodule))
-            goto error;
+/* Stores a string, unless it is already there */
+static cache_ref_t CacheSaveString (cache_writer_t *w, const char *str)
+{
+    if (str == NULL || w->failed)
+        return 0;
 
-        /* Save common info */
-        SAVE_STRING(cache[i].path);
-        SAVE_IMMEDIATE(cache[i].mtime);
-        SAVE_IMMEDIATE(cache[i].size);
+    if (2 * (w->str_count + 1) > w->str_mask)
+    {   /* Grow the hash table */
+        size_t mask = w->str_mask ? (2 * w->str_mask + 1) : 1023;
+        cache_ref_t *tab = calloc (mask + 1, sizeof (*tab));
+        if (unlikely(tab == NULL))
+        {
+            w->failed = true;
+            return 0;
+        }
+        for (size_t i = 0; w->str_mask && i <= w->str_mask; i++)
+            if (w->strings[i] != 0)
+            {
+                size_t h = CacheHash ((char *)w->data + w->strings[i]);
+                while (tab[h & mask] != 0)
+                    h++;
+                tab[h & mask] = w->strings[i];
+            }
+        free (w->strings);
+        w->strings = tab;
+        w->str_mask = mask;
     }
 
-    if (fflush (file)) /* flush libc buffers */
-        goto error;
-    return 0; /* success! */
+    size_t h = CacheHash (str);
+    for (;; h++)
+    {
+        cache_ref_t ref = w->strings[h & w->str_mask];
+        if (ref == 0)
+            break;
+        if (!strcmp ((char *)w->data + ref, str))
+            return ref;
+    }
 
-error:
-    return -1;
+    size_t len = strlen (str) + 1;
+    cache_ref_t ref = CacheReserve (w, len, 1);
+    CacheWrite (w, ref, str, len);
+    if (!w->failed)
+    {
+        w->strings[h & w->str_mask] = ref;
+        w->str_count++;
+    }
+    return ref;
 }
 
-static int CacheSaveSubmodule( FILE *file, const module_t *p_module )
+/* Stores a table of strings */
+static cache_ref_t CacheSaveStrings (cache_writer_t *w, char *const *tab,
+                                     size_t count)
 {
-    if( !p_module )
+    if (count == 0)
         return 0;
-    if( CacheSaveSubmodule( file, p_module->next ) )
-        goto error;
-
-    SAVE_STRING( p_module->psz_shortname );
-    SAVE_STRING( p_module->psz_longname );
-    SAVE_IMMEDIATE( p_module->i_shortcuts );
-    for( unsigned j = 0; j < p_module->i_shortcuts; j++ )
-         SAVE_STRING( p_module->pp_shortcuts[j] );
-
-    SAVE_STRING( p_module->psz_capability );
-    SAVE_IMMEDIATE( p_module->i_score );
-    return 0;
 
-error:
-    return -1;
+    cache_ref_t ref = CacheReserve (w, count * sizeof (cache_ref_t), 8);
+    for (size_t i = 0; i < count; i++)
+    {
+        cache_ref_t str = CacheSaveString (w, tab[i]);
+        CacheWrite (w, ref + i * sizeof (str), &str, sizeof (str));
+    }
+    return ref;
 }
 
+static void CacheSaveConfig (cache_writer_t *w, cache_ref_t ref,
+                             const module_config_t *item)
+{
+    cache_config_t rec;
+
+    memset (&rec, 0, sizeof (rec));
+    rec.item = *item;
+    rec.type = CacheSaveString (w, item->psz_type);
+    rec.name = CacheSaveString (w, item->psz_name);
+    rec.text = CacheSaveString (w, item->psz_text);
+    rec.longtext = CacheSaveString (w, item->psz_longtext);
+    if (IsConfigStringType (item->i_type))
+        rec.orig = CacheSaveString (w, item->orig.psz);
+
+    if (item->i_list > 0)
+    {
+        if (item->ppsz_list != NULL)
+            rec.list = CacheSaveStrings (w, item->ppsz_list, item->i_list);
+        if (item->ppsz_list_text != NULL)
+            rec.list_text = CacheSaveStrings (w, item->ppsz_list_text,
+                                              item->i_list);
+        if (item->pi_list != NULL)
+        {
+            rec.int_list = CacheReserve (w, item->i_list * sizeof (int), 8);
+            CacheWrite (w, rec.int_list, item->pi_list,
+                        item->i_list * sizeof (int));
+        }
+    }
+    if (item->i_action > 0)
+        rec.action_text = CacheSaveStrings (w, item->ppsz_action_text,
+                                            item->i_action);
+    CacheWrite (w, ref, &rec, sizeof (rec));
+}
 
-static int CacheSaveConfig (FILE *file, const module_t *p_module)
+static void CacheSaveModule (cache_writer_t *w, cache_ref_t ref,
+                             const module_t *module)
 {
-    uint32_t i_lines = p_module->confsize;
+    cache_module_t rec;
+
+    memset (&rec, 0, sizeof (rec));
+    rec.shortname = CacheSaveString (w, module->psz_shortname);
+    rec.longname = CacheSaveString (w, module->psz_longname);
+    rec.help = CacheSaveString (w, module->psz_help);
+    rec.capability = CacheSaveString (w, module->psz_capability);
+    rec.domain = CacheSaveString (w, module->domain);
+    rec.shortcuts = CacheSaveStrings (w, module->pp_shortcuts,
+                                      module->i_shortcuts);
+    rec.i_shortcuts = module->i_shortcuts;
+    rec.i_score = module->i_score;
+    rec.b_unloadable = module->b_unloadable;
+    rec.i_codecs = module->i_codecs;
+    rec.codecs = CacheReserve (w, module->i_codecs * sizeof (vlc_fourcc_t), 8);
+    CacheWrite (w, rec.codecs, module->p_codecs,
+                module->i_codecs * sizeof (vlc_fourcc_t));
+
+    if (module->parent == NULL)
+    {
+        /* Config stuff */
+        rec.i_config_items = module->i_config_items;
+        rec.i_bool_items = module->i_bool_items;
+        rec.confsize = module->confsize;
+        rec.config = CacheReserve (w, module->confsize
+                                          * sizeof (cache_config_t), 8);
+        for (size_t i = 0; i < module->confsize; i++)
+            CacheSaveConfig (w, rec.config + i * sizeof (cache_config_t),
+                             module->p_config + i);
+
+        rec.submodules = module->submodule_count;
+        rec.submodule = CacheReserve (w, module->submodule_count
+                                             * sizeof (cache_module_t), 8);
+        size_t i = 0;
+        for (const module_t *sub = module->submodule; sub != NULL;
+             sub = sub->next)
+            CacheSaveModule (w, rec.submodule + (i++) * sizeof (rec), sub);
+    }
+    CacheWrite (w, ref, &rec, sizeof (rec));
+}
 
-    SAVE_IMMEDIATE( p_module->i_config_items );
-    SAVE_IMMEDIATE( p_module->i_bool_items );
-    SAVE_IMMEDIATE( i_lines );
+static int CacheSaveBank (FILE *file, const module_cache_t *cache,
+                          size_t i_cache, const module_cache_dir_t *dirs,
+                          size_t i_dirs)
+{
+    cache_writer_t w = { NULL, 0, 0, false, NULL, 0, 0 };
+    cache_header_t hdr;
 
-    for (size_t i = 0; i < i_lines ; i++)
-    {
-        SAVE_IMMEDIATE( p_module->p_config[i] );
+    if (i_cache > UINT32_MAX || i_dirs > UINT32_MAX)
+        return -1;
 
-        SAVE_STRING( p_module->p_config[i].psz_type );
-        SAVE_STRING( p_module->p_config[i].psz_name );
-        SAVE_STRING( p_module->p_config[i].psz_text );
-        SAVE_STRING( p_module->p_config[i].psz_longtext );
+    /* Contains version number */
+    CacheReserve (&w, CACHE_HEADER + sizeof (hdr), 8);
+    CacheWrite (&w, 0, CACHE_MAGIC, sizeof (CACHE_MAGIC) - 1);
 
-        if (IsConfigStringType (p_module->p_config[i].i_type))
-            SAVE_STRING( p_module->p_config[i].orig.psz );
+    memset (&hdr, 0, sizeof (hdr));
+    /* Sub-version number (to avoid breakage in the dev version when cache
+     * structure changes) */
+    hdr.subversion = CACHE_SUBVERSION_NUM;
+    hdr.plugins = i_cache;
+    hdr.plugin = CacheReserve (&w, i_cache * sizeof (cache_plugin_t), 8);
+    hdr.dirs = i_dirs;
+    hdr.dir = CacheReserve (&w, i_dirs * sizeof (cache_dir_t), 8);
 
-        if( p_module->p_config[i].i_list )
-        {
-            if( p_module->p_config[i].ppsz_list )
-            {
-                for (int j = 0; j < p_module->p_config[i].i_list; j++)
-                    SAVE_STRING( p_module->p_config[i].ppsz_list[j] );
-            }
+    for (size_t i = 0; i < i_cache; i++)
+    {
+        cache_plugin_t rec;
+
+        memset (&rec, 0, sizeof (rec));
+        rec.path = CacheSaveString (&w, cache[i].path);
+        rec.mtime = cache[i].mtime;
+        rec.size = cache[i].size;
+        rec.module = CacheReserve (&w, sizeof (cache_module_t), 8);
+        CacheSaveModule (&w, rec.module, cache[i].p_module);
+        CacheWrite (&w, hdr.plugin + i * sizeof (rec), &rec, sizeof (rec));
+    }
 
-            if( p_module->p_config[i].ppsz_list_text )
-            {
-                for (int j = 0; j < p_module->p_config[i].i_list; j++)
-                    SAVE_STRING( p_module->p_config[i].ppsz_list_text[j] );
-            }
-            if( p_module->p_config[i].pi_list )
-            {
-                for (int j = 0; j < p_module->p_config[i].i_list; j++)
-                    SAVE_IMMEDIATE( p_module->p_config[i].pi_list[j] );
-            }
-        }
+    for (size_t i = 0; i < i_dirs; i++)
+    {
+        cache_dir_t rec;
 
-        for (int j = 0; j < p_module->p_config[i].i_action; j++)
-            SAVE_STRING( p_module->p_config[i].ppsz_action_text[j] );
+        memset (&rec, 0, sizeof (rec));
+        rec.path = CacheSaveString (&w, dirs[i].path);
+        rec.mtime = dirs[i].mtime;
+        rec.hash = dirs[i].hash;
+        CacheWrite (&w, hdr.dir + i * sizeof (rec), &rec, sizeof (rec));
     }
-    return 0;
 
-error:
-    return -1;
+    /* Terminates the last string, for the loader's sake */
+    CacheReserve (&w, 1, 1);
+    hdr.size = w.size;
+    CacheWrite (&w, CACHE_HEADER, &hdr, sizeof (hdr));
+
+    int ret = -1;
+    if (!w.failed && fwrite (w.data, 1, w.size, file) == w.size
+     && fflush (file) == 0) /* flush libc buffers */
+        ret = 0; /* success! */
+    else if (w.failed)
+        errno = ENOMEM;
+
+    free (w.strings);
+    free (w.data);
+    return ret;
 }
 
 /*****************************************************************************
@@ -645,6 +1021,28 @@ module_t *CacheFind (module_cache_t *cache, size_t count,
     return NULL;
 }
 
+/** Adds a browsed directory to the cache */
+int CacheAddDir (module_cache_dir_t **dirsp, size_t *countp, const char *path,
+                 const struct stat *st, uint32_t hash)
+{
+    module_cache_dir_t *dirs = *dirsp;
+    const size_t count = *countp;
+
+    dirs = realloc (dirs, (count + 1) * sizeof (*dirs));
+    if (unlikely(dirs == NULL))
+        return -1;
+    *dirsp = dirs;
+
+    dirs += count;
+    dirs->path = strdup (path);
+    if (unlikely(dirs->path == NULL))
+        return -1;
+    dirs->mtime = st->st_mtime;
+    dirs->hash = hash;
+    *countp = count + 1;
+    return 0;
+}
+
 /** Adds entry to the cache */
 int CacheAdd (module_cache_t **cachep, size_t *countp,
               const char *path, const struct stat *st, module_t *module)
@@ -26,6 +26,7 @@
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_memory.h>
+#include <vlc_memstats.h>
 #include <assert.h>
 #include <stdarg.h>
 #include <limits.h>
@@ -41,7 +42,7 @@ static char *strdup_null (const char *str)
 
 module_t *vlc_module_create (module_t *parent)
 {
-    module_t *module = malloc (sizeof (*module));
+    module_t *module = vlc_malloc_tagged (VLC_MEM_MODULES, sizeof (*module));
     if (module == NULL)
         return NULL;
 
@@ -69,8 +70,11 @@ module_t *vlc_module_create (module_t *parent)
     module->i_shortcuts = 0;
     module->psz_capability = NULL;
     module->i_score = (parent != NULL) ? parent->i_score : 1;
+    module->p_codecs = NULL;
+    module->i_codecs = 0;
     module->b_loaded = false;
     module->b_unloadable = parent == NULL;
+    module->b_cached = false;
     module->pf_activate = NULL;
     module->pf_deactivate = NULL;
     module->p_config = NULL;
@@ -97,6 +101,13 @@ void vlc_module_destroy (module_t *module)
         vlc_module_destroy (m);
     }
 
+#ifdef HAVE_DYNAMIC_PLUGINS
+    if (module->b_cached)
+    {
+        CacheFreeModule (module);
+        return;
+    }
+#endif
     config_Free (module->p_config, module->confsize);
 
     free (module->domain);
@@ -105,10 +116,11 @@ void vlc_module_destroy (module_t *module)
         free (module->pp_shortcuts[i]);
     free (module->pp_shortcuts);
     free (module->psz_capability);
+    free (module->p_codecs);
     free (module->psz_help);
     free (module->psz_longname);
     free (module->psz_shortname);
-    free (module);
+    vlc_free_tagged (VLC_MEM_MODULES, module, sizeof (*module));
 }
 
 static module_config_t *vlc_config_create (module_t *module, int type)
@@ -233,6 +245,20 @@ static int vlc_plugin_setter (void *plugin, void *tgt, int propid, ...)
             module->i_score = va_arg (ap, int);
             break;
 
+        case VLC_MODULE_CODEC:
+        {
+            vlc_fourcc_t *tab = realloc (module->p_codecs,
+                                   sizeof (*tab) * (module->i_codecs + 1));
+            if (unlikely(tab == NULL))
+            {
+                ret = -1;
+                break;
+            }
+            tab[module->i_codecs++] = va_arg (ap, unsigned);
+            module->p_codecs = tab;
+            break;
+        }
+
         case VLC_MODULE_CB_OPEN:
             module->pf_activate = va_arg (ap, void *);
             break;
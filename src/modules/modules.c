@@ -174,6 +174,20 @@ static int modulecmp (const void *a, const void *b)
     return lb->i_score - la->i_score;
 }
 
+/* Checks whether a module can handle a codec, without loading it */
+static bool module_handles (const module_t *m, vlc_fourcc_t codec)
+{
+    if (codec == 0 || m->i_codecs == 0)
+        return true;
+    for (unsigned i = 0; i < m->i_codecs; i++)
+        if (m->p_codecs[i] == codec)
+            return true;
+    return false;
+}
+
+static module_t *module_load (vlc_object_t *, const char *, const char *,
+                              bool, vlc_fourcc_t, vlc_activate_t, va_list);
+
 #undef vlc_module_load
 /**
  * Finds and instantiates the best module of a certain type.
@@ -198,6 +212,21 @@ static int modulecmp (const void *a, const void *b)
 module_t *vlc_module_load(vlc_object_t *p_this, const char *psz_capability,
                           const char *psz_name, bool b_strict,
                           vlc_activate_t probe, ...)
+{
+    module_t *module;
+    va_list args;
+
+    va_start (args, probe);
+    module = module_load (p_this, psz_capability, psz_name, b_strict, 0,
+                          probe, args);
+    va_end (args);
+    return module;
+}
+
+static module_t *module_load (vlc_object_t *p_this, const char *psz_capability,
+                              const char *psz_name, bool b_strict,
+                              vlc_fourcc_t codec, vlc_activate_t probe,
+                              va_list args)
 {
     stats_TimerStart( p_this, "module_need()", STATS_TIMER_MODULE_NEED );
 
@@ -255,19 +284,17 @@ module_t *vlc_module_load(vlc_object_t *p_this, const char *psz_capability,
     }
 
     /* Sort the modules and test them */
-    size_t count;
-    module_t **p_all = module_list_get (&count);
-    p_list = malloc( count * sizeof( module_list_t ) );
+    module_t *const *p_all;
+    size_t total = module_list_cap (&p_all, psz_capability);
+    size_t count = 0;
+    p_list = malloc( total * sizeof( module_list_t ) );
 
-    /* Parse the module list for capabilities and probe each of them */
-    count = 0;
-    for (size_t i = 0; (p_module = p_all[i]) != NULL; i++)
+    /* Parse the modules of the capability and probe each of them */
+    for (size_t i = 0; i < total; i++)
     {
         int i_shortcut_bonus = 0;
 
-        /* Test that this module can do what we need */
-        if( !module_provides( p_module, psz_capability ) )
-            continue;
+        p_module = p_all[i];
 
         /* If we required a shortcut, check this plugin provides it. */
         if( i_shortcuts > 0 )
@@ -307,6 +334,11 @@ module_t *vlc_module_load(vlc_object_t *p_this, const char *psz_capability,
         if( p_module->i_score <= 0 )
             continue;
 
+        /* Skip, without loading it, a module that cannot handle the codec,
+         * unless it was asked for */
+        if( !module_handles( p_module, codec ) )
+            continue;
+
 found_shortcut:
         /* Store this new module */
         p_list[count].p_module = p_module;
@@ -315,18 +347,14 @@ found_shortcut:
         count++;
     }
 
-    /* We can release the list, interesting modules are held */
-    module_list_free (p_all);
-
-    /* Sort candidates by descending score */
-    qsort (p_list, count, sizeof (p_list[0]), modulecmp);
+    /* Sort candidates by descending score (the index already is, only
+     * shortcut bonuses may change the order) */
+    if( i_shortcuts > 0 )
+        qsort (p_list, count, sizeof (p_list[0]), modulecmp);
     msg_Dbg( p_this, "looking for %s module: %zu candidate%s", psz_capability,
              count, count == 1 ? "" : "s" );
 
     /* Parse the linked list and use the first successful module */
-    va_list args;
-
-    va_start(args, probe);
     p_module = NULL;
 
     for (size_t i = 0; (i < count) && (p_module == NULL); i++)
@@ -366,7 +394,6 @@ found_shortcut:
         }
     }
 
-    va_end (args);
     free( p_list );
     p_this->b_force = b_force_backup;
 
@@ -437,6 +464,31 @@ module_t *module_need(vlc_object_t *obj, const char *cap, const char *name,
     return vlc_module_load(obj, cap, name, strict, generic_start, obj);
 }
 
+static module_t *module_load_generic (vlc_object_t *obj, const char *cap,
+                                     const char *name, bool strict,
+                                     vlc_fourcc_t codec, ...)
+{
+    module_t *module;
+    va_list ap;
+
+    va_start (ap, codec);
+    module = module_load (obj, cap, name, strict, codec, generic_start, ap);
+    va_end (ap);
+    return module;
+}
+
+#undef module_need_codec
+/**
+ * Finds and instantiates the best module of a certain type for a codec.
+ * Modules that declare the codecs they handle (see add_codec()) are skipped,
+ * without even being loaded, if the codec is not one of them.
+ */
+module_t *module_need_codec(vlc_object_t *obj, const char *cap,
+                            const char *name, bool strict, vlc_fourcc_t codec)
+{
+    return module_load_generic (obj, cap, name, strict, codec, obj);
+}
+
 #undef module_unneed
 void module_unneed(vlc_object_t *obj, module_t *module)
 {
@@ -25,6 +25,7 @@
 # define LIBVLC_MODULES_H 1
 
 typedef struct module_cache_t module_cache_t;
+typedef struct module_cache_file_t module_cache_file_t;
 
 /*****************************************************************************
  * Module cache description structure
@@ -40,6 +41,16 @@ struct module_cache_t
     module_t *p_module;
 };
 
+/**
+ * Browsed plug-ins directory, as recorded in the cache
+ */
+typedef struct module_cache_dir_t
+{
+    char    *path; /**< relative to the plug-ins base directory */
+    time_t   mtime;
+    uint32_t hash; /**< hash of the entry names, see CacheHashEntry() */
+} module_cache_dir_t;
+
 
 #define MODULE_SHORTCUT_MAX 20
 
@@ -76,8 +87,14 @@ struct module_t
     char    *psz_capability;                                 /**< Capability */
     int      i_score;                          /**< Score for the capability */
 
+    /** Codecs handled, so that the module is not even loaded for others
+     * (if empty, the module is tried for any codec) */
+    vlc_fourcc_t *p_codecs;
+    unsigned      i_codecs;
+
     bool          b_loaded;        /* Set to true if the dll is loaded */
     bool b_unloadable;                        /**< Can we be dlclosed? */
+    bool b_cached;           /**< Are the strings in the plugins cache? */
 
     /* Callbacks */
     void *pf_activate;
@@ -105,6 +122,7 @@ module_t *vlc_module_create (module_t *);
 void vlc_module_destroy (module_t *);
 
 void module_InitBank (void);
+size_t module_list_cap (module_t *const **, const char *);
 size_t module_LoadPlugins( vlc_object_t * );
 #define module_LoadPlugins(a) module_LoadPlugins(VLC_OBJECT(a))
 void module_EndBank (bool);
@@ -120,10 +138,17 @@ void module_Unload (module_handle_t);
 /* Plugins cache */
 void   CacheMerge (vlc_object_t *, module_t *, module_t *);
 void   CacheDelete(vlc_object_t *, const char *);
-size_t CacheLoad  (vlc_object_t *, const char *, module_cache_t **);
+size_t CacheLoad  (vlc_object_t *, const char *, module_cache_t **, bool *);
 int CacheAdd (module_cache_t **, size_t *,
               const char *, const struct stat *, module_t *);
-void CacheSave  (vlc_object_t *, const char *, module_cache_t *, size_t);
+int CacheAddDir (module_cache_dir_t **, size_t *, const char *,
+                 const struct stat *, uint32_t);
+void CacheHashEntry (uint32_t *, const char *);
+void CacheSave  (vlc_object_t *, const char *, module_cache_t *, size_t,
+                 module_cache_dir_t *, size_t);
+void CacheFreeModule (module_t *);
+module_cache_file_t *CacheTakeFiles (void);
+void CacheReleaseFiles (module_cache_file_t *);
 module_t *CacheFind (module_cache_t *, size_t,
                      const char *, const struct stat *);
 
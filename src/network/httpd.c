@@ -39,6 +39,7 @@
 #include <vlc_rand.h>
 #include <vlc_charset.h>
 #include <vlc_url.h>
+#include <vlc_atomic.h>
 #include "../libvlc.h"
 
 #include <string.h>
@@ -51,6 +52,9 @@
 #ifdef HAVE_POLL
 # include <poll.h>
 #endif
+#ifdef HAVE_SYS_EPOLL_H
+# include <sys/epoll.h>
+#endif
 
 #if defined( UNDER_CE )
 #   include <winsock.h>
@@ -67,9 +71,72 @@
 #define HTTPD_CL_BUFSIZE 10000
 #endif
 
+/* Maximum number of worker threads of a host */
+#define HTTPD_WORKERS_MAX 8
+#ifdef HAVE_SYS_EPOLL_H
+/* Maximum number of events handled per wake up of a worker */
+# define HTTPD_EVENTS_MAX 64
+#endif
+
+/* Maximum number of stream segments sent at once */
+#define HTTPD_SEGMENTS_MAX 16
+
 static void httpd_ClientClean( httpd_client_t *cl );
 
-/* each host run in his own thread */
+/* data of a stream, shared by all the clients sending it */
+typedef struct httpd_segment_t httpd_segment_t;
+struct httpd_segment_t
+{
+    httpd_segment_t *p_next;    /* valid while in the stream */
+    vlc_atomic_t    refs;
+    int64_t         i_pos;      /* absolute position of the first byte */
+    size_t          i_size;
+    uint8_t         i_hdr;      /* size of the chunk header before the data */
+    uint8_t         p_data[];   /* chunk header, data, and CRLF if i_hdr > 0 */
+};
+
+static void httpd_SegmentRelease( httpd_segment_t *seg )
+{
+    if( vlc_atomic_dec( &seg->refs ) == 0 )
+        free( seg );
+}
+
+/* Segments are sent with their chunk framing to chunked clients */
+static inline const uint8_t *httpd_SegmentData( const httpd_segment_t *seg,
+                                                bool b_chunked )
+{
+    return b_chunked ? seg->p_data : seg->p_data + seg->i_hdr;
+}
+
+static inline size_t httpd_SegmentSize( const httpd_segment_t *seg,
+                                        bool b_chunked )
+{
+    return b_chunked ? seg->i_hdr + seg->i_size + 2 : seg->i_size;
+}
+
+/* each worker thread serves its own share of the clients of a host */
+typedef struct
+{
+    httpd_host_t    *host;
+    vlc_thread_t    thread;
+
+    /* protects the clients, taken before the host lock */
+    vlc_mutex_t     lock;
+    int             i_client;
+    httpd_client_t  **client;
+
+    /* event loop */
+#ifdef HAVE_SYS_EPOLL_H
+    int             epfd;
+    struct epoll_event events[HTTPD_EVENTS_MAX];
+#else
+    unsigned        i_fd;
+    unsigned        i_fd_max;
+    struct pollfd   *ufd;
+    void            **data;
+#endif
+} httpd_worker_t;
+
 struct httpd_host_t
 {
     VLC_COMMON_MEMBERS
@@ -82,7 +149,8 @@ struct httpd_host_t
     unsigned     nfd;
     unsigned     port;
 
-    vlc_thread_t thread;
+    unsigned        i_worker;
+    httpd_worker_t  *worker;
     vlc_mutex_t lock;
     vlc_cond_t  wait;
 
@@ -93,9 +161,6 @@ struct httpd_host_t
     int         i_url;
     httpd_url_t **url;
 
-    int            i_client;
-    httpd_client_t **client;
-
     /* TLS data */
     vlc_tls_creds_t *p_tls;
 };
@@ -150,8 +215,10 @@ struct httpd_client_t
     int     i_ref;
 
     int     fd;
+    short   i_events; /* polled events, 0 if not in the worker event loop */
 
     bool    b_stream_mode;
+    bool    b_chunked; /* body sent with chunked transfer encoding */
     uint8_t i_state;
 
     mtime_t i_activity_date;
@@ -166,6 +233,13 @@ struct httpd_client_t
     httpd_message_t query;  /* client -> httpd */
     httpd_message_t answer; /* httpd -> client */
 
+    /* stream data being sent, sent bytes of the first segment, and the last
+     * segment sent (to find the next one) */
+    httpd_segment_t *segment[HTTPD_SEGMENTS_MAX];
+    unsigned        i_segment;
+    size_t          i_segment_offset;
+    httpd_segment_t *p_resume;
+
     /* TLS data */
     vlc_tls_t *p_tls;
 };
@@ -707,9 +781,11 @@ struct httpd_stream_t
     uint8_t *p_header;
     int     i_header;
 
-    /* circular buffer */
-    int         i_buffer_size;      /* buffer size, can't be reallocated smaller */
-    uint8_t     *p_buffer;          /* buffer */
+    /* segments, oldest first, sent from by every client */
+    int         i_buffer_size;      /* amount of data kept */
+    int         i_buffered;
+    httpd_segment_t *p_first;
+    httpd_segment_t **pp_last;
     int64_t     i_buffer_pos;       /* absolute position from begining */
     int64_t     i_buffer_last_pos;  /* a new connection will start with that */
 };
@@ -728,51 +804,64 @@ static int httpd_StreamCallBack( httpd_callback_sys_t *p_sys,
     if( answer->i_body_offset > 0 )
     {
         int64_t i_write;
-        int     i_pos;
 
 #if 0
         fprintf( stderr, "httpd_StreamCallBack i_body_offset=%lld\n",
                  answer->i_body_offset );
 #endif
 
+        /* Clients of the stream may be served by several workers */
+        vlc_mutex_lock( &stream->lock );
         if( answer->i_body_offset >= stream->i_buffer_pos )
         {
             /* fprintf( stderr, "httpd_StreamCallBack: no data\n" ); */
+            vlc_mutex_unlock( &stream->lock );
             return VLC_EGENERIC;    /* wait, no data available */
         }
-        if( answer->i_body_offset + stream->i_buffer_size <
-            stream->i_buffer_pos )
+
+        httpd_segment_t *seg = cl->p_resume;
+        if( seg != NULL && seg->i_pos >= stream->p_first->i_pos
+         && seg->i_pos + (int64_t)seg->i_size == answer->i_body_offset )
+        {
+            /* the usual case: go on after the last segment sent */
+            seg = seg->p_next;
+        }
+        else
         {
-            /* this client isn't fast enough */
+            if( answer->i_body_offset < stream->p_first->i_pos )
+            {
+                /* this client isn't fast enough */
 #if 0
-            fprintf( stderr, "fixing i_body_offset (old=%lld new=%lld)\n",
-                     answer->i_body_offset, stream->i_buffer_last_pos );
+                fprintf( stderr, "fixing i_body_offset (old=%lld new=%lld)\n",
+                         answer->i_body_offset, stream->i_buffer_last_pos );
 #endif
-            answer->i_body_offset = stream->i_buffer_last_pos;
+                answer->i_body_offset = stream->i_buffer_last_pos;
+            }
+            for( seg = stream->p_first;
+                 seg->i_pos + (int64_t)seg->i_size <= answer->i_body_offset;
+                 seg = seg->p_next );
         }
 
-        i_pos   = answer->i_body_offset % stream->i_buffer_size;
-        i_write = stream->i_buffer_pos - answer->i_body_offset;
-        if( i_write > HTTPD_CL_BUFSIZE )
+        /* Reference the segments rather than copying them */
+        assert( cl->i_segment == 0 );
+        cl->i_segment_offset = answer->i_body_offset - seg->i_pos;
+        i_write = -(int64_t)cl->i_segment_offset;
+        while( seg != NULL && cl->i_segment < HTTPD_SEGMENTS_MAX )
         {
-            i_write = HTTPD_CL_BUFSIZE;
+            vlc_atomic_inc( &seg->refs );
+            cl->segment[cl->i_segment++] = seg;
+            i_write += seg->i_size;
+            seg = seg->p_next;
         }
-        else if( i_write <= 0 )
-        {
-            return VLC_EGENERIC;    /* wait, no data available */
-        }
-
-        /* Don't go past the end of the circular buffer */
-        i_write = __MIN( i_write, stream->i_buffer_size - i_pos );
+        vlc_mutex_unlock( &stream->lock );
 
         /* using HTTPD_MSG_ANSWER -> data available */
         answer->i_proto  = HTTPD_PROTO_HTTP;
         answer->i_version= 0;
         answer->i_type   = HTTPD_MSG_ANSWER;
 
-        answer->i_body = i_write;
-        answer->p_body = xmalloc( i_write );
-        memcpy( answer->p_body, &stream->p_buffer[i_pos], i_write );
+        answer->i_body = 0;
+        answer->p_body = NULL;
 
         answer->i_body_offset += i_write;
 
@@ -869,7 +958,9 @@ httpd_stream_t *httpd_StreamNew( httpd_host_t *host,
     stream->i_header = 0;
     stream->p_header = NULL;
     stream->i_buffer_size = 5000000;    /* 5 Mo per stream */
-    stream->p_buffer = xmalloc( stream->i_buffer_size );
+    stream->i_buffered = 0;
+    stream->p_first = NULL;
+    stream->pp_last = &stream->p_first;
     /* We set to 1 to make life simpler
      * (this way i_body_offset can never be 0) */
     stream->i_buffer_pos = 1;
@@ -904,36 +995,45 @@ int httpd_StreamHeader( httpd_stream_t *stream, uint8_t *p_data, int i_data )
 
 int httpd_StreamSend( httpd_stream_t *stream, uint8_t *p_data, int i_data )
 {
-    int i_count;
-    int i_pos;
+    httpd_segment_t *seg;
 
-    if( i_data < 0 || p_data == NULL )
+    if( i_data <= 0 || p_data == NULL )
     {
         return VLC_SUCCESS;
     }
+
+    /* This is the only copy, clients send from the segment */
+    seg = malloc( sizeof( *seg ) + i_data );
+    if( unlikely(seg == NULL) )
+        return VLC_ENOMEM;
+    seg->p_next = NULL;
+    vlc_atomic_set( &seg->refs, 1 );
+    seg->i_size = i_data;
+    seg->i_hdr = 0;
+    memcpy( seg->p_data, p_data, i_data );
+
     vlc_mutex_lock( &stream->lock );
 
     /* save this pointer (to be used by new connection) */
     stream->i_buffer_last_pos = stream->i_buffer_pos;
 
-    i_pos = stream->i_buffer_pos % stream->i_buffer_size;
-    i_count = i_data;
-    while( i_count > 0)
-    {
-        int i_copy;
-
-        i_copy = __MIN( i_count, stream->i_buffer_size - i_pos );
+    seg->i_pos = stream->i_buffer_pos;
+    *stream->pp_last = seg;
+    stream->pp_last = &seg->p_next;
+    stream->i_buffer_pos += i_data;
+    stream->i_buffered += i_data;
 
-        /* Ok, we can't go past the end of our buffer */
-        memcpy( &stream->p_buffer[i_pos], p_data, i_copy );
+    /* Forget the oldest data, clients still sending it keep a reference */
+    while( stream->i_buffered > stream->i_buffer_size
+        && stream->p_first != seg )
+    {
+        httpd_segment_t *old = stream->p_first;
 
-        i_pos = ( i_pos + i_copy ) % stream->i_buffer_size;
-        i_count -= i_copy;
-        p_data  += i_copy;
+        stream->p_first = old->p_next;
+        stream->i_buffered -= old->i_size;
+        httpd_SegmentRelease( old );
     }
 
-    stream->i_buffer_pos += i_data;
-
     vlc_mutex_unlock( &stream->lock );
     return VLC_SUCCESS;
 }
@@ -941,17 +1041,257 @@ int httpd_StreamSend( httpd_stream_t *stream, uint8_t *p_data, int i_data )
 void httpd_StreamDelete( httpd_stream_t *stream )
 {
     httpd_UrlDelete( stream->url );
+    while( stream->p_first != NULL )
+    {
+        httpd_segment_t *seg = stream->p_first;
+
+        stream->p_first = seg->p_next;
+        httpd_SegmentRelease( seg );
+    }
     vlc_mutex_destroy( &stream->lock );
     free( stream->psz_mime );
     free( stream->p_header );
-    free( stream->p_buffer );
     free( stream );
 }
 
+/*****************************************************************************
+ * High Level Functions: httpd_live_t
+ *****************************************************************************/
+struct httpd_live_t
+{
+    vlc_mutex_t lock;
+    httpd_url_t *url;
+
+    char    *psz_mime;
+
+    /* the whole content, oldest first */
+    httpd_segment_t *p_first;
+    httpd_segment_t **pp_last;
+    int64_t     i_end;      /* absolute position after the last byte */
+    bool        b_complete;
+};
+
+static int httpd_LiveCallBack( httpd_callback_sys_t *p_sys,
+                               httpd_client_t *cl, httpd_message_t *answer,
+                               const httpd_message_t *query )
+{
+    httpd_live_t *live = (httpd_live_t*)p_sys;
+
+    if( answer == NULL || query == NULL || cl == NULL )
+    {
+        return VLC_SUCCESS;
+    }
+
+    if( answer->i_body_offset > 0 )
+    {
+        int64_t i_write = 0;
+
+        vlc_mutex_lock( &live->lock );
+        if( answer->i_body_offset >= live->i_end )
+        {
+            bool b_complete = live->b_complete;
+
+            vlc_mutex_unlock( &live->lock );
+            if( !b_complete )
+                return VLC_EGENERIC;    /* wait, no data available */
+
+            /* everything has been sent: terminate the body */
+            answer->i_proto  = HTTPD_PROTO_HTTP;
+            answer->i_version= 1;
+            answer->i_type   = HTTPD_MSG_ANSWER;
+            if( cl->b_chunked )
+            {
+                answer->i_body = 5;
+                answer->p_body = (uint8_t *)strdup( "0\r\n\r\n" );
+                if( answer->p_body == NULL )
+                    answer->i_body = 0;
+            }
+            answer->i_body_offset = 0;
+            return VLC_SUCCESS;
+        }
+
+        /* Clients always stop at a segment boundary */
+        httpd_segment_t *seg = cl->p_resume;
+        if( seg != NULL
+         && seg->i_pos + (int64_t)seg->i_size == answer->i_body_offset )
+            seg = seg->p_next;
+        else
+            for( seg = live->p_first;
+                 seg->i_pos + (int64_t)seg->i_size <= answer->i_body_offset;
+                 seg = seg->p_next );
+
+        assert( cl->i_segment == 0 );
+        cl->i_segment_offset = 0;
+        while( seg != NULL && cl->i_segment < HTTPD_SEGMENTS_MAX )
+        {
+            vlc_atomic_inc( &seg->refs );
+            cl->segment[cl->i_segment++] = seg;
+            i_write += seg->i_size;
+            seg = seg->p_next;
+        }
+        vlc_mutex_unlock( &live->lock );
+
+        answer->i_proto  = HTTPD_PROTO_HTTP;
+        answer->i_version= 1;
+        answer->i_type   = HTTPD_MSG_ANSWER;
+
+        answer->i_body = 0;
+        answer->p_body = NULL;
+
+        answer->i_body_offset += i_write;
+        return VLC_SUCCESS;
+    }
+
+    answer->i_proto  = HTTPD_PROTO_HTTP;
+    answer->i_version= 1;
+    answer->i_type   = HTTPD_MSG_ANSWER;
+    answer->i_status = 200;
+
+    httpd_MsgAdd( answer, "Content-type",  "%s", live->psz_mime );
+    httpd_MsgAdd( answer, "Cache-Control", "%s", "no-cache" );
+
+    vlc_mutex_lock( &live->lock );
+    bool b_complete = live->b_complete;
+    int64_t i_size = live->i_end - 1;
+    vlc_mutex_unlock( &live->lock );
+
+    if( b_complete )
+        httpd_MsgAdd( answer, "Content-Length", "%"PRId64, i_size );
+    else if( query->i_version >= 1 )
+    {
+        /* The size is not known yet, send what is there as it comes */
+        httpd_MsgAdd( answer, "Transfer-Encoding", "%s", "chunked" );
+        if( query->i_type != HTTPD_MSG_HEAD )
+            cl->b_chunked = true;
+    }
+    else
+        /* HTTP/1.0 clients see the end when the connection is closed */
+        httpd_MsgAdd( answer, "Connection", "%s", "close" );
+
+    if( query->i_type != HTTPD_MSG_HEAD && ( i_size > 0 || !b_complete ) )
+    {
+        cl->b_stream_mode = true;
+        answer->i_body_offset = 1;
+    }
+    else
+        answer->i_body_offset = 0;
+    return VLC_SUCCESS;
+}
+
+/**
+ * Creates an in-memory file that can be served while it is being written.
+ * Until httpd_LiveEnd() is called, HTTP/1.1 clients receive it with chunked
+ * transfer encoding, and get new data as soon as it is appended.
+ */
+httpd_live_t *httpd_LiveNew( httpd_host_t *host,
+                             const char *psz_url, const char *psz_mime,
+                             const char *psz_user, const char *psz_password,
+                             const vlc_acl_t *p_acl )
+{
+    httpd_live_t *live = malloc( sizeof( *live ) );
+    if( unlikely(live == NULL) )
+        return NULL;
+
+    if( psz_mime && *psz_mime )
+        live->psz_mime = strdup( psz_mime );
+    else
+        live->psz_mime = strdup( httpd_MimeFromUrl( psz_url ) );
+    if( unlikely(live->psz_mime == NULL) )
+    {
+        free( live );
+        return NULL;
+    }
+
+    vlc_mutex_init( &live->lock );
+    live->p_first = NULL;
+    live->pp_last = &live->p_first;
+    /* positions start at 1 as with streams, i_body_offset 0 ends a body */
+    live->i_end = 1;
+    live->b_complete = false;
+
+    if( ( live->url = httpd_UrlNewUnique( host, psz_url, psz_user,
+                                          psz_password, p_acl ) ) == NULL )
+    {
+        vlc_mutex_destroy( &live->lock );
+        free( live->psz_mime );
+        free( live );
+        return NULL;
+    }
+
+    httpd_UrlCatch( live->url, HTTPD_MSG_HEAD, httpd_LiveCallBack,
+                    (httpd_callback_sys_t*)live );
+    httpd_UrlCatch( live->url, HTTPD_MSG_GET, httpd_LiveCallBack,
+                    (httpd_callback_sys_t*)live );
+    return live;
+}
+
+/**
+ * Appends data to an in-memory file. The data is copied once, and shared by
+ * all the clients.
+ */
+int httpd_LiveAppend( httpd_live_t *live, const uint8_t *p_data, size_t i_data )
+{
+    httpd_segment_t *seg;
+    char psz_hdr[sizeof(size_t) * 2 + 3];
+
+    if( i_data == 0 )
+        return VLC_SUCCESS;
+
+    /* Frame the data as a chunk once for all the chunked clients */
+    int i_hdr = snprintf( psz_hdr, sizeof( psz_hdr ), "%zx\r\n", i_data );
+
+    seg = malloc( sizeof( *seg ) + i_hdr + i_data + 2 );
+    if( unlikely(seg == NULL) )
+        return VLC_ENOMEM;
+    seg->p_next = NULL;
+    vlc_atomic_set( &seg->refs, 1 );
+    seg->i_size = i_data;
+    seg->i_hdr = i_hdr;
+    memcpy( seg->p_data, psz_hdr, i_hdr );
+    memcpy( seg->p_data + i_hdr, p_data, i_data );
+    memcpy( seg->p_data + i_hdr + i_data, "\r\n", 2 );
+
+    vlc_mutex_lock( &live->lock );
+    assert( !live->b_complete );
+    seg->i_pos = live->i_end;
+    *live->pp_last = seg;
+    live->pp_last = &seg->p_next;
+    live->i_end += i_data;
+    vlc_mutex_unlock( &live->lock );
+    return VLC_SUCCESS;
+}
+
+/**
+ * Marks an in-memory file as complete: pending bodies are terminated, and
+ * new clients get its size upfront.
+ */
+void httpd_LiveEnd( httpd_live_t *live )
+{
+    vlc_mutex_lock( &live->lock );
+    live->b_complete = true;
+    vlc_mutex_unlock( &live->lock );
+}
+
+void httpd_LiveDelete( httpd_live_t *live )
+{
+    httpd_UrlDelete( live->url );
+    while( live->p_first != NULL )
+    {
+        httpd_segment_t *seg = live->p_first;
+
+        live->p_first = seg->p_next;
+        httpd_SegmentRelease( seg );
+    }
+    vlc_mutex_destroy( &live->lock );
+    free( live->psz_mime );
+    free( live );
+}
+
 /*****************************************************************************
  * Low level
  *****************************************************************************/
-static void* httpd_HostThread( void * );
+static int httpd_WorkersStart( httpd_host_t * );
+static void httpd_WorkersStop( httpd_host_t * );
 static httpd_host_t *httpd_HostCreate( vlc_object_t *, const char *,
                                        const char *, vlc_tls_creds_t * );
 
@@ -1104,13 +1444,10 @@ static httpd_host_t *httpd_HostCreate( vlc_object_t *p_this,
     host->port     = port;
     host->i_url    = 0;
     host->url      = NULL;
-    host->i_client = 0;
-    host->client   = NULL;
     host->p_tls    = p_tls;
 
-    /* create the thread */
-    if( vlc_clone( &host->thread, httpd_HostThread, host,
-                   VLC_THREAD_PRIORITY_LOW ) )
+    /* create the threads */
+    if( httpd_WorkersStart( host ) )
     {
         msg_Err( p_this, "cannot spawn http host thread" );
         goto error;
@@ -1155,7 +1492,7 @@ void httpd_HostDelete( httpd_host_t *host )
     host->i_ref--;
     if( host->i_ref == 0 )
     {
-        vlc_cond_signal( &host->wait );
+        vlc_cond_broadcast( &host->wait );
         delete = true;
     }
     vlc_mutex_unlock( &host->lock );
@@ -1168,8 +1505,7 @@ void httpd_HostDelete( httpd_host_t *host )
     }
     TAB_REMOVE( httpd.i_host, httpd.host, host );
 
-    vlc_object_kill( host );
-    vlc_join( host->thread, NULL );
+    httpd_WorkersStop( host );
 
     msg_Dbg( host, "HTTP host removed" );
 
@@ -1177,16 +1513,6 @@ void httpd_HostDelete( httpd_host_t *host )
     {
         msg_Err( host, "url still registered: %s", host->url[i]->psz_url );
     }
-    for( i = 0; i < host->i_client; i++ )
-    {
-        httpd_client_t *cl = host->client[i];
-        msg_Warn( host, "client still connected" );
-        httpd_ClientClean( cl );
-        TAB_REMOVE( host->i_client, host->client, cl );
-        free( cl );
-        i--;
-        /* TODO */
-    }
 
     if( host->p_tls != NULL)
         vlc_tls_ServerDelete( host->p_tls );
@@ -1238,7 +1564,7 @@ static httpd_url_t *httpd_UrlNewPrivate( httpd_host_t *host, const char *psz_url
     }
 
     TAB_APPEND( host->i_url, host->url, url );
-    vlc_cond_signal( &host->wait );
+    vlc_cond_broadcast( &host->wait );
     vlc_mutex_unlock( &host->lock );
 
     return url;
@@ -1276,33 +1602,41 @@ int httpd_UrlCatch( httpd_url_t *url, int i_msg, httpd_callback_t cb,
 void httpd_UrlDelete( httpd_url_t *url )
 {
     httpd_host_t *host = url->host;
-    int          i;
 
     vlc_mutex_lock( &host->lock );
     TAB_REMOVE( host->i_url, host->url, url );
+    vlc_mutex_unlock( &host->lock );
 
-    vlc_mutex_destroy( &url->lock );
-    free( url->psz_url );
-    free( url->psz_user );
-    free( url->psz_password );
-    ACL_Destroy( url->p_acl );
-
-    for( i = 0; i < host->i_client; i++ )
+    /* Workers lock themselves before the host, so this is done apart */
+    for( unsigned i = 0; i < host->i_worker; i++ )
     {
-        httpd_client_t *client = host->client[i];
+        httpd_worker_t *worker = &host->worker[i];
 
-        if( client->url == url )
+        vlc_mutex_lock( &worker->lock );
+        for( int j = 0; j < worker->i_client; j++ )
         {
-            /* TODO complete it */
-            msg_Warn( host, "force closing connections" );
-            httpd_ClientClean( client );
-            TAB_REMOVE( host->i_client, host->client, client );
-            free( client );
-            i--;
+            httpd_client_t *client = worker->client[j];
+
+            if( client->url == url )
+            {
+                /* TODO complete it */
+                msg_Warn( host, "force closing connections" );
+                /* The worker may have pending events for the client, it
+                 * will free it itself */
+                httpd_ClientClean( client );
+                client->url = NULL;
+                client->i_state = HTTPD_CLIENT_DEAD;
+            }
         }
+        vlc_mutex_unlock( &worker->lock );
     }
+
+    vlc_mutex_destroy( &url->lock );
+    free( url->psz_url );
+    free( url->psz_user );
+    free( url->psz_password );
+    ACL_Destroy( url->p_acl );
     free( url );
-    vlc_mutex_unlock( &host->lock );
 }
 
 static void httpd_MsgInit( httpd_message_t *msg )
@@ -1391,6 +1725,9 @@ static void httpd_ClientInit( httpd_client_t *cl, mtime_t now )
     cl->i_buffer = 0;
     cl->p_buffer = xmalloc( cl->i_buffer_size );
     cl->b_stream_mode = false;
+    cl->b_chunked = false;
+    cl->i_segment = 0;
+    cl->p_resume = NULL;
 
     httpd_MsgInit( &cl->query );
     httpd_MsgInit( &cl->answer );
@@ -1421,6 +1758,14 @@ static void httpd_ClientClean( httpd_client_t *cl )
 
     free( cl->p_buffer );
     cl->p_buffer = NULL;
+
+    while( cl->i_segment > 0 )
+        httpd_SegmentRelease( cl->segment[--cl->i_segment] );
+    if( cl->p_resume != NULL )
+    {
+        httpd_SegmentRelease( cl->p_resume );
+        cl->p_resume = NULL;
+    }
 }
 
 static httpd_client_t *httpd_ClientNew( int fd, vlc_tls_t *p_tls, mtime_t now )
@@ -1431,6 +1776,7 @@ static httpd_client_t *httpd_ClientNew( int fd, vlc_tls_t *p_tls, mtime_t now )
 
     cl->i_ref   = 0;
     cl->fd      = fd;
+    cl->i_events = 0;
     cl->url     = NULL;
     cl->p_tls = p_tls;
 
@@ -1468,6 +1814,29 @@ ssize_t httpd_NetSend (httpd_client_t *cl, const uint8_t *p, size_t i_len)
 }
 
 
+static
+ssize_t httpd_NetSendv (httpd_client_t *cl, const struct iovec *iov,
+                        unsigned count)
+{
+#ifndef WIN32
+    if (cl->p_tls == NULL && count > 1)
+    {
+        struct msghdr hdr;
+        ssize_t val;
+
+        memset (&hdr, 0, sizeof (hdr));
+        hdr.msg_iov = (struct iovec *)iov;
+        hdr.msg_iovlen = count;
+        do
+            val = sendmsg (cl->fd, &hdr, 0);
+        while (val == -1 && errno == EINTR);
+        return val;
+    }
+#endif
+    /* TLS sessions take one buffer at a time */
+    return httpd_NetSend (cl, iov[0].iov_base, iov[0].iov_len);
+}
+
 static const struct
 {
     const char name[16];
@@ -1895,6 +2264,43 @@ static void httpd_ClientRecv( httpd_client_t *cl )
 #endif
 }
 
+/* Sends stream segments, releases those fully sent */
+static ssize_t httpd_ClientSendSegments( httpd_client_t *cl )
+{
+    struct iovec iov[HTTPD_SEGMENTS_MAX];
+    unsigned i;
+
+    for( i = 0; i < cl->i_segment; i++ )
+    {
+        iov[i].iov_base = (uint8_t *)httpd_SegmentData( cl->segment[i],
+                                                        cl->b_chunked );
+        iov[i].iov_len = httpd_SegmentSize( cl->segment[i], cl->b_chunked );
+    }
+    iov[0].iov_base = (uint8_t *)iov[0].iov_base + cl->i_segment_offset;
+    iov[0].iov_len -= cl->i_segment_offset;
+
+    ssize_t i_len = httpd_NetSendv( cl, iov, cl->i_segment );
+    if( i_len <= 0 )
+        return i_len;
+
+    size_t i_sent = cl->i_segment_offset + i_len;
+    for( i = 0; i < cl->i_segment
+             && i_sent >= httpd_SegmentSize( cl->segment[i], cl->b_chunked );
+         i++ )
+    {
+        i_sent -= httpd_SegmentSize( cl->segment[i], cl->b_chunked );
+        /* keep the last one to find the next segment from there */
+        if( cl->p_resume != NULL )
+            httpd_SegmentRelease( cl->p_resume );
+        cl->p_resume = cl->segment[i];
+    }
+    cl->i_segment -= i;
+    memmove( cl->segment, cl->segment + i,
+             cl->i_segment * sizeof( *cl->segment ) );
+    cl->i_segment_offset = i_sent;
+    return i_len;
+}
+
 static void httpd_ClientSend( httpd_client_t *cl )
 {
     int i;
@@ -1940,13 +2346,21 @@ static void httpd_ClientSend( httpd_client_t *cl )
         fprintf( stderr, "%s",  cl->p_buffer );*/
     }
 
-    i_len = httpd_NetSend( cl, &cl->p_buffer[cl->i_buffer],
-                           cl->i_buffer_size - cl->i_buffer );
+    if( cl->i_buffer >= cl->i_buffer_size && cl->i_segment > 0 )
+    {
+        /* stream data, straight from the stream segments */
+        i_len = httpd_ClientSendSegments( cl );
+    }
+    else
+    {
+        i_len = httpd_NetSend( cl, &cl->p_buffer[cl->i_buffer],
+                               cl->i_buffer_size - cl->i_buffer );
+        if( i_len > 0 )
+            cl->i_buffer += i_len;
+    }
     if( i_len >= 0 )
     {
-        cl->i_buffer += i_len;
-
-        if( cl->i_buffer >= cl->i_buffer_size )
+        if( cl->i_buffer >= cl->i_buffer_size && cl->i_segment == 0 )
         {
             if( cl->answer.i_body == 0  && cl->answer.i_body_offset > 0 )
             {
@@ -1972,7 +2386,7 @@ static void httpd_ClientSend( httpd_client_t *cl )
                 cl->answer.i_body = 0;
                 cl->answer.p_body = NULL;
             }
-            else
+            else if( cl->i_segment == 0 )
             {
                 /* send finished */
                 cl->i_state = HTTPD_CLIENT_SEND_DONE;
@@ -2030,63 +2444,212 @@ static void httpd_ClientTlsHsOut( httpd_client_t *cl )
     }
 }
 
-static void* httpd_HostThread( void *data )
+/*****************************************************************************
+ * Worker event loop: epoll where available, poll otherwise
+ *****************************************************************************
+ * The data of an event is its client, NULL for a listening socket, or the
+ * host when the worker shall exit.
+ *****************************************************************************/
+#ifndef HAVE_SYS_EPOLL_H
+static void httpd_PollAdd( httpd_worker_t *worker, int fd, short events,
+                           void *p_data )
+{
+    if( worker->i_fd == worker->i_fd_max )
+    {
+        unsigned i_max = worker->i_fd_max ? 2 * worker->i_fd_max : 16;
+        struct pollfd *ufd = realloc( worker->ufd, i_max * sizeof(*ufd) );
+        if( ufd != NULL )
+            worker->ufd = ufd;
+        void **data = realloc( worker->data, i_max * sizeof(*data) );
+        if( data != NULL )
+            worker->data = data;
+        if( ufd == NULL || data == NULL )
+            return;
+        worker->i_fd_max = i_max;
+    }
+
+    worker->ufd[worker->i_fd].fd = fd;
+    worker->ufd[worker->i_fd].events = events;
+    worker->ufd[worker->i_fd].revents = 0;
+    worker->data[worker->i_fd] = p_data;
+    worker->i_fd++;
+}
+#endif
+
+static int httpd_PollInit( httpd_worker_t *worker )
+{
+#ifdef HAVE_SYS_EPOLL_H
+    httpd_host_t *host = worker->host;
+    struct epoll_event ev;
+
+    worker->epfd = epoll_create1( EPOLL_CLOEXEC );
+    if( worker->epfd == -1 )
+        return VLC_EGENERIC;
+
+    ev.events = EPOLLIN;
+    ev.data.ptr = host;
+    if( epoll_ctl( worker->epfd, EPOLL_CTL_ADD,
+                   vlc_object_waitpipe( VLC_OBJECT( host ) ), &ev ) )
+        goto error;
+
+    for( unsigned i = 0; i < host->nfd; i++ )
+    {
+        ev.events = EPOLLIN;
+# ifdef EPOLLEXCLUSIVE
+        /* wake up one worker per connection */
+        ev.events |= EPOLLEXCLUSIVE;
+# endif
+        ev.data.ptr = NULL;
+        if( epoll_ctl( worker->epfd, EPOLL_CTL_ADD, host->fds[i], &ev ) )
+            goto error;
+    }
+    return VLC_SUCCESS;
+
+error:
+    close( worker->epfd );
+    return VLC_EGENERIC;
+#else
+    worker->i_fd = worker->i_fd_max = 0;
+    worker->ufd = NULL;
+    worker->data = NULL;
+    return VLC_SUCCESS;
+#endif
+}
+
+static void httpd_PollClean( httpd_worker_t *worker )
+{
+#ifdef HAVE_SYS_EPOLL_H
+    close( worker->epfd );
+#else
+    free( worker->ufd );
+    free( worker->data );
+#endif
+}
+
+/* Starts an iteration of the loop */
+static void httpd_PollBegin( httpd_worker_t *worker )
 {
-    httpd_host_t *host = data;
+#ifdef HAVE_SYS_EPOLL_H
+    VLC_UNUSED( worker );
+#else
+    httpd_host_t *host = worker->host;
+
+    worker->i_fd = 0;
+    for( unsigned i = 0; i < host->nfd; i++ )
+        httpd_PollAdd( worker, host->fds[i], POLLIN, NULL );
+    httpd_PollAdd( worker, vlc_object_waitpipe( VLC_OBJECT( host ) ),
+                   POLLIN, host );
+#endif
+}
+
+/* Sets the events to wait for on a client, none to leave it aside */
+static void httpd_PollSet( httpd_worker_t *worker, httpd_client_t *cl,
+                           short events )
+{
+#ifdef HAVE_SYS_EPOLL_H
+    /* epoll only keeps track of changes */
+    if( events == cl->i_events )
+        return;
+    if( cl->fd == -1 )
+    {
+        /* closed, hence already out of the epoll set */
+        cl->i_events = 0;
+        return;
+    }
+
+    struct epoll_event ev;
+    int op = cl->i_events == 0 ? EPOLL_CTL_ADD
+           : events == 0 ? EPOLL_CTL_DEL : EPOLL_CTL_MOD;
+
+    ev.events = ((events & POLLIN) ? EPOLLIN : 0)
+              | ((events & POLLOUT) ? EPOLLOUT : 0);
+    ev.data.ptr = cl;
+    if( epoll_ctl( worker->epfd, op, cl->fd, &ev ) == 0 )
+        cl->i_events = events;
+#else
+    if( events != 0 )
+        httpd_PollAdd( worker, cl->fd, events, cl );
+#endif
+}
+
+/* Waits for events, returns the number of events to look at, or -1 */
+static int httpd_PollWait( httpd_worker_t *worker, int timeout )
+{
+#ifdef HAVE_SYS_EPOLL_H
+    return epoll_wait( worker->epfd, worker->events, HTTPD_EVENTS_MAX,
+                       timeout );
+#else
+    int val = poll( worker->ufd, worker->i_fd, timeout );
+    return (val > 0) ? (int)worker->i_fd : val;
+#endif
+}
+
+/* Returns the received events (0 if none) and the data of the i-th event */
+static short httpd_PollEvent( httpd_worker_t *worker, int i, void **pp_data )
+{
+#ifdef HAVE_SYS_EPOLL_H
+    const struct epoll_event *ev = &worker->events[i];
+
+    *pp_data = ev->data.ptr;
+    return ((ev->events & EPOLLIN) ? POLLIN : 0)
+         | ((ev->events & EPOLLOUT) ? POLLOUT : 0)
+         | ((ev->events & EPOLLERR) ? POLLERR : 0)
+         | ((ev->events & EPOLLHUP) ? POLLHUP : 0);
+#else
+    *pp_data = worker->data[i];
+    return worker->ufd[i].revents;
+#endif
+}
+
+static void* httpd_WorkerThread( void *data )
+{
+    httpd_worker_t *worker = data;
+    httpd_host_t *host = worker->host;
     counter_t *p_total_counter = stats_CounterCreate( host, VLC_VAR_INTEGER, STATS_COUNTER );
     counter_t *p_active_counter = stats_CounterCreate( host, VLC_VAR_INTEGER, STATS_COUNTER );
-    int evfd = vlc_object_waitpipe( VLC_OBJECT( host ) );
 
     for( ;; )
     {
-        struct pollfd ufd[host->nfd + host->i_client + 1];
-        unsigned nfd;
-        for( nfd = 0; nfd < host->nfd; nfd++ )
-        {
-            ufd[nfd].fd = host->fds[nfd];
-            ufd[nfd].events = POLLIN;
-            ufd[nfd].revents = 0;
-        }
+        httpd_PollBegin( worker );
 
-        /* add all socket that should be read/write and close dead connection */
         vlc_mutex_lock( &host->lock );
         while( host->i_url <= 0 && host->i_ref > 0 )
             vlc_cond_wait( &host->wait, &host->lock );
+        vlc_mutex_unlock( &host->lock );
 
+        /* add all socket that should be read/write and close dead connection */
+        vlc_mutex_lock( &worker->lock );
         mtime_t now = mdate();
         bool b_low_delay = false;
 
-        for(int i_client = 0; i_client < host->i_client; i_client++ )
+        for(int i_client = 0; i_client < worker->i_client; i_client++ )
         {
-            httpd_client_t *cl = host->client[i_client];
+            httpd_client_t *cl = worker->client[i_client];
             if( cl->i_ref < 0 || ( cl->i_ref == 0 &&
                 ( cl->i_state == HTTPD_CLIENT_DEAD ||
                   ( cl->i_activity_timeout > 0 &&
                     cl->i_activity_date+cl->i_activity_timeout < now) ) ) )
             {
+                httpd_PollSet( worker, cl, 0 );
                 httpd_ClientClean( cl );
                 stats_UpdateInteger( host, p_active_counter, -1, NULL );
-                TAB_REMOVE( host->i_client, host->client, cl );
+                TAB_REMOVE( worker->i_client, worker->client, cl );
                 free( cl );
                 i_client--;
                 continue;
             }
 
-            struct pollfd *pufd = ufd + nfd;
-            assert (pufd < ufd + (sizeof (ufd) / sizeof (ufd[0])));
-
-            pufd->fd = cl->fd;
-            pufd->events = pufd->revents = 0;
+            short events = 0;
 
             if( ( cl->i_state == HTTPD_CLIENT_RECEIVING )
                   || ( cl->i_state == HTTPD_CLIENT_TLS_HS_IN ) )
             {
-                pufd->events = POLLIN;
+                events = POLLIN;
             }
             else if( ( cl->i_state == HTTPD_CLIENT_SENDING )
                   || ( cl->i_state == HTTPD_CLIENT_TLS_HS_OUT ) )
             {
-                pufd->events = POLLOUT;
+                events = POLLOUT;
             }
             else if( cl->i_state == HTTPD_CLIENT_RECEIVE_DONE )
             {
@@ -2182,6 +2745,7 @@ static void* httpd_HostThread( void *data )
                     bool b_hosts_failed = false;
 
                     /* Search the url and trigger callbacks */
+                    vlc_mutex_lock( &host->lock );
                     for(int i = 0; i < host->i_url; i++ )
                     {
                         httpd_url_t *url = host->url[i];
@@ -2260,6 +2824,7 @@ static void* httpd_HostThread( void *data )
                             }
                         }
                     }
+                    vlc_mutex_unlock( &host->lock );
 
                     if( answer )
                     {
@@ -2307,6 +2872,13 @@ static void* httpd_HostThread( void *data )
                     bool b_query = false;
 
                     cl->url = NULL;
+                    cl->b_stream_mode = false;
+                    cl->b_chunked = false;
+                    if( cl->p_resume != NULL )
+                    {
+                        httpd_SegmentRelease( cl->p_resume );
+                        cl->p_resume = NULL;
+                    }
                     if( psz_connection )
                     {
                         b_connection = ( strcasecmp( psz_connection, "Close" ) == 0 );
@@ -2375,20 +2947,15 @@ static void* httpd_HostThread( void *data )
                 }
             }
 
-            if (pufd->events != 0)
-                nfd++;
-            else
+            httpd_PollSet( worker, cl, events );
+            if( events == 0 )
                 b_low_delay = true;
         }
-        vlc_mutex_unlock( &host->lock );
-
-        ufd[nfd].fd = evfd;
-        ufd[nfd].events = POLLIN;
-        ufd[nfd].revents = 0;
-        nfd++;
+        vlc_mutex_unlock( &worker->lock );
 
         /* we will wait 20ms (not too big) if HTTPD_CLIENT_WAITING */
-        switch( poll( ufd, nfd, b_low_delay ? 20 : -1) )
+        int i_events = httpd_PollWait( worker, b_low_delay ? 20 : -1 );
+        switch( i_events )
         {
             case -1:
                 if (errno != EINTR)
@@ -2401,25 +2968,30 @@ static void* httpd_HostThread( void *data )
                 continue;
         }
 
-        if( ufd[nfd - 1].revents )
-            break;
-
         /* Handle client sockets */
-        vlc_mutex_lock( &host->lock );
+        bool b_accept = false;
+        bool b_exit = false;
+
+        vlc_mutex_lock( &worker->lock );
         now = mdate();
-        nfd = host->nfd;
-        for( int i_client = 0; i_client < host->i_client; i_client++ )
+        for( int i = 0; i < i_events && !b_exit; i++ )
         {
-            httpd_client_t *cl = host->client[i_client];
-            const struct pollfd *pufd = &ufd[nfd];
-
-            assert( pufd < &ufd[sizeof(ufd) / sizeof(ufd[0])] );
+            void *p_data;
 
-            if( cl->fd != pufd->fd )
-                continue; // we were not waiting for this client
-            ++nfd;
-            if( pufd->revents == 0 )
+            if( httpd_PollEvent( worker, i, &p_data ) == 0 )
                 continue; // no event received
+            if( p_data == host )
+            {
+                b_exit = true;
+                continue;
+            }
+            if( p_data == NULL )
+            {
+                b_accept = true; // a listening socket
+                continue;
+            }
+
+            httpd_client_t *cl = p_data;
 
             cl->i_activity_date = now;
 
@@ -2440,22 +3012,23 @@ static void* httpd_HostThread( void *data )
                 httpd_ClientTlsHsOut( cl );
             }
         }
-        vlc_mutex_unlock( &host->lock );
+        vlc_mutex_unlock( &worker->lock );
+
+        if( b_exit )
+            break;
+        if( !b_accept )
+            continue;
 
-        /* Handle server sockets (accept new connections) */
-        for( nfd = 0; nfd < host->nfd; nfd++ )
+        /* Handle server sockets (accept new connections). The sockets are
+         * shared by all the workers, the first one to accept gets the
+         * client. */
+        for( unsigned nfd = 0; nfd < host->nfd; nfd++ )
         {
             httpd_client_t *cl;
             int i_state = -1;
-            int fd = ufd[nfd].fd;
-
-            assert (fd == host->fds[nfd]);
-
-            if( ufd[nfd].revents == 0 )
-                continue;
 
             /* */
-            fd = vlc_accept (fd, NULL, NULL, true);
+            int fd = vlc_accept (host->fds[nfd], NULL, NULL, true);
             if (fd == -1)
                 continue;
             setsockopt (fd, SOL_SOCKET, SO_REUSEADDR,
@@ -2491,11 +3064,11 @@ static void* httpd_HostThread( void *data )
             stats_UpdateInteger( host, p_total_counter, 1, NULL );
             stats_UpdateInteger( host, p_active_counter, 1, NULL );
             cl = httpd_ClientNew( fd, p_tls, now );
-            vlc_mutex_lock( &host->lock );
-            TAB_APPEND( host->i_client, host->client, cl );
-            vlc_mutex_unlock( &host->lock );
             if( i_state != -1 )
                 cl->i_state = i_state; // override state for TLS
+            vlc_mutex_lock( &worker->lock );
+            TAB_APPEND( worker->i_client, worker->client, cl );
+            vlc_mutex_unlock( &worker->lock );
         }
 
     }
@@ -2506,3 +3079,75 @@ static void* httpd_HostThread( void *data )
         stats_CounterClean( p_active_counter );
     return NULL;
 }
+
+/* Starts one worker per CPU, or at least one */
+static int httpd_WorkersStart( httpd_host_t *host )
+{
+    unsigned i_worker = __MIN( vlc_GetCPUCount(), HTTPD_WORKERS_MAX );
+
+    host->worker = calloc( __MAX( i_worker, 1 ), sizeof( *host->worker ) );
+    if( host->worker == NULL )
+        return VLC_ENOMEM;
+
+    host->i_worker = 0;
+    do
+    {
+        httpd_worker_t *worker = &host->worker[host->i_worker];
+
+        worker->host = host;
+        vlc_mutex_init( &worker->lock );
+        worker->i_client = 0;
+        worker->client = NULL;
+
+        if( httpd_PollInit( worker ) )
+        {
+            vlc_mutex_destroy( &worker->lock );
+            break;
+        }
+        if( vlc_clone( &worker->thread, httpd_WorkerThread, worker,
+                       VLC_THREAD_PRIORITY_LOW ) )
+        {
+            httpd_PollClean( worker );
+            vlc_mutex_destroy( &worker->lock );
+            break;
+        }
+        host->i_worker++;
+    }
+    while( host->i_worker < i_worker );
+
+    if( host->i_worker == 0 )
+    {
+        free( host->worker );
+        return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+static void httpd_WorkersStop( httpd_host_t *host )
+{
+    vlc_object_kill( host );
+    for( unsigned i = 0; i < host->i_worker; i++ )
+        vlc_join( host->worker[i].thread, NULL );
+
+    for( unsigned i = 0; i < host->i_worker; i++ )
+    {
+        httpd_worker_t *worker = &host->worker[i];
+
+        /* The worker is gone: close and free the clients it left, as it
+         * does with dead ones */
+        for( int j = 0; j < worker->i_client; j++ )
+        {
+            httpd_client_t *cl = worker->client[j];
+            msg_Warn( host, "client still connected" );
+            httpd_PollSet( worker, cl, 0 );
+            httpd_ClientClean( cl );
+            free( cl );
+        }
+        free( worker->client );
+        worker->client = NULL;
+        worker->i_client = 0;
+        httpd_PollClean( worker );
+        vlc_mutex_destroy( &worker->lock );
+    }
+    free( host->worker );
+}
@@ -950,3 +950,15 @@ unsigned vlc_GetCPUCount (void)
 
     return numprocs;
 }
+
+/* Threads do not inherit the affinity of their creator: no NUMA binding */
+unsigned vlc_numa_GetNodeCount (void)
+{
+    return 0;
+}
+
+int vlc_numa_Bind (int node)
+{
+    (void) node;
+    return ENOSYS;
+}
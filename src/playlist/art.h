@@ -31,6 +31,7 @@ typedef struct
     char *psz_album;
     char *psz_arturl;
     bool b_found;
+    bool b_pending; /* being searched */
 
 } playlist_album_t;
 
@@ -0,0 +1,129 @@
+/*****************************************************************************
+ * changes.c : log of the changes of the playlist tree
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+#include <time.h>
+
+#include <vlc_common.h>
+#include <vlc_playlist.h>
+#include "playlist_internal.h"
+
+/*
+ * Remote interfaces used to render the whole tree again on each poll. They
+ * can now remember the revision they have shown, and fetch what changed
+ * since then only. Revision N is stored in ring[N % PLAYLIST_CHANGES_MAX].
+ */
+
+void playlist_ChangesInit( playlist_t *p_playlist )
+{
+    playlist_private_t *p_sys = pl_priv(p_playlist);
+
+    vlc_mutex_init( &p_sys->changes.lock );
+    vlc_cond_init( &p_sys->changes.wait );
+    /* Revisions of a previous run must not be mistaken for ours. They must
+     * also stay exact as Lua numbers (doubles printed with 14 digits). */
+    p_sys->changes.i_first = (uint64_t)( time( NULL ) & 0xffffff ) << 16;
+    p_sys->changes.i_revision = p_sys->changes.i_first;
+}
+
+void playlist_ChangesClean( playlist_t *p_playlist )
+{
+    playlist_private_t *p_sys = pl_priv(p_playlist);
+
+    vlc_cond_destroy( &p_sys->changes.wait );
+    vlc_mutex_destroy( &p_sys->changes.lock );
+}
+
+/**
+ * Records a change of the tree, and wakes up playlist_WaitChange().
+ * This can be called with or without the playlist lock.
+ */
+void playlist_RecordChange( playlist_t *p_playlist, int i_type, int i_id,
+                            int i_node, int i_count )
+{
+    playlist_private_t *p_sys = pl_priv(p_playlist);
+
+    vlc_mutex_lock( &p_sys->changes.lock );
+    uint64_t i_revision = ++p_sys->changes.i_revision;
+    playlist_change_t *p_change =
+        &p_sys->changes.ring[i_revision % PLAYLIST_CHANGES_MAX];
+
+    p_change->i_revision = i_revision;
+    p_change->i_type = i_type;
+    p_change->i_id = i_id;
+    p_change->i_node = i_node;
+    p_change->i_count = i_count;
+    vlc_cond_broadcast( &p_sys->changes.wait );
+    vlc_mutex_unlock( &p_sys->changes.lock );
+}
+
+int playlist_GetChanges( playlist_t *p_playlist, uint64_t i_since,
+                         playlist_change_t **pp_changes, unsigned *pi_count,
+                         uint64_t *pi_revision )
+{
+    playlist_private_t *p_sys = pl_priv(p_playlist);
+    int i_ret = VLC_SUCCESS;
+
+    *pp_changes = NULL;
+    *pi_count = 0;
+
+    vlc_mutex_lock( &p_sys->changes.lock );
+    uint64_t i_revision = p_sys->changes.i_revision;
+
+    *pi_revision = i_revision;
+    if( i_since < p_sys->changes.i_first || i_since > i_revision
+     || i_revision - i_since > PLAYLIST_CHANGES_MAX )
+        i_ret = VLC_EGENERIC;
+    else if( i_since < i_revision )
+    {
+        unsigned i_count = i_revision - i_since;
+        playlist_change_t *p_changes = malloc( i_count * sizeof(*p_changes) );
+
+        if( likely(p_changes != NULL) )
+        {
+            for( unsigned i = 0; i < i_count; i++ )
+                p_changes[i] = p_sys->changes.ring[(i_since + 1 + i)
+                                                   % PLAYLIST_CHANGES_MAX];
+            *pp_changes = p_changes;
+            *pi_count = i_count;
+        }
+        else
+            i_ret = VLC_ENOMEM;
+    }
+    vlc_mutex_unlock( &p_sys->changes.lock );
+    return i_ret;
+}
+
+uint64_t playlist_WaitChange( playlist_t *p_playlist, uint64_t i_since,
+                              mtime_t deadline )
+{
+    playlist_private_t *p_sys = pl_priv(p_playlist);
+    uint64_t i_revision;
+
+    vlc_mutex_lock( &p_sys->changes.lock );
+    mutex_cleanup_push( &p_sys->changes.lock );
+    while( p_sys->changes.i_revision == i_since
+        && !vlc_cond_timedwait( &p_sys->changes.wait, &p_sys->changes.lock,
+                                deadline ) );
+    i_revision = p_sys->changes.i_revision;
+    vlc_cleanup_run();
+    return i_revision;
+}
@@ -31,6 +31,8 @@
 #include <vlc_sout.h>
 #include <vlc_playlist.h>
 #include <vlc_interface.h>
+#include <vlc_memstats.h>
+#include <synchronicity/syn_stream.h>
 #include "playlist_internal.h"
 #include "stream_output/stream_output.h" /* sout_DeleteInstance */
 #include <math.h> /* for fabs() */
@@ -182,6 +184,9 @@ playlist_t * playlist_Create( vlc_object_t *p_parent )
     VariablesInit( p_playlist );
     vlc_mutex_init( &p->lock );
     vlc_cond_init( &p->signal );
+    vlc_mutex_init( &p->syn_start_lock );
+    vlc_mutex_init( &p->syn_seek_lock );
+    playlist_ChangesInit( p_playlist );
 
     /* Initialise data structures */
     pl_priv(p_playlist)->i_last_playlist_id = 0;
@@ -191,6 +196,12 @@ playlist_t * playlist_Create( vlc_object_t *p_parent )
     ARRAY_INIT( p_playlist->all_items );
     ARRAY_INIT( pl_priv(p_playlist)->items_to_delete );
     ARRAY_INIT( p_playlist->current );
+    p->input_map.pp_buckets = NULL;
+    p->input_map.i_buckets = 0;
+    p->input_map.i_count = 0;
+    p->input_map.b_failed = false;
+    ARRAY_INIT( p->batches );
+    p->p_search = playlist_search_New();
 
     p_playlist->i_current_index = 0;
     pl_priv(p_playlist)->b_reset_currently_playing = true;
@@ -266,6 +277,7 @@ playlist_t * playlist_Create( vlc_object_t *p_parent )
 
     /* this is read in PlayItem so it needs to be initialized here */
     pl_priv(p_playlist)->b_syn_created = false;
+    pl_priv(p_playlist)->b_syn_host = false;
 
     if(b_ml)
     {
@@ -299,6 +311,16 @@ void playlist_Destroy( playlist_t *p_playlist )
     assert( !p_sys->p_input );
     assert( !p_sys->p_input_resource );
 
+    if( p_sys->b_syn_slew_timer )
+        vlc_timer_destroy( p_sys->syn_slew_timer );
+    if( p_sys->b_syn_start_timer )
+        vlc_timer_destroy( p_sys->syn_start_timer );
+    vlc_mutex_destroy( &p_sys->syn_start_lock );
+    if( p_sys->b_syn_seek_timer )
+        vlc_timer_destroy( p_sys->syn_seek_timer );
+    vlc_mutex_destroy( &p_sys->syn_seek_lock );
+
+    playlist_ChangesClean( p_playlist );
     vlc_cond_destroy( &p_sys->signal );
     vlc_mutex_destroy( &p_sys->lock );
 
@@ -306,15 +328,23 @@ void playlist_Destroy( playlist_t *p_playlist )
     FOREACH_ARRAY( playlist_item_t *p_del, p_playlist->all_items )
         free( p_del->pp_children );
         vlc_gc_decref( p_del->p_input );
-        free( p_del );
+        vlc_free_tagged( VLC_MEM_PLAYLIST, p_del, sizeof(*p_del) );
     FOREACH_END();
     ARRAY_RESET( p_playlist->all_items );
+    playlist_ItemMapClean( p_playlist );
     FOREACH_ARRAY( playlist_item_t *p_del, p_sys->items_to_delete )
         free( p_del->pp_children );
         vlc_gc_decref( p_del->p_input );
-        free( p_del );
+        vlc_free_tagged( VLC_MEM_PLAYLIST, p_del, sizeof(*p_del) );
     FOREACH_END();
     ARRAY_RESET( p_sys->items_to_delete );
+    FOREACH_ARRAY( playlist_batch_t batch, p_sys->batches )
+        vlc_gc_decref( batch.p_input );
+    FOREACH_END();
+    ARRAY_RESET( p_sys->batches );
+
+    if( p_sys->p_search )
+        playlist_search_Delete( p_sys->p_search );
 
     ARRAY_RESET( p_playlist->items );
     ARRAY_RESET( p_playlist->current );
@@ -403,6 +433,7 @@ static void VariablesInit( playlist_t *p_playlist )
     var_SetInteger( p_playlist, "playlist-item-deleted", -1 );
 
     var_Create( p_playlist, "playlist-item-append", VLC_VAR_ADDRESS );
+    var_Create( p_playlist, "playlist-items-append", VLC_VAR_ADDRESS );
 
     var_Create( p_playlist, "item-current", VLC_VAR_ADDRESS );
     var_Create( p_playlist, "input-current", VLC_VAR_ADDRESS );
@@ -450,6 +481,22 @@ static void VariablesInit( playlist_t *p_playlist )
 
     var_Create( p_playlist, "synchronicity-user", VLC_VAR_STRING );
     var_SetString( p_playlist, "synchronicity-user", "Anonymous" );
+
+    /* Every input also goes to the relay, which only takes it from the
+     * host of a viewing; see modules/access_output/synchronicity.c */
+    if( var_InheritBool( p_playlist, "synchronicity-stream" ) )
+    {
+        char *psz_sout = var_InheritString( p_playlist, "sout" );
+        if( psz_sout == NULL )
+        {
+            var_Create( p_playlist, "sout", VLC_VAR_STRING );
+            var_SetString( p_playlist, "sout", SYN_STREAM_SOUT );
+        }
+        else
+            msg_Warn( p_playlist, "not streaming to the peers, there is "
+                      "a stream output already (%s)", psz_sout );
+        free( psz_sout );
+    }
 }
 
 playlist_item_t * playlist_CurrentPlayingItem( playlist_t * p_playlist )
@@ -35,6 +35,7 @@
 #include <vlc_memory.h>
 #include <vlc_demux.h>
 #include <vlc_modules.h>
+#include <vlc_url.h>
 
 #include "art.h"
 #include "fetcher.h"
@@ -43,18 +44,31 @@
 /*****************************************************************************
  * Structures/definitions
  *****************************************************************************/
+/* Most items fetched at the same time */
+#define FETCHER_THREADS 4
+/* Most downloads from one server at the same time */
+#define FETCHER_PER_HOST 2
+
+typedef struct
+{
+    char *psz_host;
+    int i_count;
+} fetcher_host_t;
+
 struct playlist_fetcher_t
 {
     playlist_t      *p_playlist;
 
     vlc_mutex_t     lock;
     vlc_cond_t      wait;
-    bool            b_live;
+    int             i_threads;
     int             i_art_policy;
     int             i_waiting;
     input_item_t    **pp_waiting;
 
+    DECL_ARRAY(input_item_t *) running;
     DECL_ARRAY(playlist_album_t) albums;
+    DECL_ARRAY(fetcher_host_t) hosts;
 };
 
 static void *Thread( void * );
@@ -72,11 +86,13 @@ playlist_fetcher_t *playlist_fetcher_New( playlist_t *p_playlist )
     p_fetcher->p_playlist = p_playlist;
     vlc_mutex_init( &p_fetcher->lock );
     vlc_cond_init( &p_fetcher->wait );
-    p_fetcher->b_live = false;
+    p_fetcher->i_threads = 0;
     p_fetcher->i_waiting = 0;
     p_fetcher->pp_waiting = NULL;
     p_fetcher->i_art_policy = var_GetInteger( p_playlist, "album-art" );
+    ARRAY_INIT( p_fetcher->running );
     ARRAY_INIT( p_fetcher->albums );
+    ARRAY_INIT( p_fetcher->hosts );
 
     return p_fetcher;
 }
@@ -84,20 +100,33 @@ playlist_fetcher_t *playlist_fetcher_New( playlist_t *p_playlist )
 void playlist_fetcher_Push( playlist_fetcher_t *p_fetcher,
                             input_item_t *p_item )
 {
-    vlc_gc_incref( p_item );
-
     vlc_mutex_lock( &p_fetcher->lock );
+    /* The same item is often asked for again while being fetched */
+    for( int i = 0; i < p_fetcher->i_waiting; i++ )
+        if( p_fetcher->pp_waiting[i] == p_item )
+            goto out;
+    for( int i = 0; i < p_fetcher->running.i_size; i++ )
+        if( p_fetcher->running.p_elems[i] == p_item )
+            goto out;
+
+    vlc_gc_incref( p_item );
     INSERT_ELEM( p_fetcher->pp_waiting, p_fetcher->i_waiting,
                  p_fetcher->i_waiting, p_item );
-    if( !p_fetcher->b_live )
+
+    /* Threads exit when there is nothing left to do, so they are all busy */
+    if( p_fetcher->i_threads < FETCHER_THREADS )
     {
         if( vlc_clone_detach( NULL, Thread, p_fetcher,
                               VLC_THREAD_PRIORITY_LOW ) )
-            msg_Err( p_fetcher->p_playlist,
-                     "cannot spawn secondary preparse thread" );
+        {
+            if( p_fetcher->i_threads == 0 )
+                msg_Err( p_fetcher->p_playlist,
+                         "cannot spawn secondary preparse thread" );
+        }
         else
-            p_fetcher->b_live = true;
+            p_fetcher->i_threads++;
     }
+out:
     vlc_mutex_unlock( &p_fetcher->lock );
 }
 
@@ -111,10 +140,20 @@ void playlist_fetcher_Delete( playlist_fetcher_t *p_fetcher )
         REMOVE_ELEM( p_fetcher->pp_waiting, p_fetcher->i_waiting, 0 );
     }
 
-    while( p_fetcher->b_live )
+    while( p_fetcher->i_threads > 0 )
         vlc_cond_wait( &p_fetcher->wait, &p_fetcher->lock );
     vlc_mutex_unlock( &p_fetcher->lock );
 
+    FOREACH_ARRAY( playlist_album_t album, p_fetcher->albums )
+        free( album.psz_artist );
+        free( album.psz_album );
+        free( album.psz_arturl );
+    FOREACH_END();
+    ARRAY_RESET( p_fetcher->albums );
+    ARRAY_RESET( p_fetcher->running );
+    assert( p_fetcher->hosts.i_size == 0 );
+    ARRAY_RESET( p_fetcher->hosts );
+
     vlc_cond_destroy( &p_fetcher->wait );
     vlc_mutex_destroy( &p_fetcher->lock );
     free( p_fetcher );
@@ -124,6 +163,86 @@ void playlist_fetcher_Delete( playlist_fetcher_t *p_fetcher )
 /*****************************************************************************
  * Privates functions
  *****************************************************************************/
+/* Must be called with the lock held */
+static int FindAlbum( playlist_fetcher_t *p_fetcher, const char *psz_artist,
+                      const char *psz_album )
+{
+    for( int i = 0; i < p_fetcher->albums.i_size; i++ )
+    {
+        playlist_album_t *p_album = &p_fetcher->albums.p_elems[i];
+        if( !strcmp( p_album->psz_artist, psz_artist ) &&
+            !strcmp( p_album->psz_album, psz_album ) )
+            return i;
+    }
+    return -1;
+}
+
+/**
+ * Waits until fewer than FETCHER_PER_HOST downloads use the server of an URL.
+ * @return the host name to pass to ReleaseHost(), or NULL
+ */
+static char *AcquireHost( playlist_fetcher_t *p_fetcher, const char *psz_url )
+{
+    vlc_url_t url;
+    char *psz_host = NULL;
+
+    vlc_UrlParse( &url, psz_url, 0 );
+    if( url.psz_host && *url.psz_host )
+        psz_host = strdup( url.psz_host );
+    vlc_UrlClean( &url );
+    if( !psz_host )
+        return NULL;
+
+    vlc_mutex_lock( &p_fetcher->lock );
+    for( ;; )
+    {
+        int i;
+        for( i = 0; i < p_fetcher->hosts.i_size; i++ )
+            if( !strcmp( p_fetcher->hosts.p_elems[i].psz_host, psz_host ) )
+                break;
+
+        if( i == p_fetcher->hosts.i_size )
+        {
+            fetcher_host_t host = { .psz_host = strdup( psz_host ),
+                                    .i_count = 1 };
+            if( likely(host.psz_host != NULL) )
+                ARRAY_APPEND( p_fetcher->hosts, host );
+            break;
+        }
+        if( p_fetcher->hosts.p_elems[i].i_count < FETCHER_PER_HOST )
+        {
+            p_fetcher->hosts.p_elems[i].i_count++;
+            break;
+        }
+        vlc_cond_wait( &p_fetcher->wait, &p_fetcher->lock );
+    }
+    vlc_mutex_unlock( &p_fetcher->lock );
+    return psz_host;
+}
+
+static void ReleaseHost( playlist_fetcher_t *p_fetcher, char *psz_host )
+{
+    if( !psz_host )
+        return;
+
+    vlc_mutex_lock( &p_fetcher->lock );
+    for( int i = 0; i < p_fetcher->hosts.i_size; i++ )
+    {
+        fetcher_host_t *p_host = &p_fetcher->hosts.p_elems[i];
+        if( strcmp( p_host->psz_host, psz_host ) )
+            continue;
+        if( --p_host->i_count == 0 )
+        {
+            free( p_host->psz_host );
+            ARRAY_REMOVE( p_fetcher->hosts, i );
+        }
+        break;
+    }
+    vlc_cond_broadcast( &p_fetcher->wait );
+    vlc_mutex_unlock( &p_fetcher->lock );
+    free( psz_host );
+}
+
 /**
  * This function locates the art associated to an input item.
  * Return codes:
@@ -149,30 +268,55 @@ static int FindArt( playlist_fetcher_t *p_fetcher, input_item_t *p_item )
     /* If we already checked this album in this session, skip */
     if( psz_artist && psz_album )
     {
-        FOREACH_ARRAY( playlist_album_t album, p_fetcher->albums )
-            if( !strcmp( album.psz_artist, psz_artist ) &&
-                !strcmp( album.psz_album, psz_album ) )
+        vlc_mutex_lock( &p_fetcher->lock );
+        int i_album;
+        /* Another thread may be searching the same album: wait for it */
+        while( ( i_album = FindAlbum( p_fetcher, psz_artist, psz_album ) ) >= 0
+            && p_fetcher->albums.p_elems[i_album].b_pending )
+            vlc_cond_wait( &p_fetcher->wait, &p_fetcher->lock );
+
+        if( i_album >= 0 )
+        {
+            playlist_album_t *p_album = &p_fetcher->albums.p_elems[i_album];
+            char *psz_arturl = p_album->psz_arturl ?
+                               strdup( p_album->psz_arturl ) : NULL;
+            bool b_found = p_album->b_found;
+            vlc_mutex_unlock( &p_fetcher->lock );
+
+            msg_Dbg( p_fetcher->p_playlist,
+                     " %s - %s has already been searched",
+                     psz_artist, psz_album );
+            /* TODO-fenrir if we cache art filename too, we can go faster */
+            free( psz_artist );
+            free( psz_album );
+            if( b_found )
             {
-                msg_Dbg( p_fetcher->p_playlist,
-                         " %s - %s has already been searched",
-                         psz_artist, psz_album );
-                /* TODO-fenrir if we cache art filename too, we can go faster */
-                free( psz_artist );
-                free( psz_album );
-                if( album.b_found )
-                {
-                    if( !strncmp( album.psz_arturl, "file://", 7 ) )
-                        input_item_SetArtURL( p_item, album.psz_arturl );
-                    else /* Actually get URL from cache */
-                        playlist_FindArtInCache( p_item );
-                    return 0;
-                }
-                else
-                {
-                    return VLC_EGENERIC;
-                }
+                if( psz_arturl && !strncmp( psz_arturl, "file://", 7 ) )
+                    input_item_SetArtURL( p_item, psz_arturl );
+                else /* Actually get URL from cache */
+                    playlist_FindArtInCache( p_item );
+                free( psz_arturl );
+                return 0;
             }
-        FOREACH_END();
+            free( psz_arturl );
+            return VLC_EGENERIC;
+        }
+
+        /* Record this album, the other threads will wait for the result */
+        playlist_album_t a;
+        a.psz_artist = strdup( psz_artist );
+        a.psz_album = strdup( psz_album );
+        a.psz_arturl = NULL;
+        a.b_found = false;
+        a.b_pending = true;
+        if( likely(a.psz_artist && a.psz_album) )
+            ARRAY_APPEND( p_fetcher->albums, a );
+        else
+        {
+            free( a.psz_artist );
+            free( a.psz_album );
+        }
+        vlc_mutex_unlock( &p_fetcher->lock );
     }
     free( psz_artist );
     free( psz_album );
@@ -238,21 +382,23 @@ static int FindArt( playlist_fetcher_t *p_fetcher, input_item_t *p_item )
         vlc_object_release( p_finder );
     }
 
-    /* Record this album */
+    /* Record the result for this album */
     if( psz_artist && psz_album )
     {
-        playlist_album_t a;
-        a.psz_artist = psz_artist;
-        a.psz_album = psz_album;
-        a.psz_arturl = input_item_GetArtURL( p_item );
-        a.b_found = (i_ret == VLC_EGENERIC ? false : true );
-        ARRAY_APPEND( p_fetcher->albums, a );
-    }
-    else
-    {
-        free( psz_artist );
-        free( psz_album );
+        vlc_mutex_lock( &p_fetcher->lock );
+        int i_album = FindAlbum( p_fetcher, psz_artist, psz_album );
+        if( i_album >= 0 )
+        {
+            playlist_album_t *p_album = &p_fetcher->albums.p_elems[i_album];
+            p_album->psz_arturl = input_item_GetArtURL( p_item );
+            p_album->b_found = (i_ret == VLC_EGENERIC ? false : true );
+            p_album->b_pending = false;
+            vlc_cond_broadcast( &p_fetcher->wait );
+        }
+        vlc_mutex_unlock( &p_fetcher->lock );
     }
+    free( psz_artist );
+    free( psz_album );
 
     return i_ret;
 }
@@ -280,9 +426,13 @@ static int DownloadArt( playlist_fetcher_t *p_fetcher, input_item_t *p_item )
         goto error;
     }
 
+    char *psz_host = AcquireHost( p_fetcher, psz_arturl );
     stream_t *p_stream = stream_UrlNew( p_fetcher->p_playlist, psz_arturl );
     if( !p_stream )
+    {
+        ReleaseHost( p_fetcher, psz_host );
         goto error;
+    }
 
     uint8_t *p_data = NULL;
     int i_data = 0;
@@ -304,6 +454,7 @@ static int DownloadArt( playlist_fetcher_t *p_fetcher, input_item_t *p_item )
         i_data += i_read;
     }
     stream_Delete( p_stream );
+    ReleaseHost( p_fetcher, psz_host );
 
     if( p_data && i_data > 0 )
     {
@@ -405,24 +556,38 @@ static void *Thread( void *p_data )
 {
     playlist_fetcher_t *p_fetcher = p_data;
     playlist_t *p_playlist = p_fetcher->p_playlist;
+    input_item_t *p_item_done = NULL;
 
     for( ;; )
     {
         input_item_t *p_item = NULL;
 
         vlc_mutex_lock( &p_fetcher->lock );
+        if( p_item_done != NULL )
+        {
+            for( int i = 0; i < p_fetcher->running.i_size; i++ )
+                if( p_fetcher->running.p_elems[i] == p_item_done )
+                {
+                    ARRAY_REMOVE( p_fetcher->running, i );
+                    break;
+                }
+        }
         if( p_fetcher->i_waiting != 0 )
         {
             p_item = p_fetcher->pp_waiting[0];
             REMOVE_ELEM( p_fetcher->pp_waiting, p_fetcher->i_waiting, 0 );
+            ARRAY_APPEND( p_fetcher->running, p_item );
         }
         else
         {
-            p_fetcher->b_live = false;
-            vlc_cond_signal( &p_fetcher->wait );
+            p_fetcher->i_threads--;
+            vlc_cond_broadcast( &p_fetcher->wait );
         }
         vlc_mutex_unlock( &p_fetcher->lock );
 
+        if( p_item_done != NULL )
+            vlc_gc_decref( p_item_done );
+
         if( !p_item )
             break;
 
@@ -456,7 +621,8 @@ static void *Thread( void *p_data )
             input_item_SetArtNotFound( p_item, true );
         }
         free( psz_name );
-        vlc_gc_decref( p_item );
+        /* Released once it is no longer listed as running */
+        p_item_done = p_item;
     }
     return NULL;
 }
@@ -29,10 +29,14 @@
 #include <assert.h>
 #include <vlc_playlist.h>
 #include <vlc_rand.h>
+#include <vlc_memstats.h>
 #include "playlist_internal.h"
 
 static void AddItem( playlist_t *p_playlist, playlist_item_t *p_item,
                      playlist_item_t *p_node, int i_mode, int i_pos );
+static int AddItems( playlist_t *p_playlist, input_item_t *const *pp_inputs,
+                     int i_count, playlist_item_t *p_node, int i_mode,
+                     int i_pos );
 static void GoAndPreparse( playlist_t *p_playlist, int i_mode,
                            playlist_item_t * );
 static void ChangeToNode( playlist_t *p_playlist, playlist_item_t *p_item );
@@ -49,15 +53,64 @@ static int RecursiveInsertCopy (
  * An input item has gained subitems (Event Callback)
  *****************************************************************************/
 
+/* Add a batch of sub-items after the ones of the previous batch */
+static void AddSubItemBatch( playlist_t *p_playlist, int i_batch,
+                             input_item_node_t *p_root, bool b_partial )
+{
+    playlist_private_t *p_sys = pl_priv(p_playlist);
+    playlist_batch_t *p_batch = &p_sys->batches.p_elems[i_batch];
+    playlist_item_t *p_node =
+        playlist_ItemGetById( p_playlist, p_batch->i_node_id );
+
+    if( p_node != NULL && p_node->i_children >= 0 )
+    {
+        int pos = __MIN( p_batch->i_pos, p_node->i_children );
+
+        /* Items may have been moved or deleted meanwhile */
+        if( pos == 0 || p_node->pp_children[pos - 1]->i_id != p_batch->i_last_id )
+            for( int i = 0; i < p_node->i_children; i++ )
+                if( p_node->pp_children[i]->i_id == p_batch->i_last_id )
+                {
+                    pos = i + 1;
+                    break;
+                }
+
+        int last_pos = playlist_InsertInputItemTree( p_playlist, p_node,
+                                                     p_root, pos,
+                                                     p_batch->b_flat );
+        if( last_pos > pos )
+        {
+            p_batch->i_last_id = p_node->pp_children[last_pos - 1]->i_id;
+            p_batch->i_pos = last_pos;
+        }
+    }
+
+    if( !b_partial )
+    {
+        vlc_gc_decref( p_batch->p_input );
+        ARRAY_REMOVE( p_sys->batches, i_batch );
+    }
+}
+
 static void input_item_add_subitem_tree ( const vlc_event_t * p_event,
                                           void * user_data )
 {
     input_item_t *p_input = p_event->p_obj;
     playlist_t *p_playlist = (( playlist_item_t* ) user_data)->p_playlist;
     input_item_node_t *p_new_root = p_event->u.input_item_subitem_tree_added.p_root;
+    bool b_partial = p_event->u.input_item_subitem_tree_added.b_partial;
 
     PL_LOCK;
 
+    /* Following batches only add items, playback was handled by the first */
+    for( int i = 0; i < pl_priv(p_playlist)->batches.i_size; i++ )
+        if( pl_priv(p_playlist)->batches.p_elems[i].p_input == p_input )
+        {
+            AddSubItemBatch( p_playlist, i, p_new_root, b_partial );
+            PL_UNLOCK;
+            return;
+        }
+
     playlist_item_t *p_item =
         playlist_ItemGetByInput( p_playlist, p_input );
 
@@ -126,7 +179,26 @@ static void input_item_add_subitem_tree ( const vlc_event_t * p_event,
                                                  pos,
                                                  b_flat );
 
-    if( !b_flat ) var_SetInteger( p_playlist, "leaf-to-parent", p_item->i_id );
+    if( !b_flat )
+    {
+        playlist_RecordChange( p_playlist, PLAYLIST_CHANGE_REORDERED,
+                               p_item->i_id, -1, 0 );
+        var_SetInteger( p_playlist, "leaf-to-parent", p_item->i_id );
+    }
+
+    if( b_partial )
+    {
+        playlist_batch_t batch = {
+            .p_input = p_input,
+            .i_node_id = p_item->i_id,
+            .i_last_id = last_pos > pos ? p_item->pp_children[last_pos - 1]->i_id
+                                        : -1,
+            .i_pos = last_pos,
+            .b_flat = b_flat,
+        };
+        vlc_gc_incref( p_input );
+        ARRAY_APPEND( pl_priv(p_playlist)->batches, batch );
+    }
 
     //control playback only if it was the current playing item that got subitems
     if( b_current )
@@ -179,7 +251,13 @@ static void input_item_changed( const vlc_event_t * p_event,
                                 void * user_data )
 {
     playlist_item_t *p_item = user_data;
-    VLC_UNUSED( p_event );
+    playlist_search_t *p_search = pl_priv(p_item->p_playlist)->p_search;
+
+    if( p_search && ( p_event->type == vlc_InputItemMetaChanged ||
+                      p_event->type == vlc_InputItemNameChanged ) )
+        playlist_search_Update( p_search, p_item );
+    playlist_RecordChange( p_item->p_playlist, PLAYLIST_CHANGE_UPDATED,
+                           p_item->i_id, -1, 0 );
     var_SetAddress( p_item->p_playlist, "item-change", p_item->p_input );
 }
 
@@ -220,13 +298,161 @@ static void uninstall_input_item_observer( playlist_item_t * p_item )
                       input_item_changed, p_item );
 }
 
+/*****************************************************************************
+ * Map of the playlist items by input item
+ *****************************************************************************
+ * Every item of all_items is chained in the bucket of its input item. Chains
+ * keep the order of all_items, that is of the ids, so that the first item of
+ * an input is found first, as with a scan of all_items.
+ *****************************************************************************/
+struct playlist_input_entry_t
+{
+    playlist_input_entry_t *p_next;
+    playlist_item_t        *p_item;
+};
+
+static size_t ItemMapHash( input_item_t *p_input, size_t i_buckets )
+{
+    uint64_t h = (uintptr_t)p_input * UINT64_C(0x9E3779B97F4A7C15);
+    return (h >> 32) & (i_buckets - 1);
+}
+
+static void ItemMapAppend( playlist_input_entry_t **pp_buckets,
+                           size_t i_buckets, playlist_input_entry_t *p_entry )
+{
+    playlist_input_entry_t **pp =
+        &pp_buckets[ItemMapHash( p_entry->p_item->p_input, i_buckets )];
+
+    while( *pp != NULL )
+        pp = &(*pp)->p_next;
+    p_entry->p_next = NULL;
+    *pp = p_entry;
+}
+
+void playlist_ItemMapAdd( playlist_t *p_playlist, playlist_item_t *p_item )
+{
+    playlist_private_t *p_sys = pl_priv(p_playlist);
+    PL_ASSERT_LOCKED;
+
+    /* Keep the chains short */
+    if( p_sys->input_map.i_count >= p_sys->input_map.i_buckets )
+    {
+        size_t i_buckets = p_sys->input_map.i_buckets
+                         ? 2 * p_sys->input_map.i_buckets : 256;
+        playlist_input_entry_t **pp_buckets =
+            calloc( i_buckets, sizeof( *pp_buckets ) );
+
+        if( pp_buckets != NULL )
+        {
+            for( size_t i = 0; i < p_sys->input_map.i_buckets; i++ )
+            {
+                playlist_input_entry_t *p_entry =
+                    p_sys->input_map.pp_buckets[i];
+                while( p_entry != NULL )
+                {
+                    playlist_input_entry_t *p_next = p_entry->p_next;
+                    ItemMapAppend( pp_buckets, i_buckets, p_entry );
+                    p_entry = p_next;
+                }
+            }
+            free( p_sys->input_map.pp_buckets );
+            p_sys->input_map.pp_buckets = pp_buckets;
+            p_sys->input_map.i_buckets = i_buckets;
+        }
+    }
+
+    playlist_input_entry_t *p_entry = malloc( sizeof( *p_entry ) );
+    if( unlikely(p_entry == NULL || p_sys->input_map.i_buckets == 0) )
+    {
+        free( p_entry );
+        p_sys->input_map.b_failed = true;
+        return;
+    }
+    p_entry->p_item = p_item;
+    ItemMapAppend( p_sys->input_map.pp_buckets, p_sys->input_map.i_buckets,
+                   p_entry );
+    p_sys->input_map.i_count++;
+}
+
+void playlist_ItemMapRemove( playlist_t *p_playlist, playlist_item_t *p_item )
+{
+    playlist_private_t *p_sys = pl_priv(p_playlist);
+    PL_ASSERT_LOCKED;
+
+    if( p_sys->input_map.i_buckets == 0 )
+        return;
+
+    playlist_input_entry_t **pp = &p_sys->input_map.pp_buckets[
+        ItemMapHash( p_item->p_input, p_sys->input_map.i_buckets )];
+    for( ; *pp != NULL; pp = &(*pp)->p_next )
+    {
+        if( (*pp)->p_item == p_item )
+        {
+            playlist_input_entry_t *p_entry = *pp;
+            *pp = p_entry->p_next;
+            free( p_entry );
+            p_sys->input_map.i_count--;
+            return;
+        }
+    }
+}
+
+/**
+ * Finds the first item of all_items with the given input item.
+ */
+playlist_item_t *playlist_ItemMapFind( playlist_t *p_playlist,
+                                       input_item_t *p_input )
+{
+    playlist_private_t *p_sys = pl_priv(p_playlist);
+    PL_ASSERT_LOCKED;
+
+    if( unlikely(p_sys->input_map.b_failed) )
+    {   /* Out of memory at some point: the map may be incomplete */
+        FOREACH_ARRAY( playlist_item_t *p_item, p_playlist->all_items )
+            if( p_item->p_input == p_input )
+                return p_item;
+        FOREACH_END();
+        return NULL;
+    }
+    if( p_sys->input_map.i_buckets == 0 )
+        return NULL;
+
+    playlist_input_entry_t *p_entry = p_sys->input_map.pp_buckets[
+        ItemMapHash( p_input, p_sys->input_map.i_buckets )];
+    for( ; p_entry != NULL; p_entry = p_entry->p_next )
+        if( p_entry->p_item->p_input == p_input )
+            return p_entry->p_item;
+    return NULL;
+}
+
+void playlist_ItemMapClean( playlist_t *p_playlist )
+{
+    playlist_private_t *p_sys = pl_priv(p_playlist);
+
+    for( size_t i = 0; i < p_sys->input_map.i_buckets; i++ )
+    {
+        playlist_input_entry_t *p_entry = p_sys->input_map.pp_buckets[i];
+        while( p_entry != NULL )
+        {
+            playlist_input_entry_t *p_next = p_entry->p_next;
+            free( p_entry );
+            p_entry = p_next;
+        }
+    }
+    free( p_sys->input_map.pp_buckets );
+    p_sys->input_map.pp_buckets = NULL;
+    p_sys->input_map.i_buckets = 0;
+    p_sys->input_map.i_count = 0;
+}
+
 /*****************************************************************************
  * Playlist item creation
  *****************************************************************************/
 playlist_item_t *playlist_ItemNewFromInput( playlist_t *p_playlist,
                                               input_item_t *p_input )
 {
-    playlist_item_t* p_item = malloc( sizeof( playlist_item_t ) );
+    playlist_item_t* p_item = vlc_malloc_tagged( VLC_MEM_PLAYLIST,
+                                                 sizeof( playlist_item_t ) );
     if( !p_item )
         return NULL;
 
@@ -243,6 +469,8 @@ playlist_item_t *playlist_ItemNewFromInput( playlist_t *p_playlist,
     p_item->i_flags = 0;
     p_item->p_playlist = p_playlist;
 
+    if( pl_priv(p_playlist)->p_search )
+        playlist_search_Update( pl_priv(p_playlist)->p_search, p_item );
     install_input_item_observer( p_item );
 
     return p_item;
@@ -272,6 +500,8 @@ int playlist_ItemRelease( playlist_item_t *p_item )
      *
      * Who wants to add proper memory management? */
     uninstall_input_item_observer( p_item );
+    if( pl_priv(p_playlist)->p_search )
+        playlist_search_Remove( pl_priv(p_playlist)->p_search, p_item );
     ARRAY_APPEND( pl_priv(p_playlist)->items_to_delete, p_item);
     return VLC_SUCCESS;
 }
@@ -508,6 +738,41 @@ playlist_item_t * playlist_NodeAddInput( playlist_t *p_playlist,
     return p_item;
 }
 
+/**
+ * Add several input items to a given node
+ *
+ * The items are linked in one go and a single "playlist-items-append"
+ * event is sent for all of them.
+ *
+ * \param p_playlist the playlist to add into
+ * \param pp_inputs the input items to add, in order
+ * \param i_inputs the number of input items
+ * \param p_parent the parent item to add into
+ * \param i_mode the mode used when adding
+ * \param i_pos the position in the parent where to add the first item. If
+ *        this is PLAYLIST_END the items are added after all the children
+ * \param b_locked TRUE if the playlist is locked
+ * \return VLC_SUCCESS, VLC_ENOMEM if only some items were added, or
+ *         VLC_EGENERIC
+ */
+int playlist_NodeAddInputs( playlist_t *p_playlist,
+                            input_item_t *const *pp_inputs, int i_inputs,
+                            playlist_item_t *p_parent, int i_mode, int i_pos,
+                            bool b_locked )
+{
+    assert( p_parent && p_parent->i_children != -1 );
+
+    if( p_playlist->b_die )
+        return VLC_EGENERIC;
+    PL_LOCK_IF( !b_locked );
+
+    int i_added = AddItems( p_playlist, pp_inputs, i_inputs, p_parent,
+                            i_mode, i_pos );
+
+    PL_UNLOCK_IF( !b_locked );
+    return i_added == i_inputs ? VLC_SUCCESS : VLC_ENOMEM;
+}
+
 /**
  * Copy an item (and all its children, if any) into another node
  *
@@ -644,6 +909,11 @@ int playlist_TreeMove( playlist_t * p_playlist, playlist_item_t *p_item,
     INSERT_ELEM( p_node->pp_children, p_node->i_children, i_newpos, p_item );
     p_item->p_parent = p_node;
 
+    if( p_detach != p_node )
+        playlist_RecordChange( p_playlist, PLAYLIST_CHANGE_REORDERED,
+                               p_detach->i_id, -1, 0 );
+    playlist_RecordChange( p_playlist, PLAYLIST_CHANGE_REORDERED,
+                           p_node->i_id, -1, 0 );
     pl_priv( p_playlist )->b_reset_currently_playing = true;
     vlc_cond_signal( &pl_priv( p_playlist )->signal );
     return VLC_SUCCESS;
@@ -677,6 +947,10 @@ int playlist_TreeMoveMany( playlist_t *p_playlist,
         playlist_item_t *p_parent = p_item->p_parent;
         REMOVE_ELEM( p_parent->pp_children, p_parent->i_children, i_index );
         if ( p_parent == p_node && i_index < i_newpos ) i_newpos--;
+        if( p_parent != p_node
+         && ( i == 0 || p_parent != pp_items[i - 1]->p_parent ) )
+            playlist_RecordChange( p_playlist, PLAYLIST_CHANGE_REORDERED,
+                                   p_parent->i_id, -1, 0 );
     }
     for( i = i_items - 1; i >= 0; i-- )
     {
@@ -684,6 +958,8 @@ int playlist_TreeMoveMany( playlist_t *p_playlist,
         INSERT_ELEM( p_node->pp_children, p_node->i_children, i_newpos, p_item );
         p_item->p_parent = p_node;
     }
+    playlist_RecordChange( p_playlist, PLAYLIST_CHANGE_REORDERED,
+                           p_node->i_id, -1, 0 );
 
     pl_priv( p_playlist )->b_reset_currently_playing = true;
     vlc_cond_signal( &pl_priv( p_playlist )->signal );
@@ -709,6 +985,9 @@ void playlist_SendAddNotify( playlist_t *p_playlist, int i_item_id,
     if( b_signal )
         vlc_cond_signal( &p_sys->signal );
 
+    playlist_RecordChange( p_playlist, PLAYLIST_CHANGE_ADDED,
+                           i_item_id, i_node_id, 1 );
+
     playlist_add_t add;
     add.i_item = i_item_id;
     add.i_node = i_node_id;
@@ -716,6 +995,41 @@ void playlist_SendAddNotify( playlist_t *p_playlist, int i_item_id,
     var_SetAddress( p_playlist, "playlist-item-append", &add );
 }
 
+/**
+ * Send a notification that consecutive items have been added to a node
+ *
+ * \param p_playlist the playlist object
+ * \param i_item_id id of the first item added, the others follow
+ * \param i_count number of items added
+ * \param i_node_id id of the node in wich the items were added
+ * \param i_pos index of the first item in the children of the node
+ * \param b_signal TRUE if the function must send a signal
+ * \return nothing
+ */
+void playlist_SendAddRangeNotify( playlist_t *p_playlist, int i_item_id,
+                                  int i_count, int i_node_id, int i_pos,
+                                  bool b_signal )
+{
+    playlist_private_t *p_sys = pl_priv(p_playlist);
+    PL_ASSERT_LOCKED;
+
+    p_sys->b_reset_currently_playing = true;
+    if( b_signal )
+        vlc_cond_signal( &p_sys->signal );
+
+    /* The ids of items added together follow, see AddItems() */
+    playlist_RecordChange( p_playlist, PLAYLIST_CHANGE_ADDED,
+                           i_item_id, i_node_id, i_count );
+
+    playlist_add_range_t add;
+    add.i_node = i_node_id;
+    add.i_item = i_item_id;
+    add.i_count = i_count;
+    add.i_pos = i_pos;
+
+    var_SetAddress( p_playlist, "playlist-items-append", &add );
+}
+
 /***************************************************************************
  * The following functions are local
  ***************************************************************************/
@@ -756,6 +1070,7 @@ static void AddItem( playlist_t *p_playlist, playlist_item_t *p_item,
     PL_ASSERT_LOCKED;
     ARRAY_APPEND(p_playlist->items, p_item);
     ARRAY_APPEND(p_playlist->all_items, p_item);
+    playlist_ItemMapAdd( p_playlist, p_item );
 
     if( i_pos == PLAYLIST_END )
         playlist_NodeAppend( p_playlist, p_item, p_node );
@@ -767,6 +1082,71 @@ static void AddItem( playlist_t *p_playlist, playlist_item_t *p_item,
                                  !( i_mode & PLAYLIST_NO_REBUILD ) );
 }
 
+/* Add input items to the requested node and fire a single notification.
+ * Returns the number of items added. */
+static int AddItems( playlist_t *p_playlist, input_item_t *const *pp_inputs,
+                     int i_count, playlist_item_t *p_node, int i_mode,
+                     int i_pos )
+{
+    PL_ASSERT_LOCKED;
+    assert( p_node->i_children != -1 );
+
+    if( i_pos == PLAYLIST_END )
+        i_pos = p_node->i_children;
+    assert( i_pos >= 0 && i_pos <= p_node->i_children );
+    if( i_count <= 0 )
+        return 0;
+
+    /* Make room for all the items at once */
+    playlist_item_t **pp_children = p_node->i_children ? p_node->pp_children
+                                                       : NULL;
+    pp_children = realloc( pp_children, (p_node->i_children + i_count)
+                                        * sizeof( *pp_children ) );
+    if( unlikely(pp_children == NULL) )
+        return 0;
+    p_node->pp_children = pp_children;
+    memmove( pp_children + i_pos + i_count, pp_children + i_pos,
+             (p_node->i_children - i_pos) * sizeof( *pp_children ) );
+
+    ARRAY_RESERVE( p_playlist->items, i_count );
+    ARRAY_RESERVE( p_playlist->all_items, i_count );
+
+    int i_added = 0;
+    for( ; i_added < i_count; i_added++ )
+    {
+        playlist_item_t *p_item =
+            playlist_ItemNewFromInput( p_playlist, pp_inputs[i_added] );
+        if( unlikely(p_item == NULL) )
+            break;
+
+        ARRAY_APPEND( p_playlist->items, p_item );
+        ARRAY_APPEND( p_playlist->all_items, p_item );
+        playlist_ItemMapAdd( p_playlist, p_item );
+        p_item->p_parent = p_node;
+        pp_children[i_pos + i_added] = p_item;
+    }
+
+    if( i_added < i_count ) /* close the gap left by the missing items */
+        memmove( pp_children + i_pos + i_added,
+                 pp_children + i_pos + i_count,
+                 (p_node->i_children - i_pos) * sizeof( *pp_children ) );
+    p_node->i_children += i_added;
+    if( i_added == 0 )
+        return 0;
+
+    if( !pl_priv(p_playlist)->b_doing_ml )
+        playlist_SendAddRangeNotify( p_playlist, pp_children[i_pos]->i_id,
+                                     i_added, p_node->i_id, i_pos,
+                                     !( i_mode & PLAYLIST_NO_REBUILD ) );
+
+    /* Play the first item only */
+    GoAndPreparse( p_playlist, i_mode, pp_children[i_pos] );
+    for( int i = 1; i < i_added; i++ )
+        GoAndPreparse( p_playlist, i_mode & ~PLAYLIST_GO,
+                       pp_children[i_pos + i] );
+    return i_added;
+}
+
 /* Actually convert an item to a node */
 static void ChangeToNode( playlist_t *p_playlist, playlist_item_t *p_item )
 {
@@ -780,6 +1160,8 @@ static void ChangeToNode( playlist_t *p_playlist, playlist_item_t *p_item )
     p_input->i_type = ITEM_TYPE_NODE;
     vlc_mutex_unlock( &p_input->lock );
 
+    playlist_RecordChange( p_playlist, PLAYLIST_CHANGE_UPDATED,
+                           p_item->i_id, -1, 0 );
     var_SetAddress( p_playlist, "item-change", p_item->p_input );
 
     /* Remove it from the array of available items */
@@ -814,6 +1196,32 @@ static int RecursiveAddIntoParent (
         playlist_item_t *p_new_item = NULL;
         bool b_children = p_child_node->i_children > 0;
 
+        //Add consecutive leaves all at once
+        if( !b_children )
+        {
+            int i_leaves = 1;
+            while( i + i_leaves < p_node->i_children &&
+                   p_node->pp_children[i + i_leaves]->i_children == 0 )
+                i_leaves++;
+
+            input_item_t **pp_inputs = malloc( i_leaves * sizeof(*pp_inputs) );
+            if( !pp_inputs ) return i_pos;
+            for( int j = 0; j < i_leaves; j++ )
+                pp_inputs[j] = p_node->pp_children[i + j]->p_item;
+
+            int i_added = AddItems( p_playlist, pp_inputs, i_leaves,
+                                    p_parent, PLAYLIST_INSERT, i_pos );
+            free( pp_inputs );
+            if( i_added == 0 ) return i_pos;
+
+            if( i == 0 ) *pp_first_leaf = p_parent->pp_children[i_pos];
+            i_pos += i_added;
+            if( i_added < i_leaves ) return i_pos;
+
+            i += i_leaves - 1;
+            continue;
+        }
+
         //Create the playlist item represented by input node, if allowed.
         if( !(b_flat && b_children) )
         {
@@ -110,8 +110,11 @@ static void input_item_subitem_tree_added( const vlc_event_t * p_event,
         p_event->u.input_item_subitem_tree_added.p_root;
 
     PL_LOCK;
+    /* The tree may come in several batches */
     playlist_InsertInputItemTree ( p_playlist, p_playlist->p_media_library,
-                                   p_root, 0, false );
+                                   p_root,
+                                   p_playlist->p_media_library->i_children,
+                                   false );
     PL_UNLOCK;
 }
 
@@ -173,6 +176,9 @@ int playlist_MLLoad( playlist_t *p_playlist )
 
     PL_LOCK;
     pl_priv(p_playlist)->b_doing_ml = false;
+    /* Items were added silently */
+    playlist_RecordChange( p_playlist, PLAYLIST_CHANGE_REORDERED,
+                           p_playlist->p_media_library->i_id, -1, 0 );
     PL_UNLOCK;
 
     vlc_event_detach( &p_input->event_manager, vlc_InputItemSubItemTreeAdded,
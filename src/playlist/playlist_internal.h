@@ -42,17 +42,51 @@
 #include "fetcher.h"
 #include "preparser.h"
 
+#define PLAYLIST_CHANGES_MAX 256
+
 typedef struct vlc_sd_internal_t vlc_sd_internal_t;
+typedef struct playlist_search_t playlist_search_t;
+typedef struct playlist_input_entry_t playlist_input_entry_t;
+
+/* Sub-items of an input still coming, see input_item_node_PostBatch() */
+typedef struct
+{
+    input_item_t *p_input;
+    int     i_node_id;  /**< node receiving the sub-items */
+    int     i_last_id;  /**< last sub-item added, the next ones go after it */
+    int     i_pos;      /**< position after it, when it was added */
+    bool    b_flat;
+} playlist_batch_t;
 
 typedef struct playlist_private_t
 {
     playlist_t           public_data;
     playlist_preparser_t *p_preparser;  /**< Preparser data */
     playlist_fetcher_t   *p_fetcher;    /**< Meta and art fetcher data */
+    playlist_search_t    *p_search;     /**< Live search index */
 
     playlist_item_array_t items_to_delete; /**< Array of items and nodes to
             delete... At the very end. This sucks. */
 
+    struct {
+        playlist_input_entry_t **pp_buckets; /**< all_items by input item */
+        size_t  i_buckets;  /**< power of 2 */
+        size_t  i_count;
+        bool    b_failed;   /**< an item could not be added */
+    } input_map;
+
+    DECL_ARRAY(playlist_batch_t) batches; /**< Sub-items still coming */
+
+    /* Last changes of the tree, see playlist_GetChanges(). Items may change
+     * without the playlist lock (input item events), hence a lock of its own */
+    struct {
+        vlc_mutex_t lock;
+        vlc_cond_t  wait;
+        uint64_t    i_first;    /**< revision before the first change */
+        uint64_t    i_revision; /**< revision after the last change */
+        playlist_change_t ring[PLAYLIST_CHANGES_MAX]; /**< by revision */
+    } changes;
+
     vlc_sd_internal_t   **pp_sds;
     int                   i_sds;   /**< Number of service discovery modules */
     input_thread_t *      p_input;  /**< the input thread associated
@@ -95,6 +129,7 @@ typedef struct playlist_private_t
     SynConnection syn_connection;
     bool     b_syn_can_send;
     bool     b_syn_created;
+    bool     b_syn_host;   /**< we host the viewing, our media may stream */
     bool     b_need_send_seek;
     char*    psz_syn_server_host;
     char*    psz_syn_user;
@@ -106,6 +141,49 @@ typedef struct playlist_private_t
     mtime_t  t_last_correction_time;
 
     mtime_t  last_diff_diff;
+
+    /* Small offsets are played away rather than seeked, see
+     * playlist_SynCorrect() */
+    vlc_timer_t syn_slew_timer;
+    bool     b_syn_slew_timer;   /**< syn_slew_timer was created */
+    bool     b_syn_slewing;
+    float    f_syn_slew_base_rate; /**< rate to go back to */
+
+    /* Corrections of this session, for the statistics */
+    int64_t  i_syn_seeks;
+    int64_t  i_syn_slews;
+
+    /* Coordinated start, see playlist_SynStartState() */
+    vlc_mutex_t syn_start_lock;
+    int      i_syn_start;          /**< SYN_START_*, under syn_start_lock */
+    mtime_t  i_syn_start_time;     /**< media time the start is prepared at */
+    bool     b_syn_start_emptied;  /**< buffering restarted at it */
+    bool     b_syn_start_buffered; /**< and is done */
+    bool     b_syn_start_peer_ready;
+    bool     b_syn_start_pause;    /**< the timer pauses the initiator */
+    vlc_timer_t syn_start_timer;
+    bool     b_syn_start_timer;    /**< syn_start_timer was created */
+
+    /* Seek storms cost one seek at their end: ours go out once the
+     * position stood still for SYN_SEEK_COALESCE, and the peer's that
+     * follow one another closer than that are coalesced */
+    mtime_t  i_syn_seek_changed;   /**< our position last changed then */
+    vlc_mutex_t syn_seek_lock;
+    vlc_timer_t syn_seek_timer;
+    bool     b_syn_seek_timer;     /**< syn_seek_timer was created */
+    bool     b_syn_seek_pending;   /**< under syn_seek_lock, as the rest */
+    mtime_t  i_syn_seek_time;      /**< the latest seek of the peer */
+    mtime_t  i_syn_seek_sent;      /**< our date when it was sent */
+    mtime_t  i_syn_seek_window;    /**< seeks are coalesced until then */
+
+    /* The session lives across items, peers follow one another's item
+     * by content key, see playlist_SynItemChanged() */
+    uint64_t i_syn_item_key;       /**< of our item, under PL_LOCK */
+    uint64_t i_syn_peer_key;       /**< of the peer's, 0 until told */
+    bool     b_syn_item_follow;    /**< under syn_start_lock: we went to
+                                        the peer's item, its start is theirs */
+    bool     b_syn_item_prepare;   /**< the peer prepared it before that */
+    mtime_t  i_syn_item_prepare_time;
 } playlist_private_t;
 
 #define pl_priv( pl ) ((playlist_private_t *)(pl))
@@ -141,6 +219,7 @@ int playlist_MLDump( playlist_t *p_playlist );
  * Item management
  **********************************************************************/
 
+void playlist_SendAddRangeNotify( playlist_t *, int, int, int, int, bool );
 void playlist_SendAddNotify( playlist_t *p_playlist, int i_item_id,
                              int i_node_id, bool b_signal );
 
@@ -150,6 +229,24 @@ playlist_item_t * playlist_NodeAddInput( playlist_t *, input_item_t *,
 int playlist_InsertInputItemTree ( playlist_t *,
         playlist_item_t *, input_item_node_t *, int, bool );
 
+/* all_items by input item */
+void playlist_ItemMapAdd( playlist_t *, playlist_item_t * );
+void playlist_ItemMapRemove( playlist_t *, playlist_item_t * );
+playlist_item_t *playlist_ItemMapFind( playlist_t *, input_item_t * );
+void playlist_ItemMapClean( playlist_t * );
+
+/* Change log */
+void playlist_ChangesInit( playlist_t * );
+void playlist_ChangesClean( playlist_t * );
+void playlist_RecordChange( playlist_t *, int i_type, int i_id, int i_node,
+                            int i_count );
+
+/* Live search index */
+playlist_search_t *playlist_search_New( void );
+void playlist_search_Delete( playlist_search_t * );
+void playlist_search_Update( playlist_search_t *, playlist_item_t * );
+void playlist_search_Remove( playlist_search_t *, playlist_item_t * );
+
 /* Tree walking */
 playlist_item_t *playlist_ItemFindFromInputAndRoot( playlist_t *p_playlist,
                                 input_item_t *p_input, playlist_item_t *p_root,
@@ -166,6 +263,21 @@ int playlist_DeleteItem( playlist_t * p_playlist, playlist_item_t *, bool);
 void ResetCurrentlyPlaying( playlist_t *p_playlist, playlist_item_t *p_cur );
 void ResyncCurrentIndex( playlist_t *p_playlist, playlist_item_t *p_cur );
 
+/* Synchronicity */
+void playlist_SynCorrect( playlist_t *, input_thread_t *, mtime_t, mtime_t );
+void playlist_SynSlewStop( playlist_t *, input_thread_t * );
+void playlist_SynComputeStats( playlist_t *, input_stats_t * );
+bool playlist_SynStartState( playlist_t *, input_thread_t *, int );
+void playlist_SynStartBuffering( playlist_t *, input_thread_t * );
+bool playlist_SynStartBusy( playlist_t * );
+void playlist_SynStartCancel( playlist_t * );
+void playlist_SynSeekCancel( playlist_t * );
+uint64_t playlist_SynItemKey( input_item_t * );
+void playlist_SynItemChanged( playlist_t * );
+bool playlist_SynKeepsSession( playlist_t * );
+
+#define SYN_SEEK_COALESCE 250000
+
 /**
  * @}
  */
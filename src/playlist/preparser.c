@@ -25,8 +25,12 @@
 # include "config.h"
 #endif
 
+#include <sys/stat.h>
+
 #include <vlc_common.h>
 #include <vlc_playlist.h>
+#include <vlc_fs.h>
+#include <vlc_url.h>
 
 #include "art.h"
 #include "fetcher.h"
@@ -37,6 +41,14 @@
 /*****************************************************************************
  * Structures/definitions
  *****************************************************************************/
+typedef struct preparser_entry_t preparser_entry_t;
+
+struct preparser_entry_t
+{
+    preparser_entry_t *p_next;
+    input_item_t      *p_item;
+};
+
 struct playlist_preparser_t
 {
     playlist_t          *p_playlist;
@@ -44,9 +56,10 @@ struct playlist_preparser_t
 
     vlc_mutex_t     lock;
     vlc_cond_t      wait;
-    bool            b_live;
-    input_item_t  **pp_waiting;
-    int             i_waiting;
+    unsigned        i_live;     /* running worker threads */
+    unsigned        i_threads;  /* maximum worker threads */
+    preparser_entry_t  *p_waiting;  /* FIFO of the items to preparse */
+    preparser_entry_t **pp_last;
 
     int             i_art_policy;
 };
@@ -66,29 +79,42 @@ playlist_preparser_t *playlist_preparser_New( playlist_t *p_playlist, playlist_f
     p_preparser->p_fetcher = p_fetcher;
     vlc_mutex_init( &p_preparser->lock );
     vlc_cond_init( &p_preparser->wait );
-    p_preparser->b_live = false;
+    p_preparser->i_live = 0;
+    p_preparser->i_threads = var_InheritInteger( p_playlist,
+                                                 "preparse-threads" );
+    if( p_preparser->i_threads < 1 )
+        p_preparser->i_threads = 1;
     p_preparser->i_art_policy = var_GetInteger( p_playlist, "album-art" );
-    p_preparser->i_waiting = 0;
-    p_preparser->pp_waiting = NULL;
+    p_preparser->p_waiting = NULL;
+    p_preparser->pp_last = &p_preparser->p_waiting;
 
     return p_preparser;
 }
 
 void playlist_preparser_Push( playlist_preparser_t *p_preparser, input_item_t *p_item )
 {
+    preparser_entry_t *p_entry = malloc( sizeof(*p_entry) );
+    if( unlikely(p_entry == NULL) )
+        return;
+
+    p_entry->p_next = NULL;
+    p_entry->p_item = p_item;
     vlc_gc_incref( p_item );
 
     vlc_mutex_lock( &p_preparser->lock );
-    INSERT_ELEM( p_preparser->pp_waiting, p_preparser->i_waiting,
-                 p_preparser->i_waiting, p_item );
-    if( !p_preparser->b_live )
+    *p_preparser->pp_last = p_entry;
+    p_preparser->pp_last = &p_entry->p_next;
+    if( p_preparser->i_live < p_preparser->i_threads )
     {
         if( vlc_clone_detach( NULL, Thread, p_preparser,
                               VLC_THREAD_PRIORITY_LOW ) )
-            msg_Warn( p_preparser->p_playlist,
-                      "cannot spawn pre-parser thread" );
+        {
+            if( p_preparser->i_live == 0 )
+                msg_Warn( p_preparser->p_playlist,
+                          "cannot spawn pre-parser thread" );
+        }
         else
-            p_preparser->b_live = true;
+            p_preparser->i_live++;
     }
     vlc_mutex_unlock( &p_preparser->lock );
 }
@@ -97,13 +123,17 @@ void playlist_preparser_Delete( playlist_preparser_t *p_preparser )
 {
     vlc_mutex_lock( &p_preparser->lock );
     /* Remove pending item to speed up preparser thread exit */
-    while( p_preparser->i_waiting > 0 )
+    while( p_preparser->p_waiting != NULL )
     {
-        vlc_gc_decref( p_preparser->pp_waiting[0] );
-        REMOVE_ELEM( p_preparser->pp_waiting, p_preparser->i_waiting, 0 );
+        preparser_entry_t *p_entry = p_preparser->p_waiting;
+
+        p_preparser->p_waiting = p_entry->p_next;
+        vlc_gc_decref( p_entry->p_item );
+        free( p_entry );
     }
+    p_preparser->pp_last = &p_preparser->p_waiting;
 
-    while( p_preparser->b_live )
+    while( p_preparser->i_live > 0 )
         vlc_cond_wait( &p_preparser->wait, &p_preparser->lock );
     vlc_mutex_unlock( &p_preparser->lock );
 
@@ -116,6 +146,23 @@ void playlist_preparser_Delete( playlist_preparser_t *p_preparser )
 /*****************************************************************************
  * Privates functions
  *****************************************************************************/
+/**
+ * Returns the modification date of a local file item, or 0 if unknown.
+ */
+static int64_t GetFileDate( input_item_t *p_item )
+{
+    char *psz_uri = input_item_GetURI( p_item );
+    char *psz_path = psz_uri ? make_path( psz_uri ) : NULL;
+    struct stat st;
+    int64_t i_mtime = 0;
+
+    free( psz_uri );
+    if( psz_path != NULL && !vlc_stat( psz_path, &st ) )
+        i_mtime = st.st_mtime;
+    free( psz_path );
+    return i_mtime;
+}
+
 /**
  * This function preparses an item when needed.
  */
@@ -133,8 +180,17 @@ static void Preparse( playlist_t *p_playlist, input_item_t *p_item )
 
     stats_TimerStart( p_playlist, "Preparse run", STATS_TIMER_PREPARSE );
 
+    /* Files modified since they were last preparsed are preparsed again.
+     * Repeated requests for an unmodified item are coalesced. */
+    int64_t i_mtime = GetFileDate( p_item );
+    vlc_mutex_lock( &p_item->lock );
+    bool b_modified = p_item->i_preparse_mtime != 0
+                   && p_item->i_preparse_mtime != i_mtime;
+    p_item->i_preparse_mtime = i_mtime;
+    vlc_mutex_unlock( &p_item->lock );
+
     /* Do not preparse if it is already done (like by playing it) */
-    if( !input_item_IsPreparsed( p_item ) )
+    if( !input_item_IsPreparsed( p_item ) || b_modified )
     {
         input_Preparse( VLC_OBJECT(p_playlist), p_item );
         input_item_SetPreparsed( p_item, true );
@@ -189,7 +245,9 @@ static void Art( playlist_preparser_t *p_preparser, input_item_t *p_item )
 }
 
 /**
- * This function does the preparsing and issues the art fetching requests
+ * This function does the preparsing and issues the art fetching requests.
+ * Up to i_threads of them run at the same time, and exit once the queue
+ * is empty.
  */
 static void *Thread( void *data )
 {
@@ -198,26 +256,30 @@ static void *Thread( void *data )
 
     for( ;; )
     {
-        input_item_t *p_current;
+        preparser_entry_t *p_entry;
 
         /* */
         vlc_mutex_lock( &p_preparser->lock );
-        if( p_preparser->i_waiting > 0 )
+        p_entry = p_preparser->p_waiting;
+        if( p_entry != NULL )
         {
-            p_current = p_preparser->pp_waiting[0];
-            REMOVE_ELEM( p_preparser->pp_waiting, p_preparser->i_waiting, 0 );
+            p_preparser->p_waiting = p_entry->p_next;
+            if( p_preparser->p_waiting == NULL )
+                p_preparser->pp_last = &p_preparser->p_waiting;
         }
         else
         {
-            p_current = NULL;
-            p_preparser->b_live = false;
+            p_preparser->i_live--;
             vlc_cond_signal( &p_preparser->wait );
         }
         vlc_mutex_unlock( &p_preparser->lock );
 
-        if( !p_current )
+        if( !p_entry )
             break;
 
+        input_item_t *p_current = p_entry->p_item;
+        free( p_entry );
+
         Preparse( p_playlist, p_current );
 
         Art( p_preparser, p_current );
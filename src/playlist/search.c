@@ -24,11 +24,13 @@
 # include "config.h"
 #endif
 #include <assert.h>
+#include <wctype.h>
 
 #include <vlc_common.h>
 #include <vlc_playlist.h>
 #include <vlc_charset.h>
 #include "playlist_internal.h"
+#include "../libvlc.h"
 
 /***************************************************************************
  * Item search functions
@@ -62,22 +64,13 @@ playlist_item_t* playlist_ItemGetById( playlist_t * p_playlist , int i_id )
 playlist_item_t* playlist_ItemGetByInput( playlist_t * p_playlist,
                                           input_item_t *p_item )
 {
-    int i;
     PL_ASSERT_LOCKED;
     if( get_current_status_item( p_playlist ) &&
         get_current_status_item( p_playlist )->p_input == p_item )
     {
         return get_current_status_item( p_playlist );
     }
-    /** \todo Check if this is always incremental and whether we can bsearch */
-    for( i =  0 ; i < p_playlist->all_items.i_size; i++ )
-    {
-        if( ARRAY_VAL(p_playlist->all_items, i)->p_input == p_item )
-        {
-            return ARRAY_VAL(p_playlist->all_items, i);
-        }
-    }
-    return NULL;
+    return playlist_ItemMapFind( p_playlist, p_item );
 }
 
 
@@ -89,6 +82,333 @@ playlist_item_t* playlist_ItemGetByInput( playlist_t * p_playlist,
  * Enable all items in the playlist
  * @param p_root: the current root item
  */
+/***************************************************************************
+ * Live search index
+ ***************************************************************************
+ * The searchable text of every item (title, album and artist, or name) is
+ * kept case-folded, as code points, so that queries need neither the input
+ * item locks nor vlc_strcasestr(). It is updated when an item is created,
+ * and when its meta data or name change, from the item event callbacks.
+ *
+ * Items are also listed by the trigrams of their text, hashed in buckets:
+ * the shortest list among the trigrams of a query holds every item that can
+ * match it. Lists are only ever appended to; the entries of items changed
+ * or removed since go stale, and are weeded out by checking the candidates
+ * against their current text. The lists are rebuilt once they are mostly
+ * stale.
+ ***************************************************************************/
+#define SEARCH_BUCKETS 4096
+
+TYPEDEF_ARRAY(int, search_ids_t)
+
+typedef struct
+{
+    uint32_t *p_text;     /**< folded fields, each terminated by 0 */
+    size_t    i_text;
+    size_t    i_postings; /**< number of bucket entries for this text */
+    unsigned  i_serial;   /**< last query matched */
+} search_entry_t;
+
+struct playlist_search_t
+{
+    vlc_mutex_t      lock;
+    search_entry_t **pp_entries; /**< by playlist item id */
+    int              i_entries;
+    search_ids_t     buckets[SEARCH_BUCKETS];
+    size_t           i_postings;
+    size_t           i_stale;
+    unsigned         i_generation; /**< bumped whenever a text changes */
+
+    /* Last query, refined when it is extended */
+    uint32_t        *p_query;
+    size_t           i_query;
+    unsigned         i_query_generation;
+    search_ids_t     matches;
+    unsigned         i_serial;
+};
+
+playlist_search_t *playlist_search_New( void )
+{
+    playlist_search_t *p_search = calloc( 1, sizeof( *p_search ) );
+    if( !p_search )
+        return NULL;
+
+    vlc_mutex_init( &p_search->lock );
+    return p_search;
+}
+
+void playlist_search_Delete( playlist_search_t *p_search )
+{
+    for( int i = 0; i < p_search->i_entries; i++ )
+    {
+        if( p_search->pp_entries[i] )
+        {
+            free( p_search->pp_entries[i]->p_text );
+            free( p_search->pp_entries[i] );
+        }
+    }
+    free( p_search->pp_entries );
+    for( unsigned i = 0; i < SEARCH_BUCKETS; i++ )
+        ARRAY_RESET( p_search->buckets[i] );
+    ARRAY_RESET( p_search->matches );
+    free( p_search->p_query );
+    vlc_mutex_destroy( &p_search->lock );
+    free( p_search );
+}
+
+/* Appends the case-folded code points of a string, and returns their count */
+static size_t SearchFold( uint32_t *p_out, const char *psz )
+{
+    size_t i = 0;
+    ssize_t s;
+    uint32_t cp;
+
+    while( (s = vlc_towc( psz, &cp )) > 0 )
+    {
+        if( cp != 0 )
+            p_out[i++] = towlower( cp );
+        psz += s;
+    }
+    return i;
+}
+
+static unsigned SearchBucket( const uint32_t *p )
+{
+    uint32_t h = p[0] * 0x9E3779B1u ^ p[1] * 0x85EBCA77u ^ p[2] * 0xC2B2AE3Du;
+    return (h ^ (h >> 15)) % SEARCH_BUCKETS;
+}
+
+/* Lists an entry once in the bucket of each of its trigrams */
+static void SearchIndex( playlist_search_t *p_search, int i_id,
+                         search_entry_t *p_entry )
+{
+    uint8_t seen[SEARCH_BUCKETS / 8];
+    const uint32_t *p = p_entry->p_text;
+
+    memset( seen, 0, sizeof( seen ) );
+    p_entry->i_postings = 0;
+    for( size_t i = 0; i + 2 < p_entry->i_text; i++ )
+    {
+        if( !p[i] || !p[i + 1] || !p[i + 2] )
+            continue;
+
+        unsigned i_bucket = SearchBucket( &p[i] );
+        if( seen[i_bucket / 8] & (1 << (i_bucket % 8)) )
+            continue;
+        seen[i_bucket / 8] |= 1 << (i_bucket % 8);
+        ARRAY_APPEND( p_search->buckets[i_bucket], i_id );
+        p_entry->i_postings++;
+    }
+    p_search->i_postings += p_entry->i_postings;
+}
+
+static void SearchReindex( playlist_search_t *p_search )
+{
+    for( unsigned i = 0; i < SEARCH_BUCKETS; i++ )
+        p_search->buckets[i].i_size = 0;
+    p_search->i_postings = 0;
+    p_search->i_stale = 0;
+
+    for( int i = 0; i < p_search->i_entries; i++ )
+        if( p_search->pp_entries[i] )
+            SearchIndex( p_search, i, p_search->pp_entries[i] );
+}
+
+static search_entry_t *SearchEntry( playlist_search_t *p_search, int i_id )
+{
+    if( i_id < 0 || i_id >= p_search->i_entries )
+        return NULL;
+    return p_search->pp_entries[i_id];
+}
+
+/**
+ * (Re)indexes the text of an item. Takes the input item lock.
+ */
+void playlist_search_Update( playlist_search_t *p_search,
+                             playlist_item_t *p_item )
+{
+    input_item_t *p_input = p_item->p_input;
+    const char *ppsz_fields[3] = { NULL, NULL, NULL };
+    size_t i_size = 0;
+
+    vlc_mutex_lock( &p_input->lock );
+    // Use Title or fall back to psz_name, as vlc_strcasestr() did
+    if( p_input->p_meta )
+    {
+        ppsz_fields[0] = vlc_meta_Get( p_input->p_meta, vlc_meta_Title );
+        if( !ppsz_fields[0] )
+            ppsz_fields[0] = p_input->psz_name;
+        ppsz_fields[1] = vlc_meta_Get( p_input->p_meta, vlc_meta_Album );
+        ppsz_fields[2] = vlc_meta_Get( p_input->p_meta, vlc_meta_Artist );
+    }
+    else
+        ppsz_fields[0] = p_input->psz_name;
+
+    for( unsigned i = 0; i < 3; i++ )
+        if( ppsz_fields[i] )
+            i_size += strlen( ppsz_fields[i] ) + 1;
+
+    uint32_t *p_text = malloc( (i_size + 1) * sizeof( *p_text ) );
+    size_t i_text = 0;
+    if( p_text )
+    {
+        for( unsigned i = 0; i < 3; i++ )
+        {
+            if( !ppsz_fields[i] )
+                continue;
+            i_text += SearchFold( &p_text[i_text], ppsz_fields[i] );
+            p_text[i_text++] = 0;
+        }
+    }
+    vlc_mutex_unlock( &p_input->lock );
+
+    if( !p_text )
+        return;
+
+    vlc_mutex_lock( &p_search->lock );
+    if( p_item->i_id >= p_search->i_entries )
+    {
+        int i_entries = __MAX( p_search->i_entries * 2, p_item->i_id + 1 );
+        search_entry_t **pp_entries =
+            realloc( p_search->pp_entries, i_entries * sizeof( *pp_entries ) );
+        if( !pp_entries )
+        {
+            vlc_mutex_unlock( &p_search->lock );
+            free( p_text );
+            return;
+        }
+        memset( &pp_entries[p_search->i_entries], 0,
+                (i_entries - p_search->i_entries) * sizeof( *pp_entries ) );
+        p_search->pp_entries = pp_entries;
+        p_search->i_entries = i_entries;
+    }
+
+    search_entry_t *p_entry = p_search->pp_entries[p_item->i_id];
+    if( p_entry )
+    {
+        p_search->i_stale += p_entry->i_postings;
+        free( p_entry->p_text );
+    }
+    else
+    {
+        p_entry = calloc( 1, sizeof( *p_entry ) );
+        if( !p_entry )
+        {
+            vlc_mutex_unlock( &p_search->lock );
+            free( p_text );
+            return;
+        }
+        p_search->pp_entries[p_item->i_id] = p_entry;
+    }
+    p_entry->p_text = p_text;
+    p_entry->i_text = i_text;
+    SearchIndex( p_search, p_item->i_id, p_entry );
+    p_search->i_generation++;
+
+    if( p_search->i_stale > 65536 && p_search->i_stale > p_search->i_postings / 2 )
+        SearchReindex( p_search );
+    vlc_mutex_unlock( &p_search->lock );
+}
+
+/**
+ * Forgets the text of an item.
+ */
+void playlist_search_Remove( playlist_search_t *p_search,
+                             playlist_item_t *p_item )
+{
+    vlc_mutex_lock( &p_search->lock );
+    search_entry_t *p_entry = SearchEntry( p_search, p_item->i_id );
+    if( p_entry )
+    {
+        p_search->i_stale += p_entry->i_postings;
+        p_search->pp_entries[p_item->i_id] = NULL;
+        free( p_entry->p_text );
+        free( p_entry );
+    }
+    vlc_mutex_unlock( &p_search->lock );
+}
+
+static bool SearchFind( const uint32_t *p_text, size_t i_text,
+                        const uint32_t *p_needle, size_t i_needle )
+{
+    /* The needle has no 0, so a match never spans two fields */
+    for( size_t i = 0; i + i_needle <= i_text; i++ )
+        if( !memcmp( &p_text[i], p_needle, i_needle * sizeof( *p_needle ) ) )
+            return true;
+    return false;
+}
+
+/**
+ * Marks the entries matching a query with a new serial.
+ * Must be called with the index locked.
+ */
+static void SearchQuery( playlist_search_t *p_search,
+                         const uint32_t *p_needle, size_t i_needle )
+{
+    const unsigned i_serial = ++p_search->i_serial;
+    const int *pi_cand = NULL;
+    int i_cand = -1;
+
+    /* Items matching a query also matched any part of it: if nothing
+     * changed since the last query, and this one extends it, only the
+     * last matches need checking. */
+    if( p_search->p_query && p_search->i_query_generation == p_search->i_generation
+     && SearchFind( p_needle, i_needle, p_search->p_query, p_search->i_query ) )
+    {
+        pi_cand = p_search->matches.p_elems;
+        i_cand = p_search->matches.i_size;
+    }
+
+    /* Otherwise (or if shorter) the bucket of the rarest trigram */
+    for( size_t i = 0; i + 2 < i_needle; i++ )
+    {
+        const search_ids_t *p_bucket =
+            &p_search->buckets[SearchBucket( &p_needle[i] )];
+        if( i_cand < 0 || p_bucket->i_size < i_cand )
+        {
+            pi_cand = p_bucket->p_elems;
+            i_cand = p_bucket->i_size;
+        }
+    }
+
+    search_ids_t matches;
+    ARRAY_INIT( matches );
+    for( int i = 0; i_cand < 0 ? i < p_search->i_entries : i < i_cand; i++ )
+    {
+        /* Short queries have no trigram: check every item */
+        const int i_id = i_cand < 0 ? i : pi_cand[i];
+        search_entry_t *p_entry = SearchEntry( p_search, i_id );
+
+        if( p_entry && p_entry->i_serial != i_serial
+         && SearchFind( p_entry->p_text, p_entry->i_text, p_needle, i_needle ) )
+        {
+            p_entry->i_serial = i_serial;
+            ARRAY_APPEND( matches, i_id );
+        }
+    }
+    ARRAY_RESET( p_search->matches );
+    p_search->matches = matches;
+
+    uint32_t *p_query = realloc( p_search->p_query,
+                                 (i_needle + 1) * sizeof( *p_query ) );
+    if( p_query )
+    {
+        memcpy( p_query, p_needle, i_needle * sizeof( *p_query ) );
+        p_search->i_query = i_needle;
+        p_search->i_query_generation = p_search->i_generation;
+    }
+    else
+        free( p_search->p_query );
+    p_search->p_query = p_query;
+}
+
+static bool SearchMatched( playlist_search_t *p_search,
+                           const playlist_item_t *p_item )
+{
+    search_entry_t *p_entry = SearchEntry( p_search, p_item->i_id );
+    return p_entry && p_entry->i_serial == p_search->i_serial;
+}
+
 static void playlist_LiveSearchClean( playlist_item_t *p_root )
 {
     for( int i = 0; i < p_root->i_children; i++ )
@@ -107,8 +427,9 @@ static void playlist_LiveSearchClean( playlist_item_t *p_root )
  * @param psz_string: the string to search
  * @return true if an item match
  */
-static bool playlist_LiveSearchUpdateInternal( playlist_item_t *p_root,
-                                               const char *psz_string, bool b_recursive )
+static bool playlist_LiveSearchUpdateInternal( playlist_search_t *p_search,
+                                               playlist_item_t *p_root,
+                                               bool b_recursive )
 {
     int i;
     bool b_match = false;
@@ -118,31 +439,13 @@ static bool playlist_LiveSearchUpdateInternal( playlist_item_t *p_root,
         playlist_item_t *p_item = p_root->pp_children[i];
         // Go recurssively if their is some children
         if( b_recursive && p_item->i_children >= 0 &&
-            playlist_LiveSearchUpdateInternal( p_item, psz_string, true ) )
+            playlist_LiveSearchUpdateInternal( p_search, p_item, true ) )
         {
             b_enable = true;
         }
 
         if( !b_enable )
-        {
-            vlc_mutex_lock( &p_item->p_input->lock );
-            // Do we have some meta ?
-            if( p_item->p_input->p_meta )
-            {
-                // Use Title or fall back to psz_name
-                const char *psz_title = vlc_meta_Get( p_item->p_input->p_meta, vlc_meta_Title );
-                if( !psz_title )
-                    psz_title = p_item->p_input->psz_name;
-                const char *psz_album = vlc_meta_Get( p_item->p_input->p_meta, vlc_meta_Album );
-                const char *psz_artist = vlc_meta_Get( p_item->p_input->p_meta, vlc_meta_Artist );
-                b_enable = ( psz_title && vlc_strcasestr( psz_title, psz_string ) ) ||
-                           ( psz_album && vlc_strcasestr( psz_album, psz_string ) ) ||
-                           ( psz_artist && vlc_strcasestr( psz_artist, psz_string ) );
-            }
-            else
-                b_enable = p_item->p_input->psz_name && vlc_strcasestr( p_item->p_input->psz_name, psz_string );
-            vlc_mutex_unlock( &p_item->p_input->lock );
-        }
+            b_enable = SearchMatched( p_search, p_item );
 
         if( b_enable )
             p_item->i_flags &= ~PLAYLIST_DBL_FLAG;
@@ -166,10 +469,27 @@ static bool playlist_LiveSearchUpdateInternal( playlist_item_t *p_root,
 int playlist_LiveSearchUpdate( playlist_t *p_playlist, playlist_item_t *p_root,
                                const char *psz_string, bool b_recursive )
 {
+    playlist_search_t *p_search = pl_priv(p_playlist)->p_search;
+
     PL_ASSERT_LOCKED;
+    if( *psz_string && !p_search )
+        return VLC_ENOMEM;
+
     pl_priv(p_playlist)->b_reset_currently_playing = true;
     if( *psz_string )
-        playlist_LiveSearchUpdateInternal( p_root, psz_string, b_recursive );
+    {
+        uint32_t *p_needle = malloc( strlen( psz_string ) * sizeof( *p_needle ) );
+        if( !p_needle )
+            return VLC_ENOMEM;
+
+        size_t i_needle = SearchFold( p_needle, psz_string );
+
+        vlc_mutex_lock( &p_search->lock );
+        SearchQuery( p_search, p_needle, i_needle );
+        playlist_LiveSearchUpdateInternal( p_search, p_root, b_recursive );
+        vlc_mutex_unlock( &p_search->lock );
+        free( p_needle );
+    }
     else
         playlist_LiveSearchClean( p_root );
     vlc_cond_signal( &pl_priv(p_playlist)->signal );
@@ -26,6 +26,8 @@
 # include "config.h"
 #endif
 
+#include <ctype.h>
+
 #include <vlc_common.h>
 #include <vlc_rand.h>
 #define  VLC_INTERNAL_PLAYLIST_SORT_FUNCTIONS
@@ -33,111 +35,275 @@
 #include "playlist_internal.h"
 
 
+/* Sort keys
+ *
+ * Everything the comparison functions need is fetched from the input items
+ * once per item, before sorting, and strings are lower-cased then, so that
+ * comparing two items takes no lock and allocates nothing. strcmp() on the
+ * lower-cased strings orders them as strcasecmp() did.
+ */
+typedef struct
+{
+    playlist_item_t *p_item;
+    bool             b_node;
+    char            *psz_title;  /**< lower-cased title or name */
+    struct
+    {
+        char        *psz;        /**< lower-cased meta, NULL if none */
+        int          i;          /**< integer value of the meta */
+    } meta[3];
+    mtime_t          i_value;    /**< duration, id or title number */
+} sort_key_t;
+
+static char *key_fold( char *psz )
+{
+    if( psz )
+        for( char *p = psz; *p; p++ )
+            *p = tolower( (unsigned char)*p );
+    return psz;
+}
+
+static void key_title( sort_key_t *key )
+{
+    key->psz_title = key_fold( input_item_GetTitleFbName( key->p_item->p_input ) );
+}
+
+static void key_meta( sort_key_t *key, unsigned i, vlc_meta_type_t meta,
+                      bool b_integer )
+{
+    char *psz = input_item_GetMeta( key->p_item->p_input, meta );
+
+    if( psz && b_integer )
+        key->meta[i].i = atoi( psz );
+    key->meta[i].psz = key_fold( psz );
+}
+
+static void key_clean( sort_key_t *key )
+{
+    free( key->psz_title );
+    for( unsigned i = 0; i < 3; i++ )
+        free( key->meta[i].psz );
+}
+
 /* General comparison functions */
 /**
- * Compare two items using their title or name
- * @param first: the first item
- * @param second: the second item
+ * Compare two strings, missing ones last
  * @return -1, 0 or 1 like strcmp
  */
-static inline int meta_strcasecmp_title( const playlist_item_t *first,
-                              const playlist_item_t *second )
+static inline int key_strcmp( const char *psz_first, const char *psz_second )
 {
-    int i_ret;
-    char *psz_first = input_item_GetTitleFbName( first->p_input );
-    char *psz_second = input_item_GetTitleFbName( second->p_input );
-
     if( psz_first && psz_second )
-        i_ret = strcasecmp( psz_first, psz_second );
+        return strcmp( psz_first, psz_second );
     else if( !psz_first && psz_second )
-        i_ret = 1;
+        return 1;
     else if( psz_first && !psz_second )
-        i_ret = -1;
+        return -1;
     else
-        i_ret = 0;
-    free( psz_first );
-    free( psz_second );
+        return 0;
+}
 
-    return i_ret;
+/**
+ * Compare two items using their title or name
+ * @param first: the first item
+ * @param second: the second item
+ * @return -1, 0 or 1 like strcmp
+ */
+static inline int meta_strcasecmp_title( const sort_key_t *first,
+                                         const sort_key_t *second )
+{
+    return key_strcmp( first->psz_title, second->psz_title );
 }
 
 /**
- * Compare two intems accoring to the given meta type
+ * Compare two intems accoring to one of their meta
  * @param first: the first item
  * @param second: the second item
- * @param meta: the meta type to use to sort the items
+ * @param i: index of the meta in the sort key
  * @param b_integer: true if the meta are integers
  * @return -1, 0 or 1 like strcmp
  */
-static inline int meta_sort( const playlist_item_t *first,
-                             const playlist_item_t *second,
-                             vlc_meta_type_t meta, bool b_integer )
+static inline int meta_sort( const sort_key_t *first,
+                             const sort_key_t *second,
+                             unsigned i, bool b_integer )
 {
-    int i_ret;
-    char *psz_first = input_item_GetMeta( first->p_input, meta );
-    char *psz_second = input_item_GetMeta( second->p_input, meta );
+    const char *psz_first = first->meta[i].psz;
+    const char *psz_second = second->meta[i].psz;
 
     /* Nodes go first */
-    if( first->i_children == -1 && second->i_children >= 0 )
-        i_ret = 1;
-    else if( first->i_children >= 0 && second->i_children == -1 )
-       i_ret = -1;
+    if( !first->b_node && second->b_node )
+        return 1;
+    else if( first->b_node && !second->b_node )
+        return -1;
     /* Both are nodes, sort by name */
-    else if( first->i_children >= 0 && second->i_children >= 0 )
-        i_ret = meta_strcasecmp_title( first, second );
+    else if( first->b_node && second->b_node )
+        return meta_strcasecmp_title( first, second );
     /* Both are items */
     else if( !psz_first && psz_second )
-        i_ret = 1;
+        return 1;
     else if( psz_first && !psz_second )
-        i_ret = -1;
+        return -1;
     /* No meta, sort by name */
     else if( !psz_first && !psz_second )
-        i_ret = meta_strcasecmp_title( first, second );
+        return meta_strcasecmp_title( first, second );
+    else if( b_integer )
+        return ( first->meta[i].i > second->meta[i].i )
+             - ( first->meta[i].i < second->meta[i].i );
     else
-    {
-        if( b_integer )
-            i_ret = atoi( psz_first ) - atoi( psz_second );
-        else
-            i_ret = strcasecmp( psz_first, psz_second );
-    }
-
-    free( psz_first );
-    free( psz_second );
-    return i_ret;
+        return strcmp( psz_first, psz_second );
 }
 
 /* Comparison functions */
 
+typedef void (*sortkey_t)( sort_key_t * );
+typedef int (*sortfn_t)( const sort_key_t *, const sort_key_t * );
+typedef struct
+{
+    sortkey_t pf_key;
+    sortfn_t  pf_cmp;
+} sort_mode_t;
+
 /**
- * Return the comparison function appropriate for the SORT_* and ORDER_*
- * arguments given, or NULL for SORT_RANDOM.
+ * Return the key and comparison functions appropriate for the SORT_* and
+ * ORDER_* arguments given, or NULL for SORT_RANDOM.
  * @param i_mode: a SORT_* enum indicating the field to sort on
  * @param i_type: ORDER_NORMAL or ORDER_REVERSE
- * @return function pointer, or NULL for SORT_RANDOM or invalid input
+ * @return the sorting mode, or NULL for SORT_RANDOM or invalid input
  */
-typedef int (*sortfn_t)(const void *,const void *);
-static const sortfn_t sorting_fns[NUM_SORT_FNS][2];
-static inline sortfn_t find_sorting_fn( unsigned i_mode, unsigned i_type )
+static const sort_mode_t sorting_fns[NUM_SORT_FNS][2];
+static inline const sort_mode_t *find_sorting_fn( unsigned i_mode,
+                                                  unsigned i_type )
 {
     if( i_mode>=NUM_SORT_FNS || i_type>1 )
-        return 0;
-    return sorting_fns[i_mode][i_type];
+        return NULL;
+    return &sorting_fns[i_mode][i_type];
+}
+
+/* Stable merge sort of the sort keys. Big arrays have their halves sorted
+ * by different threads. */
+#define SORT_INSERTION   16     /* below this many items */
+#define SORT_PARALLEL    16384  /* from this many items */
+
+typedef struct
+{
+    sort_key_t **pp_keys;
+    sort_key_t **pp_tmp;
+    size_t       i_count;
+    sortfn_t     pf_cmp;
+    unsigned     i_depth;       /* levels that can still be split */
+} sort_job_t;
+
+static void *SortRun( void * );
+
+static void SortMerge( sort_job_t *job, size_t i_half )
+{
+    sort_key_t **a = job->pp_keys, **b = job->pp_keys + i_half;
+    sort_key_t **a_end = b, **b_end = job->pp_keys + job->i_count;
+    sort_key_t **out = job->pp_tmp;
+
+    /* Already in order */
+    if( job->pf_cmp( *b, b[-1] ) >= 0 )
+        return;
+
+    while( a < a_end && b < b_end )
+        *out++ = ( job->pf_cmp( *b, *a ) < 0 ) ? *b++ : *a++;
+    while( a < a_end )
+        *out++ = *a++;
+    /* What is left of b is already in place */
+    memcpy( job->pp_keys, job->pp_tmp, (out - job->pp_tmp) * sizeof( *out ) );
+}
+
+static void *SortRun( void *data )
+{
+    sort_job_t *job = data;
+    sort_key_t **pp_keys = job->pp_keys;
+
+    if( job->i_count < SORT_INSERTION )
+    {
+        for( size_t i = 1; i < job->i_count; i++ )
+        {
+            sort_key_t *key = pp_keys[i];
+            size_t j = i;
+
+            for( ; j > 0 && job->pf_cmp( key, pp_keys[j - 1] ) < 0; j-- )
+                pp_keys[j] = pp_keys[j - 1];
+            pp_keys[j] = key;
+        }
+        return NULL;
+    }
+
+    size_t i_half = job->i_count / 2;
+    sort_job_t left = {
+        pp_keys, job->pp_tmp, i_half, job->pf_cmp,
+        job->i_depth ? job->i_depth - 1 : 0 };
+    sort_job_t right = {
+        pp_keys + i_half, job->pp_tmp + i_half, job->i_count - i_half,
+        job->pf_cmp, left.i_depth };
+    vlc_thread_t thread;
+
+    if( job->i_depth > 0 && job->i_count >= SORT_PARALLEL
+     && !vlc_clone( &thread, SortRun, &left, VLC_THREAD_PRIORITY_LOW ) )
+    {
+        SortRun( &right );
+        vlc_join( thread, NULL );
+    }
+    else
+    {
+        SortRun( &left );
+        SortRun( &right );
+    }
+    SortMerge( job, i_half );
+    return NULL;
 }
 
 /**
- * Sort an array of items recursively
+ * Sort an array of items
  * @param i_items: number of items
  * @param pp_items: the array of items
- * @param p_sortfn: the sorting function
+ * @param p_mode: the sorting functions, NULL to shuffle
  * @return nothing
  */
 static inline
 void playlist_ItemArraySort( unsigned i_items, playlist_item_t **pp_items,
-                             sortfn_t p_sortfn )
+                             const sort_mode_t *p_mode )
 {
-    if( p_sortfn )
+    if( p_mode )
     {
-        qsort( pp_items, i_items, sizeof( pp_items[0] ), p_sortfn );
+        if( i_items < 2 )
+            return;
+
+        sort_key_t *p_keys = calloc( i_items, sizeof( *p_keys ) );
+        sort_key_t **pp_keys = malloc( 2 * i_items * sizeof( *pp_keys ) );
+        if( !p_keys || !pp_keys )
+        {
+            free( p_keys );
+            free( pp_keys );
+            return;
+        }
+
+        for( unsigned i = 0; i < i_items; i++ )
+        {
+            p_keys[i].p_item = pp_items[i];
+            p_keys[i].b_node = pp_items[i]->i_children >= 0;
+            p_mode->pf_key( &p_keys[i] );
+            pp_keys[i] = &p_keys[i];
+        }
+
+        unsigned i_depth = 0;
+        for( unsigned i_cpus = vlc_GetCPUCount(); i_cpus > 1 && i_depth < 3;
+             i_cpus /= 2 )
+            i_depth++;
+
+        sort_job_t job = {
+            pp_keys, pp_keys + i_items, i_items, p_mode->pf_cmp, i_depth };
+        SortRun( &job );
+
+        for( unsigned i = 0; i < i_items; i++ )
+        {
+            pp_items[i] = pp_keys[i]->p_item;
+            key_clean( &p_keys[i] );
+        }
+        free( pp_keys );
+        free( p_keys );
     }
     else /* Randomise */
     {
@@ -161,19 +327,19 @@ void playlist_ItemArraySort( unsigned i_items, playlist_item_t **pp_items,
  * This function must be entered with the playlist lock !
  * @param p_playlist the playlist
  * @param p_node the node to sort
- * @param p_sortfn the sorting function
+ * @param p_mode the sorting functions
  * @return VLC_SUCCESS on success
  */
 static int recursiveNodeSort( playlist_t *p_playlist, playlist_item_t *p_node,
-                              sortfn_t p_sortfn )
+                              const sort_mode_t *p_mode )
 {
     int i;
-    playlist_ItemArraySort(p_node->i_children,p_node->pp_children,p_sortfn);
+    playlist_ItemArraySort(p_node->i_children,p_node->pp_children,p_mode);
     for( i = 0 ; i< p_node->i_children; i++ )
     {
         if( p_node->pp_children[i]->i_children != -1 )
         {
-            recursiveNodeSort( p_playlist, p_node->pp_children[i], p_sortfn );
+            recursiveNodeSort( p_playlist, p_node->pp_children[i], p_mode );
         }
     }
     return VLC_SUCCESS;
@@ -195,38 +361,55 @@ int playlist_RecursiveNodeSort( playlist_t *p_playlist, playlist_item_t *p_node,
 {
     /* Ask the playlist to reset as we are changing the order */
     pl_priv(p_playlist)->b_reset_currently_playing = true;
+    playlist_RecordChange( p_playlist, PLAYLIST_CHANGE_REORDERED,
+                           p_node->i_id, -1, 0 );
 
     /* Do the real job recursively */
     return recursiveNodeSort(p_playlist,p_node,find_sorting_fn(i_mode,i_type));
 }
 
 
-/* This is the stuff the sorting functions are made of. The proto_##
- * functions are wrapped in cmp_a_## and cmp_d_## functions that do
- * void * to const playlist_item_t * casting and dereferencing and
- * cmp_d_## inverts the result, too. proto_## are static inline,
- * cmp_[ad]_## are merely static as they're the target of pointers.
+/* This is the stuff the sorting functions are made of. The key_##
+ * functions fill the sort key of an item with what the proto_## functions
+ * compare. The proto_## functions are wrapped in cmp_a_## and cmp_d_##
+ * functions, and cmp_d_## inverts the result. proto_## are static inline,
+ * key_## and cmp_[ad]_## are merely static as they're the target of
+ * pointers.
  *
  * In any case, each SORT_## constant (except SORT_RANDOM) must have
- * a matching SORTFN( )-declared function here.
+ * a matching SORTKEY( ) and SORTFN( )-declared function here.
  */
 
+#define SORTKEY( SORT, key ) static void key_##SORT( sort_key_t *key )
 #define SORTFN( SORT, first, second ) static inline int proto_##SORT \
-	( const playlist_item_t *first, const playlist_item_t *second )
+	( const sort_key_t *first, const sort_key_t *second )
+
+SORTKEY( SORT_ALBUM, key )
+{
+    key_title( key );
+    key_meta( key, 0, vlc_meta_Album, false );
+    key_meta( key, 1, vlc_meta_TrackNumber, true );
+}
 
 SORTFN( SORT_ALBUM, first, second )
 {
-    int i_ret = meta_sort( first, second, vlc_meta_Album, false );
+    int i_ret = meta_sort( first, second, 0, false );
     /* Items came from the same album: compare the track numbers */
     if( i_ret == 0 )
-        i_ret = meta_sort( first, second, vlc_meta_TrackNumber, true );
+        i_ret = meta_sort( first, second, 1, true );
 
     return i_ret;
 }
 
+SORTKEY( SORT_ARTIST, key )
+{
+    key_SORT_ALBUM( key );
+    key_meta( key, 2, vlc_meta_Artist, false );
+}
+
 SORTFN( SORT_ARTIST, first, second )
 {
-    int i_ret = meta_sort( first, second, vlc_meta_Artist, false );
+    int i_ret = meta_sort( first, second, 2, false );
     /* Items came from the same artist: compare the albums */
     if( i_ret == 0 )
         i_ret = proto_SORT_ALBUM( first, second );
@@ -234,33 +417,66 @@ SORTFN( SORT_ARTIST, first, second )
     return i_ret;
 }
 
+SORTKEY( SORT_DESCRIPTION, key )
+{
+    key_title( key );
+    key_meta( key, 0, vlc_meta_Description, false );
+}
+
 SORTFN( SORT_DESCRIPTION, first, second )
 {
-    return meta_sort( first, second, vlc_meta_Description, false );
+    return meta_sort( first, second, 0, false );
+}
+
+SORTKEY( SORT_DURATION, key )
+{
+    key->i_value = input_item_GetDuration( key->p_item->p_input );
 }
 
 SORTFN( SORT_DURATION, first, second )
 {
-    mtime_t time1 = input_item_GetDuration( first->p_input );
-    mtime_t time2 = input_item_GetDuration( second->p_input );
+    mtime_t time1 = first->i_value;
+    mtime_t time2 = second->i_value;
     int i_ret = time1 > time2 ? 1 :
                     ( time1 == time2 ? 0 : -1 );
     return i_ret;
 }
 
+SORTKEY( SORT_GENRE, key )
+{
+    key_title( key );
+    key_meta( key, 0, vlc_meta_Genre, false );
+}
+
 SORTFN( SORT_GENRE, first, second )
 {
-    return meta_sort( first, second, vlc_meta_Genre, false );
+    return meta_sort( first, second, 0, false );
+}
+
+SORTKEY( SORT_ID, key )
+{
+    key->i_value = key->p_item->i_id;
 }
 
 SORTFN( SORT_ID, first, second )
 {
-    return first->i_id - second->i_id;
+    return first->i_value - second->i_value;
+}
+
+SORTKEY( SORT_RATING, key )
+{
+    key_title( key );
+    key_meta( key, 0, vlc_meta_Rating, true );
 }
 
 SORTFN( SORT_RATING, first, second )
 {
-    return meta_sort( first, second, vlc_meta_Rating, true );
+    return meta_sort( first, second, 0, true );
+}
+
+SORTKEY( SORT_TITLE, key )
+{
+    key_title( key );
 }
 
 SORTFN( SORT_TITLE, first, second )
@@ -268,65 +484,62 @@ SORTFN( SORT_TITLE, first, second )
     return meta_strcasecmp_title( first, second );
 }
 
+SORTKEY( SORT_TITLE_NODES_FIRST, key )
+{
+    key_title( key );
+}
+
 SORTFN( SORT_TITLE_NODES_FIRST, first, second )
 {
     /* If first is a node but not second */
-    if( first->i_children == -1 && second->i_children >= 0 )
+    if( !first->b_node && second->b_node )
         return -1;
     /* If second is a node but not first */
-    else if( first->i_children >= 0 && second->i_children == -1 )
+    else if( first->b_node && !second->b_node )
         return 1;
     /* Both are nodes or both are not nodes */
     else
         return meta_strcasecmp_title( first, second );
 }
 
-SORTFN( SORT_TITLE_NUMERIC, first, second )
+SORTKEY( SORT_TITLE_NUMERIC, key )
 {
-    int i_ret;
-    char *psz_first = input_item_GetTitleFbName( first->p_input );
-    char *psz_second = input_item_GetTitleFbName( second->p_input );
+    key_title( key );
+    if( key->psz_title )
+        key->i_value = atoi( key->psz_title );
+}
 
-    if( psz_first && psz_second )
-        i_ret = atoi( psz_first ) - atoi( psz_second );
-    else if( !psz_first && psz_second )
-        i_ret = 1;
-    else if( psz_first && !psz_second )
-        i_ret = -1;
-    else
-        i_ret = 0;
+SORTFN( SORT_TITLE_NUMERIC, first, second )
+{
+    if( first->psz_title && second->psz_title )
+        return ( first->i_value > second->i_value )
+             - ( first->i_value < second->i_value );
+    return key_strcmp( first->psz_title, second->psz_title );
+}
 
-    free( psz_first );
-    free( psz_second );
-    return i_ret;
+SORTKEY( SORT_TRACK_NUMBER, key )
+{
+    key_title( key );
+    key_meta( key, 0, vlc_meta_TrackNumber, true );
 }
 
 SORTFN( SORT_TRACK_NUMBER, first, second )
 {
-    return meta_sort( first, second, vlc_meta_TrackNumber, true );
+    return meta_sort( first, second, 0, true );
 }
 
-SORTFN( SORT_URI, first, second )
+SORTKEY( SORT_URI, key )
 {
-    int i_ret;
-    char *psz_first = input_item_GetURI( first->p_input );
-    char *psz_second = input_item_GetURI( second->p_input );
-
-    if( psz_first && psz_second )
-        i_ret = strcasecmp( psz_first, psz_second );
-    else if( !psz_first && psz_second )
-        i_ret = 1;
-    else if( psz_first && !psz_second )
-        i_ret = -1;
-    else
-        i_ret = 0;
+    key->meta[0].psz = key_fold( input_item_GetURI( key->p_item->p_input ) );
+}
 
-    free( psz_first );
-    free( psz_second );
-    return i_ret;
+SORTFN( SORT_URI, first, second )
+{
+    return key_strcmp( first->meta[0].psz, second->meta[0].psz );
 }
 
 #undef  SORTFN
+#undef  SORTKEY
 
 /* Generate stubs around the proto_## sorting functions, ascending and
  * descending both. Preprocessor magic up ahead. Brace yourself.
@@ -337,12 +550,10 @@ SORTFN( SORT_URI, first, second )
 #endif
 
 #define DEF( s ) \
-	static int cmp_a_##s(const void *l,const void *r) \
-	{ return proto_##s(*(const playlist_item_t *const *)l, \
-                           *(const playlist_item_t *const *)r); } \
-	static int cmp_d_##s(const void *l,const void *r) \
-	{ return -1*proto_##s(*(const playlist_item_t * const *)l, \
-                              *(const playlist_item_t * const *)r); }
+	static int cmp_a_##s(const sort_key_t *l,const sort_key_t *r) \
+	{ return proto_##s(l, r); } \
+	static int cmp_d_##s(const sort_key_t *l,const sort_key_t *r) \
+	{ return -1*proto_##s(l, r); }
 
 	VLC_DEFINE_SORT_FUNCTIONS
 
@@ -350,8 +561,7 @@ SORTFN( SORT_URI, first, second )
 
 /* And populate an array with the addresses */
 
-static const sortfn_t sorting_fns[NUM_SORT_FNS][2] =
-#define DEF( a ) { cmp_a_##a, cmp_d_##a },
+static const sort_mode_t sorting_fns[NUM_SORT_FNS][2] =
+#define DEF( a ) { { key_##a, cmp_a_##a }, { key_##a, cmp_d_##a } },
 { VLC_DEFINE_SORT_FUNCTIONS };
 #undef  DEF
-
@@ -33,9 +33,575 @@
 #include <vlc_interface.h>
 #include <vlc_playlist.h>
 #include <vlc_rand.h>
+#include <vlc_url.h>
 #include "stream_output/stream_output.h"
 #include "playlist_internal.h"
 
+// Offsets below SYN_SLEW_THRESHOLD are corrected by playing a little
+// faster or slower, at most by 1 / SYN_SLEW_MAX_INVERSE and for at least
+// SYN_SLEW_MIN_DURATION. A seek flushes every buffer on the way from the
+// demuxer to the outputs, which stutters and is slow on network inputs.
+#define SYN_SLEW_THRESHOLD 500000
+#define SYN_SLEW_MAX_INVERSE 10
+#define SYN_SLEW_MIN_DURATION 1000000
+
+// A coordinated start: whoever starts playing pauses again and has
+// every peer pause at the same position, where the input fills its
+// buffers and the decoders preroll. Peers answer once done. The
+// initiator then starts everyone at the same wall clock time, at least
+// SYN_START_LEAD from now, and gives up waiting for answers after
+// SYN_START_TIMEOUT.
+#define SYN_START_LEAD 150000
+#define SYN_START_TIMEOUT 3000000
+
+enum {
+  SYN_START_NONE = 0,
+  SYN_START_INITIATING, /* we asked, waiting for buffers and a peer */
+  SYN_START_PREPARING,  /* a peer asked, waiting for buffers */
+  SYN_START_WAITING,    /* told the peer we are ready */
+  SYN_START_COMMITTED,  /* the start is scheduled */
+};
+
+static void SynSlewRestore(playlist_t* p_playlist, input_thread_t* p_in) {
+  playlist_private_t *p_sys = pl_priv(p_playlist);
+  if(p_sys->b_syn_slewing) {
+    p_sys->b_syn_slewing = false;
+    if (NULL != p_in) {
+      var_SetFloat(p_in, "rate", p_sys->f_syn_slew_base_rate);
+    }
+  }
+}
+
+static void SynSlewEnd(void* param) {
+  playlist_t* p_playlist = (playlist_t*)param;
+  if(!pl_priv(p_playlist)->b_syn_slewing) {
+    return;
+  }
+  input_thread_t* p_in = playlist_CurrentInput(p_playlist);
+  SynSlewRestore(p_playlist, p_in);
+  if (NULL != p_in) {
+    vlc_object_release(p_in);
+  }
+}
+
+/* Back to the base rate on p_in, or just forget the slew without an
+ * input, e.g. when a new one starts */
+void playlist_SynSlewStop(playlist_t* p_playlist, input_thread_t* p_in) {
+  playlist_private_t *p_sys = pl_priv(p_playlist);
+  if(p_sys->b_syn_slew_timer) {
+    vlc_timer_schedule(p_sys->syn_slew_timer, false, 0, 0);
+  }
+  SynSlewRestore(p_playlist, p_in);
+}
+
+static bool SynCanSlew(playlist_t* p_playlist, input_thread_t* p_in,
+    mtime_t offset) {
+  playlist_private_t *p_sys = pl_priv(p_playlist);
+  int playpause;
+  input_Control(p_in, INPUT_GET_STATE, &playpause);
+  if(PLAYING_S != playpause || llabs(offset) >= SYN_SLEW_THRESHOLD ||
+      !var_GetBool(p_in, "can-rate")) {
+    return false;
+  }
+  if(!p_sys->b_syn_slew_timer) {
+    if(vlc_timer_create(&p_sys->syn_slew_timer, SynSlewEnd, p_playlist)) {
+      return false;
+    }
+    p_sys->b_syn_slew_timer = true;
+  }
+  return true;
+}
+
+/* Get the input at current + offset, current being its time now */
+void playlist_SynCorrect(playlist_t* p_playlist, input_thread_t* p_in,
+    mtime_t current, mtime_t offset) {
+  playlist_private_t *p_sys = pl_priv(p_playlist);
+  // the next corrections lean on the clock estimate, make it fresh
+  if(p_sys->b_syn_created) {
+    SynConnection_Resync(p_sys->syn_connection);
+  }
+  if(!SynCanSlew(p_playlist, p_in, offset)) {
+    playlist_SynSlewStop(p_playlist, p_in);
+    input_Control(p_in, INPUT_SET_TIME, current + offset);
+    p_sys->i_syn_seeks++;
+    return;
+  }
+
+  if(!p_sys->b_syn_slewing) {
+    p_sys->f_syn_slew_base_rate = var_GetFloat(p_in, "rate");
+  }
+  mtime_t duration = llabs(offset) * SYN_SLEW_MAX_INVERSE;
+  if(duration < SYN_SLEW_MIN_DURATION) {
+    duration = SYN_SLEW_MIN_DURATION;
+  }
+  // the peer plays at the base rate too, the difference makes up offset
+  float rate = p_sys->f_syn_slew_base_rate + (float)offset / duration;
+  msg_Dbg(p_playlist, "slewing %"PRId64" us away at rate %f", offset, rate);
+  p_sys->b_syn_slewing = true;
+  var_SetFloat(p_in, "rate", rate);
+  vlc_timer_schedule(p_sys->syn_slew_timer, false, duration, 0);
+  p_sys->i_syn_slews++;
+}
+
+/* Fill in the session's part of p_stats, its lock held. Everything is 0
+ * without a session. */
+void playlist_SynComputeStats(playlist_t* p_playlist, input_stats_t* p_stats) {
+  playlist_private_t *p_sys = pl_priv(p_playlist);
+  SynConnection_Stats stats;
+  if(!p_sys->b_syn_created ||
+      0 != SynConnection_GetStats(p_sys->syn_connection, &stats)) {
+    memset(&stats, 0, sizeof(stats));
+  }
+  p_stats->i_syn_rtt = stats.rtt > 0 ? stats.rtt : 0;
+  p_stats->i_syn_offset = stats.offset;
+  p_stats->i_syn_offset_error = stats.offset_error;
+  p_stats->i_syn_sent_bytes = stats.bytes_sent;
+  p_stats->i_syn_received_bytes = stats.bytes_received;
+  p_stats->i_syn_beacons = stats.beacons_sent;
+  p_stats->i_syn_beacon_replies = stats.beacons_answered;
+  p_stats->i_syn_seeks = p_sys->i_syn_seeks;
+  p_stats->i_syn_slews = p_sys->i_syn_slews;
+}
+
+/* Also goes out from the receive callback, where b_syn_can_send is off */
+static void SynSendCommandNow(playlist_t* p_playlist, SynCommandType type,
+    mtime_t i_time) {
+  playlist_private_t *p_sys = pl_priv(p_playlist);
+  SynCommand syn;
+  syn.type = type;
+  syn.data.i_time = i_time;
+  char buffer[16];
+  int numbytes = SynCommand_Encode(syn, buffer, sizeof(buffer),
+      SynConnection_GetWireVersion(p_sys->syn_connection));
+  if(numbytes > 0) {
+    SynConnection_Send(p_sys->syn_connection, buffer, numbytes, NULL, NULL);
+  }
+}
+
+static void SynStartTimer(void* param);
+
+/* syn_start_lock held. Fire SynStartTimer after delay. */
+static bool SynStartSchedule(playlist_t* p_playlist, mtime_t delay) {
+  playlist_private_t *p_sys = pl_priv(p_playlist);
+  if(!p_sys->b_syn_start_timer) {
+    if(vlc_timer_create(&p_sys->syn_start_timer, SynStartTimer, p_playlist)) {
+      return false;
+    }
+    p_sys->b_syn_start_timer = true;
+  }
+  vlc_timer_schedule(p_sys->syn_start_timer, true,
+      mdate() + (delay > 0 ? delay : 1), 0);
+  return true;
+}
+
+/* syn_start_lock held. Everyone is ready, or waited for long enough. */
+static void SynStartCommit(playlist_t* p_playlist) {
+  playlist_private_t *p_sys = pl_priv(p_playlist);
+  mtime_t lead = SYN_START_LEAD;
+  SynConnection_Stats stats;
+  if(0 == SynConnection_GetStats(p_sys->syn_connection, &stats) &&
+      2 * stats.rtt > lead) {
+    lead = 2 * stats.rtt;
+  }
+  SynSendCommandNow(p_playlist, SYNCOMMAND_START, lead);
+  p_sys->i_syn_start = SYN_START_COMMITTED;
+  SynStartSchedule(p_playlist, lead);
+}
+
+/* Without syn_start_lock: pause at i_time and fill the buffers there */
+static void SynStartPause(playlist_t* p_playlist, input_thread_t* p_in,
+    mtime_t i_time) {
+  playlist_SynSlewStop(p_playlist, p_in);
+  input_Control(p_in, INPUT_SET_STATE, PAUSE_S);
+  /* seeking restarts the buffering, even paused the input demuxes
+   * until it is done */
+  input_Control(p_in, INPUT_SET_TIME, i_time);
+}
+
+static void SynStartTimer(void* param) {
+  playlist_t* p_playlist = (playlist_t*)param;
+  playlist_private_t *p_sys = pl_priv(p_playlist);
+  /* before the lock, PlayItem() cancels starts with the playlist locked */
+  input_thread_t* p_in = playlist_CurrentInput(p_playlist);
+  bool b_play = false;
+  bool b_pause = false;
+  mtime_t i_time = 0;
+  vlc_mutex_lock(&p_sys->syn_start_lock);
+  switch(p_sys->i_syn_start) {
+    case SYN_START_INITIATING:
+    case SYN_START_PREPARING:
+      if(p_sys->b_syn_start_pause) {
+        p_sys->b_syn_start_pause = false;
+        b_pause = NULL != p_in;
+        i_time = p_sys->i_syn_start_time;
+        SynStartSchedule(p_playlist, SYN_START_TIMEOUT);
+        break;
+      }
+      if(SYN_START_INITIATING == p_sys->i_syn_start) {
+        msg_Dbg(p_playlist, "no peer ready in time, starting anyway");
+        SynStartCommit(p_playlist);
+        break;
+      }
+      /* fall through */
+    case SYN_START_WAITING:
+      /* the initiator is gone, stay paused */
+      p_sys->i_syn_start = SYN_START_NONE;
+      break;
+    case SYN_START_COMMITTED:
+      if(NULL != p_in) {
+        b_play = true;
+      } else {
+        p_sys->i_syn_start = SYN_START_NONE;
+      }
+      break;
+    default:
+      break;
+  }
+  vlc_mutex_unlock(&p_sys->syn_start_lock);
+  if(NULL != p_in) {
+    /* the state callbacks come back to playlist_SynStartState() */
+    if(b_pause) {
+      SynStartPause(p_playlist, p_in, i_time);
+    }
+    if(b_play) {
+      input_Control(p_in, INPUT_SET_STATE, PLAYING_S);
+    }
+    vlc_object_release(p_in);
+  }
+}
+
+/* syn_start_lock held. A start at i_time is being prepared. */
+static void SynStartReset(playlist_t* p_playlist, int state, mtime_t i_time) {
+  playlist_private_t *p_sys = pl_priv(p_playlist);
+  p_sys->i_syn_start = state;
+  p_sys->i_syn_start_time = i_time;
+  p_sys->b_syn_start_emptied = false;
+  p_sys->b_syn_start_buffered = false;
+  p_sys->b_syn_start_peer_ready = false;
+  p_sys->b_syn_start_pause = false;
+  SynStartSchedule(p_playlist, SYN_START_TIMEOUT);
+}
+
+/* The input's state is set to state. Returns true if the change is part
+ * of a coordinated start and must not go to the peer as it is. */
+bool playlist_SynStartState(playlist_t* p_playlist, input_thread_t* p_in,
+    int state) {
+  playlist_private_t *p_sys = pl_priv(p_playlist);
+  bool b_handled = true;
+  mtime_t i_time;
+  vlc_mutex_lock(&p_sys->syn_start_lock);
+  switch(p_sys->i_syn_start) {
+    case SYN_START_NONE:
+      if(PLAYING_S == state && p_sys->b_syn_item_follow) {
+        /* we followed the peer to this item, it starts us */
+        p_sys->b_syn_item_follow = false;
+        if(p_sys->b_syn_item_prepare) {
+          p_sys->b_syn_item_prepare = false;
+          SynStartReset(p_playlist, SYN_START_PREPARING,
+              p_sys->i_syn_item_prepare_time);
+          p_sys->b_syn_start_pause = true;
+          SynStartSchedule(p_playlist, 0);
+        }
+        break;
+      }
+      if(PLAYING_S != state || !p_sys->b_syn_created ||
+          !p_sys->b_syn_can_send || !var_GetBool(p_in, "can-pause") ||
+          SynConnection_GetWireVersion(p_sys->syn_connection) <
+          SYNCOMMAND_START_VERSION) {
+        b_handled = false;
+        break;
+      }
+      input_Control(p_in, INPUT_GET_TIME, &i_time);
+      SynStartReset(p_playlist, SYN_START_INITIATING, i_time);
+      SynSendCommandNow(p_playlist, SYNCOMMAND_PREPARE, i_time);
+      /* setting the state from its own callback would deadlock, the
+       * timer pauses right away instead */
+      p_sys->b_syn_start_pause = true;
+      SynStartSchedule(p_playlist, 0);
+      break;
+    case SYN_START_COMMITTED:
+      if(PLAYING_S == state) {
+        /* our own start, the peers start now too */
+        p_sys->i_syn_start = SYN_START_NONE;
+        p_sys->t_wall_minus_video = mdate() - p_sys->i_syn_start_time;
+      }
+      break;
+    default:
+      break;
+  }
+  vlc_mutex_unlock(&p_sys->syn_start_lock);
+  return b_handled;
+}
+
+/* The input's cache level changed */
+void playlist_SynStartBuffering(playlist_t* p_playlist, input_thread_t* p_in) {
+  playlist_private_t *p_sys = pl_priv(p_playlist);
+  vlc_mutex_lock(&p_sys->syn_start_lock);
+  if(SYN_START_INITIATING == p_sys->i_syn_start ||
+      SYN_START_PREPARING == p_sys->i_syn_start) {
+    if(var_GetFloat(p_in, "cache") < 1.0) {
+      p_sys->b_syn_start_emptied = true;
+    } else if(p_sys->b_syn_start_emptied && !p_sys->b_syn_start_buffered) {
+      p_sys->b_syn_start_buffered = true;
+      if(SYN_START_PREPARING == p_sys->i_syn_start) {
+        p_sys->i_syn_start = SYN_START_WAITING;
+        SynSendCommandNow(p_playlist, SYNCOMMAND_READY,
+            p_sys->i_syn_start_time);
+      } else if(p_sys->b_syn_start_peer_ready) {
+        SynStartCommit(p_playlist);
+      }
+    }
+  }
+  vlc_mutex_unlock(&p_sys->syn_start_lock);
+}
+
+/* Position changes are ours while a start is prepared */
+bool playlist_SynStartBusy(playlist_t* p_playlist) {
+  playlist_private_t *p_sys = pl_priv(p_playlist);
+  vlc_mutex_lock(&p_sys->syn_start_lock);
+  bool b_busy = SYN_START_NONE != p_sys->i_syn_start;
+  vlc_mutex_unlock(&p_sys->syn_start_lock);
+  return b_busy;
+}
+
+void playlist_SynStartCancel(playlist_t* p_playlist) {
+  playlist_private_t *p_sys = pl_priv(p_playlist);
+  vlc_mutex_lock(&p_sys->syn_start_lock);
+  p_sys->i_syn_start = SYN_START_NONE;
+  if(p_sys->b_syn_start_timer) {
+    vlc_timer_schedule(p_sys->syn_start_timer, false, 0, 0);
+  }
+  vlc_mutex_unlock(&p_sys->syn_start_lock);
+}
+
+/* A coordinated start command from the peer, transit the time it took */
+static void SynStartReceive(playlist_t* p_playlist, input_thread_t* p_in,
+    SynCommand syn, mtime_t transit) {
+  playlist_private_t *p_sys = pl_priv(p_playlist);
+  bool b_prepare = false;
+  vlc_mutex_lock(&p_sys->syn_start_lock);
+  switch(syn.type) {
+    case SYNCOMMAND_PREPARE:
+      SynStartReset(p_playlist, SYN_START_PREPARING, syn.data.i_time);
+      p_sys->b_syn_item_follow = false;
+      b_prepare = true;
+      break;
+    case SYNCOMMAND_READY:
+      if(SYN_START_INITIATING == p_sys->i_syn_start &&
+          syn.data.i_time == p_sys->i_syn_start_time) {
+        p_sys->b_syn_start_peer_ready = true;
+        if(p_sys->b_syn_start_buffered) {
+          SynStartCommit(p_playlist);
+        }
+      }
+      break;
+    case SYNCOMMAND_START:
+      if(SYN_START_PREPARING == p_sys->i_syn_start ||
+          SYN_START_WAITING == p_sys->i_syn_start) {
+        p_sys->i_syn_start = SYN_START_COMMITTED;
+        SynStartSchedule(p_playlist, syn.data.i_time - transit);
+      }
+      break;
+    default:
+      break;
+  }
+  vlc_mutex_unlock(&p_sys->syn_start_lock);
+  if(b_prepare) {
+    SynStartPause(p_playlist, p_in, syn.data.i_time);
+  }
+}
+
+/* Move the input by delay, from current, to where the peer is */
+static void SynApply(playlist_t* p_playlist, input_thread_t* p_in,
+    mtime_t current, mtime_t delay) {
+  pl_priv(p_playlist)->t_wall_minus_video = mdate() - (current + delay);
+  var_SetInteger( p_playlist, "synchronicity", PEER_SNAP );
+  playlist_SynCorrect(p_playlist, p_in, current, delay);
+}
+
+/* The offset to a seek of the peer to i_time, sent at our date sent */
+static mtime_t SynSeekOffset(playlist_t* p_playlist, input_thread_t* p_in,
+    mtime_t i_time, mtime_t sent, mtime_t current) {
+  int playpause;
+  input_Control(p_in, INPUT_GET_STATE, &playpause);
+  switch (playpause) {
+    case PLAYING_S:
+      return i_time + (mdate() - sent) - current;
+    case PAUSE_S:
+      return i_time - current;
+    default:
+      msg_Err(p_playlist, "SynReceiveCallback: Received on no input? %d", playpause);
+      return 0;
+  }
+}
+
+/* The last seek of a storm, the window closed without another one */
+static void SynSeekTimer(void* param) {
+  playlist_t* p_playlist = (playlist_t*)param;
+  playlist_private_t *p_sys = pl_priv(p_playlist);
+  /* before the lock, PlayItem() cancels seeks with the playlist locked */
+  input_thread_t* p_in = playlist_CurrentInput(p_playlist);
+  vlc_mutex_lock(&p_sys->syn_seek_lock);
+  bool b_seek = p_sys->b_syn_seek_pending;
+  mtime_t i_time = p_sys->i_syn_seek_time;
+  mtime_t sent = p_sys->i_syn_seek_sent;
+  p_sys->b_syn_seek_pending = false;
+  vlc_mutex_unlock(&p_sys->syn_seek_lock);
+  if(NULL == p_in) {
+    return;
+  }
+  if(b_seek) {
+    mtime_t current;
+    input_Control(p_in, INPUT_GET_TIME, &current);
+    mtime_t delay = SynSeekOffset(p_playlist, p_in, i_time, sent, current);
+    if(0 != delay) {
+      SynApply(p_playlist, p_in, current, delay);
+    }
+  }
+  vlc_object_release(p_in);
+}
+
+/* A seek of the peer to i_time, transit ago. Returns false if it waits
+ * for the end of the window, superseding the one that waited so far. */
+static bool SynSeekCoalesce(playlist_t* p_playlist, mtime_t i_time,
+    mtime_t transit) {
+  playlist_private_t *p_sys = pl_priv(p_playlist);
+  mtime_t now = mdate();
+  bool b_now = true;
+  vlc_mutex_lock(&p_sys->syn_seek_lock);
+  if(now < p_sys->i_syn_seek_window) {
+    if(!p_sys->b_syn_seek_timer) {
+      if(vlc_timer_create(&p_sys->syn_seek_timer, SynSeekTimer, p_playlist)) {
+        goto out;
+      }
+      p_sys->b_syn_seek_timer = true;
+    }
+    p_sys->b_syn_seek_pending = true;
+    p_sys->i_syn_seek_time = i_time;
+    p_sys->i_syn_seek_sent = now - transit;
+    vlc_timer_schedule(p_sys->syn_seek_timer, true,
+        now + SYN_SEEK_COALESCE, 0);
+    b_now = false;
+  } else {
+    /* whatever waited is older than this one */
+    p_sys->b_syn_seek_pending = false;
+  }
+out:
+  p_sys->i_syn_seek_window = now + SYN_SEEK_COALESCE;
+  vlc_mutex_unlock(&p_sys->syn_seek_lock);
+  return b_now;
+}
+
+void playlist_SynSeekCancel(playlist_t* p_playlist) {
+  playlist_private_t *p_sys = pl_priv(p_playlist);
+  vlc_mutex_lock(&p_sys->syn_seek_lock);
+  p_sys->b_syn_seek_pending = false;
+  p_sys->i_syn_seek_window = 0;
+  if(p_sys->b_syn_seek_timer) {
+    vlc_timer_schedule(p_sys->syn_seek_timer, false, 0, 0);
+  }
+  vlc_mutex_unlock(&p_sys->syn_seek_lock);
+}
+
+/* Peers name their items by a key of the file name, which their local
+ * copies of the same content likely share even where the paths do not.
+ * Returns 0 if the item has no URI. */
+uint64_t playlist_SynItemKey(input_item_t* p_item) {
+  char *psz_uri = input_item_GetURI(p_item);
+  if(NULL == psz_uri) {
+    return 0;
+  }
+  char *psz_query = strpbrk(psz_uri, "?#");
+  if(NULL != psz_query) {
+    *psz_query = '\0';
+  }
+  const char *psz_base = strrchr(psz_uri, '/');
+  char *psz_name = decode_URI_duplicate(psz_base ? psz_base + 1 : psz_uri);
+  free(psz_uri);
+  if(NULL == psz_name) {
+    return 0;
+  }
+  /* FNV-1a */
+  uint64_t key = UINT64_C(14695981039346656037);
+  for(const char *p = psz_name; *p; p++) {
+    key = (key ^ (uint8_t)*p) * UINT64_C(1099511628211);
+  }
+  free(psz_name);
+  return key ? key : 1;
+}
+
+/* PL_LOCK held. A new item plays while the session goes on: what was
+ * going on with the last one is over, and the peer is told. */
+void playlist_SynItemChanged(playlist_t* p_playlist) {
+  playlist_private_t *p_sys = pl_priv(p_playlist);
+  playlist_SynSlewStop(p_playlist, NULL);
+  playlist_SynStartCancel(p_playlist);
+  playlist_SynSeekCancel(p_playlist);
+  p_sys->b_need_send_seek = false;
+  p_sys->t_wall_minus_video = 0;
+  if(0 != p_sys->i_syn_item_key) {
+    /* the key goes in the same bits as a time */
+    SynSendCommandNow(p_playlist, SYNCOMMAND_ITEM,
+        (int64_t)p_sys->i_syn_item_key);
+  }
+}
+
+/* The session can outlive the item, the peer follows to the next one */
+bool playlist_SynKeepsSession(playlist_t* p_playlist) {
+  playlist_private_t *p_sys = pl_priv(p_playlist);
+  return p_sys->b_syn_created &&
+    SynConnection_GetWireVersion(p_sys->syn_connection) >=
+    SYNCOMMAND_ITEM_VERSION;
+}
+
+/* The peer plays the item with key now, go there too if we have it */
+static void SynItemReceive(playlist_t* p_playlist, uint64_t key) {
+  playlist_private_t *p_sys = pl_priv(p_playlist);
+  playlist_item_t *p_found = NULL;
+  PL_LOCK;
+  p_sys->i_syn_peer_key = key;
+  if(key != p_sys->i_syn_item_key) {
+    playlist_item_t *p_item;
+    FOREACH_ARRAY( p_item, p_playlist->items )
+      if(p_item->i_children == -1 &&
+          playlist_SynItemKey(p_item->p_input) == key) {
+        p_found = p_item;
+        break;
+      }
+    FOREACH_END();
+    vlc_mutex_lock(&p_sys->syn_start_lock);
+    p_sys->b_syn_item_follow = NULL != p_found;
+    p_sys->b_syn_item_prepare = false;
+    vlc_mutex_unlock(&p_sys->syn_start_lock);
+    if(NULL != p_found) {
+      playlist_Control(p_playlist, PLAYLIST_VIEWPLAY, pl_Locked, NULL,
+          p_found);
+    } else {
+      msg_Warn(p_playlist, "the peer plays an item we do not have");
+    }
+  }
+  PL_UNLOCK;
+}
+
+/* Whether a command of the peer is about the item we play. One about
+ * another item is dropped, but a start prepared for the one we are
+ * going to is kept until we are there. */
+static bool SynItemMatches(playlist_t* p_playlist, SynCommand syn) {
+  playlist_private_t *p_sys = pl_priv(p_playlist);
+  PL_LOCK;
+  bool b_match = 0 == p_sys->i_syn_peer_key ||
+    p_sys->i_syn_peer_key == p_sys->i_syn_item_key;
+  PL_UNLOCK;
+  if(!b_match && SYNCOMMAND_PREPARE == syn.type) {
+    vlc_mutex_lock(&p_sys->syn_start_lock);
+    if(p_sys->b_syn_item_follow) {
+      p_sys->b_syn_item_prepare = true;
+      p_sys->i_syn_item_prepare_time = syn.data.i_time;
+    }
+    vlc_mutex_unlock(&p_sys->syn_start_lock);
+  }
+  return b_match;
+}
 
 static void SynBreakConnection(playlist_t* p_playlist) {
   if(pl_priv(p_playlist)->b_syn_created) {
@@ -60,9 +626,40 @@ static void SynReceiveCallback(int rv, mtime_t delay, void* param, void* buffer,
     return;
   }
 
+  SynCommand syn = CommandFromString(buffer, len);
+  if (SYNCOMMAND_ITEM == syn.type) {
+    SynItemReceive(p_playlist, (uint64_t)syn.data.i_int);
+    pl_priv(p_playlist)->b_syn_can_send = true;
+    return;
+  }
+  if (SYNCOMMAND_MYNAMEIS != syn.type && !SynItemMatches(p_playlist, syn)) {
+    pl_priv(p_playlist)->b_syn_can_send = true;
+    return;
+  }
+
   input_thread_t* p_in = playlist_CurrentInput(p_playlist);
   if (NULL != p_in) {
-    SynCommand syn = CommandFromString(buffer, len);
+    if (SYNCOMMAND_PREPARE == syn.type || SYNCOMMAND_READY == syn.type ||
+        SYNCOMMAND_START == syn.type) {
+      SynStartReceive(p_playlist, p_in, syn, delay);
+      vlc_object_release(p_in);
+      pl_priv(p_playlist)->b_syn_can_send = true;
+      return;
+    }
+    if (SYNCOMMAND_MYNAMEIS != syn.type && SYNCOMMAND_ERROR != syn.type) {
+      // the peer moved on, whatever start was prepared is off
+      playlist_SynStartCancel(p_playlist);
+    }
+    if (SYNCOMMAND_PLAY == syn.type || SYNCOMMAND_PAUSE == syn.type) {
+      // a seek still waiting is older than this
+      playlist_SynSeekCancel(p_playlist);
+    }
+    if (SYNCOMMAND_SEEK == syn.type &&
+        !SynSeekCoalesce(p_playlist, syn.data.i_time, delay)) {
+      vlc_object_release(p_in);
+      pl_priv(p_playlist)->b_syn_can_send = true;
+      return;
+    }
     mtime_t current;
     input_Control(p_in, INPUT_GET_TIME, &current);
     switch(syn.type) {
@@ -75,23 +672,8 @@ static void SynReceiveCallback(int rv, mtime_t delay, void* param, void* buffer,
         delay = syn.data.i_time - current;
         break;
       case SYNCOMMAND_SEEK:
-        {
-          int playpause;
-          input_Control(p_in, INPUT_GET_STATE, &playpause);
-
-          switch (playpause) {
-            case PLAYING_S:
-              delay = syn.data.i_time + delay - current;
-              break;
-            case PAUSE_S:
-              delay = syn.data.i_time - current;
-              break;
-            default:
-              msg_Err(p_playlist, "SynReceiveCallback: Received on no input? %d", playpause);
-              delay = 0;
-              break;
-          }
-        }
+        delay = SynSeekOffset(p_playlist, p_in, syn.data.i_time,
+            mdate() - delay, current);
         break;
       case SYNCOMMAND_MYNAMEIS:
         {
@@ -106,13 +688,10 @@ static void SynReceiveCallback(int rv, mtime_t delay, void* param, void* buffer,
         break;
     }
     if (0 != delay && SYNCOMMAND_MYNAMEIS != syn.type) {
-      pl_priv(p_playlist)->t_wall_minus_video = mdate() - (current + delay);
-      var_SetInteger( p_playlist, "synchronicity", PEER_SNAP );
-      input_Control(p_in, INPUT_SET_TIME, current + delay);
+      SynApply(p_playlist, p_in, current, delay);
     }
     vlc_object_release(p_in);
   } else { // move outside?
-    SynCommand syn = CommandFromString(buffer, len);
     if (SYNCOMMAND_MYNAMEIS == syn.type)
     {
       char *username = syn.message;
@@ -123,11 +702,6 @@ static void SynReceiveCallback(int rv, mtime_t delay, void* param, void* buffer,
   pl_priv(p_playlist)->b_syn_can_send = true;
 }
 
-static void SynFreeMemory(int rv, void* param) {
-  VLC_UNUSED(rv);
-  free(param);
-}
-
 static int SendSynCommand(playlist_t* p_playlist, SynCommand syn) {
   playlist_private_t *p_sys = pl_priv(p_playlist);
   if(SYNCOMMAND_MYNAMEIS != syn.type) {
@@ -136,13 +710,14 @@ static int SendSynCommand(playlist_t* p_playlist, SynCommand syn) {
   if(!p_sys->b_syn_can_send) {
     return VLC_SUCCESS;
   }
-  char* buffer = calloc(sizeof(char), 80);
-  int numbytes = StringFromCommand(syn, buffer, 80);
+  char buffer[80];
+  int numbytes = SynCommand_Encode(syn, buffer, sizeof(buffer),
+      SynConnection_GetWireVersion(p_sys->syn_connection));
   if (numbytes > 0) {
     return SynConnection_Send(
         p_sys->syn_connection,
         buffer, numbytes,
-        &SynFreeMemory, buffer);
+        NULL, NULL);
   }
   return VLC_EGENERIC;
 }
@@ -184,6 +759,9 @@ void playlist_SynConnect(playlist_t * p_playlist, const char* addr) {
       var_SetInteger( p_playlist, "synchronicity", CONNECTION_FAILURE );
     } else {
       p_sys->b_syn_created = true;
+      p_sys->b_syn_host = false;
+      p_sys->i_syn_seeks = p_sys->i_syn_slews = 0;
+      p_sys->i_syn_peer_key = 0;
     }
   }
 }
@@ -264,7 +842,10 @@ static void SynClientConnectedCallback(int rv, void* param) {
 
 void playlist_SynHost(playlist_t * p_playlist) {
   if(!pl_priv(p_playlist)->b_syn_created) {
-    int rv = SynConnection_InitializeAsServer(
+    // a party takes any number of clients on the same key
+    bool party = var_InheritBool(p_playlist, "synchronicity-party");
+    int rv = (party ? SynConnection_InitializeAsPartyHost :
+        SynConnection_InitializeAsServer)(
         (vlc_object_t*)p_playlist,
         &pl_priv(p_playlist)->syn_connection,
         pl_priv(p_playlist)->psz_syn_server_host,
@@ -276,6 +857,9 @@ void playlist_SynHost(playlist_t * p_playlist) {
       var_SetInteger( p_playlist, "synchronicity", CONNECTION_FAILURE );
     } else {
       pl_priv(p_playlist)->b_syn_created = true;
+      pl_priv(p_playlist)->b_syn_host = true;
+      pl_priv(p_playlist)->i_syn_seeks = pl_priv(p_playlist)->i_syn_slews = 0;
+      pl_priv(p_playlist)->i_syn_peer_key = 0;
     }
     //success, set synchronicity variable
   }
@@ -298,3 +882,24 @@ void playlist_SynGetHostAddr(playlist_t * p_playlist, char* addr, size_t len) {
     }
   }
 }
+
+/* Key our media streams on, only while we host a viewing. Returns 0 if
+ * addr holds it. */
+int playlist_SynGetStreamKey(playlist_t * p_playlist, char* addr, size_t len) {
+  playlist_private_t *p_sys = pl_priv(p_playlist);
+  if(!p_sys->b_syn_created || !p_sys->b_syn_host) {
+    return -1;
+  }
+  return SynConnection_GetAddr(p_sys->syn_connection, addr, len);
+}
+
+/* Local minus peer clock, for followers of the host's stream. Returns 0
+ * once the clocks were synced. */
+int playlist_SynGetClockOffset(playlist_t * p_playlist, mtime_t* offset) {
+  playlist_private_t *p_sys = pl_priv(p_playlist);
+  mtime_t error;
+  if(!p_sys->b_syn_created) {
+    return -1;
+  }
+  return SynConnection_GetClockOffset(p_sys->syn_connection, offset, &error);
+}
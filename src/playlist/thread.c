@@ -293,11 +293,6 @@ static int PositionListener( vlc_object_t *p_this, const char *psz_var,
  * Synchronicity callback functions
  ****************************************/
 
-static void SynFreeMemory(int rv, void* param) {
-  VLC_UNUSED(rv);
-  free(param);
-}
-
 static int SendSynCommand(playlist_t* p_playlist, SynCommand syn) {
   playlist_private_t *p_sys = pl_priv(p_playlist);
   if(SYNCOMMAND_MYNAMEIS != syn.type) {
@@ -306,14 +301,15 @@ static int SendSynCommand(playlist_t* p_playlist, SynCommand syn) {
   if(!p_sys->b_syn_can_send) {
     return VLC_SUCCESS;
   }
-  char* buffer = calloc(sizeof(char), 80);
+  char buffer[80];
   int numbytes;
-  numbytes = StringFromCommand(syn, buffer, 80);
+  numbytes = SynCommand_Encode(syn, buffer, sizeof(buffer),
+      SynConnection_GetWireVersion(p_sys->syn_connection));
   if (numbytes > 0) {
     SynConnection_Send(
         p_sys->syn_connection,
         buffer, numbytes,
-        &SynFreeMemory, buffer);
+        NULL, NULL);
     return VLC_SUCCESS;
   }
   msg_Info(p_playlist, "SendSynCommand: Error");
@@ -323,10 +319,13 @@ static int SendSynCommand(playlist_t* p_playlist, SynCommand syn) {
 static int SynStateListener( vlc_object_t *p_this, const char *psz_var,
                            vlc_value_t oldval, vlc_value_t newval,
                            void *param ) {
-  VLC_UNUSED(p_this);
   VLC_UNUSED(psz_var);
   VLC_UNUSED(oldval);
 
+  if(playlist_SynStartState((playlist_t*)param, (input_thread_t*)p_this,
+        newval.i_int)) {
+    return VLC_SUCCESS;
+  }
   SynCommand syn;
   switch (newval.i_int) {
     case PLAYING_S:
@@ -346,6 +345,10 @@ static int SynEventListener( vlc_object_t *p_this, const char *psz_var,
                            vlc_value_t oldval, vlc_value_t newval,
                            void *param ) {
   playlist_private_t* p_playlist = pl_priv((playlist_t*)param);
+  if(INPUT_EVENT_CACHE == newval.i_int) {
+    playlist_SynStartBuffering((playlist_t*)param, (input_thread_t*)p_this);
+    return VLC_SUCCESS;
+  }
   if(!p_playlist->b_syn_can_send) {
     return VLC_SUCCESS;
   }
@@ -356,19 +359,23 @@ static int SynEventListener( vlc_object_t *p_this, const char *psz_var,
     input_Control((input_thread_t*)p_this, INPUT_GET_TIME, &current_time);
     mtime_t current_difference = current_wall - current_time;
 
-    if(p_playlist->b_need_send_seek) {
+    if(p_playlist->b_need_send_seek &&
+        current_wall - p_playlist->i_syn_seek_changed >= SYN_SEEK_COALESCE) {
+      // the user stopped scrubbing, only where they ended up goes out
       p_playlist->b_need_send_seek = false;
+      SynConnection_Resync(p_playlist->syn_connection);
       SynCommand syn;
       syn.type = SYNCOMMAND_SEEK;
       syn.data.i_time = current_time;
       return SendSynCommand((playlist_t*)param, syn);
-    } else {
+    } else if(!p_playlist->b_need_send_seek) {
       // immediately after a position change, the difference is totally messed up, so
       // this is in the else block
       int playpause;
       input_Control((input_thread_t*)p_this, INPUT_GET_STATE, &playpause);
       if(p_playlist->t_wall_minus_video
         && !p_playlist->b_correcting
+        && !p_playlist->b_syn_slewing
         && PLAYING_S == playpause
         //&& current_wall - p_playlist->t_last_correction_time > 200000
         ) {
@@ -379,8 +386,8 @@ static int SynEventListener( vlc_object_t *p_this, const char *psz_var,
           p_playlist->last_diff_diff = (4 * diff_diff + p_playlist->last_diff_diff) / 5;
 
           p_playlist->b_correcting = true;
-          input_Control((input_thread_t*)p_this, INPUT_SET_TIME, current_time +
-              p_playlist->last_diff_diff);
+          playlist_SynCorrect((playlist_t*)param, (input_thread_t*)p_this,
+              current_time, p_playlist->last_diff_diff);
           p_playlist->b_correcting = false;
         }
       }
@@ -396,6 +403,11 @@ static int SynPositionListener( vlc_object_t *p_this, const char *psz_var,
   VLC_UNUSED(psz_var);
   VLC_UNUSED(oldval);
 
+  // the seek of a coordinated start is not the user's
+  if(playlist_SynStartBusy((playlist_t*)param)) {
+    return VLC_SUCCESS;
+  }
+  pl_priv((playlist_t*)param)->i_syn_seek_changed = mdate();
   pl_priv((playlist_t*)param)->b_need_send_seek = true;
   return VLC_SUCCESS;
 }
@@ -441,14 +453,21 @@ static int PlayItem( playlist_t *p_playlist, playlist_item_t *p_item )
         //var_AddCallback( p_input_thread, "position", PositionListener, p_input_thread );
 
 
+        p_sys->i_syn_item_key = playlist_SynItemKey( p_input );
         if(p_sys->b_syn_created && var_GetBool( p_playlist, "repeat" ) /* loop one */) {
           // continuing a loop single video while connected
           p_sys->b_need_send_seek = true;
+        } else if(p_sys->b_syn_created) {
+          // the session goes on, the peer follows us to this item
+          playlist_SynItemChanged( p_playlist );
         } else {
           //set synchronicity variable to enable gui
           var_SetInteger( p_playlist, "synchronicity", ITEM_PLAYING);
 
           // Re-initialize synchronicity variables on every playlist item
+          playlist_SynSlewStop( p_playlist, NULL );
+          playlist_SynStartCancel( p_playlist );
+          playlist_SynSeekCancel( p_playlist );
           p_sys->b_syn_can_send = false;
           p_sys->b_syn_created = false;
           p_sys->b_need_send_seek = false;
@@ -708,17 +727,18 @@ static int LoopInput( playlist_t *p_playlist )
         var_DelCallback( p_input, "intf-event", SynEventListener, p_playlist );
         //var_DelCallback( p_input, "position", PositionListener, p_input );
 
-        // Disconnect when ends
+        // Disconnect when stopped, the next item keeps the session if
+        // the peer can follow us there
         bool b_repeat = var_GetBool( p_playlist, "repeat" ) /* loop one */;
-        if(p_sys->b_syn_created && (
-            PLAYLIST_STOPPED == p_sys->request.i_status ||
-            !b_repeat)) {
+        bool b_keep = p_sys->b_syn_created &&
+            PLAYLIST_STOPPED != p_sys->request.i_status &&
+            (b_repeat || playlist_SynKeepsSession( p_playlist ));
+        if(p_sys->b_syn_created && !b_keep) {
           var_SetInteger( p_playlist, "synchronicity", PEER_DISCONNECT);
           SynConnection_Destroy(p_sys->syn_connection, NULL, NULL);
           p_sys->b_syn_created = false;
         }
-        if(PLAYLIST_STOPPED == p_sys->request.i_status ||
-          !p_sys->b_syn_created || !b_repeat) {
+        if(!b_keep) {
           //set synchronicity variable to disable GUI
           var_SetInteger( p_playlist, "synchronicity", ITEM_STOPPED);
         }
@@ -799,6 +819,15 @@ static void LoopRequest( playlist_t *p_playlist )
     msg_Dbg( p_playlist, "nothing to play" );
     p_sys->status.i_status = PLAYLIST_STOPPED;
 
+    if( p_sys->b_syn_created )
+    {
+        /* the session outlived the last item */
+        PL_UNLOCK;
+        playlist_SynDisconnect( p_playlist );
+        var_SetInteger( p_playlist, "synchronicity", ITEM_STOPPED );
+        PL_LOCK;
+    }
+
     if( var_GetBool( p_playlist, "play-and-exit" ) )
     {
         msg_Info( p_playlist, "end of playlist, exiting" );
@@ -78,6 +78,7 @@ playlist_item_t * playlist_NodeCreate( playlist_t *p_playlist,
     p_item->i_children = 0;
 
     ARRAY_APPEND(p_playlist->all_items, p_item);
+    playlist_ItemMapAdd( p_playlist, p_item );
 
     if( p_parent != NULL )
         playlist_NodeInsert( p_playlist, p_item, p_parent,
@@ -155,10 +156,15 @@ int playlist_NodeDelete( playlist_t *p_playlist, playlist_item_t *p_root,
     pl_priv(p_playlist)->b_reset_currently_playing = true;
 
     int i;
+    playlist_RecordChange( p_playlist, PLAYLIST_CHANGE_DELETED,
+                           p_root->i_id, -1, 0 );
     var_SetInteger( p_playlist, "playlist-item-deleted", p_root->i_id );
     ARRAY_BSEARCH( p_playlist->all_items, ->i_id, int, p_root->i_id, i );
     if( i != -1 )
+    {
         ARRAY_REMOVE( p_playlist->all_items, i );
+        playlist_ItemMapRemove( p_playlist, p_root );
+    }
 
     if( p_root->i_children == -1 ) {
         ARRAY_BSEARCH( p_playlist->items,->i_id, int, p_root->i_id, i );
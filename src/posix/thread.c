@@ -986,63 +986,187 @@ void msleep (mtime_t delay)
 }
 
 
+/*
+ * Timers share a small pool of threads instead of owning one each: a single
+ * thread sleeps until the earliest deadline of all armed timers. Another one
+ * is started only while a callback is running and other timers are armed,
+ * so that a slow callback does not delay unrelated timers. Threads in excess
+ * leave after some idle time, and all of them once no timers exist.
+ */
+#define TIMER_THREADS_MAX   8
+#define TIMER_IDLE_TIMEOUT  (5 * CLOCK_FREQ)
+/* Interval timers may fire up to 1/TIMER_SLACK_RATIO of their interval
+ * early, within TIMER_SLACK_MAX, to be coalesced with an earlier timer. */
+#define TIMER_SLACK_RATIO   32
+#define TIMER_SLACK_MAX     (CLOCK_FREQ / 20)
+
 struct vlc_timer
 {
-    vlc_thread_t thread;
-    vlc_cond_t   reschedule;
-    vlc_mutex_t  lock;
+    struct vlc_timer *next;     /* next armed timer, by deadline */
     void       (*func) (void *);
     void        *data;
     mtime_t      value, interval;
+    bool         armed;
+    bool         running;
     vlc_atomic_t overruns;
 };
 
-VLC_NORETURN
-static void *vlc_timer_thread (void *data)
+static struct
+{
+    vlc_mutex_t       lock;
+    vlc_cond_t        wait;     /* armed timers changed, or timer exited */
+    bool              init;
+    struct vlc_timer *armed;    /* sorted by deadline */
+    unsigned          count;    /* existing timers */
+    unsigned          threads;
+    unsigned          busy;     /* threads running a callback */
+} timers = { .lock = VLC_STATIC_MUTEX, };
+
+static void vlc_timer_thread_start (void);
+
+/* Starts a thread if all are busy with callbacks while other timers are armed.
+ * Must be called with timers.lock */
+static void vlc_timer_thread_check (void)
+{
+    if (timers.busy >= timers.threads && timers.armed != NULL
+     && timers.threads < TIMER_THREADS_MAX)
+        vlc_timer_thread_start ();
+}
+
+static mtime_t vlc_timer_slack (const struct vlc_timer *timer)
+{
+    return __MIN(timer->interval / TIMER_SLACK_RATIO, TIMER_SLACK_MAX);
+}
+
+/* Must be called with timers.lock */
+static void vlc_timer_insert (struct vlc_timer *timer)
 {
-    struct vlc_timer *timer = data;
+    struct vlc_timer **pp = &timers.armed;
 
-    vlc_mutex_lock (&timer->lock);
-    mutex_cleanup_push (&timer->lock);
+    while (*pp != NULL && (*pp)->value <= timer->value)
+        pp = &(*pp)->next;
+    timer->next = *pp;
+    *pp = timer;
+    timer->armed = true;
+}
 
+/* Must be called with timers.lock */
+static void vlc_timer_remove (struct vlc_timer *timer)
+{
+    if (!timer->armed)
+        return;
+
+    for (struct vlc_timer **pp = &timers.armed; *pp != NULL;
+         pp = &(*pp)->next)
+        if (*pp == timer)
+        {
+            *pp = timer->next;
+            break;
+        }
+    timer->armed = false;
+}
+
+/* Returns the first timer to fire at now, or NULL. Must be called with
+ * timers.lock */
+static struct vlc_timer *vlc_timer_due (mtime_t now)
+{
+    for (struct vlc_timer *timer = timers.armed; timer != NULL;
+         timer = timer->next)
+    {
+        if (timer->value > now + TIMER_SLACK_MAX)
+            break; /* no further timers may be due */
+        if (!timer->running && timer->value <= now + vlc_timer_slack (timer))
+            return timer;
+    }
+    return NULL;
+}
+
+static void *vlc_timer_thread (void *data)
+{
+    mtime_t idle_since = mdate ();
+
+    (void) data;
+    vlc_mutex_lock (&timers.lock);
     for (;;)
     {
-        while (timer->value == 0)
-            vlc_cond_wait (&timer->reschedule, &timer->lock);
+        if (timers.count == 0)
+            break;
 
-        if (vlc_cond_timedwait (&timer->reschedule, &timer->lock,
-                                timer->value) == 0)
+        mtime_t now = mdate ();
+        struct vlc_timer *timer = vlc_timer_due (now);
+
+        if (timer == NULL)
+        {
+            /* Wait for the earliest timer not already running */
+            bool excess = timers.threads > 1;
+            mtime_t deadline = excess ? idle_since + TIMER_IDLE_TIMEOUT
+                                      : INT64_MAX;
+
+            if (excess && now >= deadline)
+                break;
+
+            for (struct vlc_timer *t = timers.armed; t != NULL; t = t->next)
+                if (!t->running)
+                {
+                    if (t->value < deadline)
+                        deadline = t->value;
+                    break;
+                }
+
+            if (deadline == INT64_MAX)
+                vlc_cond_wait (&timers.wait, &timers.lock);
+            else
+                vlc_cond_timedwait (&timers.wait, &timers.lock, deadline);
             continue;
+        }
+
+        /* Let another thread wait for the other timers meanwhile */
+        vlc_timer_remove (timer);
+        timer->running = true;
+        timers.busy++;
+        vlc_timer_thread_check ();
         if (timer->interval == 0)
             timer->value = 0; /* disarm */
-        vlc_mutex_unlock (&timer->lock);
+        vlc_mutex_unlock (&timers.lock);
 
-        int canc = vlc_savecancel ();
         timer->func (timer->data);
-        vlc_restorecancel (canc);
-
-        mtime_t now = mdate ();
-        unsigned misses;
-
-        vlc_mutex_lock (&timer->lock);
-        if (timer->interval == 0)
-            continue;
 
-        misses = (now - timer->value) / timer->interval;
-        timer->value += timer->interval;
-        /* Try to compensate for one miss (mwait() will return immediately)
-         * but no more. Otherwise, we might busy loop, after extended periods
-         * without scheduling (suspend, SIGSTOP, RT preemption, ...). */
-        if (misses > 1)
+        now = mdate ();
+        vlc_mutex_lock (&timers.lock);
+        timer->running = false;
+        timers.busy--;
+        if (timer->value != 0 && timer->interval != 0 && !timer->armed)
         {
-            misses--;
-            timer->value += misses * timer->interval;
-            vlc_atomic_add (&timer->overruns, misses);
+            unsigned misses = (now - timer->value) / timer->interval;
+
+            timer->value += timer->interval;
+            /* Try to compensate for one miss (the timer will fire right away)
+             * but no more. Otherwise, we might busy loop, after extended
+             * periods without scheduling (suspend, SIGSTOP, RT preemption,
+             * ...). */
+            if (misses > 1)
+            {
+                misses--;
+                timer->value += misses * timer->interval;
+                vlc_atomic_add (&timer->overruns, misses);
+            }
+            vlc_timer_insert (timer);
         }
+        vlc_cond_broadcast (&timers.wait);
+        idle_since = now;
     }
+    timers.threads--;
+    vlc_cond_broadcast (&timers.wait);
+    vlc_mutex_unlock (&timers.lock);
+    return NULL;
+}
 
-    vlc_cleanup_pop ();
-    assert (0);
+/* Must be called with timers.lock */
+static void vlc_timer_thread_start (void)
+{
+    if (vlc_clone_detach (NULL, vlc_timer_thread, NULL,
+                          VLC_THREAD_PRIORITY_INPUT) == 0)
+        timers.threads++;
 }
 
 /**
@@ -1062,23 +1186,33 @@ int vlc_timer_create (vlc_timer_t *id, void (*func) (void *), void *data)
 
     if (unlikely(timer == NULL))
         return ENOMEM;
-    vlc_mutex_init (&timer->lock);
-    vlc_cond_init (&timer->reschedule);
     assert (func);
     timer->func = func;
     timer->data = data;
     timer->value = 0;
     timer->interval = 0;
+    timer->armed = false;
+    timer->running = false;
     vlc_atomic_set(&timer->overruns, 0);
 
-    if (vlc_clone (&timer->thread, vlc_timer_thread, timer,
-                   VLC_THREAD_PRIORITY_INPUT))
+    vlc_mutex_lock (&timers.lock);
+    if (!timers.init)
+    {   /* not statically initialized, to use the monotonic clock */
+        vlc_cond_init (&timers.wait);
+        timers.init = true;
+    }
+    if (timers.threads == 0)
     {
-        vlc_cond_destroy (&timer->reschedule);
-        vlc_mutex_destroy (&timer->lock);
-        free (timer);
-        return ENOMEM;
+        vlc_timer_thread_start ();
+        if (timers.threads == 0)
+        {
+            vlc_mutex_unlock (&timers.lock);
+            free (timer);
+            return ENOMEM;
+        }
     }
+    timers.count++;
+    vlc_mutex_unlock (&timers.lock);
 
     *id = timer;
     return 0;
@@ -1095,10 +1229,14 @@ int vlc_timer_create (vlc_timer_t *id, void (*func) (void *), void *data)
  */
 void vlc_timer_destroy (vlc_timer_t timer)
 {
-    vlc_cancel (timer->thread);
-    vlc_join (timer->thread, NULL);
-    vlc_cond_destroy (&timer->reschedule);
-    vlc_mutex_destroy (&timer->lock);
+    vlc_mutex_lock (&timers.lock);
+    vlc_timer_remove (timer);
+    timer->value = 0;
+    while (timer->running)
+        vlc_cond_wait (&timers.wait, &timers.lock);
+    timers.count--;
+    vlc_cond_broadcast (&timers.wait);
+    vlc_mutex_unlock (&timers.lock);
     free (timer);
 }
 
@@ -1110,6 +1248,8 @@ void vlc_timer_destroy (vlc_timer_t timer)
  * limitations. An interval timer can fail to trigger sometimes, either because
  * the system is busy or suspended, or because a previous iteration of the
  * timer is still running. See also vlc_timer_getoverrun().
+ * An interval timer can also fire slightly early, by at most 1/32 of its
+ * interval, so as to share wake-ups with other timers.
  *
  * @param timer initialized timer
  * @param absolute the timer value origin is the same as mdate() if true,
@@ -1125,11 +1265,17 @@ void vlc_timer_schedule (vlc_timer_t timer, bool absolute,
     if (!absolute && value != 0)
         value += mdate();
 
-    vlc_mutex_lock (&timer->lock);
+    vlc_mutex_lock (&timers.lock);
+    vlc_timer_remove (timer);
     timer->value = value;
     timer->interval = interval;
-    vlc_cond_signal (&timer->reschedule);
-    vlc_mutex_unlock (&timer->lock);
+    if (value != 0)
+    {
+        vlc_timer_insert (timer);
+        vlc_timer_thread_check ();
+    }
+    vlc_cond_broadcast (&timers.wait);
+    vlc_mutex_unlock (&timers.lock);
 }
 
 /**
@@ -1187,3 +1333,116 @@ unsigned vlc_GetCPUCount(void)
     return 1;
 #endif
 }
+
+#if defined (__linux__) && defined (HAVE_SCHED_GETAFFINITY)
+# include <sys/syscall.h>
+# ifndef MPOL_DEFAULT
+#  define MPOL_DEFAULT   0
+#  define MPOL_PREFERRED 1
+# endif
+# define NUMA_NODE_PATH "/sys/devices/system/node/node%u"
+
+/**
+ * Counts NUMA nodes.
+ * @return number of memory nodes, 0 if unknown (i.e. not a NUMA system).
+ */
+unsigned vlc_numa_GetNodeCount (void)
+{
+    char path[sizeof (NUMA_NODE_PATH) + 10];
+    unsigned count = 0;
+
+    for (;;)
+    {
+        snprintf (path, sizeof (path), NUMA_NODE_PATH, count);
+        if (access (path, F_OK))
+            return count;
+        count++;
+    }
+}
+
+/* Parses a sysfs CPU list, e.g. "0-7,16-23" */
+static int vlc_numa_GetNodeCPUs (unsigned node, cpu_set_t *set)
+{
+    char path[sizeof (NUMA_NODE_PATH "/cpulist") + 10];
+    char line[1024];
+
+    snprintf (path, sizeof (path), NUMA_NODE_PATH"/cpulist", node);
+    FILE *stream = fopen (path, "re");
+    if (stream == NULL)
+        return errno;
+
+    bool ok = fgets (line, sizeof (line), stream) != NULL;
+    fclose (stream);
+    if (!ok)
+        return EIO;
+
+    CPU_ZERO (set);
+    for (char *p = line, *end; *p != '\0' && *p != '\n'; p = end)
+    {
+        unsigned long first = strtoul (p, &end, 10), last = first;
+
+        if (end == p)
+            return EINVAL;
+        if (*end == '-')
+            last = strtoul (end + 1, &end, 10);
+        for (unsigned long cpu = first; cpu <= last && cpu < CPU_SETSIZE;
+             cpu++)
+            CPU_SET (cpu, set);
+        if (*end == ',')
+            end++;
+    }
+    return CPU_COUNT (set) ? 0 : ENOENT;
+}
+
+/**
+ * Binds the calling thread to the CPUs and memory of a NUMA node.
+ * The threads it creates afterwards inherit the binding: binding the input
+ * thread keeps the demux, decoders, outputs and stream output of the input
+ * on one node. Memory first touched by these threads is then allocated
+ * from the node; other allocations preferably are.
+ *
+ * @param node node number, or -1 to undo the binding
+ * @return 0 on success, an error code otherwise.
+ */
+int vlc_numa_Bind (int node)
+{
+    cpu_set_t set;
+    unsigned long mask = 0;
+    int mode = MPOL_DEFAULT;
+
+    if (node >= 0)
+    {
+        if ((unsigned)node >= 8 * sizeof (mask))
+            return EINVAL;
+
+        int val = vlc_numa_GetNodeCPUs (node, &set);
+        if (val)
+            return val;
+        mask = 1UL << node;
+        mode = MPOL_PREFERRED;
+    }
+    else
+    {   /* all CPUs the process may run on */
+        if (sched_getaffinity (getpid (), sizeof (set), &set))
+            return errno;
+    }
+
+    if (sched_setaffinity (0 /* calling thread */, sizeof (set), &set))
+        return errno;
+    /* Best effort: the kernel may lack NUMA support */
+    syscall (SYS_set_mempolicy, mode, (node >= 0) ? &mask : NULL,
+             (node >= 0) ? 8 * sizeof (mask) : 0);
+    return 0;
+}
+#else
+unsigned vlc_numa_GetNodeCount (void)
+{
+    return 0;
+}
+
+int vlc_numa_Bind (int node)
+{
+    (void) node;
+    return ENOSYS;
+}
+#endif
@@ -0,0 +1,103 @@
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <synchronicity/syn_clock.h>
+
+#include <math.h>
+
+void syn_clock_init(SynClock* clock) {
+  memset(clock, 0, sizeof(*clock));
+}
+
+// Samples of the window, shortest round trip first
+static int syn_clock_sorted(const SynClock* clock,
+    const SynClockSample** sorted) {
+  for(int i = 0; i < clock->count; ++i) {
+    const SynClockSample* sample = &clock->samples[i];
+    int j = i;
+    for(; j > 0 && sorted[j - 1]->rtt > sample->rtt; --j) {
+      sorted[j] = sorted[j - 1];
+    }
+    sorted[j] = sample;
+  }
+  return clock->count;
+}
+
+static void syn_clock_update(SynClock* clock, mtime_t now) {
+  const SynClockSample* sorted[SYN_CLOCK_SAMPLES];
+  int count = syn_clock_sorted(clock, sorted);
+
+  // best quarter, but enough for a fit once there are that many
+  int keep = count / 4;
+  if(keep < SYN_CLOCK_MIN_FIT) {
+    keep = count < SYN_CLOCK_MIN_FIT ? count : SYN_CLOCK_MIN_FIT;
+  }
+
+  // least squares, x relative to now keeps the numbers small
+  double sum_x = 0, sum_y = 0;
+  mtime_t first = now, last = 0;
+  for(int i = 0; i < keep; ++i) {
+    sum_x += sorted[i]->local - now;
+    sum_y += sorted[i]->offset;
+    first = __MIN(first, sorted[i]->local);
+    last = __MAX(last, sorted[i]->local);
+  }
+  double mean_x = sum_x / keep, mean_y = sum_y / keep;
+  double drift = 0;
+  if(keep >= SYN_CLOCK_MIN_FIT && last - first >= SYN_CLOCK_MIN_SPAN) {
+    double sxx = 0, sxy = 0;
+    for(int i = 0; i < keep; ++i) {
+      double x = sorted[i]->local - now - mean_x;
+      sxx += x * x;
+      sxy += x * (sorted[i]->offset - mean_y);
+    }
+    drift = sxy / sxx;
+    if(drift > SYN_CLOCK_MAX_DRIFT) {
+      drift = SYN_CLOCK_MAX_DRIFT;
+    } else if(drift < -SYN_CLOCK_MAX_DRIFT) {
+      drift = -SYN_CLOCK_MAX_DRIFT;
+    }
+  }
+  double offset = mean_y - drift * mean_x;
+
+  double residuals = 0;
+  for(int i = 0; i < keep; ++i) {
+    double r = sorted[i]->offset - (offset + drift * (sorted[i]->local - now));
+    residuals += r * r;
+  }
+
+  clock->reference = now;
+  clock->offset = (mtime_t)llround(offset);
+  clock->drift = drift;
+  clock->jitter = (mtime_t)llround(sqrt(residuals / keep));
+  clock->min_rtt = sorted[0]->rtt;
+}
+
+void syn_clock_add(SynClock* clock, mtime_t local, mtime_t offset,
+    mtime_t rtt) {
+  if(rtt < 0) {
+    return;  // not a round trip we sent
+  }
+  SynClockSample* sample = &clock->samples[clock->next];
+  sample->local = local;
+  sample->offset = offset;
+  sample->rtt = rtt;
+  clock->next = (clock->next + 1) % SYN_CLOCK_SAMPLES;
+  if(clock->count < SYN_CLOCK_SAMPLES) {
+    clock->count++;
+  }
+  syn_clock_update(clock, local);
+}
+
+mtime_t syn_clock_offset(const SynClock* clock, mtime_t local) {
+  if(0 == clock->count) {
+    return 0;
+  }
+  return clock->offset +
+    (mtime_t)llround(clock->drift * (local - clock->reference));
+}
+
+mtime_t syn_clock_error(const SynClock* clock) {
+  return clock->min_rtt / 2 + clock->jitter;
+}
@@ -2,6 +2,9 @@
 #include "synchronicity/syn_connection_internal.h"
 #include "synchronicity/syn_key_internal.h"
 #include "synchronicity/syn_connection_establishment.h"
+#include "synchronicity/syn_reactor.h"
+#include "synchronicity/syn_party.h"
+#include "synchronicity/syn_udp.h"
 
 #include <vlc_threads.h>
 #include <vlc_network.h>
@@ -9,7 +12,83 @@
 #include <assert.h>
 #include "libvlc.h"
 
-static SynConnectionInternal syn_ci_[MAX_CONNECTIONS];
+// Connection table. Slots are handed out from a free list and the
+// table doubles when it runs out, so any number of connections can be
+// open. A connection's internal structure is allocated with its slot and
+// kept for reuse, threads holding a pointer to it never see it freed.
+struct SynConnectionSlot {
+  SynConnectionInternal* sci;
+  unsigned int generation;  // bumped each time the slot is freed, never 0
+  int next_free;            // next slot on the free list, or -1
+};
+typedef struct SynConnectionSlot SynConnectionSlot;
+
+static vlc_mutex_t syn_table_lock_ = VLC_STATIC_MUTEX;
+static SynConnectionSlot* syn_slots_ = NULL;
+static int syn_num_slots_ = 0;
+static int syn_free_head_ = -1;
+
+// Returns the zeroed structure of a free slot, NULL if out of memory
+static SynConnectionInternal* SynConnection_AllocSlot(void) {
+  SynConnectionInternal* sci = NULL;
+  vlc_mutex_lock(&syn_table_lock_);
+  if(-1 == syn_free_head_) {
+    int num_slots = syn_num_slots_ ? 2 * syn_num_slots_ : SYN_INITIAL_CONNECTIONS;
+    SynConnectionSlot* slots =
+      realloc(syn_slots_, num_slots * sizeof(*slots));
+    if(NULL == slots) {
+      goto out;
+    }
+    for(int i = syn_num_slots_; i < num_slots; ++i) {
+      slots[i].sci = NULL;
+      slots[i].generation = 1;
+      slots[i].next_free = i + 1 < num_slots ? i + 1 : syn_free_head_;
+    }
+    syn_free_head_ = syn_num_slots_;
+    syn_slots_ = slots;
+    syn_num_slots_ = num_slots;
+  }
+  SynConnectionSlot* entry = &syn_slots_[syn_free_head_];
+  if(NULL == entry->sci) {
+    entry->sci = malloc(sizeof(*entry->sci));
+    if(NULL == entry->sci) {
+      goto out;
+    }
+  }
+  sci = entry->sci;
+  memset(sci, 0, sizeof(*sci));
+  sci->slot = syn_free_head_;
+  syn_free_head_ = entry->next_free;
+  entry->next_free = -1;
+out:
+  vlc_mutex_unlock(&syn_table_lock_);
+  return sci;
+}
+
+// Invalidates every handle to the slot and puts it back on the free list
+static void SynConnection_FreeSlot(int slot) {
+  vlc_mutex_lock(&syn_table_lock_);
+  SynConnectionSlot* entry = &syn_slots_[slot];
+  if(0 == ++entry->generation) {
+    entry->generation = 1;
+  }
+  entry->next_free = syn_free_head_;
+  syn_free_head_ = slot;
+  vlc_mutex_unlock(&syn_table_lock_);
+}
+
+// Returns NULL if the connection is out of range or has been destroyed
+SynConnectionInternal* SynConnection_Lookup(SynConnection connection) {
+  SynConnectionInternal* sci = NULL;
+  vlc_mutex_lock(&syn_table_lock_);
+  if(connection.index >= 0 && connection.index < syn_num_slots_ &&
+      syn_slots_[connection.index].generation == connection.generation &&
+      -1 == syn_slots_[connection.index].next_free) {
+    sci = syn_slots_[connection.index].sci;
+  }
+  vlc_mutex_unlock(&syn_table_lock_);
+  return sci;
+}
 
 void SynLock(SynConnectionInternal* sci) {
   vlc_mutex_lock(&sci->lock);
@@ -22,10 +101,7 @@ void SynUnlock(SynConnectionInternal* sci) {
 // send all with check. Blocks until all of buffer is sent
 int csend_all(int socket, const void *buf, int len,
     struct Empty* useless_vlc_object) {
-  int i = 0;
-  while(!useless_vlc_object) {
-    useless_vlc_object = syn_ci_[i++].useless_vlc_object;
-  }
+  assert(NULL != useless_vlc_object);
   return net_Write(useless_vlc_object, socket, 0, buf, len);
 }
 
@@ -34,10 +110,7 @@ int csend_all(int socket, const void *buf, int len,
 // if everything went as expected
 int srecv_all(int socket, void *buf, int len,
     struct Empty* useless_vlc_object) {
-  int i = 0;
-  while(!useless_vlc_object) {
-    useless_vlc_object = syn_ci_[i++].useless_vlc_object;
-  }
+  assert(NULL != useless_vlc_object);
   int rv = net_Read(useless_vlc_object, socket, 0, buf, len, 1);
   if(rv < 0) {
     return rv;
@@ -48,14 +121,168 @@ int srecv_all(int socket, void *buf, int len,
   }
 }
 
+// Lock held, before the reply's sample goes into the estimate. Back the
+// beacons off while replies agree with the clock estimate, burst when
+// one does not or the path changed.
+static void syn_connection_adapt_beacons(SynConnectionInternal* sci,
+    mtime_t now, mtime_t offset, mtime_t rtt) {
+  const SynClock* clock = &sci->clock;
+  int disrupted = 0;
+  if(clock->count >= SYN_CLOCK_MIN_FIT) {
+    // the sample itself is only good to half its round trip
+    mtime_t miss = offset - syn_clock_offset(clock, now);
+    mtime_t bound = syn_clock_error(clock) + 2 * clock->jitter + rtt / 2;
+    if(miss > bound || miss < -bound) {
+      disrupted = 1;
+    }
+  }
+  if(sci->estimated_rtt > 0 &&
+      (rtt > SYN_BEACON_RTT_JUMP * sci->estimated_rtt + SYN_BEACON_TOLERANCE ||
+       SYN_BEACON_RTT_JUMP * rtt + SYN_BEACON_TOLERANCE < sci->estimated_rtt)) {
+    disrupted = 1;
+  }
+
+  if(disrupted) {
+    sci->beacon_burst = SYN_BEACON_BURST;
+    sci->beacon_interval = SYN_BEACON_MIN;
+    sci->beacon_reschedule = 1;
+    vlc_cond_signal(&sci->send_info_non_empy);
+  } else if(sci->beacon_burst > 0) {
+    sci->beacon_burst--;
+  } else if(sci->count_sync >= SYN_CLOCK_FAST_SAMPLES) {
+    mtime_t max = SYN_BEACON_MAX;
+    mtime_t error = syn_clock_error(clock);
+    if(error > SYN_BEACON_TOLERANCE) {
+      max = max * SYN_BEACON_TOLERANCE / error;
+    }
+    mtime_t interval = 2 * sci->beacon_interval;
+    if(interval > max) {
+      interval = max;
+    }
+    sci->beacon_interval = interval < SYN_BEACON_MIN ? SYN_BEACON_MIN : interval;
+  }
+}
+
+// A reply to our sync request came in at now, over TCP or UDP, with
+// timestamp_reply our request's time; without one, 0. Updates the rtt
+// and clock offset estimates.
+void syn_connection_sync_sample(SynConnectionInternal* sci, mtime_t now,
+    mtime_t timestamp_sync, mtime_t timestamp_reply) {
+  SynLock(sci);
+  if(0 != timestamp_reply) {
+    sci->count_sync_reply++;
+
+    // update rtt
+    mtime_t sample_rtt = now - timestamp_reply;
+    mtime_t sample_offset = now - sample_rtt / 2 - timestamp_sync;
+    syn_connection_adapt_beacons(sci, now, sample_offset, sample_rtt);
+    if(sci->estimated_rtt < 0) {
+      sci->estimated_rtt = sample_rtt;
+    } else {
+      sci->estimated_rtt = ((SYNC_ALPHA_INVERSE - 1) * sci->estimated_rtt +
+          sample_rtt) / SYNC_ALPHA_INVERSE;
+    }
+    syn_clock_add(&sci->clock, now, sample_offset, sample_rtt);
+  }
+  // follow the drift between replies too
+  sci->delta_t = syn_clock_offset(&sci->clock, now);
+  SynUnlock(sci);
+}
+
+// Tell whoever waits for the peer once the clock estimate is worth
+// something. Not called by the UDP thread, which holds its lock.
+static void syn_connection_check_peer(SynConnectionInternal* sci) {
+  // A follower of a party host is there as soon as it talks, the host
+  // does not ask for sync replies of its own
+  if(sci->peer_connect_callback &&
+      (sci->count_sync_reply >= SYNC_INITIAL_COUNT || NULL != sci->hub)) {
+    // TODO this block of code is duplicated
+    SynLock(sci);
+    SynConnection_Callback* peer_connect_callback =
+      sci->peer_connect_callback;
+    void* peer_connect_param = sci->peer_connect_param;
+    sci->peer_connect_callback = 0;
+    sci->peer_connect_param = 0;
+    SynUnlock(sci);
+
+    (*peer_connect_callback)(0, peer_connect_param);
+  }
+}
+
+// Bookkeeping for a received segment header: answer sync requests,
+// update the rtt and clock offset estimates and tell the host once the
+// peer is there. Returns the delay to pass to the receive callback.
+mtime_t syn_connection_handle_header(SynConnectionInternal* sci,
+    const SynSegmentHeader* header, size_t wire_size) {
+  SynLock(sci);
+    sci->bytes_received += wire_size;
+    if(!sci->peer_connected) {
+      sci->peer_connected = 1;
+      vlc_cond_signal(&sci->send_info_non_empy);
+    }
+  SynUnlock(sci);
+
+  if(header->flag & SYNC_MASK) {
+    int mask = SYNC_REPLY_MASK;
+    if(!(header->flag & SYNC_END)) {
+      mask |= SYNC_MASK | SYNC_END;
+    }
+
+    // send with SYNC_REPLY_MASK
+    syn_connection_append_send_info(
+        sci, 0, 0, 0, 0,
+        mask, header->timestamp_sync);
+  }
+
+  // Peer's wire version, answered with our upgrade if both go compact
+  if((header->flag & SYNC_HELLO) && 0 == sci->wire_version) {
+    int version = header->timestamp_reply < SYN_WIRE_VERSION ?
+      (int)header->timestamp_reply : SYN_WIRE_VERSION;
+    sci->wire_version = version;
+    if(version >= 1) {
+      syn_connection_append_send_info(sci, 0, 0, 0, 0, SYNC_UPGRADE, 0);
+    }
+  }
+  if(header->flag & SYNC_UPGRADE) {
+    sci->recv_compact = 1;
+  }
+
+  mtime_t current_mdate = mdate();
+  if(header->flag & SYNC_REPLY_MASK) {
+    sci->awaiting_reply = 0;
+  }
+  syn_connection_sync_sample(sci, current_mdate,
+      header->timestamp_sync,
+      (header->flag & SYNC_REPLY_MASK) ? header->timestamp_reply : 0);
+
+  syn_connection_check_peer(sci);
+
+  return current_mdate - header->timestamp_sync - sci->delta_t;
+}
+
+// The receive thread's socket failed with rv. Reported to the receive
+// callback, unless the send thread is to resume the session.
+static void syn_receive_failed(SynConnectionInternal* sci, int rv) {
+  SynLock(sci);
+    int report = SYN_DESTROYING != sci->state && !sci->link_broken;
+    if(report && syn_connection_can_resume(sci, rv)) {
+      sci->link_broken = 1;
+      vlc_cond_signal(&sci->send_info_non_empy);
+      report = 0;
+    }
+  SynUnlock(sci);
+  if(report) {
+    (*sci->receive_callback)(rv, sci->estimated_rtt / 2,
+        sci->receive_param, 0, 0);
+  }
+}
+
 void* syn_receive_thread(void* param) {
-  int index = (int)param;
-  SynConnectionInternal* sci = &syn_ci_[index];
+  SynConnectionInternal* sci = param;
   int sockfd = sci->socket;
   SynConnection_ReceiveCallback* callback = sci->receive_callback;
   param = sci->receive_param;
 
-  unsigned int count_sync_reply = 0;
   static const unsigned int RECV_BUFFER_SIZE = 100;
   char buffer[RECV_BUFFER_SIZE];
   SynSegmentHeader header;
@@ -66,76 +293,43 @@ void* syn_receive_thread(void* param) {
       }
     SynUnlock(sci);
 
-    // receive header
-    int rv = srecv_all(sockfd, &header, sizeof(header),
-        sci->useless_vlc_object);
-
-    // recv data is there is any to receive
-    if(rv > 0) {
-      if(!sci->peer_connected) {
-        SynLock(sci);
-        sci->peer_connected = 1;
-        vlc_cond_signal(&sci->send_info_non_empy);
-        SynUnlock(sci);
-      }
-
-      if(header.flag & SYNC_MASK) {
-        int mask = SYNC_REPLY_MASK;
-        if(!(header.flag & SYNC_END)) {
-          mask |= SYNC_MASK | SYNC_END;
-        }
-
-        // send with SYNC_REPLY_MASK
-        syn_connection_append_send_info(
-            sci, 0, 0, 0, 0,
-            mask, header.timestamp_sync);
-      }
-
-      mtime_t current_mdate = mdate();
-      if(header.flag & SYNC_REPLY_MASK) {
-        count_sync_reply++;
-        sci->awaiting_reply = 0;
-
-        // update rtt
-        mtime_t sample_rtt = current_mdate - header.timestamp_reply;
-        SynLock(sci);
-          if(sci->estimated_rtt < 0) {
-            sci->estimated_rtt = sample_rtt;
-          } else {
-            sci->estimated_rtt = ((SYNC_ALPHA_INVERSE - 1) * sci->estimated_rtt +
-                sample_rtt) / SYNC_ALPHA_INVERSE;
+    int rv;
+    if(sci->recv_compact) {
+      // length prefix, then the body in one go
+      uint8_t prefix[SYN_COMPACT_PREFIX_LENGTH];
+      rv = srecv_all(sockfd, prefix, sizeof(prefix), sci->useless_vlc_object);
+      if(rv > 0) {
+        size_t length = (prefix[0] << 8) | prefix[1];
+        uint8_t* body = length > RECV_BUFFER_SIZE ?
+          malloc(length) : (uint8_t*)buffer;
+        if(NULL == body) {
+          rv = -1;
+        } else {
+          rv = srecv_all(sockfd, body, length, sci->useless_vlc_object);
+          if(rv > 0 && syn_connection_handle_segment(sci, body, length) < 0) {
+            msg_Err(sci->useless_vlc_object, "malformed segment");
+            rv = -1;
           }
-          mtime_t new_delta_t = current_mdate - sample_rtt / 2 - header.timestamp_sync;
-          mtime_t cs = (sample_rtt * sample_rtt) >> 14;
-          if(sci->delta_t_initialized) {
-            // complicated math follows...doing a weighted sum of new_delta_t and old delta_t
-            sci->delta_t = (new_delta_t * sci->delta_t_confidence + sci->delta_t * cs) /
-              (sci->delta_t_confidence + cs);
-            sci->delta_t_confidence = (2 * sci->delta_t_confidence * cs) /
-              (sci->delta_t_confidence + cs);
-          } else {
-            sci->delta_t = new_delta_t;
-            sci->delta_t_confidence = cs;
-            sci->delta_t_initialized = 1;
+          if(body != (uint8_t*)buffer) {
+            free(body);
           }
-        SynUnlock(sci);
+        }
       }
-
-      if(sci->peer_connect_callback &&
-          (count_sync_reply >= SYNC_INITIAL_COUNT)) {
-        // TODO this block of code is duplicated
-        SynLock(sci);
-        SynConnection_Callback* peer_connect_callback =
-          sci->peer_connect_callback;
-        void* peer_connect_param = sci->peer_connect_param;
-        sci->peer_connect_callback = 0;
-        sci->peer_connect_param = 0;
-        SynUnlock(sci);
-
-        (*peer_connect_callback)(0, peer_connect_param);
+      if(rv <= 0) {
+        syn_receive_failed(sci, rv);
+        break;
       }
+      continue;
+    }
+
+    // receive header
+    rv = srecv_all(sockfd, &header, sizeof(header),
+        sci->useless_vlc_object);
 
-      mtime_t delay = current_mdate - header.timestamp_sync - sci->delta_t;
+    // recv data is there is any to receive
+    if(rv > 0) {
+      mtime_t delay = syn_connection_handle_header(sci, &header,
+          sizeof(header) + header.length);
 
       if(header.length > 0) {
         // receive data
@@ -143,21 +337,22 @@ void* syn_receive_thread(void* param) {
           char* buffer_on_heap = malloc(header.length);
           rv = srecv_all(sockfd, buffer_on_heap, header.length,
               sci->useless_vlc_object);
-          (*callback)(rv, delay, param, buffer_on_heap, header.length);
+          if(rv > 0) {
+            (*callback)(rv, delay, param, buffer_on_heap, header.length);
+          }
           free(buffer_on_heap);
         } else {
           rv = srecv_all(sockfd, buffer, header.length,
               sci->useless_vlc_object);
-          (*callback)(rv, delay, param, buffer, header.length);
+          if(rv > 0) {
+            (*callback)(rv, delay, param, buffer, header.length);
+          }
         }
       }
-    } else {
-      if(SYN_DESTROYING != sci->state) {
-        (*callback)(rv, sci->estimated_rtt / 2, param, 0, 0);
-      }
     }
 
     if(rv <= 0) {
+      syn_receive_failed(sci, rv);
       break;
     }
   }
@@ -169,9 +364,405 @@ void syn_set_sync_header(SynSegmentHeader* header) {
   header->timestamp_sync = mdate();
 }
 
+// How long to wait for something to send before the next sync beacon
+mtime_t syn_connection_beacon_delay(SynConnectionInternal* sci) {
+  if(sci->count_sync < SYN_CLOCK_FAST_SAMPLES || sci->beacon_burst > 0) {
+    return SYN_BEACON_FAST;
+  }
+  mtime_t delay = sci->beacon_interval;
+  if(delay < SYN_BEACON_MIN) {
+    delay = SYN_BEACON_MIN;
+  }
+  if(delay < sci->estimated_rtt) {
+    delay = sci->estimated_rtt;
+  }
+  // keep connections that came up together from beaconing in step
+  return delay + vlc_lrand48() % (delay / 8 + 1);
+}
+
+// Whether the wait for something to send ended is worth a sync beacon
+int syn_connection_wants_beacon(SynConnectionInternal* sci) {
+  return (sci->peer_connected && !sci->awaiting_reply) ||
+      (sci->was_client && 0 == sci->count_sync);
+}
+
+// A beacon is due. Over UDP once the peer answers there, over the relay
+// connection otherwise.
+void syn_connection_beacon(SynConnectionInternal* sci) {
+  syn_connection_check_peer(sci);  // replies may have come over UDP
+  if(sci->udp && sci->peer_connected && syn_udp_beacon(sci)) {
+    return;
+  }
+  if(syn_connection_wants_beacon(sci)) {
+    syn_connection_append_send_info(sci, 0, 0, 0, 0, SYNC_MASK, 0);
+  }
+}
+
+// Stamp a segment header right before it goes out. Only one sync
+// request is in flight at a time, later ones go out as plain data.
+static void syn_connection_prepare_header(SynConnectionInternal* sci,
+    SynSegmentHeader* header) {
+  syn_set_sync_header(header);
+  if(sci->party) {
+    // a broadcast, the followers' replies would all come back to members
+    header->flag &= ~(SYNC_MASK | SYNC_END);
+  }
+  if(header->flag & SYNC_MASK) {
+    if(sci->awaiting_reply) {
+      header->flag &= ~SYNC_MASK;
+    } else {
+      sci->awaiting_reply = 1;
+      sci->await_start_time = mdate();
+      sci->count_sync++;
+    }
+  }
+}
+
+// Send queue entries, lock held. A payload too large for the inline
+// storage gets a buffer of its own.
+static SynConnection_SendInfo* syn_send_info_get(SynConnectionInternal* sci,
+    int len) {
+  SynConnection_SendInfo* send_info = sci->send_info_free;
+  if(NULL != send_info) {
+    sci->send_info_free = send_info->next;
+    sci->send_info_spare--;
+  } else {
+    send_info = malloc(sizeof(*send_info));
+    if(NULL == send_info) {
+      return NULL;
+    }
+  }
+  send_info->buffer = send_info->storage;
+  if(len > SYN_SEND_INLINE_PAYLOAD) {
+    send_info->buffer = malloc(len + sizeof(SynSegmentHeader));
+    if(NULL == send_info->buffer) {
+      free(send_info);
+      return NULL;
+    }
+  }
+  return send_info;
+}
+
+static void syn_send_info_put(SynConnectionInternal* sci,
+    SynConnection_SendInfo* send_info) {
+  if(send_info->buffer != send_info->storage) {
+    free(send_info->buffer);
+  }
+  if(sci->send_info_spare < SYN_SEND_POOL_SIZE) {
+    send_info->next = sci->send_info_free;
+    sci->send_info_free = send_info;
+    sci->send_info_spare++;
+  } else {
+    free(send_info);
+  }
+}
+
+// Merge the send infos of a compact segment into one header: a sync
+// request only stops at the peer's reply if every message said so, and
+// the newest reply timestamp wins.
+static void syn_connection_merge_headers(SynConnection_SendInfo* send_info,
+    SynSegmentHeader* merged) {
+  int any_sync = 0, all_end = 1;
+  merged->flag = 0;
+  merged->timestamp_reply = 0;
+  for(; NULL != send_info; send_info = send_info->next) {
+    const SynSegmentHeader* header = (SynSegmentHeader*)send_info->buffer;
+    if(header->flag & SYNC_MASK) {
+      any_sync = 1;
+      if(!(header->flag & SYNC_END)) {
+        all_end = 0;
+      }
+    }
+    if(header->flag & SYNC_REPLY_MASK) {
+      merged->flag |= SYNC_REPLY_MASK;
+      merged->timestamp_reply = header->timestamp_reply;
+    }
+  }
+  if(any_sync) {
+    merged->flag |= SYNC_MASK | (all_end ? SYNC_END : 0);
+  }
+}
+
+// Take what is queued and lay out the next segment in out_buffer.
+// Legacy peers get the first send info as it is, compact peers get as
+// many as fit one segment. Returns 0 if nothing is queued.
+int syn_connection_take_segment(SynConnectionInternal* sci) {
+  SynConnection_SendInfo* first;
+  SynConnection_SendInfo* last;
+  size_t bound = 1 + 2 * SYN_VARINT_MAX_LENGTH;
+  SynLock(sci);
+    first = last = sci->send_info_head;
+    if(NULL == first) {
+      SynUnlock(sci);
+      return 0;
+    }
+    if(sci->send_compact) {
+      bound += SYN_VARINT_MAX_LENGTH +
+        ((SynSegmentHeader*)first->buffer)->length;
+      while(NULL != last->next) {
+        size_t more = SYN_VARINT_MAX_LENGTH +
+          ((SynSegmentHeader*)last->next->buffer)->length;
+        if(bound + more > SYN_COMPACT_MAX_BODY) {
+          break;
+        }
+        bound += more;
+        last = last->next;
+      }
+    }
+    sci->send_info_head = last->next;
+    if(NULL == last->next) {
+      sci->send_info_tail = NULL;
+    }
+    last->next = NULL;
+  SynUnlock(sci);
+
+  sci->out_infos = first;
+  if(!sci->send_compact) {
+    SynSegmentHeader* header = (SynSegmentHeader*)first->buffer;
+    syn_connection_prepare_header(sci, header);
+    sci->out_upgrade = (header->flag & SYNC_UPGRADE) ? 1 : 0;
+    sci->out_buffer = first->buffer;
+    sci->out_size = first->size;
+    return 1;
+  }
+
+  SynSegmentHeader merged;
+  syn_connection_merge_headers(first, &merged);
+  syn_connection_prepare_header(sci, &merged);
+
+  if(sci->out_capacity < SYN_COMPACT_PREFIX_LENGTH + bound) {
+    char* storage = realloc(sci->out_storage,
+        SYN_COMPACT_PREFIX_LENGTH + bound);
+    if(NULL == storage) {
+      // nothing went out, fail the messages rather than the connection
+      syn_connection_segment_done(sci, -6);
+      return syn_connection_take_segment(sci);
+    }
+    sci->out_storage = storage;
+    sci->out_capacity = SYN_COMPACT_PREFIX_LENGTH + bound;
+  }
+  uint8_t* out = (uint8_t*)sci->out_storage;
+  uint8_t* body = out + SYN_COMPACT_PREFIX_LENGTH;
+  size_t len = 0;
+  body[len++] = (uint8_t)merged.flag;
+  len += syn_put_varint(body + len, merged.timestamp_sync);
+  if(merged.flag & SYNC_REPLY_MASK) {
+    len += syn_put_varint(body + len, merged.timestamp_reply);
+  }
+  for(SynConnection_SendInfo* send_info = first; NULL != send_info;
+      send_info = send_info->next) {
+    uint64_t length = ((SynSegmentHeader*)send_info->buffer)->length;
+    if(0 == length) {
+      continue;  // bare sync requests and replies carry no message
+    }
+    len += syn_put_varint(body + len, length);
+    memcpy(body + len, send_info->buffer + sizeof(SynSegmentHeader), length);
+    len += length;
+  }
+  assert(len <= SYN_COMPACT_MAX_BODY);
+  out[0] = (uint8_t)(len >> 8);
+  out[1] = (uint8_t)len;
+
+  sci->out_upgrade = 0;
+  sci->out_buffer = sci->out_storage;
+  sci->out_size = SYN_COMPACT_PREFIX_LENGTH + len;
+  return 1;
+}
+
+// The segment from syn_connection_take_segment is out, or failed with
+// rv < 0: report to every message it carried and let it go
+void syn_connection_segment_done(SynConnectionInternal* sci, int rv) {
+  SynConnection_SendInfo* send_info;
+  for(send_info = sci->out_infos; NULL != send_info;
+      send_info = send_info->next) {
+    if(NULL != send_info->callback) {
+      (*send_info->callback)(rv < 0 ? rv : 0, send_info->param);
+    }
+  }
+  SynLock(sci);
+    while(NULL != sci->out_infos) {
+      send_info = sci->out_infos;
+      sci->out_infos = send_info->next;
+      syn_send_info_put(sci, send_info);
+    }
+    if(rv >= 0) {
+      sci->bytes_sent += sci->out_size;
+    }
+  SynUnlock(sci);
+  if(rv >= 0 && sci->out_upgrade) {
+    sci->send_compact = 1;
+  }
+  sci->out_buffer = NULL;
+  sci->out_size = 0;
+  sci->out_upgrade = 0;
+}
+
+// A compact segment body: handle its header once, then hand every
+// message to the receive callback. Returns -1 if the body is malformed.
+int syn_connection_handle_segment(SynConnectionInternal* sci,
+    const uint8_t* body, size_t len) {
+  SynSegmentHeader header;
+  uint64_t value;
+  size_t at = 0;
+  int rv;
+  if(len < 1) {
+    return -1;
+  }
+  header.flag = body[at++];
+  if((rv = syn_get_varint(body + at, len - at, &value)) < 0) {
+    return -1;
+  }
+  header.timestamp_sync = value;
+  at += rv;
+  header.timestamp_reply = 0;
+  if(header.flag & SYNC_REPLY_MASK) {
+    if((rv = syn_get_varint(body + at, len - at, &value)) < 0) {
+      return -1;
+    }
+    header.timestamp_reply = value;
+    at += rv;
+  }
+  header.length = 0;
+
+  // check the message lengths before anything is delivered
+  size_t check = at;
+  while(check < len) {
+    if((rv = syn_get_varint(body + check, len - check, &value)) < 0 ||
+        0 == value || value > len - check - rv) {
+      return -1;
+    }
+    check += rv + value;
+  }
+
+  mtime_t delay = syn_connection_handle_header(sci, &header,
+      SYN_COMPACT_PREFIX_LENGTH + len);
+  while(at < len) {
+    at += syn_get_varint(body + at, len - at, &value);
+    (*sci->receive_callback)(value, delay, sci->receive_param,
+        (void*)(body + at), value);
+    at += value;
+  }
+  return 0;
+}
+
+// No reply to our last sync request for too long: the peer is gone
+int syn_connection_timed_out(SynConnectionInternal* sci) {
+  return sci->awaiting_reply &&
+    (mdate() - sci->await_start_time) > SYN_CONNECTION_THRESHOLD;
+}
+
+// Whether a relay connection that broke with rv is resumed rather than
+// torn down. Only errors are: the relay closes the connection cleanly
+// when the peer left for good, and resets it when the peer may be back.
+int syn_connection_can_resume(SynConnectionInternal* sci, int rv) {
+  return rv < 0 && 0 != sci->session_token;
+}
+
+// The broken relay connection is closed: drop what was on its way in
+// either direction and get the session back on a new one. The clock
+// estimate stays, a burst of beacons checks it right away. Returns 0
+// once resumed.
+int syn_connection_relink(SynConnectionInternal* sci) {
+  msg_Warn(sci->useless_vlc_object, "relay connection lost, resuming");
+  syn_connection_segment_done(sci, -10);
+  free(sci->recv_payload);
+  sci->recv_payload = NULL;
+  sci->recv_have = 0;
+  sci->send_offset = 0;
+  SynLock(sci);
+    sci->link_broken = 0;
+    sci->awaiting_reply = 0;
+    sci->beacon_burst = SYN_BEACON_BURST;
+    sci->beacon_reschedule = 1;
+  SynUnlock(sci);
+  // the peer starts its new stream in the legacy format as well
+  sci->wire_version = 0;
+  sci->send_compact = 0;
+  sci->recv_compact = 0;
+
+  int rv = syn_connection_resume(sci);
+  if(0 != rv) {
+    msg_Err(sci->useless_vlc_object, "relay session lost (%d)", rv);
+    return rv;
+  }
+  msg_Dbg(sci->useless_vlc_object, "relay session resumed");
+  syn_connection_append_send_info(sci, 0, 0, 0, 0,
+      SYNC_HELLO, SYN_WIRE_VERSION);
+  return 0;
+}
+
+// Last step of tearing a connection down, once its socket is closed and
+// no other thread uses it any more: fail what is still queued, report
+// the destruction and give the slot back.
+void syn_connection_release(SynConnectionInternal* sci) {
+  // Clean up send info, a half sent segment first
+  syn_connection_segment_done(sci, -10);
+  while(NULL != sci->send_info_head) {
+    SynConnection_SendInfo* send_info = sci->send_info_head;
+    sci->send_info_head = send_info->next;
+    if(NULL != send_info->callback) {
+      (*send_info->callback)(-10, send_info->param);
+    }
+    syn_send_info_put(sci, send_info);
+  }
+  while(NULL != sci->send_info_free) {
+    SynConnection_SendInfo* send_info = sci->send_info_free;
+    sci->send_info_free = send_info->next;
+    free(send_info);
+  }
+  free(sci->out_storage);
+  if(sci->udp) {
+    syn_udp_close(sci);
+  }
+  if(sci->party) {
+    syn_party_free(sci);
+  }
+
+  // call destroy callback, which is only set when destroy is called
+  if(NULL != sci->destroy_callback) {
+    (*sci->destroy_callback)(0, sci->destroy_param);
+  }
+
+  // free data structure
+  sci->state = SYN_UNINITIALIZED;
+
+  vlc_object_release(sci->useless_vlc_object);
+  int slot = sci->slot;
+  memset(sci, 0, sizeof(*sci));
+  SynConnection_FreeSlot(slot);
+}
+
+// A follower of a party host. It has no socket and no threads, the
+// party host's I/O runs its segments through the relay session. Returns
+// NULL if out of memory.
+SynConnectionInternal* syn_connection_new_member(SynConnectionInternal* hub,
+    uint32_t id) {
+  SynConnectionInternal* const sci = SynConnection_AllocSlot();
+  if(NULL == sci) {
+    return NULL;
+  }
+  vlc_mutex_init(&sci->lock);
+  vlc_cond_init(&sci->send_info_non_empy);
+  sci->state = SYN_INITIALIZED;
+  sci->socket = -1;
+  sci->receive_callback = hub->receive_callback;
+  sci->receive_param = hub->receive_param;
+  sci->peer_connect_callback = hub->peer_connect_callback;
+  sci->peer_connect_param = hub->peer_connect_param;
+  sci->estimated_rtt = -1;
+  syn_clock_init(&sci->clock);
+  sci->delta_t = 0;
+  sci->useless_vlc_object = hub->useless_vlc_object;
+  vlc_object_hold(sci->useless_vlc_object);
+  sci->hub = hub;
+  sci->member_id = id;
+  syn_connection_append_send_info(sci, 0, 0, 0, 0,
+      SYNC_HELLO, SYN_WIRE_VERSION);
+  return sci;
+}
+
 void* syn_send_thread(void* param) {
-  int index = (int)param;
-  SynConnectionInternal* const sci = &syn_ci_[index];
+  SynConnectionInternal* const sci = param;
 
   int rv = -1;
   if(SYN_SERVER_INITIALIZING == sci->state) {
@@ -198,20 +789,50 @@ void* syn_send_thread(void* param) {
     (*initialize_callback)(0, init_param);
   }
 
-  int was_client = 0;
   SynLock(sci);
     if(SYN_CLIENT_INITIALIZING == sci->state) {
       //sci->peer_connected = 1;
-      was_client = 1;
+      sci->was_client = 1;
     }
     sci->state = SYN_INITIALIZED;
   SynUnlock(sci);
 
-  // Start receive thread
+  // Tell the peer which wire format we speak, in the one every version
+  // understands. A party host has no peer of its own, every follower's
+  // member connection says hello instead.
+  if(!sci->party) {
+    syn_connection_append_send_info(sci, 0, 0, 0, 0,
+        SYNC_HELLO, SYN_WIRE_VERSION);
+  }
+
+  // Beacons try UDP next to it, a party's relay session has no room
+  if(!sci->party &&
+      var_InheritBool(sci->useless_vlc_object, "synchronicity-udp") &&
+      0 != syn_udp_open(sci)) {
+    msg_Warn(sci->useless_vlc_object, "no UDP beacons, syncing over TCP");
+  }
+
+  // From here on the shared I/O thread takes over, if there is one
+  if(sci->reactor) {
+    if(0 == syn_reactor_add(sci)) {
+      return NULL;
+    }
+    if(sci->party) {
+      msg_Err(sci->useless_vlc_object, "I/O thread unavailable for party");
+      rv = -4;
+      goto SynDestroyWithIniailize;
+    }
+    msg_Warn(sci->useless_vlc_object,
+        "I/O thread unavailable, using per connection threads");
+    sci->reactor = 0;
+  }
+
+  // Start receive thread, again after a resume
+Receive:
   rv = vlc_clone(
       &sci->receive_thread,
       &syn_receive_thread,
-      (void*)index,
+      sci,
       SYN_THREAD_PRIORITY);
   if(0 != rv) {
     msg_Err(sci->useless_vlc_object, "recv thread failed to start");
@@ -222,84 +843,66 @@ void* syn_send_thread(void* param) {
     sci->receive_thread_initialized = 1;
   SynUnlock(sci);
 
-  unsigned int count_sync = 0;
   while(true) {
     SynLock(sci);
       if(SYN_DESTROYING == sci->state) goto SynDestroying;
 
-      if(NULL == sci->send_info_head) {
-        mtime_t delay;
-        if(count_sync < SYNC_INITIAL_COUNT) {
-          delay = 100000;
-        } else {
-          delay = sci->estimated_rtt;
-          if(delay < SYN_INTERNAL_IN_MICROS) {
-            delay = SYN_INTERNAL_IN_MICROS;
-          }
-          delay = delay * (vlc_lrand48() % 10 + 1);
-        }
+      if(NULL == sci->send_info_head && !sci->link_broken) {
+        mtime_t delay = syn_connection_beacon_delay(sci);
         vlc_cond_timedwait(&sci->send_info_non_empy, &sci->lock,
             mdate() + delay);
       }
-      SynConnection_SendInfo* send_info = NULL;
-      if(NULL != sci->send_info_head) {
-        send_info  = sci->send_info_head;
-        sci->send_info_head = send_info->next;
-        if(NULL == send_info->next) {
-          sci->send_info_tail = NULL;
-        }
-      }
+      int broken = sci->link_broken;
     SynUnlock(sci);
 
-    if(sci->awaiting_reply &&
-      (mdate() - sci->await_start_time) > SYN_CONNECTION_THRESHOLD) {
-      goto SynDestroyWithIniailize;
+    if(broken || syn_connection_timed_out(sci)) {
+      rv = -5;
+      goto Broken;
     }
 
-    if(NULL != send_info) {
+    if(syn_connection_take_segment(sci)) {
       // send data
-      SynSegmentHeader* header = (SynSegmentHeader*)(send_info->buffer);
-      syn_set_sync_header(header);
-      if(header->flag & SYNC_MASK) {
-        if(sci->awaiting_reply) {
-          header->flag &= ~SYNC_MASK;
-        } else {
-          sci->awaiting_reply = 1;
-          sci->await_start_time = mdate();
-          count_sync++;
-        }
-      }
-
-      if(rv >= 0) {
-        rv = csend_all(sci->socket, send_info->buffer, send_info->size,
-            sci->useless_vlc_object);
-      }
-
-      // Execute callback
-      if(NULL != send_info->callback) {
-        (*send_info->callback)(rv < 0 ? rv : 0, send_info->param);
-      }
-
-      // delete resources
-      free(send_info->buffer);
-      free(send_info);
+      rv = csend_all(sci->socket, sci->out_buffer, sci->out_size,
+          sci->useless_vlc_object);
+      syn_connection_segment_done(sci, rv);
 
       if(rv < 0) {
         msg_Err(sci->useless_vlc_object, "send thread error %d %m", rv);
         rv = -5;
-        goto SynDestroyWithIniailize;
+        goto Broken;
       }
-    } else if((sci->peer_connected && !sci->awaiting_reply) ||
-        (was_client && 0 == count_sync)) {
-      SynSegmentHeader header;
-      header.flag = SYNC_MASK;
-      syn_set_sync_header(&header);
-      header.length = 0;
-      sci->awaiting_reply = 1;
-      count_sync++;
-      sci->await_start_time = mdate();
-      csend_all(sci->socket, &header, sizeof(header),
-          sci->useless_vlc_object);
+    } else {
+      // over TCP it goes out on the next turn, batched with whatever
+      // else is queued
+      syn_connection_beacon(sci);
+    }
+  }
+
+// lock is not held here
+Broken:
+  if(syn_connection_can_resume(sci, rv)) {
+    // the receive thread must not report what we are about to do
+    SynLock(sci);
+      sci->link_broken = 1;
+      shutdown(sci->socket, SHUT_RDWR);
+    SynUnlock(sci);
+    vlc_join(sci->receive_thread, NULL);
+    SynLock(sci);
+      sci->receive_thread_initialized = 0;
+      net_Close(sci->socket);
+      sci->socket = -1;
+    SynUnlock(sci);
+
+    rv = syn_connection_relink(sci);
+    if(0 == rv) {
+      goto Receive;
+    }
+    SynLock(sci);
+      int destroying = SYN_DESTROYING == sci->state;
+    SynUnlock(sci);
+    if(!destroying) {
+      (*sci->receive_callback)(rv, sci->estimated_rtt / 2,
+          sci->receive_param, 0, 0);
     }
   }
 
@@ -315,9 +918,11 @@ SynDestroyWithIniailize:
 
 // lock is assumed to be held here
 SynDestroying:
-  // close socket
-  shutdown(sci->socket, SHUT_RDWR);
-  net_Close(sci->socket);
+  // close socket, unless a resume failed
+  if(sci->socket >= 0) {
+    shutdown(sci->socket, SHUT_RDWR);
+    net_Close(sci->socket);
+  }
 
   // release mutex
   SynUnlock(sci);
@@ -329,33 +934,12 @@ SynDestroying:
 
   // We now be only thread accessing this structure so no need
   // to acquire lock
-
-  // Clean up send info
-  while(NULL != sci->send_info_head) {
-    SynConnection_SendInfo* send_info = sci->send_info_head;
-    sci->send_info_head = send_info->next;
-    if(NULL != send_info->callback) {
-      (*send_info->callback)(-10, send_info->param);
-    }
-    free(send_info->buffer);
-    free(send_info);
-  }
-
-  // call destroy callback, which is only set when destroy is called
-  if(NULL != sci->destroy_callback) {
-    (*sci->destroy_callback)(0, sci->destroy_param);
-  }
-
-  // free data structure
-  sci->state = SYN_UNINITIALIZED;
-
-  vlc_object_release(sci->useless_vlc_object);
-  memset(sci, 0, sizeof(*sci));
+  syn_connection_release(sci);
 
   return NULL;
 }
 
-// server == 1, client == 0
+// server == 1, client == 0, party host == 2
 int SynConnection_InitializeHelper(
     vlc_object_t* parent,
     SynConnection* connection,
@@ -373,78 +957,112 @@ int SynConnection_InitializeHelper(
   assert(NULL != receive_callback);
 
   connection->index = -1;
+  connection->generation = 0;
 
   // Find empty internal descriptor
-  int i;
-  for(i = 0; i < MAX_CONNECTIONS; ++i) {
-    if(SYN_UNINITIALIZED == syn_ci_[i].state) {
-      connection->index = i;
-      break;
-    }
-  }
-  if(MAX_CONNECTIONS == i) {
+  SynConnectionInternal* const sci = SynConnection_AllocSlot();
+  if(NULL == sci) {
     if(callback) {
       (*callback)(-1, param);
     }
     return -1;
   }
-  memset(&syn_ci_[i], 0, sizeof(syn_ci_[i]));
+  const int i = sci->slot;
 
   // Initialize internal structure variables
   // no need to acquire lock since we have not started
   // the thread yet
-  vlc_mutex_init(&syn_ci_[i].lock);
-  vlc_cond_init(&syn_ci_[i].send_info_non_empy);
-  syn_ci_[i].relay_server_host = server_addr;
-  syn_ci_[i].relay_server_port = server_port;
-  syn_ci_[i].receive_callback = receive_callback;
-  syn_ci_[i].receive_param = receive_param;
-  syn_ci_[i].initialize_callback = callback;
-  syn_ci_[i].initialize_param = param;
-  syn_ci_[i].peer_connect_callback = peer_connect_callback;
-  syn_ci_[i].peer_connect_param = peer_connect_param;
-  syn_ci_[i].estimated_rtt = -1;
-  syn_ci_[i].delta_t_initialized = 0;
-  syn_ci_[i].delta_t = 0;
-  syn_ci_[i].delta_t_confidence = 100000;
-  syn_ci_[i].useless_vlc_object = vlc_custom_create(
+  vlc_mutex_init(&sci->lock);
+  vlc_cond_init(&sci->send_info_non_empy);
+  sci->relay_server_host = server_addr;
+  sci->relay_server_port = server_port;
+  sci->receive_callback = receive_callback;
+  sci->receive_param = receive_param;
+  sci->initialize_callback = callback;
+  sci->initialize_param = param;
+  sci->peer_connect_callback = peer_connect_callback;
+  sci->peer_connect_param = peer_connect_param;
+  sci->estimated_rtt = -1;
+  syn_clock_init(&sci->clock);
+  sci->delta_t = 0;
+  sci->reactor = var_InheritBool(parent, "synchronicity-reactor");
+  if(2 == type) {
+    // followers are only ever driven by the shared I/O thread
+    sci->party = syn_party_new();
+    if(NULL == sci->party) {
+      vlc_cond_destroy(&sci->send_info_non_empy);
+      vlc_mutex_destroy(&sci->lock);
+      memset(sci, 0, sizeof(*sci));
+      SynConnection_FreeSlot(i);
+      if(callback) {
+        (*callback)(-1, param);
+      }
+      return -1;
+    }
+    sci->reactor = 1;
+    sci->send_compact = 1;  // what the relay copies to adopted followers
+  }
+  sci->useless_vlc_object = vlc_custom_create(
       parent,
-      sizeof( *syn_ci_[i].useless_vlc_object ),
+      sizeof( *sci->useless_vlc_object ),
       "syn_connection_dymmy" );
 
-
+  int rv;
   if(type) {
-    syn_ci_[i].state = SYN_SERVER_INITIALIZING;
+    sci->state = SYN_SERVER_INITIALIZING;
   } else {
-    syn_ci_[i].state = SYN_CLIENT_INITIALIZING;
+    sci->state = SYN_CLIENT_INITIALIZING;
 
     // check key is valid
     if(!SynConnection_IsAddrValid(addr)) {
-      if(callback) {
-        (*callback)(-2, param);
-      }
-      return -2;
+      rv = -2;
+      goto error;
     }
 
 
-    int rv = char_to_uint64(&syn_ci_[i].address.relay_server_key, addr);
+    rv = char_to_uint64(&sci->address.relay_server_key, addr);
     assert(0 == rv);
   }
 
-  // Create Send Thread
-  int rv = vlc_clone(
-      &syn_ci_[i].send_thread,
-      &syn_send_thread,
-      (void*)i, 
-      SYN_THREAD_PRIORITY);
+  // The send thread may already tear the connection down, so the
+  // handle is filled in first
+  vlc_mutex_lock(&syn_table_lock_);
+  connection->index = i;
+  connection->generation = syn_slots_[i].generation;
+  vlc_mutex_unlock(&syn_table_lock_);
+
+  // Create Send Thread. Once connected, a reactor driven connection
+  // leaves this thread, nobody is left to join it.
+  if(sci->reactor) {
+    rv = vlc_clone_detach(
+        &sci->send_thread,
+        &syn_send_thread,
+        sci,
+        SYN_THREAD_PRIORITY);
+  } else {
+    rv = vlc_clone(
+        &sci->send_thread,
+        &syn_send_thread,
+        sci,
+        SYN_THREAD_PRIORITY);
+  }
   if(0 == rv) {
     return 0;
-  } else {
-    if(callback) {
-      (*callback)(-3, param);
-    }
-    return -3;
   }
+  connection->index = -1;
+  rv = -3;
+
+error:
+  free(sci->party);
+  vlc_object_release(sci->useless_vlc_object);
+  vlc_cond_destroy(&sci->send_info_non_empy);
+  vlc_mutex_destroy(&sci->lock);
+  memset(sci, 0, sizeof(*sci));
+  SynConnection_FreeSlot(i);
+  if(callback) {
+    (*callback)(rv, param);
+  }
+  return rv;
 }
 
 int SynConnection_InitializeAsServer(
@@ -471,6 +1089,30 @@ int SynConnection_InitializeAsServer(
       1  /* server */);
 }
 
+int SynConnection_InitializeAsPartyHost(
+    vlc_object_t* parent,
+    SynConnection* connection,
+    const char* server_addr,
+    int server_port,
+    SynConnection_ReceiveCallback* receive_callback,
+    void* receive_param,
+    SynConnection_Callback* host_key_callback,
+    void* host_key_param,
+    SynConnection_Callback* peer_connect_callback,
+    void* peer_connect_param
+) {
+  return SynConnection_InitializeHelper(
+      parent,
+      connection,
+      0,  /* addr */
+      server_addr, server_port,
+      receive_callback,
+      receive_param,
+      host_key_callback, host_key_param,
+      peer_connect_callback, peer_connect_param,
+      2  /* party host */);
+}
+
 int SynConnection_InitializeAsClient(
     vlc_object_t* parent,
     SynConnection* connection,
@@ -498,33 +1140,37 @@ int SynConnection_Destroy(
     SynConnection_Callback* callback,
     void* param
 ) {
-  int i = connection.index;
-  if(i < 0 || i >= MAX_CONNECTIONS) {
+  SynConnectionInternal* sci = SynConnection_Lookup(connection);
+  if(NULL == sci) {
     if(callback) {
       (*callback)(-1, param);
     }
     return -1;
   }
-  if(SYN_UNINITIALIZED == syn_ci_[i].state ||
-      SYN_DESTROYING == syn_ci_[i].state) {
+  if(SYN_UNINITIALIZED == sci->state ||
+      SYN_DESTROYING == sci->state) {
     if(callback) {
       (*callback)(-2, param);
     }
     return -2;
   }
-  SynConnectionInternal* sci = &syn_ci_[i];
 
   SynLock(sci);
     sci->state = SYN_DESTROYING;
     sci->destroy_callback = callback;
     sci->destroy_param = param;
     shutdown(sci->socket, SHUT_RDWR);
+    vlc_cond_signal(&sci->send_info_non_empy);  // may wait to resume
   SynUnlock(sci);
+  if(sci->reactor) {
+    syn_reactor_wake();
+  }
 
   return 0;
 }
 
-void syn_connection_append_send_info(
+// Returns -1 if out of memory
+int syn_connection_append_send_info(
     SynConnectionInternal* sci,
     SynConnection_Callback* callback,
     void* param,
@@ -532,22 +1178,24 @@ void syn_connection_append_send_info(
     void* buffer,
     uint64_t flag,
     uint64_t timestamp) {
-  SynConnection_SendInfo* send_info =
-    malloc(sizeof(SynConnection_SendInfo));
-  send_info->callback = callback;
-  send_info->param = param;
-  send_info->size = len + sizeof(SynSegmentHeader);
-  send_info->next = NULL;
-  send_info->buffer = malloc(len + sizeof(SynSegmentHeader));
-  SynSegmentHeader *header = (SynSegmentHeader*)send_info->buffer;
-  header->flag = flag;
-  header->timestamp_reply = timestamp;
-  header->length = len;
-  if(len > 0) {
-    memcpy(send_info->buffer + sizeof(SynSegmentHeader), buffer, len);
-  }
-
   SynLock(sci);
+    SynConnection_SendInfo* send_info = syn_send_info_get(sci, len);
+    if(NULL == send_info) {
+      SynUnlock(sci);
+      return -1;
+    }
+    send_info->callback = callback;
+    send_info->param = param;
+    send_info->size = len + sizeof(SynSegmentHeader);
+    send_info->next = NULL;
+    SynSegmentHeader *header = (SynSegmentHeader*)send_info->buffer;
+    header->flag = flag;
+    header->timestamp_reply = timestamp;
+    header->length = len;
+    if(len > 0) {
+      memcpy(send_info->buffer + sizeof(SynSegmentHeader), buffer, len);
+    }
+
     if(NULL == sci->send_info_head) {
       sci->send_info_head = sci->send_info_tail = send_info;
     } else {
@@ -556,6 +1204,36 @@ void syn_connection_append_send_info(
     }
     vlc_cond_signal(&sci->send_info_non_empy);
   SynUnlock(sci);
+  if(sci->reactor) {
+    syn_reactor_wake();
+  }
+  return 0;
+}
+
+int SynConnection_Resync(
+    SynConnection connection
+) {
+  SynConnectionInternal* sci = SynConnection_Lookup(connection);
+  if(NULL == sci) {
+    return -1;
+  }
+  if(SYN_INITIALIZED != sci->state) {
+    return -2;
+  }
+  if(sci->party) {
+    return 0;  // followers sync themselves, see syn_party.h
+  }
+
+  SynLock(sci);
+    sci->beacon_burst = SYN_BEACON_BURST;
+    sci->beacon_interval = SYN_BEACON_MIN;
+    sci->beacon_reschedule = 1;
+  SynUnlock(sci);
+  // stays a plain segment if a sync request is in flight already
+  if(0 != syn_connection_append_send_info(sci, 0, 0, 0, 0, SYNC_MASK, 0)) {
+    return -4;
+  }
+  return 0;
 }
 
 int SynConnection_Send(
@@ -565,18 +1243,22 @@ int SynConnection_Send(
     SynConnection_Callback* callback,
     void* param
 ) {
-  int i = connection.index;
-  if(i < 0 || i >= MAX_CONNECTIONS) {
+  SynConnectionInternal* sci = SynConnection_Lookup(connection);
+  if(NULL == sci) {
     return -1;
   }
-  if(SYN_INITIALIZED != syn_ci_[i].state) {
+  if(SYN_INITIALIZED != sci->state) {
     return -2;
   }
-  SynConnectionInternal* sci = &syn_ci_[i];
+  if(len > SYN_MAX_PAYLOAD) {
+    return -3;
+  }
 
-  syn_connection_append_send_info(
-      sci, callback, param, len, buffer,
-      SYNC_MASK | SYNC_END, 0);
+  if(0 != syn_connection_append_send_info(
+        sci, callback, param, len, buffer,
+        SYNC_MASK | SYNC_END, 0)) {
+    return -4;
+  }
 
   return 0;
 }
@@ -584,8 +1266,7 @@ int SynConnection_Send(
 size_t SynConnection_GetAddrLen(
     SynConnection connection
 ) {
-  int i = connection.index;
-  if(i < 0 || i >= MAX_CONNECTIONS) {
+  if(NULL == SynConnection_Lookup(connection)) {
     return -1;
   }
   return SYN_KEY_BUFFER_LENGTH + 1;
@@ -596,14 +1277,68 @@ int SynConnection_GetAddr(
     char* out_buffer,
     size_t len
 ) {
-  int i = connection.index;
-  if(i < 0 || i >= MAX_CONNECTIONS) {
+  SynConnectionInternal* sci = SynConnection_Lookup(connection);
+  if(NULL == sci) {
     return -1;
   }
   if(len < SYN_KEY_BUFFER_LENGTH + 1) {
     return -3;
   }
-  uint64_to_char(syn_ci_[i].address.relay_server_key, out_buffer);
+  uint64_to_char(sci->address.relay_server_key, out_buffer);
 
   return 0;
 }
+
+int SynConnection_GetWireVersion(
+    SynConnection connection
+) {
+  SynConnectionInternal* sci = SynConnection_Lookup(connection);
+  if(NULL == sci) {
+    return 0;
+  }
+  if(sci->party) {
+    return syn_party_wire_version(sci);
+  }
+  return sci->wire_version;
+}
+
+int SynConnection_GetClockOffset(
+    SynConnection connection,
+    mtime_t* offset,
+    mtime_t* error
+) {
+  SynConnectionInternal* sci = SynConnection_Lookup(connection);
+  if(NULL == sci) {
+    return -1;
+  }
+  int rv = 0;
+  SynLock(sci);
+    if(0 == sci->clock.count) {
+      rv = -2;
+    } else {
+      *offset = syn_clock_offset(&sci->clock, mdate());
+      *error = syn_clock_error(&sci->clock);
+    }
+  SynUnlock(sci);
+  return rv;
+}
+
+int SynConnection_GetStats(
+    SynConnection connection,
+    SynConnection_Stats* stats
+) {
+  SynConnectionInternal* sci = SynConnection_Lookup(connection);
+  if(NULL == sci) {
+    return -1;
+  }
+  SynLock(sci);
+    stats->rtt = sci->estimated_rtt;
+    stats->offset = syn_clock_offset(&sci->clock, mdate());
+    stats->offset_error = syn_clock_error(&sci->clock);
+    stats->bytes_sent = sci->bytes_sent;
+    stats->bytes_received = sci->bytes_received;
+    stats->beacons_sent = sci->count_sync;
+    stats->beacons_answered = sci->count_sync_reply;
+  SynUnlock(sci);
+  return 0;
+}
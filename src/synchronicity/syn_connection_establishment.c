@@ -1,7 +1,9 @@
 #include "synchronicity/syn_connection_establishment.h"
 #include <vlc_network.h>
+#include <vlc_rand.h>
 
 #include "synchronicity/syn_key_internal.h"
+#include "synchronicity/syn_party.h"
 
 int syn_connection_helper_connect_to_relay_server(SynConnectionInternal* const sci) {
   return net_ConnectTCP(sci->useless_vlc_object,
@@ -9,15 +11,19 @@ int syn_connection_helper_connect_to_relay_server(SynConnectionInternal* const s
       sci->relay_server_port);
 }
 
-int syn_connection_send_relay_server_key(uint64_t key, int sockfd) {
+int syn_connection_send_relay_server_key(SynConnectionInternal* const sci,
+    uint64_t key, int sockfd) {
   char key_buffer[SYN_KEY_BUFFER_LENGTH+1];
   uint64_to_char(key, key_buffer);
-  return csend_all(sockfd, &key_buffer, SYN_KEY_BUFFER_LENGTH, 0);
+  return csend_all(sockfd, &key_buffer, SYN_KEY_BUFFER_LENGTH,
+      sci->useless_vlc_object);
 }
 
-int syn_connection_recv_relay_server_key(uint64_t* key, int sockfd) {
+int syn_connection_recv_relay_server_key(SynConnectionInternal* const sci,
+    uint64_t* key, int sockfd) {
   char key_buffer[SYN_KEY_BUFFER_LENGTH+1];
-  int rv = srecv_all(sockfd, &key_buffer, SYN_KEY_BUFFER_LENGTH, 0);
+  int rv = srecv_all(sockfd, &key_buffer, SYN_KEY_BUFFER_LENGTH,
+      sci->useless_vlc_object);
   if(rv <= 0) {
     return -100 + rv;
   }
@@ -25,16 +31,17 @@ int syn_connection_recv_relay_server_key(uint64_t* key, int sockfd) {
 }
 
 int syn_connection_helper_relay_server_handshake(
+    SynConnectionInternal* const sci,
     uint64_t* key,
     int sockfd) {
   // Send hankshake key
-  int rv = syn_connection_send_relay_server_key(*key, sockfd);
+  int rv = syn_connection_send_relay_server_key(sci, *key, sockfd);
   if(rv < 0) {
     return -200 + rv;
   }
 
   // Receive hankshake key
-  rv = syn_connection_recv_relay_server_key(key, sockfd);
+  rv = syn_connection_recv_relay_server_key(sci, key, sockfd);
   if(rv < 0) {
     return -300 + rv;
   } else {
@@ -42,6 +49,44 @@ int syn_connection_helper_relay_server_handshake(
   }
 }
 
+// The handshake that also asks for a session token. A relay without
+// sessions takes SYN_SESSION_OPEN_KEY for a client key it does not know
+// and closes the connection, the plain handshake then runs on a new one.
+int syn_connection_helper_session_handshake(
+    SynConnectionInternal* const sci,
+    uint64_t* key,
+    int* sockfd) {
+  uint64_t request = *key;
+  uint64_t token = 0;
+  int rv = syn_connection_send_relay_server_key(sci, SYN_SESSION_OPEN_KEY,
+      *sockfd);
+  if(rv >= 0) {
+    rv = syn_connection_helper_relay_server_handshake(sci, key, *sockfd);
+  }
+  if(rv >= 0) {
+    rv = syn_connection_recv_relay_server_key(sci, &token, *sockfd);
+  }
+  if(rv >= 0) {
+    sci->session_token = token;
+    return 0;
+  }
+
+  msg_Dbg(sci->useless_vlc_object, "relay without sessions");
+  net_Close(*sockfd);
+  *sockfd = syn_connection_helper_connect_to_relay_server(sci);
+  if(*sockfd < 0) {
+    return *sockfd;
+  }
+  *key = request;
+  return syn_connection_helper_relay_server_handshake(sci, key, *sockfd);
+}
+
+// Whether to ask the relay for a session, parties have none
+static int syn_connection_wants_session(SynConnectionInternal* const sci) {
+  return !sci->party &&
+    var_InheritBool(sci->useless_vlc_object, "synchronicity-resume");
+}
+
 int syn_connection_host(SynConnectionInternal* const sci) {
   int sockfd = syn_connection_helper_connect_to_relay_server(sci);
   if(sockfd < 0) {
@@ -49,8 +94,10 @@ int syn_connection_host(SynConnectionInternal* const sci) {
   }
 
   // variables for handshake
-  uint64_t key = 0;
-  int rv = syn_connection_helper_relay_server_handshake(&key, sockfd);
+  uint64_t key = sci->party ? SYN_PARTY_HOST_KEY : 0;
+  int rv = syn_connection_wants_session(sci) ?
+    syn_connection_helper_session_handshake(sci, &key, &sockfd) :
+    syn_connection_helper_relay_server_handshake(sci, &key, sockfd);
   if(rv < 0) {
     return rv;
   }
@@ -78,7 +125,9 @@ int syn_connection_connect(SynConnectionInternal* const sci) {
   SynUnlock(sci);
 
   // handshake with relay server
-  int rv = syn_connection_helper_relay_server_handshake(&key, sockfd);
+  int rv = syn_connection_wants_session(sci) ?
+    syn_connection_helper_session_handshake(sci, &key, &sockfd) :
+    syn_connection_helper_relay_server_handshake(sci, &key, sockfd);
   if(rv < 0) {
     return rv;
   }
@@ -96,3 +145,67 @@ int syn_connection_connect(SynConnectionInternal* const sci) {
 
   return 0;
 }
+
+// One attempt at resuming. Returns the new socket, -1 if the relay is
+// out of reach and -2 if it no longer knows the session.
+static int syn_connection_resume_once(SynConnectionInternal* const sci) {
+  int sockfd = syn_connection_helper_connect_to_relay_server(sci);
+  if(sockfd < 0) {
+    return -1;
+  }
+  uint64_t reply = SYN_SESSION_UNKNOWN;
+  int rv = syn_connection_send_relay_server_key(sci, SYN_SESSION_RESUME_KEY,
+      sockfd);
+  if(rv >= 0) {
+    rv = syn_connection_send_relay_server_key(sci, sci->session_token,
+        sockfd);
+  }
+  if(rv >= 0) {
+    rv = syn_connection_recv_relay_server_key(sci, &reply, sockfd);
+  }
+  if(rv >= 0 && 0 == reply) {
+    return sockfd;
+  }
+  net_Close(sockfd);
+  return rv >= 0 ? -2 : -1;
+}
+
+int syn_connection_resume(SynConnectionInternal* const sci) {
+  const mtime_t deadline = mdate() + SYN_RESUME_TIMEOUT;
+  mtime_t backoff = SYN_RESUME_BACKOFF_MIN;
+  for(;;) {
+    int sockfd = syn_connection_resume_once(sci);
+    if(-2 == sockfd) {
+      return -600;
+    }
+
+    int destroying;
+    SynLock(sci);
+      destroying = SYN_DESTROYING == sci->state;
+      if(sockfd >= 0 && !destroying) {
+        sci->socket = sockfd;
+        SynUnlock(sci);
+        return 0;
+      }
+    SynUnlock(sci);
+    if(sockfd >= 0) {
+      net_Close(sockfd);
+    }
+    if(destroying) {
+      return -1000;
+    }
+
+    // peers that lost the network together should not retry in step
+    mtime_t until = mdate() + backoff + vlc_lrand48() % (backoff / 4 + 1);
+    if(until > deadline) {
+      return -601;
+    }
+    SynLock(sci);
+      while(SYN_DESTROYING != sci->state && mdate() < until) {
+        vlc_cond_timedwait(&sci->send_info_non_empy, &sci->lock, until);
+      }
+    SynUnlock(sci);
+    backoff = 2 * backoff < SYN_RESUME_BACKOFF_MAX ?
+      2 * backoff : SYN_RESUME_BACKOFF_MAX;
+  }
+}
@@ -3,16 +3,34 @@
 
 #include "synchronicity/syn_connection_internal.h"
 
+// Sent before the key to get a session token after the usual reply, and
+// before the token to resume the session; see relay_session.h. The relay
+// answers a resume with 0, or SYN_SESSION_UNKNOWN once it is over.
+#define SYN_SESSION_OPEN_KEY 2
+#define SYN_SESSION_RESUME_KEY 3
+#define SYN_SESSION_UNKNOWN 1
+
 // return sockfd or negative if failed
 int syn_connection_host(SynConnectionInternal* const sci);
 int syn_connection_connect(SynConnectionInternal* const sci);
 
-int syn_connection_send_relay_server_key(uint64_t key, int sockfd);
-int syn_connection_recv_relay_server_key(uint64_t* key, int sockfd);
+// Put the relay session back on a new socket once the old one is
+// closed, returns 0 on success
+int syn_connection_resume(SynConnectionInternal* const sci);
+
+int syn_connection_send_relay_server_key(SynConnectionInternal* const sci,
+    uint64_t key, int sockfd);
+int syn_connection_recv_relay_server_key(SynConnectionInternal* const sci,
+    uint64_t* key, int sockfd);
 
 // prototypes to shut up compiler
 int syn_connection_helper_connect_to_relay_server(SynConnectionInternal* const sci);
 int syn_connection_helper_relay_server_handshake(
+    SynConnectionInternal* const sci,
     uint64_t* key,
     int sockfd);
+int syn_connection_helper_session_handshake(
+    SynConnectionInternal* const sci,
+    uint64_t* key,
+    int* sockfd);
 #endif
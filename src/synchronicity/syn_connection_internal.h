@@ -1,27 +1,80 @@
 #ifndef SYN_CONNECTION_INTERNAL_H_
 #define SYN_CONNECTION_INTERNAL_H_
 
+#include <synchronicity/syn_clock.h>
 #include <synchronicity/syn_connection.h>
 #include "synchronicity/syn_key_internal.h"
+#include "synchronicity/syn_varint.h"
 
-#define MAX_CONNECTIONS 10
+#define SYN_INITIAL_CONNECTIONS 16  // connection table grows from here
 #define SYN_THREAD_PRIORITY 10
 
 #define SYN_CONNECTION_THRESHOLD 30000000
-#define SYN_INTERNAL_IN_MICROS 1000000
 #define SYNC_MASK 0x1
 #define SYNC_REPLY_MASK 0x2
 #define SYNC_END 0x4
+#define SYNC_HELLO 0x8      // timestamp_reply is the highest wire version we speak
+#define SYNC_UPGRADE 0x10   // the rest of this direction uses the compact format
 #define SYNC_ALPHA_INVERSE 4  // alpha is 1 / SYNC_ALPHA_INVERSE
-#define SYNC_BETA_INVERSE 4
 #define SYNC_INITIAL_COUNT 5
 
+// Sync beacons go out every SYN_BEACON_FAST while the clock estimate
+// fills up and for SYN_BEACON_BURST replies after a disruption: a reply
+// the estimate did not predict, a jump in round trip time or a resync
+// asked for. Otherwise the interval doubles with every reply, up to
+// SYN_BEACON_MAX for an estimate within SYN_BEACON_TOLERANCE and less
+// for a noisier one.
+#define SYN_BEACON_FAST 100000
+#define SYN_BEACON_MIN 1000000
+#define SYN_BEACON_MAX 20000000
+#define SYN_BEACON_BURST 4
+#define SYN_BEACON_TOLERANCE 5000
+#define SYN_BEACON_RTT_JUMP 2  // rtt factor that counts as a new path
+
+// A relay connection that breaks on an error is resumed when the relay
+// gave us a session token: the relay keeps the pair for a while and
+// both peers come back with their clock estimate, see relay_session.h.
+// Attempts back off from SYN_RESUME_BACKOFF_MIN to SYN_RESUME_BACKOFF_MAX
+// and stop after SYN_RESUME_TIMEOUT, the relay's default grace period.
+#define SYN_RESUME_TIMEOUT 60000000
+#define SYN_RESUME_BACKOFF_MIN 250000
+#define SYN_RESUME_BACKOFF_MAX 8000000
+
+// Wire format. Version 0 frames every message with a SynSegmentHeader.
+// From version 1 on a segment is a 16 bit big endian length and a body
+// of one flag byte, the varint sync timestamp, the varint reply
+// timestamp if SYNC_REPLY_MASK is set, then any number of messages,
+// each a varint length and its bytes. Peers announce their version with
+// SYNC_HELLO once connected and switch with SYNC_UPGRADE, so either side
+// can still talk to a peer without compact format support. Version 2
+// peers also know the coordinated start commands, version 3 peers the
+// item command.
+#define SYN_WIRE_VERSION 3
+#define SYN_COMPACT_PREFIX_LENGTH 2
+#define SYN_COMPACT_MAX_BODY 0xffff
+#define SYN_MAX_PAYLOAD \
+  (SYN_COMPACT_MAX_BODY - 1 - 3 * SYN_VARINT_MAX_LENGTH)
+
+struct SynSegmentHeader {
+  uint64_t flag;
+  uint64_t timestamp_sync;
+  uint64_t timestamp_reply;
+  uint64_t length;
+};
+typedef struct SynSegmentHeader SynSegmentHeader;
+
+// Send queue entries come from a per connection pool and hold small
+// payloads inline, so steady state sends do not touch the heap
+#define SYN_SEND_INLINE_PAYLOAD 128
+#define SYN_SEND_POOL_SIZE 32  // spare entries kept per connection
+
 struct SynConnection_SendInfo {
   struct SynConnection_SendInfo* next;
   SynConnection_Callback* callback;
   void* param;
   uint32_t size;
-  char* buffer;
+  char* buffer;  // header and payload, storage unless the payload is large
+  char storage[sizeof(SynSegmentHeader) + SYN_SEND_INLINE_PAYLOAD];
 };
 typedef struct SynConnection_SendInfo SynConnection_SendInfo;
 
@@ -38,6 +91,8 @@ struct Empty {
   VLC_COMMON_MEMBERS
 };
 
+typedef struct SynParty SynParty;
+
 struct SynConnectionInternal {
   vlc_mutex_t lock;  // protects this data structure
 
@@ -74,6 +129,8 @@ struct SynConnectionInternal {
   // link list of send buffers and callbacks
   SynConnection_SendInfo* send_info_head;
   SynConnection_SendInfo* send_info_tail;
+  SynConnection_SendInfo* send_info_free;  // pool of spare entries
+  int send_info_spare;
 
   // called when socket is destroyed
   SynConnection_Callback* destroy_callback;
@@ -82,21 +139,68 @@ struct SynConnectionInternal {
   int awaiting_reply;
   mtime_t await_start_time;
   mtime_t estimated_rtt;
-  int delta_t_initialized;
-  mtime_t delta_t_confidence;  // actually the inverse of the confidence
-  mtime_t delta_t;
+  SynClock clock;   // peer clock estimate, protected by lock
+  mtime_t delta_t;  // local minus peer clock, from clock
+
+  mtime_t beacon_interval;  // once the burst is over, protected by lock
+  int beacon_burst;         // fast beacons still to go
+  int beacon_reschedule;    // the reactor's timer for us is stale
+
+  unsigned int count_sync;        // sync requests sent
+  unsigned int count_sync_reply;  // sync replies received
+  uint64_t bytes_sent;            // segments and datagrams, protected by lock
+  uint64_t bytes_received;
+  int was_client;
+
+  uint64_t session_token;  // from the relay, 0 if it does not keep the pair
+  int link_broken;  // the receive thread wants a resume, protected by lock
+
+  int wire_version;  // agreed with the peer, 0 until its SYNC_HELLO arrived
+  int send_compact;  // our SYNC_UPGRADE went out
+  int recv_compact;  // the peer's SYNC_UPGRADE came in
+
+  // Segment on its way out and the send infos it carries
+  char* out_buffer;
+  size_t out_size;
+  char* out_storage; // compact segments are laid out here, kept
+  size_t out_capacity;
+  int out_upgrade;   // segment is our SYNC_UPGRADE
+  SynConnection_SendInfo* out_infos;
 
   struct Empty* useless_vlc_object;
+
+  // Only used when the shared I/O thread drives this connection, see
+  // syn_reactor.c; the connection then has no threads of its own.
+  int reactor;
+  SynSegmentHeader recv_header;  // compact: length is that of the body
+  uint8_t recv_prefix[SYN_COMPACT_PREFIX_LENGTH];
+  size_t recv_have;       // bytes of the current segment received so far
+  char* recv_payload;
+  mtime_t recv_delay;
+  size_t send_offset;     // bytes of out_buffer already sent
+  mtime_t next_beacon;
+  int heap_index;         // position in the reactor's timer heap
+  int conn_index;         // position in the reactor's poll set
+
+  // Party host and its followers, see syn_party.h
+  SynParty* party;                    // set on the party host only
+  struct SynConnectionInternal* hub;  // set on followers only
+  uint32_t member_id;                 // the relay's id for the follower
+  int adopted;                        // follower receives broadcasts
+
+  // Sync beacons over UDP, see syn_udp.h; protected by lock but for
+  // udp and udp_socket, which only change before and after the I/O
+  int udp;               // udp_socket is open
+  int udp_socket;
+  int udp_up;            // the peer answers over UDP, TCP beacons pause
+  int udp_awaiting;      // our last UDP beacon is on its way
+  mtime_t udp_sent;      // and went out then
+  int udp_misses;        // UDP beacons in a row that went unanswered
+
+  int slot;  // index in the connection table
 };
 typedef struct SynConnectionInternal SynConnectionInternal;
 
-struct SynSegmentHeader {
-  uint64_t flag;
-  uint64_t timestamp_sync;
-  uint64_t timestamp_reply;
-  uint64_t length;
-};
-typedef struct SynSegmentHeader SynSegmentHeader;
 
 
 // function prototypes
@@ -104,6 +208,27 @@ void SynLock(SynConnectionInternal* sci);
 void SynUnlock(SynConnectionInternal* sci);
 int csend_all(int socket, const void *buf, int len, struct Empty*);
 int srecv_all(int socket, void *buf, int len, struct Empty*);
+SynConnectionInternal* SynConnection_Lookup(SynConnection connection);
+
+// shared by the connection threads and the reactor
+// wire_size is what the segment took on the wire, for the statistics
+mtime_t syn_connection_handle_header(SynConnectionInternal* sci,
+    const SynSegmentHeader* header, size_t wire_size);
+mtime_t syn_connection_beacon_delay(SynConnectionInternal* sci);
+int syn_connection_wants_beacon(SynConnectionInternal* sci);
+void syn_connection_beacon(SynConnectionInternal* sci);
+void syn_connection_sync_sample(SynConnectionInternal* sci, mtime_t now,
+    mtime_t timestamp_sync, mtime_t timestamp_reply);
+int syn_connection_handle_segment(SynConnectionInternal* sci,
+    const uint8_t* body, size_t len);
+int syn_connection_take_segment(SynConnectionInternal* sci);
+void syn_connection_segment_done(SynConnectionInternal* sci, int rv);
+int syn_connection_timed_out(SynConnectionInternal* sci);
+int syn_connection_can_resume(SynConnectionInternal* sci, int rv);
+int syn_connection_relink(SynConnectionInternal* sci);
+void syn_connection_release(SynConnectionInternal* sci);
+SynConnectionInternal* syn_connection_new_member(SynConnectionInternal* hub,
+    uint32_t id);
 
 // prototypes to shut up compiler
 void* syn_receive_thread(void* param);
@@ -122,7 +247,7 @@ int SynConnection_InitializeHelper(
     SynConnection_Callback* peer_connect_callback,
     void* peer_connect_param,
     int type);
-void syn_connection_append_send_info(
+int syn_connection_append_send_info(
     SynConnectionInternal* sci,
     SynConnection_Callback* callback,
     void* param,
@@ -1,6 +1,7 @@
 #include <synchronicity/syn_parsing.h>
 
 #include <vlc_common.h>
+#include "synchronicity/syn_varint.h"
 
 // 8 characters for command, then data
 
@@ -11,14 +12,98 @@ const char* SynCommandTypeNames[] = {
   "play    ",
   "pause   ",
   "seek    ",
-  "beat    ",
-  "mynameis",
+  "beat    ",  // SYNCOMMAND_MYNAMEIS
+  "prepare ",
+  "ready   ",
+  "start   ",
+  "item    ",
   "error   "
 };
 
+// Binary format: SYNCOMMAND_BINARY_MARK | type, then the zigzag varint
+// time for play/pause/seek, the varint content key of an item or the
+// varint length and bytes of the name
+static SynCommand CommandFromBinary(const uint8_t* buffer, int length) {
+  SynCommand return_value;
+  memset(&return_value, 0, sizeof(return_value));
+  return_value.type = SYNCOMMAND_ERROR;
+  if (length < 1) {
+    return return_value;
+  }
+  int type = buffer[0] & ~SYNCOMMAND_BINARY_MARK;
+  uint64_t value;
+  int rv = syn_get_varint(buffer + 1, length - 1, &value);
+  if (rv < 0) {
+    return return_value;
+  }
+  switch (type) {
+    case SYNCOMMAND_PLAY:
+    case SYNCOMMAND_PAUSE:
+    case SYNCOMMAND_SEEK:
+    case SYNCOMMAND_PREPARE:
+    case SYNCOMMAND_READY:
+    case SYNCOMMAND_START:
+      return_value.data.i_time = syn_unzigzag(value);
+      break;
+    case SYNCOMMAND_ITEM:
+      return_value.data.i_int = (int64_t)value;
+      break;
+    case SYNCOMMAND_MYNAMEIS:
+      if (value >= MESSAGE_LENGTH || value > (uint64_t)(length - 1 - rv)) {
+        return return_value;
+      }
+      memcpy(return_value.message, buffer + 1 + rv, value);
+      break;
+    default:
+      return return_value;
+  }
+  return_value.type = type;
+  return return_value;
+}
+
+static int BinaryFromCommand(SynCommand command, uint8_t* outbuffer,
+    int length) {
+  uint8_t encoded[1 + SYN_VARINT_MAX_LENGTH + MESSAGE_LENGTH];
+  int num_bytes = 1;
+  encoded[0] = SYNCOMMAND_BINARY_MARK | command.type;
+  switch (command.type) {
+    case SYNCOMMAND_PLAY:
+    case SYNCOMMAND_PAUSE:
+    case SYNCOMMAND_SEEK:
+    case SYNCOMMAND_PREPARE:
+    case SYNCOMMAND_READY:
+    case SYNCOMMAND_START:
+      num_bytes += syn_put_varint(encoded + num_bytes,
+          syn_zigzag(command.data.i_time));
+      break;
+    case SYNCOMMAND_ITEM:
+      num_bytes += syn_put_varint(encoded + num_bytes,
+          (uint64_t)command.data.i_int);
+      break;
+    case SYNCOMMAND_MYNAMEIS:
+      {
+        size_t name_length = strnlen(command.message, MESSAGE_LENGTH - 1);
+        num_bytes += syn_put_varint(encoded + num_bytes, name_length);
+        memcpy(encoded + num_bytes, command.message, name_length);
+        num_bytes += name_length;
+      }
+      break;
+    default:
+      return -1;
+  }
+  if (length < num_bytes) {
+    return -2;
+  }
+  memcpy(outbuffer, encoded, num_bytes);
+  return num_bytes;
+}
+
 SynCommand CommandFromString(char* buffer, int length) {
   SynCommand return_value;
   return_value.type = SYNCOMMAND_ERROR;
+  if (length > 0 && (buffer[0] & SYNCOMMAND_BINARY_MARK)) {
+    return CommandFromBinary((const uint8_t*)buffer, length);
+  }
   if (length < COMMAND_LENGTH) {
     return return_value;
   }
@@ -80,3 +165,11 @@ int StringFromCommand(SynCommand command, char* outbuffer, int length) {
   return COMMAND_LENGTH;
 }
 
+
+int SynCommand_Encode(SynCommand command, char* outbuffer, int length,
+    int version) {
+  if (version < 1) {
+    return StringFromCommand(command, outbuffer, length);
+  }
+  return BinaryFromCommand(command, (uint8_t*)outbuffer, length);
+}
@@ -0,0 +1,363 @@
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "synchronicity/syn_party.h"
+#include "synchronicity/syn_reactor.h"
+
+#include <vlc_network.h>
+#include <assert.h>
+#include <errno.h>
+#include "libvlc.h"
+
+#ifndef MSG_NOSIGNAL
+# define MSG_NOSIGNAL 0
+#endif
+
+struct SynParty {
+  // Followers in join order. Only the I/O thread changes the list, with
+  // the party host's lock held so other threads can read it under it.
+  SynConnectionInternal** members;
+  size_t num_members;
+  size_t max_members;
+
+  // frame being received
+  uint8_t in_header[SYN_PARTY_FRAME_HEADER];
+  size_t in_have;                    // header bytes received so far
+  uint32_t in_id;
+  size_t in_left;                    // payload bytes still to come
+  SynConnectionInternal* in_member;  // where a data frame goes, if anywhere
+
+  // frames on their way out
+  uint8_t* out;
+  size_t out_size;
+  size_t out_sent;
+  size_t out_capacity;
+};
+
+SynParty* syn_party_new(void) {
+  return calloc(1, sizeof(SynParty));
+}
+
+static SynConnectionInternal* syn_party_find(SynParty* p, uint32_t id) {
+  for(size_t i = 0; i < p->num_members; ++i) {
+    if(p->members[i]->member_id == id) {
+      return p->members[i];
+    }
+  }
+  return NULL;
+}
+
+// Queue one frame towards the relay. Returns -1 if out of memory.
+static int syn_party_frame(SynParty* p, int type, uint32_t id,
+    const char* payload, size_t len) {
+  assert(len <= SYN_PARTY_MAX_PAYLOAD);
+  size_t need = p->out_size + SYN_PARTY_FRAME_HEADER + len;
+  if(need > p->out_capacity) {
+    size_t capacity = p->out_capacity ? 2 * p->out_capacity : 4096;
+    while(capacity < need) {
+      capacity *= 2;
+    }
+    uint8_t* out = realloc(p->out, capacity);
+    if(NULL == out) {
+      return -1;
+    }
+    p->out = out;
+    p->out_capacity = capacity;
+  }
+  uint8_t* header = p->out + p->out_size;
+  header[0] = (uint8_t)type;
+  header[1] = (uint8_t)(id >> 24);
+  header[2] = (uint8_t)(id >> 16);
+  header[3] = (uint8_t)(id >> 8);
+  header[4] = (uint8_t)id;
+  header[5] = (uint8_t)(len >> 8);
+  header[6] = (uint8_t)len;
+  if(len > 0) {
+    memcpy(header + SYN_PARTY_FRAME_HEADER, payload, len);
+  }
+  p->out_size = need;
+  return 0;
+}
+
+// Bytes for follower id, or for every adopted follower if id is 0
+static int syn_party_data(SynParty* p, uint32_t id, const char* data,
+    size_t len) {
+  while(len > 0) {
+    size_t n = len < SYN_PARTY_MAX_PAYLOAD ? len : SYN_PARTY_MAX_PAYLOAD;
+    if(0 != syn_party_frame(p, SYN_PARTY_DATA, id, data, n)) {
+      return -1;
+    }
+    data += n;
+    len -= n;
+  }
+  return 0;
+}
+
+static void syn_party_join(SynConnectionInternal* hub, uint32_t id) {
+  SynParty* p = hub->party;
+  SynConnectionInternal* member = NULL;
+  if(p->num_members == p->max_members) {
+    size_t max = p->max_members ? 2 * p->max_members : SYN_INITIAL_CONNECTIONS;
+    SynLock(hub);
+      SynConnectionInternal** members =
+        realloc(p->members, max * sizeof(*members));
+      if(NULL != members) {
+        p->members = members;
+        p->max_members = max;
+      }
+    SynUnlock(hub);
+    if(NULL == members) {
+      goto error;
+    }
+  }
+  member = syn_connection_new_member(hub, id);
+  if(NULL == member) {
+    goto error;
+  }
+  SynLock(hub);
+    p->members[p->num_members++] = member;
+  SynUnlock(hub);
+  msg_Dbg(hub->useless_vlc_object, "follower %u joined", id);
+  return;
+
+error:
+  msg_Err(hub->useless_vlc_object, "no room for follower %u", id);
+  syn_party_frame(p, SYN_PARTY_LEAVE, id, NULL, 0);
+}
+
+// Tear a follower down without a word to the receive callback, the
+// party goes on. The relay is told unless the follower left by itself.
+static void syn_party_drop(SynConnectionInternal* hub,
+    SynConnectionInternal* member, int tell_relay) {
+  SynParty* p = hub->party;
+  SynLock(hub);
+    for(size_t i = 0; i < p->num_members; ++i) {
+      if(p->members[i] == member) {
+        memmove(p->members + i, p->members + i + 1,
+            (p->num_members - i - 1) * sizeof(*p->members));
+        p->num_members--;
+        break;
+      }
+    }
+  SynUnlock(hub);
+  if(p->in_member == member) {
+    p->in_member = NULL;
+  }
+  if(tell_relay) {
+    syn_party_frame(p, SYN_PARTY_LEAVE, member->member_id, NULL, 0);
+  }
+  msg_Dbg(hub->useless_vlc_object, "follower %u left", member->member_id);
+
+  SynLock(member);
+    member->state = SYN_DESTROYING;
+  SynUnlock(member);
+  free(member->recv_payload);
+  syn_connection_release(member);
+}
+
+void syn_party_free(SynConnectionInternal* hub) {
+  SynParty* p = hub->party;
+  while(p->num_members > 0) {
+    syn_party_drop(hub, p->members[p->num_members - 1], 0);
+  }
+  free(p->members);
+  free(p->out);
+  free(p);
+  hub->party = NULL;
+}
+
+// A frame header is complete
+static void syn_party_frame_started(SynConnectionInternal* hub) {
+  SynParty* p = hub->party;
+  const uint8_t* header = p->in_header;
+  int type = header[0];
+  p->in_id = ((uint32_t)header[1] << 24) | (header[2] << 16) |
+    (header[3] << 8) | header[4];
+  p->in_left = (header[5] << 8) | header[6];
+  p->in_member = NULL;
+  switch(type) {
+    case SYN_PARTY_DATA:
+      p->in_member = syn_party_find(p, p->in_id);
+      break;
+    case SYN_PARTY_JOIN:
+      syn_party_join(hub, p->in_id);
+      break;
+    case SYN_PARTY_LEAVE:
+      {
+        SynConnectionInternal* member = syn_party_find(p, p->in_id);
+        if(NULL != member) {
+          syn_party_drop(hub, member, 0);
+        }
+      }
+      break;
+    default:
+      break;  // payload is skipped
+  }
+}
+
+// Returns 1 if the connection is fine, 0 once the relay closed it and
+// -1 on error
+int syn_party_read(SynConnectionInternal* hub) {
+  SynParty* p = hub->party;
+  char buffer[SYN_REACTOR_READ_SIZE];
+  for(;;) {
+    ssize_t rv = recv(hub->socket, buffer, sizeof(buffer), 0);
+    if(rv < 0) {
+      if(net_errno == EINTR) {
+        continue;
+      }
+      if(net_errno == EAGAIN || net_errno == EWOULDBLOCK) {
+        return 1;
+      }
+      return -1;
+    }
+    if(0 == rv) {
+      return 0;
+    }
+
+    size_t at = 0;
+    while(at < (size_t)rv) {
+      size_t left = rv - at;
+      if(p->in_have < SYN_PARTY_FRAME_HEADER) {
+        size_t n = SYN_PARTY_FRAME_HEADER - p->in_have;
+        n = n < left ? n : left;
+        memcpy(p->in_header + p->in_have, buffer + at, n);
+        p->in_have += n;
+        at += n;
+        if(p->in_have < SYN_PARTY_FRAME_HEADER) {
+          break;
+        }
+        syn_party_frame_started(hub);
+      } else {
+        size_t n = p->in_left < left ? p->in_left : left;
+        if(NULL != p->in_member &&
+            0 != syn_reactor_feed(p->in_member, buffer + at, n)) {
+          msg_Err(hub->useless_vlc_object, "dropping follower %u", p->in_id);
+          syn_party_drop(hub, p->in_member, 1);
+        }
+        at += n;
+        p->in_left -= n;
+      }
+      if(0 == p->in_left) {
+        p->in_have = 0;  // next frame
+      }
+    }
+  }
+}
+
+// Lay out what is queued as frames: what was sent on the party host is
+// broadcast, with copies for followers not adopted yet, then what every
+// follower's own connection has. A follower speaking the compact format
+// is adopted into broadcasts. Returns 1 if frames were added, 0 if
+// there was nothing to send and -1 if out of memory.
+static int syn_party_fill(SynConnectionInternal* hub) {
+  SynParty* p = hub->party;
+  const size_t before = p->out_size;
+  int rv;
+
+  if(syn_connection_take_segment(hub)) {
+    for(size_t i = 0; i < p->num_members; ++i) {
+      SynConnectionInternal* member = p->members[i];
+      if(member->adopted) {
+        continue;
+      }
+      for(SynConnection_SendInfo* send_info = hub->out_infos;
+          NULL != send_info; send_info = send_info->next) {
+        const SynSegmentHeader* header =
+          (const SynSegmentHeader*)send_info->buffer;
+        syn_connection_append_send_info(member, 0, 0, header->length,
+            send_info->buffer + sizeof(*header),
+            header->flag, header->timestamp_reply);
+      }
+    }
+    rv = syn_party_data(p, 0, hub->out_buffer, hub->out_size);
+    syn_connection_segment_done(hub, rv);
+    if(rv < 0) {
+      return -1;
+    }
+  }
+
+  for(size_t i = 0; i < p->num_members; ++i) {
+    SynConnectionInternal* member = p->members[i];
+    while(syn_connection_take_segment(member)) {
+      rv = syn_party_data(p, member->member_id,
+          member->out_buffer, member->out_size);
+      syn_connection_segment_done(member, rv);
+      if(rv < 0) {
+        return -1;
+      }
+    }
+    if(member->send_compact && !member->adopted) {
+      if(0 != syn_party_frame(p, SYN_PARTY_JOIN, member->member_id,
+            NULL, 0)) {
+        return -1;
+      }
+      member->adopted = 1;
+    }
+  }
+  return p->out_size > before;
+}
+
+// Returns 1 if the connection is fine and -1 on error
+int syn_party_write(SynConnectionInternal* hub) {
+  SynParty* p = hub->party;
+  for(;;) {
+    if(p->out_sent == p->out_size) {
+      p->out_sent = p->out_size = 0;
+      int rv = syn_party_fill(hub);
+      if(rv < 0) {
+        msg_Err(hub->useless_vlc_object, "party out of memory");
+        return -1;
+      }
+      if(0 == rv) {
+        return 1;
+      }
+    }
+    ssize_t rv = send(hub->socket, p->out + p->out_sent,
+        p->out_size - p->out_sent, MSG_NOSIGNAL);
+    if(rv < 0) {
+      if(net_errno == EINTR) {
+        continue;
+      }
+      if(net_errno == EAGAIN || net_errno == EWOULDBLOCK) {
+        return 1;
+      }
+      msg_Err(hub->useless_vlc_object, "send error %m");
+      return -1;
+    }
+    p->out_sent += rv;
+  }
+}
+
+int syn_party_wants_write(SynConnectionInternal* hub) {
+  SynParty* p = hub->party;
+  if(p->out_sent < p->out_size) {
+    return 1;
+  }
+  int want = 0;
+  SynLock(hub);
+    want = NULL != hub->send_info_head;
+  SynUnlock(hub);
+  for(size_t i = 0; !want && i < p->num_members; ++i) {
+    SynConnectionInternal* member = p->members[i];
+    SynLock(member);
+      want = NULL != member->send_info_head;
+    SynUnlock(member);
+  }
+  return want;
+}
+
+int syn_party_wire_version(SynConnectionInternal* hub) {
+  int version = 0;
+  SynLock(hub);
+    SynParty* p = hub->party;
+    for(size_t i = 0; NULL != p && i < p->num_members; ++i) {
+      int member_version = p->members[i]->wire_version;
+      if(0 == i || member_version < version) {
+        version = member_version;
+      }
+    }
+  SynUnlock(hub);
+  return version;
+}
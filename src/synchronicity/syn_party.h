@@ -0,0 +1,41 @@
+#ifndef SYN_PARTY_H_
+#define SYN_PARTY_H_
+
+#include "synchronicity/syn_connection_internal.h"
+
+// A party host opens one relay session that any number of followers
+// join with its key. The relay frames everything between itself and
+// the host, see relay_party.h; followers talk to the host exactly as
+// with a paired connection and do not know about the party.
+//
+// On the host every follower gets a member connection of its own, with
+// its own clock estimate, wire version and send queue but no socket:
+// the shared I/O thread runs their bytes through the party host socket.
+// What is sent on the party host goes out once and the relay copies it
+// to every follower taken into broadcasts, which happens once the
+// follower speaks the compact format. Until then it gets copies through
+// its member connection.
+#define SYN_PARTY_HOST_KEY 1  // sent to the relay instead of 0
+
+#define SYN_PARTY_FRAME_HEADER 7  // type, follower id, payload length
+#define SYN_PARTY_MAX_PAYLOAD 0xffff
+#define SYN_PARTY_DATA 0
+#define SYN_PARTY_JOIN 1
+#define SYN_PARTY_LEAVE 2
+
+// Returns NULL if out of memory
+SynParty* syn_party_new(void);
+
+// Tears down every member and frees the party once the host connection
+// is closed. Only called by the I/O thread or before it took over.
+void syn_party_free(SynConnectionInternal* hub);
+
+// Driven by the I/O thread like syn_reactor_read and syn_reactor_write
+int syn_party_read(SynConnectionInternal* hub);
+int syn_party_write(SynConnectionInternal* hub);
+int syn_party_wants_write(SynConnectionInternal* hub);
+
+// Lowest wire version among the followers, 0 while there is none
+int syn_party_wire_version(SynConnectionInternal* hub);
+
+#endif
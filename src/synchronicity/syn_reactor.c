@@ -0,0 +1,516 @@
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "synchronicity/syn_reactor.h"
+#include "synchronicity/syn_party.h"
+
+#include <vlc_fs.h>
+#include <vlc_network.h>
+#include <vlc_threads.h>
+#include <vlc_tracer.h>
+#include <assert.h>
+#include <errno.h>
+#ifdef HAVE_UNISTD_H
+#   include <unistd.h>
+#endif
+#ifdef HAVE_POLL
+#   include <poll.h>
+#endif
+#include "libvlc.h"
+
+#ifndef MSG_NOSIGNAL
+# define MSG_NOSIGNAL 0
+#endif
+
+// With --synchronicity-reactor, connections that are up are driven by
+// this one thread instead of a send and a receive thread each. It polls
+// every socket at once and times the sync beacons of all connections
+// from a binary heap ordered by due date.
+//
+// Establishing a connection still happens on a thread of its own, since
+// the relay handshake blocks; that thread exits once it handed the
+// connection over.
+struct SynReactor {
+  vlc_mutex_t lock;  // protects the fields up to the wake pipe
+  int running;
+  int started;       // thread is set, may have exited since
+  vlc_thread_t thread;
+  int wake_pending;  // a byte is in the wake pipe already
+
+  // added but not yet picked up by the thread
+  SynConnectionInternal** pending;
+  size_t num_pending;
+  size_t max_pending;
+
+  int wake_fd[2];
+
+  // only touched by the reactor thread
+  SynConnectionInternal** conns;
+  SynConnectionInternal** heap;  // the same connections, by next_beacon
+  struct pollfd* fds;            // fds[0] is the wake pipe
+  int* status;
+  size_t num_conns;
+  size_t max_conns;
+};
+typedef struct SynReactor SynReactor;
+
+static SynReactor syn_reactor_ = {
+  .lock = VLC_STATIC_MUTEX,
+  .wake_fd = { -1, -1 },
+};
+
+static void* syn_reactor_thread(void* param);
+
+// Timer heap
+
+static void syn_reactor_heap_swap(SynReactor* r, size_t i, size_t j) {
+  SynConnectionInternal* tmp = r->heap[i];
+  r->heap[i] = r->heap[j];
+  r->heap[j] = tmp;
+  r->heap[i]->heap_index = i;
+  r->heap[j]->heap_index = j;
+}
+
+static void syn_reactor_heap_up(SynReactor* r, size_t i) {
+  while(i > 0 && r->heap[(i - 1) / 2]->next_beacon > r->heap[i]->next_beacon) {
+    syn_reactor_heap_swap(r, i, (i - 1) / 2);
+    i = (i - 1) / 2;
+  }
+}
+
+static void syn_reactor_heap_down(SynReactor* r, size_t i) {
+  for(;;) {
+    size_t smallest = i;
+    size_t left = 2 * i + 1;
+    size_t right = left + 1;
+    if(left < r->num_conns &&
+        r->heap[left]->next_beacon < r->heap[smallest]->next_beacon) {
+      smallest = left;
+    }
+    if(right < r->num_conns &&
+        r->heap[right]->next_beacon < r->heap[smallest]->next_beacon) {
+      smallest = right;
+    }
+    if(smallest == i) {
+      return;
+    }
+    syn_reactor_heap_swap(r, i, smallest);
+    i = smallest;
+  }
+}
+
+// Connections
+
+// Make room for one more connection. Returns 0 on success.
+static int syn_reactor_reserve(SynReactor* r) {
+  if(r->num_conns < r->max_conns) {
+    return 0;
+  }
+  size_t max = r->max_conns ? 2 * r->max_conns : SYN_INITIAL_CONNECTIONS;
+  SynConnectionInternal** conns = realloc(r->conns, max * sizeof(*conns));
+  if(NULL == conns) {
+    return -1;
+  }
+  r->conns = conns;
+  SynConnectionInternal** heap = realloc(r->heap, max * sizeof(*heap));
+  if(NULL == heap) {
+    return -1;
+  }
+  r->heap = heap;
+  struct pollfd* fds = realloc(r->fds, (max + 1) * sizeof(*fds));
+  if(NULL == fds) {
+    return -1;
+  }
+  r->fds = fds;
+  int* status = realloc(r->status, max * sizeof(*status));
+  if(NULL == status) {
+    return -1;
+  }
+  r->status = status;
+  r->max_conns = max;
+  return 0;
+}
+
+// Last step of tearing a connection down. Unless it is being destroyed
+// anyway, rv is reported to the receive callback as the reason.
+static void syn_reactor_release(SynConnectionInternal* sci, int rv) {
+  SynLock(sci);
+    int destroying = SYN_DESTROYING == sci->state;
+    sci->state = SYN_DESTROYING;
+  SynUnlock(sci);
+  if(!destroying) {
+    (*sci->receive_callback)(rv, sci->estimated_rtt / 2,
+        sci->receive_param, 0, 0);
+    if(sci->peer_connect_callback) {
+      (*sci->peer_connect_callback)(-5, sci->peer_connect_param);
+    }
+  }
+  syn_connection_release(sci);
+}
+
+// The relay handshake blocks, so a connection whose relay connection
+// broke gets its session back on a thread of its own, like it was
+// established, and is handed over again.
+static void* syn_reactor_resume_thread(void* param) {
+  SynConnectionInternal* sci = param;
+  int rv = syn_connection_relink(sci);
+  if(0 == rv) {
+    if(0 == syn_reactor_add(sci)) {
+      return NULL;
+    }
+    net_Close(sci->socket);
+    rv = -4;
+  }
+  syn_reactor_release(sci, rv);
+  return NULL;
+}
+
+// Take a connection out of the poll set. It is torn down, unless the
+// relay keeps its session and rv lets it resume.
+static void syn_reactor_close(SynReactor* r, SynConnectionInternal* sci,
+    int rv) {
+  SynLock(sci);
+    int resume = SYN_DESTROYING != sci->state &&
+      syn_connection_can_resume(sci, rv);
+  SynUnlock(sci);
+
+  shutdown(sci->socket, SHUT_RDWR);
+  net_Close(sci->socket);
+  sci->socket = -1;
+  free(sci->recv_payload);
+  sci->recv_payload = NULL;
+
+  if(sci->heap_index >= 0) {
+    size_t i = sci->heap_index;
+    size_t last = --r->num_conns;
+    // heap and conns shrink together, num_conns is already the new size
+    if(i != last) {
+      r->heap[i] = r->heap[last];
+      r->heap[i]->heap_index = i;
+      syn_reactor_heap_down(r, i);
+      syn_reactor_heap_up(r, i);
+    }
+    size_t j = sci->conn_index;
+    if(j != last) {
+      r->conns[j] = r->conns[last];
+      r->conns[j]->conn_index = j;
+    }
+  }
+
+  if(resume && 0 == vlc_clone_detach(&sci->send_thread,
+        syn_reactor_resume_thread, sci, SYN_THREAD_PRIORITY)) {
+    return;
+  }
+  syn_reactor_release(sci, rv);
+}
+
+// Move connections added since the last round into the poll set
+static void syn_reactor_take_pending(SynReactor* r) {
+  mtime_t now = mdate();
+  for(size_t i = 0; i < r->num_pending; ++i) {
+    SynConnectionInternal* sci = r->pending[i];
+    sci->heap_index = -1;
+    if(0 != syn_reactor_reserve(r)) {
+      syn_reactor_close(r, sci, -1);
+      continue;
+    }
+    sci->conn_index = r->num_conns;
+    r->conns[r->num_conns] = sci;
+    sci->heap_index = r->num_conns;
+    r->heap[r->num_conns] = sci;
+    sci->next_beacon = now + syn_connection_beacon_delay(sci);
+    r->num_conns++;
+    syn_reactor_heap_up(r, sci->heap_index);
+  }
+  r->num_pending = 0;
+}
+
+int syn_reactor_feed(SynConnectionInternal* sci, const char* data,
+    size_t len) {
+  while(len > 0) {
+    // the peer's upgrade switches the framing between two segments
+    const int compact = sci->recv_compact;
+    const size_t header_size = compact ?
+      SYN_COMPACT_PREFIX_LENGTH : sizeof(sci->recv_header);
+    char* head = compact ?
+      (char*)sci->recv_prefix : (char*)&sci->recv_header;
+    size_t n;
+    if(sci->recv_have < header_size) {
+      n = header_size - sci->recv_have;
+      n = n < len ? n : len;
+      memcpy(head + sci->recv_have, data, n);
+    } else {
+      size_t have = sci->recv_have - header_size;
+      n = sci->recv_header.length - have;
+      n = n < len ? n : len;
+      memcpy(sci->recv_payload + have, data, n);
+    }
+    data += n;
+    len -= n;
+    sci->recv_have += n;
+
+    if(compact) {
+      if(sci->recv_have == header_size) {
+        // a body has its flag byte at least
+        sci->recv_header.length =
+          (sci->recv_prefix[0] << 8) | sci->recv_prefix[1];
+        sci->recv_payload = 0 == sci->recv_header.length ?
+          NULL : malloc(sci->recv_header.length);
+        if(NULL == sci->recv_payload) {
+          return -1;
+        }
+      } else if(sci->recv_have == header_size + sci->recv_header.length) {
+        int handled = syn_connection_handle_segment(sci,
+            (uint8_t*)sci->recv_payload, sci->recv_header.length);
+        free(sci->recv_payload);
+        sci->recv_payload = NULL;
+        sci->recv_have = 0;
+        if(handled < 0) {
+          msg_Err(sci->useless_vlc_object, "malformed segment");
+          return -1;
+        }
+      }
+    } else if(sci->recv_have == header_size) {
+      sci->recv_delay = syn_connection_handle_header(sci, &sci->recv_header,
+          header_size + sci->recv_header.length);
+      if(0 == sci->recv_header.length) {
+        sci->recv_have = 0;
+      } else {
+        sci->recv_payload = malloc(sci->recv_header.length);
+        if(NULL == sci->recv_payload) {
+          return -1;
+        }
+      }
+    } else if(sci->recv_have == header_size + sci->recv_header.length) {
+      (*sci->receive_callback)(sci->recv_header.length, sci->recv_delay,
+          sci->receive_param, sci->recv_payload, sci->recv_header.length);
+      free(sci->recv_payload);
+      sci->recv_payload = NULL;
+      sci->recv_have = 0;
+    }
+  }
+  return 0;
+}
+
+// Read whatever arrived. Returns 1 if the connection is fine, 0 once
+// the peer closed it and -1 on error.
+static int syn_reactor_read(SynConnectionInternal* sci) {
+  char buffer[SYN_REACTOR_READ_SIZE];
+  for(;;) {
+    ssize_t rv = recv(sci->socket, buffer, sizeof(buffer), 0);
+    if(rv < 0) {
+      if(net_errno == EINTR) {
+        continue;
+      }
+      if(net_errno == EAGAIN || net_errno == EWOULDBLOCK) {
+        return 1;
+      }
+      return -1;
+    }
+    if(0 == rv) {
+      return 0;
+    }
+    VLC_TRACE_COUNTER("syn receive", rv);
+    if(0 != syn_reactor_feed(sci, buffer, rv)) {
+      return -1;
+    }
+  }
+}
+
+// Send queued segments until the socket is full. Returns 1 if the
+// connection is fine and -1 on error.
+static int syn_reactor_write(SynConnectionInternal* sci) {
+  for(;;) {
+    if(NULL == sci->out_buffer) {
+      if(!syn_connection_take_segment(sci)) {
+        return 1;
+      }
+      sci->send_offset = 0;
+    }
+    ssize_t rv = send(sci->socket, sci->out_buffer + sci->send_offset,
+        sci->out_size - sci->send_offset, MSG_NOSIGNAL);
+    if(rv < 0) {
+      if(net_errno == EINTR) {
+        continue;
+      }
+      if(net_errno == EAGAIN || net_errno == EWOULDBLOCK) {
+        return 1;
+      }
+      msg_Err(sci->useless_vlc_object, "send error %m");
+      return -1;
+    }
+    VLC_TRACE_COUNTER("syn send", rv);
+    sci->send_offset += rv;
+    if(sci->send_offset < sci->out_size) {
+      continue;
+    }
+    sci->send_offset = 0;
+    syn_connection_segment_done(sci, 0);
+  }
+}
+
+// Fire every beacon timer that is due
+static void syn_reactor_run_timers(SynReactor* r) {
+  mtime_t now = mdate();
+  while(r->num_conns > 0 && r->heap[0]->next_beacon <= now) {
+    SynConnectionInternal* sci = r->heap[0];
+    if(syn_connection_timed_out(sci)) {
+      syn_reactor_close(r, sci, -1);
+      continue;
+    }
+    SynLock(sci);
+      int idle = NULL == sci->send_info_head && NULL == sci->out_buffer;
+    SynUnlock(sci);
+    if(idle) {
+      syn_connection_beacon(sci);
+    }
+    sci->next_beacon = now + syn_connection_beacon_delay(sci);
+    syn_reactor_heap_down(r, 0);
+  }
+}
+
+static void* syn_reactor_thread(void* param) {
+  SynReactor* r = param;
+  for(;;) {
+    vlc_mutex_lock(&r->lock);
+      syn_reactor_take_pending(r);
+      if(0 == r->num_conns) {
+        // Next syn_reactor_add() starts a new thread
+        r->running = 0;
+        vlc_mutex_unlock(&r->lock);
+        break;
+      }
+    vlc_mutex_unlock(&r->lock);
+
+    // Drop connections being destroyed and collect what the rest wait for
+    for(size_t i = 0; i < r->num_conns;) {
+      SynConnectionInternal* sci = r->conns[i];
+      SynLock(sci);
+        int destroying = SYN_DESTROYING == sci->state;
+        int want_write = NULL != sci->send_info_head ||
+          NULL != sci->out_buffer;
+        int reschedule = sci->beacon_reschedule;
+        sci->beacon_reschedule = 0;
+      SynUnlock(sci);
+      if(reschedule && !destroying) {
+        sci->next_beacon = mdate() + syn_connection_beacon_delay(sci);
+        syn_reactor_heap_down(r, sci->heap_index);
+        syn_reactor_heap_up(r, sci->heap_index);
+      }
+      if(!destroying && sci->party) {
+        want_write = syn_party_wants_write(sci);
+      }
+      if(destroying) {
+        syn_reactor_close(r, sci, 0);
+        continue;  // another connection took slot i
+      }
+      r->fds[i + 1].fd = sci->socket;
+      r->fds[i + 1].events = POLLIN | (want_write ? POLLOUT : 0);
+      r->fds[i + 1].revents = 0;
+      ++i;
+    }
+    if(0 == r->num_conns) {
+      continue;
+    }
+    r->fds[0].fd = r->wake_fd[0];
+    r->fds[0].events = POLLIN;
+    r->fds[0].revents = 0;
+
+    mtime_t due = r->heap[0]->next_beacon - mdate();
+    int timeout = due <= 0 ? 0 : (int)((due + 999) / 1000);
+    if(poll(r->fds, r->num_conns + 1, timeout) < 0) {
+      continue;
+    }
+
+    if(r->fds[0].revents) {
+      char buffer[16];
+      vlc_mutex_lock(&r->lock);
+        if(read(r->wake_fd[0], buffer, sizeof(buffer)) < 0) {
+          msg_Err(r->conns[0]->useless_vlc_object, "wake pipe: %m");
+        }
+        r->wake_pending = 0;
+      vlc_mutex_unlock(&r->lock);
+    }
+
+    for(size_t i = 0; i < r->num_conns; ++i) {
+      SynConnectionInternal* sci = r->conns[i];
+      short revents = r->fds[i + 1].revents;
+      int rv = 1;
+      if(revents & (POLLIN | POLLERR | POLLHUP)) {
+        rv = sci->party ? syn_party_read(sci) : syn_reactor_read(sci);
+      }
+      if(rv > 0 && (revents & POLLOUT)) {
+        rv = sci->party ? syn_party_write(sci) : syn_reactor_write(sci);
+      }
+      r->status[i] = rv;
+    }
+    // Backwards, closing only moves connections already looked at
+    for(size_t i = r->num_conns; i-- > 0;) {
+      if(r->status[i] <= 0) {
+        syn_reactor_close(r, r->conns[i], r->status[i]);
+      }
+    }
+
+    syn_reactor_run_timers(r);
+  }
+  return NULL;
+}
+
+int syn_reactor_add(SynConnectionInternal* sci) {
+  SynReactor* r = &syn_reactor_;
+  int rv = 0;
+  vlc_mutex_lock(&r->lock);
+  if(-1 == r->wake_fd[0] && 0 != vlc_pipe(r->wake_fd)) {
+    r->wake_fd[0] = r->wake_fd[1] = -1;
+    rv = -1;
+    goto out;
+  }
+  if(r->num_pending == r->max_pending) {
+    size_t max = r->max_pending ? 2 * r->max_pending : SYN_INITIAL_CONNECTIONS;
+    SynConnectionInternal** pending =
+      realloc(r->pending, max * sizeof(*pending));
+    if(NULL == pending) {
+      rv = -1;
+      goto out;
+    }
+    r->pending = pending;
+    r->max_pending = max;
+  }
+  r->pending[r->num_pending++] = sci;
+
+  if(!r->running) {
+    if(r->started) {
+      vlc_join(r->thread, NULL);  // it gave up the lock for good
+      r->started = 0;
+    }
+    r->wake_pending = 0;
+    if(0 != vlc_clone(&r->thread, syn_reactor_thread, r,
+          SYN_THREAD_PRIORITY)) {
+      r->num_pending--;
+      rv = -1;
+      goto out;
+    }
+    r->started = r->running = 1;
+  } else if(!r->wake_pending) {
+    r->wake_pending = 1;
+    if(write(r->wake_fd[1], "", 1) < 0) {
+      msg_Err(sci->useless_vlc_object, "wake pipe: %m");
+    }
+  }
+out:
+  vlc_mutex_unlock(&r->lock);
+  return rv;
+}
+
+void syn_reactor_wake(void) {
+  SynReactor* r = &syn_reactor_;
+  vlc_mutex_lock(&r->lock);
+  if(r->running && !r->wake_pending) {
+    r->wake_pending = 1;
+    if(write(r->wake_fd[1], "", 1) < 0) {
+      r->wake_pending = 0;
+    }
+  }
+  vlc_mutex_unlock(&r->lock);
+}
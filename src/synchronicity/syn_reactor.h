@@ -0,0 +1,22 @@
+#ifndef SYN_REACTOR_H_
+#define SYN_REACTOR_H_
+
+#include "synchronicity/syn_connection_internal.h"
+
+#define SYN_REACTOR_READ_SIZE 4096
+
+// Hand an established connection over to the shared I/O thread, which
+// is started on demand. Returns 0 on success; the caller keeps driving
+// the connection itself otherwise.
+int syn_reactor_add(SynConnectionInternal* sci);
+
+// Tell the I/O thread a connection it drives has something to send or
+// is being destroyed
+void syn_reactor_wake(void);
+
+// Run received bytes through the segment parser of a connection the I/O
+// thread drives. Returns -1 if they are malformed or memory ran out.
+int syn_reactor_feed(SynConnectionInternal* sci, const char* data,
+    size_t len);
+
+#endif
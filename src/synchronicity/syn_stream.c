@@ -0,0 +1,47 @@
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <synchronicity/syn_key.h>
+#include <synchronicity/syn_stream.h>
+#include "synchronicity/syn_key_internal.h"
+
+#include <vlc_network.h>
+#include "libvlc.h"
+
+#undef SynStream_Open
+int SynStream_Open(vlc_object_t* obj, const char* key, bool source) {
+  uint64_t value;
+  if(!SynConnection_IsAddrValid(key) || 0 != char_to_uint64(&value, key)) {
+    msg_Err(obj, "invalid stream key %s", key);
+    return -1;
+  }
+
+  char* host = var_InheritString(obj, "synchronicity-server");
+  if(NULL == host) {
+    return -1;
+  }
+  int sockfd = net_ConnectTCP(obj, host,
+      var_InheritInteger(obj, "synchronicity-port"));
+  free(host);
+  if(sockfd < 0) {
+    return -1;
+  }
+
+  // marker and key, the relay answers 0 or refuses
+  char out[2 * SYN_KEY_BUFFER_LENGTH + 1];
+  uint64_to_char(source ? SYN_STREAM_SOURCE_KEY : SYN_STREAM_SINK_KEY, out);
+  uint64_to_char(value, out + SYN_KEY_BUFFER_LENGTH);
+  char in[SYN_KEY_BUFFER_LENGTH + 1];
+  uint64_t reply;
+  if(net_Write(obj, sockfd, NULL, out, 2 * SYN_KEY_BUFFER_LENGTH) !=
+        2 * SYN_KEY_BUFFER_LENGTH ||
+      net_Read(obj, sockfd, NULL, in, SYN_KEY_BUFFER_LENGTH, true) !=
+        SYN_KEY_BUFFER_LENGTH ||
+      0 != char_to_uint64(&reply, in) || 0 != reply) {
+    msg_Err(obj, "relay refused the stream of %s", key);
+    net_Close(sockfd);
+    return -1;
+  }
+  return sockfd;
+}
@@ -0,0 +1,303 @@
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "synchronicity/syn_udp.h"
+
+#include <vlc_fs.h>
+#include <vlc_network.h>
+#include <vlc_threads.h>
+#include <vlc_tracer.h>
+#include <assert.h>
+#include <errno.h>
+#ifdef HAVE_UNISTD_H
+#   include <unistd.h>
+#endif
+#ifdef HAVE_POLL
+#   include <poll.h>
+#endif
+#include "libvlc.h"
+
+// One thread listens on the datagram sockets of every connection, it
+// is started on demand and exits once there is none. Datagrams are
+// handled with the lock held, so a connection that is closed is never
+// touched again.
+struct SynUdp {
+  vlc_mutex_t lock;
+  int running;
+  int started;     // thread is set, may have exited since
+  vlc_thread_t thread;
+  int wake_pending;  // a byte is in the wake pipe already
+  int wake_fd[2];
+
+  SynConnectionInternal** conns;
+  size_t num_conns;
+  size_t max_conns;
+  unsigned int changes;  // bumped whenever conns changes
+};
+typedef struct SynUdp SynUdp;
+
+static SynUdp syn_udp_ = {
+  .lock = VLC_STATIC_MUTEX,
+  .wake_fd = { -1, -1 },
+};
+
+static void syn_udp_put64(uint8_t* out, uint64_t value) {
+  for(int i = 7; i >= 0; --i) {
+    out[i] = (uint8_t)value;
+    value >>= 8;
+  }
+}
+
+static uint64_t syn_udp_get64(const uint8_t* in) {
+  uint64_t value = 0;
+  for(int i = 0; i < 8; ++i) {
+    value = (value << 8) | in[i];
+  }
+  return value;
+}
+
+// The relay's header: magic, key, role
+static void syn_udp_header(SynConnectionInternal* sci, uint8_t* out) {
+  memcpy(out, SYN_UDP_MAGIC, 4);
+  syn_udp_put64(out + 4, sci->address.relay_server_key);
+  out[12] = sci->was_client ? 1 : 0;
+}
+
+static void syn_udp_send(SynConnectionInternal* sci, int flag,
+    mtime_t timestamp_sync, mtime_t timestamp_reply) {
+  uint8_t out[SYN_UDP_DATAGRAM];
+  syn_udp_header(sci, out);
+  out[SYN_UDP_HEADER] = (uint8_t)flag;
+  syn_udp_put64(out + SYN_UDP_HEADER + 1, timestamp_sync);
+  syn_udp_put64(out + SYN_UDP_HEADER + 9, timestamp_reply);
+  // a full socket buffer only costs this sample
+  VLC_TRACE_INSTANT("syn udp send");
+  if(send(sci->udp_socket, out, sizeof(out), 0) > 0) {
+    SynLock(sci);
+      sci->bytes_sent += sizeof(out);
+    SynUnlock(sci);
+  }
+}
+
+// Lock held. Answer sync requests, take replies to our last beacon.
+static void syn_udp_receive(SynConnectionInternal* sci) {
+  uint8_t in[SYN_UDP_DATAGRAM + 1];
+  uint8_t header[SYN_UDP_HEADER];
+  syn_udp_header(sci, header);
+  for(;;) {
+    ssize_t rv = recv(sci->udp_socket, in, sizeof(in), 0);
+    if(rv < 0) {
+      if(net_errno == EINTR) {
+        continue;
+      }
+      return;  // drained, or an ICMP error nobody can act on
+    }
+    mtime_t now = mdate();
+    // the peer has the same header but the other role
+    if(SYN_UDP_DATAGRAM != rv || 0 != memcmp(in, header, 12) ||
+        in[12] == header[12]) {
+      continue;
+    }
+    VLC_TRACE_INSTANT("syn udp receive");
+    SynLock(sci);
+      sci->bytes_received += rv;
+    SynUnlock(sci);
+    int flag = in[SYN_UDP_HEADER];
+    mtime_t timestamp_sync = syn_udp_get64(in + SYN_UDP_HEADER + 1);
+    mtime_t timestamp_reply = syn_udp_get64(in + SYN_UDP_HEADER + 9);
+    if(flag & SYNC_MASK) {
+      syn_udp_send(sci, SYNC_REPLY_MASK, mdate(), timestamp_sync);
+    }
+    if(flag & SYNC_REPLY_MASK) {
+      SynLock(sci);
+        int match = sci->udp_awaiting && timestamp_reply == sci->udp_sent;
+        int first = match && !sci->udp_up;
+        if(match) {
+          sci->udp_awaiting = 0;
+          sci->udp_misses = 0;
+          sci->udp_up = 1;
+        }
+      SynUnlock(sci);
+      if(first) {
+        msg_Dbg(sci->useless_vlc_object, "sync beacons over UDP");
+      }
+      if(match) {
+        syn_connection_sync_sample(sci, now, timestamp_sync, timestamp_reply);
+      }
+    }
+  }
+}
+
+static void* syn_udp_thread(void* param) {
+  SynUdp* u = param;
+  struct pollfd* fds = NULL;
+  size_t max_fds = 0;
+  for(;;) {
+    vlc_mutex_lock(&u->lock);
+      if(0 == u->num_conns) {
+        // Next syn_udp_open() starts a new thread
+        u->running = 0;
+        vlc_mutex_unlock(&u->lock);
+        break;
+      }
+      size_t num = u->num_conns;
+      if(num + 1 > max_fds) {
+        struct pollfd* more = realloc(fds, 2 * (num + 1) * sizeof(*fds));
+        if(NULL == more) {
+          vlc_mutex_unlock(&u->lock);
+          msleep(SYN_UDP_MIN_WAIT);
+          continue;
+        }
+        fds = more;
+        max_fds = 2 * (num + 1);
+      }
+      fds[0].fd = u->wake_fd[0];
+      fds[0].events = POLLIN;
+      for(size_t i = 0; i < num; ++i) {
+        fds[i + 1].fd = u->conns[i]->udp_socket;
+        fds[i + 1].events = POLLIN;
+      }
+      unsigned int changes = u->changes;
+    vlc_mutex_unlock(&u->lock);
+
+    if(poll(fds, num + 1, -1) < 0) {
+      continue;
+    }
+
+    vlc_mutex_lock(&u->lock);
+      if(fds[0].revents) {
+        char buffer[16];
+        if(read(u->wake_fd[0], buffer, sizeof(buffer)) >= 0) {
+          u->wake_pending = 0;
+        }
+      }
+      // conns changed while we polled: poll again, datagrams wait
+      for(size_t i = 0; changes == u->changes && i < num; ++i) {
+        if(fds[i + 1].revents) {
+          syn_udp_receive(u->conns[i]);
+        }
+      }
+    vlc_mutex_unlock(&u->lock);
+  }
+  free(fds);
+  return NULL;
+}
+
+// Lock held
+static void syn_udp_wake(SynUdp* u) {
+  if(!u->wake_pending) {
+    u->wake_pending = 1;
+    if(write(u->wake_fd[1], "", 1) < 0) {
+      u->wake_pending = 0;
+    }
+  }
+}
+
+int syn_udp_open(SynConnectionInternal* sci) {
+  SynUdp* u = &syn_udp_;
+  int fd = net_ConnectUDP(VLC_OBJECT(sci->useless_vlc_object),
+      sci->relay_server_host, sci->relay_server_port, -1);
+  if(fd < 0) {
+    return -1;
+  }
+
+  int rv = -1;
+  vlc_mutex_lock(&u->lock);
+  if(-1 == u->wake_fd[0] && 0 != vlc_pipe(u->wake_fd)) {
+    u->wake_fd[0] = u->wake_fd[1] = -1;
+    goto out;
+  }
+  if(u->num_conns == u->max_conns) {
+    size_t max = u->max_conns ? 2 * u->max_conns : SYN_INITIAL_CONNECTIONS;
+    SynConnectionInternal** conns = realloc(u->conns, max * sizeof(*conns));
+    if(NULL == conns) {
+      goto out;
+    }
+    u->conns = conns;
+    u->max_conns = max;
+  }
+
+  sci->udp_socket = fd;
+  sci->udp = 1;
+  u->conns[u->num_conns++] = sci;
+  u->changes++;
+  if(!u->running) {
+    if(u->started) {
+      vlc_join(u->thread, NULL);  // it gave up the lock for good
+      u->started = 0;
+    }
+    u->wake_pending = 0;
+    if(0 != vlc_clone(&u->thread, syn_udp_thread, u, SYN_THREAD_PRIORITY)) {
+      u->num_conns--;
+      sci->udp = 0;
+      goto out;
+    }
+    u->started = u->running = 1;
+  } else {
+    syn_udp_wake(u);
+  }
+  rv = 0;
+out:
+  vlc_mutex_unlock(&u->lock);
+  if(0 != rv) {
+    net_Close(fd);
+    return rv;
+  }
+
+  // the relay learns our address from this, the peer's beacons follow
+  uint8_t header[SYN_UDP_HEADER];
+  syn_udp_header(sci, header);
+  send(fd, header, sizeof(header), 0);
+  return 0;
+}
+
+void syn_udp_close(SynConnectionInternal* sci) {
+  SynUdp* u = &syn_udp_;
+  vlc_mutex_lock(&u->lock);
+    for(size_t i = 0; i < u->num_conns; ++i) {
+      if(u->conns[i] == sci) {
+        u->conns[i] = u->conns[--u->num_conns];
+        u->changes++;
+        break;
+      }
+    }
+    if(u->running) {
+      syn_udp_wake(u);
+    }
+  vlc_mutex_unlock(&u->lock);
+  net_Close(sci->udp_socket);
+  sci->udp = 0;
+}
+
+int syn_udp_beacon(SynConnectionInternal* sci) {
+  mtime_t now = mdate();
+  SynLock(sci);
+    if(sci->udp_awaiting) {
+      mtime_t wait = 2 * sci->estimated_rtt;
+      if(wait < SYN_UDP_MIN_WAIT) {
+        wait = SYN_UDP_MIN_WAIT;
+      }
+      if(now - sci->udp_sent < wait) {
+        int up = sci->udp_up;
+        SynUnlock(sci);
+        return up;
+      }
+      sci->udp_awaiting = 0;
+      if(++sci->udp_misses >= SYN_UDP_MAX_MISSES && sci->udp_up) {
+        sci->udp_up = 0;
+        msg_Dbg(sci->useless_vlc_object, "UDP beacons lost, back to TCP");
+      }
+    }
+    if(sci->udp_misses >= SYN_UDP_MAX_PROBES) {
+      SynUnlock(sci);
+      return 0;
+    }
+    sci->udp_awaiting = 1;
+    sci->udp_sent = now;
+    sci->count_sync++;
+    int up = sci->udp_up;
+  SynUnlock(sci);
+  syn_udp_send(sci, SYNC_MASK, now, 0);
+  return up;
+}
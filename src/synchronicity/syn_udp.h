@@ -0,0 +1,35 @@
+#ifndef SYN_UDP_H_
+#define SYN_UDP_H_
+
+#include "synchronicity/syn_connection_internal.h"
+
+// Sync beacons can go out as UDP datagrams through the relay, which
+// passes them between the two sides of a pair by key, see
+// relay_beacon.h. TCP retransmissions then no longer show up as round
+// trip time in the clock estimate. Commands stay on the relay
+// connection, and so do the beacons until the peer answered one over
+// UDP or again once a few in a row went unanswered.
+//
+// A datagram is the relay's header, magic, key and our role, then the
+// flag byte and the sync and reply timestamps, big endian.
+#define SYN_UDP_MAGIC "SYNB"
+#define SYN_UDP_HEADER 13
+#define SYN_UDP_DATAGRAM (SYN_UDP_HEADER + 1 + 8 + 8)
+
+#define SYN_UDP_MIN_WAIT 500000  // before an unanswered beacon counts as lost
+#define SYN_UDP_MAX_MISSES 3     // lost in a row until TCP takes over again
+#define SYN_UDP_MAX_PROBES 8     // and until UDP is given up on
+
+// Open the connection's datagram socket and tell the relay where we
+// are. Returns 0 on success, the connection simply beacons over TCP
+// otherwise.
+int syn_udp_open(SynConnectionInternal* sci);
+
+// Stop listening; the socket is closed once this returns
+void syn_udp_close(SynConnectionInternal* sci);
+
+// A beacon is due: send it over UDP unless the last one is still on its
+// way. Returns 1 if the peer answers over UDP and TCP can do without.
+int syn_udp_beacon(SynConnectionInternal* sci);
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef SYN_VARINT_H_
+#define SYN_VARINT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+// LEB128 style: 7 bits per byte, low bits first, high bit set on every
+// byte but the last
+#define SYN_VARINT_MAX_LENGTH 10
+
+// Returns the number of bytes written to out
+static inline int syn_put_varint(uint8_t* out, uint64_t value) {
+  int i = 0;
+  while(value >= 0x80) {
+    out[i++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  out[i++] = (uint8_t)value;
+  return i;
+}
+
+// Returns the number of bytes read, or -1 if in is too short or the
+// value does not fit 64 bits
+static inline int syn_get_varint(const uint8_t* in, size_t len,
+    uint64_t* value) {
+  uint64_t result = 0;
+  size_t i;
+  for(i = 0; i < len && i < SYN_VARINT_MAX_LENGTH; ++i) {
+    result |= (uint64_t)(in[i] & 0x7f) << (7 * i);
+    if(!(in[i] & 0x80)) {
+      *value = result;
+      return i + 1;
+    }
+  }
+  return -1;
+}
+
+// Signed values are zigzag mapped first so small negatives stay short
+static inline uint64_t syn_zigzag(int64_t value) {
+  return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static inline int64_t syn_unzigzag(uint64_t value) {
+  return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+#endif
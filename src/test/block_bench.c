@@ -0,0 +1,130 @@
+/*****************************************************************************
+ * block_bench.c: Allocation rate of block_t under a multi-stream load
+ *****************************************************************************
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Every stream is an input thread receiving TS over UDP, 7 packets per
+ * datagram, and a decoder thread releasing what it is handed, through a
+ * paced FIFO like the one of the decoders.
+ *
+ *   bench_block [streams] [seconds] [spsc]
+ *
+ * bench_block_malloc is the same over plain malloc(). */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_atomic.h>
+
+#define DATAGRAM (7 * 188)
+
+typedef struct
+{
+    block_fifo_t *fifo;
+    vlc_thread_t  input;
+    vlc_thread_t  decoder;
+    unsigned long count;
+} bench_stream_t;
+
+static vlc_atomic_t running = VLC_ATOMIC_INIT(1);
+
+static void *Input (void *data)
+{
+    bench_stream_t *stream = data;
+
+    while (vlc_atomic_get (&running))
+    {
+        for (unsigned i = 0; i < 1024; i++)
+        {
+            /* now and then a reassembled frame */
+            size_t size = (stream->count++ % 64) ? DATAGRAM : 65536;
+            block_t *block = block_Alloc (size);
+            if (block == NULL)
+                abort ();
+            memset (block->p_buffer, 0x47, 4);
+            block_FifoPace (stream->fifo, 1000, SIZE_MAX);
+            block_FifoPut (stream->fifo, block);
+        }
+    }
+    block_FifoPut (stream->fifo, block_Alloc (0));
+    return NULL;
+}
+
+static void *Decoder (void *data)
+{
+    bench_stream_t *stream = data;
+    block_t *block;
+
+    while ((block = block_FifoGet (stream->fifo))->i_buffer != 0)
+        block_Release (block);
+    block_Release (block);
+    return NULL;
+}
+
+int main (int argc, char *argv[])
+{
+    unsigned streams = (argc > 1) ? strtoul (argv[1], NULL, 10) : 4;
+    unsigned seconds = (argc > 2) ? strtoul (argv[2], NULL, 10) : 2;
+    bool spsc = (argc > 3) && !strcmp (argv[3], "spsc");
+    if (streams == 0 || seconds == 0)
+        return 1;
+
+    bench_stream_t *tab = calloc (streams, sizeof (*tab));
+    if (tab == NULL)
+        return 1;
+
+    mtime_t start = mdate ();
+    for (unsigned i = 0; i < streams; i++)
+    {
+        tab[i].fifo = spsc ? block_FifoNewSPSC () : block_FifoNew ();
+        if (tab[i].fifo == NULL)
+            return 1;
+        if (vlc_clone (&tab[i].decoder, Decoder, tab + i,
+                       VLC_THREAD_PRIORITY_LOW)
+         || vlc_clone (&tab[i].input, Input, tab + i,
+                       VLC_THREAD_PRIORITY_LOW))
+            return 1;
+    }
+    msleep (seconds * CLOCK_FREQ);
+    vlc_atomic_set (&running, 0);
+
+    unsigned long total = 0;
+    for (unsigned i = 0; i < streams; i++)
+    {
+        vlc_join (tab[i].input, NULL);
+        vlc_join (tab[i].decoder, NULL);
+        block_FifoRelease (tab[i].fifo);
+        total += tab[i].count;
+    }
+    mtime_t elapsed = mdate () - start;
+    free (tab);
+
+    struct rusage ru;
+    getrusage (RUSAGE_SELF, &ru);
+    printf ("%u streams: %.0f blocks/s per stream, max RSS %ld KiB\n",
+            streams, (double)total * CLOCK_FREQ / elapsed / streams,
+            ru.ru_maxrss);
+    return 0;
+}
@@ -23,6 +23,7 @@
 #endif
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #undef NDEBUG
 #include <assert.h>
@@ -84,10 +85,186 @@ static void test_block (void)
     //assert (block == NULL);
 }
 
+static block_fifo_t *fifo;
+
+static void *test_block_releaser (void *data)
+{
+    block_t *block;
+
+    (void) data;
+    while ((block = block_FifoGet (fifo))->i_buffer != 0)
+    {
+        for (size_t i = 0; i < block->i_buffer; i++)
+            assert (block->p_buffer[i] == (uint8_t)block->i_buffer);
+        block_Release (block);
+    }
+    block_Release (block);
+    return NULL;
+}
+
+/* Blocks released by another thread come back to the pool */
+static void test_block_Threads (block_fifo_t *(*fifo_new) (void))
+{
+    vlc_thread_t th;
+
+    fifo = fifo_new ();
+    assert (fifo != NULL);
+    assert (vlc_clone (&th, test_block_releaser, NULL,
+                       VLC_THREAD_PRIORITY_LOW) == 0);
+
+    for (unsigned i = 0; i < 100000; i++)
+    {
+        size_t size = 1 + (i * 7919) % 70000;
+        block_t *block = block_Alloc (size);
+        assert (block != NULL);
+        memset (block->p_buffer, (uint8_t)size, size);
+        if (i % 3 == 0)
+        {   /* grows and shrinks within the block or moves it */
+            block = block_Realloc (block, 0, 1 + size / 2);
+            assert (block != NULL);
+            block = block_Realloc (block, 0, size);
+            assert (block != NULL);
+            memset (block->p_buffer, (uint8_t)size, size);
+        }
+        block_FifoPace (fifo, 100, SIZE_MAX);
+        block_FifoPut (fifo, block);
+    }
+    block_FifoPut (fifo, block_Alloc (0));
+    vlc_join (th, NULL);
+    block_FifoRelease (fifo);
+}
+
+static void test_block_FifoSPSC (void)
+{
+    block_fifo_t *fifo = block_FifoNewSPSC ();
+    assert (fifo != NULL);
+
+    block_t *chain = block_Alloc (10);
+    chain->p_next = block_Alloc (20);
+    block_FifoPut (fifo, chain);
+    block_FifoPut (fifo, block_Alloc (30));
+    assert (block_FifoCount (fifo) == 3);
+    assert (block_FifoSize (fifo) == 60);
+
+    block_t *block = block_FifoGet (fifo);
+    assert (block->i_buffer == 10 && block->p_next == NULL);
+    block_Release (block);
+    assert (block_FifoShow (fifo)->i_buffer == 20);
+
+    /* what was there is gone, what comes next is not */
+    block_FifoEmpty (fifo);
+    block_FifoPut (fifo, block_Alloc (40));
+    block = block_FifoGet (fifo);
+    assert (block->i_buffer == 40);
+    block_Release (block);
+    assert (block_FifoCount (fifo) == 0);
+    assert (block_FifoSize (fifo) == 0);
+
+    block_FifoWake (fifo);
+    assert (block_FifoGet (fifo) == NULL);
+
+    block_FifoPut (fifo, block_Alloc (50));
+    block_FifoRelease (fifo);
+}
+
+static void test_block_FifoGetUpTo (block_fifo_t *(*fifo_new) (void))
+{
+    block_fifo_t *fifo = fifo_new ();
+    assert (fifo != NULL);
+
+    for (unsigned i = 1; i <= 6; i++)
+        block_FifoPut (fifo, block_Alloc (100 * i));
+
+    /* the first one whatever its size */
+    block_t *chain = block_FifoGetUpTo (fifo, 4, 50);
+    assert (chain->i_buffer == 100 && chain->p_next == NULL);
+    block_Release (chain);
+
+    chain = block_FifoGetUpTo (fifo, 4, 700);
+    assert (chain->i_buffer == 200 && chain->p_next->i_buffer == 300);
+    assert (chain->p_next->p_next == NULL);
+    block_ChainRelease (chain);
+
+    chain = block_FifoGetUpTo (fifo, 2, SIZE_MAX);
+    assert (chain->i_buffer == 400 && chain->p_next->i_buffer == 500);
+    assert (chain->p_next->p_next == NULL);
+    block_ChainRelease (chain);
+    assert (block_FifoCount (fifo) == 1);
+    assert (block_FifoSize (fifo) == 600);
+
+    chain = block_FifoGetUpTo (fifo, SIZE_MAX, SIZE_MAX);
+    assert (chain->i_buffer == 600 && chain->p_next == NULL);
+    block_Release (chain);
+    assert (block_FifoCount (fifo) == 0);
+    assert (block_FifoSize (fifo) == 0);
+
+    block_FifoWake (fifo);
+    assert (block_FifoGetUpTo (fifo, 4, SIZE_MAX) == NULL);
+    block_FifoRelease (fifo);
+}
+
+static void test_block_Slice (void)
+{
+    block_t *block = block_Alloc (100);
+    assert (block != NULL);
+    for (unsigned i = 0; i < 100; i++)
+        block->p_buffer[i] = i;
+    block->i_pts = 42;
+
+    block_t *a = block_Slice (block, 10, 20);
+    block_t *b = block_Slice (block, 30, 30);
+    assert (a != NULL && b != NULL);
+    assert (a->p_buffer == block->p_buffer + 10 && a->i_buffer == 20);
+    assert (a->i_pts == VLC_TS_INVALID);
+    const uint8_t *buf = block->p_buffer;
+    block_Release (block);
+
+    /* a slice of a slice views the same buffer */
+    block_t *c = block_Slice (b, 5, 10);
+    assert (c->p_buffer == buf + 35 && c->p_buffer[0] == 35);
+
+    /* consecutive slices join without a copy, others are gathered */
+    a->p_next = b;
+    block = block_ChainGather (a);
+    assert (block->p_buffer == buf + 10 && block->i_buffer == 50);
+    assert (block->p_buffer[49] == 59);
+
+    block->p_next = c;
+    block = block_ChainGather (block);
+    assert (block->i_buffer == 60 && block->p_buffer != buf + 10);
+    assert (block->p_buffer[0] == 10 && block->p_buffer[59] == 44);
+
+    /* a shared buffer is copied before it changes */
+    a = block_Alloc (10);
+    memset (a->p_buffer, 1, 10);
+    b = block_Slice (a, 0, 10);
+    a = block_Realloc (a, 0, 20);
+    memset (a->p_buffer, 2, 20);
+    assert (b->p_buffer[9] == 1);
+    block_Release (b);
+    block_Release (a);
+    block_Release (block);
+
+    /* other blocks are copied */
+    uint8_t *data = malloc (16);
+    assert (data != NULL);
+    block = block_heap_Alloc (data, data, 16);
+    a = block_Slice (block, 4, 8);
+    assert (a != NULL && a->p_buffer != data + 4);
+    block_Release (a);
+    block_Release (block);
+}
+
 int main (void)
 {
     test_block_File ();
     test_block ();
+    test_block_Threads (block_FifoNew);
+    test_block_Threads (block_FifoNewSPSC);
+    test_block_FifoSPSC ();
+    test_block_FifoGetUpTo (block_FifoNew);
+    test_block_FifoGetUpTo (block_FifoNewSPSC);
+    test_block_Slice ();
     return 0;
 }
 
@@ -0,0 +1,175 @@
+/*****************************************************************************
+ * executor.c: Test for the executor API
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_executor.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#undef NDEBUG
+#include <assert.h>
+
+static vlc_mutex_t lock;
+static vlc_cond_t  wait;
+static unsigned    count;
+static bool        blocked;
+static char        order[4];
+
+static void count_cb (void *data)
+{
+    (void) data;
+    vlc_mutex_lock (&lock);
+    count++;
+    vlc_mutex_unlock (&lock);
+}
+
+/* Keeps the thread busy until unblock() */
+static void block_cb (void *data)
+{
+    (void) data;
+    vlc_mutex_lock (&lock);
+    blocked = true;
+    vlc_cond_broadcast (&wait);
+    while (blocked)
+        vlc_cond_wait (&wait, &lock);
+    vlc_mutex_unlock (&lock);
+}
+
+static void wait_blocked (void)
+{
+    vlc_mutex_lock (&lock);
+    while (!blocked)
+        vlc_cond_wait (&wait, &lock);
+    vlc_mutex_unlock (&lock);
+}
+
+static void unblock (void)
+{
+    vlc_mutex_lock (&lock);
+    blocked = false;
+    vlc_cond_broadcast (&wait);
+    vlc_mutex_unlock (&lock);
+}
+
+static void order_cb (void *data)
+{
+    vlc_mutex_lock (&lock);
+    order[strlen (order)] = *(const char *)data;
+    vlc_mutex_unlock (&lock);
+}
+
+static vlc_executor_t *exec;
+
+static void cancel_cb (void *data)
+{
+    vlc_task_t *task = data;
+
+    vlc_mutex_lock (&lock);
+    blocked = true;
+    vlc_cond_broadcast (&wait);
+    vlc_mutex_unlock (&lock);
+
+    while (!vlc_executor_IsCanceled (exec, task))
+        msleep (CLOCK_FREQ / 100);
+}
+
+static void free_cb (void *data)
+{
+    free (data);
+    vlc_mutex_lock (&lock);
+    count++;
+    vlc_cond_broadcast (&wait);
+    vlc_mutex_unlock (&lock);
+}
+
+int main (void)
+{
+    vlc_task_t tasks[100];
+
+    vlc_mutex_init (&lock);
+    vlc_cond_init (&wait);
+
+    /* All tasks run */
+    exec = vlc_executor_New (4, VLC_THREAD_PRIORITY_LOW);
+    assert (exec != NULL);
+    assert (vlc_executor_GetThreadCount (exec) == 4);
+    for (unsigned i = 0; i < 100; i++)
+    {
+        vlc_task_Init (&tasks[i], count_cb, NULL);
+        tasks[i].i_affinity = (i % 3) ? (int)i : -1;
+        assert (vlc_executor_Submit (exec, &tasks[i]) == VLC_SUCCESS);
+    }
+    for (unsigned i = 0; i < 100; i++)
+        vlc_executor_Wait (exec, &tasks[i]);
+    assert (count == 100);
+
+    /* Tasks may free themselves */
+    for (unsigned i = 0; i < 10; i++)
+    {
+        vlc_task_t *task = malloc (sizeof (*task));
+        assert (task != NULL);
+        vlc_task_Init (task, free_cb, task);
+        assert (vlc_executor_Submit (exec, task) == VLC_SUCCESS);
+    }
+    vlc_mutex_lock (&lock);
+    while (count < 110)
+        vlc_cond_wait (&wait, &lock);
+    vlc_mutex_unlock (&lock);
+    vlc_executor_Delete (exec);
+
+    /* Priorities, cancellation of a queued task */
+    exec = vlc_executor_New (1, VLC_THREAD_PRIORITY_LOW);
+    assert (exec != NULL);
+    vlc_task_Init (&tasks[0], block_cb, NULL);
+    vlc_executor_Submit (exec, &tasks[0]);
+    wait_blocked ();
+
+    static char marks[] = "lnhx";
+    vlc_task_Init (&tasks[1], order_cb, &marks[0]);
+    tasks[1].i_priority = VLC_TASK_LOW;
+    vlc_task_Init (&tasks[2], order_cb, &marks[1]);
+    vlc_task_Init (&tasks[3], order_cb, &marks[2]);
+    tasks[3].i_priority = VLC_TASK_HIGH;
+    vlc_task_Init (&tasks[4], order_cb, &marks[3]);
+    for (unsigned i = 1; i <= 4; i++)
+        vlc_executor_Submit (exec, &tasks[i]);
+    assert (vlc_executor_Cancel (exec, &tasks[4]));
+    unblock ();
+    for (unsigned i = 0; i <= 4; i++)
+        vlc_executor_Wait (exec, &tasks[i]);
+    printf ("Order = %s\n", order);
+    assert (!strcmp (order, "hnl"));
+
+    /* Cancellation of a running task */
+    vlc_task_Init (&tasks[0], cancel_cb, &tasks[0]);
+    vlc_executor_Submit (exec, &tasks[0]);
+    wait_blocked ();
+    assert (!vlc_executor_Cancel (exec, &tasks[0]));
+    vlc_executor_Delete (exec);
+
+    vlc_cond_destroy (&wait);
+    vlc_mutex_destroy (&lock);
+    return 0;
+}
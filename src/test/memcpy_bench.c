@@ -0,0 +1,91 @@
+/*****************************************************************************
+ * memcpy_bench.c: Throughput of vlc_memcpy() against the C library
+ *****************************************************************************
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Copies buffers from a few bytes to a 1080p picture, over a working set
+ * larger than the caches, like a video output copying successive pictures.
+ * The tiers are compared by limiting the CPU capabilities:
+ *
+ *   bench_memcpy [milliseconds per size]
+ *   VLC_CPU=sse2 bench_memcpy
+ *   VLC_CPU=none bench_memcpy */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+
+#define WORKING_SET (64 << 20)
+
+static double Bench (void *(*copy) (void *, const void *, size_t),
+                     uint8_t *dst, const uint8_t *src, size_t size,
+                     mtime_t duration)
+{
+    const size_t count = WORKING_SET / size;
+    unsigned long long bytes = 0;
+    mtime_t start = mdate (), now;
+    size_t i = 0;
+
+    do
+    {
+        for (unsigned j = 0; j < 64; j++)
+        {
+            copy (dst + i * size, src + i * size, size);
+            if (++i == count)
+                i = 0;
+        }
+        bytes += 64 * size;
+        now = mdate ();
+    }
+    while (now - start < duration);
+
+    return (double)bytes * CLOCK_FREQ / (now - start) / (1 << 20);
+}
+
+int main (int argc, char *argv[])
+{
+    static const size_t sizes[] = {
+        64, 1024, 16 << 10, 256 << 10, 1920 * 1080, 1920 * 1080 * 4 };
+    unsigned ms = (argc > 1) ? strtoul (argv[1], NULL, 10) : 200;
+    if (ms == 0)
+        return 1;
+
+    uint8_t *src = malloc (WORKING_SET), *dst = malloc (WORKING_SET);
+    if (src == NULL || dst == NULL)
+        return 1;
+    memset (src, 0x55, WORKING_SET);
+    memset (dst, 0xAA, WORKING_SET);
+
+    printf ("CPU flags 0x%x\n%10s %12s %12s\n", vlc_CPU (), "size",
+            "libc MiB/s", "vlc MiB/s");
+    for (size_t i = 0; i < sizeof (sizes) / sizeof (sizes[0]); i++)
+    {
+        double libc = Bench (memcpy, dst, src, sizes[i], ms * 1000);
+        double vlc = Bench (vlc_memcpy, dst, src, sizes[i], ms * 1000);
+
+        printf ("%10zu %12.0f %12.0f\n", sizes[i], libc, vlc);
+    }
+    free (dst);
+    free (src);
+    return 0;
+}
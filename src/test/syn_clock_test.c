@@ -0,0 +1,100 @@
+/*****************************************************************************
+ * syn_clock_test.c: test the Synchronicity peer clock estimate
+ *****************************************************************************
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <synchronicity/syn_clock.h>
+
+static unsigned int seed = 1;
+
+/* Queueing delay, mostly short with the odd long one like on Wi-Fi */
+static mtime_t queueing (mtime_t max)
+{
+    seed = seed * 1103515245 + 12345;
+    unsigned int r = (seed >> 16) & 0x7fff;
+    return (r % 8) ? r % 2000 : r * max / 0x7fff;
+}
+
+/* Exchanges every interval with a peer whose clock is offset and
+ * drifts, over a path where uplink and downlink differ */
+static mtime_t run (SynClock *clock, int samples, mtime_t interval,
+                    mtime_t offset, double drift, mtime_t up, mtime_t down)
+{
+    mtime_t local = 1000000;
+    syn_clock_init (clock);
+    for (int i = 0; i < samples; i++)
+    {
+        local += interval;
+        mtime_t arrive = local + up + queueing (40000);
+        mtime_t peer_stamp = arrive
+                           - (offset + (mtime_t)(drift * arrive));
+        mtime_t back = arrive + down + queueing (40000);
+        mtime_t rtt = back - local;
+        syn_clock_add (clock, back, back - rtt / 2 - peer_stamp, rtt);
+        local = back;
+    }
+    mtime_t truth = offset + (mtime_t)(drift * local);
+    return syn_clock_offset (clock, local) - truth;
+}
+
+static void check (const char *what, mtime_t err, mtime_t bound)
+{
+    printf ("%s: off by %"PRId64" us\n", what, err);
+    if (llabs (err) > bound)
+    {
+        printf ("more than %"PRId64" us\n", bound);
+        exit (1);
+    }
+}
+
+int main (void)
+{
+    SynClock clock;
+
+    syn_clock_init (&clock);
+    if (syn_clock_offset (&clock, 12345) != 0)
+        return 1;
+
+    /* A few seconds of fast syncs get within 5ms */
+    check ("symmetric", run (&clock, 30, 100000, 1234567, 0., 3000, 3000),
+           5000);
+    check ("asymmetric", run (&clock, 30, 100000, -987654, 0., 8000, 2000),
+           5000);
+    if (syn_clock_error (&clock) < 3000)
+    {
+        printf ("error bound %"PRId64" hides the asymmetry\n",
+                syn_clock_error (&clock));
+        return 1;
+    }
+
+    /* Slow syncs over minutes follow the drift */
+    check ("drift", run (&clock, 100, 3000000, 42, 0.0001, 3000, 3000),
+           5000);
+    if (clock.drift < 0.00008 || clock.drift > 0.00012)
+    {
+        printf ("drift %f ppm\n", clock.drift * 1e6);
+        return 1;
+    }
+    return 0;
+}
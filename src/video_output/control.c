@@ -26,6 +26,7 @@
 #endif
 
 #include <vlc_common.h>
+#include <vlc_atomic.h>
 #include <vlc_vout.h>
 #include "control.h"
 
@@ -61,20 +62,66 @@ void vout_control_Init(vout_control_t *ctrl)
     vlc_cond_init(&ctrl->wait_request);
     vlc_cond_init(&ctrl->wait_acknowledge);
 
-    ctrl->is_dead = false;
+    vlc_atomic_set(&ctrl->is_dead, false);
     ctrl->is_sleeping = false;
     ctrl->can_sleep = true;
-    ctrl->is_processing = false;
+    vlc_atomic_set(&ctrl->is_processing, false);
+
+    for (unsigned i = 0; i < VOUT_CONTROL_SLOTS; i++)
+        vlc_atomic_set(&ctrl->slot[i].seq, i);
+    vlc_atomic_set(&ctrl->push_index, 0);
+    vlc_atomic_set(&ctrl->pop_index, 0);
+    vlc_atomic_set(&ctrl->is_waiting, false);
+    vlc_atomic_set(&ctrl->has_overflow, false);
     ARRAY_INIT(ctrl->cmd);
 }
 
+/* Takes the oldest command of the ring (vout thread only) */
+static bool ControlPopRing(vout_control_t *ctrl, vout_control_cmd_t *cmd)
+{
+    uintptr_t index = vlc_atomic_get(&ctrl->pop_index);
+    vout_control_slot_t *slot = &ctrl->slot[index % VOUT_CONTROL_SLOTS];
+
+    /* Empty, or a push has not finished writing it yet */
+    if (vlc_atomic_get(&slot->seq) != index + 1)
+        return false;
+
+    *cmd = slot->cmd;
+    /* swap, as it orders the copy above before the slot is given back */
+    vlc_atomic_swap(&slot->seq, index + VOUT_CONTROL_SLOTS);
+    vlc_atomic_set(&ctrl->pop_index, index + 1);
+    return true;
+}
+
+/* Same, then from the commands that overflowed (lock held) */
+static bool ControlPopLocked(vout_control_t *ctrl, vout_control_cmd_t *cmd)
+{
+    if (ControlPopRing(ctrl, cmd))
+        return true;
+    if (ctrl->cmd.i_size <= 0)
+        return false;
+
+    *cmd = ARRAY_VAL(ctrl->cmd, 0);
+    ARRAY_REMOVE(ctrl->cmd, 0);
+    if (ctrl->cmd.i_size <= 0)
+        vlc_atomic_set(&ctrl->has_overflow, false);
+    return true;
+}
+
+/* Whether a command is pending (lock held) */
+static bool ControlIsEmpty(vout_control_t *ctrl)
+{
+    /* the pop index first, so that it never exceeds the push one */
+    uintptr_t pop = vlc_atomic_get(&ctrl->pop_index);
+    return vlc_atomic_get(&ctrl->push_index) == pop && ctrl->cmd.i_size <= 0;
+}
+
 void vout_control_Clean(vout_control_t *ctrl)
 {
     /* */
-    for (int i = 0; i < ctrl->cmd.i_size; i++) {
-        vout_control_cmd_t cmd = ARRAY_VAL(ctrl->cmd, i);
+    vout_control_cmd_t cmd;
+    while (ControlPopLocked(ctrl, &cmd))
         vout_control_cmd_Clean(&cmd);
-    }
     ARRAY_RESET(ctrl->cmd);
 
     vlc_mutex_destroy(&ctrl->lock);
@@ -85,7 +132,7 @@ void vout_control_Clean(vout_control_t *ctrl)
 void vout_control_Dead(vout_control_t *ctrl)
 {
     vlc_mutex_lock(&ctrl->lock);
-    ctrl->is_dead = true;
+    vlc_atomic_set(&ctrl->is_dead, true);
     vlc_cond_broadcast(&ctrl->wait_acknowledge);
     vlc_mutex_unlock(&ctrl->lock);
 
@@ -94,20 +141,59 @@ void vout_control_Dead(vout_control_t *ctrl)
 void vout_control_WaitEmpty(vout_control_t *ctrl)
 {
     vlc_mutex_lock(&ctrl->lock);
-    while ((ctrl->cmd.i_size > 0 || ctrl->is_processing) && !ctrl->is_dead)
+    /* The vout thread marks itself processing before it pops a command,
+     * so the queue has to be looked at first */
+    while ((!ControlIsEmpty(ctrl) || vlc_atomic_get(&ctrl->is_processing))
+        && !vlc_atomic_get(&ctrl->is_dead))
         vlc_cond_wait(&ctrl->wait_acknowledge, &ctrl->lock);
     vlc_mutex_unlock(&ctrl->lock);
 }
 
+/* Copies a command into a free slot of the ring, unless it is full */
+static bool ControlPushRing(vout_control_t *ctrl, const vout_control_cmd_t *cmd)
+{
+    for (;;) {
+        uintptr_t index = vlc_atomic_get(&ctrl->push_index);
+        vout_control_slot_t *slot = &ctrl->slot[index % VOUT_CONTROL_SLOTS];
+        intptr_t diff = (intptr_t)(vlc_atomic_get(&slot->seq) - index);
+
+        if (diff < 0)
+            return false; /* not popped yet: full */
+        if (diff == 0 &&
+            vlc_atomic_compare_swap(&ctrl->push_index, index, index + 1) == index) {
+            slot->cmd = *cmd;
+            /* swap, as it orders the copy above before the publication */
+            vlc_atomic_swap(&slot->seq, index + 1);
+            return true;
+        }
+        /* another thread took that slot */
+    }
+}
+
 void vout_control_Push(vout_control_t *ctrl, vout_control_cmd_t *cmd)
 {
-    vlc_mutex_lock(&ctrl->lock);
-    if (!ctrl->is_dead) {
-        ARRAY_APPEND(ctrl->cmd, *cmd);
-        vlc_cond_signal(&ctrl->wait_request);
-    } else {
+    if (vlc_atomic_get(&ctrl->is_dead)) {
         vout_control_cmd_Clean(cmd);
+        return;
     }
+
+    /* Once a command overflowed, the next ones follow it until the vout
+     * thread has caught up, to keep them in order */
+    if (!vlc_atomic_get(&ctrl->has_overflow) && ControlPushRing(ctrl, cmd)) {
+        /* Either the vout thread sees the command before it waits, or we see
+         * it waiting */
+        if (vlc_atomic_get(&ctrl->is_waiting)) {
+            vlc_mutex_lock(&ctrl->lock);
+            vlc_cond_signal(&ctrl->wait_request);
+            vlc_mutex_unlock(&ctrl->lock);
+        }
+        return;
+    }
+
+    vlc_mutex_lock(&ctrl->lock);
+    ARRAY_APPEND(ctrl->cmd, *cmd);
+    vlc_atomic_set(&ctrl->has_overflow, true);
+    vlc_cond_signal(&ctrl->wait_request);
     vlc_mutex_unlock(&ctrl->lock);
 }
 
@@ -181,15 +267,24 @@ void vout_control_PushString(vout_control_t *ctrl, int type, const char *string)
 int vout_control_Pop(vout_control_t *ctrl, vout_control_cmd_t *cmd,
                      mtime_t deadline, mtime_t timeout)
 {
+    /* Without locking while commands are coming */
+    vlc_atomic_set(&ctrl->is_processing, true);
+    if (ControlPopRing(ctrl, cmd))
+        return VLC_SUCCESS;
+
     vlc_mutex_lock(&ctrl->lock);
-    if (ctrl->cmd.i_size <= 0) {
-        ctrl->is_processing = false;
+    bool has_cmd = ControlPopLocked(ctrl, cmd);
+    if (!has_cmd) {
+        vlc_atomic_set(&ctrl->is_processing, false);
         vlc_cond_broadcast(&ctrl->wait_acknowledge);
 
         const mtime_t max_deadline = mdate() + timeout;
 
+        vlc_atomic_set(&ctrl->is_waiting, true);
         /* Supurious wake up are perfectly fine */
-        if (deadline <= VLC_TS_INVALID) {
+        if (!ControlIsEmpty(ctrl)) {
+            /* a command is being pushed, or has just been */
+        } else if (deadline <= VLC_TS_INVALID) {
             ctrl->is_sleeping = true;
             if (ctrl->can_sleep)
                 vlc_cond_timedwait(&ctrl->wait_request, &ctrl->lock, max_deadline);
@@ -197,18 +292,13 @@ int vout_control_Pop(vout_control_t *ctrl, vout_control_cmd_t *cmd,
         } else {
             vlc_cond_timedwait(&ctrl->wait_request, &ctrl->lock, __MIN(deadline, max_deadline));
         }
-    }
-
-    bool has_cmd;
-    if (ctrl->cmd.i_size > 0) {
-        has_cmd = true;
-        *cmd = ARRAY_VAL(ctrl->cmd, 0);
-        ARRAY_REMOVE(ctrl->cmd, 0);
+        vlc_atomic_set(&ctrl->is_waiting, false);
 
-        ctrl->is_processing = true;
-    } else {
-        has_cmd = false;
-        ctrl->can_sleep = true;
+        has_cmd = ControlPopLocked(ctrl, cmd);
+        if (has_cmd)
+            vlc_atomic_set(&ctrl->is_processing, true);
+        else
+            ctrl->can_sleep = true;
     }
     vlc_mutex_unlock(&ctrl->lock);
 
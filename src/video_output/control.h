@@ -100,16 +100,32 @@ typedef struct {
 void vout_control_cmd_Init(vout_control_cmd_t *, int type);
 void vout_control_cmd_Clean(vout_control_cmd_t *);
 
+#define VOUT_CONTROL_SLOTS 64 /* power of 2 */
+
+typedef struct {
+    vlc_atomic_t       seq; /* push index it is ready for, plus 1 if full */
+    vout_control_cmd_t cmd;
+} vout_control_slot_t;
+
 typedef struct {
     vlc_mutex_t lock;
     vlc_cond_t  wait_request;
     vlc_cond_t  wait_acknowledge;
 
     /* */
-    bool is_dead;
+    vlc_atomic_t is_dead;
     bool is_sleeping;
     bool can_sleep;
-    bool is_processing;
+    vlc_atomic_t is_processing;
+
+    /* Commands are pushed from any thread into a ring of preallocated slots
+     * without locking, and popped by the vout thread alone. When the ring
+     * is full, they overflow into cmd, under the lock. */
+    vout_control_slot_t slot[VOUT_CONTROL_SLOTS];
+    vlc_atomic_t push_index;
+    vlc_atomic_t pop_index;
+    vlc_atomic_t is_waiting;    /* the vout thread waits or is about to */
+    vlc_atomic_t has_overflow;  /* cmd is not empty */
     DECL_ARRAY(vout_control_cmd_t) cmd;
 } vout_control_t;
 
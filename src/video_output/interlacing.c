@@ -230,8 +230,73 @@ void vout_InitInterlacingSupport(vout_thread_t *vout, bool is_interlaced)
     free(deinterlace_mode);
 }
 
-void vout_SetInterlacingState(vout_thread_t *vout, vout_interlacing_support_t *state, bool is_interlaced)
+/*****************************************************************************
+ * Detection
+ *****************************************************************************/
+/* Some streams are flagged as progressive, but are interlaced or telecined.
+ * In automatic mode, the luma of the displayed frame is checked for combing
+ * a few times per second, on a sparse subset of its lines, with the comb
+ * metric of the deinterlace filter (see its metrics.h). Once the filter is
+ * in, it tells the combed frames itself. */
+#define COMBING_PERIOD      (CLOCK_FREQ / 4)
+#define COMBING_CONFIRM     2   /* checks in a row */
+#define COMBING_THRESHOLD   100
+#define COMBING_BLOCK_WIDTH 32
+#define COMBING_BLOCK_LINES 32
+#define COMBING_SAMPLING    8   /* one line in 8 */
+
+static bool DetectCombing(const picture_t *picture)
 {
+    const vlc_chroma_description_t *dsc =
+        vlc_fourcc_GetChromaDescription(picture->format.i_chroma);
+    if (!dsc || dsc->plane_count < 1 || dsc->pixel_size != 1 ||
+        !vlc_fourcc_IsYUV(picture->format.i_chroma) || picture->i_planes < 1)
+        return false;
+
+    const plane_t *plane = &picture->p[Y_PLANE];
+    const int pitch = plane->i_pitch;
+    /* A quarter of the tested pixels of a block */
+    const unsigned threshold =
+        COMBING_BLOCK_WIDTH * (COMBING_BLOCK_LINES / COMBING_SAMPLING) / 4;
+
+    for (int y0 = 0; y0 + COMBING_BLOCK_LINES < plane->i_visible_lines;
+         y0 += COMBING_BLOCK_LINES) {
+        for (int x0 = 0; x0 + COMBING_BLOCK_WIDTH <= plane->i_visible_pitch;
+             x0 += COMBING_BLOCK_WIDTH) {
+            unsigned count = 0;
+
+            for (int y = y0 + 1; y < y0 + COMBING_BLOCK_LINES; y += COMBING_SAMPLING) {
+                const uint8_t *c = &plane->p_pixels[y * pitch + x0];
+
+                for (int x = 0; x < COMBING_BLOCK_WIDTH; x++) {
+                    const int comb = (c[x - pitch] - c[x]) * (c[x + pitch] - c[x]);
+                    count += comb > COMBING_THRESHOLD;
+                }
+            }
+            if (count > threshold)
+                return true;
+        }
+    }
+    return false;
+}
+
+void vout_SetInterlacingState(vout_thread_t *vout, vout_interlacing_support_t *state, bool is_interlaced,
+                              const picture_t *picture)
+{
+    if (is_interlaced || !picture) {
+        state->combed_count = 0;
+    } else if (state->detect_date + COMBING_PERIOD <= mdate()) {
+        state->detect_date = mdate();
+        if (var_GetInteger(vout, "deinterlace") == -1 && DetectCombing(picture)) {
+            if (state->combed_count < COMBING_CONFIRM)
+                state->combed_count++;
+        } else {
+            state->combed_count = 0;
+        }
+    }
+    if (state->combed_count >= COMBING_CONFIRM)
+        is_interlaced = true;
+
      /* Wait 30s before quiting interlacing mode */
     const int interlacing_change = (!!is_interlaced) - (!!state->is_interlaced);
     if ((interlacing_change == 1) ||
@@ -27,9 +27,14 @@
 typedef struct {
     bool    is_interlaced;
     mtime_t date;
+
+    /* Detection of combing in frames flagged as progressive */
+    mtime_t  detect_date;
+    unsigned combed_count;
 } vout_interlacing_support_t;
 
 void vout_InitInterlacingSupport(vout_thread_t *, bool is_interlaced);
-void vout_SetInterlacingState(vout_thread_t *, vout_interlacing_support_t *, bool is_interlaced);
+void vout_SetInterlacingState(vout_thread_t *, vout_interlacing_support_t *, bool is_interlaced,
+                              const picture_t *);
 
 #endif
@@ -45,6 +45,7 @@
 #include <vlc_filter.h>
 #include <vlc_vout_osd.h>
 #include <vlc_image.h>
+#include <vlc_tracer.h>
 
 #include <libvlc.h>
 #include "vout_internal.h"
@@ -307,26 +308,27 @@ bool vout_IsEmpty(vout_thread_t *vout)
 {
     vlc_mutex_lock(&vout->p->picture_lock);
 
-    picture_t *picture = picture_fifo_Peek(vout->p->decoder_fifo);
-    if (picture)
-        picture_Release(picture);
+    bool is_empty = picture_fifo_IsEmpty(vout->p->decoder_fifo);
 
     vlc_mutex_unlock(&vout->p->picture_lock);
 
-    return !picture;
+    return is_empty;
 }
 
 void vout_FixLeaks( vout_thread_t *vout )
 {
     vlc_mutex_lock(&vout->p->picture_lock);
 
-    picture_t *picture = picture_fifo_Peek(vout->p->decoder_fifo);
-    if (!picture) {
-        picture = picture_pool_Get(vout->p->decoder_pool);
+    bool has_picture = !picture_fifo_IsEmpty(vout->p->decoder_fifo);
+    if (!has_picture) {
+        picture_t *picture = picture_pool_Get(vout->p->decoder_pool);
+        if (picture) {
+            picture_Release(picture);
+            has_picture = true;
+        }
     }
 
-    if (picture) {
-        picture_Release(picture);
+    if (has_picture) {
         /* Not all pictures has been displayed yet or some are
          * free */
         vlc_mutex_unlock(&vout->p->picture_lock);
@@ -818,6 +820,7 @@ static int ThreadDisplayPreparePicture(vout_thread_t *vout, bool reuse, bool is_
 {
     int lost_count = 0;
 
+    VLC_TRACE_BEGIN("vout prepare");
     vlc_mutex_lock(&vout->p->filter.lock);
 
     picture_t *picture = filter_chain_VideoFilter(vout->p->filter.chain_static, NULL);
@@ -834,6 +837,7 @@ static int ThreadDisplayPreparePicture(vout_thread_t *vout, bool reuse, bool is_
                 const mtime_t late = predicted - decoded->date;
                 if (late > VOUT_DISPLAY_LATE_THRESHOLD) {
                     msg_Warn(vout, "picture is too late to be displayed (missing %d ms)", (int)(late/1000));
+                    VLC_TRACE_INSTANT("vout drop");
                     picture_Release(decoded);
                     lost_count++;
                     continue;
@@ -861,6 +865,7 @@ static int ThreadDisplayPreparePicture(vout_thread_t *vout, bool reuse, bool is_
     }
 
     vlc_mutex_unlock(&vout->p->filter.lock);
+    VLC_TRACE_END("vout prepare");
 
     vout_statistic_Update(&vout->p->statistic, 0, lost_count);
     if (!picture)
@@ -882,13 +887,16 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
     picture_t *torender = picture_Hold(vout->p->displayed.current);
 
     vout_chrono_Start(&vout->p->render);
+    VLC_TRACE_BEGIN("vout render");
 
     vlc_mutex_lock(&vout->p->filter.lock);
     picture_t *filtered = filter_chain_VideoFilter(vout->p->filter.chain_interactive, torender);
     vlc_mutex_unlock(&vout->p->filter.lock);
 
-    if (!filtered)
+    if (!filtered) {
+        VLC_TRACE_END("vout render");
         return VLC_EGENERIC;
+    }
 
     if (filtered->date != vout->p->displayed.current->date)
         msg_Warn(vout, "Unsupported timestamp modifications done by chain_interactive");
@@ -983,8 +991,10 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
         subpicture_Delete(subpic);
         subpic = NULL;
 
-        if (!todisplay)
+        if (!todisplay) {
+            VLC_TRACE_END("vout render");
             return VLC_EGENERIC;
+        }
     }
 
     picture_t *direct;
@@ -1002,6 +1012,7 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
     if (!direct) {
         if (subpic)
             subpicture_Delete(subpic);
+        VLC_TRACE_END("vout render");
         return VLC_EGENERIC;
     }
 
@@ -1025,10 +1036,13 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
         }
         if (!do_dr_spu && subpic)
             subpicture_Delete(subpic);
-        if (!sys->display.filtered)
+        if (!sys->display.filtered) {
+            VLC_TRACE_END("vout render");
             return VLC_EGENERIC;
+        }
     }
 
+    VLC_TRACE_END("vout render");
     vout_chrono_Stop(&vout->p->render);
 #if 0
         {
@@ -1050,10 +1064,12 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
 
     /* Display the direct buffer returned by vout_RenderPicture */
     vout->p->displayed.date = mdate();
+    VLC_TRACE_BEGIN("vout display");
     vout_display_Display(vd,
                          sys->display.filtered ? sys->display.filtered
                                                 : direct,
                          subpic);
+    VLC_TRACE_END("vout display");
     sys->display.filtered = NULL;
 
     vout_statistic_Update(&vout->p->statistic, 1, 0);
@@ -1141,6 +1157,9 @@ static void ThreadManage(vout_thread_t *vout,
 
     const int  picture_qtype      = vout->p->displayed.qtype;
     const bool picture_interlaced = vout->p->displayed.is_interlaced;
+    picture_t  *picture_decoded   = vout->p->displayed.decoded;
+    if (picture_decoded)
+        picture_Hold(picture_decoded);
 
     vlc_mutex_unlock(&vout->p->picture_lock);
 
@@ -1148,7 +1167,9 @@ static void ThreadManage(vout_thread_t *vout,
     vout_SetPostProcessingState(vout, postprocessing, picture_qtype);
 
     /* Deinterlacing */
-    vout_SetInterlacingState(vout, interlacing, picture_interlaced);
+    vout_SetInterlacingState(vout, interlacing, picture_interlaced, picture_decoded);
+    if (picture_decoded)
+        picture_Release(picture_decoded);
 
     vout_ManageWrapper(vout);
 }
@@ -1330,7 +1351,7 @@ static void ThreadExecuteCropRatio(vout_thread_t *vout,
 static int ThreadStart(vout_thread_t *vout, const vout_display_state_t *state)
 {
     vlc_mouse_Init(&vout->p->mouse);
-    vout->p->decoder_fifo = picture_fifo_New();
+    vout->p->decoder_fifo = picture_fifo_NewSPSC();
     vout->p->decoder_pool = NULL;
     vout->p->display_pool = NULL;
     vout->p->private_pool = NULL;
@@ -1480,6 +1501,8 @@ static void *Thread(void *object)
 
     vout_interlacing_support_t interlacing = {
         .is_interlaced = false,
+        .detect_date   = VLC_TS_INVALID,
+        .combed_count  = 0,
         .date = mdate(),
     };
     vout_postprocessing_support_t postprocessing = {
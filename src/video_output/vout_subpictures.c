@@ -61,6 +61,38 @@ typedef struct {
     spu_heap_entry_t entry[VOUT_MAX_SUBPICTURES];
 } spu_heap_t;
 
+/* Number of rendered text regions kept for reuse */
+#define SPU_TEXT_CACHE_SIZE (16)
+
+/* Longest chroma list remembered for text rendering */
+#define SPU_CHROMA_MAX (8)
+
+/* Number of subtitles waiting to be rendered ahead of their display */
+#define SPU_PRERENDER_SIZE (8)
+
+/* A rendered text region, keyed by everything the text renderer uses */
+typedef struct {
+    char           *text;
+    char           *html;
+    text_style_t   *style;
+    int            align;
+    video_format_t fmt_in;
+    unsigned       render_width;
+    unsigned       render_height;
+    vlc_fourcc_t   chroma_list[SPU_CHROMA_MAX + 1];
+
+    video_format_t fmt_out;
+    picture_t      *picture;
+    unsigned       last_use;
+} spu_text_cache_entry_t;
+
+/* Copies of the text regions of a subtitle, to be rendered ahead */
+typedef struct {
+    subpicture_region_t *regions;
+    unsigned            render_width;
+    unsigned            render_height;
+} spu_prerender_job_t;
+
 struct spu_private_t {
     vlc_mutex_t  lock;            /* lock to protect all followings fields */
     vlc_object_t *input;
@@ -93,6 +125,26 @@ struct spu_private_t {
 
     /* */
     mtime_t last_sort_date;
+
+    /* Rendered text regions */
+    spu_text_cache_entry_t text_cache[SPU_TEXT_CACHE_SIZE];
+    unsigned               text_cache_use;
+
+    /* Text subtitles rendered ahead of their display */
+    struct {
+        vlc_thread_t        thread;
+        vlc_cond_t          wait;
+        bool                running;
+        bool                stop;
+        bool                reload;        /**< the input has changed */
+        spu_prerender_job_t job[SPU_PRERENDER_SIZE];
+        int                 count;
+
+        /* Output of the last rendering */
+        video_format_t      fmt_src;
+        video_format_t      fmt_dst;
+        vlc_fourcc_t        chroma_list[SPU_CHROMA_MAX + 1];
+    } prerender;
 };
 
 /*****************************************************************************
@@ -253,6 +305,181 @@ static filter_t *SpuRenderCreateAndLoadScale(vlc_object_t *object,
     return scale;
 }
 
+/*****************************************************************************
+ * Text cache
+ *****************************************************************************
+ * OSD and sub source filters (marq, rss, ...) often send the same text again
+ * in new subpictures. The rendered bitmaps are kept so that such regions
+ * cost a picture reference instead of a new rendering.
+ *****************************************************************************/
+static bool SpuTextStringEqual(const char *a, const char *b)
+{
+    if (!a || !b)
+        return a == b;
+    return !strcmp(a, b);
+}
+
+static bool SpuTextStyleEqual(const text_style_t *a, const text_style_t *b)
+{
+    if (!a || !b)
+        return a == b;
+    return SpuTextStringEqual(a->psz_fontname, b->psz_fontname) &&
+           a->i_font_size                == b->i_font_size &&
+           a->i_font_color               == b->i_font_color &&
+           a->i_font_alpha               == b->i_font_alpha &&
+           a->i_style_flags              == b->i_style_flags &&
+           a->i_outline_color            == b->i_outline_color &&
+           a->i_outline_alpha            == b->i_outline_alpha &&
+           a->i_shadow_color             == b->i_shadow_color &&
+           a->i_shadow_alpha             == b->i_shadow_alpha &&
+           a->i_background_color         == b->i_background_color &&
+           a->i_background_alpha         == b->i_background_alpha &&
+           a->i_karaoke_background_color == b->i_karaoke_background_color &&
+           a->i_karaoke_background_alpha == b->i_karaoke_background_alpha &&
+           a->i_outline_width            == b->i_outline_width &&
+           a->i_shadow_width             == b->i_shadow_width &&
+           a->i_spacing                  == b->i_spacing;
+}
+
+static bool SpuChromaListCopy(vlc_fourcc_t *dst, const vlc_fourcc_t *src)
+{
+    for (int i = 0; i <= SPU_CHROMA_MAX; i++) {
+        dst[i] = src[i];
+        if (src[i] == 0)
+            return true;
+    }
+    dst[0] = 0;
+    return false;
+}
+
+static bool SpuChromaListEqual(const vlc_fourcc_t *a, const vlc_fourcc_t *b)
+{
+    for (; *a == *b; a++, b++) {
+        if (*a == 0)
+            return true;
+    }
+    return false;
+}
+
+static bool SpuTextCacheMatch(const spu_text_cache_entry_t *entry,
+                              const subpicture_region_t *region,
+                              const filter_t *text,
+                              const vlc_fourcc_t *chroma_list)
+{
+    return entry->picture &&
+           entry->render_width  == text->fmt_out.video.i_width &&
+           entry->render_height == text->fmt_out.video.i_height &&
+           SpuChromaListEqual(entry->chroma_list, chroma_list) &&
+           entry->align         == region->i_align &&
+           entry->fmt_in.i_width          == region->fmt.i_width &&
+           entry->fmt_in.i_height         == region->fmt.i_height &&
+           entry->fmt_in.i_visible_width  == region->fmt.i_visible_width &&
+           entry->fmt_in.i_visible_height == region->fmt.i_visible_height &&
+           SpuTextStringEqual(entry->text, region->psz_text) &&
+           SpuTextStringEqual(entry->html, region->psz_html) &&
+           SpuTextStyleEqual(entry->style, region->p_style);
+}
+
+static void SpuTextCacheClean(spu_text_cache_entry_t *entry)
+{
+    free(entry->text);
+    free(entry->html);
+    if (entry->style)
+        text_style_Delete(entry->style);
+    if (entry->picture)
+        picture_Release(entry->picture);
+    memset(entry, 0, sizeof(*entry));
+}
+
+static spu_text_cache_entry_t *SpuTextCacheFind(spu_private_t *sys,
+                                                const subpicture_region_t *region,
+                                                const filter_t *text,
+                                                const vlc_fourcc_t *chroma_list)
+{
+    for (int i = 0; i < SPU_TEXT_CACHE_SIZE; i++) {
+        spu_text_cache_entry_t *entry = &sys->text_cache[i];
+
+        if (SpuTextCacheMatch(entry, region, text, chroma_list))
+            return entry;
+    }
+    return NULL;
+}
+
+static bool SpuTextCacheGet(spu_t *spu, subpicture_region_t *region,
+                            const vlc_fourcc_t *chroma_list)
+{
+    spu_private_t *sys = spu->p;
+    spu_text_cache_entry_t *entry = SpuTextCacheFind(sys, region, sys->text,
+                                                     chroma_list);
+    if (entry) {
+        entry->last_use = ++sys->text_cache_use;
+        if (region->p_picture)
+            picture_Release(region->p_picture);
+        region->p_picture = picture_Hold(entry->picture);
+        region->fmt = entry->fmt_out;
+        return true;
+    }
+    return false;
+}
+
+static void SpuTextCachePut(spu_t *spu, const filter_t *text,
+                            const subpicture_region_t *region,
+                            const video_format_t *fmt_in,
+                            const vlc_fourcc_t *chroma_list)
+{
+    spu_private_t *sys = spu->p;
+
+    /* Palettes are owned by the region format, do not bother with them */
+    if (!region->p_picture || region->fmt.p_palette)
+        return;
+
+    vlc_fourcc_t chromas[SPU_CHROMA_MAX + 1];
+    if (!SpuChromaListCopy(chromas, chroma_list))
+        return;
+
+    /* Replace the least recently used entry */
+    spu_text_cache_entry_t *entry = &sys->text_cache[0];
+    for (int i = 1; i < SPU_TEXT_CACHE_SIZE; i++) {
+        if (sys->text_cache[i].last_use < entry->last_use)
+            entry = &sys->text_cache[i];
+    }
+    SpuTextCacheClean(entry);
+
+    entry->text  = region->psz_text ? strdup(region->psz_text) : NULL;
+    entry->html  = region->psz_html ? strdup(region->psz_html) : NULL;
+    entry->style = region->p_style ? text_style_Duplicate(region->p_style) : NULL;
+    if ((region->psz_text && !entry->text) ||
+        (region->psz_html && !entry->html) ||
+        (region->p_style  && !entry->style)) {
+        SpuTextCacheClean(entry);
+        return;
+    }
+    entry->align         = region->i_align;
+    entry->fmt_in        = *fmt_in;
+    entry->fmt_in.p_palette = NULL;
+    entry->render_width  = text->fmt_out.video.i_width;
+    entry->render_height = text->fmt_out.video.i_height;
+    memcpy(entry->chroma_list, chromas, sizeof(chromas));
+    entry->fmt_out       = region->fmt;
+    entry->picture       = picture_Hold(region->p_picture);
+    entry->last_use      = ++sys->text_cache_use;
+}
+
+/* Renders a text region in place, returns true if it depends on the time */
+static bool SpuRenderTextRegion(filter_t *text, subpicture_region_t *region,
+                                const vlc_fourcc_t *chroma_list,
+                                mtime_t elapsed_time)
+{
+    var_SetTime(text, "spu-elapsed", elapsed_time);
+    var_SetBool(text, "text-rerender", false);
+
+    if (text->pf_render_html && region->psz_html)
+        text->pf_render_html(text, region, region, chroma_list);
+    else if (text->pf_render_text)
+        text->pf_render_text(text, region, region, chroma_list);
+    return var_GetBool(text, "text-rerender");
+}
+
 static void SpuRenderText(spu_t *spu, bool *rerender_text,
                           subpicture_region_t *region,
                           const vlc_fourcc_t *chroma_list,
@@ -265,6 +492,11 @@ static void SpuRenderText(spu_t *spu, bool *rerender_text,
     if (!text || !text->p_module)
         return;
 
+    if (SpuTextCacheGet(spu, region, chroma_list))
+        return;
+
+    const video_format_t fmt_in = region->fmt;
+
     /* Setup 3 variables which can be used to render
      * time-dependent text (and effects). The first indicates
      * the total amount of time the text will be on screen,
@@ -284,14 +516,187 @@ static void SpuRenderText(spu_t *spu, bool *rerender_text,
      * least show up on screen, but the effect won't change
      * the text over time.
      */
-    var_SetTime(text, "spu-elapsed", elapsed_time);
-    var_SetBool(text, "text-rerender", false);
+    *rerender_text = SpuRenderTextRegion(text, region, chroma_list,
+                                         elapsed_time);
 
-    if (text->pf_render_html && region->psz_html)
-        text->pf_render_html(text, region, region, chroma_list);
-    else if (text->pf_render_text)
-        text->pf_render_text(text, region, region, chroma_list);
-    *rerender_text = var_GetBool(text, "text-rerender");
+    /* Time dependent text must be rendered each time */
+    if (!*rerender_text && region->fmt.i_chroma != VLC_CODEC_TEXT)
+        SpuTextCachePut(spu, text, region, &fmt_in, chroma_list);
+}
+
+/*****************************************************************************
+ * Text pre-rendering
+ *****************************************************************************
+ * Text subtitles are sent well before their display. Their regions are
+ * rendered into the text cache by a thread with its own text renderer, for
+ * the output of the last rendering, so that the vout thread finds them
+ * ready. A change of that output drops the subtitles not rendered yet.
+ *****************************************************************************/
+static void SpuPrerenderJobClean(spu_prerender_job_t *job)
+{
+    subpicture_region_ChainDelete(job->regions);
+    job->regions = NULL;
+}
+
+static void SpuPrerenderFlush(spu_private_t *sys)
+{
+    for (int i = 0; i < sys->prerender.count; i++)
+        SpuPrerenderJobClean(&sys->prerender.job[i]);
+    sys->prerender.count = 0;
+}
+
+static void *SpuPrerenderThread(void *data)
+{
+    spu_t *spu = data;
+    spu_private_t *sys = spu->p;
+    filter_t *text = NULL;
+
+    vlc_mutex_lock(&sys->lock);
+    for (;;) {
+        while (!sys->prerender.stop && sys->prerender.count <= 0)
+            vlc_cond_wait(&sys->prerender.wait, &sys->lock);
+        if (sys->prerender.stop)
+            break;
+
+        spu_prerender_job_t job = sys->prerender.job[0];
+        sys->prerender.count--;
+        memmove(&sys->prerender.job[0], &sys->prerender.job[1],
+                sys->prerender.count * sizeof(job));
+
+        vlc_fourcc_t chroma_list[SPU_CHROMA_MAX + 1];
+        memcpy(chroma_list, sys->prerender.chroma_list, sizeof(chroma_list));
+
+        /* Loaded with the lock held, like the one of the vout thread, as
+         * the attachments are fetched from the input */
+        if (!text || sys->prerender.reload) {
+            if (text)
+                FilterRelease(text);
+            text = SpuRenderCreateAndLoadText(spu);
+            sys->prerender.reload = false;
+        }
+        vlc_mutex_unlock(&sys->lock);
+
+        if (text && text->p_module) {
+            text->fmt_out.video.i_width          =
+            text->fmt_out.video.i_visible_width  = job.render_width;
+            text->fmt_out.video.i_height         =
+            text->fmt_out.video.i_visible_height = job.render_height;
+        }
+        for (subpicture_region_t *r = job.regions;
+             r != NULL && text && text->p_module; r = r->p_next) {
+            vlc_mutex_lock(&sys->lock);
+            bool cached = SpuTextCacheFind(sys, r, text, chroma_list) != NULL;
+            vlc_mutex_unlock(&sys->lock);
+            if (cached)
+                continue;
+
+            const video_format_t fmt_in = r->fmt;
+            if (SpuRenderTextRegion(text, r, chroma_list, 0) ||
+                r->fmt.i_chroma == VLC_CODEC_TEXT)
+                continue;
+
+            vlc_mutex_lock(&sys->lock);
+            SpuTextCachePut(spu, text, r, &fmt_in, chroma_list);
+            vlc_mutex_unlock(&sys->lock);
+        }
+        SpuPrerenderJobClean(&job);
+
+        vlc_mutex_lock(&sys->lock);
+    }
+    vlc_mutex_unlock(&sys->lock);
+
+    if (text)
+        FilterRelease(text);
+    return NULL;
+}
+
+/**
+ * Lays out a new subtitle for the output of the last rendering and queues
+ * its text regions for pre-rendering. The subpicture is not shared yet.
+ */
+static void SpuPrerender(spu_t *spu, subpicture_t *subpic)
+{
+    spu_private_t *sys = spu->p;
+
+    if (!subpic->b_subtitle)
+        return;
+
+    vlc_mutex_lock(&sys->lock);
+    const bool has_output = sys->prerender.chroma_list[0] != 0;
+    video_format_t fmt_src = sys->prerender.fmt_src;
+    video_format_t fmt_dst = sys->prerender.fmt_dst;
+    vlc_mutex_unlock(&sys->lock);
+
+    if (!has_output)
+        return;
+
+    /* The vout thread will keep the regions as long as the output is the
+     * same */
+    subpicture_Update(subpic, &fmt_src, &fmt_dst, subpic->i_start);
+
+    spu_prerender_job_t job;
+    job.regions = NULL;
+    if (subpic->i_original_picture_width  > 0 &&
+        subpic->i_original_picture_height > 0) {
+        job.render_width  = subpic->i_original_picture_width;
+        job.render_height = subpic->i_original_picture_height;
+    } else {
+        job.render_width  = fmt_src.i_width;
+        job.render_height = fmt_src.i_height;
+    }
+
+    subpicture_region_t **last = &job.regions;
+    for (subpicture_region_t *r = subpic->p_region; r != NULL; r = r->p_next) {
+        if (r->fmt.i_chroma != VLC_CODEC_TEXT)
+            continue;
+
+        subpicture_region_t *copy = subpicture_region_New(&r->fmt);
+        if (!copy)
+            break;
+        copy->i_align  = r->i_align;
+        copy->psz_text = r->psz_text ? strdup(r->psz_text) : NULL;
+        copy->psz_html = r->psz_html ? strdup(r->psz_html) : NULL;
+        copy->p_style  = r->p_style ? text_style_Duplicate(r->p_style) : NULL;
+
+        *last = copy;
+        last  = &copy->p_next;
+    }
+    if (!job.regions)
+        return;
+
+    vlc_mutex_lock(&sys->lock);
+    if (!sys->prerender.running)
+        sys->prerender.running =
+            !vlc_clone(&sys->prerender.thread, SpuPrerenderThread, spu,
+                       VLC_THREAD_PRIORITY_LOW);
+    /* The older subtitles are the closer to their display */
+    if (sys->prerender.running && sys->prerender.count < SPU_PRERENDER_SIZE) {
+        sys->prerender.job[sys->prerender.count++] = job;
+        job.regions = NULL;
+        vlc_cond_signal(&sys->prerender.wait);
+    }
+    vlc_mutex_unlock(&sys->lock);
+
+    SpuPrerenderJobClean(&job);
+}
+
+/* Remembers the output of a rendering, with the lock held */
+static void SpuPrerenderSetOutput(spu_private_t *sys,
+                                  const vlc_fourcc_t *chroma_list,
+                                  const video_format_t *fmt_dst,
+                                  const video_format_t *fmt_src)
+{
+    if (SpuChromaListEqual(chroma_list, sys->prerender.chroma_list) &&
+        video_format_IsSimilar(fmt_dst, &sys->prerender.fmt_dst) &&
+        video_format_IsSimilar(fmt_src, &sys->prerender.fmt_src))
+        return;
+
+    SpuPrerenderFlush(sys);
+    SpuChromaListCopy(sys->prerender.chroma_list, chroma_list);
+    sys->prerender.fmt_dst = *fmt_dst;
+    sys->prerender.fmt_dst.p_palette = NULL;
+    sys->prerender.fmt_src = *fmt_src;
+    sys->prerender.fmt_src.p_palette = NULL;
 }
 
 /**
@@ -777,11 +1182,14 @@ static void SpuRenderRegion(spu_t *spu,
             convert_chroma = false;
     }
 
-    /* Scale from rendered size to destination size */
+    /* Scale from rendered size to destination size
+     * Palettized regions which need no scaling are kept as they are when the
+     * output accepts them: blending them directly reads 4 times less data
+     * than blending their YUVA/RGBA expansion. */
     if (sys->scale && sys->scale->p_module &&
         (!using_palette || (sys->scale_yuvp && sys->scale_yuvp->p_module)) &&
         (scale_size.w != SCALE_UNIT || scale_size.h != SCALE_UNIT ||
-        using_palette || convert_chroma)) {
+        convert_chroma)) {
         const unsigned dst_width  = spu_scale_w(region->fmt.i_width,  scale_size);
         const unsigned dst_height = spu_scale_h(region->fmt.i_height, scale_size);
 
@@ -1257,6 +1665,18 @@ spu_t *spu_Create(vlc_object_t *object)
     /* */
     sys->last_sort_date = -1;
 
+    memset(sys->text_cache, 0, sizeof(sys->text_cache));
+    sys->text_cache_use = 0;
+
+    vlc_cond_init(&sys->prerender.wait);
+    sys->prerender.running = false;
+    sys->prerender.stop    = false;
+    sys->prerender.reload  = false;
+    sys->prerender.count   = 0;
+    video_format_Init(&sys->prerender.fmt_src, 0);
+    video_format_Init(&sys->prerender.fmt_dst, 0);
+    sys->prerender.chroma_list[0] = 0;
+
     return spu;
 }
 
@@ -1269,6 +1689,16 @@ void spu_Destroy(spu_t *spu)
 {
     spu_private_t *sys = spu->p;
 
+    if (sys->prerender.running) {
+        vlc_mutex_lock(&sys->lock);
+        sys->prerender.stop = true;
+        vlc_cond_signal(&sys->prerender.wait);
+        vlc_mutex_unlock(&sys->lock);
+        vlc_join(sys->prerender.thread, NULL);
+    }
+    SpuPrerenderFlush(sys);
+    vlc_cond_destroy(&sys->prerender.wait);
+
     if (sys->text)
         FilterRelease(sys->text);
 
@@ -1288,6 +1718,9 @@ void spu_Destroy(spu_t *spu)
     /* Destroy all remaining subpictures */
     SpuHeapClean(&sys->heap);
 
+    for (int i = 0; i < SPU_TEXT_CACHE_SIZE; i++)
+        SpuTextCacheClean(&sys->text_cache[i]);
+
     vlc_mutex_destroy(&sys->lock);
 
     vlc_object_release(spu);
@@ -1312,6 +1745,7 @@ void spu_Attach(spu_t *spu, vlc_object_t *input, bool attach)
         if (spu->p->text)
             FilterRelease(spu->p->text);
         spu->p->text = SpuRenderCreateAndLoadText(spu);
+        spu->p->prerender.reload = true;
 
         vlc_mutex_unlock(&spu->p->lock);
     } else {
@@ -1398,6 +1832,9 @@ void spu_PutSubpicture(spu_t *spu, subpicture_t *subpic)
     if (subpic->i_channel == SPU_DEFAULT_CHANNEL)
         spu_ClearChannel(spu, SPU_DEFAULT_CHANNEL);
 
+    /* Render the text ahead, before the subpicture is shared */
+    SpuPrerender(spu, subpic);
+
     /* p_private is for spu only and cannot be non NULL here */
     for (subpicture_region_t *r = subpic->p_region; r != NULL; r = r->p_next)
         assert(r->p_private == NULL);
@@ -1460,6 +1897,8 @@ subpicture_t *spu_Render(spu_t *spu,
 
     vlc_mutex_lock(&sys->lock);
 
+    SpuPrerenderSetOutput(sys, chroma_list, fmt_dst, fmt_src);
+
     unsigned int subpicture_count;
     subpicture_t *subpicture_array[VOUT_MAX_SUBPICTURES];
 
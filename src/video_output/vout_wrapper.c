@@ -171,6 +171,13 @@ void vout_EndWrapper(vout_thread_t *vout)
     vout_thread_sys_t *sys = vout->p;
 
     assert(!sys->display.filtered);
+    if (sys->decoder_pool) {
+        unsigned used_max, starved;
+
+        picture_pool_GetStats(sys->decoder_pool, &used_max, &starved);
+        msg_Dbg(vout, "decoder pool: %u/%d pictures used at most, %u shortages",
+                used_max, picture_pool_GetSize(sys->decoder_pool), starved);
+    }
     if (sys->private_pool)
         picture_pool_Delete(sys->private_pool);
 
@@ -959,3 +959,15 @@ unsigned vlc_GetCPUCount (void)
 #endif
      return 1;
 }
+
+/* Threads do not inherit the affinity of their creator: no NUMA binding */
+unsigned vlc_numa_GetNodeCount (void)
+{
+    return 0;
+}
+
+int vlc_numa_Bind (int node)
+{
+    (void) node;
+    return ENOSYS;
+}
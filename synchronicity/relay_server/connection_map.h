@@ -1,10 +1,14 @@
 #ifndef _CONNECTION_MAP_H_
 #define _CONNECTION_MAP_H_
 
+#include <pthread.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <iostream>
 #include <stdio.h>
+#include <time.h>
+
+#include <vector>
 
 #define KEY_BUFFER_LENGTH 16
 #define KEY_LENGTH 8
@@ -80,4 +84,239 @@ std::ostream& operator<< (std::ostream& out, ConnectionMapKeyBuffer& val ) {
   return out;
 }
 
+#define CONNECTION_MAP_SHARDS 16
+#define CONNECTION_MAP_MIN_CAPACITY 64
+
+// A host socket waiting for its client
+struct PendingSocket {
+  ConnectionMapKey key;  // 0 marks an empty slot, RandomKey never hands it out
+  int sockfd;
+  time_t deadline;
+
+  PendingSocket()
+    : key(0), sockfd(-1), deadline(0) {
+  }
+
+  PendingSocket(ConnectionMapKey key, int sockfd, time_t deadline)
+    : key(key), sockfd(sockfd), deadline(deadline) {
+  }
+};
+
+// Pending host sockets by key. The key space is split into shards, each
+// an open addressing table with linear probing and its own lock, so
+// lookups stay O(1) with a million hosts waiting and threads working on
+// different keys do not contend. Deletion shifts the following entries
+// back instead of leaving tombstones, so probe chains never degrade.
+class ConnectionMap {
+ public:
+  ConnectionMap() {
+    for (unsigned int i = 0; i < CONNECTION_MAP_SHARDS; ++i) {
+      pthread_mutex_init(&shards[i].lock, NULL);
+      shards[i].slots.resize(CONNECTION_MAP_MIN_CAPACITY);
+      shards[i].count = 0;
+    }
+  }
+
+  ~ConnectionMap() {
+    for (unsigned int i = 0; i < CONNECTION_MAP_SHARDS; ++i) {
+      pthread_mutex_destroy(&shards[i].lock);
+    }
+  }
+
+  // Returns false if the key is taken already
+  bool Insert(const PendingSocket& entry) {
+    Shard& shard = ShardOf(entry.key);
+    pthread_mutex_lock(&shard.lock);
+    bool inserted = false;
+    if (!FindSlot(shard, entry.key, NULL)) {
+      if ((shard.count + 1) * 10 > shard.slots.size() * 7) {
+        Grow(shard);
+      }
+      Place(shard.slots, entry);
+      ++shard.count;
+      inserted = true;
+    }
+    pthread_mutex_unlock(&shard.lock);
+    return inserted;
+  }
+
+  bool Contains(ConnectionMapKey key) {
+    Shard& shard = ShardOf(key);
+    pthread_mutex_lock(&shard.lock);
+    bool found = FindSlot(shard, key, NULL);
+    pthread_mutex_unlock(&shard.lock);
+    return found;
+  }
+
+  // Copies the entry out if present
+  bool Find(ConnectionMapKey key, PendingSocket* entry) {
+    Shard& shard = ShardOf(key);
+    pthread_mutex_lock(&shard.lock);
+    size_t index;
+    bool found = FindSlot(shard, key, &index);
+    if (found && entry) {
+      *entry = shard.slots[index];
+    }
+    pthread_mutex_unlock(&shard.lock);
+    return found;
+  }
+
+  // Removes the entry and copies it out if present
+  bool Take(ConnectionMapKey key, PendingSocket* entry) {
+    Shard& shard = ShardOf(key);
+    pthread_mutex_lock(&shard.lock);
+    size_t index;
+    bool found = FindSlot(shard, key, &index);
+    if (found) {
+      if (entry) {
+        *entry = shard.slots[index];
+      }
+      Erase(shard, index);
+    }
+    pthread_mutex_unlock(&shard.lock);
+    return found;
+  }
+
+  // Take the entry only if it is due, for lazily cancelled timers
+  bool TakeExpired(ConnectionMapKey key, time_t now, PendingSocket* entry) {
+    Shard& shard = ShardOf(key);
+    pthread_mutex_lock(&shard.lock);
+    size_t index;
+    bool found = FindSlot(shard, key, &index) &&
+        shard.slots[index].deadline <= now;
+    if (found) {
+      if (entry) {
+        *entry = shard.slots[index];
+      }
+      Erase(shard, index);
+    }
+    pthread_mutex_unlock(&shard.lock);
+    return found;
+  }
+
+  size_t Size() {
+    size_t size = 0;
+    for (unsigned int i = 0; i < CONNECTION_MAP_SHARDS; ++i) {
+      pthread_mutex_lock(&shards[i].lock);
+      size += shards[i].count;
+      pthread_mutex_unlock(&shards[i].lock);
+    }
+    return size;
+  }
+
+  // Empty the map, handing every entry to the caller
+  void Drain(std::vector<PendingSocket>& entries) {
+    for (unsigned int i = 0; i < CONNECTION_MAP_SHARDS; ++i) {
+      Shard& shard = shards[i];
+      pthread_mutex_lock(&shard.lock);
+      for (size_t j = 0; j < shard.slots.size(); ++j) {
+        if (0 != shard.slots[j].key) {
+          entries.push_back(shard.slots[j]);
+        }
+      }
+      shard.slots.assign(CONNECTION_MAP_MIN_CAPACITY, PendingSocket());
+      shard.count = 0;
+      pthread_mutex_unlock(&shard.lock);
+    }
+  }
+
+  void Clear() {
+    std::vector<PendingSocket> entries;
+    Drain(entries);
+  }
+
+ private:
+  struct Shard {
+    pthread_mutex_t lock;
+    std::vector<PendingSocket> slots;  // size is a power of two
+    size_t count;
+  };
+
+  // Keys are random, but clients pick what they send us; mix the bits
+  // so crafted keys cannot pile up in one probe chain (splitmix64).
+  static uint64_t Hash(ConnectionMapKey key) {
+    uint64_t h = key;
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    return h ^ (h >> 31);
+  }
+
+  Shard& ShardOf(ConnectionMapKey key) {
+    return shards[Hash(key) >> 60 & (CONNECTION_MAP_SHARDS - 1)];
+  }
+
+  static size_t Home(const std::vector<PendingSocket>& slots,
+      ConnectionMapKey key) {
+    return Hash(key) & (slots.size() - 1);
+  }
+
+  static bool FindSlot(Shard& shard, ConnectionMapKey key, size_t* index) {
+    if (0 == key) {
+      return false;
+    }
+    size_t mask = shard.slots.size() - 1;
+    for (size_t i = Home(shard.slots, key); ; i = (i + 1) & mask) {
+      if (0 == shard.slots[i].key) {
+        return false;
+      }
+      if (key == shard.slots[i].key) {
+        if (index) {
+          *index = i;
+        }
+        return true;
+      }
+    }
+  }
+
+  static void Place(std::vector<PendingSocket>& slots,
+      const PendingSocket& entry) {
+    size_t mask = slots.size() - 1;
+    size_t i = Home(slots, entry.key);
+    while (0 != slots[i].key) {
+      i = (i + 1) & mask;
+    }
+    slots[i] = entry;
+  }
+
+  static void Grow(Shard& shard) {
+    std::vector<PendingSocket> slots(shard.slots.size() * 2);
+    for (size_t i = 0; i < shard.slots.size(); ++i) {
+      if (0 != shard.slots[i].key) {
+        Place(slots, shard.slots[i]);
+      }
+    }
+    shard.slots.swap(slots);
+  }
+
+  // Backward shift deletion: pull later members of the probe chain into
+  // the hole as long as that does not move them before their home slot.
+  static void Erase(Shard& shard, size_t hole) {
+    std::vector<PendingSocket>& slots = shard.slots;
+    size_t mask = slots.size() - 1;
+    size_t i = hole;
+    while (true) {
+      i = (i + 1) & mask;
+      if (0 == slots[i].key) {
+        break;
+      }
+      size_t home = Home(slots, slots[i].key);
+      // can slots[i] move to hole? only if home is not in (hole, i]
+      bool movable = (hole <= i) ? (home <= hole || home > i)
+                                 : (home <= hole && home > i);
+      if (movable) {
+        slots[hole] = slots[i];
+        hole = i;
+      }
+    }
+    slots[hole] = PendingSocket();
+    --shard.count;
+  }
+
+  Shard shards[CONNECTION_MAP_SHARDS];
+
+  // not copyable
+  ConnectionMap(const ConnectionMap&);
+  ConnectionMap& operator=(const ConnectionMap&);
+};
+
 #endif
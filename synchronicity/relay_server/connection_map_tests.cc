@@ -1,6 +1,13 @@
 #include <iostream>
 #include "connection_map.h"
+#include "relay_cluster.h"
+#include "relay_limits.h"
+#include "relay_log.h"
+#include "relay_session.h"
+#include "relay_stream.h"
+#include "timer_wheel.h"
 #include <string>
+#include <vector>
 #include "testing.h"
 
 
@@ -54,8 +61,372 @@ int TestSimpleParse(void) {
   return 0;
 }
 
+int TestMapInsertFindTake(void) {
+  ConnectionMap map;
+  if (!map.Insert(PendingSocket(0x1234, 5, 100))) {
+    std::cerr << "Insert failed" << std::endl;
+    return 1;
+  }
+  if (map.Insert(PendingSocket(0x1234, 6, 100))) {
+    std::cerr << "Duplicate key inserted" << std::endl;
+    return 1;
+  }
+  PendingSocket entry;
+  if (!map.Find(0x1234, &entry) || entry.sockfd != 5) {
+    std::cerr << "Find failed" << std::endl;
+    return 1;
+  }
+  if (map.Contains(0) || map.Contains(0x4321)) {
+    std::cerr << "Found a key never inserted" << std::endl;
+    return 1;
+  }
+  if (!map.Take(0x1234, &entry) || entry.sockfd != 5 || map.Size() != 0) {
+    std::cerr << "Take failed" << std::endl;
+    return 1;
+  }
+  if (map.Take(0x1234, &entry)) {
+    std::cerr << "Took a key twice" << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+int TestMapManyKeys(void) {
+  ConnectionMap map;
+  const int count = 100000;
+  // Sequential keys with a large stride still have to spread out
+  for (int i = 1; i <= count; ++i) {
+    if (!map.Insert(PendingSocket((ConnectionMapKey)i << 32, i, 0))) {
+      std::cerr << "Insert " << i << " failed" << std::endl;
+      return 1;
+    }
+  }
+  if (map.Size() != (size_t)count) {
+    std::cerr << "Expected size " << count << " Got: " << map.Size() << std::endl;
+    return 1;
+  }
+  // Removing every other key exercises the backward shift on long chains
+  for (int i = 2; i <= count; i += 2) {
+    if (!map.Take((ConnectionMapKey)i << 32, NULL)) {
+      std::cerr << "Take " << i << " failed" << std::endl;
+      return 1;
+    }
+  }
+  for (int i = 1; i <= count; ++i) {
+    PendingSocket entry;
+    bool found = map.Find((ConnectionMapKey)i << 32, &entry);
+    if (found != (i % 2 == 1) || (found && entry.sockfd != i)) {
+      std::cerr << "Lookup " << i << " wrong after removals" << std::endl;
+      return 1;
+    }
+  }
+  std::vector<PendingSocket> drained;
+  map.Drain(drained);
+  if (drained.size() != (size_t)count / 2 || map.Size() != 0) {
+    std::cerr << "Drain returned " << drained.size() << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+int TestMapTakeExpired(void) {
+  ConnectionMap map;
+  map.Insert(PendingSocket(0x10, 3, 50));
+  if (map.TakeExpired(0x10, 49, NULL)) {
+    std::cerr << "Expired before its deadline" << std::endl;
+    return 1;
+  }
+  if (!map.TakeExpired(0x10, 50, NULL) || map.Contains(0x10)) {
+    std::cerr << "Did not expire at its deadline" << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+int TestTimerWheel(void) {
+  TimerWheel<int> wheel(8, 1000);
+  wheel.Schedule(1000, 1);
+  wheel.Schedule(1003, 2);
+  wheel.Schedule(1020, 3);  // more than one lap away
+  wheel.Schedule(990, 4);   // already due
+  std::vector<int> expired;
+  wheel.Advance(1000, expired);
+  if (expired.size() != 2) {
+    std::cerr << "Expected 2 due at start Got: " << expired.size() << std::endl;
+    return 1;
+  }
+  expired.clear();
+  wheel.Advance(1002, expired);
+  if (!expired.empty()) {
+    std::cerr << "Fired early" << std::endl;
+    return 1;
+  }
+  wheel.Advance(1012, expired);
+  if (expired.size() != 1 || expired[0] != 2) {
+    std::cerr << "Expected entry 2 only" << std::endl;
+    return 1;
+  }
+  expired.clear();
+  wheel.Advance(1019, expired);
+  if (!expired.empty() || wheel.Size() != 1) {
+    std::cerr << "Entry a lap away fired early" << std::endl;
+    return 1;
+  }
+  wheel.Advance(1100, expired);
+  if (expired.size() != 1 || expired[0] != 3 || wheel.Size() != 0) {
+    std::cerr << "Entry a lap away never fired" << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+int TestKeyForNode(void) {
+  ConnectionMapKey key = KeyForNode(0xffffffffffffffffULL, 0x12);
+  if (key != 0x12ffffffffffffffULL || NodeOfKey(key) != 0x12) {
+    std::cerr << "Node not in top bits Got: " << std::hex << key << std::endl;
+    return 1;
+  }
+  if (NodeOfKey(KeyForNode(0x1234, 0)) != 0 || KeyForNode(0x1234, 0) != 0x1234) {
+    std::cerr << "Node 0 changed the key" << std::endl;
+    return 1;
+  }
+  RelayCluster cluster;  // not loaded: owns every key
+  if (!cluster.IsLocal(KeyForNode(1, 7)) || cluster.OwnKey(0xab) != 0xab) {
+    std::cerr << "Lone relay should own every key" << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+int TestSessionResume(void) {
+  RelaySessions sessions;
+  sessions.SetGrace(30);
+  ConnectionMapKey host = sessions.Open(0x42, 100);
+  if (0 == host || 0 != sessions.Join(0x43) || sessions.Knows(host)) {
+    std::cerr << "Pending session misbehaves" << std::endl;
+    return 1;
+  }
+  ConnectionMapKey client = sessions.Join(0x42);
+  RelaySession* session = sessions.Paired(0x42, 5, 6);
+  if (0 == client || client == host || NULL == session ||
+      !sessions.Knows(client)) {
+    std::cerr << "Pairing did not make a session" << std::endl;
+    return 1;
+  }
+  // The worker noticed the break before anyone resumed
+  if (!SessionBreak(session, false)) {
+    std::cerr << "Broken pair not resumable" << std::endl;
+    return 1;
+  }
+  int fds[2];
+  if (0 != socketpair(AF_UNIX, SOCK_STREAM, 0, fds)) {
+    return 1;
+  }
+  std::vector<RelaySession*> ready;
+  if (!sessions.Resume(client, fds[1])) {
+    std::cerr << "Resume refused" << std::endl;
+    return 1;
+  }
+  sessions.Ready(ready);
+  if (!ready.empty()) {
+    std::cerr << "Ready with one side only" << std::endl;
+    return 1;
+  }
+  sessions.Resume(host, fds[0]);
+  sessions.Ready(ready);
+  if (ready.size() != 1 || ready[0]->sockfd[0] != fds[0] ||
+      ready[0]->sockfd[1] != fds[1] || SESSION_PAIRED != session->state) {
+    std::cerr << "Both sides back but not ready" << std::endl;
+    return 1;
+  }
+  // A clean close ends it for good
+  if (SessionBreak(session, true) || sessions.Knows(host)) {
+    std::cerr << "Ended session still resumable" << std::endl;
+    return 1;
+  }
+  close(fds[0]);
+  close(fds[1]);
+  sessions.Expire(1000);
+  if (sessions.Size() != 0) {
+    std::cerr << "Ended session kept" << std::endl;
+    return 1;
+  }
+  // A client that did not ask for a session makes the host's useless
+  sessions.Open(0x50, 100);
+  if (NULL != sessions.Paired(0x50, 7, 8) || sessions.Size() != 0) {
+    std::cerr << "Session without client token kept" << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+int TestStreamBackpressure(void) {
+  StreamQueue fast, slow;
+  const size_t size = STREAM_MAX_BACKLOG / 4;
+  StreamSegment* first = new StreamSegment();
+  first->data.assign(size, 'a');
+  fast.Push(first);
+  slow.Push(first);
+  SegmentRelease(first);
+  // The fast sink sends everything, the slow one half of the first
+  fast.Consumed(fast.Available());
+  slow.Consumed(size / 2);
+  if (0 != fast.Backlog() || size - size / 2 != slow.Backlog()) {
+    std::cerr << "Backlog miscounted" << std::endl;
+    return 1;
+  }
+  size_t dropped = 0;
+  for (char c = 'b'; c <= 'f'; ++c) {
+    StreamSegment* segment = new StreamSegment();
+    segment->data.assign(size, c);
+    if (0 != fast.Push(segment)) {
+      std::cerr << "Fast sink skipped" << std::endl;
+      return 1;
+    }
+    fast.Consumed(fast.Available());
+    dropped += slow.Push(segment);
+    SegmentRelease(segment);
+  }
+  // Over the cap at 'e' the slow sink dropped what it had not started,
+  // never a part of a frame, and went on with 'e' and 'f'
+  if (3 != dropped || 3 != slow.Skipped() || 3 != slow.Size() ||
+      slow.Backlog() > STREAM_MAX_BACKLOG) {
+    std::cerr << "Slow sink not skipped ahead: " << dropped << " dropped, "
+        << slow.Size() << " queued" << std::endl;
+    return 1;
+  }
+  slow.Consumed(slow.Available());
+  if (slow.Available() != size || slow.Data()[0] != 'e') {
+    std::cerr << "Slow sink did not go on from the newest frame"
+        << std::endl;
+    return 1;
+  }
+  slow.Consumed(size);
+  slow.Consumed(size);
+  if (0 != slow.Backlog() || 0 != slow.Size()) {
+    std::cerr << "Queue not drained" << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+int TestTokenBucket(void) {
+  TokenBucket bucket;
+  bucket.Init(1000, 500, 10000);
+  if (500 != bucket.Allow(800, 10000)) {
+    std::cerr << "Burst not allowed at once" << std::endl;
+    return 1;
+  }
+  bucket.Spend(500);
+  if (0 != bucket.Allow(100, 10000) || 0 == bucket.WaitMs()) {
+    std::cerr << "Empty bucket let bytes through" << std::endl;
+    return 1;
+  }
+  // 1000 bytes a second is one byte a millisecond
+  bucket.Allow(100, 10001);
+  if (1 != bucket.Allow(100, 10001) || 2 != bucket.Allow(100, 10002)) {
+    std::cerr << "Bucket refilled wrong" << std::endl;
+    return 1;
+  }
+  // A long pause refills up to the burst only
+  if (500 != bucket.Allow(10000, 99999999)) {
+    std::cerr << "Bucket overfilled" << std::endl;
+    return 1;
+  }
+  TokenBucket unlimited;
+  unlimited.Init(0, 0, 0);
+  unlimited.Spend(1 << 30);
+  if (4096 != unlimited.Allow(4096, 0)) {
+    std::cerr << "Unlimited bucket throttled" << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+int TestAdmission(void) {
+  struct sockaddr_storage storage;
+  memset(&storage, 0, sizeof(storage));
+  struct sockaddr_in* in = (struct sockaddr_in*)&storage;
+  in->sin_family = AF_INET;
+  in->sin_addr.s_addr = htonl(0x0a000001);
+  RelayAddr first(storage);
+  in->sin_addr.s_addr = htonl(0x0a000002);
+  RelayAddr second(storage);
+
+  RelayAdmission admission;
+  admission.SetLimits(2, 1);
+  if (!admission.AdmitHandshake(first) || !admission.AdmitHandshake(first) ||
+      admission.AdmitHandshake(first) || !admission.AdmitHandshake(second)) {
+    std::cerr << "Handshake limit not per address" << std::endl;
+    return 1;
+  }
+  admission.HandshakeDone(first);
+  if (!admission.AdmitHandshake(first)) {
+    std::cerr << "Finished handshake still counted" << std::endl;
+    return 1;
+  }
+  admission.AddPending(0x42, first);
+  admission.AddPending(0x42, first);  // the same host waiting again
+  if (admission.MayHost(first) || !admission.MayHost(second)) {
+    std::cerr << "Pending limit not per address" << std::endl;
+    return 1;
+  }
+  admission.RemovePending(0x42);
+  if (!admission.MayHost(first)) {
+    std::cerr << "Pending key still counted" << std::endl;
+    return 1;
+  }
+  admission.HandshakeDone(first);
+  admission.HandshakeDone(first);
+  admission.HandshakeDone(second);
+  if (0 != admission.NumAddrs()) {
+    std::cerr << "Idle addresses kept" << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+int TestLogRing(void) {
+  FILE* out = tmpfile();
+  RelayLog* log = new RelayLog(out);
+  log->Log(LOG_HOST_WAITING, 0x42);
+  log->Log(LOG_MATCHED, 0x42, 3);
+  if (2 != log->Drain() || 0 != log->Drain()) {
+    std::cerr << "Entries not drained once" << std::endl;
+    return 1;
+  }
+  // Lapped by writers, the oldest entries are lost
+  for (int i = 0; i < RELAY_LOG_SIZE + 10; ++i) {
+    log->Log(LOG_SESSION_OVER, i);
+  }
+  if (RELAY_LOG_SIZE != log->Drain() || 10 != log->Lost()) {
+    std::cerr << "Overwritten entries not counted" << std::endl;
+    return 1;
+  }
+  rewind(out);
+  char line[128];
+  if (NULL == fgets(line, sizeof(line), out) ||
+      NULL == strstr(line, "Inserting with key 0x42")) {
+    std::cerr << "Entry misformatted: " << line << std::endl;
+    return 1;
+  }
+  delete log;
+  fclose(out);
+  return 0;
+}
+
 int main(void) {
   run_test(TestSimplePrintKey, "TestSimplePrintKey");
   run_test(TestSimpleParse, "TestSimpleParse");
+  run_test(TestMapInsertFindTake, "TestMapInsertFindTake");
+  run_test(TestMapManyKeys, "TestMapManyKeys");
+  run_test(TestMapTakeExpired, "TestMapTakeExpired");
+  run_test(TestTimerWheel, "TestTimerWheel");
+  run_test(TestKeyForNode, "TestKeyForNode");
+  run_test(TestSessionResume, "TestSessionResume");
+  run_test(TestStreamBackpressure, "TestStreamBackpressure");
+  run_test(TestTokenBucket, "TestTokenBucket");
+  run_test(TestAdmission, "TestAdmission");
+  run_test(TestLogRing, "TestLogRing");
   return 0;
 }
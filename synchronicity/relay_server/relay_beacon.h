@@ -0,0 +1,129 @@
+#ifndef _RELAY_BEACON_H_
+#define _RELAY_BEACON_H_
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+
+#include <map>
+
+#include "connection_map.h"
+#include "relay_common.h"
+
+// Sync beacons of a pair may also travel as UDP datagrams on the relay
+// port, so a lost packet costs one sample instead of stalling the TCP
+// stream behind it. Every datagram starts with
+//   magic "SYNB", the pair's key (8 bytes, big endian), the sender's
+//   role (0 host, 1 client)
+// and is passed on as it is to the address the other side last sent
+// from. A datagram with nothing after the header only tells us the
+// sender's address. Only keys paired here are relayed.
+#define BEACON_MAGIC "SYNB"
+#define BEACON_HEADER 13
+#define BEACON_MAX_DATAGRAM 512
+#define BEACON_SESSION_TIMEOUT 120  // seconds without a datagram
+#define BEACON_SWEEP_INTERVAL 10
+
+struct BeaconSession {
+  struct sockaddr_storage addr[2];  // by role
+  socklen_t addr_len[2];
+  time_t last_seen;
+};
+
+class RelayBeacons {
+ public:
+  RelayBeacons() : sockfd(-1), last_sweep(0) {
+  }
+
+  ~RelayBeacons() {
+    if (sockfd != -1) {
+      close(sockfd);
+    }
+  }
+
+  // Bind the datagram socket to the relay's port. Returns 0 on success.
+  int Open(const char* port) {
+    sockfd = prepare_server_socket(port, 0, SOCK_DGRAM);
+    if (sockfd == -1 || 0 != set_nonblocking(sockfd)) {
+      return 1;
+    }
+    return 0;
+  }
+
+  int Socket() const { return sockfd; }
+
+  // A host and its client were paired under key
+  void Pair(ConnectionMapKey key, time_t now) {
+    BeaconSession& session = sessions[key];
+    memset(&session, 0, sizeof(session));
+    session.last_seen = now;
+  }
+
+  // Relay every datagram waiting on the socket
+  void Receive(time_t now) {
+    unsigned char buffer[BEACON_MAX_DATAGRAM];
+    for (;;) {
+      struct sockaddr_storage from;
+      socklen_t from_len = sizeof(from);
+      ssize_t rv = recvfrom(sockfd, buffer, sizeof(buffer), 0,
+          (struct sockaddr*)&from, &from_len);
+      if (rv < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+          perror("beacon recvfrom");
+        }
+        return;
+      }
+      if (rv < BEACON_HEADER || 0 != memcmp(buffer, BEACON_MAGIC, 4) ||
+          buffer[12] > 1) {
+        continue;
+      }
+      ConnectionMapKey key = 0;
+      for (int i = 4; i < 12; ++i) {
+        key = (key << 8) | buffer[i];
+      }
+      std::map<ConnectionMapKey, BeaconSession>::iterator itr =
+        sessions.find(key);
+      if (itr == sessions.end()) {
+        continue;
+      }
+      BeaconSession& session = itr->second;
+      int role = buffer[12];
+      memcpy(&session.addr[role], &from, from_len);
+      session.addr_len[role] = from_len;
+      session.last_seen = now;
+      if (rv > BEACON_HEADER && session.addr_len[1 - role] > 0) {
+        // a full socket buffer only costs this sample
+        sendto(sockfd, buffer, rv, 0,
+            (struct sockaddr*)&session.addr[1 - role],
+            session.addr_len[1 - role]);
+      }
+    }
+  }
+
+  // Forget pairs that stopped sending beacons
+  void Expire(time_t now) {
+    if (now - last_sweep < BEACON_SWEEP_INTERVAL) {
+      return;
+    }
+    last_sweep = now;
+    std::map<ConnectionMapKey, BeaconSession>::iterator itr =
+      sessions.begin();
+    while (itr != sessions.end()) {
+      if (now - itr->second.last_seen > BEACON_SESSION_TIMEOUT) {
+        sessions.erase(itr++);
+      } else {
+        ++itr;
+      }
+    }
+  }
+
+ private:
+  int sockfd;
+  time_t last_sweep;
+  std::map<ConnectionMapKey, BeaconSession> sessions;
+};
+
+#endif
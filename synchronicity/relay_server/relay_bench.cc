@@ -0,0 +1,444 @@
+// Load test for the relay server.
+//
+// Opens N host/client pairs against a running relay, then has every host
+// send framed messages to its client at a fixed rate for a while; clients
+// echo them back. Reports how long pairing took, the round trip through
+// the relay, throughput and, given the relay's pid, its resident memory.
+// Several values of N can be given to see how the relay scales.
+//
+//   g++ -O2 relay_bench.cc -o relay_bench
+//   ./relay_bench -n 1,10,100,1000 -r 20 -d 10 -P `pidof server`
+
+#include <errno.h>
+#include <netdb.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "connection_map.h"
+#include "relay_common.h"
+
+#define DEFAULT_ADDRESS "127.0.0.1"
+#define DEFAULT_PORT "56789"
+#define DEFAULT_RATE 10          // messages per second per pair
+#define DEFAULT_DURATION 5       // seconds per run
+#define DEFAULT_PAYLOAD 32       // bytes after the header
+#define BENCH_READ_SIZE 65536
+// Stop queueing on a host that is this far behind, the relay is saturated
+#define MAX_BACKLOG (1 << 20)
+
+// Same layout as SynSegmentHeader in src/synchronicity, which is sent in
+// host byte order as well
+struct BenchSegmentHeader {
+  uint64_t flag;
+  uint64_t timestamp_sync;
+  uint64_t timestamp_reply;
+  uint64_t length;
+};
+
+#define FLAG_REQUEST 0
+#define FLAG_REPLY 1
+
+typedef uint64_t Microseconds;
+
+Microseconds Now() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (Microseconds)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+struct BenchPeer {
+  int sockfd;
+  std::string in;   // bytes of the message being received
+  std::string out;  // bytes still to send
+  size_t sent;
+
+  BenchPeer() : sockfd(-1), sent(0) {}
+};
+
+struct BenchPair {
+  BenchPeer host;
+  BenchPeer client;
+  Microseconds next_send;
+};
+
+struct BenchResult {
+  std::vector<Microseconds> pairing;
+  std::vector<Microseconds> rtt;
+  uint64_t bytes;
+  uint64_t messages;
+  uint64_t skipped;
+  int failed_pairs;
+
+  BenchResult() : bytes(0), messages(0), skipped(0), failed_pairs(0) {}
+};
+
+struct addrinfo* relay_address;
+int rate = DEFAULT_RATE;
+int duration = DEFAULT_DURATION;
+int payload_size = DEFAULT_PAYLOAD;
+long relay_pid = -1;
+
+// Blocking connect to the relay, -1 on failure
+int ConnectRelay() {
+  int sockfd = socket(relay_address->ai_family, relay_address->ai_socktype,
+      relay_address->ai_protocol);
+  if (sockfd == -1) {
+    perror("socket");
+    return -1;
+  }
+  if (connect(sockfd, relay_address->ai_addr, relay_address->ai_addrlen) == -1) {
+    perror("connect");
+    close(sockfd);
+    return -1;
+  }
+  return sockfd;
+}
+
+// Key exchange of one pair. Returns 0 and the time the client waited
+// for its match on success.
+int OpenPair(BenchPair* pair, Microseconds* pairing) {
+  ConnectionMapKeyBuffer key;
+  ConnectionMapKeyBuffer reply;
+  PrintKey(0, key);
+  pair->host.sockfd = ConnectRelay();
+  if (pair->host.sockfd == -1 ||
+      0 != ssend_all(pair->host.sockfd, key, KEY_BUFFER_LENGTH) ||
+      0 != srecv_all(pair->host.sockfd, key, KEY_BUFFER_LENGTH)) {
+    return 1;
+  }
+  Microseconds start = Now();
+  pair->client.sockfd = ConnectRelay();
+  if (pair->client.sockfd == -1 ||
+      0 != ssend_all(pair->client.sockfd, key, KEY_BUFFER_LENGTH) ||
+      0 != srecv_all(pair->client.sockfd, reply, KEY_BUFFER_LENGTH)) {
+    return 1;
+  }
+  *pairing = Now() - start;
+  set_nonblocking(pair->host.sockfd);
+  set_nonblocking(pair->client.sockfd);
+  return 0;
+}
+
+void ClosePair(BenchPair* pair) {
+  if (pair->host.sockfd != -1) {
+    close(pair->host.sockfd);
+  }
+  if (pair->client.sockfd != -1) {
+    close(pair->client.sockfd);
+  }
+}
+
+void Queue(BenchPeer* peer, uint64_t flag, Microseconds sync,
+    Microseconds reply) {
+  BenchSegmentHeader header;
+  header.flag = flag;
+  header.timestamp_sync = sync;
+  header.timestamp_reply = reply;
+  header.length = payload_size;
+  peer->out.append((const char*)&header, sizeof(header));
+  peer->out.append(payload_size, 'x');
+}
+
+// Returns false if the relay closed the connection
+bool Flush(BenchPeer* peer) {
+  while (peer->sent < peer->out.size()) {
+    int rv = send(peer->sockfd, peer->out.data() + peer->sent,
+        peer->out.size() - peer->sent, MSG_NOSIGNAL);
+    if (rv < 0) {
+      return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+    peer->sent += rv;
+  }
+  peer->out.clear();
+  peer->sent = 0;
+  return true;
+}
+
+// Read whatever arrived and handle every complete message: clients
+// echo requests, hosts record the round trip of replies.
+bool Receive(BenchPeer* peer, bool is_host, BenchResult* result) {
+  char buffer[BENCH_READ_SIZE];
+  int rv;
+  while ((rv = recv(peer->sockfd, buffer, sizeof(buffer), 0)) > 0) {
+    result->bytes += rv;
+    peer->in.append(buffer, rv);
+  }
+  if (rv == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+    return false;
+  }
+  size_t offset = 0;
+  while (peer->in.size() - offset >= sizeof(BenchSegmentHeader)) {
+    BenchSegmentHeader header;
+    memcpy(&header, peer->in.data() + offset, sizeof(header));
+    size_t total = sizeof(header) + header.length;
+    if (peer->in.size() - offset < total) {
+      break;
+    }
+    offset += total;
+    ++result->messages;
+    if (is_host && FLAG_REPLY == header.flag) {
+      result->rtt.push_back(Now() - header.timestamp_sync);
+    } else if (!is_host && FLAG_REQUEST == header.flag) {
+      Queue(peer, FLAG_REPLY, header.timestamp_sync, Now());
+    }
+  }
+  peer->in.erase(0, offset);
+  return true;
+}
+
+// Resident set of the relay in kB, -1 if unknown
+long RelayRss() {
+  if (relay_pid == -1) {
+    return -1;
+  }
+  char path[64];
+  snprintf(path, sizeof(path), "/proc/%ld/status", relay_pid);
+  FILE* file = fopen(path, "r");
+  if (NULL == file) {
+    return -1;
+  }
+  char line[256];
+  long rss = -1;
+  while (fgets(line, sizeof(line), file)) {
+    if (1 == sscanf(line, "VmRSS: %ld", &rss)) {
+      break;
+    }
+  }
+  fclose(file);
+  return rss;
+}
+
+// Drive traffic over all pairs for the configured duration
+void RunTraffic(std::vector<BenchPair>& pairs, BenchResult* result) {
+  Microseconds interval = 1000000 / rate;
+  Microseconds start = Now();
+  Microseconds end = start + (Microseconds)duration * 1000000;
+  // Spread the first sends over one interval so pairs do not beat in step
+  for (size_t i = 0; i < pairs.size(); ++i) {
+    pairs[i].next_send = start + interval * i / pairs.size();
+  }
+
+  std::vector<struct pollfd> fds(pairs.size() * 2);
+  Microseconds now = start;
+  while (now < end) {
+    Microseconds next = end;
+    for (size_t i = 0; i < pairs.size(); ++i) {
+      BenchPair& pair = pairs[i];
+      if (pair.host.sockfd == -1) {
+        continue;
+      }
+      while (pair.next_send <= now) {
+        if (pair.host.out.size() < MAX_BACKLOG) {
+          Queue(&pair.host, FLAG_REQUEST, now, 0);
+        } else {
+          ++result->skipped;
+        }
+        pair.next_send += interval;
+      }
+      next = std::min(next, pair.next_send);
+    }
+
+    for (size_t i = 0; i < pairs.size(); ++i) {
+      BenchPeer* peers[2] = { &pairs[i].host, &pairs[i].client };
+      for (int side = 0; side < 2; ++side) {
+        struct pollfd& fd = fds[2 * i + side];
+        fd.fd = peers[side]->sockfd;
+        fd.events = POLLIN;
+        if (!peers[side]->out.empty()) {
+          fd.events |= POLLOUT;
+        }
+        fd.revents = 0;
+      }
+    }
+    int timeout = next > now ? (int)((next - now + 999) / 1000) : 0;
+    if (poll(&fds[0], fds.size(), timeout) < 0 && errno != EINTR) {
+      perror("poll");
+      return;
+    }
+
+    for (size_t i = 0; i < pairs.size(); ++i) {
+      BenchPair& pair = pairs[i];
+      if (pair.host.sockfd == -1) {
+        continue;
+      }
+      bool ok = true;
+      if (fds[2 * i].revents) {
+        ok = Receive(&pair.host, true, result);
+      }
+      if (ok && fds[2 * i + 1].revents) {
+        ok = Receive(&pair.client, false, result);
+      }
+      ok = ok && Flush(&pair.host) && Flush(&pair.client);
+      if (!ok) {
+        fprintf(stderr, "pair %zu: relay closed the connection\n", i);
+        ClosePair(&pair);
+        pair.host.sockfd = pair.client.sockfd = -1;
+        ++result->failed_pairs;
+      }
+    }
+    now = Now();
+  }
+}
+
+Microseconds Percentile(std::vector<Microseconds>& samples, double p) {
+  if (samples.empty()) {
+    return 0;
+  }
+  size_t index = (size_t)(p * (samples.size() - 1));
+  std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+  return samples[index];
+}
+
+void PrintHeader() {
+  printf("%7s %9s %9s %9s %9s %9s %9s %10s %9s %8s %10s\n",
+      "pairs", "pair_p50", "pair_p99", "pair_p999",
+      "rtt_p50", "rtt_p99", "rtt_p999", "msgs/s", "MB/s", "failed",
+      "relay_kB");
+}
+
+void PrintResult(size_t num_pairs, BenchResult& result, long rss) {
+  printf("%7zu %9llu %9llu %9llu %9llu %9llu %9llu %10.0f %9.2f %8d %10ld\n",
+      num_pairs,
+      (unsigned long long)Percentile(result.pairing, 0.5),
+      (unsigned long long)Percentile(result.pairing, 0.99),
+      (unsigned long long)Percentile(result.pairing, 0.999),
+      (unsigned long long)Percentile(result.rtt, 0.5),
+      (unsigned long long)Percentile(result.rtt, 0.99),
+      (unsigned long long)Percentile(result.rtt, 0.999),
+      (double)result.messages / duration,
+      (double)result.bytes / duration / (1024 * 1024),
+      result.failed_pairs, rss);
+  if (result.skipped) {
+    printf("        %llu sends skipped, relay could not keep up\n",
+        (unsigned long long)result.skipped);
+  }
+  fflush(stdout);
+}
+
+void Bench(size_t num_pairs) {
+  BenchResult result;
+  std::vector<BenchPair> pairs(num_pairs);
+  for (size_t i = 0; i < num_pairs; ++i) {
+    Microseconds pairing;
+    if (0 != OpenPair(&pairs[i], &pairing)) {
+      fprintf(stderr, "could only open %zu of %zu pairs\n", i, num_pairs);
+      ClosePair(&pairs[i]);
+      pairs.resize(i);
+      break;
+    }
+    result.pairing.push_back(pairing);
+  }
+  if (!pairs.empty()) {
+    RunTraffic(pairs, &result);
+  }
+  long rss = RelayRss();  // while all pairs are still open
+  for (size_t i = 0; i < pairs.size(); ++i) {
+    ClosePair(&pairs[i]);
+  }
+  PrintResult(pairs.size(), result, rss);
+}
+
+void usage(const char* name) {
+  fprintf(stderr, "Usage: %s [-a address] [-p port] [-n pairs[,pairs...]]"
+      " [-r rate] [-d seconds] [-s bytes] [-P relay pid]\n"
+      "  -a address  relay to test [default: %s]\n"
+      "  -p port     relay port [default: %s]\n"
+      "  -n pairs    comma separated numbers of pairs, one run each\n"
+      "  -r rate     messages per second each host sends [default: %d]\n"
+      "  -d seconds  length of each run [default: %d]\n"
+      "  -s bytes    payload after each segment header [default: %d]\n"
+      "  -P pid      relay process whose memory to report\n"
+      "Times are in microseconds.\n",
+      name, DEFAULT_ADDRESS, DEFAULT_PORT, DEFAULT_RATE, DEFAULT_DURATION,
+      DEFAULT_PAYLOAD);
+}
+
+int main(int argc, char* argv[]) {
+  const char* address = DEFAULT_ADDRESS;
+  const char* port = DEFAULT_PORT;
+  std::vector<size_t> runs;
+  int opt;
+  while ((opt = getopt(argc, argv, "a:p:n:r:d:s:P:h")) != -1) {
+    switch (opt) {
+      case 'a':
+        address = optarg;
+        break;
+      case 'p':
+        port = optarg;
+        break;
+      case 'n': {
+        char* next = optarg;
+        while (*next) {
+          long n = strtol(next, &next, 10);
+          if (n > 0) {
+            runs.push_back(n);
+          }
+          if (*next == ',') {
+            ++next;
+          } else if (*next) {
+            usage(argv[0]);
+            exit(1);
+          }
+        }
+        break;
+      }
+      case 'r':
+        rate = atoi(optarg);
+        break;
+      case 'd':
+        duration = atoi(optarg);
+        break;
+      case 's':
+        payload_size = atoi(optarg);
+        break;
+      case 'P':
+        relay_pid = strtol(optarg, NULL, 10);
+        break;
+      default:
+        usage(argv[0]);
+        exit(1);
+    }
+  }
+  if (runs.empty()) {
+    runs.push_back(1);
+  }
+  if (rate < 1 || duration < 1 || payload_size < 0) {
+    usage(argv[0]);
+    exit(1);
+  }
+
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof hints);
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  int rv = getaddrinfo(address, port, &hints, &relay_address);
+  if (rv != 0) {
+    fprintf(stderr, "getaddrinfo: %s\n", gai_strerror(rv));
+    exit(1);
+  }
+
+  // Two sockets per pair on our side
+  struct rlimit limit;
+  if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+  }
+
+  PrintHeader();
+  for (size_t i = 0; i < runs.size(); ++i) {
+    Bench(runs[i]);
+  }
+  freeaddrinfo(relay_address);
+  return 0;
+}
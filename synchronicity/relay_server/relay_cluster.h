@@ -0,0 +1,181 @@
+#ifndef _RELAY_CLUSTER_H_
+#define _RELAY_CLUSTER_H_
+
+#include <errno.h>
+#include <netdb.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "connection_map.h"
+#include "relay_common.h"
+
+// The top KEY_NODE_BITS of a key name the relay node holding the host,
+// so any node can tell where a client has to go.
+#define KEY_NODE_BITS 8
+#define KEY_NODE_SHIFT (64 - KEY_NODE_BITS)
+#define MAX_RELAY_NODES (1 << KEY_NODE_BITS)
+
+unsigned NodeOfKey(ConnectionMapKey key) {
+  return (unsigned)(key >> KEY_NODE_SHIFT);
+}
+
+ConnectionMapKey KeyForNode(ConnectionMapKey random, unsigned node) {
+  ConnectionMapKey mask = ((ConnectionMapKey)1 << KEY_NODE_SHIFT) - 1;
+  return (random & mask) | ((ConnectionMapKey)node << KEY_NODE_SHIFT);
+}
+
+struct RelayNode {
+  bool configured;
+  struct sockaddr_storage addr;
+  socklen_t addrlen;
+
+  RelayNode() : configured(false), addrlen(0) {}
+};
+
+// Static view of the relay nodes sharing the key space. The node file
+// has one "<id> <host> <port>" line per node, '#' starts a comment.
+// Every node is given the same file and its own id.
+class RelayCluster {
+ public:
+  RelayCluster() : self(0), enabled(false) {}
+
+  // Returns 0 on success
+  int Load(const char* path, unsigned self_id) {
+    if (self_id >= MAX_RELAY_NODES) {
+      fprintf(stderr, "cluster: node id %u out of range\n", self_id);
+      return 1;
+    }
+    FILE* file = fopen(path, "r");
+    if (NULL == file) {
+      perror("cluster");
+      return 1;
+    }
+    char line[512];
+    int line_number = 0;
+    int rv = 0;
+    while (0 == rv && fgets(line, sizeof(line), file)) {
+      ++line_number;
+      char* comment = strchr(line, '#');
+      if (comment) {
+        *comment = '\0';
+      }
+      unsigned id;
+      char host[256];
+      char port[16];
+      int fields = sscanf(line, "%u %255s %15s", &id, host, port);
+      if (fields <= 0) {
+        continue;  // blank line
+      }
+      if (fields != 3 || id >= MAX_RELAY_NODES || 0 != Resolve(id, host, port)) {
+        fprintf(stderr, "cluster: %s:%d: bad node entry\n", path, line_number);
+        rv = 1;
+      }
+    }
+    fclose(file);
+    if (0 == rv && !nodes[self_id].configured) {
+      fprintf(stderr, "cluster: node %u missing from %s\n", self_id, path);
+      rv = 1;
+    }
+    if (0 == rv) {
+      self = self_id;
+      enabled = true;
+    }
+    return rv;
+  }
+
+  bool Enabled() const { return enabled; }
+
+  unsigned Self() const { return self; }
+
+  // New host keys always point back at this node
+  ConnectionMapKey OwnKey(ConnectionMapKey random) const {
+    return enabled ? KeyForNode(random, self) : random;
+  }
+
+  bool IsLocal(ConnectionMapKey key) const {
+    return !enabled || NodeOfKey(key) == self;
+  }
+
+  bool Knows(ConnectionMapKey key) const {
+    return nodes[NodeOfKey(key)].configured;
+  }
+
+  // Whether a connection from addr comes from one of the nodes, which
+  // proxy clients of many addresses. Ports are not compared.
+  bool IsNode(const struct sockaddr_storage& addr) const {
+    if (!enabled) {
+      return false;
+    }
+    for (unsigned id = 0; id < MAX_RELAY_NODES; ++id) {
+      const struct sockaddr_storage& node = nodes[id].addr;
+      if (!nodes[id].configured || node.ss_family != addr.ss_family) {
+        continue;
+      }
+      if (AF_INET == addr.ss_family &&
+          0 == memcmp(&((const struct sockaddr_in*)&node)->sin_addr,
+            &((const struct sockaddr_in*)&addr)->sin_addr,
+            sizeof(struct in_addr))) {
+        return true;
+      }
+      if (AF_INET6 == addr.ss_family &&
+          0 == memcmp(&((const struct sockaddr_in6*)&node)->sin6_addr,
+            &((const struct sockaddr_in6*)&addr)->sin6_addr,
+            sizeof(struct in6_addr))) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Start a non-blocking connection to the node owning key. Returns the
+  // socket, the connection may still be in progress; -1 on failure.
+  int ConnectToOwner(ConnectionMapKey key) const {
+    const RelayNode& node = nodes[NodeOfKey(key)];
+    if (!node.configured) {
+      return -1;
+    }
+    int sockfd = socket(node.addr.ss_family, SOCK_STREAM, 0);
+    if (sockfd == -1) {
+      perror("cluster: socket");
+      return -1;
+    }
+    if (0 != set_nonblocking(sockfd)) {
+      close(sockfd);
+      return -1;
+    }
+    if (connect(sockfd, (const struct sockaddr*)&node.addr, node.addrlen) == -1 &&
+        errno != EINPROGRESS) {
+      perror("cluster: connect");
+      close(sockfd);
+      return -1;
+    }
+    return sockfd;
+  }
+
+ private:
+  int Resolve(unsigned id, const char* host, const char* port) {
+    struct addrinfo hints, *info;
+    memset(&hints, 0, sizeof hints);
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    int rv = getaddrinfo(host, port, &hints, &info);
+    if (rv != 0) {
+      fprintf(stderr, "cluster: %s: %s\n", host, gai_strerror(rv));
+      return 1;
+    }
+    memcpy(&nodes[id].addr, info->ai_addr, info->ai_addrlen);
+    nodes[id].addrlen = info->ai_addrlen;
+    nodes[id].configured = true;
+    freeaddrinfo(info);
+    return 0;
+  }
+
+  RelayNode nodes[MAX_RELAY_NODES];
+  unsigned self;
+  bool enabled;
+};
+
+#endif  // _RELAY_CLUSTER_H_
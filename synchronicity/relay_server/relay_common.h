@@ -2,6 +2,7 @@
 #define _RELAY_COMMON_H_
 
 #include <errno.h>
+#include <fcntl.h>
 #include <netdb.h>
 #include <netinet/in.h>
 #include <stdio.h>
@@ -14,6 +15,10 @@
 
 #include <arpa/inet.h>
 
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0  // OS X: SIGPIPE is ignored process wide instead
+#endif
+
 namespace {
 // To hide these functions from being used/linked against
 
@@ -29,9 +34,24 @@ void *get_in_addr(struct sockaddr *sa)
 
 }
 
+// Switch a socket between blocking and non-blocking mode.
+// Returns 0 on success.
+int set_nonblocking(int sockfd, bool nonblocking = true) {
+  int flags = fcntl(sockfd, F_GETFL, 0);
+  if (flags != -1) {
+    flags = nonblocking ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+  }
+  if (flags == -1 || fcntl(sockfd, F_SETFL, flags) == -1) {
+    perror("fcntl");
+    return 1;
+  }
+  return 0;
+}
+
 // Bind a socket to the port given and start listening for connections
-// and return the socket
-int prepare_server_socket(const char* port, const int backlog = 100) {
+// and return the socket. Datagram sockets are only bound.
+int prepare_server_socket(const char* port, const int backlog = 100,
+    const int socktype = SOCK_STREAM) {
   int sockfd;
   struct addrinfo hints, *servinfo, *p;
   int rv;  // return value
@@ -39,7 +59,7 @@ int prepare_server_socket(const char* port, const int backlog = 100) {
 
   memset(&hints, 0, sizeof hints);
   hints.ai_family = AF_UNSPEC;
-  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_socktype = socktype;
   hints.ai_flags = AI_PASSIVE;
 
   // get server addrinfo to connect socket to
@@ -78,7 +98,7 @@ int prepare_server_socket(const char* port, const int backlog = 100) {
 
   freeaddrinfo(servinfo); // all done with this structure
 
-  if (listen(sockfd, backlog) == -1) {
+  if (socktype == SOCK_STREAM && listen(sockfd, backlog) == -1) {
     perror("listen");
     exit(1);
   }
@@ -87,25 +107,15 @@ int prepare_server_socket(const char* port, const int backlog = 100) {
 }
 
 // Block and wait for accepting a connection on server socket
-// Return the connecting socket
-int accept_connection(int server_socket) {
-  int new_socket;
+// Return the connecting socket, its peer address in addr if given
+int accept_connection(int server_socket,
+    struct sockaddr_storage* addr = NULL) {
   struct sockaddr_storage their_addr; // connector's address information
   socklen_t sin_size = sizeof their_addr;
-  new_socket = accept(server_socket, (struct sockaddr *)&their_addr, &sin_size);
-
-  if (new_socket == -1) {
-    return new_socket;
+  if (NULL == addr) {
+    addr = &their_addr;
   }
-
-  // TODO(bo): Only compile this when debug flag is set
-  char s[INET6_ADDRSTRLEN];
-  inet_ntop(their_addr.ss_family,
-      get_in_addr((struct sockaddr *)&their_addr),
-      s, sizeof s);
-  printf("server: got connection from %s\n", s);
-
-  return new_socket;
+  return accept(server_socket, (struct sockaddr *)addr, &sin_size);
 }
 
 // send with check. Returns number of bytes sent.
@@ -0,0 +1,190 @@
+#ifndef _RELAY_HANDSHAKE_H_
+#define _RELAY_HANDSHAKE_H_
+
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#include "connection_map.h"
+#include "relay_common.h"
+#include "relay_limits.h"
+#include "relay_log.h"
+#include "relay_session.h"
+#include "relay_stream.h"
+
+// What a handshake leads to besides a plain pair
+enum HandshakeParty {
+  HANDSHAKE_NO_PARTY = 0,
+  HANDSHAKE_PARTY_HOST,
+  HANDSHAKE_PARTY_FOLLOWER,
+  HANDSHAKE_STREAM_SOURCE,
+  HANDSHAKE_STREAM_SINK,
+};
+
+// Seconds a client gets to send its key and read our reply
+#define HANDSHAKE_TIMEOUT 10
+
+enum HandshakeState {
+  HANDSHAKE_READING_KEY = 0,
+  HANDSHAKE_WRITING_REPLY,
+  HANDSHAKE_CONNECTING,  // upstream only: connect() in progress
+  HANDSHAKE_PROXYING,    // client waiting on its upstream handshake
+  HANDSHAKE_DONE,
+  HANDSHAKE_FAILED,
+};
+
+// Key exchange of one freshly accepted socket. The socket is
+// non-blocking, so the key and the reply may both take several
+// readiness events to get through; partial progress lives in here.
+//
+// When the key belongs to another relay node the same structure runs
+// the exchange the other way round on an upstream socket to that node:
+// connect, write the client's key, read the node's reply.
+struct Handshake {
+  int sockfd;
+  HandshakeState state;
+  time_t deadline;
+
+  ConnectionMapKey key;        // parsed once the whole key arrived
+  ConnectionMapKey marker;     // session or stream key that came first
+  int paired_sockfd;           // host socket a client key matched, or -1
+  bool upstream;               // true on our side of a proxied exchange
+  Handshake* peer;             // client <-> upstream while proxying
+  HandshakeParty party;
+  struct sockaddr_storage addr;  // of the client, for the log
+  RelayAddr client;            // what admission counts it under
+  bool admitted;               // counted by admission control
+
+  ConnectionMapKeyBuffer in;   // key as received
+  int received;
+  char out[2 * KEY_BUFFER_LENGTH];  // reply to send back, token after it
+  int out_length;
+  int sent;
+
+  Handshake(int sockfd, time_t now)
+    : sockfd(sockfd),
+      state(HANDSHAKE_READING_KEY),
+      deadline(now + HANDSHAKE_TIMEOUT),
+      key(0),
+      marker(0),
+      paired_sockfd(-1),
+      upstream(false),
+      peer(NULL),
+      party(HANDSHAKE_NO_PARTY),
+      admitted(false),
+      received(0),
+      out_length(KEY_BUFFER_LENGTH),
+      sent(0) {
+    memset(&addr, 0, sizeof(addr));
+  }
+
+  // Turn this into the upstream side of a proxied client: once
+  // connected, send key, then read the owning node's answer into key.
+  void Forward(ConnectionMapKey client_key) {
+    upstream = true;
+    state = HANDSHAKE_CONNECTING;
+    Reply(client_key);
+  }
+
+  // Upstream only: the connection is up, or failed
+  void Connected() {
+    int error = 0;
+    socklen_t len = sizeof(error);
+    if (getsockopt(sockfd, SOL_SOCKET, SO_ERROR, &error, &len) == -1 ||
+        error != 0) {
+      relay_log.Log(LOG_HANDSHAKE_FAILED, HANDSHAKE_FAILED_CONNECT);
+      state = HANDSHAKE_FAILED;
+      return;
+    }
+    state = HANDSHAKE_WRITING_REPLY;
+  }
+
+  // Upstream only: the key went out, now wait for the answer
+  void Expect() {
+    state = HANDSHAKE_READING_KEY;
+    received = 0;
+  }
+
+  // Read as much of the key as is available. Moves to
+  // HANDSHAKE_WRITING_REPLY when the key is complete and parsed, to
+  // HANDSHAKE_FAILED on error or bad key. A session or stream key is
+  // followed by the actual key, see relay_session.h and relay_stream.h.
+  void Read() {
+    for (;;) {
+      ReadBlock();
+      if (HANDSHAKE_WRITING_REPLY != state || upstream || 0 != marker ||
+          key < SESSION_OPEN_KEY || key > STREAM_SINK_KEY) {
+        return;
+      }
+      marker = key;
+      state = HANDSHAKE_READING_KEY;
+      received = 0;
+    }
+  }
+
+  // Queue the reply, the caller then drives Write(). After a session
+  // key the token follows.
+  void Reply(ConnectionMapKey reply, ConnectionMapKey token = 0) {
+    PrintKey(reply, *reinterpret_cast<ConnectionMapKeyBuffer*>(out));
+    out_length = KEY_BUFFER_LENGTH;
+    if (SESSION_OPEN_KEY == marker) {
+      PrintKey(token, *reinterpret_cast<ConnectionMapKeyBuffer*>(
+            out + KEY_BUFFER_LENGTH));
+      out_length += KEY_BUFFER_LENGTH;
+    }
+    sent = 0;
+  }
+
+  // Send what the socket accepts. Moves to HANDSHAKE_DONE once the
+  // reply is out.
+  void Write() {
+    while (HANDSHAKE_WRITING_REPLY == state && sent < out_length) {
+      int rv = send(sockfd, out + sent, out_length - sent,
+          MSG_NOSIGNAL);
+      if (rv < 0 && errno == EINTR) {
+        continue;
+      }
+      if (rv < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return;
+      }
+      if (rv < 0) {
+        relay_log.Log(LOG_HANDSHAKE_FAILED, HANDSHAKE_FAILED_SEND);
+        state = HANDSHAKE_FAILED;
+        return;
+      }
+      sent += rv;
+    }
+    if (HANDSHAKE_WRITING_REPLY == state) {
+      state = HANDSHAKE_DONE;
+    }
+  }
+
+ private:
+  // One key of the exchange
+  void ReadBlock() {
+    while (HANDSHAKE_READING_KEY == state && received < KEY_BUFFER_LENGTH) {
+      int rv = recv(sockfd, in + received, KEY_BUFFER_LENGTH - received, 0);
+      if (rv < 0 && errno == EINTR) {
+        continue;
+      }
+      if (rv < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return;
+      }
+      if (rv <= 0) {
+        relay_log.Log(LOG_HANDSHAKE_FAILED, HANDSHAKE_FAILED_RECEIVE);
+        state = HANDSHAKE_FAILED;
+        return;
+      }
+      received += rv;
+    }
+    if (0 != ParseKey(in, key)) {
+      relay_log.Log(LOG_HANDSHAKE_FAILED, HANDSHAKE_FAILED_PARSE);
+      state = HANDSHAKE_FAILED;
+      return;
+    }
+    state = HANDSHAKE_WRITING_REPLY;
+  }
+};
+
+#endif  // _RELAY_HANDSHAKE_H_
@@ -0,0 +1,135 @@
+#ifndef _RELAY_HUB_H_
+#define _RELAY_HUB_H_
+
+#include <pthread.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "relay_common.h"
+#include "relay_poller.h"
+
+// A thread running its own poller over the sockets handed to it. The
+// accepting thread hands them over as Message through a pipe, so the
+// hub never needs a lock on its hot path. RelayWorker, RelayPartyHub
+// and RelayStreamHub are all one of these.
+//
+// Objects closed while a batch of events is handled are freed once the
+// batch is over, later events of the batch may still point at them.
+// Stop() closes and frees everything the hub still owns, sockets left
+// in the pipe included; subclasses call it from their own destructor,
+// their hooks are gone by the time ours runs.
+template <typename Message>
+class RelayHub {
+ public:
+  explicit RelayHub(int poll_timeout_ms)
+    : running(false), timeout_ms(poll_timeout_ms) {
+    handoff[0] = handoff[1] = -1;
+  }
+
+  virtual ~RelayHub() {
+  }
+
+  int Start() {
+    if (!poller.IsValid()) {
+      return 1;
+    }
+    if (pipe(handoff) == -1) {
+      perror("pipe");
+      return 1;
+    }
+    set_nonblocking(handoff[0]);
+    if (poller.Add(handoff[0], NULL, true, false) == -1) {
+      return 1;
+    }
+    running = true;
+    if (pthread_create(&thread, NULL, &RelayHub::ThreadMain, this) != 0) {
+      perror("pthread_create");
+      running = false;
+      return 1;
+    }
+    return 0;
+  }
+
+  void Stop() {
+    if (running) {
+      running = false;
+      pthread_join(thread, NULL);
+    }
+    if (handoff[0] == -1) {
+      return;
+    }
+    Message message;
+    while (read(handoff[0], &message, sizeof(message)) == sizeof(message)) {
+      Discard(message);
+    }
+    CloseAll();
+    FreeClosed();
+    close(handoff[0]);
+    close(handoff[1]);
+    handoff[0] = handoff[1] = -1;
+  }
+
+ protected:
+  // Called from the accepting thread. Returns 0 on success.
+  int Handoff(const Message& message) {
+    if (write(handoff[1], &message, sizeof(message)) != sizeof(message)) {
+      perror("handoff");
+      return 1;
+    }
+    return 0;
+  }
+
+  // A message read from the pipe
+  virtual void Accept(const Message& message) = 0;
+  // An event on a socket the hub added to the poller with data
+  virtual void Dispatch(const RelayPollEvent& event) = 0;
+  // After each batch, before the closed objects are freed
+  virtual void AfterBatch() {}
+  virtual int PollTimeoutMs() { return timeout_ms; }
+  // Frees what was closed
+  virtual void FreeClosed() = 0;
+  // A message left in the pipe at Stop()
+  virtual void Discard(const Message& message) = 0;
+  // Closes what is still open at Stop()
+  virtual void CloseAll() = 0;
+
+  RelayPoller poller;
+
+ private:
+  static void* ThreadMain(void* param) {
+    static_cast<RelayHub*>(param)->Run();
+    return NULL;
+  }
+
+  void Run() {
+    RelayPollEvent events[RELAY_POLLER_MAX_EVENTS];
+    while (running) {
+      int num_ready = poller.Wait(events, RELAY_POLLER_MAX_EVENTS,
+          PollTimeoutMs());
+      for (int i = 0; i < num_ready; ++i) {
+        if (NULL == events[i].data) {
+          Message message;
+          while (read(handoff[0], &message, sizeof(message)) ==
+              sizeof(message)) {
+            Accept(message);
+          }
+          continue;
+        }
+        Dispatch(events[i]);
+      }
+      AfterBatch();
+      FreeClosed();
+    }
+  }
+
+  pthread_t thread;
+  int handoff[2];
+  volatile bool running;
+  int timeout_ms;
+
+  // not copyable
+  RelayHub(const RelayHub&);
+  RelayHub& operator=(const RelayHub&);
+};
+
+#endif  // _RELAY_HUB_H_
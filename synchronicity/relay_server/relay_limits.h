@@ -0,0 +1,208 @@
+#ifndef _RELAY_LIMITS_H_
+#define _RELAY_LIMITS_H_
+
+#include <netinet/in.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#include <map>
+
+#include "connection_map.h"
+
+// Per address limits on what the accepting thread holds for a client:
+// sockets still in their handshake and host keys waiting for a client.
+// A client over either limit is refused, the connections it already
+// has are left alone. IPv6 clients count per /64, which is what a
+// single subscriber usually gets.
+#define DEFAULT_MAX_HANDSHAKES_PER_ADDR 16
+#define DEFAULT_MAX_PENDING_PER_ADDR 8
+
+// Argument of LOG_REFUSED
+enum RelayRefusal {
+  REFUSED_HANDSHAKES = 0,
+  REFUSED_PENDING,
+};
+
+// Address a client is counted under
+struct RelayAddr {
+  int family;
+  unsigned char bytes[8];
+
+  RelayAddr() : family(AF_UNSPEC) {
+    memset(bytes, 0, sizeof(bytes));
+  }
+
+  explicit RelayAddr(const struct sockaddr_storage& addr)
+    : family(addr.ss_family) {
+    memset(bytes, 0, sizeof(bytes));
+    if (AF_INET == family) {
+      memcpy(bytes, &((const struct sockaddr_in*)&addr)->sin_addr, 4);
+    } else if (AF_INET6 == family) {
+      memcpy(bytes, &((const struct sockaddr_in6*)&addr)->sin6_addr, 8);
+    }
+  }
+
+  bool operator<(const RelayAddr& other) const {
+    if (family != other.family) {
+      return family < other.family;
+    }
+    return memcmp(bytes, other.bytes, sizeof(bytes)) < 0;
+  }
+};
+
+// Only used by the accepting thread
+class RelayAdmission {
+ public:
+  RelayAdmission()
+    : max_handshakes(DEFAULT_MAX_HANDSHAKES_PER_ADDR),
+      max_pending(DEFAULT_MAX_PENDING_PER_ADDR) {
+  }
+
+  // 0 for no limit
+  void SetLimits(int handshakes, int pending) {
+    max_handshakes = handshakes;
+    max_pending = pending;
+  }
+
+  // A connection from addr wants to start its handshake. Counts it and
+  // returns true if it may.
+  bool AdmitHandshake(const RelayAddr& addr) {
+    Usage& usage = by_addr[addr];
+    if (0 != max_handshakes && usage.handshakes >= max_handshakes) {
+      return false;
+    }
+    ++usage.handshakes;
+    return true;
+  }
+
+  // An admitted handshake finished, either way
+  void HandshakeDone(const RelayAddr& addr) {
+    std::map<RelayAddr, Usage>::iterator itr = by_addr.find(addr);
+    if (itr != by_addr.end()) {
+      --itr->second.handshakes;
+      Release(addr, itr->second);
+    }
+  }
+
+  // Whether addr may get one more host key
+  bool MayHost(const RelayAddr& addr) {
+    std::map<RelayAddr, Usage>::iterator itr = by_addr.find(addr);
+    return 0 == max_pending || itr == by_addr.end() ||
+        itr->second.pending < max_pending;
+  }
+
+  // The host of key from addr waits for its client. A key counted
+  // already, a host waiting again after its client failed, stays
+  // counted once.
+  void AddPending(ConnectionMapKey key, const RelayAddr& addr) {
+    if (pending.count(key)) {
+      return;
+    }
+    pending[key] = addr;
+    ++by_addr[addr].pending;
+  }
+
+  // The host of key got its client, or went away
+  void RemovePending(ConnectionMapKey key) {
+    std::map<ConnectionMapKey, RelayAddr>::iterator itr = pending.find(key);
+    if (itr == pending.end()) {
+      return;
+    }
+    Usage& usage = by_addr[itr->second];
+    --usage.pending;
+    Release(itr->second, usage);
+    pending.erase(itr);
+  }
+
+  size_t NumAddrs() const { return by_addr.size(); }
+
+ private:
+  struct Usage {
+    int handshakes;
+    int pending;
+    Usage() : handshakes(0), pending(0) {}
+  };
+
+  void Release(const RelayAddr& addr, const Usage& usage) {
+    if (0 == usage.handshakes && 0 == usage.pending) {
+      RelayAddr copy = addr;  // addr may live in the entry
+      by_addr.erase(copy);
+    }
+  }
+
+  std::map<RelayAddr, Usage> by_addr;
+  std::map<ConnectionMapKey, RelayAddr> pending;
+  int max_handshakes;
+  int max_pending;
+
+  // not copyable
+  RelayAdmission(const RelayAdmission&);
+  RelayAdmission& operator=(const RelayAdmission&);
+};
+
+// Milliseconds on a clock that only matters for differences
+uint64_t relay_now_ms() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (uint64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+// Caps the bytes per second of one direction of a pair. Up to burst
+// bytes may go at once after a quiet spell.
+struct TokenBucket {
+  long rate;    // bytes per second, 0 for no limit
+  long burst;
+  long tokens;
+  long fraction;  // of a byte earned, in thousandths
+  uint64_t last_ms;
+
+  TokenBucket() : rate(0), burst(0), tokens(0), fraction(0), last_ms(0) {}
+
+  void Init(long bytes_per_second, long burst_bytes, uint64_t now_ms) {
+    rate = bytes_per_second;
+    burst = burst_bytes < 1 ? 1 : burst_bytes;
+    tokens = burst;
+    fraction = 0;
+    last_ms = now_ms;
+  }
+
+  // How many of wanted bytes may go now
+  long Allow(long wanted, uint64_t now_ms) {
+    if (0 == rate) {
+      return wanted;
+    }
+    if (now_ms > last_ms) {
+      uint64_t elapsed = now_ms - last_ms;
+      long long earned = elapsed > 1000000 ? 1000LL * burst :
+        (long long)elapsed * rate + fraction;
+      if (tokens + earned / 1000 >= burst) {
+        tokens = burst;
+        fraction = 0;
+      } else {
+        tokens += (long)(earned / 1000);
+        fraction = (long)(earned % 1000);
+      }
+    }
+    last_ms = now_ms;  // or the clock went back
+    return tokens < wanted ? (tokens < 0 ? 0 : tokens) : wanted;
+  }
+
+  // bytes went, which may be more than allowed for a blocking sender
+  void Spend(long bytes) {
+    if (0 != rate) {
+      tokens -= bytes;
+    }
+  }
+
+  // Milliseconds until some bytes may go again
+  long WaitMs() const {
+    if (0 == rate || tokens > 0) {
+      return 0;
+    }
+    return (long)((1 - tokens) * 1000 / rate) + 1;
+  }
+};
+
+#endif  // _RELAY_LIMITS_H_
@@ -0,0 +1,325 @@
+#ifndef _RELAY_LOG_H_
+#define _RELAY_LOG_H_
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+// Events are logged into a fixed ring of binary entries instead of
+// being printed where they happen: a relay thread only stamps an entry,
+// a log thread formats and writes them out behind it. Entries the log
+// thread could not keep up with are overwritten and counted as lost.
+//
+// Logging takes no lock and makes no system call but time(), so it is
+// fine from the workers, the hubs and the SIGCHLD handler alike.
+#define RELAY_LOG_SIZE 8192  // entries, a power of 2
+#define RELAY_LOG_FLUSH_MS 100
+
+enum RelayLogEvent {
+  LOG_CONNECTION = 0,     // address
+  LOG_REFUSED,            // address, RelayRefusal
+  LOG_ACCEPT_FAILED,      // errno
+  LOG_ACCEPT_DROPPED,     // out of descriptors
+  LOG_ACCEPT_PAUSED,      // out of descriptors, seconds
+  LOG_HANDSHAKE_FAILED,   // HandshakeFailure
+  LOG_HANDSHAKE_TIMEOUT,
+  LOG_HOST_WAITING,       // key
+  LOG_MATCHED,            // key, seconds the host waited
+  LOG_NO_HOST,            // key
+  LOG_HOST_EXPIRED,       // key
+  LOG_PROXYING,           // key, node
+  LOG_NO_NODE,            // key, node
+  LOG_PAIR_FAILED,
+  LOG_PAIR_CLOSED,
+  LOG_PAIR_THROTTLED,     // bytes per second allowed
+  LOG_RELAY_ERROR,
+  LOG_CHILD_DIED,
+  LOG_SESSION_RESUMING,
+  LOG_SESSION_RESUMED,    // key
+  LOG_SESSION_OVER,       // key
+  LOG_PARTY_JOINING,      // key
+  LOG_PARTY_OPENED,       // key
+  LOG_PARTY_FOLLOWER_JOINED,  // key, follower
+  LOG_PARTY_FOLLOWER_SLOW,    // key, follower
+  LOG_PARTY_FOLLOWER_LEFT,    // key, follower
+  LOG_PARTY_HOST_LEFT,    // key
+  LOG_PARTY_BAD_FRAME,    // key, frame type
+  LOG_PARTY_CLOSED,       // key
+  LOG_STREAM_SINK_JOINED,     // key
+  LOG_STREAM_SOURCE_UP,   // key
+  LOG_STREAM_BAD_FRAME,   // key, payload length
+  LOG_STREAM_SINK_BEHIND, // key
+  LOG_STREAM_SOURCE_LEFT, // key
+  LOG_STREAM_SINK_LEFT,   // key, frames skipped
+  LOG_STREAM_IDLE,        // key
+  LOG_NUM_EVENTS
+};
+
+// What a handshake failed on, argument of LOG_HANDSHAKE_FAILED
+enum HandshakeFailure {
+  HANDSHAKE_FAILED_CONNECT = 0,
+  HANDSHAKE_FAILED_SEND,
+  HANDSHAKE_FAILED_RECEIVE,
+  HANDSHAKE_FAILED_PARSE,
+};
+
+// Format of each event, fed the address first for the events that
+// have one, then both arguments as unsigned long long. Reasons of
+// refusals and failures are fed by name instead.
+struct RelayLogFormat {
+  const char* format;
+  bool address;
+};
+
+static const RelayLogFormat kRelayLogFormats[LOG_NUM_EVENTS] = {
+  { "server: got connection from %s\n", true },
+  { "Refused connection from %s: %s\n", true },
+  { "Error: accept: %s\n", false },
+  { "Out of descriptors, dropped a connection\n", false },
+  { "Out of descriptors, not accepting for %llus\n", false },
+  { "Error: handshake failed: %s\n", false },
+  { "Closed pending connection\n", false },
+  { "Inserting with key %#llx\n", false },
+  { "Matched with key %#llx after %llus\n", false },
+  { "Error: Cannot find matching socket with key %#llx\n", false },
+  { "Deleting key %#llx\n", false },
+  { "Proxying key %#llx to node %llu\n", false },
+  { "Error: No relay node for key %#llx, node %llu\n", false },
+  { "Error: Could not hand pair to a worker\n", false },
+  { "connection closing\n", false },
+  { "Pair throttled to %llu bytes/s\n", false },
+  { "Error: Could not relay message.\n", false },
+  { "child died\n", false },
+  { "Resuming a session\n", false },
+  { "Resumed key %#llx\n", false },
+  { "Session of key %#llx is over\n", false },
+  { "Joining party %#llx\n", false },
+  { "Party %#llx opened\n", false },
+  { "Party %#llx: follower %llu joined\n", false },
+  { "Party %#llx: follower %llu too slow\n", false },
+  { "Party %#llx: follower %llu left\n", false },
+  { "Party %#llx: host left\n", false },
+  { "Error: party %#llx: bad frame type %lld\n", false },
+  { "Party %#llx closed\n", false },
+  { "Stream %#llx: sink joined\n", false },
+  { "Stream %#llx: source up\n", false },
+  { "Error: stream %#llx: frame of %llu bytes\n", false },
+  { "Stream %#llx: sink behind, skipped to the newest frame\n", false },
+  { "Stream %#llx: source left\n", false },
+  { "Stream %#llx: sink left, %llu frames skipped\n", false },
+  { "Stream %#llx: no source, closed\n", false },
+};
+
+static const char* const kRefusalNames[] = {
+  "too many handshakes",
+  "too many pending keys",
+};
+
+static const char* const kHandshakeFailureNames[] = {
+  "cannot reach relay node",
+  "cannot send key",
+  "did not receive key",
+  "cannot parse key",
+};
+
+// One event. seq is odd while the entry is being written and
+// 2 * (position + 1) once it holds the event at that position.
+struct RelayLogEntry {
+  volatile uint64_t seq;
+  time_t time;
+  int event;
+  int family;  // of address, AF_UNSPEC if none
+  uint64_t a;
+  uint64_t b;
+  unsigned char address[16];
+};
+
+class RelayLog {
+ public:
+  explicit RelayLog(FILE* out = stdout)
+    : head(0), tail(0), lost(0), output(out), direct(false), running(false) {
+    memset(ring, 0, sizeof(ring));
+  }
+
+  ~RelayLog() {
+    Stop();
+  }
+
+  // Starts the thread writing the entries out
+  int Start() {
+    running = true;
+    if (pthread_create(&thread, NULL, &RelayLog::ThreadMain, this) != 0) {
+      perror("pthread_create");
+      running = false;
+      return 1;
+    }
+    return 0;
+  }
+
+  // Writes out what is left
+  void Stop() {
+    if (running) {
+      running = false;
+      pthread_join(thread, NULL);
+      Drain();
+    }
+  }
+
+  // Print every event right away from now on. For forked children,
+  // which have no log thread and do not mind waiting on their output.
+  void Direct() {
+    direct = true;
+    running = false;  // not ours to join
+  }
+
+  void Log(int event, uint64_t a = 0, uint64_t b = 0,
+      const struct sockaddr_storage* addr = NULL) {
+    RelayLogEntry entry;
+    RelayLogEntry* slot = &entry;
+    uint64_t position = 0;
+    if (!direct) {
+      position = __sync_fetch_and_add(&head, 1);
+      slot = &ring[position & (RELAY_LOG_SIZE - 1)];
+      slot->seq = 2 * position + 1;
+      __sync_synchronize();
+    }
+    slot->time = time(NULL);
+    slot->event = event;
+    slot->a = a;
+    slot->b = b;
+    slot->family = AF_UNSPEC;
+    if (NULL != addr && AF_INET == addr->ss_family) {
+      slot->family = AF_INET;
+      memcpy(slot->address,
+          &((const struct sockaddr_in*)addr)->sin_addr, 4);
+    } else if (NULL != addr && AF_INET6 == addr->ss_family) {
+      slot->family = AF_INET6;
+      memcpy(slot->address,
+          &((const struct sockaddr_in6*)addr)->sin6_addr, 16);
+    }
+    if (direct) {
+      Print(entry);
+      fflush(output);
+      return;
+    }
+    __sync_synchronize();
+    slot->seq = 2 * position + 2;
+  }
+
+  // Writes out the entries logged so far, returns how many. Only one
+  // thread at a time may drain.
+  size_t Drain() {
+    uint64_t end = __sync_fetch_and_add(&head, 0);
+    if (end - tail > RELAY_LOG_SIZE) {
+      __sync_fetch_and_add(&lost, end - RELAY_LOG_SIZE - tail);
+      tail = end - RELAY_LOG_SIZE;
+    }
+    size_t printed = 0;
+    while (tail < end) {
+      RelayLogEntry* slot = &ring[tail & (RELAY_LOG_SIZE - 1)];
+      uint64_t seq = slot->seq;
+      if (seq < 2 * tail + 2) {
+        break;  // still being written, next time
+      }
+      __sync_synchronize();
+      RelayLogEntry entry;
+      memcpy(&entry, slot, sizeof(entry));
+      __sync_synchronize();
+      if (seq != 2 * tail + 2 || slot->seq != seq) {
+        __sync_fetch_and_add(&lost, 1);  // overwritten under our feet
+      } else {
+        Print(entry);
+        ++printed;
+      }
+      ++tail;
+    }
+    if (printed > 0) {
+      fflush(output);
+    }
+    return printed;
+  }
+
+  // Entries overwritten before they could be written out
+  uint64_t Lost() { return __sync_fetch_and_add(&lost, 0); }
+
+ private:
+  static void* ThreadMain(void* param) {
+    static_cast<RelayLog*>(param)->Run();
+    return NULL;
+  }
+
+  void Run() {
+    uint64_t reported = 0;
+    while (running) {
+      Drain();
+      uint64_t now_lost = Lost();
+      if (now_lost != reported) {
+        fprintf(output, "log: %llu entries lost\n",
+            (unsigned long long)(now_lost - reported));
+        reported = now_lost;
+      }
+      usleep(RELAY_LOG_FLUSH_MS * 1000);
+    }
+  }
+
+  void Print(const RelayLogEntry& entry) {
+    if (entry.event < 0 || entry.event >= LOG_NUM_EVENTS) {
+      return;
+    }
+    char date[32];
+    struct tm tm;
+    strftime(date, sizeof date, "%Y-%m-%d %H:%M:%S",
+        localtime_r(&entry.time, &tm));
+    fprintf(output, "%s ", date);
+
+    const RelayLogFormat& format = kRelayLogFormats[entry.event];
+    char s[INET6_ADDRSTRLEN] = "?";
+    if (AF_UNSPEC != entry.family) {
+      inet_ntop(entry.family, entry.address, s, sizeof s);
+    }
+    unsigned long long a = entry.a;
+    unsigned long long b = entry.b;
+    switch (entry.event) {
+      case LOG_REFUSED:
+        fprintf(output, format.format, s, kRefusalNames[a % 2]);
+        break;
+      case LOG_HANDSHAKE_FAILED:
+        fprintf(output, format.format, kHandshakeFailureNames[a % 4]);
+        break;
+      case LOG_ACCEPT_FAILED:
+        fprintf(output, format.format, strerror((int)a));
+        break;
+      default:
+        if (format.address) {
+          fprintf(output, format.format, s, a, b);
+        } else {
+          fprintf(output, format.format, a, b);
+        }
+        break;
+    }
+  }
+
+  RelayLogEntry ring[RELAY_LOG_SIZE];
+  volatile uint64_t head;  // next position to write
+  uint64_t tail;           // next position to print, log thread only
+  volatile uint64_t lost;
+  FILE* output;
+  bool direct;
+  pthread_t thread;
+  volatile bool running;
+
+  // not copyable
+  RelayLog(const RelayLog&);
+  RelayLog& operator=(const RelayLog&);
+};
+
+// Shared by every thread of the relay
+RelayLog relay_log;
+
+#endif  // _RELAY_LOG_H_
@@ -0,0 +1,229 @@
+#ifndef _RELAY_METRICS_H_
+#define _RELAY_METRICS_H_
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "relay_common.h"
+
+// Counters of the relay, served as plain text by RelayMetricsEndpoint
+// in the Prometheus exposition format to whoever connects to it. The
+// request is not even looked at.
+#define METRICS_POLL_TIMEOUT_MS 1000
+#define METRICS_IO_TIMEOUT 2  // seconds a scraper gets to read the page
+
+// Upper bounds, in seconds, of the buckets of the time hosts waited for
+// their client; a last bucket takes the rest
+#define PAIRING_BUCKETS 6
+static const long kPairingBounds[PAIRING_BUCKETS] = { 1, 5, 30, 60, 300, 900 };
+
+// name value, with its type line
+void AppendMetric(std::string* out, const char* name, const char* type,
+    unsigned long long value) {
+  char line[256];
+  snprintf(line, sizeof(line), "# TYPE %s %s\n%s %llu\n",
+      name, type, name, value);
+  out->append(line);
+}
+
+// Counters are bumped from any thread, gauges are set by the accepting
+// thread.
+struct RelayMetrics {
+  volatile unsigned long long connections;
+  volatile unsigned long long refused[2];  // by RelayRefusal
+  volatile unsigned long long handshake_failures;
+  volatile unsigned long long handshake_timeouts;
+  volatile unsigned long long pairs;
+  volatile unsigned long long expired_keys;
+  volatile unsigned long long pairing[PAIRING_BUCKETS + 1];
+  volatile unsigned long long pairing_seconds;
+  volatile long pending_keys;
+  volatile long handshakes;
+  volatile unsigned long long bytes_per_second;
+
+  RelayMetrics() {
+    memset((void*)this, 0, sizeof(*this));
+  }
+
+  void Count(volatile unsigned long long* counter) {
+    __sync_fetch_and_add(counter, 1);
+  }
+
+  // A host got its client after waiting that long
+  void Paired(time_t waited) {
+    int bucket = 0;
+    while (bucket < PAIRING_BUCKETS && waited > kPairingBounds[bucket]) {
+      ++bucket;
+    }
+    Count(&pairs);
+    Count(&pairing[bucket]);
+    __sync_fetch_and_add(&pairing_seconds, waited);
+  }
+
+  // Once a second or so, with the bytes relayed so far
+  void Tick(time_t now, unsigned long long bytes) {
+    if (0 != last_tick && now > last_tick) {
+      bytes_per_second = (bytes - last_bytes) / (now - last_tick);
+    }
+    if (now != last_tick) {
+      last_tick = now;
+      last_bytes = bytes;
+    }
+  }
+
+  void Render(std::string* out) {
+    AppendMetric(out, "relay_connections_total", "counter", connections);
+    out->append("# TYPE relay_refused_total counter\n");
+    char line[256];
+    snprintf(line, sizeof(line),
+        "relay_refused_total{reason=\"handshakes\"} %llu\n"
+        "relay_refused_total{reason=\"pending\"} %llu\n",
+        refused[0], refused[1]);
+    out->append(line);
+    AppendMetric(out, "relay_handshake_failures_total", "counter",
+        handshake_failures);
+    AppendMetric(out, "relay_handshake_timeouts_total", "counter",
+        handshake_timeouts);
+    AppendMetric(out, "relay_expired_keys_total", "counter", expired_keys);
+    AppendMetric(out, "relay_handshakes", "gauge", handshakes);
+    AppendMetric(out, "relay_pending_keys", "gauge", pending_keys);
+    AppendMetric(out, "relay_bytes_per_second", "gauge", bytes_per_second);
+
+    out->append("# TYPE relay_pairing_seconds histogram\n");
+    unsigned long long total = 0;
+    for (int i = 0; i <= PAIRING_BUCKETS; ++i) {
+      total += pairing[i];
+      if (i < PAIRING_BUCKETS) {
+        snprintf(line, sizeof(line),
+            "relay_pairing_seconds_bucket{le=\"%ld\"} %llu\n",
+            kPairingBounds[i], total);
+      } else {
+        snprintf(line, sizeof(line),
+            "relay_pairing_seconds_bucket{le=\"+Inf\"} %llu\n", total);
+      }
+      out->append(line);
+    }
+    snprintf(line, sizeof(line),
+        "relay_pairing_seconds_sum %llu\nrelay_pairing_seconds_count %llu\n",
+        pairing_seconds, total);
+    out->append(line);
+  }
+
+ private:
+  time_t last_tick;
+  unsigned long long last_bytes;
+};
+
+// Serves the page render builds, one connection at a time on its own
+// thread. A scraper is not worth a poller.
+class RelayMetricsEndpoint {
+ public:
+  typedef void (*Renderer)(std::string* out);
+
+  RelayMetricsEndpoint() : sockfd(-1), render(NULL), running(false) {
+  }
+
+  ~RelayMetricsEndpoint() {
+    Stop();
+  }
+
+  int Start(const char* port, Renderer renderer) {
+    sockfd = prepare_server_socket(port, 8);
+    if (-1 == sockfd) {
+      return 1;
+    }
+    render = renderer;
+    running = true;
+    if (pthread_create(&thread, NULL, &RelayMetricsEndpoint::ThreadMain,
+          this) != 0) {
+      perror("pthread_create");
+      running = false;
+      return 1;
+    }
+    return 0;
+  }
+
+  void Stop() {
+    if (running) {
+      running = false;
+      pthread_join(thread, NULL);
+    }
+    if (-1 != sockfd) {
+      close(sockfd);
+      sockfd = -1;
+    }
+  }
+
+ private:
+  static void* ThreadMain(void* param) {
+    static_cast<RelayMetricsEndpoint*>(param)->Run();
+    return NULL;
+  }
+
+  void Run() {
+    while (running) {
+      struct pollfd pfd;
+      pfd.fd = sockfd;
+      pfd.events = POLLIN;
+      if (poll(&pfd, 1, METRICS_POLL_TIMEOUT_MS) <= 0) {
+        continue;
+      }
+      int client = accept(sockfd, NULL, NULL);
+      if (-1 == client) {
+        continue;
+      }
+      Serve(client);
+      close(client);
+    }
+  }
+
+  void Serve(int client) {
+    struct timeval timeout;
+    timeout.tv_sec = METRICS_IO_TIMEOUT;
+    timeout.tv_usec = 0;
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    char request[1024];
+    recv(client, request, sizeof(request), 0);  // whatever it asks
+
+    std::string body;
+    render(&body);
+    char header[128];
+    snprintf(header, sizeof(header), "HTTP/1.0 200 OK\r\n"
+        "Content-Type: text/plain; version=0.0.4\r\n"
+        "Content-Length: %lu\r\n\r\n", (unsigned long)body.size());
+    std::string page = header + body;
+    size_t sent = 0;
+    while (sent < page.size()) {
+      int rv = send(client, page.data() + sent, page.size() - sent,
+          MSG_NOSIGNAL);
+      if (rv < 0 && errno == EINTR) {
+        continue;
+      }
+      if (rv <= 0) {
+        return;
+      }
+      sent += rv;
+    }
+  }
+
+  int sockfd;
+  Renderer render;
+  pthread_t thread;
+  volatile bool running;
+
+  // not copyable
+  RelayMetricsEndpoint(const RelayMetricsEndpoint&);
+  RelayMetricsEndpoint& operator=(const RelayMetricsEndpoint&);
+};
+
+#endif  // _RELAY_METRICS_H_
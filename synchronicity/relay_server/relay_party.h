@@ -0,0 +1,451 @@
+#ifndef _RELAY_PARTY_H_
+#define _RELAY_PARTY_H_
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "connection_map.h"
+#include "relay_common.h"
+#include "relay_hub.h"
+#include "relay_log.h"
+#include "relay_poller.h"
+
+// Key a host sends instead of 0 to open a party: one host, any number
+// of followers joining with the key it gets back.
+#define PARTY_HOST_KEY 1
+
+// Between the relay and a party's host everything is framed: type,
+// follower id and payload length, big endian, then the payload.
+// Followers see plain byte streams, as with a paired host.
+//   PARTY_DATA   to the host: bytes from follower id
+//                from the host: bytes for follower id, 0 for every
+//                follower taken into broadcasts
+//   PARTY_JOIN   to the host: follower id joined
+//                from the host: take follower id into broadcasts
+//   PARTY_LEAVE  to the host: follower id is gone
+//                from the host: drop follower id
+#define PARTY_FRAME_HEADER 7
+#define PARTY_MAX_PAYLOAD 0xffff
+#define PARTY_DATA 0
+#define PARTY_JOIN 1
+#define PARTY_LEAVE 2
+
+// Bytes queued towards a socket before it counts as stuck: a follower
+// is dropped, a host stops hearing from its followers until it drains
+#define PARTY_MAX_BACKLOG (1 << 20)
+#define PARTY_READ_SIZE 16384
+#define PARTY_POLL_TIMEOUT_MS 1000
+
+struct RelayParty;
+
+// A socket passed from the accepting thread to the hub
+struct PartyHandoff {
+  ConnectionMapKey key;
+  int sockfd;
+  bool host;
+};
+
+// One socket of a party; the poller hands these back to us
+struct PartyEndpoint {
+  RelayParty* party;
+  uint32_t id;     // 0 for the host
+  int sockfd;
+  bool adopted;    // followers: receives broadcasts
+  std::string out; // queued towards sockfd, sent from out_start on
+  size_t out_start;
+
+  PartyEndpoint(RelayParty* party, uint32_t id, int sockfd)
+    : party(party), id(id), sockfd(sockfd), adopted(false), out_start(0) {
+  }
+
+  size_t Backlog() const { return out.size() - out_start; }
+};
+
+struct RelayParty {
+  ConnectionMapKey key;
+  PartyEndpoint host;
+  std::map<uint32_t, PartyEndpoint*> followers;
+  uint32_t next_id;
+  std::string in;  // partial frame from the host
+  bool throttled;  // followers not read while the host backlog drains
+
+  RelayParty(ConnectionMapKey key, int sockfd)
+    : key(key), host(this, 0, sockfd), next_id(1), throttled(false) {
+  }
+};
+
+// The parties of this relay, all driven by one hub: they only carry
+// playback commands and clock sync, far less than a paired stream.
+// The key set is shared with the accepting thread so it can route
+// joining clients.
+class RelayPartyHub : public RelayHub<PartyHandoff> {
+ public:
+  RelayPartyHub() : RelayHub<PartyHandoff>(PARTY_POLL_TIMEOUT_MS) {
+    pthread_mutex_init(&keys_lock, NULL);
+  }
+
+  ~RelayPartyHub() {
+    Stop();
+    pthread_mutex_destroy(&keys_lock);
+  }
+
+  bool Has(ConnectionMapKey key) {
+    pthread_mutex_lock(&keys_lock);
+    bool found = keys.count(key) > 0;
+    pthread_mutex_unlock(&keys_lock);
+    return found;
+  }
+
+  // Called from the accepting thread, the hub owns sockfd afterwards.
+  // Returns 0 on success.
+  int Host(ConnectionMapKey key, int sockfd) {
+    pthread_mutex_lock(&keys_lock);
+    keys.insert(key);
+    pthread_mutex_unlock(&keys_lock);
+    if (0 != Handoff(key, sockfd, true)) {
+      pthread_mutex_lock(&keys_lock);
+      keys.erase(key);
+      pthread_mutex_unlock(&keys_lock);
+      return 1;
+    }
+    return 0;
+  }
+
+  // A client with the key of a party. If the party ended in the
+  // meantime the socket is simply closed.
+  int Join(ConnectionMapKey key, int sockfd) {
+    return Handoff(key, sockfd, false);
+  }
+
+ private:
+  int Handoff(ConnectionMapKey key, int sockfd, bool host) {
+    PartyHandoff message;
+    message.key = key;
+    message.sockfd = sockfd;
+    message.host = host;
+    return RelayHub<PartyHandoff>::Handoff(message);
+  }
+
+  void Accept(const PartyHandoff& message) {
+    if (0 != set_nonblocking(message.sockfd)) {
+      close(message.sockfd);
+      if (message.host) {
+        Forget(message.key);
+      }
+      return;
+    }
+    if (message.host) {
+      RelayParty* party = new RelayParty(message.key, message.sockfd);
+      if (0 != poller.Add(message.sockfd, &party->host, true, false)) {
+        close(message.sockfd);
+        Forget(message.key);
+        delete party;
+        return;
+      }
+      parties[message.key] = party;
+      relay_log.Log(LOG_PARTY_OPENED, message.key);
+      return;
+    }
+
+    std::map<ConnectionMapKey, RelayParty*>::iterator itr =
+      parties.find(message.key);
+    if (itr == parties.end()) {
+      close(message.sockfd);
+      return;
+    }
+    RelayParty* party = itr->second;
+    PartyEndpoint* follower =
+      new PartyEndpoint(party, party->next_id++, message.sockfd);
+    if (0 != poller.Add(message.sockfd, follower, !party->throttled,
+          false)) {
+      close(message.sockfd);
+      delete follower;
+      return;
+    }
+    party->followers[follower->id] = follower;
+    relay_log.Log(LOG_PARTY_FOLLOWER_JOINED, party->key, follower->id);
+    if (!QueueFrame(party, PARTY_JOIN, follower->id, NULL, 0)) {
+      CloseParty(party);
+    }
+  }
+
+  void Dispatch(const RelayPollEvent& event) {
+    PartyEndpoint* endpoint = static_cast<PartyEndpoint*>(event.data);
+    if (-1 == endpoint->sockfd || -1 == endpoint->party->host.sockfd) {
+      return;  // closed earlier in this batch
+    }
+    bool ok = true;
+    if (event.writable) {
+      ok = Flush(endpoint);
+    }
+    if (ok && (event.readable || event.hangup)) {
+      ok = 0 == endpoint->id ? ReadHost(endpoint->party) :
+          ReadFollower(endpoint);
+    }
+    if (!ok && 0 == endpoint->id) {
+      CloseParty(endpoint->party);
+    } else if (!ok) {
+      DropFollower(endpoint, true);
+    }
+  }
+
+  void FreeClosed() {
+    for (size_t i = 0; i < closed_endpoints.size(); ++i) {
+      delete closed_endpoints[i];
+    }
+    closed_endpoints.clear();
+    for (size_t i = 0; i < closed_parties.size(); ++i) {
+      delete closed_parties[i];
+    }
+    closed_parties.clear();
+  }
+
+  void Discard(const PartyHandoff& message) {
+    close(message.sockfd);
+    if (message.host) {
+      Forget(message.key);
+    }
+  }
+
+  void CloseAll() {
+    while (!parties.empty()) {
+      CloseParty(parties.begin()->second);
+    }
+  }
+
+  // Frames from the host
+  bool ReadHost(RelayParty* party) {
+    char buffer[PARTY_READ_SIZE];
+    int rv = recv(party->host.sockfd, buffer, sizeof(buffer), 0);
+    if (rv < 0) {
+      return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+    if (rv == 0) {
+      relay_log.Log(LOG_PARTY_HOST_LEFT, party->key);
+      return false;
+    }
+    party->in.append(buffer, rv);
+
+    size_t at = 0;
+    while (party->in.size() - at >= PARTY_FRAME_HEADER) {
+      const unsigned char* header =
+        reinterpret_cast<const unsigned char*>(party->in.data() + at);
+      int type = header[0];
+      uint32_t id = ((uint32_t)header[1] << 24) | (header[2] << 16) |
+        (header[3] << 8) | header[4];
+      size_t length = (header[5] << 8) | header[6];
+      if (party->in.size() - at < PARTY_FRAME_HEADER + length) {
+        break;
+      }
+      const char* payload = party->in.data() + at + PARTY_FRAME_HEADER;
+      at += PARTY_FRAME_HEADER + length;
+      if (!HostFrame(party, type, id, payload, length)) {
+        return false;
+      }
+    }
+    party->in.erase(0, at);
+    return true;
+  }
+
+  bool HostFrame(RelayParty* party, int type, uint32_t id,
+      const char* payload, size_t length) {
+    if (PARTY_DATA == type && 0 == id) {
+      std::vector<PartyEndpoint*> followers;
+      std::map<uint32_t, PartyEndpoint*>::iterator itr;
+      for (itr = party->followers.begin(); itr != party->followers.end();
+          ++itr) {
+        if (itr->second->adopted) {
+          followers.push_back(itr->second);
+        }
+      }
+      for (size_t i = 0; i < followers.size(); ++i) {
+        Queue(followers[i], payload, length);
+      }
+      return true;
+    }
+
+    std::map<uint32_t, PartyEndpoint*>::iterator itr =
+      party->followers.find(id);
+    if (itr == party->followers.end()) {
+      return true;  // left before the host noticed
+    }
+    switch (type) {
+      case PARTY_DATA:
+        Queue(itr->second, payload, length);
+        return true;
+      case PARTY_JOIN:
+        itr->second->adopted = true;
+        return true;
+      case PARTY_LEAVE:
+        DropFollower(itr->second, false);
+        return true;
+      default:
+        relay_log.Log(LOG_PARTY_BAD_FRAME, party->key, type);
+        return false;
+    }
+  }
+
+  // Bytes from a follower go to the host as they come
+  bool ReadFollower(PartyEndpoint* follower) {
+    RelayParty* party = follower->party;
+    if (party->throttled) {
+      return true;
+    }
+    char buffer[PARTY_READ_SIZE];
+    int rv = recv(follower->sockfd, buffer, sizeof(buffer), 0);
+    if (rv < 0) {
+      return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+    if (rv == 0) {
+      return false;
+    }
+    if (!QueueFrame(party, PARTY_DATA, follower->id, buffer, rv)) {
+      CloseParty(party);
+    }
+    return true;
+  }
+
+  // Frame towards the host. Returns false if the host is gone.
+  bool QueueFrame(RelayParty* party, int type, uint32_t id,
+      const char* payload, size_t length) {
+    unsigned char header[PARTY_FRAME_HEADER];
+    header[0] = type;
+    header[1] = id >> 24;
+    header[2] = id >> 16;
+    header[3] = id >> 8;
+    header[4] = id;
+    header[5] = length >> 8;
+    header[6] = length;
+    PartyEndpoint* host = &party->host;
+    host->out.append(reinterpret_cast<char*>(header), sizeof(header));
+    host->out.append(payload, length);
+    if (!Flush(host)) {
+      return false;
+    }
+    if (!party->throttled && host->Backlog() > PARTY_MAX_BACKLOG) {
+      party->throttled = true;
+      UpdateFollowers(party);
+    }
+    return true;
+  }
+
+  void Queue(PartyEndpoint* follower, const char* payload, size_t length) {
+    follower->out.append(payload, length);
+    if (!Flush(follower)) {
+      DropFollower(follower, true);
+    } else if (follower->Backlog() > PARTY_MAX_BACKLOG) {
+      relay_log.Log(LOG_PARTY_FOLLOWER_SLOW, follower->party->key,
+          follower->id);
+      DropFollower(follower, true);
+    }
+  }
+
+  // Send what the socket takes and update interest. Returns false on
+  // error.
+  bool Flush(PartyEndpoint* endpoint) {
+    while (endpoint->Backlog() > 0) {
+      int rv = send(endpoint->sockfd, endpoint->out.data() + endpoint->out_start,
+          endpoint->Backlog(), MSG_NOSIGNAL);
+      if (rv < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+          break;
+        }
+        return false;
+      }
+      endpoint->out_start += rv;
+    }
+    if (0 == endpoint->Backlog()) {
+      endpoint->out.clear();
+      endpoint->out_start = 0;
+    } else if (endpoint->out_start > PARTY_READ_SIZE) {
+      endpoint->out.erase(0, endpoint->out_start);
+      endpoint->out_start = 0;
+    }
+
+    RelayParty* party = endpoint->party;
+    if (0 == endpoint->id && party->throttled &&
+        endpoint->Backlog() <= PARTY_MAX_BACKLOG / 2) {
+      party->throttled = false;
+      UpdateFollowers(party);
+    }
+    bool want_read = 0 == endpoint->id || !party->throttled;
+    poller.Modify(endpoint->sockfd, endpoint, want_read,
+        endpoint->Backlog() > 0);
+    return true;
+  }
+
+  void UpdateFollowers(RelayParty* party) {
+    std::map<uint32_t, PartyEndpoint*>::iterator itr;
+    for (itr = party->followers.begin(); itr != party->followers.end();
+        ++itr) {
+      poller.Modify(itr->second->sockfd, itr->second, !party->throttled,
+          itr->second->Backlog() > 0);
+    }
+  }
+
+  void DropFollower(PartyEndpoint* follower, bool tell_host) {
+    if (-1 == follower->sockfd) {
+      return;
+    }
+    RelayParty* party = follower->party;
+    poller.Remove(follower->sockfd);
+    close(follower->sockfd);
+    follower->sockfd = -1;
+    party->followers.erase(follower->id);
+    closed_endpoints.push_back(follower);
+    relay_log.Log(LOG_PARTY_FOLLOWER_LEFT, party->key, follower->id);
+    if (tell_host && -1 != party->host.sockfd &&
+        !QueueFrame(party, PARTY_LEAVE, follower->id, NULL, 0)) {
+      CloseParty(party);
+    }
+  }
+
+  // The host is gone, and with it the party
+  void CloseParty(RelayParty* party) {
+    if (-1 == party->host.sockfd) {
+      return;
+    }
+    poller.Remove(party->host.sockfd);
+    close(party->host.sockfd);
+    party->host.sockfd = -1;
+    while (!party->followers.empty()) {
+      DropFollower(party->followers.begin()->second, false);
+    }
+    parties.erase(party->key);
+    Forget(party->key);
+    closed_parties.push_back(party);
+    relay_log.Log(LOG_PARTY_CLOSED, party->key);
+  }
+
+  void Forget(ConnectionMapKey key) {
+    pthread_mutex_lock(&keys_lock);
+    keys.erase(key);
+    pthread_mutex_unlock(&keys_lock);
+  }
+
+  std::map<ConnectionMapKey, RelayParty*> parties;  // hub thread only
+  std::vector<PartyEndpoint*> closed_endpoints;
+  std::vector<RelayParty*> closed_parties;
+
+  pthread_mutex_t keys_lock;
+  std::set<ConnectionMapKey> keys;  // of open parties, for Has()
+
+  // not copyable
+  RelayPartyHub(const RelayPartyHub&);
+  RelayPartyHub& operator=(const RelayPartyHub&);
+};
+
+#endif  // _RELAY_PARTY_H_
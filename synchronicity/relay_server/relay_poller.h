@@ -0,0 +1,174 @@
+#ifndef _RELAY_POLLER_H_
+#define _RELAY_POLLER_H_
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#define RELAY_POLLER_EPOLL 1
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) || \
+      defined(__NetBSD__) || defined(__DragonFly__)
+#include <sys/types.h>
+#include <sys/event.h>
+#include <sys/time.h>
+#define RELAY_POLLER_KQUEUE 1
+#else
+#error "relay event loop needs epoll or kqueue"
+#endif
+
+#define RELAY_POLLER_MAX_EVENTS 64
+
+// One readiness notification returned by RelayPoller::Wait
+struct RelayPollEvent {
+  void* data;
+  bool readable;
+  bool writable;
+  bool hangup;
+};
+
+// Thin wrapper over epoll (Linux) or kqueue (BSD, OS X) so the relay
+// worker loop does not care which one it runs on. Interest is level
+// triggered on both backends.
+class RelayPoller {
+ public:
+  RelayPoller() {
+#if defined(RELAY_POLLER_EPOLL)
+    fd = epoll_create(RELAY_POLLER_MAX_EVENTS);
+#else
+    fd = kqueue();
+#endif
+    if (fd == -1) {
+      perror("poller");
+    }
+  }
+
+  ~RelayPoller() {
+    if (fd != -1) {
+      close(fd);
+    }
+  }
+
+  bool IsValid() const { return fd != -1; }
+
+  // Start watching sockfd. data is handed back in RelayPollEvent.
+  int Add(int sockfd, void* data, bool want_read, bool want_write) {
+#if defined(RELAY_POLLER_EPOLL)
+    return Control(EPOLL_CTL_ADD, sockfd, data, want_read, want_write);
+#else
+    return Control(sockfd, data, EV_ADD, want_read, want_write);
+#endif
+  }
+
+  // Change the interest set of a socket already added
+  int Modify(int sockfd, void* data, bool want_read, bool want_write) {
+#if defined(RELAY_POLLER_EPOLL)
+    return Control(EPOLL_CTL_MOD, sockfd, data, want_read, want_write);
+#else
+    return Control(sockfd, data, 0, want_read, want_write);
+#endif
+  }
+
+  // Stop watching the socket. Must be called before closing it if the
+  // socket has been dup'ed anywhere, harmless otherwise.
+  int Remove(int sockfd) {
+#if defined(RELAY_POLLER_EPOLL)
+    struct epoll_event ev;  // ignored, but required before 2.6.9
+    return epoll_ctl(fd, EPOLL_CTL_DEL, sockfd, &ev);
+#else
+    struct kevent changes[2];
+    EV_SET(&changes[0], sockfd, EVFILT_READ, EV_DELETE, 0, 0, NULL);
+    EV_SET(&changes[1], sockfd, EVFILT_WRITE, EV_DELETE, 0, 0, NULL);
+    return kevent(fd, changes, 2, NULL, 0, NULL);
+#endif
+  }
+
+  // Block up to timeout_ms (-1 for ever) and fill at most max_events.
+  // Returns the number of events, 0 on timeout or when interrupted.
+  int Wait(RelayPollEvent* events, int max_events, int timeout_ms) {
+    if (max_events > RELAY_POLLER_MAX_EVENTS) {
+      max_events = RELAY_POLLER_MAX_EVENTS;
+    }
+#if defined(RELAY_POLLER_EPOLL)
+    struct epoll_event ready[RELAY_POLLER_MAX_EVENTS];
+    int rv = epoll_wait(fd, ready, max_events, timeout_ms);
+    if (rv < 0) {
+      if (errno != EINTR) {
+        perror("epoll_wait");
+      }
+      return 0;
+    }
+    for (int i = 0; i < rv; ++i) {
+      events[i].data = ready[i].data.ptr;
+      events[i].readable = (ready[i].events & EPOLLIN) != 0;
+      events[i].writable = (ready[i].events & EPOLLOUT) != 0;
+      events[i].hangup = (ready[i].events & (EPOLLHUP | EPOLLERR)) != 0;
+    }
+    return rv;
+#else
+    struct kevent ready[RELAY_POLLER_MAX_EVENTS];
+    struct timespec timeout;
+    struct timespec* timeout_ptr = NULL;
+    if (timeout_ms >= 0) {
+      timeout.tv_sec = timeout_ms / 1000;
+      timeout.tv_nsec = (timeout_ms % 1000) * 1000000;
+      timeout_ptr = &timeout;
+    }
+    int rv = kevent(fd, NULL, 0, ready, max_events, timeout_ptr);
+    if (rv < 0) {
+      if (errno != EINTR) {
+        perror("kevent");
+      }
+      return 0;
+    }
+    // kqueue reports read and write readiness as separate events; the
+    // caller copes with seeing the same socket twice.
+    for (int i = 0; i < rv; ++i) {
+      events[i].data = ready[i].udata;
+      events[i].readable = ready[i].filter == EVFILT_READ;
+      events[i].writable = ready[i].filter == EVFILT_WRITE;
+      events[i].hangup = (ready[i].flags & (EV_EOF | EV_ERROR)) != 0;
+    }
+    return rv;
+#endif
+  }
+
+ private:
+#if defined(RELAY_POLLER_EPOLL)
+  int Control(int op, int sockfd, void* data, bool want_read, bool want_write) {
+    struct epoll_event ev;
+    ev.events = (want_read ? (uint32_t)EPOLLIN : 0u) |
+        (want_write ? (uint32_t)EPOLLOUT : 0u);
+    ev.data.ptr = data;
+    int rv = epoll_ctl(fd, op, sockfd, &ev);
+    if (rv == -1) {
+      perror("epoll_ctl");
+    }
+    return rv;
+  }
+#else
+  int Control(int sockfd, void* data, unsigned short add,
+      bool want_read, bool want_write) {
+    struct kevent changes[2];
+    EV_SET(&changes[0], sockfd, EVFILT_READ,
+        add | (want_read ? EV_ENABLE : EV_DISABLE), 0, 0, data);
+    EV_SET(&changes[1], sockfd, EVFILT_WRITE,
+        add | (want_write ? EV_ENABLE : EV_DISABLE), 0, 0, data);
+    int rv = kevent(fd, changes, 2, NULL, 0, NULL);
+    if (rv == -1) {
+      perror("kevent");
+    }
+    return rv;
+  }
+#endif
+
+  int fd;
+
+  // not copyable
+  RelayPoller(const RelayPoller&);
+  RelayPoller& operator=(const RelayPoller&);
+};
+
+#endif  // _RELAY_POLLER_H_
@@ -1,5 +1,6 @@
 #include <arpa/inet.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <netdb.h>
 #include <netinet/in.h>
 #include <signal.h>
@@ -13,39 +14,106 @@
 #include <unistd.h>
 #include <sstream>
 
+#include <deque>
 #include <map>
-#include <set>
+#include <string>
+#include <utility>
+#include <vector>
 
+#include "relay_beacon.h"
+#include "relay_cluster.h"
 #include "relay_common.h"
+#include "relay_handshake.h"
+#include "relay_limits.h"
+#include "relay_log.h"
+#include "relay_metrics.h"
+#include "relay_party.h"
+#include "relay_poller.h"
+#include "relay_session.h"
+#include "relay_stream.h"
+#include "relay_worker.h"
 #include "connection_map.h"
+#include "timer_wheel.h"
 
 #define STARTING_PORT 56789
 #define MIN_PORT 1025
 #define MAX_PORT 65535
 
-struct PendingSocket {
-  int sockfd;
+// Seconds a host may wait for its client before its key is dropped
+#define DEFAULT_PENDING_TIMEOUT (15*60)
 
-  PendingSocket(int sockfd)
-    : sockfd(sockfd) {
-  }
-};
-
-
-typedef std::map<ConnectionMapKey,
-         PendingSocket> ConnectionMap;
 ConnectionMap connection_map;
+time_t pending_timeout = DEFAULT_PENDING_TIMEOUT;
+// Deadlines of pending hosts; entries of hosts that got paired in the
+// meantime are ignored when they fire
+TimerWheel<ConnectionMapKey> pending_expiry(1024, time(NULL));
 
 typedef int SocketDescriptor;
-typedef std::set<SocketDescriptor> SocketSet;
 
 bool running;
 int server_sockfd;  // listen on sock_fd, new connection on new_fd
 
+// Seconds the listening socket is left alone once out of descriptors
+#define ACCEPT_PAUSE 1
+
+// Kept open to be given up when the process runs out of descriptors:
+// the connection at the head of the backlog can then be accepted and
+// dropped, rather than making the listening socket ready forever.
+int spare_fd = -1;
+// While out of descriptors the listening socket is not watched
+bool accept_paused = false;
+time_t accept_resume = 0;
+
+// Paired sockets are relayed by this pool unless fork_mode is set,
+// in which case every pair gets its own child process as before.
+bool fork_mode = false;
+bool use_splice = true;
+RelayWorkerPool worker_pool;
+
+// Only set up with -n and -N; a lone relay owns every key
+RelayCluster cluster;
+
+// One host, many followers: see relay_party.h
+RelayPartyHub party_hub;
+
+// UDP sync beacons of local pairs: see relay_beacon.h
+RelayBeacons beacons;
+
+// Pairs that may be resumed: see relay_session.h
+RelaySessions sessions;
+
+// Media from a host to its peers: see relay_stream.h
+RelayStreamHub stream_hub;
+
+// Per address limits: see relay_limits.h
+RelayAdmission admission;
+// Bytes per second of each direction of a pair, 0 for no limit
+long pair_rate = 0;
+
+// Pairs may burst a second's worth, and at least one full read
+long PairBurst() {
+  return pair_rate > RELAY_SPLICE_SIZE ? pair_rate : RELAY_SPLICE_SIZE;
+}
+
+// Served on the metrics port if one is given: see relay_metrics.h
+RelayMetrics metrics;
+RelayMetricsEndpoint metrics_endpoint;
+
 void sigchld_handler(int s)
 {
-    while(waitpid(-1, NULL, WNOHANG) > 0);
-    printf("child died");
+    while(waitpid(-1, NULL, WNOHANG) > 0) {
+      relay_log.Log(LOG_CHILD_DIED);
+    }
+}
+
+// Page of the metrics endpoint
+void RenderMetrics(std::string* out) {
+  metrics.Render(out);
+  AppendMetric(out, "relay_pairs_active", "gauge", worker_pool.NumPairs());
+  AppendMetric(out, "relay_pairs_throttled", "gauge",
+      worker_pool.NumThrottled());
+  AppendMetric(out, "relay_bytes_total", "counter", worker_pool.Bytes());
+  AppendMetric(out, "relay_log_lost_total", "counter", relay_log.Lost());
 }
 
 void sigint_handler(int s) {
@@ -58,6 +126,11 @@ void forked_child_worker(int sock1, int sock2) {
   int ready_sock = sock2;
   int other_sock;
   char buffer[10240];
+  // The rate cap is enforced by sleeping, which holds the other
+  // direction too; good enough for the legacy mode.
+  TokenBucket buckets[2];
+  buckets[0].Init(pair_rate, PairBurst(), relay_now_ms());
+  buckets[1].Init(pair_rate, PairBurst(), relay_now_ms());
 
   while(running) {
     if(ready_sock == sock1) {
@@ -72,18 +145,24 @@ void forked_child_worker(int sock1, int sock2) {
       other_sock = sock1;
     }
 
-    int len = crecv_upto(ready_sock, buffer, 10240);
+    TokenBucket& bucket = buckets[ready_sock == sock1 ? 0 : 1];
+    long allowed;
+    while(0 == (allowed = bucket.Allow(sizeof(buffer), relay_now_ms()))) {
+      usleep(bucket.WaitMs() * 1000);
+    }
+    int len = crecv_upto(ready_sock, buffer, allowed);
 
     if(len == 0) {
-      printf("connection closing\n");
+      relay_log.Log(LOG_PAIR_CLOSED);
       close(sock1);
       close(sock2);
       break;
     }
+    bucket.Spend(len);
 
     int rv = ssend_all(other_sock, buffer, len);
     if (rv != 0) {
-      printf("Error: Could not relay message.\n");
+      relay_log.Log(LOG_RELAY_ERROR);
       continue;
     }
   }
@@ -91,11 +170,29 @@ void forked_child_worker(int sock1, int sock2) {
   exit(0);
 }
 
-void ConnectionPairReady(int sockfd1, int sockfd2) {
+// session is NULL unless the pair may be resumed, never in fork_mode
+void ConnectionPairReady(int sockfd1, int sockfd2, RelaySession* session) {
+  if(!fork_mode) {
+    if(0 != worker_pool.Assign(sockfd1, sockfd2, session)) {
+      relay_log.Log(LOG_PAIR_FAILED);
+      if(NULL != session && SessionBreak(session, false)) {
+        reset_on_close(sockfd1);
+        reset_on_close(sockfd2);
+      }
+      close(sockfd1);
+      close(sockfd2);
+    }
+    return;
+  }
+
+  // The relay loop of the child expects blocking sockets
+  set_nonblocking(sockfd1, false);
+  set_nonblocking(sockfd2, false);
   if(!fork()) {
     // Child process
     close(server_sockfd);
-    connection_map.clear();
+    connection_map.Clear();
+    relay_log.Direct();  // the log thread stayed with the parent
     forked_child_worker(sockfd1, sockfd2); // never returns
   } else {
     // Parent
@@ -104,34 +201,483 @@ void ConnectionPairReady(int sockfd1, int sockfd2) {
   }
 }
 
-int SetupPendingSockets(SocketSet& pending_sockets, fd_set& sockets) {
-  int max_fd = -1;
-  FD_ZERO(&sockets);
-  for(SocketSet::iterator it = pending_sockets.begin();
-      it != pending_sockets.end();
-      it++) {
-    FD_SET(*it, &sockets);
-    if (*it > max_fd) {
-      max_fd = *it;
+typedef std::map<SocketDescriptor, Handshake*> HandshakeMap;
+typedef std::deque<std::pair<time_t, SocketDescriptor> > HandshakeDeadlines;
+
+RelayPoller handshake_poller;
+HandshakeMap handshakes;
+HandshakeDeadlines handshake_deadlines;
+std::vector<Handshake*> finished_handshakes;  // freed after each batch
+
+// Start watching a handshake socket. Returns 0 on success.
+int TrackHandshake(Handshake* handshake, bool want_read, bool want_write) {
+  if(0 != handshake_poller.Add(handshake->sockfd, handshake,
+        want_read, want_write)) {
+    return 1;
+  }
+  handshakes[handshake->sockfd] = handshake;
+  handshake_deadlines.push_back(
+      std::make_pair(handshake->deadline, handshake->sockfd));
+  return 0;
+}
+
+// Accept every connection waiting on the listening socket and start
+// its handshake. Returns false if accept failed for good. Addresses
+// over their limit are turned away at once, other relay nodes are not
+// limited.
+bool AcceptPendingSockets(time_t now) {
+  while(running) {
+    struct sockaddr_storage addr;
+    int client_socket = accept_connection(server_sockfd, &addr);
+    if(-1 == client_socket) {
+      if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ||
+          errno == ECONNABORTED) {
+        return true;
+      }
+      if(errno != EMFILE && errno != ENFILE) {
+        relay_log.Log(LOG_ACCEPT_FAILED, errno);
+        return false;
+      }
+      if(-1 != spare_fd) {
+        close(spare_fd);
+        int dropped = accept(server_sockfd, NULL, NULL);
+        if(-1 != dropped) {
+          close(dropped);
+          relay_log.Log(LOG_ACCEPT_DROPPED);
+        }
+        spare_fd = open("/dev/null", O_RDONLY);
+        if(-1 != dropped && -1 != spare_fd) {
+          continue;
+        }
+      }
+      // No spare to give up, wait for descriptors to free up
+      handshake_poller.Remove(server_sockfd);
+      accept_paused = true;
+      accept_resume = now + ACCEPT_PAUSE;
+      relay_log.Log(LOG_ACCEPT_PAUSED, ACCEPT_PAUSE);
+      return true;
+    }
+    metrics.Count(&metrics.connections);
+    relay_log.Log(LOG_CONNECTION, 0, 0, &addr);
+    Handshake* handshake = new Handshake(client_socket, now);
+    handshake->addr = addr;
+    handshake->client = RelayAddr(addr);
+    if(!cluster.IsNode(addr)) {
+      if(!admission.AdmitHandshake(handshake->client)) {
+        metrics.Count(&metrics.refused[REFUSED_HANDSHAKES]);
+        relay_log.Log(LOG_REFUSED, REFUSED_HANDSHAKES, 0, &addr);
+        close(client_socket);
+        delete handshake;
+        continue;
+      }
+      handshake->admitted = true;
     }
+    if(0 != set_nonblocking(client_socket) ||
+        0 != TrackHandshake(handshake, true, false)) {
+      if(handshake->admitted) {
+        admission.HandshakeDone(handshake->client);
+      }
+      close(client_socket);
+      delete handshake;
+      continue;
+    }
+  }
+  return true;
+}
+
+// Stop tracking the handshake; does not close the socket
+void FinishHandshake(Handshake* handshake) {
+  if(handshake->admitted) {
+    admission.HandshakeDone(handshake->client);
+    handshake->admitted = false;
+  }
+  handshake_poller.Remove(handshake->sockfd);
+  handshakes.erase(handshake->sockfd);
+  finished_handshakes.push_back(handshake);
+}
+
+// The host of this client key waits on another node. Pass the key on
+// to that node and relay through it once it answers; clients only know
+// the address they were given, so they cannot be redirected.
+void ProxyToOwner(Handshake* handshake, time_t now) {
+  ConnectionMapKey key = handshake->key;
+  if(!cluster.Knows(key)) {
+    relay_log.Log(LOG_NO_NODE, key, NodeOfKey(key));
+    handshake->state = HANDSHAKE_FAILED;
+    return;
+  }
+  int sockfd = cluster.ConnectToOwner(key);
+  if(-1 == sockfd) {
+    handshake->state = HANDSHAKE_FAILED;
+    return;
+  }
+  Handshake* upstream = new Handshake(sockfd, now);
+  upstream->Forward(key);
+  if(0 != TrackHandshake(upstream, false, true)) {
+    close(sockfd);
+    delete upstream;
+    handshake->state = HANDSHAKE_FAILED;
+    return;
+  }
+  upstream->peer = handshake;
+  handshake->peer = upstream;
+  handshake->state = HANDSHAKE_PROXYING;
+  relay_log.Log(LOG_PROXYING, key, NodeOfKey(key));
+}
+
+// The whole key arrived: pick the reply and look up the host
+void HandshakeKeyReceived(Handshake* handshake, time_t now) {
+  ConnectionMapKey key = handshake->key;
+  // Sessions only for pairs relayed by a worker of this node
+  bool open = SESSION_OPEN_KEY == handshake->marker && !fork_mode;
+  if(SESSION_RESUME_KEY == handshake->marker) {
+    // key is the token, checked again once the reply is out
+    handshake->Reply(sessions.Knows(key) ? 0 : SESSION_UNKNOWN);
+  } else if(STREAM_SOURCE_KEY == handshake->marker ||
+      STREAM_SINK_KEY == handshake->marker) {
+    // Only the owning node fans a stream out, proxies carry no streams
+    if(key <= STREAM_SINK_KEY || !cluster.IsLocal(key)) {
+      handshake->Reply(STREAM_REFUSED);
+    } else {
+      handshake->party = STREAM_SOURCE_KEY == handshake->marker ?
+        HANDSHAKE_STREAM_SOURCE : HANDSHAKE_STREAM_SINK;
+      handshake->Reply(0);
+    }
+  } else if(0 == key || PARTY_HOST_KEY == key) {
+    if(PARTY_HOST_KEY == key) {
+      handshake->party = HANDSHAKE_PARTY_HOST;
+    } else if(handshake->admitted && !admission.MayHost(handshake->client)) {
+      metrics.Count(&metrics.refused[REFUSED_PENDING]);
+      relay_log.Log(LOG_REFUSED, REFUSED_PENDING, 0, &handshake->addr);
+      handshake->state = HANDSHAKE_FAILED;
+      return;
+    }
+    do {
+      key = cluster.OwnKey(RandomKey());
+    } while(key <= STREAM_SINK_KEY ||
+        connection_map.Contains(key) || party_hub.Has(key));
+    handshake->key = key;
+    handshake->Reply(key, open && HANDSHAKE_NO_PARTY == handshake->party ?
+        sessions.Open(key, handshake->deadline) : 0);
+  } else if(!cluster.IsLocal(key)) {
+    ProxyToOwner(handshake, now);
+  } else if(party_hub.Has(key)) {
+    handshake->party = HANDSHAKE_PARTY_FOLLOWER;
+    relay_log.Log(LOG_PARTY_JOINING, key);
+    handshake->Reply(0);
+  } else {
+    PendingSocket host;
+    if(!connection_map.Take(key, &host)) {
+      relay_log.Log(LOG_NO_HOST, key);
+      handshake->state = HANDSHAKE_FAILED;
+      return;
+    }
+    handshake->paired_sockfd = host.sockfd;
+    beacons.Pair(key, now);
+    time_t waited = now - (host.deadline - pending_timeout);
+    waited = waited < 0 ? 0 : waited;
+    metrics.Paired(waited);
+    relay_log.Log(LOG_MATCHED, key, waited);
+    handshake->Reply(0, open ? sessions.Join(key) : 0);
+  }
+}
+
+// Park a host socket until its client shows up or the timeout hits.
+// The key counts against the address of the host until then.
+void AddPendingHost(ConnectionMapKey key, int sockfd, time_t now,
+    const RelayAddr& addr) {
+  time_t deadline = now + pending_timeout;
+  if(!connection_map.Insert(PendingSocket(key, sockfd, deadline))) {
+    sessions.Drop(key);
+    admission.RemovePending(key);
+    close(sockfd);
+    return;
+  }
+  admission.AddPending(key, addr);
+  sessions.Pending(key, deadline);
+  pending_expiry.Schedule(deadline, key);
+}
+
+// Close hosts whose deadline passed, one key at a time
+void ExpirePendingHosts(time_t now) {
+  std::vector<ConnectionMapKey> expired;
+  pending_expiry.Advance(now, expired);
+  for(size_t i = 0; i < expired.size(); ++i) {
+    PendingSocket host;
+    if(connection_map.TakeExpired(expired[i], now, &host)) {
+      sessions.Drop(host.key);
+      admission.RemovePending(host.key);
+      close(host.sockfd);
+      metrics.Count(&metrics.expired_keys);
+      relay_log.Log(LOG_HOST_EXPIRED, host.key);
+    }
+  }
+}
+
+void ProgressUpstream(Handshake* upstream, bool readable, bool writable,
+    time_t now);
+
+// Move the handshake forward after a readiness event
+void ProgressHandshake(Handshake* handshake, bool readable, bool writable,
+    time_t now) {
+  if(handshake->upstream) {
+    ProgressUpstream(handshake, readable, writable, now);
+    return;
+  }
+  if(HANDSHAKE_READING_KEY == handshake->state && readable) {
+    handshake->Read();
+    if(HANDSHAKE_WRITING_REPLY == handshake->state) {
+      HandshakeKeyReceived(handshake, now);
+      writable = true;  // try right away, the socket is usually ready
+    }
+  }
+  if(HANDSHAKE_WRITING_REPLY == handshake->state && writable) {
+    handshake->Write();
+  }
+
+  switch(handshake->state) {
+    case HANDSHAKE_READING_KEY:
+      break;
+    case HANDSHAKE_WRITING_REPLY:
+      handshake_poller.Modify(handshake->sockfd, handshake, false, true);
+      break;
+    case HANDSHAKE_PROXYING:
+      // Nothing to do until the owning node answers
+      handshake_poller.Modify(handshake->sockfd, handshake, false, false);
+      break;
+    case HANDSHAKE_CONNECTING:
+      break;  // upstream only
+    case HANDSHAKE_DONE:
+      FinishHandshake(handshake);
+      if(SESSION_RESUME_KEY == handshake->marker) {
+        if(!sessions.Resume(handshake->key, handshake->sockfd)) {
+          close(handshake->sockfd);  // ended while we replied
+        } else {
+          relay_log.Log(LOG_SESSION_RESUMING);
+        }
+      } else if(HANDSHAKE_STREAM_SOURCE == handshake->party ||
+          HANDSHAKE_STREAM_SINK == handshake->party) {
+        if(0 != stream_hub.Add(handshake->key, handshake->sockfd,
+              HANDSHAKE_STREAM_SOURCE == handshake->party)) {
+          close(handshake->sockfd);
+        }
+      } else if(STREAM_SOURCE_KEY == handshake->marker ||
+          STREAM_SINK_KEY == handshake->marker) {
+        close(handshake->sockfd);  // refused
+      } else if(HANDSHAKE_PARTY_HOST == handshake->party) {
+        if(0 != party_hub.Host(handshake->key, handshake->sockfd)) {
+          close(handshake->sockfd);
+        }
+      } else if(HANDSHAKE_PARTY_FOLLOWER == handshake->party) {
+        if(0 != party_hub.Join(handshake->key, handshake->sockfd)) {
+          close(handshake->sockfd);
+        }
+      } else if(-1 == handshake->paired_sockfd) {
+        AddPendingHost(handshake->key, handshake->sockfd, now,
+            handshake->client);
+        relay_log.Log(LOG_HOST_WAITING, handshake->key);
+      } else {
+        admission.RemovePending(handshake->key);
+        ConnectionPairReady(handshake->paired_sockfd, handshake->sockfd,
+            sessions.Paired(handshake->key, handshake->paired_sockfd,
+              handshake->sockfd));
+      }
+      break;
+    case HANDSHAKE_FAILED:
+      FinishHandshake(handshake);
+      close(handshake->sockfd);
+      metrics.Count(&metrics.handshake_failures);
+      if(NULL != handshake->peer) {
+        Handshake* upstream = handshake->peer;
+        upstream->peer = NULL;
+        handshake->peer = NULL;
+        upstream->state = HANDSHAKE_FAILED;
+        ProgressUpstream(upstream, false, false, now);
+      }
+      if(-1 != handshake->paired_sockfd) {
+        if(cluster.IsLocal(handshake->key)) {
+          // The host did nothing wrong, let it wait for another client,
+          // its key is still counted against its address
+          AddPendingHost(handshake->key, handshake->paired_sockfd, now,
+              RelayAddr());
+        } else {
+          close(handshake->paired_sockfd);  // the owning node cleans up
+        }
+      }
+      break;
   }
-  return max_fd;
 }
 
-SocketDescriptor GetReadableSocket(SocketSet& pending_sockets, fd_set& sockets) {
-  for(SocketSet::iterator it = pending_sockets.begin();
-      it != pending_sockets.end();
-      it++) {
-      if(FD_ISSET(*it, &sockets)) {
-        return *it;
+// Our side of a proxied client: connect to the owning node, send the
+// client's key and hand the answer back to the waiting client.
+void ProgressUpstream(Handshake* upstream, bool readable, bool writable,
+    time_t now) {
+  if(HANDSHAKE_CONNECTING == upstream->state && writable) {
+    upstream->Connected();
+  }
+  if(HANDSHAKE_WRITING_REPLY == upstream->state && writable) {
+    upstream->Write();
+    if(HANDSHAKE_DONE == upstream->state) {
+      upstream->Expect();
+      readable = true;  // the answer may be there already
+    }
+  }
+  if(HANDSHAKE_READING_KEY == upstream->state && readable) {
+    upstream->Read();
+    if(HANDSHAKE_WRITING_REPLY == upstream->state) {
+      upstream->state = HANDSHAKE_DONE;  // answer parsed into key
+    }
+  }
+
+  Handshake* client = upstream->peer;
+  switch(upstream->state) {
+    case HANDSHAKE_CONNECTING:
+    case HANDSHAKE_WRITING_REPLY:
+      handshake_poller.Modify(upstream->sockfd, upstream, false, true);
+      break;
+    case HANDSHAKE_READING_KEY:
+      handshake_poller.Modify(upstream->sockfd, upstream, true, false);
+      break;
+    case HANDSHAKE_PROXYING:
+      break;  // clients only
+    case HANDSHAKE_DONE:
+      FinishHandshake(upstream);
+      upstream->peer = NULL;
+      client->peer = NULL;
+      client->paired_sockfd = upstream->sockfd;
+      client->Reply(upstream->key);
+      client->state = HANDSHAKE_WRITING_REPLY;
+      ProgressHandshake(client, false, true, now);
+      break;
+    case HANDSHAKE_FAILED:
+      FinishHandshake(upstream);
+      close(upstream->sockfd);
+      if(NULL != client) {
+        upstream->peer = NULL;
+        client->peer = NULL;
+        client->state = HANDSHAKE_FAILED;
+        ProgressHandshake(client, false, false, now);
       }
+      break;
   }
-  return -1;
 }
 
-int main(void) {
+// Relay the sessions both sides of which came back
+void ResumeSessions(time_t now) {
+  std::vector<RelaySession*> ready;
+  sessions.Ready(ready);
+  for(size_t i = 0; i < ready.size(); ++i) {
+    RelaySession* session = ready[i];
+    beacons.Pair(session->key, now);
+    relay_log.Log(LOG_SESSION_RESUMED, session->key);
+    ConnectionPairReady(session->sockfd[0], session->sockfd[1], session);
+  }
+}
+
+// Drop handshakes that have not completed in HANDSHAKE_TIMEOUT.
+// Deadlines are queued in accept order, so they are sorted already.
+void ExpireHandshakes(time_t now) {
+  while(!handshake_deadlines.empty() &&
+      handshake_deadlines.front().first <= now) {
+    HandshakeMap::iterator itr =
+      handshakes.find(handshake_deadlines.front().second);
+    // The descriptor may have been reused by a later handshake
+    if(itr != handshakes.end() &&
+        itr->second->deadline <= handshake_deadlines.front().first) {
+      metrics.Count(&metrics.handshake_timeouts);
+      relay_log.Log(LOG_HANDSHAKE_TIMEOUT);
+      itr->second->state = HANDSHAKE_FAILED;
+      ProgressHandshake(itr->second, false, false, now);
+    }
+    handshake_deadlines.pop_front();
+  }
+}
+
+void usage(const char* name) {
+  fprintf(stderr, "Usage: %s [-f] [-c] [-w workers] [-t seconds]"
+      " [-g seconds] [-n id -N nodes] [-a count] [-p count] [-b kbytes]"
+      " [-m port]\n"
+      "  -f          fork one process per pair (legacy mode)\n"
+      "  -c          copy relayed bytes through user space, no splice()\n"
+      "  -w workers  number of relay threads [default: one per cpu]\n"
+      "  -t seconds  how long a host key waits for its client [default: %d]\n"
+      "  -g seconds  how long a broken pair may be resumed [default: %d]\n"
+      "  -n id       id of this relay in the node file\n"
+      "  -N nodes    file of \"<id> <host> <port>\" lines, one per relay\n"
+      "  -a count    handshakes at once per address, 0 for any [default: %d]\n"
+      "  -p count    host keys waiting per address, 0 for any [default: %d]\n"
+      "  -b kbytes   KiB per second each way of a pair [default: no limit]\n"
+      "  -m port     serve metrics over HTTP on this port\n",
+      name, DEFAULT_PENDING_TIMEOUT, DEFAULT_SESSION_GRACE,
+      DEFAULT_MAX_HANDSHAKES_PER_ADDR, DEFAULT_MAX_PENDING_PER_ADDR);
+}
+
+int main(int argc, char* argv[]) {
   struct sigaction sa;
 
+  long num_workers = sysconf(_SC_NPROCESSORS_ONLN);
+  long node_id = -1;
+  const char* nodes_path = NULL;
+  long max_handshakes = DEFAULT_MAX_HANDSHAKES_PER_ADDR;
+  long max_pending = DEFAULT_MAX_PENDING_PER_ADDR;
+  const char* metrics_port = NULL;
+  int opt;
+  while ((opt = getopt(argc, argv, "fcw:t:g:n:N:a:p:b:m:h")) != -1) {
+    switch (opt) {
+      case 'f':
+        fork_mode = true;
+        break;
+      case 'c':
+        use_splice = false;
+        break;
+      case 'w':
+        num_workers = strtol(optarg, NULL, 10);
+        break;
+      case 't':
+        pending_timeout = strtol(optarg, NULL, 10);
+        break;
+      case 'g':
+        sessions.SetGrace(strtol(optarg, NULL, 10));
+        break;
+      case 'n':
+        node_id = strtol(optarg, NULL, 10);
+        break;
+      case 'N':
+        nodes_path = optarg;
+        break;
+      case 'a':
+        max_handshakes = strtol(optarg, NULL, 10);
+        break;
+      case 'p':
+        max_pending = strtol(optarg, NULL, 10);
+        break;
+      case 'b':
+        pair_rate = strtol(optarg, NULL, 10) * 1024;
+        break;
+      case 'm':
+        metrics_port = optarg;
+        break;
+      default:
+        usage(argv[0]);
+        exit(1);
+    }
+  }
+  if (num_workers < 1) {
+    num_workers = 1;
+  }
+  if ((node_id == -1) != (nodes_path == NULL) || max_handshakes < 0 ||
+      max_pending < 0 || pair_rate < 0) {
+    usage(argv[0]);
+    exit(1);
+  }
+  admission.SetLimits(max_handshakes, max_pending);
+  if (nodes_path) {
+    if (node_id < 0 || 0 != cluster.Load(nodes_path, node_id)) {
+      exit(1);
+    }
+    printf("server: relay node %u of cluster %s\n", cluster.Self(), nodes_path);
+  }
+
   int port = STARTING_PORT;
   char port_buffer[7];
   while (true) {
@@ -164,123 +710,118 @@ int main(void) {
     perror("sigaction");
     exit(1);
   }
+  // A peer going away must not take the whole relay down with it
+  sa.sa_handler = SIG_IGN;
+  sigemptyset(&sa.sa_mask);
+  if (sigaction(SIGPIPE, &sa, NULL) == -1) {
+    perror("sigaction");
+    exit(1);
+  }
+
+  if (0 != relay_log.Start()) {
+    fprintf(stderr, "Error: could not start logging\n");
+    exit(1);
+  }
+
+  if (!fork_mode) {
+    if (0 != worker_pool.Start(num_workers, use_splice, pair_rate,
+          PairBurst())) {
+      fprintf(stderr, "Error: could not start relay workers\n");
+      exit(1);
+    }
+    printf("server: relaying with %ld worker threads\n", num_workers);
+  }
+
+  if (0 != party_hub.Start()) {
+    fprintf(stderr, "Error: could not start party hub\n");
+    exit(1);
+  }
+
+  if (0 != stream_hub.Start()) {
+    fprintf(stderr, "Error: could not start stream hub\n");
+    exit(1);
+  }
+
+  if (metrics_port) {
+    if (0 != metrics_endpoint.Start(metrics_port, RenderMetrics)) {
+      fprintf(stderr, "Error: could not serve metrics on port %s\n",
+          metrics_port);
+      exit(1);
+    }
+    printf("server: metrics on port %s\n", metrics_port);
+  }
 
   printf("server: waiting for connections...\n");
+  fflush(stdout);
 
   running = true;
 
-  fd_set sockets;
-  SocketSet readable_sockets;
-  readable_sockets.insert(server_sockfd);
+  spare_fd = open("/dev/null", O_RDONLY);
+  if(!handshake_poller.IsValid() ||
+      0 != set_nonblocking(server_sockfd) ||
+      0 != handshake_poller.Add(server_sockfd, NULL, true, false)) {
+    fprintf(stderr, "Error: could not watch server socket\n");
+    exit(1);
+  }
+  // Pairs simply keep their beacons on TCP without it
+  if(0 != beacons.Open(port_buffer) ||
+      0 != handshake_poller.Add(beacons.Socket(), &beacons, true, false)) {
+    fprintf(stderr, "Warning: no UDP beacons on port %s\n", port_buffer);
+  }
 
-  ConnectionMapKeyBuffer key_buffer;
-  int rv;
-  struct timeval timeout;
+  RelayPollEvent events[RELAY_POLLER_MAX_EVENTS];
   while(running) {
-    int max_fd = SetupPendingSockets(readable_sockets, sockets);
-    timeout.tv_sec = 15*60;
-    timeout.tv_usec = 0;
-    int num_ready = select(max_fd+1,
-        &sockets,       //Readable set
-        (fd_set*) NULL, //Writable set
-        (fd_set*) NULL, //Exception set
-        &timeout);      //Timeout
-    if (-1 == num_ready) {
-      perror("Select");
-      continue;
-    } else if (0 == num_ready) {
-      // Timeout
-      for(SocketSet::iterator iter = readable_sockets.begin();
-          readable_sockets.end() != iter;
-          ++iter) {
-        if (server_sockfd != *iter) {
-          close(*iter);
-          printf("Closed pending connection\n");
+    int num_ready = handshake_poller.Wait(events, RELAY_POLLER_MAX_EVENTS,
+        1000);
+    time_t now = time(NULL);
+    for(int i = 0; i < num_ready && running; ++i) {
+      if(NULL == events[i].data) {
+        if(!AcceptPendingSockets(now)) {
+          running = false;
         }
-      }
-      readable_sockets.clear();
-      readable_sockets.insert(server_sockfd);
-
-      for(ConnectionMap::iterator iter = connection_map.begin();
-          connection_map.end() != iter;
-          ++iter) {
-        close((*iter).second.sockfd);
-        printf("Deleting key %#llx\n", (*iter).first);
-      }
-
-      connection_map.clear();
-      continue;
-    }
-    int socket = GetReadableSocket(readable_sockets, sockets);
-    if (server_sockfd == socket) {
-      int client_socket = accept_connection(server_sockfd);
-      if(-1 == client_socket) {
-        perror("accept");
-        break;
-      }
-      if (!running) {
-        break;
-      }
-      readable_sockets.insert(client_socket);
-    } else {
-      readable_sockets.erase(socket);
-
-      ConnectionMapKey key;
-      rv = srecv_all(socket, key_buffer, KEY_BUFFER_LENGTH);
-      if(0 != rv) {
-        close(socket);
-        printf("Error: did not receive key\n");
         continue;
       }
-
-      rv = ParseKey(key_buffer, key);
-      if(0 != rv) {
-        close(socket);
-        printf("Error: Cannot parse key\n");
+      if(&beacons == events[i].data) {
+        beacons.Receive(now);
         continue;
       }
-
-      if(0 == key) {
-        do {
-          key = RandomKey();
-        } while(0 == key ||
-            connection_map.find(key) != connection_map.end());
-
-        PrintKey(key, key_buffer);
-        rv = ssend_all(socket, key_buffer, KEY_BUFFER_LENGTH);
-        if(0 != rv) {
-          close(socket);
-          printf("Error: Cannot send key\n");
-          continue;
-        }
-        connection_map.insert(ConnectionMap::value_type(
-              key, PendingSocket(socket)));
-        printf("Inserting with key %#llx\n", key);
-      } else {
-        ConnectionMap::iterator itr = connection_map.find(key);
-        if(itr == connection_map.end()) {
-          close(socket);
-          printf("Error: Cannot find matching socket with key %#llx\n", key);
-          continue;
-        }
-        int first_socket = itr->second.sockfd;
-        connection_map.erase(itr);
-        printf("Matched with key %#llx\n", itr->first);
-
-        key = 0;
-        PrintKey(key, key_buffer);
-        rv = ssend_all(socket, key_buffer, KEY_BUFFER_LENGTH);
-        if(0 != rv) {
-          close(socket);
-          printf("Error: Cannot send 0 key\n");
-          continue;
-        }
-
-        ConnectionPairReady(first_socket, socket);
+      Handshake* handshake = static_cast<Handshake*>(events[i].data);
+      if(HANDSHAKE_DONE == handshake->state ||
+          HANDSHAKE_FAILED == handshake->state) {
+        continue;  // finished earlier in this batch
+      }
+      if(HANDSHAKE_PROXYING == handshake->state && events[i].hangup) {
+        handshake->state = HANDSHAKE_FAILED;  // gave up while we proxied
       }
+      ProgressHandshake(handshake,
+          events[i].readable || events[i].hangup, events[i].writable, now);
+    }
+    ExpireHandshakes(now);
+    for(size_t i = 0; i < finished_handshakes.size(); ++i) {
+      delete finished_handshakes[i];
+    }
+    finished_handshakes.clear();
+
+    if(accept_paused && now >= accept_resume) {
+      accept_paused = 0 != handshake_poller.Add(server_sockfd, NULL,
+          true, false);
+      accept_resume = now + ACCEPT_PAUSE;
     }
+    ExpirePendingHosts(now);
+    ResumeSessions(now);
+    sessions.Expire(now);
+    beacons.Expire(now);
+
+    metrics.pending_keys = connection_map.Size();
+    metrics.handshakes = handshakes.size();
+    metrics.Tick(now, worker_pool.Bytes());
   }
 
+  metrics_endpoint.Stop();
+  worker_pool.Stop();
+  party_hub.Stop();
+  stream_hub.Stop();
+  relay_log.Stop();
   printf("Exiting...\n");
 
   return 0;
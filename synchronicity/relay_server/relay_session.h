@@ -0,0 +1,303 @@
+#ifndef _RELAY_SESSION_H_
+#define _RELAY_SESSION_H_
+
+#include <sched.h>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <map>
+#include <set>
+#include <vector>
+
+#include "connection_map.h"
+#include "relay_log.h"
+
+// A pair may outlive its TCP connections for a grace period, so peers
+// on flaky networks resume it instead of exchanging keys again.
+//
+// A host or client that sends SESSION_OPEN_KEY before its usual key
+// gets its usual reply followed by a session token of its own, 0 if
+// the pair cannot be resumed (the other side did not ask, a party, a
+// key of another node). Once paired, the session lives as long as the
+// pair, then for the grace period if the pair broke on an error rather
+// than because a side closed its connection.
+//
+// A peer whose connection broke sends SESSION_RESUME_KEY then its
+// token and gets 0 back, or SESSION_UNKNOWN if there is nothing to
+// resume. Its socket then waits for the other side to come back too,
+// and both are relayed again. Nothing that was on its way is replayed,
+// the peers start their byte streams anew.
+//
+// A resume while the old pair is still relayed (a peer moved to
+// another network before the relay noticed) cuts the old pair. Pairs
+// that break with a session to resume are reset rather than closed,
+// so the remaining peer can tell them from a peer that left.
+#define SESSION_OPEN_KEY 2
+#define SESSION_RESUME_KEY 3
+#define SESSION_UNKNOWN 1  // reply to a resume
+#define DEFAULT_SESSION_GRACE 60
+#define SESSION_SWEEP_INTERVAL 10
+
+// A session is shared with the worker relaying its pair, which only
+// ever moves it out of SESSION_PAIRED; everything else happens on the
+// accepting thread.
+enum SessionState {
+  SESSION_PENDING = 0,  // the host waits for its client
+  SESSION_PAIRED,       // a worker relays the pair
+  SESSION_KICKING,      // a side resumed, sockfd are being shut down
+  SESSION_KICKED,       // the worker has yet to notice
+  SESSION_BROKEN,       // the sides may resume until broken_at + grace
+  SESSION_ENDED,        // a side closed its connection
+};
+
+struct RelaySession {
+  ConnectionMapKey key;
+  ConnectionMapKey token[2];  // host, client
+  int sockfd[2];              // of the pair a worker relays
+  int waiting[2];             // sockets of sides that resumed, or -1
+  time_t deadline;            // of the host while pending
+  volatile int state;
+  volatile time_t broken_at;
+
+  explicit RelaySession(ConnectionMapKey key)
+    : key(key),
+      deadline(0),
+      state(SESSION_PENDING),
+      broken_at(0) {
+    token[0] = token[1] = 0;
+    sockfd[0] = sockfd[1] = -1;
+    waiting[0] = waiting[1] = -1;
+  }
+};
+
+// The worker gives the pair of session up, clean if a side closed its
+// connection. Returns true if the sides may resume, the sockets should
+// then be reset. The session must not be touched after this.
+bool SessionBreak(RelaySession* session, bool clean) {
+  for (;;) {
+    int state = session->state;
+    if (SESSION_KICKING == state) {
+      sched_yield();  // shutdown() of our sockets is under way
+      continue;
+    }
+    int next = clean && SESSION_PAIRED == state ?
+      SESSION_ENDED : SESSION_BROKEN;
+    session->broken_at = time(NULL);
+    if (__sync_bool_compare_and_swap(&session->state, state, next)) {
+      return SESSION_BROKEN == next;
+    }
+  }
+}
+
+// Close with a reset instead of an orderly shutdown
+void reset_on_close(int sockfd) {
+  struct linger linger;
+  linger.l_onoff = 1;
+  linger.l_linger = 0;
+  setsockopt(sockfd, SOL_SOCKET, SO_LINGER, &linger, sizeof(linger));
+}
+
+// Sessions by key and by token. Only used by the accepting thread.
+class RelaySessions {
+ public:
+  RelaySessions() : grace(DEFAULT_SESSION_GRACE), last_sweep(0) {
+  }
+
+  ~RelaySessions() {
+    while (!by_key.empty()) {
+      Free(by_key.begin()->second);
+    }
+  }
+
+  void SetGrace(time_t seconds) { grace = seconds; }
+
+  // A host asked for a session under the key it was given. Returns its
+  // token.
+  ConnectionMapKey Open(ConnectionMapKey key, time_t deadline) {
+    if (by_key.count(key)) {
+      return 0;
+    }
+    RelaySession* session = new RelaySession(key);
+    session->deadline = deadline;
+    by_key[key] = session;
+    session->token[0] = NewToken(session);
+    return session->token[0];
+  }
+
+  // The host of key waits until deadline, after a client failed maybe
+  void Pending(ConnectionMapKey key, time_t deadline) {
+    RelaySession* session = Find(key);
+    if (NULL != session && SESSION_PENDING == session->state) {
+      session->deadline = deadline;
+    }
+  }
+
+  // A client that asked for a session matched the host of key. Returns
+  // its token, 0 if the host did not ask for one.
+  ConnectionMapKey Join(ConnectionMapKey key) {
+    RelaySession* session = Find(key);
+    if (NULL == session || SESSION_PENDING != session->state) {
+      return 0;
+    }
+    if (0 != session->token[1]) {
+      by_token.erase(session->token[1]);  // of a client that failed
+    }
+    session->token[1] = NewToken(session);
+    return session->token[1];
+  }
+
+  // The host of key is relayed with a client. Returns the session to
+  // hand to the worker, NULL if the pair cannot be resumed.
+  RelaySession* Paired(ConnectionMapKey key, int host_sockfd,
+      int client_sockfd) {
+    RelaySession* session = Find(key);
+    if (NULL == session || SESSION_PENDING != session->state) {
+      return NULL;
+    }
+    if (0 == session->token[1]) {
+      Free(session);  // the client cannot resume, the host alone is no use
+      return NULL;
+    }
+    session->sockfd[0] = host_sockfd;
+    session->sockfd[1] = client_sockfd;
+    session->state = SESSION_PAIRED;
+    return session;
+  }
+
+  // The host of key went away before its client came
+  void Drop(ConnectionMapKey key) {
+    RelaySession* session = Find(key);
+    if (NULL != session && SESSION_PENDING == session->state) {
+      Free(session);
+    }
+  }
+
+  // Whether token names a session that may still be resumed
+  bool Knows(ConnectionMapKey token) {
+    std::map<ConnectionMapKey, RelaySession*>::iterator itr =
+      by_token.find(token);
+    if (itr == by_token.end()) {
+      return false;
+    }
+    int state = itr->second->state;
+    return SESSION_PENDING != state && SESSION_ENDED != state;
+  }
+
+  // The side of token came back on sockfd, which the sessions own from
+  // then on. Cuts the old pair if a worker still relays it. Returns
+  // false if there is nothing to resume, the socket is the caller's.
+  bool Resume(ConnectionMapKey token, int sockfd) {
+    if (!Knows(token)) {
+      return false;
+    }
+    RelaySession* session = by_token[token];
+    int side = token == session->token[0] ? 0 : 1;
+    if (-1 != session->waiting[side]) {
+      close(session->waiting[side]);  // an earlier attempt of that side
+    }
+    session->waiting[side] = sockfd;
+    resuming.insert(session);
+    if (__sync_bool_compare_and_swap(&session->state, SESSION_PAIRED,
+          SESSION_KICKING)) {
+      // The worker sees both ends closing and breaks the pair
+      shutdown(session->sockfd[0], SHUT_RD);
+      shutdown(session->sockfd[1], SHUT_RD);
+      __sync_bool_compare_and_swap(&session->state, SESSION_KICKING,
+          SESSION_KICKED);
+    }
+    return true;
+  }
+
+  // Sessions both sides resumed and whose old pair is gone, with their
+  // sockets (host, client) to relay again
+  void Ready(std::vector<RelaySession*>& ready) {
+    std::set<RelaySession*>::iterator itr = resuming.begin();
+    while (itr != resuming.end()) {
+      RelaySession* session = *itr;
+      if (SESSION_BROKEN == session->state &&
+          -1 != session->waiting[0] && -1 != session->waiting[1]) {
+        session->sockfd[0] = session->waiting[0];
+        session->sockfd[1] = session->waiting[1];
+        session->waiting[0] = session->waiting[1] = -1;
+        session->state = SESSION_PAIRED;
+        ready.push_back(session);
+        resuming.erase(itr++);
+      } else {
+        ++itr;
+      }
+    }
+  }
+
+  // Forget sessions that ended, whose grace period is over or whose
+  // host never got a client. Sockets still waiting are closed, which
+  // tells the peer the other side is not coming back.
+  void Expire(time_t now) {
+    if (now - last_sweep < SESSION_SWEEP_INTERVAL) {
+      return;
+    }
+    last_sweep = now;
+    std::vector<RelaySession*> expired;
+    std::map<ConnectionMapKey, RelaySession*>::iterator itr;
+    for (itr = by_key.begin(); itr != by_key.end(); ++itr) {
+      RelaySession* session = itr->second;
+      int state = session->state;
+      __sync_synchronize();  // broken_at was set before the state
+      if (SESSION_ENDED == state ||
+          (SESSION_BROKEN == state && now - session->broken_at > grace) ||
+          (SESSION_PENDING == state && now > session->deadline)) {
+        expired.push_back(session);
+      }
+    }
+    for (size_t i = 0; i < expired.size(); ++i) {
+      relay_log.Log(LOG_SESSION_OVER, expired[i]->key);
+      Free(expired[i]);
+    }
+  }
+
+  size_t Size() const { return by_key.size(); }
+
+ private:
+  RelaySession* Find(ConnectionMapKey key) {
+    std::map<ConnectionMapKey, RelaySession*>::iterator itr =
+      by_key.find(key);
+    return itr == by_key.end() ? NULL : itr->second;
+  }
+
+  ConnectionMapKey NewToken(RelaySession* session) {
+    ConnectionMapKey token;
+    do {
+      token = RandomKey();
+    } while (0 == token || by_token.count(token));
+    by_token[token] = session;
+    return token;
+  }
+
+  // Only for sessions no worker relays
+  void Free(RelaySession* session) {
+    for (int side = 0; side < 2; ++side) {
+      if (-1 != session->waiting[side]) {
+        close(session->waiting[side]);
+      }
+      if (0 != session->token[side]) {
+        by_token.erase(session->token[side]);
+      }
+    }
+    resuming.erase(session);
+    by_key.erase(session->key);
+    delete session;
+  }
+
+  std::map<ConnectionMapKey, RelaySession*> by_key;
+  std::map<ConnectionMapKey, RelaySession*> by_token;
+  std::set<RelaySession*> resuming;  // some side is waiting
+  time_t grace;
+  time_t last_sweep;
+
+  // not copyable
+  RelaySessions(const RelaySessions&);
+  RelaySessions& operator=(const RelaySessions&);
+};
+
+#endif  // _RELAY_SESSION_H_
@@ -0,0 +1,414 @@
+#ifndef _RELAY_STREAM_H_
+#define _RELAY_STREAM_H_
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "connection_map.h"
+#include "relay_common.h"
+#include "relay_hub.h"
+#include "relay_log.h"
+#include "relay_poller.h"
+
+// A host may stream its media to the peers that joined its key. It
+// sends STREAM_SOURCE_KEY then its key, each peer STREAM_SINK_KEY then
+// the same key, and both get 0 back, or STREAM_REFUSED if the key is
+// not one of this node's. The source then sends frames, every sink
+// gets a copy of each frame as is:
+//   32 bit payload length, 64 bit host date, big endian, then the
+//   payload, at most STREAM_MAX_PAYLOAD bytes
+// Sinks send nothing.
+//
+// A frame is read once into a segment that every sink's queue shares.
+// The source is never slowed down: a sink that falls more than
+// STREAM_MAX_BACKLOG behind skips the segments it has not started and
+// goes on from the newest one. Sinks may come before the source and
+// outlive it, a host that plays its next item opens a new source on
+// the same key; sinks wait STREAM_IDLE_TIMEOUT for one.
+#define STREAM_SOURCE_KEY 4
+#define STREAM_SINK_KEY 5
+#define STREAM_REFUSED 1
+
+#define STREAM_FRAME_HEADER 12
+#define STREAM_MAX_PAYLOAD (1 << 20)
+#define STREAM_MAX_BACKLOG (4 << 20)
+#define STREAM_IDLE_TIMEOUT 60
+#define STREAM_READ_SIZE 65536
+#define STREAM_POLL_TIMEOUT_MS 1000
+
+// One frame, header included, shared by the queues it is in
+struct StreamSegment {
+  int refs;
+  std::string data;
+
+  StreamSegment() : refs(1) {
+  }
+};
+
+void SegmentRelease(StreamSegment* segment) {
+  if (0 == --segment->refs) {
+    delete segment;
+  }
+}
+
+// Segments on their way to one sink, the first one from offset on
+class StreamQueue {
+ public:
+  StreamQueue() : offset(0), backlog(0), skipped(0) {
+  }
+
+  ~StreamQueue() {
+    while (!segments.empty()) {
+      Pop();
+    }
+  }
+
+  // Takes a reference to segment. A queue too far behind first drops
+  // what the sink has not started, so that it never gets part of a
+  // frame. Returns the number of segments dropped.
+  size_t Push(StreamSegment* segment) {
+    size_t dropped = 0;
+    if (backlog + segment->data.size() > STREAM_MAX_BACKLOG) {
+      size_t keep = 0 < offset ? 1 : 0;
+      while (segments.size() > keep) {
+        StreamSegment* last = segments.back();
+        backlog -= last->data.size();
+        segments.pop_back();
+        SegmentRelease(last);
+        ++dropped;
+      }
+      skipped += dropped;
+    }
+    ++segment->refs;
+    segments.push_back(segment);
+    backlog += segment->data.size();
+    return dropped;
+  }
+
+  // What to send next, NULL if nothing
+  const char* Data() const {
+    return segments.empty() ? NULL : segments.front()->data.data() + offset;
+  }
+
+  size_t Available() const {
+    return segments.empty() ? 0 : segments.front()->data.size() - offset;
+  }
+
+  // length bytes of Data() went out
+  void Consumed(size_t length) {
+    offset += length;
+    backlog -= length;
+    if (!segments.empty() && offset == segments.front()->data.size()) {
+      offset = 0;
+      Pop();
+    }
+  }
+
+  size_t Backlog() const { return backlog; }
+  size_t Size() const { return segments.size(); }
+  unsigned long Skipped() const { return skipped; }
+
+ private:
+  void Pop() {
+    StreamSegment* first = segments.front();
+    segments.pop_front();
+    if (0 != offset) {
+      backlog -= first->data.size() - offset;
+      offset = 0;
+    }
+    SegmentRelease(first);
+  }
+
+  std::deque<StreamSegment*> segments;
+  size_t offset;   // into the first segment
+  size_t backlog;  // bytes left to send
+  unsigned long skipped;
+
+  // not copyable
+  StreamQueue(const StreamQueue&);
+  StreamQueue& operator=(const StreamQueue&);
+};
+
+struct RelayStream;
+
+// A socket passed from the accepting thread to the hub
+struct StreamHandoff {
+  ConnectionMapKey key;
+  int sockfd;
+  bool source;
+};
+
+// One socket of a stream; the poller hands these back to us
+struct StreamEndpoint {
+  RelayStream* stream;
+  int sockfd;
+  bool source;
+  StreamQueue queue;  // sinks: towards sockfd
+  std::string in;     // source: partial frame
+
+  StreamEndpoint(RelayStream* stream, int sockfd, bool source)
+    : stream(stream), sockfd(sockfd), source(source) {
+  }
+};
+
+struct RelayStream {
+  ConnectionMapKey key;
+  StreamEndpoint* source;  // NULL between sources
+  std::set<StreamEndpoint*> sinks;
+  time_t idle_since;       // without a source
+
+  RelayStream(ConnectionMapKey key, time_t now)
+    : key(key), source(NULL), idle_since(now) {
+  }
+};
+
+// The streams of this relay, driven by a hub of their own so that
+// media never holds up pairs or parties.
+class RelayStreamHub : public RelayHub<StreamHandoff> {
+ public:
+  RelayStreamHub() : RelayHub<StreamHandoff>(STREAM_POLL_TIMEOUT_MS) {
+  }
+
+  ~RelayStreamHub() {
+    Stop();
+  }
+
+  // Called from the accepting thread, the hub owns sockfd afterwards.
+  // Returns 0 on success.
+  int Add(ConnectionMapKey key, int sockfd, bool source) {
+    StreamHandoff message;
+    message.key = key;
+    message.sockfd = sockfd;
+    message.source = source;
+    return Handoff(message);
+  }
+
+ private:
+  void Accept(const StreamHandoff& message) {
+    if (0 != set_nonblocking(message.sockfd)) {
+      close(message.sockfd);
+      return;
+    }
+    time_t now = time(NULL);
+    RelayStream*& stream = streams[message.key];
+    if (NULL == stream) {
+      stream = new RelayStream(message.key, now);
+    }
+    StreamEndpoint* endpoint =
+      new StreamEndpoint(stream, message.sockfd, message.source);
+    if (0 != poller.Add(message.sockfd, endpoint, true, false)) {
+      close(message.sockfd);
+      delete endpoint;
+      ForgetIfEmpty(stream);
+      return;
+    }
+    if (!message.source) {
+      stream->sinks.insert(endpoint);
+      relay_log.Log(LOG_STREAM_SINK_JOINED, stream->key);
+      return;
+    }
+    StreamEndpoint* previous = stream->source;
+    stream->source = endpoint;
+    if (NULL != previous) {
+      // The host went on to another item before we saw it leave
+      CloseEndpoint(previous, now);
+    }
+    relay_log.Log(LOG_STREAM_SOURCE_UP, stream->key);
+  }
+
+  void Dispatch(const RelayPollEvent& event) {
+    StreamEndpoint* endpoint = static_cast<StreamEndpoint*>(event.data);
+    if (-1 == endpoint->sockfd) {
+      return;  // closed earlier in this batch
+    }
+    bool ok = true;
+    if (event.writable) {
+      ok = Flush(endpoint);
+    }
+    if (ok && (event.readable || event.hangup)) {
+      ok = endpoint->source ? ReadSource(endpoint) : ReadSink(endpoint);
+    }
+    if (!ok) {
+      CloseEndpoint(endpoint, time(NULL));
+    }
+  }
+
+  void AfterBatch() {
+    ExpireIdle(time(NULL));
+  }
+
+  void FreeClosed() {
+    for (size_t i = 0; i < closed.size(); ++i) {
+      delete closed[i];
+    }
+    closed.clear();
+  }
+
+  void Discard(const StreamHandoff& message) {
+    close(message.sockfd);
+  }
+
+  // Closing the last endpoint of a stream frees it
+  void CloseAll() {
+    std::vector<StreamEndpoint*> open;
+    std::map<ConnectionMapKey, RelayStream*>::iterator itr;
+    for (itr = streams.begin(); itr != streams.end(); ++itr) {
+      if (NULL != itr->second->source) {
+        open.push_back(itr->second->source);
+      }
+      open.insert(open.end(), itr->second->sinks.begin(),
+          itr->second->sinks.end());
+    }
+    time_t now = time(NULL);
+    for (size_t i = 0; i < open.size(); ++i) {
+      CloseEndpoint(open[i], now);
+    }
+  }
+
+  // Frames from the source, each copied to every sink
+  bool ReadSource(StreamEndpoint* source) {
+    char buffer[STREAM_READ_SIZE];
+    int rv = recv(source->sockfd, buffer, sizeof(buffer), 0);
+    if (rv < 0) {
+      return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+    if (rv == 0) {
+      return false;
+    }
+    source->in.append(buffer, rv);
+
+    RelayStream* stream = source->stream;
+    size_t at = 0;
+    while (source->in.size() - at >= STREAM_FRAME_HEADER) {
+      const unsigned char* header =
+        reinterpret_cast<const unsigned char*>(source->in.data() + at);
+      size_t length = ((uint32_t)header[0] << 24) | (header[1] << 16) |
+        (header[2] << 8) | header[3];
+      if (length > STREAM_MAX_PAYLOAD) {
+        relay_log.Log(LOG_STREAM_BAD_FRAME, stream->key, length);
+        return false;
+      }
+      if (source->in.size() - at < STREAM_FRAME_HEADER + length) {
+        break;
+      }
+      StreamSegment* segment = new StreamSegment();
+      segment->data.assign(source->in, at, STREAM_FRAME_HEADER + length);
+      at += STREAM_FRAME_HEADER + length;
+
+      std::vector<StreamEndpoint*> sinks(stream->sinks.begin(),
+          stream->sinks.end());
+      for (size_t i = 0; i < sinks.size(); ++i) {
+        if (0 != sinks[i]->queue.Push(segment)) {
+          relay_log.Log(LOG_STREAM_SINK_BEHIND, stream->key);
+        }
+        if (!Flush(sinks[i])) {
+          CloseEndpoint(sinks[i], time(NULL));
+        }
+      }
+      SegmentRelease(segment);
+    }
+    source->in.erase(0, at);
+    return true;
+  }
+
+  // Sinks only ever close their end
+  bool ReadSink(StreamEndpoint* sink) {
+    char buffer[256];
+    int rv = recv(sink->sockfd, buffer, sizeof(buffer), 0);
+    if (rv < 0) {
+      return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+    return rv > 0;
+  }
+
+  // Send what the socket takes and update interest. Returns false on
+  // error.
+  bool Flush(StreamEndpoint* sink) {
+    StreamQueue& queue = sink->queue;
+    while (queue.Available() > 0) {
+      int rv = send(sink->sockfd, queue.Data(), queue.Available(),
+          MSG_NOSIGNAL);
+      if (rv < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+          break;
+        }
+        return false;
+      }
+      queue.Consumed(rv);
+    }
+    poller.Modify(sink->sockfd, sink, true, queue.Backlog() > 0);
+    return true;
+  }
+
+  void CloseEndpoint(StreamEndpoint* endpoint, time_t now) {
+    if (-1 == endpoint->sockfd) {
+      return;
+    }
+    RelayStream* stream = endpoint->stream;
+    poller.Remove(endpoint->sockfd);
+    close(endpoint->sockfd);
+    endpoint->sockfd = -1;
+    closed.push_back(endpoint);
+    if (endpoint->source) {
+      if (stream->source == endpoint) {
+        stream->source = NULL;
+        stream->idle_since = now;
+      }
+      relay_log.Log(LOG_STREAM_SOURCE_LEFT, stream->key);
+    } else {
+      stream->sinks.erase(endpoint);
+      relay_log.Log(LOG_STREAM_SINK_LEFT, stream->key,
+          endpoint->queue.Skipped());
+    }
+    ForgetIfEmpty(stream);
+  }
+
+  // Sinks give up on a source that does not come (back)
+  void ExpireIdle(time_t now) {
+    std::vector<RelayStream*> idle;
+    std::map<ConnectionMapKey, RelayStream*>::iterator itr;
+    for (itr = streams.begin(); itr != streams.end(); ++itr) {
+      if (NULL == itr->second->source &&
+          now - itr->second->idle_since > STREAM_IDLE_TIMEOUT) {
+        idle.push_back(itr->second);
+      }
+    }
+    for (size_t i = 0; i < idle.size(); ++i) {
+      relay_log.Log(LOG_STREAM_IDLE, idle[i]->key);
+      // Closing the last sink frees the stream
+      for (size_t left = idle[i]->sinks.size(); left > 0; --left) {
+        CloseEndpoint(*idle[i]->sinks.begin(), now);
+      }
+    }
+  }
+
+  void ForgetIfEmpty(RelayStream* stream) {
+    if (NULL == stream->source && stream->sinks.empty()) {
+      streams.erase(stream->key);
+      delete stream;
+    }
+  }
+
+  std::map<ConnectionMapKey, RelayStream*> streams;  // hub thread only
+  std::vector<StreamEndpoint*> closed;
+
+  // not copyable
+  RelayStreamHub(const RelayStreamHub&);
+  RelayStreamHub& operator=(const RelayStreamHub&);
+};
+
+#endif  // _RELAY_STREAM_H_
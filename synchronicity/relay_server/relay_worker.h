@@ -0,0 +1,494 @@
+#ifndef _RELAY_WORKER_H_
+#define _RELAY_WORKER_H_
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <set>
+#include <vector>
+
+#if defined(__linux__)
+#define RELAY_HAVE_SPLICE 1
+#endif
+
+#include "relay_common.h"
+#include "relay_hub.h"
+#include "relay_limits.h"
+#include "relay_log.h"
+#include "relay_poller.h"
+#include "relay_session.h"
+
+#define RELAY_BUFFER_SIZE 10240
+#define RELAY_SPLICE_SIZE 65536
+#define RELAY_WORKER_POLL_TIMEOUT_MS 1000
+// How often a worker looks whether throttled pairs may go on
+#define RELAY_THROTTLE_POLL_MS 10
+
+struct RelayPair;
+
+// Bytes read from one socket of the pair and not yet written to the other.
+// With splice() the bytes sit in a kernel pipe and never reach user
+// space; otherwise they go through a buffer allocated on first use.
+// A direction that used up its bucket is not read until it refills.
+struct RelayDirection {
+  int pipe_fd[2];
+  int pending;  // bytes queued in the pipe
+  char* buffer;
+  int start;
+  int end;
+  TokenBucket bucket;
+  bool throttled;
+
+  RelayDirection()
+    : pending(0), buffer(NULL), start(0), end(0), throttled(false) {
+    pipe_fd[0] = pipe_fd[1] = -1;
+  }
+
+  ~RelayDirection() {
+    ClosePipe();
+    delete[] buffer;
+  }
+
+  bool Empty() const { return pending == 0 && start == end; }
+
+  bool Spliced() const { return pipe_fd[0] != -1; }
+
+  // Returns 0 if the direction now relays through a pipe
+  int OpenPipe() {
+#if defined(RELAY_HAVE_SPLICE)
+    if (pipe2(pipe_fd, O_NONBLOCK) == -1) {
+      pipe_fd[0] = pipe_fd[1] = -1;
+      return 1;
+    }
+    return 0;
+#else
+    return 1;
+#endif
+  }
+
+  void ClosePipe() {
+    if (pipe_fd[0] != -1) {
+      close(pipe_fd[0]);
+      close(pipe_fd[1]);
+      pipe_fd[0] = pipe_fd[1] = -1;
+    }
+  }
+
+  char* Buffer() {
+    if (NULL == buffer) {
+      buffer = new char[RELAY_BUFFER_SIZE];
+    }
+    return buffer;
+  }
+};
+
+// One socket of a pair, this is what the poller hands back to us
+struct RelayEndpoint {
+  RelayPair* pair;
+  int side;
+  int sockfd;
+};
+
+// Two paired sockets. direction[i] holds data flowing out of
+// endpoint[i] towards endpoint[1 - i].
+struct RelayPair {
+  RelayEndpoint endpoint[2];
+  RelayDirection direction[2];
+  RelaySession* session;  // if the pair may be resumed
+  bool clean;             // a side closed its connection
+  bool was_throttled;     // logged once per pair
+
+  RelayPair(int sockfd1, int sockfd2, RelaySession* session)
+    : session(session), clean(false), was_throttled(false) {
+    endpoint[0].pair = this;
+    endpoint[0].side = 0;
+    endpoint[0].sockfd = sockfd1;
+    endpoint[1].pair = this;
+    endpoint[1].side = 1;
+    endpoint[1].sockfd = sockfd2;
+  }
+};
+
+// A hub over the pairs assigned to it, several of them make up a
+// RelayWorkerPool.
+class RelayWorker : public RelayHub<RelayPair*> {
+ public:
+  RelayWorker()
+    : RelayHub<RelayPair*>(RELAY_WORKER_POLL_TIMEOUT_MS),
+      num_pairs(0), num_throttled(0), bytes(0), use_splice(false), rate(0),
+      burst(0) {
+  }
+
+  ~RelayWorker() {
+    Stop();
+  }
+
+  // Each direction of a pair gets rate bytes per second, burst at once,
+  // rate 0 for no limit
+  int Start(bool splice, long bytes_per_second = 0, long burst_bytes = 0) {
+    use_splice = splice;
+    rate = bytes_per_second;
+    burst = burst_bytes;
+    return RelayHub<RelayPair*>::Start();
+  }
+
+  // Called from the accepting thread. Ownership of both sockets passes
+  // to the worker, the session is broken when the pair closes. Returns
+  // 0 on success.
+  int Assign(int sockfd1, int sockfd2, RelaySession* session) {
+    RelayPair* pair = new RelayPair(sockfd1, sockfd2, session);
+    __sync_fetch_and_add(&num_pairs, 1);
+    if (0 != Handoff(pair)) {
+      __sync_fetch_and_sub(&num_pairs, 1);
+      delete pair;
+      return 1;
+    }
+    return 0;
+  }
+
+  int NumPairs() const { return num_pairs; }
+
+  int NumThrottled() const { return num_throttled; }
+
+  // Bytes read from the sockets of the pairs so far
+  unsigned long long Bytes() { return __sync_fetch_and_add(&bytes, 0); }
+
+ private:
+  void Accept(RelayPair* const& pair) {
+    uint64_t now_ms = relay_now_ms();
+    pair->direction[0].bucket.Init(rate, burst, now_ms);
+    pair->direction[1].bucket.Init(rate, burst, now_ms);
+    bool ok = true;
+    for (int side = 0; side < 2 && ok; ++side) {
+      ok = 0 == set_nonblocking(pair->endpoint[side].sockfd) &&
+          0 == poller.Add(pair->endpoint[side].sockfd,
+              &pair->endpoint[side], true, false);
+    }
+    for (int side = 0; side < 2 && ok && use_splice; ++side) {
+      if (0 != pair->direction[side].OpenPipe()) {
+        // Out of descriptors most likely, copying still works
+        pair->direction[0].ClosePipe();
+        break;
+      }
+    }
+    if (!ok) {
+      ClosePair(pair);
+      delete pair;
+      return;
+    }
+    pairs.insert(pair);
+  }
+
+  void Dispatch(const RelayPollEvent& event) {
+    RelayEndpoint* endpoint = static_cast<RelayEndpoint*>(event.data);
+    RelayPair* pair = endpoint->pair;
+    if (pair->endpoint[0].sockfd == -1) {
+      return;  // already closed during this batch
+    }
+    bool ok = true;
+    if (event.writable) {
+      ok = Flush(pair, 1 - endpoint->side);
+    }
+    if (ok && (event.readable || event.hangup)) {
+      ok = Relay(pair, endpoint->side, event.hangup);
+    }
+    if (!ok) {
+      ClosePair(pair);
+      closed.push_back(pair);
+    }
+  }
+
+  int PollTimeoutMs() {
+    return throttled.empty() ? RELAY_WORKER_POLL_TIMEOUT_MS :
+        RELAY_THROTTLE_POLL_MS;
+  }
+
+  void AfterBatch() {
+    Unthrottle();
+  }
+
+  void FreeClosed() {
+    for (size_t i = 0; i < closed.size(); ++i) {
+      delete closed[i];
+    }
+    closed.clear();
+  }
+
+  void Discard(RelayPair* const& pair) {
+    ClosePair(pair);
+    delete pair;
+  }
+
+  void CloseAll() {
+    while (!pairs.empty()) {
+      RelayPair* pair = *pairs.begin();
+      ClosePair(pair);
+      closed.push_back(pair);
+    }
+    throttled.clear();
+    num_throttled = 0;
+  }
+
+  // Read what we can from side and push it to the other side. A side
+  // that hung up is read regardless of its bucket, to see it close.
+  bool Relay(RelayPair* pair, int side, bool hangup) {
+    RelayDirection& direction = pair->direction[side];
+    if (!direction.Empty()) {
+      // still waiting for the peer to drain, unless this side is gone
+      return !hangup;
+    }
+    long allowed = direction.bucket.Allow(
+        direction.Spliced() ? RELAY_SPLICE_SIZE : RELAY_BUFFER_SIZE,
+        relay_now_ms());
+    if (0 == allowed && !hangup) {
+      Throttle(pair, side);
+      return true;
+    }
+    if (0 == allowed) {
+      allowed = RELAY_BUFFER_SIZE;
+    }
+    int rv;
+#if defined(RELAY_HAVE_SPLICE)
+    if (direction.Spliced()) {
+      rv = splice(pair->endpoint[side].sockfd, NULL,
+          direction.pipe_fd[1], NULL, allowed,
+          SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+      if (rv < 0 && errno == EINVAL) {
+        // Socket type the kernel cannot splice, fall back to copying
+        direction.ClosePipe();
+      } else if (rv > 0) {
+        Count(direction, rv);
+        direction.pending = rv;
+        return Flush(pair, side);
+      }
+    }
+    if (!direction.Spliced())
+#endif
+    {
+      rv = recv(pair->endpoint[side].sockfd, direction.Buffer(),
+          allowed < RELAY_BUFFER_SIZE ? allowed : RELAY_BUFFER_SIZE, 0);
+      if (rv > 0) {
+        Count(direction, rv);
+        direction.start = 0;
+        direction.end = rv;
+        return Flush(pair, side);
+      }
+    }
+    if (rv == 0) {
+      relay_log.Log(LOG_PAIR_CLOSED);
+      pair->clean = true;
+      return false;
+    }
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+  }
+
+  // Write buffered data of direction[side] to the opposite socket and
+  // update interest so a slow reader throttles the fast writer.
+  bool Flush(RelayPair* pair, int side) {
+    RelayDirection& direction = pair->direction[side];
+    int to = 1 - side;
+#if defined(RELAY_HAVE_SPLICE)
+    while (direction.pending > 0) {
+      int rv = splice(direction.pipe_fd[0], NULL,
+          pair->endpoint[to].sockfd, NULL, direction.pending,
+          SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+      if (rv < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+          break;
+        }
+        return false;
+      }
+      direction.pending -= rv;
+    }
+#endif
+    while (direction.start != direction.end) {
+      int rv = send(pair->endpoint[to].sockfd,
+          direction.buffer + direction.start,
+          direction.end - direction.start, MSG_NOSIGNAL);
+      if (rv < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+          break;
+        }
+        return false;
+      }
+      direction.start += rv;
+    }
+    UpdateInterest(pair, side);
+    UpdateInterest(pair, to);
+    return true;
+  }
+
+  void Count(RelayDirection& direction, int read) {
+    direction.bucket.Spend(read);
+    __sync_fetch_and_add(&bytes, read);
+  }
+
+  // Stop reading side until its bucket refills
+  void Throttle(RelayPair* pair, int side) {
+    if (!pair->direction[0].throttled && !pair->direction[1].throttled) {
+      throttled.push_back(pair);
+      num_throttled = throttled.size();
+    }
+    pair->direction[side].throttled = true;
+    if (!pair->was_throttled) {
+      pair->was_throttled = true;
+      relay_log.Log(LOG_PAIR_THROTTLED, rate);
+    }
+    UpdateInterest(pair, side);
+  }
+
+  // Read again from the throttled directions whose bucket refilled.
+  // Pairs closed during the batch are dropped, they are about to be
+  // freed.
+  void Unthrottle() {
+    if (throttled.empty()) {
+      return;
+    }
+    uint64_t now_ms = relay_now_ms();
+    size_t kept = 0;
+    for (size_t i = 0; i < throttled.size(); ++i) {
+      RelayPair* pair = throttled[i];
+      if (pair->endpoint[0].sockfd == -1) {
+        continue;
+      }
+      for (int side = 0; side < 2; ++side) {
+        RelayDirection& direction = pair->direction[side];
+        if (direction.throttled && direction.bucket.Allow(1, now_ms) > 0) {
+          direction.throttled = false;
+          UpdateInterest(pair, side);
+        }
+      }
+      if (pair->direction[0].throttled || pair->direction[1].throttled) {
+        throttled[kept++] = pair;
+      }
+    }
+    throttled.resize(kept);
+    num_throttled = kept;
+  }
+
+  // Read from a socket only while its outgoing buffer is empty and its
+  // bucket has some bytes left, and ask for writability only while data
+  // is queued towards it.
+  void UpdateInterest(RelayPair* pair, int side) {
+    bool want_read = pair->direction[side].Empty() &&
+        !pair->direction[side].throttled;
+    bool want_write = !pair->direction[1 - side].Empty();
+    poller.Modify(pair->endpoint[side].sockfd, &pair->endpoint[side],
+        want_read, want_write);
+  }
+
+  // A pair that may be resumed is reset, so the side left knows to
+  void ClosePair(RelayPair* pair) {
+    bool reset = NULL != pair->session &&
+        SessionBreak(pair->session, pair->clean);
+    for (int side = 0; side < 2; ++side) {
+      poller.Remove(pair->endpoint[side].sockfd);
+      if (reset) {
+        reset_on_close(pair->endpoint[side].sockfd);
+      }
+      close(pair->endpoint[side].sockfd);
+      pair->endpoint[side].sockfd = -1;
+    }
+    pairs.erase(pair);
+    __sync_fetch_and_sub(&num_pairs, 1);
+  }
+
+  volatile int num_pairs;
+  volatile int num_throttled;
+  volatile unsigned long long bytes;
+  bool use_splice;
+  long rate;
+  long burst;
+  std::set<RelayPair*> pairs;  // open ones
+  std::vector<RelayPair*> closed;
+  std::vector<RelayPair*> throttled;  // pairs with a throttled direction
+
+  // not copyable
+  RelayWorker(const RelayWorker&);
+  RelayWorker& operator=(const RelayWorker&);
+};
+
+// Fixed set of workers, each new pair goes to the least loaded one
+class RelayWorkerPool {
+ public:
+  ~RelayWorkerPool() {
+    Stop();
+  }
+
+  // With use_splice, pairs are relayed with splice() where the platform
+  // supports it and with a userspace buffer otherwise. Each direction
+  // of a pair is capped at rate bytes per second, see RelayWorker.
+  int Start(int num_workers, bool use_splice, long rate = 0,
+      long burst = 0) {
+    for (int i = 0; i < num_workers; ++i) {
+      RelayWorker* worker = new RelayWorker();
+      if (worker->Start(use_splice, rate, burst) != 0) {
+        delete worker;
+        Stop();
+        return 1;
+      }
+      workers.push_back(worker);
+    }
+    return 0;
+  }
+
+  void Stop() {
+    for (size_t i = 0; i < workers.size(); ++i) {
+      delete workers[i];  // joins the thread
+    }
+    workers.clear();
+  }
+
+  int Assign(int sockfd1, int sockfd2, RelaySession* session) {
+    if (workers.empty()) {
+      return 1;
+    }
+    RelayWorker* best = workers[0];
+    for (size_t i = 1; i < workers.size(); ++i) {
+      if (workers[i]->NumPairs() < best->NumPairs()) {
+        best = workers[i];
+      }
+    }
+    return best->Assign(sockfd1, sockfd2, session);
+  }
+
+  int NumPairs() const {
+    int total = 0;
+    for (size_t i = 0; i < workers.size(); ++i) {
+      total += workers[i]->NumPairs();
+    }
+    return total;
+  }
+
+  int NumThrottled() const {
+    int total = 0;
+    for (size_t i = 0; i < workers.size(); ++i) {
+      total += workers[i]->NumThrottled();
+    }
+    return total;
+  }
+
+  unsigned long long Bytes() const {
+    unsigned long long total = 0;
+    for (size_t i = 0; i < workers.size(); ++i) {
+      total += workers[i]->Bytes();
+    }
+    return total;
+  }
+
+ private:
+  std::vector<RelayWorker*> workers;
+};
+
+#endif  // _RELAY_WORKER_H_
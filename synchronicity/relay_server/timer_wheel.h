@@ -0,0 +1,78 @@
+#ifndef _TIMER_WHEEL_H_
+#define _TIMER_WHEEL_H_
+
+#include <time.h>
+
+#include <utility>
+#include <vector>
+
+// Hashed timer wheel with one second ticks. Scheduling is O(1) and
+// advancing the clock only touches the slots that went by, so expiring
+// one entry never means walking all of them. Deadlines further away
+// than the wheel is long simply stay in their slot for another lap.
+//
+// Entries cannot be cancelled; the owner is expected to check, when an
+// entry fires, whether it still means anything.
+template <typename T>
+class TimerWheel {
+ public:
+  TimerWheel(size_t num_slots, time_t now)
+    : slots(num_slots), current(now), size(0) {
+  }
+
+  void Schedule(time_t deadline, const T& value) {
+    if (deadline < current) {
+      deadline = current;
+    }
+    slots[deadline % slots.size()].push_back(std::make_pair(deadline, value));
+    ++size;
+  }
+
+  // Move the wheel to now and append everything due to expired
+  void Advance(time_t now, std::vector<T>& expired) {
+    if (now < current) {
+      return;  // clock went backwards, wait for it to catch up
+    }
+    time_t ticks = now - current + 1;
+    if (ticks > (time_t)slots.size()) {
+      ticks = slots.size();
+    }
+    for (time_t tick = 0; tick < ticks; ++tick) {
+      Slot& slot = slots[(current + tick) % slots.size()];
+      size_t kept = 0;
+      for (size_t i = 0; i < slot.size(); ++i) {
+        if (slot[i].first <= now) {
+          expired.push_back(slot[i].second);
+          --size;
+        } else {
+          slot[kept++] = slot[i];
+        }
+      }
+      slot.resize(kept);
+    }
+    current = now;
+  }
+
+  size_t Size() const { return size; }
+
+  // Seconds until the earliest deadline could be due, capped at max
+  time_t NextTimeout(time_t max) const {
+    if (0 == size) {
+      return max;
+    }
+    for (time_t tick = 0; tick < max && tick < (time_t)slots.size(); ++tick) {
+      if (!slots[(current + tick) % slots.size()].empty()) {
+        return tick;
+      }
+    }
+    return max;
+  }
+
+ private:
+  typedef std::vector<std::pair<time_t, T> > Slot;
+  std::vector<Slot> slots;
+  time_t current;
+  size_t size;
+};
+
+#endif  // _TIMER_WHEEL_H_
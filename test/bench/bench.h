@@ -0,0 +1,188 @@
+/*****************************************************************************
+ * bench.h: micro-benchmark harness
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef BENCH_H
+#define BENCH_H
+
+/* A benchmark is a function running an operation a given number of times.
+ * bench_Run() warms it up, finds a number of loops lasting about
+ * BENCH_SAMPLE_TIME, then times several samples of that many loops and
+ * reports the median, minimum, mean and deviation of the time per
+ * operation. The median is the figure to compare across builds.
+ *
+ *   program [-j] [-n samples] [pattern]
+ *
+ * -j prints one line of JSON per result. Only the benchmarks whose
+ * "name/variant" contains the pattern are run. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+
+#define BENCH_WARMUP      (CLOCK_FREQ / 10)
+#define BENCH_SAMPLE_TIME (CLOCK_FREQ / 50)
+#define BENCH_SAMPLES_MAX 100
+
+typedef void (*bench_func_t)( void *p_data, unsigned i_loops );
+
+static struct
+{
+    const char *psz_pattern;
+    unsigned    i_samples;
+    bool        b_json;
+    bool        b_header;
+} bench_config = { NULL, 15, false, false };
+
+static inline void bench_Init( int argc, char *argv[] )
+{
+    for( int i = 1; i < argc; i++ )
+    {
+        if( !strcmp( argv[i], "-j" ) )
+            bench_config.b_json = true;
+        else if( !strcmp( argv[i], "-n" ) && i + 1 < argc )
+        {
+            unsigned n = strtoul( argv[++i], NULL, 10 );
+            bench_config.i_samples = VLC_CLIP( n, 1, BENCH_SAMPLES_MAX );
+        }
+        else
+            bench_config.psz_pattern = argv[i];
+    }
+}
+
+static inline bool bench_Match( const char *psz_name,
+                                const char *psz_variant )
+{
+    char psz_full[256];
+
+    if( bench_config.psz_pattern == NULL )
+        return true;
+    snprintf( psz_full, sizeof(psz_full), "%s/%s", psz_name, psz_variant );
+    return strstr( psz_full, bench_config.psz_pattern ) != NULL;
+}
+
+static int bench_Compare( const void *a, const void *b )
+{
+    const double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Reports a variant that cannot run, e.g. for lack of CPU support.
+ */
+static inline void bench_Skip( const char *psz_name, const char *psz_variant,
+                               const char *psz_reason )
+{
+    if( !bench_Match( psz_name, psz_variant ) )
+        return;
+    if( bench_config.b_json )
+        printf( "{\"bench\":\"%s\",\"variant\":\"%s\",\"skipped\":\"%s\"}\n",
+                psz_name, psz_variant, psz_reason );
+    else
+        printf( "%-24s %-14s skipped: %s\n", psz_name, psz_variant,
+                psz_reason );
+}
+
+/**
+ * Times a benchmark.
+ * \param i_bytes bytes processed per operation, for the throughput, or 0
+ */
+static inline void bench_Run( const char *psz_name, const char *psz_variant,
+                              bench_func_t pf_run, void *p_data,
+                              size_t i_bytes )
+{
+    double samples[BENCH_SAMPLES_MAX];
+    const unsigned n = bench_config.i_samples;
+    unsigned i_loops = 1;
+    mtime_t i_start, i_duration;
+
+    if( !bench_Match( psz_name, psz_variant ) )
+        return;
+
+    /* Warm the caches, the branch predictors and the CPU clock up */
+    i_start = mdate();
+    do
+        pf_run( p_data, 1 );
+    while( mdate() - i_start < BENCH_WARMUP );
+
+    /* Calibrate */
+    for( ;; )
+    {
+        i_start = mdate();
+        pf_run( p_data, i_loops );
+        i_duration = mdate() - i_start;
+        if( i_duration >= BENCH_SAMPLE_TIME || i_loops >= (1u << 30) )
+            break;
+        i_loops *= (i_duration > 0) ? __MIN( 2 * BENCH_SAMPLE_TIME
+                                                 / i_duration, 16 ) : 16;
+    }
+
+    double f_sum = 0., f_sum2 = 0.;
+    for( unsigned i = 0; i < n; i++ )
+    {
+        i_start = mdate();
+        pf_run( p_data, i_loops );
+        i_duration = mdate() - i_start;
+
+        samples[i] = i_duration * (1000000000. / CLOCK_FREQ) / i_loops;
+        f_sum += samples[i];
+        f_sum2 += samples[i] * samples[i];
+    }
+    qsort( samples, n, sizeof(samples[0]), bench_Compare );
+
+    const double f_median = (n & 1) ? samples[n / 2]
+                          : (samples[n / 2 - 1] + samples[n / 2]) / 2.;
+    const double f_mean = f_sum / n;
+    const double f_stddev = sqrt( fmax( f_sum2 / n - f_mean * f_mean, 0. ) );
+    /* bytes per nanosecond to MiB/s */
+    const double f_rate = i_bytes * 1e9 / (1 << 20) / f_median;
+
+    if( bench_config.b_json )
+    {
+        printf( "{\"bench\":\"%s\",\"variant\":\"%s\",\"cpu\":\"0x%x\","
+                "\"median_ns\":%.2f,\"min_ns\":%.2f,\"mean_ns\":%.2f,"
+                "\"stddev_ns\":%.2f,\"samples\":%u,\"loops\":%u",
+                psz_name, psz_variant, vlc_CPU(), f_median, samples[0],
+                f_mean, f_stddev, n, i_loops );
+        if( i_bytes > 0 )
+            printf( ",\"mib_s\":%.1f", f_rate );
+        puts( "}" );
+    }
+    else
+    {
+        if( !bench_config.b_header )
+        {
+            printf( "%-24s %-14s %12s %12s %7s %10s\n", "benchmark",
+                    "variant", "median ns", "min ns", "dev %", "MiB/s" );
+            bench_config.b_header = true;
+        }
+        printf( "%-24s %-14s %12.1f %12.1f %7.1f", psz_name, psz_variant,
+                f_median, samples[0], 100. * f_stddev / f_mean );
+        if( i_bytes > 0 )
+            printf( " %10.1f", f_rate );
+        putchar( '\n' );
+    }
+    fflush( stdout );
+}
+
+#endif
@@ -0,0 +1,569 @@
+/*****************************************************************************
+ * micro.c: micro-benchmarks of the core data structures and kernels
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* The SIMD variants of the kernels are benchmarked side by side when they
+ * are separate functions or plugins. The others pick their implementation
+ * from the CPU capabilities, which VLC_CPU limits, e.g.:
+ *
+ *   VLC_CPU=sse2 bench_micro -j audio */
+
+#define MODULE_STRING "bench"
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+#include <vlc/vlc.h>
+#include "../../lib/libvlc_internal.h"
+#include "bench.h"
+
+#include <assert.h>
+#include <math.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_picture.h>
+#include <vlc_picture_pool.h>
+#include <vlc_filter.h>
+#include <vlc_aout.h>
+#include <vlc_cpu.h>
+#include <synchronicity/syn_parsing.h>
+
+#include "../../modules/video_filter/deinterlace/common.h"
+#include "../../modules/video_filter/deinterlace/merge.h"
+#include "../../modules/video_filter/deinterlace/yadif.h"
+
+/*****************************************************************************
+ * Blocks
+ *****************************************************************************/
+static void BlockAlloc( void *data, unsigned n )
+{
+    const size_t size = *(const size_t *)data;
+
+    for( unsigned i = 0; i < n; i++ )
+        block_Release( block_Alloc( size ) );
+}
+
+static void FifoPutGet( void *data, unsigned n )
+{
+    block_fifo_t *fifo = data;
+    block_t *block = block_Alloc( 7 * 188 );
+
+    for( unsigned i = 0; i < n; i++ )
+    {
+        block_FifoPut( fifo, block );
+        block = block_FifoGet( fifo );
+    }
+    block_Release( block );
+}
+
+static void BenchBlocks( void )
+{
+    static const size_t sizes[] = { 7 * 188, 65536 };
+    char variant[16];
+
+    for( unsigned i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++ )
+    {
+        snprintf( variant, sizeof(variant), "%zu", sizes[i] );
+        bench_Run( "block_Alloc", variant, BlockAlloc, (void *)&sizes[i], 0 );
+    }
+
+    block_fifo_t *fifo = block_FifoNew();
+    if( fifo != NULL )
+    {
+        bench_Run( "block_FifoPut+Get", "mutex", FifoPutGet, fifo, 0 );
+        block_FifoRelease( fifo );
+    }
+    fifo = block_FifoNewSPSC();
+    if( fifo != NULL )
+    {
+        bench_Run( "block_FifoPut+Get", "spsc", FifoPutGet, fifo, 0 );
+        block_FifoRelease( fifo );
+    }
+}
+
+/*****************************************************************************
+ * Picture pool
+ *****************************************************************************/
+static void PoolGet( void *data, unsigned n )
+{
+    picture_pool_t *pool = data;
+
+    for( unsigned i = 0; i < n; i++ )
+    {
+        picture_t *pic = picture_pool_Get( pool );
+        if( pic != NULL )
+            picture_Release( pic );
+    }
+}
+
+static void BenchPicturePool( void )
+{
+    video_format_t fmt;
+    picture_t *pics[8];
+
+    video_format_Setup( &fmt, VLC_CODEC_I420, 1280, 720, 1, 1 );
+    for( unsigned i = 0; i < 8; i++ )
+    {
+        pics[i] = picture_NewFromFormat( &fmt );
+        assert( pics[i] != NULL );
+    }
+
+    picture_pool_t *pool = picture_pool_New( 8, pics );
+    assert( pool != NULL );
+    bench_Run( "picture_pool_Get", "720p", PoolGet, pool, 0 );
+    picture_pool_Delete( pool );
+}
+
+/*****************************************************************************
+ * Variables and messages
+ *****************************************************************************/
+static void VarGetInteger( void *data, unsigned n )
+{
+    libvlc_int_t *p_libvlc = data;
+
+    for( unsigned i = 0; i < n; i++ )
+        var_GetInteger( p_libvlc, "bench-int" );
+}
+
+static void VarGetString( void *data, unsigned n )
+{
+    libvlc_int_t *p_libvlc = data;
+
+    for( unsigned i = 0; i < n; i++ )
+        free( var_GetString( p_libvlc, "bench-string" ) );
+}
+
+static void VarInheritInteger( void *data, unsigned n )
+{
+    libvlc_int_t *p_libvlc = data;
+
+    for( unsigned i = 0; i < n; i++ )
+        var_InheritInteger( p_libvlc, "file-caching" );
+}
+
+static void LogFiltered( void *data, unsigned n )
+{
+    libvlc_int_t *p_libvlc = data;
+
+    for( unsigned i = 0; i < n; i++ )
+        msg_Dbg( p_libvlc, "picture %u is %d ms late", i, 42 );
+}
+
+static void BenchVariables( libvlc_int_t *p_libvlc )
+{
+    /* Lookups among as many variables as a libvlc instance has */
+    var_Create( p_libvlc, "bench-int", VLC_VAR_INTEGER );
+    var_SetInteger( p_libvlc, "bench-int", 42 );
+    var_Create( p_libvlc, "bench-string", VLC_VAR_STRING );
+    var_SetString( p_libvlc, "bench-string", "VLC media player" );
+
+    bench_Run( "var_GetInteger", "c", VarGetInteger, p_libvlc, 0 );
+    bench_Run( "var_GetString", "c", VarGetString, p_libvlc, 0 );
+    bench_Run( "var_InheritInteger", "c", VarInheritInteger, p_libvlc, 0 );
+    bench_Run( "vlc_vaLog", "filtered", LogFiltered, p_libvlc, 0 );
+
+    var_Destroy( p_libvlc, "bench-string" );
+    var_Destroy( p_libvlc, "bench-int" );
+}
+
+/*****************************************************************************
+ * Chroma converters
+ *****************************************************************************/
+typedef struct
+{
+    filter_chain_t *chain;
+    picture_t      *pic;
+} video_bench_t;
+
+static void VideoFilter( void *data, unsigned n )
+{
+    video_bench_t *b = data;
+
+    for( unsigned i = 0; i < n; i++ )
+    {
+        picture_t *out = filter_chain_VideoFilter( b->chain,
+                                                   picture_Hold( b->pic ) );
+        if( out != NULL )
+            picture_Release( out );
+    }
+}
+
+static void BenchChroma( libvlc_int_t *p_libvlc )
+{
+    static const struct
+    {
+        const char  *psz_module;
+        vlc_fourcc_t i_chroma;
+    } converters[] = {
+        { "i420_yuy2",       VLC_CODEC_YUYV },
+        { "i420_yuy2_mmx",   VLC_CODEC_YUYV },
+        { "i420_yuy2_sse2",  VLC_CODEC_YUYV },
+        { "i420_rgb",        VLC_CODEC_RGB32 },
+        { "i420_rgb_mmx",    VLC_CODEC_RGB32 },
+        { "i420_rgb_sse2",   VLC_CODEC_RGB32 },
+        { "i422_i420",       VLC_CODEC_I420 },
+        { "yuy2_i420",       VLC_CODEC_I420 },
+        { "swscale",         VLC_CODEC_YUYV },
+    };
+    video_bench_t b;
+    es_format_t in, out;
+    char name[32];
+
+    for( unsigned i = 0; i < sizeof(converters) / sizeof(converters[0]); i++ )
+    {
+        const char *psz_module = converters[i].psz_module;
+        vlc_fourcc_t i_src = VLC_CODEC_I420;
+
+        if( !strncmp( psz_module, "i422", 4 ) )
+            i_src = VLC_CODEC_I422;
+        else if( !strncmp( psz_module, "yuy2", 4 ) )
+            i_src = VLC_CODEC_YUYV;
+
+        es_format_Init( &in, VIDEO_ES, i_src );
+        video_format_Setup( &in.video, i_src, 1920, 1080, 1, 1 );
+        es_format_Init( &out, VIDEO_ES, converters[i].i_chroma );
+        video_format_Setup( &out.video, converters[i].i_chroma,
+                            1920, 1080, 1, 1 );
+        snprintf( name, sizeof(name), "chroma %4.4s>%4.4s",
+                  (const char *)&i_src,
+                  (const char *)&converters[i].i_chroma );
+
+        b.chain = filter_chain_New( p_libvlc, "video filter2", false,
+                                    NULL, NULL, NULL );
+        assert( b.chain != NULL );
+        filter_chain_Reset( b.chain, &in, &out );
+        b.pic = picture_NewFromFormat( &in.video );
+        assert( b.pic != NULL );
+        for( int p = 0; p < b.pic->i_planes; p++ )
+            memset( b.pic->p[p].p_pixels, 0x80,
+                    b.pic->p[p].i_pitch * b.pic->p[p].i_lines );
+
+        if( filter_chain_AppendFilter( b.chain, psz_module, NULL,
+                                       &in, &out ) != NULL )
+            bench_Run( name, psz_module, VideoFilter, &b,
+                       in.video.i_width * in.video.i_height );
+        else
+            bench_Skip( name, psz_module, "not available" );
+
+        picture_Release( b.pic );
+        filter_chain_Delete( b.chain );
+    }
+}
+
+/*****************************************************************************
+ * Audio sample format conversions
+ *****************************************************************************/
+#define AUDIO_FRAMES 4096
+
+typedef struct
+{
+    filter_chain_t *chain;
+    block_t        *block;
+} audio_bench_t;
+
+static void AudioFilter( void *data, unsigned n )
+{
+    audio_bench_t *b = data;
+
+    for( unsigned i = 0; i < n; i++ )
+    {
+        /* The filters consume their input */
+        block_t *in = block_Alloc( b->block->i_buffer );
+        if( unlikely(in == NULL) )
+            abort();
+        memcpy( in->p_buffer, b->block->p_buffer, in->i_buffer );
+        in->i_nb_samples = AUDIO_FRAMES;
+
+        block_t *out = filter_chain_AudioFilter( b->chain, in );
+        if( out != NULL )
+            block_Release( out );
+    }
+}
+
+static void SetupAudio( es_format_t *fmt, vlc_fourcc_t i_codec )
+{
+    es_format_Init( fmt, AUDIO_ES, i_codec );
+    fmt->audio.i_format = i_codec;
+    fmt->audio.i_rate = 48000;
+    fmt->audio.i_physical_channels =
+    fmt->audio.i_original_channels = AOUT_CHANS_STEREO;
+    aout_FormatPrepare( &fmt->audio );
+}
+
+static void BenchAudio( libvlc_int_t *p_libvlc )
+{
+    static const vlc_fourcc_t conversions[][2] = {
+        { VLC_CODEC_FL32, VLC_CODEC_S16N },
+        { VLC_CODEC_S16N, VLC_CODEC_FL32 },
+        { VLC_CODEC_S32N, VLC_CODEC_FL32 },
+        { VLC_CODEC_FL32, VLC_CODEC_S32N },
+        { VLC_CODEC_S16N, VLC_CODEC_U8 },
+    };
+    audio_bench_t b;
+    es_format_t in, out;
+    char name[32];
+
+    for( unsigned i = 0; i < sizeof(conversions) / sizeof(conversions[0]);
+         i++ )
+    {
+        SetupAudio( &in, conversions[i][0] );
+        SetupAudio( &out, conversions[i][1] );
+        snprintf( name, sizeof(name), "audio %4.4s>%4.4s",
+                  (const char *)&conversions[i][0],
+                  (const char *)&conversions[i][1] );
+
+        b.chain = filter_chain_New( p_libvlc, "audio filter", false,
+                                    NULL, NULL, NULL );
+        assert( b.chain != NULL );
+        filter_chain_Reset( b.chain, &in, &out );
+
+        /* A sine wave, within the range of every format */
+        b.block = block_Alloc( AUDIO_FRAMES * in.audio.i_bytes_per_frame );
+        assert( b.block != NULL );
+        for( unsigned j = 0; j < 2 * AUDIO_FRAMES; j++ )
+        {
+            const double s = 0.5 * sin( j * 0.01 );
+
+            switch( conversions[i][0] )
+            {
+                case VLC_CODEC_FL32:
+                    ((float *)b.block->p_buffer)[j] = s;
+                    break;
+                case VLC_CODEC_S16N:
+                    ((int16_t *)b.block->p_buffer)[j] = s * INT16_MAX;
+                    break;
+                case VLC_CODEC_S32N:
+                    ((int32_t *)b.block->p_buffer)[j] = s * INT32_MAX;
+                    break;
+            }
+        }
+
+        /* The copy of the input is part of the time */
+        if( filter_chain_AppendFilter( b.chain, "audio_format", NULL,
+                                       &in, &out ) != NULL )
+            bench_Run( name, "c+copy", AudioFilter, &b, b.block->i_buffer );
+        else
+            bench_Skip( name, "c+copy", "not available" );
+
+        block_Release( b.block );
+        filter_chain_Delete( b.chain );
+    }
+}
+
+/*****************************************************************************
+ * Deinterlacer kernels
+ *****************************************************************************/
+#define DEINT_WIDTH 1920
+#define DEINT_PITCH (DEINT_WIDTH + 64)
+
+typedef void (*yadif_line_t)(uint8_t *, uint8_t *, uint8_t *, uint8_t *,
+                             int, int, int, int, int);
+typedef void (*merge_t)(void *, const void *, const void *, size_t);
+
+typedef struct
+{
+    uint8_t     *lines; /* 3 pictures of 3 lines, and the output line */
+    yadif_line_t pf_yadif;
+    merge_t      pf_merge;
+    void       (*pf_end)( void );
+} deint_bench_t;
+
+static uint8_t *DeintLine( deint_bench_t *b, int pic )
+{
+    return &b->lines[(3 * pic + 1) * DEINT_PITCH + 32];
+}
+
+static void YadifLine( void *data, unsigned n )
+{
+    deint_bench_t *b = data;
+
+    for( unsigned i = 0; i < n; i++ )
+        b->pf_yadif( DeintLine( b, 3 ), DeintLine( b, 0 ), DeintLine( b, 1 ),
+                     DeintLine( b, 2 ), DEINT_WIDTH, DEINT_PITCH,
+                     -DEINT_PITCH, i & 1, 0 );
+}
+
+static void MergeLine( void *data, unsigned n )
+{
+    deint_bench_t *b = data;
+
+    for( unsigned i = 0; i < n; i++ )
+        b->pf_merge( DeintLine( b, 3 ), DeintLine( b, 0 ), DeintLine( b, 1 ),
+                     DEINT_WIDTH );
+    if( b->pf_end != NULL )
+        b->pf_end();
+}
+
+static void BenchDeinterlace( void )
+{
+    static const struct
+    {
+        const char  *psz_name;
+        unsigned     i_cpu;
+        yadif_line_t pf_line;
+    } yadif[] = {
+        { "c",     0,                    yadif_filter_line_c },
+#if defined(HAVE_YADIF_MMX)
+        { "mmx",   CPU_CAPABILITY_MMX,   yadif_filter_line_mmx },
+#endif
+#if defined(HAVE_YADIF_SSE2)
+        { "sse2",  CPU_CAPABILITY_SSE2,  yadif_filter_line_sse2 },
+#endif
+#if defined(HAVE_YADIF_SSSE3)
+        { "ssse3", CPU_CAPABILITY_SSSE3, yadif_filter_line_ssse3 },
+#endif
+#if defined(HAVE_YADIF_AVX2)
+        { "avx2",  CPU_CAPABILITY_AVX2,  yadif_filter_line_avx2 },
+#endif
+#if defined(HAVE_YADIF_NEON)
+        { "neon",  CPU_CAPABILITY_NEON,  yadif_filter_line_neon },
+#endif
+    };
+    static const struct
+    {
+        const char *psz_name;
+        unsigned    i_cpu;
+        merge_t     pf_merge;
+        void      (*pf_end)( void );
+    } merge[] = {
+        { "c",       0,                      MergeGeneric, NULL },
+#if defined(CAN_COMPILE_MMXEXT)
+        { "mmxext",  CPU_CAPABILITY_MMXEXT,  MergeMMXEXT,  EndMMX },
+#endif
+#if defined(CAN_COMPILE_SSE)
+        { "sse2",    CPU_CAPABILITY_SSE2,    MergeSSE2,    EndMMX },
+#endif
+#if defined(CAN_COMPILE_AVX2)
+        { "avx2",    CPU_CAPABILITY_AVX2,    MergeAVX2,    NULL },
+#endif
+#if defined(CAN_COMPILE_C_ALTIVEC)
+        { "altivec", CPU_CAPABILITY_ALTIVEC, MergeAltivec, NULL },
+#endif
+#if defined(__ARM_NEON__)
+        { "neon",    CPU_CAPABILITY_NEON,    MergeNEON,    NULL },
+#endif
+    };
+    deint_bench_t b;
+
+    b.lines = malloc( 12 * DEINT_PITCH );
+    assert( b.lines != NULL );
+    for( unsigned i = 0; i < 12 * DEINT_PITCH; i++ )
+        b.lines[i] = rand();
+
+    for( unsigned i = 0; i < sizeof(yadif) / sizeof(yadif[0]); i++ )
+    {
+        if( yadif[i].i_cpu && !(vlc_CPU() & yadif[i].i_cpu) )
+        {
+            bench_Skip( "yadif line", yadif[i].psz_name, "no CPU support" );
+            continue;
+        }
+        b.pf_yadif = yadif[i].pf_line;
+        bench_Run( "yadif line", yadif[i].psz_name, YadifLine, &b, DEINT_WIDTH );
+    }
+
+    for( unsigned i = 0; i < sizeof(merge) / sizeof(merge[0]); i++ )
+    {
+        if( merge[i].i_cpu && !(vlc_CPU() & merge[i].i_cpu) )
+        {
+            bench_Skip( "merge line", merge[i].psz_name, "no CPU support" );
+            continue;
+        }
+        b.pf_merge = merge[i].pf_merge;
+        b.pf_end = merge[i].pf_end;
+        bench_Run( "merge line", merge[i].psz_name, MergeLine, &b, DEINT_WIDTH );
+    }
+    free( b.lines );
+}
+
+/*****************************************************************************
+ * Synchronicity commands
+ *****************************************************************************/
+typedef struct
+{
+    SynCommand command;
+    int        i_version;
+} syn_bench_t;
+
+static void SynEncode( void *data, unsigned n )
+{
+    syn_bench_t *b = data;
+    char buffer[80];
+
+    for( unsigned i = 0; i < n; i++ )
+    {
+        b->command.data.i_time = i;
+        SynCommand_Encode( b->command, buffer, sizeof(buffer), b->i_version );
+    }
+}
+
+static void SynDecode( void *data, unsigned n )
+{
+    syn_bench_t *b = data;
+    char buffer[80];
+    int len = SynCommand_Encode( b->command, buffer, sizeof(buffer),
+                                 b->i_version );
+
+    for( unsigned i = 0; i < n; i++ )
+        if( CommandFromString( buffer, len ).type == SYNCOMMAND_ERROR )
+            abort();
+}
+
+static void BenchSynchronicity( void )
+{
+    syn_bench_t b;
+
+    memset( &b, 0, sizeof(b) );
+    b.command.type = SYNCOMMAND_SEEK;
+    b.command.data.i_time = INT64_C(5025000000);
+
+    b.i_version = 0;
+    bench_Run( "StringFromCommand", "text", SynEncode, &b, 0 );
+    bench_Run( "CommandFromString", "text", SynDecode, &b, 0 );
+    b.i_version = 1;
+    bench_Run( "StringFromCommand", "binary", SynEncode, &b, 0 );
+    bench_Run( "CommandFromString", "binary", SynDecode, &b, 0 );
+}
+
+int main( int argc, char *argv[] )
+{
+    static const char *args[] = {
+        "-q", "--ignore-config", "--no-media-library",
+    };
+
+    setenv( "VLC_PLUGIN_PATH", "../modules", 0 );
+    bench_Init( argc, argv );
+    srand( 42 );
+
+    libvlc_instance_t *p_vlc = libvlc_new( sizeof(args) / sizeof(args[0]),
+                                           args );
+    assert( p_vlc != NULL );
+    libvlc_int_t *p_libvlc = p_vlc->p_libvlc_int;
+
+    BenchBlocks();
+    BenchPicturePool();
+    BenchVariables( p_libvlc );
+    BenchChroma( p_libvlc );
+    BenchAudio( p_libvlc );
+    BenchDeinterlace();
+    BenchSynchronicity();
+
+    libvlc_release( p_vlc );
+    return 0;
+}
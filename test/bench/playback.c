@@ -0,0 +1,202 @@
+/*
+ * playback.c - headless playback benchmark
+ */
+
+/**********************************************************************
+ *  Copyright (C) 2026 VLC authors and VideoLAN                       *
+ *  This program is free software; you can redistribute and/or modify *
+ *  it under the terms of the GNU General Public License as published *
+ *  by the Free Software Foundation; version 2 of the license, or (at *
+ *  your option) any later version.                                   *
+ *                                                                    *
+ *  This program is distributed in the hope that it will be useful,   *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of    *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *  See the GNU General Public License for more details.              *
+ *                                                                    *
+ *  You should have received a copy of the GNU General Public License *
+ *  along with this program; if not, you can get it from:             *
+ *  http://www.gnu.org/copyleft/gpl.html                              *
+ **********************************************************************/
+
+/* Plays one file with the dummy outputs, as fast as the input rate allows,
+ * and prints one line of JSON:
+ *
+ *   bench_playback <name> <file> [:media-option...]
+ *
+ * Run one process per file, so that the peak RSS is that of the file.
+ * "make bench" runs it over the corpus listed in bench/corpus.txt. */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+#include <vlc/vlc.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#ifdef __GLIBC__
+/* Counts the heap allocations of the whole process: the executable
+ * interposes the allocator of the C library for the shared objects. */
+extern void *__libc_malloc (size_t);
+extern void *__libc_calloc (size_t, size_t);
+extern void *__libc_realloc (void *, size_t);
+extern void *__libc_memalign (size_t, size_t);
+
+static unsigned long allocations;
+
+void *malloc (size_t size)
+{
+    __sync_fetch_and_add (&allocations, 1);
+    return __libc_malloc (size);
+}
+
+void *calloc (size_t n, size_t size)
+{
+    __sync_fetch_and_add (&allocations, 1);
+    return __libc_calloc (n, size);
+}
+
+void *realloc (void *ptr, size_t size)
+{
+    __sync_fetch_and_add (&allocations, 1);
+    return __libc_realloc (ptr, size);
+}
+
+int posix_memalign (void **pp, size_t align, size_t size)
+{
+    __sync_fetch_and_add (&allocations, 1);
+    *pp = __libc_memalign (align, size);
+    return (*pp != NULL) ? 0 : ENOMEM;
+}
+# define ALLOCATIONS() __sync_fetch_and_add (&allocations, 0)
+#else
+# define ALLOCATIONS() 0UL
+#endif
+
+static const char *args[] = {
+    "-q",
+    "--ignore-config",
+    "--no-media-library",
+    "--vout=dummy",
+    "--aout=dummy",
+    "--stats",
+    /* There is no free-running clock: play at the highest rate, and
+     * keep every picture, so that the decoders are the bottleneck. */
+    "--rate=32",
+    "--no-drop-late-frames",
+    "--no-skip-frames",
+};
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wait = PTHREAD_COND_INITIALIZER;
+static bool done, failed;
+
+static void on_end (const libvlc_event_t *ev, void *data)
+{
+    (void) data;
+    pthread_mutex_lock (&lock);
+    done = true;
+    failed = ev->type == libvlc_MediaPlayerEncounteredError;
+    pthread_cond_signal (&wait);
+    pthread_mutex_unlock (&lock);
+}
+
+static double now (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double cpu_time (const struct rusage *ru)
+{
+    return ru->ru_utime.tv_sec + ru->ru_utime.tv_usec / 1e6
+         + ru->ru_stime.tv_sec + ru->ru_stime.tv_usec / 1e6;
+}
+
+int main (int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        fprintf (stderr, "Usage: %s <name> <file> [:option...]\n", argv[0]);
+        return 2;
+    }
+
+    alarm (600); /* Make sure "make bench" does not get stuck */
+    if (getenv ("VLC_PLUGIN_PATH") == NULL)
+        setenv ("VLC_PLUGIN_PATH", "../modules", 1);
+
+    libvlc_instance_t *vlc = libvlc_new (sizeof (args) / sizeof (args[0]),
+                                         args);
+    if (vlc == NULL)
+        return 1;
+
+    libvlc_media_t *md = libvlc_media_new_path (vlc, argv[2]);
+    if (md == NULL)
+        return 1;
+    for (int i = 3; i < argc; i++)
+        libvlc_media_add_option (md, argv[i]);
+
+    libvlc_media_player_t *mp = libvlc_media_player_new_from_media (md);
+    if (mp == NULL)
+        return 1;
+
+    libvlc_event_manager_t *em = libvlc_media_player_event_manager (mp);
+    libvlc_event_attach (em, libvlc_MediaPlayerEndReached, on_end, NULL);
+    libvlc_event_attach (em, libvlc_MediaPlayerEncounteredError, on_end,
+                         NULL);
+
+    struct rusage ru_start, ru_end;
+    getrusage (RUSAGE_SELF, &ru_start);
+    unsigned long allocs_start = ALLOCATIONS ();
+    double start = now ();
+
+    libvlc_media_player_play (mp);
+    pthread_mutex_lock (&lock);
+    while (!done)
+        pthread_cond_wait (&wait, &lock);
+    pthread_mutex_unlock (&lock);
+
+    double seconds = now () - start;
+    unsigned long allocs = ALLOCATIONS () - allocs_start;
+    getrusage (RUSAGE_SELF, &ru_end);
+
+    libvlc_media_stats_t st;
+    memset (&st, 0, sizeof (st));
+    libvlc_media_get_stats (md, &st);
+
+    libvlc_media_player_stop (mp);
+    libvlc_media_player_release (mp);
+    libvlc_media_release (md);
+    libvlc_release (vlc);
+
+    /* Audio-only files are measured per decoded buffer */
+    unsigned frames = st.i_decoded_video ? st.i_decoded_video
+                                         : st.i_decoded_audio;
+    double cpu = cpu_time (&ru_end) - cpu_time (&ru_start);
+
+    printf ("{\"name\":\"%s\",\"error\":%s,\"frames\":%u,"
+            "\"displayed\":%d,\"lost\":%d,\"seconds\":%.3f,\"fps\":%.1f,"
+            "\"cpu_us_per_frame\":%.1f,\"peak_rss_kb\":%ld,"
+            "\"allocs_per_frame\":%.1f,\"decode_us_p50\":%d,"
+            "\"decode_us_p99\":%d}\n",
+            argv[1], failed ? "true" : "false", frames,
+            st.i_displayed_pictures, st.i_lost_pictures, seconds,
+            frames / seconds, frames ? cpu * 1e6 / frames : 0.,
+            ru_end.ru_maxrss,
+            frames ? (double)allocs / frames : 0.,
+            st.i_decoded_video ? st.i_video_decode_time_p50
+                               : st.i_audio_decode_time_p50,
+            st.i_decoded_video ? st.i_video_decode_time_p99
+                               : st.i_audio_decode_time_p99);
+    return failed;
+}
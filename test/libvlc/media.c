@@ -23,6 +23,8 @@
 
 #include "test.h"
 
+#include <poll.h>
+
 static void preparsed_changed(const libvlc_event_t *event, void *user_data)
 {
     (void)event;
@@ -73,11 +75,67 @@ static void test_media_preparsed(const char** argv, int argc)
     libvlc_release (vlc);
 }
 
+static void test_media_event_queue(const char** argv, int argc)
+{
+    libvlc_event_t events[4];
+
+    log ("Testing event_queue\n");
+
+    libvlc_instance_t *vlc = libvlc_new (argc, argv);
+    assert (vlc != NULL);
+
+    libvlc_media_t *media = libvlc_media_new_path (vlc, "/dev/null");
+    assert (media != NULL);
+
+    libvlc_event_queue_t *queue = libvlc_event_queue_new ();
+    assert (queue != NULL);
+    assert (libvlc_event_queue_poll (queue, events, 4) == 0);
+
+    libvlc_event_manager_t *em = libvlc_media_event_manager (media);
+    int ret = libvlc_event_queue_attach (queue, em, libvlc_MediaMetaChanged);
+    assert (ret == 0);
+
+    libvlc_media_set_meta (media, libvlc_meta_Title, "title");
+    libvlc_media_set_meta (media, libvlc_meta_Artist, "artist");
+
+    int fd = libvlc_event_queue_fd (queue);
+    if (fd != -1)
+    {
+        struct pollfd ufd = { .fd = fd, .events = POLLIN };
+        assert (poll (&ufd, 1, 0) == 1);
+    }
+
+    /* Meta changes are not coalesced, and come out in order */
+    assert (libvlc_event_queue_poll (queue, events, 1) == 1);
+    assert (events[0].type == libvlc_MediaMetaChanged);
+    assert (events[0].p_obj == media);
+    assert (events[0].u.media_meta_changed.meta_type == libvlc_meta_Title);
+    assert (libvlc_event_queue_poll (queue, events, 4) == 1);
+    assert (events[0].u.media_meta_changed.meta_type == libvlc_meta_Artist);
+    assert (libvlc_event_queue_poll (queue, events, 4) == 0);
+
+    if (fd != -1)
+    {
+        struct pollfd ufd = { .fd = fd, .events = POLLIN };
+        assert (poll (&ufd, 1, 0) == 0);
+    }
+
+    /* Detaching drops the pending events */
+    libvlc_media_set_meta (media, libvlc_meta_Album, "album");
+    libvlc_event_queue_detach (queue, em, libvlc_MediaMetaChanged);
+    assert (libvlc_event_queue_poll (queue, events, 4) == 0);
+
+    libvlc_event_queue_release (queue);
+    libvlc_media_release (media);
+    libvlc_release (vlc);
+}
+
 int main (void)
 {
     test_init();
 
     test_media_preparsed (test_defaults_args, test_defaults_nargs);
+    test_media_event_queue (test_defaults_args, test_defaults_nargs);
 
     return 0;
 }
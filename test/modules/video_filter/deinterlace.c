@@ -0,0 +1,391 @@
+/*****************************************************************************
+ * deinterlace.c: test and benchmark the deinterlacer line kernels
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../libvlc/test.h"
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+
+#include "../../../modules/video_filter/deinterlace/common.h"
+#include "../../../modules/video_filter/deinterlace/merge.h"
+#include "../../../modules/video_filter/deinterlace/metrics.h"
+#include "../../../modules/video_filter/deinterlace/yadif.h"
+
+/* Each kernel is compared against the C version on random lines, for all
+ * modes and parities, then timed on a full HD line. */
+#define WIDTH  1920
+#define MARGIN 32
+#define PITCH  (WIDTH + 2 * MARGIN)
+#define LINES  5
+#define LOOPS  20000
+
+typedef void (*yadif_line_t)(uint8_t *, uint8_t *, uint8_t *, uint8_t *,
+                             int, int, int, int, int);
+typedef void (*merge_t)(void *, const void *, const void *, size_t);
+
+static const struct
+{
+    const char  *psz_name;
+    unsigned     i_cpu;
+    yadif_line_t pf_line;
+} yadif_kernels[] = {
+#if defined(HAVE_YADIF_MMX)
+    { "mmx",   CPU_CAPABILITY_MMX,   yadif_filter_line_mmx },
+#endif
+#if defined(HAVE_YADIF_SSE2)
+    { "sse2",  CPU_CAPABILITY_SSE2,  yadif_filter_line_sse2 },
+#endif
+#if defined(HAVE_YADIF_SSSE3)
+    { "ssse3", CPU_CAPABILITY_SSSE3, yadif_filter_line_ssse3 },
+#endif
+#if defined(HAVE_YADIF_AVX2)
+    { "avx2",  CPU_CAPABILITY_AVX2,  yadif_filter_line_avx2 },
+#endif
+#if defined(HAVE_YADIF_NEON)
+    { "neon",  CPU_CAPABILITY_NEON,  yadif_filter_line_neon },
+#endif
+    { NULL, 0, NULL }
+};
+
+static const struct
+{
+    const char *psz_name;
+    unsigned    i_cpu;
+    merge_t     pf_merge;
+    void      (*pf_end)( void );
+    int         i_max_diff; /* pavgb rounds up */
+} merge_kernels[] = {
+#if defined(CAN_COMPILE_MMXEXT)
+    { "mmxext",  CPU_CAPABILITY_MMXEXT,  MergeMMXEXT, EndMMX,   1 },
+#endif
+#if defined(CAN_COMPILE_3DNOW)
+    { "3dnow",   CPU_CAPABILITY_3DNOW,   Merge3DNow,  End3DNow, 1 },
+#endif
+#if defined(CAN_COMPILE_SSE)
+    { "sse2",    CPU_CAPABILITY_SSE2,    MergeSSE2,   EndMMX,   1 },
+#endif
+#if defined(CAN_COMPILE_AVX2)
+    { "avx2",    CPU_CAPABILITY_AVX2,    MergeAVX2,   NULL,     0 },
+#endif
+#if defined(CAN_COMPILE_C_ALTIVEC)
+    { "altivec", CPU_CAPABILITY_ALTIVEC, MergeAltivec, NULL,    1 },
+#endif
+#if defined(__ARM_NEON__)
+    { "neon",    CPU_CAPABILITY_NEON,    MergeNEON,   NULL,     0 },
+#endif
+    { NULL, 0, NULL, NULL, 0 }
+};
+
+static const struct
+{
+    const char  *psz_name;
+    unsigned     i_cpu;
+    comb_line_t  pf_comb;
+    motion_row_t pf_motion;
+} metrics_kernels[] = {
+#if defined(CAN_COMPILE_MMXEXT)
+    { "mmxext", CPU_CAPABILITY_MMXEXT, CombLineMMXEXT, MotionRowMMXEXT },
+#endif
+#if defined(HAVE_METRICS_SSE2)
+    { "sse2",   CPU_CAPABILITY_SSE2,   CombLineSSE2,   MotionRowSSE2 },
+#endif
+#if defined(HAVE_METRICS_NEON)
+    { "neon",   CPU_CAPABILITY_NEON,   CombLineNEON,   MotionRowNEON },
+#endif
+    { NULL, 0, NULL, NULL }
+};
+
+static void fill_random( uint8_t *p, size_t i_size )
+{
+    for( size_t i = 0; i < i_size; i++ )
+        p[i] = rand();
+}
+
+/* Returns the line in the middle of a picture buffer */
+static uint8_t *middle( uint8_t *p )
+{
+    return &p[(LINES / 2) * PITCH + MARGIN];
+}
+
+static void run_yadif( yadif_line_t pf_line, uint8_t *dst, uint8_t *prev,
+                       uint8_t *cur, uint8_t *next, int w, int parity,
+                       int mode )
+{
+    pf_line( middle(dst), middle(prev), middle(cur), middle(next),
+             w, PITCH, -PITCH, parity, mode );
+}
+
+static void test_yadif( void )
+{
+    uint8_t *prev = malloc( LINES * PITCH );
+    uint8_t *cur  = malloc( LINES * PITCH );
+    uint8_t *next = malloc( LINES * PITCH );
+    uint8_t *ref  = calloc( LINES, PITCH );
+    uint8_t *out  = calloc( LINES, PITCH );
+    assert( prev && cur && next && ref && out );
+
+    for( int k = 0; yadif_kernels[k].psz_name; k++ )
+    {
+        if( !(vlc_CPU() & yadif_kernels[k].i_cpu) )
+        {
+            log( "yadif %s: not supported by the CPU\n",
+                 yadif_kernels[k].psz_name );
+            continue;
+        }
+
+        /* Odd widths exercise the C tail of the kernels */
+        static const int widths[] = { WIDTH, WIDTH - 3, 13, 1 };
+        for( int i = 0; i < 64; i++ )
+        {
+            fill_random( prev, LINES * PITCH );
+            fill_random( cur, LINES * PITCH );
+            fill_random( next, LINES * PITCH );
+            /* Flat pictures take the other branches */
+            if( i % 4 == 0 )
+                memset( next, cur[0], LINES * PITCH );
+
+            const int w = widths[i % 4];
+            const int parity = (i / 4) % 2;
+            const int mode = (i / 8) % 2 ? 2 : 0;
+
+            run_yadif( yadif_filter_line_c, ref, prev, cur, next,
+                       w, parity, mode );
+            run_yadif( yadif_kernels[k].pf_line, out, prev, cur, next,
+                       w, parity, mode );
+            if( memcmp( middle(ref), middle(out), w ) )
+            {
+                log( "yadif %s: differs from C (width %d, parity %d, "
+                     "mode %d)\n", yadif_kernels[k].psz_name, w, parity,
+                     mode );
+                abort();
+            }
+        }
+    }
+
+    /* Speed */
+    fill_random( prev, LINES * PITCH );
+    fill_random( cur, LINES * PITCH );
+    fill_random( next, LINES * PITCH );
+    for( int k = -1; k < 0 || yadif_kernels[k].psz_name; k++ )
+    {
+        yadif_line_t pf_line = k < 0 ? yadif_filter_line_c
+                                     : yadif_kernels[k].pf_line;
+        if( k >= 0 && !(vlc_CPU() & yadif_kernels[k].i_cpu) )
+            continue;
+
+        mtime_t i_start = mdate();
+        for( int i = 0; i < LOOPS; i++ )
+            run_yadif( pf_line, out, prev, cur, next, WIDTH, i & 1, 0 );
+        mtime_t i_duration = mdate() - i_start;
+
+        log( "yadif %-7s: %6.1f ns/line\n",
+             k < 0 ? "c" : yadif_kernels[k].psz_name,
+             i_duration * 1000. / LOOPS );
+    }
+
+    free( prev );
+    free( cur );
+    free( next );
+    free( ref );
+    free( out );
+}
+
+static void test_merge( void )
+{
+    uint8_t *s1  = malloc( PITCH );
+    uint8_t *s2  = malloc( PITCH );
+    uint8_t *ref = malloc( PITCH );
+    uint8_t *out = malloc( PITCH );
+    assert( s1 && s2 && ref && out );
+
+    for( int k = 0; merge_kernels[k].psz_name; k++ )
+    {
+        if( !(vlc_CPU() & merge_kernels[k].i_cpu) )
+        {
+            log( "merge %s: not supported by the CPU\n",
+                 merge_kernels[k].psz_name );
+            continue;
+        }
+
+        for( int i = 0; i < 64; i++ )
+        {
+            /* Misaligned pointers and odd sizes exercise the C parts */
+            const int i_offset = i % 16;
+            const size_t i_bytes = WIDTH - i;
+
+            fill_random( s1, PITCH );
+            fill_random( s2, PITCH );
+            MergeGeneric( ref + i_offset, s1 + i_offset, s2 + 2 * i_offset,
+                          i_bytes );
+            merge_kernels[k].pf_merge( out + i_offset, s1 + i_offset,
+                                       s2 + 2 * i_offset, i_bytes );
+            if( merge_kernels[k].pf_end )
+                merge_kernels[k].pf_end();
+
+            for( size_t j = 0; j < i_bytes; j++ )
+            {
+                if( abs( ref[i_offset + j] - out[i_offset + j] )
+                     > merge_kernels[k].i_max_diff )
+                {
+                    log( "merge %s: differs from C at %zu\n",
+                         merge_kernels[k].psz_name, j );
+                    abort();
+                }
+            }
+        }
+    }
+
+    /* Speed */
+    for( int k = -1; k < 0 || merge_kernels[k].psz_name; k++ )
+    {
+        merge_t pf_merge = k < 0 ? MergeGeneric : merge_kernels[k].pf_merge;
+        if( k >= 0 && !(vlc_CPU() & merge_kernels[k].i_cpu) )
+            continue;
+
+        mtime_t i_start = mdate();
+        for( int i = 0; i < LOOPS; i++ )
+            pf_merge( out, s1, s2, WIDTH );
+        if( k >= 0 && merge_kernels[k].pf_end )
+            merge_kernels[k].pf_end();
+        mtime_t i_duration = mdate() - i_start;
+
+        log( "merge %-7s: %6.1f ns/line\n",
+             k < 0 ? "c" : merge_kernels[k].psz_name,
+             i_duration * 1000. / LOOPS );
+    }
+
+    free( s1 );
+    free( s2 );
+    free( ref );
+    free( out );
+}
+
+/* Random pixels of a given range, so that the thresholds matter */
+static void fill_range( uint8_t *p, size_t i_size, int i_base, int i_range )
+{
+    for( size_t i = 0; i < i_size; i++ )
+        p[i] = i_base + rand() % i_range;
+}
+
+static void test_metrics( void )
+{
+    uint8_t *prev = malloc( 8 * PITCH );
+    uint8_t *cur  = malloc( 8 * PITCH );
+    assert( prev && cur );
+
+    for( int k = 0; metrics_kernels[k].psz_name; k++ )
+    {
+        if( !(vlc_CPU() & metrics_kernels[k].i_cpu) )
+        {
+            log( "metrics %s: not supported by the CPU\n",
+                 metrics_kernels[k].psz_name );
+            continue;
+        }
+
+        static const int ranges[] = { 256, 24, 64, 2 };
+        for( int i = 0; i < 64; i++ )
+        {
+            const int i_range = ranges[i % 4];
+            const int w = WIDTH - i;
+
+            /* Comb metric, on three lines of the buffer */
+            fill_range( cur, 3 * PITCH, 128 - i_range / 2, i_range );
+            unsigned i_ref = CombLineC( &cur[PITCH], cur, &cur[2 * PITCH], w );
+            unsigned i_out = metrics_kernels[k].pf_comb( &cur[PITCH], cur,
+                                                         &cur[2 * PITCH], w );
+            if( i_ref != i_out )
+            {
+                log( "comb %s: %u instead of %u (width %d)\n",
+                     metrics_kernels[k].psz_name, i_out, i_ref, w );
+                abort();
+            }
+
+            /* Motion, on a row of 8x8 blocks, an odd number of them */
+            const int i_blocks = (w / 8) | 1;
+            uint8_t ref[2 * (WIDTH / 8 + 1)], out[2 * (WIDTH / 8 + 1)];
+
+            fill_range( prev, 8 * PITCH, 128 - i_range / 2, i_range );
+            if( i % 8 < 4 )
+                memcpy( cur, prev, 8 * PITCH );
+            else
+                fill_range( cur, 8 * PITCH, 128 - i_range / 2, i_range );
+            for( int j = 0; j < 8 * PITCH; j += 1 + rand() % 16 )
+                cur[j] += rand() % 32 - 16;
+
+            MotionRowC( prev, PITCH, cur, PITCH, i_blocks, ref );
+            metrics_kernels[k].pf_motion( prev, PITCH, cur, PITCH, i_blocks,
+                                          out );
+            if( memcmp( ref, out, 2 * i_blocks ) )
+            {
+                log( "motion %s: differs from C (%d blocks)\n",
+                     metrics_kernels[k].psz_name, i_blocks );
+                abort();
+            }
+        }
+    }
+
+    /* Speed */
+    fill_random( prev, 8 * PITCH );
+    fill_random( cur, 8 * PITCH );
+    for( int k = -1; k < 0 || metrics_kernels[k].psz_name; k++ )
+    {
+        comb_line_t pf_comb = k < 0 ? CombLineC : metrics_kernels[k].pf_comb;
+        motion_row_t pf_motion = k < 0 ? MotionRowC
+                                       : metrics_kernels[k].pf_motion;
+        if( k >= 0 && !(vlc_CPU() & metrics_kernels[k].i_cpu) )
+            continue;
+
+        volatile unsigned i_sink = 0;
+        mtime_t i_start = mdate();
+        for( int i = 0; i < LOOPS; i++ )
+            i_sink += pf_comb( &cur[PITCH], cur, &cur[2 * PITCH], WIDTH );
+        mtime_t i_comb = mdate() - i_start;
+
+        uint8_t counts[2 * WIDTH / 8];
+        i_start = mdate();
+        for( int i = 0; i < LOOPS / 8; i++ )
+            pf_motion( prev, PITCH, cur, PITCH, WIDTH / 8, counts );
+        mtime_t i_motion = mdate() - i_start;
+
+        log( "comb   %-7s: %6.1f ns/line\n",
+             k < 0 ? "c" : metrics_kernels[k].psz_name,
+             i_comb * 1000. / LOOPS );
+        log( "motion %-7s: %6.1f ns/line\n",
+             k < 0 ? "c" : metrics_kernels[k].psz_name,
+             i_motion * 1000. / LOOPS );
+        (void) i_sink;
+    }
+
+    free( prev );
+    free( cur );
+}
+
+int main( void )
+{
+    log( "Testing the deinterlacer kernels\n" );
+    srand( 42 );
+    test_yadif();
+    test_merge();
+    test_metrics();
+    return 0;
+}
@@ -401,6 +401,59 @@ static void test_creation_and_type( libvlc_int_t *p_libvlc )
     assert( var_Get( p_libvlc, "bla", &val ) == VLC_ENOVAR );
 }
 
+static void test_handles( libvlc_int_t *p_libvlc )
+{
+    vlc_var_handle_t *handles[6];
+    int i;
+
+    assert( var_Handle( p_libvlc, "bla" ) == NULL );
+
+    for( i = 0; i < i_var_count; i++ )
+    {
+        var_Create( p_libvlc, psz_var_name[i], VLC_VAR_INTEGER );
+        handles[i] = var_Handle( p_libvlc, psz_var_name[i] );
+        assert( handles[i] != NULL );
+    }
+
+    for( i = 0; i < i_var_count; i++ )
+    {
+        var_value[i].i_int = rand();
+        var_HandleSetInteger( p_libvlc, handles[i], var_value[i].i_int );
+    }
+
+    for( i = 0; i < i_var_count; i++ )
+    {
+        assert( var_GetInteger( p_libvlc, psz_var_name[i] ) == var_value[i].i_int );
+        var_SetInteger( p_libvlc, psz_var_name[i], var_value[i].i_int + 1 );
+        assert( var_HandleGetInteger( p_libvlc, handles[i] ) == var_value[i].i_int + 1 );
+    }
+
+    /* The handle keeps the variable */
+    for( i = 0; i < i_var_count; i++ )
+    {
+        var_Destroy( p_libvlc, psz_var_name[i] );
+        assert( var_Type( p_libvlc, psz_var_name[i] ) == VLC_VAR_INTEGER );
+        var_HandleRelease( p_libvlc, handles[i] );
+        assert( var_Type( p_libvlc, psz_var_name[i] ) == 0 );
+    }
+
+    /* Many variables, to grow the hash table */
+    for( i = 0; i < 1000; i++ )
+    {
+        char psz_name[16];
+        sprintf( psz_name, "var%d", i );
+        var_Create( p_libvlc, psz_name, VLC_VAR_INTEGER );
+        var_SetInteger( p_libvlc, psz_name, i );
+    }
+    for( i = 0; i < 1000; i++ )
+    {
+        char psz_name[16];
+        sprintf( psz_name, "var%d", i );
+        assert( var_GetInteger( p_libvlc, psz_name ) == i );
+        var_Destroy( p_libvlc, psz_name );
+    }
+}
+
 static void test_variables( libvlc_instance_t *p_vlc )
 {
     libvlc_int_t *p_libvlc = p_vlc->p_libvlc_int;
@@ -438,6 +491,9 @@ static void test_variables( libvlc_instance_t *p_vlc )
 
     log( "Testing type at creation\n" );
     test_creation_and_type( p_libvlc );
+
+    log( "Testing handles\n" );
+    test_handles( p_libvlc );
 }
 
 